@@ -0,0 +1,149 @@
+//! Rust side of the C++ FFI overhead comparison: the same workloads as
+//! `benches/ffi_cpp/main.cpp`, through the native API the bridge methods
+//! wrap, timed the same way (best of `REPS` runs) and printed in the same
+//! `FFI\t<side>\t<case>\t<ops>\t<ns/op>` lines. `benches/ffi_cpp/run.sh`
+//! runs both and joins them into a per-case overhead table.
+//!
+//! Run on its own it also prints the corpus world path (`WORLD\t<dir>`) the
+//! C++ side streams, and records each case as a baseline.
+//!
+//! The Rust numbers include this bench's counting allocator: two relaxed
+//! atomics per allocation, which slightly understates the overhead.
+
+use std::time::Instant;
+
+use nucleation::formats::world_stream::WorldSource;
+use nucleation::{BlockState, UniversalSchematic};
+
+#[path = "support/alloc_count.rs"]
+mod alloc_count;
+#[path = "support/baseline.rs"]
+mod baseline;
+#[path = "support/corpus.rs"]
+mod corpus;
+
+const BENCH: &str = "ffi_bench";
+const SIDE: i32 = 64;
+const REPS: usize = 5;
+const NAMES: [&str; 4] = [
+    "minecraft:stone",
+    "minecraft:dirt",
+    "minecraft:oak_planks",
+    "minecraft:glass",
+];
+
+fn name_at(x: i32, y: i32, z: i32) -> &'static str {
+    NAMES[((x + y + z) % 4) as usize]
+}
+
+fn cube() -> impl Iterator<Item = (i32, i32, i32)> {
+    (0..SIDE).flat_map(|y| (0..SIDE).flat_map(move |z| (0..SIDE).map(move |x| (x, y, z))))
+}
+
+/// Best of `REPS` runs of `f`, which does `ops` operations, printed as
+/// nanoseconds per operation and recorded as a baseline.
+fn time(case: &str, ops: u64, mut f: impl FnMut() -> u64) {
+    let mut best = f64::MAX;
+    for _ in 0..REPS {
+        let started = Instant::now();
+        std::hint::black_box(f());
+        best = best.min(started.elapsed().as_nanos() as f64);
+    }
+    println!("FFI\trust\t{case}\t{ops}\t{:.1}", best / ops as f64);
+    baseline::measure(BENCH, case, ops, "ops", f);
+}
+
+fn filled() -> UniversalSchematic {
+    let mut schematic = UniversalSchematic::new("ffi".to_string());
+    for (x, y, z) in cube() {
+        schematic.set_block_str(x, y, z, name_at(x, y, z));
+    }
+    schematic
+}
+
+fn main() {
+    let ops = (SIDE * SIDE * SIDE) as u64;
+
+    // Bridge `set_block` parses the name through `try_set_block_str`.
+    time("set_block", ops, || {
+        let mut schematic = UniversalSchematic::new("ffi".to_string());
+        cube()
+            .map(|(x, y, z)| schematic.set_block_str(x, y, z, name_at(x, y, z)) as u64)
+            .sum()
+    });
+
+    let schematic = filled();
+    time("get_block_name", ops, || {
+        cube()
+            .filter_map(|(x, y, z)| schematic.get_block(x, y, z))
+            .map(|block| block.name.len() as u64)
+            .sum()
+    });
+
+    // Bridge `set_blocks` grows the region to the batch's box once, then
+    // places one parsed state everywhere.
+    let stone = BlockState::new("minecraft:stone".to_string());
+    time("set_blocks", ops, || {
+        let mut schematic = UniversalSchematic::new("ffi".to_string());
+        schematic
+            .default_region
+            .ensure_bounds((0, 0, 0), (SIDE - 1, SIDE - 1, SIDE - 1));
+        cube()
+            .map(|(x, y, z)| schematic.set_block(x, y, z, &stone) as u64)
+            .sum()
+    });
+
+    let world = corpus::world();
+    println!("WORLD\t{}", world.dir.display());
+    time("world_chunks", world.chunks, || {
+        WorldSource::open_dir(&world.dir)
+            .expect("open corpus")
+            .chunks()
+            .expect("chunks")
+            .filter(Result::is_ok)
+            .count() as u64
+    });
+
+    #[cfg(feature = "meshing")]
+    mesh_cases(&schematic);
+}
+
+/// Cases that need `MINECRAFT_RESOURCE_PACK`, as the C++ side does.
+#[cfg(feature = "meshing")]
+fn mesh_cases(schematic: &UniversalSchematic) {
+    use nucleation::meshing::{MeshConfig, ResourcePackSource};
+
+    let Ok(path) = std::env::var("MINECRAFT_RESOURCE_PACK") else {
+        eprintln!("SKIP\tmesh and render cases: set MINECRAFT_RESOURCE_PACK");
+        return;
+    };
+    let pack = ResourcePackSource::from_file(&path).expect("load resource pack");
+    let config = MeshConfig::default();
+
+    // Bridge: `MeshResult::create` then `glb_data_b64`.
+    time("mesh_glb", 1, || {
+        let mesh = schematic.to_mesh(&pack, &config).expect("mesh");
+        mesh.to_glb().expect("glb").len() as u64
+    });
+
+    // Bridge: `Renderer::render_pixels_b64_with_pack`, which meshes too.
+    #[cfg(feature = "rendering")]
+    {
+        use nucleation::rendering::{render_meshes, RenderConfig};
+
+        let render = RenderConfig {
+            width: 512,
+            height: 512,
+            ..RenderConfig::default()
+        };
+        let mesh = schematic.to_mesh(&pack, &config).expect("mesh");
+        if let Err(e) = render_meshes(std::slice::from_ref(&mesh), &render, None) {
+            eprintln!("SKIP\trender_pixels: {e}");
+            return;
+        }
+        time("render_pixels", 1, || {
+            let mesh = schematic.to_mesh(&pack, &config).expect("mesh");
+            render_meshes(&[mesh], &render, None).expect("render").len() as u64
+        });
+    }
+}
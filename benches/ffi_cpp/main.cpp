@@ -0,0 +1,208 @@
+// C++ side of the FFI overhead comparison. Runs the workloads of
+// benches/ffi_bench.rs through the generated bindings/cpp headers and prints
+// the same `FFI\t<side>\t<case>\t<ops>\t<ns/op>` lines, so run.sh can join
+// the two. Each case is the best of REPS runs.
+//
+// Binary results cross the bridge as base64 and are decoded here, since a
+// caller has to; the `_write` case reuses one std::string to separate the
+// copy into a fresh string from the call itself.
+//
+// Environment: NUCLEATION_BENCH_WORLD (corpus world directory, printed by
+// ffi_bench) and MINECRAFT_RESOURCE_PACK (pack zip for mesh and render).
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "MeshConfig.hpp"
+#include "MeshResult.hpp"
+#include "RenderConfig.hpp"
+#include "Renderer.hpp"
+#include "ResourcePack.hpp"
+#include "Schematic.hpp"
+#include "WorldChunkView.hpp"
+#include "WorldStream.hpp"
+
+namespace {
+
+constexpr int32_t SIDE = 64;
+constexpr int REPS = 5;
+constexpr const char* NAMES[] = {
+    "minecraft:stone",
+    "minecraft:dirt",
+    "minecraft:oak_planks",
+    "minecraft:glass",
+};
+
+const char* name_at(int32_t x, int32_t y, int32_t z) {
+    return NAMES[(x + y + z) % 4];
+}
+
+// Visit the cube in the order the Rust side does: x fastest, then z, then y.
+template <typename F>
+void cube(F&& f) {
+    for (int32_t y = 0; y < SIDE; ++y)
+        for (int32_t z = 0; z < SIDE; ++z)
+            for (int32_t x = 0; x < SIDE; ++x) f(x, y, z);
+}
+
+volatile uint64_t sink;
+
+template <typename F>
+void time(const char* name, uint64_t ops, F&& f) {
+    double best = 1e300;
+    for (int rep = 0; rep < REPS; ++rep) {
+        auto started = std::chrono::steady_clock::now();
+        sink = f();
+        auto elapsed = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - started);
+        if (elapsed.count() < best) best = elapsed.count();
+    }
+    std::printf("FFI\tcpp\t%s\t%llu\t%.1f\n", name, (unsigned long long)ops, best / ops);
+    std::fflush(stdout);
+}
+
+[[noreturn]] void fail(const char* what) {
+    std::fprintf(stderr, "ffi_cpp: %s failed\n", what);
+    std::exit(1);
+}
+
+template <typename T, typename E>
+T take(diplomat::result<T, E>&& result, const char* what) {
+    if (!result.is_ok()) fail(what);
+    return std::move(std::move(result).ok().value());
+}
+
+std::vector<uint8_t> base64_decode(const std::string& in) {
+    static const auto table = [] {
+        std::vector<int8_t> t(256, -1);
+        const char* chars =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (int i = 0; i < 64; ++i) t[(uint8_t)chars[i]] = (int8_t)i;
+        return t;
+    }();
+    std::vector<uint8_t> out;
+    out.reserve(in.size() / 4 * 3);
+    uint32_t acc = 0;
+    int bits = 0;
+    for (char c : in) {
+        int8_t v = table[(uint8_t)c];
+        if (v < 0) continue;
+        acc = (acc << 6) | (uint32_t)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back((uint8_t)(acc >> bits));
+        }
+    }
+    return out;
+}
+
+std::unique_ptr<Schematic> filled() {
+    auto schematic = Schematic::create("ffi");
+    cube([&](int32_t x, int32_t y, int32_t z) {
+        take(schematic->set_block(x, y, z, name_at(x, y, z)), "set_block");
+    });
+    return schematic;
+}
+
+void mesh_cases(const Schematic& schematic) {
+    const char* path = std::getenv("MINECRAFT_RESOURCE_PACK");
+    if (!path) {
+        std::fprintf(stderr, "SKIP\tmesh and render cases: set MINECRAFT_RESOURCE_PACK\n");
+        return;
+    }
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> zip((std::istreambuf_iterator<char>(file)), {});
+    auto pack = take(
+        ResourcePack::from_bytes(diplomat::span<const uint8_t>(zip.data(), zip.size())),
+        "ResourcePack::from_bytes");
+    auto config = MeshConfig::create();
+
+    time("mesh_glb", 1, [&] {
+        auto mesh = take(MeshResult::create(schematic, *pack, *config), "MeshResult::create");
+        return (uint64_t)base64_decode(take(mesh->glb_data_b64(), "glb_data_b64")).size();
+    });
+
+    auto render = RenderConfig::create(512, 512);
+    if (!Renderer::render_pixels_b64_with_pack(schematic, *pack, *render).is_ok()) {
+        std::fprintf(stderr, "SKIP\trender_pixels: renderer unavailable\n");
+        return;
+    }
+    time("render_pixels", 1, [&] {
+        auto pixels = take(Renderer::render_pixels_b64_with_pack(schematic, *pack, *render),
+                           "render_pixels_b64_with_pack");
+        return (uint64_t)base64_decode(pixels).size();
+    });
+}
+
+}  // namespace
+
+int main() {
+    const uint64_t ops = (uint64_t)SIDE * SIDE * SIDE;
+
+    time("set_block", ops, [] {
+        auto schematic = Schematic::create("ffi");
+        uint64_t placed = 0;
+        cube([&](int32_t x, int32_t y, int32_t z) {
+            placed += take(schematic->set_block(x, y, z, name_at(x, y, z)), "set_block");
+        });
+        return placed;
+    });
+
+    auto schematic = filled();
+    time("get_block_name", ops, [&] {
+        uint64_t total = 0;
+        cube([&](int32_t x, int32_t y, int32_t z) {
+            total += take(schematic->get_block_name(x, y, z), "get_block_name").size();
+        });
+        return total;
+    });
+
+    time("get_block_name_write", ops, [&] {
+        uint64_t total = 0;
+        std::string name;
+        cube([&](int32_t x, int32_t y, int32_t z) {
+            name.clear();
+            take(schematic->get_block_name_write(x, y, z, name), "get_block_name_write");
+            total += name.size();
+        });
+        return total;
+    });
+
+    std::vector<int32_t> positions;
+    positions.reserve(ops * 3);
+    cube([&](int32_t x, int32_t y, int32_t z) {
+        positions.insert(positions.end(), {x, y, z});
+    });
+    time("set_blocks", ops, [&] {
+        auto target = Schematic::create("ffi");
+        return (uint64_t)take(
+            target->set_blocks(
+                diplomat::span<const int32_t>(positions.data(), positions.size()),
+                "minecraft:stone"),
+            "set_blocks");
+    });
+
+    if (const char* world = std::getenv("NUCLEATION_BENCH_WORLD")) {
+        // One pass to learn the chunk count for the ops column.
+        auto count = [&] {
+            auto stream = take(WorldStream::open_dir(world), "WorldStream::open_dir");
+            uint64_t chunks = 0;
+            while (stream->next().is_ok()) ++chunks;
+            return chunks;
+        };
+        time("world_chunks", count(), count);
+    } else {
+        std::fprintf(stderr, "SKIP\tworld_chunks: set NUCLEATION_BENCH_WORLD\n");
+    }
+
+    mesh_cases(*schematic);
+    return 0;
+}
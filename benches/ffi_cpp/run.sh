@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+# Time the same workloads through bindings/cpp and through the Rust API, and
+# print the per-call overhead of the binding path for each case. The joined
+# table is also saved to target/bench-baselines/<version>/ffi_overhead.tsv.
+set -euo pipefail
+cd "$(dirname "$0")"
+ROOT="../.."
+FEATURES="${FEATURES:-meshing,rendering}"
+
+cargo build --release --lib --features bridge-full --manifest-path "$ROOT/Cargo.toml"
+BIN="$(mktemp -d)/ffi_cpp"
+clang++ -std=c++20 -O2 -I "$ROOT/bindings/cpp" main.cpp \
+    -L "$ROOT/target/release" -lnucleation -o "$BIN"
+
+OUT="$(mktemp -d)"
+cargo bench --bench ffi_bench --features "$FEATURES" --manifest-path "$ROOT/Cargo.toml" \
+    | tee "$OUT/rust.tsv"
+WORLD="$(awk -F'\t' '$1 == "WORLD" { print $2 }' "$OUT/rust.tsv")"
+if [[ "$(uname)" == "Darwin" ]]; then
+    NUCLEATION_BENCH_WORLD="$WORLD" DYLD_LIBRARY_PATH="$ROOT/target/release" "$BIN" | tee "$OUT/cpp.tsv"
+else
+    NUCLEATION_BENCH_WORLD="$WORLD" LD_LIBRARY_PATH="$ROOT/target/release" "$BIN" | tee "$OUT/cpp.tsv"
+fi
+
+VERSION="${NUCLEATION_BENCH_BASELINE:-$(awk -F'"' '/^version/ { print $2; exit }' "$ROOT/Cargo.toml")}"
+SAVE="${CARGO_TARGET_DIR:-$ROOT/target}/bench-baselines/$VERSION"
+mkdir -p "$SAVE"
+awk -F'\t' '
+    $1 != "FFI" { next }
+    $2 == "rust" { rust[$3] = $5 }
+    $2 == "cpp" { cpp[$3] = $5; order[++n] = $3 }
+    END {
+        print "case\trust_ns\tcpp_ns\toverhead_ns\tratio"
+        for (i = 1; i <= n; i++) {
+            c = order[i]; r = rust[c]
+            # _write variants compare against the same Rust call.
+            if (r == "") { base = c; sub(/_write$/, "", base); r = rust[base] }
+            if (r == "") { printf "%s\t-\t%s\t-\t-\n", c, cpp[c]; continue }
+            printf "%s\t%s\t%s\t%.1f\t%.2fx\n", c, r, cpp[c], cpp[c] - r, (r > 0 ? cpp[c] / r : 0)
+        }
+    }' "$OUT/rust.tsv" "$OUT/cpp.tsv" | tee "$SAVE/ffi_overhead.tsv" | column -t -s $'\t'
@@ -0,0 +1,113 @@
+//! Meshing and rendering a corner of the corpus world with a real resource
+//! pack. The pack is taken from `MINECRAFT_RESOURCE_PACK`, as in the
+//! examples; without it the bench prints a note and measures nothing.
+//!
+//! `NUCLEATION_BENCH_MESH_CHUNKS` sets the side of the meshed area in chunks
+//! (default 8). With the `rendering` feature the meshes are also rendered
+//! headless; that part is skipped when no GPU adapter is available.
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion, Throughput};
+use nucleation::formats::world::from_world_directory_bounded;
+use nucleation::meshing::{MeshConfig, MeshOutput, ResourcePackSource};
+use nucleation::UniversalSchematic;
+
+#[path = "support/alloc_count.rs"]
+mod alloc_count;
+#[path = "support/baseline.rs"]
+mod baseline;
+#[path = "support/corpus.rs"]
+mod corpus;
+
+const BENCH: &str = "mesh_bench";
+
+fn threads() -> usize {
+    std::thread::available_parallelism().map_or(4, |n| n.get())
+}
+
+fn pack() -> Option<ResourcePackSource> {
+    let Ok(path) = std::env::var("MINECRAFT_RESOURCE_PACK") else {
+        eprintln!("SKIP\tmesh_bench: set MINECRAFT_RESOURCE_PACK to a resource pack zip");
+        return None;
+    };
+    Some(ResourcePackSource::from_file(&path).expect("load resource pack"))
+}
+
+/// The corpus's `side` × `side` chunk corner as one schematic.
+fn area() -> (UniversalSchematic, u64) {
+    let side: i32 = std::env::var("NUCLEATION_BENCH_MESH_CHUNKS")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .unwrap_or(8);
+    let corpus = corpus::world();
+    let side = side.clamp(1, corpus.side);
+    let max = side * 16 - 1;
+    let schematic =
+        from_world_directory_bounded(&corpus.dir, 0, corpus::MIN_Y, 0, max, corpus::MAX_Y, max)
+            .expect("import corpus area");
+    (schematic, (side * side) as u64)
+}
+
+fn mesh(schematic: &UniversalSchematic, pack: &ResourcePackSource) -> Vec<MeshOutput> {
+    schematic
+        .mesh_chunks_parallel(pack, &MeshConfig::default(), 16, threads())
+        .expect("mesh")
+}
+
+fn bench_mesh(c: &mut Criterion) {
+    let Some(pack) = pack() else {
+        return;
+    };
+    let (schematic, columns) = area();
+
+    let mut group = c.benchmark_group("mesh_chunks_parallel");
+    group.sample_size(10);
+    group.throughput(Throughput::Elements(columns));
+    group.bench_function("corpus", |b| b.iter(|| black_box(mesh(&schematic, &pack))));
+    group.finish();
+
+    let meshes = baseline::measure(BENCH, "mesh.corpus", columns, "columns", || {
+        mesh(&schematic, &pack)
+    });
+
+    #[cfg(feature = "rendering")]
+    bench_render(c, &meshes);
+    #[cfg(not(feature = "rendering"))]
+    drop(meshes);
+}
+
+#[cfg(feature = "rendering")]
+fn bench_render(c: &mut Criterion, meshes: &[MeshOutput]) {
+    use nucleation::rendering::{RenderConfig, RenderSession};
+
+    const SIZE: u32 = 1024;
+    let mut session = match RenderSession::new(meshes, SIZE, SIZE, None) {
+        Ok(session) => session,
+        Err(e) => {
+            eprintln!("SKIP\trender: {e}");
+            return;
+        }
+    };
+    let config = RenderConfig {
+        width: SIZE,
+        height: SIZE,
+        ..RenderConfig::default()
+    };
+
+    let mut group = c.benchmark_group("render_frame");
+    group.sample_size(20);
+    group.throughput(Throughput::Elements(1));
+    group.bench_function("corpus", |b| {
+        b.iter(|| black_box(session.render(&config).expect("render")))
+    });
+    group.finish();
+
+    const FRAMES: u64 = 16;
+    baseline::measure(BENCH, "render.corpus", FRAMES, "frames", || {
+        for _ in 0..FRAMES {
+            black_box(session.render(&config).expect("render"));
+        }
+    });
+}
+
+criterion_group!(benches, bench_mesh);
+criterion_main!(benches);
@@ -1,6 +1,12 @@
-use criterion::{criterion_group, criterion_main, Criterion};
+use criterion::{black_box, criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use flate2::Compression;
+use nucleation::formats::manager::get_manager;
+use nucleation::formats::schematic::{from_schematic, to_schematic_with_options, SchematicVersion};
 use nucleation::{BlockState, Region, UniversalSchematic};
 
+#[path = "support/alloc_count.rs"]
+mod alloc_count;
+
 fn benchmark_schematic_creation(c: &mut Criterion) {
     c.bench_function("create schematic", |b| {
         b.iter(|| UniversalSchematic::new("Test Schematic".to_string()))
@@ -62,11 +68,100 @@ fn benchmark_big_schematic_creation_with_region_prealloc(c: &mut Criterion) {
     });
 }
 
+/// A 64³ schematic cycling through `palette_len` blocks, so every index is
+/// a single-byte varint below 128 entries and mostly two bytes above.
+fn make_palette_schematic(palette_len: usize) -> UniversalSchematic {
+    let mut schematic = UniversalSchematic::new("Bench".to_string());
+    schematic.add_region(Region::new("Main".to_string(), (0, 0, 0), (64, 64, 64)));
+    let blocks: Vec<BlockState> = (0..palette_len)
+        .map(|i| BlockState::new(format!("minecraft:block_{}", i)))
+        .collect();
+    let mut i = 0;
+    for y in 0..64 {
+        for z in 0..64 {
+            for x in 0..64 {
+                schematic.set_block(x, y, z, &blocks[i % palette_len]);
+                i += 1;
+            }
+        }
+    }
+    schematic
+}
+
+fn benchmark_block_data_varints(c: &mut Criterion) {
+    let mut group = c.benchmark_group("schematic block data varints");
+    for palette_len in [64, 1000] {
+        let schematic = make_palette_schematic(palette_len);
+        // Uncompressed so gzip does not hide the block data codec.
+        let data = alloc_count::report(&format!("encode/{palette_len}"), || {
+            to_schematic_with_options(&schematic, SchematicVersion::V3, Compression::none())
+                .unwrap()
+        });
+        alloc_count::report(&format!("decode/{palette_len}"), || {
+            from_schematic(&data).unwrap()
+        });
+        group.bench_with_input(
+            BenchmarkId::new("encode", palette_len),
+            &schematic,
+            |b, schematic| {
+                b.iter(|| {
+                    to_schematic_with_options(
+                        black_box(schematic),
+                        SchematicVersion::V3,
+                        Compression::none(),
+                    )
+                    .unwrap()
+                })
+            },
+        );
+        group.bench_with_input(BenchmarkId::new("decode", palette_len), &data, |b, data| {
+            b.iter(|| from_schematic(black_box(data)).unwrap())
+        });
+    }
+    group.finish();
+}
+
+/// Loads through the shared format registry from several threads at once.
+/// Loads only contend on the read lock that clones the registry snapshot,
+/// so per-load time should stay flat as threads are added.
+fn benchmark_concurrent_registry_loads(c: &mut Criterion) {
+    const LOADS_PER_THREAD: usize = 16;
+    let mut schematic = UniversalSchematic::new("Bench".to_string());
+    let stone = BlockState::new("minecraft:stone".to_string());
+    for i in 0..16 * 16 * 16 {
+        schematic.set_block(i % 16, i / 256, (i / 16) % 16, &stone);
+    }
+    let data =
+        to_schematic_with_options(&schematic, SchematicVersion::V3, Compression::fast()).unwrap();
+
+    let mut group = c.benchmark_group("registry loads");
+    alloc_count::report("registry load", || get_manager().read(&data).unwrap());
+    for threads in [1, 4, 16] {
+        group.throughput(Throughput::Elements((threads * LOADS_PER_THREAD) as u64));
+        group.bench_with_input(BenchmarkId::new("threads", threads), &data, |b, data| {
+            b.iter(|| {
+                std::thread::scope(|scope| {
+                    for _ in 0..threads {
+                        scope.spawn(|| {
+                            for _ in 0..LOADS_PER_THREAD {
+                                black_box(get_manager().read(black_box(data)).unwrap());
+                            }
+                        });
+                    }
+                })
+            })
+        });
+    }
+    group.finish();
+}
+
 criterion_group!(
     benches,
     benchmark_schematic_creation,
     benchmark_block_setting,
     benchmark_big_schematic_creation,
-    benchmark_big_schematic_creation_with_region_prealloc
+    benchmark_big_schematic_creation_with_region_prealloc,
+    benchmark_block_data_varints,
+    benchmark_concurrent_registry_loads
 );
 criterion_main!(benches);
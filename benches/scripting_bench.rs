@@ -105,6 +105,19 @@ fn js_fill_and_export(n: i32) {
     nucleation::scripting::js_engine::run_js_code(&code).unwrap();
 }
 
+/// Scenario 4: A script too small to matter, so VM startup dominates
+const TINY_LUA: &str = r#"
+    local s = Schematic.new("bench")
+    s:set_block(0, 0, 0, "minecraft:stone")
+    result = s
+"#;
+
+const TINY_JS: &str = r#"
+    let s = new Schematic("bench");
+    s.set_block(0, 0, 0, "minecraft:stone");
+    result = s;
+"#;
+
 // --- Criterion benchmarks ---
 
 fn bench_set_blocks(c: &mut Criterion) {
@@ -155,10 +168,32 @@ fn bench_fill_and_export(c: &mut Criterion) {
     group.finish();
 }
 
+/// Cold runs build and set up a VM per call; warm runs reuse a
+/// `ScriptContext`'s VM and only reset its globals.
+fn bench_startup(c: &mut Criterion) {
+    let mut group = c.benchmark_group("startup");
+    group.bench_function("lua/cold", |b| {
+        b.iter(|| nucleation::scripting::lua_engine::run_lua_code(TINY_LUA).unwrap())
+    });
+    group.bench_function("lua/warm", |b| {
+        let mut context = nucleation::scripting::ScriptContext::new();
+        b.iter(|| context.run_code("lua", TINY_LUA).unwrap())
+    });
+    group.bench_function("js/cold", |b| {
+        b.iter(|| nucleation::scripting::js_engine::run_js_code(TINY_JS).unwrap())
+    });
+    group.bench_function("js/warm", |b| {
+        let mut context = nucleation::scripting::ScriptContext::new();
+        b.iter(|| context.run_code("js", TINY_JS).unwrap())
+    });
+    group.finish();
+}
+
 criterion_group!(
     benches,
     bench_set_blocks,
     bench_fill_cuboid,
-    bench_fill_and_export
+    bench_fill_and_export,
+    bench_startup
 );
 criterion_main!(benches);
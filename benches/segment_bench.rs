@@ -0,0 +1,76 @@
+//! World segmentation over the corpus world: every region streamed through
+//! `WorldSourceTiles`, segmented, stitched and materialized. The corpus
+//! scatters small builds on natural terrain, so every stage has work.
+
+use std::collections::BTreeSet;
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion, Throughput};
+use nucleation::formats::world_stream::WorldSource;
+use nucleation::world_segment::partition::PartitionIndex;
+use nucleation::world_segment::profile::WorldProfile;
+use nucleation::world_segment::runner::{SegmentJob, WorldSegmenter};
+use nucleation::world_segment::score::ScoreConfig;
+use nucleation::world_segment::segment::SegConfig;
+use nucleation::world_segment::spill::SpillConfig;
+use nucleation::world_segment::world_source::WorldSourceTiles;
+
+#[path = "support/alloc_count.rs"]
+mod alloc_count;
+#[path = "support/baseline.rs"]
+mod baseline;
+#[path = "support/corpus.rs"]
+mod corpus;
+
+const BENCH: &str = "segment_bench";
+
+fn segment(corpus: &corpus::Corpus) -> u64 {
+    let source = WorldSourceTiles::new(
+        WorldSource::open_dir(&corpus.dir).expect("open corpus"),
+        corpus::MIN_Y,
+        corpus::MAX_Y,
+    );
+    let profile = WorldProfile::new(
+        corpus::TERRAIN
+            .iter()
+            .map(|name| name.to_string())
+            .collect::<BTreeSet<_>>(),
+        (corpus::MIN_Y, 90),
+    );
+    let job = SegmentJob {
+        config: SegConfig::default(),
+        score_config: ScoreConfig::default(),
+        source_id: "bench-corpus".to_string(),
+        snapshot_id: "bench".to_string(),
+        min_y: corpus::MIN_Y,
+        max_y: corpus::MAX_Y,
+        extracted_at: 0,
+        match_iou: 0.5,
+        spill: SpillConfig::default(),
+    };
+    let stats = WorldSegmenter::run_streaming(
+        &source,
+        &profile,
+        &PartitionIndex::new(vec![]),
+        &job,
+        &[],
+        &mut |build| drop(black_box(build)),
+    );
+    stats.builds
+}
+
+fn bench_segment(c: &mut Criterion) {
+    let corpus = corpus::world();
+
+    let mut group = c.benchmark_group("world_segment");
+    group.sample_size(10);
+    group.throughput(Throughput::Elements(corpus.chunks));
+    group.bench_function("corpus", |b| b.iter(|| black_box(segment(&corpus))));
+    group.finish();
+
+    baseline::measure(BENCH, "segment.corpus", corpus.chunks, "chunks", || {
+        segment(&corpus)
+    });
+}
+
+criterion_group!(benches, bench_segment);
+criterion_main!(benches);
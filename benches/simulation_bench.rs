@@ -0,0 +1,207 @@
+//! Redpiler-backed simulation throughput: compile time, raw ticks, executor
+//! latency and batch throughput, and the cost of syncing state back to the
+//! schematic. Circuits are built in code (long wires, repeater chains) plus
+//! the connect4 and ALU samples under `tests/samples`.
+
+use criterion::{
+    black_box, criterion_group, criterion_main, BatchSize, BenchmarkId, Criterion, Throughput,
+};
+use nucleation::formats::mcstructure::from_mcstructure;
+use nucleation::formats::schematic::from_schematic;
+use nucleation::simulation::typed_executor::{
+    ExecutionMode, ExecutorPool, InputBatch, IoMapping, IoType, LayoutFunction,
+    TypedCircuitExecutor, Value,
+};
+use nucleation::simulation::{BlockPos, MchprsWorld};
+use nucleation::{SchematicBuilder, UniversalSchematic};
+use std::collections::HashMap;
+use std::path::PathBuf;
+
+/// Lever at x=0, `len` wires, lamp at the end.
+fn long_wire(len: i32) -> UniversalSchematic {
+    let mut schematic = UniversalSchematic::new("long_wire".to_string());
+    for x in 0..=len + 1 {
+        schematic.set_block_str(x, 0, 0, "minecraft:gray_concrete");
+    }
+    schematic.set_block_str(
+        0,
+        1,
+        0,
+        "minecraft:lever[facing=east,powered=false,face=floor]",
+    );
+    for x in 1..=len {
+        schematic.set_block_str(x, 1, 0, "minecraft:redstone_wire[power=0]");
+    }
+    schematic.set_block_str(len + 1, 1, 0, "minecraft:redstone_lamp[lit=false]");
+    schematic
+}
+
+/// `repeaters` repeaters separated by wire, input wire at z=2n, output at z=0.
+fn repeater_chain(repeaters: usize) -> UniversalSchematic {
+    let mut template = String::from("# Base layer\n");
+    template.push_str(&"c\n".repeat(2 * repeaters + 1));
+    template.push_str("# Logic layer\n│\n");
+    template.push_str(&"↑\n│\n".repeat(repeaters));
+    SchematicBuilder::from_template(&template)
+        .expect("Failed to parse template")
+        .use_standard_palette()
+        .build()
+        .expect("Failed to build schematic")
+}
+
+fn repeater_executor(repeaters: usize) -> TypedCircuitExecutor {
+    let port = |z: i32| IoMapping {
+        io_type: IoType::Boolean,
+        layout: LayoutFunction::OneToOne,
+        positions: vec![(0, 1, z)],
+    };
+    let inputs = HashMap::from([("in".to_string(), port(2 * repeaters as i32))]);
+    let outputs = HashMap::from([("out".to_string(), port(0))]);
+    let world = MchprsWorld::new(repeater_chain(repeaters)).expect("Failed to create world");
+    TypedCircuitExecutor::new(world, inputs, outputs)
+}
+
+/// Sample circuits that load and compile, by name.
+fn samples() -> Vec<(&'static str, UniversalSchematic)> {
+    let dir = PathBuf::from(env!("CARGO_MANIFEST_DIR")).join("tests/samples");
+    let mut samples = Vec::new();
+    for name in ["c4_ai_last_played.schem", "8-bit_alu.mcstructure"] {
+        let Ok(data) = std::fs::read(dir.join(name)) else {
+            continue;
+        };
+        let schematic = if name.ends_with(".schem") {
+            from_schematic(&data).ok()
+        } else {
+            from_mcstructure(&data).ok()
+        };
+        match schematic {
+            Some(schematic) if MchprsWorld::new(schematic.clone()).is_ok() => {
+                samples.push((name, schematic))
+            }
+            _ => eprintln!("Skipping sample {} (does not load or compile)", name),
+        }
+    }
+    samples
+}
+
+fn bench_compile(c: &mut Criterion) {
+    let mut group = c.benchmark_group("simulation/compile");
+    group.sample_size(20);
+    let mut circuits = vec![
+        ("long_wire_64".to_string(), long_wire(64)),
+        ("repeater_chain_64".to_string(), repeater_chain(64)),
+    ];
+    circuits.extend(samples().into_iter().map(|(n, s)| (n.to_string(), s)));
+    for (name, schematic) in &circuits {
+        group.bench_with_input(BenchmarkId::from_parameter(name), schematic, |b, s| {
+            b.iter_batched(
+                || s.clone(),
+                |s| MchprsWorld::new(s).unwrap(),
+                BatchSize::LargeInput,
+            )
+        });
+    }
+    group.finish();
+}
+
+fn bench_ticks(c: &mut Criterion) {
+    const TICKS: u32 = 1000;
+    let mut group = c.benchmark_group("simulation/ticks");
+    group.throughput(Throughput::Elements(TICKS as u64));
+    let mut circuits = vec![
+        ("long_wire_64", long_wire(64), Some(BlockPos::new(0, 1, 0))),
+        ("repeater_chain_64", repeater_chain(64), None),
+    ];
+    circuits.extend(samples().into_iter().map(|(n, s)| (n, s, None)));
+    for (name, schematic, lever) in circuits {
+        let mut world = MchprsWorld::new(schematic).unwrap();
+        group.bench_function(name, |b| {
+            b.iter(|| {
+                // Keep the circuit busy where it has a lever to toggle.
+                if let Some(lever) = lever {
+                    world.on_use_block(lever);
+                }
+                world.tick(TICKS);
+                world.flush();
+            })
+        });
+    }
+    group.finish();
+}
+
+fn bench_execute(c: &mut Criterion) {
+    let mut group = c.benchmark_group("simulation/execute");
+    group.sample_size(20);
+    for repeaters in [8, 64] {
+        let mut executor = repeater_executor(repeaters);
+        let mode = ExecutionMode::FixedTicks {
+            ticks: 2 * repeaters as u32 + 2,
+        };
+        let mut on = false;
+        group.bench_function(BenchmarkId::new("stateless", repeaters), |b| {
+            b.iter(|| {
+                on = !on;
+                let inputs = HashMap::from([("in".to_string(), Value::Bool(on))]);
+                black_box(executor.execute(inputs, mode.clone()).unwrap())
+            })
+        });
+    }
+    group.finish();
+}
+
+fn bench_batch(c: &mut Criterion) {
+    const ROWS: usize = 256;
+    let mut group = c.benchmark_group("simulation/batch");
+    group.sample_size(10);
+    group.throughput(Throughput::Elements(ROWS as u64));
+    let mut executor = repeater_executor(8);
+    let mode = ExecutionMode::FixedTicks { ticks: 20 };
+    let mut batch = InputBatch::new(ROWS);
+    batch
+        .set_column("in", (0..ROWS as u64).map(|i| i & 1).collect())
+        .unwrap();
+
+    group.bench_function("single_executor", |b| {
+        b.iter(|| black_box(executor.execute_batch(&batch, &mode).unwrap()))
+    });
+    let pool = ExecutorPool::from_executor(&executor, 0).unwrap();
+    group.bench_function(BenchmarkId::new("pool", pool.worker_count()), |b| {
+        b.iter(|| black_box(pool.execute_batch(&batch, &mode).unwrap()))
+    });
+    group.finish();
+}
+
+fn bench_sync(c: &mut Criterion) {
+    let mut group = c.benchmark_group("simulation/sync");
+    for len in [16, 256] {
+        let schematic = long_wire(len);
+        group.bench_with_input(BenchmarkId::new("full", len), &schematic, |b, s| {
+            b.iter_batched(
+                || MchprsWorld::new(s.clone()).unwrap(),
+                |mut world| world.sync_to_schematic(),
+                BatchSize::LargeInput,
+            )
+        });
+
+        let mut world = MchprsWorld::new(schematic).unwrap();
+        world.sync_to_schematic();
+        group.bench_function(BenchmarkId::new("after_toggle", len), |b| {
+            b.iter(|| {
+                world.on_use_block(BlockPos::new(0, 1, 0));
+                world.tick(2);
+                black_box(world.sync_changes())
+            })
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_compile,
+    bench_ticks,
+    bench_execute,
+    bench_batch,
+    bench_sync
+);
+criterion_main!(benches);
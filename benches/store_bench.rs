@@ -0,0 +1,94 @@
+//! Store round-trips: batched puts then gets of chunk-sized blobs through
+//! `store::open`, so the `TracedStore` wrapper every caller gets is part of
+//! the measurement. Payloads are the corpus's own region files cut into
+//! 16 KiB pieces, which compress like real chunk data.
+//!
+//! `mem://`, `cas://mem://` and a scratch `file://` store always run. Set
+//! `NUCLEATION_BENCH_STORE_URLS` to a comma-separated list to add others
+//! (e.g. a local Redis or MinIO), with their features enabled.
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion, Throughput};
+use nucleation::store::{self, Store};
+
+#[path = "support/alloc_count.rs"]
+mod alloc_count;
+#[path = "support/baseline.rs"]
+mod baseline;
+#[path = "support/corpus.rs"]
+mod corpus;
+
+const BENCH: &str = "store_bench";
+const BLOB: usize = 16 * 1024;
+const BLOBS: usize = 1024;
+
+fn payloads() -> Vec<(String, Vec<u8>)> {
+    let corpus = corpus::world();
+    let region =
+        std::fs::read(corpus.dir.join("region").join("r.0.0.mca")).expect("read corpus region");
+    region
+        .chunks(BLOB)
+        .cycle()
+        .take(BLOBS)
+        .enumerate()
+        .map(|(i, blob)| (format!("bench/{:02x}/{i:06}", i % 256), blob.to_vec()))
+        .collect()
+}
+
+fn urls() -> Vec<String> {
+    let mut urls = vec!["mem://".to_string(), "cas://mem://".to_string()];
+    if cfg!(feature = "store-fs") {
+        let dir = corpus::scratch_dir("store");
+        urls.push(format!("file://{}", dir.display()));
+    }
+    if let Ok(extra) = std::env::var("NUCLEATION_BENCH_STORE_URLS") {
+        urls.extend(
+            extra
+                .split(',')
+                .map(str::trim)
+                .filter(|u| !u.is_empty())
+                .map(String::from),
+        );
+    }
+    urls
+}
+
+/// Put every payload in one batch, then read them all back in one batch.
+fn round_trip(store: &dyn Store, payloads: &[(String, Vec<u8>)]) -> usize {
+    let items: Vec<(&str, &[u8])> = payloads
+        .iter()
+        .map(|(k, v)| (k.as_str(), v.as_slice()))
+        .collect();
+    store.put_many(&items).expect("put_many");
+    let keys: Vec<&str> = items.iter().map(|(k, _)| *k).collect();
+    let read = store.get_many(&keys).expect("get_many");
+    read.iter().flatten().map(Vec::len).sum()
+}
+
+fn bench_store(c: &mut Criterion) {
+    let payloads = payloads();
+    let bytes: u64 = payloads.iter().map(|(_, v)| v.len() as u64).sum();
+
+    let mut group = c.benchmark_group("store_round_trip");
+    group.sample_size(10);
+    group.throughput(Throughput::Bytes(bytes));
+    for url in urls() {
+        let store = match store::open(&url) {
+            Ok(store) => store,
+            Err(e) => {
+                eprintln!("SKIP\t{url}: {e}");
+                continue;
+            }
+        };
+        let scheme = url.split("://").next().unwrap_or(&url).to_string();
+        group.bench_function(&scheme, |b| {
+            b.iter(|| black_box(round_trip(store.as_ref(), &payloads)))
+        });
+        baseline::measure(BENCH, &format!("store.{scheme}"), bytes, "bytes", || {
+            round_trip(store.as_ref(), &payloads)
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_store);
+criterion_main!(benches);
@@ -0,0 +1,102 @@
+//! Counting wrapper around the system allocator, so a bench can print how
+//! many allocations one run of its workload makes next to criterion's times.
+//!
+//! Including the module installs the counter. It stands aside when an
+//! allocator feature is on, since the library's `#[global_allocator]` would
+//! clash with it, and [`report`] then prints nothing.
+//!
+//! Besides totals it tracks live heap bytes and their high-water mark, which
+//! [`measure`] reports per run.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::sync::atomic::{AtomicU64, Ordering};
+
+pub struct CountingAlloc;
+
+#[cfg(not(any(feature = "mimalloc", feature = "jemalloc")))]
+#[global_allocator]
+static GLOBAL: CountingAlloc = CountingAlloc;
+
+static ALLOCATIONS: AtomicU64 = AtomicU64::new(0);
+static BYTES: AtomicU64 = AtomicU64::new(0);
+static LIVE: AtomicU64 = AtomicU64::new(0);
+static PEAK: AtomicU64 = AtomicU64::new(0);
+
+fn grow(bytes: usize) {
+    let live = LIVE.fetch_add(bytes as u64, Ordering::Relaxed) + bytes as u64;
+    PEAK.fetch_max(live, Ordering::Relaxed);
+}
+
+fn shrink(bytes: usize) {
+    LIVE.fetch_sub(bytes as u64, Ordering::Relaxed);
+}
+
+unsafe impl GlobalAlloc for CountingAlloc {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        BYTES.fetch_add(layout.size() as u64, Ordering::Relaxed);
+        grow(layout.size());
+        System.alloc(layout)
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        BYTES.fetch_add(layout.size() as u64, Ordering::Relaxed);
+        grow(layout.size());
+        System.alloc_zeroed(layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        BYTES.fetch_add(new_size as u64, Ordering::Relaxed);
+        shrink(layout.size());
+        grow(new_size);
+        System.realloc(ptr, layout, new_size)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        shrink(layout.size());
+        System.dealloc(ptr, layout)
+    }
+}
+
+/// What one run of a workload allocated.
+#[derive(Clone, Copy, Debug)]
+pub struct AllocStats {
+    pub count: u64,
+    pub bytes: u64,
+    /// Highest live heap during the run, above what was live when it began.
+    pub peak_bytes: u64,
+}
+
+/// Run `f` once and return what it allocated, or `None` when an allocator
+/// feature displaced the counter.
+pub fn measure<T>(f: impl FnOnce() -> T) -> (T, Option<AllocStats>) {
+    if cfg!(any(feature = "mimalloc", feature = "jemalloc")) {
+        return (f(), None);
+    }
+    let (count, bytes) = (
+        ALLOCATIONS.load(Ordering::Relaxed),
+        BYTES.load(Ordering::Relaxed),
+    );
+    let base = LIVE.load(Ordering::Relaxed);
+    PEAK.store(base, Ordering::Relaxed);
+    let out = f();
+    let stats = AllocStats {
+        count: ALLOCATIONS.load(Ordering::Relaxed) - count,
+        bytes: BYTES.load(Ordering::Relaxed) - bytes,
+        peak_bytes: PEAK.load(Ordering::Relaxed).saturating_sub(base),
+    };
+    (out, Some(stats))
+}
+
+/// Run `f` once and print its allocation count and allocated bytes to
+/// stderr as `ALLOCS\t<label>\t<count>\t<bytes>`. Allocations on other
+/// threads during the run are counted too.
+pub fn report<T>(label: &str, f: impl FnOnce() -> T) -> T {
+    let (out, stats) = measure(f);
+    if let Some(stats) = stats {
+        eprintln!("ALLOCS\t{label}\t{}\t{}", stats.count, stats.bytes);
+    }
+    out
+}
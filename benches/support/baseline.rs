@@ -0,0 +1,142 @@
+//! Machine-readable bench results, kept per release so runs can be compared.
+//!
+//! Criterion's own numbers come from many short iterations; [`measure`] adds
+//! one instrumented run of the same workload and records its wall time,
+//! throughput, allocations (via [`alloc_count`](super::alloc_count)) and peak
+//! RSS. Records go to `<target>/bench-baselines/<baseline>/<bench>.json`,
+//! one object per label, where `<baseline>` is `NUCLEATION_BENCH_BASELINE`
+//! or the crate version. Re-running a bench replaces its labels and keeps
+//! the rest.
+//!
+//! With `NUCLEATION_BENCH_COMPARE=<baseline>` set, each measurement is also
+//! printed against the same label in that baseline.
+//!
+//! Requires the including bench to declare `mod alloc_count` beside it.
+
+#![allow(dead_code)]
+
+use std::collections::BTreeMap;
+use std::path::PathBuf;
+use std::sync::Mutex;
+use std::time::Instant;
+
+use serde_json::{json, Value};
+
+use super::alloc_count;
+
+/// The cargo target directory, honouring `CARGO_TARGET_DIR`.
+pub fn target_dir() -> PathBuf {
+    std::env::var_os("CARGO_TARGET_DIR")
+        .map(PathBuf::from)
+        .unwrap_or_else(|| PathBuf::from(env!("CARGO_MANIFEST_DIR")).join("target"))
+}
+
+fn baseline_dir(name: &str) -> PathBuf {
+    target_dir().join("bench-baselines").join(name)
+}
+
+fn current_baseline() -> String {
+    std::env::var("NUCLEATION_BENCH_BASELINE")
+        .unwrap_or_else(|_| env!("CARGO_PKG_VERSION").to_string())
+}
+
+fn load(path: &PathBuf) -> BTreeMap<String, Value> {
+    std::fs::read(path)
+        .ok()
+        .and_then(|bytes| serde_json::from_slice(&bytes).ok())
+        .unwrap_or_default()
+}
+
+/// Records of this process, by bench, merged over what was on disk.
+static RECORDS: Mutex<BTreeMap<String, BTreeMap<String, Value>>> = Mutex::new(BTreeMap::new());
+
+/// Peak resident set size in KiB since the last [`reset_peak_rss`]. Linux
+/// only; `None` elsewhere.
+pub fn peak_rss_kib() -> Option<u64> {
+    let status = std::fs::read_to_string("/proc/self/status").ok()?;
+    status
+        .lines()
+        .find_map(|line| line.strip_prefix("VmHWM:"))
+        .and_then(|rest| rest.trim().trim_end_matches("kB").trim().parse().ok())
+}
+
+/// Reset the kernel's RSS high-water mark to the current RSS, so the next
+/// [`peak_rss_kib`] covers only what follows. Best effort: a no-op where
+/// `/proc/self/clear_refs` is missing or read-only.
+pub fn reset_peak_rss() {
+    let _ = std::fs::write("/proc/self/clear_refs", "5");
+}
+
+/// Run `f` once, instrumented, and record it under `bench`/`label`.
+/// `elements` is the amount of work in `unit`s (chunks, blocks, bytes), from
+/// which throughput is derived.
+pub fn measure<T>(bench: &str, label: &str, elements: u64, unit: &str, f: impl FnOnce() -> T) -> T {
+    reset_peak_rss();
+    let started = Instant::now();
+    let (out, allocs) = alloc_count::measure(f);
+    let seconds = started.elapsed().as_secs_f64();
+    let peak_rss = peak_rss_kib();
+
+    let record = json!({
+        "elements": elements,
+        "unit": unit,
+        "seconds": seconds,
+        "throughput": if seconds > 0.0 { elements as f64 / seconds } else { 0.0 },
+        "allocations": allocs.map(|a| a.count),
+        "allocated_bytes": allocs.map(|a| a.bytes),
+        "peak_heap_bytes": allocs.map(|a| a.peak_bytes),
+        "peak_rss_kib": peak_rss,
+    });
+    eprintln!(
+        "BASELINE\t{bench}/{label}\t{:.3}s\t{:.1} {unit}/s\tallocs {}\tpeak rss {} KiB",
+        seconds,
+        record["throughput"].as_f64().unwrap_or(0.0),
+        allocs.map_or("-".to_string(), |a| a.count.to_string()),
+        peak_rss.map_or("-".to_string(), |kib| kib.to_string()),
+    );
+    compare(bench, label, &record);
+    save(bench, label, record);
+    out
+}
+
+fn save(bench: &str, label: &str, record: Value) {
+    let dir = baseline_dir(&current_baseline());
+    let path = dir.join(format!("{bench}.json"));
+    let mut records = RECORDS.lock().unwrap_or_else(|e| e.into_inner());
+    let records = records
+        .entry(bench.to_string())
+        .or_insert_with(|| load(&path));
+    records.insert(label.to_string(), record);
+    let written = std::fs::create_dir_all(&dir).and_then(|()| {
+        std::fs::write(
+            &path,
+            serde_json::to_vec_pretty(&*records).expect("records serialize"),
+        )
+    });
+    if let Err(e) = written {
+        eprintln!("BASELINE\tcannot write {}: {e}", path.display());
+    }
+}
+
+fn compare(bench: &str, label: &str, record: &Value) {
+    let Ok(other) = std::env::var("NUCLEATION_BENCH_COMPARE") else {
+        return;
+    };
+    let old = load(&baseline_dir(&other).join(format!("{bench}.json")));
+    let Some(old) = old.get(label) else {
+        eprintln!("COMPARE\t{bench}/{label}\tnot in baseline {other}");
+        return;
+    };
+    let ratio = |key: &str| match (old[key].as_f64(), record[key].as_f64()) {
+        (Some(before), Some(now)) if before > 0.0 => {
+            format!("{:+.1}%", (now / before - 1.0) * 100.0)
+        }
+        _ => "-".to_string(),
+    };
+    eprintln!(
+        "COMPARE\t{bench}/{label}\tvs {other}\tthroughput {}\tallocs {}\tpeak rss {}",
+        ratio("throughput"),
+        ratio("allocations"),
+        ratio("peak_rss_kib"),
+    );
+}
@@ -0,0 +1,275 @@
+//! Reproducible large-world corpus for the end-to-end benches.
+//!
+//! [`world`] generates an Anvil world of `NUCLEATION_BENCH_REGIONS` ×
+//! `NUCLEATION_BENCH_REGIONS` regions (default 1, i.e. 32 × 32 chunks) under
+//! `<target>/bench-corpus/`, and reuses it on later runs. Everything derives
+//! from a fixed seed through an integer hash, so the same size always yields
+//! byte-identical region files on every machine.
+//!
+//! The terrain is rolling stone, dirt and grass from y 0 to roughly y 80 with
+//! scattered ores, and every few chunks a small build (plank house with glass
+//! and a redstone line) sits on the surface, so the corpus exercises mixed
+//! palettes, dense sections and structures worth segmenting.
+//!
+//! Requires the including bench to declare `mod baseline` beside it.
+
+#![allow(dead_code)]
+
+use std::path::PathBuf;
+
+use nucleation::formats::world_pack::Placement;
+use nucleation::formats::world_stream::{WorldChunkView, WorldSink};
+use nucleation::{BlockState, UniversalSchematic};
+
+use super::baseline::target_dir;
+
+const SEED: u64 = 0x6e75_636c_6561_7465;
+
+/// Terrain floor. Everything below is left empty.
+pub const MIN_Y: i32 = 0;
+/// Highest block the generator can place.
+pub const MAX_Y: i32 = 127;
+
+/// Blocks the generator treats as natural ground.
+pub const TERRAIN: &[&str] = &[
+    "minecraft:bedrock",
+    "minecraft:stone",
+    "minecraft:dirt",
+    "minecraft:grass_block",
+    "minecraft:coal_ore",
+    "minecraft:iron_ore",
+    "minecraft:gravel",
+];
+
+pub struct Corpus {
+    pub dir: PathBuf,
+    /// Chunk columns per side.
+    pub side: i32,
+    pub chunks: u64,
+}
+
+impl Corpus {
+    /// Block-space footprint of the world, for bounded imports.
+    pub fn blocks_per_side(&self) -> i32 {
+        self.side * 16
+    }
+}
+
+/// The corpus world, generated on first use.
+pub fn world() -> Corpus {
+    let regions: i32 = std::env::var("NUCLEATION_BENCH_REGIONS")
+        .ok()
+        .and_then(|v| v.parse().ok())
+        .filter(|&n| n > 0)
+        .unwrap_or(1);
+    let side = regions * 32;
+    let dir = target_dir()
+        .join("bench-corpus")
+        .join(format!("world-{regions}x{regions}-{SEED:x}"));
+    let corpus = Corpus {
+        chunks: (side as u64) * (side as u64),
+        dir,
+        side,
+    };
+    if !corpus.dir.join("corpus.done").is_file() {
+        generate(&corpus);
+    }
+    corpus
+}
+
+/// An empty scratch directory under the target dir, for benches that write.
+pub fn scratch_dir(name: &str) -> PathBuf {
+    let dir = target_dir().join("bench-scratch").join(name);
+    let _ = std::fs::remove_dir_all(&dir);
+    std::fs::create_dir_all(&dir).expect("create scratch dir");
+    dir
+}
+
+fn generate(corpus: &Corpus) {
+    eprintln!(
+        "CORPUS\tgenerating {} chunks in {}",
+        corpus.chunks,
+        corpus.dir.display()
+    );
+    let _ = std::fs::remove_dir_all(&corpus.dir);
+    let blocks = Blocks::new();
+    let mut sink = WorldSink::create(&corpus.dir, None).expect("create corpus world");
+    for cx in 0..corpus.side {
+        for cz in 0..corpus.side {
+            sink.write_chunk(&chunk(&blocks, cx, cz))
+                .expect("write corpus chunk");
+        }
+    }
+    sink.finish().expect("finish corpus world");
+    std::fs::write(corpus.dir.join("corpus.done"), corpus.chunks.to_string())
+        .expect("mark corpus done");
+}
+
+struct Blocks {
+    bedrock: BlockState,
+    stone: BlockState,
+    dirt: BlockState,
+    grass: BlockState,
+    coal: BlockState,
+    iron: BlockState,
+    gravel: BlockState,
+}
+
+impl Blocks {
+    fn new() -> Self {
+        let b = |name: &str| BlockState::new(name.to_string());
+        Self {
+            bedrock: b("minecraft:bedrock"),
+            stone: b("minecraft:stone"),
+            dirt: b("minecraft:dirt"),
+            grass: b("minecraft:grass_block"),
+            coal: b("minecraft:coal_ore"),
+            iron: b("minecraft:iron_ore"),
+            gravel: b("minecraft:gravel"),
+        }
+    }
+}
+
+/// SplitMix64 finalizer over the seed and a coordinate triple.
+fn hash(x: i32, y: i32, z: i32) -> u64 {
+    let mut h = SEED
+        ^ (x as u32 as u64).wrapping_mul(0x9e37_79b9_7f4a_7c15)
+        ^ (y as u32 as u64).wrapping_mul(0xc2b2_ae3d_27d4_eb4f)
+        ^ (z as u32 as u64).wrapping_mul(0x1656_67b1_9e37_79f9);
+    h = (h ^ (h >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+    h = (h ^ (h >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+    h ^ (h >> 31)
+}
+
+/// Value noise on a `cell`-block lattice, smoothly interpolated, in `0..1`.
+fn noise(x: i32, z: i32, cell: i32) -> f64 {
+    let (gx, gz) = (x.div_euclid(cell), z.div_euclid(cell));
+    let (fx, fz) = (
+        x.rem_euclid(cell) as f64 / cell as f64,
+        z.rem_euclid(cell) as f64 / cell as f64,
+    );
+    let corner =
+        |dx: i32, dz: i32| (hash(gx + dx, cell, gz + dz) >> 11) as f64 / (1u64 << 53) as f64;
+    let smooth = |t: f64| t * t * (3.0 - 2.0 * t);
+    let (sx, sz) = (smooth(fx), smooth(fz));
+    let top = corner(0, 0) + (corner(1, 0) - corner(0, 0)) * sx;
+    let bottom = corner(0, 1) + (corner(1, 1) - corner(0, 1)) * sx;
+    top + (bottom - top) * sz
+}
+
+/// Surface height of column (`x`, `z`).
+pub fn height(x: i32, z: i32) -> i32 {
+    56 + (noise(x, z, 64) * 20.0 + noise(x, z, 16) * 6.0) as i32
+}
+
+fn chunk(blocks: &Blocks, cx: i32, cz: i32) -> WorldChunkView {
+    let mut view = WorldChunkView::new(cx, cz);
+    for lx in 0..16 {
+        for lz in 0..16 {
+            let (x, z) = (cx * 16 + lx, cz * 16 + lz);
+            let top = height(x, z);
+            for y in MIN_Y..=top {
+                let block = if y == MIN_Y {
+                    &blocks.bedrock
+                } else if y == top {
+                    &blocks.grass
+                } else if y > top - 4 {
+                    &blocks.dirt
+                } else {
+                    match hash(x, y, z) % 64 {
+                        0 => &blocks.coal,
+                        1 => &blocks.iron,
+                        2 | 3 => &blocks.gravel,
+                        _ => &blocks.stone,
+                    }
+                };
+                view.set_block(x, y, z, block);
+            }
+        }
+    }
+    if hash(cx, -1, cz) % 4 == 0 {
+        let (x, z) = (cx * 16 + 4, cz * 16 + 4);
+        let build = build((hash(cx, -2, cz) % 3) as i32);
+        for (dx, dy, dz, block) in build.iter() {
+            view.set_block(x + dx, height(x, z) + 1 + dy, z + dz, block);
+        }
+    }
+    view
+}
+
+/// One of a few small builds, as (dx, dy, dz, block) offsets from its
+/// corner: a plank shell with glass windows, a door gap and a redstone line
+/// leading away from it. `variant` stretches the footprint.
+fn build(variant: i32) -> Vec<(i32, i32, i32, BlockState)> {
+    let planks = BlockState::new("minecraft:oak_planks".to_string());
+    let glass = BlockState::new("minecraft:glass".to_string());
+    let wire = BlockState::new("minecraft:redstone_wire".to_string());
+    let lamp = BlockState::new("minecraft:redstone_lamp".to_string());
+    let (w, d, h) = (5 + variant, 5, 4);
+    let mut out = Vec::new();
+    for dx in 0..w {
+        for dz in 0..d {
+            for dy in 0..=h {
+                let wall = dx == 0 || dz == 0 || dx == w - 1 || dz == d - 1;
+                if !(wall || dy == 0 || dy == h) {
+                    continue;
+                }
+                if dz == 0 && dx == w / 2 && (dy == 1 || dy == 2) {
+                    continue;
+                }
+                let window = wall && dy == 2 && (dx + dz) % 2 == 1;
+                out.push((
+                    dx,
+                    dy,
+                    dz,
+                    if window {
+                        glass.clone()
+                    } else {
+                        planks.clone()
+                    },
+                ));
+            }
+        }
+    }
+    out.push((w / 2, 1, 1, lamp));
+    for dz in d..d + 4 {
+        out.push((w / 2, 0, dz, wire.clone()));
+    }
+    out
+}
+
+/// `count` placements of the corpus builds on a grid, with each build as
+/// its own schematic, for `world_pack`. Returns the placements and a loader.
+pub fn placements(count: usize) -> (Vec<Placement>, impl Fn(&Placement) -> UniversalSchematic) {
+    let schematics: Vec<UniversalSchematic> = (0..3).map(build_schematic).collect();
+    let per_row = (count as f64).sqrt().ceil() as i32;
+    let placements = (0..count)
+        .map(|i| {
+            let variant = i % schematics.len();
+            let (col, row) = (i as i32 % per_row, i as i32 / per_row);
+            Placement {
+                key: format!("build-{i:06}-{variant}"),
+                offset: (col * 12, 64, row * 12),
+                local_bbox: schematics[variant].get_bounding_box(),
+            }
+        })
+        .collect();
+    let load = move |p: &Placement| {
+        let variant: usize = p
+            .key
+            .rsplit('-')
+            .next()
+            .and_then(|v| v.parse().ok())
+            .unwrap_or(0);
+        schematics[variant].clone()
+    };
+    (placements, load)
+}
+
+fn build_schematic(variant: i32) -> UniversalSchematic {
+    let mut schematic = UniversalSchematic::new(format!("build-{variant}"));
+    for (dx, dy, dz, block) in build(variant) {
+        schematic.set_block(dx, dy, dz, &block);
+    }
+    schematic
+}
@@ -0,0 +1,118 @@
+//! End-to-end world paths over the generated corpus (see `support/corpus.rs`):
+//! streaming chunks out of real region files, and packing schematics into a
+//! new world. Each workload also gets one instrumented run recorded as a
+//! baseline (see `support/baseline.rs`).
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion, Throughput};
+use nucleation::formats::world_pack::{pack, pack_parallel};
+use nucleation::formats::world_stream::{ShardedWorldSink, WorldChunkView, WorldSink, WorldSource};
+use std::path::Path;
+
+#[path = "support/alloc_count.rs"]
+mod alloc_count;
+#[path = "support/baseline.rs"]
+mod baseline;
+#[path = "support/corpus.rs"]
+mod corpus;
+
+const BENCH: &str = "world_bench";
+
+fn threads() -> usize {
+    std::thread::available_parallelism().map_or(4, |n| n.get())
+}
+
+/// Stream every chunk and visit every block; returns the block count.
+fn stream(source: WorldSource, threads: usize) -> u64 {
+    let chunks = source.chunks().expect("chunks");
+    let count = |chunk: WorldChunkView| chunk.blocks().count() as u64;
+    if threads > 1 {
+        chunks
+            .parallel(threads, false)
+            .map(|c| count(c.expect("chunk")))
+            .sum()
+    } else {
+        chunks.map(|c| count(c.expect("chunk"))).sum()
+    }
+}
+
+fn open(dir: &Path, mapped: bool) -> WorldSource {
+    if mapped {
+        WorldSource::open_dir_mapped(dir).expect("open corpus")
+    } else {
+        WorldSource::open_dir(dir).expect("open corpus")
+    }
+}
+
+fn bench_world_stream(c: &mut Criterion) {
+    let corpus = corpus::world();
+    let cases = [
+        ("serial", false, 1),
+        ("mapped", true, 1),
+        ("parallel", true, threads()),
+    ];
+
+    let mut group = c.benchmark_group("world_stream");
+    group.sample_size(10);
+    group.throughput(Throughput::Elements(corpus.chunks));
+    for (label, mapped, threads) in cases {
+        group.bench_function(label, |b| {
+            b.iter(|| black_box(stream(open(&corpus.dir, mapped), threads)))
+        });
+    }
+    group.finish();
+
+    for (label, mapped, threads) in cases {
+        baseline::measure(
+            BENCH,
+            &format!("world_stream.{label}"),
+            corpus.chunks,
+            "chunks",
+            || stream(open(&corpus.dir, mapped), threads),
+        );
+    }
+}
+
+fn bench_world_pack(c: &mut Criterion) {
+    const BUILDS: usize = 4096;
+    let (placements, load) = corpus::placements(BUILDS);
+
+    let pack_serial = || {
+        let dir = corpus::scratch_dir("world_pack");
+        let mut sink = WorldSink::create(&dir, None).expect("sink");
+        let stats = pack(&placements, |p| Ok(load(p)), &mut sink).expect("pack");
+        sink.finish().expect("finish");
+        stats
+    };
+    let pack_sharded = || {
+        let dir = corpus::scratch_dir("world_pack_parallel");
+        let sink = ShardedWorldSink::create(&dir, None, 8).expect("sink");
+        let stats = pack_parallel(&placements, |p| Ok(load(p)), &sink).expect("pack");
+        sink.finish().expect("finish");
+        stats
+    };
+
+    let mut group = c.benchmark_group("world_pack");
+    group.sample_size(10);
+    group.throughput(Throughput::Elements(BUILDS as u64));
+    group.bench_function("serial", |b| b.iter(|| black_box(pack_serial())));
+    group.bench_function("parallel", |b| b.iter(|| black_box(pack_sharded())));
+    group.finish();
+
+    baseline::measure(
+        BENCH,
+        "world_pack.serial",
+        BUILDS as u64,
+        "builds",
+        pack_serial,
+    );
+    baseline::measure(
+        BENCH,
+        "world_pack.parallel",
+        BUILDS as u64,
+        "builds",
+        pack_sharded,
+    );
+}
+
+criterion_group!(benches, bench_world_stream, bench_world_pack);
+criterion_main!(benches);
@@ -6,7 +6,7 @@
 //! block states; Geyser blockstate mappings; and the texture-derived color
 //! cache) and writes two files into `OUT_DIR`:
 //!
-//!   - `block_table.rs`     — `BLOCKS` PHF map of `BlockFacts` + color query helpers
+//!   - `block_table.rs`     — `BLOCKS` PHF map of `BlockFacts`, query indexes, color helpers
 //!   - `bedrock_mappings.rs` — Java<->Bedrock blockstate string PHF maps
 //!
 //! This is the prebuilt-data path only: no network access, ever. Refreshing
@@ -446,6 +446,41 @@ fn rust_ident_for(block_id: &str) -> String {
         .to_uppercase()
 }
 
+/// The air blocks; meshing and fingerprinting skip them.
+const AIR_BLOCKS: &[&str] = &["minecraft:air", "minecraft:cave_air", "minecraft:void_air"];
+
+/// Blocks a redstone wire turns toward when its connections are fixed up.
+const REDSTONE_CONNECTABLE: &[&str] = &[
+    "minecraft:redstone_wire",
+    "minecraft:repeater",
+    "minecraft:comparator",
+    "minecraft:observer",
+    "minecraft:target",
+];
+
+/// The `BlockFlags` bits for a block, as a constant expression.
+fn block_flags_expr(block_data: &UnifiedBlockData) -> String {
+    let id = block_data.id.as_str();
+    let flags = [
+        ("AIR", AIR_BLOCKS.contains(&id)),
+        ("TRANSPARENT", block_data.transparent),
+        ("FULL_CUBE", block_data.full_cube),
+        ("BLOCK_ENTITY", block_data.has_block_entity),
+        ("LIGHT_SOURCE", block_data.emit_light > 0),
+        ("REDSTONE_CONNECTABLE", REDSTONE_CONNECTABLE.contains(&id)),
+    ];
+    let set: Vec<String> = flags
+        .iter()
+        .filter(|(_, set)| *set)
+        .map(|(name, _)| format!("crate::blockpedia::BlockFlags::{}", name))
+        .collect();
+    if set.is_empty() {
+        "0".to_string()
+    } else {
+        set.join(" | ")
+    }
+}
+
 /// Emit `block_table.rs`: statics + PHF map + color query helpers.
 ///
 /// All type paths are `crate::blockpedia::...` because the file is included
@@ -462,7 +497,12 @@ fn generate_block_table(
     writeln!(file, "use phf::{{phf_map, Map}};")?;
     writeln!(file)?;
 
-    for block_data in unified_blocks {
+    // Blocks in id order; a block's position here is its ordinal, the bit
+    // it owns in every index below.
+    let mut ordered: Vec<&UnifiedBlockData> = unified_blocks.iter().collect();
+    ordered.sort_by(|a, b| a.id.cmp(&b.id));
+
+    for (ordinal, block_data) in ordered.iter().enumerate() {
         let block_id = &block_data.id;
         let safe_name = rust_ident_for(block_id);
 
@@ -472,6 +512,12 @@ fn generate_block_table(
             safe_name
         )?;
         writeln!(file, "    id: \"{}\",", block_id)?;
+        writeln!(file, "    ordinal: {},", ordinal)?;
+        writeln!(
+            file,
+            "    flags: crate::blockpedia::BlockFlags::from_bits({}),",
+            block_flags_expr(block_data)
+        )?;
         writeln!(file, "    transparent: {},", block_data.transparent)?;
         writeln!(file, "    emit_light: {},", block_data.emit_light)?;
         writeln!(file, "    kind: \"{}\",", block_data.kind)?;
@@ -583,10 +629,11 @@ fn generate_block_table(
     writeln!(file, "}};")?;
     writeln!(file)?;
 
-    // Tag index: tag name -> block ids carrying it (drives `blocks_by_tag`).
+    // Tag index: tag name -> block ids carrying it (drives `blocks_by_tag`),
+    // in id order.
     let mut tag_index: std::collections::BTreeMap<&str, Vec<&str>> =
         std::collections::BTreeMap::new();
-    for block_data in unified_blocks {
+    for block_data in &ordered {
         for tag in &block_data.tags {
             tag_index.entry(tag).or_default().push(&block_data.id);
         }
@@ -608,6 +655,8 @@ fn generate_block_table(
     writeln!(file, "}};")?;
     writeln!(file)?;
 
+    generate_block_indexes(&mut file, &ordered, colors)?;
+
     // Color query helpers (same generated API as blockpedia)
     writeln!(file, "// Generated query helper functions")?;
     writeln!(file, "impl crate::blockpedia::BlockFacts {{")?;
@@ -695,6 +744,94 @@ fn generate_block_table(
     Ok(())
 }
 
+/// Emit the query indexes over `ordered` (blocks in id order): `BLOCK_LIST`,
+/// a bitset per data attribute, and ordinal lists per tag, kind and
+/// property name (see `src/blockpedia/index.rs`).
+fn generate_block_indexes(
+    file: &mut std::fs::File,
+    ordered: &[&UnifiedBlockData],
+    colors: &HashMap<String, CachedColor>,
+) -> Result<()> {
+    let words = ordered.len().div_ceil(64);
+    writeln!(file, "pub(crate) const BLOCK_WORDS: usize = {};", words)?;
+    writeln!(
+        file,
+        "pub static BLOCK_LIST: [&'static crate::blockpedia::BlockFacts; {}] = [",
+        ordered.len()
+    )?;
+    for block_data in ordered {
+        writeln!(file, "    &{},", rust_ident_for(&block_data.id))?;
+    }
+    writeln!(file, "];")?;
+    writeln!(file)?;
+
+    let sets: [(&str, &dyn Fn(&UnifiedBlockData) -> bool); 5] = [
+        ("FULL_CUBE_SET", &|b| b.full_cube),
+        ("BLOCK_ENTITY_SET", &|b| b.has_block_entity),
+        ("TRANSPARENT_SET", &|b| b.transparent),
+        ("LIGHT_SOURCE_SET", &|b| b.emit_light > 0),
+        ("COLORED_SET", &|b| colors.contains_key(&b.id)),
+    ];
+    for (name, keep) in sets {
+        let mut bits = vec![0u64; words];
+        for (ordinal, block_data) in ordered.iter().enumerate() {
+            if keep(block_data) {
+                bits[ordinal / 64] |= 1 << (ordinal % 64);
+            }
+        }
+        write!(
+            file,
+            "pub(crate) static {}: crate::blockpedia::index::BlockSet = crate::blockpedia::index::BlockSet::from_words([",
+            name
+        )?;
+        for (i, word) in bits.iter().enumerate() {
+            if i > 0 {
+                write!(file, ", ")?;
+            }
+            write!(file, "{:#x}", word)?;
+        }
+        writeln!(file, "]);")?;
+    }
+    writeln!(file)?;
+
+    let mut tags: std::collections::BTreeMap<&str, Vec<usize>> = Default::default();
+    let mut kinds: std::collections::BTreeMap<&str, Vec<usize>> = Default::default();
+    let mut properties: std::collections::BTreeMap<&str, Vec<usize>> = Default::default();
+    for (ordinal, block_data) in ordered.iter().enumerate() {
+        for tag in &block_data.tags {
+            tags.entry(tag).or_default().push(ordinal);
+        }
+        kinds.entry(&block_data.kind).or_default().push(ordinal);
+        for name in block_data.properties.keys() {
+            properties.entry(name).or_default().push(ordinal);
+        }
+    }
+    for (name, index) in [
+        ("TAG_ORDINALS", &tags),
+        ("KIND_ORDINALS", &kinds),
+        ("PROPERTY_ORDINALS", &properties),
+    ] {
+        writeln!(
+            file,
+            "pub(crate) static {}: Map<&'static str, &'static [u16]> = phf_map! {{",
+            name
+        )?;
+        for (key, ordinals) in index {
+            write!(file, "    \"{}\" => &[", key)?;
+            for (i, ordinal) in ordinals.iter().enumerate() {
+                if i > 0 {
+                    write!(file, ", ")?;
+                }
+                write!(file, "{}", ordinal)?;
+            }
+            writeln!(file, "],")?;
+        }
+        writeln!(file, "}};")?;
+    }
+    writeln!(file)?;
+    Ok(())
+}
+
 /// Emit `bedrock_mappings.rs` from the Geyser mappings snapshot.
 fn generate_bedrock_mappings(out_dir: &str, data_dir: &Path) -> Result<()> {
     let mappings_path = Path::new(out_dir).join("bedrock_mappings.rs");
@@ -34,7 +34,7 @@ fn main() {
     // index values in an order-insensitive way.
     if std::env::var("BENCH_CHECK").is_ok() {
         let raw = schem.to_raw_mesh(&pack, &config).expect("to_raw_mesh");
-        let pos = raw.positions_flat();
+        let pos = raw.positions();
         let idx = raw.indices();
         let pos_sum: f64 = pos.iter().map(|v| *v as f64).sum();
         let pos_absum: f64 = pos.iter().map(|v| (*v as f64).abs()).sum();
@@ -23,7 +23,6 @@ fn main() {
         );
     let pack = ResourcePackSource::from_file(&pack_path).expect("load pack");
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
     let config = MeshConfig::default();
 
     println!(
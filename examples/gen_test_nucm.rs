@@ -34,7 +34,6 @@ fn main() {
     println!("  Loaded in {:.1}s", t.elapsed().as_secs_f64());
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
     let mesh_config = MeshConfig::default();
 
     for (name, schem_path) in SCHEMATICS {
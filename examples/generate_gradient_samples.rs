@@ -9,9 +9,8 @@ use std::io::Write;
 
 fn save_schematic(name: &str, schematic: &UniversalSchematic) {
     let manager = get_manager();
-    let locked = manager.lock().unwrap();
     // Use .schem format (Sponge Schematic)
-    let data = locked
+    let data = manager
         .write("schematic", schematic, None)
         .expect("Failed to serialize schematic");
 
@@ -10,8 +10,7 @@ use std::sync::Arc;
 
 fn save_schematic(name: &str, schematic: &UniversalSchematic) {
     let manager = get_manager();
-    let locked = manager.lock().unwrap();
-    let data = locked
+    let data = manager
         .write("schematic", schematic, None)
         .expect("Failed to serialize schematic");
 
@@ -12,7 +12,6 @@ fn main() {
     let bytes = std::fs::read(&path).expect("read input");
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
 
     println!("detected format: {:?}", manager.detect_format(&bytes));
 
@@ -44,7 +44,6 @@ fn main() {
     );
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
 
     let mut results = Vec::new();
     let mut loaded = 0;
@@ -119,7 +119,6 @@ fn full_pipeline(args: &[String]) {
     // Load schematic
     let t = Instant::now();
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
     let schem_bytes = std::fs::read(schem_path).expect("read schematic");
     let schematic = manager.read(&schem_bytes).expect("import schematic");
     println!("Loaded schematic in {:.1}ms", t.elapsed().as_millis());
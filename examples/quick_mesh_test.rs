@@ -9,7 +9,6 @@ fn main() {
     let schem_data = std::fs::read(schem_path).expect("Failed to read schematic");
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
     let schematic = manager
         .read(&schem_data)
         .expect("Failed to parse schematic");
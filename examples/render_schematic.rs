@@ -269,7 +269,6 @@ fn main() {
         println!("Loading schematic: {}", cfg.schem_path);
         let schem_data = std::fs::read(&cfg.schem_path).expect("Failed to read schematic file");
         let manager = get_manager();
-        let manager = manager.lock().unwrap();
         let schematic = manager
             .read(&schem_data)
             .expect("Failed to parse schematic");
@@ -28,6 +28,7 @@ use nucleation::world_segment::runner::{MaterializedBuild, RunStats, SegmentJob,
 use nucleation::world_segment::score::{ScoreConfig, Tier};
 use nucleation::world_segment::segment::SegConfig;
 use nucleation::world_segment::source::{TileError, TileSource};
+use nucleation::world_segment::spill::SpillConfig;
 use nucleation::world_segment::targz_source::TarGzSource;
 use nucleation::world_segment::tile::VoxelTile;
 
@@ -376,6 +377,7 @@ fn main() {
         max_y: 320,
         extracted_at: 1_747_800_000,
         match_iou: 0.5,
+        spill: SpillConfig::default(),
     };
     let partitions = PartitionIndex::new(hints);
 
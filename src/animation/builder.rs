@@ -10,8 +10,15 @@ use super::{
     OperationTransform, Property, Repeat, Target, Timeline, Track, TransformAxis,
 };
 use crate::universal_schematic::UniversalSchematic;
+use rayon::prelude::*;
 use std::collections::{BTreeMap, BTreeSet};
 
+/// Frames [`BuildAnimation::render_stream`] samples together: enough to keep
+/// the sampling threads busy, few enough that a capture of a large build
+/// never holds much more than the readback ring.
+#[cfg(all(feature = "rendering", not(target_arch = "wasm32")))]
+const RENDER_SAMPLE_BATCH: usize = 8;
+
 #[derive(Debug, Clone, PartialEq)]
 pub struct AnimationEffect {
     clip: Clip,
@@ -709,11 +716,11 @@ impl BuildAnimation {
         match scope {
             OperationScope::DefaultRegion => schematic
                 .get_region("Main")
-                .map(|region| region.entities.clone())
+                .map(|region| region.entities.to_vec())
                 .unwrap_or_default(),
             OperationScope::Region(name) => schematic
                 .get_region(name)
-                .map(|region| region.entities.clone())
+                .map(|region| region.entities.to_vec())
                 .unwrap_or_default(),
             OperationScope::Schematic => schematic.get_entities_as_list(),
             OperationScope::StampRegion(_) | OperationScope::StampBox => Vec::new(),
@@ -1497,7 +1504,15 @@ impl BuildAnimation {
                     z: final_position.2,
                 };
                 let replaced_destination = self.schematic.get_block_entity(final_pos).cloned();
-                let final_state = transformed.get_block_entity(final_pos).cloned();
+                // Stamped block entities share the source's templates, which
+                // keep the source position.
+                let final_state = transformed
+                    .get_block_entity(final_pos)
+                    .cloned()
+                    .map(|mut be| {
+                        be.position = *final_position;
+                        be
+                    });
                 (source_state.is_some() || replaced_destination.is_some() || final_state.is_some())
                     .then_some(BlockEntityDelta {
                         source_position: [source_position.0, source_position.1, source_position.2],
@@ -1671,7 +1686,15 @@ impl BuildAnimation {
                 };
                 let source_state = source.get_block_entity(source_pos).cloned();
                 let replaced_destination = self.schematic.get_block_entity(final_pos).cloned();
-                let final_state = transformed.get_block_entity(final_pos).cloned();
+                // Stamped block entities share the source's templates, which
+                // keep the source position.
+                let final_state = transformed
+                    .get_block_entity(final_pos)
+                    .cloned()
+                    .map(|mut be| {
+                        be.position = *final_position;
+                        be
+                    });
                 (source_state.is_some() || replaced_destination.is_some() || final_state.is_some())
                     .then_some(BlockEntityDelta {
                         source_position: [source_position.0, source_position.1, source_position.2],
@@ -2040,7 +2063,12 @@ impl BuildAnimation {
     }
 
     pub fn frame_at(&self, t_ms: f32) -> super::Frame {
-        let mut frame = self.timeline().seek(t_ms);
+        self.finish_frame(self.timeline().seek(t_ms))
+    }
+
+    /// Apply visibility, operation transforms and gizmos to a sampled frame.
+    fn finish_frame(&self, mut frame: super::Frame) -> super::Frame {
+        let t_ms = frame.time_ms;
         for (id, pose) in &mut frame.poses {
             if let Some(step) = self.steps.get(*id as usize) {
                 if t_ms < step.visible_from_ms
@@ -2102,24 +2130,28 @@ impl BuildAnimation {
     /// Mesh every animation draw from the immutable schematic snapshot owned by
     /// that draw. This preserves pre-operation directional states while a
     /// transform is moving and authoritative final states after the endpoint.
+    ///
+    /// Output `i` is group `i`'s geometry; draws are meshed in parallel.
     #[cfg(feature = "meshing")]
     pub fn mesh_outputs(
         &self,
         pack: &crate::meshing::ResourcePackSource,
         config: &crate::meshing::MeshConfig,
     ) -> crate::meshing::Result<Vec<crate::meshing::MeshOutput>> {
-        let mut outputs = Vec::with_capacity(self.steps.len());
-        for (id, step) in self.steps.iter().enumerate() {
-            let group = Group::new(id as GroupId, step.blocks.clone());
-            let mut meshed = step.mesh_source.mesh_groups_in_region(
-                pack,
-                config,
-                step.mesh_region.as_deref(),
-                &[group],
-            )?;
-            outputs.push(meshed.remove(0));
-        }
-        Ok(outputs)
+        self.steps
+            .par_iter()
+            .enumerate()
+            .map(|(id, step)| -> crate::meshing::Result<_> {
+                let group = Group::new(id as GroupId, step.blocks.clone());
+                let mut meshed = step.mesh_source.mesh_groups_in_region(
+                    pack,
+                    config,
+                    step.mesh_region.as_deref(),
+                    &[group],
+                )?;
+                Ok(meshed.remove(0))
+            })
+            .collect()
     }
 
     pub fn timeline(&self) -> Timeline {
@@ -2151,13 +2183,20 @@ impl BuildAnimation {
             .max(self.timeline().duration_ms())
     }
 
-    /// Sample deterministic frames and optionally hold the final state.
+    /// Sample deterministic frames and optionally hold the final state. The
+    /// timeline is compiled once and the frames sampled in parallel.
     ///
     /// Loop captures round the requested frame count to the nearest whole
     /// frame, then partition `[0, period)` evenly so the full cycle is sampled
     /// without duplicating its endpoint.
     pub fn frames(&self, fps: f64, hold_ms: f32) -> Vec<super::Frame> {
         let timeline = self.timeline();
+        let times = self.capture_times(&timeline, fps, hold_ms);
+        self.sample(&timeline.compile(), &times)
+    }
+
+    /// The times [`BuildAnimation::frames`] samples.
+    fn capture_times(&self, timeline: &Timeline, fps: f64, hold_ms: f32) -> Vec<f32> {
         let fps = fps.max(1.0);
         let base_duration = self.next_operation_start_ms().max(timeline.duration_ms()) as f64;
         let duration = self
@@ -2171,9 +2210,7 @@ impl BuildAnimation {
             1000.0 / fps
         };
         if self.loop_period_ms.is_some() {
-            return (0..count)
-                .map(|i| self.frame_at((i as f64 * step_ms) as f32))
-                .collect();
+            return (0..count).map(|i| (i as f64 * step_ms) as f32).collect();
         }
         let mut times: Vec<f32> = (0..count)
             .map(|i| (i as f64 * step_ms) as f32)
@@ -2185,7 +2222,82 @@ impl BuildAnimation {
         }
         times.sort_by(f32::total_cmp);
         times.dedup_by(|a, b| (*a - *b).abs() <= 0.001);
-        times.into_iter().map(|time| self.frame_at(time)).collect()
+        times
+    }
+
+    fn sample(&self, compiled: &super::CompiledTimeline, times: &[f32]) -> Vec<super::Frame> {
+        times
+            .par_iter()
+            .map(|&time| self.finish_frame(compiled.seek(time)))
+            .collect()
+    }
+
+    /// [`BuildAnimation::frames`] packed into flat per-attribute arrays,
+    /// ready to upload; see [`super::PoseBuffer`].
+    pub fn pose_buffer(&self, fps: f64, hold_ms: f32) -> super::PoseBuffer {
+        super::PoseBuffer::from_frames(&self.frames(fps, hold_ms))
+    }
+
+    /// Render the capture [`BuildAnimation::frames`] describes and hand each
+    /// frame's RGBA pixels to `consume`, in order. Returns the frame count.
+    ///
+    /// `meshes` come from [`BuildAnimation::mesh_outputs`] and are uploaded
+    /// once; each frame only rewrites the per-group instance transforms.
+    /// Frames are sampled [`RENDER_SAMPLE_BATCH`] at a time, in parallel,
+    /// while earlier frames are still on the GPU, so no frame list is held.
+    #[cfg(all(feature = "rendering", not(target_arch = "wasm32")))]
+    pub fn render_stream(
+        &self,
+        meshes: &[crate::meshing::MeshOutput],
+        config: &crate::rendering::RenderConfig,
+        hdri: Option<&crate::rendering::HdriData>,
+        fps: f64,
+        hold_ms: f32,
+        consume: impl FnMut(usize, &[u8]) -> Result<(), crate::rendering::RenderError>,
+    ) -> Result<usize, crate::rendering::RenderError> {
+        let timeline = self.timeline();
+        let times = self.capture_times(&timeline, fps, hold_ms);
+        let compiled = timeline.compile();
+        let mut batch = Vec::new().into_iter();
+        crate::rendering::render_animation_source(
+            meshes,
+            times.len(),
+            |index| {
+                if index % RENDER_SAMPLE_BATCH == 0 {
+                    let end = (index + RENDER_SAMPLE_BATCH).min(times.len());
+                    batch = self.sample(&compiled, &times[index..end]).into_iter();
+                }
+                std::borrow::Cow::Owned(batch.next().expect("frames are requested in order"))
+            },
+            config,
+            hdri,
+            consume,
+        )?;
+        Ok(times.len())
+    }
+
+    /// [`BuildAnimation::render_stream`] into a video file at `video.fps`.
+    #[cfg(all(feature = "rendering", not(target_arch = "wasm32")))]
+    pub fn render_video(
+        &self,
+        meshes: &[crate::meshing::MeshOutput],
+        config: &crate::rendering::RenderConfig,
+        hdri: Option<&crate::rendering::HdriData>,
+        video: &crate::rendering::VideoConfig,
+        hold_ms: f32,
+        output: &std::path::Path,
+    ) -> Result<usize, crate::rendering::RenderError> {
+        let mut encoder = crate::rendering::video::VideoEncoder::start(
+            video,
+            config.width,
+            config.height,
+            output,
+        )?;
+        let count = self.render_stream(meshes, config, hdri, video.fps, hold_ms, |_, pixels| {
+            encoder.write_frame(pixels)
+        })?;
+        encoder.finish()?;
+        Ok(count)
     }
 
     fn delays(&self) -> Vec<f32> {
@@ -0,0 +1,383 @@
+//! A [`Timeline`] compiled for sampling many frames.
+//!
+//! [`Timeline::seek`] builds and sorts the pose list and walks every entry for
+//! every group on each call. A [`CompiledTimeline`] does that work once: each
+//! group gets the entries that drive it, and its time axis is cut at the
+//! instants those entries start and stop moving. Outside that window a clip
+//! holds its first or last frame, so within one interval the held entries
+//! ahead of the first moving one fold into a precomputed pose, and a frame
+//! samples only what is left.
+//!
+//! Sampling stays exact: a compiled timeline yields the same [`Frame`] as
+//! `seek` at every instant. Intervals are cut slightly wide, so an entry
+//! close to an edge is sampled rather than folded.
+//!
+//! Frames are sampled in parallel, either as [`Frame`]s or straight into a
+//! [`PoseBuffer`] of flat per-attribute arrays that a renderer can upload
+//! without repacking.
+
+use rayon::prelude::*;
+
+use super::pose::Pose;
+use super::stagger::GroupId;
+use super::timeline::{CameraPose, Frame, Target, Timeline};
+use super::track::{Clip, Repeat};
+
+/// How one entry is sampled within an interval.
+#[derive(Debug, Clone, Copy, PartialEq)]
+enum Hold {
+    /// Moving: sampled at the frame's time.
+    Live,
+    /// Before its start: its first frame.
+    First,
+    /// Past its end: its last frame.
+    Last,
+}
+
+impl Hold {
+    fn sample(self, clip: &Clip, local_ms: f32, pose: &mut Pose) {
+        let t = match self {
+            Hold::Live => local_ms,
+            // Any time before the start or past the end samples the same.
+            Hold::First => f32::NEG_INFINITY,
+            Hold::Last => f32::INFINITY,
+        };
+        clip.sample_into(t, pose);
+    }
+}
+
+/// One interval of a group's time axis.
+#[derive(Debug, Clone)]
+struct Interval {
+    /// The group's pose with the held entries before the first live one
+    /// applied.
+    base: Pose,
+    /// The remaining entries, as a range of [`CompiledTimeline::steps`].
+    steps: std::ops::Range<u32>,
+}
+
+#[derive(Debug, Clone)]
+struct GroupPlan {
+    id: GroupId,
+    /// Interval `k` covers `[edges[k - 1], edges[k])`, open at the ends.
+    edges: Vec<f32>,
+    intervals: Vec<Interval>,
+}
+
+/// A [`Timeline`] precompiled for repeated sampling; see the module docs.
+#[derive(Debug, Clone)]
+pub struct CompiledTimeline {
+    clips: Vec<(Clip, f32)>,
+    /// Groups sorted by id.
+    groups: Vec<GroupPlan>,
+    steps: Vec<(u32, Hold)>,
+    /// Camera entries, in timeline order.
+    camera: Vec<u32>,
+    duration_ms: f32,
+}
+
+/// Where an entry moves, widened a little; `None` when it never moves.
+fn live_window(clip: &Clip, offset_ms: f32) -> Option<(f32, f32)> {
+    if clip.duration_ms <= 0.0 {
+        // Zero-length clips always report their last frame.
+        return None;
+    }
+    let start = offset_ms + clip.delay_ms;
+    let end = match clip.repeat {
+        Repeat::Forever => f32::INFINITY,
+        _ => offset_ms + clip.total_ms().unwrap_or(f32::INFINITY),
+    };
+    if !start.is_finite() || end.is_nan() {
+        return Some((f32::NEG_INFINITY, f32::INFINITY));
+    }
+    let pad = 1e-5 * (1.0 + start.abs() + if end.is_finite() { end.abs() } else { 0.0 });
+    Some((start - pad, end + pad))
+}
+
+impl CompiledTimeline {
+    pub fn new(timeline: &Timeline) -> Self {
+        let clips: Vec<(Clip, f32)> = timeline
+            .entries()
+            .map(|(clip, _, offset)| (clip.clone(), offset))
+            .collect();
+        let targets: Vec<&Target> = timeline.entries().map(|(_, target, _)| target).collect();
+        let windows: Vec<Option<(f32, f32)>> = clips
+            .iter()
+            .map(|(clip, offset)| live_window(clip, *offset))
+            .collect();
+        let camera = (0..targets.len() as u32)
+            .filter(|&e| matches!(targets[e as usize], Target::Camera))
+            .collect();
+
+        let mut sorted: Vec<_> = timeline.groups().iter().collect();
+        sorted.sort_by_key(|g| g.id);
+
+        // Entries per group, in timeline order. `Target::Group` drives one
+        // group even if ids repeat, as `seek`'s binary search does.
+        let mut driving: Vec<Vec<u32>> = vec![Vec::new(); sorted.len()];
+        for (e, target) in targets.iter().enumerate() {
+            match target {
+                Target::Camera => {}
+                Target::Group(id) => {
+                    if let Ok(i) = sorted.binary_search_by_key(id, |g| g.id) {
+                        driving[i].push(e as u32);
+                    }
+                }
+                _ => {
+                    for (i, g) in sorted.iter().enumerate() {
+                        if target.matches(g.id) {
+                            driving[i].push(e as u32);
+                        }
+                    }
+                }
+            }
+        }
+
+        let mut steps = Vec::new();
+        let groups = sorted
+            .iter()
+            .zip(&driving)
+            .map(|(group, entries)| {
+                let mut edges: Vec<f32> = entries
+                    .iter()
+                    .filter_map(|&e| windows[e as usize])
+                    .flat_map(|(lo, hi)| [lo, hi])
+                    .filter(|t| t.is_finite())
+                    .collect();
+                edges.sort_by(f32::total_cmp);
+                edges.dedup();
+
+                let intervals = (0..=edges.len())
+                    .map(|k| {
+                        let from = if k == 0 {
+                            f32::NEG_INFINITY
+                        } else {
+                            edges[k - 1]
+                        };
+                        let to = edges.get(k).copied().unwrap_or(f32::INFINITY);
+                        let hold = |e: u32| match windows[e as usize] {
+                            None => Hold::Last,
+                            Some((lo, _)) if to <= lo => Hold::First,
+                            Some((_, hi)) if from >= hi => Hold::Last,
+                            Some(_) => Hold::Live,
+                        };
+                        let live = entries
+                            .iter()
+                            .position(|&e| hold(e) == Hold::Live)
+                            .unwrap_or(entries.len());
+                        let mut base = Pose::about(group.centroid);
+                        for &e in &entries[..live] {
+                            hold(e).sample(&clips[e as usize].0, 0.0, &mut base);
+                        }
+                        let start = steps.len() as u32;
+                        steps.extend(entries[live..].iter().map(|&e| (e, hold(e))));
+                        Interval {
+                            base,
+                            steps: start..steps.len() as u32,
+                        }
+                    })
+                    .collect();
+                GroupPlan {
+                    id: group.id,
+                    edges,
+                    intervals,
+                }
+            })
+            .collect();
+
+        CompiledTimeline {
+            clips,
+            groups,
+            steps,
+            camera,
+            duration_ms: timeline.duration_ms(),
+        }
+    }
+
+    pub fn duration_ms(&self) -> f32 {
+        self.duration_ms
+    }
+
+    /// Number of groups, and of poses per frame.
+    pub fn group_count(&self) -> usize {
+        self.groups.len()
+    }
+
+    /// Group ids in pose order.
+    pub fn group_ids(&self) -> impl Iterator<Item = GroupId> + '_ {
+        self.groups.iter().map(|g| g.id)
+    }
+
+    fn pose(&self, group: &GroupPlan, t_ms: f32) -> Pose {
+        let k = group.edges.partition_point(|&e| e <= t_ms);
+        let interval = &group.intervals[k];
+        let mut pose = interval.base;
+        for &(e, hold) in &self.steps[interval.steps.start as usize..interval.steps.end as usize] {
+            let (clip, offset) = &self.clips[e as usize];
+            hold.sample(clip, t_ms - offset, &mut pose);
+        }
+        pose
+    }
+
+    fn camera(&self, t_ms: f32) -> Option<CameraPose> {
+        self.camera.last().map(|&e| {
+            let (clip, offset) = &self.clips[e as usize];
+            let mut p = Pose::IDENTITY;
+            clip.sample_into(t_ms - offset, &mut p);
+            CameraPose::from_pose(&p)
+        })
+    }
+
+    /// The same frame [`Timeline::seek`] returns at `t_ms`.
+    pub fn seek(&self, t_ms: f32) -> Frame {
+        Frame {
+            time_ms: t_ms,
+            poses: self
+                .groups
+                .iter()
+                .map(|g| (g.id, self.pose(g, t_ms)))
+                .collect(),
+            camera: self.camera(t_ms),
+            gizmos: Vec::new(),
+        }
+    }
+
+    /// [`Timeline::frames`], sampled in parallel.
+    pub fn frames(&self, fps: f64) -> Vec<Frame> {
+        self.frames_at(&frame_times(self.duration_ms, fps))
+    }
+
+    /// One frame per time, sampled in parallel.
+    pub fn frames_at(&self, times: &[f32]) -> Vec<Frame> {
+        times.par_iter().map(|&t| self.seek(t)).collect()
+    }
+
+    /// Sample `times` straight into a [`PoseBuffer`], in parallel.
+    pub fn pose_buffer(&self, times: &[f32]) -> PoseBuffer {
+        let mut buffer = PoseBuffer::new(times.to_vec(), self.group_ids().collect());
+        buffer.fill(|t, i| self.pose(&self.groups[i], t), |t| self.camera(t));
+        buffer
+    }
+}
+
+/// Frame times for a capture of `duration_ms` at `fps`; see
+/// [`Timeline::frame_times`].
+pub(super) fn frame_times(duration_ms: f32, fps: f64) -> Vec<f32> {
+    let fps = if fps <= 0.0 { 1.0 } else { fps };
+    let count = ((duration_ms as f64 / 1000.0) * fps).round().max(1.0) as usize;
+    (0..count)
+        .map(|i| (i as f64 * 1000.0 / fps) as f32)
+        .collect()
+}
+
+/// Sampled frames as flat arrays, one per attribute, frame-major and then in
+/// group-id order: the pose of group `g` in frame `f` is element
+/// `f * group_count + g`, scaled by the attribute's width.
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct PoseBuffer {
+    pub times: Vec<f32>,
+    pub group_ids: Vec<GroupId>,
+    /// Column-major model matrices ([`Pose::to_matrix`]), 16 floats each.
+    pub matrices: Vec<f32>,
+    pub opacity: Vec<f32>,
+    /// RGBA, 4 floats each.
+    pub tint: Vec<f32>,
+    /// RGBA, 4 floats each.
+    pub emissive: Vec<f32>,
+    /// Per frame: yaw, pitch, zoom and the target offset, 6 floats. Zero
+    /// where `has_camera` is false.
+    pub camera: Vec<f32>,
+    pub has_camera: Vec<bool>,
+}
+
+impl PoseBuffer {
+    fn new(times: Vec<f32>, group_ids: Vec<GroupId>) -> Self {
+        let (f, g) = (times.len(), group_ids.len());
+        PoseBuffer {
+            times,
+            group_ids,
+            matrices: vec![0.0; f * g * 16],
+            opacity: vec![0.0; f * g],
+            tint: vec![0.0; f * g * 4],
+            emissive: vec![0.0; f * g * 4],
+            camera: vec![0.0; f * 6],
+            has_camera: vec![false; f],
+        }
+    }
+
+    /// Pack already-sampled frames. Every frame must hold the same groups in
+    /// the same order, as frames of one timeline do.
+    pub fn from_frames(frames: &[Frame]) -> Self {
+        let ids = frames
+            .first()
+            .map(|f| f.poses.iter().map(|(id, _)| *id).collect())
+            .unwrap_or_default();
+        let mut buffer = PoseBuffer::new(frames.iter().map(|f| f.time_ms).collect(), ids);
+        buffer.fill_indexed(|f, i| frames[f].poses[i].1, |f| frames[f].camera);
+        buffer
+    }
+
+    pub fn frame_count(&self) -> usize {
+        self.times.len()
+    }
+
+    pub fn group_count(&self) -> usize {
+        self.group_ids.len()
+    }
+
+    fn fill(
+        &mut self,
+        pose: impl Fn(f32, usize) -> Pose + Sync,
+        camera: impl Fn(f32) -> Option<CameraPose> + Sync,
+    ) {
+        let times = std::mem::take(&mut self.times);
+        self.fill_indexed(|f, i| pose(times[f], i), |f| camera(times[f]));
+        self.times = times;
+    }
+
+    fn fill_indexed(
+        &mut self,
+        pose: impl Fn(usize, usize) -> Pose + Sync,
+        camera: impl Fn(usize) -> Option<CameraPose> + Sync,
+    ) {
+        let g = self.group_ids.len();
+        if g == 0 {
+            return self.fill_camera(camera);
+        }
+        self.matrices
+            .par_chunks_mut(g * 16)
+            .zip(self.opacity.par_chunks_mut(g))
+            .zip(self.tint.par_chunks_mut(g * 4))
+            .zip(self.emissive.par_chunks_mut(g * 4))
+            .enumerate()
+            .for_each(|(f, (((matrices, opacity), tint), emissive))| {
+                for i in 0..g {
+                    let p = pose(f, i);
+                    let m = p.to_matrix();
+                    for (c, column) in m.iter().enumerate() {
+                        matrices[i * 16 + c * 4..i * 16 + c * 4 + 4].copy_from_slice(column);
+                    }
+                    opacity[i] = p.opacity;
+                    tint[i * 4..i * 4 + 4].copy_from_slice(&p.tint);
+                    emissive[i * 4..i * 4 + 4].copy_from_slice(&p.emissive);
+                }
+            });
+        self.fill_camera(camera);
+    }
+
+    fn fill_camera(&mut self, camera: impl Fn(usize) -> Option<CameraPose>) {
+        for f in 0..self.has_camera.len() {
+            if let Some(c) = camera(f) {
+                self.has_camera[f] = true;
+                self.camera[f * 6..f * 6 + 6].copy_from_slice(&[
+                    c.yaw,
+                    c.pitch,
+                    c.zoom,
+                    c.target_offset[0],
+                    c.target_offset[1],
+                    c.target_offset[2],
+                ]);
+            }
+        }
+    }
+}
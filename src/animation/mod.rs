@@ -26,6 +26,7 @@
 //! `docs/plans/2026-07-21-build-animator-design.md` for the design rationale.
 
 pub mod builder;
+pub mod compiled;
 pub mod easing;
 pub mod operation;
 pub mod pose;
@@ -35,6 +36,7 @@ pub mod timeline;
 pub mod track;
 
 pub use builder::{AnimationEffect, BuildAnimation};
+pub use compiled::{CompiledTimeline, PoseBuffer};
 pub use easing::{Easing, Power};
 pub use operation::{
     BlockEntityDelta, CellDelta, EntityDelta, LatticeAffine, OperationBounds, OperationKind,
@@ -45,6 +47,8 @@ pub use stagger::{Axis, Group, GroupId, Grouping, Order, Pos, Spread, Stagger, S
 pub use timeline::{CameraPose, Frame, GizmoKind, GizmoLine, Target, Timeline};
 pub use track::{Clip, Keyframe, Modifier, Property, Repeat, Track};
 
+use rayon::prelude::*;
+
 use crate::universal_schematic::UniversalSchematic;
 
 /// Groups plus the timeline that drives them.
@@ -101,13 +105,28 @@ impl BuildAnimator {
 }
 
 /// Non-air block positions, sorted for reproducibility.
+///
+/// Reads region storage directly: air is decided once per palette entry, and
+/// `minecraft:air` cells are skipped by [`Region::cells_ne`] without being
+/// visited one by one.
+///
+/// [`Region::cells_ne`]: crate::Region::cells_ne
 pub fn non_air_positions(schem: &UniversalSchematic) -> Vec<Pos> {
-    let mut out: Vec<Pos> = schem
-        .iter_blocks()
-        .filter(|(_, b)| !crate::fingerprint::is_air(b.get_name()))
-        .map(|(p, _)| (p.x, p.y, p.z))
-        .collect();
-    out.sort_unstable();
+    let mut out = Vec::new();
+    for region in std::iter::once(&schem.default_region).chain(schem.other_regions.values()) {
+        let air: Vec<bool> = region
+            .palette
+            .iter()
+            .map(|b| crate::fingerprint::is_air(b.get_name()))
+            .collect();
+        out.extend(
+            region
+                .cells_ne(region.air_index())
+                .filter(|&(_, index)| !air[index])
+                .map(|(p, _)| p),
+        );
+    }
+    out.par_sort_unstable();
     out
 }
 
@@ -139,6 +158,26 @@ mod tests {
         assert_eq!(anim.groups().len(), 2, "air must not become a group");
     }
 
+    #[test]
+    fn non_air_positions_match_a_block_scan() {
+        let mut s = UniversalSchematic::new("anim".to_string());
+        for i in 0..40 {
+            let block = match i % 4 {
+                0 => "minecraft:air",
+                1 => "minecraft:cave_air",
+                _ => "minecraft:stone",
+            };
+            s.set_block_from_string(i % 7, i / 7, i % 3, block).ok();
+        }
+        let mut expected: Vec<Pos> = s
+            .iter_blocks()
+            .filter(|(_, b)| !crate::fingerprint::is_air(b.get_name()))
+            .map(|(p, _)| (p.x, p.y, p.z))
+            .collect();
+        expected.sort_unstable();
+        assert_eq!(non_air_positions(&s), expected);
+    }
+
     #[test]
     fn empty_schematic_produces_no_groups() {
         let s = UniversalSchematic::new("empty".to_string());
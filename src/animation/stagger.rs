@@ -9,7 +9,13 @@
 //! Note the two *different* easings in play. [`Stagger::ease`] shapes **when**
 //! each group starts; the easing inside a [`super::track::Clip`] shapes **how**
 //! it moves once started. Conflating them is the usual mistake.
+//!
+//! Per-block grouping of a large build yields millions of groups, so grouping
+//! sorts positions once by group key instead of bucketing them in a map, and
+//! ranking radix-sorts integer keys (see [`radix_order`]) rather than
+//! comparing floats.
 
+use rayon::prelude::*;
 use serde::{Deserialize, Serialize};
 
 use super::easing::Easing;
@@ -60,18 +66,45 @@ impl Group {
 
 /// The mesher centres each block model on its integer schematic coordinate, so
 /// a single block at `(x, y, z)` must rotate around exactly `(x, y, z)`.
+///
+/// Sums are integer so a large group's centroid does not drift with block
+/// order.
 fn centroid_of(blocks: &[Pos]) -> [f32; 3] {
     if blocks.is_empty() {
         return [0.0; 3];
     }
-    let n = blocks.len() as f32;
-    let (mut x, mut y, mut z) = (0.0f32, 0.0f32, 0.0f32);
+    let n = blocks.len() as f64;
+    let (mut x, mut y, mut z) = (0i64, 0i64, 0i64);
     for b in blocks {
-        x += b.0 as f32;
-        y += b.1 as f32;
-        z += b.2 as f32;
+        x += b.0 as i64;
+        y += b.1 as i64;
+        z += b.2 as i64;
+    }
+    [
+        (x as f64 / n) as f32,
+        (y as f64 / n) as f32,
+        (z as f64 / n) as f32,
+    ]
+}
+
+/// One group per distinct `key`, in key order, each holding its blocks
+/// sorted.
+fn groups_by_key<K: Ord + Copy + Send>(
+    positions: &[Pos],
+    key: impl Fn(Pos) -> K + Sync,
+) -> Vec<Group> {
+    let mut keyed: Vec<(K, Pos)> = positions.par_iter().map(|&p| (key(p), p)).collect();
+    keyed.par_sort_unstable();
+    let mut groups = Vec::new();
+    let mut start = 0;
+    while start < keyed.len() {
+        let k = keyed[start].0;
+        let len = keyed[start..].partition_point(|e| e.0 == k);
+        let blocks = keyed[start..start + len].iter().map(|e| e.1).collect();
+        groups.push(Group::new(groups.len() as GroupId, blocks));
+        start += len;
     }
-    [x / n, y / n, z / n]
+    groups
 }
 
 /// How a set of positions becomes animatable units.
@@ -94,46 +127,22 @@ impl Grouping {
         match self {
             Grouping::PerBlock => {
                 let mut ps = positions.to_vec();
-                ps.sort_unstable();
+                ps.par_sort_unstable();
                 ps.dedup();
-                ps.into_iter()
-                    .enumerate()
-                    .map(|(i, p)| Group::new(i as GroupId, vec![p]))
-                    .collect()
-            }
-            Grouping::Layer(axis) => {
-                let mut by_layer: std::collections::BTreeMap<i32, Vec<Pos>> = Default::default();
-                for &p in positions {
-                    by_layer.entry(axis.of(p)).or_default().push(p);
-                }
-                by_layer
-                    .into_values()
+                ps.into_par_iter()
                     .enumerate()
-                    .map(|(i, mut blocks)| {
-                        blocks.sort_unstable();
-                        Group::new(i as GroupId, blocks)
+                    .map(|(i, p)| Group {
+                        id: i as GroupId,
+                        blocks: vec![p],
+                        centroid: [p.0 as f32, p.1 as f32, p.2 as f32],
                     })
                     .collect()
             }
+            Grouping::Layer(axis) => groups_by_key(positions, |p| axis.of(p)),
             Grouping::Chunk(size) => {
                 let s = (*size).max(1) as i32;
                 let key = |v: i32| v.div_euclid(s);
-                let mut by_chunk: std::collections::BTreeMap<(i32, i32, i32), Vec<Pos>> =
-                    Default::default();
-                for &p in positions {
-                    by_chunk
-                        .entry((key(p.0), key(p.1), key(p.2)))
-                        .or_default()
-                        .push(p);
-                }
-                by_chunk
-                    .into_values()
-                    .enumerate()
-                    .map(|(i, mut blocks)| {
-                        blocks.sort_unstable();
-                        Group::new(i as GroupId, blocks)
-                    })
-                    .collect()
+                groups_by_key(positions, |p| (key(p.0), key(p.1), key(p.2)))
             }
             Grouping::Custom(sets) => sets
                 .iter()
@@ -169,83 +178,143 @@ pub enum Order {
 
 impl Order {
     /// Rank each group, `0..n-1`. Ties resolve by group index so the result is
-    /// always a total order.
+    /// always a total order. Float keys compare as numbers, with NaN last.
     pub fn ranks(&self, groups: &[Group]) -> Vec<usize> {
         let n = groups.len();
         if n == 0 {
             return Vec::new();
         }
-        let mut idx: Vec<usize> = (0..n).collect();
-        match self {
-            Order::Index => {}
-            Order::Axis(axis, ascending) => {
-                let comp = |g: &Group| match axis {
-                    Axis::X => g.centroid[0],
-                    Axis::Y => g.centroid[1],
-                    Axis::Z => g.centroid[2],
+        let keys: Vec<u64> = match self {
+            Order::Index => (0..n as u64).collect(),
+            Order::Axis(axis, _) => {
+                let c = match axis {
+                    Axis::X => 0,
+                    Axis::Y => 1,
+                    Axis::Z => 2,
                 };
-                idx.sort_by(|&a, &b| {
-                    let (ka, kb) = (comp(&groups[a]), comp(&groups[b]));
-                    ka.partial_cmp(&kb)
-                        .unwrap_or(core::cmp::Ordering::Equal)
-                        .then(a.cmp(&b))
-                });
-                if !ascending {
-                    idx.reverse();
-                }
+                groups.par_iter().map(|g| f32_key(g.centroid[c])).collect()
             }
-            Order::DistanceFrom(o) => {
-                let d = |g: &Group| {
+            Order::DistanceFrom(o) => groups
+                .par_iter()
+                .map(|g| {
                     let dx = g.centroid[0] - o[0];
                     let dy = g.centroid[1] - o[1];
                     let dz = g.centroid[2] - o[2];
-                    dx * dx + dy * dy + dz * dz
-                };
-                idx.sort_by(|&a, &b| {
-                    d(&groups[a])
-                        .partial_cmp(&d(&groups[b]))
-                        .unwrap_or(core::cmp::Ordering::Equal)
-                        .then(a.cmp(&b))
-                });
-            }
-            Order::Key(keys) => {
-                idx.sort_by(|&a, &b| {
-                    let ka = keys.get(a).copied().unwrap_or(f64::MAX);
-                    let kb = keys.get(b).copied().unwrap_or(f64::MAX);
-                    ka.partial_cmp(&kb)
-                        .unwrap_or(core::cmp::Ordering::Equal)
-                        .then(a.cmp(&b))
-                });
-            }
-            Order::Custom(ranks) => {
-                idx.sort_by_key(|&i| (ranks.get(i).copied().unwrap_or(usize::MAX), i));
-            }
+                    f32_key(dx * dx + dy * dy + dz * dz)
+                })
+                .collect(),
+            Order::Key(keys) => (0..n)
+                .into_par_iter()
+                .map(|i| f64_key(keys.get(i).copied().unwrap_or(f64::MAX)))
+                .collect(),
+            Order::Custom(ranks) => (0..n)
+                .into_par_iter()
+                .map(|i| ranks.get(i).map_or(u64::MAX, |&r| r as u64))
+                .collect(),
             Order::Random(seed) => {
                 // SplitMix64: tiny, seeded, and identical on every platform.
-                let mut state = *seed;
-                let mut keyed: Vec<(u64, usize)> = idx
-                    .iter()
-                    .map(|&i| {
-                        state = state.wrapping_add(0x9E37_79B9_7F4A_7C15);
-                        let mut z = state;
+                // Its state after `i + 1` steps is computed directly, so the
+                // keys can be drawn in parallel.
+                (0..n as u64)
+                    .into_par_iter()
+                    .map(|i| {
+                        let mut z = seed.wrapping_add((i + 1).wrapping_mul(0x9E37_79B9_7F4A_7C15));
                         z = (z ^ (z >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
                         z = (z ^ (z >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
-                        (z ^ (z >> 31), i)
+                        z ^ (z >> 31)
                     })
-                    .collect();
-                keyed.sort_unstable();
-                idx = keyed.into_iter().map(|(_, i)| i).collect();
+                    .collect()
             }
+        };
+        let mut idx = radix_order(&keys);
+        if let Order::Axis(_, false) = self {
+            idx.reverse();
         }
         // idx is "position -> group"; invert to "group -> rank".
         let mut ranks = vec![0usize; n];
         for (rank, &g) in idx.iter().enumerate() {
-            ranks[g] = rank;
+            ranks[g as usize] = rank;
         }
         ranks
     }
 }
 
+/// `v` as an integer with the same order; `-0.0` equals `0.0` and NaN sorts
+/// after every number.
+fn f32_key(v: f32) -> u64 {
+    let v = if v == 0.0 || v.is_nan() { v.abs() } else { v };
+    let bits = v.to_bits();
+    (if bits >> 31 == 1 {
+        !bits
+    } else {
+        bits | 1 << 31
+    }) as u64
+}
+
+/// [`f32_key`] for `f64`.
+fn f64_key(v: f64) -> u64 {
+    let v = if v == 0.0 || v.is_nan() { v.abs() } else { v };
+    let bits = v.to_bits();
+    if bits >> 63 == 1 {
+        !bits
+    } else {
+        bits | 1 << 63
+    }
+}
+
+/// Indices of `keys` in ascending key order, ties by index.
+///
+/// A least-significant-byte radix sort: the eight byte histograms are counted
+/// in one parallel read of the keys, chunk by chunk, and a byte on which every
+/// key agrees is skipped, so index or small integer keys take one or two
+/// passes.
+fn radix_order(keys: &[u64]) -> Vec<u32> {
+    const CHUNK: usize = 1 << 16;
+    let counts = keys
+        .par_chunks(CHUNK)
+        .map(|chunk| {
+            let mut counts = vec![[0usize; 256]; 8];
+            for &k in chunk {
+                for (byte, count) in counts.iter_mut().enumerate() {
+                    count[(k >> (byte * 8)) as usize & 0xFF] += 1;
+                }
+            }
+            counts
+        })
+        .reduce(
+            || vec![[0usize; 256]; 8],
+            |mut a, b| {
+                for (a, b) in a.iter_mut().zip(&b) {
+                    for (a, b) in a.iter_mut().zip(b) {
+                        *a += b;
+                    }
+                }
+                a
+            },
+        );
+
+    let mut order: Vec<(u64, u32)> = keys.iter().zip(0..).map(|(&k, i)| (k, i)).collect();
+    let mut next = vec![(0u64, 0u32); keys.len()];
+    for (byte, count) in counts.iter().enumerate() {
+        if count.contains(&keys.len()) {
+            continue;
+        }
+        let mut at = [0usize; 256];
+        let mut sum = 0;
+        for (at, &c) in at.iter_mut().zip(count) {
+            *at = sum;
+            sum += c;
+        }
+        for &entry in &order {
+            let digit = (entry.0 >> (byte * 8)) as usize & 0xFF;
+            next[at[digit]] = entry;
+            at[digit] += 1;
+        }
+        std::mem::swap(&mut order, &mut next);
+    }
+    order.into_iter().map(|(_, i)| i).collect()
+}
+
 /// Where the stagger wave originates.
 #[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
 pub enum StaggerFrom {
@@ -317,7 +386,7 @@ impl Stagger {
 
         // Distance in rank-space from the anchor.
         let dist: Vec<f32> = ranks
-            .iter()
+            .par_iter()
             .map(|&r| {
                 let r = r as f32;
                 match self.from {
@@ -337,7 +406,7 @@ impl Stagger {
             Spread::EachMs(each) => each * max,
             Spread::TotalMs(total) => total,
         };
-        dist.iter()
+        dist.par_iter()
             .map(|&d| self.ease.eval(d / max) * span)
             .collect()
     }
@@ -493,6 +562,37 @@ mod tests {
         assert!(d[2] < 500.0, "quadratic ease-in should bunch the start");
     }
 
+    #[test]
+    fn radix_ranks_match_a_comparison_sort() {
+        let groups = Grouping::PerBlock.apply(&line(300));
+        let keys: Vec<f64> = (0..300u64)
+            .map(|i| match i % 7 {
+                0 => 0.0,
+                1 => -0.0,
+                2 => -((i * 31 % 17) as f64),
+                3 => 1e300,
+                _ => ((i * 2654435761) % 1000) as f64 / 7.0 - 50.0,
+            })
+            .collect();
+        let mut idx: Vec<usize> = (0..keys.len()).collect();
+        idx.sort_by(|&a, &b| keys[a].partial_cmp(&keys[b]).unwrap().then(a.cmp(&b)));
+        let mut expected = vec![0; idx.len()];
+        for (rank, &g) in idx.iter().enumerate() {
+            expected[g] = rank;
+        }
+        assert_eq!(Order::Key(keys).ranks(&groups), expected);
+
+        let nan_last = Order::Key(vec![f64::NAN, 1.0, -1.0]).ranks(&groups[..3]);
+        assert_eq!(nan_last, vec![2, 1, 0]);
+    }
+
+    #[test]
+    fn large_groups_get_an_exact_centroid() {
+        let blocks: Vec<Pos> = (0..200_000).map(|i| (i % 1000 + 100_000, 0, 0)).collect();
+        let g = Grouping::Layer(Axis::Y).apply(&blocks);
+        assert_eq!(g[0].centroid, [100_499.5, 0.0, 0.0]);
+    }
+
     #[test]
     fn single_group_and_empty_are_safe() {
         let one = Grouping::PerBlock.apply(&[(0, 0, 0)]);
@@ -7,6 +7,7 @@
 
 use serde::{Deserialize, Serialize};
 
+use super::compiled::{frame_times, CompiledTimeline};
 use super::pose::Pose;
 use super::stagger::{Group, GroupId, Stagger};
 use super::track::Clip;
@@ -59,7 +60,7 @@ pub enum Target {
 }
 
 impl Target {
-    fn matches(&self, id: GroupId) -> bool {
+    pub(super) fn matches(&self, id: GroupId) -> bool {
         match self {
             Target::Group(g) => *g == id,
             Target::Groups(gs) => gs.contains(&id),
@@ -137,6 +138,18 @@ impl Timeline {
         &self.groups
     }
 
+    /// Every entry as `(clip, target, offset_ms)`, in the order added.
+    pub(super) fn entries(&self) -> impl Iterator<Item = (&Clip, &Target, f32)> + '_ {
+        self.entries
+            .iter()
+            .map(|e| (&e.clip, &e.target, e.offset_ms))
+    }
+
+    /// Precompile for sampling many frames; see [`CompiledTimeline`].
+    pub fn compile(&self) -> CompiledTimeline {
+        CompiledTimeline::new(self)
+    }
+
     /// Bind a clip to a target, starting at `offset_ms`.
     pub fn add(&mut self, clip: Clip, target: Target, offset_ms: f32) -> &mut Self {
         self.entries.push(Entry {
@@ -222,26 +235,20 @@ impl Timeline {
     /// Times are computed in `f64` as `i * 1000 / fps` so they do not drift the
     /// way repeated accumulation would.
     pub fn frame_times(&self, fps: f64) -> Vec<f32> {
-        let fps = if fps <= 0.0 { 1.0 } else { fps };
-        let dur = self.duration_ms() as f64;
-        let count = ((dur / 1000.0) * fps).round().max(1.0) as usize;
-        (0..count)
-            .map(|i| (i as f64 * 1000.0 / fps) as f32)
-            .collect()
+        frame_times(self.duration_ms(), fps)
     }
 
-    /// Sample every frame of a capture at `fps`.
+    /// Sample every frame of a capture at `fps`, through a
+    /// [`CompiledTimeline`] and in parallel.
     pub fn frames(&self, fps: f64) -> Vec<Frame> {
-        self.frame_times(fps)
-            .into_iter()
-            .map(|t| self.seek(t))
-            .collect()
+        self.compile().frames(fps)
     }
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::animation::compiled::PoseBuffer;
     use crate::animation::easing::Easing;
     use crate::animation::stagger::{Axis, Grouping, Order};
     use crate::animation::track::{Property, Track};
@@ -418,4 +425,64 @@ mod tests {
         let empty = Timeline::new(vec![]);
         assert!(empty.seek(0.0).poses.is_empty());
     }
+
+    #[test]
+    fn compiled_timeline_matches_seek() {
+        use crate::animation::track::Repeat;
+        let mut tl = Timeline::new(groups(40));
+        tl.add_staggered(
+            slide(),
+            &Stagger::total(Order::Random(3), 900.0).eased(Easing::out_back()),
+            50.0,
+        );
+        tl.add(
+            Clip::new(300.0).delay(200.0).track(Track::tween(
+                Property::X,
+                0.0,
+                4.0,
+                Easing::Linear,
+            )),
+            Target::Groups(vec![3, 7, 11]),
+            100.0,
+        );
+        tl.add(
+            Clip::new(250.0)
+                .alternate(true)
+                .repeat(Repeat::Times(3))
+                .track(Track::tween(Property::Y, -2.0, 2.0, Easing::Linear)),
+            Target::All,
+            400.0,
+        );
+        tl.add(
+            Clip::new(1000.0)
+                .repeat(Repeat::Forever)
+                .track(Track::tween(Property::RotY, 0.0, 360.0, Easing::Linear)),
+            Target::Camera,
+            0.0,
+        );
+
+        let compiled = tl.compile();
+        let mut times = tl.frame_times(60.0);
+        // Exactly on entry edges, and past the end.
+        times.extend([50.0, 150.0, 300.0, 400.0, 600.0, 1150.0, 5000.0, -10.0]);
+        for &t in &times {
+            assert_eq!(compiled.seek(t), tl.seek(t), "t={t}");
+        }
+        assert_eq!(
+            compiled.frames_at(&times),
+            times.iter().map(|&t| tl.seek(t)).collect::<Vec<_>>()
+        );
+
+        let buffer = compiled.pose_buffer(&times);
+        assert_eq!(buffer, PoseBuffer::from_frames(&compiled.frames_at(&times)));
+        let (f, g) = (7, 11);
+        let pose = tl.seek(times[f]).poses[g].1;
+        let at = (f * buffer.group_count() + g) * 16;
+        assert_eq!(
+            &buffer.matrices[at + 12..at + 15],
+            &pose.to_matrix()[3][..3]
+        );
+        assert_eq!(buffer.opacity[f * buffer.group_count() + g], pose.opacity);
+        assert!(buffer.has_camera.iter().all(|&c| c));
+    }
 }
@@ -263,18 +263,17 @@ fn cell_bbox(grid: &Grid, v: Vec3) -> (Vec3, Vec3) {
 
 /// Build a [`Structure`] for a graph-detected period vector, using the voxel
 /// grid for coverage/region.
-fn structure_for(s: &UniversalSchematic, period: Vec3) -> Option<Structure> {
-    let grid = build_grid(s);
+pub(super) fn structure_for(grid: &Grid, period: Vec3) -> Option<Structure> {
     if grid.is_empty() {
         return None;
     }
-    let region = region_set(&grid, period);
+    let region = region_set(grid, period);
     if region.is_empty() {
         return None;
     }
     let coverage = region.len() as f32 / grid.len().max(1) as f32;
     let (rmn, rmx) = bbox_of(&region);
-    let (cmn, cmx) = cell_bbox(&grid, period);
+    let (cmn, cmx) = cell_bbox(grid, period);
     let diagonal = period.iter().filter(|&&c| c != 0).count() > 1;
     let dir = if diagonal {
         format!("diagonal {:?}", (period[0], period[1], period[2]))
@@ -302,33 +301,28 @@ fn structure_for(s: &UniversalSchematic, period: Vec3) -> Option<Structure> {
 /// diagonal lattices the pure-voxel detector misses. Returns an empty vec if the
 /// build isn't redstone-computational or has no detectable graph period.
 pub fn detect_structures_graph(s: &UniversalSchematic) -> Vec<Structure> {
-    let world = match MchprsWorld::new(s.clone()) {
-        Ok(w) => w,
-        Err(_) => return Vec::new(),
-    };
-    let graph = match world.export_graph_structural() {
-        Ok(g) => g,
-        Err(_) => return Vec::new(),
-    };
+    graph_period(s)
+        .and_then(|period| structure_for(&build_grid(s), period))
+        .into_iter()
+        .collect()
+}
+
+/// The period vector of the build's redstone logic graph, if it has one.
+pub(super) fn graph_period(s: &UniversalSchematic) -> Option<Vec3> {
+    let world = MchprsWorld::new(s.clone()).ok()?;
+    let graph = world.export_graph_structural().ok()?;
     if graph.nodes.len() < MIN_NODES {
-        return Vec::new();
+        return None;
     }
 
     let lab = wl_labels(&graph);
-    let dir = match dominant_dir(&graph, &lab) {
-        Some(d) => d,
-        None => return Vec::new(),
-    };
+    let dir = dominant_dir(&graph, &lab)?;
     let nodes: Vec<&RedstoneNode> = graph.nodes.iter().filter(|n| n.pos.is_some()).collect();
     if nodes.len() < MIN_NODES {
-        return Vec::new();
+        return None;
     }
     let origin = node_origin(&nodes);
-    let period = match true_period(&nodes, &lab, dir, origin) {
-        Some(p) => p,
-        None => return Vec::new(),
-    };
-    structure_for(s, period).into_iter().collect()
+    true_period(&nodes, &lab, dir, origin)
 }
 
 /// JSON array of graph-detected structures (binding-friendly entry point).
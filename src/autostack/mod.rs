@@ -5,13 +5,15 @@
 //! module ports the pure-voxel core: region-coverage multi-structure detection
 //! and lattice-vector resizing (1D, diagonal, and 2D). Graph-based detection,
 //! near-periodic/booster handling, and simulation-based verification layer on
-//! top behind the `simulation` feature.
+//! top behind the `simulation` feature. [`DetectSession`] re-detects after
+//! edits without re-analysing the whole build.
 //!
 //! See `docs`/the design notes for the maths. Everything here operates on a
 //! `Grid` (a map from integer voxel position to block state) extracted from a
 //! [`UniversalSchematic`], so it has no rendering or simulation dependencies.
 
 use crate::{BlockState, UniversalSchematic};
+use rayon::prelude::*;
 use std::collections::{HashMap, HashSet};
 
 /// Graph-based diagonal period detection (requires the redstone graph / sim).
@@ -20,6 +22,14 @@ mod graph_detect;
 #[cfg(feature = "simulation")]
 pub use graph_detect::{detect_structures_graph, detect_structures_graph_json};
 
+/// Detection kept up to date across edits.
+mod session;
+pub use session::DetectSession;
+
+/// Resize results stamped on demand.
+mod tiled;
+pub use tiled::TiledSchematic;
+
 pub type Pos = (i32, i32, i32);
 pub type Vec3 = [i32; 3];
 type Grid = HashMap<Pos, BlockState>;
@@ -75,14 +85,6 @@ fn build_grid(s: &UniversalSchematic) -> Grid {
     g
 }
 
-fn grid_to_schematic(grid: &Grid, name: &str) -> UniversalSchematic {
-    let mut out = UniversalSchematic::new(name.to_string());
-    for (&(x, y, z), bs) in grid {
-        out.set_block(x, y, z, bs);
-    }
-    out
-}
-
 #[inline]
 fn proj(p: Pos, v: Vec3, o: Vec3) -> i64 {
     (p.0 - o[0]) as i64 * v[0] as i64
@@ -110,19 +112,19 @@ fn grid_origin(grid: &Grid) -> Vec3 {
 // ---------------------------------------------------------------------------
 /// Voxels locally periodic under `v`: a +v or -v translate exists and matches.
 fn region_set(grid: &Grid, v: Vec3) -> HashSet<Pos> {
-    let mut r = HashSet::new();
-    for (p, bs) in grid {
-        for sgn in [1i32, -1] {
-            let q = (p.0 + sgn * v[0], p.1 + sgn * v[1], p.2 + sgn * v[2]);
-            if let Some(bq) = grid.get(&q) {
-                if bq.name == bs.name {
-                    r.insert(*p);
-                    break;
-                }
-            }
-        }
-    }
-    r
+    grid.iter()
+        .filter(|(p, bs)| periodic_at(grid, **p, bs, v))
+        .map(|(p, _)| *p)
+        .collect()
+}
+
+/// Whether the voxel `bs` at `p` belongs to [`region_set`] for `v`.
+#[inline]
+fn periodic_at(grid: &Grid, p: Pos, bs: &BlockState, v: Vec3) -> bool {
+    [1i32, -1].iter().any(|&sgn| {
+        let q = (p.0 + sgn * v[0], p.1 + sgn * v[1], p.2 + sgn * v[2]);
+        grid.get(&q).is_some_and(|bq| bq.name == bs.name)
+    })
 }
 
 fn axis_vec(ax: usize, t: i32) -> Vec3 {
@@ -131,11 +133,31 @@ fn axis_vec(ax: usize, t: i32) -> Vec3 {
     v
 }
 
-/// `(T, region)` maximising local-periodicity coverage along `ax`.
-fn best_axis(grid: &Grid, ax: usize, tmax: i32) -> (i32, HashSet<Pos>) {
-    let mut best: (i32, HashSet<Pos>) = (2, HashSet::new());
-    for t in 2..=tmax {
-        let r = region_set(grid, axis_vec(ax, t));
+/// Longest period tried along each axis (the shortest is 2).
+const MAX_PERIOD: i32 = 10;
+/// Periods tried per axis.
+const PERIODS: usize = (MAX_PERIOD - 1) as usize;
+
+/// Period vector of candidate `i`: axis `i / PERIODS`, period `2 + i % PERIODS`.
+fn candidate_vec(i: usize) -> Vec3 {
+    axis_vec(i / PERIODS, 2 + (i % PERIODS) as i32)
+}
+
+/// [`region_set`] of every candidate, by [`candidate_vec`] index. The
+/// candidates are independent, so they run on the rayon pool.
+fn candidate_sets(grid: &Grid) -> Vec<HashSet<Pos>> {
+    (0..3 * PERIODS)
+        .into_par_iter()
+        .map(|i| region_set(grid, candidate_vec(i)))
+        .collect()
+}
+
+/// `(T, region)` maximising local-periodicity coverage along `ax`; the
+/// shortest period wins a tie.
+fn best_axis(sets: &[HashSet<Pos>], ax: usize) -> (i32, &HashSet<Pos>) {
+    let mut best = (2, &sets[ax * PERIODS]);
+    for t in 3..=MAX_PERIOD {
+        let r = &sets[ax * PERIODS + (t - 2) as usize];
         if r.len() > best.1.len() {
             best = (t, r);
         }
@@ -191,8 +213,14 @@ pub fn detect_structures(s: &UniversalSchematic) -> Vec<Structure> {
 }
 
 fn detect_structures_grid(grid: &Grid) -> Vec<Structure> {
-    let tot = grid.len().max(1) as f32;
-    let axper: Vec<(i32, HashSet<Pos>)> = (0..3).map(|ax| best_axis(grid, ax, 10)).collect();
+    structures_from(grid.len(), &candidate_sets(grid))
+}
+
+/// The ranked structures of a build of `voxels` non-air voxels, given its
+/// [`candidate_sets`].
+fn structures_from(voxels: usize, sets: &[HashSet<Pos>]) -> Vec<Structure> {
+    let tot = voxels.max(1) as f32;
+    let axper: Vec<(i32, &HashSet<Pos>)> = (0..3).map(|ax| best_axis(sets, ax)).collect();
     let cov: Vec<f32> = (0..3).map(|ax| axper[ax].1.len() as f32 / tot).collect();
 
     let mut structs: Vec<Structure> = Vec::new();
@@ -203,7 +231,7 @@ fn detect_structures_grid(grid: &Grid) -> Vec<Structure> {
     cands.sort_by(|&a, &b| cov[b].partial_cmp(&cov[a]).unwrap());
     if cands.len() >= 2 {
         let (a, b) = (cands[0], cands[1]);
-        let inter: HashSet<Pos> = axper[a].1.intersection(&axper[b].1).copied().collect();
+        let inter: HashSet<Pos> = axper[a].1.intersection(axper[b].1).copied().collect();
         if inter.len() as f32 / tot >= 0.35 {
             let (rmn, rmx) = bbox_of(&inter);
             let vecs = vec![axis_vec(a, axper[a].0), axis_vec(b, axper[b].0)];
@@ -228,7 +256,7 @@ fn detect_structures_grid(grid: &Grid) -> Vec<Structure> {
         if used[ax] || cov[ax] < 0.15 {
             continue;
         }
-        let (rmn, rmx) = bbox_of(&axper[ax].1);
+        let (rmn, rmx) = bbox_of(axper[ax].1);
         let vecs = vec![axis_vec(ax, axper[ax].0)];
         let (cmn, cmx) = unit_bbox(&vecs, rmn, rmx);
         structs.push(Structure {
@@ -316,6 +344,16 @@ pub fn resize_1d(
     v: Vec3,
     n_units: usize,
 ) -> Result<UniversalSchematic, AutostackError> {
+    resize_1d_tiled(s, v, n_units).map(|t| t.materialize())
+}
+
+/// [`resize_1d`] without stamping: the unit cell is converted once and
+/// placed when the result is materialized.
+pub fn resize_1d_tiled(
+    s: &UniversalSchematic,
+    v: Vec3,
+    n_units: usize,
+) -> Result<TiledSchematic, AutostackError> {
     if n_units == 0 {
         return Err(AutostackError::BadUnits);
     }
@@ -324,27 +362,20 @@ pub fn resize_1d(
     let (phase, ks, run_start, run_len) = best_phase(&grid, v, o);
     let byk = lattice_slabs(&grid, v, o, phase);
 
-    let mut seq: Vec<&Cell> = Vec::new();
-    for &k in &ks[..run_start] {
-        seq.push(&byk[&k]);
-    }
-    let unit = &byk[&ks[run_start]];
-    for _ in 0..n_units {
-        seq.push(unit);
-    }
-    for &k in &ks[run_start + run_len..] {
-        seq.push(&byk[&k]);
-    }
-
-    let mut out = Grid::new();
-    for (i, cell) in seq.iter().enumerate() {
-        let i = i as i32;
-        for (loc, bs) in cell.iter() {
-            let p = (loc[0] + i * v[0], loc[1] + i * v[1], loc[2] + i * v[2]);
-            out.insert(p, bs.clone());
+    let mut seq: Vec<i64> = ks[..run_start].to_vec();
+    seq.extend(std::iter::repeat_n(ks[run_start], n_units));
+    seq.extend_from_slice(&ks[run_start + run_len..]);
+
+    let mut out = TiledSchematic::new("resized");
+    let mut bricks: HashMap<i64, Option<usize>> = HashMap::new();
+    for (i, k) in seq.iter().enumerate() {
+        let brick = *bricks.entry(*k).or_insert_with(|| out.add_cell(&byk[k]));
+        if let Some(brick) = brick {
+            let i = i as i32;
+            out.stamp(brick, [i * v[0], i * v[1], i * v[2]]);
         }
     }
-    Ok(grid_to_schematic(&out, "resized"))
+    Ok(out)
 }
 
 // ---------------------------------------------------------------------------
@@ -372,6 +403,18 @@ pub fn resize_2d(
     m1: usize,
     m2: usize,
 ) -> Result<UniversalSchematic, AutostackError> {
+    resize_2d_tiled(s, v1, v2, m1, m2).map(|t| t.materialize())
+}
+
+/// [`resize_2d`] without stamping: each distinct cell is converted once and
+/// placed when the result is materialized.
+pub fn resize_2d_tiled(
+    s: &UniversalSchematic,
+    v1: Vec3,
+    v2: Vec3,
+    m1: usize,
+    m2: usize,
+) -> Result<TiledSchematic, AutostackError> {
     if m1 == 0 || m2 == 0 {
         return Err(AutostackError::BadUnits);
     }
@@ -399,24 +442,30 @@ pub fn resize_2d(
     let new_i = rs1 + m1 + n_tail1;
     let new_j = rs2 + m2 + n_tail2;
 
-    let mut out = Grid::new();
+    let mut out = TiledSchematic::new("resized");
+    let mut bricks: HashMap<(i64, i64), Option<usize>> = HashMap::new();
     for i2 in 0..new_i {
         let oi = remap(i2, rs1, rl1, m1) as i64;
         for j2 in 0..new_j {
             let oj = remap(j2, rs2, rl2, m2) as i64;
-            if let Some(cell) = byij.get(&(oi, oj)) {
-                for (loc, bs) in cell {
-                    let p = (
-                        loc[0] + (i2 as i32) * v1[0] + (j2 as i32) * v2[0],
-                        loc[1] + (i2 as i32) * v1[1] + (j2 as i32) * v2[1],
-                        loc[2] + (i2 as i32) * v1[2] + (j2 as i32) * v2[2],
-                    );
-                    out.insert(p, bs.clone());
-                }
+            let Some(cell) = byij.get(&(oi, oj)) else {
+                continue;
+            };
+            let brick = *bricks.entry((oi, oj)).or_insert_with(|| out.add_cell(cell));
+            if let Some(brick) = brick {
+                let (i2, j2) = (i2 as i32, j2 as i32);
+                out.stamp(
+                    brick,
+                    [
+                        i2 * v1[0] + j2 * v2[0],
+                        i2 * v1[1] + j2 * v2[1],
+                        i2 * v1[2] + j2 * v2[2],
+                    ],
+                );
             }
         }
     }
-    Ok(grid_to_schematic(&out, "resized"))
+    Ok(out)
 }
 
 /// JSON array of the detected structures — the binding-friendly entry point
@@ -452,6 +501,23 @@ pub fn resize(
     }
 }
 
+/// [`resize`] without stamping; see [`TiledSchematic`].
+pub fn resize_tiled(
+    s: &UniversalSchematic,
+    st: &Structure,
+    units: &[usize],
+) -> Result<TiledSchematic, AutostackError> {
+    match st.mode.as_str() {
+        "2d" if st.vectors.len() == 2 && units.len() >= 2 => {
+            resize_2d_tiled(s, st.vectors[0], st.vectors[1], units[0], units[1])
+        }
+        _ if !st.vectors.is_empty() && !units.is_empty() => {
+            resize_1d_tiled(s, st.vectors[0], units[0])
+        }
+        _ => Err(AutostackError::BadUnits),
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -550,6 +616,35 @@ mod tests {
         assert_eq!(build_grid(&r).len(), 20);
     }
 
+    #[test]
+    fn tiled_resize_matches_its_materialization() {
+        // The diagonal staircase's cells overlap in their boxes.
+        let mut s = UniversalSchematic::new("diag".into());
+        let stone = BlockState::new("minecraft:stone");
+        let glass = BlockState::new("minecraft:glass");
+        for i in 0..6 {
+            s.set_block(i * 2, i, 0, &stone);
+            s.set_block(i * 2 + 1, i, 0, &glass);
+            s.set_block(i * 2 + 1, i + 1, 0, &glass);
+        }
+        let tiled = resize_1d_tiled(&s, [2, 1, 0], 40).unwrap();
+        assert!(tiled.cell_count() < tiled.stamp_count());
+
+        let m = tiled.materialize();
+        let b = tiled.bounds().unwrap();
+        for x in b.min.0..=b.max.0 {
+            for y in b.min.1..=b.max.1 {
+                let lazy = tiled.get_block(x, y, 0).map(|bs| bs.name.clone());
+                let built = m
+                    .get_block(x, y, 0)
+                    .filter(|bs| !AIR.contains(&bs.get_name()))
+                    .map(|bs| bs.name.clone());
+                assert_eq!(lazy, built);
+            }
+        }
+        assert_eq!(build_grid(&m).len(), 40 * 3);
+    }
+
     #[test]
     fn json_roundtrip() {
         let s = bar(6);
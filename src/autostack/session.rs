@@ -0,0 +1,259 @@
+//! [`DetectSession`]: auto-stack detection kept up to date across edits, so
+//! an editor offering resize handles after every stroke re-analyses only the
+//! voxels the stroke could have changed.
+//!
+//! The session keeps the voxel grid and the `region_set` of every
+//! `(axis, period)` candidate. Edits are found through
+//! [`Region::take_changed_cells`]; a voxel's membership of a candidate's set
+//! depends on the voxels one period either side of it, so each box of
+//! written cells is grown by the period along the candidate's axis before it
+//! is re-tested. Candidates update in parallel. A region that was added,
+//! removed or relaid out rebuilds everything.
+//!
+//! Like [`MeshSession`](crate::meshing::MeshSession), the session owns the
+//! change marks; pairing it with another consumer of them on the same
+//! schematic hides edits from both.
+
+use std::collections::{HashMap, HashSet};
+
+use rayon::prelude::*;
+
+use super::{
+    build_grid, candidate_sets, candidate_vec, periodic_at, structures_from, Grid, Pos, Structure,
+    AIR,
+};
+use crate::bounding_box::BoundingBox;
+use crate::{BlockState, Region, UniversalSchematic};
+
+/// Detected structures of one schematic, re-detected incrementally by
+/// [`DetectSession::update`].
+pub struct DetectSession {
+    /// Name and box of every region the grid was built from, by key.
+    regions: HashMap<String, (String, BoundingBox)>,
+    grid: Grid,
+    /// [`region_set`](super::region_set) of every candidate, by
+    /// [`candidate_vec`] index, kept in step with `grid`.
+    sets: Vec<HashSet<Pos>>,
+    structures: Vec<Structure>,
+    /// Graph-detected structures, until the next edit.
+    #[cfg(feature = "simulation")]
+    graph: Option<Vec<Structure>>,
+}
+
+impl DetectSession {
+    /// Detect the structures of all of `schematic` and start tracking its
+    /// edits.
+    pub fn new(schematic: &mut UniversalSchematic) -> Self {
+        let mut session = DetectSession {
+            regions: HashMap::new(),
+            grid: Grid::new(),
+            sets: Vec::new(),
+            structures: Vec::new(),
+            #[cfg(feature = "simulation")]
+            graph: None,
+        };
+        session.rebuild(schematic);
+        session
+    }
+
+    /// Re-detect after the edits since the last call (or since
+    /// [`DetectSession::new`]) and return the structures, ranked as
+    /// [`detect_structures`](super::detect_structures) ranks them.
+    pub fn update(&mut self, schematic: &mut UniversalSchematic) -> &[Structure] {
+        match self.take_written(schematic) {
+            None => self.rebuild(schematic),
+            Some(written) if written.is_empty() => {}
+            Some(written) => self.apply(schematic, &written),
+        }
+        &self.structures
+    }
+
+    /// The structures as of the last update.
+    pub fn structures(&self) -> &[Structure] {
+        &self.structures
+    }
+
+    /// [`detect_structures_graph`](super::detect_structures_graph) after
+    /// [`DetectSession::update`]. The logic graph is extracted from the whole
+    /// build, so it is only re-extracted when something was edited; coverage
+    /// comes from the session's grid.
+    #[cfg(feature = "simulation")]
+    pub fn update_graph(&mut self, schematic: &mut UniversalSchematic) -> &[Structure] {
+        self.update(schematic);
+        if self.graph.is_none() {
+            let found = super::graph_detect::graph_period(schematic)
+                .and_then(|period| super::graph_detect::structure_for(&self.grid, period));
+            self.graph = Some(found.into_iter().collect());
+        }
+        self.graph.as_deref().unwrap_or_default()
+    }
+
+    fn rebuild(&mut self, schematic: &mut UniversalSchematic) {
+        // Clear the change marks first: everything is re-detected below.
+        self.regions = regions_mut(schematic)
+            .map(|(key, region)| {
+                region.take_changed_cells();
+                (
+                    key.clone(),
+                    (region.name.clone(), region.get_bounding_box()),
+                )
+            })
+            .collect();
+        self.grid = build_grid(schematic);
+        self.sets = candidate_sets(&self.grid);
+        self.refresh();
+    }
+
+    /// Re-read the `written` boxes into the grid and re-test every candidate
+    /// around them.
+    fn apply(&mut self, schematic: &UniversalSchematic, written: &[BoundingBox]) {
+        for cells in written {
+            for p in cells_of(cells) {
+                match voxel_at(schematic, p) {
+                    Some(bs) => self.grid.insert(p, bs.clone()),
+                    None => self.grid.remove(&p),
+                };
+            }
+        }
+        let grid = &self.grid;
+        self.sets.par_iter_mut().enumerate().for_each(|(i, set)| {
+            let v = candidate_vec(i);
+            for cells in written {
+                let reach = BoundingBox::new(
+                    (cells.min.0 - v[0], cells.min.1 - v[1], cells.min.2 - v[2]),
+                    (cells.max.0 + v[0], cells.max.1 + v[1], cells.max.2 + v[2]),
+                );
+                for p in cells_of(&reach) {
+                    match grid.get(&p) {
+                        Some(bs) if periodic_at(grid, p, bs, v) => set.insert(p),
+                        _ => set.remove(&p),
+                    };
+                }
+            }
+        });
+        self.refresh();
+    }
+
+    fn refresh(&mut self) {
+        self.structures = structures_from(self.grid.len(), &self.sets);
+        #[cfg(feature = "simulation")]
+        {
+            self.graph = None;
+        }
+    }
+
+    /// Boxes of the cells written since the last call, or `None` if the
+    /// regions were added, removed or relaid out.
+    fn take_written(&mut self, schematic: &mut UniversalSchematic) -> Option<Vec<BoundingBox>> {
+        let mut written = Vec::new();
+        let mut seen = 0;
+        let mut relaid = false;
+        for (key, region) in regions_mut(schematic) {
+            // Every region is drained, even after a relayout is found, so the
+            // next call starts clean.
+            let boxes = region.take_changed_cells();
+            let known =
+                self.regions.get(key) == Some(&(region.name.clone(), region.get_bounding_box()));
+            seen += 1;
+            match boxes.filter(|_| known) {
+                Some(boxes) => written.extend(boxes),
+                None => relaid = true,
+            }
+        }
+        (!relaid && seen == self.regions.len()).then_some(written)
+    }
+}
+
+/// The voxel [`build_grid`] keeps at `p`: the non-air block of the last
+/// region holding one there, in `iter_blocks` order.
+fn voxel_at(schematic: &UniversalSchematic, p: Pos) -> Option<&BlockState> {
+    std::iter::once(&schematic.default_region)
+        .chain(schematic.other_regions.values())
+        .filter_map(|region| region.get_block(p.0, p.1, p.2))
+        .filter(|bs| !AIR.contains(&bs.get_name()))
+        .last()
+}
+
+fn cells_of(b: &BoundingBox) -> impl Iterator<Item = Pos> + '_ {
+    (b.min.1..=b.max.1).flat_map(move |y| {
+        (b.min.2..=b.max.2).flat_map(move |z| (b.min.0..=b.max.0).map(move |x| (x, y, z)))
+    })
+}
+
+/// Every region by key, default first.
+fn regions_mut(
+    schematic: &mut UniversalSchematic,
+) -> impl Iterator<Item = (&String, &mut Region)> + '_ {
+    std::iter::once((
+        &schematic.default_region_name,
+        &mut schematic.default_region,
+    ))
+    .chain(schematic.other_regions.iter_mut())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::autostack::detect_structures;
+
+    fn summary(structures: &[Structure]) -> Vec<(String, Vec<[i32; 3]>, u32, [i32; 3], [i32; 3])> {
+        structures
+            .iter()
+            .map(|st| {
+                (
+                    st.mode.clone(),
+                    st.vectors.clone(),
+                    (st.coverage * 1000.0) as u32,
+                    st.region_min,
+                    st.region_max,
+                )
+            })
+            .collect()
+    }
+
+    #[test]
+    fn updates_match_a_fresh_detection() {
+        let stone = BlockState::new("minecraft:stone");
+        let glass = BlockState::new("minecraft:glass");
+        let air = BlockState::new("minecraft:air");
+        let mut s = UniversalSchematic::new("t".into());
+        for i in 0..8 {
+            s.set_block(i * 3, 0, 0, &stone);
+            s.set_block(i * 3 + 1, 0, 0, &glass);
+        }
+        // Size the region so the edits below stay inside it.
+        s.set_block(23, 0, 4, &glass);
+        let mut session = DetectSession::new(&mut s);
+        assert_eq!(session.structures()[0].vectors[0], [3, 0, 0]);
+
+        let edits: [&dyn Fn(&mut UniversalSchematic); 4] = [
+            // Break the period at one end.
+            &|s| {
+                s.set_block(21, 0, 0, &glass);
+            },
+            // Clear a cell.
+            &|s| {
+                s.set_block(3, 0, 0, &air);
+            },
+            // Grow a second row along Z.
+            &|s| {
+                for i in 0..8 {
+                    s.set_block(i * 3, 0, 2, &stone);
+                    s.set_block(i * 3, 0, 4, &stone);
+                }
+            },
+            // Nothing.
+            &|_| {},
+        ];
+        for edit in edits {
+            edit(&mut s);
+            let incremental = summary(session.update(&mut s));
+            assert_eq!(incremental, summary(&detect_structures(&s)));
+        }
+
+        // Growing past the region's box relays it out and rebuilds.
+        s.set_block(40, 5, 5, &stone);
+        let incremental = summary(session.update(&mut s));
+        assert_eq!(incremental, summary(&detect_structures(&s)));
+    }
+}
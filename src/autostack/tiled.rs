@@ -0,0 +1,204 @@
+//! [`TiledSchematic`]: a resize result kept as unit cells plus where to stamp
+//! them.
+//!
+//! Stacking a 64-bit bank to 1024 bits is mostly copies of one cell. Each
+//! distinct cell is converted once into a dense brick of palette indices (x
+//! fastest, then z, then y, like region storage), so the block states are
+//! looked up once per cell rather than once per stamped block. Stamping then
+//! copies brick rows into the output buffer: a row with no air is a
+//! `memcpy`, and only rows with holes are copied cell by cell so that
+//! overlapping diagonal stamps keep each other's blocks. Nothing is stamped
+//! until [`TiledSchematic::materialize`].
+
+use std::collections::HashMap;
+
+use super::{Cell, Vec3};
+use crate::bounding_box::BoundingBox;
+use crate::{BlockState, UniversalSchematic};
+
+/// Palette index of air in a [`TiledSchematic`].
+const EMPTY: u32 = 0;
+
+/// One unit cell as palette indices over its bounding box.
+struct Brick {
+    min: Vec3,
+    /// Extent along x, y and z.
+    dims: [usize; 3],
+    cells: Vec<u32>,
+    /// Per `(y, z)` row, whether it holds no air.
+    full_rows: Vec<bool>,
+}
+
+impl Brick {
+    fn row(&self, row: usize) -> &[u32] {
+        &self.cells[row * self.dims[0]..(row + 1) * self.dims[0]]
+    }
+}
+
+/// A resized build as unit cells and their stamp offsets, materialized on
+/// demand. Later stamps win where stamps overlap, as they would placed one
+/// after another.
+pub struct TiledSchematic {
+    name: String,
+    /// Air first.
+    palette: Vec<BlockState>,
+    palette_index: HashMap<BlockState, u32>,
+    bricks: Vec<Brick>,
+    /// Brick and world offset of each stamp, in stamping order.
+    stamps: Vec<(usize, Vec3)>,
+}
+
+impl TiledSchematic {
+    pub(super) fn new(name: &str) -> Self {
+        let air = BlockState::new("minecraft:air");
+        TiledSchematic {
+            name: name.to_string(),
+            palette: vec![air.clone()],
+            palette_index: HashMap::from([(air, EMPTY)]),
+            bricks: Vec::new(),
+            stamps: Vec::new(),
+        }
+    }
+
+    /// Convert `cell` (block states by cell-local position) to a brick and
+    /// return its id. Empty cells get no brick.
+    pub(super) fn add_cell(&mut self, cell: &Cell) -> Option<usize> {
+        let mut min = [i32::MAX; 3];
+        let mut max = [i32::MIN; 3];
+        for loc in cell.keys() {
+            for i in 0..3 {
+                min[i] = min[i].min(loc[i]);
+                max[i] = max[i].max(loc[i]);
+            }
+        }
+        if cell.is_empty() {
+            return None;
+        }
+        let dims = [0, 1, 2].map(|i| (max[i] - min[i] + 1) as usize);
+        let mut cells = vec![EMPTY; dims[0] * dims[1] * dims[2]];
+        for (loc, bs) in cell {
+            let index = match self.palette_index.get(bs) {
+                Some(&index) => index,
+                None => {
+                    let index = self.palette.len() as u32;
+                    self.palette.push(bs.clone());
+                    self.palette_index.insert(bs.clone(), index);
+                    index
+                }
+            };
+            let [x, y, z] = [0, 1, 2].map(|i| (loc[i] - min[i]) as usize);
+            cells[(y * dims[2] + z) * dims[0] + x] = index;
+        }
+        let full_rows = cells
+            .chunks_exact(dims[0])
+            .map(|row| !row.contains(&EMPTY))
+            .collect();
+        self.bricks.push(Brick {
+            min,
+            dims,
+            cells,
+            full_rows,
+        });
+        Some(self.bricks.len() - 1)
+    }
+
+    /// Stamp `brick` shifted by `offset`.
+    pub(super) fn stamp(&mut self, brick: usize, offset: Vec3) {
+        self.stamps.push((brick, offset));
+    }
+
+    /// Box of every stamp; `None` if nothing is stamped.
+    pub fn bounds(&self) -> Option<BoundingBox> {
+        self.stamps
+            .iter()
+            .map(|(brick, offset)| self.stamp_box(*brick, *offset))
+            .reduce(|a, b| a.union(&b))
+    }
+
+    /// Stamps placed.
+    pub fn stamp_count(&self) -> usize {
+        self.stamps.len()
+    }
+
+    /// Distinct unit cells the stamps draw from.
+    pub fn cell_count(&self) -> usize {
+        self.bricks.len()
+    }
+
+    /// The block the materialized schematic would hold at `(x, y, z)`, or
+    /// `None` for air. Scans the stamps, latest first.
+    pub fn get_block(&self, x: i32, y: i32, z: i32) -> Option<&BlockState> {
+        self.stamps.iter().rev().find_map(|&(id, offset)| {
+            let brick = &self.bricks[id];
+            let local = [x - offset[0], y - offset[1], z - offset[2]];
+            let mut at = [0usize; 3];
+            for i in 0..3 {
+                let d = local[i] - brick.min[i];
+                if d < 0 || d as usize >= brick.dims[i] {
+                    return None;
+                }
+                at[i] = d as usize;
+            }
+            let index = brick.cells[(at[1] * brick.dims[2] + at[2]) * brick.dims[0] + at[0]];
+            (index != EMPTY).then(|| &self.palette[index as usize])
+        })
+    }
+
+    /// Stamp every cell into one dense region and return the schematic.
+    pub fn materialize(&self) -> UniversalSchematic {
+        let mut out = UniversalSchematic::new(self.name.clone());
+        let Some(bounds) = self.bounds() else {
+            return out;
+        };
+        let (w, h, l) = bounds.get_dimensions();
+        let (w, l) = (w as usize, l as usize);
+        let mut buf = vec![EMPTY; w * h as usize * l];
+        for &(id, offset) in &self.stamps {
+            let brick = &self.bricks[id];
+            let x0 = (brick.min[0] + offset[0] - bounds.min.0) as usize;
+            let y0 = (brick.min[1] + offset[1] - bounds.min.1) as usize;
+            let z0 = (brick.min[2] + offset[2] - bounds.min.2) as usize;
+            for y in 0..brick.dims[1] {
+                for z in 0..brick.dims[2] {
+                    let row = y * brick.dims[2] + z;
+                    let start = ((y0 + y) * l + z0 + z) * w + x0;
+                    let dst = &mut buf[start..start + brick.dims[0]];
+                    let src = brick.row(row);
+                    if brick.full_rows[row] {
+                        dst.copy_from_slice(src);
+                    } else {
+                        for (d, &s) in dst.iter_mut().zip(src) {
+                            if s != EMPTY {
+                                *d = s;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        out.ensure_bounds(bounds.min, bounds.max);
+        let region = &mut out.default_region;
+        let remap: Vec<u32> = self
+            .palette
+            .iter()
+            .map(|bs| region.get_or_insert_in_palette(bs) as u32)
+            .collect();
+        if remap.iter().enumerate().any(|(i, &r)| r as usize != i) {
+            for v in &mut buf {
+                *v = remap[*v as usize];
+            }
+        }
+        region
+            .write_palette_indices(bounds.min, bounds.max, &buf)
+            .expect("buffer covers the stamped box");
+        out
+    }
+
+    fn stamp_box(&self, id: usize, offset: Vec3) -> BoundingBox {
+        let brick = &self.bricks[id];
+        let min = [0, 1, 2].map(|i| brick.min[i] + offset[i]);
+        let max = [0, 1, 2].map(|i| min[i] + brick.dims[i] as i32 - 1);
+        BoundingBox::new((min[0], min[1], min[2]), (max[0], max[1], max[2]))
+    }
+}
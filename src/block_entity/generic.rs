@@ -1,4 +1,5 @@
 use crate::item::ItemStack;
+use crate::memory;
 use crate::utils::{NbtMap, NbtValue};
 use quartz_nbt::NbtCompound;
 use serde::{Deserialize, Serialize};
@@ -34,6 +35,12 @@ impl BlockEntity {
         }
     }
 
+    /// Heap bytes held by the id and the NBT allocation. Shared NBT is
+    /// counted in full by every holder.
+    pub fn heap_bytes(&self) -> usize {
+        self.id.len() + memory::arc_bytes::<NbtMap>() + self.nbt.heap_bytes()
+    }
+
     /// Get a mutable reference to the NBT map. Copy-on-write: if other
     /// BlockEntity instances share this NBT (via `clone`), this clones
     /// it once and gives back a uniquely-owned mutable reference.
@@ -48,6 +55,17 @@ impl BlockEntity {
         self.nbt = Arc::new(nbt);
     }
 
+    /// Drop the position keys (`Pos`, `x`, `y`, `z`) from the NBT once they
+    /// have been read into `position`, so block entities that differ only in
+    /// where they stand compare equal. Writers emit position from
+    /// `position`, never from these keys.
+    pub fn strip_position_keys(&mut self) {
+        const KEYS: [&str; 4] = ["Pos", "x", "y", "z"];
+        if KEYS.iter().any(|key| self.nbt.contains_key(key)) {
+            self.nbt_mut().retain(|key, _| !KEYS.contains(&key));
+        }
+    }
+
     pub fn with_nbt_data(mut self, key: String, value: NbtValue) -> Self {
         self.nbt_mut().insert(key, value);
         self
@@ -61,7 +79,7 @@ impl BlockEntity {
             NbtValue::IntArray(vec![self.position.0, self.position.1, self.position.2]),
         );
         for (key, value) in self.nbt.iter() {
-            map.insert(key.clone(), value.clone());
+            map.insert(key.to_string(), value.clone());
         }
         map
     }
@@ -92,7 +110,12 @@ impl BlockEntity {
     }
 
     pub fn from_nbt(nbt: &NbtCompound) -> Self {
-        let nbt_map = NbtMap::from_quartz_nbt(nbt);
+        Self::from_nbt_map(NbtMap::from_quartz_nbt(nbt))
+    }
+
+    /// [`BlockEntity::from_nbt`] for NBT already in the crate's own form,
+    /// which is kept as the block entity's data without a copy.
+    pub fn from_nbt_map(nbt_map: NbtMap) -> Self {
         // The id key is `Id` in Sponge v3 / Nucleation's own litematic writer, but
         // vanilla and Litematica use lowercase `id` — accept both.
         let id = nbt_map
@@ -139,7 +162,7 @@ impl BlockEntity {
 
         // Store the rest of the NBT data
         for (key, value) in self.nbt.iter() {
-            nbt.insert(key, value.to_quartz_nbt());
+            nbt.insert(key.as_str(), value.to_quartz_nbt());
         }
         nbt
     }
@@ -200,7 +223,7 @@ impl BlockEntity {
 
             // Add all NBT data
             for (key, value) in self.nbt.iter() {
-                data_compound.insert(key, value.to_quartz_nbt());
+                data_compound.insert(key.as_str(), value.to_quartz_nbt());
             }
             nbt.insert("Data", quartz_nbt::NbtTag::Compound(data_compound));
         }
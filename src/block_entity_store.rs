@@ -13,6 +13,8 @@
 //! by an owned BlockEntity value. The palette layout collapses repeated
 //! templates: `insert_template(positions, Arc<BE>)` performs ONE palette
 //! push and N small u32 inserts.
+//! Format readers get the same sharing for loaded files by routing each
+//! block entity through a [`BlockEntityInterner`].
 //!
 //! ## Position invariant
 //!
@@ -30,8 +32,12 @@
 //! `.reserve()`, `.drain()`, `.extend()`.
 
 use crate::block_entity::BlockEntity;
-use rustc_hash::FxHashMap;
+use crate::memory;
+use crate::nbt::NbtMap;
+use rayon::prelude::*;
+use rustc_hash::{FxHashMap, FxHashSet, FxHasher};
 use serde::{Deserialize, Deserializer, Serialize, Serializer};
+use std::hash::{Hash, Hasher};
 use std::sync::Arc;
 
 #[derive(Debug, Clone, Default)]
@@ -74,6 +80,16 @@ impl BlockEntityStore {
         }
     }
 
+    /// Store `template` at `pos`, sharing it with every other position that
+    /// holds the same Arc. For loaders routing through a
+    /// [`BlockEntityInterner`]; the template's `position` may be stale.
+    #[inline]
+    pub fn insert_shared(&mut self, pos: (i32, i32, i32), template: Arc<BlockEntity>) {
+        let idx = self.palette.len() as u32;
+        self.palette.push(template);
+        self.by_pos.insert(pos, idx);
+    }
+
     #[inline]
     pub fn get(&self, pos: &(i32, i32, i32)) -> Option<&BlockEntity> {
         self.by_pos
@@ -111,6 +127,28 @@ impl BlockEntityStore {
         self.by_pos.reserve(n);
     }
 
+    /// Heap bytes held by the position table and every template, including
+    /// templates no longer referenced by any position. Templates and NBT
+    /// shared within the store are counted once.
+    pub fn heap_bytes(&self) -> usize {
+        let mut seen_templates = FxHashSet::default();
+        let mut seen_nbt = FxHashSet::default();
+        let templates: usize = self
+            .palette
+            .iter()
+            .filter(|be| seen_templates.insert(Arc::as_ptr(*be)))
+            .map(|be| {
+                let nbt = if seen_nbt.insert(Arc::as_ptr(&be.nbt)) {
+                    memory::arc_bytes::<NbtMap>() + be.nbt.heap_bytes()
+                } else {
+                    0
+                };
+                memory::arc_bytes::<BlockEntity>() + be.id.len() + nbt
+            })
+            .sum();
+        memory::vec_bytes(&self.palette) + memory::table_bytes(&self.by_pos) + templates
+    }
+
     /// Iterate `(position, &BlockEntity)` pairs. **The position from the
     /// iterator is the canonical position; do not use `be.position` for
     /// serialization** — it may be stale on shared templates.
@@ -132,6 +170,38 @@ impl BlockEntityStore {
         self.by_pos.keys()
     }
 
+    /// Keep only the positions `f` accepts. Templates stay in the palette.
+    pub fn retain(&mut self, mut f: impl FnMut(&(i32, i32, i32)) -> bool) {
+        self.by_pos.retain(|pos, _| f(pos));
+    }
+
+    /// Store the template `src` holds at every position `place` maps to
+    /// `Some(destination)`, at that destination. Templates are shared, not
+    /// cloned: each source slot joins this palette once however many
+    /// positions use it, so stamping a module of identical chests adds one
+    /// Arc. Like [`insert_shared`](Self::insert_shared), the templates keep
+    /// their source `position`. Returns the number of positions stored.
+    pub fn copy_shared_from(
+        &mut self,
+        src: &BlockEntityStore,
+        mut place: impl FnMut((i32, i32, i32)) -> Option<(i32, i32, i32)>,
+    ) -> usize {
+        let mut by_slot: Vec<Option<u32>> = vec![None; src.palette.len()];
+        let mut copied = 0;
+        for (&pos, &idx) in &src.by_pos {
+            let Some(dest) = place(pos) else {
+                continue;
+            };
+            let slot = *by_slot[idx as usize].get_or_insert_with(|| {
+                self.palette.push(src.palette[idx as usize].clone());
+                (self.palette.len() - 1) as u32
+            });
+            self.by_pos.insert(dest, slot);
+            copied += 1;
+        }
+        copied
+    }
+
     /// Remap every stored position via `f` without touching the palette.
     /// Far cheaper than `drain` + `insert` when transforms only shuffle
     /// coordinates (flip, rotate, translate). Templates remain shared and
@@ -148,6 +218,69 @@ impl BlockEntityStore {
         }
     }
 
+    /// Rewrite every referenced template with `f`, each once and in
+    /// parallel, rather than once per position: positions sharing a
+    /// template keep sharing it. Templates no position references are
+    /// dropped. `f` sees the template's (possibly stale) `position`.
+    pub fn par_map_templates<F>(&mut self, f: F)
+    where
+        F: Fn(&mut BlockEntity) + Sync + Send,
+    {
+        // Old palette index -> new one; the same Arc in two slots is one
+        // template.
+        let mut remap = vec![u32::MAX; self.palette.len()];
+        let mut by_ptr: FxHashMap<*const BlockEntity, u32> = FxHashMap::default();
+        let mut palette = Vec::new();
+        for idx in self.by_pos.values_mut() {
+            let slot = &mut remap[*idx as usize];
+            if *slot == u32::MAX {
+                let template = &self.palette[*idx as usize];
+                *slot = *by_ptr.entry(Arc::as_ptr(template)).or_insert_with(|| {
+                    palette.push(template.clone());
+                    (palette.len() - 1) as u32
+                });
+            }
+            *idx = *slot;
+        }
+        // Drop the old slots so templates only this store held convert in
+        // place instead of being cloned.
+        self.palette.clear();
+        palette
+            .par_iter_mut()
+            .for_each(|template| f(Arc::make_mut(template)));
+        self.palette = palette;
+    }
+
+    /// `(position, value)` for every position whose template `f` maps to
+    /// `Some(value)`. `f` runs once per template rather than once per
+    /// position, so selecting and decoding one kind of block entity (every
+    /// sign and its text, say) costs one call per distinct template. In no
+    /// particular order.
+    pub fn filter_map_templates<T: Clone>(
+        &self,
+        mut f: impl FnMut(&BlockEntity) -> Option<T>,
+    ) -> Vec<((i32, i32, i32), T)> {
+        // Palette slot -> index into `mapped`; the same Arc in two slots is
+        // one template.
+        let mut by_slot: Vec<Option<u32>> = vec![None; self.palette.len()];
+        let mut by_ptr: FxHashMap<*const BlockEntity, u32> = FxHashMap::default();
+        let mut mapped: Vec<Option<T>> = Vec::new();
+        let mut out = Vec::new();
+        for (&pos, &idx) in &self.by_pos {
+            let slot = *by_slot[idx as usize].get_or_insert_with(|| {
+                let template = &self.palette[idx as usize];
+                *by_ptr.entry(Arc::as_ptr(template)).or_insert_with(|| {
+                    mapped.push(f(template));
+                    (mapped.len() - 1) as u32
+                })
+            });
+            if let Some(value) = &mapped[slot as usize] {
+                out.push((pos, value.clone()));
+            }
+        }
+        out
+    }
+
     /// Drain all entries, materializing each into an owned BlockEntity with
     /// its position field set from the storage key. Used by transforms
     /// (rotate/flip) that need ownership to mutate.
@@ -180,6 +313,49 @@ impl BlockEntityStore {
     }
 }
 
+/// Collapses block entities with identical id and NBT onto one shared
+/// template while a file loads, so a storage hall of identical chests keeps
+/// one copy of their contents. Position is ignored: callers strip the
+/// position keys from the NBT first and store each result with
+/// [`BlockEntityStore::insert_shared`] under its real position.
+#[derive(Debug, Default)]
+pub struct BlockEntityInterner {
+    /// Content hash -> templates seen with that hash.
+    seen: FxHashMap<u64, Vec<Arc<BlockEntity>>>,
+}
+
+impl BlockEntityInterner {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// The shared template equal to `be`, or `be` itself as a new one.
+    pub fn intern(&mut self, be: BlockEntity) -> Arc<BlockEntity> {
+        let mut hasher = FxHasher::default();
+        be.id.hash(&mut hasher);
+        be.nbt.hash(&mut hasher);
+        let bucket = self.seen.entry(hasher.finish()).or_default();
+        if let Some(template) = bucket
+            .iter()
+            .find(|t| t.id == be.id && (Arc::ptr_eq(&t.nbt, &be.nbt) || *t.nbt == *be.nbt))
+        {
+            return template.clone();
+        }
+        let template = Arc::new(be);
+        bucket.push(template.clone());
+        template
+    }
+
+    /// Distinct templates handed out so far.
+    pub fn len(&self) -> usize {
+        self.seen.values().map(Vec::len).sum()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.seen.is_empty()
+    }
+}
+
 impl Serialize for BlockEntityStore {
     fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
         // Emit a Vec<BlockEntity> where each entry's position field is set
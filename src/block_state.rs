@@ -1,3 +1,4 @@
+use crate::memory;
 use quartz_nbt::{NbtCompound, NbtTag};
 use serde::{Deserialize, Serialize};
 use smol_str::SmolStr;
@@ -49,6 +50,16 @@ impl BlockState {
         self.name.as_str()
     }
 
+    /// Heap bytes held by the name and properties.
+    pub fn heap_bytes(&self) -> usize {
+        let properties: usize = self
+            .properties
+            .iter()
+            .map(|(k, v)| memory::smol_str_bytes(k) + memory::smol_str_bytes(v))
+            .sum();
+        memory::smol_str_bytes(&self.name) + memory::vec_bytes(&self.properties) + properties
+    }
+
     /// Parse the `Display` form: `name` or `name[k=v,k=v]`. Inverse of `to_string`.
     pub fn from_block_string(s: &str) -> Result<Self, String> {
         let s = s.trim();
@@ -0,0 +1,79 @@
+//! Process-wide interner for block states.
+//!
+//! [`StateId::of`] maps each distinct [`BlockState`] to a `u32` id and
+//! [`StateId::state`] resolves it back. Ids are stable for the life of the
+//! process but depend on interning order, so they are never serialized.
+
+use crate::BlockState;
+use rustc_hash::FxHashMap;
+use std::sync::{OnceLock, RwLock};
+
+/// Interned id of a [`BlockState`]. Equal ids mean equal states.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub struct StateId(u32);
+
+#[derive(Default)]
+struct Registry {
+    ids: FxHashMap<BlockState, StateId>,
+    states: Vec<BlockState>,
+}
+
+fn registry() -> &'static RwLock<Registry> {
+    static REGISTRY: OnceLock<RwLock<Registry>> = OnceLock::new();
+    REGISTRY.get_or_init(Default::default)
+}
+
+impl StateId {
+    /// The id of `state`, interning it on first sight.
+    pub fn of(state: &BlockState) -> StateId {
+        // A poisoned lock only means another thread panicked mid-insert; the
+        // maps are updated together below, so their contents stay usable.
+        {
+            let registry = registry().read().unwrap_or_else(|e| e.into_inner());
+            if let Some(&id) = registry.ids.get(state) {
+                return id;
+            }
+        }
+        let mut registry = registry().write().unwrap_or_else(|e| e.into_inner());
+        if let Some(&id) = registry.ids.get(state) {
+            return id;
+        }
+        let id =
+            StateId(u32::try_from(registry.states.len()).expect("more than u32::MAX block states"));
+        registry.states.push(state.clone());
+        registry.ids.insert(state.clone(), id);
+        id
+    }
+
+    /// Intern every state of a palette, in order.
+    pub fn of_all(states: &[BlockState]) -> Vec<StateId> {
+        states.iter().map(StateId::of).collect()
+    }
+
+    /// The state this id was interned from.
+    pub fn state(self) -> BlockState {
+        let registry = registry().read().unwrap_or_else(|e| e.into_inner());
+        registry.states[self.0 as usize].clone()
+    }
+
+    /// The raw id, for use as a dense table index within this process.
+    pub fn as_u32(self) -> u32 {
+        self.0
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn equal_states_share_one_id() {
+        let stairs = BlockState::new("minecraft:oak_stairs")
+            .with_properties(vec![("facing".into(), "east".into())]);
+        let id = StateId::of(&stairs);
+        assert_eq!(StateId::of(&stairs.clone()), id);
+        assert_ne!(StateId::of(&BlockState::new("minecraft:oak_stairs")), id);
+        assert_eq!(id.state(), stairs);
+        assert_eq!(StateId::of_all(&[stairs.clone(), stairs]), vec![id, id]);
+    }
+}
@@ -0,0 +1,1804 @@
+//! Storage for a region's per-cell palette indices.
+//!
+//! Dense storage holds one element per cell at the narrowest width the
+//! palette allows (`u8`, `u16` or `u32`) and widens in place when a larger
+//! index is written; `usize::MAX` (the no-air sentinel) round-trips as
+//! `u32::MAX`. Sparse storage ([`BlockStorage::sparse`]) keeps only written
+//! 16×16×16 sections, shared copy-on-write, and reads the rest as air. Both
+//! serialize as a plain sequence of integers.
+
+use rustc_hash::FxHashMap;
+use serde::{Deserialize, Deserializer, Serialize, Serializer};
+use std::collections::hash_map::Entry;
+use std::collections::TryReserveError;
+use std::ops::Range;
+use std::sync::Arc;
+
+/// Element width of a dense [`BlockStorage`], narrowest first.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord)]
+enum Width {
+    U8,
+    U16,
+    U32,
+}
+
+impl Width {
+    /// Narrowest width that can hold `value`.
+    #[inline]
+    fn of(value: usize) -> Width {
+        if value <= u8::MAX as usize {
+            Width::U8
+        } else if value <= u16::MAX as usize {
+            Width::U16
+        } else if u32::fits(value) {
+            Width::U32
+        } else {
+            panic!("palette index {value} exceeds 32-bit block storage")
+        }
+    }
+
+    fn bytes(self) -> usize {
+        match self {
+            Width::U8 => 1,
+            Width::U16 => 2,
+            Width::U32 => 4,
+        }
+    }
+}
+
+/// One storage element type. Conversions assume the value fits.
+trait Cell: Copy + PartialEq + Send + Sync + bytemuck::Pod + 'static {
+    fn fits(value: usize) -> bool;
+    fn from_index(value: usize) -> Self;
+    fn index(self) -> usize;
+    /// Decode from exactly `size_of::<Self>()` little-endian bytes.
+    fn read_le(bytes: &[u8]) -> Self;
+    fn write_le(self, out: &mut Vec<u8>);
+}
+
+impl Cell for u8 {
+    #[inline(always)]
+    fn fits(value: usize) -> bool {
+        value <= u8::MAX as usize
+    }
+    #[inline(always)]
+    fn from_index(value: usize) -> Self {
+        value as u8
+    }
+    #[inline(always)]
+    fn index(self) -> usize {
+        self as usize
+    }
+    #[inline(always)]
+    fn read_le(bytes: &[u8]) -> Self {
+        u8::from_le_bytes(bytes.try_into().expect("cell width"))
+    }
+    #[inline(always)]
+    fn write_le(self, out: &mut Vec<u8>) {
+        out.extend_from_slice(&self.to_le_bytes());
+    }
+}
+
+impl Cell for u16 {
+    #[inline(always)]
+    fn fits(value: usize) -> bool {
+        value <= u16::MAX as usize
+    }
+    #[inline(always)]
+    fn from_index(value: usize) -> Self {
+        value as u16
+    }
+    #[inline(always)]
+    fn index(self) -> usize {
+        self as usize
+    }
+    #[inline(always)]
+    fn read_le(bytes: &[u8]) -> Self {
+        u16::from_le_bytes(bytes.try_into().expect("cell width"))
+    }
+    #[inline(always)]
+    fn write_le(self, out: &mut Vec<u8>) {
+        out.extend_from_slice(&self.to_le_bytes());
+    }
+}
+
+impl Cell for u32 {
+    #[inline(always)]
+    fn fits(value: usize) -> bool {
+        value < u32::MAX as usize || value == usize::MAX
+    }
+    #[inline(always)]
+    fn from_index(value: usize) -> Self {
+        if value == usize::MAX {
+            u32::MAX
+        } else {
+            value as u32
+        }
+    }
+    #[inline(always)]
+    fn index(self) -> usize {
+        if self == u32::MAX {
+            usize::MAX
+        } else {
+            self as usize
+        }
+    }
+    #[inline(always)]
+    fn read_le(bytes: &[u8]) -> Self {
+        u32::from_le_bytes(bytes.try_into().expect("cell width"))
+    }
+    #[inline(always)]
+    fn write_le(self, out: &mut Vec<u8>) {
+        out.extend_from_slice(&self.to_le_bytes());
+    }
+}
+
+#[derive(Debug, Clone)]
+enum Cells {
+    U8(Vec<u8>),
+    U16(Vec<u16>),
+    U32(Vec<u32>),
+    Sparse(Box<SparseCells>),
+}
+
+/// Dispatch over the concrete vector inside a `Cells`, binding it to `$v`
+/// for `$dense`, or the sparse sections to `$s` for `$sparse`. `$cells` may
+/// be `&Cells` or `&mut Cells`.
+macro_rules! with_cells {
+    ($cells:expr, $v:ident => $dense:expr, $s:ident => $sparse:expr) => {
+        match $cells {
+            Cells::U8($v) => $dense,
+            Cells::U16($v) => $dense,
+            Cells::U32($v) => $dense,
+            Cells::Sparse($s) => $sparse,
+        }
+    };
+}
+
+fn try_filled_vec<T: Cell>(len: usize, value: usize) -> Result<Vec<T>, TryReserveError> {
+    let mut cells = Vec::new();
+    cells.try_reserve_exact(len)?;
+    cells.resize(len, T::from_index(value));
+    Ok(cells)
+}
+
+fn widen_vec<T: Cell, U: Cell>(cells: &[T]) -> Vec<U> {
+    cells.iter().map(|&c| U::from_index(c.index())).collect()
+}
+
+fn narrow_vec<U: Cell>(values: &[usize]) -> Vec<U> {
+    values.iter().map(|&v| U::from_index(v)).collect()
+}
+
+/// Decode little-endian cells, with a plain copy when `bytes` is aligned
+/// for `T` on a little-endian target.
+fn decode_le<T: Cell>(bytes: &[u8]) -> Vec<T> {
+    if cfg!(target_endian = "little") {
+        if let Ok(cells) = bytemuck::try_cast_slice::<u8, T>(bytes) {
+            return cells.to_vec();
+        }
+    }
+    bytes
+        .chunks_exact(std::mem::size_of::<T>())
+        .map(T::read_le)
+        .collect()
+}
+
+fn copy_widened<T: Cell>(cells: &mut [T], values: &[u8]) {
+    for (cell, &value) in cells.iter_mut().zip(values) {
+        *cell = T::from_index(value as usize);
+    }
+}
+
+fn extend_widened<T: Cell>(cells: &mut Vec<T>, values: &[u8]) {
+    cells.extend(values.iter().map(|&value| T::from_index(value as usize)));
+}
+
+/// Replace every cell `v` below `table.len()` with `table[v]`.
+fn remap_into<T: Cell>(cells: &mut [T], table: &[usize]) {
+    let remap = |cells: &mut [T]| {
+        for c in cells {
+            if let Some(&v) = table.get(c.index()) {
+                *c = T::from_index(v);
+            }
+        }
+    };
+    #[cfg(not(target_arch = "wasm32"))]
+    {
+        use rayon::prelude::*;
+        cells.par_chunks_mut(1 << 16).for_each(remap);
+    }
+    #[cfg(target_arch = "wasm32")]
+    remap(cells);
+}
+
+fn count_eq<T: Cell>(cells: &[T], value: usize) -> usize {
+    if !T::fits(value) {
+        return 0;
+    }
+    let target = T::from_index(value);
+    cells.iter().filter(|&&c| c == target).count()
+}
+
+fn histogram_into<T: Cell>(cells: &[T], counts: &mut [u64]) {
+    if std::mem::size_of::<T>() != 1 {
+        for &c in cells {
+            counts[c.index()] += 1;
+        }
+        return;
+    }
+    // Runs of one block are the common case, and bumping the same counter
+    // back to back stalls on the previous store. Four interleaved tables
+    // keep neighbouring cells on separate counters.
+    let bytes: &[u8] = bytemuck::cast_slice(cells);
+    let mut tables = [[0u64; 256]; 4];
+    let mut quads = bytes.chunks_exact(4);
+    for q in &mut quads {
+        tables[0][q[0] as usize] += 1;
+        tables[1][q[1] as usize] += 1;
+        tables[2][q[2] as usize] += 1;
+        tables[3][q[3] as usize] += 1;
+    }
+    for &b in quads.remainder() {
+        tables[0][b as usize] += 1;
+    }
+    for value in 0..256 {
+        let n = tables[0][value] + tables[1][value] + tables[2][value] + tables[3][value];
+        if n > 0 {
+            counts[value] += n;
+        }
+    }
+}
+
+fn position_ne<T: Cell>(cells: &[T], value: usize) -> Option<usize> {
+    if !T::fits(value) {
+        return (!cells.is_empty()).then_some(0);
+    }
+    let target = T::from_index(value);
+    cells.iter().position(|&c| c != target)
+}
+
+/// Palette-index storage for one region, one entry per cell.
+#[derive(Debug, Clone)]
+pub struct BlockStorage(Cells);
+
+impl Default for BlockStorage {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl BlockStorage {
+    pub fn new() -> Self {
+        BlockStorage(Cells::U8(Vec::new()))
+    }
+
+    /// `len` cells, all holding `value`.
+    pub fn filled(len: usize, value: usize) -> Self {
+        Self::try_filled(len, value).expect("block storage allocation failed")
+    }
+
+    /// Like [`BlockStorage::filled`], but reports allocation failure instead
+    /// of aborting, for callers that size regions from untrusted input.
+    pub fn try_filled(len: usize, value: usize) -> Result<Self, TryReserveError> {
+        Ok(BlockStorage(match Width::of(value) {
+            Width::U8 => Cells::U8(try_filled_vec(len, value)?),
+            Width::U16 => Cells::U16(try_filled_vec(len, value)?),
+            Width::U32 => Cells::U32(try_filled_vec(len, value)?),
+        }))
+    }
+
+    /// Sparse storage for the box at `origin` with `dims` (x, y, z) cells,
+    /// every cell reading `fill` until written. Allocates nothing per cell.
+    pub fn sparse(origin: (i32, i32, i32), dims: (usize, usize, usize), fill: usize) -> Self {
+        BlockStorage(Cells::Sparse(Box::new(SparseCells {
+            origin,
+            dims,
+            fill,
+            sections: FxHashMap::default(),
+        })))
+    }
+
+    pub fn is_sparse(&self) -> bool {
+        matches!(self.0, Cells::Sparse(_))
+    }
+
+    /// Stored 16³ sections (0 for dense storage).
+    pub fn section_count(&self) -> usize {
+        match &self.0 {
+            Cells::Sparse(s) => s.sections.len(),
+            _ => 0,
+        }
+    }
+
+    /// Grow sparse storage to the box at `origin` with `dims`, which must
+    /// contain the current box. Cells keep their world positions, so this
+    /// is O(1); new cells read as the fill value. Panics on dense storage,
+    /// whose linear layout has to be rebuilt to grow.
+    pub fn rebound(&mut self, origin: (i32, i32, i32), dims: (usize, usize, usize)) {
+        let Cells::Sparse(s) = &mut self.0 else {
+            panic!("rebound needs sparse block storage");
+        };
+        let (lo, hi) = s.world_bounds();
+        let contains = |p: (i32, i32, i32)| {
+            (0..3).all(|axis| {
+                let (p, o, d) = match axis {
+                    0 => (p.0, origin.0, dims.0),
+                    1 => (p.1, origin.1, dims.1),
+                    _ => (p.2, origin.2, dims.2),
+                };
+                i64::from(p) >= i64::from(o) && (i64::from(p) - i64::from(o)) < d as i64
+            })
+        };
+        assert!(
+            s.len() == 0 || (contains(lo) && contains(hi)),
+            "rebound must not shrink sparse block storage"
+        );
+        s.origin = origin;
+        s.dims = dims;
+    }
+
+    fn width(&self) -> Option<Width> {
+        match self.0 {
+            Cells::U8(_) => Some(Width::U8),
+            Cells::U16(_) => Some(Width::U16),
+            Cells::U32(_) => Some(Width::U32),
+            Cells::Sparse(_) => None,
+        }
+    }
+
+    /// Bytes per cell at the current width (1, 2 or 4). For sparse storage,
+    /// the width of its widest materialized section.
+    pub fn width_bytes(&self) -> usize {
+        match &self.0 {
+            Cells::Sparse(s) => s
+                .sections
+                .values()
+                .map(|section| match section {
+                    Section::Uniform(_) => 1,
+                    Section::Cells(cells) => cells.width_bytes(),
+                })
+                .max()
+                .unwrap_or(1),
+            _ => self.width().map_or(1, Width::bytes),
+        }
+    }
+
+    /// Heap bytes held by the cells (excluding spare capacity). For sparse
+    /// storage, the section table plus every materialized section, including
+    /// sections shared with clones.
+    pub fn heap_bytes(&self) -> usize {
+        match &self.0 {
+            Cells::Sparse(s) => {
+                let table = s.sections.len()
+                    * (std::mem::size_of::<SectionKey>() + std::mem::size_of::<Section>());
+                let cells: usize = s
+                    .sections
+                    .values()
+                    .map(|section| match section {
+                        Section::Uniform(_) => 0,
+                        Section::Cells(cells) => cells.heap_bytes(),
+                    })
+                    .sum();
+                table + cells
+            }
+            _ => self.len() * self.width_bytes(),
+        }
+    }
+
+    /// Append every cell as a little-endian integer and return its width in
+    /// bytes (1, 2 or 4): the dense width, or for sparse storage the
+    /// narrowest width holding every value. Read back with
+    /// [`BlockStorage::from_le_bytes`] or, one cell at a time,
+    /// [`BlockStorage::read_le`].
+    pub fn write_le_bytes(&self, out: &mut Vec<u8>) -> usize {
+        let width = self
+            .width()
+            .unwrap_or_else(|| self.iter().max().map_or(Width::U8, Width::of));
+        out.reserve(self.len() * width.bytes());
+        match (&self.0, width) {
+            (Cells::U8(v), _) => out.extend_from_slice(v),
+            (Cells::U16(v), _) => v.iter().for_each(|c| c.write_le(out)),
+            (Cells::U32(v), _) => v.iter().for_each(|c| c.write_le(out)),
+            (Cells::Sparse(_), Width::U8) => out.extend(self.iter().map(u8::from_index)),
+            (Cells::Sparse(_), Width::U16) => {
+                self.iter().for_each(|c| u16::from_index(c).write_le(out))
+            }
+            (Cells::Sparse(_), Width::U32) => {
+                self.iter().for_each(|c| u32::from_index(c).write_le(out))
+            }
+        }
+        width.bytes()
+    }
+
+    /// Dense storage from [`BlockStorage::write_le_bytes`] output. `None`
+    /// if the width is not 1, 2 or 4 or does not divide the byte count.
+    pub fn from_le_bytes(bytes: &[u8], width_bytes: usize) -> Option<Self> {
+        if !matches!(width_bytes, 1 | 2 | 4) || !bytes.len().is_multiple_of(width_bytes) {
+            return None;
+        }
+        Some(BlockStorage(match width_bytes {
+            1 => Cells::U8(bytes.to_vec()),
+            2 => Cells::U16(decode_le(bytes)),
+            _ => Cells::U32(decode_le(bytes)),
+        }))
+    }
+
+    /// Cell `index` of [`BlockStorage::write_le_bytes`] output, without
+    /// decoding the rest. Panics if `index` is out of range.
+    #[inline]
+    pub fn read_le(bytes: &[u8], width_bytes: usize, index: usize) -> usize {
+        let at = index * width_bytes;
+        match width_bytes {
+            1 => bytes[index] as usize,
+            2 => u16::read_le(&bytes[at..at + 2]).index(),
+            _ => u32::read_le(&bytes[at..at + 4]).index(),
+        }
+    }
+
+    #[inline]
+    pub fn len(&self) -> usize {
+        with_cells!(&self.0, v => v.len(), s => s.len())
+    }
+
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// The palette index at `index`, or `None` when out of range.
+    #[inline]
+    pub fn get(&self, index: usize) -> Option<usize> {
+        with_cells!(
+            &self.0,
+            v => v.get(index).map(|&c| c.index()),
+            s => (index < s.len()).then(|| s.get(index))
+        )
+    }
+
+    /// The palette index at `index`. Panics when out of range, like `v[i]`.
+    #[inline(always)]
+    pub fn at(&self, index: usize) -> usize {
+        with_cells!(&self.0, v => v[index].index(), s => {
+            assert!(index < s.len(), "block index {index} out of range");
+            s.get(index)
+        })
+    }
+
+    /// Widen (if needed) so that `value` can be stored without a further
+    /// conversion. Call once before a bulk write of known maximum. Sparse
+    /// sections widen individually, so this is a no-op for them.
+    pub fn ensure_holds(&mut self, value: usize) {
+        let Some(width) = self.width() else {
+            return;
+        };
+        let needed = Width::of(value);
+        if needed <= width {
+            return;
+        }
+        self.0 = match (&self.0, needed) {
+            (Cells::U8(v), Width::U16) => Cells::U16(widen_vec(v)),
+            (Cells::U8(v), Width::U32) => Cells::U32(widen_vec(v)),
+            (Cells::U16(v), Width::U32) => Cells::U32(widen_vec(v)),
+            _ => unreachable!("only narrower widths are widened"),
+        };
+    }
+
+    /// Store `value` at `index`, widening first if it does not fit.
+    #[inline(always)]
+    pub fn set(&mut self, index: usize, value: usize) {
+        self.replace(index, value);
+    }
+
+    /// Store `value` at `index` and return the previous value.
+    #[inline(always)]
+    pub fn replace(&mut self, index: usize, value: usize) -> usize {
+        match &mut self.0 {
+            Cells::U8(v) if u8::fits(value) => {
+                std::mem::replace(&mut v[index], value as u8).index()
+            }
+            Cells::U16(v) if u16::fits(value) => {
+                std::mem::replace(&mut v[index], value as u16).index()
+            }
+            Cells::U32(v) => std::mem::replace(&mut v[index], u32::from_index(value)).index(),
+            Cells::Sparse(s) => {
+                assert!(index < s.len(), "block index {index} out of range");
+                s.replace(index, value)
+            }
+            _ => {
+                self.ensure_holds(value);
+                self.replace(index, value)
+            }
+        }
+    }
+
+    /// Append `value`, widening first if it does not fit. Dense storage
+    /// only: sparse storage has a fixed box.
+    pub fn push(&mut self, value: usize) {
+        self.ensure_holds(value);
+        with_cells!(
+            &mut self.0,
+            v => v.push(Cell::from_index(value)),
+            _s => panic!("cannot push to sparse block storage")
+        );
+    }
+
+    pub fn fill(&mut self, value: usize) {
+        if let Cells::Sparse(s) = &mut self.0 {
+            s.sections.clear();
+            s.fill = value;
+            return;
+        }
+        let len = self.len();
+        self.fill_range(0..len, value);
+    }
+
+    pub fn fill_range(&mut self, range: Range<usize>, value: usize) {
+        self.ensure_holds(value);
+        with_cells!(&mut self.0, v => v[range].fill(Cell::from_index(value)), s => {
+            for index in range {
+                s.replace(index, value);
+            }
+        });
+    }
+
+    /// Number of cells in `range` holding `value`.
+    pub fn count_in_range(&self, range: Range<usize>, value: usize) -> usize {
+        with_cells!(&self.0, v => count_eq(&v[range], value), s => {
+            if range == (0..s.len()) {
+                s.count(value)
+            } else {
+                range.filter(|&index| s.get(index) == value).count()
+            }
+        })
+    }
+
+    /// Add the number of cells holding each value to `counts[value]`.
+    /// `counts` must be longer than the largest value stored.
+    pub fn histogram(&self, counts: &mut [u64]) {
+        with_cells!(&self.0, v => histogram_into(v, counts), s => s.histogram(counts))
+    }
+
+    /// Rewrite every stored value `v` as `table[v]`, widening first if the
+    /// table needs it. Values past the table (the `usize::MAX` sentinel)
+    /// are left alone. Dense storage is rewritten in parallel; sparse
+    /// storage rewrites its fill value, uniform sections in place and each
+    /// materialized section once.
+    pub fn remap_values(&mut self, table: &[usize]) {
+        if let Some(&max) = table.iter().max() {
+            self.ensure_holds(max);
+        }
+        with_cells!(&mut self.0, v => remap_into(v, table), s => s.remap_values(table))
+    }
+
+    /// Call `f(index)` for every cell whose value is not `value`. Dense
+    /// storage visits cells in index order; sparse storage visits only its
+    /// stored sections (when `value` is the fill value), in no particular
+    /// order.
+    pub fn for_each_index_ne(&self, value: usize, mut f: impl FnMut(usize)) {
+        with_cells!(
+            &self.0,
+            v => {
+                for (index, &c) in v.iter().enumerate() {
+                    if c.index() != value {
+                        f(index);
+                    }
+                }
+            },
+            s => s.for_each_index_ne(value, f)
+        )
+    }
+
+    /// The first cell in `range` whose value is not `value`, with that value.
+    /// Callers scanning rows use this to skip whole runs of air with one
+    /// search (a byte compare per cell on `u8` storage) instead of a
+    /// per-cell `at`.
+    #[inline]
+    pub fn find_ne(&self, range: Range<usize>, value: usize) -> Option<(usize, usize)> {
+        with_cells!(
+            &self.0,
+            v => {
+                let start = range.start;
+                position_ne(&v[range], value).map(|k| (start + k, v[start + k].index()))
+            },
+            s => range.map(|i| (i, s.get(i))).find(|&(_, v)| v != value)
+        )
+    }
+
+    /// Overwrite the inclusive world box `min..=max` (which must lie inside
+    /// the storage bounds) with `value`, returning how many overwritten cells
+    /// held `counted`. Sections the box covers entirely collapse to a single
+    /// value. Returns `None` for dense storage, which does not know its world
+    /// position; callers fall back to [`BlockStorage::fill_range`] per row.
+    pub fn fill_box(
+        &mut self,
+        min: (i32, i32, i32),
+        max: (i32, i32, i32),
+        value: usize,
+        counted: usize,
+    ) -> Option<usize> {
+        match &mut self.0 {
+            Cells::Sparse(s) => Some(s.fill_box(min, max, value, counted)),
+            _ => None,
+        }
+    }
+
+    pub fn reverse_range(&mut self, range: Range<usize>) {
+        with_cells!(&mut self.0, v => v[range].reverse(), s => {
+            let (mut lo, mut hi) = (range.start, range.end);
+            while lo + 1 < hi {
+                hi -= 1;
+                let a = s.get(lo);
+                let b = s.replace(hi, a);
+                s.replace(lo, b);
+                lo += 1;
+            }
+        });
+    }
+
+    /// Swap the `len` cells starting at `a` with the `len` cells starting at
+    /// `b`. The two ranges must not overlap.
+    pub fn swap_ranges(&mut self, a: usize, b: usize, len: usize) {
+        let (lo, hi) = if a < b { (a, b) } else { (b, a) };
+        assert!(lo + len <= hi, "swap_ranges: ranges overlap");
+        with_cells!(
+            &mut self.0,
+            v => {
+                let (head, tail) = v.split_at_mut(hi);
+                head[lo..lo + len].swap_with_slice(&mut tail[..len]);
+            },
+            s => {
+                for k in 0..len {
+                    let first = s.get(lo + k);
+                    let second = s.replace(hi + k, first);
+                    s.replace(lo + k, second);
+                }
+            }
+        );
+    }
+
+    /// Copy `len` cells from `src[src_start..]` into `self[dst_start..]`,
+    /// widening `self` to `src`'s width first. Same-width dense copies are a
+    /// `memcpy`.
+    pub fn copy_range_from(
+        &mut self,
+        dst_start: usize,
+        src: &BlockStorage,
+        src_start: usize,
+        len: usize,
+    ) {
+        if let (Some(src_width), Some(dst_width)) = (src.width(), self.width()) {
+            if src_width > dst_width {
+                self.widen_to(src_width);
+            }
+        }
+        let dst = dst_start..dst_start + len;
+        let from = src_start..src_start + len;
+        match (&mut self.0, &src.0) {
+            (Cells::U8(d), Cells::U8(s)) => d[dst].copy_from_slice(&s[from]),
+            (Cells::U16(d), Cells::U16(s)) => d[dst].copy_from_slice(&s[from]),
+            (Cells::U32(d), Cells::U32(s)) => d[dst].copy_from_slice(&s[from]),
+            (Cells::Sparse(_), _) | (_, Cells::Sparse(_)) => {
+                for (dst, from) in dst.zip(from) {
+                    self.set(dst, src.at(from));
+                }
+            }
+            (d, s) => with_cells!(
+                d,
+                d => with_cells!(
+                    s,
+                    s => {
+                        for (dst, &src) in d[dst].iter_mut().zip(&s[from]) {
+                            *dst = Cell::from_index(src.index());
+                        }
+                    },
+                    _s => unreachable!()
+                ),
+                _s => unreachable!()
+            ),
+        }
+    }
+
+    /// Copy `out.len()` cells starting at `start` into `out`.
+    pub fn read_into_u32(&self, start: usize, out: &mut [u32]) {
+        let range = start..start + out.len();
+        with_cells!(
+            &self.0,
+            v => {
+                for (dst, &src) in out.iter_mut().zip(&v[range]) {
+                    *dst = src.index() as u32;
+                }
+            },
+            s => {
+                for (dst, index) in out.iter_mut().zip(range) {
+                    *dst = s.get(index) as u32;
+                }
+            }
+        );
+    }
+
+    /// Store `values` at `start..start + values.len()`. Into `u8` cells this
+    /// is a `memcpy`; wider cells widen each byte.
+    pub fn copy_from_u8(&mut self, start: usize, values: &[u8]) {
+        let range = start..start + values.len();
+        match &mut self.0 {
+            Cells::U8(v) => v[range].copy_from_slice(values),
+            Cells::U16(v) => copy_widened(&mut v[range], values),
+            Cells::U32(v) => copy_widened(&mut v[range], values),
+            Cells::Sparse(s) => {
+                for (index, &value) in range.zip(values) {
+                    s.replace(index, value as usize);
+                }
+            }
+        }
+    }
+
+    /// Append `values`. Dense storage only, like [`push`](Self::push).
+    pub fn extend_from_u8(&mut self, values: &[u8]) {
+        with_cells!(
+            &mut self.0,
+            v => extend_widened(v, values),
+            _s => panic!("cannot push to sparse block storage")
+        );
+    }
+
+    fn widen_to(&mut self, width: Width) {
+        match width {
+            Width::U8 => {}
+            Width::U16 => self.ensure_holds(u16::MAX as usize),
+            Width::U32 => self.ensure_holds(usize::MAX),
+        }
+    }
+
+    /// Run `f(slab_index, slab)` for each `slab_len`-cell slab of `self` in
+    /// parallel, where each slab can copy rows out of `src`. `self` is
+    /// widened to `src`'s width first so every row copy is a `memcpy`. When
+    /// either side is sparse the slabs run one after another.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn par_copy_slabs<F>(&mut self, src: &BlockStorage, slab_len: usize, f: F)
+    where
+        F: Fn(usize, &mut SlabCopy<'_>) + Sync + Send,
+    {
+        use rayon::prelude::*;
+
+        let (Some(src_width), Some(dst_width)) = (src.width(), self.width()) else {
+            let slabs = self.len().div_ceil(slab_len.max(1));
+            for i in 0..slabs {
+                let base = i * slab_len;
+                f(i, &mut SlabCopy(SlabPair::Indirect(self, base, src)));
+            }
+            return;
+        };
+        let widened;
+        let src = if src_width < dst_width {
+            let mut copy = src.clone();
+            copy.widen_to(dst_width);
+            widened = copy;
+            &widened
+        } else {
+            self.widen_to(src_width);
+            src
+        };
+        macro_rules! run {
+            ($d:expr, $s:expr, $variant:ident) => {
+                $d.par_chunks_mut(slab_len)
+                    .enumerate()
+                    .for_each(|(i, slab)| f(i, &mut SlabCopy(SlabPair::$variant(slab, &$s[..]))))
+            };
+        }
+        match (&mut self.0, &src.0) {
+            (Cells::U8(d), Cells::U8(s)) => run!(d, s, U8),
+            (Cells::U16(d), Cells::U16(s)) => run!(d, s, U16),
+            (Cells::U32(d), Cells::U32(s)) => run!(d, s, U32),
+            _ => unreachable!("widths matched above"),
+        }
+    }
+
+    /// Run `f(slab_index, slab)` for each `slab_len`-cell slab of `self`,
+    /// in parallel where threads are available, where each slab writes rows
+    /// copied, remapped or gathered out of other storages, or permutes its
+    /// own rows. Call [`BlockStorage::ensure_holds`] first with the largest
+    /// value the rows will write. On sparse storage the slabs run one after
+    /// another.
+    pub fn for_each_slab<F>(&mut self, slab_len: usize, f: F)
+    where
+        F: Fn(usize, &mut SlabWriter<'_>) + Sync + Send,
+    {
+        if self.is_sparse() {
+            let len = self.len();
+            for (i, base) in (0..len).step_by(slab_len.max(1)).enumerate() {
+                let cells = base..(base + slab_len).min(len);
+                f(i, &mut SlabWriter(SlabCells::Indirect(self, cells)));
+            }
+            return;
+        }
+        macro_rules! run {
+            ($v:expr, $variant:ident) => {{
+                #[cfg(not(target_arch = "wasm32"))]
+                {
+                    use rayon::prelude::*;
+                    $v.par_chunks_mut(slab_len)
+                        .enumerate()
+                        .for_each(|(i, slab)| f(i, &mut SlabWriter(SlabCells::$variant(slab))));
+                }
+                #[cfg(target_arch = "wasm32")]
+                for (i, slab) in $v.chunks_mut(slab_len).enumerate() {
+                    f(i, &mut SlabWriter(SlabCells::$variant(slab)));
+                }
+            }};
+        }
+        match &mut self.0 {
+            Cells::U8(v) => run!(v, U8),
+            Cells::U16(v) => run!(v, U16),
+            Cells::U32(v) => run!(v, U32),
+            Cells::Sparse(_) => unreachable!("handled above"),
+        }
+    }
+
+    pub fn iter(&self) -> Iter<'_> {
+        Iter(match &self.0 {
+            Cells::U8(v) => IterInner::U8(v.iter()),
+            Cells::U16(v) => IterInner::U16(v.iter()),
+            Cells::U32(v) => IterInner::U32(v.iter()),
+            Cells::Sparse(s) => IterInner::Sparse(s, 0..s.len()),
+        })
+    }
+
+    pub fn to_vec(&self) -> Vec<usize> {
+        self.iter().collect()
+    }
+
+    /// Dense copy at the narrowest width.
+    pub fn to_dense(&self) -> BlockStorage {
+        match &self.0 {
+            Cells::Sparse(_) => self.iter().collect(),
+            _ => self.clone(),
+        }
+    }
+
+    /// Sparse copy for the box at `origin` with `dims` (whose volume must be
+    /// `self.len()`), storing only cells that differ from `fill`.
+    pub fn to_sparse(
+        &self,
+        origin: (i32, i32, i32),
+        dims: (usize, usize, usize),
+        fill: usize,
+    ) -> BlockStorage {
+        assert_eq!(
+            dims.0 * dims.1 * dims.2,
+            self.len(),
+            "sparse dims must cover every cell"
+        );
+        let mut sparse = BlockStorage::sparse(origin, dims, fill);
+        self.for_each_index_ne(fill, |index| sparse.set(index, self.at(index)));
+        sparse
+    }
+}
+
+/// A destination slab paired with its source, handed out by
+/// [`BlockStorage::par_copy_slabs`].
+#[cfg(not(target_arch = "wasm32"))]
+pub struct SlabCopy<'a>(SlabPair<'a>);
+
+#[cfg(not(target_arch = "wasm32"))]
+enum SlabPair<'a> {
+    U8(&'a mut [u8], &'a [u8]),
+    U16(&'a mut [u16], &'a [u16]),
+    U32(&'a mut [u32], &'a [u32]),
+    /// Sparse on either side: the whole destination plus the slab's base.
+    Indirect(&'a mut BlockStorage, usize, &'a BlockStorage),
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+impl SlabCopy<'_> {
+    /// Copy `len` source cells starting at `src_start` to slab offset
+    /// `dst_start`.
+    #[inline]
+    pub fn copy(&mut self, dst_start: usize, src_start: usize, len: usize) {
+        let dst = dst_start..dst_start + len;
+        let src = src_start..src_start + len;
+        match &mut self.0 {
+            SlabPair::U8(d, s) => d[dst].copy_from_slice(&s[src]),
+            SlabPair::U16(d, s) => d[dst].copy_from_slice(&s[src]),
+            SlabPair::U32(d, s) => d[dst].copy_from_slice(&s[src]),
+            SlabPair::Indirect(d, base, s) => {
+                d.copy_range_from(*base + dst_start, s, src_start, len)
+            }
+        }
+    }
+}
+
+/// One destination slab handed out by [`BlockStorage::for_each_slab`].
+pub struct SlabWriter<'a>(SlabCells<'a>);
+
+enum SlabCells<'a> {
+    U8(&'a mut [u8]),
+    U16(&'a mut [u16]),
+    U32(&'a mut [u32]),
+    /// Sparse destination: the whole storage plus the slab's cells.
+    Indirect(&'a mut BlockStorage, Range<usize>),
+}
+
+/// Write `src[src_start..]` into `dst`, mapping each value through `remap`
+/// and leaving cells whose source value is `skip` untouched.
+fn write_row<T: Cell>(
+    dst: &mut [T],
+    src: &BlockStorage,
+    src_start: usize,
+    remap: Option<&[usize]>,
+    skip: Option<usize>,
+) {
+    let map = |v: usize| remap.map_or(v, |remap| remap[v]);
+    let from = src_start..src_start + dst.len();
+    with_cells!(
+        &src.0,
+        s => {
+            for (d, &v) in dst.iter_mut().zip(&s[from]) {
+                let v = v.index();
+                if skip != Some(v) {
+                    *d = T::from_index(map(v));
+                }
+            }
+        },
+        s => {
+            for (k, d) in dst.iter_mut().enumerate() {
+                let v = s.get(src_start + k);
+                if skip != Some(v) {
+                    *d = T::from_index(map(v));
+                }
+            }
+        }
+    );
+}
+
+/// Edge of the square tiles [`SlabWriter::gather`] walks: 32 × 32 cells of
+/// `u32` are 4 KiB, so a tile's strided source lines stay in L1.
+const GATHER_TILE: usize = 32;
+
+/// `dst[r * row_len + k] = src(start + r * row_step + k * step)`, tile by
+/// tile.
+#[inline(always)]
+fn gather_tiled<T: Cell>(
+    dst: &mut [T],
+    row_len: usize,
+    start: isize,
+    step: isize,
+    row_step: isize,
+    src: impl Fn(usize) -> usize,
+) {
+    let rows = dst.len() / row_len.max(1);
+    for r0 in (0..rows).step_by(GATHER_TILE) {
+        for k0 in (0..row_len).step_by(GATHER_TILE) {
+            let k1 = (k0 + GATHER_TILE).min(row_len);
+            for r in r0..(r0 + GATHER_TILE).min(rows) {
+                let row = &mut dst[r * row_len + k0..r * row_len + k1];
+                let mut from = start + r as isize * row_step + k0 as isize * step;
+                for d in row {
+                    *d = T::from_index(src(from as usize));
+                    from += step;
+                }
+            }
+        }
+    }
+}
+
+/// [`gather_tiled`] for any source backend.
+fn gather_rows<T: Cell>(
+    dst: &mut [T],
+    row_len: usize,
+    src: &BlockStorage,
+    start: isize,
+    step: isize,
+    row_step: isize,
+) {
+    with_cells!(
+        &src.0,
+        s => gather_tiled(dst, row_len, start, step, row_step, |i| s[i].index()),
+        s => gather_tiled(dst, row_len, start, step, row_step, |i| s.get(i))
+    );
+}
+
+impl SlabWriter<'_> {
+    /// Copy `len` cells of `src` starting at `src_start` to slab offset
+    /// `dst_start`. Same-width dense rows are a `memcpy`.
+    #[inline]
+    pub fn copy_from(
+        &mut self,
+        dst_start: usize,
+        src: &BlockStorage,
+        src_start: usize,
+        len: usize,
+    ) {
+        let dst = dst_start..dst_start + len;
+        let from = src_start..src_start + len;
+        match (&mut self.0, &src.0) {
+            (SlabCells::U8(d), Cells::U8(s)) => d[dst].copy_from_slice(&s[from]),
+            (SlabCells::U16(d), Cells::U16(s)) => d[dst].copy_from_slice(&s[from]),
+            (SlabCells::U32(d), Cells::U32(s)) => d[dst].copy_from_slice(&s[from]),
+            _ => self.copy_remapped(dst_start, src, src_start, len, None, None),
+        }
+    }
+
+    /// Like [`SlabWriter::copy_from`], mapping each source value `v` to
+    /// `remap[v]` (identity when `None`) and leaving the destination cell
+    /// untouched where the source holds `skip`.
+    pub fn copy_remapped(
+        &mut self,
+        dst_start: usize,
+        src: &BlockStorage,
+        src_start: usize,
+        len: usize,
+        remap: Option<&[usize]>,
+        skip: Option<usize>,
+    ) {
+        let dst = dst_start..dst_start + len;
+        match &mut self.0 {
+            SlabCells::U8(d) => write_row(&mut d[dst], src, src_start, remap, skip),
+            SlabCells::U16(d) => write_row(&mut d[dst], src, src_start, remap, skip),
+            SlabCells::U32(d) => write_row(&mut d[dst], src, src_start, remap, skip),
+            SlabCells::Indirect(d, cells) => {
+                for k in 0..len {
+                    let v = src.at(src_start + k);
+                    if skip != Some(v) {
+                        d.set(
+                            cells.start + dst_start + k,
+                            remap.map_or(v, |remap| remap[v]),
+                        );
+                    }
+                }
+            }
+        }
+    }
+
+    /// Fill the `rows` rows of `row_len` cells starting at slab offset
+    /// `dst_start` with a strided read of `src`: column `k` of row `r` takes
+    /// `src[src_start + r * row_step + k * step]`. This is how a rotation
+    /// permutes cells. The rows are written in square tiles, so a large
+    /// source stride still reads each cache line once per tile.
+    #[allow(clippy::too_many_arguments)]
+    pub fn gather(
+        &mut self,
+        dst_start: usize,
+        row_len: usize,
+        rows: usize,
+        src: &BlockStorage,
+        src_start: usize,
+        step: isize,
+        row_step: isize,
+    ) {
+        let dst = dst_start..dst_start + row_len * rows;
+        let start = src_start as isize;
+        match &mut self.0 {
+            SlabCells::U8(d) => gather_rows(&mut d[dst], row_len, src, start, step, row_step),
+            SlabCells::U16(d) => gather_rows(&mut d[dst], row_len, src, start, step, row_step),
+            SlabCells::U32(d) => gather_rows(&mut d[dst], row_len, src, start, step, row_step),
+            SlabCells::Indirect(d, cells) => {
+                for r in 0..rows {
+                    for k in 0..row_len {
+                        let from = start + r as isize * row_step + k as isize * step;
+                        d.set(
+                            cells.start + dst_start + r * row_len + k,
+                            src.at(from as usize),
+                        );
+                    }
+                }
+            }
+        }
+    }
+
+    /// Reverse each `row_len`-cell row of the slab in place.
+    pub fn reverse_rows(&mut self, row_len: usize) {
+        match &mut self.0 {
+            SlabCells::U8(d) => d.chunks_mut(row_len).for_each(<[u8]>::reverse),
+            SlabCells::U16(d) => d.chunks_mut(row_len).for_each(<[u16]>::reverse),
+            SlabCells::U32(d) => d.chunks_mut(row_len).for_each(<[u32]>::reverse),
+            SlabCells::Indirect(d, cells) => {
+                for start in cells.clone().step_by(row_len.max(1)) {
+                    d.reverse_range(start..(start + row_len).min(cells.end));
+                }
+            }
+        }
+    }
+
+    /// Swap row `r` with row `rows - 1 - r` for every `row_len`-cell row of
+    /// the slab.
+    pub fn mirror_rows(&mut self, row_len: usize) {
+        fn mirror<T>(cells: &mut [T], row_len: usize) {
+            let rows = cells.len() / row_len.max(1);
+            for r in 0..rows / 2 {
+                let (head, tail) = cells.split_at_mut((rows - 1 - r) * row_len);
+                head[r * row_len..(r + 1) * row_len].swap_with_slice(&mut tail[..row_len]);
+            }
+        }
+        match &mut self.0 {
+            SlabCells::U8(d) => mirror(d, row_len),
+            SlabCells::U16(d) => mirror(d, row_len),
+            SlabCells::U32(d) => mirror(d, row_len),
+            SlabCells::Indirect(d, cells) => {
+                let rows = cells.len() / row_len.max(1);
+                for r in 0..rows / 2 {
+                    let a = cells.start + r * row_len;
+                    let b = cells.start + (rows - 1 - r) * row_len;
+                    d.swap_ranges(a, b, row_len);
+                }
+            }
+        }
+    }
+}
+
+/// Iterator over the palette indices of a [`BlockStorage`].
+pub struct Iter<'a>(IterInner<'a>);
+
+enum IterInner<'a> {
+    U8(std::slice::Iter<'a, u8>),
+    U16(std::slice::Iter<'a, u16>),
+    U32(std::slice::Iter<'a, u32>),
+    Sparse(&'a SparseCells, Range<usize>),
+}
+
+impl Iterator for Iter<'_> {
+    type Item = usize;
+
+    #[inline]
+    fn next(&mut self) -> Option<usize> {
+        match &mut self.0 {
+            IterInner::U8(it) => it.next().map(|&c| c.index()),
+            IterInner::U16(it) => it.next().map(|&c| c.index()),
+            IterInner::U32(it) => it.next().map(|&c| c.index()),
+            IterInner::Sparse(s, range) => range.next().map(|index| s.get(index)),
+        }
+    }
+
+    #[inline]
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        match &self.0 {
+            IterInner::U8(it) => it.size_hint(),
+            IterInner::U16(it) => it.size_hint(),
+            IterInner::U32(it) => it.size_hint(),
+            IterInner::Sparse(_, range) => range.size_hint(),
+        }
+    }
+}
+
+impl ExactSizeIterator for Iter<'_> {}
+
+impl<'a> IntoIterator for &'a BlockStorage {
+    type Item = usize;
+    type IntoIter = Iter<'a>;
+
+    fn into_iter(self) -> Iter<'a> {
+        self.iter()
+    }
+}
+
+impl From<Vec<usize>> for BlockStorage {
+    fn from(values: Vec<usize>) -> Self {
+        let width = values.iter().copied().max().map_or(Width::U8, Width::of);
+        BlockStorage(match width {
+            Width::U8 => Cells::U8(narrow_vec(&values)),
+            Width::U16 => Cells::U16(narrow_vec(&values)),
+            Width::U32 => Cells::U32(narrow_vec(&values)),
+        })
+    }
+}
+
+impl FromIterator<usize> for BlockStorage {
+    fn from_iter<I: IntoIterator<Item = usize>>(iter: I) -> Self {
+        let iter = iter.into_iter();
+        let mut storage = BlockStorage(Cells::U8(Vec::with_capacity(iter.size_hint().0)));
+        for value in iter {
+            storage.push(value);
+        }
+        storage
+    }
+}
+
+/// Compares cell values, not widths or backends.
+impl PartialEq for BlockStorage {
+    fn eq(&self, other: &Self) -> bool {
+        self.len() == other.len() && self.iter().eq(other.iter())
+    }
+}
+
+impl Eq for BlockStorage {}
+
+impl PartialEq<Vec<usize>> for BlockStorage {
+    fn eq(&self, other: &Vec<usize>) -> bool {
+        self.len() == other.len() && self.iter().eq(other.iter().copied())
+    }
+}
+
+impl Serialize for BlockStorage {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        serializer.collect_seq(self.iter())
+    }
+}
+
+impl<'de> Deserialize<'de> for BlockStorage {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        Vec::<usize>::deserialize(deserializer).map(BlockStorage::from)
+    }
+}
+
+const SECTION_BITS: i32 = 4;
+const SECTION_EDGE: i32 = 1 << SECTION_BITS;
+const SECTION_MASK: i32 = SECTION_EDGE - 1;
+const SECTION_VOLUME: usize = 1 << (3 * SECTION_BITS);
+
+/// World section coordinates: block coordinates shifted right by 4.
+type SectionKey = (i32, i32, i32);
+
+/// A world-space block position, used for inclusive box corners.
+type Corner = (i32, i32, i32);
+
+#[derive(Debug, Clone)]
+enum Section {
+    /// Every cell holds this value.
+    Uniform(usize),
+    /// 4096 dense cells, x fastest, then z, then y (like a region), shared
+    /// between clones until one of them writes.
+    Cells(Arc<BlockStorage>),
+}
+
+/// The sparse backend: stored sections plus the box that linear indices
+/// address. Cells outside the box are never written, so they always hold
+/// `fill`.
+#[derive(Debug, Clone)]
+struct SparseCells {
+    origin: (i32, i32, i32),
+    dims: (usize, usize, usize),
+    fill: usize,
+    sections: FxHashMap<SectionKey, Section>,
+}
+
+impl SparseCells {
+    #[inline]
+    fn len(&self) -> usize {
+        self.dims.0 * self.dims.1 * self.dims.2
+    }
+
+    /// Inclusive world-space corners of the box.
+    fn world_bounds(&self) -> (Corner, Corner) {
+        let (w, h, l) = self.dims;
+        let o = self.origin;
+        (
+            o,
+            (o.0 + w as i32 - 1, o.1 + h as i32 - 1, o.2 + l as i32 - 1),
+        )
+    }
+
+    #[inline]
+    fn world(&self, index: usize) -> (i32, i32, i32) {
+        let (w, _, l) = self.dims;
+        let wl = w * l;
+        let rem = index % wl;
+        (
+            self.origin.0 + (rem % w) as i32,
+            self.origin.1 + (index / wl) as i32,
+            self.origin.2 + (rem / w) as i32,
+        )
+    }
+
+    #[inline]
+    fn linear(&self, x: i32, y: i32, z: i32) -> usize {
+        let (w, _, l) = self.dims;
+        let dx = (x - self.origin.0) as usize;
+        let dy = (y - self.origin.1) as usize;
+        let dz = (z - self.origin.2) as usize;
+        dx + dz * w + dy * w * l
+    }
+
+    #[inline]
+    fn locate(x: i32, y: i32, z: i32) -> (SectionKey, usize) {
+        let key = (x >> SECTION_BITS, y >> SECTION_BITS, z >> SECTION_BITS);
+        let local = (x & SECTION_MASK)
+            | ((z & SECTION_MASK) << SECTION_BITS)
+            | ((y & SECTION_MASK) << (2 * SECTION_BITS));
+        (key, local as usize)
+    }
+
+    #[inline]
+    fn get(&self, index: usize) -> usize {
+        let (x, y, z) = self.world(index);
+        let (key, local) = Self::locate(x, y, z);
+        match self.sections.get(&key) {
+            None => self.fill,
+            Some(Section::Uniform(value)) => *value,
+            Some(Section::Cells(cells)) => cells.at(local),
+        }
+    }
+
+    fn replace(&mut self, index: usize, value: usize) -> usize {
+        let (x, y, z) = self.world(index);
+        self.replace_world(x, y, z, value)
+    }
+
+    fn replace_world(&mut self, x: i32, y: i32, z: i32, value: usize) -> usize {
+        let (key, local) = Self::locate(x, y, z);
+        let fill = self.fill;
+        let section = match self.sections.entry(key) {
+            Entry::Occupied(entry) => entry.into_mut(),
+            Entry::Vacant(entry) => {
+                if value == fill {
+                    return fill;
+                }
+                entry.insert(Section::Uniform(fill))
+            }
+        };
+        match *section {
+            Section::Uniform(old) if old == value => old,
+            Section::Uniform(old) => {
+                let mut cells = BlockStorage::filled(SECTION_VOLUME, old);
+                cells.set(local, value);
+                *section = Section::Cells(Arc::new(cells));
+                old
+            }
+            Section::Cells(ref mut cells) => {
+                let old = cells.at(local);
+                if old != value {
+                    Arc::make_mut(cells).set(local, value);
+                }
+                old
+            }
+        }
+    }
+
+    /// Intersection of section `key` with the box, as inclusive corners.
+    fn overlap(&self, key: SectionKey) -> Option<(Corner, Corner)> {
+        let (lo, hi) = self.world_bounds();
+        let clip = |k: i32, lo: i32, hi: i32| {
+            let start = (k << SECTION_BITS).max(lo);
+            let end = ((k << SECTION_BITS) + SECTION_MASK).min(hi);
+            (start <= end).then_some((start, end))
+        };
+        let (x0, x1) = clip(key.0, lo.0, hi.0)?;
+        let (y0, y1) = clip(key.1, lo.1, hi.1)?;
+        let (z0, z1) = clip(key.2, lo.2, hi.2)?;
+        Some(((x0, y0, z0), (x1, y1, z1)))
+    }
+
+    fn overlap_cells(&self, key: SectionKey) -> usize {
+        self.overlap(key).map_or(0, |(lo, hi)| {
+            (hi.0 - lo.0 + 1) as usize * (hi.1 - lo.1 + 1) as usize * (hi.2 - lo.2 + 1) as usize
+        })
+    }
+
+    /// Cells in the box holding `value`, without visiting unstored sections.
+    fn count(&self, value: usize) -> usize {
+        let mut covered = 0;
+        let mut count = 0;
+        for (&key, section) in &self.sections {
+            let inside = self.overlap_cells(key);
+            covered += inside;
+            count += match section {
+                Section::Uniform(v) => usize::from(*v == value) * inside,
+                Section::Cells(cells) => {
+                    // Cells outside the box still hold the fill value.
+                    let outside = usize::from(self.fill == value) * (SECTION_VOLUME - inside);
+                    cells.count_in_range(0..SECTION_VOLUME, value) - outside
+                }
+            };
+        }
+        if self.fill == value {
+            count += self.len() - covered;
+        }
+        count
+    }
+
+    fn remap_values(&mut self, table: &[usize]) {
+        let map = |v: usize| table.get(v).copied().unwrap_or(v);
+        self.fill = map(self.fill);
+        for section in self.sections.values_mut() {
+            match section {
+                Section::Uniform(v) => *v = map(*v),
+                Section::Cells(cells) => Arc::make_mut(cells).remap_values(table),
+            }
+        }
+    }
+
+    fn histogram(&self, counts: &mut [u64]) {
+        let mut covered = 0;
+        for (&key, section) in &self.sections {
+            let inside = self.overlap_cells(key);
+            covered += inside;
+            match section {
+                Section::Uniform(v) => counts[*v] += inside as u64,
+                Section::Cells(cells) => {
+                    cells.histogram(counts);
+                    // Cells outside the box still hold the fill value.
+                    counts[self.fill] -= (SECTION_VOLUME - inside) as u64;
+                }
+            }
+        }
+        if self.len() > covered {
+            counts[self.fill] += (self.len() - covered) as u64;
+        }
+    }
+
+    fn for_each_index_ne(&self, value: usize, mut f: impl FnMut(usize)) {
+        if self.fill != value {
+            // Unstored cells match too; nothing to skip.
+            for index in 0..self.len() {
+                if self.get(index) != value {
+                    f(index);
+                }
+            }
+            return;
+        }
+        for (&key, section) in &self.sections {
+            if matches!(section, Section::Uniform(v) if *v == value) {
+                continue;
+            }
+            let Some((lo, hi)) = self.overlap(key) else {
+                continue;
+            };
+            for y in lo.1..=hi.1 {
+                for z in lo.2..=hi.2 {
+                    for x in lo.0..=hi.0 {
+                        let cell = match section {
+                            Section::Uniform(v) => *v,
+                            Section::Cells(cells) => cells.at(Self::locate(x, y, z).1),
+                        };
+                        if cell != value {
+                            f(self.linear(x, y, z));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    fn fill_box(
+        &mut self,
+        min: (i32, i32, i32),
+        max: (i32, i32, i32),
+        value: usize,
+        counted: usize,
+    ) -> usize {
+        let mut replaced = 0;
+        for sy in (min.1 >> SECTION_BITS)..=(max.1 >> SECTION_BITS) {
+            for sz in (min.2 >> SECTION_BITS)..=(max.2 >> SECTION_BITS) {
+                for sx in (min.0 >> SECTION_BITS)..=(max.0 >> SECTION_BITS) {
+                    let key = (sx, sy, sz);
+                    let lo = (
+                        (sx << SECTION_BITS).max(min.0),
+                        (sy << SECTION_BITS).max(min.1),
+                        (sz << SECTION_BITS).max(min.2),
+                    );
+                    let hi = (
+                        ((sx << SECTION_BITS) + SECTION_MASK).min(max.0),
+                        ((sy << SECTION_BITS) + SECTION_MASK).min(max.1),
+                        ((sz << SECTION_BITS) + SECTION_MASK).min(max.2),
+                    );
+                    let whole = lo == (sx << SECTION_BITS, sy << SECTION_BITS, sz << SECTION_BITS)
+                        && hi.0 - lo.0 == SECTION_MASK
+                        && hi.1 - lo.1 == SECTION_MASK
+                        && hi.2 - lo.2 == SECTION_MASK;
+                    if whole {
+                        replaced += match self.sections.get(&key) {
+                            None => usize::from(self.fill == counted) * SECTION_VOLUME,
+                            Some(Section::Uniform(v)) => {
+                                usize::from(*v == counted) * SECTION_VOLUME
+                            }
+                            Some(Section::Cells(cells)) => {
+                                cells.count_in_range(0..SECTION_VOLUME, counted)
+                            }
+                        };
+                        if value == self.fill {
+                            self.sections.remove(&key);
+                        } else {
+                            self.sections.insert(key, Section::Uniform(value));
+                        }
+                        continue;
+                    }
+                    for y in lo.1..=hi.1 {
+                        for z in lo.2..=hi.2 {
+                            for x in lo.0..=hi.0 {
+                                let old = self.replace_world(x, y, z, value);
+                                replaced += usize::from(old == counted);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        replaced
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn widens_only_when_an_index_stops_fitting() {
+        let mut storage = BlockStorage::filled(1000, 0);
+        assert_eq!(storage.width_bytes(), 1);
+        assert_eq!(storage.heap_bytes(), 1000);
+
+        storage.set(3, 255);
+        assert_eq!(storage.width_bytes(), 1);
+        storage.set(4, 256);
+        assert_eq!(storage.width_bytes(), 2);
+        storage.set(5, 70_000);
+        assert_eq!(storage.width_bytes(), 4);
+        assert_eq!(storage.replace(6, usize::MAX), 0);
+
+        assert_eq!(storage.at(3), 255);
+        assert_eq!(storage.at(4), 256);
+        assert_eq!(storage.get(5), Some(70_000));
+        assert_eq!(storage.at(6), usize::MAX);
+        assert_eq!(storage.get(1000), None);
+        assert_eq!(storage.iter().filter(|&v| v != 0).count(), 4);
+    }
+
+    #[test]
+    fn row_helpers_match_vec_semantics() {
+        let values: Vec<usize> = (0..12).collect();
+        let mut storage = BlockStorage::from(values.clone());
+        let mut expected = values.clone();
+
+        storage.reverse_range(0..4);
+        expected[0..4].reverse();
+        storage.swap_ranges(8, 4, 4);
+        let (head, tail) = expected.split_at_mut(8);
+        head[4..8].swap_with_slice(&mut tail[..4]);
+        assert_eq!(storage, expected);
+
+        // Copying from wider storage widens the destination.
+        let wide = BlockStorage::filled(4, 300);
+        storage.copy_range_from(2, &wide, 0, 3);
+        expected[2..5].fill(300);
+        assert_eq!(storage.width_bytes(), 2);
+        assert_eq!(storage, expected);
+        assert_eq!(storage.count_in_range(0..12, 300), 3);
+
+        let mut out = [0u32; 4];
+        storage.read_into_u32(1, &mut out);
+        assert_eq!(out, [2, 300, 300, 300]);
+
+        // Byte runs widen into wide cells and append at the current width.
+        storage.copy_from_u8(9, &[7, 8, 255]);
+        expected[9..12].copy_from_slice(&[7, 8, 255]);
+        storage.extend_from_u8(&[1, 2]);
+        expected.extend([1, 2]);
+        assert_eq!(storage, expected);
+    }
+
+    #[test]
+    fn serializes_like_a_vec_and_reloads_at_the_narrowest_width() {
+        let mut storage = BlockStorage::filled(3, 1);
+        storage.set(0, 1000);
+        storage.set(0, 2);
+        let json = serde_json::to_string(&storage).unwrap();
+        assert_eq!(json, "[2,1,1]");
+        let reloaded: BlockStorage = serde_json::from_str(&json).unwrap();
+        assert_eq!(reloaded, storage);
+        assert_eq!(reloaded.width_bytes(), 1);
+    }
+
+    #[test]
+    fn sparse_storage_matches_dense_and_stores_only_written_sections() {
+        // An unaligned 40×20×40 box starting at negative coordinates.
+        let origin = (-7, -3, -20);
+        let dims = (40, 20, 40);
+        let len = dims.0 * dims.1 * dims.2;
+        let mut dense = BlockStorage::filled(len, 0);
+        let mut sparse = BlockStorage::sparse(origin, dims, 0);
+        assert_eq!(sparse.heap_bytes(), 0);
+
+        for (index, value) in [(0, 3), (17, 300), (len - 1, 5), (len / 2, 1)] {
+            assert_eq!(dense.replace(index, value), sparse.replace(index, value));
+        }
+        // Writing the fill value into an unstored section allocates nothing.
+        // Cells 0 and 17 straddle x = 0, so four sections hold the writes.
+        sparse.set(len / 3, 0);
+        assert_eq!(sparse.section_count(), 4);
+        assert_eq!(sparse, dense);
+        assert_eq!(sparse.count_in_range(0..len, 0), len - 4);
+
+        let mut visited = Vec::new();
+        sparse.for_each_index_ne(0, |index| visited.push(index));
+        visited.sort_unstable();
+        assert_eq!(visited, vec![0, 17, len / 2, len - 1]);
+
+        sparse.reverse_range(0..18);
+        dense.reverse_range(0..18);
+        sparse.swap_ranges(0, 40, 20);
+        dense.swap_ranges(0, 40, 20);
+        assert_eq!(sparse, dense);
+        assert_eq!(sparse.to_dense(), dense);
+        assert_eq!(dense.to_sparse(origin, dims, 0), dense);
+    }
+
+    #[test]
+    fn sparse_fill_box_collapses_whole_sections_and_rebound_keeps_cells() {
+        let mut sparse = BlockStorage::sparse((0, 0, 0), (32, 32, 32), 0);
+        // One full section plus a partial slab next to it.
+        let replaced = sparse.fill_box((0, 0, 0), (15, 15, 17), 2, 0);
+        assert_eq!(replaced, Some(16 * 16 * 18));
+        assert_eq!(sparse.section_count(), 2);
+        assert_eq!(sparse.count_in_range(0..sparse.len(), 2), 16 * 16 * 18);
+        assert_eq!(sparse.fill_box((0, 0, 0), (15, 15, 15), 0, 2), Some(4096));
+        assert_eq!(sparse.section_count(), 1);
+        assert_eq!(
+            BlockStorage::filled(8, 0).fill_box((0, 0, 0), (1, 1, 1), 1, 0),
+            None
+        );
+
+        // Growing towards negative coordinates keeps every cell in place.
+        let before: Vec<(i32, i32, i32)> = {
+            let mut cells = Vec::new();
+            sparse.for_each_index_ne(0, |index| {
+                let Cells::Sparse(s) = &sparse.0 else {
+                    unreachable!()
+                };
+                cells.push(s.world(index));
+            });
+            cells
+        };
+        sparse.rebound((-100, 0, -100), (200, 32, 200));
+        let Cells::Sparse(s) = &sparse.0 else {
+            unreachable!()
+        };
+        for (x, y, z) in before {
+            assert_eq!(s.get(s.linear(x, y, z)), 2);
+        }
+        assert_eq!(sparse.count_in_range(0..sparse.len(), 2), 16 * 16 * 2);
+    }
+
+    #[test]
+    fn histogram_matches_per_value_counts_at_every_width() {
+        fn naive(storage: &BlockStorage, values: usize) -> Vec<u64> {
+            (0..values)
+                .map(|v| storage.count_in_range(0..storage.len(), v) as u64)
+                .collect()
+        }
+        let mut narrow = BlockStorage::from((0..1003).map(|i| i % 7).collect::<Vec<_>>());
+        let mut counts = vec![0; 7];
+        narrow.histogram(&mut counts);
+        assert_eq!(counts, naive(&narrow, 7));
+
+        narrow.set(5, 400);
+        let mut counts = vec![0; 401];
+        narrow.histogram(&mut counts);
+        assert_eq!(counts, naive(&narrow, 401));
+
+        let mut sparse = BlockStorage::sparse((-3, 0, -3), (40, 20, 40), 0);
+        sparse.fill_box((0, 0, 0), (15, 15, 15), 2, 0);
+        sparse.set(7, 1);
+        let mut counts = vec![0; 3];
+        sparse.histogram(&mut counts);
+        assert_eq!(counts, naive(&sparse, 3));
+        assert_eq!(counts.iter().sum::<u64>(), sparse.len() as u64);
+    }
+
+    #[test]
+    fn sparse_clones_share_sections_until_written() {
+        fn shared(a: &BlockStorage, b: &BlockStorage) -> usize {
+            let (Cells::Sparse(a), Cells::Sparse(b)) = (&a.0, &b.0) else {
+                unreachable!()
+            };
+            a.sections
+                .iter()
+                .filter(|(key, section)| match (section, b.sections.get(key)) {
+                    (Section::Cells(x), Some(Section::Cells(y))) => Arc::ptr_eq(x, y),
+                    _ => false,
+                })
+                .count()
+        }
+
+        let mut base = BlockStorage::sparse((0, 0, 0), (64, 16, 16), 0);
+        for section in 0..4 {
+            base.set(section * 16, 1);
+        }
+        let mut variant = base.clone();
+        assert_eq!(shared(&base, &variant), 4);
+
+        // Rewriting a cell with its current value copies nothing.
+        variant.set(0, 1);
+        assert_eq!(shared(&base, &variant), 4);
+        variant.set(1, 2);
+        assert_eq!(shared(&base, &variant), 3);
+        assert_eq!(base.at(1), 0);
+        assert_eq!(variant.at(1), 2);
+    }
+
+    #[test]
+    fn slab_writer_copies_remaps_and_skips() {
+        let src = BlockStorage::from(vec![0, 1, 2, 1, 0, 2]);
+        let mut dst = BlockStorage::filled(8, 7);
+        dst.ensure_holds(300);
+        dst.for_each_slab(4, |slab_index, slab| {
+            if slab_index == 0 {
+                slab.copy_from(1, &src, 0, 3);
+            } else {
+                slab.copy_remapped(0, &src, 2, 4, Some(&[10, 20, 300]), Some(0));
+            }
+        });
+        assert_eq!(dst, vec![7, 0, 1, 2, 300, 20, 7, 300]);
+
+        let mut sparse = BlockStorage::sparse((0, 0, 0), (4, 2, 1), 0);
+        sparse.for_each_slab(4, |slab_index, slab| {
+            slab.copy_remapped(0, &src, slab_index, 4, Some(&[10, 20, 30]), Some(0));
+        });
+        assert_eq!(sparse, vec![0, 20, 30, 20, 20, 30, 20, 0]);
+    }
+
+    #[test]
+    fn find_ne_skips_runs_on_both_backends() {
+        let values = vec![0, 0, 0, 5, 0, 0, 300, 0];
+        for cells in [
+            BlockStorage::from(values.clone()),
+            BlockStorage::from(values.clone()).to_sparse((0, 0, 0), (8, 1, 1), 0),
+        ] {
+            assert_eq!(cells.find_ne(0..8, 0), Some((3, 5)));
+            assert_eq!(cells.find_ne(4..8, 0), Some((6, 300)));
+            assert_eq!(cells.find_ne(7..8, 0), None);
+            assert_eq!(cells.find_ne(0..0, 7), None);
+        }
+        // A value no cell can hold differs from every cell.
+        assert_eq!(
+            BlockStorage::from(vec![1, 2]).find_ne(1..2, 9999),
+            Some((1, 2))
+        );
+    }
+
+    #[test]
+    fn slab_writer_gathers_and_permutes_rows() {
+        // 40 × 40 so a gather crosses tile edges; reading column-major
+        // transposes the source.
+        let n = 40;
+        let src = BlockStorage::from((0..n * n).map(|i| i % 300).collect::<Vec<_>>());
+        let transposed: Vec<usize> = (0..n * n).map(|i| (i % n * n + i / n) % 300).collect();
+        for mut dst in [
+            BlockStorage::filled(n * n, 0),
+            BlockStorage::sparse((0, 0, 0), (n, n, 1), 0),
+        ] {
+            dst.ensure_holds(299);
+            dst.for_each_slab(n * n, |_, slab| {
+                slab.gather(0, n, n, &src, 0, n as isize, 1)
+            });
+            assert_eq!(dst, transposed);
+        }
+
+        for mut cells in [
+            BlockStorage::from(vec![0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]),
+            BlockStorage::from(vec![0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]).to_sparse(
+                (0, 0, 0),
+                (2, 2, 3),
+                0,
+            ),
+        ] {
+            cells.for_each_slab(6, |_, slab| slab.reverse_rows(2));
+            assert_eq!(cells, vec![1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10]);
+            cells.for_each_slab(6, |_, slab| slab.mirror_rows(2));
+            assert_eq!(cells, vec![5, 4, 3, 2, 1, 0, 11, 10, 9, 8, 7, 6]);
+        }
+    }
+
+    #[test]
+    fn le_bytes_round_trip_at_every_width() {
+        for values in [
+            vec![0, 1, 255, 7],
+            vec![0, 300, 65535, 2],
+            vec![0, 70000, usize::MAX, 5],
+        ] {
+            let dense = BlockStorage::from(values.clone());
+            let sparse = dense.to_sparse((0, 0, 0), (2, 1, 2), 0);
+            for storage in [dense, sparse] {
+                let mut bytes = vec![0xAA];
+                let width = storage.write_le_bytes(&mut bytes);
+                assert_eq!(bytes.len(), 1 + values.len() * width);
+                // Offset by one byte so the wider widths decode unaligned.
+                let restored = BlockStorage::from_le_bytes(&bytes[1..], width).unwrap();
+                assert_eq!(restored, values);
+                for (i, &value) in values.iter().enumerate() {
+                    assert_eq!(BlockStorage::read_le(&bytes[1..], width, i), value);
+                }
+            }
+        }
+        assert!(BlockStorage::from_le_bytes(&[0, 0, 0], 2).is_none());
+        assert!(BlockStorage::from_le_bytes(&[0, 0, 0], 3).is_none());
+    }
+}
@@ -0,0 +1,192 @@
+//! Process-wide cache of parsed block strings.
+//!
+//! `set_block_from_string` and its region variant parse strings such as
+//! `minecraft:chest[facing=north]{Items:[...]}` into a [`BlockState`] and
+//! optional block-entity NBT. Callers, the bindings above all, send the
+//! same few strings over and over and from many schematics, so the parses
+//! live here, shared, instead of in one unbounded map per schematic.
+//!
+//! ## Bounds
+//!
+//! At most [`CAPACITY`] strings are held. A miss on a full cache evicts by
+//! the clock algorithm: every hit marks its entry, and a hand sweeping the
+//! slots evicts the first unmarked one, clearing marks as it passes. Recently
+//! used strings stay, as with an LRU, but a hit only needs the read lock.
+//! Parse errors are never cached.
+//!
+//! The NBT is `Arc`-shared with every block entity placed from it;
+//! `BlockEntity::nbt_mut` copies on write, so the sharing is invisible.
+
+use crate::nbt::NbtMap;
+use crate::BlockState;
+use rustc_hash::FxHashMap;
+use smol_str::SmolStr;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Arc, OnceLock, RwLock};
+
+/// Most block strings held at once.
+pub const CAPACITY: usize = 4096;
+
+/// A parsed block string: its state and its block-entity NBT, if any.
+pub type Parsed = (BlockState, Option<Arc<NbtMap>>);
+
+/// Counters since the process started (or the last [`clear`]), plus the
+/// current occupancy.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct BlockStringCacheStats {
+    /// Lookups served from the cache.
+    pub hits: u64,
+    /// Lookups that had to parse.
+    pub misses: u64,
+    /// Entries dropped to stay within [`CAPACITY`].
+    pub evictions: u64,
+    /// Strings currently held.
+    pub entries: usize,
+    pub capacity: usize,
+}
+
+impl BlockStringCacheStats {
+    /// Fraction of lookups served from the cache; 0 before any lookup.
+    pub fn hit_rate(&self) -> f64 {
+        let lookups = self.hits + self.misses;
+        if lookups == 0 {
+            0.0
+        } else {
+            self.hits as f64 / lookups as f64
+        }
+    }
+}
+
+struct Slot {
+    key: SmolStr,
+    parsed: Parsed,
+    /// Set by every hit, cleared when the clock hand passes.
+    used: AtomicBool,
+}
+
+#[derive(Default)]
+struct Cache {
+    /// Block string -> index into `slots`. Keys up to 23 bytes, which is
+    /// most block ids, are stored inline without a heap allocation.
+    index: FxHashMap<SmolStr, usize>,
+    slots: Vec<Slot>,
+    hand: usize,
+}
+
+static HITS: AtomicU64 = AtomicU64::new(0);
+static MISSES: AtomicU64 = AtomicU64::new(0);
+static EVICTIONS: AtomicU64 = AtomicU64::new(0);
+
+fn cache() -> &'static RwLock<Cache> {
+    static CACHE: OnceLock<RwLock<Cache>> = OnceLock::new();
+    CACHE.get_or_init(Default::default)
+}
+
+impl Cache {
+    fn insert(&mut self, block_string: &str, parsed: Parsed) {
+        // Another thread may have parsed the same string meanwhile.
+        if self.index.contains_key(block_string) {
+            return;
+        }
+        let key = SmolStr::from(block_string);
+        let slot = Slot {
+            key: key.clone(),
+            parsed,
+            used: AtomicBool::new(false),
+        };
+        if self.slots.len() < CAPACITY {
+            self.index.insert(key, self.slots.len());
+            self.slots.push(slot);
+            return;
+        }
+        while self.slots[self.hand].used.swap(false, Ordering::Relaxed) {
+            self.hand = (self.hand + 1) % CAPACITY;
+        }
+        let evicted = std::mem::replace(&mut self.slots[self.hand], slot);
+        self.index.remove(&evicted.key);
+        self.index.insert(key, self.hand);
+        self.hand = (self.hand + 1) % CAPACITY;
+        EVICTIONS.fetch_add(1, Ordering::Relaxed);
+    }
+}
+
+/// The parse of `block_string`: cached, or `parse(block_string)` on a miss.
+pub(crate) fn get_or_parse(
+    block_string: &str,
+    parse: impl FnOnce(&str) -> Result<Parsed, String>,
+) -> Result<Parsed, String> {
+    // A poisoned lock only means another thread panicked mid-insert; every
+    // slot is whole at any point, so the contents stay usable.
+    {
+        let cache = cache().read().unwrap_or_else(|e| e.into_inner());
+        if let Some(&i) = cache.index.get(block_string) {
+            let slot = &cache.slots[i];
+            slot.used.store(true, Ordering::Relaxed);
+            HITS.fetch_add(1, Ordering::Relaxed);
+            return Ok(slot.parsed.clone());
+        }
+    }
+    MISSES.fetch_add(1, Ordering::Relaxed);
+    // Parse without holding the lock; threads racing on one new string
+    // only duplicate the parse.
+    let parsed = parse(block_string)?;
+    cache()
+        .write()
+        .unwrap_or_else(|e| e.into_inner())
+        .insert(block_string, parsed.clone());
+    Ok(parsed)
+}
+
+/// Hit and miss counts and occupancy of the shared cache.
+pub fn stats() -> BlockStringCacheStats {
+    let entries = cache()
+        .read()
+        .unwrap_or_else(|e| e.into_inner())
+        .slots
+        .len();
+    BlockStringCacheStats {
+        hits: HITS.load(Ordering::Relaxed),
+        misses: MISSES.load(Ordering::Relaxed),
+        evictions: EVICTIONS.load(Ordering::Relaxed),
+        entries,
+        capacity: CAPACITY,
+    }
+}
+
+/// Drop every cached parse and reset the counters.
+pub fn clear() {
+    *cache().write().unwrap_or_else(|e| e.into_inner()) = Cache::default();
+    HITS.store(0, Ordering::Relaxed);
+    MISSES.store(0, Ordering::Relaxed);
+    EVICTIONS.store(0, Ordering::Relaxed);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn parse(s: &str) -> Result<Parsed, String> {
+        Ok((BlockState::new(s.to_string()), None))
+    }
+
+    #[test]
+    fn hot_strings_survive_a_full_sweep() {
+        // Other tests share the cache, so only check what they cannot undo.
+        let hot = "minecraft:block_string_cache_hot";
+        let before = stats();
+        get_or_parse(hot, parse).unwrap();
+        for i in 0..CAPACITY * 2 {
+            get_or_parse(&format!("minecraft:block_string_cache_{i}"), parse).unwrap();
+            let (state, _) = get_or_parse(hot, |_| panic!("hot string was evicted")).unwrap();
+            assert_eq!(state.name, hot);
+        }
+        let after = stats();
+        assert!(after.entries <= CAPACITY);
+        assert!(after.hits - before.hits >= (CAPACITY * 2) as u64);
+        assert!(after.evictions - before.evictions >= CAPACITY as u64);
+        assert!(after.hit_rate() > 0.0);
+
+        assert!(get_or_parse("minecraft:block_string_cache_bad", |_| Err("bad".into())).is_err());
+        assert!(get_or_parse("minecraft:block_string_cache_bad", parse).is_ok());
+    }
+}
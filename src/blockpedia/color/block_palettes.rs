@@ -1,6 +1,9 @@
 use super::{palettes::GradientMethod, ExtendedColorData};
 use crate::blockpedia::BlockFacts;
 use crate::blockpedia::BLOCKS;
+use crate::building::color_index::ColorIndex;
+use std::sync::OnceLock;
+
 /// Generate palettes of actual Minecraft blocks based on color relationships
 pub struct BlockPaletteGenerator;
 
@@ -289,6 +292,40 @@ impl BlockFilter {
     }
 }
 
+/// Colored blocks passing a filter, indexed for nearest-Oklab lookups.
+/// Ties go to the block met first in `BLOCKS`, as a linear scan would.
+struct ClosestBlocks {
+    blocks: Vec<&'static BlockFacts>,
+    index: ColorIndex,
+}
+
+impl ClosestBlocks {
+    fn new(keep: impl Fn(&BlockFacts) -> bool) -> Self {
+        let blocks: Vec<&'static BlockFacts> = BLOCKS
+            .values()
+            .copied()
+            .filter(|block| block.extras.color.is_some() && keep(*block))
+            .collect();
+        let index = ColorIndex::new(
+            blocks
+                .iter()
+                .filter_map(|block| block.extras.color)
+                .map(|color| color.to_extended().oklab),
+        );
+        Self { blocks, index }
+    }
+
+    /// Every colored block, built on first use.
+    fn all() -> &'static Self {
+        static ALL: OnceLock<ClosestBlocks> = OnceLock::new();
+        ALL.get_or_init(|| Self::new(|_| true))
+    }
+
+    fn closest(&self, target: &ExtendedColorData) -> Option<&'static BlockFacts> {
+        self.index.nearest(&target.oklab).map(|i| self.blocks[i])
+    }
+}
+
 #[allow(dead_code, clippy::needless_borrow, clippy::explicit_auto_deref)] // API for future use
 impl BlockPaletteGenerator {
     /// Generate a gradient palette of blocks between two blocks with filtering
@@ -324,9 +361,10 @@ impl BlockPaletteGenerator {
         );
 
         // Find blocks that match each color in the gradient, honoring the filter
+        let candidates = ClosestBlocks::new(|block| filter.allows_block(block));
         let mut blocks = Vec::new();
         for (i, target_color) in color_gradient.iter().enumerate() {
-            if let Some(block) = Self::find_closest_block_to_color_filtered(*target_color, filter) {
+            if let Some(block) = candidates.closest(target_color) {
                 let role = match i {
                     0 => BlockRole::Primary,
                     i if i == steps - 1 => BlockRole::Accent,
@@ -485,20 +523,7 @@ impl BlockPaletteGenerator {
 
     /// Find the closest block to a target color
     fn find_closest_block_to_color(target_color: ExtendedColorData) -> Option<&'static BlockFacts> {
-        let mut best_block = None;
-        let mut best_distance = f32::INFINITY;
-
-        for block in BLOCKS.values() {
-            if let Some(block_color) = block.extras.color {
-                let distance = block_color.to_extended().distance_oklab(&target_color);
-                if distance < best_distance {
-                    best_distance = distance;
-                    best_block = Some(*block);
-                }
-            }
-        }
-
-        best_block
+        ClosestBlocks::all().closest(&target_color)
     }
 
     /// Find the closest block to a target color among blocks passing `filter`
@@ -506,23 +531,7 @@ impl BlockPaletteGenerator {
         target_color: ExtendedColorData,
         filter: &BlockFilter,
     ) -> Option<&'static BlockFacts> {
-        let mut best_block = None;
-        let mut best_distance = f32::INFINITY;
-
-        for block in BLOCKS.values() {
-            if !filter.allows_block(block) {
-                continue;
-            }
-            if let Some(block_color) = block.extras.color {
-                let distance = block_color.to_extended().distance_oklab(&target_color);
-                if distance < best_distance {
-                    best_distance = distance;
-                    best_block = Some(*block);
-                }
-            }
-        }
-
-        best_block
+        ClosestBlocks::new(|block| filter.allows_block(block)).closest(&target_color)
     }
 
     /// Generate usage notes for a block in a specific role
@@ -171,7 +171,7 @@ fn rgb_to_hsl(r: u8, g: u8, b: u8) -> [f32; 3] {
 }
 
 /// Simple RGB to Oklab conversion (matching existing build script)
-fn rgb_to_oklab_simple(rgb: [u8; 3]) -> [f32; 3] {
+pub(crate) fn rgb_to_oklab_simple(rgb: [u8; 3]) -> [f32; 3] {
     let r = rgb[0] as f32 / 255.0;
     let g = rgb[1] as f32 / 255.0;
     let b = rgb[2] as f32 / 255.0;
@@ -5,9 +5,10 @@
 
 use serde_json::{json, Map, Value};
 
+use super::index::BlockSet;
 use super::{
-    all_blocks, blocks_by_tag, get_block, variants_of, BlockFacts, BlockpediaError, Result, BLOCKS,
-    BLOCK_TAGS,
+    blocks_by_tag, get_block, variants_of, BlockFacts, BlockpediaError, Result, BLOCKS, BLOCK_TAGS,
+    KIND_ORDINALS,
 };
 
 /// Cap on the number of property-value combinations [`block_states_json`]
@@ -29,7 +30,11 @@ fn normalize_mc_name(name: &str) -> String {
 /// Look up a block accepting both `minecraft:oak_stairs` and short
 /// `oak_stairs` forms.
 fn get_block_normalized(id: &str) -> Option<&'static BlockFacts> {
-    get_block(&normalize_mc_name(id))
+    if id.contains(':') {
+        get_block(id)
+    } else {
+        get_block(&normalize_mc_name(id))
+    }
 }
 
 fn facts_value(f: &BlockFacts) -> Value {
@@ -75,8 +80,8 @@ pub fn all_block_ids_json() -> String {
 /// string (empty array for unknown tags). Accepts `minecraft:wool` and
 /// short `wool` forms, including nested paths like `mineable/pickaxe`.
 pub fn block_ids_by_tag_json(tag: &str) -> String {
-    let mut ids: Vec<&str> = blocks_by_tag(tag).map(|b| b.id).collect();
-    ids.sort_unstable();
+    // `BLOCK_TAGS` lists are generated in id order.
+    let ids: Vec<&str> = blocks_by_tag(tag).map(|b| b.id).collect();
     json!(ids).to_string()
 }
 
@@ -85,11 +90,10 @@ pub fn block_ids_by_tag_json(tag: &str) -> String {
 /// (empty array for unknown kinds).
 pub fn block_ids_by_kind_json(kind: &str) -> String {
     let key = normalize_mc_name(kind);
-    let mut ids: Vec<&str> = all_blocks()
-        .filter(|b| b.kind == key)
+    let ids: Vec<&str> = BlockSet::lookup(&KIND_ORDINALS, &key)
+        .iter()
         .map(|b| b.id)
         .collect();
-    ids.sort_unstable();
     json!(ids).to_string()
 }
 
@@ -0,0 +1,211 @@
+//! Bitset indexes over the block table.
+//!
+//! Every block has an ordinal, its position in [`BLOCK_LIST`] (block id
+//! order), and a [`BlockSet`] holds one bit per ordinal. `build.rs` bakes a
+//! set per data attribute (`FULL_CUBE_SET`, `COLORED_SET`, ...) and ordinal
+//! lists per tag, kind and property name, so a [`BlockQuery`] filter is a
+//! few dozen word operations instead of a pass over every block.
+//!
+//! Color lookups go through a k-d tree built on first use. It holds the
+//! Oklab values that `ColorData::to_extended` computes, the ones queries
+//! have always compared, and the build script cannot compute them.
+//!
+//! [`BlockQuery`]: super::BlockQuery
+
+use super::{BlockFacts, ExtendedColorData, BLOCK_LIST, BLOCK_WORDS, COLORED_SET};
+use crate::building::color_index::ColorIndex;
+use phf::Map;
+use std::sync::OnceLock;
+
+/// A set of blocks, one bit per ordinal. Iterates in block id order.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct BlockSet {
+    words: [u64; BLOCK_WORDS],
+}
+
+impl BlockSet {
+    pub(crate) const fn from_words(words: [u64; BLOCK_WORDS]) -> Self {
+        Self { words }
+    }
+
+    pub fn empty() -> Self {
+        Self::from_words([0; BLOCK_WORDS])
+    }
+
+    /// Every block in the table.
+    pub fn all() -> Self {
+        let mut set = Self::from_words([u64::MAX; BLOCK_WORDS]);
+        let tail = BLOCK_LIST.len() % 64;
+        if tail != 0 {
+            set.words[BLOCK_WORDS - 1] = (1 << tail) - 1;
+        }
+        set
+    }
+
+    pub fn from_ordinals(ordinals: &[u16]) -> Self {
+        let mut set = Self::empty();
+        for &ordinal in ordinals {
+            set.insert(ordinal);
+        }
+        set
+    }
+
+    /// The set for `key` in one of the generated ordinal maps; empty for
+    /// unknown keys.
+    pub(crate) fn lookup(index: &Map<&'static str, &'static [u16]>, key: &str) -> Self {
+        index
+            .get(key)
+            .map_or_else(Self::empty, |ordinals| Self::from_ordinals(ordinals))
+    }
+
+    pub fn insert(&mut self, ordinal: u16) {
+        self.words[ordinal as usize / 64] |= 1 << (ordinal % 64);
+    }
+
+    pub fn remove(&mut self, ordinal: u16) {
+        self.words[ordinal as usize / 64] &= !(1 << (ordinal % 64));
+    }
+
+    pub fn contains(&self, ordinal: u16) -> bool {
+        self.words[ordinal as usize / 64] & (1 << (ordinal % 64)) != 0
+    }
+
+    pub fn intersect(&mut self, other: &Self) {
+        for (a, b) in self.words.iter_mut().zip(&other.words) {
+            *a &= b;
+        }
+    }
+
+    pub fn union(&mut self, other: &Self) {
+        for (a, b) in self.words.iter_mut().zip(&other.words) {
+            *a |= b;
+        }
+    }
+
+    pub fn subtract(&mut self, other: &Self) {
+        for (a, b) in self.words.iter_mut().zip(&other.words) {
+            *a &= !b;
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.words.iter().map(|w| w.count_ones() as usize).sum()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.words.iter().all(|&w| w == 0)
+    }
+
+    /// The blocks in the set, in id order.
+    pub fn iter(&self) -> impl Iterator<Item = &'static BlockFacts> + '_ {
+        self.words.iter().enumerate().flat_map(|(i, &word)| {
+            let mut rest = word;
+            std::iter::from_fn(move || {
+                if rest == 0 {
+                    return None;
+                }
+                let bit = rest.trailing_zeros() as usize;
+                rest &= rest - 1;
+                Some(BLOCK_LIST[i * 64 + bit])
+            })
+        })
+    }
+}
+
+/// The colored blocks, in ordinal order, and a k-d tree over their colors.
+struct ColorTable {
+    index: ColorIndex,
+    blocks: Vec<&'static BlockFacts>,
+}
+
+fn color_table() -> &'static ColorTable {
+    static TABLE: OnceLock<ColorTable> = OnceLock::new();
+    TABLE.get_or_init(|| {
+        let blocks: Vec<&'static BlockFacts> = COLORED_SET.iter().collect();
+        let index = ColorIndex::new(
+            blocks
+                .iter()
+                .filter_map(|b| b.extras.color.map(|c| c.to_extended().oklab)),
+        );
+        ColorTable { index, blocks }
+    })
+}
+
+/// Colored blocks no farther than `radius` from `target`, judged as
+/// `color.to_extended().distance_oklab(target) <= radius` would.
+pub fn colors_within(target: &ExtendedColorData, radius: f32) -> BlockSet {
+    let table = color_table();
+    let mut set = BlockSet::empty();
+    table.index.within(&target.oklab, radius, |i| {
+        set.insert(table.blocks[i].ordinal)
+    });
+    set
+}
+
+/// The colored block nearest `target` in Oklab; the lower id wins a tie.
+pub fn nearest_color(target: &ExtendedColorData) -> Option<&'static BlockFacts> {
+    let table = color_table();
+    table.index.nearest(&target.oklab).map(|i| table.blocks[i])
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::blockpedia::{all_blocks, FULL_CUBE_SET, KIND_ORDINALS};
+
+    #[test]
+    fn indexes_agree_with_the_block_facts() {
+        assert_eq!(BlockSet::all().len(), BLOCK_LIST.len());
+        for (ordinal, block) in BLOCK_LIST.iter().enumerate() {
+            assert_eq!(block.ordinal as usize, ordinal);
+            assert_eq!(FULL_CUBE_SET.contains(block.ordinal), block.full_cube);
+            assert_eq!(
+                COLORED_SET.contains(block.ordinal),
+                block.extras.color.is_some()
+            );
+        }
+        assert!(BLOCK_LIST.windows(2).all(|w| w[0].id < w[1].id));
+
+        let stairs = BlockSet::lookup(&KIND_ORDINALS, "minecraft:stair");
+        let expected = all_blocks().filter(|b| b.kind == "minecraft:stair").count();
+        assert!(expected > 0);
+        assert_eq!(stairs.len(), expected);
+        assert!(stairs.iter().all(|b| b.kind == "minecraft:stair"));
+        assert!(BlockSet::lookup(&KIND_ORDINALS, "minecraft:nope").is_empty());
+    }
+
+    #[test]
+    fn color_tree_matches_a_linear_scan() {
+        for rgb in [
+            [200u8, 40, 40],
+            [20, 20, 20],
+            [240, 240, 230],
+            [60, 140, 70],
+        ] {
+            let target = ExtendedColorData::from_rgb(rgb[0], rgb[1], rgb[2]);
+            let distance = |b: &BlockFacts| {
+                b.extras
+                    .color
+                    .map(|c| c.to_extended().distance_oklab(&target))
+            };
+
+            let within = colors_within(&target, 0.1);
+            let expected: Vec<&str> = BLOCK_LIST
+                .iter()
+                .filter(|b| distance(b).is_some_and(|d| d <= 0.1))
+                .map(|b| b.id)
+                .collect();
+            assert_eq!(within.iter().map(|b| b.id).collect::<Vec<_>>(), expected);
+
+            let mut best: Option<(f32, &str)> = None;
+            for b in BLOCK_LIST.iter() {
+                if let Some(d) = distance(b) {
+                    if best.is_none_or(|(bd, _)| d < bd) {
+                        best = Some((d, b.id));
+                    }
+                }
+            }
+            assert_eq!(nearest_color(&target).map(|b| b.id), best.map(|b| b.1));
+        }
+    }
+}
@@ -16,6 +16,10 @@ use std::collections::HashMap;
 #[derive(Debug, Clone)]
 pub struct BlockFacts {
     pub id: &'static str,
+    /// Position in [`BLOCK_LIST`] (every block in id order), and the bit
+    /// the block owns in the query indexes.
+    pub ordinal: u16,
+    pub flags: BlockFlags,
     pub properties: &'static [(&'static str, &'static [&'static str])],
     pub default_state: &'static [(&'static str, &'static str)],
     pub transparent: bool,
@@ -45,6 +49,51 @@ pub struct BlockFacts {
     pub extras: Extras,
 }
 
+/// A block's yes/no facts packed into one word at build time, for hot loops
+/// that test blocks by id (meshing, redstone wiring, fingerprinting). Look
+/// them up with [`block_flags`].
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, Hash)]
+pub struct BlockFlags(u16);
+
+impl BlockFlags {
+    /// `minecraft:air`, `cave_air` or `void_air`.
+    pub const AIR: u16 = 1 << 0;
+    pub const TRANSPARENT: u16 = 1 << 1;
+    pub const FULL_CUBE: u16 = 1 << 2;
+    pub const BLOCK_ENTITY: u16 = 1 << 3;
+    /// The default state emits light.
+    pub const LIGHT_SOURCE: u16 = 1 << 4;
+    /// Redstone wire turns toward the block (wire, repeater, comparator,
+    /// observer, target).
+    pub const REDSTONE_CONNECTABLE: u16 = 1 << 5;
+
+    pub const fn from_bits(bits: u16) -> Self {
+        BlockFlags(bits)
+    }
+
+    pub const fn bits(self) -> u16 {
+        self.0
+    }
+
+    pub const fn contains(self, flag: u16) -> bool {
+        self.0 & flag == flag
+    }
+
+    pub const fn is_air(self) -> bool {
+        self.contains(Self::AIR)
+    }
+
+    /// A full cube that is not transparent: it hides its neighbours' faces
+    /// and conducts redstone power. Leaves, glass, slabs and carpets are not.
+    pub const fn is_opaque(self) -> bool {
+        self.0 & (Self::AIR | Self::TRANSPARENT | Self::FULL_CUBE) == Self::FULL_CUBE
+    }
+
+    pub const fn is_redstone_connectable(self) -> bool {
+        self.contains(Self::REDSTONE_CONNECTABLE)
+    }
+}
+
 #[derive(Debug, Clone, Default)]
 pub struct Extras {
     // Future extension point for fetcher data
@@ -586,6 +635,9 @@ pub use data_sources::*;
 pub mod color;
 pub use color::ExtendedColorData;
 
+// Bitset indexes and the color k-d tree behind the query builder
+pub mod index;
+
 // Query builder module for chained filtering
 pub mod query_builder;
 pub use query_builder::{
@@ -604,6 +656,12 @@ pub fn get_block(id: &str) -> Option<&'static BlockFacts> {
     BLOCKS.get(id).copied()
 }
 
+/// The flags of the block with the given id; `None` for ids not in the
+/// table.
+pub fn block_flags(id: &str) -> Option<BlockFlags> {
+    BLOCKS.get(id).map(|facts| facts.flags)
+}
+
 /// Get all blocks as an iterator
 pub fn all_blocks() -> impl Iterator<Item = &'static BlockFacts> {
     BLOCKS.values().copied()
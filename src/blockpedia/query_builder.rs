@@ -1,10 +1,62 @@
-use crate::blockpedia::{color::ExtendedColorData, BlockFacts, BLOCKS};
-use std::collections::HashSet;
+use crate::blockpedia::index::{self, BlockSet};
+use crate::blockpedia::{
+    color::ExtendedColorData, BlockFacts, BLOCKS, BLOCK_ENTITY_SET, BLOCK_LIST, COLORED_SET,
+    FULL_CUBE_SET, LIGHT_SOURCE_SET, PROPERTY_ORDINALS, TRANSPARENT_SET,
+};
+use std::collections::HashMap;
+use std::sync::OnceLock;
 
 /// Main entry point for block queries - works with BlockFacts throughout
 #[derive(Debug, Clone)]
 pub struct BlockQuery {
-    blocks: Vec<&'static BlockFacts>,
+    selection: Selection,
+}
+
+/// A query's blocks. Filters on a fresh query only narrow a [`BlockSet`]
+/// (kept in block id order); once a step orders or trims the result, it
+/// becomes a list and later filters test each block's bit instead.
+#[derive(Debug, Clone)]
+enum Selection {
+    Set(BlockSet),
+    List(Vec<&'static BlockFacts>),
+}
+
+/// Sets for the filters that go by block name, worked out on first use.
+struct NameSets {
+    falling: BlockSet,
+    needs_support: BlockSet,
+    survival: BlockSet,
+    /// Lowercased family name -> its blocks.
+    families: HashMap<String, BlockSet>,
+}
+
+fn name_sets() -> &'static NameSets {
+    static SETS: OnceLock<NameSets> = OnceLock::new();
+    SETS.get_or_init(|| {
+        let mut sets = NameSets {
+            falling: BlockSet::empty(),
+            needs_support: BlockSet::empty(),
+            survival: BlockSet::empty(),
+            families: HashMap::new(),
+        };
+        for block in BLOCK_LIST.iter() {
+            let ordinal = block.ordinal;
+            if BlockQuery::is_falling_block(block) {
+                sets.falling.insert(ordinal);
+            }
+            if BlockQuery::needs_support(block) {
+                sets.needs_support.insert(ordinal);
+            }
+            if BlockQuery::is_survival_obtainable(block) {
+                sets.survival.insert(ordinal);
+            }
+            sets.families
+                .entry(BlockQuery::get_block_family(block).to_lowercase())
+                .or_insert_with(BlockSet::empty)
+                .insert(ordinal);
+        }
+        sets
+    })
 }
 
 /// Color sampling methods for palette generation
@@ -82,145 +134,180 @@ impl AllBlocks {
     #[allow(clippy::new_ret_no_self)] // AllBlocks is just a namespace
     pub fn new() -> BlockQuery {
         BlockQuery {
-            blocks: BLOCKS.values().copied().collect(),
+            selection: Selection::Set(BlockSet::all()),
         }
     }
 }
 
 impl BlockQuery {
+    fn listed(blocks: Vec<&'static BlockFacts>) -> Self {
+        BlockQuery {
+            selection: Selection::List(blocks),
+        }
+    }
+
+    /// The matching blocks, in query order.
+    fn into_blocks(self) -> Vec<&'static BlockFacts> {
+        match self.selection {
+            Selection::Set(set) => set.iter().collect(),
+            Selection::List(blocks) => blocks,
+        }
+    }
+
+    /// Keep only the blocks in `set`.
+    fn keep(mut self, set: &BlockSet) -> Self {
+        match &mut self.selection {
+            Selection::Set(own) => own.intersect(set),
+            Selection::List(blocks) => blocks.retain(|b| set.contains(b.ordinal)),
+        }
+        self
+    }
+
+    /// Drop the blocks in `set`.
+    fn exclude(mut self, set: &BlockSet) -> Self {
+        match &mut self.selection {
+            Selection::Set(own) => own.subtract(set),
+            Selection::List(blocks) => blocks.retain(|b| !set.contains(b.ordinal)),
+        }
+        self
+    }
+
+    /// Keep only the blocks `f` accepts, for filters no index covers.
+    fn retain(mut self, f: impl Fn(&BlockFacts) -> bool) -> Self {
+        match &mut self.selection {
+            Selection::Set(own) => {
+                let mut kept = BlockSet::empty();
+                for block in own.iter().filter(|b| f(b)) {
+                    kept.insert(block.ordinal);
+                }
+                *own = kept;
+            }
+            Selection::List(blocks) => blocks.retain(|b| f(b)),
+        }
+        self
+    }
+
+    fn family_set(families: &[&str]) -> BlockSet {
+        let sets = &name_sets().families;
+        let mut set = BlockSet::empty();
+        for family in families {
+            if let Some(members) = sets.get(&family.to_lowercase()) {
+                set.union(members);
+            }
+        }
+        set
+    }
+
     // === FILTERING METHODS (return BlockQuery) ===
+    //
+    // Solidity, block entities, transparency and light come from the
+    // official data baked into the table, not name-substring guesses: a
+    // solid block is a full-cube model, and an unlit-by-default emitter
+    // (candle, redstone lamp) is not a light source.
 
     /// Only include solid blocks (exclude partial blocks, stairs, slabs, etc.)
-    pub fn only_solid(mut self) -> Self {
-        self.blocks.retain(|block| Self::is_solid_block(block));
-        self
+    pub fn only_solid(self) -> Self {
+        self.keep(&FULL_CUBE_SET)
     }
 
     /// Exclude blocks that are tile entities (chests, furnaces, etc.)
-    pub fn exclude_tile_entities(mut self) -> Self {
-        self.blocks.retain(|block| !Self::is_tile_entity(block));
-        self
+    pub fn exclude_tile_entities(self) -> Self {
+        self.exclude(&BLOCK_ENTITY_SET)
     }
 
     /// Exclude blocks that fall due to gravity
-    pub fn exclude_falling(mut self) -> Self {
-        self.blocks.retain(|block| !Self::is_falling_block(block));
-        self
+    pub fn exclude_falling(self) -> Self {
+        self.exclude(&name_sets().falling)
     }
 
     /// Exclude transparent blocks (glass, water, etc.)
-    pub fn exclude_transparent(mut self) -> Self {
-        self.blocks.retain(|block| !Self::is_transparent(block));
-        self
+    pub fn exclude_transparent(self) -> Self {
+        self.exclude(&TRANSPARENT_SET)
     }
 
     /// Exclude blocks that emit light
-    pub fn exclude_light_sources(mut self) -> Self {
-        self.blocks.retain(|block| !Self::is_light_source(block));
-        self
+    pub fn exclude_light_sources(self) -> Self {
+        self.exclude(&LIGHT_SOURCE_SET)
     }
 
     /// Only include blocks that require no support
-    pub fn exclude_needs_support(mut self) -> Self {
-        self.blocks.retain(|block| !Self::needs_support(block));
-        self
+    pub fn exclude_needs_support(self) -> Self {
+        self.exclude(&name_sets().needs_support)
     }
 
     /// Only include blocks obtainable in survival mode
-    pub fn survival_only(mut self) -> Self {
-        self.blocks
-            .retain(|block| Self::is_survival_obtainable(block));
-        self
+    pub fn survival_only(self) -> Self {
+        self.keep(&name_sets().survival)
     }
 
     /// Only include blocks that have color data
-    pub fn with_color(mut self) -> Self {
-        self.blocks.retain(|block| block.extras.color.is_some());
-        self
+    pub fn with_color(self) -> Self {
+        self.keep(&COLORED_SET)
     }
 
     /// Filter by property existence
-    pub fn with_property(mut self, property: &str) -> Self {
-        let property = property.to_string();
-        self.blocks.retain(|block| block.has_property(&property));
-        self
+    pub fn with_property(self, property: &str) -> Self {
+        self.keep(&BlockSet::lookup(&PROPERTY_ORDINALS, property))
     }
 
     /// Filter by property value
-    pub fn with_property_value(mut self, property: &str, value: &str) -> Self {
-        let property = property.to_string();
-        let value = value.to_string();
-        self.blocks.retain(|block| {
-            block.get_property(&property) == Some(value.as_str())
-                || block
-                    .get_property_values(&property)
-                    .map(|values| values.contains(&value))
-                    .unwrap_or(false)
-        });
-        self
+    pub fn with_property_value(self, property: &str, value: &str) -> Self {
+        self.keep(&BlockSet::lookup(&PROPERTY_ORDINALS, property))
+            .retain(|block| {
+                block.get_property(property) == Some(value)
+                    || block
+                        .properties
+                        .iter()
+                        .any(|&(key, values)| key == property && values.contains(&value))
+            })
     }
 
     /// Filter by block name pattern (supports wildcards)
-    pub fn matching(mut self, pattern: &str) -> Self {
+    pub fn matching(self, pattern: &str) -> Self {
         let pattern = pattern.to_lowercase();
-        self.blocks.retain(|block| {
+        self.retain(|block| {
             let id = block.id().to_lowercase();
             if pattern.contains('*') {
                 Self::matches_pattern(&id, &pattern)
             } else {
                 id.contains(&pattern)
             }
-        });
-        self
+        })
     }
 
     /// Include only blocks from specific families
-    pub fn from_families(mut self, families: &[&str]) -> Self {
-        let family_set: HashSet<String> = families.iter().map(|f| f.to_lowercase()).collect();
-        self.blocks.retain(|block| {
-            let family = Self::get_block_family(block);
-            family_set.contains(&family.to_lowercase())
-        });
-        self
+    pub fn from_families(self, families: &[&str]) -> Self {
+        self.keep(&Self::family_set(families))
     }
 
     /// Exclude blocks from specific families
-    pub fn exclude_families(mut self, families: &[&str]) -> Self {
-        let family_set: HashSet<String> = families.iter().map(|f| f.to_lowercase()).collect();
-        self.blocks.retain(|block| {
-            let family = Self::get_block_family(block);
-            !family_set.contains(&family.to_lowercase())
-        });
-        self
+    pub fn exclude_families(self, families: &[&str]) -> Self {
+        self.exclude(&Self::family_set(families))
     }
 
     /// Filter by color similarity to a target color
-    pub fn similar_to_color(mut self, target_color: ExtendedColorData, tolerance: f32) -> Self {
-        self.blocks.retain(|block| {
-            if let Some(color) = block.extras.color {
-                color.to_extended().distance_oklab(&target_color) <= tolerance
-            } else {
-                false
-            }
-        });
-        self
+    pub fn similar_to_color(self, target_color: ExtendedColorData, tolerance: f32) -> Self {
+        self.keep(&index::colors_within(&target_color, tolerance))
     }
 
     /// Limit the number of results
-    pub fn limit(mut self, count: usize) -> Self {
-        self.blocks.truncate(count);
-        self
+    pub fn limit(self, count: usize) -> Self {
+        let mut blocks = self.into_blocks();
+        blocks.truncate(count);
+        Self::listed(blocks)
     }
 
     /// Sort blocks by name
-    pub fn sort_by_name(mut self) -> Self {
-        self.blocks.sort_by(|a, b| a.id().cmp(b.id()));
-        self
+    pub fn sort_by_name(self) -> Self {
+        let mut blocks = self.into_blocks();
+        blocks.sort_by(|a, b| a.id().cmp(b.id()));
+        Self::listed(blocks)
     }
 
     /// Sort blocks by color similarity to a reference color
-    pub fn sort_by_color_similarity(mut self, reference: ExtendedColorData) -> Self {
-        self.blocks.sort_by(|a, b| {
+    pub fn sort_by_color_similarity(self, reference: ExtendedColorData) -> Self {
+        let mut blocks = self.into_blocks();
+        blocks.sort_by(|a, b| {
             let dist_a = a
                 .extras
                 .color
@@ -235,55 +322,61 @@ impl BlockQuery {
                 .partial_cmp(&dist_b)
                 .unwrap_or(std::cmp::Ordering::Equal)
         });
-        self
+        Self::listed(blocks)
     }
 
     // === TERMINAL METHODS (return Vec<BlockFacts> or other types) ===
 
     /// Get the blocks as a vector
     pub fn collect(self) -> Vec<&'static BlockFacts> {
-        self.blocks
+        self.into_blocks()
     }
 
     /// Get the count of matching blocks (consumes the query)
     pub fn count(self) -> usize {
-        self.blocks.len()
+        self.len()
     }
 
     /// Get the length of matching blocks (non-consuming)
     pub fn len(&self) -> usize {
-        self.blocks.len()
+        match &self.selection {
+            Selection::Set(set) => set.len(),
+            Selection::List(blocks) => blocks.len(),
+        }
     }
 
     /// Check if the query is empty (non-consuming)
     pub fn is_empty(&self) -> bool {
-        self.blocks.is_empty()
+        match &self.selection {
+            Selection::Set(set) => set.is_empty(),
+            Selection::List(blocks) => blocks.is_empty(),
+        }
     }
 
     /// Get the first block (if any)
     pub fn first(self) -> Option<&'static BlockFacts> {
-        self.blocks.into_iter().next()
+        match self.selection {
+            Selection::Set(set) => set.iter().next(),
+            Selection::List(blocks) => blocks.into_iter().next(),
+        }
     }
 
     /// Check if any blocks match
     pub fn any(self) -> bool {
-        !self.blocks.is_empty()
+        !self.is_empty()
     }
 
     /// Generate a gradient between blocks (returns blocks that match the gradient colors)
     pub fn generate_gradient(self, config: GradientConfig) -> Self {
         // Need at least 2 blocks with colors to generate a gradient
         let colored_blocks: Vec<_> = self
-            .blocks
-            .iter()
+            .into_blocks()
+            .into_iter()
             .filter(|block| block.extras.color.is_some())
-            .copied()
             .collect();
 
         if colored_blocks.len() < 2 {
-            return BlockQuery {
-                blocks: colored_blocks,
-            };
+            return Self::listed(colored_blocks);
         }
 
         let start_color = colored_blocks
@@ -323,10 +416,10 @@ impl BlockQuery {
                         config,
                     )
                 } else {
-                    BlockQuery { blocks: Vec::new() }
+                    Self::listed(Vec::new())
                 }
             }
-            _ => BlockQuery { blocks: Vec::new() },
+            _ => Self::listed(Vec::new()),
         }
     }
 
@@ -343,20 +436,17 @@ impl BlockQuery {
     /// Generate a multi-color gradient through all available block colors
     pub fn generate_multi_gradient(self, config: GradientConfig) -> Self {
         let colored_blocks: Vec<_> = self
-            .blocks
-            .iter()
+            .into_blocks()
+            .into_iter()
             .filter(|block| block.extras.color.is_some())
-            .copied()
             .collect();
 
         if colored_blocks.is_empty() {
-            return BlockQuery { blocks: Vec::new() };
+            return Self::listed(Vec::new());
         }
 
         if colored_blocks.len() == 1 {
-            return BlockQuery {
-                blocks: vec![colored_blocks[0]; config.steps.min(1)],
-            };
+            return Self::listed(vec![colored_blocks[0]; config.steps.min(1)]);
         }
 
         let colors: Vec<ExtendedColorData> = colored_blocks
@@ -365,53 +455,33 @@ impl BlockQuery {
             .collect();
 
         // Create a dummy instance to call the method
-        let dummy = BlockQuery { blocks: vec![] };
+        let dummy = Self::listed(vec![]);
         let gradient_colors = dummy.create_multi_gradient_colors(colors, config);
 
         // Find blocks that best match each gradient color
-        let mut gradient_blocks = Vec::new();
-        for target_color in gradient_colors {
-            // Use static method to find closest block
-            let mut best_block = None;
-            let mut best_distance = f32::INFINITY;
-
-            for block in BLOCKS.values() {
-                if let Some(block_color) = block.extras.color {
-                    let distance = block_color.to_extended().distance_oklab(&target_color);
-                    if distance < best_distance {
-                        best_distance = distance;
-                        best_block = Some(*block);
-                    }
-                }
-            }
-
-            if let Some(block) = best_block {
-                gradient_blocks.push(block);
-            }
-        }
+        let gradient_blocks = gradient_colors
+            .iter()
+            .filter_map(index::nearest_color)
+            .collect();
 
-        BlockQuery {
-            blocks: gradient_blocks,
-        }
+        Self::listed(gradient_blocks)
     }
 
     /// Sort blocks to create a smooth color transition
     pub fn sort_by_color_gradient(self) -> Self {
-        if self.blocks.len() <= 1 {
+        if self.len() <= 1 {
             return self;
         }
 
         // Only consider blocks with colors
         let mut colored_blocks: Vec<_> = self
-            .blocks
+            .into_blocks()
             .into_iter()
             .filter(|block| block.extras.color.is_some())
             .collect();
 
         if colored_blocks.len() <= 1 {
-            return BlockQuery {
-                blocks: colored_blocks,
-            };
+            return Self::listed(colored_blocks);
         }
 
         // Use traveling salesman-like approach to create smooth color transitions
@@ -441,23 +511,11 @@ impl BlockQuery {
             result.push(colored_blocks.remove(best_index));
         }
 
-        BlockQuery { blocks: result }
+        Self::listed(result)
     }
 
     // === HELPER METHODS ===
 
-    fn is_solid_block(block: &BlockFacts) -> bool {
-        // Official model geometry (cube-family template / full 16^3 element)
-        // instead of the old name-substring guess.
-        block.is_full_cube()
-    }
-
-    fn is_tile_entity(block: &BlockFacts) -> bool {
-        // Official `block_entity_type` registry data baked into the table
-        // instead of the old name-substring guess.
-        block.has_block_entity
-    }
-
     fn is_falling_block(block: &BlockFacts) -> bool {
         let id = block.id().to_lowercase();
         matches!(id.as_str(),
@@ -468,19 +526,6 @@ impl BlockQuery {
         )
     }
 
-    fn is_transparent(block: &BlockFacts) -> bool {
-        // Data field from the block report pipeline instead of the old
-        // name-substring guess.
-        block.transparent
-    }
-
-    fn is_light_source(block: &BlockFacts) -> bool {
-        // Data field (prismarine `emitLight` for the default state) instead
-        // of the old name-substring guess: an unlit-by-default emitter
-        // (candle, redstone lamp) no longer counts as a light source.
-        block.is_light_source()
-    }
-
     fn needs_support(block: &BlockFacts) -> bool {
         let id = block.id().to_lowercase();
         matches!(id.as_str(),
@@ -684,20 +729,7 @@ impl BlockQuery {
         &self,
         target_color: &ExtendedColorData,
     ) -> Option<&'static BlockFacts> {
-        let mut best_block = None;
-        let mut best_distance = f32::INFINITY;
-
-        for block in BLOCKS.values() {
-            if let Some(block_color) = block.extras.color {
-                let distance = block_color.to_extended().distance_oklab(target_color);
-                if distance < best_distance {
-                    best_distance = distance;
-                    best_block = Some(*block);
-                }
-            }
-        }
-
-        best_block
+        index::nearest_color(target_color)
     }
 
     fn apply_easing(t: f32, easing: EasingFunction) -> f32 {
@@ -955,37 +987,31 @@ impl BlockQuery {
 
         // Find blocks that best match each gradient color, avoiding duplicates
         let mut gradient_blocks = Vec::new();
-        let mut used_blocks = HashSet::new();
+        let mut unused = COLORED_SET;
 
         for target_color in colors {
-            let mut candidates: Vec<(&BlockFacts, f32)> = BLOCKS
-                .values()
-                .filter_map(|block| {
-                    if let Some(block_color) = block.extras.color {
-                        if !used_blocks.contains(block.id()) {
-                            let distance = block_color.to_extended().distance_oklab(&target_color);
-                            Some((*block, distance))
-                        } else {
-                            None
-                        }
-                    } else {
-                        None
-                    }
-                })
-                .collect();
-
-            // Sort by distance and pick the best unused block
-            candidates.sort_by(|a, b| a.1.partial_cmp(&b.1).unwrap_or(std::cmp::Ordering::Equal));
-
-            if let Some((best_block, _)) = candidates.first() {
-                gradient_blocks.push(*best_block);
-                used_blocks.insert(best_block.id().to_string());
+            // The tree's pick is usually still free; otherwise fall back to
+            // the nearest unused block.
+            let best = index::nearest_color(&target_color)
+                .filter(|block| unused.contains(block.ordinal))
+                .or_else(|| {
+                    unused
+                        .iter()
+                        .map(|block| {
+                            let color = block.extras.color.unwrap().to_extended();
+                            (block, color.distance_oklab(&target_color))
+                        })
+                        .min_by(|a, b| a.1.total_cmp(&b.1))
+                        .map(|(block, _)| block)
+                });
+
+            if let Some(best_block) = best {
+                gradient_blocks.push(best_block);
+                unused.remove(best_block.ordinal);
             }
         }
 
-        BlockQuery {
-            blocks: gradient_blocks,
-        }
+        Self::listed(gradient_blocks)
     }
 }
 
@@ -61,6 +61,22 @@ impl BoundingBox {
         }
     }
 
+    /// The cells inside both boxes, or `None` when they do not overlap.
+    pub fn intersection(&self, other: &BoundingBox) -> Option<BoundingBox> {
+        self.intersects(other).then(|| BoundingBox {
+            min: (
+                self.min.0.max(other.min.0),
+                self.min.1.max(other.min.1),
+                self.min.2.max(other.min.2),
+            ),
+            max: (
+                self.max.0.min(other.max.0),
+                self.max.1.min(other.max.1),
+                self.max.2.min(other.max.2),
+            ),
+        })
+    }
+
     pub fn coords_to_index(&self, x: i32, y: i32, z: i32) -> usize {
         let (width, _, length) = self.get_dimensions();
         let dx = x - self.min.0;
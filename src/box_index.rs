@@ -0,0 +1,172 @@
+//! A static bounding-volume hierarchy over a list of boxes.
+//!
+//! [`DefinitionRegion`](crate::definition_region::DefinitionRegion) can hold
+//! tens of thousands of boxes after `from_positions` on an irregular
+//! selection, and scanning them all per point query makes per-position work
+//! quadratic. The tree splits the boxes at the median centre along the
+//! longest axis until a leaf holds at most [`LEAF_SIZE`], so a point or box
+//! query visits O(log n) nodes plus the boxes it actually hits.
+//!
+//! The tree is immutable; owners rebuild it after changing their boxes.
+
+use crate::bounding_box::BoundingBox;
+
+/// Most boxes a leaf holds.
+const LEAF_SIZE: usize = 4;
+
+#[derive(Clone, Debug)]
+struct Node {
+    bounds: BoundingBox,
+    /// Range of `boxes` under this node.
+    start: u32,
+    end: u32,
+    /// Index of the second child; the first follows this node. 0 for a leaf.
+    right: u32,
+}
+
+#[derive(Clone, Debug, Default)]
+pub(crate) struct BoxIndex {
+    nodes: Vec<Node>,
+    /// The boxes in tree order, with their position in the source list.
+    boxes: Vec<(BoundingBox, usize)>,
+}
+
+impl BoxIndex {
+    pub(crate) fn new(boxes: &[BoundingBox]) -> Self {
+        let mut index = Self {
+            nodes: Vec::with_capacity(2 * boxes.len() / LEAF_SIZE + 1),
+            boxes: boxes.iter().cloned().zip(0..).collect(),
+        };
+        if !boxes.is_empty() {
+            index.build(0, boxes.len());
+        }
+        index
+    }
+
+    /// Boxes indexed; the owner's box count when the index was built.
+    pub(crate) fn len(&self) -> usize {
+        self.boxes.len()
+    }
+
+    fn build(&mut self, start: usize, end: usize) {
+        let bounds = self.boxes[start..end]
+            .iter()
+            .skip(1)
+            .fold(self.boxes[start].0.clone(), |acc, (b, _)| acc.union(b));
+        let node = self.nodes.len();
+        self.nodes.push(Node {
+            bounds: bounds.clone(),
+            start: start as u32,
+            end: end as u32,
+            right: 0,
+        });
+        if end - start <= LEAF_SIZE {
+            return;
+        }
+
+        let (dx, dy, dz) = bounds.get_dimensions();
+        let axis = if dx >= dy && dx >= dz {
+            0
+        } else if dy >= dz {
+            1
+        } else {
+            2
+        };
+        // Twice the centre, to stay in integers.
+        let centre = |b: &BoundingBox| -> i64 {
+            match axis {
+                0 => b.min.0 as i64 + b.max.0 as i64,
+                1 => b.min.1 as i64 + b.max.1 as i64,
+                _ => b.min.2 as i64 + b.max.2 as i64,
+            }
+        };
+        let mid = start + (end - start) / 2;
+        self.boxes[start..end].select_nth_unstable_by_key(mid - start, |(b, _)| centre(b));
+
+        self.build(start, mid);
+        self.nodes[node].right = self.nodes.len() as u32;
+        self.build(mid, end);
+    }
+
+    /// Calls `hit` with the source position and box of every box
+    /// overlapping `query`, stopping early when `hit` returns `false`.
+    /// Returns whether the search ran to the end.
+    pub(crate) fn search<'a>(
+        &'a self,
+        query: &BoundingBox,
+        mut hit: impl FnMut(usize, &'a BoundingBox) -> bool,
+    ) -> bool {
+        if self.nodes.is_empty() {
+            return true;
+        }
+        let mut stack = vec![0u32];
+        while let Some(i) = stack.pop() {
+            let node = &self.nodes[i as usize];
+            if !node.bounds.intersects(query) {
+                continue;
+            }
+            if node.right == 0 {
+                for (b, source) in &self.boxes[node.start as usize..node.end as usize] {
+                    if b.intersects(query) && !hit(*source, b) {
+                        return false;
+                    }
+                }
+            } else {
+                stack.push(node.right);
+                stack.push(i + 1);
+            }
+        }
+        true
+    }
+
+    pub(crate) fn contains(&self, x: i32, y: i32, z: i32) -> bool {
+        !self.search(&BoundingBox::new((x, y, z), (x, y, z)), |_, _| false)
+    }
+
+    /// The boxes overlapping `query`, in no particular order.
+    pub(crate) fn overlapping(&self, query: &BoundingBox) -> Vec<&BoundingBox> {
+        let mut found = Vec::new();
+        self.search(query, |_, b| {
+            found.push(b);
+            true
+        });
+        found
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn queries_match_a_linear_scan() {
+        let boxes: Vec<BoundingBox> = (0..500)
+            .map(|i: i32| {
+                let (x, y, z) = ((i * 37) % 101, (i * 11) % 23, (i * 53) % 67);
+                BoundingBox::new((x, y, z), (x + i % 4, y + i % 3, z + i % 5))
+            })
+            .collect();
+        let index = BoxIndex::new(&boxes);
+        assert_eq!(index.len(), boxes.len());
+
+        for x in (-2..110).step_by(3) {
+            for y in -1..30 {
+                for z in (-2..75).step_by(5) {
+                    let linear = boxes.iter().any(|b| b.contains((x, y, z)));
+                    assert_eq!(index.contains(x, y, z), linear);
+                }
+            }
+        }
+
+        let query = BoundingBox::new((20, 5, 10), (40, 12, 30));
+        let mut found = index.overlapping(&query);
+        let mut expected: Vec<&BoundingBox> =
+            boxes.iter().filter(|b| b.intersects(&query)).collect();
+        let key = |b: &&BoundingBox| (b.min, b.max);
+        found.sort_by_key(key);
+        expected.sort_by_key(key);
+        assert_eq!(found, expected);
+
+        assert!(!BoxIndex::new(&[]).contains(0, 0, 0));
+    }
+}
@@ -580,6 +580,12 @@ pub mod ffi {
             self.0.frames(fps, hold_ms).len() as u32
         }
 
+        /// Sample every group's pose at `fps` into flat per-frame arrays, for
+        /// hosts that drive their own renderer.
+        pub fn sample_poses(&self, fps: f64, hold_ms: f32) -> Box<PoseBuffer> {
+            Box::new(PoseBuffer(self.0.pose_buffer(fps, hold_ms)))
+        }
+
         /// Render directly to a looping GIF. The renderer, meshes, timeline and
         /// GIF encoder all live in the Rust core; no ffmpeg subprocess is needed.
         #[diplomat::attr(js, disable)]
@@ -599,8 +605,12 @@ pub mod ffi {
                 .0
                 .mesh_outputs(&pack, &crate::meshing::MeshConfig::default())
                 .map_err(|_| NucleationError::Mesh)?;
-            let frames = self.0.frames(fps, hold_ms);
-            let pixels = crate::rendering::render_animation(&meshes, &frames, &config.0, None)
+            let mut pixels = Vec::new();
+            self.0
+                .render_stream(&meshes, &config.0, None, fps, hold_ms, |_, frame| {
+                    pixels.push(frame.to_vec());
+                    Ok(())
+                })
                 .map_err(|_| NucleationError::Render)?;
             crate::rendering::write_animation_gif(
                 &pixels,
@@ -610,7 +620,7 @@ pub mod ffi {
                 path,
             )
             .map_err(|_| NucleationError::Io)?;
-            Ok(frames.len() as u32)
+            Ok(pixels.len() as u32)
         }
 
         /// Render and stream with an already parsed resource pack.
@@ -629,21 +639,23 @@ pub mod ffi {
                 .0
                 .mesh_outputs(&pack.0, &crate::meshing::MeshConfig::default())
                 .map_err(|_| NucleationError::Mesh)?;
-            let frames = self.0.frames(video.0.fps, hold_ms);
-            crate::rendering::render_animation_to_video(
-                &meshes,
-                &frames,
-                &config.0,
-                None,
-                &video.0,
-                std::path::Path::new(path),
-            )
-            .map_err(|_| NucleationError::Render)?;
-            Ok(frames.len() as u32)
+            let count = self
+                .0
+                .render_video(
+                    &meshes,
+                    &config.0,
+                    None,
+                    &video.0,
+                    hold_ms,
+                    std::path::Path::new(path),
+                )
+                .map_err(|_| NucleationError::Render)?;
+            Ok(count as u32)
         }
 
         /// Render and stream directly to video. The GPU renderer and meshes are
-        /// reused for the complete animation and no frame sequence is retained.
+        /// reused for the complete animation, and frames are sampled as they are
+        /// rendered rather than retained.
         #[diplomat::attr(js, disable)]
         #[cfg(all(feature = "rendering", not(target_arch = "wasm32")))]
         pub fn render_video(
@@ -661,17 +673,18 @@ pub mod ffi {
                 .0
                 .mesh_outputs(&pack, &crate::meshing::MeshConfig::default())
                 .map_err(|_| NucleationError::Mesh)?;
-            let frames = self.0.frames(video.0.fps, hold_ms);
-            crate::rendering::render_animation_to_video(
-                &meshes,
-                &frames,
-                &config.0,
-                None,
-                &video.0,
-                std::path::Path::new(path),
-            )
-            .map_err(|_| NucleationError::Render)?;
-            Ok(frames.len() as u32)
+            let count = self
+                .0
+                .render_video(
+                    &meshes,
+                    &config.0,
+                    None,
+                    &video.0,
+                    hold_ms,
+                    std::path::Path::new(path),
+                )
+                .map_err(|_| NucleationError::Render)?;
+            Ok(count as u32)
         }
 
         /// Render numbered PNG frames (`prefix0000.png`, ...) for an external
@@ -704,7 +717,6 @@ pub mod ffi {
             use crate::formats::manager::get_manager;
             let path = utf8(path)?;
             let manager = get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let bytes = manager
                 .write_auto_with_settings(path, self.0.schematic(), None, None)
                 .map_err(|_| NucleationError::Serialize)?;
@@ -719,6 +731,54 @@ pub mod ffi {
             self.0.duration_ms()
         }
     }
+
+    /// Sampled poses, frame-major then group. Slices borrow from this handle.
+    #[diplomat::opaque]
+    pub struct PoseBuffer(pub(crate) crate::animation::PoseBuffer);
+
+    impl PoseBuffer {
+        pub fn frame_count(&self) -> u32 {
+            self.0.frame_count() as u32
+        }
+
+        pub fn group_count(&self) -> u32 {
+            self.0.group_count() as u32
+        }
+
+        /// Frame times in milliseconds.
+        pub fn times<'a>(&'a self) -> &'a [f32] {
+            &self.0.times
+        }
+
+        pub fn group_ids<'a>(&'a self) -> &'a [u32] {
+            &self.0.group_ids
+        }
+
+        /// Column-major model matrices, 16 floats per pose.
+        pub fn matrices<'a>(&'a self) -> &'a [f32] {
+            &self.0.matrices
+        }
+
+        pub fn opacity<'a>(&'a self) -> &'a [f32] {
+            &self.0.opacity
+        }
+
+        /// RGBA, 4 floats per pose.
+        pub fn tint<'a>(&'a self) -> &'a [f32] {
+            &self.0.tint
+        }
+
+        /// RGBA, 4 floats per pose.
+        pub fn emissive<'a>(&'a self) -> &'a [f32] {
+            &self.0.emissive
+        }
+
+        /// Yaw, pitch, zoom and target offset, 6 floats per frame; zero on
+        /// frames without a camera pose.
+        pub fn camera<'a>(&'a self) -> &'a [f32] {
+            &self.0.camera
+        }
+    }
 }
 
 #[cfg(test)]
@@ -3,7 +3,7 @@
 #[diplomat::bridge]
 pub mod ffi {
     use super::super::schematic::ffi::Schematic;
-    use super::super::shared::ffi::NucleationError;
+    use super::super::shared::ffi::{BlockPos, NucleationError};
     use diplomat_runtime::DiplomatWrite;
     use std::fmt::Write;
 
@@ -79,5 +79,166 @@ pub mod ffi {
             .map(|s| Box::new(Schematic(s)))
             .map_err(|_| NucleationError::InvalidArgument)
         }
+
+        /// [`Autostack::resize_1d`] without stamping: the result holds the unit
+        /// cell once and stacks it when materialized.
+        pub fn resize_1d_tiled(
+            schematic: &Schematic,
+            vx: i32,
+            vy: i32,
+            vz: i32,
+            units: u32,
+        ) -> Result<Box<TiledSchematic>, NucleationError> {
+            crate::autostack::resize_1d_tiled(&schematic.0, [vx, vy, vz], units as usize)
+                .map(|t| Box::new(TiledSchematic(t)))
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// [`Autostack::resize_2d`] without stamping.
+        #[allow(clippy::too_many_arguments)]
+        pub fn resize_2d_tiled(
+            schematic: &Schematic,
+            v1x: i32,
+            v1y: i32,
+            v1z: i32,
+            v2x: i32,
+            v2y: i32,
+            v2z: i32,
+            n1: u32,
+            n2: u32,
+        ) -> Result<Box<TiledSchematic>, NucleationError> {
+            crate::autostack::resize_2d_tiled(
+                &schematic.0,
+                [v1x, v1y, v1z],
+                [v2x, v2y, v2z],
+                n1 as usize,
+                n2 as usize,
+            )
+            .map(|t| Box::new(TiledSchematic(t)))
+            .map_err(|_| NucleationError::InvalidArgument)
+        }
+    }
+
+    /// A resize result kept as unit cells and stamp offsets. Cheap to build
+    /// and query; [`TiledSchematic::materialize`] stamps it into a schematic,
+    /// e.g. right before export.
+    #[diplomat::opaque]
+    pub struct TiledSchematic(pub(crate) crate::autostack::TiledSchematic);
+
+    impl TiledSchematic {
+        /// Stamp every cell into a new schematic.
+        pub fn materialize(&self) -> Box<Schematic> {
+            Box::new(Schematic(self.0.materialize()))
+        }
+
+        /// Number of unit cells placed.
+        pub fn stamp_count(&self) -> u32 {
+            self.0.stamp_count() as u32
+        }
+
+        /// Number of distinct unit cells the stamps draw from.
+        pub fn cell_count(&self) -> u32 {
+            self.0.cell_count() as u32
+        }
+    }
+
+    /// One detected repeating structure (see `Autostack::detect_structures`
+    /// for the fields), with the label read through
+    /// [`AutostackSession::label_at`].
+    pub struct StackStructure {
+        /// `true` for a 2D array, `false` for a 1D run.
+        pub two_d: bool,
+        pub v1: BlockPos,
+        /// Second period vector; zero for a 1D run.
+        pub v2: BlockPos,
+        pub coverage: f32,
+        pub region_min: BlockPos,
+        pub region_max: BlockPos,
+        pub cell_min: BlockPos,
+        pub cell_max: BlockPos,
+    }
+
+    /// Detected structures kept up to date across edits. Wraps
+    /// [`crate::autostack::DetectSession`]: after `Schematic::set_block` and
+    /// friends, [`AutostackSession::update`] re-analyses only the voxels the
+    /// edits could change instead of the whole build.
+    #[diplomat::opaque_mut]
+    pub struct AutostackSession {
+        pub(crate) session: crate::autostack::DetectSession,
+        /// Structures from the last `update` or `update_graph`.
+        pub(crate) structures: Vec<crate::autostack::Structure>,
+    }
+
+    impl AutostackSession {
+        /// Detect the structures of all of `schematic` and start tracking its
+        /// edits. Read them with [`AutostackSession::structure_at`].
+        pub fn create(schematic: &mut Schematic) -> Box<AutostackSession> {
+            let session = crate::autostack::DetectSession::new(&mut schematic.0);
+            let structures = session.structures().to_vec();
+            Box::new(AutostackSession {
+                session,
+                structures,
+            })
+        }
+
+        /// Re-detect after the edits since the last call and return how many
+        /// structures there are.
+        pub fn update(&mut self, schematic: &mut Schematic) -> u32 {
+            self.structures = self.session.update(&mut schematic.0).to_vec();
+            self.structures.len() as u32
+        }
+
+        /// Graph-based detection over the session, re-run only after edits.
+        /// Requires the `simulation` feature; finds nothing without it.
+        pub fn update_graph(&mut self, schematic: &mut Schematic) -> u32 {
+            #[cfg(feature = "simulation")]
+            {
+                self.structures = self.session.update_graph(&mut schematic.0).to_vec();
+            }
+            #[cfg(not(feature = "simulation"))]
+            {
+                self.session.update(&mut schematic.0);
+                self.structures.clear();
+            }
+            self.structures.len() as u32
+        }
+
+        /// Number of structures from the last update.
+        pub fn structure_count(&self) -> u32 {
+            self.structures.len() as u32
+        }
+
+        /// The `index`-th structure from the last update, best first.
+        pub fn structure_at(&self, index: u32) -> Result<StackStructure, NucleationError> {
+            let st = self
+                .structures
+                .get(index as usize)
+                .ok_or(NucleationError::NotFound)?;
+            let pos = |v: [i32; 3]| BlockPos {
+                x: v[0],
+                y: v[1],
+                z: v[2],
+            };
+            Ok(StackStructure {
+                two_d: st.mode == "2d",
+                v1: pos(st.vectors.first().copied().unwrap_or_default()),
+                v2: pos(st.vectors.get(1).copied().unwrap_or_default()),
+                coverage: st.coverage,
+                region_min: pos(st.region_min),
+                region_max: pos(st.region_max),
+                cell_min: pos(st.cell_min),
+                cell_max: pos(st.cell_max),
+            })
+        }
+
+        /// Human-readable summary of the `index`-th structure.
+        pub fn label_at(&self, index: u32, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let st = self
+                .structures
+                .get(index as usize)
+                .ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", st.label);
+            Ok(())
+        }
     }
 }
@@ -57,13 +57,14 @@ pub mod ffi {
             out: &mut DiplomatWrite,
         ) -> Result<(), NucleationError> {
             let target = crate::blockpedia::ExtendedColorData::from_rgb(r, g, b);
-            let mut hits: Vec<(f32, &str, [u8; 3])> = crate::blockpedia::all_blocks()
-                .filter_map(|f| {
-                    let c = f.extras.color.as_ref()?.to_extended();
-                    let d = c.distance_oklab(&target);
-                    (d <= max_distance).then_some((d, f.id, c.rgb))
-                })
-                .collect();
+            let mut hits: Vec<(f32, &str, [u8; 3])> =
+                crate::blockpedia::index::colors_within(&target, max_distance)
+                    .iter()
+                    .filter_map(|f| {
+                        let c = f.extras.color.as_ref()?.to_extended();
+                        Some((c.distance_oklab(&target), f.id, c.rgb))
+                    })
+                    .collect();
             hits.sort_by(|a, b| a.0.partial_cmp(&b.0).unwrap_or(std::cmp::Ordering::Equal));
             let rows: Vec<serde_json::Value> = hits
                 .into_iter()
@@ -635,6 +635,38 @@ pub mod ffi {
             let _ = write!(out, "{}", id);
             Ok(())
         }
+
+        /// Snap a whole RGB image (3 bytes per pixel, row-major, `width`
+        /// pixels per row) at once: one palette index per pixel, in
+        /// `block_ids_json` order. With `dither`, pixel (x, row) matches
+        /// `closest_block_dithered` at voxel (x, 0, row). Errors with
+        /// `NotFound` on an empty palette.
+        pub fn closest_indices(
+            &self,
+            rgb: &[u8],
+            width: u32,
+            dither: bool,
+        ) -> Result<Box<PaletteIndices>, NucleationError> {
+            if self.0.is_empty() {
+                return Err(NucleationError::NotFound);
+            }
+            Ok(Box::new(PaletteIndices(self.0.closest_indices(
+                rgb,
+                width as usize,
+                dither,
+            ))))
+        }
+    }
+
+    /// Per-pixel palette indices from `Palette::closest_indices`. The slice
+    /// borrows from this handle.
+    #[diplomat::opaque]
+    pub struct PaletteIndices(pub(crate) Vec<u32>);
+
+    impl PaletteIndices {
+        pub fn indices<'a>(&'a self) -> &'a [u32] {
+            &self.0
+        }
     }
 
     /// Filter-driven palette construction (wraps
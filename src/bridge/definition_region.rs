@@ -16,7 +16,8 @@
 #[diplomat::bridge]
 pub mod ffi {
     use super::super::schematic::ffi::Schematic;
-    use super::super::shared::ffi::{BlockPos, Dimensions, NucleationError};
+    use super::super::shared::ffi::{BlockPos, Dimensions, NucleationError, ResultBuffer};
+    use super::super::shared::{refill_text, write_json_array};
     use diplomat_runtime::DiplomatWrite;
     use std::collections::HashMap;
     use std::fmt::Write;
@@ -268,13 +269,16 @@ pub mod ffi {
         /// Every contained position, written as a flat JSON array of ints
         /// (`[x0, y0, z0, x1, y1, z1, …]`), deduplicated, in box order.
         pub fn positions_json(&self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
-            let mut flat: Vec<i32> = Vec::new();
-            for (x, y, z) in self.0.iter_positions() {
-                flat.extend_from_slice(&[x, y, z]);
-            }
-            let json = serde_json::to_string(&flat).map_err(|_| NucleationError::Serialize)?;
-            let _ = write!(out, "{}", json);
-            Ok(())
+            write_json_array(out, self.0.iter_positions().flat_map(|(x, y, z)| [x, y, z]))
+        }
+
+        /// `positions_json` into a reusable `ResultBuffer`, so a caller
+        /// polling the same region does not allocate a string per call.
+        pub fn positions_json_into(&self, buf: &mut ResultBuffer) -> Result<(), NucleationError> {
+            write_json_array(
+                &mut refill_text(buf),
+                self.0.iter_positions().flat_map(|(x, y, z)| [x, y, z]),
+            )
         }
 
         /// Every contained position in sorted (y, z, x) order, written as a flat
@@ -327,6 +331,34 @@ pub mod ffi {
             Ok(())
         }
 
+        /// Every box into `out`, six ints per box (`min_x, min_y, min_z,
+        /// max_x, max_y, max_z`) like `boxes_json`. `out` must hold exactly
+        /// `box_count() * 6` ints.
+        pub fn boxes_into(&self, out: &mut [i32]) -> Result<(), NucleationError> {
+            if out.len() != self.0.boxes.len() * 6 {
+                return Err(NucleationError::InvalidArgument);
+            }
+            for (chunk, bbox) in out.chunks_exact_mut(6).zip(&self.0.boxes) {
+                let (min, max) = (bbox.min, bbox.max);
+                chunk.copy_from_slice(&[min.0, min.1, min.2, max.0, max.1, max.2]);
+            }
+            Ok(())
+        }
+
+        /// Every contained position into `out` as flat `[x, y, z, …]`, in box
+        /// order like `positions_json`, without building a list first. `out`
+        /// must hold exactly `volume() * 3` ints. For large regions prefer
+        /// `boxes_into`, which is six ints per box.
+        pub fn positions_into(&self, out: &mut [i32]) -> Result<(), NucleationError> {
+            if out.len() as u64 != self.0.volume() * 3 {
+                return Err(NucleationError::InvalidArgument);
+            }
+            for (chunk, (x, y, z)) in out.chunks_exact_mut(3).zip(self.0.iter_positions()) {
+                chunk.copy_from_slice(&[x, y, z]);
+            }
+            Ok(())
+        }
+
         /// Whether all positions form a single face-connected (6-connectivity)
         /// component. `true` for empty and single-block regions.
         pub fn is_contiguous(&self) -> bool {
@@ -344,6 +376,13 @@ pub mod ffi {
             self.0.simplify();
         }
 
+        /// `simplify`, then merge neighbouring boxes into their bounds until
+        /// at most `max_boxes` remain. The result may cover extra positions
+        /// (never fewer) and its boxes may overlap.
+        pub fn simplify_to(&mut self, max_boxes: u32) {
+            self.0.simplify_to(max_boxes as usize);
+        }
+
         /// A new region containing only the positions where `schematic` has a
         /// block named `block_name`.
         pub fn filter_by_block(
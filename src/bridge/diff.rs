@@ -6,8 +6,11 @@
 
 #[diplomat::bridge]
 pub mod ffi {
-    use super::super::schematic::ffi::Schematic;
-    use super::super::shared::ffi::NucleationError;
+    use super::super::jobs::ffi::Job;
+    use super::super::jobs::{spawn_job, take_job_output};
+    use super::super::schematic::ffi::{FrozenSchematic, Schematic};
+    use super::super::shared::ffi::{Bytes, NucleationError};
+    use super::super::store_io::ffi::Store;
     use diplomat_runtime::DiplomatWrite;
     use std::fmt::Write;
 
@@ -83,6 +86,492 @@ pub mod ffi {
         }
     }
 
+    fn parse_fingerprint_hex(
+        hex: &str,
+    ) -> Result<crate::fingerprint::Fingerprint, NucleationError> {
+        u128::from_str_radix(hex, 16)
+            .map(crate::fingerprint::Fingerprint)
+            .map_err(|_| NucleationError::Parse)
+    }
+
+    /// A JSON array of hex fingerprints.
+    fn parse_fingerprints_json(
+        json: &[u8],
+    ) -> Result<Vec<crate::fingerprint::Fingerprint>, NucleationError> {
+        let hexes: Vec<String> =
+            serde_json::from_slice(json).map_err(|_| NucleationError::Parse)?;
+        hexes.iter().map(|h| parse_fingerprint_hex(h)).collect()
+    }
+
+    /// A JSON array of ids, `null` for `None`.
+    fn write_ids_json(
+        ids: &[Option<&str>],
+        out: &mut DiplomatWrite,
+    ) -> Result<(), NucleationError> {
+        let json = serde_json::to_string(&ids).map_err(|_| NucleationError::Serialize)?;
+        let _ = write!(out, "{}", json);
+        Ok(())
+    }
+
+    /// Exact-duplicate lookup: each preset's 128-bit fingerprints mapped to
+    /// the id of the first build registered with them, so an upload can be
+    /// checked against everything seen before without loading any other
+    /// schematic. Save it to a `Store` or a file; open a saved catalog
+    /// read-only with `FrozenFingerprintCatalog` for lookups in place.
+    #[diplomat::opaque]
+    pub struct FingerprintCatalog(pub(crate) crate::fingerprint::FingerprintCatalog);
+
+    impl FingerprintCatalog {
+        pub fn create() -> Box<FingerprintCatalog> {
+            Box::new(FingerprintCatalog(Default::default()))
+        }
+
+        /// Entries across every preset.
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+
+        /// Register the schematic as `id` under `preset`. Returns `true` if
+        /// its fingerprint was new; otherwise writes the id it was first
+        /// registered with to `out` and returns `false`.
+        pub fn register(
+            &mut self,
+            id: &DiplomatStr,
+            schematic: &Schematic,
+            preset: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<bool, NucleationError> {
+            let spec = Fingerprint::spec(preset)?;
+            let fingerprint = crate::fingerprint::fingerprint(&schematic.0, &spec);
+            let id = std::str::from_utf8(id).map_err(|_| NucleationError::InvalidArgument)?;
+            let preset =
+                std::str::from_utf8(preset).map_err(|_| NucleationError::InvalidArgument)?;
+            match self.0.insert(preset, fingerprint, id) {
+                None => Ok(true),
+                Some(existing) => {
+                    let _ = write!(out, "{}", existing);
+                    Ok(false)
+                }
+            }
+        }
+
+        /// Register many precomputed fingerprints under `preset`, given as a
+        /// JSON array of `{"id", "fingerprint"}` (hex, as
+        /// `Fingerprint::compute` writes). Writes a JSON array with, per
+        /// entry, `null` if it was new or the id it was first registered
+        /// with.
+        pub fn register_batch_json(
+            &mut self,
+            preset: &DiplomatStr,
+            entries_json: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            #[derive(serde::Deserialize)]
+            struct Entry {
+                id: String,
+                fingerprint: String,
+            }
+            let preset =
+                std::str::from_utf8(preset).map_err(|_| NucleationError::InvalidArgument)?;
+            let entries: Vec<Entry> =
+                serde_json::from_slice(entries_json).map_err(|_| NucleationError::Parse)?;
+            let entries = entries
+                .into_iter()
+                .map(|e| Ok((parse_fingerprint_hex(&e.fingerprint)?, e.id)))
+                .collect::<Result<Vec<_>, NucleationError>>()?;
+            let first = self.0.insert_batch(preset, &entries);
+            let first: Vec<Option<&str>> = first.iter().map(|id| id.as_deref()).collect();
+            write_ids_json(&first, out)
+        }
+
+        /// Whether a build with the schematic's fingerprint is registered
+        /// under `preset`; if so its id is written to `out`.
+        pub fn lookup(
+            &self,
+            schematic: &Schematic,
+            preset: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<bool, NucleationError> {
+            let spec = Fingerprint::spec(preset)?;
+            let fingerprint = crate::fingerprint::fingerprint(&schematic.0, &spec);
+            let preset =
+                std::str::from_utf8(preset).map_err(|_| NucleationError::InvalidArgument)?;
+            Ok(match self.0.get(preset, fingerprint) {
+                Some(id) => {
+                    let _ = write!(out, "{}", id);
+                    true
+                }
+                None => false,
+            })
+        }
+
+        /// Look up a JSON array of hex fingerprints under `preset`, writing
+        /// a JSON array of ids, `null` where none is registered.
+        pub fn lookup_batch_json(
+            &self,
+            preset: &DiplomatStr,
+            fingerprints_json: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let preset =
+                std::str::from_utf8(preset).map_err(|_| NucleationError::InvalidArgument)?;
+            let fingerprints = parse_fingerprints_json(fingerprints_json)?;
+            write_ids_json(&self.0.get_batch(preset, &fingerprints), out)
+        }
+
+        /// Write the catalog to `key` in `store`.
+        pub fn save(&self, store: &Store, key: &DiplomatStr) -> Result<(), NucleationError> {
+            let key = std::str::from_utf8(key).map_err(|_| NucleationError::InvalidArgument)?;
+            self.0
+                .save(store.0.as_ref(), key)
+                .map_err(|_| NucleationError::Store)
+        }
+
+        /// Write the catalog to a file, replacing it atomically. Not
+        /// available in JS: the WASM build has no filesystem.
+        #[cfg(not(target_arch = "wasm32"))]
+        #[diplomat::attr(js, disable)]
+        pub fn write_file(&self, path: &DiplomatStr) -> Result<(), NucleationError> {
+            let path = std::str::from_utf8(path).map_err(|_| NucleationError::InvalidArgument)?;
+            self.0
+                .write_file(std::path::Path::new(path))
+                .map_err(|_| NucleationError::Io)
+        }
+
+        /// Read a catalog written by `save`, to register more builds.
+        /// Errors with `NotFound` when `key` is absent and `Parse` when it
+        /// does not hold a catalog.
+        pub fn load(
+            store: &Store,
+            key: &DiplomatStr,
+        ) -> Result<Box<FingerprintCatalog>, NucleationError> {
+            FrozenFingerprintCatalog::load(store, key)
+                .map(|frozen| Box::new(FingerprintCatalog(frozen.0.thaw())))
+        }
+    }
+
+    /// A saved `FingerprintCatalog` opened read-only: lookups binary-search
+    /// its records in place, so opening one costs only its header.
+    #[diplomat::opaque]
+    pub struct FrozenFingerprintCatalog(pub(crate) crate::fingerprint::FrozenCatalog);
+
+    impl FrozenFingerprintCatalog {
+        /// Open a catalog file written by `FingerprintCatalog::write_file`,
+        /// mapped read-only. Errors with `Io` when it cannot be read or is
+        /// not a catalog. Not available in JS: the WASM build has no
+        /// filesystem.
+        #[cfg(not(target_arch = "wasm32"))]
+        #[diplomat::attr(js, disable)]
+        pub fn open(path: &DiplomatStr) -> Result<Box<FrozenFingerprintCatalog>, NucleationError> {
+            let path = std::str::from_utf8(path).map_err(|_| NucleationError::InvalidArgument)?;
+            crate::fingerprint::FrozenCatalog::open(path)
+                .map(|c| Box::new(FrozenFingerprintCatalog(c)))
+                .map_err(|_| NucleationError::Io)
+        }
+
+        /// Fetch a catalog saved to `key` in `store`. Errors with `NotFound`
+        /// when `key` is absent and `Parse` when it does not hold a catalog.
+        pub fn load(
+            store: &Store,
+            key: &DiplomatStr,
+        ) -> Result<Box<FrozenFingerprintCatalog>, NucleationError> {
+            use crate::store::StoreError;
+            let key = std::str::from_utf8(key).map_err(|_| NucleationError::InvalidArgument)?;
+            crate::fingerprint::FrozenCatalog::load(store.0.as_ref(), key)
+                .map(|c| Box::new(FrozenFingerprintCatalog(c)))
+                .map_err(|e| match e {
+                    StoreError::NotFound(_) => NucleationError::NotFound,
+                    StoreError::Other(_) => NucleationError::Parse,
+                    _ => NucleationError::Store,
+                })
+        }
+
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+
+        /// `FingerprintCatalog::lookup`.
+        pub fn lookup(
+            &self,
+            schematic: &Schematic,
+            preset: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<bool, NucleationError> {
+            let spec = Fingerprint::spec(preset)?;
+            let fingerprint = crate::fingerprint::fingerprint(&schematic.0, &spec);
+            let preset =
+                std::str::from_utf8(preset).map_err(|_| NucleationError::InvalidArgument)?;
+            Ok(match self.0.get(preset, fingerprint) {
+                Some(id) => {
+                    let _ = write!(out, "{}", id);
+                    true
+                }
+                None => false,
+            })
+        }
+
+        /// `FingerprintCatalog::lookup_batch_json`.
+        pub fn lookup_batch_json(
+            &self,
+            preset: &DiplomatStr,
+            fingerprints_json: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let preset =
+                std::str::from_utf8(preset).map_err(|_| NucleationError::InvalidArgument)?;
+            let fingerprints = parse_fingerprints_json(fingerprints_json)?;
+            write_ids_json(&self.0.get_batch(preset, &fingerprints), out)
+        }
+    }
+
+    /// An approximate nearest-neighbour index over footprints (HNSW), for
+    /// near-duplicate search across a library without comparing every pair.
+    /// Ids are caller-chosen strings, e.g. the schematics' store keys. Use
+    /// one preset for every footprint in an index.
+    #[diplomat::opaque]
+    pub struct FootprintIndex(pub(crate) crate::fingerprint::FootprintIndex);
+
+    impl FootprintIndex {
+        fn utf8(s: &[u8]) -> Result<&str, NucleationError> {
+            std::str::from_utf8(s).map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        fn footprint_from_json(
+            json: &[u8],
+        ) -> Result<crate::fingerprint::Footprint, NucleationError> {
+            serde_json::from_slice(json)
+                .map(crate::fingerprint::Footprint)
+                .map_err(|_| NucleationError::Parse)
+        }
+
+        /// An empty index with the default graph parameters.
+        pub fn create() -> Box<FootprintIndex> {
+            Box::new(FootprintIndex(Default::default()))
+        }
+
+        /// An empty index keeping `m` links per node and inserting with a
+        /// candidate list `ef_construction` wide; larger values give better
+        /// recall for a slower build.
+        pub fn create_with_params(m: u32, ef_construction: u32) -> Box<FootprintIndex> {
+            Box::new(FootprintIndex(crate::fingerprint::FootprintIndex::new(
+                m as usize,
+                ef_construction as usize,
+            )))
+        }
+
+        /// Candidate-list width while searching: higher is slower and finds
+        /// more of the true nearest neighbours.
+        pub fn set_ef_search(&mut self, ef_search: u32) {
+            self.0.set_ef_search(ef_search as usize);
+        }
+
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+
+        /// Add a schematic's footprint under `id`. Errors with
+        /// `InvalidArgument` on an unknown preset or an id already present.
+        pub fn add(
+            &mut self,
+            id: &DiplomatStr,
+            schematic: &Schematic,
+            preset: &DiplomatStr,
+        ) -> Result<(), NucleationError> {
+            let spec = Fingerprint::spec(preset)?;
+            let footprint = crate::fingerprint::footprint(&schematic.0, &spec);
+            self.0
+                .insert(Self::utf8(id)?, &footprint)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Add a footprint given as the JSON array `Fingerprint::footprint_json`
+        /// writes, so an index can be rebuilt without reloading schematics.
+        /// Errors with `Parse` on bad JSON and `InvalidArgument` on a
+        /// duplicate id or a footprint of the wrong length.
+        pub fn add_footprint_json(
+            &mut self,
+            id: &DiplomatStr,
+            footprint_json: &DiplomatStr,
+        ) -> Result<(), NucleationError> {
+            let footprint = Self::footprint_from_json(footprint_json)?;
+            self.0
+                .insert(Self::utf8(id)?, &footprint)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        fn write_neighbors(
+            &self,
+            query: &crate::fingerprint::Footprint,
+            k: u32,
+            max_distance: f32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let found = self
+                .0
+                .search(query, k as usize, max_distance)
+                .map_err(|_| NucleationError::InvalidArgument)?;
+            let json: Vec<serde_json::Value> = found
+                .into_iter()
+                .map(|n| serde_json::json!({ "id": n.id, "distance": n.distance }))
+                .collect();
+            let json = serde_json::to_string(&json).map_err(|_| NucleationError::Serialize)?;
+            let _ = write!(out, "{}", json);
+            Ok(())
+        }
+
+        /// Up to `k` indexed footprints within `max_distance` of the
+        /// schematic's, nearest first, as a JSON array of
+        /// `{"id", "distance"}`. Approximate: a true neighbour can be missed.
+        pub fn nearest_json(
+            &self,
+            schematic: &Schematic,
+            preset: &DiplomatStr,
+            k: u32,
+            max_distance: f32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let spec = Fingerprint::spec(preset)?;
+            let footprint = crate::fingerprint::footprint(&schematic.0, &spec);
+            self.write_neighbors(&footprint, k, max_distance, out)
+        }
+
+        /// `nearest_json` for a footprint given as a JSON array.
+        pub fn nearest_footprint_json(
+            &self,
+            footprint_json: &DiplomatStr,
+            k: u32,
+            max_distance: f32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let footprint = Self::footprint_from_json(footprint_json)?;
+            self.write_neighbors(&footprint, k, max_distance, out)
+        }
+
+        /// Write the index to `key` in `store`.
+        pub fn save(&self, store: &Store, key: &DiplomatStr) -> Result<(), NucleationError> {
+            self.0
+                .save(store.0.as_ref(), Self::utf8(key)?)
+                .map_err(|_| NucleationError::Store)
+        }
+
+        /// Read an index written by `save`. Errors with `NotFound` when `key`
+        /// is absent and `Parse` when it does not hold an index.
+        pub fn load(
+            store: &Store,
+            key: &DiplomatStr,
+        ) -> Result<Box<FootprintIndex>, NucleationError> {
+            use crate::store::StoreError;
+            crate::fingerprint::FootprintIndex::load(store.0.as_ref(), Self::utf8(key)?)
+                .map(|index| Box::new(FootprintIndex(index)))
+                .map_err(|e| match e {
+                    StoreError::NotFound(_) => NucleationError::NotFound,
+                    StoreError::Other(_) => NucleationError::Parse,
+                    _ => NucleationError::Store,
+                })
+        }
+    }
+
+    /// Schematics collected for batch work (`FootprintMatrix::compute`,
+    /// `InsignRegions::compile_batch`). Holds frozen handles, so adding one
+    /// is a reference-count bump, not a copy.
+    #[diplomat::opaque]
+    pub struct FootprintBatch(pub(crate) Vec<std::sync::Arc<crate::UniversalSchematic>>);
+
+    impl FootprintBatch {
+        pub fn create() -> Box<FootprintBatch> {
+            Box::new(FootprintBatch(Vec::new()))
+        }
+
+        /// Append a schematic; its row in the matrix is its position here.
+        pub fn push(&mut self, schematic: &FrozenSchematic) {
+            self.0.push(schematic.0.clone());
+        }
+
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+    }
+
+    /// Footprints of many schematics in one contiguous `len × dims` float
+    /// buffer, with blocked all-pairs distances and top-k neighbours written
+    /// straight into caller-owned arrays instead of one call per pair.
+    #[diplomat::opaque]
+    pub struct FootprintMatrix(pub(crate) crate::fingerprint::FootprintMatrix);
+
+    impl FootprintMatrix {
+        /// Footprints of every schematic in `batch`, computed in parallel.
+        pub fn compute(
+            batch: &FootprintBatch,
+            preset: &DiplomatStr,
+        ) -> Result<Box<FootprintMatrix>, NucleationError> {
+            let spec = Fingerprint::spec(preset)?;
+            Ok(Box::new(FootprintMatrix(
+                crate::fingerprint::FootprintMatrix::from_schematics(&batch.0, &spec),
+            )))
+        }
+
+        /// Wrap footprints read back with `read_rows`. Errors with
+        /// `InvalidArgument` unless the length is a multiple of `dims`.
+        pub fn from_rows(rows: &[f32]) -> Result<Box<FootprintMatrix>, NucleationError> {
+            crate::fingerprint::FootprintMatrix::from_rows(rows.to_vec())
+                .map(|m| Box::new(FootprintMatrix(m)))
+                .ok_or(NucleationError::InvalidArgument)
+        }
+
+        /// Floats per footprint row.
+        pub fn dims() -> u32 {
+            crate::fingerprint::footprint::FOOTPRINT_DIMS as u32
+        }
+
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+
+        /// Copy every row into `out`, which must hold exactly `len × dims`.
+        pub fn read_rows(&self, out: &mut [f32]) -> Result<(), NucleationError> {
+            let rows = self.0.as_slice();
+            if out.len() != rows.len() {
+                return Err(NucleationError::InvalidArgument);
+            }
+            out.copy_from_slice(rows);
+            Ok(())
+        }
+
+        /// Distances from rows `first_row..first_row + row_count` to every
+        /// row, row-major into `out` (exactly `row_count × len`). Page
+        /// through the matrix in row blocks when all of it would not fit.
+        pub fn distances(
+            &self,
+            first_row: u32,
+            row_count: u32,
+            out: &mut [f32],
+        ) -> Result<(), NucleationError> {
+            let first = first_row as usize;
+            self.0
+                .distances(first..first + row_count as usize, out)
+                .ok_or(NucleationError::InvalidArgument)
+        }
+
+        /// Each row's `k` nearest other rows, nearest first, into `indices`
+        /// and `distances` (each exactly `len × k`). Rows with fewer than `k`
+        /// others are padded with index `u32::MAX` and infinite distance.
+        pub fn top_k(
+            &self,
+            k: u32,
+            indices: &mut [u32],
+            distances: &mut [f32],
+        ) -> Result<(), NucleationError> {
+            let want = self.0.len() * k as usize;
+            if indices.len() != want || distances.len() != want {
+                return Err(NucleationError::InvalidArgument);
+            }
+            let top = self.0.top_k(k as usize);
+            indices.copy_from_slice(&top.indices);
+            distances.copy_from_slice(&top.distances);
+            Ok(())
+        }
+    }
+
     /// A computed diff between two schematics.
     #[diplomat::opaque]
     pub struct Diff(pub(crate) crate::diff::Diff);
@@ -142,6 +631,31 @@ pub mod ffi {
             Ok(Box::new(Diff(crate::diff::diff(&a.0, &b.0, &spec))))
         }
 
+        /// `compute` between two frozen schematics as a background job. Take
+        /// the result with `Diff::from_job`. `InvalidArgument` on an unknown
+        /// preset.
+        pub fn start_compute(
+            a: &FrozenSchematic,
+            b: &FrozenSchematic,
+            preset: &DiplomatStr,
+        ) -> Result<Box<Job>, NucleationError> {
+            let preset =
+                std::str::from_utf8(preset).map_err(|_| NucleationError::InvalidArgument)?;
+            let spec =
+                crate::diff::DiffSpec::resolve(preset, &crate::diff::SpecOverrides::default())
+                    .ok_or(NucleationError::InvalidArgument)?;
+            let (a, b) = (std::sync::Arc::clone(&a.0), std::sync::Arc::clone(&b.0));
+            Ok(spawn_job(NucleationError::InvalidArgument, move |_| {
+                Ok(crate::diff::diff(&a, &b, &spec))
+            }))
+        }
+
+        /// The diff produced by a `start_compute` job. Blocks until the job
+        /// finishes; `AlreadyConsumed` on a second call.
+        pub fn from_job(job: &mut Job) -> Result<Box<Diff>, NucleationError> {
+            take_job_output::<crate::diff::Diff>(job).map(|d| Box::new(Diff(d)))
+        }
+
         /// Reconstruct a diff from its JSON representation.
         pub fn from_json(json: &DiplomatStr) -> Result<Box<Diff>, NucleationError> {
             let json = std::str::from_utf8(json).map_err(|_| NucleationError::InvalidArgument)?;
@@ -150,6 +664,13 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Parse)
         }
 
+        /// Reconstruct a diff from its compact binary form (`to_bytes`).
+        pub fn from_bytes(data: &[u8]) -> Result<Box<Diff>, NucleationError> {
+            crate::diff::Diff::from_bytes(data)
+                .map(|d| Box::new(Diff(d)))
+                .map_err(|_| NucleationError::Parse)
+        }
+
         /// The edit distance of the diff.
         pub fn distance(&self) -> u64 {
             self.0.distance
@@ -165,6 +686,21 @@ pub mod ffi {
             let _ = write!(out, "{}", self.0.to_json());
         }
 
+        /// The diff in its compact binary form: a blockstate palette plus
+        /// delta-coded positions, lossless like `to_json`.
+        pub fn to_bytes(&self) -> Box<Bytes> {
+            Box::new(Bytes(self.0.to_bytes()))
+        }
+
+        /// Rebuild the diff's "after" build from its "before" build. Exact for
+        /// diffs taken with the `exact` preset; edited cells carry no NBT.
+        pub fn apply(&self, base: &Schematic) -> Result<Box<Schematic>, NucleationError> {
+            self.0
+                .apply(&base.0)
+                .map(|s| Box::new(Schematic(s)))
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
         /// Serialize the diff to its compact summary JSON.
         pub fn summary_json(&self, out: &mut DiplomatWrite) {
             let _ = write!(out, "{}", self.0.summary_json());
@@ -2,10 +2,14 @@
 //! terrain from an elevation heightmap. Thin wrappers over `crate::geo`; the
 //! caller does the fetching and lat/lon → block projection.
 
+use crate::bridge::shared::ffi::NucleationError;
+
 #[diplomat::bridge]
 pub mod ffi {
     use super::super::schematic::ffi::Schematic;
     use super::super::shared::ffi::NucleationError;
+    #[cfg(not(target_arch = "wasm32"))]
+    use super::super::world_stream::ffi::WorldSink;
 
     /// Namespace for the geodata entry points (no network — data goes in,
     /// blocks come out).
@@ -73,20 +77,10 @@ pub mod ffi {
         ) -> Result<Box<Schematic>, NucleationError> {
             let hj =
                 std::str::from_utf8(heights_json).map_err(|_| NucleationError::InvalidArgument)?;
-            let sj = std::str::from_utf8(surface_blocks_json)
-                .map_err(|_| NucleationError::InvalidArgument)?;
-            let sub = std::str::from_utf8(subsurface_block)
-                .map_err(|_| NucleationError::InvalidArgument)?;
+            let (surface_blocks, sub) =
+                super::terrain_blocks(width, surface_blocks_json, subsurface_block)?;
             let name = std::str::from_utf8(name).map_err(|_| NucleationError::InvalidArgument)?;
-            if width <= 0 {
-                return Err(NucleationError::InvalidArgument);
-            }
             let heights: Vec<i32> = serde_json::from_str(hj).map_err(|_| NucleationError::Parse)?;
-            let surface_blocks: Vec<String> =
-                serde_json::from_str(sj).map_err(|_| NucleationError::Parse)?;
-            if surface_blocks.is_empty() {
-                return Err(NucleationError::InvalidArgument);
-            }
             let s = crate::geo::heightmap_terrain(
                 name,
                 &heights,
@@ -97,5 +91,82 @@ pub mod ffi {
             );
             Ok(Box::new(Schematic(s)))
         }
+
+        /// `heightmap_terrain` over raw elevation samples, passed as a float
+        /// array instead of JSON (a DEM tile straight from the caller's
+        /// buffer). Each sample is rounded to the nearest block; NaN becomes
+        /// 0. Errors as `heightmap_terrain`.
+        pub fn heightmap_terrain_floats(
+            heights: &[f32],
+            width: i32,
+            surface_blocks_json: &DiplomatStr,
+            subsurface_block: &DiplomatStr,
+            surface_depth: i32,
+            name: &DiplomatStr,
+        ) -> Result<Box<Schematic>, NucleationError> {
+            let (surface_blocks, sub) =
+                super::terrain_blocks(width, surface_blocks_json, subsurface_block)?;
+            let name = std::str::from_utf8(name).map_err(|_| NucleationError::InvalidArgument)?;
+            let s = crate::geo::heightmap_terrain(
+                name,
+                heights,
+                width as usize,
+                &surface_blocks,
+                sub,
+                surface_depth,
+            );
+            Ok(Box::new(Schematic(s)))
+        }
+
+        /// `heightmap_terrain_floats` streamed into `sink` instead of a
+        /// schematic: grid column (0, 0) lands on block (0, 0) and chunks are
+        /// written a region at a time, so memory stays flat for any grid size.
+        /// The caller still calls `finish` on the sink. Errors as
+        /// `heightmap_terrain`, plus `AlreadyConsumed` on a finished sink and
+        /// `Io` on a write failure.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn heightmap_terrain_to_world(
+            sink: &mut WorldSink,
+            heights: &[f32],
+            width: i32,
+            surface_blocks_json: &DiplomatStr,
+            subsurface_block: &DiplomatStr,
+            surface_depth: i32,
+        ) -> Result<(), NucleationError> {
+            let (surface_blocks, sub) =
+                super::terrain_blocks(width, surface_blocks_json, subsurface_block)?;
+            let sink = sink.0.as_mut().ok_or(NucleationError::AlreadyConsumed)?;
+            crate::geo::heightmap_terrain_to_world(
+                sink,
+                heights,
+                width as usize,
+                &surface_blocks,
+                sub,
+                surface_depth,
+            )
+            .map_err(|_| NucleationError::Io)
+        }
+    }
+}
+
+/// Validate the width and block arguments shared by the heightmap entry
+/// points: the surface block list and the subsurface block name.
+fn terrain_blocks<'a>(
+    width: i32,
+    surface_blocks_json: &[u8],
+    subsurface_block: &'a [u8],
+) -> Result<(Vec<String>, &'a str), NucleationError> {
+    let sj =
+        std::str::from_utf8(surface_blocks_json).map_err(|_| NucleationError::InvalidArgument)?;
+    let sub =
+        std::str::from_utf8(subsurface_block).map_err(|_| NucleationError::InvalidArgument)?;
+    if width <= 0 {
+        return Err(NucleationError::InvalidArgument);
+    }
+    let surface_blocks: Vec<String> =
+        serde_json::from_str(sj).map_err(|_| NucleationError::Parse)?;
+    if surface_blocks.is_empty() {
+        return Err(NucleationError::InvalidArgument);
     }
+    Ok((surface_blocks, sub))
 }
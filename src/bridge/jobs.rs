@@ -0,0 +1,441 @@
+//! Background jobs: the `MeshJob` polling pattern generalized so loading,
+//! saving, rendering, diffing and world segmentation can run off the calling
+//! thread.
+//!
+//! A job is started by a domain entry point (`Schematic::start_from_data`,
+//! `FrozenSchematic::start_save_as`, `Renderer::start_render_png`,
+//! `Diff::start_compute`, `WsRunResult::start_run_dir`, `Store::start_get`,
+//! …) which returns a [`ffi::Job`] immediately. The work runs on one shared,
+//! bounded worker pool (one thread per core, or `RAYON_NUM_THREADS`) instead
+//! of an OS thread per job; where threads are unavailable (wasm32) it runs
+//! inline before the entry point returns. Store operations on networked
+//! backends skip the pool and run as tasks on the backend's own runtime (see
+//! [`external_job`]). The caller polls `Job::poll_progress`, may `cancel`,
+//! and collects the output once, either with the generic `take_bytes` /
+//! `take_text` or with the domain's `from_job` (e.g. `Schematic::from_job`).
+//!
+//! PORTING rule 8 rules out callbacks, so completion is signalled by
+//! `Job::wait(timeout_ms)` instead of a function pointer: a host that wants
+//! a completion callback parks one of its own threads in `wait` and invokes
+//! the callback itself.
+
+use crate::bridge::shared::ffi::NucleationError;
+use std::any::Any;
+use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::sync::{Arc, Condvar, Mutex, OnceLock};
+
+type JobOutput = Result<Box<dyn Any + Send>, NucleationError>;
+
+struct JobSlot {
+    status: ffi::JobStatus,
+    output: Option<JobOutput>,
+}
+
+/// State shared between a [`ffi::Job`] handle and the pool task running it.
+pub(crate) struct JobCore {
+    slot: Mutex<JobSlot>,
+    finished: Condvar,
+    cancelled: Arc<AtomicBool>,
+    current: AtomicU32,
+    total: AtomicU32,
+}
+
+impl JobCore {
+    fn new() -> Self {
+        Self {
+            slot: Mutex::new(JobSlot {
+                status: ffi::JobStatus::Queued,
+                output: None,
+            }),
+            finished: Condvar::new(),
+            cancelled: Arc::new(AtomicBool::new(false)),
+            current: AtomicU32::new(0),
+            total: AtomicU32::new(0),
+        }
+    }
+
+    fn status(&self) -> ffi::JobStatus {
+        self.slot
+            .lock()
+            .map(|slot| slot.status)
+            .unwrap_or(ffi::JobStatus::Failed)
+    }
+
+    fn set_running(&self) {
+        if let Ok(mut slot) = self.slot.lock() {
+            slot.status = ffi::JobStatus::Running;
+        }
+    }
+
+    fn finish(&self, status: ffi::JobStatus, output: Option<JobOutput>) {
+        if let Ok(mut slot) = self.slot.lock() {
+            slot.status = status;
+            slot.output = output;
+        }
+        self.finished.notify_all();
+    }
+
+    fn is_finished(status: ffi::JobStatus) -> bool {
+        !matches!(status, ffi::JobStatus::Queued | ffi::JobStatus::Running)
+    }
+
+    /// Block until the job finishes or `timeout` elapses (`None` waits
+    /// forever). Returns whether it finished.
+    fn wait(&self, timeout: Option<std::time::Duration>) -> bool {
+        let Ok(slot) = self.slot.lock() else {
+            return true;
+        };
+        let pending = |slot: &mut JobSlot| !Self::is_finished(slot.status);
+        match timeout {
+            None => self
+                .finished
+                .wait_while(slot, pending)
+                .map(|slot| Self::is_finished(slot.status))
+                .unwrap_or(true),
+            Some(timeout) => self
+                .finished
+                .wait_timeout_while(slot, timeout, pending)
+                .map(|(slot, _)| Self::is_finished(slot.status))
+                .unwrap_or(true),
+        }
+    }
+}
+
+/// What a running job sees: its cancellation flag and a progress slot.
+pub(crate) struct JobContext<'a>(&'a JobCore);
+
+impl JobContext<'_> {
+    /// Whether `Job::cancel` has been called. Long-running work should check
+    /// this between steps and bail out with `Err(NucleationError::Cancelled)`.
+    pub(crate) fn is_cancelled(&self) -> bool {
+        self.0.cancelled.load(Ordering::Relaxed)
+    }
+
+    /// The cancellation flag itself, for work that polls a shared flag
+    /// (e.g. a meshing `CancelToken`) rather than this context.
+    pub(crate) fn cancel_flag(&self) -> Arc<AtomicBool> {
+        Arc::clone(&self.0.cancelled)
+    }
+
+    pub(crate) fn set_progress(&self, current: u32, total: u32) {
+        self.0.total.store(total, Ordering::Relaxed);
+        self.0.current.store(current, Ordering::Relaxed);
+    }
+}
+
+/// The shared job pool, or `None` where worker threads cannot be spawned.
+/// Kept separate from rayon's global pool so blocking I/O jobs never starve
+/// the data-parallel meshing and diffing that runs there.
+fn pool() -> Option<&'static rayon::ThreadPool> {
+    static POOL: OnceLock<Option<rayon::ThreadPool>> = OnceLock::new();
+    POOL.get_or_init(|| {
+        rayon::ThreadPoolBuilder::new()
+            .thread_name(|i| format!("nucleation-job-{i}"))
+            .build()
+            .ok()
+    })
+    .as_ref()
+}
+
+/// Queue `work` on the job pool and return its handle. A panic inside `work`
+/// is caught (it must not unwind across the FFI boundary) and reported as
+/// `panic_error`. A job cancelled before it starts never runs.
+pub(crate) fn spawn_job<T, F>(panic_error: NucleationError, work: F) -> Box<ffi::Job>
+where
+    T: Send + 'static,
+    F: FnOnce(&JobContext) -> Result<T, NucleationError> + Send + 'static,
+{
+    let core = Arc::new(JobCore::new());
+    let task_core = Arc::clone(&core);
+    let task = move || {
+        let ctx = JobContext(&task_core);
+        if ctx.is_cancelled() {
+            task_core.finish(ffi::JobStatus::Cancelled, None);
+            return;
+        }
+        task_core.set_running();
+        let outcome = std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| work(&ctx)));
+        match outcome {
+            _ if ctx.is_cancelled() => task_core.finish(ffi::JobStatus::Cancelled, None),
+            Ok(Ok(value)) => {
+                task_core.finish(ffi::JobStatus::Complete, Some(Ok(Box::new(value))));
+            }
+            Ok(Err(e)) => task_core.finish(ffi::JobStatus::Failed, Some(Err(e))),
+            Err(_) => task_core.finish(ffi::JobStatus::Failed, Some(Err(panic_error))),
+        }
+    };
+    match pool() {
+        Some(pool) => pool.spawn(task),
+        None => task(),
+    }
+    Box::new(ffi::Job { core, taken: false })
+}
+
+/// The finishing side of a job whose work runs outside the pool, e.g. as a
+/// task on a store backend's runtime. Dropping it unfinished (the task was
+/// torn down before it could report) fails the job with `abandoned`, so a
+/// waiter never hangs.
+pub(crate) struct JobCompleter {
+    core: Option<Arc<JobCore>>,
+    abandoned: NucleationError,
+}
+
+impl JobCompleter {
+    /// Record the job's result. A job cancelled meanwhile ends as
+    /// `Cancelled` and drops the output.
+    pub(crate) fn finish<T: Send + 'static>(mut self, result: Result<T, NucleationError>) {
+        let Some(core) = self.core.take() else {
+            return;
+        };
+        match result {
+            _ if core.cancelled.load(Ordering::Relaxed) => {
+                core.finish(ffi::JobStatus::Cancelled, None)
+            }
+            Ok(value) => core.finish(ffi::JobStatus::Complete, Some(Ok(Box::new(value)))),
+            Err(e) => core.finish(ffi::JobStatus::Failed, Some(Err(e))),
+        }
+    }
+}
+
+impl Drop for JobCompleter {
+    fn drop(&mut self) {
+        if let Some(core) = self.core.take() {
+            core.finish(ffi::JobStatus::Failed, Some(Err(self.abandoned)));
+        }
+    }
+}
+
+/// A `Running` job finished through the returned [`JobCompleter`] rather
+/// than by a pool task. `abandoned` is the error reported if the completer
+/// is dropped unfinished.
+pub(crate) fn external_job(abandoned: NucleationError) -> (Box<ffi::Job>, JobCompleter) {
+    let core = Arc::new(JobCore::new());
+    core.set_running();
+    let completer = JobCompleter {
+        core: Some(Arc::clone(&core)),
+        abandoned,
+    };
+    (Box::new(ffi::Job { core, taken: false }), completer)
+}
+
+/// Block until `job` finishes, then move its output out as a `T`. Errors with
+/// the job's own error if it failed, `Cancelled` if it was cancelled,
+/// `AlreadyConsumed` on a second take, and `InvalidArgument` (leaving the
+/// output in place) if the job produces something other than `T`.
+pub(crate) fn take_job_output<T: 'static>(job: &mut ffi::Job) -> Result<T, NucleationError> {
+    if job.taken {
+        return Err(NucleationError::AlreadyConsumed);
+    }
+    job.core.wait(None);
+    let mut slot = job.core.slot.lock().map_err(|_| NucleationError::Lock)?;
+    match slot.output.take() {
+        Some(Ok(value)) => match value.downcast::<T>() {
+            Ok(value) => {
+                job.taken = true;
+                Ok(*value)
+            }
+            Err(value) => {
+                slot.output = Some(Ok(value));
+                Err(NucleationError::InvalidArgument)
+            }
+        },
+        Some(Err(e)) => {
+            job.taken = true;
+            Err(e)
+        }
+        None => {
+            job.taken = true;
+            match slot.status {
+                ffi::JobStatus::Cancelled => Err(NucleationError::Cancelled),
+                _ => Err(NucleationError::AlreadyConsumed),
+            }
+        }
+    }
+}
+
+#[diplomat::bridge]
+pub mod ffi {
+    use super::super::shared::ffi::{Bytes, NucleationError};
+    use diplomat_runtime::DiplomatWrite;
+    use std::fmt::Write;
+    use std::sync::atomic::Ordering;
+
+    /// Lifecycle of a [`Job`].
+    #[derive(PartialEq, Eq, Debug)]
+    pub enum JobStatus {
+        /// Waiting for a pool thread.
+        Queued,
+        Running,
+        /// Finished; the output is ready to take.
+        Complete,
+        /// Finished with an error; taking the output returns it.
+        Failed,
+        /// Cancelled before it produced an output.
+        Cancelled,
+    }
+
+    /// Snapshot of a [`Job`]'s progress.
+    pub struct JobProgress {
+        pub status: JobStatus,
+        /// Steps completed so far (job-specific units).
+        pub current: u32,
+        /// Total steps (0 until known).
+        pub total: u32,
+    }
+
+    /// A bridge operation running on the shared job pool. Poll it with
+    /// [`Job::poll_progress`] or block in [`Job::wait`], then take the output
+    /// once (a second take returns `AlreadyConsumed`). Destroying a running
+    /// job detaches it: the work finishes in the background and its output is
+    /// dropped.
+    #[diplomat::opaque_mut]
+    pub struct Job {
+        pub(crate) core: std::sync::Arc<super::JobCore>,
+        pub(crate) taken: bool,
+    }
+
+    impl Job {
+        /// Cheap, non-blocking progress snapshot. Call from a timer/poll loop.
+        pub fn poll_progress(&self) -> JobProgress {
+            JobProgress {
+                status: self.core.status(),
+                current: self.core.current.load(Ordering::Relaxed),
+                total: self.core.total.load(Ordering::Relaxed),
+            }
+        }
+
+        /// Request cancellation. A queued job never runs; a running one stops
+        /// at its next cancellation check, or runs to completion and has its
+        /// output discarded. Either way it ends as `Cancelled`.
+        pub fn cancel(&self) {
+            self.core.cancelled.store(true, Ordering::Relaxed);
+        }
+
+        /// Block for up to `timeout_ms` milliseconds (0 just checks) until the
+        /// job finishes. Returns `true` once it has.
+        pub fn wait(&self, timeout_ms: u32) -> bool {
+            self.core
+                .wait(Some(std::time::Duration::from_millis(timeout_ms as u64)))
+        }
+
+        /// Take the output of a job that produces bytes (saves, PNG renders).
+        /// Blocks until the job finishes.
+        pub fn take_bytes(&mut self) -> Result<Box<Bytes>, NucleationError> {
+            super::take_job_output::<Vec<u8>>(self).map(|data| Box::new(Bytes(data)))
+        }
+
+        /// Take the output of a job that produces a flag (store `exists`).
+        /// Blocks until the job finishes.
+        pub fn take_bool(&mut self) -> Result<bool, NucleationError> {
+            super::take_job_output::<bool>(self)
+        }
+
+        /// Take the outcome of a job that produces nothing (store `put` and
+        /// `delete`): `Ok` once it succeeded, or its error. Blocks until the
+        /// job finishes.
+        pub fn take_empty(&mut self) -> Result<(), NucleationError> {
+            super::take_job_output::<()>(self)
+        }
+
+        /// Take the output of a job that produces text (fingerprints).
+        /// Blocks until the job finishes.
+        pub fn take_text(&mut self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let text = super::take_job_output::<String>(self)?;
+            let _ = write!(out, "{}", text);
+            Ok(())
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn completed_job_hands_over_its_output_once() {
+        let mut job = spawn_job(NucleationError::Io, |ctx| {
+            ctx.set_progress(1, 1);
+            Ok(vec![1u8, 2, 3])
+        });
+        assert!(job.wait(10_000));
+        assert_eq!(job.poll_progress().status, ffi::JobStatus::Complete);
+        assert_eq!(
+            take_job_output::<String>(&mut job).unwrap_err(),
+            NucleationError::InvalidArgument
+        );
+        assert_eq!(take_job_output::<Vec<u8>>(&mut job).unwrap(), vec![1, 2, 3]);
+        assert_eq!(
+            take_job_output::<Vec<u8>>(&mut job).unwrap_err(),
+            NucleationError::AlreadyConsumed
+        );
+    }
+
+    #[test]
+    fn external_jobs_finish_through_their_completer() {
+        let (mut job, completer) = external_job(NucleationError::Store);
+        assert_eq!(job.poll_progress().status, ffi::JobStatus::Running);
+        assert!(!job.wait(0));
+        std::thread::spawn(move || completer.finish(Ok(true)));
+        assert!(job.take_bool().unwrap());
+
+        let (mut dropped, completer) = external_job(NucleationError::Store);
+        drop(completer);
+        assert_eq!(dropped.poll_progress().status, ffi::JobStatus::Failed);
+        assert_eq!(dropped.take_empty().unwrap_err(), NucleationError::Store);
+
+        let (mut cancelled, completer) = external_job(NucleationError::Store);
+        cancelled.cancel();
+        completer.finish(Ok(()));
+        assert_eq!(
+            cancelled.take_empty().unwrap_err(),
+            NucleationError::Cancelled
+        );
+    }
+
+    #[test]
+    fn cancelled_and_failing_jobs_report_errors() {
+        let gate = Arc::new(std::sync::Barrier::new(2));
+        let job_gate = Arc::clone(&gate);
+        let mut job = spawn_job(NucleationError::Io, move |ctx| {
+            job_gate.wait();
+            while !ctx.is_cancelled() {
+                std::thread::yield_now();
+            }
+            Err::<(), _>(NucleationError::Cancelled)
+        });
+        gate.wait();
+        job.cancel();
+        assert!(job.wait(10_000));
+        assert_eq!(job.poll_progress().status, ffi::JobStatus::Cancelled);
+        assert_eq!(
+            take_job_output::<()>(&mut job).unwrap_err(),
+            NucleationError::Cancelled
+        );
+
+        let mut panicking = spawn_job(NucleationError::Render, |_| -> Result<(), _> {
+            panic!("worker bug")
+        });
+        assert_eq!(
+            take_job_output::<()>(&mut panicking).unwrap_err(),
+            NucleationError::Render
+        );
+    }
+
+    #[test]
+    fn cancel_flag_is_the_jobs_own() {
+        let gate = Arc::new(std::sync::Barrier::new(2));
+        let job_gate = Arc::clone(&gate);
+        let job = spawn_job(NucleationError::Io, move |ctx| {
+            let flag = ctx.cancel_flag();
+            job_gate.wait();
+            while !flag.load(Ordering::Relaxed) {
+                std::thread::yield_now();
+            }
+            Ok(())
+        });
+        gate.wait();
+        job.cancel();
+        assert!(job.wait(10_000));
+        assert_eq!(job.poll_progress().status, ffi::JobStatus::Cancelled);
+    }
+}
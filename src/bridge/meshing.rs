@@ -7,8 +7,9 @@
 //!   little-endian bytes of the `f32`/`u32` array, base64-encoded.
 //! - `schematic_mesh_chunks_with_atlas_progress` (C callback) is replaced by the
 //!   polling `MeshJob` API from `stencil/docs/mesh-progress-api.md`:
-//!   `MeshJob::start` spawns a background thread, `poll_progress` reads a shared
-//!   progress slot without blocking, `take_result` joins and consumes the job.
+//!   `MeshJob::start` queues the work on the shared job pool (`jobs.rs`),
+//!   `poll_progress` reads a shared progress slot without blocking,
+//!   `take_result` waits for and consumes the job.
 //! - String lists (`StringArray` in the old ABI) are written as JSON array
 //!   strings (`_json` methods).
 //! - `chunkmeshresult_chunk_coordinates` (flat int array) becomes
@@ -25,13 +26,129 @@
 
 use diplomat_runtime::DiplomatWrite;
 
-/// Shared progress slot written by the mesh worker thread and read by
+/// Shared progress slot written by the mesh job and read by
 /// `MeshJob::poll_progress`. Phase: 0 = BuildingAtlas, 1 = MeshingChunks,
-/// 2 = Complete, 3 = Failed.
+/// 2 = Complete, 3 = Failed, 4 = Cancelled.
 pub(crate) struct MeshJobState {
     pub(crate) phase: u8,
     pub(crate) current: u32,
     pub(crate) total: u32,
+    /// Meshed chunks not yet taken by `MeshJob::take_ready`, for jobs started
+    /// with `MeshJob::start_ordered`; `None` for jobs that only return
+    /// everything from `take_result`.
+    pub(crate) ready: Option<Vec<crate::meshing::MeshOutput>>,
+}
+
+/// Mark a mesh job's progress slot as cancelled and produce its result.
+fn mesh_job_cancelled(
+    state: &std::sync::Mutex<MeshJobState>,
+) -> Result<crate::meshing::ChunkMeshResult, crate::bridge::shared::ffi::NucleationError> {
+    if let Ok(mut s) = state.lock() {
+        s.phase = 4;
+    }
+    Err(crate::bridge::shared::ffi::NucleationError::Cancelled)
+}
+
+/// Queue chunk meshing for `MeshJob::start` (`order` is `None`) and
+/// `MeshJob::start_ordered`, which also streams chunks through `take_ready`.
+fn start_mesh_job(
+    schematic: crate::UniversalSchematic,
+    pack: crate::meshing::ResourcePackSource,
+    config: crate::meshing::MeshConfig,
+    chunk_size: i32,
+    atlas: schematic_mesher::TextureAtlas,
+    order: Option<crate::meshing::MeshOrder>,
+) -> Box<ffi::MeshJob> {
+    use crate::bridge::shared::ffi::NucleationError;
+
+    let state = std::sync::Arc::new(std::sync::Mutex::new(MeshJobState {
+        phase: 0,
+        current: 0,
+        total: 0,
+        ready: order.map(|_| Vec::new()),
+    }));
+    let thread_state = state.clone();
+    let job = super::jobs::spawn_job(NucleationError::Mesh, move |ctx| {
+        let job_cancel = crate::meshing::CancelToken::from_flag(ctx.cancel_flag());
+        if job_cancel.is_cancelled() {
+            return mesh_job_cancelled(&thread_state);
+        }
+        let mut iter = match &order {
+            Some(order) => {
+                schematic.mesh_chunks_ordered(&pack, &config, chunk_size, Some(atlas), order)
+            }
+            None => schematic.mesh_chunks_with_atlas(&pack, &config, chunk_size, atlas),
+        };
+        // Dropping the unmeshed schematic copy early also frees its
+        // blocks while the chunks mesh.
+        drop(schematic);
+        if job_cancel.is_cancelled() {
+            return mesh_job_cancelled(&thread_state);
+        }
+        iter.set_cancel_token(job_cancel.clone());
+        if let Ok(mut s) = thread_state.lock() {
+            s.phase = 1;
+            s.total = iter.chunk_count() as u32;
+        }
+        let cb_state = thread_state.clone();
+        iter.set_progress_callback(Box::new(move |p: crate::meshing::MeshProgress| {
+            if let Ok(mut s) = cb_state.lock() {
+                s.phase = match p.phase {
+                    crate::meshing::MeshPhase::BuildingAtlas => 0,
+                    crate::meshing::MeshPhase::MeshingChunks => 1,
+                    crate::meshing::MeshPhase::Complete => 2,
+                };
+                s.current = p.chunks_done;
+                s.total = p.chunks_total;
+            }
+        }));
+
+        let mut meshes = std::collections::HashMap::new();
+        let mut total_vertex_count = 0;
+        let mut total_triangle_count = 0;
+        for result in iter {
+            match result {
+                Ok(mesh) => {
+                    total_vertex_count += mesh.total_vertices();
+                    total_triangle_count += mesh.total_triangles();
+                    if order.is_some() {
+                        if let Ok(mut s) = thread_state.lock() {
+                            s.ready.get_or_insert_with(Vec::new).push(mesh);
+                        }
+                    } else if let Some(coord) = mesh.chunk_coord {
+                        meshes.insert(coord, mesh);
+                    }
+                }
+                Err(crate::meshing::MeshError::Cancelled) => {
+                    return mesh_job_cancelled(&thread_state);
+                }
+                Err(_) => {
+                    if let Ok(mut s) = thread_state.lock() {
+                        s.phase = 3;
+                    }
+                    return Err(NucleationError::Mesh);
+                }
+            }
+        }
+        if let Ok(mut s) = thread_state.lock() {
+            s.phase = 2;
+            s.current = s.total;
+            // Streamed chunks nobody took yet go to `take_result`.
+            for mesh in s.ready.iter_mut().flat_map(std::mem::take) {
+                if let Some(coord) = mesh.chunk_coord {
+                    meshes.insert(coord, mesh);
+                }
+            }
+        }
+        Ok(crate::meshing::ChunkMeshResult {
+            meshes,
+            total_vertex_count,
+            total_triangle_count,
+            lods: Vec::new(),
+        })
+    });
+
+    Box::new(ffi::MeshJob { state, job })
 }
 
 /// Write `bytes` into `out` as standard base64.
@@ -61,10 +178,38 @@ pub(crate) fn f32s_to_le_bytes(floats: &[f32]) -> Vec<u8> {
     bytes
 }
 
+/// A schematic and its config queued in an `ItemModelBatch`.
+type ItemModelJob = (
+    std::sync::Arc<crate::UniversalSchematic>,
+    crate::meshing::ItemModelConfig,
+);
+
+/// Stream the pack of `ItemModelPackBuilder`'s results into `out`, failing
+/// with `write_error` if the pack cannot be written there.
+fn write_pack_zip<W: std::io::Write>(
+    items: &std::cell::RefCell<Vec<crate::meshing::ItemModelResult>>,
+    out: W,
+    write_error: crate::bridge::shared::ffi::NucleationError,
+) -> Result<(), crate::bridge::shared::ffi::NucleationError> {
+    use crate::bridge::shared::ffi::NucleationError;
+    let items = items.try_borrow().map_err(|_| NucleationError::Lock)?;
+    if items.is_empty() {
+        return Err(NucleationError::InvalidArgument);
+    }
+    let refs: Vec<&crate::meshing::ItemModelResult> = items.iter().collect();
+    crate::meshing::write_resource_pack(&refs, out)
+        .map(drop)
+        .map_err(|_| write_error)
+}
+
 #[diplomat::bridge]
 pub mod ffi {
-    use super::super::schematic::ffi::Schematic;
-    use super::super::shared::ffi::{BlockPos, Dimensions, NucleationError};
+    use super::super::jobs::ffi::Job;
+    use super::super::jobs::take_job_output;
+    use super::super::schematic::ffi::{FrozenSchematic, Schematic};
+    use super::super::shared::ffi::{BlockPos, Bytes, Dimensions, NucleationError, ResultBuffer};
+    use super::super::shared::refill;
+    use super::super::store_io::ffi::Store;
     use diplomat_runtime::DiplomatWrite;
     use std::fmt::Write;
 
@@ -113,6 +258,58 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Parse)
         }
 
+        /// Load a pack saved by [`ResourcePack::to_cache_bytes`], skipping
+        /// unzipping and PNG decoding. Fails with `Parse` if `data` is not one.
+        pub fn from_cache_bytes(data: &[u8]) -> Result<Box<ResourcePack>, NucleationError> {
+            crate::meshing::ResourcePackSource::from_cache_bytes(data)
+                .map(|p| Box::new(ResourcePack(p)))
+                .map_err(|_| NucleationError::Parse)
+        }
+
+        /// Load a ZIP pack through a directory of pack caches keyed by the
+        /// archive's content hash, so later loads of the same archive skip
+        /// normalization, unzipping and PNG decoding.
+        #[cfg(not(target_arch = "wasm32"))]
+        #[diplomat::attr(js, disable)]
+        pub fn from_file_cached(
+            path: &DiplomatStr,
+            cache_dir: &DiplomatStr,
+        ) -> Result<Box<ResourcePack>, NucleationError> {
+            let path = std::str::from_utf8(path).map_err(|_| NucleationError::InvalidArgument)?;
+            let cache_dir =
+                std::str::from_utf8(cache_dir).map_err(|_| NucleationError::InvalidArgument)?;
+            crate::meshing::ResourcePackSource::from_file_cached(
+                path,
+                std::path::Path::new(cache_dir),
+            )
+            .map(|p| Box::new(ResourcePack(p)))
+            .map_err(|_| NucleationError::Parse)
+        }
+
+        /// [`ResourcePack::from_bytes`] with its pack cache kept in `store`
+        /// under `prefix`, keyed by the archive's content hash.
+        pub fn from_bytes_cached(
+            data: &[u8],
+            store: &Store,
+            prefix: &DiplomatStr,
+        ) -> Result<Box<ResourcePack>, NucleationError> {
+            let prefix =
+                std::str::from_utf8(prefix).map_err(|_| NucleationError::InvalidArgument)?;
+            crate::meshing::ResourcePackSource::from_bytes_cached_in_store(
+                data,
+                store.0.as_ref(),
+                prefix,
+            )
+            .map(|p| Box::new(ResourcePack(p)))
+            .map_err(|_| NucleationError::Parse)
+        }
+
+        /// The parsed pack (blockstates, models, decoded RGBA textures) as a
+        /// binary cache for [`ResourcePack::from_cache_bytes`].
+        pub fn to_cache_bytes(&self) -> Box<Bytes> {
+            Box::new(Bytes(self.0.to_cache_bytes()))
+        }
+
         /// Number of blockstate definitions in the pack.
         pub fn blockstate_count(&self) -> u32 {
             self.0.stats().blockstate_count as u32
@@ -256,9 +453,7 @@ pub mod ffi {
             let exporter = crate::meshing::MeshExporter::new(
                 crate::meshing::ResourcePackSource::from_resource_pack(self.0.pack().clone()),
             );
-            let manager = crate::formats::manager::get_manager();
-            let mut manager = manager.lock().map_err(|_| NucleationError::Lock)?;
-            manager.register_exporter(exporter);
+            crate::formats::manager::update_manager(|manager| manager.register_exporter(exporter));
             Ok(())
         }
     }
@@ -370,6 +565,35 @@ pub mod ffi {
         pub fn greedy_meshing(&self) -> bool {
             self.0.greedy_meshing
         }
+
+        /// Downsampled levels of detail to mesh per chunk alongside full
+        /// detail (2×, 4×, 8× merging for levels 1–3; clamped to 3). Only
+        /// [`ChunkMeshResult::create`] and `create_with_size` produce them
+        /// (default: 0).
+        pub fn set_lod_levels(&mut self, levels: u8) {
+            self.0.lod_levels = levels.min(crate::meshing::MAX_LOD_LEVEL);
+        }
+
+        /// Number of downsampled levels of detail meshed per chunk.
+        pub fn lod_levels(&self) -> u8 {
+            self.0.lod_levels
+        }
+
+        /// Store exported vertices in the compact 20-byte form (quantized
+        /// positions, normals, UVs and colors) instead of `f32` streams. Used
+        /// by [`RawMeshExport::create`] (default: false).
+        pub fn set_compact_vertices(&mut self, val: bool) {
+            self.0.vertex_format = if val {
+                crate::meshing::VertexFormat::Compact
+            } else {
+                crate::meshing::VertexFormat::Float
+            };
+        }
+
+        /// Whether exported vertices use the compact form.
+        pub fn compact_vertices(&self) -> bool {
+            self.0.vertex_format == crate::meshing::VertexFormat::Compact
+        }
     }
 
     // ─── MeshResult ──────────────────────────────────────────────────────────
@@ -402,6 +626,20 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Mesh)
         }
 
+        /// Mesh a frozen schematic in one pass. Safe to call from several
+        /// threads on the same `FrozenSchematic` at once.
+        pub fn create_from_frozen(
+            schematic: &FrozenSchematic,
+            pack: &ResourcePack,
+            config: &MeshConfig,
+        ) -> Result<Box<MeshResult>, NucleationError> {
+            schematic
+                .0
+                .to_mesh(&pack.0, &config.0)
+                .map(|r| Box::new(MeshResult(r)))
+                .map_err(|_| NucleationError::Mesh)
+        }
+
         /// Mesh a schematic with USDZ-compatible output (old ABI: `schematic_to_usdz`).
         pub fn create_usdz(
             schematic: &Schematic,
@@ -422,6 +660,30 @@ pub mod ffi {
             Ok(())
         }
 
+        /// The mesh as a binary GLB, in an owned buffer (no base64).
+        pub fn glb_data_bytes(&self) -> Result<Box<Bytes>, NucleationError> {
+            self.0
+                .to_glb()
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
+        /// The mesh as a binary GLB, written into a reusable `ResultBuffer`.
+        pub fn glb_data_into(&self, buf: &mut ResultBuffer) -> Result<(), NucleationError> {
+            let data = self.0.to_glb().map_err(|_| NucleationError::Serialize)?;
+            refill(buf).extend_from_slice(&data);
+            Ok(())
+        }
+
+        /// The mesh as a binary GLB with compact vertex streams
+        /// (`KHR_mesh_quantization`), in an owned buffer. About 2.4× smaller
+        /// vertex data than [`MeshResult::glb_data_bytes`].
+        pub fn compact_glb_data_bytes(&self) -> Result<Box<Bytes>, NucleationError> {
+            crate::meshing::compact::to_compact_glb(&self.0)
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
         /// The mesh as a USDZ archive, base64-encoded.
         pub fn usdz_data_b64(&self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
             let data = self.0.to_usdz().map_err(|_| NucleationError::Serialize)?;
@@ -435,6 +697,15 @@ pub mod ffi {
             super::write_b64(&data, out);
         }
 
+        /// The mesh in the NUCM cache format, written into a reusable
+        /// `ResultBuffer` (no base64, no clone of the mesh).
+        pub fn nucm_data_into(&self, buf: &mut ResultBuffer) {
+            crate::meshing::cache::serialize_meshes_into(
+                refill(buf),
+                std::slice::from_ref(&self.0),
+            );
+        }
+
         /// Total number of vertices in the mesh.
         pub fn vertex_count(&self) -> u32 {
             self.0.total_vertices() as u32
@@ -581,6 +852,7 @@ pub mod ffi {
                 meshes,
                 total_vertex_count,
                 total_triangle_count,
+                lods: Vec::new(),
             })))
         }
 
@@ -611,6 +883,25 @@ pub mod ffi {
             }
         }
 
+        /// One chunk's mesh in the NUCM cache format, written into a reusable
+        /// `ResultBuffer`. Streaming chunks through one buffer avoids both the
+        /// `MeshResult` clone of `get_chunk_mesh` and a fresh allocation per chunk.
+        pub fn chunk_nucm_data_into(
+            &self,
+            cx: i32,
+            cy: i32,
+            cz: i32,
+            buf: &mut ResultBuffer,
+        ) -> Result<(), NucleationError> {
+            let mesh = self
+                .0
+                .meshes
+                .get(&(cx, cy, cz))
+                .ok_or(NucleationError::NotFound)?;
+            crate::meshing::cache::serialize_meshes_into(refill(buf), std::slice::from_ref(mesh));
+            Ok(())
+        }
+
         /// Total vertex count across all chunk meshes.
         pub fn total_vertex_count(&self) -> u32 {
             self.0.total_vertex_count as u32
@@ -621,21 +912,191 @@ pub mod ffi {
             self.0.total_triangle_count as u32
         }
 
+        /// Full-detail meshes, then levels of detail.
+        fn all_meshes(&self) -> Vec<crate::meshing::MeshOutput> {
+            self.0
+                .meshes
+                .values()
+                .chain(&self.0.lods)
+                .cloned()
+                .collect()
+        }
+
+        /// Number of downsampled chunk meshes (see [`MeshConfig::set_lod_levels`]).
+        pub fn lod_count(&self) -> u32 {
+            self.0.lods.len() as u32
+        }
+
+        /// The downsampled mesh of one chunk at `level` (cloned).
+        pub fn get_lod_mesh(
+            &self,
+            cx: i32,
+            cy: i32,
+            cz: i32,
+            level: u8,
+        ) -> Result<Box<MeshResult>, NucleationError> {
+            self.0
+                .lods
+                .iter()
+                .find(|mesh| mesh.chunk_coord == Some((cx, cy, cz)) && mesh.lod_level == level)
+                .map(|mesh| Box::new(MeshResult(mesh.clone())))
+                .ok_or(NucleationError::NotFound)
+        }
+
         /// All chunk meshes serialized in the NUCM cache format, base64-encoded.
+        /// Levels of detail follow the full-detail meshes, each tagged with its
+        /// `lod_level`.
         pub fn nucm_data_b64(&self, out: &mut DiplomatWrite) {
-            let meshes: Vec<crate::meshing::MeshOutput> = self.0.meshes.values().cloned().collect();
+            let meshes = self.all_meshes();
             let data = crate::meshing::cache::serialize_meshes(&meshes);
             super::write_b64(&data, out);
         }
 
         /// NUCM v2 with a shared atlas, base64-encoded.
         pub fn nucm_data_with_atlas_b64(&self, atlas: &TextureAtlas, out: &mut DiplomatWrite) {
-            let meshes: Vec<crate::meshing::MeshOutput> = self.0.meshes.values().cloned().collect();
+            let meshes = self.all_meshes();
             let data = crate::meshing::cache::serialize_meshes_with_atlas(&meshes, &atlas.0);
             super::write_b64(&data, out);
         }
     }
 
+    // ─── MeshSession ─────────────────────────────────────────────────────────
+
+    /// Per-chunk meshes kept up to date across edits. Wraps
+    /// [`crate::meshing::MeshSession`]: after `Schematic::set_block`,
+    /// `Schematic::fill_cuboid` or `BuildingTool::fill`, [`MeshSession::update`]
+    /// remeshes only the chunks the edits touched (and the neighbours their
+    /// culling and AO reach), instead of calling [`ChunkMeshResult::create`]
+    /// again.
+    #[diplomat::opaque_mut]
+    pub struct MeshSession {
+        pub(crate) session: crate::meshing::MeshSession,
+        /// Chunks the last `update` or `remesh_all` changed, sorted.
+        pub(crate) changed: Vec<(i32, i32, i32)>,
+    }
+
+    impl MeshSession {
+        /// Mesh all of `schematic` against a shared atlas and start tracking
+        /// its edits. Fails with `Mesh` if `chunk_size` is not positive.
+        pub fn create(
+            schematic: &mut Schematic,
+            pack: &ResourcePack,
+            config: &MeshConfig,
+            chunk_size: i32,
+        ) -> Result<Box<MeshSession>, NucleationError> {
+            let session =
+                crate::meshing::MeshSession::new(&mut schematic.0, &pack.0, &config.0, chunk_size)
+                    .map_err(|_| NucleationError::Mesh)?;
+            let changed = {
+                let mut coords: Vec<_> = session.meshes().keys().copied().collect();
+                coords.sort_unstable();
+                coords
+            };
+            Ok(Box::new(MeshSession { session, changed }))
+        }
+
+        /// [`MeshSession::create`] against a prebuilt atlas (cloned), which
+        /// the session extends instead of rebuilding.
+        pub fn create_with_atlas(
+            schematic: &mut Schematic,
+            pack: &ResourcePack,
+            atlas: &PackAtlas,
+            chunk_size: i32,
+        ) -> Result<Box<MeshSession>, NucleationError> {
+            let session = crate::meshing::MeshSession::with_atlas(
+                &mut schematic.0,
+                &pack.0,
+                atlas.0.clone(),
+                chunk_size,
+            )
+            .map_err(|_| NucleationError::Mesh)?;
+            let changed = {
+                let mut coords: Vec<_> = session.meshes().keys().copied().collect();
+                coords.sort_unstable();
+                coords
+            };
+            Ok(Box::new(MeshSession { session, changed }))
+        }
+
+        /// Remesh the chunks edited since the last call and return how many
+        /// changed; read them with [`MeshSession::changed_chunk_at`]. Edits
+        /// that bring in a new texture or resize a region remesh everything.
+        pub fn update(
+            &mut self,
+            schematic: &mut Schematic,
+            pack: &ResourcePack,
+        ) -> Result<u32, NucleationError> {
+            self.changed = self
+                .session
+                .update(&mut schematic.0, &pack.0)
+                .map_err(|_| NucleationError::Mesh)?;
+            Ok(self.changed.len() as u32)
+        }
+
+        /// Extend the atlas and remesh every chunk, e.g. after entity edits,
+        /// which `update` does not track. Returns how many chunks changed.
+        pub fn remesh_all(
+            &mut self,
+            schematic: &mut Schematic,
+            pack: &ResourcePack,
+        ) -> Result<u32, NucleationError> {
+            self.changed = self
+                .session
+                .remesh_all(&mut schematic.0, &pack.0)
+                .map_err(|_| NucleationError::Mesh)?;
+            Ok(self.changed.len() as u32)
+        }
+
+        /// The `index`-th chunk changed by the last `update` or `remesh_all`.
+        /// A changed chunk with no mesh ([`MeshSession::get_mesh`] returns
+        /// `NotFound`) became empty and should be dropped by the caller.
+        pub fn changed_chunk_at(&self, index: u32) -> Result<BlockPos, NucleationError> {
+            match self.changed.get(index as usize) {
+                Some(&(x, y, z)) => Ok(BlockPos { x, y, z }),
+                None => Err(NucleationError::NotFound),
+            }
+        }
+
+        /// Number of chunks changed by the last `update` or `remesh_all`.
+        pub fn changed_count(&self) -> u32 {
+            self.changed.len() as u32
+        }
+
+        /// Number of non-empty chunk meshes.
+        pub fn chunk_count(&self) -> u32 {
+            self.session.meshes().len() as u32
+        }
+
+        /// The current mesh for one chunk coordinate (cloned).
+        pub fn get_mesh(
+            &self,
+            cx: i32,
+            cy: i32,
+            cz: i32,
+        ) -> Result<Box<MeshResult>, NucleationError> {
+            match self.session.meshes().get(&(cx, cy, cz)) {
+                Some(mesh) => Ok(Box::new(MeshResult(mesh.clone()))),
+                None => Err(NucleationError::NotFound),
+            }
+        }
+
+        /// The shared atlas every chunk mesh samples (cloned).
+        pub fn atlas(&self) -> Box<TextureAtlas> {
+            Box::new(TextureAtlas(self.session.atlas().clone()))
+        }
+
+        /// The session's atlas with the states it covers (cloned), to save
+        /// for the next session.
+        pub fn pack_atlas(&self) -> Box<PackAtlas> {
+            Box::new(PackAtlas(self.session.pack_atlas().clone()))
+        }
+
+        /// A snapshot of every current chunk mesh.
+        pub fn to_chunk_mesh_result(&self) -> Box<ChunkMeshResult> {
+            Box::new(ChunkMeshResult(self.session.to_chunk_mesh_result()))
+        }
+    }
+
     // ─── RawMeshExport ───────────────────────────────────────────────────────
 
     /// Raw vertex streams for custom rendering. Wraps [`crate::meshing::RawMeshExport`].
@@ -668,22 +1129,22 @@ pub mod ffi {
 
         /// Flat `[x,y,z,...]` positions as little-endian `f32` bytes, base64-encoded.
         pub fn positions_b64(&self, out: &mut DiplomatWrite) {
-            super::write_b64(&super::f32s_to_le_bytes(&self.0.positions_flat()), out);
+            super::write_b64(&super::f32s_to_le_bytes(self.0.positions()), out);
         }
 
         /// Flat normals as little-endian `f32` bytes, base64-encoded.
         pub fn normals_b64(&self, out: &mut DiplomatWrite) {
-            super::write_b64(&super::f32s_to_le_bytes(&self.0.normals_flat()), out);
+            super::write_b64(&super::f32s_to_le_bytes(self.0.normals()), out);
         }
 
         /// Flat UVs as little-endian `f32` bytes, base64-encoded.
         pub fn uvs_b64(&self, out: &mut DiplomatWrite) {
-            super::write_b64(&super::f32s_to_le_bytes(&self.0.uvs_flat()), out);
+            super::write_b64(&super::f32s_to_le_bytes(self.0.uvs()), out);
         }
 
         /// Flat vertex colors as little-endian `f32` bytes, base64-encoded.
         pub fn colors_b64(&self, out: &mut DiplomatWrite) {
-            super::write_b64(&super::f32s_to_le_bytes(&self.0.colors_flat()), out);
+            super::write_b64(&super::f32s_to_le_bytes(self.0.colors()), out);
         }
 
         /// Triangle indices as little-endian `u32` bytes, base64-encoded.
@@ -700,6 +1161,40 @@ pub mod ffi {
             super::write_b64(self.0.texture_rgba(), out);
         }
 
+        // Borrowed views of the same streams, valid for the lifetime of this
+        // handle: C/C++ callers can memcpy or map them straight into a GPU
+        // buffer without the base64 round trip.
+
+        /// Flat `[x,y,z,...]` vertex positions.
+        pub fn positions<'a>(&'a self) -> &'a [f32] {
+            self.0.positions()
+        }
+
+        /// Flat `[x,y,z,...]` vertex normals.
+        pub fn normals<'a>(&'a self) -> &'a [f32] {
+            self.0.normals()
+        }
+
+        /// Flat `[u,v,...]` texture coordinates.
+        pub fn uvs<'a>(&'a self) -> &'a [f32] {
+            self.0.uvs()
+        }
+
+        /// Flat `[r,g,b,a,...]` vertex colors.
+        pub fn colors<'a>(&'a self) -> &'a [f32] {
+            self.0.colors()
+        }
+
+        /// Triangle indices.
+        pub fn indices<'a>(&'a self) -> &'a [u32] {
+            self.0.indices()
+        }
+
+        /// Raw RGBA texture pixels (`texture_width * texture_height * 4` bytes).
+        pub fn texture_rgba<'a>(&'a self) -> &'a [u8] {
+            self.0.texture_rgba()
+        }
+
         /// Width of the baked texture in pixels.
         pub fn texture_width(&self) -> u32 {
             self.0.texture_width()
@@ -709,6 +1204,65 @@ pub mod ffi {
         pub fn texture_height(&self) -> u32 {
             self.0.texture_height()
         }
+
+        // Compact streams, present when exported with
+        // `MeshConfig::set_compact_vertices(true)` and empty otherwise.
+
+        /// Whether the compact streams were exported.
+        pub fn has_compact(&self) -> bool {
+            self.0.compact().is_some()
+        }
+
+        /// Compact positions, `[x,y,z,0,...]` fixed point: world position is
+        /// `origin + value / steps_per_block`, from
+        /// [`RawMeshExport::compact_quantization`].
+        pub fn compact_positions<'a>(&'a self) -> &'a [u16] {
+            self.0
+                .compact()
+                .map_or(&[][..], |(_, layer)| bytemuck::cast_slice(&layer.positions))
+        }
+
+        /// Compact normals, `[x,y,z,0,...]` signed-normalized (`/127`).
+        pub fn compact_normals<'a>(&'a self) -> &'a [i8] {
+            self.0
+                .compact()
+                .map_or(&[][..], |(_, layer)| bytemuck::cast_slice(&layer.normals))
+        }
+
+        /// Compact UVs, `[u,v,...]` unsigned-normalized (`/65535`).
+        pub fn compact_uvs<'a>(&'a self) -> &'a [u16] {
+            self.0
+                .compact()
+                .map_or(&[][..], |(_, layer)| bytemuck::cast_slice(&layer.uvs))
+        }
+
+        /// Compact colors, `[r,g,b,a,...]` unsigned-normalized (`/255`).
+        pub fn compact_colors<'a>(&'a self) -> &'a [u8] {
+            self.0
+                .compact()
+                .map_or(&[][..], |(_, layer)| bytemuck::cast_slice(&layer.colors))
+        }
+
+        /// How compact positions map back to world space. All zero without
+        /// compact streams.
+        pub fn compact_quantization(&self) -> CompactQuantization {
+            let q = self.0.compact().map(|(q, _)| *q);
+            let origin = q.map_or([0.0; 3], |q| q.origin);
+            CompactQuantization {
+                origin_x: origin[0],
+                origin_y: origin[1],
+                origin_z: origin[2],
+                steps_per_block: q.map_or(0.0, |q| q.steps_per_block),
+            }
+        }
+    }
+
+    /// World position of a compact position `p`: `origin + p / steps_per_block`.
+    pub struct CompactQuantization {
+        pub origin_x: f32,
+        pub origin_y: f32,
+        pub origin_z: f32,
+        pub steps_per_block: f32,
     }
 
     // ─── TextureAtlas ────────────────────────────────────────────────────────
@@ -744,6 +1298,68 @@ pub mod ffi {
         pub fn rgba_data_b64(&self, out: &mut DiplomatWrite) {
             super::write_b64(&self.0.pixels, out);
         }
+
+        /// Raw RGBA atlas pixels (`width * height * 4` bytes), borrowed for the
+        /// lifetime of this handle.
+        pub fn rgba_data<'a>(&'a self) -> &'a [u8] {
+            &self.0.pixels
+        }
+    }
+
+    /// An atlas for a whole resource pack, extended as new block states
+    /// appear and saved between runs. Wraps [`crate::meshing::PackAtlas`].
+    #[diplomat::opaque_mut]
+    pub struct PackAtlas(pub(crate) crate::meshing::PackAtlas);
+
+    impl PackAtlas {
+        /// Build the atlas for every blockstate in the pack, keyed by the
+        /// pack's content fingerprint.
+        pub fn build(
+            pack: &ResourcePack,
+            config: &MeshConfig,
+        ) -> Result<Box<PackAtlas>, NucleationError> {
+            crate::meshing::PackAtlas::build(&pack.0, &config.0, pack.0.fingerprint())
+                .map(|a| Box::new(PackAtlas(a)))
+                .map_err(|_| NucleationError::Mesh)
+        }
+
+        /// Read a blob from [`PackAtlas::to_bytes`]. Fails with `Parse` if it
+        /// is not one.
+        pub fn from_bytes(
+            data: &[u8],
+            config: &MeshConfig,
+        ) -> Result<Box<PackAtlas>, NucleationError> {
+            crate::meshing::PackAtlas::from_bytes(data, &config.0)
+                .map(|a| Box::new(PackAtlas(a)))
+                .map_err(|_| NucleationError::Parse)
+        }
+
+        /// Cover every block state of `schematic`. Returns whether the atlas
+        /// was repacked, which invalidates meshes made against it.
+        pub fn extend_for(
+            &mut self,
+            schematic: &Schematic,
+            pack: &ResourcePack,
+        ) -> Result<bool, NucleationError> {
+            self.0
+                .extend_for_schematic(&schematic.0, &pack.0)
+                .map_err(|_| NucleationError::Mesh)
+        }
+
+        /// Whether the atlas was built for `pack`'s current content.
+        pub fn matches_pack(&self, pack: &ResourcePack) -> bool {
+            self.0.pack_id() == pack.0.fingerprint()
+        }
+
+        /// The packed atlas (cloned).
+        pub fn atlas(&self) -> Box<TextureAtlas> {
+            Box::new(TextureAtlas(self.0.atlas().clone()))
+        }
+
+        /// The atlas and the states it covers as a blob.
+        pub fn to_bytes(&self) -> Box<Bytes> {
+            Box::new(Bytes(self.0.to_bytes()))
+        }
     }
 
     // ─── MeshJob: polling replacement for the progress callback ─────────────
@@ -759,6 +1375,8 @@ pub mod ffi {
         Complete,
         /// The job failed; `take_result` returns the error.
         Failed,
+        /// `MeshJob::cancel` stopped the job; `take_result` returns `Cancelled`.
+        Cancelled,
     }
 
     /// Snapshot of a [`MeshJob`]'s progress.
@@ -770,7 +1388,20 @@ pub mod ffi {
         pub total: u32,
     }
 
-    /// A chunk-meshing job running on a background thread. Replaces the old
+    /// Camera for [`MeshJob::start_ordered`]: a position, and a view
+    /// direction (all zero for none) with the half field of view around it.
+    pub struct MeshCamera {
+        pub x: f32,
+        pub y: f32,
+        pub z: f32,
+        pub view_x: f32,
+        pub view_y: f32,
+        pub view_z: f32,
+        pub half_fov_degrees: f32,
+    }
+
+    /// A chunk-meshing job running on the shared job pool (see
+    /// [`Job`](super::super::jobs::ffi::Job)). Replaces the old
     /// `schematic_mesh_chunks_with_atlas_progress` C callback: poll it from a
     /// timer loop with [`MeshJob::poll_progress`], then call
     /// [`MeshJob::take_result`] once (it blocks until the job finishes and
@@ -778,13 +1409,12 @@ pub mod ffi {
     #[diplomat::opaque_mut]
     pub struct MeshJob {
         pub(crate) state: std::sync::Arc<std::sync::Mutex<super::MeshJobState>>,
-        pub(crate) handle:
-            Option<std::thread::JoinHandle<Result<crate::meshing::ChunkMeshResult, String>>>,
+        pub(crate) job: Box<Job>,
     }
 
     impl MeshJob {
-        /// Kick off chunk meshing with a shared atlas on a background thread
-        /// and return immediately. Takes the same parameters as
+        /// Queue chunk meshing with a shared atlas on the job pool and return
+        /// immediately. Takes the same parameters as
         /// [`ChunkMeshResult::create_with_atlas`].
         pub fn start(
             schematic: &Schematic,
@@ -793,73 +1423,74 @@ pub mod ffi {
             chunk_size: i32,
             atlas: &TextureAtlas,
         ) -> Box<MeshJob> {
-            let schematic = schematic.0.clone();
-            let pack =
-                crate::meshing::ResourcePackSource::from_resource_pack(pack.0.pack().clone());
-            let config = config.0.clone();
-            let atlas = atlas.0.clone();
-
-            let state = std::sync::Arc::new(std::sync::Mutex::new(super::MeshJobState {
-                phase: 0,
-                current: 0,
-                total: 0,
-            }));
-            let thread_state = state.clone();
-
-            let handle = std::thread::spawn(move || {
-                let mut iter = schematic.mesh_chunks_with_atlas(&pack, &config, chunk_size, atlas);
-                if let Ok(mut s) = thread_state.lock() {
-                    s.phase = 1;
-                    s.total = iter.chunk_count() as u32;
-                }
-                let cb_state = thread_state.clone();
-                iter.set_progress_callback(Box::new(move |p: crate::meshing::MeshProgress| {
-                    if let Ok(mut s) = cb_state.lock() {
-                        s.phase = match p.phase {
-                            crate::meshing::MeshPhase::BuildingAtlas => 0,
-                            crate::meshing::MeshPhase::MeshingChunks => 1,
-                            crate::meshing::MeshPhase::Complete => 2,
-                        };
-                        s.current = p.chunks_done;
-                        s.total = p.chunks_total;
-                    }
-                }));
-
-                let mut meshes = std::collections::HashMap::new();
-                let mut total_vertex_count = 0;
-                let mut total_triangle_count = 0;
-                for result in iter {
-                    match result {
-                        Ok(mesh) => {
-                            total_vertex_count += mesh.total_vertices();
-                            total_triangle_count += mesh.total_triangles();
-                            if let Some(coord) = mesh.chunk_coord {
-                                meshes.insert(coord, mesh);
-                            }
-                        }
-                        Err(e) => {
-                            if let Ok(mut s) = thread_state.lock() {
-                                s.phase = 3;
-                            }
-                            return Err(e.to_string());
-                        }
-                    }
-                }
-                if let Ok(mut s) = thread_state.lock() {
-                    s.phase = 2;
-                    s.current = s.total;
+            super::start_mesh_job(
+                schematic.0.clone(),
+                crate::meshing::ResourcePackSource::from_resource_pack(pack.0.pack().clone()),
+                config.0.clone(),
+                chunk_size,
+                atlas.0.clone(),
+                None,
+            )
+        }
+
+        /// [`MeshJob::start`] meshing chunks in `strategy` order (the names of
+        /// `Schematic::get_chunks_with_strategy_json`), so `distance_to_camera`
+        /// meshes front to back. A non-zero view direction meshes the chunks
+        /// within `half_fov_degrees` of it first. `skip_occluded` drops chunks
+        /// walled in by opaque full blocks on every side, unless the camera is
+        /// in them. Collect chunks as they finish with
+        /// [`MeshJob::take_ready`]; `take_result` returns the rest.
+        #[allow(clippy::too_many_arguments)]
+        pub fn start_ordered(
+            schematic: &Schematic,
+            pack: &ResourcePack,
+            config: &MeshConfig,
+            chunk_size: i32,
+            atlas: &TextureAtlas,
+            strategy: &DiplomatStr,
+            camera: &MeshCamera,
+            skip_occluded: bool,
+        ) -> Result<Box<MeshJob>, NucleationError> {
+            let strategy = std::str::from_utf8(strategy).map_err(|_| NucleationError::Parse)?;
+            let eye = (camera.x, camera.y, camera.z);
+            let forward = [camera.view_x, camera.view_y, camera.view_z];
+            let order = crate::meshing::MeshOrder {
+                strategy: super::super::schematic::parse_strategy(strategy, eye),
+                view: (forward != [0.0; 3])
+                    .then(|| (forward, camera.half_fov_degrees.to_radians())),
+                skip_occluded,
+            };
+            Ok(super::start_mesh_job(
+                schematic.0.clone(),
+                crate::meshing::ResourcePackSource::from_resource_pack(pack.0.pack().clone()),
+                config.0.clone(),
+                chunk_size,
+                atlas.0.clone(),
+                Some(order),
+            ))
+        }
+
+        /// The chunks meshed since the last call, without waiting. Always
+        /// empty for jobs from [`MeshJob::start`].
+        pub fn take_ready(&self) -> Box<ChunkMeshResult> {
+            let ready = match self.state.lock() {
+                Ok(mut s) => s.ready.as_mut().map(std::mem::take).unwrap_or_default(),
+                Err(_) => Vec::new(),
+            };
+            let mut result = crate::meshing::ChunkMeshResult {
+                meshes: std::collections::HashMap::new(),
+                total_vertex_count: 0,
+                total_triangle_count: 0,
+                lods: Vec::new(),
+            };
+            for mesh in ready {
+                result.total_vertex_count += mesh.total_vertices();
+                result.total_triangle_count += mesh.total_triangles();
+                if let Some(coord) = mesh.chunk_coord {
+                    result.meshes.insert(coord, mesh);
                 }
-                Ok(crate::meshing::ChunkMeshResult {
-                    meshes,
-                    total_vertex_count,
-                    total_triangle_count,
-                })
-            });
-
-            Box::new(MeshJob {
-                state,
-                handle: Some(handle),
-            })
+            }
+            Box::new(ChunkMeshResult(result))
         }
 
         /// Cheap, non-blocking progress snapshot. Call from a timer/poll loop.
@@ -870,6 +1501,7 @@ pub mod ffi {
                         0 => MeshPhase::BuildingAtlas,
                         1 => MeshPhase::MeshingChunks,
                         2 => MeshPhase::Complete,
+                        4 => MeshPhase::Cancelled,
                         _ => MeshPhase::Failed,
                     },
                     current: s.current,
@@ -883,14 +1515,19 @@ pub mod ffi {
             }
         }
 
+        /// Stop the job. It is checked between phases and before each chunk,
+        /// so the worker returns to the pool after at most the chunk in
+        /// flight, and the chunks meshed so far are freed. The phase becomes
+        /// `Cancelled` and `take_result` returns `Cancelled`.
+        pub fn cancel(&self) {
+            self.job.cancel();
+        }
+
         /// Block until the job finishes (if it hasn't already) and return the
         /// result. Consumes the job: a second call returns `AlreadyConsumed`.
         pub fn take_result(&mut self) -> Result<Box<ChunkMeshResult>, NucleationError> {
-            let handle = self.handle.take().ok_or(NucleationError::AlreadyConsumed)?;
-            let result = handle.join().map_err(|_| NucleationError::Mesh)?;
-            result
+            take_job_output::<crate::meshing::ChunkMeshResult>(&mut self.job)
                 .map(|r| Box::new(ChunkMeshResult(r)))
-                .map_err(|_| NucleationError::Mesh)
         }
     }
 
@@ -1089,5 +1726,69 @@ pub mod ffi {
             super::write_b64(&data, out);
             Ok(())
         }
+
+        /// Generate the item model of every schematic in `batch` against
+        /// `pack`, in parallel, and add them in batch order. Adds nothing and
+        /// errors with `Mesh` if any schematic fails. Returns the number
+        /// added.
+        pub fn add_batch(
+            &self,
+            batch: &ItemModelBatch,
+            pack: &ResourcePack,
+        ) -> Result<u32, NucleationError> {
+            let jobs: Vec<(&crate::UniversalSchematic, &crate::meshing::ItemModelConfig)> = batch
+                .0
+                .iter()
+                .map(|(schematic, config)| (schematic.as_ref(), config))
+                .collect();
+            let results = crate::meshing::to_item_models(&pack.0, &jobs)
+                .into_iter()
+                .collect::<Result<Vec<_>, _>>()
+                .map_err(|_| NucleationError::Mesh)?;
+            let added = results.len() as u32;
+            self.0
+                .try_borrow_mut()
+                .map_err(|_| NucleationError::Lock)?
+                .extend(results);
+            Ok(added)
+        }
+
+        /// Stream the resource pack ZIP to a file instead of building it in
+        /// memory. Not available in JS: the WASM build has no filesystem.
+        #[cfg(not(target_arch = "wasm32"))]
+        #[diplomat::attr(js, disable)]
+        pub fn write_zip_file(&self, path: &DiplomatStr) -> Result<(), NucleationError> {
+            let path = std::str::from_utf8(path).map_err(|_| NucleationError::InvalidArgument)?;
+            let file = std::fs::File::create(path).map_err(|_| NucleationError::Io)?;
+            super::write_pack_zip(&self.0, std::io::BufWriter::new(file), NucleationError::Io)
+        }
+
+        /// Stream the resource pack ZIP to `key` in `store`.
+        pub fn save_zip(&self, store: &Store, key: &DiplomatStr) -> Result<(), NucleationError> {
+            let key = std::str::from_utf8(key).map_err(|_| NucleationError::InvalidArgument)?;
+            let writer = store.0.writer(key).map_err(|_| NucleationError::Store)?;
+            super::write_pack_zip(&self.0, writer, NucleationError::Store)
+        }
+    }
+
+    /// Schematics and their configs queued for
+    /// [`ItemModelPackBuilder::add_batch`]. Frozen schematics are shared, not
+    /// copied.
+    #[diplomat::opaque_mut]
+    pub struct ItemModelBatch(pub(crate) Vec<super::ItemModelJob>);
+
+    impl ItemModelBatch {
+        pub fn create() -> Box<ItemModelBatch> {
+            Box::new(ItemModelBatch(Vec::new()))
+        }
+
+        /// Queue `schematic` with a copy of `config`.
+        pub fn push(&mut self, schematic: &FrozenSchematic, config: &ItemModelConfig) {
+            self.0.push((schematic.0.clone(), config.0.clone()));
+        }
+
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
     }
 }
@@ -18,6 +18,7 @@ pub mod definition_region;
 pub mod diff;
 pub mod distance_field;
 pub mod geo;
+pub mod jobs;
 #[cfg(feature = "meshing")]
 pub mod meshing;
 pub mod nbt;
@@ -31,6 +32,7 @@ pub mod sdf;
 #[cfg(feature = "simulation")]
 pub mod simulation;
 pub mod store_io;
+pub mod telemetry;
 #[cfg(feature = "voxelize")]
 pub mod voxelize;
 #[cfg(all(feature = "bridge", feature = "world-segment"))]
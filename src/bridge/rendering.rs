@@ -14,13 +14,32 @@
 
 #[diplomat::bridge]
 pub mod ffi {
-    use super::super::meshing::ffi::ResourcePack;
-    use super::super::schematic::ffi::Schematic;
-    use super::super::shared::ffi::NucleationError;
+    use super::super::jobs::ffi::Job;
+    use super::super::jobs::{external_job, spawn_job};
+    use super::super::meshing::ffi::{MeshConfig, ResourcePack};
+    use super::super::schematic::ffi::{FrozenSchematic, Schematic};
+    use super::super::shared::ffi::{Bytes, NucleationError};
     use base64::Engine;
     use diplomat_runtime::DiplomatWrite;
     use std::fmt::Write;
 
+    /// zlib effort for PNG output. Mirrors [`crate::rendering::PngCompression`].
+    pub enum PngCompression {
+        Default,
+        Fast,
+        Best,
+    }
+
+    /// PNG row filter. Mirrors [`crate::rendering::PngFilter`].
+    pub enum PngFilter {
+        NoFilter,
+        Sub,
+        Up,
+        Avg,
+        Paeth,
+        Adaptive,
+    }
+
     /// Camera / output configuration for rendering.
     #[diplomat::opaque_mut]
     pub struct RenderConfig(pub(crate) crate::rendering::RenderConfig);
@@ -95,6 +114,34 @@ pub mod ffi {
             self.0.background = Some([r, g, b, a]);
         }
 
+        /// Encode image output as PNG with the given compression effort and
+        /// row filter. Default: `Default` compression, `Adaptive` filter.
+        pub fn set_png_options(&mut self, compression: PngCompression, filter: PngFilter) {
+            use crate::rendering::{PngCompression as C, PngFilter as F};
+            self.0.format = crate::rendering::ImageFormat::Png {
+                compression: match compression {
+                    PngCompression::Default => C::Default,
+                    PngCompression::Fast => C::Fast,
+                    PngCompression::Best => C::Best,
+                },
+                filter: match filter {
+                    PngFilter::NoFilter => F::NoFilter,
+                    PngFilter::Sub => F::Sub,
+                    PngFilter::Up => F::Up,
+                    PngFilter::Avg => F::Avg,
+                    PngFilter::Paeth => F::Paeth,
+                    PngFilter::Adaptive => F::Adaptive,
+                },
+            };
+        }
+
+        /// Encode image output as QOI instead of PNG: lossless and much
+        /// faster to encode, somewhat larger. Applies to every entry point
+        /// that returns encoded image bytes, despite their `png` names.
+        pub fn set_qoi_output(&mut self) {
+            self.0.format = crate::rendering::ImageFormat::Qoi;
+        }
+
         /// Clear the custom background — revert to default sky / HDRI.
         pub fn clear_background(&mut self) {
             self.0.background = None;
@@ -173,6 +220,214 @@ pub mod ffi {
         }
     }
 
+    /// A schematic meshed once and uploaded to a GPU renderer that stays
+    /// alive between renders. Wraps [`crate::rendering::RenderSession`]: each
+    /// [`RenderSession::render_view`] reuses the device, pipelines and
+    /// geometry, so many cameras per schematic cost one frame each.
+    #[diplomat::opaque_mut]
+    pub struct RenderSession(pub(crate) crate::rendering::RenderSession);
+
+    impl RenderSession {
+        /// Mesh `schematic` with `pack` and `mesh_config` and upload it. The
+        /// first view's size is taken from `config`; others resize in place.
+        pub fn create(
+            schematic: &Schematic,
+            pack: &ResourcePack,
+            mesh_config: &MeshConfig,
+            config: &RenderConfig,
+        ) -> Result<Box<RenderSession>, NucleationError> {
+            crate::rendering::RenderSession::for_schematic(
+                &schematic.0,
+                &pack.0,
+                &mesh_config.0,
+                config.0.width,
+                config.0.height,
+            )
+            .map(|s| Box::new(RenderSession(s)))
+            .map_err(|_| NucleationError::Render)
+        }
+
+        /// Render one view to PNG bytes.
+        pub fn render_view(
+            &mut self,
+            config: &RenderConfig,
+        ) -> Result<Box<Bytes>, NucleationError> {
+            self.0
+                .render_png(&config.0)
+                .map(|png| Box::new(Bytes(png)))
+                .map_err(|_| NucleationError::Render)
+        }
+
+        /// Render every view in `views` in one GPU submission and return
+        /// their PNGs, in order. All views must have the same size.
+        pub fn render_views(
+            &mut self,
+            views: &RenderViewList,
+        ) -> Result<Box<RenderedImages>, NucleationError> {
+            self.0
+                .render_views_png(&views.0)
+                .map(|pngs| Box::new(RenderedImages(pngs)))
+                .map_err(|_| NucleationError::Render)
+        }
+
+        /// Render one view to raw RGBA pixels (`width * height * 4` bytes).
+        pub fn render_view_pixels(
+            &mut self,
+            config: &RenderConfig,
+        ) -> Result<Box<Bytes>, NucleationError> {
+            self.0
+                .render(&config.0)
+                .map(|pixels| Box::new(Bytes(pixels)))
+                .map_err(|_| NucleationError::Render)
+        }
+    }
+
+    /// Camera configs collected for [`RenderSession::render_views`].
+    #[diplomat::opaque_mut]
+    pub struct RenderViewList(pub(crate) Vec<crate::rendering::RenderConfig>);
+
+    impl RenderViewList {
+        /// Create an empty view list.
+        pub fn create() -> Box<RenderViewList> {
+            Box::new(RenderViewList(Vec::new()))
+        }
+
+        /// Append a copy of `config`.
+        pub fn add(&mut self, config: &RenderConfig) {
+            self.0.push(config.0.clone());
+        }
+
+        /// Number of views added so far.
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+    }
+
+    /// Images from [`RenderSession::render_views`], in view order.
+    #[diplomat::opaque]
+    pub struct RenderedImages(pub(crate) Vec<Vec<u8>>);
+
+    impl RenderedImages {
+        /// Number of images.
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+
+        /// The `index`-th image (copied); `NotFound` past the end.
+        pub fn get(&self, index: u32) -> Result<Box<Bytes>, NucleationError> {
+            match self.0.get(index as usize) {
+                Some(image) => Ok(Box::new(Bytes(image.clone()))),
+                None => Err(NucleationError::NotFound),
+            }
+        }
+    }
+
+    /// Counters of a [`RenderPool`]. Times are in milliseconds.
+    pub struct RenderPoolStats {
+        pub contexts: u32,
+        /// Requests waiting for a GPU context.
+        pub queued: u32,
+        /// Requests running on a context now.
+        pub running: u32,
+        pub completed: u64,
+        pub failed: u64,
+        pub mean_queue_wait_ms: f64,
+        pub max_queue_wait_ms: f64,
+        pub mean_render_ms: f64,
+    }
+
+    /// A fixed set of GPU contexts shared by renders started from any number
+    /// of threads. Wraps [`crate::rendering::RenderPool`]: requests queue on
+    /// the pool instead of each opening its own device.
+    #[diplomat::opaque]
+    pub struct RenderPool(pub(crate) crate::rendering::RenderPool);
+
+    impl RenderPool {
+        /// Open `contexts` GPU devices (at least one), each with a worker.
+        pub fn create(contexts: u32) -> Result<Box<RenderPool>, NucleationError> {
+            crate::rendering::RenderPool::new(contexts as usize)
+                .map(|pool| Box::new(RenderPool(pool)))
+                .map_err(|_| NucleationError::Render)
+        }
+
+        /// Render a frozen schematic as a background job: it is meshed on the
+        /// shared CPU pool, then rendered on the next free GPU context and
+        /// encoded in `config`'s format. Take the bytes with `Job::take_bytes`.
+        pub fn start_render(
+            &self,
+            schematic: &FrozenSchematic,
+            pack: &ResourcePack,
+            mesh_config: &MeshConfig,
+            config: &RenderConfig,
+        ) -> Box<Job> {
+            let (job, completer) = external_job(NucleationError::Render);
+            let pool = self.0.clone();
+            let schematic = std::sync::Arc::clone(&schematic.0);
+            let pack =
+                crate::meshing::ResourcePackSource::from_resource_pack(pack.0.pack().clone());
+            let mesh_config = mesh_config.0.clone();
+            let config = config.0.clone();
+            rayon::spawn(move || {
+                let threads = rayon::current_num_threads();
+                let meshes = match schematic.mesh_chunks_parallel(&pack, &mesh_config, 64, threads)
+                {
+                    Ok(meshes) => meshes,
+                    Err(_) => return completer.finish::<Vec<u8>>(Err(NucleationError::Mesh)),
+                };
+                pool.submit_with(
+                    move |context| {
+                        let pixels = context.render(&meshes, &config, None)?;
+                        crate::rendering::encode_image(
+                            &pixels,
+                            config.width,
+                            config.height,
+                            config.format,
+                        )
+                    },
+                    move |result| completer.finish(result.map_err(|_| NucleationError::Render)),
+                );
+            });
+            job
+        }
+
+        /// Queue depth, throughput and latency counters.
+        pub fn stats(&self) -> RenderPoolStats {
+            let stats = self.0.stats();
+            let ms = |d: std::time::Duration| d.as_secs_f64() * 1000.0;
+            RenderPoolStats {
+                contexts: stats.contexts as u32,
+                queued: stats.queued as u32,
+                running: stats.running as u32,
+                completed: stats.completed,
+                failed: stats.failed,
+                mean_queue_wait_ms: ms(stats.mean_queue_wait),
+                max_queue_wait_ms: ms(stats.max_queue_wait),
+                mean_render_ms: ms(stats.mean_render_time),
+            }
+        }
+    }
+
+    /// An image with the [`crate::rendering::RenderStats`] of the render
+    /// that produced it.
+    #[diplomat::opaque]
+    pub struct ProfiledRender {
+        image: Vec<u8>,
+        stats: crate::rendering::RenderStats,
+    }
+
+    impl ProfiledRender {
+        /// The image bytes (copied), in the config's image format.
+        pub fn image(&self) -> Box<Bytes> {
+            Box::new(Bytes(self.image.clone()))
+        }
+
+        /// Per-phase timings (milliseconds), bytes uploaded and read back,
+        /// draw calls and triangles, as a JSON object.
+        pub fn stats_json(&self, out: &mut DiplomatWrite) {
+            let _ = write!(out, "{}", self.stats.to_json());
+        }
+    }
+
     /// Namespace type for the render entry points (PORTING rule 12).
     #[diplomat::opaque]
     pub struct Renderer;
@@ -239,6 +494,26 @@ pub mod ffi {
             Ok(())
         }
 
+        /// `render_png_b64_with_pack` on a frozen schematic as a background
+        /// job. Take the raw PNG bytes with `Job::take_bytes`.
+        pub fn start_render_png(
+            schematic: &FrozenSchematic,
+            pack: &ResourcePack,
+            config: &RenderConfig,
+        ) -> Box<Job> {
+            let schematic = std::sync::Arc::clone(&schematic.0);
+            let pack =
+                crate::meshing::ResourcePackSource::from_resource_pack(pack.0.pack().clone());
+            let config = config.0.clone();
+            spawn_job(NucleationError::Render, move |_| {
+                let mesh = schematic
+                    .to_mesh(&pack, &crate::meshing::MeshConfig::default())
+                    .map_err(|_| NucleationError::Mesh)?;
+                crate::rendering::render_meshes_png(&[mesh], &config, None)
+                    .map_err(|_| NucleationError::Render)
+            })
+        }
+
         /// Render a schematic to a PNG file at `path`.
         pub fn render_to_file(
             schematic: &Schematic,
@@ -286,6 +561,25 @@ pub mod ffi {
             Ok(())
         }
 
+        /// `render_png_b64_with_pack` with profiling: meshing, device,
+        /// upload, GPU (timestamp queries where supported), readback and
+        /// encode timings alongside the image.
+        pub fn render_profiled(
+            schematic: &Schematic,
+            pack: &ResourcePack,
+            config: &RenderConfig,
+        ) -> Result<Box<ProfiledRender>, NucleationError> {
+            let meshing = std::time::Instant::now();
+            let mesh = Self::mesh_with_pack(schematic, pack)?;
+            let mesh_ms = meshing.elapsed().as_secs_f64() * 1000.0;
+            let (image, mut stats) =
+                crate::rendering::render_meshes_png_profiled(&[mesh], &config.0, None)
+                    .map_err(|_| NucleationError::Render)?;
+            stats.mesh_ms = mesh_ms;
+            stats.total_ms += mesh_ms;
+            Ok(Box::new(ProfiledRender { image, stats }))
+        }
+
         /// Render PNG bytes with an already parsed resource pack.
         pub fn render_png_b64_with_pack(
             schematic: &Schematic,
@@ -7,12 +7,29 @@
 //! name "Default"; pass any name here).
 
 use crate::bridge::shared::ffi::NucleationError;
+use crate::bridge::shared::write_json_array;
+use crate::universal_schematic::ChunkLoadingStrategy;
+use diplomat_runtime::DiplomatWrite;
 
 /// Validate a `&DiplomatStr` (raw UTF-8 bytes) into `&str`.
 fn utf8(bytes: &[u8]) -> Result<&str, NucleationError> {
     std::str::from_utf8(bytes).map_err(|_| NucleationError::InvalidArgument)
 }
 
+/// Auto-detecting read shared by `Schematic::from_data` and its job variants.
+/// `Parse` if a format was detected but failed to parse, `InvalidArgument` if
+/// no format was recognized.
+fn read_schematic_data(data: &[u8]) -> Result<crate::UniversalSchematic, NucleationError> {
+    let manager = crate::formats::manager::get_manager();
+    manager.read(data).map_err(|_| {
+        if manager.detect_format(data).is_some() {
+            NucleationError::Parse
+        } else {
+            NucleationError::InvalidArgument
+        }
+    })
+}
+
 fn b64(bytes: &[u8]) -> String {
     use base64::Engine as _;
     base64::engine::general_purpose::STANDARD.encode(bytes)
@@ -59,12 +76,174 @@ fn block_json(
     })
 }
 
+/// The default region, then the named regions by name: the order the SNBT
+/// exports list their contents in.
+fn snbt_regions(schematic: &crate::UniversalSchematic) -> Vec<&crate::region::Region> {
+    let mut regions = vec![&schematic.default_region];
+    regions.extend(crate::UniversalSchematic::sorted_named_regions(schematic));
+    regions
+}
+
+/// Stream every block entity into `out` as `{"id", "position", "snbt"}`,
+/// region by region and by position within a region. Block entities sharing
+/// one NBT allocation (placed from the same template) are rendered once,
+/// and the distinct payloads are rendered in parallel.
+fn write_block_entities_snbt_json(
+    schematic: &crate::UniversalSchematic,
+    out: &mut DiplomatWrite,
+) -> Result<(), NucleationError> {
+    use rayon::prelude::*;
+
+    #[derive(serde::Serialize)]
+    struct Row<'a> {
+        id: &'a str,
+        position: [i32; 3],
+        snbt: &'a str,
+    }
+
+    let mut entries = Vec::new();
+    for region in snbt_regions(schematic) {
+        let start = entries.len();
+        entries.extend(region.block_entities.iter());
+        entries[start..].sort_unstable_by_key(|&(pos, _)| pos);
+    }
+    let mut slots: rustc_hash::FxHashMap<*const crate::nbt::NbtMap, usize> = Default::default();
+    let mut unique = Vec::new();
+    let rendered: Vec<usize> = entries
+        .iter()
+        .map(|(_, be)| {
+            *slots
+                .entry(std::sync::Arc::as_ptr(&be.nbt))
+                .or_insert_with(|| {
+                    unique.push(&*be.nbt);
+                    unique.len() - 1
+                })
+        })
+        .collect();
+    let snbt: Vec<String> = unique
+        .par_iter()
+        .map(|nbt| quartz_nbt::NbtTag::Compound(nbt.to_quartz_nbt()).to_snbt())
+        .collect();
+    write_json_array(
+        out,
+        entries.iter().zip(&rendered).map(|(&(pos, be), &i)| Row {
+            id: &be.id,
+            position: [pos.0, pos.1, pos.2],
+            snbt: &snbt[i],
+        }),
+    )
+}
+
+/// Stream every mobile entity into `out` as an SNBT string, region by region
+/// in insertion order, rendering in parallel.
+fn write_entities_snbt_json(
+    schematic: &crate::UniversalSchematic,
+    out: &mut DiplomatWrite,
+) -> Result<(), NucleationError> {
+    use rayon::prelude::*;
+
+    let entities: Vec<&crate::entity::Entity> = snbt_regions(schematic)
+        .into_iter()
+        .flat_map(|region| &region.entities)
+        .collect();
+    let snbt: Vec<String> = entities
+        .par_iter()
+        .map(|entity| entity.to_nbt().to_snbt())
+        .collect();
+    write_json_array(out, &snbt)
+}
+
+/// Map a bridge strategy name to a [`ChunkLoadingStrategy`]; unknown names
+/// fall back to bottom-up.
+pub(crate) fn parse_strategy(strategy: &str, camera: (f32, f32, f32)) -> ChunkLoadingStrategy {
+    match strategy {
+        "distance_to_camera" => {
+            ChunkLoadingStrategy::DistanceToCamera(camera.0, camera.1, camera.2)
+        }
+        "top_down" => ChunkLoadingStrategy::TopDown,
+        "bottom_up" => ChunkLoadingStrategy::BottomUp,
+        "center_outward" => ChunkLoadingStrategy::CenterOutward,
+        "random" => ChunkLoadingStrategy::Random,
+        _ => ChunkLoadingStrategy::BottomUp,
+    }
+}
+
+/// Stream `iter_chunks` output into `out` as the JSON array shared by
+/// `Schematic` and `FrozenSchematic`: `{"chunk_x", "chunk_y", "chunk_z",
+/// "blocks": [...]}` per chunk, written chunk by chunk. Unknown strategy names
+/// fall back to `bottom_up`.
+fn write_chunks_json(
+    schematic: &crate::UniversalSchematic,
+    chunk_size: (i32, i32, i32),
+    strategy: &str,
+    camera: (f32, f32, f32),
+    out: &mut DiplomatWrite,
+) {
+    use std::fmt::Write as _;
+    let strategy = parse_strategy(strategy, camera);
+    let _ = out.write_char('[');
+    let chunks = schematic.iter_chunks(chunk_size.0, chunk_size.1, chunk_size.2, Some(strategy));
+    for (i, chunk) in chunks.enumerate() {
+        if i > 0 {
+            let _ = out.write_char(',');
+        }
+        let _ = write!(
+            out,
+            "{{\"chunk_x\":{},\"chunk_y\":{},\"chunk_z\":{},\"blocks\":",
+            chunk.chunk_x, chunk.chunk_y, chunk.chunk_z
+        );
+        let blocks = chunk
+            .positions
+            .into_iter()
+            .filter_map(|pos| schematic.get_block(pos.x, pos.y, pos.z).map(|b| (pos, b)))
+            .map(|(pos, block)| block_json(&pos, block));
+        let _ = write_json_array(out, blocks);
+        let _ = out.write_char('}');
+    }
+    let _ = out.write_char(']');
+}
+
+/// A region by name; `"default"`/`"Default"` also address the default region.
+fn region_named<'a>(
+    schematic: &'a crate::UniversalSchematic,
+    name: &str,
+) -> Result<&'a crate::region::Region, NucleationError> {
+    schematic
+        .get_region(name)
+        .or_else(|| (name == "default" || name == "Default").then_some(&schematic.default_region))
+        .ok_or(NucleationError::NotFound)
+}
+
+/// `region`'s palette as a JSON array of full block-state strings
+/// (`name[k=v,...]`), so positions match the region's palette indices.
+fn write_region_states_json<W: std::fmt::Write + ?Sized>(
+    region: &crate::region::Region,
+    out: &mut W,
+) -> Result<(), NucleationError> {
+    write_json_array(out, region.palette.iter().map(|bs| bs.to_string()))
+}
+
+// Everything `FrozenSchematic` shares across threads must stay `Send + Sync`;
+// this fails to compile if a field ever grows interior mutability.
+const _: fn() = || {
+    fn assert_send_sync<T: Send + Sync>() {}
+    assert_send_sync::<std::sync::Arc<crate::UniversalSchematic>>();
+};
+
 #[diplomat::bridge]
 pub mod ffi {
-    use super::super::shared::ffi::{BlockPos, Dimensions, NucleationError};
-    use super::{b64, block_json, parse_excluded_blocks, parse_world_options, utf8};
+    use super::super::definition_region::ffi::RegionBounds;
+    use super::super::diff::ffi::FootprintBatch;
+    use super::super::jobs::ffi::Job;
+    use super::super::jobs::{spawn_job, take_job_output};
+    use super::super::shared::ffi::{BlockPos, Bytes, Dimensions, NucleationError, ResultBuffer};
+    use super::super::shared::refill_text;
+    use super::{
+        b64, block_json, parse_excluded_blocks, parse_strategy, parse_world_options,
+        read_schematic_data, region_named, utf8, write_block_entities_snbt_json, write_chunks_json,
+        write_entities_snbt_json, write_json_array, write_region_states_json,
+    };
     use crate::formats::{litematic, manager::get_manager, mcstructure};
-    use crate::universal_schematic::ChunkLoadingStrategy;
     use diplomat_runtime::DiplomatWrite;
     use std::collections::HashMap;
     use std::fmt::Write;
@@ -86,6 +265,30 @@ pub mod ffi {
             Box::new(Schematic(self.0.clone()))
         }
 
+        /// Switch block storage to shared, copy-on-write 16³ sections. After
+        /// this, `deep_clone` costs one pointer per section and each copy
+        /// allocates only the sections it changes. Reads get slightly slower,
+        /// so call it on a base you clone many times.
+        pub fn make_sparse(&mut self) {
+            self.0.make_sparse();
+        }
+
+        /// Move this schematic's contents into an immutable, reference-counted
+        /// `FrozenSchematic` that any number of threads may read concurrently.
+        /// No block data is copied: this handle is left holding an empty
+        /// schematic with the same name. Use `FrozenSchematic::thaw` to get an
+        /// editable copy back.
+        pub fn freeze(&mut self) -> Box<FrozenSchematic> {
+            let name = self
+                .0
+                .metadata
+                .name
+                .clone()
+                .unwrap_or_else(|| "Default".to_string());
+            let inner = std::mem::replace(&mut self.0, crate::UniversalSchematic::new(name));
+            Box::new(FrozenSchematic(std::sync::Arc::new(inner)))
+        }
+
         /// The allocated dimensions (width, height, length) of the schematic's
         /// bounding box.
         pub fn dimensions(&self) -> Dimensions {
@@ -127,6 +330,20 @@ pub mod ffi {
             }
         }
 
+        /// `get_block_name` into a reusable `ResultBuffer`, for per-block
+        /// polling loops that should not allocate a string per call.
+        pub fn get_block_name_into(
+            &self,
+            x: i32,
+            y: i32,
+            z: i32,
+            buf: &mut ResultBuffer,
+        ) -> Result<(), NucleationError> {
+            let state = self.0.get_block(x, y, z).ok_or(NucleationError::NotFound)?;
+            let _ = write!(refill_text(buf), "{}", state.name);
+            Ok(())
+        }
+
         /// Save the schematic to a file, picking the format from the file
         /// extension (`.litematic`, `.schem`, `.schematic`, `.mcstructure`,
         /// `.nbt`, `.nusn`; unknown extensions write Litematic). For an
@@ -137,7 +354,6 @@ pub mod ffi {
         pub fn save_to_file(&self, path: &DiplomatStr) -> Result<(), NucleationError> {
             let path = std::str::from_utf8(path).map_err(|_| NucleationError::InvalidArgument)?;
             let manager = get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let bytes = manager
                 .write_auto_with_settings(path, &self.0, None, None)
                 .map_err(|_| NucleationError::Serialize)?;
@@ -164,9 +380,15 @@ pub mod ffi {
         }
 
         /// Convenience alias for `load_from_file`, matching the established
-        /// Python API (`Schematic.open("build.schem")`).
+        /// Python API (`Schematic.open("build.schem")`). A `.nusn` snapshot
+        /// is mapped rather than read, and its block arrays are copied
+        /// without decoding (see `SnapshotView` to read one in place).
         #[diplomat::attr(js, disable)]
         pub fn open(path: &DiplomatStr) -> Result<Box<Schematic>, NucleationError> {
+            let path_str = utf8(path)?;
+            if path_str.ends_with(".nusn") {
+                return SnapshotView::open(path)?.to_schematic();
+            }
             Self::load_from_file(path)
         }
 
@@ -177,18 +399,88 @@ pub mod ffi {
         /// `Parse` if a format was detected but failed to parse, `InvalidArgument` if
         /// no format was recognized.
         pub fn from_data(data: &[u8]) -> Result<Box<Schematic>, NucleationError> {
+            read_schematic_data(data).map(|s| Box::new(Schematic(s)))
+        }
+
+        /// Build a schematic from only the blocks of `data` inside the inclusive
+        /// box, given in the file's own coordinates. Litematic and Sponge files
+        /// decode just the box; other formats load fully and are cropped.
+        /// Errors as `from_data` does.
+        pub fn from_data_bounded(
+            data: &[u8],
+            min_x: i32,
+            min_y: i32,
+            min_z: i32,
+            max_x: i32,
+            max_y: i32,
+            max_z: i32,
+        ) -> Result<Box<Schematic>, NucleationError> {
+            let bounds =
+                crate::bounding_box::BoundingBox::new((min_x, min_y, min_z), (max_x, max_y, max_z));
             let manager = get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
-            match manager.read(data) {
-                Ok(res) => Ok(Box::new(Schematic(res))),
-                Err(_) => {
+            manager
+                .read_bounded(data, &bounds)
+                .map(|s| Box::new(Schematic(s)))
+                .map_err(|_| {
                     if manager.detect_format(data).is_some() {
-                        Err(NucleationError::Parse)
+                        NucleationError::Parse
                     } else {
-                        Err(NucleationError::InvalidArgument)
+                        NucleationError::InvalidArgument
                     }
+                })
+        }
+
+        /// Read only the header fields of schematic `data` (format, dimensions,
+        /// name/author, versions), written as a JSON object string with the
+        /// same shape as `StoreIo::probe`. Errors as `from_data` does.
+        pub fn probe(data: &[u8], out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let manager = get_manager();
+            let info = manager.probe(data).map_err(|_| {
+                if manager.detect_format(data).is_some() {
+                    NucleationError::Parse
+                } else {
+                    NucleationError::InvalidArgument
                 }
-            }
+            })?;
+            let json = serde_json::to_string(&info).map_err(|_| NucleationError::Serialize)?;
+            let _ = write!(out, "{}", json);
+            Ok(())
+        }
+
+        /// `from_data` as a background job (the bytes are copied first). Take
+        /// the result with `Schematic::from_job`.
+        pub fn start_from_data(data: &[u8]) -> Box<Job> {
+            let data = data.to_vec();
+            spawn_job(NucleationError::Parse, move |_| read_schematic_data(&data))
+        }
+
+        /// `load_from_file` as a background job. Take the result with
+        /// `Schematic::from_job`.
+        #[diplomat::attr(js, disable)]
+        pub fn start_load_from_file(path: &DiplomatStr) -> Result<Box<Job>, NucleationError> {
+            let path = utf8(path)?.to_string();
+            Ok(spawn_job(NucleationError::Parse, move |_| {
+                let bytes = std::fs::read(path).map_err(|_| NucleationError::Io)?;
+                read_schematic_data(&bytes)
+            }))
+        }
+
+        /// `from_world_directory` as a background job. Take the result with
+        /// `Schematic::from_job`.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn start_from_world_directory(path: &DiplomatStr) -> Result<Box<Job>, NucleationError> {
+            let path = std::path::PathBuf::from(utf8(path)?);
+            Ok(spawn_job(NucleationError::Parse, move |_| {
+                crate::formats::world::from_world_directory(&path)
+                    .map_err(|_| NucleationError::Parse)
+            }))
+        }
+
+        /// The schematic produced by a load job. Blocks until the job finishes;
+        /// `AlreadyConsumed` on a second call, `InvalidArgument` if the job
+        /// does not produce a schematic.
+        pub fn from_job(job: &mut Job) -> Result<Box<Schematic>, NucleationError> {
+            take_job_output::<crate::UniversalSchematic>(job).map(|s| Box::new(Schematic(s)))
         }
 
         /// Build a schematic from Litematic data.
@@ -198,10 +490,17 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Parse)
         }
 
+        /// The schematic as Litematic bytes, in an owned buffer (no base64).
+        pub fn to_litematic_bytes(&self) -> Result<Box<Bytes>, NucleationError> {
+            litematic::to_litematic(&self.0)
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
         /// The schematic as Litematic bytes, base64-encoded.
         pub fn to_litematic_b64(&self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
-            let data = litematic::to_litematic(&self.0).map_err(|_| NucleationError::Serialize)?;
-            let _ = write!(out, "{}", b64(&data));
+            let data = self.to_litematic_bytes()?;
+            let _ = write!(out, "{}", b64(&data.0));
             Ok(())
         }
 
@@ -212,11 +511,17 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Parse)
         }
 
+        /// The schematic as classic `.schematic` bytes, in an owned buffer (no base64).
+        pub fn to_schematic_bytes(&self) -> Result<Box<Bytes>, NucleationError> {
+            crate::formats::schematic::to_schematic(&self.0)
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
         /// The schematic as classic `.schematic` bytes, base64-encoded.
         pub fn to_schematic_b64(&self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
-            let data = crate::formats::schematic::to_schematic(&self.0)
-                .map_err(|_| NucleationError::Serialize)?;
-            let _ = write!(out, "{}", b64(&data));
+            let data = self.to_schematic_bytes()?;
+            let _ = write!(out, "{}", b64(&data.0));
             Ok(())
         }
 
@@ -227,11 +532,17 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Parse)
         }
 
+        /// The schematic as snapshot (fast binary) bytes, in an owned buffer (no base64).
+        pub fn to_snapshot_bytes(&self) -> Result<Box<Bytes>, NucleationError> {
+            crate::formats::snapshot::to_snapshot(&self.0)
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
         /// The schematic as snapshot (fast binary) bytes, base64-encoded.
         pub fn to_snapshot_b64(&self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
-            let data = crate::formats::snapshot::to_snapshot(&self.0)
-                .map_err(|_| NucleationError::Serialize)?;
-            let _ = write!(out, "{}", b64(&data));
+            let data = self.to_snapshot_bytes()?;
+            let _ = write!(out, "{}", b64(&data.0));
             Ok(())
         }
 
@@ -242,11 +553,17 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Parse)
         }
 
+        /// The schematic as McStructure (Bedrock) bytes, in an owned buffer (no base64).
+        pub fn to_mcstructure_bytes(&self) -> Result<Box<Bytes>, NucleationError> {
+            mcstructure::to_mcstructure(&self.0)
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
         /// The schematic as McStructure (Bedrock) bytes, base64-encoded.
         pub fn to_mcstructure_b64(&self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
-            let data =
-                mcstructure::to_mcstructure(&self.0).map_err(|_| NucleationError::Serialize)?;
-            let _ = write!(out, "{}", b64(&data));
+            let data = self.to_mcstructure_bytes()?;
+            let _ = write!(out, "{}", b64(&data.0));
             Ok(())
         }
 
@@ -365,6 +682,18 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Io)
         }
 
+        /// Export the schematic as a zipped Minecraft world, in an owned buffer
+        /// (no base64). `options_json` may be empty for defaults.
+        pub fn to_world_zip_bytes(
+            &self,
+            options_json: &DiplomatStr,
+        ) -> Result<Box<Bytes>, NucleationError> {
+            let options = parse_world_options(utf8(options_json)?)?;
+            crate::formats::world::to_world_zip(&self.0, options)
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
         /// Export the schematic as a zipped Minecraft world, base64-encoded.
         /// `options_json` may be empty for defaults.
         pub fn to_world_zip_b64(
@@ -372,10 +701,8 @@ pub mod ffi {
             options_json: &DiplomatStr,
             out: &mut DiplomatWrite,
         ) -> Result<(), NucleationError> {
-            let options = parse_world_options(utf8(options_json)?)?;
-            let bytes = crate::formats::world::to_world_zip(&self.0, options)
-                .map_err(|_| NucleationError::Serialize)?;
-            let _ = write!(out, "{}", b64(&bytes));
+            let data = self.to_world_zip_bytes(options_json)?;
+            let _ = write!(out, "{}", b64(&data.0));
             Ok(())
         }
 
@@ -459,6 +786,99 @@ pub mod ffi {
             Ok(())
         }
 
+        /// Place many blocks by pre-resolved palette index (from `prepare_block`)
+        /// in one call. `positions` is flat `[x0,y0,z0, x1,y1,z1, ...]` and
+        /// `palette_indices` holds one index per position. Everything is
+        /// validated up front and the region grows once to the batch bounding
+        /// box, so a bad entry leaves the schematic untouched. Returns the number
+        /// of blocks placed.
+        pub fn place_batch(
+            &mut self,
+            positions: &[i32],
+            palette_indices: &[i32],
+        ) -> Result<i32, NucleationError> {
+            if positions.len() % 3 != 0 || positions.len() / 3 != palette_indices.len() {
+                return Err(NucleationError::InvalidArgument);
+            }
+            let count = palette_indices.len();
+            if count == 0 {
+                return Ok(0);
+            }
+            let count_i32 = i32::try_from(count).map_err(|_| NucleationError::InvalidArgument)?;
+            let region = &mut self.0.default_region;
+            let palette_len = region.palette.len();
+            if palette_indices
+                .iter()
+                .any(|&i| i < 0 || i as usize >= palette_len)
+            {
+                return Err(NucleationError::InvalidArgument);
+            }
+
+            let (mut min_x, mut min_y, mut min_z) = (positions[0], positions[1], positions[2]);
+            let (mut max_x, mut max_y, mut max_z) = (min_x, min_y, min_z);
+            for p in positions.chunks_exact(3).skip(1) {
+                min_x = min_x.min(p[0]);
+                min_y = min_y.min(p[1]);
+                min_z = min_z.min(p[2]);
+                max_x = max_x.max(p[0]);
+                max_y = max_y.max(p[1]);
+                max_z = max_z.max(p[2]);
+            }
+            region.ensure_bounds((min_x, min_y, min_z), (max_x, max_y, max_z));
+            for (p, &index) in positions.chunks_exact(3).zip(palette_indices) {
+                region.set_block_at_index_unchecked(index as usize, p[0], p[1], p[2]);
+            }
+            Ok(count_i32)
+        }
+
+        /// Copy the default region's palette indices for the inclusive box
+        /// `min..=max` into `out`, x fastest, then z, then y (the storage order,
+        /// so this is close to a memcpy). Cells outside the allocated bounds read
+        /// as air. `out` must hold exactly the box volume; decode indices with
+        /// `indices_palette_json`.
+        pub fn read_indices(
+            &self,
+            min: BlockPos,
+            max: BlockPos,
+            out: &mut [u32],
+        ) -> Result<(), NucleationError> {
+            self.0
+                .default_region
+                .read_palette_indices((min.x, min.y, min.z), (max.x, max.y, max.z), out)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Overwrite the inclusive box `min..=max` of the default region with
+        /// palette indices laid out like `read_indices`. Indices must already be
+        /// in the palette (see `prepare_block` / `indices_palette_json`); they are
+        /// all validated before anything is written.
+        pub fn write_indices(
+            &mut self,
+            min: BlockPos,
+            max: BlockPos,
+            indices: &[u32],
+        ) -> Result<(), NucleationError> {
+            self.0
+                .default_region
+                .write_palette_indices((min.x, min.y, min.z), (max.x, max.y, max.z), indices)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// The default region's palette as full block-state strings
+        /// (`name[k=v,...]`), a JSON array whose positions are the indices used by
+        /// `read_indices` / `write_indices` / `place`.
+        pub fn indices_palette_json(&self, out: &mut DiplomatWrite) {
+            let states: Vec<String> = self
+                .0
+                .default_region
+                .palette
+                .iter()
+                .map(|bs| bs.to_string())
+                .collect();
+            let json = serde_json::to_string(&states).unwrap_or_else(|_| "[]".to_string());
+            let _ = write!(out, "{}", json);
+        }
+
         /// Batch-set blocks at multiple positions to the same block (name, block
         /// string with properties, or block string with NBT). `positions` is flat
         /// `[x0,y0,z0, x1,y1,z1, ...]` (length must be a multiple of 3).
@@ -702,6 +1122,19 @@ pub mod ffi {
             }
         }
 
+        /// `get_block_string` into a reusable `ResultBuffer`.
+        pub fn get_block_string_into(
+            &self,
+            x: i32,
+            y: i32,
+            z: i32,
+            buf: &mut ResultBuffer,
+        ) -> Result<(), NucleationError> {
+            let bs = self.0.get_block(x, y, z).ok_or(NucleationError::NotFound)?;
+            let _ = write!(refill_text(buf), "{}", bs);
+            Ok(())
+        }
+
         /// The block entity at a position as JSON
         /// `{"id": ..., "position": [x,y,z], "nbt": {...}}` (the old `CBlockEntity`).
         pub fn get_block_entity_json(
@@ -751,20 +1184,49 @@ pub mod ffi {
         /// Every block entity as a JSON array of
         /// `{"id": ..., "position": [x,y,z], "nbt": {...}}`.
         pub fn get_all_block_entities_json(&self, out: &mut DiplomatWrite) {
-            let items: Vec<serde_json::Value> = self
-                .0
-                .get_block_entities_as_list()
-                .into_iter()
-                .map(|be| {
-                    serde_json::json!({
-                        "id": be.id,
-                        "position": [be.position.0, be.position.1, be.position.2],
-                        "nbt": serde_json::to_value(&be.nbt).unwrap_or(serde_json::Value::Null),
-                    })
+            let items = self.0.get_block_entities_as_list().into_iter().map(|be| {
+                serde_json::json!({
+                    "id": be.id,
+                    "position": [be.position.0, be.position.1, be.position.2],
+                    "nbt": serde_json::to_value(&be.nbt).unwrap_or(serde_json::Value::Null),
                 })
-                .collect();
-            let json = serde_json::to_string(&items).unwrap_or_else(|_| "[]".to_string());
-            let _ = write!(out, "{}", json);
+            });
+            let _ = write_json_array(out, items);
+        }
+
+        /// Every block entity (all regions) as binary columns — packed `int32`
+        /// positions, interned ids and binary NBT blobs — for scanning without
+        /// JSON. See `BlockEntityColumns`.
+        pub fn block_entity_columns(&self) -> Result<Box<BlockEntityColumns>, NucleationError> {
+            crate::formats::columnar::block_entity_columns(&self.0)
+                .map(|c| Box::new(BlockEntityColumns(c)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
+        /// Every mobile entity (all regions) as binary columns, like
+        /// `block_entity_columns` but with `double` positions. See `EntityColumns`.
+        pub fn entity_columns(&self) -> Result<Box<EntityColumns>, NucleationError> {
+            crate::formats::columnar::entity_columns(&self.0)
+                .map(|c| Box::new(EntityColumns(c)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
+        /// `entity_columns` limited to entities standing in the inclusive
+        /// block box. Answered from each region's chunk index.
+        pub fn entity_columns_in_box(
+            &self,
+            min_x: i32,
+            min_y: i32,
+            min_z: i32,
+            max_x: i32,
+            max_y: i32,
+            max_z: i32,
+        ) -> Result<Box<EntityColumns>, NucleationError> {
+            let bounds =
+                crate::bounding_box::BoundingBox::new((min_x, min_y, min_z), (max_x, max_y, max_z));
+            crate::formats::columnar::entity_columns_in_box(&self.0, &bounds)
+                .map(|c| Box::new(EntityColumns(c)))
+                .map_err(|_| NucleationError::Serialize)
         }
 
         /// The number of mobile entities (not block entities).
@@ -775,21 +1237,14 @@ pub mod ffi {
         /// Every mobile entity as a JSON array of
         /// `{"id": ..., "position": [x,y,z], "nbt": {...}}` (the old `CEntityArray`).
         pub fn get_entities_json(&self, out: &mut DiplomatWrite) {
-            let items: Vec<serde_json::Value> = self
-                .0
-                .default_region
-                .entities
-                .iter()
-                .map(|entity| {
-                    serde_json::json!({
-                        "id": entity.id,
-                        "position": [entity.position.0, entity.position.1, entity.position.2],
-                        "nbt": serde_json::to_value(&entity.nbt).unwrap_or(serde_json::Value::Null),
-                    })
+            let items = self.0.default_region.entities.iter().map(|entity| {
+                serde_json::json!({
+                    "id": entity.id,
+                    "position": [entity.position.0, entity.position.1, entity.position.2],
+                    "nbt": serde_json::to_value(&entity.nbt).unwrap_or(serde_json::Value::Null),
                 })
-                .collect();
-            let json = serde_json::to_string(&items).unwrap_or_else(|_| "[]".to_string());
-            let _ = write!(out, "{}", json);
+            });
+            let _ = write_json_array(out, items);
         }
 
         /// Add a mobile entity. `nbt_json` is a JSON object (may be empty).
@@ -806,7 +1261,7 @@ pub mod ffi {
             let mut entity = crate::entity::Entity::new(id_str, (x, y, z));
             if !json.is_empty() {
                 if let Ok(nbt_map) = serde_json::from_str(json) {
-                    entity.nbt = nbt_map;
+                    entity.set_nbt(nbt_map);
                 }
             }
             self.0.add_entity(entity);
@@ -979,34 +1434,13 @@ pub mod ffi {
         /// Every block entity as a JSON array of `{id, position: [x,y,z], snbt}`.
         /// The `snbt` is the inner data only (no `Id`/`Pos`).
         pub fn get_all_block_entities_snbt_json(&self, out: &mut DiplomatWrite) {
-            let items: Vec<serde_json::Value> = self
-                .0
-                .get_block_entities_as_list()
-                .into_iter()
-                .map(|be| {
-                    let snbt = quartz_nbt::NbtTag::Compound(be.nbt.to_quartz_nbt()).to_snbt();
-                    serde_json::json!({
-                        "id": be.id,
-                        "position": [be.position.0, be.position.1, be.position.2],
-                        "snbt": snbt,
-                    })
-                })
-                .collect();
-            let json = serde_json::to_string(&items).unwrap_or_else(|_| "[]".to_string());
-            let _ = write!(out, "{}", json);
+            let _ = write_block_entities_snbt_json(&self.0, out);
         }
 
         /// Every mobile entity as a JSON array of typed SNBT strings (full compound
         /// incl. `id`/`Pos`).
         pub fn get_entities_snbt_json(&self, out: &mut DiplomatWrite) {
-            let snbts: Vec<String> = self
-                .0
-                .get_entities_as_list()
-                .iter()
-                .map(|entity| entity.to_nbt().to_snbt())
-                .collect();
-            let json = serde_json::to_string(&snbts).unwrap_or_else(|_| "[]".to_string());
-            let _ = write!(out, "{}", json);
+            let _ = write_entities_snbt_json(&self.0, out);
         }
 
         /// Add a mobile entity from a full SNBT entity compound (must contain `id`
@@ -1023,13 +1457,11 @@ pub mod ffi {
         /// Every non-air block as a JSON array of
         /// `{"x", "y", "z", "name", "properties"}` (the old `CBlockArray`).
         pub fn get_all_blocks_json(&self, out: &mut DiplomatWrite) {
-            let items: Vec<serde_json::Value> = self
+            let items = self
                 .0
                 .iter_blocks()
-                .map(|(pos, block)| block_json(&pos, block))
-                .collect();
-            let json = serde_json::to_string(&items).unwrap_or_else(|_| "[]".to_string());
-            let _ = write!(out, "{}", json);
+                .map(|(pos, block)| block_json(&pos, block));
+            let _ = write_json_array(out, items);
         }
 
         /// All blocks within a sub-region (chunk) of the schematic, as the same
@@ -1045,7 +1477,7 @@ pub mod ffi {
             length: i32,
             out: &mut DiplomatWrite,
         ) {
-            let items: Vec<serde_json::Value> = self
+            let items = self
                 .0
                 .iter_blocks()
                 .filter(|(pos, _)| {
@@ -1056,10 +1488,8 @@ pub mod ffi {
                         && pos.z >= offset_z
                         && pos.z < offset_z + length
                 })
-                .map(|(pos, block)| block_json(&pos, block))
-                .collect();
-            let json = serde_json::to_string(&items).unwrap_or_else(|_| "[]".to_string());
-            let _ = write!(out, "{}", json);
+                .map(|(pos, block)| block_json(&pos, block));
+            let _ = write_json_array(out, items);
         }
 
         // --- Chunking ---
@@ -1104,36 +1534,37 @@ pub mod ffi {
             out: &mut DiplomatWrite,
         ) {
             let strategy_str = std::str::from_utf8(strategy).unwrap_or("");
-            let strategy_enum = match strategy_str {
-                "distance_to_camera" => {
-                    ChunkLoadingStrategy::DistanceToCamera(camera_x, camera_y, camera_z)
-                }
-                "top_down" => ChunkLoadingStrategy::TopDown,
-                "bottom_up" => ChunkLoadingStrategy::BottomUp,
-                "center_outward" => ChunkLoadingStrategy::CenterOutward,
-                "random" => ChunkLoadingStrategy::Random,
-                _ => ChunkLoadingStrategy::BottomUp,
-            };
-            let chunks: Vec<serde_json::Value> = self
-                .0
-                .iter_chunks(chunk_width, chunk_height, chunk_length, Some(strategy_enum))
-                .map(|chunk| {
-                    let blocks: Vec<serde_json::Value> = chunk
-                        .positions
-                        .into_iter()
-                        .filter_map(|pos| self.0.get_block(pos.x, pos.y, pos.z).map(|b| (pos, b)))
-                        .map(|(pos, block)| block_json(&pos, block))
-                        .collect();
-                    serde_json::json!({
-                        "chunk_x": chunk.chunk_x,
-                        "chunk_y": chunk.chunk_y,
-                        "chunk_z": chunk.chunk_z,
-                        "blocks": blocks,
-                    })
-                })
-                .collect();
-            let json = serde_json::to_string(&chunks).unwrap_or_else(|_| "[]".to_string());
-            let _ = write!(out, "{}", json);
+            write_chunks_json(
+                &self.0,
+                (chunk_width, chunk_height, chunk_length),
+                strategy_str,
+                (camera_x, camera_y, camera_z),
+                out,
+            );
+        }
+
+        /// A cursor over the schematic's chunks in `strategy` order (same names
+        /// as `get_chunks_with_strategy_json`). Creating it only orders chunk
+        /// coordinates; each `ChunkCursor::advance` reads one chunk, so the
+        /// first chunk is ready without a full pass over the blocks. The cursor
+        /// holds no reference: pass this schematic, unmodified, to every
+        /// `advance`. `InvalidArgument` when a chunk dimension is not positive.
+        #[allow(clippy::too_many_arguments)]
+        pub fn chunk_cursor(
+            &self,
+            chunk_width: i32,
+            chunk_height: i32,
+            chunk_length: i32,
+            strategy: &DiplomatStr,
+            camera_x: f32,
+            camera_y: f32,
+            camera_z: f32,
+        ) -> Result<Box<ChunkCursor>, NucleationError> {
+            let strategy = parse_strategy(utf8(strategy)?, (camera_x, camera_y, camera_z));
+            self.0
+                .chunk_cursor(chunk_width, chunk_height, chunk_length, strategy)
+                .map(|cursor| Box::new(ChunkCursor(cursor)))
+                .map_err(|_| NucleationError::InvalidArgument)
         }
 
         // --- Metadata & Info ---
@@ -1148,6 +1579,20 @@ pub mod ffi {
             self.0.total_volume()
         }
 
+        /// Estimated heap bytes held by the schematic.
+        pub fn memory_usage(&self) -> u64 {
+            self.0.memory_usage().total as u64
+        }
+
+        /// Estimated heap bytes by component (`block_arrays`, `palettes`,
+        /// `block_entities`, `entities`, `definition_regions`,
+        /// `block_state_cache`, `other`) and per region, as JSON.
+        pub fn memory_usage_json(&self, out: &mut DiplomatWrite) {
+            let usage = self.0.memory_usage();
+            let json = serde_json::to_string(&usage).unwrap_or_else(|_| "{}".to_string());
+            let _ = write!(out, "{}", json);
+        }
+
         /// The names of all regions, as a JSON array of strings.
         pub fn region_names_json(&self, out: &mut DiplomatWrite) {
             let names = self.0.get_region_names();
@@ -1556,15 +2001,14 @@ pub mod ffi {
 
         // --- Format management ---
 
-        /// Serialize to a named format, base64-encoded. `version` and `settings`
-        /// may be empty strings for defaults.
-        pub fn save_as_b64(
+        /// Serialize to a named format, in an owned buffer (no base64). `version`
+        /// and `settings` may be empty strings for defaults.
+        pub fn save_as_bytes(
             &self,
             format: &DiplomatStr,
             version: &DiplomatStr,
             settings: &DiplomatStr,
-            out: &mut DiplomatWrite,
-        ) -> Result<(), NucleationError> {
+        ) -> Result<Box<Bytes>, NucleationError> {
             let fmt = utf8(format)?;
             let ver = utf8(version)?;
             let ver = if ver.is_empty() { None } else { Some(ver) };
@@ -1575,11 +2019,23 @@ pub mod ffi {
                 Some(settings_str)
             };
             let manager = get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
-            let data = manager
+            manager
                 .write_with_settings(fmt, &self.0, ver, settings_str)
-                .map_err(|_| NucleationError::Serialize)?;
-            let _ = write!(out, "{}", b64(&data));
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
+        /// Serialize to a named format, base64-encoded. `version` and `settings`
+        /// may be empty strings for defaults.
+        pub fn save_as_b64(
+            &self,
+            format: &DiplomatStr,
+            version: &DiplomatStr,
+            settings: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let data = self.save_as_bytes(format, version, settings)?;
+            let _ = write!(out, "{}", b64(&data.0));
             Ok(())
         }
 
@@ -1598,7 +2054,6 @@ pub mod ffi {
             let ver = utf8(version)?;
             let ver = if ver.is_empty() { None } else { Some(ver) };
             let manager = get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let bytes = if fmt.is_empty() {
                 manager.write_auto_with_settings(path, &self.0, ver, None)
             } else {
@@ -1617,7 +2072,6 @@ pub mod ffi {
         ) -> Result<(), NucleationError> {
             let ver = utf8(version)?;
             let manager = get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let data = manager
                 .write("sponge", &self.0, Some(ver))
                 .map_err(|_| NucleationError::Serialize)?;
@@ -1631,7 +2085,6 @@ pub mod ffi {
             out: &mut DiplomatWrite,
         ) -> Result<(), NucleationError> {
             let manager = get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let versions = manager.get_exporter_versions("sponge").unwrap_or_default();
             let json = serde_json::to_string(&versions).map_err(|_| NucleationError::Serialize)?;
             let _ = write!(out, "{}", json);
@@ -1819,6 +2272,14 @@ pub mod ffi {
             Ok(())
         }
 
+        /// Compile the schematic's insign annotations to typed regions
+        /// (schematic 0 of the result), through the insign region cache.
+        pub fn compile_insign_regions(&self) -> Result<Box<InsignRegions>, NucleationError> {
+            crate::insign::compile_schematic_regions(&self.0)
+                .map(|regions| Box::new(InsignRegions(vec![Ok(regions)])))
+                .map_err(|_| NucleationError::Parse)
+        }
+
         /// Every region's palette, as a JSON object mapping region name → array of
         /// block names (the default region under `"default"`).
         pub fn all_palettes_json(&self, out: &mut DiplomatWrite) {
@@ -1863,20 +2324,25 @@ pub mod ffi {
             region_name: &DiplomatStr,
             out: &mut DiplomatWrite,
         ) -> Result<(), NucleationError> {
-            let name = utf8(region_name)?;
-            let region = self
-                .0
-                .get_region(name)
-                .or_else(|| {
-                    (name == "default" || name == "Default").then_some(&self.0.default_region)
-                })
-                .ok_or(NucleationError::NotFound)?;
+            let region = region_named(&self.0, utf8(region_name)?)?;
             let names: Vec<&str> = region.palette.iter().map(|bs| bs.name.as_str()).collect();
             let json = serde_json::to_string(&names).unwrap_or_else(|_| "[]".to_string());
             let _ = write!(out, "{}", json);
             Ok(())
         }
 
+        /// A named region's palette as full block-state strings
+        /// (`name[k=v,...]`), a JSON array whose positions are the indices
+        /// `ChunkCursor::palette_indices` uses. `"default"`/`"Default"` address
+        /// the default region.
+        pub fn region_indices_palette_json(
+            &self,
+            region_name: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            write_region_states_json(region_named(&self.0, utf8(region_name)?)?, out)
+        }
+
         /// The minimum corner of the tight (content) bounds. `NotFound` when the
         /// schematic has no content.
         pub fn tight_bounds_min(&self) -> Result<BlockPos, NucleationError> {
@@ -1904,21 +2370,615 @@ pub mod ffi {
         }
     }
 
-    /// A block state: a block name plus its properties. Port of the old
-    /// `BlockStateWrapper` / `blockstate_*` fns.
+    /// Columnar block-entity export from `Schematic::block_entity_columns`.
+    /// Every accessor borrows from the handle and stays valid until it is
+    /// destroyed. Record `i` is at `positions[3i..3i+3]`, has id
+    /// `id_at(id_indices[i])`, and its binary NBT (big-endian, unnamed root
+    /// compound) is `nbt_data[nbt_offsets[i] .. nbt_offsets[i] + nbt_lengths[i]]`.
     #[diplomat::opaque]
-    pub struct BlockState(pub(crate) crate::BlockState);
+    pub struct BlockEntityColumns(pub(crate) crate::formats::columnar::Columns<i32>);
 
-    impl BlockState {
-        /// Create a block state with the given name and no properties.
-        pub fn create(name: &DiplomatStr) -> Box<BlockState> {
-            Box::new(BlockState(crate::BlockState::new(
-                String::from_utf8_lossy(name).into_owned(),
-            )))
+    impl BlockEntityColumns {
+        /// Number of records.
+        pub fn count(&self) -> u32 {
+            self.0.len() as u32
         }
 
-        /// A copy of this block state with `key=value` set; the original is
-        /// unchanged.
+        /// Flat `[x0, y0, z0, x1, ...]` positions, three per record.
+        pub fn positions<'a>(&'a self) -> &'a [i32] {
+            &self.0.positions
+        }
+
+        /// One index per record into the interned id table.
+        pub fn id_indices<'a>(&'a self) -> &'a [u32] {
+            &self.0.id_indices
+        }
+
+        /// Number of distinct ids in the interned table.
+        pub fn id_count(&self) -> u32 {
+            self.0.id_table.len() as u32
+        }
+
+        /// The id at `index` in the interned table. `NotFound` if out of range.
+        pub fn id_at(&self, index: u32, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let id = self
+                .0
+                .id_table
+                .get(index as usize)
+                .ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", id);
+            Ok(())
+        }
+
+        /// Byte offset of each record's NBT blob in `nbt_data`.
+        pub fn nbt_offsets<'a>(&'a self) -> &'a [u64] {
+            &self.0.nbt_offsets
+        }
+
+        /// Byte length of each record's NBT blob.
+        pub fn nbt_lengths<'a>(&'a self) -> &'a [u32] {
+            &self.0.nbt_lengths
+        }
+
+        /// Concatenated binary NBT blobs. Records sharing a template share a blob.
+        pub fn nbt_data<'a>(&'a self) -> &'a [u8] {
+            &self.0.nbt_data
+        }
+    }
+
+    /// Columnar entity export from `Schematic::entity_columns`.
+    /// Every accessor borrows from the handle and stays valid until it is
+    /// destroyed. Record `i` is at `positions[3i..3i+3]`, has id
+    /// `id_at(id_indices[i])`, and its binary NBT (big-endian, unnamed root
+    /// compound) is `nbt_data[nbt_offsets[i] .. nbt_offsets[i] + nbt_lengths[i]]`.
+    #[diplomat::opaque]
+    pub struct EntityColumns(pub(crate) crate::formats::columnar::Columns<f64>);
+
+    impl EntityColumns {
+        /// Number of records.
+        pub fn count(&self) -> u32 {
+            self.0.len() as u32
+        }
+
+        /// Flat `[x0, y0, z0, x1, ...]` positions, three per record.
+        pub fn positions<'a>(&'a self) -> &'a [f64] {
+            &self.0.positions
+        }
+
+        /// One index per record into the interned id table.
+        pub fn id_indices<'a>(&'a self) -> &'a [u32] {
+            &self.0.id_indices
+        }
+
+        /// Number of distinct ids in the interned table.
+        pub fn id_count(&self) -> u32 {
+            self.0.id_table.len() as u32
+        }
+
+        /// The id at `index` in the interned table. `NotFound` if out of range.
+        pub fn id_at(&self, index: u32, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let id = self
+                .0
+                .id_table
+                .get(index as usize)
+                .ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", id);
+            Ok(())
+        }
+
+        /// Byte offset of each record's NBT blob in `nbt_data`.
+        pub fn nbt_offsets<'a>(&'a self) -> &'a [u64] {
+            &self.0.nbt_offsets
+        }
+
+        /// Byte length of each record's NBT blob.
+        pub fn nbt_lengths<'a>(&'a self) -> &'a [u32] {
+            &self.0.nbt_lengths
+        }
+
+        /// Concatenated binary NBT blobs. Records sharing a template share a blob.
+        pub fn nbt_data<'a>(&'a self) -> &'a [u8] {
+            &self.0.nbt_data
+        }
+    }
+
+    /// A version 2 snapshot read in place: only its header is parsed, and
+    /// block reads come straight from the file mapping. Call `to_schematic`
+    /// for an editable copy.
+    #[diplomat::opaque]
+    pub struct SnapshotView(pub(crate) crate::formats::snapshot::Snapshot);
+
+    impl SnapshotView {
+        /// Map a `.nusn` file. `Io` if it cannot be opened, `Parse` if it is
+        /// not a version 2 snapshot.
+        #[diplomat::attr(js, disable)]
+        pub fn open(path: &DiplomatStr) -> Result<Box<SnapshotView>, NucleationError> {
+            use crate::formats::error::FormatError;
+            crate::formats::snapshot::Snapshot::open(utf8(path)?)
+                .map(|snapshot| Box::new(SnapshotView(snapshot)))
+                .map_err(|error| match error {
+                    FormatError::Io(_) => NucleationError::Io,
+                    _ => NucleationError::Parse,
+                })
+        }
+
+        /// Read snapshot bytes in place (the bytes are copied once).
+        pub fn from_data(data: &[u8]) -> Result<Box<SnapshotView>, NucleationError> {
+            let bytes = crate::formats::snapshot::SnapshotBytes::Owned(data.to_vec());
+            crate::formats::snapshot::Snapshot::parse(bytes)
+                .map(|snapshot| Box::new(SnapshotView(snapshot)))
+                .map_err(|_| NucleationError::Parse)
+        }
+
+        /// The names of all regions, default first, as a JSON array.
+        pub fn region_names_json(&self, out: &mut DiplomatWrite) {
+            let names: Vec<&str> = self.0.region_names().collect();
+            let json = serde_json::to_string(&names).unwrap_or_else(|_| "[]".to_string());
+            let _ = write!(out, "{}", json);
+        }
+
+        /// The name of the block at a position. `NotFound` if the position is
+        /// outside every region.
+        pub fn get_block_name(
+            &self,
+            x: i32,
+            y: i32,
+            z: i32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let state = self.0.get_block(x, y, z).ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", state.name);
+            Ok(())
+        }
+
+        /// The full block string (name and properties) at a position.
+        pub fn get_block_string(
+            &self,
+            x: i32,
+            y: i32,
+            z: i32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let state = self.0.get_block(x, y, z).ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", state);
+            Ok(())
+        }
+
+        /// An editable schematic built from the snapshot.
+        pub fn to_schematic(&self) -> Result<Box<Schematic>, NucleationError> {
+            self.0
+                .to_schematic()
+                .map(|s| Box::new(Schematic(s)))
+                .map_err(|_| NucleationError::Parse)
+        }
+    }
+
+    /// Compiled insign regions of one or more schematics, read back by
+    /// schematic and region index instead of as JSON. A schematic whose
+    /// annotations failed to compile has no regions and an error message.
+    #[diplomat::opaque]
+    pub struct InsignRegions(
+        pub(crate) Vec<Result<std::sync::Arc<Vec<crate::insign::InsignRegion>>, String>>,
+    );
+
+    impl InsignRegions {
+        /// Compile every schematic in `batch` in parallel, through the
+        /// insign region cache. Schematic `i` of the result is entry `i` of
+        /// the batch.
+        pub fn compile_batch(batch: &FootprintBatch) -> Box<InsignRegions> {
+            Box::new(InsignRegions(crate::insign::compile_schematics_regions(
+                &batch.0,
+            )))
+        }
+
+        fn region(
+            &self,
+            schematic: u32,
+            region: u32,
+        ) -> Result<&crate::insign::InsignRegion, NucleationError> {
+            match self.0.get(schematic as usize) {
+                Some(Ok(regions)) => regions
+                    .get(region as usize)
+                    .ok_or(NucleationError::InvalidArgument),
+                _ => Err(NucleationError::InvalidArgument),
+            }
+        }
+
+        fn metadata(
+            &self,
+            schematic: u32,
+            region: u32,
+            index: u32,
+        ) -> Result<&(String, serde_json::Value), NucleationError> {
+            self.region(schematic, region)?
+                .metadata
+                .get(index as usize)
+                .ok_or(NucleationError::InvalidArgument)
+        }
+
+        pub fn schematic_count(&self) -> u32 {
+            self.0.len() as u32
+        }
+
+        /// Whether the schematic's annotations compiled.
+        pub fn is_ok(&self, schematic: u32) -> bool {
+            matches!(self.0.get(schematic as usize), Some(Ok(_)))
+        }
+
+        /// The compile error of a failed schematic. `NotFound` if it
+        /// compiled.
+        pub fn error(
+            &self,
+            schematic: u32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            match self.0.get(schematic as usize) {
+                Some(Err(message)) => {
+                    let _ = write!(out, "{}", message);
+                    Ok(())
+                }
+                Some(Ok(_)) => Err(NucleationError::NotFound),
+                None => Err(NucleationError::InvalidArgument),
+            }
+        }
+
+        /// Regions of the schematic; 0 if it failed.
+        pub fn region_count(&self, schematic: u32) -> u32 {
+            match self.0.get(schematic as usize) {
+                Some(Ok(regions)) => regions.len() as u32,
+                _ => 0,
+            }
+        }
+
+        pub fn region_name(
+            &self,
+            schematic: u32,
+            region: u32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let _ = write!(out, "{}", self.region(schematic, region)?.name);
+            Ok(())
+        }
+
+        /// Boxes of the region; 0 for wildcard and `$global` entries.
+        pub fn box_count(&self, schematic: u32, region: u32) -> Result<u32, NucleationError> {
+            Ok(self.region(schematic, region)?.boxes.len() as u32)
+        }
+
+        /// One absolute, inclusive box of the region.
+        pub fn region_box(
+            &self,
+            schematic: u32,
+            region: u32,
+            index: u32,
+        ) -> Result<RegionBounds, NucleationError> {
+            let (min, max) = *self
+                .region(schematic, region)?
+                .boxes
+                .get(index as usize)
+                .ok_or(NucleationError::InvalidArgument)?;
+            Ok(RegionBounds {
+                min_x: min[0],
+                min_y: min[1],
+                min_z: min[2],
+                max_x: max[0],
+                max_y: max[1],
+                max_z: max[2],
+            })
+        }
+
+        pub fn metadata_count(&self, schematic: u32, region: u32) -> Result<u32, NucleationError> {
+            Ok(self.region(schematic, region)?.metadata.len() as u32)
+        }
+
+        pub fn metadata_key(
+            &self,
+            schematic: u32,
+            region: u32,
+            index: u32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let _ = write!(out, "{}", self.metadata(schematic, region, index)?.0);
+            Ok(())
+        }
+
+        /// A metadata value as text: strings unquoted, anything else as
+        /// JSON (what `import_insign_regions` stores).
+        pub fn metadata_value(
+            &self,
+            schematic: u32,
+            region: u32,
+            index: u32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let (_, value) = self.metadata(schematic, region, index)?;
+            let _ = write!(out, "{}", crate::insign::metadata_text(value));
+            Ok(())
+        }
+
+        /// A metadata value as JSON.
+        pub fn metadata_value_json(
+            &self,
+            schematic: u32,
+            region: u32,
+            index: u32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let (_, value) = self.metadata(schematic, region, index)?;
+            let _ = write!(out, "{}", value);
+            Ok(())
+        }
+    }
+
+    /// A read-only, `Send + Sync` schematic produced by `Schematic::freeze`.
+    /// Every method takes `&self`. The queries (blocks, indices, chunks,
+    /// palettes, fingerprints) read only the frozen storage, so one handle may
+    /// be queried from many threads at once without locking. `save_as_bytes`
+    /// and `start_save_as` also briefly lock the shared format registry to
+    /// look up the exporter. `share` hands out further handles to the same
+    /// storage.
+    #[diplomat::opaque]
+    pub struct FrozenSchematic(pub(crate) std::sync::Arc<crate::UniversalSchematic>);
+
+    impl FrozenSchematic {
+        /// Another handle to the same frozen storage (a reference-count bump).
+        /// Destroy each handle independently; the data lives until the last one
+        /// is gone.
+        pub fn share(&self) -> Box<FrozenSchematic> {
+            Box::new(FrozenSchematic(std::sync::Arc::clone(&self.0)))
+        }
+
+        /// An editable deep copy of the frozen schematic.
+        pub fn thaw(&self) -> Box<Schematic> {
+            Box::new(Schematic((*self.0).clone()))
+        }
+
+        /// The allocated dimensions (width, height, length).
+        pub fn dimensions(&self) -> Dimensions {
+            let (x, y, z) = self.0.get_dimensions();
+            Dimensions { x, y, z }
+        }
+
+        /// The total number of non-air blocks.
+        pub fn block_count(&self) -> i32 {
+            self.0.total_blocks()
+        }
+
+        /// The name of the block at a position. `NotFound` if the position is
+        /// outside every region.
+        pub fn get_block_name(
+            &self,
+            x: i32,
+            y: i32,
+            z: i32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let state = self.0.get_block(x, y, z).ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", state.name);
+            Ok(())
+        }
+
+        /// The full block string (name and properties) at a position.
+        pub fn get_block_string(
+            &self,
+            x: i32,
+            y: i32,
+            z: i32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let state = self.0.get_block(x, y, z).ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", state);
+            Ok(())
+        }
+
+        /// Same as `Schematic::read_indices`.
+        pub fn read_indices(
+            &self,
+            min: BlockPos,
+            max: BlockPos,
+            out: &mut [u32],
+        ) -> Result<(), NucleationError> {
+            self.0
+                .default_region
+                .read_palette_indices((min.x, min.y, min.z), (max.x, max.y, max.z), out)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Same as `Schematic::get_chunks_with_strategy_json`.
+        #[allow(clippy::too_many_arguments)]
+        pub fn get_chunks_with_strategy_json(
+            &self,
+            chunk_width: i32,
+            chunk_height: i32,
+            chunk_length: i32,
+            strategy: &DiplomatStr,
+            camera_x: f32,
+            camera_y: f32,
+            camera_z: f32,
+            out: &mut DiplomatWrite,
+        ) {
+            let strategy_str = std::str::from_utf8(strategy).unwrap_or("");
+            write_chunks_json(
+                &self.0,
+                (chunk_width, chunk_height, chunk_length),
+                strategy_str,
+                (camera_x, camera_y, camera_z),
+                out,
+            );
+        }
+
+        /// Same as `Schematic::chunk_cursor`; advance it with
+        /// `ChunkCursor::advance_frozen`.
+        #[allow(clippy::too_many_arguments)]
+        pub fn chunk_cursor(
+            &self,
+            chunk_width: i32,
+            chunk_height: i32,
+            chunk_length: i32,
+            strategy: &DiplomatStr,
+            camera_x: f32,
+            camera_y: f32,
+            camera_z: f32,
+        ) -> Result<Box<ChunkCursor>, NucleationError> {
+            let strategy = parse_strategy(utf8(strategy)?, (camera_x, camera_y, camera_z));
+            self.0
+                .chunk_cursor(chunk_width, chunk_height, chunk_length, strategy)
+                .map(|cursor| Box::new(ChunkCursor(cursor)))
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Same as `Schematic::region_indices_palette_json`.
+        pub fn region_indices_palette_json(
+            &self,
+            region_name: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            write_region_states_json(region_named(&self.0, utf8(region_name)?)?, out)
+        }
+
+        /// The fingerprint for the given preset, as a hex string (same as
+        /// `Fingerprint::compute`). `InvalidArgument` on an unknown preset.
+        pub fn fingerprint(
+            &self,
+            preset: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let spec = crate::fingerprint::FingerprintSpec::from_preset(utf8(preset)?)
+                .ok_or(NucleationError::InvalidArgument)?;
+            let _ = write!(
+                out,
+                "{}",
+                crate::fingerprint::fingerprint(&self.0, &spec).to_hex()
+            );
+            Ok(())
+        }
+
+        /// Serialize to a named format (same as `Schematic::save_as_bytes`).
+        pub fn save_as_bytes(
+            &self,
+            format: &DiplomatStr,
+            version: &DiplomatStr,
+        ) -> Result<Box<Bytes>, NucleationError> {
+            let fmt = utf8(format)?;
+            let ver = utf8(version)?;
+            let ver = if ver.is_empty() { None } else { Some(ver) };
+            let manager = get_manager();
+            manager
+                .write_with_settings(fmt, &self.0, ver, None)
+                .map(|data| Box::new(Bytes(data)))
+                .map_err(|_| NucleationError::Serialize)
+        }
+
+        /// `save_as_bytes` as a background job sharing this frozen storage.
+        /// Take the bytes with `Job::take_bytes`.
+        pub fn start_save_as(
+            &self,
+            format: &DiplomatStr,
+            version: &DiplomatStr,
+        ) -> Result<Box<Job>, NucleationError> {
+            let fmt = utf8(format)?.to_string();
+            let ver = utf8(version)?.to_string();
+            let schematic = std::sync::Arc::clone(&self.0);
+            Ok(spawn_job(NucleationError::Serialize, move |_| {
+                let ver = if ver.is_empty() {
+                    None
+                } else {
+                    Some(ver.as_str())
+                };
+                let manager = get_manager();
+                manager
+                    .write_with_settings(&fmt, &schematic, ver, None)
+                    .map_err(|_| NucleationError::Serialize)
+            }))
+        }
+
+        /// `fingerprint` as a background job. Take the hex string with
+        /// `Job::take_text`. `InvalidArgument` on an unknown preset.
+        pub fn start_fingerprint(&self, preset: &DiplomatStr) -> Result<Box<Job>, NucleationError> {
+            let spec = crate::fingerprint::FingerprintSpec::from_preset(utf8(preset)?)
+                .ok_or(NucleationError::InvalidArgument)?;
+            let schematic = std::sync::Arc::clone(&self.0);
+            Ok(spawn_job(NucleationError::InvalidArgument, move |_| {
+                Ok(crate::fingerprint::fingerprint(&schematic, &spec).to_hex())
+            }))
+        }
+    }
+
+    /// One-chunk-at-a-time walk from `Schematic::chunk_cursor`. After a
+    /// successful `advance`, `palette_indices` holds the chunk's
+    /// `width * height * length` palette indices (x fastest, then z, then y,
+    /// starting at `chunk_min`) into the palette of region `region_name`
+    /// (see `Schematic::region_indices_palette_json`). The span stays valid until the
+    /// next `advance`. Chunks with no non-air block are skipped.
+    #[diplomat::opaque_mut]
+    pub struct ChunkCursor(pub(crate) crate::universal_schematic::ChunkCursor);
+
+    impl ChunkCursor {
+        /// Load the next chunk of `schematic`. Returns `false` when done.
+        pub fn advance(&mut self, schematic: &Schematic) -> bool {
+            self.0.advance(&schematic.0)
+        }
+
+        /// `advance` for a cursor created by `FrozenSchematic::chunk_cursor`.
+        pub fn advance_frozen(&mut self, schematic: &FrozenSchematic) -> bool {
+            self.0.advance(&schematic.0)
+        }
+
+        /// Chunk coordinate of the current chunk. `NotFound` before the first
+        /// `advance` and after the last.
+        pub fn chunk(&self) -> Result<BlockPos, NucleationError> {
+            self.0
+                .chunk()
+                .map(|(x, y, z)| BlockPos { x, y, z })
+                .ok_or(NucleationError::NotFound)
+        }
+
+        /// Minimum block corner of the current chunk.
+        pub fn chunk_min(&self) -> Result<BlockPos, NucleationError> {
+            self.0
+                .chunk_min()
+                .map(|(x, y, z)| BlockPos { x, y, z })
+                .ok_or(NucleationError::NotFound)
+        }
+
+        pub fn chunk_size(&self) -> Dimensions {
+            let (x, y, z) = self.0.chunk_size();
+            Dimensions { x, y, z }
+        }
+
+        /// Region the current chunk came from; its palette is what
+        /// `palette_indices` refers to.
+        pub fn region_name(&self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let name = self.0.region_name().ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", name);
+            Ok(())
+        }
+
+        pub fn palette_indices<'a>(&'a self) -> &'a [u32] {
+            self.0.indices()
+        }
+
+        /// Chunks not yet visited (an upper bound, as empty chunks are skipped).
+        pub fn remaining(&self) -> u32 {
+            self.0.remaining() as u32
+        }
+    }
+
+    /// A block state: a block name plus its properties. Port of the old
+    /// `BlockStateWrapper` / `blockstate_*` fns.
+    #[diplomat::opaque]
+    pub struct BlockState(pub(crate) crate::BlockState);
+
+    impl BlockState {
+        /// Create a block state with the given name and no properties.
+        pub fn create(name: &DiplomatStr) -> Box<BlockState> {
+            Box::new(BlockState(crate::BlockState::new(
+                String::from_utf8_lossy(name).into_owned(),
+            )))
+        }
+
+        /// A copy of this block state with `key=value` set; the original is
+        /// unchanged.
         pub fn with_property(
             &self,
             key: &DiplomatStr,
@@ -1975,3 +3035,66 @@ mod file_convenience_alias_tests {
         std::fs::remove_file(path).expect("remove test file");
     }
 }
+
+#[cfg(test)]
+mod frozen_schematic_tests {
+    use super::ffi::Schematic;
+
+    #[test]
+    fn freeze_moves_contents_and_reads_from_many_threads() {
+        let mut schematic = Schematic::create(b"frozen");
+        schematic
+            .set_block(1, 2, 3, b"minecraft:stone")
+            .expect("place block");
+        let frozen = schematic.freeze();
+        assert_eq!(schematic.block_count(), 0);
+
+        std::thread::scope(|scope| {
+            for _ in 0..8 {
+                let handle = frozen.share();
+                scope.spawn(move || {
+                    let block = handle.0.get_block(1, 2, 3).expect("block is frozen in");
+                    assert_eq!(block.name, "minecraft:stone");
+                    assert_eq!(handle.block_count(), 1);
+                });
+            }
+        });
+
+        let thawed = frozen.thaw();
+        assert_eq!(thawed.block_count(), 1);
+    }
+}
+
+#[cfg(test)]
+mod chunk_cursor_tests {
+    use super::ffi::Schematic;
+    use super::{region_named, write_region_states_json};
+
+    #[test]
+    fn cursor_indices_decode_to_full_states_in_named_regions() {
+        let stairs = "minecraft:oak_stairs[facing=east,half=bottom]";
+        let mut schematic = Schematic::create(b"cursor");
+        assert!(schematic
+            .0
+            .set_block_in_region_str("Detail", 2, 3, 4, stairs));
+
+        let mut cursor = schematic
+            .chunk_cursor(16, 16, 16, b"bottom_up", 0.0, 0.0, 0.0)
+            .expect("cursor");
+        let mut decoded = Vec::new();
+        while cursor.advance(&schematic) {
+            let region = cursor.0.region_name().expect("region").to_string();
+            let mut json = String::new();
+            write_region_states_json(
+                region_named(&schematic.0, &region).expect("region exists"),
+                &mut json,
+            )
+            .expect("palette json");
+            let palette: Vec<String> = serde_json::from_str(&json).expect("valid json");
+            let min = cursor.chunk_min().expect("chunk loaded");
+            let offset = ((4 - min.z) * 16 + (2 - min.x)) as usize + (3 - min.y) as usize * 256;
+            decoded.push(palette[cursor.palette_indices()[offset] as usize].clone());
+        }
+        assert_eq!(decoded, vec![stairs.to_string()]);
+    }
+}
@@ -1,4 +1,5 @@
 //! Text-template schematic builder. Port of `ffi/schematic_builder.rs`.
+//! `ImageBuilder` (pixel art and map art from image buffers) is bridge-only.
 //!
 //! Omitted from port: `schematicbuilder_free` — destructor is generated.
 //! Omitted from port: `schematicbuilder_build_with_error` — error-string transport
@@ -7,6 +8,7 @@
 
 #[diplomat::bridge]
 pub mod ffi {
+    use super::super::building::ffi::Palette;
     use super::super::schematic::ffi::Schematic;
     use super::super::shared::ffi::NucleationError;
     use diplomat_runtime::DiplomatWrite;
@@ -169,4 +171,110 @@ pub mod ffi {
             Ok(())
         }
     }
+
+    /// Bulk builder for pixel art, map art and heightmaps: whole RGBA images
+    /// are matched against a `Palette` at once and written as block rows,
+    /// without text layers. Setters may be called in any order; builds do
+    /// not consume the builder.
+    #[diplomat::opaque_mut]
+    pub struct ImageBuilder(crate::schematic_builder::image::ImageBuilder);
+
+    impl ImageBuilder {
+        /// A builder matching pixels against `palette`: a flat floor image
+        /// at the origin, no dithering, stone supports and fill.
+        pub fn create(palette: &Palette) -> Box<ImageBuilder> {
+            Box::new(ImageBuilder(
+                crate::schematic_builder::image::ImageBuilder::new(palette.0.clone()),
+            ))
+        }
+
+        /// Set the schematic name.
+        pub fn name(&mut self, name: &DiplomatStr) -> Result<(), NucleationError> {
+            let name = std::str::from_utf8(name).map_err(|_| NucleationError::InvalidArgument)?;
+            self.0 = self.0.clone().name(name);
+            Ok(())
+        }
+
+        /// Ordered (Bayer) dithering between the two nearest blocks.
+        pub fn dither(&mut self, dither: bool) {
+            self.0 = self.0.clone().dither(dither);
+        }
+
+        /// Stand the image up (pixel rows along Y, top row highest) instead
+        /// of laying it on the floor.
+        pub fn wall(&mut self, wall: bool) {
+            use crate::schematic_builder::image::ImageOrientation;
+            let orientation = if wall {
+                ImageOrientation::Wall
+            } else {
+                ImageOrientation::Floor
+            };
+            self.0 = self.0.clone().orientation(orientation);
+        }
+
+        /// Map-art staircase shading (floor images only): each block steps
+        /// up, level or down from its northern neighbour so a map shows its
+        /// light, normal or dark shade.
+        pub fn staircase(&mut self, staircase: bool) {
+            use crate::schematic_builder::image::MapShading;
+            let shading = if staircase {
+                MapShading::Staircase
+            } else {
+                MapShading::Flat
+            };
+            self.0 = self.0.clone().shading(shading);
+        }
+
+        /// Set the build offset applied to every placed block.
+        pub fn offset(&mut self, x: i32, y: i32, z: i32) {
+            self.0 = self.0.clone().offset(x, y, z);
+        }
+
+        /// Block id under staircased blocks and in the support row.
+        pub fn support_block(&mut self, block: &DiplomatStr) -> Result<(), NucleationError> {
+            let block = std::str::from_utf8(block).map_err(|_| NucleationError::InvalidArgument)?;
+            self.0 = self.0.clone().support_block(block);
+            Ok(())
+        }
+
+        /// Block id filling heightmap columns below their surface.
+        pub fn fill_block(&mut self, block: &DiplomatStr) -> Result<(), NucleationError> {
+            let block = std::str::from_utf8(block).map_err(|_| NucleationError::InvalidArgument)?;
+            self.0 = self.0.clone().fill_block(block);
+            Ok(())
+        }
+
+        /// Build from an RGBA image (4 bytes per pixel, rows top to bottom).
+        /// Pixels with alpha below 128 stay empty. Errors with
+        /// `InvalidArgument` on a size mismatch, an empty palette, or
+        /// staircase shading on a wall.
+        pub fn build_rgba(
+            &self,
+            rgba: &[u8],
+            width: u32,
+            height: u32,
+        ) -> Result<Box<Schematic>, NucleationError> {
+            self.0
+                .build_rgba(rgba, width as usize, height as usize)
+                .map(|s| Box::new(Schematic(s)))
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Build terrain from one height per pixel (row-major). With a
+        /// non-empty `rgba` of the same size, each column's top block is
+        /// that pixel's palette match.
+        pub fn build_heightmap(
+            &self,
+            heights: &[u16],
+            width: u32,
+            height: u32,
+            rgba: &[u8],
+        ) -> Result<Box<Schematic>, NucleationError> {
+            let colors = (!rgba.is_empty()).then_some(rgba);
+            self.0
+                .build_heightmap(heights, width as usize, height as usize, colors)
+                .map(|s| Box::new(Schematic(s)))
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+    }
 }
@@ -70,4 +70,71 @@ pub mod ffi {
             }
         }
     }
+
+    /// Warm script VMs, one per engine, kept between runs with the bindings
+    /// registered; globals are reset after every run. Cheaper than the
+    /// `Scripting` runners, which start a VM per call.
+    #[diplomat::opaque_mut]
+    pub struct ScriptContext(crate::scripting::ScriptContext);
+
+    impl ScriptContext {
+        pub fn create() -> Box<ScriptContext> {
+            Box::new(ScriptContext(crate::scripting::ScriptContext::new()))
+        }
+
+        /// Per-run ceilings on VM instructions and heap bytes; 0 means
+        /// unlimited.
+        pub fn set_limits(&mut self, max_instructions: u64, max_memory: u64) {
+            self.0.set_limits(crate::scripting::ScriptLimits {
+                max_instructions: (max_instructions > 0).then_some(max_instructions),
+                max_memory: (max_memory > 0).then(|| max_memory.try_into().unwrap_or(usize::MAX)),
+            });
+        }
+
+        /// Run `code` with `engine` ("lua" or "js"). Returns the schematic the
+        /// script assigns to `result`; `NotFound` if it produced none, `Parse` if
+        /// it failed or hit a limit, and `InvalidArgument` for an engine that is
+        /// unknown or compiled out.
+        pub fn run_code(
+            &mut self,
+            engine: &DiplomatStr,
+            code: &DiplomatStr,
+        ) -> Result<Box<Schematic>, NucleationError> {
+            let engine =
+                std::str::from_utf8(engine).map_err(|_| NucleationError::InvalidArgument)?;
+            let code = std::str::from_utf8(code).map_err(|_| NucleationError::InvalidArgument)?;
+            if !crate::scripting::ScriptContext::supports(engine) {
+                return Err(NucleationError::InvalidArgument);
+            }
+            match self.0.run_code(engine, code) {
+                Ok(Some(ss)) => Ok(Box::new(Schematic(ss.inner))),
+                Ok(None) => Err(NucleationError::NotFound),
+                Err(_) => Err(NucleationError::Parse),
+            }
+        }
+
+        /// `run_code` with `params_json` (any JSON value) readable by the script
+        /// as the `params` global, so one cached script serves many inputs.
+        /// `Parse` also covers malformed JSON.
+        pub fn run_code_with_params(
+            &mut self,
+            engine: &DiplomatStr,
+            code: &DiplomatStr,
+            params_json: &DiplomatStr,
+        ) -> Result<Box<Schematic>, NucleationError> {
+            let engine =
+                std::str::from_utf8(engine).map_err(|_| NucleationError::InvalidArgument)?;
+            let code = std::str::from_utf8(code).map_err(|_| NucleationError::InvalidArgument)?;
+            let params: serde_json::Value =
+                serde_json::from_slice(params_json).map_err(|_| NucleationError::Parse)?;
+            if !crate::scripting::ScriptContext::supports(engine) {
+                return Err(NucleationError::InvalidArgument);
+            }
+            match self.0.run_code_with_params(engine, code, &params) {
+                Ok(Some(ss)) => Ok(Box::new(Schematic(ss.inner))),
+                Ok(None) => Err(NucleationError::NotFound),
+                Err(_) => Err(NucleationError::Parse),
+            }
+        }
+    }
 }
@@ -4,6 +4,8 @@
 pub mod ffi {
     use super::super::schematic::ffi::Schematic;
     use super::super::shared::ffi::NucleationError;
+    #[cfg(not(target_arch = "wasm32"))]
+    use super::super::world_stream::ffi::ShardedWorldSink;
 
     /// Namespace for the SDF free functions of the old ABI (`schematic_from_sdf`,
     /// `sdf_eval`).
@@ -60,6 +62,48 @@ pub mod ffi {
                 .map_err(|_| NucleationError::InvalidArgument)
         }
 
+        /// Sample an SDF tree straight into a world through `sink`, one chunk
+        /// column per worker, instead of building a schematic — for scenes
+        /// too big to hold in memory. Blocks match `schematic_from_sdf` with
+        /// the same arguments (block-entity NBT in rule blocks is dropped),
+        /// and there is no volume cap. Bounds work as for
+        /// `schematic_from_sdf`. The caller still calls `finish` on the sink.
+        /// Errors `Parse` on bad JSON, `InvalidArgument` on bad bounds or
+        /// rules, `AlreadyConsumed` on a finished sink, `Lock` on a poisoned
+        /// sink.
+        #[allow(clippy::too_many_arguments)]
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn sdf_to_world(
+            sdf_json: &DiplomatStr,
+            rules_json: &DiplomatStr,
+            has_bounds: bool,
+            min_x: i32,
+            min_y: i32,
+            min_z: i32,
+            max_x: i32,
+            max_y: i32,
+            max_z: i32,
+            sink: &ShardedWorldSink,
+        ) -> Result<(), NucleationError> {
+            let sdf_str =
+                std::str::from_utf8(sdf_json).map_err(|_| NucleationError::InvalidArgument)?;
+            let rules_str =
+                std::str::from_utf8(rules_json).map_err(|_| NucleationError::InvalidArgument)?;
+
+            let node =
+                crate::sdf::SdfNode::from_json(sdf_str).map_err(|_| NucleationError::Parse)?;
+            let rules = crate::sdf::MaterialRules::from_json(rules_str)
+                .map_err(|_| NucleationError::Parse)?;
+            let bounds = has_bounds.then_some(crate::sdf::SampleBounds {
+                min: [min_x, min_y, min_z],
+                max: [max_x, max_y, max_z],
+            });
+            let guard = sink.0.read().map_err(|_| NucleationError::Lock)?;
+            let sink = guard.as_ref().ok_or(NucleationError::AlreadyConsumed)?;
+            crate::sdf::sample_to_world(&node, &rules, bounds, sink)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
         /// Evaluates an SDF JSON tree at a point, returning the signed distance.
         pub fn eval(
             sdf_json: &DiplomatStr,
@@ -1,4 +1,73 @@
-//! Types shared by every bridge module: the unified error enum and small POD structs.
+//! Types shared by every bridge module: the unified error enum, small POD structs,
+//! the owned `Bytes` buffer binary serializers return, and the reusable
+//! `ResultBuffer` the `_into` variants fill. Also the streaming JSON helpers the
+//! large `_json` exporters write through.
+
+use diplomat_runtime::DiplomatWrite;
+use std::fmt::Write as _;
+
+/// `io::Write` over a [`DiplomatWrite`] (or a [`TextSink`]), so `serde_json` can
+/// serialize straight into the caller's writeable instead of materializing a
+/// `String` first. The writeable grows (or drains, for a custom C++ `WriteTrait`
+/// sink) as bytes arrive, so peak Rust-side memory is one element, not the whole
+/// document.
+pub(crate) struct JsonSink<'a, W: std::fmt::Write + ?Sized = DiplomatWrite>(pub(crate) &'a mut W);
+
+impl<W: std::fmt::Write + ?Sized> std::io::Write for JsonSink<'_, W> {
+    fn write(&mut self, buf: &[u8]) -> std::io::Result<usize> {
+        // serde_json only splits its output at ASCII token boundaries, so every
+        // chunk it hands us is valid UTF-8 on its own.
+        let text = std::str::from_utf8(buf)
+            .map_err(|e| std::io::Error::new(std::io::ErrorKind::InvalidData, e))?;
+        self.0
+            .write_str(text)
+            .map_err(|_| std::io::Error::other("writeable rejected output"))?;
+        Ok(buf.len())
+    }
+
+    fn flush(&mut self) -> std::io::Result<()> {
+        Ok(())
+    }
+}
+
+/// Stream `items` into `out` as a JSON array, one element at a time.
+pub(crate) fn write_json_array<T: serde::Serialize, W: std::fmt::Write + ?Sized>(
+    out: &mut W,
+    items: impl IntoIterator<Item = T>,
+) -> Result<(), ffi::NucleationError> {
+    let _ = out.write_char('[');
+    for (i, item) in items.into_iter().enumerate() {
+        if i > 0 {
+            let _ = out.write_char(',');
+        }
+        serde_json::to_writer(JsonSink(&mut *out), &item)
+            .map_err(|_| ffi::NucleationError::Serialize)?;
+    }
+    let _ = out.write_char(']');
+    Ok(())
+}
+
+/// `fmt::Write` over a [`ffi::ResultBuffer`]'s bytes, so text results use the
+/// same `write!` calls as a `DiplomatWrite`.
+pub(crate) struct TextSink<'a>(&'a mut Vec<u8>);
+
+impl std::fmt::Write for TextSink<'_> {
+    fn write_str(&mut self, s: &str) -> std::fmt::Result {
+        self.0.extend_from_slice(s.as_bytes());
+        Ok(())
+    }
+}
+
+/// Empty `buf` for a new result, keeping its allocation.
+pub(crate) fn refill(buf: &mut ffi::ResultBuffer) -> &mut Vec<u8> {
+    buf.0.clear();
+    &mut buf.0
+}
+
+/// [`refill`] for a text result.
+pub(crate) fn refill_text(buf: &mut ffi::ResultBuffer) -> TextSink<'_> {
+    TextSink(refill(buf))
+}
 
 #[diplomat::bridge]
 pub mod ffi {
@@ -20,6 +89,7 @@ pub mod ffi {
         Simulation,
         AlreadyConsumed,
         NotFound,
+        Cancelled,
     }
 
     #[diplomat::attr(auto, abi_compatible)]
@@ -37,4 +107,74 @@ pub mod ffi {
         pub y: i32,
         pub z: i32,
     }
+
+    /// An owned byte buffer returned by the binary serializers (`to_*_bytes`,
+    /// `save_as_bytes`). `data` borrows the bytes for the lifetime of the handle,
+    /// so C/C++ callers can hand a large export straight to a file or socket
+    /// instead of paying the size blow-up and decode of the `_b64` variants.
+    #[diplomat::opaque]
+    pub struct Bytes(pub(crate) Vec<u8>);
+
+    impl Bytes {
+        /// The buffer contents, valid until this handle is destroyed.
+        pub fn data<'a>(&'a self) -> &'a [u8] {
+            &self.0
+        }
+
+        /// Length of the buffer in bytes.
+        pub fn len(&self) -> usize {
+            self.0.len()
+        }
+
+        /// `true` if the buffer holds no bytes.
+        pub fn is_empty(&self) -> bool {
+            self.0.is_empty()
+        }
+    }
+
+    /// A caller-owned result buffer the `_into` methods fill in place of a
+    /// fresh `DiplomatWrite` string or `Bytes` handle. Each fill replaces the
+    /// previous contents but keeps the allocation, so a polling loop that
+    /// reuses one buffer stops allocating once it has grown to the largest
+    /// result. Text results are UTF-8; binary results are raw bytes, not
+    /// base64.
+    #[diplomat::opaque_mut]
+    pub struct ResultBuffer(pub(crate) Vec<u8>);
+
+    impl ResultBuffer {
+        pub fn create() -> Box<ResultBuffer> {
+            Box::new(ResultBuffer(Vec::new()))
+        }
+
+        /// The last result, valid until the buffer is filled again or
+        /// destroyed.
+        pub fn data<'a>(&'a self) -> &'a [u8] {
+            &self.0
+        }
+
+        /// Length of the last result in bytes.
+        pub fn len(&self) -> usize {
+            self.0.len()
+        }
+
+        /// `true` if the last result was empty.
+        pub fn is_empty(&self) -> bool {
+            self.0.is_empty()
+        }
+
+        /// Bytes the buffer can hold before it must grow.
+        pub fn capacity(&self) -> usize {
+            self.0.capacity()
+        }
+
+        /// Drop the contents, keeping the allocation.
+        pub fn clear(&mut self) {
+            self.0.clear();
+        }
+
+        /// Release the allocation, e.g. after one outsized result.
+        pub fn shrink(&mut self) {
+            self.0 = Vec::new();
+        }
+    }
 }
@@ -213,7 +213,8 @@ pub mod ffi {
     use crate::definition_region::DefinitionRegion;
     use crate::simulation::circuit_builder::CircuitBuilder as InnerCircuitBuilder;
     use crate::simulation::typed_executor::{
-        ExecutionMode as InnerExecutionMode, IoLayout as InnerIoLayout,
+        BatchResult as InnerBatchResult, ExecutionMode as InnerExecutionMode,
+        InputBatch as InnerInputBatch, IoLayout as InnerIoLayout,
         IoLayoutBuilder as InnerIoLayoutBuilder, IoType as InnerIoType,
         LayoutFunction as InnerLayoutFunction, OutputCondition as InnerOutputCondition,
         SortStrategy as InnerSortStrategy, TypedCircuitExecutor as InnerTypedCircuitExecutor,
@@ -331,6 +332,64 @@ pub mod ffi {
             self.0.get_signal_strength(MPos::new(x, y, z))
         }
 
+        /// Set the signal strengths of many custom IO positions in one call.
+        /// `positions` is flat `[x,y,z, x,y,z, ...]` with one strength per
+        /// triple.
+        pub fn set_signals_batch(
+            &mut self,
+            positions: &[i32],
+            strengths: &[u8],
+        ) -> Result<(), NucleationError> {
+            let positions = super::positions_from_flat(positions);
+            self.0
+                .set_signals_batch(&positions, strengths)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Read the signal strengths of many positions in one call into
+        /// `out`, one per `[x,y,z]` triple of `positions`. For repeated reads
+        /// of the same positions, `create_probe` + `read_probe` skips the
+        /// per-call position decoding.
+        pub fn get_signals_batch(
+            &self,
+            positions: &[i32],
+            out: &mut [u8],
+        ) -> Result<(), NucleationError> {
+            let positions = super::positions_from_flat(positions);
+            let probe = self
+                .0
+                .probe(&positions, crate::simulation::ProbeKind::SignalStrength);
+            self.0
+                .read_probe(&probe, out)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Register a fixed position set (flat `[x,y,z, ...]`) to read as a
+        /// whole with `read_probe`, e.g. every wire a visualizer draws.
+        pub fn create_probe(
+            &self,
+            positions: &[i32],
+            kind: ProbeKind,
+        ) -> Result<Box<SignalProbe>, NucleationError> {
+            let positions = super::positions_from_flat(positions);
+            Ok(Box::new(SignalProbe(
+                self.0.probe(&positions, kind.to_core()),
+            )))
+        }
+
+        /// Read every position of `probe` into `out` (one byte each, in
+        /// registration order). `out` must hold exactly `probe.len()` bytes.
+        /// Power and lamp reads see flushed state: `flush` after ticking.
+        pub fn read_probe(
+            &self,
+            probe: &SignalProbe,
+            out: &mut [u8],
+        ) -> Result<(), NucleationError> {
+            self.0
+                .read_probe(&probe.0, out)
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
         /// Simulate a right-click on a block (typically a lever).
         pub fn on_use_block(&mut self, x: i32, y: i32, z: i32) {
             self.0.on_use_block(MPos::new(x, y, z));
@@ -341,6 +400,13 @@ pub mod ffi {
             self.0.sync_to_schematic();
         }
 
+        /// Sync the simulation state back to the internal schematic and
+        /// return the blocks written. The first sync reports every block,
+        /// later ones only those that changed since.
+        pub fn sync_changes(&mut self) -> Box<BlockChanges> {
+            Box::new(BlockChanges::new(self.0.sync_changes()))
+        }
+
         /// A clone of the world's schematic.
         pub fn get_schematic(&self) -> Box<Schematic> {
             Box::new(Schematic(self.0.get_schematic().clone()))
@@ -391,6 +457,86 @@ pub mod ffi {
                 .map(|g| Box::new(RedstoneGraph(g)))
                 .map_err(|_| NucleationError::Simulation)
         }
+
+        /// `export_graph` straight to typed arrays, without keeping the
+        /// node list.
+        pub fn export_compact_graph(&self) -> Result<Box<CompactRedstoneGraph>, NucleationError> {
+            self.0
+                .export_graph()
+                .map(|g| Box::new(CompactRedstoneGraph(g.to_compact())))
+                .map_err(|_| NucleationError::Simulation)
+        }
+    }
+
+    /// What a `SignalProbe` reads at each position.
+    pub enum ProbeKind {
+        /// As `get_signal_strength` (0-15).
+        SignalStrength,
+        /// As `get_redstone_power` (0-15).
+        RedstonePower,
+        /// As `is_lit`, 0 or 1.
+        Lit,
+    }
+
+    impl ProbeKind {
+        fn to_core(self) -> crate::simulation::ProbeKind {
+            match self {
+                ProbeKind::SignalStrength => crate::simulation::ProbeKind::SignalStrength,
+                ProbeKind::RedstonePower => crate::simulation::ProbeKind::RedstonePower,
+                ProbeKind::Lit => crate::simulation::ProbeKind::Lit,
+            }
+        }
+    }
+
+    /// A registered position set of an `MchprsWorld`, read in one call by
+    /// `MchprsWorld::read_probe`. Wraps [`crate::simulation::SignalProbe`].
+    #[diplomat::opaque]
+    pub struct SignalProbe(pub(crate) crate::simulation::SignalProbe);
+
+    impl SignalProbe {
+        /// Number of positions, i.e. the bytes `read_probe` writes.
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+    }
+
+    /// Blocks written by a `sync_changes` call, ordered by position.
+    #[diplomat::opaque]
+    pub struct BlockChanges {
+        positions: Vec<i32>,
+        blocks: Vec<String>,
+    }
+
+    impl BlockChanges {
+        fn new(changes: Vec<((i32, i32, i32), crate::BlockState)>) -> Self {
+            let mut positions = Vec::with_capacity(changes.len() * 3);
+            let mut blocks = Vec::with_capacity(changes.len());
+            for ((x, y, z), block) in changes {
+                positions.extend_from_slice(&[x, y, z]);
+                blocks.push(block.to_string());
+            }
+            BlockChanges { positions, blocks }
+        }
+
+        /// Number of changed blocks.
+        pub fn len(&self) -> u32 {
+            self.blocks.len() as u32
+        }
+
+        /// Changed positions as flat `[x0, y0, z0, x1, ...]`.
+        pub fn positions<'a>(&'a self) -> &'a [i32] {
+            &self.positions
+        }
+
+        /// Block state string (`minecraft:name[props]`) of change `index`.
+        pub fn block(&self, index: u32, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let block = self
+                .blocks
+                .get(index as usize)
+                .ok_or(NucleationError::InvalidArgument)?;
+            let _ = write!(out, "{}", block);
+            Ok(())
+        }
     }
 
     // ─── Value ───────────────────────────────────────────────────────────────
@@ -1357,6 +1503,42 @@ pub mod ffi {
             .map_err(|_| NucleationError::Simulation)
         }
 
+        /// `from_insign` through a process-wide cache keyed by the schematic's
+        /// exact fingerprint, so repeated schematics skip sign parsing and
+        /// layout building.
+        pub fn from_insign_cached(
+            schematic: &Schematic,
+        ) -> Result<Box<TypedCircuitExecutor>, NucleationError> {
+            crate::simulation::typed_executor::create_executor_from_insign_cached(&schematic.0)
+                .map(|e| Box::new(TypedCircuitExecutor(e)))
+                .map_err(|_| NucleationError::Simulation)
+        }
+
+        /// `from_insign_with_options` through the same cache; the options
+        /// are part of the key.
+        pub fn from_insign_with_options_cached(
+            schematic: &Schematic,
+            optimize: bool,
+            io_only: bool,
+        ) -> Result<Box<TypedCircuitExecutor>, NucleationError> {
+            let options = SimulationOptions {
+                optimize,
+                io_only,
+                custom_io: Vec::new(),
+            };
+            crate::simulation::typed_executor::create_executor_from_insign_with_options_cached(
+                &schematic.0,
+                options,
+            )
+            .map(|e| Box::new(TypedCircuitExecutor(e)))
+            .map_err(|_| NucleationError::Simulation)
+        }
+
+        /// Empty the cache behind the `*_cached` constructors.
+        pub fn clear_insign_cache() {
+            crate::simulation::typed_executor::clear_insign_cache();
+        }
+
         /// Set the state mode ("stateless" | "stateful" | "manual").
         pub fn set_state_mode(&mut self, mode: &DiplomatStr) -> Result<(), NucleationError> {
             let mode = std::str::from_utf8(mode).map_err(|_| NucleationError::InvalidArgument)?;
@@ -1423,6 +1605,21 @@ pub mod ffi {
             Ok(())
         }
 
+        /// Execute once per vector of a columnar batch. Columns hold each
+        /// port's raw binary encoding (LSB first), so ports are limited to
+        /// 64 bits; see
+        /// [`crate::simulation::typed_executor::TypedCircuitExecutor::execute_batch`].
+        pub fn execute_batch(
+            &mut self,
+            inputs: &InputBatch,
+            mode: &ExecutionMode,
+        ) -> Result<Box<BatchResult>, NucleationError> {
+            self.0
+                .execute_batch(&inputs.0, &mode.0)
+                .map(|r| Box::new(BatchResult(r)))
+                .map_err(|_| NucleationError::Simulation)
+        }
+
         /// Input names as a JSON array string.
         pub fn input_names_json(&self, out: &mut DiplomatWrite) {
             let names: Vec<&str> = self.0.input_names();
@@ -1448,6 +1645,137 @@ pub mod ffi {
         pub fn sync_to_schematic(&mut self) -> Box<Schematic> {
             Box::new(Schematic(self.0.sync_and_get_schematic().clone()))
         }
+
+        /// Sync the simulation state and return just the changed blocks,
+        /// instead of cloning the whole schematic.
+        pub fn sync_changes(&mut self) -> Box<BlockChanges> {
+            Box::new(BlockChanges::new(self.0.sync_changes()))
+        }
+    }
+
+    // ─── InputBatch / BatchResult ────────────────────────────────────────────
+
+    /// Columnar input vectors for [`TypedCircuitExecutor::execute_batch`].
+    #[diplomat::opaque_mut]
+    pub struct InputBatch(pub(crate) InnerInputBatch);
+
+    impl InputBatch {
+        /// An empty batch of `len` vectors.
+        pub fn create(len: u32) -> Box<InputBatch> {
+            Box::new(InputBatch(InnerInputBatch::new(len as usize)))
+        }
+
+        /// Set input `name`'s column: one raw value per vector.
+        pub fn set_column(
+            &mut self,
+            name: &DiplomatStr,
+            values: &[u64],
+        ) -> Result<(), NucleationError> {
+            let name = std::str::from_utf8(name).map_err(|_| NucleationError::InvalidArgument)?;
+            self.0
+                .set_column(name, values.to_vec())
+                .map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Number of vectors.
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
+    }
+
+    /// Columnar results of a batch execution, one column per output in name
+    /// order.
+    #[diplomat::opaque]
+    pub struct BatchResult(pub(crate) InnerBatchResult);
+
+    impl BatchResult {
+        /// Number of vectors.
+        pub fn len(&self) -> u32 {
+            self.0.len as u32
+        }
+
+        /// Number of output columns.
+        pub fn output_count(&self) -> u32 {
+            self.0.output_names.len() as u32
+        }
+
+        /// Name of output column `index`.
+        pub fn output_name(
+            &self,
+            index: u32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let name = self
+                .0
+                .output_names
+                .get(index as usize)
+                .ok_or(NucleationError::NotFound)?;
+            let _ = write!(out, "{}", name);
+            Ok(())
+        }
+
+        /// Output column `index` (raw binary encodings); empty if out of
+        /// range.
+        pub fn column<'a>(&'a self, index: u32) -> &'a [u64] {
+            self.0
+                .outputs
+                .get(index as usize)
+                .map_or(&[][..], |c| c.as_slice())
+        }
+
+        /// Ticks elapsed for each vector.
+        pub fn ticks_elapsed<'a>(&'a self) -> &'a [u32] {
+            &self.0.ticks_elapsed
+        }
+
+        /// Whether each vector's execution condition was met.
+        pub fn condition_met<'a>(&'a self) -> &'a [bool] {
+            &self.0.condition_met
+        }
+    }
+
+    // ─── ExecutorPool ─────────────────────────────────────────────────────────
+
+    /// Worker threads each driving their own instance of one circuit. Wraps
+    /// [`crate::simulation::typed_executor::ExecutorPool`].
+    #[cfg(not(target_arch = "wasm32"))]
+    #[diplomat::opaque]
+    pub struct ExecutorPool(pub(crate) crate::simulation::typed_executor::ExecutorPool);
+
+    #[cfg(not(target_arch = "wasm32"))]
+    impl ExecutorPool {
+        /// Start `workers` instances (`0` = one per core) of the circuit
+        /// `executor` was built from. Its current simulation state is not
+        /// copied.
+        pub fn from_executor(
+            executor: &TypedCircuitExecutor,
+            workers: u32,
+        ) -> Result<Box<ExecutorPool>, NucleationError> {
+            crate::simulation::typed_executor::ExecutorPool::from_executor(
+                &executor.0,
+                workers as usize,
+            )
+            .map(|p| Box::new(ExecutorPool(p)))
+            .map_err(|_| NucleationError::Simulation)
+        }
+
+        /// Number of worker instances.
+        pub fn worker_count(&self) -> u32 {
+            self.0.worker_count() as u32
+        }
+
+        /// `TypedCircuitExecutor::execute_batch` spread across the workers;
+        /// results are in input order.
+        pub fn execute_batch(
+            &self,
+            inputs: &InputBatch,
+            mode: &ExecutionMode,
+        ) -> Result<Box<BatchResult>, NucleationError> {
+            self.0
+                .execute_batch(&inputs.0, &mode.0)
+                .map(|r| Box::new(BatchResult(r)))
+                .map_err(|_| NucleationError::Simulation)
+        }
     }
 
     // ─── RedstoneGraph ───────────────────────────────────────────────────────
@@ -1533,5 +1861,244 @@ pub mod ffi {
                 .map(|g| Box::new(RedstoneGraph(g)))
                 .map_err(|_| NucleationError::Parse)
         }
+
+        /// The graph as typed arrays, for large graphs where the JSON
+        /// getters are too slow.
+        pub fn to_compact(&self) -> Box<CompactRedstoneGraph> {
+            Box::new(CompactRedstoneGraph(self.0.to_compact()))
+        }
+    }
+
+    /// Scalar graph features (`RedstoneGraph::features_json` without the
+    /// kind map; see `CompactRedstoneGraph::kind_counts_into`).
+    pub struct GraphMetrics {
+        pub node_count: u32,
+        pub edge_count: u32,
+        pub has_cycles: bool,
+        pub critical_path: u32,
+        pub delay_weighted_depth: u32,
+        pub scc_count: u32,
+        pub largest_scc: u32,
+        pub weakly_connected_components: u32,
+        pub max_fan_in: u32,
+        pub max_fan_out: u32,
+        pub approx_input_count: u32,
+        pub approx_output_count: u32,
+    }
+
+    /// A redstone graph as flat arrays. Wraps
+    /// [`crate::simulation::graph::CompactGraph`], which documents the
+    /// layout: per-node arrays indexed by node id, and edges as compressed
+    /// sparse rows by target (`in_offsets`) and by source (`out_offsets`).
+    /// Slices borrow from this handle.
+    #[diplomat::opaque]
+    pub struct CompactRedstoneGraph(pub(crate) crate::simulation::graph::CompactGraph);
+
+    impl CompactRedstoneGraph {
+        pub fn node_count(&self) -> u32 {
+            self.0.node_count() as u32
+        }
+
+        pub fn edge_count(&self) -> u32 {
+            self.0.edge_count() as u32
+        }
+
+        /// Kind code per node; see `kind_name`.
+        pub fn kinds<'a>(&'a self) -> &'a [u8] {
+            &self.0.kinds
+        }
+
+        /// The name of a kind code ("Repeater", "Comparator", ...).
+        pub fn kind_name(code: u8, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let name = crate::simulation::graph::NODE_KIND_NAMES
+                .get(code as usize)
+                .ok_or(NucleationError::InvalidArgument)?;
+            let _ = write!(out, "{}", name);
+            Ok(())
+        }
+
+        /// Repeater delay or comparator mode (0 compare, 1 subtract) per
+        /// node, else 0.
+        pub fn params<'a>(&'a self) -> &'a [u8] {
+            &self.0.params
+        }
+
+        /// Comparator far input per node; 255 when absent.
+        pub fn far_inputs<'a>(&'a self) -> &'a [u8] {
+            &self.0.far_inputs
+        }
+
+        pub fn output_strengths<'a>(&'a self) -> &'a [u8] {
+            &self.0.output_strengths
+        }
+
+        /// Bits per node: 1 has a position, 2 powered, 4 repeater locked,
+        /// 8 facing a diode.
+        pub fn flags<'a>(&'a self) -> &'a [u8] {
+            &self.0.flags
+        }
+
+        /// `x, y, z` per node; zero when the node has no position.
+        pub fn positions<'a>(&'a self) -> &'a [i32] {
+            &self.0.positions
+        }
+
+        /// `node_count + 1` offsets into `aliased_blocks`, in blocks.
+        pub fn alias_offsets<'a>(&'a self) -> &'a [u32] {
+            &self.0.alias_offsets
+        }
+
+        /// `x, y, z` per aliased block.
+        pub fn aliased_blocks<'a>(&'a self) -> &'a [i32] {
+            &self.0.aliased_blocks
+        }
+
+        /// `node_count + 1` offsets into the edge arrays, which are grouped
+        /// by target.
+        pub fn in_offsets<'a>(&'a self) -> &'a [u32] {
+            &self.0.in_offsets
+        }
+
+        pub fn edge_sources<'a>(&'a self) -> &'a [u32] {
+            &self.0.edge_sources
+        }
+
+        pub fn edge_targets<'a>(&'a self) -> &'a [u32] {
+            &self.0.edge_targets
+        }
+
+        /// Signal-strength loss per edge.
+        pub fn edge_weights<'a>(&'a self) -> &'a [u8] {
+            &self.0.edge_weights
+        }
+
+        /// 0 default, 1 side, per edge.
+        pub fn edge_kinds<'a>(&'a self) -> &'a [u8] {
+            &self.0.edge_kinds
+        }
+
+        /// `node_count + 1` offsets into `out_targets`.
+        pub fn out_offsets<'a>(&'a self) -> &'a [u32] {
+            &self.0.out_offsets
+        }
+
+        pub fn out_targets<'a>(&'a self) -> &'a [u32] {
+            &self.0.out_targets
+        }
+
+        /// Node count per kind code into `out`, which must hold exactly
+        /// `kind_code_count()` ints.
+        pub fn kind_counts_into(&self, out: &mut [u32]) -> Result<(), NucleationError> {
+            let counts = self.0.kind_counts();
+            if out.len() != counts.len() {
+                return Err(NucleationError::InvalidArgument);
+            }
+            for (slot, count) in out.iter_mut().zip(counts) {
+                *slot = count as u32;
+            }
+            Ok(())
+        }
+
+        /// Number of kind codes.
+        pub fn kind_code_count() -> u32 {
+            crate::simulation::graph::NODE_KIND_NAMES.len() as u32
+        }
+
+        /// Component (strongly connected) id per node into `out`, which
+        /// must hold exactly `node_count()` ints. Returns the number of
+        /// components.
+        pub fn scc_ids_into(&self, out: &mut [u32]) -> Result<u32, NucleationError> {
+            if out.len() != self.0.node_count() {
+                return Err(NucleationError::InvalidArgument);
+            }
+            let sccs = self.0.strongly_connected_components();
+            for (id, members) in sccs.iter().enumerate() {
+                for &node in members {
+                    out[node] = id as u32;
+                }
+            }
+            Ok(sccs.len() as u32)
+        }
+
+        /// All scalar features, from one SCC pass.
+        pub fn metrics(&self) -> GraphMetrics {
+            Self::metrics_of(&self.0.features())
+        }
+
+        fn metrics_of(f: &crate::simulation::GraphFeatures) -> GraphMetrics {
+            GraphMetrics {
+                node_count: f.node_count as u32,
+                edge_count: f.edge_count as u32,
+                has_cycles: f.has_cycles,
+                critical_path: f.critical_path,
+                delay_weighted_depth: f.delay_weighted_depth,
+                scc_count: f.scc_count as u32,
+                largest_scc: f.largest_scc as u32,
+                weakly_connected_components: f.weakly_connected_components as u32,
+                max_fan_in: f.max_fan_in as u32,
+                max_fan_out: f.max_fan_out as u32,
+                approx_input_count: f.approx_input_count as u32,
+                approx_output_count: f.approx_output_count as u32,
+            }
+        }
+    }
+
+    /// Features and fingerprints of successive graph exports of one build,
+    /// updated incrementally. Wraps
+    /// [`crate::simulation::AnalysisSession`]: nodes are matched to the
+    /// previous export by position, unchanged weak components keep their
+    /// results, and fingerprint colours are recomputed only near changes.
+    #[diplomat::opaque_mut]
+    pub struct GraphAnalysisSession(pub(crate) crate::simulation::AnalysisSession);
+
+    impl GraphAnalysisSession {
+        /// Analyse `graph` from scratch.
+        pub fn create(graph: &CompactRedstoneGraph) -> Box<GraphAnalysisSession> {
+            Box::new(GraphAnalysisSession(
+                crate::simulation::AnalysisSession::new(graph.0.clone()),
+            ))
+        }
+
+        /// Move to the next export of the build and return its features.
+        pub fn update(&mut self, graph: &CompactRedstoneGraph) -> GraphMetrics {
+            CompactRedstoneGraph::metrics_of(self.0.update(graph.0.clone()))
+        }
+
+        /// Features of the current export.
+        pub fn metrics(&self) -> GraphMetrics {
+            CompactRedstoneGraph::metrics_of(self.0.features())
+        }
+
+        /// Fingerprint (hex string) of the current export for `preset`, as
+        /// `RedstoneGraph::fingerprint`. Presets used once are kept current by
+        /// later updates.
+        pub fn fingerprint(
+            &mut self,
+            preset: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let preset =
+                std::str::from_utf8(preset).map_err(|_| NucleationError::InvalidArgument)?;
+            let preset = if preset.is_empty() {
+                "structural"
+            } else {
+                preset
+            };
+            let spec = crate::simulation::fingerprint::GraphFingerprintSpec::from_preset(preset)
+                .ok_or(NucleationError::InvalidArgument)?;
+            let _ = write!(out, "{}", self.0.fingerprint(&spec).to_hex());
+            Ok(())
+        }
+
+        /// Weak components the last update carried over unchanged.
+        pub fn reused_components(&self) -> u32 {
+            self.0.reused_components() as u32
+        }
+
+        /// Nodes of the current export without a clean match in the previous
+        /// one.
+        pub fn dirty_nodes(&self) -> u32 {
+            self.0.dirty_nodes() as u32
+        }
     }
 }
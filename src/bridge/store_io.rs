@@ -10,6 +10,8 @@
 
 #[diplomat::bridge]
 pub mod ffi {
+    use super::super::jobs::external_job;
+    use super::super::jobs::ffi::Job;
     use super::super::schematic::ffi::Schematic;
     use super::super::shared::ffi::NucleationError;
     use base64::Engine;
@@ -17,20 +19,25 @@ pub mod ffi {
     use std::fmt::Write;
 
     /// A key/value store opened from a URL (e.g. `mem://`, `file:///path`,
-    /// `s3://bucket/prefix`, `redis://…`, `postgres://…`).
+    /// `s3://bucket/prefix`, `redis://…`, `postgres://…`). Prefix any URL
+    /// with `cas://` to store each distinct object once, keyed by its blake3
+    /// hash, so saving a duplicate writes only a small pointer. Handles opened
+    /// from the same URL share one connection.
     #[diplomat::opaque]
-    pub struct Store(pub(crate) Box<dyn crate::store::Store>);
+    pub struct Store(pub(crate) std::sync::Arc<dyn crate::store::Store>);
 
     impl Store {
         fn utf8(s: &[u8]) -> Result<&str, NucleationError> {
             std::str::from_utf8(s).map_err(|_| NucleationError::InvalidArgument)
         }
 
-        /// Open a store from a URL. Errors with `Store` on an unknown scheme or
+        /// Open a store from a URL, reusing the process's cached connection
+        /// for that URL when it is still healthy (`mem://` is always a new,
+        /// empty store). Errors with `Store` on an unknown scheme or
         /// connection failure.
         pub fn open(url: &DiplomatStr) -> Result<Box<Store>, NucleationError> {
             let url = Self::utf8(url)?;
-            crate::store::open(url)
+            crate::store::open_shared(url)
                 .map(|s| Box::new(Store(s)))
                 .map_err(|_| NucleationError::Store)
         }
@@ -123,6 +130,132 @@ pub mod ffi {
             Ok(())
         }
 
+        /// Parse a JSON array of key strings, the batch methods' key list.
+        fn keys_json(keys_json: &[u8]) -> Result<Vec<String>, NucleationError> {
+            serde_json::from_slice(keys_json).map_err(|_| NucleationError::InvalidArgument)
+        }
+
+        /// Fetch every key in `keys_json` (a JSON array of strings) in one
+        /// batch, writing a JSON array with one entry per key, in order: the
+        /// value as base64 (PORTING rule 6), or `null` when absent.
+        pub fn get_many_b64(
+            &self,
+            keys_json: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let keys = Self::keys_json(keys_json)?;
+            let keys: Vec<&str> = keys.iter().map(String::as_str).collect();
+            let values = self.0.get_many(&keys).map_err(|_| NucleationError::Store)?;
+            let engine = &base64::engine::general_purpose::STANDARD;
+            let encoded: Vec<Option<String>> = values
+                .iter()
+                .map(|v| v.as_ref().map(|b| engine.encode(b)))
+                .collect();
+            let json = serde_json::to_string(&encoded).map_err(|_| NucleationError::Serialize)?;
+            let _ = write!(out, "{}", json);
+            Ok(())
+        }
+
+        /// Store every entry of `items_json`, a JSON object mapping each key
+        /// to its base64 value, in one batch. Errors with `InvalidArgument`
+        /// on malformed JSON or base64, before anything is written.
+        pub fn put_many_b64(&self, items_json: &DiplomatStr) -> Result<(), NucleationError> {
+            let items: std::collections::BTreeMap<String, String> =
+                serde_json::from_slice(items_json).map_err(|_| NucleationError::InvalidArgument)?;
+            let engine = &base64::engine::general_purpose::STANDARD;
+            let decoded = items
+                .iter()
+                .map(|(k, v)| Ok((k.as_str(), engine.decode(v)?)))
+                .collect::<Result<Vec<_>, base64::DecodeError>>()
+                .map_err(|_| NucleationError::InvalidArgument)?;
+            let pairs: Vec<(&str, &[u8])> =
+                decoded.iter().map(|(k, v)| (*k, v.as_slice())).collect();
+            self.0.put_many(&pairs).map_err(|_| NucleationError::Store)
+        }
+
+        /// Whether each key in `keys_json` (a JSON array of strings) exists,
+        /// written as a JSON array of booleans in the same order.
+        pub fn exists_many(
+            &self,
+            keys_json: &DiplomatStr,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let keys = Self::keys_json(keys_json)?;
+            let keys: Vec<&str> = keys.iter().map(String::as_str).collect();
+            let found = self
+                .0
+                .exists_many(&keys)
+                .map_err(|_| NucleationError::Store)?;
+            let json = serde_json::to_string(&found).map_err(|_| NucleationError::Serialize)?;
+            let _ = write!(out, "{}", json);
+            Ok(())
+        }
+
+        /// Delete every key in `keys_json` (a JSON array of strings) in one
+        /// batch; missing keys are skipped.
+        pub fn delete_many(&self, keys_json: &DiplomatStr) -> Result<(), NucleationError> {
+            let keys = Self::keys_json(keys_json)?;
+            let keys: Vec<&str> = keys.iter().map(String::as_str).collect();
+            self.0
+                .delete_many(&keys)
+                .map_err(|_| NucleationError::Store)
+        }
+
+        /// Submit `op` without blocking. The job completes on the backend's
+        /// runtime (S3, Redis, Postgres) or, for local backends, before this
+        /// returns.
+        fn submit_job(&self, op: crate::store::StoreOp) -> Box<Job> {
+            use crate::store::StoreOutcome;
+            let (job, completer) = external_job(NucleationError::Store);
+            self.0.submit(
+                op,
+                Box::new(move |result| match result {
+                    Ok(StoreOutcome::Value(Some(bytes))) => completer.finish(Ok(bytes)),
+                    Ok(StoreOutcome::Value(None)) => {
+                        completer.finish::<()>(Err(NucleationError::NotFound))
+                    }
+                    Ok(StoreOutcome::Exists(found)) => completer.finish(Ok(found)),
+                    Ok(StoreOutcome::Done) => completer.finish(Ok(())),
+                    Err(_) => completer.finish::<()>(Err(NucleationError::Store)),
+                }),
+            );
+            job
+        }
+
+        /// Start fetching `key` without blocking; take the value with
+        /// `Job::take_bytes`, which errors with `NotFound` when the key is
+        /// absent. Networked backends keep any number of these in flight on
+        /// their own runtime, with no thread parked per operation.
+        pub fn start_get(&self, key: &DiplomatStr) -> Result<Box<Job>, NucleationError> {
+            let key = Self::utf8(key)?;
+            Ok(self.submit_job(crate::store::StoreOp::Get(key.to_string())))
+        }
+
+        /// Start storing `data` at `key` without blocking; confirm with
+        /// `Job::take_empty`.
+        pub fn start_put(
+            &self,
+            key: &DiplomatStr,
+            data: &[u8],
+        ) -> Result<Box<Job>, NucleationError> {
+            let key = Self::utf8(key)?;
+            Ok(self.submit_job(crate::store::StoreOp::Put(key.to_string(), data.to_vec())))
+        }
+
+        /// Start checking whether `key` exists without blocking; take the
+        /// answer with `Job::take_bool`.
+        pub fn start_exists(&self, key: &DiplomatStr) -> Result<Box<Job>, NucleationError> {
+            let key = Self::utf8(key)?;
+            Ok(self.submit_job(crate::store::StoreOp::Exists(key.to_string())))
+        }
+
+        /// Start deleting `key` without blocking; confirm with
+        /// `Job::take_empty`.
+        pub fn start_delete(&self, key: &DiplomatStr) -> Result<Box<Job>, NucleationError> {
+            let key = Self::utf8(key)?;
+            Ok(self.submit_job(crate::store::StoreOp::Delete(key.to_string())))
+        }
+
         /// Health check: `Ok` when the store is usable.
         pub fn health(&self) -> Result<(), NucleationError> {
             self.0.health().map_err(|_| NucleationError::Store)
@@ -208,6 +341,18 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Store)
         }
 
+        /// Read the header fields of the schematic at a URI (same resolution as
+        /// `open`) without decoding its blocks, written as a JSON object string
+        /// `{"format","format_version","metadata","dimensions","region_count",
+        /// "total_blocks"}`.
+        pub fn probe(uri: &DiplomatStr, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let uri = Self::utf8(uri)?;
+            let info = crate::store_io::probe(uri).map_err(|_| NucleationError::Store)?;
+            let json = serde_json::to_string(&info).map_err(|_| NucleationError::Serialize)?;
+            let _ = write!(out, "{}", json);
+            Ok(())
+        }
+
         /// The JSON schema describing the export settings of `format`. Errors
         /// with `NotFound` for an unknown format.
         pub fn export_settings_schema(
@@ -216,7 +361,6 @@ pub mod ffi {
         ) -> Result<(), NucleationError> {
             let format = Self::utf8(format)?;
             let manager = crate::formats::manager::get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let schema = manager
                 .get_export_settings_schema(format)
                 .ok_or(NucleationError::NotFound)?;
@@ -232,7 +376,6 @@ pub mod ffi {
         ) -> Result<(), NucleationError> {
             let format = Self::utf8(format)?;
             let manager = crate::formats::manager::get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let schema = manager
                 .get_import_settings_schema(format)
                 .ok_or(NucleationError::NotFound)?;
@@ -243,7 +386,6 @@ pub mod ffi {
         /// The supported import formats, written as a JSON array string.
         pub fn supported_import_formats(out: &mut DiplomatWrite) -> Result<(), NucleationError> {
             let manager = crate::formats::manager::get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let json = serde_json::to_string(&manager.list_importers())
                 .map_err(|_| NucleationError::Serialize)?;
             let _ = write!(out, "{}", json);
@@ -253,7 +395,6 @@ pub mod ffi {
         /// The supported export formats, written as a JSON array string.
         pub fn supported_export_formats(out: &mut DiplomatWrite) -> Result<(), NucleationError> {
             let manager = crate::formats::manager::get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let json = serde_json::to_string(&manager.list_exporters())
                 .map_err(|_| NucleationError::Serialize)?;
             let _ = write!(out, "{}", json);
@@ -268,7 +409,6 @@ pub mod ffi {
         ) -> Result<(), NucleationError> {
             let format = Self::utf8(format)?;
             let manager = crate::formats::manager::get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let versions = manager.get_exporter_versions(format).unwrap_or_default();
             let json = serde_json::to_string(&versions).map_err(|_| NucleationError::Serialize)?;
             let _ = write!(out, "{}", json);
@@ -283,7 +423,6 @@ pub mod ffi {
         ) -> Result<(), NucleationError> {
             let format = Self::utf8(format)?;
             let manager = crate::formats::manager::get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let version = manager
                 .get_exporter_default_version(format)
                 .ok_or(NucleationError::NotFound)?;
@@ -0,0 +1,49 @@
+//! Process-wide telemetry: switches the metric registry on and off, reads it
+//! back as JSON and installs a stderr span subscriber. Bridge-native surface
+//! (no old `ffi/*.rs` counterpart) fronting [`crate::telemetry`].
+
+#[diplomat::bridge]
+pub mod ffi {
+    use super::super::shared::ffi::NucleationError;
+    use diplomat_runtime::DiplomatWrite;
+    use std::fmt::Write;
+
+    /// Namespace for the spans and metrics the hot paths emit (format
+    /// read/write, chunk meshing, world chunk decode, store get/put,
+    /// simulation ticks, segmentation phases).
+    #[diplomat::opaque]
+    pub struct Telemetry;
+
+    impl Telemetry {
+        /// Start or stop recording counters and stage timings. Off by
+        /// default.
+        pub fn set_enabled(enabled: bool) {
+            crate::telemetry::set_enabled(enabled);
+        }
+
+        pub fn is_enabled() -> bool {
+            crate::telemetry::is_enabled()
+        }
+
+        /// Everything recorded so far as a JSON object:
+        /// `{counters: {name: n}, histograms: {name: {count, sum, min, max,
+        /// p50, p90, p99}}}`. Stage histograms are in microseconds.
+        pub fn snapshot_json(out: &mut DiplomatWrite) {
+            let _ = write!(out, "{}", crate::telemetry::snapshot().to_json());
+        }
+
+        /// Clear every counter and histogram.
+        pub fn reset() {
+            crate::telemetry::reset();
+        }
+
+        /// Print spans to stderr, filtered by `filter` in `RUST_LOG` syntax
+        /// (e.g. `nucleation=debug`). Errors with `InvalidArgument` when a
+        /// subscriber is already installed.
+        pub fn init_stderr(filter: &DiplomatStr) -> Result<(), NucleationError> {
+            let filter =
+                std::str::from_utf8(filter).map_err(|_| NucleationError::InvalidArgument)?;
+            crate::telemetry::init_subscriber(filter).map_err(|_| NucleationError::InvalidArgument)
+        }
+    }
+}
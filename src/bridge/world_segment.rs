@@ -2,8 +2,10 @@
 //! Bridges [`crate::world_segment::runner::WorldSegmenter`] and its supporting
 //! types (job config, partition hints, world profile, run results).
 //!
-//! Every entry point that walks a world directory (`WsProfile::derive_from_dir`,
-//! `WsRunResult::run_dir`) is `#[cfg(not(target_arch = "wasm32"))]`, matching
+//! Every entry point that walks a world directory or touches checkpoint files
+//! (`WsProfile::derive_from_dir[_sampled]`, `WsRunResult::run_dir`,
+//! `WsSegmentJob::map_shard_dir`, `WsRunResult::reduce_checkpoints`) is
+//! `#[cfg(not(target_arch = "wasm32"))]`, matching
 //! `WorldSource::open_dir` and the `world_stream` bridge module (no filesystem
 //! on wasm32).
 //!
@@ -16,7 +18,10 @@
 //! `std::panic::catch_unwind` (the same pattern already used for redpiler
 //! compilation in `src/simulation/graph.rs`) and maps a caught panic to
 //! `NucleationError::Io`, since the only way `run_streaming` panics today is a
-//! failing `TileSource`. This is an interim measure: the proper fix is a
+//! failing `TileSource`. The distributed entry points (`map_shard_dir`,
+//! `reduce_checkpoints`) return source errors as `Result`s but are wrapped
+//! the same way for the runner's remaining `expect`s (block spill I/O).
+//! This is an interim measure: the proper fix is a
 //! `try_run_streaming` in `src/world_segment/runner.rs` that returns
 //! `Result<RunStats, TileError>` instead of panicking, which would let this
 //! wrapper go away.
@@ -28,24 +33,127 @@ pub mod ffi {
     use diplomat_runtime::DiplomatWrite;
     use std::fmt::Write;
 
+    use super::super::jobs::ffi::Job;
+    use super::super::jobs::{spawn_job, take_job_output};
     use super::super::shared::ffi::{BlockPos, NucleationError};
 
     use crate::formats::manager::get_manager;
     use crate::formats::world_stream::WorldSource;
+    use crate::world_segment::metrics::RunMetrics;
     use crate::world_segment::partition::{PartitionHint, PartitionIndex, PartitionPolicy};
     use crate::world_segment::profile::{ProfileParams, WorldProfile};
-    use crate::world_segment::runner::{MaterializedBuild, RunStats, SegmentJob, WorldSegmenter};
+    use crate::world_segment::runner::{
+        shard_tile_ids, MaterializedBuild, RunStats, SegmentJob, WorldSegmenter,
+    };
     use crate::world_segment::score::{ScoreConfig, Tier};
     use crate::world_segment::segment::SegConfig;
     use crate::world_segment::source::TileError;
     use crate::world_segment::source::TileSource as _;
-    use crate::world_segment::tile::VoxelTile;
+    use crate::world_segment::spill::SpillConfig;
     use crate::world_segment::world_source::WorldSourceTiles;
+    #[cfg(not(target_arch = "wasm32"))]
+    use crate::world_segment::world_source::derive_dir_profile;
 
     fn utf8(bytes: &[u8]) -> Result<&str, NucleationError> {
         std::str::from_utf8(bytes).map_err(|_| NucleationError::InvalidArgument)
     }
 
+    /// The body of `WsRunResult::run_dir` / `start_run_dir`. `progress` is
+    /// called with the tiles segmented so far and the world's tile count.
+    /// See the module docs for why this catches a panic instead of
+    /// propagating it.
+    #[cfg(not(target_arch = "wasm32"))]
+    fn run_world_dir(
+        job: &SegmentJob,
+        hints: Vec<PartitionHint>,
+        profile: &WorldProfile,
+        dir: &Path,
+        progress: &mut dyn FnMut(u64, u64),
+    ) -> Result<(Vec<MaterializedBuild>, RunStats, RunMetrics), NucleationError> {
+        let source = WorldSource::open_dir(dir).map_err(|_| NucleationError::Io)?;
+        let tiles = WorldSourceTiles::new(source, job.min_y, job.max_y);
+        let partitions = PartitionIndex::new(hints);
+        let total = tiles.tile_ids().map_err(|_| NucleationError::Io)?.len() as u64;
+
+        let tiles_ref = &tiles;
+        let partitions_ref = &partitions;
+
+        std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
+            let mut builds: Vec<MaterializedBuild> = Vec::new();
+            let (stats, metrics) = WorldSegmenter::run_streaming_metered(
+                tiles_ref,
+                profile,
+                partitions_ref,
+                job,
+                &[],
+                &mut |m| progress(m.tiles, total),
+                &mut |mb| builds.push(mb),
+            );
+            (builds, stats, metrics)
+        }))
+        // The only documented panic in `run_streaming` is the tile source's
+        // `.expect("tile source failed")`; there is no richer error to recover
+        // from a caught panic payload.
+        .map_err(|_| NucleationError::Io)
+    }
+
+    /// The body of `WsSegmentJob::map_shard_dir`; panics are caught as in
+    /// [`run_world_dir`].
+    #[cfg(not(target_arch = "wasm32"))]
+    fn map_world_dir_shard(
+        job: &SegmentJob,
+        hints: Vec<PartitionHint>,
+        profile: &WorldProfile,
+        dir: &Path,
+        shard: (usize, usize),
+        checkpoint: &Path,
+    ) -> Result<u32, NucleationError> {
+        let source = WorldSource::open_dir(dir).map_err(|_| NucleationError::Io)?;
+        let tiles = WorldSourceTiles::new(source, job.min_y, job.max_y);
+        let partitions = PartitionIndex::new(hints);
+        let ids = tiles.tile_ids().map_err(|_| NucleationError::Io)?;
+        let ids = shard_tile_ids(&ids, shard.0, shard.1);
+
+        let tiles_ref = &tiles;
+        let partitions_ref = &partitions;
+        std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
+            WorldSegmenter::map_shard(tiles_ref, &ids, profile, partitions_ref, job, checkpoint)
+        }))
+        .map_err(|_| NucleationError::Io)?
+        .map(|found| found as u32)
+        .map_err(|_| NucleationError::Io)
+    }
+
+    /// The body of `WsRunResult::reduce_checkpoints`; panics are caught as
+    /// in [`run_world_dir`].
+    #[cfg(not(target_arch = "wasm32"))]
+    fn reduce_checkpoint_files(
+        job: &SegmentJob,
+        hints: Vec<PartitionHint>,
+        profile: &WorldProfile,
+        checkpoints: &[std::path::PathBuf],
+    ) -> Result<(Vec<MaterializedBuild>, RunStats), NucleationError> {
+        let partitions = PartitionIndex::new(hints);
+        let partitions_ref = &partitions;
+        std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
+            let mut builds: Vec<MaterializedBuild> = Vec::new();
+            WorldSegmenter::reduce_shards(
+                checkpoints,
+                profile,
+                partitions_ref,
+                job,
+                &[],
+                &mut |mb| builds.push(mb),
+            )
+            .map(|stats| (builds, stats))
+        }))
+        .map_err(|_| NucleationError::Io)?
+        .map_err(|e| match e {
+            TileError::Malformed(_) => NucleationError::Parse,
+            _ => NucleationError::Io,
+        })
+    }
+
     /// One segmentation run's parameters (the primitive knobs of
     /// [`SegmentJob`](crate::world_segment::runner::SegmentJob), plus a
     /// `hard_cut` flag selecting [`PartitionPolicy`]). Built once, passed by
@@ -91,8 +199,61 @@ pub mod ffi {
                 max_y,
                 extracted_at,
                 match_iou,
+                spill: SpillConfig::default(),
             })))
         }
+
+        /// Map phase of a distributed run: segment shard `shard_index` of
+        /// `shard_count` of a world directory's tiles (contiguous in
+        /// ascending `(x, z)` order) and write a checkpoint file to
+        /// `checkpoint_path`. Run every shard, on any machines, with the same
+        /// job, hints and profile, then merge them with
+        /// `WsRunResult::reduce_checkpoints`. Returns the number of tiles in
+        /// the shard that had data.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn map_shard_dir(
+            &self,
+            hints: &WsPartitionHints,
+            profile: &WsProfile,
+            world_dir: &DiplomatStr,
+            shard_index: u32,
+            shard_count: u32,
+            checkpoint_path: &DiplomatStr,
+        ) -> Result<u32, NucleationError> {
+            if shard_index >= shard_count {
+                return Err(NucleationError::InvalidArgument);
+            }
+            let dir = utf8(world_dir)?;
+            let checkpoint = utf8(checkpoint_path)?;
+            map_world_dir_shard(
+                &self.0,
+                hints.0.clone(),
+                &profile.0,
+                Path::new(dir),
+                (shard_index as usize, shard_count as usize),
+                Path::new(checkpoint),
+            )
+        }
+    }
+
+    /// Checkpoint file paths for `WsRunResult::reduce_checkpoints`. Order
+    /// does not matter.
+    #[diplomat::opaque_mut]
+    pub struct WsCheckpoints(pub(crate) Vec<std::path::PathBuf>);
+
+    impl WsCheckpoints {
+        pub fn create() -> Box<WsCheckpoints> {
+            Box::new(WsCheckpoints(Vec::new()))
+        }
+
+        pub fn add(&mut self, path: &DiplomatStr) -> Result<(), NucleationError> {
+            self.0.push(utf8(path)?.into());
+            Ok(())
+        }
+
+        pub fn len(&self) -> u32 {
+            self.0.len() as u32
+        }
     }
 
     /// Caller-supplied partition hints (full-column boxes a cluster may never
@@ -135,9 +296,12 @@ pub mod ffi {
 
     impl WsProfile {
         /// Derive a profile from up to `sample` tiles (regions) of a world
-        /// directory, in ascending `(x, z)` region order. `coverage` is
+        /// directory, spread evenly over its ascending `(x, z)` region order
+        /// and read in parallel. `coverage` is
         /// `ProfileParams::min_slab_coverage`; every other `ProfileParams`
         /// field uses its default (`sample_stride: 1`, `y_scan: (-64, 320)`).
+        /// The result is cached in the world directory and reused while the
+        /// arguments and region files are unchanged.
         #[cfg(not(target_arch = "wasm32"))]
         pub fn derive_from_dir(
             world_dir: &DiplomatStr,
@@ -146,26 +310,27 @@ pub mod ffi {
             sample: u32,
             coverage: f32,
         ) -> Result<Box<WsProfile>, NucleationError> {
-            let dir = utf8(world_dir)?;
-            let source =
-                WorldSource::open_dir(Path::new(dir)).map_err(|_| NucleationError::Io)?;
-            let tiles = WorldSourceTiles::new(source, min_y, max_y);
-
-            let limit = sample.max(1) as usize;
-            let mut samples: Vec<VoxelTile> = Vec::new();
-            tiles
-                .for_each_tile(&mut |tile| {
-                    samples.push(tile);
-                    if samples.len() >= limit {
-                        Err(TileError::Stop)
-                    } else {
-                        Ok(())
-                    }
-                })
-                .map_err(|_| NucleationError::Io)?;
+            Self::derive_from_dir_sampled(world_dir, min_y, max_y, sample, coverage, 1)
+        }
 
+        /// `derive_from_dir` reading one chunk from each `chunk_stride` x
+        /// `chunk_stride` block of every sampled region instead of all of
+        /// them: stride 4 reads 1/16 of each region.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn derive_from_dir_sampled(
+            world_dir: &DiplomatStr,
+            min_y: i32,
+            max_y: i32,
+            sample: u32,
+            coverage: f32,
+            chunk_stride: u32,
+        ) -> Result<Box<WsProfile>, NucleationError> {
+            let dir = utf8(world_dir)?;
             let params = ProfileParams { min_slab_coverage: coverage, ..ProfileParams::default() };
-            Ok(Box::new(WsProfile(WorldProfile::derive(&samples, &params))))
+            let limit = sample.max(1) as usize;
+            derive_dir_profile(Path::new(dir), min_y, max_y, limit, chunk_stride, &params)
+                .map(|profile| Box::new(WsProfile(profile)))
+                .map_err(|_| NucleationError::Io)
         }
 
         /// The derived substrate Y band's lower bound (inclusive).
@@ -194,11 +359,13 @@ pub mod ffi {
 
     /// The materialized output of one segmentation run: every build (in the
     /// pipeline's deterministic stable-id order) plus the aggregate
-    /// [`RunStats`](crate::world_segment::runner::RunStats).
+    /// [`RunStats`](crate::world_segment::runner::RunStats) and the run's
+    /// [`RunMetrics`](crate::world_segment::metrics::RunMetrics).
     #[diplomat::opaque]
     pub struct WsRunResult {
         builds: Vec<MaterializedBuild>,
         stats: RunStats,
+        metrics: RunMetrics,
     }
 
     impl WsRunResult {
@@ -217,36 +384,56 @@ pub mod ffi {
             world_dir: &DiplomatStr,
         ) -> Result<Box<WsRunResult>, NucleationError> {
             let dir = utf8(world_dir)?;
-            let source =
-                WorldSource::open_dir(Path::new(dir)).map_err(|_| NucleationError::Io)?;
-            let tiles = WorldSourceTiles::new(source, job.0.min_y, job.0.max_y);
-            let partitions = PartitionIndex::new(hints.0.clone());
-
-            let job_ref = &job.0;
-            let profile_ref = &profile.0;
-            let tiles_ref = &tiles;
-            let partitions_ref = &partitions;
-
-            let outcome = std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
-                let mut builds: Vec<MaterializedBuild> = Vec::new();
-                let stats = WorldSegmenter::run_streaming(
-                    tiles_ref,
-                    profile_ref,
-                    partitions_ref,
-                    job_ref,
-                    &[],
-                    &mut |mb| builds.push(mb),
-                );
-                (builds, stats)
-            }));
-
-            match outcome {
-                Ok((builds, stats)) => Ok(Box::new(WsRunResult { builds, stats })),
-                // The only documented panic in `run_streaming` is the tile
-                // source's `.expect("tile source failed")`; there is no
-                // richer error to recover from a caught panic payload.
-                Err(_) => Err(NucleationError::Io),
-            }
+            run_world_dir(&job.0, hints.0.clone(), &profile.0, Path::new(dir), &mut |_, _| {})
+                .map(|(builds, stats, metrics)| Box::new(WsRunResult { builds, stats, metrics }))
+        }
+
+        /// `run_dir` as a background job (the job, hints and profile are
+        /// copied). `Job::poll_progress` reports tiles segmented out of the
+        /// world's tile count, updated about once a second. Take the result
+        /// with `WsRunResult::from_job`.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn start_run_dir(
+            job: &WsSegmentJob,
+            hints: &WsPartitionHints,
+            profile: &WsProfile,
+            world_dir: &DiplomatStr,
+        ) -> Result<Box<Job>, NucleationError> {
+            let dir = std::path::PathBuf::from(utf8(world_dir)?);
+            let (job, hints, profile) = (job.0.clone(), hints.0.clone(), profile.0.clone());
+            Ok(spawn_job(NucleationError::Io, move |ctx| {
+                run_world_dir(&job, hints, &profile, &dir, &mut |done, total| {
+                    let clamp = |n: u64| n.min(u32::MAX as u64) as u32;
+                    ctx.set_progress(clamp(done), clamp(total))
+                })
+            }))
+        }
+
+        /// Reduce phase of a distributed run: merge the checkpoints written
+        /// by `WsSegmentJob::map_shard_dir` and materialize the builds,
+        /// identical to `run_dir` over the whole world. The checkpoint files
+        /// are read, not consumed. `Parse` if a checkpoint is malformed,
+        /// came from a different job, hints or profile, or shares a tile
+        /// with another.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn reduce_checkpoints(
+            job: &WsSegmentJob,
+            hints: &WsPartitionHints,
+            profile: &WsProfile,
+            checkpoints: &WsCheckpoints,
+        ) -> Result<Box<WsRunResult>, NucleationError> {
+            reduce_checkpoint_files(&job.0, hints.0.clone(), &profile.0, &checkpoints.0).map(
+                |(builds, stats)| {
+                    Box::new(WsRunResult { builds, stats, metrics: RunMetrics::default() })
+                },
+            )
+        }
+
+        /// The result of a `start_run_dir` job. Blocks until the job finishes;
+        /// `AlreadyConsumed` on a second call.
+        pub fn from_job(job: &mut Job) -> Result<Box<WsRunResult>, NucleationError> {
+            take_job_output::<(Vec<MaterializedBuild>, RunStats, RunMetrics)>(job)
+                .map(|(builds, stats, metrics)| Box::new(WsRunResult { builds, stats, metrics }))
         }
 
         /// Total builds materialized (same as `build_count`, from `RunStats`).
@@ -274,6 +461,50 @@ pub mod ffi {
             self.stats.largest_block_count
         }
 
+        /// Tiles segmented per second of wall-clock time. Zero for
+        /// `reduce_checkpoints` results, which are not metered, and on
+        /// wasm32, which has no clock.
+        pub fn tiles_per_sec(&self) -> f64 {
+            self.metrics.tiles_per_sec()
+        }
+
+        /// Blocks segmented per second of wall-clock time; zero as for
+        /// `tiles_per_sec`.
+        pub fn blocks_per_sec(&self) -> f64 {
+            self.metrics.blocks_per_sec()
+        }
+
+        /// The run's [`RunMetrics`](crate::world_segment::metrics::RunMetrics)
+        /// as a JSON object: stage times in milliseconds (`decode_ms`,
+        /// `segment_ms`, `stitch_ms`, `materialize_ms`, `emit_ms`,
+        /// `total_ms`), throughput, and the memory figures (peak retained
+        /// blocks, margin sizes, spill volume).
+        pub fn write_metrics_json(&self, out: &mut DiplomatWrite) -> Result<(), NucleationError> {
+            let m = &self.metrics;
+            let ms = |d: std::time::Duration| d.as_secs_f64() * 1000.0;
+            let json = serde_json::json!({
+                "decode_ms": ms(m.decode),
+                "segment_ms": ms(m.segment),
+                "stitch_ms": ms(m.stitch),
+                "materialize_ms": ms(m.materialize),
+                "emit_ms": ms(m.emit),
+                "total_ms": ms(m.total),
+                "tiles": m.tiles,
+                "blocks": m.blocks,
+                "builds": m.builds,
+                "tiles_per_sec": m.tiles_per_sec(),
+                "blocks_per_sec": m.blocks_per_sec(),
+                "peak_retained_blocks": m.peak_retained_blocks,
+                "peak_margin_entries": m.peak_margin_entries,
+                "final_margin_entries": m.final_margin_entries,
+                "spilled_runs": m.spilled_runs,
+                "spilled_blocks": m.spilled_blocks,
+                "spilled_bytes": m.spilled_bytes(),
+            });
+            let _ = write!(out, "{}", json);
+            Ok(())
+        }
+
         /// Number of builds held in this result (indices `0..build_count()`
         /// are valid for every per-index accessor below).
         pub fn build_count(&self) -> u32 {
@@ -344,7 +575,6 @@ pub mod ffi {
             let mb = self.get(index)?;
             let path = utf8(path)?;
             let manager = get_manager();
-            let manager = manager.lock().map_err(|_| NucleationError::Lock)?;
             let bytes = manager
                 .write_auto_with_settings(path, &mb.schematic, None, None)
                 .map_err(|_| NucleationError::Serialize)?;
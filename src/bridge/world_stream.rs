@@ -5,6 +5,12 @@
 //! — destructors are generated (dropping an unfinished `WorldSink` abandons it,
 //! matching the old `worldsink_free` semantics).
 
+// Serial and parallel chunk iterators sit behind one stream handle.
+pub(crate) type InnerWorldStream = Box<
+    dyn Iterator<Item = crate::formats::error::Result<crate::formats::world_stream::WorldChunkView>>
+        + Send,
+>;
+
 // The core WorldSink type only exists off-wasm (filesystem writer). The bridge
 // opaque keeps a stable shape via this alias; all of its methods are gated
 // `#[cfg(not(target_arch = "wasm32"))]`, matching the old wasm layer (which
@@ -14,16 +20,24 @@ pub(crate) type InnerWorldSink = Option<crate::formats::world_stream::WorldSink>
 #[cfg(target_arch = "wasm32")]
 pub(crate) type InnerWorldSink = ();
 
+// Writers share the sink through a read lock; `finish` takes the write lock
+// to consume it.
+#[cfg(not(target_arch = "wasm32"))]
+pub(crate) type InnerShardedWorldSink =
+    std::sync::RwLock<Option<crate::formats::world_stream::ShardedWorldSink>>;
+#[cfg(target_arch = "wasm32")]
+pub(crate) type InnerShardedWorldSink = ();
+
 #[diplomat::bridge]
 pub mod ffi {
     use super::super::schematic::ffi::Schematic;
-    use super::super::shared::ffi::NucleationError;
+    use super::super::shared::ffi::{Bytes, NucleationError};
     use diplomat_runtime::DiplomatWrite;
     use std::fmt::Write;
 
     /// A streaming iterator over the chunks of a world.
     #[diplomat::opaque_mut]
-    pub struct WorldStream(crate::formats::world_stream::ChunkIter);
+    pub struct WorldStream(super::InnerWorldStream);
 
     /// A single decoded chunk (or a from-scratch chunk under construction).
     #[diplomat::opaque_mut]
@@ -33,7 +47,13 @@ pub mod ffi {
     /// held in an `Option` and taken on `finish`; every method afterwards returns
     /// `AlreadyConsumed`. Dropping the handle without `finish` abandons the sink.
     #[diplomat::opaque_mut]
-    pub struct WorldSink(super::InnerWorldSink);
+    pub struct WorldSink(pub(crate) super::InnerWorldSink);
+
+    /// A world writer that accepts chunks from several threads at once and
+    /// in any order, buffering a bounded number of regions. `finish` is
+    /// consuming, as for `WorldSink`.
+    #[diplomat::opaque]
+    pub struct ShardedWorldSink(pub(crate) super::InnerShardedWorldSink);
 
     impl WorldStream {
         fn utf8(s: &[u8]) -> Result<&str, NucleationError> {
@@ -49,7 +69,7 @@ pub mod ffi {
                     .map_err(|_| NucleationError::Io)?;
             source
                 .chunks()
-                .map(|it| Box::new(WorldStream(it)))
+                .map(|it| Box::new(WorldStream(Box::new(it))))
                 .map_err(|_| NucleationError::Io)
         }
 
@@ -72,7 +92,48 @@ pub mod ffi {
                     .map_err(|_| NucleationError::Io)?;
             source
                 .chunks_bounded((min_x, min_y, min_z), (max_x, max_y, max_z))
-                .map(|it| Box::new(WorldStream(it)))
+                .map(|it| Box::new(WorldStream(Box::new(it))))
+                .map_err(|_| NucleationError::Io)
+        }
+
+        /// Open a streaming iterator over a world directory that decodes chunks
+        /// on `threads` worker threads (0 = one per core). With `ordered`,
+        /// chunks arrive in the same order as `open_dir`; otherwise in
+        /// whatever order they finish decoding.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn open_dir_parallel(
+            path: &DiplomatStr,
+            threads: u32,
+            ordered: bool,
+        ) -> Result<Box<WorldStream>, NucleationError> {
+            let path = Self::utf8(path)?;
+            let source =
+                crate::formats::world_stream::WorldSource::open_dir(std::path::Path::new(path))
+                    .map_err(|_| NucleationError::Io)?;
+            source
+                .chunks()
+                .map(|it| {
+                    Box::new(WorldStream(Box::new(
+                        it.parallel(threads as usize, ordered),
+                    )))
+                })
+                .map_err(|_| NucleationError::Io)
+        }
+
+        /// Open a streaming iterator over the chunks of a world directory
+        /// that changed since the last call for that directory. The chunk
+        /// index sidecar in the directory is created on first use (every
+        /// chunk counts as changed) and updated on each call.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn open_dir_changed(path: &DiplomatStr) -> Result<Box<WorldStream>, NucleationError> {
+            let path = std::path::Path::new(Self::utf8(path)?);
+            let source = crate::formats::world_stream::WorldSource::open_dir(path)
+                .map_err(|_| NucleationError::Io)?;
+            let (_, delta) = crate::formats::world_index::WorldIndex::open(path)
+                .map_err(|_| NucleationError::Io)?;
+            source
+                .chunks_at(&delta.changed)
+                .map(|it| Box::new(WorldStream(Box::new(it))))
                 .map_err(|_| NucleationError::Io)
         }
 
@@ -82,7 +143,7 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Parse)?;
             source
                 .chunks()
-                .map(|it| Box::new(WorldStream(it)))
+                .map(|it| Box::new(WorldStream(Box::new(it))))
                 .map_err(|_| NucleationError::Parse)
         }
 
@@ -101,7 +162,7 @@ pub mod ffi {
                 .map_err(|_| NucleationError::Parse)?;
             source
                 .chunks_bounded((min_x, min_y, min_z), (max_x, max_y, max_z))
-                .map(|it| Box::new(WorldStream(it)))
+                .map(|it| Box::new(WorldStream(Box::new(it))))
                 .map_err(|_| NucleationError::Parse)
         }
 
@@ -117,6 +178,39 @@ pub mod ffi {
                 }
             }
         }
+
+        /// Drain the stream into a schematic file at `path` holding the
+        /// block box `[min_x..max_x, min_y..max_y, min_z..max_z]`. `format`
+        /// is `"schem"` (Sponge v3) or `"litematic"`. Blocks are spooled to
+        /// a temporary file beside `path`, so memory stays flat however
+        /// large the box. Corrupt chunks are skipped, as for `next`.
+        #[allow(clippy::too_many_arguments)]
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn write_schematic(
+            &mut self,
+            path: &DiplomatStr,
+            format: &DiplomatStr,
+            min_x: i32,
+            min_y: i32,
+            min_z: i32,
+            max_x: i32,
+            max_y: i32,
+            max_z: i32,
+        ) -> Result<(), NucleationError> {
+            let path = std::path::Path::new(Self::utf8(path)?);
+            let format = crate::formats::world_export::SpoolFormat::from_name(Self::utf8(format)?)
+                .ok_or(NucleationError::InvalidArgument)?;
+            let chunks = self.0.by_ref().filter(|chunk| chunk.is_ok());
+            crate::formats::world_export::export_chunks(
+                chunks,
+                (min_x, min_y, min_z),
+                (max_x, max_y, max_z),
+                format,
+                path,
+            )
+            .map(|_| ())
+            .map_err(|_| NucleationError::Io)
+        }
     }
 
     impl WorldChunkView {
@@ -200,6 +294,76 @@ pub mod ffi {
             let _ = write!(out, "{}", json);
             Ok(())
         }
+
+        /// Number of sections in the chunk. Section indices below run by
+        /// ascending section Y.
+        pub fn section_count(&self) -> u32 {
+            self.0.sections().len() as u32
+        }
+
+        /// Section Y of section `index`; it covers block Ys `y * 16` to
+        /// `y * 16 + 15`.
+        pub fn section_y(&self, index: u32) -> Result<i32, NucleationError> {
+            self.0
+                .sections()
+                .get(index as usize)
+                .map(|section| section.y)
+                .ok_or(NucleationError::NotFound)
+        }
+
+        /// Non-air blocks in section `index`.
+        pub fn section_non_air_count(&self, index: u32) -> Result<u32, NucleationError> {
+            self.0
+                .sections()
+                .get(index as usize)
+                .map(|section| section.non_air)
+                .ok_or(NucleationError::NotFound)
+        }
+
+        /// Palette of section `index` as a JSON array of block state strings
+        /// (e.g. `minecraft:oak_log[axis=y]`).
+        pub fn section_palette_json(
+            &self,
+            index: u32,
+            out: &mut DiplomatWrite,
+        ) -> Result<(), NucleationError> {
+            let sections = self.0.sections();
+            let section = sections
+                .get(index as usize)
+                .ok_or(NucleationError::NotFound)?;
+            let names: Vec<String> = section.palette.iter().map(|b| b.to_string()).collect();
+            let json = serde_json::to_string(&names).map_err(|_| NucleationError::Serialize)?;
+            let _ = write!(out, "{}", json);
+            Ok(())
+        }
+
+        /// Palette indices of section `index`: 4096 little-endian `u16`s in
+        /// `y * 256 + z * 16 + x` order.
+        pub fn section_block_indices(&self, index: u32) -> Result<Box<Bytes>, NucleationError> {
+            let sections = self.0.sections();
+            let section = sections
+                .get(index as usize)
+                .ok_or(NucleationError::NotFound)?;
+            let bytes = section
+                .block_states
+                .iter()
+                .flat_map(|i| i.to_le_bytes())
+                .collect();
+            Ok(Box::new(Bytes(bytes)))
+        }
+
+        /// Heightmap `name` (`MOTION_BLOCKING`, `WORLD_SURFACE`, ...) as 256
+        /// little-endian `i32` world Ys in `z * 16 + x` order: the Y just
+        /// above each column's highest counted block. Stored heightmaps are
+        /// returned as read; chunks without them compute the two named kinds
+        /// from their blocks. `NotFound` for any other kind the chunk does
+        /// not store.
+        pub fn heightmap(&self, name: &DiplomatStr) -> Result<Box<Bytes>, NucleationError> {
+            let name = std::str::from_utf8(name).map_err(|_| NucleationError::InvalidArgument)?;
+            let heights = self.0.heightmap(name).ok_or(NucleationError::NotFound)?;
+            let bytes = heights.iter().flat_map(|h| h.to_le_bytes()).collect();
+            Ok(Box::new(Bytes(bytes)))
+        }
     }
 
     impl WorldSink {
@@ -268,4 +432,57 @@ pub mod ffi {
             sink.finish().map_err(|_| NucleationError::Io)
         }
     }
+
+    impl ShardedWorldSink {
+        /// Create a sharded sink writing a fresh world to `dir`, keeping at
+        /// most `max_open_regions` region buffers in memory. `options_json`
+        /// is as for `WorldSink::create`.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn create(
+            dir: &DiplomatStr,
+            options_json: &DiplomatStr,
+            max_open_regions: u32,
+        ) -> Result<Box<ShardedWorldSink>, NucleationError> {
+            let dir = std::str::from_utf8(dir).map_err(|_| NucleationError::InvalidArgument)?;
+            let options_json =
+                std::str::from_utf8(options_json).map_err(|_| NucleationError::InvalidArgument)?;
+            let options = if options_json.is_empty() {
+                None
+            } else {
+                Some(
+                    serde_json::from_str::<crate::formats::world::WorldExportOptions>(options_json)
+                        .map_err(|_| NucleationError::Parse)?,
+                )
+            };
+            crate::formats::world_stream::ShardedWorldSink::create(
+                std::path::Path::new(dir),
+                options,
+                max_open_regions as usize,
+            )
+            .map(|sink| Box::new(ShardedWorldSink(std::sync::RwLock::new(Some(sink)))))
+            .map_err(|_| NucleationError::Io)
+        }
+
+        /// Write a chunk view into the sink. Safe to call from several
+        /// threads at once; the view is not consumed.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn write_chunk(&self, view: &WorldChunkView) -> Result<(), NucleationError> {
+            let guard = self.0.read().map_err(|_| NucleationError::Lock)?;
+            let sink = guard.as_ref().ok_or(NucleationError::AlreadyConsumed)?;
+            sink.write_chunk(&view.0).map_err(|_| NucleationError::Io)
+        }
+
+        /// Write every buffered region and `level.dat`. Waits for in-flight
+        /// writes; afterwards every method returns `AlreadyConsumed`.
+        #[cfg(not(target_arch = "wasm32"))]
+        pub fn finish(&self) -> Result<(), NucleationError> {
+            let sink = self
+                .0
+                .write()
+                .map_err(|_| NucleationError::Lock)?
+                .take()
+                .ok_or(NucleationError::AlreadyConsumed)?;
+            sink.finish().map_err(|_| NucleationError::Io)
+        }
+    }
 }
@@ -1,6 +1,10 @@
+use super::color_index::ColorIndex;
 use crate::blockpedia::color::block_palettes::BlockFilter;
+use crate::blockpedia::color::rgb_to_oklab_simple;
 use crate::blockpedia::{all_blocks, BlockFacts, ExtendedColorData};
 use crate::BlockState;
+use rayon::prelude::*;
+use rustc_hash::FxHashMap;
 use std::sync::{Arc, OnceLock};
 
 pub struct PaletteBuilder {
@@ -158,6 +162,8 @@ pub struct BlockPalette {
     /// When set, brush snapping uses ordered (Bayer 4x4) dithering between
     /// the two nearest blocks instead of a hard nearest pick.
     dither: bool,
+    /// Built once from `blocks`; every nearest-color lookup goes through it.
+    index: ColorIndex,
 }
 
 /// Definition kinds of technical blocks that carry a color in blockpedia's
@@ -192,6 +198,15 @@ fn is_buildable(facts: &BlockFacts) -> bool {
 }
 
 impl BlockPalette {
+    fn from_blocks(blocks: Vec<(ExtendedColorData, String)>, dither: bool) -> Self {
+        let index = ColorIndex::new(blocks.iter().map(|(c, _)| c.oklab));
+        Self {
+            blocks,
+            dither,
+            index,
+        }
+    }
+
     /// Every colored block except the technical non-buildables
     /// (portals, fluids, fire, piston internals, ...).
     pub fn new_all() -> Self {
@@ -235,10 +250,7 @@ impl BlockPalette {
                 }
             }
         }
-        Self {
-            blocks,
-            dither: false,
-        }
+        Self::from_blocks(blocks, false)
     }
 
     /// Create a palette containing only concrete blocks
@@ -293,10 +305,7 @@ impl BlockPalette {
                 .partial_cmp(&b.0.oklab[0])
                 .unwrap_or(std::cmp::Ordering::Equal)
         });
-        Self {
-            blocks,
-            dither: false,
-        }
+        Self::from_blocks(blocks, false)
     }
 
     /// Sample an N-step color gradient from `start` to `end` (Oklab
@@ -431,10 +440,27 @@ impl BlockPalette {
                 }
             }
         }
-        Self {
-            blocks,
-            dither: false,
-        }
+        Self::from_blocks(blocks, false)
+    }
+
+    /// This palette with every block repeated once per brightness factor
+    /// in `shades`, its color scaled by that factor: entry
+    /// `i * shades.len() + s` is block `i` at `shades[s]`. Matching against
+    /// it picks a block and a shade together, as map-art staircasing needs.
+    pub fn with_shades(&self, shades: &[f32]) -> Self {
+        let blocks = self
+            .blocks
+            .iter()
+            .flat_map(|(color, id)| {
+                shades.iter().map(move |&shade| {
+                    let [r, g, b] = color
+                        .rgb
+                        .map(|c| (c as f32 * shade).round().clamp(0.0, 255.0) as u8);
+                    (ExtendedColorData::from_rgb(r, g, b), id.clone())
+                })
+            })
+            .collect();
+        Self::from_blocks(blocks, false)
     }
 
     pub fn len(&self) -> usize {
@@ -457,6 +483,7 @@ impl BlockPalette {
         Self {
             blocks: self.blocks.clone(),
             dither: true,
+            index: self.index.clone(),
         }
     }
 
@@ -489,62 +516,94 @@ impl BlockPalette {
         y: i32,
         z: i32,
     ) -> Option<String> {
-        if self.blocks.len() < 2 {
-            return self.find_closest(target);
-        }
-        let (mut ai, mut ad) = (0usize, f32::MAX);
-        let (mut bi, mut bd) = (0usize, f32::MAX);
-        for (i, (color, _)) in self.blocks.iter().enumerate() {
-            let d = target.distance_oklab(color);
-            if d < ad {
-                bi = ai;
-                bd = ad;
-                ai = i;
-                ad = d;
-            } else if d < bd {
-                bi = i;
-                bd = d;
-            }
-        }
+        let (ai, bi, f) = self.dither_pair(&target.oklab)?;
+        let pick = if f > bayer_threshold(x, y, z) { bi } else { ai };
+        Some(self.blocks[pick].1.clone())
+    }
+
+    /// The two nearest blocks to `t` and where `t` projects onto the Oklab
+    /// segment between them (0 at the nearest). A palette of one block, or
+    /// two coincident nearest colors, gives the nearest block twice at 0.
+    fn dither_pair(&self, t: &[f32; 3]) -> Option<(usize, usize, f32)> {
+        let Some((ai, bi)) = self.index.nearest_two(t) else {
+            return self.index.nearest(t).map(|i| (i, i, 0.0));
+        };
         let a = &self.blocks[ai].0.oklab;
         let b = &self.blocks[bi].0.oklab;
-        let t = &target.oklab;
         let ab = [b[0] - a[0], b[1] - a[1], b[2] - a[2]];
         let len_sq = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
         if len_sq < 1e-9 {
-            return Some(self.blocks[ai].1.clone());
+            return Some((ai, ai, 0.0));
         }
         let at = [t[0] - a[0], t[1] - a[1], t[2] - a[2]];
         let f = ((at[0] * ab[0] + at[1] * ab[1] + at[2] * ab[2]) / len_sq).clamp(0.0, 1.0);
-
-        // 4x4 Bayer matrix, y folded in so vertical runs dither too.
-        const BAYER: [[f32; 4]; 4] = [
-            [0.0, 8.0, 2.0, 10.0],
-            [12.0, 4.0, 14.0, 6.0],
-            [3.0, 11.0, 1.0, 9.0],
-            [15.0, 7.0, 13.0, 5.0],
-        ];
-        let bx = ((x + y) & 3) as usize;
-        let bz = ((z + (y >> 2)) & 3) as usize;
-        let threshold = (BAYER[bx][bz] + 0.5) / 16.0;
-        let pick = if f > threshold { bi } else { ai };
-        Some(self.blocks[pick].1.clone())
+        Some((ai, bi, f))
+    }
+
+    /// Palette index (in [`Self::block_ids`] order) of the nearest block
+    /// for every pixel of a `width`-pixel-wide image, `rgb` holding three
+    /// bytes per pixel, row-major. With `dither`, pixel (x, row) picks as
+    /// [`Self::find_closest_dithered`] does at (x, 0, row). Bands of rows
+    /// run in parallel, and a color repeated within a band is searched
+    /// once. Empty when the palette is.
+    pub fn closest_indices(&self, rgb: &[u8], width: usize, dither: bool) -> Vec<u32> {
+        const BAND_ROWS: usize = 64;
+        if self.is_empty() {
+            return Vec::new();
+        }
+        let width = width.max(1);
+        let mut out = vec![0u32; rgb.len() / 3];
+        out.par_chunks_mut(width * BAND_ROWS)
+            .zip(rgb.par_chunks(width * BAND_ROWS * 3))
+            .enumerate()
+            .for_each(|(band, (out, rgb))| {
+                let mut seen: FxHashMap<[u8; 3], (usize, usize, f32)> = FxHashMap::default();
+                for (i, (slot, px)) in out.iter_mut().zip(rgb.chunks_exact(3)).enumerate() {
+                    let color = [px[0], px[1], px[2]];
+                    let &mut (ai, bi, f) = seen.entry(color).or_insert_with(|| {
+                        let t = rgb_to_oklab_simple(color);
+                        if dither {
+                            self.dither_pair(&t)
+                        } else {
+                            self.index.nearest(&t).map(|i| (i, i, 0.0))
+                        }
+                        .unwrap_or_default()
+                    });
+                    let (x, row) = (i % width, band * BAND_ROWS + i / width);
+                    let pick = if f > bayer_threshold(x as i32, 0, row as i32) {
+                        bi
+                    } else {
+                        ai
+                    };
+                    *slot = pick as u32;
+                }
+            });
+        out
     }
 
+    /// The block whose Oklab color is nearest `target` (first in palette
+    /// order on ties).
     pub fn find_closest(&self, target: &ExtendedColorData) -> Option<String> {
-        let mut best_dist = f32::MAX;
-        let mut best_id = None;
-        for (color, id) in &self.blocks {
-            let dist = target.distance_oklab(color);
-            if dist < best_dist {
-                best_dist = dist;
-                best_id = Some(id);
-            }
-        }
-        best_id.cloned()
+        self.index
+            .nearest(&target.oklab)
+            .map(|i| self.blocks[i].1.clone())
     }
 }
 
+/// Ordered-dither threshold at a voxel: a 4x4 Bayer matrix with y folded
+/// in so vertical runs dither too.
+fn bayer_threshold(x: i32, y: i32, z: i32) -> f32 {
+    const BAYER: [[f32; 4]; 4] = [
+        [0.0, 8.0, 2.0, 10.0],
+        [12.0, 4.0, 14.0, 6.0],
+        [3.0, 11.0, 1.0, 9.0],
+        [15.0, 7.0, 13.0, 5.0],
+    ];
+    let bx = ((x + y) & 3) as usize;
+    let bz = ((z + (y >> 2)) & 3) as usize;
+    (BAYER[bx][bz] + 0.5) / 16.0
+}
+
 // Global default palette
 static DEFAULT_PALETTE: OnceLock<Arc<BlockPalette>> = OnceLock::new();
 
@@ -557,6 +616,12 @@ fn get_default_palette() -> Arc<BlockPalette> {
 pub trait Brush {
     /// Get the block to place at the given coordinates, optionally using the surface normal
     fn get_block(&self, x: i32, y: i32, z: i32, normal: (f64, f64, f64)) -> Option<BlockState>;
+
+    /// The block placed at every point, for brushes that never vary. Fills
+    /// use it to write whole runs instead of asking point by point.
+    fn uniform_block(&self) -> Option<&BlockState> {
+        None
+    }
 }
 
 /// A brush that places a single specific block
@@ -575,6 +640,10 @@ impl Brush for SolidBrush {
     fn get_block(&self, _x: i32, _y: i32, _z: i32, _normal: (f64, f64, f64)) -> Option<BlockState> {
         Some(self.block.clone())
     }
+
+    fn uniform_block(&self) -> Option<&BlockState> {
+        Some(&self.block)
+    }
 }
 
 /// A brush that places blocks closest to a specific color
@@ -1489,7 +1558,7 @@ fn sample_stops(stops: &[GradientStop], t: f64, space: InterpolationSpace) -> Ex
 /// drives geometry, pointed at color.
 #[derive(Clone)]
 pub struct FieldBrush {
-    field: crate::sdf::SdfNode,
+    field: crate::sdf::SdfTape,
     stops: Vec<GradientStop>,
     lo: f64,
     hi: f64,
@@ -1500,7 +1569,7 @@ pub struct FieldBrush {
 impl FieldBrush {
     pub fn new(field: crate::sdf::SdfNode, stops: Vec<GradientStop>, lo: f64, hi: f64) -> Self {
         Self {
-            field,
+            field: crate::sdf::SdfTape::compile(&field),
             stops,
             lo,
             hi,
@@ -0,0 +1,246 @@
+//! Nearest-color search over a [`BlockPalette`](super::BlockPalette).
+//!
+//! The palette's Oklab colors are arranged once into an implicit k-d tree
+//! (each subslice stores its median split in the middle), so a lookup
+//! visits a handful of blocks instead of all of them. Distances and ties
+//! resolve exactly as a linear scan with `distance_oklab` would: smallest
+//! distance first, lowest palette index on equal distances. Radius queries
+//! take the same exact distances.
+
+/// One palette color and its index in the palette.
+#[derive(Clone, Copy, Debug)]
+struct Entry {
+    lab: [f32; 3],
+    index: u32,
+}
+
+#[derive(Clone, Debug, Default)]
+pub(crate) struct ColorIndex {
+    /// Tree order: the split of `entries[lo..hi]` sits at `(lo + hi) / 2`.
+    entries: Vec<Entry>,
+    /// Split axis per position of `entries`.
+    axes: Vec<u8>,
+}
+
+/// The `k` best `(distance, index)` pairs seen so far, ascending.
+struct Best<const K: usize> {
+    items: [(f32, u32); K],
+    len: usize,
+}
+
+impl<const K: usize> Best<K> {
+    fn new() -> Self {
+        Self {
+            items: [(f32::MAX, u32::MAX); K],
+            len: 0,
+        }
+    }
+
+    fn offer(&mut self, d: f32, index: u32) {
+        if d.is_nan() {
+            // A linear scan's `<` never picks a NaN distance either.
+            return;
+        }
+        let item = (d, index);
+        let at = self.items[..self.len]
+            .iter()
+            .position(|&(bd, bi)| d < bd || (d == bd && index < bi))
+            .unwrap_or(self.len);
+        if at == K {
+            return;
+        }
+        self.items.copy_within(at..K - 1, at + 1);
+        self.items[at] = item;
+        self.len = (self.len + 1).min(K);
+    }
+
+    /// Whether a point at least `gap` away along one axis could still place.
+    fn reachable(&self, gap: f32) -> bool {
+        if self.len < K {
+            return true;
+        }
+        let worst = self.items[K - 1].0;
+        // Slack keeps far-side ties and rounding in distance_oklab in reach.
+        gap * gap <= worst * worst * 1.0001 + 1e-12
+    }
+}
+
+fn distance(t: &[f32; 3], c: &[f32; 3]) -> f32 {
+    // Same operations as ExtendedColorData::distance_oklab(target, color).
+    let dl = t[0] - c[0];
+    let da = t[1] - c[1];
+    let db = t[2] - c[2];
+    (dl * dl + da * da + db * db).sqrt()
+}
+
+impl ColorIndex {
+    pub(crate) fn new(colors: impl IntoIterator<Item = [f32; 3]>) -> Self {
+        let mut entries: Vec<Entry> = colors
+            .into_iter()
+            .enumerate()
+            .map(|(i, lab)| Entry {
+                lab,
+                index: i as u32,
+            })
+            .collect();
+        let mut axes = vec![0; entries.len()];
+        build(&mut entries, &mut axes);
+        Self { entries, axes }
+    }
+
+    /// Palette index of the nearest color to `target`.
+    pub(crate) fn nearest(&self, target: &[f32; 3]) -> Option<usize> {
+        let mut best = Best::<1>::new();
+        self.search(target, 0, self.entries.len(), &mut best);
+        (best.len > 0).then(|| best.items[0].1 as usize)
+    }
+
+    /// Palette indices of the two nearest colors, nearest first.
+    pub(crate) fn nearest_two(&self, target: &[f32; 3]) -> Option<(usize, usize)> {
+        let mut best = Best::<2>::new();
+        self.search(target, 0, self.entries.len(), &mut best);
+        (best.len == 2).then(|| (best.items[0].1 as usize, best.items[1].1 as usize))
+    }
+
+    /// Calls `f` with the palette index of every color no farther than
+    /// `radius` from `target`, in no particular order.
+    pub(crate) fn within(&self, target: &[f32; 3], radius: f32, mut f: impl FnMut(usize)) {
+        self.search_within(target, radius, 0, self.entries.len(), &mut f);
+    }
+
+    fn search_within(
+        &self,
+        t: &[f32; 3],
+        radius: f32,
+        lo: usize,
+        hi: usize,
+        f: &mut impl FnMut(usize),
+    ) {
+        if lo >= hi {
+            return;
+        }
+        let mid = (lo + hi) / 2;
+        let entry = &self.entries[mid];
+        if distance(t, &entry.lab) <= radius {
+            f(entry.index as usize);
+        }
+        let axis = self.axes[mid] as usize;
+        let gap = t[axis] - entry.lab[axis];
+        // Same slack as `Best::reachable`: only the exact check above decides.
+        let reach = radius * radius * 1.0001 + 1e-12;
+        if gap <= 0.0 || gap * gap <= reach {
+            self.search_within(t, radius, lo, mid, f);
+        }
+        if gap >= 0.0 || gap * gap <= reach {
+            self.search_within(t, radius, mid + 1, hi, f);
+        }
+    }
+
+    fn search<const K: usize>(&self, t: &[f32; 3], lo: usize, hi: usize, best: &mut Best<K>) {
+        if lo >= hi {
+            return;
+        }
+        let mid = (lo + hi) / 2;
+        let entry = &self.entries[mid];
+        best.offer(distance(t, &entry.lab), entry.index);
+        let axis = self.axes[mid] as usize;
+        let gap = t[axis] - entry.lab[axis];
+        let (near, far) = if gap < 0.0 {
+            ((lo, mid), (mid + 1, hi))
+        } else {
+            ((mid + 1, hi), (lo, mid))
+        };
+        self.search(t, near.0, near.1, best);
+        if best.reachable(gap) {
+            self.search(t, far.0, far.1, best);
+        }
+    }
+}
+
+/// Arrange `entries` into tree order, splitting on the widest axis.
+fn build(entries: &mut [Entry], axes: &mut [u8]) {
+    if entries.len() <= 1 {
+        return;
+    }
+    let axis = (0..3)
+        .map(|a| {
+            let (lo, hi) = entries.iter().fold((f32::MAX, f32::MIN), |(lo, hi), e| {
+                (lo.min(e.lab[a]), hi.max(e.lab[a]))
+            });
+            (hi - lo, a)
+        })
+        .max_by(|x, y| x.0.total_cmp(&y.0))
+        .map_or(0, |(_, a)| a);
+    let mid = entries.len() / 2;
+    entries.select_nth_unstable_by(mid, |a, b| a.lab[axis].total_cmp(&b.lab[axis]));
+    axes[mid] = axis as u8;
+    let (left, rest) = entries.split_at_mut(mid);
+    let (left_axes, rest_axes) = axes.split_at_mut(mid);
+    build(left, left_axes);
+    build(&mut rest[1..], &mut rest_axes[1..]);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn scan(colors: &[[f32; 3]], t: &[f32; 3]) -> (usize, usize) {
+        let (mut ai, mut ad) = (0usize, f32::MAX);
+        let (mut bi, mut bd) = (0usize, f32::MAX);
+        for (i, c) in colors.iter().enumerate() {
+            let d = distance(t, c);
+            if d < ad {
+                bi = ai;
+                bd = ad;
+                ai = i;
+                ad = d;
+            } else if d < bd {
+                bi = i;
+                bd = d;
+            }
+        }
+        (ai, bi)
+    }
+
+    #[test]
+    fn tree_lookups_match_a_linear_scan() {
+        // A deterministic spread of colors, with exact duplicates so ties
+        // between palette entries are exercised.
+        let mut state = 0x2545_f491_4f6c_dd1du64;
+        let mut next = || {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            (state >> 40) as f32 / (1u64 << 24) as f32
+        };
+        let mut colors: Vec<[f32; 3]> = (0..300)
+            .map(|_| [next(), next() * 0.4 - 0.2, next() * 0.4 - 0.2])
+            .collect();
+        colors.extend_from_within(10..40);
+        let index = ColorIndex::new(colors.iter().copied());
+        for _ in 0..2000 {
+            let t = [next(), next() * 0.5 - 0.25, next() * 0.5 - 0.25];
+            let expected = scan(&colors, &t);
+            assert_eq!(index.nearest(&t), Some(expected.0));
+            assert_eq!(index.nearest_two(&t), Some(expected));
+        }
+        for (t, radius) in [(colors[7], 0.05), ([0.5, 0.0, 0.0], 0.2), ([2.0; 3], 0.1)] {
+            let mut found = Vec::new();
+            index.within(&t, radius, |i| found.push(i));
+            found.sort_unstable();
+            let expected: Vec<usize> = (0..colors.len())
+                .filter(|&i| distance(&t, &colors[i]) <= radius)
+                .collect();
+            assert_eq!(found, expected);
+        }
+        // Querying an entry itself finds the first of its duplicates.
+        assert_eq!(index.nearest(&colors[305]), Some(15));
+
+        let empty = ColorIndex::new(std::iter::empty());
+        assert_eq!(empty.nearest(&[0.5, 0.0, 0.0]), None);
+        assert_eq!(
+            ColorIndex::new([[0.1, 0.0, 0.0]]).nearest_two(&[0.0; 3]),
+            None
+        );
+    }
+}
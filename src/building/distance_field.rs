@@ -9,28 +9,28 @@
 //! Materials can then key on depth (strata, a glowing core, a glass shell) and
 //! on slope (grass on the flats, stone on the steep faces) over any build.
 
-use std::collections::VecDeque;
+//!
+//! The depth is the exact Euclidean distance to the nearest empty voxel (space
+//! outside the box counts as empty), rounded up to whole blocks, from a
+//! separable Felzenszwalb–Huttenlocher transform: one linear-time pass per
+//! axis, each parallel over its rows. Depths are stored as `u16`; normals are
+//! taken from the stored field when asked for rather than kept per voxel.
 
-const NB: [(i32, i32, i32); 6] = [
-    (1, 0, 0),
-    (-1, 0, 0),
-    (0, 1, 0),
-    (0, -1, 0),
-    (0, 0, 1),
-    (0, 0, -1),
-];
+use rayon::prelude::*;
 
 pub struct DistanceField {
     min: (i32, i32, i32),
     dims: (usize, usize, usize),
     /// 0 = empty; n >= 1 = solid, n blocks below the nearest surface.
-    depth: Vec<i32>,
+    /// Laid out y-major (`(y, z, x)`, x fastest) so the last transform pass
+    /// writes disjoint slices.
+    depth: Vec<u16>,
 }
 
 impl DistanceField {
     fn lin(&self, dx: usize, dy: usize, dz: usize) -> usize {
-        let (w, h, _) = self.dims;
-        (dz * h + dy) * w + dx
+        let (w, _, d) = self.dims;
+        (dy * d + dz) * w + dx
     }
 
     fn local(&self, x: i32, y: i32, z: i32) -> Option<(usize, usize, usize)> {
@@ -47,62 +47,76 @@ impl DistanceField {
     }
 
     /// Build from an occupancy closure over an inclusive world-space box. A voxel
-    /// is a surface voxel when it is solid and touches empty space (or the box
-    /// edge); depth grows inward by one per block via multi-source BFS.
+    /// is a surface voxel (depth 1) when it is solid and touches empty space (or
+    /// the box edge); deeper voxels take their Euclidean distance to empty space.
     pub fn from_occupancy(
         min: (i32, i32, i32),
         max: (i32, i32, i32),
-        occupied: impl Fn(i32, i32, i32) -> bool,
+        occupied: impl Fn(i32, i32, i32) -> bool + Sync,
     ) -> Self {
         let dims = (
             (max.0 - min.0 + 1).max(0) as usize,
             (max.1 - min.1 + 1).max(0) as usize,
             (max.2 - min.2 + 1).max(0) as usize,
         );
-        let (w, h, d) = (dims.0 as i32, dims.1 as i32, dims.2 as i32);
-        let lin = |x: i32, y: i32, z: i32| ((z * h + y) * w + x) as usize;
-        let inb = |x: i32, y: i32, z: i32| x >= 0 && y >= 0 && z >= 0 && x < w && y < h && z < d;
-        let mut depth = vec![0i32; dims.0 * dims.1 * dims.2];
-
-        // -1 marks solid-but-unassigned.
-        for z in 0..d {
-            for y in 0..h {
-                for x in 0..w {
-                    if occupied(min.0 + x, min.1 + y, min.2 + z) {
-                        depth[lin(x, y, z)] = -1;
-                    }
-                }
-            }
+        let (w, h, d) = dims;
+        if w * h * d == 0 {
+            return DistanceField {
+                min,
+                dims,
+                depth: Vec::new(),
+            };
         }
 
-        let mut q: VecDeque<(i32, i32, i32)> = VecDeque::new();
-        for z in 0..d {
-            for y in 0..h {
-                for x in 0..w {
-                    if depth[lin(x, y, z)] != -1 {
-                        continue;
-                    }
-                    let surface = NB.iter().any(|&(dx, dy, dz)| {
-                        let (nx, ny, nz) = (x + dx, y + dy, z + dz);
-                        !inb(nx, ny, nz) || depth[lin(nx, ny, nz)] == 0
-                    });
-                    if surface {
-                        depth[lin(x, y, z)] = 1;
-                        q.push_back((x, y, z));
-                    }
+        // Squared distances, (z, y, x) with x fastest. Pass 1 (x): distance to
+        // the nearest empty voxel along each row.
+        let mut dist2 = vec![0u32; w * h * d];
+        dist2.par_chunks_mut(w).enumerate().for_each(|(row, out)| {
+            let (y, z) = ((row % h) as i32, (row / h) as i32);
+            let mut last = -1i64;
+            for (x, cell) in out.iter_mut().enumerate() {
+                if occupied(min.0 + x as i32, min.1 + y, min.2 + z) {
+                    *cell = (x as i64 - last) as u32;
+                } else {
+                    last = x as i64;
                 }
             }
-        }
-        while let Some((x, y, z)) = q.pop_front() {
-            let cur = depth[lin(x, y, z)];
-            for &(dx, dy, dz) in &NB {
-                let (nx, ny, nz) = (x + dx, y + dy, z + dz);
-                if inb(nx, ny, nz) && depth[lin(nx, ny, nz)] == -1 {
-                    depth[lin(nx, ny, nz)] = cur + 1;
-                    q.push_back((nx, ny, nz));
+            let mut next = w as i64;
+            for (x, cell) in out.iter_mut().enumerate().rev() {
+                if *cell == 0 {
+                    next = x as i64;
+                } else {
+                    let g = (*cell as i64).min(next - x as i64) as u32;
+                    *cell = g * g;
                 }
             }
-        }
+        });
+
+        // Pass 2 (y): columns within each z-slab.
+        dist2.par_chunks_mut(w * h).for_each(|slab| {
+            let mut edt = Edt::default();
+            for x in 0..w {
+                edt.run((0..h).map(|y| slab[y * w + x]));
+                for (y, &v) in edt.out.iter().enumerate() {
+                    slab[y * w + x] = v;
+                }
+            }
+        });
+
+        // Pass 3 (z): reads the (z, y, x) buffer, writes (y, z, x) depths.
+        let mut depth = vec![0u16; w * h * d];
+        depth
+            .par_chunks_mut(d * w)
+            .enumerate()
+            .for_each(|(y, out)| {
+                let mut edt = Edt::default();
+                for x in 0..w {
+                    edt.run((0..d).map(|z| dist2[(z * h + y) * w + x]));
+                    for (z, &v) in edt.out.iter().enumerate() {
+                        out[z * w + x] = (v as f64).sqrt().ceil().min(u16::MAX as f64) as u16;
+                    }
+                }
+            });
         DistanceField { min, dims, depth }
     }
 
@@ -110,7 +124,7 @@ impl DistanceField {
     /// surface, increasing inward.
     pub fn depth_at(&self, x: i32, y: i32, z: i32) -> i32 {
         self.local(x, y, z)
-            .map(|(dx, dy, dz)| self.depth[self.lin(dx, dy, dz)].max(0))
+            .map(|(dx, dy, dz)| self.depth[self.lin(dx, dy, dz)] as i32)
             .unwrap_or(0)
     }
 
@@ -132,6 +146,65 @@ impl DistanceField {
     }
 }
 
+/// One-dimensional squared distance transform (Felzenszwalb & Huttenlocher):
+/// `out[q] = min_p (q - p)² + f[p]`, with empty space (`f = 0`) just past
+/// both ends. The lower envelope of the parabolas rooted at each `p` is built
+/// in one sweep and read off in another; buffers are reused across rows.
+#[derive(Default)]
+struct Edt {
+    f: Vec<f64>,
+    v: Vec<usize>,
+    z: Vec<f64>,
+    out: Vec<u32>,
+}
+
+impl Edt {
+    fn run(&mut self, f: impl Iterator<Item = u32>) {
+        // Sample positions are shifted by one so the boundary sites sit at 0
+        // and n + 1.
+        self.f.clear();
+        self.f.push(0.0);
+        self.f.extend(f.map(f64::from));
+        self.f.push(0.0);
+        let n = self.f.len();
+        let f = &self.f;
+        let (v, z) = (&mut self.v, &mut self.z);
+        v.clear();
+        z.clear();
+        v.push(0);
+        z.push(f64::NEG_INFINITY);
+        z.push(f64::INFINITY);
+        for q in 1..n {
+            let qf = q as f64;
+            loop {
+                let p = *v.last().unwrap();
+                let pf = p as f64;
+                let s = ((f[q] + qf * qf) - (f[p] + pf * pf)) / (2.0 * (qf - pf));
+                if s <= z[v.len() - 1] {
+                    v.pop();
+                    z.pop();
+                } else {
+                    *z.last_mut().unwrap() = s;
+                    v.push(q);
+                    z.push(f64::INFINITY);
+                    break;
+                }
+            }
+        }
+        self.out.clear();
+        let mut k = 0;
+        for q in 1..n - 1 {
+            while z[k + 1] < q as f64 {
+                k += 1;
+            }
+            let p = v[k];
+            let dq = q.abs_diff(p) as u64;
+            self.out
+                .push((dq * dq + f[p] as u64).min(u32::MAX as u64) as u32);
+        }
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -148,4 +221,43 @@ mod tests {
         let (_, ny, _) = f.normal_at(3, 6, 3);
         assert!(ny > 0.7, "top normal should point up, got ny={ny}");
     }
+
+    #[test]
+    fn depth_is_the_rounded_up_euclidean_distance_to_empty_space() {
+        // A blob with a cavity, off-origin, checked against brute force.
+        let (min, max) = ((-4, 2, 1), (9, 12, 8));
+        let occupied = |x: i32, y: i32, z: i32| {
+            let r2 = (x - 2).pow(2) + (y - 7).pow(2) * 2 + (z - 4).pow(2);
+            r2 <= 40 && !(x == 3 && y == 7 && z == 4)
+        };
+        let f = DistanceField::from_occupancy(min, max, occupied);
+        for x in min.0..=max.0 {
+            for y in min.1..=max.1 {
+                for z in min.2..=max.2 {
+                    let mut best = i64::MAX;
+                    for ex in min.0 - 1..=max.0 + 1 {
+                        for ey in min.1 - 1..=max.1 + 1 {
+                            for ez in min.2 - 1..=max.2 + 1 {
+                                let inside = (min.0..=max.0).contains(&ex)
+                                    && (min.1..=max.1).contains(&ey)
+                                    && (min.2..=max.2).contains(&ez);
+                                if !inside || !occupied(ex, ey, ez) {
+                                    let d = ((ex - x).pow(2) + (ey - y).pow(2) + (ez - z).pow(2))
+                                        as i64;
+                                    best = best.min(d);
+                                }
+                            }
+                        }
+                    }
+                    let expected = (best as f64).sqrt().ceil() as i32;
+                    assert_eq!(f.depth_at(x, y, z), expected, "at {x},{y},{z}");
+                }
+            }
+        }
+        assert_eq!(f.depth_at(3, 7, 4), 0);
+        assert_eq!(f.depth_at(2, 7, 4), 1);
+
+        let empty = DistanceField::from_occupancy((0, 0, 0), (-1, 3, 3), |_, _, _| true);
+        assert_eq!(empty.depth_at(0, 0, 0), 0);
+    }
 }
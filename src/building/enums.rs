@@ -6,6 +6,8 @@ use crate::building::{
     Triangle, TubePath, Union,
 };
 use crate::BlockState;
+use std::collections::HashMap;
+use std::sync::{Arc, Mutex, OnceLock};
 
 // ============================================================================
 // Preset palette lookup
@@ -35,6 +37,25 @@ pub fn palette_by_name(name: &str) -> Result<BlockPalette, String> {
     })
 }
 
+/// [`palette_by_name`], built once per name and shared after that, so
+/// repeated lookups (scripting calls, per-pixel matching) reuse the
+/// palette's color index instead of rescanning every block.
+pub fn shared_palette_by_name(name: &str) -> Result<Arc<BlockPalette>, String> {
+    static PALETTES: OnceLock<Mutex<HashMap<String, Arc<BlockPalette>>>> = OnceLock::new();
+    let palettes = PALETTES.get_or_init(Default::default);
+    if let Some(palette) = palettes.lock().unwrap().get(name) {
+        return Ok(palette.clone());
+    }
+    // Built unlocked: the first build of a palette walks every block.
+    let palette = Arc::new(palette_by_name(name)?);
+    Ok(palettes
+        .lock()
+        .unwrap()
+        .entry(name.to_string())
+        .or_insert(palette)
+        .clone())
+}
+
 // ============================================================================
 // Delegate macro for ShapeEnum
 // ============================================================================
@@ -146,6 +167,17 @@ impl Shape for ShapeEnum {
     {
         delegate_shape!(self, for_each_point, f)
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        delegate_shape!(self, for_each_span, y, z, f)
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        delegate_shape!(self, spans_cover_points)
+    }
 }
 
 // ============================================================================
@@ -200,6 +232,13 @@ impl Brush for BrushEnum {
             BrushEnum::Field(b) => b.get_block(x, y, z, normal),
         }
     }
+
+    fn uniform_block(&self) -> Option<&BlockState> {
+        match self {
+            BrushEnum::Solid(b) => b.uniform_block(),
+            _ => None,
+        }
+    }
 }
 
 impl BrushEnum {
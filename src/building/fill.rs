@@ -0,0 +1,211 @@
+//! Parallel fill engine behind [`BuildingTool`](super::BuildingTool).
+//!
+//! The shape's points are split, in the shape's own order, into chunks that
+//! rayon paints concurrently. Each chunk dedupes the brush's output into a
+//! small local palette, so the serial write pass resolves every distinct
+//! block to a region palette index once and then stores plain indices
+//! straight into the region. Writes keep the shape's point order, so the
+//! result — palette order included — matches painting point by point.
+//!
+//! A brush that places one block everywhere skips all of that when the
+//! shape's row spans cover its points: rows are rasterized in parallel and
+//! each run is written with one [`Region::fill_uniform`].
+//!
+//! [`Region::fill_uniform`]: crate::region::Region::fill_uniform
+
+use std::collections::HashMap;
+
+use rayon::prelude::*;
+
+use super::masks::FillMode;
+use super::shapes::{Shape, Spans};
+use crate::{BlockState, UniversalSchematic};
+
+/// Points painted per rayon task.
+const CHUNK: usize = 4096;
+/// Cell marker for points the brush or the mask left alone.
+const SKIP: u32 = u32::MAX;
+
+/// One chunk's brush output: local palette ids per point.
+struct Painted {
+    palette: Vec<BlockState>,
+    cells: Vec<u32>,
+}
+
+/// Paint every point of `shape` that `mode` allows with `brush(x, y, z)`.
+pub(crate) fn paint<S, B>(schematic: &mut UniversalSchematic, shape: &S, mode: &FillMode, brush: B)
+where
+    S: Shape + ?Sized,
+    B: Fn(i32, i32, i32) -> Option<BlockState> + Sync,
+{
+    let mut points = Vec::new();
+    shape.for_each_point(|x, y, z| points.push((x, y, z)));
+    paint_points(schematic, shape.bounds(), &points, mode, |i| {
+        let (x, y, z) = points[i];
+        brush(x, y, z)
+    });
+}
+
+/// Paint `points` (within `bounds`, in order) that `mode` allows, with
+/// `brush(i)` giving the block for `points[i]`.
+pub(crate) fn paint_points<B>(
+    schematic: &mut UniversalSchematic,
+    bounds: (i32, i32, i32, i32, i32, i32),
+    points: &[(i32, i32, i32)],
+    mode: &FillMode,
+    brush: B,
+) where
+    B: Fn(usize) -> Option<BlockState> + Sync,
+{
+    let (min_x, min_y, min_z, max_x, max_y, max_z) = bounds;
+    schematic.ensure_bounds((min_x, min_y, min_z), (max_x, max_y, max_z));
+
+    // The mask is checked against the pre-fill schematic to skip brush work,
+    // and again at write time in case the shape visits a point twice.
+    let masked = !matches!(mode, FillMode::Replace);
+    let before = &*schematic;
+    let painted: Vec<Painted> = points
+        .par_chunks(CHUNK)
+        .enumerate()
+        .map(|(c, chunk)| {
+            let mut index: HashMap<BlockState, u32> = HashMap::new();
+            let mut palette = Vec::new();
+            let cells = chunk
+                .iter()
+                .enumerate()
+                .map(|(i, &(x, y, z))| {
+                    if masked && !mode.allows(before.get_block(x, y, z)) {
+                        return SKIP;
+                    }
+                    match brush(c * CHUNK + i) {
+                        Some(block) => *index.entry(block).or_insert_with_key(|block| {
+                            palette.push(block.clone());
+                            (palette.len() - 1) as u32
+                        }),
+                        None => SKIP,
+                    }
+                })
+                .collect();
+            Painted { palette, cells }
+        })
+        .collect();
+
+    let mut resolved: Vec<Option<usize>> = Vec::new();
+    for (chunk, painted) in points.chunks(CHUNK).zip(&painted) {
+        resolved.clear();
+        resolved.resize(painted.palette.len(), None);
+        for (&(x, y, z), &cell) in chunk.iter().zip(&painted.cells) {
+            if cell == SKIP || (masked && !mode.allows(schematic.get_block(x, y, z))) {
+                continue;
+            }
+            let block = &painted.palette[cell as usize];
+            let region = &mut schematic.default_region;
+            if !region.is_in_region(x, y, z) {
+                // A shape straying outside its own bounds: let set_block grow
+                // the region (which may rebuild its palette).
+                schematic.set_block(x, y, z, block);
+                resolved.fill(None);
+                continue;
+            }
+            let index = *resolved[cell as usize]
+                .get_or_insert_with(|| region.get_or_insert_palette_by_state(block));
+            region.set_block_at_index_unchecked(index, x, y, z);
+        }
+    }
+}
+
+/// Fill every run of `shape` with `block`. Only for shapes whose
+/// [spans cover their points](Shape::spans_cover_points).
+pub(crate) fn fill_spans<S>(schematic: &mut UniversalSchematic, shape: &S, block: &BlockState)
+where
+    S: Shape + Sync + ?Sized,
+{
+    let (min_x, min_y, min_z, max_x, max_y, max_z) = shape.bounds();
+    schematic.ensure_bounds((min_x, min_y, min_z), (max_x, max_y, max_z));
+
+    let rows: Vec<(i32, i32, Spans)> = (min_y..=max_y)
+        .into_par_iter()
+        .flat_map_iter(|y| (min_z..=max_z).map(move |z| (y, z, Spans::of(shape, y, z))))
+        .filter(|(_, _, spans)| !spans.is_empty())
+        .collect();
+    if rows.is_empty() {
+        return;
+    }
+    let region = &mut schematic.default_region;
+    let index = region.get_or_insert_palette_by_state(block);
+    for (y, z, spans) in &rows {
+        for (x0, x1) in spans.iter() {
+            region.fill_uniform((x0, *y, *z), (x1 - 1, *y, *z), index);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::building::Sphere;
+
+    #[test]
+    fn parallel_paint_matches_point_by_point_writes() {
+        let shape = Sphere::new((3, -2, 5), 21.0);
+        let brush = |x: i32, y: i32, z: i32| match (x + 2 * y + 3 * z).rem_euclid(5) {
+            0 => None,
+            1 => Some(BlockState::new("minecraft:stone".to_string())),
+            2 => Some(BlockState::new("minecraft:dirt".to_string())),
+            3 => Some(BlockState::new("minecraft:oak_log".to_string()).with_property("axis", "x")),
+            _ => Some(BlockState::new("minecraft:glass".to_string())),
+        };
+
+        let mut expected = UniversalSchematic::new("a".to_string());
+        let (x0, y0, z0, x1, y1, z1) = shape.bounds();
+        expected.ensure_bounds((x0, y0, z0), (x1, y1, z1));
+        shape.for_each_point(|x, y, z| {
+            if let Some(block) = brush(x, y, z) {
+                expected.set_block(x, y, z, &block);
+            }
+        });
+
+        let mut painted = UniversalSchematic::new("b".to_string());
+        paint(&mut painted, &shape, &FillMode::Replace, brush);
+        assert_eq!(
+            painted.default_region.get_palette(),
+            expected.default_region.get_palette()
+        );
+        assert_eq!(painted.total_blocks(), expected.total_blocks());
+        shape.for_each_point(|x, y, z| {
+            assert_eq!(painted.get_block(x, y, z), expected.get_block(x, y, z));
+        });
+
+        // KeepExisting leaves everything painted above untouched.
+        let before = painted.total_blocks();
+        paint(&mut painted, &shape, &FillMode::KeepExisting, |_, _, _| {
+            Some(BlockState::new("minecraft:sand".to_string()))
+        });
+        assert!(painted.total_blocks() > before);
+        assert_eq!(painted.get_block(3, -2, 6), expected.get_block(3, -2, 6));
+    }
+
+    #[test]
+    fn span_fill_matches_point_fill() {
+        let shape = Sphere::new((1, 4, -2), 12.5);
+        let stone = BlockState::new("minecraft:stone".to_string());
+
+        let mut expected = UniversalSchematic::new("a".to_string());
+        expected.set_block_str(1, 4, -2, "minecraft:dirt");
+        let mut filled = expected.clone();
+        paint(&mut expected, &shape, &FillMode::Replace, |_, _, _| {
+            Some(stone.clone())
+        });
+        fill_spans(&mut filled, &shape, &stone);
+
+        assert_eq!(filled.total_blocks(), expected.total_blocks());
+        let (x0, y0, z0, x1, y1, z1) = shape.bounds();
+        for x in x0 - 1..=x1 + 1 {
+            for y in y0 - 1..=y1 + 1 {
+                for z in z0 - 1..=z1 + 1 {
+                    assert_eq!(filled.get_block(x, y, z), expected.get_block(x, y, z));
+                }
+            }
+        }
+    }
+}
@@ -1,6 +1,8 @@
 pub mod brushes;
+pub(crate) mod color_index;
 pub mod distance_field;
 pub mod enums;
+pub(crate) mod fill;
 pub mod masks;
 pub mod shapes;
 
@@ -22,16 +24,16 @@ impl<'a> BuildingTool<'a> {
     }
 
     /// Fill a shape with a brush using generic trait objects (pure Rust API).
-    pub fn fill(&mut self, shape: &impl Shape, brush: &impl Brush) {
-        let (min_x, min_y, min_z, max_x, max_y, max_z) = shape.bounds();
-        self.schematic
-            .ensure_bounds((min_x, min_y, min_z), (max_x, max_y, max_z));
-
-        shape.for_each_point(|x, y, z| {
-            let normal = shape.normal_at(x, y, z);
-            if let Some(block) = brush.get_block(x, y, z, normal) {
-                self.schematic.set_block(x, y, z, &block);
+    /// The brush runs on the shape's points in parallel; a uniform brush
+    /// writes the shape's row spans whole.
+    pub fn fill(&mut self, shape: &(impl Shape + Sync), brush: &(impl Brush + Sync)) {
+        if let Some(block) = brush.uniform_block() {
+            if shape.spans_cover_points() {
+                return fill::fill_spans(self.schematic, shape, block);
             }
+        }
+        fill::paint(self.schematic, shape, &FillMode::Replace, |x, y, z| {
+            brush.get_block(x, y, z, shape.normal_at(x, y, z))
         });
     }
 
@@ -45,19 +47,15 @@ impl<'a> BuildingTool<'a> {
     /// [`FillMode::KeepExisting`] only fills air/unset cells, and
     /// [`FillMode::ReplaceOnly`] only overwrites the listed block ids.
     pub fn fill_enum_masked(&mut self, shape: &ShapeEnum, brush: &BrushEnum, mode: &FillMode) {
-        let (min_x, min_y, min_z, max_x, max_y, max_z) = shape.bounds();
-        self.schematic
-            .ensure_bounds((min_x, min_y, min_z), (max_x, max_y, max_z));
-
-        shape.for_each_point(|x, y, z| {
-            if !mode.allows(self.schematic.get_block(x, y, z)) {
-                return;
+        if let (FillMode::Replace, Some(block)) = (mode, brush.uniform_block()) {
+            if shape.spans_cover_points() {
+                return fill::fill_spans(self.schematic, shape, block);
             }
+        }
+        fill::paint(self.schematic, shape, mode, |x, y, z| {
             let normal = shape.normal_at(x, y, z);
             let t = shape.parameter_at(x, y, z);
-            if let Some(block) = brush.get_block_with_parameter(x, y, z, normal, t) {
-                self.schematic.set_block(x, y, z, &block);
-            }
+            brush.get_block_with_parameter(x, y, z, normal, t)
         });
     }
 
@@ -75,17 +73,22 @@ impl<'a> BuildingTool<'a> {
             let dy = offset.1 * i as i32;
             let dz = offset.2 * i as i32;
             let translated = TranslatedShape::new(shape, dx, dy, dz);
-            let (min_x, min_y, min_z, max_x, max_y, max_z) = translated.bounds();
-            self.schematic
-                .ensure_bounds((min_x, min_y, min_z), (max_x, max_y, max_z));
-
-            translated.for_each_point(|x, y, z| {
-                let normal = translated.normal_at(x, y, z);
-                let t = shape.parameter_at(x - dx, y - dy, z - dz);
-                if let Some(block) = brush.get_block_with_parameter(x, y, z, normal, t) {
-                    self.schematic.set_block(x, y, z, &block);
+            if let Some(block) = brush.uniform_block() {
+                if translated.spans_cover_points() {
+                    fill::fill_spans(self.schematic, &translated, block);
+                    continue;
                 }
-            });
+            }
+            fill::paint(
+                self.schematic,
+                &translated,
+                &FillMode::Replace,
+                |x, y, z| {
+                    let normal = translated.normal_at(x, y, z);
+                    let t = shape.parameter_at(x - dx, y - dy, z - dz);
+                    brush.get_block_with_parameter(x, y, z, normal, t)
+                },
+            );
         }
     }
 }
@@ -144,4 +147,17 @@ impl Shape for TranslatedShape<'_> {
             f(x + dx, y + dy, z + dz);
         });
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let dx = self.dx;
+        self.inner
+            .for_each_span(y - self.dy, z - self.dz, |x0, x1| f(x0 + dx, x1 + dx));
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        self.inner.spans_cover_points()
+    }
 }
@@ -1,4 +1,4 @@
-use super::Shape;
+use super::{Shape, Spans};
 use crate::building::enums::ShapeEnum;
 
 #[derive(Clone)]
@@ -63,6 +63,21 @@ impl Shape for Union {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let mut spans = Spans::of(&*self.a, y, z);
+        spans.union_with(&Spans::of(&*self.b, y, z));
+        for (x0, x1) in spans.iter() {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        self.a.spans_cover_points() && self.b.spans_cover_points()
+    }
 }
 
 #[derive(Clone)]
@@ -123,6 +138,21 @@ impl Shape for Intersection {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let mut spans = Spans::of(&*self.a, y, z);
+        spans.intersection_with(&Spans::of(&*self.b, y, z));
+        for (x0, x1) in spans.iter() {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        self.a.spans_cover_points() && self.b.spans_cover_points()
+    }
 }
 
 #[derive(Clone)]
@@ -174,4 +204,19 @@ impl Shape for Difference {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let mut spans = Spans::of(&*self.a, y, z);
+        spans.difference_with(&Spans::of(&*self.b, y, z));
+        for (x0, x1) in spans.iter() {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        self.a.spans_cover_points() && self.b.spans_cover_points()
+    }
 }
@@ -52,4 +52,17 @@ impl Shape for Cuboid {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        if y >= self.min.1 && y <= self.max.1 && z >= self.min.2 && z <= self.max.2 {
+            f(self.min.0, self.max.0 + 1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        true
+    }
 }
@@ -1,3 +1,4 @@
+use super::spans::{quadratic_le_zero, settle};
 use super::{ParametricShape, Shape};
 
 #[derive(Clone)]
@@ -127,6 +128,50 @@ impl Shape for Cylinder {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let (min_x, min_y, min_z, max_x, max_y, max_z) = self.bounds();
+        if y < min_y || y > max_y || z < min_z || z > max_z {
+            return;
+        }
+        let ax = self.normalized_axis();
+        let dy = y as f64 - self.base_center.1;
+        let dz = z as f64 - self.base_center.2;
+        // Along the row, with u = x - base.x: axial = ax.0·u + k is linear
+        // and radial² = (1 - ax.0²)·u² - 2·ax.0·k·u + (dy² + dz² - k²).
+        let k = dy * ax.1 + dz * ax.2;
+        let (mut lo, mut hi) = if ax.0 > 0.0 {
+            (-k / ax.0, (self.height - k) / ax.0)
+        } else if ax.0 < 0.0 {
+            ((self.height - k) / ax.0, -k / ax.0)
+        } else if (0.0..=self.height).contains(&k) {
+            (f64::NEG_INFINITY, f64::INFINITY)
+        } else {
+            return;
+        };
+        let a = 1.0 - ax.0 * ax.0;
+        let c = dy * dy + dz * dz - k * k - self.radius * self.radius;
+        if a > 1e-9 {
+            let (r0, r1) = quadratic_le_zero(a, -2.0 * ax.0 * k, c);
+            lo = lo.max(r0);
+            hi = hi.min(r1);
+        } else if c > 1e-9 * self.radius * self.radius + 1e-9 {
+            // Axis along x: the radial distance is the same all along the row.
+            return;
+        }
+        let bx = self.base_center.0;
+        if let Some((x0, x1)) = settle(bx + lo, bx + hi, (min_x, max_x), |x| self.contains(x, y, z))
+        {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        true
+    }
 }
 
 impl ParametricShape for Cylinder {
@@ -1,3 +1,4 @@
+use super::spans::settle;
 use super::Shape;
 
 #[derive(Clone)]
@@ -67,4 +68,25 @@ impl Shape for Ellipsoid {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let (min_x, min_y, min_z, max_x, max_y, max_z) = self.bounds();
+        if y < min_y || y > max_y || z < min_z || z > max_z {
+            return;
+        }
+        let dy = (y - self.center.1) as f64 / self.radii.1;
+        let dz = (z - self.center.2) as f64 / self.radii.2;
+        let w = self.radii.0 * (1.0 - (dy * dy + dz * dz)).sqrt();
+        let cx = self.center.0 as f64;
+        if let Some((x0, x1)) = settle(cx - w, cx + w, (min_x, max_x), |x| self.contains(x, y, z)) {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        true
+    }
 }
@@ -1,4 +1,4 @@
-use super::Shape;
+use super::{Shape, Spans};
 use crate::building::enums::ShapeEnum;
 
 #[derive(Clone)]
@@ -66,4 +66,26 @@ impl Shape for Hollow {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let row = Spans::of(&*self.inner, y, z);
+        if row.is_empty() {
+            return;
+        }
+        let t = self.thickness as i32;
+        let neighbours: Vec<Spans> = (1..=t)
+            .flat_map(|d| [(y + d, z), (y - d, z), (y, z + d), (y, z - d)])
+            .map(|(ny, nz)| Spans::of(&*self.inner, ny, nz))
+            .collect();
+        for (x0, x1) in Spans::hollow(&row, &neighbours, t).iter() {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        self.inner.spans_cover_points()
+    }
 }
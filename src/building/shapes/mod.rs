@@ -12,6 +12,7 @@ mod plane;
 mod polygon_prism;
 mod pyramid;
 mod sdf_shape;
+mod spans;
 mod sphere;
 mod torus;
 mod triangle;
@@ -30,6 +31,7 @@ pub use plane::Plane;
 pub use polygon_prism::PolygonPrism;
 pub use pyramid::Pyramid;
 pub use sdf_shape::SdfShape;
+pub use spans::Spans;
 pub use sphere::Sphere;
 pub use torus::Torus;
 pub use triangle::Triangle;
@@ -47,6 +49,24 @@ pub trait Shape {
     fn for_each_point<F>(&self, f: F)
     where
         F: FnMut(i32, i32, i32);
+
+    /// Calls `f(x0, x1)` for each maximal run `[x0, x1)` of contained points
+    /// on the row at `(y, z)`, left to right, within [`bounds`](Self::bounds).
+    /// The default tests `contains` across the row; analytic shapes solve
+    /// for the run ends instead.
+    fn for_each_span<F>(&self, y: i32, z: i32, f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        spans::scan(self, y, z, f)
+    }
+
+    /// Whether the spans are exactly the points `for_each_point` visits
+    /// (the shape contains nothing outside its bounds and rasterizes by
+    /// testing `contains`), so fills may write whole runs at once.
+    fn spans_cover_points(&self) -> bool {
+        false
+    }
 }
 
 pub trait ParametricShape: Shape {
@@ -1,4 +1,4 @@
-use super::Shape;
+use super::{Shape, Spans};
 
 /// A vertical prism: a closed 2D polygon in the X/Z plane extruded between two
 /// Y levels. The footprint is filled by an even-odd point-in-polygon test at
@@ -51,25 +51,31 @@ impl PolygonPrism {
 
     /// Even-odd ray cast in the X/Z plane.
     fn footprint_contains(&self, px: f64, pz: f64) -> bool {
+        let mut inside = false;
+        self.for_each_crossing(pz, |xint| {
+            if px < xint {
+                inside = !inside;
+            }
+        });
+        inside
+    }
+
+    /// The x of every footprint edge crossing the line at `pz`.
+    fn for_each_crossing(&self, pz: f64, mut f: impl FnMut(f64)) {
         let v = &self.verts;
         let n = v.len();
         if n < 3 {
-            return false;
+            return;
         }
-        let mut inside = false;
         let mut j = n - 1;
         for i in 0..n {
             let (xi, zi) = v[i];
             let (xj, zj) = v[j];
             if (zi > pz) != (zj > pz) {
-                let xint = (xj - xi) * (pz - zi) / (zj - zi) + xi;
-                if px < xint {
-                    inside = !inside;
-                }
+                f((xj - xi) * (pz - zi) / (zj - zi) + xi);
             }
             j = i;
         }
-        inside
     }
 }
 
@@ -112,6 +118,51 @@ impl Shape for PolygonPrism {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        if y < self.y_min || y > self.y_max || z < self.min_z || z > self.max_z {
+            return;
+        }
+        // Voxel x is inside when an odd number of the edge crossings on this
+        // row lie right of x + 0.5, so the parity flips at the first x each
+        // crossing stops counting for.
+        let pz = z as f64 + 0.5;
+        let mut cuts = Vec::new();
+        self.for_each_crossing(pz, |xint| {
+            let mut t = ((xint - 0.5).ceil() as i32).clamp(self.min_x, self.max_x + 1);
+            while t > self.min_x && (t - 1) as f64 + 0.5 >= xint {
+                t -= 1;
+            }
+            while t <= self.max_x && (t as f64 + 0.5) < xint {
+                t += 1;
+            }
+            cuts.push(t);
+        });
+        cuts.sort_unstable();
+        let mut inside = cuts.len() % 2 == 1;
+        let mut from = self.min_x;
+        let mut runs = Spans::new();
+        for t in cuts {
+            if inside {
+                runs.push(from, t);
+            }
+            inside = !inside;
+            from = t;
+        }
+        if inside {
+            runs.push(from, self.max_x + 1);
+        }
+        for (x0, x1) in runs.iter() {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        true
+    }
 }
 
 #[cfg(test)]
@@ -1,5 +1,5 @@
 use super::Shape;
-use crate::sdf::SdfNode;
+use crate::sdf::{SdfNode, SdfTape};
 use std::sync::Arc;
 
 /// An SDF tree used as a building [`Shape`] — the bridge between the two
@@ -12,7 +12,8 @@ use std::sync::Arc;
 /// at the block center (`x + 0.5`), solid where `eval <= 0`.
 #[derive(Clone)]
 pub struct SdfShape {
-    node: Arc<SdfNode>,
+    /// The tree compiled once; every membership test runs the tape.
+    tape: Arc<SdfTape>,
     bounds: (i32, i32, i32, i32, i32, i32),
 }
 
@@ -30,7 +31,7 @@ impl SdfShape {
             b.max[2].ceil() as i32,
         );
         Some(Self {
-            node: Arc::new(node),
+            tape: Arc::new(SdfTape::compile(&node)),
             bounds,
         })
     }
@@ -38,13 +39,13 @@ impl SdfShape {
     /// Wrap a tree with explicit sampling bounds (inclusive block coords).
     pub fn with_bounds(node: SdfNode, min: (i32, i32, i32), max: (i32, i32, i32)) -> Self {
         Self {
-            node: Arc::new(node),
+            tape: Arc::new(SdfTape::compile(&node)),
             bounds: (min.0, min.1, min.2, max.0, max.1, max.2),
         }
     }
 
     fn eval_center(&self, x: i32, y: i32, z: i32) -> f32 {
-        self.node
+        self.tape
             .eval(x as f32 + 0.5, y as f32 + 0.5, z as f32 + 0.5)
     }
 }
@@ -71,9 +72,9 @@ impl Shape for SdfShape {
         // Central-difference gradient of the field at the block center.
         let (fx, fy, fz) = (x as f32 + 0.5, y as f32 + 0.5, z as f32 + 0.5);
         const H: f32 = 0.5;
-        let nx = self.node.eval(fx + H, fy, fz) - self.node.eval(fx - H, fy, fz);
-        let ny = self.node.eval(fx, fy + H, fz) - self.node.eval(fx, fy - H, fz);
-        let nz = self.node.eval(fx, fy, fz + H) - self.node.eval(fx, fy, fz - H);
+        let nx = self.tape.eval(fx + H, fy, fz) - self.tape.eval(fx - H, fy, fz);
+        let ny = self.tape.eval(fx, fy + H, fz) - self.tape.eval(fx, fy - H, fz);
+        let nz = self.tape.eval(fx, fy, fz + H) - self.tape.eval(fx, fy, fz - H);
         let len = ((nx * nx + ny * ny + nz * nz) as f64).sqrt();
         if len < 1e-9 {
             (0.0, 1.0, 0.0)
@@ -91,14 +92,58 @@ impl Shape for SdfShape {
         F: FnMut(i32, i32, i32),
     {
         let (x0, y0, z0, x1, y1, z1) = self.bounds;
+        if z1 < z0 {
+            return;
+        }
+        // One z-row per batch.
+        let zs: Vec<f32> = (z0..=z1).map(|z| z as f32 + 0.5).collect();
+        let (mut xs, mut ys) = (vec![0.0; zs.len()], vec![0.0; zs.len()]);
+        let mut dist = vec![0.0; zs.len()];
         for x in x0..=x1 {
+            xs.fill(x as f32 + 0.5);
             for y in y0..=y1 {
-                for z in z0..=z1 {
-                    if self.eval_center(x, y, z) <= 0.0 {
+                ys.fill(y as f32 + 0.5);
+                self.tape.eval_batch(&xs, &ys, &zs, &mut dist);
+                for (z, d) in (z0..).zip(&dist) {
+                    if *d <= 0.0 {
                         f(x, y, z);
                     }
                 }
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let (x0, y0, z0, x1, y1, z1) = self.bounds;
+        if x1 < x0 || y < y0 || y > y1 || z < z0 || z > z1 {
+            return;
+        }
+        // The whole row in one batch.
+        let xs: Vec<f32> = (x0..=x1).map(|x| x as f32 + 0.5).collect();
+        let ys = vec![y as f32 + 0.5; xs.len()];
+        let zs = vec![z as f32 + 0.5; xs.len()];
+        let mut dist = vec![0.0; xs.len()];
+        self.tape.eval_batch(&xs, &ys, &zs, &mut dist);
+        let mut start = None;
+        for (x, d) in (x0..).zip(&dist) {
+            match (start, *d <= 0.0) {
+                (None, true) => start = Some(x),
+                (Some(s), false) => {
+                    f(s, x);
+                    start = None;
+                }
+                _ => {}
+            }
+        }
+        if let Some(s) = start {
+            f(s, x1 + 1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        true
+    }
 }
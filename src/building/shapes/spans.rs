@@ -0,0 +1,312 @@
+//! Row spans: the points of a shape on one `(y, z)` row as half-open x runs.
+//!
+//! Analytic shapes solve for their run ends instead of testing every voxel,
+//! and composites combine their children's runs with the boolean ops here.
+
+use super::Shape;
+
+/// Sorted, disjoint, non-touching runs `[x0, x1)` of one row.
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct Spans(Vec<(i32, i32)>);
+
+impl Spans {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// The runs of `shape` on row `(y, z)`.
+    pub fn of<S: Shape + ?Sized>(shape: &S, y: i32, z: i32) -> Self {
+        let mut spans = Self::new();
+        shape.for_each_span(y, z, |x0, x1| spans.push(x0, x1));
+        spans
+    }
+
+    /// Append `[x0, x1)`, which must not start left of the last run. Empty
+    /// runs are dropped; runs touching or overlapping the last one merge.
+    pub fn push(&mut self, x0: i32, x1: i32) {
+        if x0 >= x1 {
+            return;
+        }
+        match self.0.last_mut() {
+            Some(last) if x0 <= last.1 => {
+                debug_assert!(x0 >= last.0, "spans pushed out of order");
+                last.1 = last.1.max(x1);
+            }
+            _ => self.0.push((x0, x1)),
+        }
+    }
+
+    pub fn as_slice(&self) -> &[(i32, i32)] {
+        &self.0
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.0.is_empty()
+    }
+
+    pub fn clear(&mut self) {
+        self.0.clear();
+    }
+
+    /// Number of points covered.
+    pub fn count(&self) -> usize {
+        self.0.iter().map(|&(a, b)| (b - a) as usize).sum()
+    }
+
+    pub fn contains(&self, x: i32) -> bool {
+        let i = self.0.partition_point(|&(_, b)| b <= x);
+        self.0.get(i).is_some_and(|&(a, _)| a <= x)
+    }
+
+    pub fn union_with(&mut self, other: &Spans) {
+        *self = combine(self, other, |a, b| a || b);
+    }
+
+    pub fn intersection_with(&mut self, other: &Spans) {
+        *self = combine(self, other, |a, b| a && b);
+    }
+
+    pub fn difference_with(&mut self, other: &Spans) {
+        *self = combine(self, other, |a, b| a && !b);
+    }
+
+    /// Shrink every run by `d` at both ends: what is left are the points
+    /// whose `d` neighbours either side along x are all covered.
+    pub fn erode(&mut self, d: i32) {
+        self.0 = self
+            .0
+            .iter()
+            .map(|&(a, b)| (a + d, b - d))
+            .filter(|&(a, b)| a < b)
+            .collect();
+    }
+
+    /// The runs of the shell of depth `thickness` of a solid, given the
+    /// solid's runs on this row (`row`) and on every row up to `thickness`
+    /// steps away along y and z (`neighbours`, in any order): what
+    /// [`Hollow`](super::Hollow) keeps of `row`.
+    pub fn hollow<'a>(
+        row: &Spans,
+        neighbours: impl IntoIterator<Item = &'a Spans>,
+        thickness: i32,
+    ) -> Spans {
+        let mut interior = row.clone();
+        interior.erode(thickness);
+        for n in neighbours {
+            interior.intersection_with(n);
+        }
+        let mut shell = row.clone();
+        shell.difference_with(&interior);
+        shell
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = (i32, i32)> + '_ {
+        self.0.iter().copied()
+    }
+}
+
+/// Test `contains` across the row `(y, z)` of `shape`'s bounds, calling
+/// `f` once per maximal run.
+pub(crate) fn scan<S, F>(shape: &S, y: i32, z: i32, mut f: F)
+where
+    S: Shape + ?Sized,
+    F: FnMut(i32, i32),
+{
+    let (min_x, min_y, min_z, max_x, max_y, max_z) = shape.bounds();
+    if y < min_y || y > max_y || z < min_z || z > max_z {
+        return;
+    }
+    let mut start = None;
+    for x in min_x..=max_x {
+        match (start, shape.contains(x, y, z)) {
+            (None, true) => start = Some(x),
+            (Some(x0), false) => {
+                f(x0, x);
+                start = None;
+            }
+            _ => {}
+        }
+    }
+    if let Some(x0) = start {
+        f(x0, max_x + 1);
+    }
+}
+
+/// Sweep the run ends of `a` and `b` left to right, keeping the stretches
+/// where `keep(in_a, in_b)` holds.
+fn combine(a: &Spans, b: &Spans, keep: impl Fn(bool, bool) -> bool) -> Spans {
+    // Run ends of one list, flattened: even positions open, odd ones close.
+    let edge = |s: &Spans, i: usize| {
+        s.0.get(i / 2)
+            .map(|&(x0, x1)| if i % 2 == 0 { x0 } else { x1 })
+    };
+    let mut out = Spans::new();
+    let (mut i, mut j) = (0, 0);
+    let mut start = None;
+    loop {
+        let x = match (edge(a, i), edge(b, j)) {
+            (None, None) => break,
+            (ea, eb) => ea.unwrap_or(i32::MAX).min(eb.unwrap_or(i32::MAX)),
+        };
+        if edge(a, i) == Some(x) {
+            i += 1;
+        }
+        if edge(b, j) == Some(x) {
+            j += 1;
+        }
+        match (start, keep(i % 2 == 1, j % 2 == 1)) {
+            (None, true) => start = Some(x),
+            (Some(s), false) => {
+                out.push(s, x);
+                start = None;
+            }
+            _ => {}
+        }
+    }
+    out
+}
+
+/// The run of a row whose points form one interval, from a real estimate
+/// `[lo, hi]` of its ends. The ends are corrected against `contains`, so
+/// rounding in the estimate never changes the result; a few `contains`
+/// calls per row instead of one per voxel. Clipped to `min_x..=max_x`.
+pub(crate) fn settle(
+    lo: f64,
+    hi: f64,
+    (min_x, max_x): (i32, i32),
+    contains: impl Fn(i32) -> bool,
+) -> Option<(i32, i32)> {
+    if min_x > max_x || lo.is_nan() || hi.is_nan() {
+        return None;
+    }
+    let a0 = lo.ceil().clamp(min_x as f64, max_x as f64) as i32;
+    let b0 = hi.floor().clamp(min_x as f64, max_x as f64) as i32;
+    // Search one past the estimate on each side; an estimate that came out
+    // empty only by rounding leaves a gap of at most two.
+    let (from, to) = if a0 <= b0 {
+        (a0 - 1, b0 + 1)
+    } else if a0 - b0 <= 2 {
+        (b0, a0)
+    } else {
+        return None;
+    };
+    let (from, to) = (from.max(min_x), to.min(max_x));
+    let mut a = (from..=to).find(|&x| contains(x))?;
+    let mut b = (a..=to).rev().find(|&x| contains(x))?;
+    while a > min_x && contains(a - 1) {
+        a -= 1;
+    }
+    while b < max_x && contains(b + 1) {
+        b += 1;
+    }
+    Some((a, b + 1))
+}
+
+/// The interval of real `t` with `a·t² + b·t + c ≤ 0`, for `a > 0`. A
+/// negative discriminant collapses to the vertex so [`settle`] can still
+/// probe a row that only grazes the shape.
+pub(crate) fn quadratic_le_zero(a: f64, b: f64, c: f64) -> (f64, f64) {
+    let vertex = -b / (2.0 * a);
+    let disc = b * b - 4.0 * a * c;
+    if disc < 0.0 {
+        return (vertex, vertex);
+    }
+    let w = disc.sqrt() / (2.0 * a);
+    (vertex - w, vertex + w)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::building::enums::ShapeEnum;
+    use crate::building::shapes::{
+        Cuboid, Cylinder, Difference, Ellipsoid, Hollow, Intersection, PolygonPrism, Sphere, Torus,
+        Union,
+    };
+
+    fn spans(v: &[(i32, i32)]) -> Spans {
+        let mut s = Spans::new();
+        for &(a, b) in v {
+            s.push(a, b);
+        }
+        s
+    }
+
+    #[test]
+    fn boolean_ops_on_runs() {
+        let a = spans(&[(0, 5), (8, 12)]);
+        let b = spans(&[(3, 9), (12, 14)]);
+        let mut u = a.clone();
+        u.union_with(&b);
+        assert_eq!(u, spans(&[(0, 14)]));
+        let mut i = a.clone();
+        i.intersection_with(&b);
+        assert_eq!(i, spans(&[(3, 5), (8, 9)]));
+        let mut d = a.clone();
+        d.difference_with(&b);
+        assert_eq!(d, spans(&[(0, 3), (9, 12)]));
+        let mut e = a.clone();
+        e.erode(2);
+        assert_eq!(e, spans(&[(2, 3)]));
+        assert!(a.contains(11) && !a.contains(5) && !a.contains(-1));
+        assert_eq!(a.count(), 9);
+    }
+
+    /// Every row's spans must be exactly the points `for_each_point` visits.
+    fn assert_spans_match(shape: &ShapeEnum) {
+        assert!(shape.spans_cover_points());
+        let (_, y0, z0, _, y1, z1) = shape.bounds();
+        let mut expected = std::collections::HashSet::new();
+        shape.for_each_point(|x, y, z| {
+            expected.insert((x, y, z));
+        });
+        let mut seen = 0;
+        for y in y0 - 1..=y1 + 1 {
+            for z in z0 - 1..=z1 + 1 {
+                for (a, b) in Spans::of(shape, y, z).iter() {
+                    for x in a..b {
+                        assert!(expected.contains(&(x, y, z)), "extra {x},{y},{z}");
+                        seen += 1;
+                    }
+                }
+            }
+        }
+        assert_eq!(seen, expected.len());
+    }
+
+    #[test]
+    fn analytic_spans_match_point_scans() {
+        let sphere = ShapeEnum::Sphere(Sphere::new((2, -3, 1), 9.5));
+        let shapes = vec![
+            sphere.clone(),
+            ShapeEnum::Sphere(Sphere::new((0, 0, 0), 7.0)),
+            ShapeEnum::Ellipsoid(Ellipsoid::new((1, 2, 3), (6.3, 3.0, 4.7))),
+            ShapeEnum::Cylinder(Cylinder::new((0.5, 0.0, -1.0), (0.0, 1.0, 0.0), 4.2, 9.0)),
+            ShapeEnum::Cylinder(Cylinder::new((-2.0, 1.0, 0.0), (1.0, 0.7, -0.4), 3.1, 11.0)),
+            ShapeEnum::Torus(Torus::new((0.0, 0.0, 0.0), 6.0, 2.5, (0.0, 1.0, 0.0))),
+            ShapeEnum::Torus(Torus::new((0.3, 1.0, 0.0), 5.0, 1.5, (1.0, 1.0, 0.0))),
+            ShapeEnum::PolygonPrism(PolygonPrism::new(
+                vec![(0.0, 0.0), (10.0, 0.0), (10.0, 8.0), (5.0, 3.0), (0.0, 8.0)],
+                -1,
+                2,
+            )),
+            ShapeEnum::Cuboid(Cuboid::new((-3, 0, 2), (4, 2, 5))),
+            ShapeEnum::Hollow(Hollow::new(sphere.clone(), 2)),
+            ShapeEnum::Union(Union::new(
+                sphere.clone(),
+                ShapeEnum::Cuboid(Cuboid::new((5, -3, 1), (14, 0, 3))),
+            )),
+            ShapeEnum::Intersection(Intersection::new(
+                sphere.clone(),
+                ShapeEnum::Ellipsoid(Ellipsoid::new((6, -3, 1), (8.0, 4.0, 8.0))),
+            )),
+            ShapeEnum::Difference(Difference::new(
+                sphere,
+                ShapeEnum::Cylinder(Cylinder::new((2.0, -15.0, 1.0), (0.0, 1.0, 0.0), 3.0, 30.0)),
+            )),
+        ];
+        for shape in &shapes {
+            assert_spans_match(shape);
+        }
+    }
+}
@@ -1,3 +1,4 @@
+use super::spans::settle;
 use super::Shape;
 
 #[derive(Clone)]
@@ -70,4 +71,25 @@ impl Shape for Sphere {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let (min_x, min_y, min_z, max_x, max_y, max_z) = self.bounds();
+        if y < min_y || y > max_y || z < min_z || z > max_z {
+            return;
+        }
+        let dy = y - self.center.1;
+        let dz = z - self.center.2;
+        let w = (self.radius * self.radius - (dy * dy + dz * dz) as f64).sqrt();
+        let cx = self.center.0 as f64;
+        if let Some((x0, x1)) = settle(cx - w, cx + w, (min_x, max_x), |x| self.contains(x, y, z)) {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        true
+    }
 }
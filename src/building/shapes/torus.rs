@@ -1,4 +1,5 @@
-use super::{ParametricShape, Shape};
+use super::spans::{scan, settle};
+use super::{ParametricShape, Shape, Spans};
 
 #[derive(Clone)]
 pub struct Torus {
@@ -126,6 +127,54 @@ impl Shape for Torus {
             }
         }
     }
+
+    fn for_each_span<F>(&self, y: i32, z: i32, mut f: F)
+    where
+        F: FnMut(i32, i32),
+    {
+        let ax = self.normalized_axis();
+        if ax.0 != 0.0 {
+            // The height varies along the row; the run ends are roots of a
+            // quartic, so test each voxel instead.
+            return scan(self, y, z, f);
+        }
+        let (min_x, min_y, min_z, max_x, max_y, max_z) = self.bounds();
+        if y < min_y || y > max_y || z < min_z || z > max_z {
+            return;
+        }
+        // With the axis across the row the height is fixed, and the row
+        // meets the tube where the planar distance lies within √(r² - h²)
+        // of the major radius: one run, or two either side of the hole.
+        let dy = y as f64 - self.center.1;
+        let dz = z as f64 - self.center.2;
+        let h = dy * ax.1 + dz * ax.2;
+        let (py, pz) = (dy - h * ax.1, dz - h * ax.2);
+        let q = py * py + pz * pz;
+        let s = (self.minor_radius * self.minor_radius - h * h).sqrt();
+        let outer = self.major_radius + s;
+        let inner = self.major_radius - s;
+        let wo = (outer * outer - q).max(0.0).sqrt();
+        let cx = self.center.0;
+        let contains = |x| self.contains(x, y, z);
+        if inner > 0.0 && inner * inner > q {
+            let wi = (inner * inner - q).sqrt();
+            let mut runs = Spans::new();
+            for (lo, hi) in [(cx - wo, cx - wi), (cx + wi, cx + wo)] {
+                if let Some((x0, x1)) = settle(lo, hi, (min_x, max_x), contains) {
+                    runs.push(x0, x1);
+                }
+            }
+            for (x0, x1) in runs.iter() {
+                f(x0, x1);
+            }
+        } else if let Some((x0, x1)) = settle(cx - wo, cx + wo, (min_x, max_x), contains) {
+            f(x0, x1);
+        }
+    }
+
+    fn spans_cover_points(&self) -> bool {
+        true
+    }
 }
 
 impl ParametricShape for Torus {
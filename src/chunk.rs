@@ -1,4 +1,5 @@
 use crate::block_position::BlockPosition;
+use std::ops::Range;
 
 pub struct Chunk {
     pub chunk_x: i32,
@@ -6,3 +7,82 @@ pub struct Chunk {
     pub chunk_z: i32,
     pub positions: Vec<BlockPosition>,
 }
+
+/// Blocks grouped by chunk in one flat buffer: every chunk is a borrowed,
+/// contiguous slice of it, instead of a vector of its own. Chunks are
+/// ordered by chunk coordinate.
+#[derive(Debug, Clone)]
+pub struct ChunkedBlocks<T> {
+    items: Vec<T>,
+    chunks: Vec<((i32, i32, i32), Range<usize>)>,
+}
+
+impl<T: Copy> ChunkedBlocks<T> {
+    /// Group `items` from runs of `(chunk, range into items)`. Runs of the
+    /// same chunk (from different regions) are joined in run order.
+    pub(crate) fn from_runs(items: Vec<T>, mut runs: Vec<((i32, i32, i32), Range<usize>)>) -> Self {
+        runs.sort_by_key(|(chunk, _)| *chunk);
+        if runs.windows(2).all(|pair| pair[0].0 != pair[1].0) {
+            return ChunkedBlocks {
+                items,
+                chunks: runs,
+            };
+        }
+        let mut joined = Vec::with_capacity(items.len());
+        let mut chunks: Vec<((i32, i32, i32), Range<usize>)> = Vec::new();
+        for (chunk, range) in runs {
+            let start = joined.len();
+            joined.extend_from_slice(&items[range]);
+            match chunks.last_mut() {
+                Some((last, range)) if *last == chunk => range.end = joined.len(),
+                _ => chunks.push((chunk, start..joined.len())),
+            }
+        }
+        ChunkedBlocks {
+            items: joined,
+            chunks,
+        }
+    }
+}
+
+impl<T> ChunkedBlocks<T> {
+    /// Number of chunks.
+    pub fn len(&self) -> usize {
+        self.chunks.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.chunks.is_empty()
+    }
+
+    /// Total number of blocks across all chunks.
+    pub fn block_count(&self) -> usize {
+        self.chunks.iter().map(|(_, range)| range.len()).sum()
+    }
+
+    /// `(chunk coordinate, blocks)` for each chunk.
+    pub fn iter(&self) -> impl Iterator<Item = ((i32, i32, i32), &[T])> + '_ {
+        self.chunks
+            .iter()
+            .map(|(chunk, range)| (*chunk, &self.items[range.clone()]))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn runs_of_one_chunk_are_joined_in_order() {
+        let chunked = ChunkedBlocks::from_runs(
+            vec![1, 2, 3, 4, 5],
+            vec![((1, 0, 0), 0..2), ((0, 0, 0), 2..3), ((1, 0, 0), 3..5)],
+        );
+        let chunks: Vec<_> = chunked.iter().collect();
+        assert_eq!(
+            chunks,
+            vec![((0, 0, 0), &[3][..]), ((1, 0, 0), &[1, 2, 4, 5][..])]
+        );
+        assert_eq!(chunked.block_count(), 5);
+    }
+}
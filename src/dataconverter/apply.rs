@@ -5,10 +5,13 @@
 //! lives here now; block-entity and entity conversion (which need id-key and
 //! entity-enum bridging) land alongside the load/save wiring.
 
+use rustc_hash::FxHashMap;
 use smol_str::SmolStr;
 use std::collections::HashMap;
+use std::sync::{OnceLock, RwLock};
 
 use crate::block_entity::BlockEntity;
+use crate::block_state_registry::StateId;
 use crate::entity::{Entity, NbtValue as EntityNbtValue};
 use crate::nbt::{NbtMap, NbtValue};
 use crate::{BlockState, Region, UniversalSchematic};
@@ -20,10 +23,43 @@ use super::registry::{
 };
 use super::types::{MapExt, ValueExt};
 
+/// Forward block-state conversions already worked out, keyed by the interned
+/// input state and the version pair. The BLOCK_STATE chain is a pure function
+/// of those three, so every palette entry of every chunk, region and thread
+/// after the first is one lookup. (Reverse conversion records losses as it
+/// goes and is not cached.)
+type BlockStateCache = RwLock<FxHashMap<(StateId, i32, i32), BlockState>>;
+
+fn block_state_cache() -> &'static BlockStateCache {
+    static CACHE: OnceLock<BlockStateCache> = OnceLock::new();
+    CACHE.get_or_init(Default::default)
+}
+
 /// Convert one palette [`BlockState`] in place through the BLOCK_STATE converter
 /// chain (block renames + per-block property fixers). Round-trips the struct
-/// through the `{Name, Properties}` NBT shape the engine expects.
+/// through the `{Name, Properties}` NBT shape the engine expects the first
+/// time a `(state, from, to)` is seen; repeats come from a process-wide cache.
 pub fn convert_block_state_struct(bs: &mut BlockState, from: i32, to: i32) {
+    let key = (StateId::of(bs), from, to);
+    // A poisoned lock only means a converter panicked mid-call; entries are
+    // inserted whole, so the map stays usable.
+    let cached = block_state_cache()
+        .read()
+        .unwrap_or_else(|e| e.into_inner())
+        .get(&key)
+        .cloned();
+    if let Some(converted) = cached {
+        *bs = converted;
+        return;
+    }
+    convert_block_state_uncached(bs, from, to);
+    block_state_cache()
+        .write()
+        .unwrap_or_else(|e| e.into_inner())
+        .insert(key, bs.clone());
+}
+
+fn convert_block_state_uncached(bs: &mut BlockState, from: i32, to: i32) {
     let mut map = NbtMap::new();
     map.set_string("Name", bs.get_name());
     if !bs.properties.is_empty() {
@@ -42,10 +78,7 @@ pub fn convert_block_state_struct(bs: &mut BlockState, from: i32, to: i32) {
     let mut entries: Vec<(SmolStr, SmolStr)> = match map.get_map("Properties") {
         Some(props) => props
             .iter()
-            .filter_map(|(k, v)| {
-                v.as_str()
-                    .map(|s| (SmolStr::from(k.as_str()), SmolStr::from(s)))
-            })
+            .filter_map(|(k, v)| v.as_str().map(|s| (k.clone(), SmolStr::from(s))))
             .collect(),
         None => Vec::new(),
     };
@@ -129,7 +162,7 @@ fn entity_map_to_nbt(map: &HashMap<String, EntityNbtValue>) -> NbtMap {
 fn nbt_map_to_entity(map: &NbtMap) -> HashMap<String, EntityNbtValue> {
     let mut out = HashMap::new();
     for (key, value) in map.iter() {
-        out.insert(key.clone(), nbt_value_to_entity(value));
+        out.insert(key.to_string(), nbt_value_to_entity(value));
     }
     out
 }
@@ -148,21 +181,26 @@ pub fn convert_entity_struct(entity: &mut Entity, from: i32, to: i32) {
         entity.id = new_id;
     }
     map.take("id");
-    entity.nbt = nbt_map_to_entity(&map);
+    entity.set_nbt(nbt_map_to_entity(&map));
 }
 
 /// Convert a region's block-state palette and every block entity. (Mobile
 /// entities use their own NBT enum, so bridge them through the converter NBT
 /// shape here.)
+///
+/// Old states that convert to the same new one are merged into a single
+/// palette entry. Block entities are converted once per shared template, in
+/// parallel, not once per position.
 pub fn convert_region(region: &mut Region, from: i32, to: i32) {
     convert_palette(&mut region.palette, from, to);
-
-    let entries = region.block_entities.drain();
-    for (pos, mut be) in entries {
-        convert_block_entity_struct(&mut be, from, to);
-        region.block_entities.insert(pos, be);
+    if !region.dedup_palette() {
+        region.rebuild_palette_index();
     }
 
+    region
+        .block_entities
+        .par_map_templates(|be| convert_block_entity_struct(be, from, to));
+
     for entity in &mut region.entities {
         convert_entity_struct(entity, from, to);
     }
@@ -203,10 +241,7 @@ fn convert_block_state_struct_reverse(bs: &mut BlockState, from: i32, to: i32) {
     let mut entries: Vec<(SmolStr, SmolStr)> = match map.get_map("Properties") {
         Some(props) => props
             .iter()
-            .filter_map(|(k, v)| {
-                v.as_str()
-                    .map(|s| (SmolStr::from(k.as_str()), SmolStr::from(s)))
-            })
+            .filter_map(|(k, v)| v.as_str().map(|s| (k.clone(), SmolStr::from(s))))
             .collect(),
         None => Vec::new(),
     };
@@ -248,7 +283,7 @@ fn convert_entity_struct_reverse(entity: &mut Entity, from: i32, to: i32) {
         entity.id = new_id;
     }
     map.take("id");
-    entity.nbt = nbt_map_to_entity(&map);
+    entity.set_nbt(nbt_map_to_entity(&map));
 }
 
 /// Reverse-convert a region's palette + block entities, seeding a human path for
@@ -258,6 +293,7 @@ fn convert_region_reverse(region: &mut Region, from: i32, to: i32) {
         let _scope = loss::path_scope(format!("palette[{i}] {}", bs.get_name()));
         convert_block_state_struct_reverse(bs, from, to);
     }
+    region.rebuild_palette_index();
 
     let entries = region.block_entities.drain();
     for (pos, mut be) in entries {
@@ -302,13 +338,15 @@ pub fn convert_schematic_reverse(
 mod tests {
     use super::*;
     use crate::nbt::NbtValue;
+    use std::sync::Arc;
 
     #[test]
     fn convert_entity_struct_forward_and_reverse_round_trip() {
         // V107 splits Minecart + Type=2 -> "MinecartFurnace"; bridge the entity
         // enum across the converter and confirm forward + (schematic) reverse.
         let mut e = Entity::new("Minecart".to_string(), (0.0, 0.0, 0.0));
-        e.nbt.insert("Type".to_string(), EntityNbtValue::Int(2));
+        e.nbt_mut()
+            .insert("Type".to_string(), EntityNbtValue::Int(2));
 
         convert_entity_struct(&mut e, 106, 107);
         assert_eq!(e.id, "MinecartFurnace");
@@ -358,6 +396,66 @@ mod tests {
         assert_eq!(palette[1].get_name(), "minecraft:dirt_path");
     }
 
+    #[test]
+    fn cached_block_state_conversion_matches_the_converter_chain() {
+        let input = BlockState::new("minecraft:grass_path").with_property("snowy", "true");
+        let mut uncached = input.clone();
+        convert_block_state_uncached(&mut uncached, 1489, 2680);
+        for _ in 0..2 {
+            let mut bs = input.clone();
+            convert_block_state_struct(&mut bs, 1489, 2680);
+            assert_eq!(bs, uncached);
+        }
+        // The version pair is part of the key.
+        let mut early = input.clone();
+        convert_block_state_struct(&mut early, 1489, 1490);
+        assert_eq!(early.get_name(), "minecraft:grass_path");
+    }
+
+    #[test]
+    fn convert_region_merges_converged_states_and_shares_templates() {
+        let mut region = Region::new("r".to_string(), (0, 0, 0), (4, 2, 1));
+        region.set_block(0, 0, 0, &BlockState::new("minecraft:melon_block"));
+        region.set_block(1, 0, 0, &BlockState::new("minecraft:melon"));
+        region.set_block(2, 0, 0, &BlockState::new("minecraft:stone"));
+        convert_region(&mut region, 1489, 1490);
+
+        let names: Vec<_> = region.palette.iter().map(|b| b.get_name()).collect();
+        assert_eq!(
+            names,
+            ["minecraft:air", "minecraft:melon", "minecraft:stone"]
+        );
+        let melon = BlockState::new("minecraft:melon");
+        assert_eq!(region.get_block(0, 0, 0), Some(&melon));
+        assert_eq!(region.get_block(1, 0, 0), Some(&melon));
+        assert_eq!(
+            region.get_block(2, 0, 0).unwrap().get_name(),
+            "minecraft:stone"
+        );
+        assert_eq!(region.count_non_air_blocks(), 3);
+
+        let mut region = Region::new("r".to_string(), (0, 0, 0), (4, 2, 1));
+        let chest = Arc::new(BlockEntity::new("Chest".to_string(), (0, 1, 0)));
+        region
+            .block_entities
+            .insert_template(&[(0, 1, 0), (2, 1, 0)], chest);
+        region.block_entities.insert(
+            (3, 1, 0),
+            BlockEntity::new("Furnace".to_string(), (3, 1, 0)),
+        );
+        convert_region(&mut region, 703, 704);
+
+        let a = region.block_entities.get(&(0, 1, 0)).unwrap();
+        let b = region.block_entities.get(&(2, 1, 0)).unwrap();
+        assert_eq!(a.id, "minecraft:chest");
+        assert!(std::ptr::eq(a, b), "shared template stays shared");
+        assert_eq!(
+            region.block_entities.get(&(3, 1, 0)).unwrap().id,
+            "minecraft:furnace"
+        );
+        assert_eq!(region.block_entities.len(), 3);
+    }
+
     #[test]
     fn convert_block_state_preserves_properties() {
         let mut bs = BlockState::new("minecraft:melon_block").with_property("foo", "bar");
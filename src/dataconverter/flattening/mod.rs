@@ -94,6 +94,9 @@ fn canon_key_from_map(m: &NbtMap) -> Option<String> {
     Some(canon_key(name?, &props))
 }
 
+/// Tables the forward (old -> new) direction reads. Split from
+/// [`ReverseTables`] so loading an old schematic only builds these, and a
+/// save to an older version only builds the reverse ones.
 struct Tables {
     /// `FLATTENED_BY_ID` after BLOCK_DEFAULTS fill + `finalizeMaps` (length 4096).
     flattened_by_id: Vec<Option<FlatState>>,
@@ -101,8 +104,10 @@ struct Tables {
     id_by_old_nbt: HashMap<String, u16>,
     /// `ID_BY_OLD_NAME`: pre-flattening name -> lowest id (putIfAbsent).
     id_by_old_name: HashMap<&'static str, u16>,
+}
 
-    // --- reverse (un-flattening) tables, built from the same registrations ---
+/// Reverse (un-flattening) tables, built from the same registrations.
+struct ReverseTables {
     /// Exact flattened `{Name, Properties}` (canonical key) -> that
     /// registration's pre-flattening states. First registration wins on
     /// collision; the best-matching pre is chosen at reverse time.
@@ -129,16 +134,6 @@ static TABLES: LazyLock<Tables> = LazyLock::new(|| {
     let mut id_by_old_nbt: HashMap<String, u16> = HashMap::new();
     let mut id_by_old_name: HashMap<&'static str, u16> = HashMap::new();
 
-    let mut pre_by_flat: HashMap<String, &'static [FlatState]> = HashMap::new();
-    let mut variants_by_flat_name: HashMap<
-        &'static str,
-        Vec<(
-            &'static [(&'static str, &'static str)],
-            &'static [FlatState],
-        )>,
-    > = HashMap::new();
-    let mut old_name_by_new: HashMap<&'static str, &'static str> = HashMap::new();
-
     // Registrations are in ascending-id source order, so the first state seen for
     // a block is its default and the lowest id wins for a name (putIfAbsent).
     for r in data::REGISTRATIONS {
@@ -151,9 +146,36 @@ static TABLES: LazyLock<Tables> = LazyLock::new(|| {
             id_by_old_name.entry(pre.name).or_insert(r.id);
             id_by_old_nbt.insert(canon_key(pre.name, pre.props), r.id);
         }
+    }
+
+    // finalizeMaps: every empty slot falls back to its block default.
+    for i in 0..4096 {
+        if flattened_by_id[i].is_none() {
+            flattened_by_id[i] = block_defaults[i >> 4];
+        }
+    }
+
+    Tables {
+        flattened_by_id,
+        id_by_old_nbt,
+        id_by_old_name,
+    }
+});
+
+static REVERSE_TABLES: LazyLock<ReverseTables> = LazyLock::new(|| {
+    let mut pre_by_flat: HashMap<String, &'static [FlatState]> = HashMap::new();
+    let mut variants_by_flat_name: HashMap<
+        &'static str,
+        Vec<(
+            &'static [(&'static str, &'static str)],
+            &'static [FlatState],
+        )>,
+    > = HashMap::new();
+    let mut old_name_by_new: HashMap<&'static str, &'static str> = HashMap::new();
 
-        // Reverse: keep this registration's full preimage list so the closest
-        // pre to a given modern state can be chosen at reverse time.
+    for r in data::REGISTRATIONS {
+        // Keep this registration's full preimage list so the closest pre to a
+        // given modern state can be chosen at reverse time.
         if let Some(first) = r.pres.first() {
             pre_by_flat
                 .entry(canon_key(r.flat.name, r.flat.props))
@@ -166,23 +188,13 @@ static TABLES: LazyLock<Tables> = LazyLock::new(|| {
         }
     }
 
-    // finalizeMaps: every empty slot falls back to its block default.
-    for i in 0..4096 {
-        if flattened_by_id[i].is_none() {
-            flattened_by_id[i] = block_defaults[i >> 4];
-        }
-    }
-
     // Match the most specific variant first (most flat-props), so a stairs state
     // resolves to the registration that pins facing+half rather than a barer one.
     for variants in variants_by_flat_name.values_mut() {
         variants.sort_by(|a, b| b.0.len().cmp(&a.0.len()));
     }
 
-    Tables {
-        flattened_by_id,
-        id_by_old_nbt,
-        id_by_old_name,
+    ReverseTables {
         pre_by_flat,
         variants_by_flat_name,
         old_name_by_new,
@@ -273,7 +285,7 @@ pub fn unflatten_nbt(modern: &NbtMap) -> Unflatten {
     };
 
     if let Some(key) = canon_key_from_map(modern) {
-        if let Some(pres) = TABLES.pre_by_flat.get(&key) {
+        if let Some(pres) = REVERSE_TABLES.pre_by_flat.get(&key) {
             return Unflatten::Exact(best_pre(pres, &modern_props).to_nbt());
         }
     }
@@ -283,7 +295,7 @@ pub fn unflatten_nbt(modern: &NbtMap) -> Unflatten {
         None => return Unflatten::Unknown,
     };
 
-    if let Some(variants) = TABLES.variants_by_flat_name.get(name) {
+    if let Some(variants) = REVERSE_TABLES.variants_by_flat_name.get(name) {
         // `variants` is sorted most-specific-first, so the first subset match is
         // the registration that pins the most properties.
         for (flat_props, pres) in variants {
@@ -328,7 +340,7 @@ fn best_pre(pres: &'static [FlatState], modern_props: &[(&str, &str)]) -> &'stat
 /// Inverse of [`get_new_block_name`]: modern block name -> canonical pre-1.13
 /// name (returns the input unchanged when there is no known older name).
 pub fn get_old_block_name(new: &str) -> String {
-    TABLES
+    REVERSE_TABLES
         .old_name_by_new
         .get(new)
         .map(|s| s.to_string())
@@ -4,7 +4,7 @@
 //! `converters/itemname/`, `converters/entity/`.
 
 use std::collections::HashMap;
-use std::sync::Arc;
+use std::sync::{Arc, OnceLock};
 
 use crate::nbt::{NbtMap, NbtValue};
 
@@ -41,7 +41,7 @@ impl RenameSpec {
     /// The forward (old -> new) renamer.
     pub fn forward(&self) -> Renamer {
         match self {
-            RenameSpec::Pairs(pairs) => map_table_renamer(pairs.iter().map(|(o, n)| (*o, *n))),
+            RenameSpec::Pairs(pairs) => map_table_renamer(pairs, false),
             RenameSpec::Custom { forward, .. } => forward.clone(),
         }
     }
@@ -49,7 +49,7 @@ impl RenameSpec {
     /// The reverse (new -> old) renamer.
     pub fn reverse(&self) -> Renamer {
         match self {
-            RenameSpec::Pairs(pairs) => map_table_renamer(pairs.iter().map(|(o, n)| (*n, *o))),
+            RenameSpec::Pairs(pairs) => map_table_renamer(pairs, true),
             RenameSpec::Custom { reverse, .. } => reverse.clone(),
         }
     }
@@ -67,13 +67,24 @@ impl From<Renamer> for RenameSpec {
     }
 }
 
-/// Build a renamer from `(from, to)` pairs, first-wins on duplicate `from` keys.
-fn map_table_renamer(pairs: impl Iterator<Item = (&'static str, &'static str)>) -> Renamer {
-    let mut map: HashMap<&'static str, &'static str> = HashMap::new();
-    for (from, to) in pairs {
-        map.entry(from).or_insert(to);
-    }
-    Arc::new(move |id: &str| map.get(id).map(|s| s.to_string()))
+/// Build a renamer from `(from, to)` pairs (`(to, from)` when `inverse`),
+/// first-wins on duplicate keys. The lookup table is built on the first
+/// rename, not at registration: building the registry then only boxes
+/// closures, and a conversion that never reaches a version never pays for
+/// its tables.
+fn map_table_renamer(pairs: &'static [(&'static str, &'static str)], inverse: bool) -> Renamer {
+    let map: OnceLock<HashMap<&'static str, &'static str>> = OnceLock::new();
+    Arc::new(move |id: &str| {
+        let map = map.get_or_init(|| {
+            let mut map = HashMap::with_capacity(pairs.len());
+            for &(old, new) in pairs {
+                let (from, to) = if inverse { (new, old) } else { (old, new) };
+                map.entry(from).or_insert(to);
+            }
+            map
+        });
+        map.get(id).map(|s| s.to_string())
+    })
 }
 
 /// Build a rename spec from a static `(old, new)` table. The reverse engine
@@ -176,41 +187,47 @@ pub fn register_entity_rename(
     version: i32,
     spec: impl Into<RenameSpec>,
 ) {
+    // Resolve each direction once so every site shares one lookup table.
     let spec = spec.into();
+    let (forward, reverse) = (spec.forward(), spec.reverse());
     reg.entity
-        .add_structure_converter(version, 0, id_field_rename_converter(spec.forward()));
+        .add_structure_converter(version, 0, id_field_rename_converter(forward.clone()));
     reg.entity
-        .add_reverse_converter(version, 0, id_field_rename_converter(spec.reverse()));
-    register_value_rename(&mut reg.entity_name, version, 0, spec);
+        .add_reverse_converter(version, 0, id_field_rename_converter(reverse.clone()));
+    register_value_rename(
+        &mut reg.entity_name,
+        version,
+        0,
+        RenameSpec::custom(forward, reverse),
+    );
 }
 
 /// `ConverterAbstractBlockRename.register` — rename BLOCK_NAME, the BLOCK_STATE
 /// `Name` field, and the FLAT_BLOCK_STATE string prefix, plus the inverses.
 pub fn register_block_rename(reg: &mut RegistryBuilder, version: i32, spec: impl Into<RenameSpec>) {
+    // Resolve each direction once so every site shares one lookup table.
     let spec = spec.into();
+    let (forward, reverse) = (spec.forward(), spec.reverse());
 
     register_value_rename(
         &mut reg.block_name,
         version,
         0,
-        RenameSpec::custom(spec.forward(), spec.reverse()),
+        RenameSpec::custom(forward.clone(), reverse.clone()),
     );
 
     reg.block_state.add_structure_converter(
         version,
         0,
-        name_field_rename_converter(spec.forward()),
+        name_field_rename_converter(forward.clone()),
     );
     reg.block_state
-        .add_reverse_converter(version, 0, name_field_rename_converter(spec.reverse()));
+        .add_reverse_converter(version, 0, name_field_rename_converter(reverse.clone()));
 
     reg.flat_block_state
-        .add_converter(version, 0, flat_state_rename_converter(spec.forward()));
-    reg.flat_block_state.add_reverse_converter(
-        version,
-        0,
-        flat_state_rename_converter(spec.reverse()),
-    );
+        .add_converter(version, 0, flat_state_rename_converter(forward));
+    reg.flat_block_state
+        .add_reverse_converter(version, 0, flat_state_rename_converter(reverse));
 }
 
 // --- namespace enforcement (hooks/DataHook*EnforceNamespaced) ---------------
@@ -74,6 +74,18 @@ mod tests {
         assert_eq!(calls, vec![(7, 7)]);
     }
 
+    #[test]
+    fn table_renamers_resolve_first_wins_in_both_directions() {
+        const PAIRS: &[(&str, &str)] = &[("a", "x"), ("a", "y"), ("b", "x")];
+        let spec = helpers::map_renamer(PAIRS);
+        let (forward, reverse) = (spec.forward(), spec.reverse());
+        assert_eq!(forward("a").as_deref(), Some("x"));
+        assert_eq!(forward("b").as_deref(), Some("x"));
+        assert_eq!(forward("c"), None);
+        assert_eq!(reverse("x").as_deref(), Some("a"));
+        assert_eq!(reverse("y").as_deref(), Some("a"));
+    }
+
     #[test]
     fn forward_item_rename() {
         let mut item = NbtMap::new();
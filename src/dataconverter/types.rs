@@ -124,13 +124,13 @@ impl MapExt for NbtMap {
         self.get(key).is_some()
     }
     fn is_empty(&self) -> bool {
-        self.iter().next().is_none()
+        NbtMap::is_empty(self)
     }
     fn len(&self) -> usize {
-        self.iter().count()
+        NbtMap::len(self)
     }
     fn keys(&self) -> Vec<String> {
-        self.iter().map(|(k, _)| k.clone()).collect()
+        self.iter().map(|(k, _)| k.to_string()).collect()
     }
     fn get_string(&self, key: &str) -> Option<&str> {
         self.get(key).and_then(ValueExt::as_str)
@@ -165,37 +165,37 @@ impl MapExt for NbtMap {
     }
 
     fn set_string(&mut self, key: &str, v: impl Into<String>) {
-        self.insert(key.to_string(), NbtValue::String(v.into()));
+        self.insert(key, NbtValue::String(v.into()));
     }
     fn set_byte(&mut self, key: &str, v: i8) {
-        self.insert(key.to_string(), NbtValue::Byte(v));
+        self.insert(key, NbtValue::Byte(v));
     }
     fn set_short(&mut self, key: &str, v: i16) {
-        self.insert(key.to_string(), NbtValue::Short(v));
+        self.insert(key, NbtValue::Short(v));
     }
     fn set_i32(&mut self, key: &str, v: i32) {
-        self.insert(key.to_string(), NbtValue::Int(v));
+        self.insert(key, NbtValue::Int(v));
     }
     fn set_i64(&mut self, key: &str, v: i64) {
-        self.insert(key.to_string(), NbtValue::Long(v));
+        self.insert(key, NbtValue::Long(v));
     }
     fn set_f32(&mut self, key: &str, v: f32) {
-        self.insert(key.to_string(), NbtValue::Float(v));
+        self.insert(key, NbtValue::Float(v));
     }
     fn set_f64(&mut self, key: &str, v: f64) {
-        self.insert(key.to_string(), NbtValue::Double(v));
+        self.insert(key, NbtValue::Double(v));
     }
     fn set_bool(&mut self, key: &str, v: bool) {
-        self.insert(key.to_string(), NbtValue::Byte(if v { 1 } else { 0 }));
+        self.insert(key, NbtValue::Byte(if v { 1 } else { 0 }));
     }
     fn set_map(&mut self, key: &str, v: NbtMap) {
-        self.insert(key.to_string(), NbtValue::Compound(v));
+        self.insert(key, NbtValue::Compound(v));
     }
     fn set_list(&mut self, key: &str, v: Vec<NbtValue>) {
-        self.insert(key.to_string(), NbtValue::List(v));
+        self.insert(key, NbtValue::List(v));
     }
     fn set_generic(&mut self, key: &str, v: NbtValue) {
-        self.insert(key.to_string(), v);
+        self.insert(key, v);
     }
     fn take(&mut self, key: &str) -> Option<NbtValue> {
         self.remove(key)
@@ -205,7 +205,7 @@ impl MapExt for NbtMap {
             return;
         }
         if let Some(v) = self.remove(from) {
-            self.insert(to.to_string(), v);
+            self.insert(to, v);
         }
     }
 }
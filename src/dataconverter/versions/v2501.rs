@@ -95,7 +95,7 @@ fn recipes_used_reverse_converter() -> Converter {
                 crate::nbt::NbtValue::Long(v) => *v as i32,
                 _ => 0,
             };
-            data.set_string(&format!("RecipeLocation{}", i), location);
+            data.set_string(&format!("RecipeLocation{}", i), location.as_str());
             data.set_i32(&format!("RecipeAmount{}", i), recipe_amount);
             i += 1;
         }
@@ -94,7 +94,7 @@ fn convert_profile(input: Option<NbtValue>) -> NbtMap {
                 ret.set_generic("id", id.clone());
             }
             if let Some(properties) = input.get_map("Properties") {
-                if !properties.inner().is_empty() {
+                if !properties.is_empty() {
                     ret.set_list("properties", convert_properties(properties));
                 }
             }
@@ -220,7 +220,7 @@ pub fn register(reg: &mut RegistryBuilder) {
                     "removed ominous banner hide_additional_tooltip while restoring legacy CustomName",
                 );
             }
-            if components.inner().is_empty() {
+            if components.is_empty() {
                 data.take("components");
             }
 
@@ -275,7 +275,7 @@ pub fn register(reg: &mut RegistryBuilder) {
                     normal_config.set_generic(key, value);
                 }
             }
-            if !normal_config.inner().is_empty() {
+            if !normal_config.is_empty() {
                 data.set_map("normal_config", normal_config);
             }
         }),
@@ -125,7 +125,7 @@ fn reverse_convert_lock(root: &mut NbtMap, src_path: &str, dst_path: &str) {
         return;
     };
 
-    if lock_map.inner().len() != 1 || components.inner().len() != 1 {
+    if lock_map.len() != 1 || components.len() != 1 {
         report_loss(
             VERSION,
             LossKind::ComponentDropped,
@@ -72,7 +72,7 @@ pub fn register(reg: &mut RegistryBuilder) {
                 .and_then(|v| v.as_f64());
             if let Some(model_data) = model_data {
                 let float_count = model_data.get_list("floats").map(|f| f.len()).unwrap_or(0);
-                if float_count != 1 || model_data.inner().len() != 1 {
+                if float_count != 1 || model_data.len() != 1 {
                     report_loss(
                         VERSION,
                         LossKind::ComponentDropped,
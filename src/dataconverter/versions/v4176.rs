@@ -21,9 +21,9 @@ const VERSION: i32 = 4176;
 /// exactly `minecraft:custom_name == "\"\""`.
 fn fix_invalid_lock(root: &mut NbtMap, path: &str) {
     let should_remove = match root.get_map(path) {
-        Some(lock) if lock.inner().len() == 1 => match lock.get_map("components") {
+        Some(lock) if lock.len() == 1 => match lock.get_map("components") {
             Some(components) => {
-                components.inner().len() == 1
+                components.len() == 1
                     && components.get_string("minecraft:custom_name") == Some("\"\"")
             }
             None => false,
@@ -220,7 +220,7 @@ pub fn register(reg: &mut RegistryBuilder) {
                         let variant = entity_data.take("variant");
                         // After removing `variant`, if only `id` remains the whole
                         // entity_data component is dropped (Java: size() == 1).
-                        let remove = entity_data.inner().len() == 1;
+                        let remove = entity_data.len() == 1;
                         (variant, remove)
                     };
 
@@ -109,7 +109,7 @@ pub fn register(reg: &mut RegistryBuilder) {
             data.take("body_armor_item");
             data.take("saddle");
 
-            if !equipment.inner().is_empty() {
+            if !equipment.is_empty() {
                 data.set_map("equipment", equipment);
             }
         }),
@@ -1,8 +1,12 @@
 use crate::bounding_box::BoundingBox;
+use crate::box_index::BoxIndex;
+use crate::memory;
 use crate::BlockState;
 use crate::UniversalSchematic;
 use serde::{Deserialize, Serialize};
+use std::borrow::Cow;
 use std::collections::{HashMap, HashSet, VecDeque};
+use std::sync::OnceLock;
 
 /// A DefinitionRegion represents a logical region defined by multiple bounding boxes.
 /// It is used for defining inputs, outputs, and other logical constructs that may be disjoint.
@@ -10,6 +14,13 @@ use std::collections::{HashMap, HashSet, VecDeque};
 pub struct DefinitionRegion {
     pub boxes: Vec<BoundingBox>,
     pub metadata: HashMap<String, String>,
+    /// Whether point and box queries go through `index`; see
+    /// [`DefinitionRegion::build_index`].
+    #[serde(skip)]
+    indexed: bool,
+    /// Built on the first query after a change, when `indexed`.
+    #[serde(skip)]
+    index: OnceLock<BoxIndex>,
 }
 
 impl Default for DefinitionRegion {
@@ -24,9 +35,22 @@ impl DefinitionRegion {
         DefinitionRegion {
             boxes: Vec::new(),
             metadata: HashMap::new(),
+            indexed: false,
+            index: OnceLock::new(),
         }
     }
 
+    /// Heap bytes held by the boxes and metadata.
+    pub fn heap_bytes(&self) -> usize {
+        memory::vec_bytes(&self.boxes)
+            + memory::table_bytes(&self.metadata)
+            + self
+                .metadata
+                .iter()
+                .map(|(k, v)| k.len() + v.len())
+                .sum::<usize>()
+    }
+
     /// Create a DefinitionRegion from a single bounding box
     pub fn from_bounds(min: (i32, i32, i32), max: (i32, i32, i32)) -> Self {
         let mut region = Self::new();
@@ -41,6 +65,7 @@ impl DefinitionRegion {
         let true_max = (min.0.max(max.0), min.1.max(max.1), min.2.max(max.2));
 
         self.boxes.push(BoundingBox::new(true_min, true_max));
+        self.index.take();
         self
     }
 
@@ -53,6 +78,7 @@ impl DefinitionRegion {
     pub fn merge(&mut self, other: &DefinitionRegion) -> &mut Self {
         self.boxes.extend(other.boxes.clone());
         self.metadata.extend(other.metadata.clone());
+        self.index.take();
         self
     }
 
@@ -74,15 +100,7 @@ impl DefinitionRegion {
     /// **Warning:** This iteration order is NOT globally sorted across boxes.
     /// For deterministic bit ordering in circuits, use `iter_positions_sorted()` instead.
     pub fn iter_positions(&self) -> impl Iterator<Item = (i32, i32, i32)> + '_ {
-        self.boxes.iter().flat_map(|bbox| {
-            let (min_x, min_y, min_z) = bbox.min;
-            let (max_x, max_y, max_z) = bbox.max;
-
-            // Standard redstone order: Y-axis first (layers), then X (rows), then Z (columns)
-            (min_y..=max_y).flat_map(move |y| {
-                (min_x..=max_x).flat_map(move |x| (min_z..=max_z).map(move |z| (x, y, z)))
-            })
-        })
+        self.boxes.iter().flat_map(box_positions)
     }
 
     /// Iterate over all positions in the region in a globally sorted order.
@@ -112,80 +130,30 @@ impl DefinitionRegion {
 
     /// Reconstruct the region from a set of points, merging adjacent points into larger bounding boxes.
     /// This effectively simplifies the region representation.
+    ///
+    /// The points are sorted by (y, z, x) and swept once: X runs merge into
+    /// rectangles across rows and rectangles into boxes across layers, so
+    /// the result is deterministic, disjoint, and built in O(n log n).
     pub fn from_positions(positions: &[(i32, i32, i32)]) -> Self {
-        if positions.is_empty() {
-            return Self::new();
-        }
-
-        let mut point_set: HashSet<(i32, i32, i32)> = positions.iter().cloned().collect();
-        let mut boxes = Vec::new();
-
-        // While there are points left to process
-        while !point_set.is_empty() {
-            // Pick a starting point (arbitrary, but consistent iteration order helps deterministic results)
-            let start = *point_set.iter().next().unwrap();
-
-            // Greedily expand in X, then Z, then Y
-            let min = start;
-            let mut max = start;
-
-            // Expand +X
-            while point_set.contains(&(max.0 + 1, min.1, min.2)) {
-                max.0 += 1;
-            }
-
-            // Expand +Z (for the whole X row)
-            let mut can_expand_z = true;
-            while can_expand_z {
-                let next_z = max.2 + 1;
-                // Check if the whole row at next_z exists
-                for x in min.0..=max.0 {
-                    if !point_set.contains(&(x, min.1, next_z)) {
-                        can_expand_z = false;
-                        break;
-                    }
-                }
-                if can_expand_z {
-                    max.2 += 1;
-                }
-            }
-
-            // Expand +Y (for the whole X*Z plane)
-            let mut can_expand_y = true;
-            while can_expand_y {
-                let next_y = max.1 + 1;
-                // Check if the whole plane at next_y exists
-                for x in min.0..=max.0 {
-                    for z in min.2..=max.2 {
-                        if !point_set.contains(&(x, next_y, z)) {
-                            can_expand_y = false;
-                            break;
-                        }
-                    }
-                    if !can_expand_y {
-                        break;
-                    }
-                }
-                if can_expand_y {
-                    max.1 += 1;
-                }
-            }
-
-            // Remove covered points from set
-            for x in min.0..=max.0 {
-                for y in min.1..=max.1 {
-                    for z in min.2..=max.2 {
-                        point_set.remove(&(x, y, z));
-                    }
-                }
-            }
-
-            boxes.push(BoundingBox::new(min, max));
+        let mut sorted = positions.to_vec();
+        sorted.sort_unstable_by_key(|&(x, y, z)| (y, z, x));
+        sorted.dedup();
+
+        let mut merger = RunMerger::default();
+        let mut rest = sorted.as_slice();
+        while let Some(&(x0, y, z)) = rest.first() {
+            let len = rest
+                .iter()
+                .zip(x0..)
+                .take_while(|&(&(px, py, pz), x)| (px, py, pz) == (x, y, z))
+                .count();
+            merger.push(y, z, x0, x0 + len as i32 - 1);
+            rest = &rest[len..];
         }
 
         DefinitionRegion {
-            boxes,
-            metadata: HashMap::new(),
+            boxes: merger.finish(),
+            ..Self::new()
         }
     }
 
@@ -194,6 +162,25 @@ impl DefinitionRegion {
         let positions: Vec<_> = self.iter_positions().collect();
         let simplified = Self::from_positions(&positions);
         self.boxes = simplified.boxes;
+        self.index.take();
+    }
+
+    /// Simplify, then merge boxes until at most `max_boxes` (at least 1)
+    /// remain, for consumers that pay per box (stamping, rendering,
+    /// contiguity checks).
+    ///
+    /// Past the exact simplification this over-approximates: boxes that
+    /// are neighbours in (y, z, x) order are replaced by their bounding
+    /// box, cheapest added volume first, so the region may gain positions
+    /// (never lose any) and the boxes may overlap. O(n log n).
+    pub fn simplify_to(&mut self, max_boxes: usize) -> &mut Self {
+        self.simplify();
+        let max_boxes = max_boxes.max(1);
+        if self.boxes.len() > max_boxes {
+            self.boxes = coarsen(std::mem::take(&mut self.boxes), max_boxes);
+            self.index.take();
+        }
+        self
     }
 
     // ========================================================================
@@ -204,14 +191,20 @@ impl DefinitionRegion {
     ///
     /// Mutates `self` in place. For an immutable version, use `subtracted()`.
     pub fn subtract(&mut self, other: &DefinitionRegion) -> &mut Self {
-        let other_positions: HashSet<_> = other.iter_positions().collect();
-        let remaining: Vec<_> = self
-            .iter_positions()
-            .filter(|pos| !other_positions.contains(pos))
-            .collect();
+        // Only the boxes of `other` that overlap a box are tested against
+        // its points, so the cost follows this region's volume, not both.
+        let cutters = other.index_or_build();
+        let mut remaining = Vec::new();
+        for bbox in &self.boxes {
+            let overlapping = cutters.overlapping(bbox);
+            remaining.extend(
+                box_positions(bbox).filter(|&pos| !overlapping.iter().any(|b| b.contains(pos))),
+            );
+        }
 
         let simplified = Self::from_positions(&remaining);
         self.boxes = simplified.boxes;
+        self.index.take();
         self
     }
 
@@ -219,14 +212,23 @@ impl DefinitionRegion {
     ///
     /// Mutates `self` in place. For an immutable version, use `intersected()`.
     pub fn intersect(&mut self, other: &DefinitionRegion) -> &mut Self {
-        let other_positions: HashSet<_> = other.iter_positions().collect();
-        let intersection: Vec<_> = self
-            .iter_positions()
-            .filter(|pos| other_positions.contains(pos))
-            .collect();
+        // Only the overlaps between boxes are walked, so the cost follows
+        // the size of the result.
+        let others = other.index_or_build();
+        let mut intersection = Vec::new();
+        for bbox in &self.boxes {
+            for common in others
+                .overlapping(bbox)
+                .into_iter()
+                .filter_map(|b| bbox.intersection(b))
+            {
+                intersection.extend(box_positions(&common));
+            }
+        }
 
         let simplified = Self::from_positions(&intersection);
         self.boxes = simplified.boxes;
+        self.index.take();
         self
     }
 
@@ -281,6 +283,7 @@ impl DefinitionRegion {
             bbox.min = (bbox.min.0 + x, bbox.min.1 + y, bbox.min.2 + z);
             bbox.max = (bbox.max.0 + x, bbox.max.1 + y, bbox.max.2 + z);
         }
+        self.index.take();
         self
     }
 
@@ -295,6 +298,7 @@ impl DefinitionRegion {
         self.boxes.retain(|bbox| {
             bbox.min.0 <= bbox.max.0 && bbox.min.1 <= bbox.max.1 && bbox.min.2 <= bbox.max.2
         });
+        self.index.take();
         self
     }
 
@@ -418,7 +422,8 @@ impl DefinitionRegion {
         schematic: &UniversalSchematic,
         block_name: &str,
     ) -> &mut Self {
-        let filtered = self.filter_by_block_immutable(schematic, block_name);
+        let mut filtered = self.filter_by_block_immutable(schematic, block_name);
+        filtered.indexed = self.indexed;
         *self = filtered;
         self
     }
@@ -433,18 +438,7 @@ impl DefinitionRegion {
 
     /// Internal immutable filter helper
     fn filter_by_block_immutable(&self, schematic: &UniversalSchematic, block_name: &str) -> Self {
-        let positions: Vec<_> = self
-            .iter_positions()
-            .filter(|&(x, y, z)| {
-                if let Some(block) = schematic.get_block(x, y, z) {
-                    block.name.contains(block_name)
-                } else {
-                    false
-                }
-            })
-            .collect();
-
-        Self::from_positions(&positions)
+        self.filter_by(schematic, |block| block.name.contains(block_name))
     }
 
     /// Filter positions by block state properties
@@ -454,33 +448,73 @@ impl DefinitionRegion {
         schematic: &UniversalSchematic,
         properties: &HashMap<String, String>,
     ) -> Self {
-        let positions: Vec<_> = self
-            .iter_positions()
-            .filter(|&(x, y, z)| {
-                if let Some(block) = schematic.get_block(x, y, z) {
-                    properties
-                        .iter()
-                        .all(|(key, value)| block.get_property(key).is_some_and(|v| v == value))
-                } else {
-                    false
-                }
-            })
-            .collect();
-
-        Self::from_positions(&positions)
+        self.filter_by(schematic, |block| {
+            properties
+                .iter()
+                .all(|(key, value)| block.get_property(key).is_some_and(|v| v == value))
+        })
     }
 
     /// Filter positions where a custom predicate returns true
+    ///
+    /// Runs box by box: the predicate is evaluated once per palette entry of
+    /// each schematic region, each box's cells are read from the region
+    /// storage (skipping air runs when air fails), and the kept cells are
+    /// merged straight into boxes without collecting positions.
     pub fn filter_by<F>(&self, schematic: &UniversalSchematic, predicate: F) -> Self
     where
         F: Fn(&BlockState) -> bool,
     {
-        let positions: Vec<_> = self
-            .iter_positions()
-            .filter(|&(x, y, z)| schematic.get_block(x, y, z).is_some_and(&predicate))
+        let regions: Vec<_> = std::iter::once(&schematic.default_region)
+            .chain(UniversalSchematic::sorted_named_regions(schematic))
             .collect();
+        let passes: Vec<Vec<bool>> = regions
+            .iter()
+            .map(|region| region.palette.iter().map(&predicate).collect())
+            .collect();
+        let index = self.index_or_build();
 
-        Self::from_positions(&positions)
+        let mut boxes = Vec::new();
+        for (i, bbox) in self.boxes.iter().enumerate() {
+            // Cells an earlier box covers were already filtered there.
+            let mut earlier = Vec::new();
+            index.search(bbox, |j, other| {
+                if j < i {
+                    earlier.push(other);
+                }
+                true
+            });
+            let (dx, dy, dz) = bbox.get_dimensions();
+            let mut kept = vec![0u64; (dx as usize * dy as usize * dz as usize).div_ceil(64)];
+            for (r, region) in regions.iter().enumerate() {
+                let Some(clip) = region.get_bounding_box().intersection(bbox) else {
+                    continue;
+                };
+                let air = region.air_index();
+                let skip = if passes[r].get(air) == Some(&false) {
+                    air
+                } else {
+                    usize::MAX
+                };
+                for ((x, y, z), palette_index) in region.cells_ne_in(&clip, skip) {
+                    // `get_block` resolves a cell in the first region holding it.
+                    if !passes[r][palette_index]
+                        || regions[..r].iter().any(|o| o.is_in_region(x, y, z))
+                        || earlier.iter().any(|o| o.contains((x, y, z)))
+                    {
+                        continue;
+                    }
+                    let cell = bbox.coords_to_index(x, y, z);
+                    kept[cell / 64] |= 1 << (cell % 64);
+                }
+            }
+            boxes_from_cells(bbox, &kept, &mut boxes);
+        }
+
+        DefinitionRegion {
+            boxes,
+            ..Self::new()
+        }
     }
 
     // ========================================================================
@@ -494,7 +528,54 @@ impl DefinitionRegion {
 
     /// Check if the region contains a specific point
     pub fn contains(&self, x: i32, y: i32, z: i32) -> bool {
-        self.boxes.iter().any(|bbox| bbox.contains((x, y, z)))
+        match self.index() {
+            Some(index) => index.contains(x, y, z),
+            None => self.boxes.iter().any(|bbox| bbox.contains((x, y, z))),
+        }
+    }
+
+    // ========================================================================
+    // Spatial Index
+    // ========================================================================
+
+    /// Route `contains` and `intersects_bounds` through a bounding-volume
+    /// tree over the boxes: O(log n) per query instead of a scan, for
+    /// regions with many boxes. The tree is rebuilt on the first query after
+    /// the region changes. Code that edits `boxes` directly must call this
+    /// again afterwards.
+    pub fn build_index(&mut self) -> &mut Self {
+        self.indexed = true;
+        self.index.take();
+        self
+    }
+
+    /// Go back to scanning the boxes, freeing the index.
+    pub fn drop_index(&mut self) -> &mut Self {
+        self.indexed = false;
+        self.index.take();
+        self
+    }
+
+    pub fn has_index(&self) -> bool {
+        self.indexed
+    }
+
+    /// The index, when enabled and in step with `boxes`.
+    fn index(&self) -> Option<&BoxIndex> {
+        if !self.indexed {
+            return None;
+        }
+        let index = self.index.get_or_init(|| BoxIndex::new(&self.boxes));
+        // `boxes` is public; an index built before a direct edit is ignored.
+        (index.len() == self.boxes.len()).then_some(index)
+    }
+
+    /// The index, or a temporary one for a single boolean operation.
+    fn index_or_build(&self) -> Cow<'_, BoxIndex> {
+        match self.index() {
+            Some(index) => Cow::Borrowed(index),
+            None => Cow::Owned(BoxIndex::new(&self.boxes)),
+        }
     }
 
     /// Get a list of all positions as a Vec
@@ -613,7 +694,10 @@ impl DefinitionRegion {
     /// Useful for frustum culling in renderers.
     pub fn intersects_bounds(&self, min: (i32, i32, i32), max: (i32, i32, i32)) -> bool {
         let query = BoundingBox::new(min, max);
-        self.boxes.iter().any(|bbox| bbox.intersects(&query))
+        match self.index() {
+            Some(index) => !index.search(&query, |_, _| false),
+            None => self.boxes.iter().any(|bbox| bbox.intersects(&query)),
+        }
     }
 
     // ========================================================================
@@ -656,6 +740,183 @@ impl DefinitionRegion {
     }
 }
 
+/// Append boxes covering the set cells of `bbox` (bits in
+/// `BoundingBox::coords_to_index` order: x fastest, then z, then y).
+fn boxes_from_cells(bbox: &BoundingBox, cells: &[u64], out: &mut Vec<BoundingBox>) {
+    let (min, max) = (bbox.min, bbox.max);
+    let is_set = |x: i32, y: i32, z: i32| {
+        let cell = bbox.coords_to_index(x, y, z);
+        cells[cell / 64] >> (cell % 64) & 1 != 0
+    };
+    let mut merger = RunMerger::default();
+    for y in min.1..=max.1 {
+        for z in min.2..=max.2 {
+            let mut x = min.0;
+            while x <= max.0 {
+                if !is_set(x, y, z) {
+                    x += 1;
+                    continue;
+                }
+                let start = x;
+                while x < max.0 && is_set(x + 1, y, z) {
+                    x += 1;
+                }
+                merger.push(y, z, start, x);
+                x += 1;
+            }
+        }
+    }
+    out.extend(merger.finish());
+}
+
+/// Merges X runs, pushed in (y, z, x) order, into disjoint boxes. A run
+/// extends the rectangle of the row behind it when their X spans match, and
+/// a finished layer's rectangle extends the box of the layer below when the
+/// rectangles match: greedy meshing in one sweep.
+#[derive(Default)]
+struct RunMerger {
+    boxes: Vec<BoundingBox>,
+    /// The current layer's rectangles as `(x0, x1, z0, z1)`.
+    rects: Vec<(i32, i32, i32, i32)>,
+    /// X spans of the previous row's runs -> rectangle.
+    behind: HashMap<(i32, i32), usize>,
+    /// X spans of the current row's runs -> rectangle.
+    row: HashMap<(i32, i32), usize>,
+    /// The previous layer's rectangles -> box.
+    below: HashMap<(i32, i32, i32, i32), usize>,
+    /// Current layer and row.
+    at: Option<(i32, i32)>,
+}
+
+impl RunMerger {
+    fn push(&mut self, y: i32, z: i32, x0: i32, x1: i32) {
+        match self.at {
+            Some((ay, az)) if ay == y => {
+                if az != z {
+                    self.behind = std::mem::take(&mut self.row);
+                    if az + 1 != z {
+                        self.behind.clear();
+                    }
+                }
+            }
+            at => {
+                self.finish_layer();
+                if at.map_or(true, |(ay, _)| ay + 1 != y) {
+                    self.below.clear();
+                }
+                self.behind.clear();
+                self.row.clear();
+            }
+        }
+        self.at = Some((y, z));
+
+        let rect = match self.behind.get(&(x0, x1)) {
+            Some(&rect) => {
+                self.rects[rect].3 = z;
+                rect
+            }
+            None => {
+                self.rects.push((x0, x1, z, z));
+                self.rects.len() - 1
+            }
+        };
+        self.row.insert((x0, x1), rect);
+    }
+
+    fn finish_layer(&mut self) {
+        let Some((y, _)) = self.at else {
+            return;
+        };
+        let mut layer = HashMap::with_capacity(self.rects.len());
+        for rect @ (x0, x1, z0, z1) in self.rects.drain(..) {
+            let i = match self.below.get(&rect) {
+                Some(&i) => {
+                    self.boxes[i].max.1 = y;
+                    i
+                }
+                None => {
+                    self.boxes.push(BoundingBox::new((x0, y, z0), (x1, y, z1)));
+                    self.boxes.len() - 1
+                }
+            };
+            layer.insert(rect, i);
+        }
+        self.below = layer;
+    }
+
+    fn finish(mut self) -> Vec<BoundingBox> {
+        self.finish_layer();
+        self.boxes
+    }
+}
+
+/// Merge neighbouring boxes in (y, z, x) order of their minimum corner into
+/// their bounding box, cheapest added volume first, until `target` remain.
+fn coarsen(mut boxes: Vec<BoundingBox>, target: usize) -> Vec<BoundingBox> {
+    use std::cmp::Reverse;
+    use std::collections::BinaryHeap;
+
+    boxes.sort_unstable_by_key(|b| (b.min.1, b.min.2, b.min.0));
+    let n = boxes.len();
+    let cost = |a: &BoundingBox, b: &BoundingBox| {
+        a.union(b).volume().saturating_sub(a.volume() + b.volume())
+    };
+    // A doubly linked list over the survivors; `version` invalidates heap
+    // entries for boxes that have grown since.
+    let mut prev: Vec<Option<usize>> = (0..n).map(|i| i.checked_sub(1)).collect();
+    let mut next: Vec<Option<usize>> = (0..n).map(|i| (i + 1 < n).then_some(i + 1)).collect();
+    let mut alive = vec![true; n];
+    let mut version = vec![0u32; n];
+    let mut heap: BinaryHeap<Reverse<(u64, usize, usize, u32, u32)>> = (0..n.saturating_sub(1))
+        .map(|i| Reverse((cost(&boxes[i], &boxes[i + 1]), i, i + 1, 0, 0)))
+        .collect();
+
+    let mut remaining = n;
+    while remaining > target {
+        let Some(Reverse((_, a, b, va, vb))) = heap.pop() else {
+            break;
+        };
+        if !alive[a] || !alive[b] || version[a] != va || version[b] != vb {
+            continue;
+        }
+        boxes[a] = boxes[a].union(&boxes[b]);
+        alive[b] = false;
+        version[a] += 1;
+        next[a] = next[b];
+        if let Some(c) = next[b] {
+            prev[c] = Some(a);
+        }
+        remaining -= 1;
+        for (l, r) in [(prev[a], Some(a)), (Some(a), next[a])] {
+            if let (Some(l), Some(r)) = (l, r) {
+                heap.push(Reverse((
+                    cost(&boxes[l], &boxes[r]),
+                    l,
+                    r,
+                    version[l],
+                    version[r],
+                )));
+            }
+        }
+    }
+
+    boxes
+        .into_iter()
+        .zip(alive)
+        .filter_map(|(b, alive)| alive.then_some(b))
+        .collect()
+}
+
+/// The positions in `bbox`, Y first (layers), then X (rows), then Z
+/// (columns): standard redstone order.
+fn box_positions(bbox: &BoundingBox) -> impl Iterator<Item = (i32, i32, i32)> {
+    let (min_x, min_y, min_z) = bbox.min;
+    let (max_x, max_y, max_z) = bbox.max;
+    (min_y..=max_y).flat_map(move |y| {
+        (min_x..=max_x).flat_map(move |x| (min_z..=max_z).map(move |z| (x, y, z)))
+    })
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -1029,4 +1290,139 @@ mod tests {
         assert_eq!(region.box_count(), 2);
         assert_eq!(region.volume(), 2);
     }
+
+    #[test]
+    fn test_index_tracks_boolean_operations() {
+        // An irregular selection that from_positions splits into many boxes.
+        let positions: Vec<_> = (0..40)
+            .flat_map(|x| (0..6).flat_map(move |y| (0..40).map(move |z| (x, y, z))))
+            .filter(|&(x, y, z)| (x * 7 + y * 3 + z * 5) % 11 < 6)
+            .collect();
+        let mut indexed = DefinitionRegion::from_positions(&positions);
+        indexed.build_index();
+        let mut scanned = indexed.clone();
+        scanned.drop_index();
+        assert!(indexed.has_index() && !scanned.has_index());
+        assert!(indexed.box_count() > 100);
+
+        let cut = DefinitionRegion::from_bounds((10, 0, 10), (25, 3, 30));
+        let mut keep = DefinitionRegion::from_bounds((5, 1, 0), (35, 5, 20));
+        keep.add_bounds((0, 0, 35), (39, 5, 39));
+        let set = |r: &DefinitionRegion| r.iter_positions().collect::<HashSet<_>>();
+        let expected_subtract: HashSet<_> = set(&indexed).difference(&set(&cut)).copied().collect();
+        let expected_intersect: HashSet<_> = expected_subtract
+            .intersection(&set(&keep))
+            .copied()
+            .collect();
+
+        for region in [&mut indexed, &mut scanned] {
+            region.subtract(&cut);
+            assert_eq!(set(region), expected_subtract);
+            region.intersect(&keep);
+            assert_eq!(set(region), expected_intersect);
+            region.shift(1, 0, 0);
+        }
+        assert!(indexed.has_index());
+        for x in -1..42 {
+            for y in -1..7 {
+                for z in -1..41 {
+                    assert_eq!(indexed.contains(x, y, z), scanned.contains(x, y, z));
+                }
+            }
+        }
+        assert_eq!(
+            indexed.intersects_bounds((0, 0, 21), (40, 6, 34)),
+            scanned.intersects_bounds((0, 0, 21), (40, 6, 34))
+        );
+
+        // A direct edit to `boxes` is not missed.
+        indexed
+            .boxes
+            .push(BoundingBox::new((100, 0, 0), (100, 0, 0)));
+        assert!(indexed.contains(100, 0, 0));
+    }
+
+    #[test]
+    fn test_filter_by_matches_a_position_scan() {
+        let mut schematic = UniversalSchematic::new("test".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        for x in 0..12 {
+            for y in 0..4 {
+                for z in 0..12 {
+                    if (x + 2 * z + y) % 5 != 0 {
+                        let block = if (x / 3 + z / 4) % 2 == 0 {
+                            &stone
+                        } else {
+                            &glass
+                        };
+                        schematic.set_block(x, y, z, block);
+                    }
+                }
+            }
+        }
+
+        // Overlapping boxes, one reaching past the schematic.
+        let mut region = DefinitionRegion::from_bounds((0, 0, 0), (7, 3, 7));
+        region.add_bounds((4, 1, 4), (15, 5, 9));
+        let filtered = region.filter_by(&schematic, |b| b.get_name() == "minecraft:stone");
+
+        let expected: HashSet<_> = region
+            .iter_positions()
+            .filter(|&(x, y, z)| {
+                schematic
+                    .get_block(x, y, z)
+                    .is_some_and(|b| b.get_name() == "minecraft:stone")
+            })
+            .collect();
+        let kept: HashSet<_> = filtered.iter_positions().collect();
+        assert_eq!(kept, expected);
+        // Disjoint boxes: the summed volume counts each position once.
+        assert_eq!(filtered.volume(), expected.len() as u64);
+        assert!(filtered.box_count() < expected.len());
+    }
+
+    #[test]
+    fn test_from_positions_sweeps_into_few_boxes() {
+        // A 4x3x5 block with a 2x3x1 notch: the sweep splits it into the
+        // slab before the notch, the notch row's remainder, and the slab
+        // after, all full height.
+        let positions: Vec<_> = (0..4)
+            .flat_map(|x| (0..3).flat_map(move |y| (0..5).map(move |z| (x, y, z))))
+            .filter(|&(x, _, z)| !(z == 2 && x < 2))
+            .collect();
+        let region = DefinitionRegion::from_positions(&positions);
+        assert_eq!(region.volume(), positions.len() as u64);
+        assert_eq!(region.box_count(), 3);
+        assert!(positions.iter().all(|&(x, y, z)| region.contains(x, y, z)));
+
+        let cube: Vec<_> = (0..8).map(|i| (i & 1, i >> 1 & 1, i >> 2)).collect();
+        assert_eq!(DefinitionRegion::from_positions(&cube).box_count(), 1);
+    }
+
+    #[test]
+    fn test_simplify_to_caps_the_box_count() {
+        let positions: Vec<_> = (0..30)
+            .flat_map(|x| (0..4).flat_map(move |y| (0..30).map(move |z| (x, y, z))))
+            .filter(|&(x, y, z)| (x * 5 + y * 3 + z * 7) % 9 < 4)
+            .collect();
+        let mut region = DefinitionRegion::from_positions(&positions);
+        let exact = region.box_count();
+        assert!(exact > 50);
+
+        region.simplify_to(usize::MAX);
+        assert_eq!(region.box_count(), exact);
+
+        region.simplify_to(50);
+        assert!(region.box_count() <= 50);
+        assert!(positions.iter().all(|&(x, y, z)| region.contains(x, y, z)));
+        let bounds = DefinitionRegion::from_bounds((0, 0, 0), (29, 3, 29));
+        assert!(region
+            .iter_positions()
+            .all(|(x, y, z)| bounds.contains(x, y, z)));
+
+        region.simplify_to(0);
+        assert_eq!(region.box_count(), 1);
+        assert_eq!(region.get_bounds(), bounds.get_bounds());
+    }
 }
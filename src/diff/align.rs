@@ -1,8 +1,10 @@
 //! Alignment: find the translation that best maps A-cells onto B-cells.
 
 use std::collections::HashMap;
+use std::sync::{Arc, Mutex, OnceLock};
 
-use rustfft::{num_complex::Complex, FftPlanner};
+use rayon::prelude::*;
+use rustfft::{num_complex::Complex, Fft, FftPlanner};
 
 use crate::diff::{AlignOptions, Cell, IVec3};
 
@@ -90,37 +92,41 @@ fn occupancy(cells: &[Cell], limit: usize, stride: usize) -> Option<([usize; 3],
 /// cells) that best maps `a` onto `b` (peak of the FFT cross-correlation).
 fn correlate(da: [usize; 3], ga: &[f32], db: [usize; 3], gb: &[f32]) -> IVec3 {
     let n = [da[0] + db[0], da[1] + db[1], da[2] + db[2]];
-    let total = n[0] * n[1] * n[2];
-    let mut ca = vec![Complex::new(0.0, 0.0); total];
-    let mut cb = vec![Complex::new(0.0, 0.0); total];
-    let idx = |i: usize, j: usize, k: usize| i + n[0] * (j + n[1] * k);
-    for k in 0..da[2] {
-        for j in 0..da[1] {
-            for i in 0..da[0] {
-                ca[idx(i, j, k)] = Complex::new(ga[i + da[0] * (j + da[1] * k)], 0.0);
-            }
-        }
-    }
-    for k in 0..db[2] {
-        for j in 0..db[1] {
-            for i in 0..db[0] {
-                cb[idx(i, j, k)] = Complex::new(gb[i + db[0] * (j + db[1] * k)], 0.0);
-            }
-        }
-    }
-    fft3d(&mut ca, n, false);
-    fft3d(&mut cb, n, false);
-    let mut prod: Vec<Complex<f32>> = ca.iter().zip(&cb).map(|(x, y)| x.conj() * y).collect();
+    let (mut ca, cb) = rayon::join(
+        || {
+            let mut c = embed(da, ga, n);
+            fft3d(&mut c, n, false);
+            c
+        },
+        || {
+            let mut c = embed(db, gb, n);
+            fft3d(&mut c, n, false);
+            c
+        },
+    );
+    ca.par_iter_mut()
+        .zip(cb.par_iter())
+        .for_each(|(x, y)| *x = x.conj() * y);
+    drop(cb);
+    let mut prod = ca;
     fft3d(&mut prod, n, true);
-    let mut best = (0usize, f32::MIN);
-    for (i, v) in prod.iter().enumerate() {
-        if v.re > best.1 {
-            best = (i, v.re);
-        }
-    }
-    let li = best.0 % n[0];
-    let lj = (best.0 / n[0]) % n[1];
-    let lk = best.0 / (n[0] * n[1]);
+    // Highest peak, lowest index on ties, so the result does not depend on
+    // how the search was split.
+    let best = prod
+        .par_iter()
+        .enumerate()
+        .map(|(i, v)| (i, v.re))
+        .reduce_with(|x, y| {
+            if y.1 > x.1 || (y.1 == x.1 && y.0 < x.0) {
+                y
+            } else {
+                x
+            }
+        })
+        .map_or(0, |(i, _)| i);
+    let li = best % n[0];
+    let lj = (best / n[0]) % n[1];
+    let lk = best / (n[0] * n[1]);
     let unwrap = |v: usize, m: usize| {
         if v > m / 2 {
             v as i32 - m as i32
@@ -131,60 +137,96 @@ fn correlate(da: [usize; 3], ga: &[f32], db: [usize; 3], gb: &[f32]) -> IVec3 {
     (unwrap(li, n[0]), unwrap(lj, n[1]), unwrap(lk, n[2]))
 }
 
-fn fft3d(cube: &mut [Complex<f32>], n: [usize; 3], inverse: bool) {
-    let mut planner = FftPlanner::<f32>::new();
-    let idx = |i: usize, j: usize, k: usize| i + n[0] * (j + n[1] * k);
-    let fx = if inverse {
-        planner.plan_fft_inverse(n[0])
-    } else {
-        planner.plan_fft_forward(n[0])
-    };
-    let mut lx = vec![Complex::new(0.0, 0.0); n[0]];
-    for k in 0..n[2] {
-        for j in 0..n[1] {
-            for i in 0..n[0] {
-                lx[i] = cube[idx(i, j, k)];
+/// Zero-pad the `d`-sized grid `g` into an `n`-sized complex cube.
+fn embed(d: [usize; 3], g: &[f32], n: [usize; 3]) -> Vec<Complex<f32>> {
+    let mut cube = vec![Complex::new(0.0, 0.0); n[0] * n[1] * n[2]];
+    cube.par_chunks_mut(n[0] * n[1])
+        .take(d[2])
+        .enumerate()
+        .for_each(|(k, slab)| {
+            for j in 0..d[1] {
+                let row = &g[d[0] * (j + d[1] * k)..][..d[0]];
+                for (out, &v) in slab[n[0] * j..][..d[0]].iter_mut().zip(row) {
+                    *out = Complex::new(v, 0.0);
+                }
             }
-            fx.process(&mut lx);
-            for i in 0..n[0] {
-                cube[idx(i, j, k)] = lx[i];
+        });
+    cube
+}
+
+/// Plans are costly to build and the same few sizes recur across diffs (and
+/// across the rotations of one diff), so they are kept for the process.
+fn plan(len: usize, inverse: bool) -> Arc<dyn Fft<f32>> {
+    static PLANS: OnceLock<Mutex<HashMap<(usize, bool), Arc<dyn Fft<f32>>>>> = OnceLock::new();
+    let mut plans = PLANS
+        .get_or_init(Default::default)
+        .lock()
+        .unwrap_or_else(|e| e.into_inner());
+    plans
+        .entry((len, inverse))
+        .or_insert_with(|| {
+            let mut planner = FftPlanner::<f32>::new();
+            if inverse {
+                planner.plan_fft_inverse(len)
+            } else {
+                planner.plan_fft_forward(len)
             }
-        }
-    }
-    let fy = if inverse {
-        planner.plan_fft_inverse(n[1])
-    } else {
-        planner.plan_fft_forward(n[1])
-    };
-    let mut ly = vec![Complex::new(0.0, 0.0); n[1]];
-    for k in 0..n[2] {
+        })
+        .clone()
+}
+
+/// Lines handed to one rayon task per FFT pass; enough to amortize the task
+/// without starving threads on small cubes.
+const LINES_PER_TASK: usize = 64;
+
+/// Run the 1-D FFT `fft` over every contiguous line of `data` in parallel.
+fn fft_lines(fft: &dyn Fft<f32>, data: &mut [Complex<f32>]) {
+    let len = fft.len();
+    data.par_chunks_mut(len * LINES_PER_TASK).for_each(|lines| {
+        let mut scratch = vec![Complex::new(0.0, 0.0); fft.get_inplace_scratch_len()];
+        fft.process_with_scratch(lines, &mut scratch);
+    });
+}
+
+/// In-place 3-D FFT of an x-fastest cube: X lines are contiguous; Y lines
+/// are transformed slab by slab; Z lines go through a transposed copy so each
+/// is contiguous. Every pass is parallel over lines.
+fn fft3d(cube: &mut [Complex<f32>], n: [usize; 3], inverse: bool) {
+    let slab = n[0] * n[1];
+    fft_lines(&*plan(n[0], inverse), cube);
+
+    let fy = plan(n[1], inverse);
+    cube.par_chunks_mut(slab).for_each(|plane| {
+        let mut line = vec![Complex::new(0.0, 0.0); n[1]];
+        let mut scratch = vec![Complex::new(0.0, 0.0); fy.get_inplace_scratch_len()];
         for i in 0..n[0] {
             for j in 0..n[1] {
-                ly[j] = cube[idx(i, j, k)];
+                line[j] = plane[i + n[0] * j];
             }
-            fy.process(&mut ly);
+            fy.process_with_scratch(&mut line, &mut scratch);
             for j in 0..n[1] {
-                cube[idx(i, j, k)] = ly[j];
+                plane[i + n[0] * j] = line[j];
             }
         }
-    }
-    let fz = if inverse {
-        planner.plan_fft_inverse(n[2])
-    } else {
-        planner.plan_fft_forward(n[2])
-    };
-    let mut lz = vec![Complex::new(0.0, 0.0); n[2]];
-    for j in 0..n[1] {
-        for i in 0..n[0] {
-            for k in 0..n[2] {
-                lz[k] = cube[idx(i, j, k)];
-            }
-            fz.process(&mut lz);
-            for k in 0..n[2] {
-                cube[idx(i, j, k)] = lz[k];
+    });
+
+    // Transpose to z-fastest ([i + n0*j] major), transform, transpose back.
+    let src: &[Complex<f32>] = cube;
+    let mut columns = vec![Complex::new(0.0, 0.0); src.len()];
+    columns
+        .par_chunks_mut(n[2])
+        .enumerate()
+        .for_each(|(ij, column)| {
+            for (k, out) in column.iter_mut().enumerate() {
+                *out = src[ij + slab * k];
             }
+        });
+    fft_lines(&*plan(n[2], inverse), &mut columns);
+    cube.par_chunks_mut(slab).enumerate().for_each(|(k, out)| {
+        for (ij, v) in out.iter_mut().enumerate() {
+            *v = columns[k + n[2] * ij];
         }
-    }
+    });
 }
 
 /// FFT cross-correlation: exact translation aligning A-cells onto B-cells, or
@@ -232,3 +274,37 @@ pub fn fft_translate_downsampled(a: &[Cell], b: &[Cell], limit: usize) -> Option
     );
     Some((off, stride))
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::block_state::BlockState;
+    use crate::fingerprint::classifier::Token;
+
+    fn cells(points: &[IVec3], shift: IVec3) -> Vec<Cell> {
+        points
+            .iter()
+            .map(|p| {
+                let name = "minecraft:stone";
+                (
+                    (p.0 + shift.0, p.1 + shift.1, p.2 + shift.2),
+                    Token::from(name),
+                    BlockState::new(name),
+                )
+            })
+            .collect()
+    }
+
+    #[test]
+    fn fft_translate_recovers_a_shift_on_odd_sized_grids() {
+        // An asymmetric staircase, so exactly one shift lines it up.
+        let points: Vec<IVec3> = (0..7)
+            .flat_map(|i| [(i, i / 2, 0), (i, 0, i % 3), (0, i, 4)])
+            .collect();
+        let a = cells(&points, (0, 0, 0));
+        let b = cells(&points, (5, -3, 11));
+        assert_eq!(fft_translate(&a, &b, 96), Some((5, -3, 11)));
+        assert_eq!(fft_translate(&b, &a, 96), Some((-5, 3, -11)));
+        assert_eq!(fft_translate(&a, &b, 4), None);
+    }
+}
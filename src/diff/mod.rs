@@ -4,7 +4,9 @@
 pub mod align;
 #[cfg(feature = "meshing")]
 mod overlay;
+mod patch;
 pub mod regions;
+mod sections;
 
 #[cfg(feature = "meshing")]
 pub use overlay::{OverlayError, OverlayOptions};
@@ -49,6 +51,9 @@ pub struct AlignOptions {
     pub anchor_max_count: usize,
     pub fft_fallback: bool,
     pub ambiguous_margin: f32,
+    /// Largest extent (per axis) the FFT fallback correlates exactly; larger
+    /// builds are aligned on a pooled grid and refined.
+    pub fft_limit: usize,
 }
 impl Default for AlignOptions {
     fn default() -> Self {
@@ -56,6 +61,7 @@ impl Default for AlignOptions {
             anchor_max_count: 64,
             fft_fallback: true,
             ambiguous_margin: 1.5,
+            fft_limit: 96,
         }
     }
 }
@@ -144,42 +150,84 @@ use crate::universal_schematic::UniversalSchematic;
 
 /// Tokenize a build under a rotation: B-frame positions + tokens + rotated blocks.
 pub(crate) fn cells(schem: &UniversalSchematic, g: &RigidOp, spec: &FingerprintSpec) -> Vec<Cell> {
-    // Memoize block-entity NBT serializations by NBT identity so
-    // template-shared entities are hashed once, not once per cell.
-    let mut nbt_memo: HashMap<*const crate::utils::NbtMap, Option<Token>> = HashMap::new();
-    // Only content-exact specs fold block-entity NBT into the token; the fuzzy
-    // presets deliberately ignore block identity. Rotation-tolerant specs also
-    // drop facing/rotation NBT keys, which the group element does not rotate.
-    let fold_nbt = spec.block_entities;
-    let ignore_directional = spec.symmetry != crate::fingerprint::symmetry::Symmetry::None;
-    schem
-        .iter_blocks()
-        // Air is absence, not a block: never tokenize it as a present cell in the
-        // diff path. Done here (rather than per-policy) so it is preset-independent
-        // and consistent across all bindings.
-        .filter(|(_, b)| !crate::fingerprint::is_air(b.get_name()))
-        .filter_map(|(pos, b)| {
-            let rb = g.apply_block(b);
-            spec.blocks.tokenize(&rb).map(|tok| {
-                // Cells differing only in tile-entity NBT (sign text, chest
-                // contents) must not compare equal: fold the entity's stable
-                // NBT token into the cell token.
-                let tok = match schem.get_block_entity(pos).filter(|_| fold_nbt) {
-                    Some(be) => {
-                        let key = std::sync::Arc::as_ptr(&be.nbt);
-                        match nbt_memo.entry(key).or_insert_with(|| {
+    CellSource::new(schem, spec).cells(g, spec)
+}
+
+/// The rotation-invariant half of [`cells`]: a build's non-air cells as
+/// palette indices plus their block-entity NBT tokens. Built once per build
+/// and shared by every orbit element, which then rotates and tokenizes only
+/// the distinct palette entries instead of every cell.
+pub(crate) struct CellSource<'a> {
+    palette: Vec<&'a BlockState>,
+    cells: Vec<(IVec3, usize, Option<Token>)>,
+}
+
+impl<'a> CellSource<'a> {
+    pub(crate) fn new(schem: &'a UniversalSchematic, spec: &FingerprintSpec) -> Self {
+        // Memoize block-entity NBT serializations by NBT identity so
+        // template-shared entities are hashed once, not once per cell.
+        let mut nbt_memo: HashMap<*const crate::utils::NbtMap, Option<Token>> = HashMap::new();
+        // Only content-exact specs fold block-entity NBT into the token; the fuzzy
+        // presets deliberately ignore block identity. Rotation-tolerant specs also
+        // drop facing/rotation NBT keys, which the group element does not rotate.
+        let fold_nbt = spec.block_entities;
+        let ignore_directional = spec.symmetry != crate::fingerprint::symmetry::Symmetry::None;
+        let mut palette: Vec<&BlockState> = Vec::new();
+        let mut index: HashMap<crate::block_state_registry::StateId, usize> = HashMap::new();
+        let mut cells = Vec::new();
+        for (pos, state_id, b) in schem.iter_blocks_with_ids() {
+            // Air is absence, not a block: never tokenize it as a present cell in
+            // the diff path. Done here (rather than per-policy) so it is
+            // preset-independent and consistent across all bindings.
+            if crate::fingerprint::is_air(b.get_name()) {
+                continue;
+            }
+            let id = *index.entry(state_id).or_insert_with(|| {
+                palette.push(b);
+                palette.len() - 1
+            });
+            // Cells differing only in tile-entity NBT (sign text, chest
+            // contents) must not compare equal: keep the entity's stable NBT
+            // token to fold into the cell token.
+            let nbt = fold_nbt
+                .then(|| schem.get_block_entity(pos))
+                .flatten()
+                .and_then(|be| {
+                    let key = std::sync::Arc::as_ptr(&be.nbt);
+                    nbt_memo
+                        .entry(key)
+                        .or_insert_with(|| {
                             crate::fingerprint::stable_nbt_token(&be.nbt, ignore_directional)
-                        }) {
-                            Some(nbt) => crate::fingerprint::token_with_nbt(&tok, nbt),
-                            None => tok,
-                        }
-                    }
-                    None => tok,
+                        })
+                        .clone()
+                });
+            cells.push(((pos.x, pos.y, pos.z), id, nbt));
+        }
+        CellSource { palette, cells }
+    }
+
+    /// The build's cells under `g`, in the order [`cells`] yields them.
+    pub(crate) fn cells(&self, g: &RigidOp, spec: &FingerprintSpec) -> Vec<Cell> {
+        let rotated: Vec<Option<(Token, BlockState)>> = self
+            .palette
+            .iter()
+            .map(|b| {
+                let rb = g.apply_block(b);
+                spec.blocks.tokenize(&rb).map(|tok| (tok, rb))
+            })
+            .collect();
+        self.cells
+            .iter()
+            .filter_map(|(pos, id, nbt)| {
+                let (tok, rb) = rotated[*id].as_ref()?;
+                let tok = match nbt {
+                    Some(nbt) => crate::fingerprint::token_with_nbt(tok, nbt),
+                    None => tok.clone(),
                 };
-                (g.apply_pos((pos.x, pos.y, pos.z)), tok, rb)
+                Some((g.apply_pos(*pos), tok, rb.clone()))
             })
-        })
-        .collect()
+            .collect()
+    }
 }
 
 /// Raw cell diff (before palette-swap collapsing).
@@ -400,17 +448,13 @@ fn refine_offset(
     (best, best_raw)
 }
 
-fn diff_for_rotation(
-    a: &UniversalSchematic,
-    b_cells: &[Cell],
-    g: &RigidOp,
-    spec: &DiffSpec,
-) -> Diff {
-    let a_cells = cells(a, g, &spec.fingerprint);
+fn diff_for_rotation(a: &CellSource, b_cells: &[Cell], g: &RigidOp, spec: &DiffSpec) -> Diff {
+    let a_cells = a.cells(g, &spec.fingerprint);
     let (mut t, margin) = crate::diff::align::hough_translate(&a_cells, b_cells, &spec.align);
     let mut raw = compare(&a_cells, t, b_cells);
     if spec.align.fft_fallback && margin < spec.align.ambiguous_margin {
-        if let Some(ft) = crate::diff::align::fft_translate(&a_cells, b_cells, 96) {
+        if let Some(ft) = crate::diff::align::fft_translate(&a_cells, b_cells, spec.align.fft_limit)
+        {
             // Exact FFT fit: keep whichever offset yields fewer residual changes.
             let raw_ft = compare(&a_cells, ft, b_cells);
             if raw_score(&raw_ft) < raw_score(&raw) {
@@ -418,7 +462,7 @@ fn diff_for_rotation(
                 raw = raw_ft;
             }
         } else if let Some((coarse, stride)) =
-            crate::diff::align::fft_translate_downsampled(&a_cells, b_cells, 96)
+            crate::diff::align::fft_translate_downsampled(&a_cells, b_cells, spec.align.fft_limit)
         {
             // Build too large for the exact grid: align coarsely on a pooled grid,
             // then refine within ±stride to recover the exact translation.
@@ -430,7 +474,8 @@ fn diff_for_rotation(
         }
     }
     // Reuse the winning offset's comparison — no extra `compare` pass in diff_at.
-    diff_at_raw(raw, &a_cells, b_cells, g, t, spec)
+    let max_cells = a_cells.len().max(b_cells.len());
+    diff_at_raw(raw, &a_cells, b_cells, g, t, max_cells, spec)
 }
 
 /// Diff A-cells against B-cells at a FIXED translation `t` (no alignment
@@ -438,17 +483,21 @@ fn diff_for_rotation(
 /// `diff_identity` with `t = (0, 0, 0)`.
 fn diff_at(a_cells: &[Cell], b_cells: &[Cell], g: &RigidOp, t: IVec3, spec: &DiffSpec) -> Diff {
     let raw = compare(a_cells, t, b_cells);
-    diff_at_raw(raw, a_cells, b_cells, g, t, spec)
+    let max_cells = a_cells.len().max(b_cells.len());
+    diff_at_raw(raw, a_cells, b_cells, g, t, max_cells, spec)
 }
 
 /// Like [`diff_at`] but takes a precomputed [`RawDiff`] for `t`, avoiding a
-/// redundant `compare` pass when the caller already has it.
+/// redundant `compare` pass when the caller already has it. `max_cells` is
+/// the larger side's full cell count, which exceeds the slices' lengths when
+/// they hold only the changed sections.
 fn diff_at_raw(
     raw: RawDiff,
     a_cells: &[Cell],
     b_cells: &[Cell],
     g: &RigidOp,
     t: IVec3,
+    max_cells: usize,
     spec: &DiffSpec,
 ) -> Diff {
     let matched = raw.matched;
@@ -467,7 +516,7 @@ fn diff_at_raw(
     removed.sort_by(|x, y| x.0.cmp(&y.0));
     changed.sort_by(|x, y| x.0.cmp(&y.0));
     swapped.sort_by(|x, y| x.0.cmp(&y.0));
-    let max_cells = a_cells.len().max(b_cells.len()).max(1);
+    let max_cells = max_cells.max(1);
     let distance = spec.costs.add as u64 * added.len() as u64
         + spec.costs.delete as u64 * removed.len() as u64
         + spec.costs.change as u64 * changed.len() as u64
@@ -491,19 +540,21 @@ fn diff_at_raw(
     }
 }
 
+/// Orbit elements are diffed in parallel on the rayon pool, all sharing one
+/// [`CellSource`] for `a`. Ties go to the earliest element, as a serial scan
+/// would pick.
 pub fn diff(a: &UniversalSchematic, b: &UniversalSchematic, spec: &DiffSpec) -> Diff {
+    use rayon::prelude::*;
+
     let b_cells = cells(b, &RigidOp::identity(), &spec.fingerprint);
-    let mut best: Option<Diff> = None;
-    for g in spec.fingerprint.symmetry.elements() {
-        let d = diff_for_rotation(a, &b_cells, &g, spec);
-        if best
-            .as_ref()
-            .map(|bd| d.distance < bd.distance)
-            .unwrap_or(true)
-        {
-            best = Some(d);
-        }
-    }
+    let a_source = CellSource::new(a, &spec.fingerprint);
+    let best = spec
+        .fingerprint
+        .symmetry
+        .elements()
+        .par_iter()
+        .map(|g| diff_for_rotation(&a_source, &b_cells, g, spec))
+        .reduce_with(|best, d| if d.distance < best.distance { d } else { best });
     best.unwrap_or_else(|| Diff {
         transform: Transform {
             rotate: RigidOp::identity(),
@@ -525,10 +576,35 @@ pub fn diff(a: &UniversalSchematic, b: &UniversalSchematic, spec: &DiffSpec) ->
 /// reported in absolute coordinates (used by world_stream's per-chunk diff,
 /// where both worlds use the same world coordinates).
 pub fn diff_identity(a: &UniversalSchematic, b: &UniversalSchematic, spec: &DiffSpec) -> Diff {
+    diff_at_translation(a, b, (0, 0, 0), spec)
+}
+
+/// Diff `a` shifted by `t` against `b`, with no rotation and no alignment
+/// search: for versions of a build whose offset is already known.
+///
+/// Both builds are digested per 16³ section first and only the sections
+/// whose digests differ are tokenized and compared, so near-identical builds
+/// cost one pass over their palette indices plus the changed sections.
+pub fn diff_at_translation(
+    a: &UniversalSchematic,
+    b: &UniversalSchematic,
+    t: IVec3,
+    spec: &DiffSpec,
+) -> Diff {
     let id = RigidOp::identity();
-    let a_cells = cells(a, &id, &spec.fingerprint);
-    let b_cells = cells(b, &id, &spec.fingerprint);
-    diff_at(&a_cells, &b_cells, &id, (0, 0, 0), spec)
+    let changed = sections::changed_sections(a, b, t, &spec.fingerprint);
+    let mut raw = compare(&changed.a_cells, t, &changed.b_cells);
+    raw.matched += changed.unchanged;
+    let max_cells = changed.a_total.max(changed.b_total);
+    diff_at_raw(
+        raw,
+        &changed.a_cells,
+        &changed.b_cells,
+        &id,
+        t,
+        max_cells,
+        spec,
+    )
 }
 
 impl Diff {
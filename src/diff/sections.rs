@@ -0,0 +1,257 @@
+//! Section-hashed fast path for diffing builds that already share a frame.
+//!
+//! Both sides are digested per 16³ section (B-frame) in one integer pass over
+//! their palette indices. Only sections whose digests differ are tokenized
+//! into [`Cell`]s and compared, so two large versions of a build that differ
+//! in a few blocks cost one scan plus work proportional to the changed
+//! sections, not a `Cell` and two hash-map entries per block.
+
+use std::collections::hash_map::DefaultHasher;
+use std::collections::HashMap;
+use std::hash::{Hash, Hasher};
+
+use crate::bounding_box::BoundingBox;
+use crate::diff::{Cell, IVec3};
+use crate::fingerprint::classifier::Token;
+use crate::fingerprint::FingerprintSpec;
+use crate::region::Region;
+use crate::universal_schematic::UniversalSchematic;
+
+/// log2 of the section edge; matches the 16³ sections of sparse storage.
+const SECTION_BITS: i32 = 4;
+
+fn section_of(p: IVec3) -> IVec3 {
+    (
+        p.0 >> SECTION_BITS,
+        p.1 >> SECTION_BITS,
+        p.2 >> SECTION_BITS,
+    )
+}
+
+/// Order-independent digest of one section's cells: how many there are and
+/// the wrapping sum of their position/token hashes.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+struct Digest {
+    cells: usize,
+    sum: u64,
+}
+
+/// splitmix64 finalizer.
+fn mix(mut x: u64) -> u64 {
+    x = (x ^ (x >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+    x = (x ^ (x >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+    x ^ (x >> 31)
+}
+
+fn cell_hash(p: IVec3, token: u64) -> u64 {
+    let xy = (p.0 as u32 as u64) | ((p.1 as u32 as u64) << 32);
+    mix(token ^ mix(xy ^ mix(p.2 as u32 as u64)))
+}
+
+fn token_hash(token: &Token) -> u64 {
+    let mut h = DefaultHasher::new();
+    token.hash(&mut h);
+    h.finish()
+}
+
+/// One side of the diff, tokenized per palette entry (air and dropped
+/// entries are `None`) rather than per cell.
+struct Side<'a> {
+    regions: Vec<(&'a Region, Vec<Option<(Token, u64)>>)>,
+    /// Added to this side's positions to reach the B frame.
+    shift: IVec3,
+    fold_nbt: bool,
+    ignore_directional: bool,
+}
+
+impl<'a> Side<'a> {
+    fn new(schem: &'a UniversalSchematic, shift: IVec3, spec: &FingerprintSpec) -> Self {
+        let regions = std::iter::once(&schem.default_region)
+            .chain(schem.other_regions.values())
+            .map(|region| {
+                let tokens = region
+                    .palette
+                    .iter()
+                    .map(|b| {
+                        if crate::fingerprint::is_air(b.get_name()) {
+                            return None;
+                        }
+                        let tok = spec.blocks.tokenize(b)?;
+                        let hash = token_hash(&tok);
+                        Some((tok, hash))
+                    })
+                    .collect();
+                (region, tokens)
+            })
+            .collect();
+        Side {
+            regions,
+            shift,
+            fold_nbt: spec.block_entities,
+            ignore_directional: spec.symmetry != crate::fingerprint::symmetry::Symmetry::None,
+        }
+    }
+
+    fn to_b(&self, p: IVec3) -> IVec3 {
+        (p.0 + self.shift.0, p.1 + self.shift.1, p.2 + self.shift.2)
+    }
+
+    fn nbt_token(&self, region: &Region, pos: IVec3) -> Option<Token> {
+        if !self.fold_nbt {
+            return None;
+        }
+        let be = region.block_entities.get(&pos)?;
+        crate::fingerprint::stable_nbt_token(&be.nbt, self.ignore_directional)
+    }
+
+    fn digests(&self) -> HashMap<IVec3, Digest> {
+        let mut out: HashMap<IVec3, Digest> = HashMap::new();
+        for (region, tokens) in &self.regions {
+            for (pos, index) in region.cells_ne(region.air_index()) {
+                let Some((_, hash)) = &tokens[index] else {
+                    continue;
+                };
+                let p = self.to_b(pos);
+                let d = out.entry(section_of(p)).or_default();
+                d.cells += 1;
+                d.sum = d.sum.wrapping_add(cell_hash(p, *hash));
+            }
+            if !self.fold_nbt {
+                continue;
+            }
+            // Block-entity NBT is folded into the cell token, so it has to
+            // move the digest too. There are few of them; visit each once.
+            for (pos, be) in region.block_entities.iter() {
+                let kept = region
+                    .get_block_index(pos.0, pos.1, pos.2)
+                    .and_then(|index| tokens[index].as_ref());
+                let (Some((_, hash)), Some(nbt)) = (
+                    kept,
+                    crate::fingerprint::stable_nbt_token(&be.nbt, self.ignore_directional),
+                ) else {
+                    continue;
+                };
+                let p = self.to_b(pos);
+                let d = out.entry(section_of(p)).or_default();
+                d.sum = d
+                    .sum
+                    .wrapping_add(mix(cell_hash(p, *hash) ^ token_hash(&nbt)));
+            }
+        }
+        out
+    }
+
+    /// Append this side's cells (own frame) that land in B-frame `section`.
+    fn cells_in(&self, section: IVec3, out: &mut Vec<Cell>) {
+        let edge = 1 << SECTION_BITS;
+        let min = (
+            (section.0 << SECTION_BITS) - self.shift.0,
+            (section.1 << SECTION_BITS) - self.shift.1,
+            (section.2 << SECTION_BITS) - self.shift.2,
+        );
+        let max = (min.0 + edge - 1, min.1 + edge - 1, min.2 + edge - 1);
+        let section_box = BoundingBox::new(min, max);
+        for (region, tokens) in &self.regions {
+            let Some(bounds) = region.get_bounding_box().intersection(&section_box) else {
+                continue;
+            };
+            for (pos, index) in region.cells_ne_in(&bounds, region.air_index()) {
+                let Some((tok, _)) = &tokens[index] else {
+                    continue;
+                };
+                let tok = match self.nbt_token(region, pos) {
+                    Some(nbt) => crate::fingerprint::token_with_nbt(tok, &nbt),
+                    None => tok.clone(),
+                };
+                out.push((pos, tok, region.palette[index].clone()));
+            }
+        }
+    }
+}
+
+/// The cells of the sections that differ between `a` (shifted by `t`) and
+/// `b`, each in its own frame as [`crate::diff::cells`] would give them under
+/// the identity rotation.
+pub(crate) struct ChangedSections {
+    pub a_cells: Vec<Cell>,
+    pub b_cells: Vec<Cell>,
+    /// Cells of `a` in sections whose digests matched; all of them match.
+    pub unchanged: usize,
+    /// Total cells on each side.
+    pub a_total: usize,
+    pub b_total: usize,
+}
+
+pub(crate) fn changed_sections(
+    a: &UniversalSchematic,
+    b: &UniversalSchematic,
+    t: IVec3,
+    spec: &FingerprintSpec,
+) -> ChangedSections {
+    let a_side = Side::new(a, t, spec);
+    let b_side = Side::new(b, (0, 0, 0), spec);
+    let (da, db) = rayon::join(|| a_side.digests(), || b_side.digests());
+    let mut keys: Vec<IVec3> = da
+        .iter()
+        .filter(|(k, d)| db.get(*k) != Some(*d))
+        .map(|(k, _)| *k)
+        .chain(db.keys().filter(|k| !da.contains_key(*k)).copied())
+        .collect();
+    keys.sort_unstable();
+    let mut a_cells = Vec::new();
+    let mut b_cells = Vec::new();
+    for &key in &keys {
+        a_side.cells_in(key, &mut a_cells);
+        b_side.cells_in(key, &mut b_cells);
+    }
+    let a_total: usize = da.values().map(|d| d.cells).sum();
+    let b_total = db.values().map(|d| d.cells).sum();
+    ChangedSections {
+        unchanged: a_total - a_cells.len(),
+        a_cells,
+        b_cells,
+        a_total,
+        b_total,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::diff::{cells, compare};
+    use crate::fingerprint::symmetry::RigidOp;
+
+    #[test]
+    fn only_sections_with_edits_are_tokenized() {
+        let spec = FingerprintSpec::exact();
+        let mut a = UniversalSchematic::new("a".to_string());
+        for x in 0..40 {
+            for z in 0..40 {
+                a.set_block_str(x, 0, z, "minecraft:stone");
+            }
+        }
+        let mut b = UniversalSchematic::new("b".to_string());
+        for x in 0..40 {
+            for z in 0..40 {
+                b.set_block_str(x + 3, 5, z - 2, "minecraft:stone");
+            }
+        }
+        b.set_block_str(3, 5, -2, "minecraft:dirt");
+        b.set_block_str(30, 6, 30, "minecraft:glass");
+        let t = (3, 5, -2);
+
+        let changed = changed_sections(&a, &b, t, &spec);
+        assert_eq!((changed.a_total, changed.b_total), (1600, 1601));
+        // Two B-frame sections hold the edits; the rest were skipped.
+        assert!(changed.b_cells.len() < 16 * 16 * 2 + 1);
+        assert_eq!(changed.unchanged + changed.a_cells.len(), 1600);
+
+        let id = RigidOp::identity();
+        let full = compare(&cells(&a, &id, &spec), t, &cells(&b, &id, &spec));
+        let fast = compare(&changed.a_cells, t, &changed.b_cells);
+        assert_eq!(fast.added.len(), full.added.len());
+        assert_eq!(fast.removed.len(), full.removed.len());
+        assert_eq!(fast.changed.len(), full.changed.len());
+        assert_eq!(fast.matched + changed.unchanged, full.matched);
+    }
+}
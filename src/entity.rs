@@ -1,6 +1,8 @@
+use crate::memory;
 use quartz_nbt::{NbtCompound, NbtList, NbtTag};
 use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
+use std::sync::Arc;
 
 #[derive(Clone, Debug, PartialEq, Serialize, Deserialize)]
 pub enum NbtValue {
@@ -19,6 +21,31 @@ pub enum NbtValue {
     Compound(HashMap<String, NbtValue>),
 }
 
+impl NbtValue {
+    /// Heap bytes held by the value, including nested lists and compounds.
+    pub fn heap_bytes(&self) -> usize {
+        match self {
+            NbtValue::String(s) => s.len(),
+            NbtValue::IntArray(v) => memory::vec_bytes(v),
+            NbtValue::LongArray(v) => memory::vec_bytes(v),
+            NbtValue::ByteArray(v) => memory::vec_bytes(v),
+            NbtValue::List(items) => {
+                memory::vec_bytes(items) + items.iter().map(NbtValue::heap_bytes).sum::<usize>()
+            }
+            NbtValue::Compound(map) => compound_heap_bytes(map),
+            _ => 0,
+        }
+    }
+}
+
+pub(crate) fn compound_heap_bytes(map: &HashMap<String, NbtValue>) -> usize {
+    memory::table_bytes(map)
+        + map
+            .iter()
+            .map(|(k, v)| k.len() + v.heap_bytes())
+            .sum::<usize>()
+}
+
 #[derive(Clone, Debug, Default, PartialEq, Eq, Serialize, Deserialize)]
 pub struct ArmorStandEquipment {
     pub helmet: Option<String>,
@@ -41,11 +68,14 @@ impl ArmorStandEquipment {
     }
 }
 
+/// A mobile entity. The NBT is `Arc`-shared so that entities loaded with
+/// identical data (see [`crate::entity_store::EntityInterner`]) and clones
+/// of one entity keep a single map; [`Entity::nbt_mut`] copies on write.
 #[derive(Clone, Debug, PartialEq, Serialize, Deserialize)]
 pub struct Entity {
     pub id: String,
     pub position: (f64, f64, f64),
-    pub nbt: HashMap<String, NbtValue>,
+    pub nbt: Arc<HashMap<String, NbtValue>>,
 }
 
 impl Entity {
@@ -53,10 +83,25 @@ impl Entity {
         Entity {
             id,
             position,
-            nbt: HashMap::new(),
+            nbt: Arc::default(),
         }
     }
 
+    /// Mutable NBT, copied first if another entity shares it.
+    pub fn nbt_mut(&mut self) -> &mut HashMap<String, NbtValue> {
+        Arc::make_mut(&mut self.nbt)
+    }
+
+    /// Replace the NBT.
+    pub fn set_nbt(&mut self, nbt: HashMap<String, NbtValue>) {
+        self.nbt = Arc::new(nbt);
+    }
+
+    /// Heap bytes held by the id and NBT.
+    pub fn heap_bytes(&self) -> usize {
+        self.id.len() + compound_heap_bytes(&self.nbt)
+    }
+
     /// Construct an armor stand with typed equipment instead of hand-authored NBT.
     /// Equipment is stored in Minecraft's boots-to-helmet `ArmorItems` order.
     pub fn armor_stand(
@@ -73,12 +118,13 @@ impl Entity {
             NbtValue::Compound(compound)
         };
         let mut entity = Self::new("minecraft:armor_stand".to_string(), position);
-        entity.nbt.insert(
+        let nbt = entity.nbt_mut();
+        nbt.insert(
             "Rotation".to_string(),
             NbtValue::List(vec![NbtValue::Float(yaw), NbtValue::Float(0.0)]),
         );
-        entity.nbt.insert("ShowArms".to_string(), NbtValue::Byte(1));
-        entity.nbt.insert(
+        nbt.insert("ShowArms".to_string(), NbtValue::Byte(1));
+        nbt.insert(
             "ArmorItems".to_string(),
             NbtValue::List(vec![
                 item(equipment.boots),
@@ -91,7 +137,7 @@ impl Entity {
     }
 
     pub fn with_nbt_data(mut self, key: String, value: String) -> Self {
-        self.nbt.insert(key, NbtValue::String(value));
+        self.nbt_mut().insert(key, NbtValue::String(value));
         self
     }
 
@@ -168,13 +214,22 @@ impl Entity {
         compound.insert("Pos", NbtTag::List(pos_list));
 
         // Write all NBT fields at top level (Minecraft's native format)
-        for (key, value) in &self.nbt {
+        for (key, value) in self.nbt.iter() {
             compound.insert(key, Self::value_to_nbt_tag(value));
         }
 
         NbtTag::Compound(compound)
     }
 
+    /// Just the NBT fields, without `id` and `Pos`.
+    pub fn nbt_compound(&self) -> NbtCompound {
+        let mut compound = NbtCompound::new();
+        for (key, value) in self.nbt.iter() {
+            compound.insert(key, Self::value_to_nbt_tag(value));
+        }
+        compound
+    }
+
     pub fn from_nbt(nbt: &NbtCompound) -> Result<Self, String> {
         // Handle both id cases, but preserve the minecraft: prefix
         let id = match nbt.get::<_, &str>("id") {
@@ -235,7 +290,7 @@ impl Entity {
         Ok(Entity {
             id,
             position,
-            nbt: nbt_map,
+            nbt: Arc::new(nbt_map),
         })
     }
 }
@@ -268,9 +323,9 @@ mod tests {
     fn test_entity_serialization() {
         let mut entity = Entity::new("minecraft:creeper".to_string(), (1.0, 2.0, 3.0));
         entity
-            .nbt
+            .nbt_mut()
             .insert("Health".to_string(), NbtValue::Float(20.0));
-        entity.nbt.insert(
+        entity.nbt_mut().insert(
             "CustomName".to_string(),
             NbtValue::String("Bob".to_string()),
         );
@@ -423,13 +478,13 @@ mod tests {
 
         // Test array types
         entity
-            .nbt
+            .nbt_mut()
             .insert("IntArray".to_string(), NbtValue::IntArray(vec![1, 2, 3]));
         entity
-            .nbt
+            .nbt_mut()
             .insert("LongArray".to_string(), NbtValue::LongArray(vec![1, 2, 3]));
         entity
-            .nbt
+            .nbt_mut()
             .insert("ByteArray".to_string(), NbtValue::ByteArray(vec![1, 2, 3]));
 
         // Test nested compound
@@ -439,11 +494,11 @@ mod tests {
             NbtValue::String("test".to_string()),
         );
         entity
-            .nbt
+            .nbt_mut()
             .insert("NestedCompound".to_string(), NbtValue::Compound(nested_map));
 
         // Test list
-        entity.nbt.insert(
+        entity.nbt_mut().insert(
             "Tags".to_string(),
             NbtValue::List(vec![
                 NbtValue::String("a".to_string()),
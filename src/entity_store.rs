@@ -0,0 +1,392 @@
+//! Storage layer for mobile entities (Entity) within a region.
+//!
+//! Replaces the previous `Vec<Entity>`. Entities stay rows of [`Entity`], so
+//! exporters and converters see the type they always have, with two
+//! additions in the manner of [`crate::block_entity_store`]:
+//!
+//! - NBT is shared. `Entity::nbt` is an `Arc`, copied on write through
+//!   [`Entity::nbt_mut`], and loaders route entities through an
+//!   [`EntityInterner`] so a wall of identical item frames keeps one map.
+//!   Columnar exports encode each shared map once. Maps that differ only in
+//!   their `UUID` are not identical and do not share.
+//! - Positions are indexed by chunk column. [`EntityStore::in_box`] builds
+//!   the index on first use and any mutable access drops it, so a bulk edit
+//!   costs one rebuild rather than one per entity, and box queries over a
+//!   large world only look at the chunks the box covers.
+//!
+//! ## API shape
+//!
+//! Derefs to `[Entity]` and has the `Vec` methods call sites used (`push`,
+//! `extend`, `remove`, `retain`, `clear`), so most code that held a
+//! `Vec<Entity>` works unchanged. Serializes exactly as a `Vec<Entity>`.
+
+use crate::bounding_box::BoundingBox;
+use crate::entity::{compound_heap_bytes, Entity, NbtValue};
+use crate::memory;
+use rayon::prelude::*;
+use rustc_hash::{FxHashMap, FxHashSet, FxHasher};
+use serde::{Deserialize, Deserializer, Serialize, Serializer};
+use std::collections::HashMap;
+use std::hash::{Hash, Hasher};
+use std::ops::{Deref, DerefMut};
+use std::sync::{Arc, OnceLock};
+
+/// Block an entity stands in: its position, floored.
+#[inline]
+pub fn block_of(position: (f64, f64, f64)) -> (i32, i32, i32) {
+    (
+        position.0.floor() as i32,
+        position.1.floor() as i32,
+        position.2.floor() as i32,
+    )
+}
+
+#[inline]
+fn chunk_of(position: (f64, f64, f64)) -> (i32, i32) {
+    let (x, _, z) = block_of(position);
+    (x >> 4, z >> 4)
+}
+
+#[derive(Debug, Clone, Default)]
+pub struct EntityStore {
+    entities: Vec<Entity>,
+    /// Entity indices per chunk column, ascending. Built by the first box
+    /// query after a mutation.
+    by_chunk: OnceLock<FxHashMap<(i32, i32), Vec<u32>>>,
+}
+
+impl EntityStore {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            entities: Vec::with_capacity(capacity),
+            by_chunk: OnceLock::new(),
+        }
+    }
+
+    pub fn push(&mut self, entity: Entity) {
+        self.by_chunk.take();
+        self.entities.push(entity);
+    }
+
+    /// Remove and return the entity at `index`, shifting later ones down.
+    /// Panics if `index` is out of bounds, like `Vec::remove`.
+    pub fn remove(&mut self, index: usize) -> Entity {
+        self.by_chunk.take();
+        self.entities.remove(index)
+    }
+
+    pub fn retain(&mut self, f: impl FnMut(&Entity) -> bool) {
+        self.by_chunk.take();
+        self.entities.retain(f);
+    }
+
+    pub fn clear(&mut self) {
+        self.by_chunk.take();
+        self.entities.clear();
+    }
+
+    pub fn into_vec(self) -> Vec<Entity> {
+        self.entities
+    }
+
+    /// Heap bytes held by the rows, every id and NBT map, and the chunk
+    /// index if built. Maps shared within the store are counted once.
+    pub fn heap_bytes(&self) -> usize {
+        let mut seen_nbt = FxHashSet::default();
+        let rows: usize = self
+            .entities
+            .iter()
+            .map(|entity| {
+                let nbt = if seen_nbt.insert(Arc::as_ptr(&entity.nbt)) {
+                    memory::arc_bytes::<HashMap<String, NbtValue>>()
+                        + compound_heap_bytes(&entity.nbt)
+                } else {
+                    0
+                };
+                entity.id.len() + nbt
+            })
+            .sum();
+        let index = self.by_chunk.get().map_or(0, |by_chunk| {
+            memory::table_bytes(by_chunk)
+                + by_chunk
+                    .values()
+                    .map(|b| memory::vec_bytes(b))
+                    .sum::<usize>()
+        });
+        memory::vec_bytes(&self.entities) + rows + index
+    }
+
+    fn chunk_index(&self) -> &FxHashMap<(i32, i32), Vec<u32>> {
+        self.by_chunk.get_or_init(|| {
+            let mut by_chunk: FxHashMap<(i32, i32), Vec<u32>> = FxHashMap::default();
+            for (i, entity) in self.entities.iter().enumerate() {
+                by_chunk
+                    .entry(chunk_of(entity.position))
+                    .or_default()
+                    .push(i as u32);
+            }
+            by_chunk
+        })
+    }
+
+    /// Indices of the entities whose block (position floored) lies in
+    /// `bbox`, ascending. Only the chunk columns the box covers are
+    /// visited, or only the occupied ones when the box is wider than them.
+    pub fn indices_in_box(&self, bbox: &BoundingBox) -> Vec<usize> {
+        let by_chunk = self.chunk_index();
+        let (cx0, cz0) = (bbox.min.0 >> 4, bbox.min.2 >> 4);
+        let (cx1, cz1) = (bbox.max.0 >> 4, bbox.max.2 >> 4);
+        let columns = (cx1 as i64 - cx0 as i64 + 1) * (cz1 as i64 - cz0 as i64 + 1);
+        let covered =
+            |&(cx, cz): &(i32, i32)| (cx0..=cx1).contains(&cx) && (cz0..=cz1).contains(&cz);
+        let buckets: Vec<&Vec<u32>> = if columns > by_chunk.len() as i64 {
+            by_chunk
+                .iter()
+                .filter(|(chunk, _)| covered(chunk))
+                .map(|(_, bucket)| bucket)
+                .collect()
+        } else {
+            (cx0..=cx1)
+                .flat_map(|cx| (cz0..=cz1).map(move |cz| (cx, cz)))
+                .filter_map(|chunk| by_chunk.get(&chunk))
+                .collect()
+        };
+        let mut hits: Vec<usize> = buckets
+            .into_iter()
+            .flatten()
+            .map(|&i| i as usize)
+            .filter(|&i| bbox.contains(block_of(self.entities[i].position)))
+            .collect();
+        hits.sort_unstable();
+        hits
+    }
+
+    /// The entities whose block lies in `bbox`, in store order.
+    pub fn in_box<'a>(&'a self, bbox: &BoundingBox) -> impl Iterator<Item = &'a Entity> + 'a {
+        self.indices_in_box(bbox)
+            .into_iter()
+            .map(move |i| &self.entities[i])
+    }
+
+    /// Move every entity to `f(position)`, in parallel. NBT is not touched,
+    /// so shared maps stay shared.
+    pub fn map_positions<F>(&mut self, f: F)
+    where
+        F: Fn((f64, f64, f64)) -> (f64, f64, f64) + Sync + Send,
+    {
+        self.by_chunk.take();
+        self.entities
+            .par_iter_mut()
+            .for_each(|entity| entity.position = f(entity.position));
+    }
+}
+
+impl Deref for EntityStore {
+    type Target = [Entity];
+
+    fn deref(&self) -> &[Entity] {
+        &self.entities
+    }
+}
+
+impl DerefMut for EntityStore {
+    /// Mutable access may move entities, so it drops the chunk index.
+    fn deref_mut(&mut self) -> &mut [Entity] {
+        self.by_chunk.take();
+        &mut self.entities
+    }
+}
+
+impl From<Vec<Entity>> for EntityStore {
+    fn from(entities: Vec<Entity>) -> Self {
+        Self {
+            entities,
+            by_chunk: OnceLock::new(),
+        }
+    }
+}
+
+impl Extend<Entity> for EntityStore {
+    fn extend<I: IntoIterator<Item = Entity>>(&mut self, iter: I) {
+        self.by_chunk.take();
+        self.entities.extend(iter);
+    }
+}
+
+impl FromIterator<Entity> for EntityStore {
+    fn from_iter<I: IntoIterator<Item = Entity>>(iter: I) -> Self {
+        Vec::from_iter(iter).into()
+    }
+}
+
+impl IntoIterator for EntityStore {
+    type Item = Entity;
+    type IntoIter = std::vec::IntoIter<Entity>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.entities.into_iter()
+    }
+}
+
+impl<'a> IntoIterator for &'a EntityStore {
+    type Item = &'a Entity;
+    type IntoIter = std::slice::Iter<'a, Entity>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.entities.iter()
+    }
+}
+
+impl<'a> IntoIterator for &'a mut EntityStore {
+    type Item = &'a mut Entity;
+    type IntoIter = std::slice::IterMut<'a, Entity>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.iter_mut()
+    }
+}
+
+impl PartialEq for EntityStore {
+    fn eq(&self, other: &Self) -> bool {
+        self.entities == other.entities
+    }
+}
+
+impl Serialize for EntityStore {
+    fn serialize<S: Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        self.entities.serialize(serializer)
+    }
+}
+
+impl<'de> Deserialize<'de> for EntityStore {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        Vec::<Entity>::deserialize(deserializer).map(Self::from)
+    }
+}
+
+/// Points entities with identical NBT at one shared map while a file
+/// loads. Ids and positions are left alone; only `Entity::nbt` is swapped.
+#[derive(Debug, Default)]
+pub struct EntityInterner {
+    /// Content hash -> maps seen with that hash.
+    seen: FxHashMap<u64, Vec<Arc<HashMap<String, NbtValue>>>>,
+}
+
+impl EntityInterner {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// `entity` with its NBT replaced by the shared map equal to it, or
+    /// kept as a new shared map.
+    pub fn intern(&mut self, mut entity: Entity) -> Entity {
+        let bucket = self.seen.entry(hash_compound(&entity.nbt)).or_default();
+        match bucket
+            .iter()
+            .find(|map| Arc::ptr_eq(map, &entity.nbt) || **map == *entity.nbt)
+        {
+            Some(shared) => entity.nbt = shared.clone(),
+            None => bucket.push(entity.nbt.clone()),
+        }
+        entity
+    }
+
+    /// Distinct maps handed out so far.
+    pub fn len(&self) -> usize {
+        self.seen.values().map(Vec::len).sum()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.seen.is_empty()
+    }
+}
+
+/// Order-independent hash of a compound: entry hashes are summed.
+fn hash_compound(map: &HashMap<String, NbtValue>) -> u64 {
+    map.iter().fold(map.len() as u64, |sum, (key, value)| {
+        let mut hasher = FxHasher::default();
+        key.hash(&mut hasher);
+        hash_value(value, &mut hasher);
+        sum.wrapping_add(hasher.finish())
+    })
+}
+
+fn hash_value(value: &NbtValue, hasher: &mut FxHasher) {
+    std::mem::discriminant(value).hash(hasher);
+    match value {
+        NbtValue::String(v) => v.hash(hasher),
+        NbtValue::Int(v) => v.hash(hasher),
+        NbtValue::Long(v) => v.hash(hasher),
+        NbtValue::Float(v) => v.to_bits().hash(hasher),
+        NbtValue::Double(v) => v.to_bits().hash(hasher),
+        NbtValue::Byte(v) => v.hash(hasher),
+        NbtValue::Short(v) => v.hash(hasher),
+        NbtValue::Boolean(v) => v.hash(hasher),
+        NbtValue::IntArray(v) => v.hash(hasher),
+        NbtValue::LongArray(v) => v.hash(hasher),
+        NbtValue::ByteArray(v) => v.hash(hasher),
+        NbtValue::List(items) => {
+            items.len().hash(hasher);
+            for item in items {
+                hash_value(item, hasher);
+            }
+        }
+        NbtValue::Compound(map) => hash_compound(map).hash(hasher),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn frame(x: f64, z: f64) -> Entity {
+        let mut entity = Entity::new("minecraft:item_frame".to_string(), (x, 64.0, z));
+        entity
+            .nbt_mut()
+            .insert("Facing".to_string(), NbtValue::Byte(2));
+        entity
+    }
+
+    #[test]
+    fn box_queries_use_the_chunk_index_and_follow_mutation() {
+        let mut store: EntityStore = [(0.5, 0.5), (15.9, 3.0), (16.0, 3.0), (-0.5, 40.0)]
+            .into_iter()
+            .map(|(x, z)| frame(x, z))
+            .collect();
+        let first_chunk = BoundingBox::new((0, 0, 0), (15, 255, 15));
+        assert_eq!(store.indices_in_box(&first_chunk), vec![0, 1]);
+        let everything = BoundingBox::new((-1000, 0, -1000), (1000, 255, 1000));
+        assert_eq!(store.indices_in_box(&everything), vec![0, 1, 2, 3]);
+
+        // Moving entities drops the index; the next query sees them moved.
+        store.map_positions(|(x, y, z)| (x + 16.0, y, z));
+        assert_eq!(store.indices_in_box(&first_chunk), vec![3]);
+        store[3].position.0 = 100.0;
+        assert!(store.indices_in_box(&first_chunk).is_empty());
+        store.push(frame(1.0, 1.0));
+        assert_eq!(store.in_box(&first_chunk).count(), 1);
+    }
+
+    #[test]
+    fn interned_entities_share_nbt_until_written() {
+        let mut interner = EntityInterner::new();
+        let mut a = interner.intern(frame(0.0, 0.0));
+        let b = interner.intern(frame(5.0, 5.0));
+        assert!(Arc::ptr_eq(&a.nbt, &b.nbt));
+        assert_eq!(interner.len(), 1);
+
+        let store: EntityStore = vec![a.clone(), b.clone()].into();
+        let shared = store.heap_bytes();
+        let unshared: EntityStore = vec![frame(0.0, 0.0), frame(5.0, 5.0)].into();
+        assert!(shared < unshared.heap_bytes());
+
+        a.nbt_mut()
+            .insert("Invisible".to_string(), NbtValue::Byte(1));
+        assert!(!Arc::ptr_eq(&a.nbt, &b.nbt));
+        assert!(!b.nbt.contains_key("Invisible"));
+    }
+}
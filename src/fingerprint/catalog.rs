@@ -0,0 +1,422 @@
+//! Exact-duplicate lookup: a catalog of 128-bit [`Fingerprint`]s per preset,
+//! each mapped to the id of the first build registered with it.
+//!
+//! [`FingerprintCatalog`] is the mutable form, a hash table per preset.
+//! [`FrozenCatalog`] is its serialized form read in place: lookups
+//! binary-search sorted records straight from the bytes (a file mapping or
+//! a blob fetched from a [`Store`]), so opening a catalog file costs only
+//! its header and checking an upload never loads another schematic.
+//!
+//! ```text
+//! "NUFC" | u32 version = 1 | u64 header length | header (bincode) | records | id bytes
+//! ```
+//!
+//! All integers are little-endian. Records are 24 bytes: the fingerprint as
+//! a `u128`, then the id's offset into the id bytes and its length as
+//! `u32`s. Each preset's records are contiguous and sorted by fingerprint.
+
+use std::collections::{BTreeMap, HashMap};
+
+use serde::{Deserialize, Serialize};
+
+use crate::fingerprint::Fingerprint;
+use crate::store::{Store, StoreError};
+
+const MAGIC: &[u8; 4] = b"NUFC";
+const VERSION: u32 = 1;
+/// Magic, version and header length.
+const PREAMBLE: usize = 16;
+const RECORD_BYTES: usize = 24;
+
+/// Fingerprint -> first registered id, per preset name.
+#[derive(Clone, Debug, Default, PartialEq)]
+pub struct FingerprintCatalog {
+    tables: BTreeMap<String, HashMap<u128, String>>,
+}
+
+impl FingerprintCatalog {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Entries across every preset.
+    pub fn len(&self) -> usize {
+        self.tables.values().map(HashMap::len).sum()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Register `id` as a build with `fingerprint` under `preset`. If the
+    /// fingerprint is already registered, the catalog keeps the first id
+    /// and returns it.
+    pub fn insert(&mut self, preset: &str, fingerprint: Fingerprint, id: &str) -> Option<String> {
+        let table = self.tables.entry(preset.to_string()).or_default();
+        match table.get(&fingerprint.0) {
+            Some(existing) => Some(existing.clone()),
+            None => {
+                table.insert(fingerprint.0, id.to_string());
+                None
+            }
+        }
+    }
+
+    /// [`Self::insert`] for each entry in order, so a fingerprint repeated
+    /// within the batch reports the first id it was given.
+    pub fn insert_batch(
+        &mut self,
+        preset: &str,
+        entries: &[(Fingerprint, String)],
+    ) -> Vec<Option<String>> {
+        entries
+            .iter()
+            .map(|(fingerprint, id)| self.insert(preset, *fingerprint, id))
+            .collect()
+    }
+
+    /// The id registered with `fingerprint` under `preset`.
+    pub fn get(&self, preset: &str, fingerprint: Fingerprint) -> Option<&str> {
+        self.tables
+            .get(preset)?
+            .get(&fingerprint.0)
+            .map(String::as_str)
+    }
+
+    pub fn get_batch(&self, preset: &str, fingerprints: &[Fingerprint]) -> Vec<Option<&str>> {
+        fingerprints.iter().map(|f| self.get(preset, *f)).collect()
+    }
+
+    /// The catalog in the layout described in the module docs.
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut header = Header::default();
+        let mut records = Vec::with_capacity(self.len() * RECORD_BYTES);
+        let mut ids = Vec::new();
+        for (preset, table) in &self.tables {
+            let mut entries: Vec<(&u128, &String)> = table.iter().collect();
+            entries.sort_unstable_by_key(|(fingerprint, _)| **fingerprint);
+            header.presets.push(Table {
+                preset: preset.clone(),
+                start: header.records,
+                count: entries.len() as u64,
+            });
+            header.records += entries.len() as u64;
+            for (fingerprint, id) in entries {
+                records.extend_from_slice(&fingerprint.to_le_bytes());
+                records.extend_from_slice(&(ids.len() as u32).to_le_bytes());
+                records.extend_from_slice(&(id.len() as u32).to_le_bytes());
+                ids.extend_from_slice(id.as_bytes());
+            }
+        }
+        assert!(ids.len() <= u32::MAX as usize, "catalog ids exceed 4 GiB");
+        header.id_bytes = ids.len() as u64;
+
+        let header = bincode::serialize(&header).expect("catalog header serializes");
+        let mut out = Vec::with_capacity(PREAMBLE + header.len() + records.len() + ids.len());
+        out.extend_from_slice(MAGIC);
+        out.extend_from_slice(&VERSION.to_le_bytes());
+        out.extend_from_slice(&(header.len() as u64).to_le_bytes());
+        out.extend_from_slice(&header);
+        out.extend_from_slice(&records);
+        out.extend_from_slice(&ids);
+        out
+    }
+
+    /// Write the catalog to `key` in `store`.
+    pub fn save(&self, store: &dyn Store, key: &str) -> Result<(), StoreError> {
+        store.put(key, &self.to_bytes())
+    }
+
+    /// Write the catalog to `path`, through a temporary file renamed over
+    /// it, so a [`FrozenCatalog`] mapping the old file is never torn.
+    pub fn write_file(&self, path: &std::path::Path) -> std::io::Result<()> {
+        let tmp = path.with_extension("nufc.tmp");
+        std::fs::write(&tmp, self.to_bytes())?;
+        std::fs::rename(&tmp, path)
+    }
+
+    /// Read a catalog written by [`Self::save`] back into mutable form.
+    pub fn load(store: &dyn Store, key: &str) -> Result<Self, StoreError> {
+        FrozenCatalog::load(store, key).map(|frozen| frozen.thaw())
+    }
+}
+
+#[derive(Debug, Default, Serialize, Deserialize)]
+struct Header {
+    /// Sorted by preset name.
+    presets: Vec<Table>,
+    records: u64,
+    id_bytes: u64,
+}
+
+#[derive(Debug, Serialize, Deserialize)]
+struct Table {
+    preset: String,
+    /// Index of the preset's first record.
+    start: u64,
+    count: u64,
+}
+
+/// Bytes behind a [`FrozenCatalog`]: owned, or a read-only file mapping.
+pub enum CatalogBytes {
+    Owned(Vec<u8>),
+    #[cfg(not(target_arch = "wasm32"))]
+    Mapped(memmap2::Mmap),
+}
+
+impl AsRef<[u8]> for CatalogBytes {
+    fn as_ref(&self) -> &[u8] {
+        match self {
+            CatalogBytes::Owned(bytes) => bytes.as_slice(),
+            #[cfg(not(target_arch = "wasm32"))]
+            CatalogBytes::Mapped(map) => &map[..],
+        }
+    }
+}
+
+/// A serialized catalog with only its header parsed; lookups read the
+/// records in place.
+pub struct FrozenCatalog<B: AsRef<[u8]> = CatalogBytes> {
+    bytes: B,
+    header: Header,
+    /// Byte offsets of the records and of the id bytes.
+    records: usize,
+    ids: usize,
+}
+
+impl FrozenCatalog {
+    /// Open a catalog file. It is mapped read-only (read into memory on
+    /// wasm, which has no mapping).
+    pub fn open(path: impl AsRef<std::path::Path>) -> std::io::Result<FrozenCatalog> {
+        #[cfg(not(target_arch = "wasm32"))]
+        let bytes = {
+            let file = std::fs::File::open(path)?;
+            // SAFETY: the mapping is read-only, and `write_file` replaces a
+            // catalog by renaming a new file over it, never in place.
+            CatalogBytes::Mapped(unsafe { memmap2::Mmap::map(&file)? })
+        };
+        #[cfg(target_arch = "wasm32")]
+        let bytes = CatalogBytes::Owned(std::fs::read(path)?);
+        FrozenCatalog::parse(bytes)
+            .map_err(|e| std::io::Error::new(std::io::ErrorKind::InvalidData, e))
+    }
+
+    /// Fetch a catalog written by [`FingerprintCatalog::save`]. `NotFound`
+    /// when `key` is absent, `Other` when it does not hold a catalog.
+    pub fn load(store: &dyn Store, key: &str) -> Result<FrozenCatalog, StoreError> {
+        let bytes = store
+            .get(key)?
+            .ok_or_else(|| StoreError::NotFound(key.to_string()))?;
+        FrozenCatalog::parse(CatalogBytes::Owned(bytes)).map_err(StoreError::Other)
+    }
+}
+
+impl<B: AsRef<[u8]>> FrozenCatalog<B> {
+    /// Parse the header and check that the records and id bytes it
+    /// describes lie inside `bytes`. Ids are checked as they are read.
+    pub fn parse(bytes: B) -> Result<Self, String> {
+        let data = bytes.as_ref();
+        if data.len() < PREAMBLE || &data[..4] != MAGIC {
+            return Err("not a fingerprint catalog".to_string());
+        }
+        let version = u32::from_le_bytes(data[4..8].try_into().unwrap());
+        if version != VERSION {
+            return Err(format!(
+                "unsupported fingerprint catalog version {}",
+                version
+            ));
+        }
+        let header_end = usize::try_from(u64::from_le_bytes(data[8..16].try_into().unwrap()))
+            .ok()
+            .and_then(|len| len.checked_add(PREAMBLE))
+            .filter(|&end| end <= data.len())
+            .ok_or("fingerprint catalog header out of range")?;
+        let header: Header =
+            bincode::deserialize(&data[PREAMBLE..header_end]).map_err(|e| e.to_string())?;
+
+        let records = header_end;
+        let ids = usize::try_from(header.records)
+            .ok()
+            .and_then(|n| n.checked_mul(RECORD_BYTES))
+            .and_then(|len| len.checked_add(records));
+        let end = ids.and_then(|ids| {
+            usize::try_from(header.id_bytes)
+                .ok()
+                .and_then(|len| len.checked_add(ids))
+        });
+        let (Some(ids), Some(end)) = (ids, end) else {
+            return Err("fingerprint catalog sizes overflow".to_string());
+        };
+        if end != data.len() {
+            return Err("fingerprint catalog length does not match its header".to_string());
+        }
+        let tables_fit = header.presets.iter().all(|t| {
+            t.start
+                .checked_add(t.count)
+                .is_some_and(|e| e <= header.records)
+        });
+        let sorted = header.presets.windows(2).all(|w| w[0].preset < w[1].preset);
+        if !tables_fit || !sorted {
+            return Err("fingerprint catalog preset table out of range".to_string());
+        }
+        Ok(FrozenCatalog {
+            bytes,
+            header,
+            records,
+            ids,
+        })
+    }
+
+    /// Entries across every preset.
+    pub fn len(&self) -> usize {
+        self.header.records as usize
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    fn record(&self, index: usize) -> (u128, usize, usize) {
+        let start = self.records + index * RECORD_BYTES;
+        let r = &self.bytes.as_ref()[start..start + RECORD_BYTES];
+        (
+            u128::from_le_bytes(r[..16].try_into().unwrap()),
+            u32::from_le_bytes(r[16..20].try_into().unwrap()) as usize,
+            u32::from_le_bytes(r[20..24].try_into().unwrap()) as usize,
+        )
+    }
+
+    /// The id of record `index`, or `None` if its bytes are out of range
+    /// or not UTF-8.
+    fn id(&self, index: usize) -> Option<&str> {
+        let (_, offset, len) = self.record(index);
+        let ids = &self.bytes.as_ref()[self.ids..];
+        std::str::from_utf8(ids.get(offset..offset.checked_add(len)?)?).ok()
+    }
+
+    /// The id registered with `fingerprint` under `preset`.
+    pub fn get(&self, preset: &str, fingerprint: Fingerprint) -> Option<&str> {
+        let table = self
+            .header
+            .presets
+            .binary_search_by(|t| t.preset.as_str().cmp(preset))
+            .ok()
+            .map(|i| &self.header.presets[i])?;
+        let (mut lo, mut hi) = (table.start as usize, (table.start + table.count) as usize);
+        while lo < hi {
+            let mid = lo + (hi - lo) / 2;
+            match self.record(mid).0.cmp(&fingerprint.0) {
+                std::cmp::Ordering::Less => lo = mid + 1,
+                std::cmp::Ordering::Greater => hi = mid,
+                std::cmp::Ordering::Equal => return self.id(mid),
+            }
+        }
+        None
+    }
+
+    pub fn get_batch(&self, preset: &str, fingerprints: &[Fingerprint]) -> Vec<Option<&str>> {
+        fingerprints.iter().map(|f| self.get(preset, *f)).collect()
+    }
+
+    /// Every entry, in mutable form, to register more builds. Records whose
+    /// id cannot be read are dropped.
+    pub fn thaw(&self) -> FingerprintCatalog {
+        let mut catalog = FingerprintCatalog::new();
+        for table in &self.header.presets {
+            let entries = catalog.tables.entry(table.preset.clone()).or_default();
+            for index in table.start as usize..(table.start + table.count) as usize {
+                if let Some(id) = self.id(index) {
+                    entries.insert(self.record(index).0, id.to_string());
+                }
+            }
+        }
+        catalog
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::store::MemStore;
+
+    fn sample() -> FingerprintCatalog {
+        let mut catalog = FingerprintCatalog::new();
+        for i in 0..100u128 {
+            let fingerprint =
+                Fingerprint(i.wrapping_mul(0x9e37_79b9_7f4a_7c15_f39c_c060_5ced_c835));
+            assert_eq!(
+                catalog.insert("exact", fingerprint, &format!("build-{}", i)),
+                None
+            );
+        }
+        catalog.insert("shape", Fingerprint(7), "shape-7");
+        catalog
+    }
+
+    #[test]
+    fn first_registration_wins() {
+        let mut catalog = sample();
+        let fingerprint =
+            Fingerprint(3u128.wrapping_mul(0x9e37_79b9_7f4a_7c15_f39c_c060_5ced_c835));
+        assert_eq!(
+            catalog.insert("exact", fingerprint, "copy"),
+            Some("build-3".to_string())
+        );
+        assert_eq!(catalog.get("exact", fingerprint), Some("build-3"));
+        assert_eq!(catalog.get("shape", fingerprint), None);
+
+        let batch = vec![
+            (Fingerprint(1), "a".to_string()),
+            (Fingerprint(1), "b".to_string()),
+            (Fingerprint(7), "c".to_string()),
+        ];
+        assert_eq!(
+            catalog.insert_batch("shape", &batch),
+            vec![None, Some("a".to_string()), Some("shape-7".to_string())]
+        );
+        assert_eq!(catalog.len(), 102);
+    }
+
+    #[test]
+    fn frozen_lookups_match_the_catalog() {
+        let catalog = sample();
+        let frozen = FrozenCatalog::parse(catalog.to_bytes()).unwrap();
+        assert_eq!(frozen.len(), catalog.len());
+        let probes: Vec<Fingerprint> = (0..120u128)
+            .map(|i| Fingerprint(i.wrapping_mul(0x9e37_79b9_7f4a_7c15_f39c_c060_5ced_c835)))
+            .collect();
+        assert_eq!(
+            frozen.get_batch("exact", &probes),
+            catalog.get_batch("exact", &probes)
+        );
+        assert_eq!(frozen.get("shape", Fingerprint(7)), Some("shape-7"));
+        assert_eq!(frozen.get("structural", Fingerprint(7)), None);
+        assert_eq!(frozen.thaw(), catalog);
+
+        let mut truncated = catalog.to_bytes();
+        truncated.pop();
+        assert!(FrozenCatalog::parse(truncated).is_err());
+    }
+
+    #[test]
+    fn round_trips_through_a_store_and_a_file() {
+        let catalog = sample();
+        let store = MemStore::new();
+        catalog.save(&store, "catalog.nufc").unwrap();
+        assert_eq!(
+            FingerprintCatalog::load(&store, "catalog.nufc").unwrap(),
+            catalog
+        );
+        assert!(matches!(
+            FrozenCatalog::load(&store, "missing"),
+            Err(StoreError::NotFound(_))
+        ));
+
+        let path = std::env::temp_dir().join(format!("catalog-{}.nufc", std::process::id()));
+        catalog.write_file(&path).unwrap();
+        let frozen = FrozenCatalog::open(&path).unwrap();
+        assert_eq!(frozen.get("shape", Fingerprint(7)), Some("shape-7"));
+        drop(frozen);
+        std::fs::remove_file(&path).unwrap();
+    }
+}
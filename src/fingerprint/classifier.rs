@@ -8,6 +8,7 @@ use serde::Deserialize;
 use smol_str::SmolStr;
 
 use crate::block_state::BlockState;
+use crate::blockpedia::BlockFlags;
 
 pub type Token = SmolStr;
 
@@ -55,10 +56,11 @@ fn glob_match(pattern: &str, name: &str) -> bool {
 }
 
 fn match_category(cat: BpCategory, name: &str) -> bool {
-    match crate::blockpedia::get_block(name) {
-        Some(facts) => match cat {
-            BpCategory::Transparent => facts.transparent,
-            BpCategory::Solid => !facts.transparent,
+    let transparent = BlockFlags::TRANSPARENT;
+    match crate::blockpedia::block_flags(name) {
+        Some(flags) => match cat {
+            BpCategory::Transparent => flags.contains(transparent),
+            BpCategory::Solid => !flags.contains(transparent),
         },
         None => false,
     }
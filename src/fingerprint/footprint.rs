@@ -14,6 +14,9 @@ use crate::universal_schematic::UniversalSchematic;
 const N: usize = 32; // canonical padded cube edge
 const LOW: usize = 8; // low-frequency block edge kept per axis (8^3 = 512 dims)
 
+/// Length of every [`Footprint`] vector.
+pub const FOOTPRINT_DIMS: usize = LOW * LOW * LOW;
+
 #[derive(Clone, Debug, PartialEq)]
 pub struct Footprint(pub Vec<f32>);
 
@@ -74,7 +77,7 @@ pub fn footprint(schem: &UniversalSchematic, spec: &FingerprintSpec) -> Footprin
     }
 
     fft3d(&mut cube);
-    let mut feat = Vec::with_capacity(LOW * LOW * LOW);
+    let mut feat = Vec::with_capacity(FOOTPRINT_DIMS);
     for k in 0..LOW {
         for j in 0..LOW {
             for i in 0..LOW {
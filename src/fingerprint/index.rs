@@ -0,0 +1,529 @@
+//! Approximate nearest-neighbour search over FFT [`Footprint`]s, so
+//! near-duplicates in a large library can be found without comparing every
+//! pair.
+//!
+//! [`FootprintIndex`] is a hierarchical navigable small-world graph (HNSW,
+//! Malkov & Yashunin). Every footprint is a node linked to its near
+//! neighbours on layer 0 and, with geometrically falling probability, on the
+//! sparser layers above. A query descends greedily from the top layer, then
+//! runs a best-first search of width `ef_search` on layer 0. Inserts are
+//! incremental; there is no separate build or training step.
+//!
+//! The graph is deterministic: a node's top layer comes from a hash of its
+//! id, not an RNG, so inserting the same footprints in the same order always
+//! gives the same index and the same answers.
+//!
+//! Vectors are kept at full precision (512 `f32`s for a default footprint),
+//! so each node costs about 2 KiB plus its links.
+
+use std::cmp::{Ordering, Reverse};
+use std::collections::{BinaryHeap, HashMap, HashSet};
+
+use serde::{Deserialize, Serialize};
+
+use crate::fingerprint::Footprint;
+use crate::store::{Store, StoreError};
+
+const MAGIC: &[u8; 4] = b"NUFI";
+const VERSION: u32 = 1;
+/// Layers above this are never assigned; `m^16` nodes is far past any library.
+const MAX_LEVEL: usize = 16;
+
+/// Links per node on the upper layers; layer 0 keeps twice as many.
+pub const DEFAULT_M: usize = 16;
+/// Candidate-list width while inserting.
+pub const DEFAULT_EF_CONSTRUCTION: usize = 200;
+/// Minimum candidate-list width while searching (raised to `k` when larger).
+pub const DEFAULT_EF_SEARCH: usize = 64;
+
+#[derive(Debug, PartialEq, thiserror::Error)]
+pub enum IndexError {
+    #[error("id `{0}` is already in the index")]
+    DuplicateId(String),
+    #[error("footprint has {found} dimensions, the index holds {expected}")]
+    Dimension { expected: usize, found: usize },
+}
+
+/// One search hit.
+#[derive(Clone, Debug, PartialEq)]
+pub struct Neighbor {
+    pub id: String,
+    /// Euclidean distance between the footprints, as [`Footprint::distance`].
+    pub distance: f32,
+}
+
+/// An HNSW graph over footprints, keyed by caller-chosen string ids (e.g.
+/// the store keys of the schematics).
+///
+/// Footprints are only comparable under one [`FingerprintSpec`]; the index
+/// does not record which one its footprints used.
+///
+/// [`FingerprintSpec`]: crate::fingerprint::FingerprintSpec
+#[derive(Clone, Debug, Serialize, Deserialize)]
+pub struct FootprintIndex {
+    m: usize,
+    ef_construction: usize,
+    ef_search: usize,
+    /// Vector length, fixed by the first insert.
+    dim: usize,
+    ids: Vec<String>,
+    /// Node `n`'s vector is `vectors[n * dim..(n + 1) * dim]`.
+    vectors: Vec<f32>,
+    /// `links[n][layer]`: node `n`'s neighbours on every layer it is on.
+    links: Vec<Vec<Vec<u32>>>,
+    /// The node on the top layer where every search starts.
+    entry: Option<u32>,
+    /// Rebuilt from `ids` on load.
+    #[serde(skip)]
+    by_id: HashMap<String, u32>,
+}
+
+/// A node and its distance to the query, ordered nearest first (ties by
+/// node, so searches are deterministic).
+#[derive(Clone, Copy, Debug, PartialEq)]
+struct Cand {
+    dist: f32,
+    node: u32,
+}
+
+impl Eq for Cand {}
+
+impl Ord for Cand {
+    fn cmp(&self, other: &Self) -> Ordering {
+        self.dist
+            .total_cmp(&other.dist)
+            .then(self.node.cmp(&other.node))
+    }
+}
+
+impl PartialOrd for Cand {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+fn distance(a: &[f32], b: &[f32]) -> f32 {
+    a.iter()
+        .zip(b)
+        .map(|(x, y)| (x - y) * (x - y))
+        .sum::<f32>()
+        .sqrt()
+}
+
+impl Default for FootprintIndex {
+    fn default() -> Self {
+        Self::new(DEFAULT_M, DEFAULT_EF_CONSTRUCTION)
+    }
+}
+
+impl FootprintIndex {
+    /// An empty index keeping `m` links per node (`2 * m` on layer 0) and
+    /// inserting with a candidate list `ef_construction` wide. Larger values
+    /// give better recall for a slower build and a bigger graph.
+    pub fn new(m: usize, ef_construction: usize) -> Self {
+        FootprintIndex {
+            m: m.max(2),
+            ef_construction: ef_construction.max(1),
+            ef_search: DEFAULT_EF_SEARCH,
+            dim: 0,
+            ids: Vec::new(),
+            vectors: Vec::new(),
+            links: Vec::new(),
+            entry: None,
+            by_id: HashMap::new(),
+        }
+    }
+
+    /// Candidate-list width for [`Self::search`]: higher is slower and
+    /// finds more of the true nearest neighbours.
+    pub fn set_ef_search(&mut self, ef_search: usize) {
+        self.ef_search = ef_search.max(1);
+    }
+
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
+    pub fn contains(&self, id: &str) -> bool {
+        self.by_id.contains_key(id)
+    }
+
+    fn vector(&self, node: u32) -> &[f32] {
+        let start = node as usize * self.dim;
+        &self.vectors[start..start + self.dim]
+    }
+
+    fn dist(&self, query: &[f32], node: u32) -> f32 {
+        distance(query, self.vector(node))
+    }
+
+    fn max_links(&self, layer: usize) -> usize {
+        if layer == 0 {
+            2 * self.m
+        } else {
+            self.m
+        }
+    }
+
+    /// `floor(-ln(u) / ln(m))` for `u` uniform in `(0, 1]`, drawn from a hash
+    /// of `id`: each layer holds about `1/m` of the nodes below it.
+    fn level_for(&self, id: &str) -> usize {
+        let hash = blake3::hash(id.as_bytes());
+        let bits = u64::from_le_bytes(hash.as_bytes()[..8].try_into().unwrap());
+        let u = ((bits >> 11) + 1) as f64 / (1u64 << 53) as f64;
+        ((-u.ln() / (self.m as f64).ln()) as usize).min(MAX_LEVEL)
+    }
+
+    fn check_dim(&self, footprint: &Footprint) -> Result<(), IndexError> {
+        if footprint.0.len() == self.dim {
+            Ok(())
+        } else {
+            Err(IndexError::Dimension {
+                expected: self.dim,
+                found: footprint.0.len(),
+            })
+        }
+    }
+
+    /// Add `footprint` under `id`. The first insert fixes the dimension.
+    pub fn insert(&mut self, id: &str, footprint: &Footprint) -> Result<(), IndexError> {
+        if self.by_id.contains_key(id) {
+            return Err(IndexError::DuplicateId(id.to_string()));
+        }
+        if self.ids.is_empty() {
+            self.dim = footprint.0.len();
+        }
+        self.check_dim(footprint)?;
+
+        let node = self.ids.len() as u32;
+        let level = self.level_for(id);
+        self.ids.push(id.to_string());
+        self.vectors.extend_from_slice(&footprint.0);
+        self.links.push(vec![Vec::new(); level + 1]);
+        self.by_id.insert(id.to_string(), node);
+
+        let Some(entry) = self.entry else {
+            self.entry = Some(node);
+            return Ok(());
+        };
+        let query = &footprint.0;
+        let top = self.links[entry as usize].len() - 1;
+        let mut nearest = vec![Cand {
+            dist: self.dist(query, entry),
+            node: entry,
+        }];
+        for layer in (level + 1..=top).rev() {
+            nearest = self.search_layer(query, &nearest, 1, layer);
+        }
+        for layer in (0..=level.min(top)).rev() {
+            let found = self.search_layer(query, &nearest, self.ef_construction, layer);
+            for chosen in self.select(&found, self.m) {
+                self.links[node as usize][layer].push(chosen.node);
+                self.link(chosen.node, node, layer);
+            }
+            nearest = found;
+        }
+        if level > top {
+            self.entry = Some(node);
+        }
+        Ok(())
+    }
+
+    /// Add `to` to `from`'s links on `layer`, re-selecting them if that
+    /// takes `from` past its limit.
+    fn link(&mut self, from: u32, to: u32, layer: usize) {
+        self.links[from as usize][layer].push(to);
+        if self.links[from as usize][layer].len() <= self.max_links(layer) {
+            return;
+        }
+        let origin = self.vector(from);
+        let mut current: Vec<Cand> = self.links[from as usize][layer]
+            .iter()
+            .map(|&node| Cand {
+                dist: distance(origin, self.vector(node)),
+                node,
+            })
+            .collect();
+        current.sort();
+        let kept = self.select(&current, self.max_links(layer));
+        self.links[from as usize][layer] = kept.into_iter().map(|c| c.node).collect();
+    }
+
+    /// Pick up to `m` of `candidates` (nearest first) to link to: a
+    /// candidate is kept only if it is nearer the query than to every one
+    /// already kept, so links spread in different directions instead of
+    /// bunching in one cluster. Pruned candidates fill any places left, so
+    /// sparse regions stay connected.
+    fn select(&self, candidates: &[Cand], m: usize) -> Vec<Cand> {
+        let mut kept: Vec<Cand> = Vec::with_capacity(m);
+        for &c in candidates {
+            if kept.len() == m {
+                return kept;
+            }
+            let v = self.vector(c.node);
+            if kept
+                .iter()
+                .all(|k| distance(v, self.vector(k.node)) > c.dist)
+            {
+                kept.push(c);
+            }
+        }
+        for &c in candidates {
+            if kept.len() == m {
+                break;
+            }
+            if !kept.contains(&c) {
+                kept.push(c);
+            }
+        }
+        kept
+    }
+
+    /// Best-first search of `layer` from `entry`, keeping the `ef` nearest
+    /// nodes seen. Returns them nearest first.
+    fn search_layer(&self, query: &[f32], entry: &[Cand], ef: usize, layer: usize) -> Vec<Cand> {
+        let mut visited: HashSet<u32> = entry.iter().map(|c| c.node).collect();
+        let mut candidates: BinaryHeap<Reverse<Cand>> =
+            entry.iter().copied().map(Reverse).collect();
+        let mut found: BinaryHeap<Cand> = entry.iter().copied().collect();
+        while let Some(Reverse(c)) = candidates.pop() {
+            if found.len() >= ef && found.peek().is_some_and(|worst| c.dist > worst.dist) {
+                break;
+            }
+            for &node in &self.links[c.node as usize][layer] {
+                if !visited.insert(node) {
+                    continue;
+                }
+                let dist = self.dist(query, node);
+                if found.len() < ef || found.peek().is_some_and(|worst| dist < worst.dist) {
+                    candidates.push(Reverse(Cand { dist, node }));
+                    found.push(Cand { dist, node });
+                    if found.len() > ef {
+                        found.pop();
+                    }
+                }
+            }
+        }
+        found.into_sorted_vec()
+    }
+
+    /// Up to `k` indexed footprints within `max_distance` of `query`,
+    /// nearest first. Approximate: a true neighbour can be missed, more
+    /// rarely the wider `ef_search` is.
+    pub fn search(
+        &self,
+        query: &Footprint,
+        k: usize,
+        max_distance: f32,
+    ) -> Result<Vec<Neighbor>, IndexError> {
+        let Some(entry) = self.entry else {
+            return Ok(Vec::new());
+        };
+        self.check_dim(query)?;
+        let query = &query.0;
+        let mut nearest = vec![Cand {
+            dist: self.dist(query, entry),
+            node: entry,
+        }];
+        for layer in (1..self.links[entry as usize].len()).rev() {
+            nearest = self.search_layer(query, &nearest, 1, layer);
+        }
+        let found = self.search_layer(query, &nearest, self.ef_search.max(k), 0);
+        Ok(found
+            .into_iter()
+            .take_while(|c| c.dist <= max_distance)
+            .take(k)
+            .map(|c| Neighbor {
+                id: self.ids[c.node as usize].clone(),
+                distance: c.dist,
+            })
+            .collect())
+    }
+
+    /// `"NUFI" | u32 version (LE) | bincode index`.
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut out = MAGIC.to_vec();
+        out.extend_from_slice(&VERSION.to_le_bytes());
+        bincode::serialize_into(&mut out, self).expect("index serializes");
+        out
+    }
+
+    /// Parse [`Self::to_bytes`] output, checking that every link points at
+    /// a node on that layer.
+    pub fn from_bytes(bytes: &[u8]) -> Result<Self, String> {
+        if bytes.len() < 8 || &bytes[..4] != MAGIC {
+            return Err("not a footprint index".to_string());
+        }
+        let version = u32::from_le_bytes(bytes[4..8].try_into().unwrap());
+        if version != VERSION {
+            return Err(format!("unsupported footprint index version {}", version));
+        }
+        let mut index: FootprintIndex =
+            bincode::deserialize(&bytes[8..]).map_err(|e| e.to_string())?;
+
+        let len = index.ids.len();
+        if index.vectors.len() != len * index.dim || index.links.len() != len {
+            return Err("footprint index sizes disagree".to_string());
+        }
+        if index.entry.map_or(len > 0, |e| e as usize >= len) {
+            return Err("footprint index entry point out of range".to_string());
+        }
+        for layers in &index.links {
+            for (layer, links) in layers.iter().enumerate() {
+                if links.iter().any(|&n| {
+                    index
+                        .links
+                        .get(n as usize)
+                        .map_or(true, |l| l.len() <= layer)
+                }) {
+                    return Err("footprint index link out of range".to_string());
+                }
+            }
+        }
+        for (node, id) in index.ids.iter().enumerate() {
+            if index.by_id.insert(id.clone(), node as u32).is_some() {
+                return Err(format!("footprint index repeats id `{}`", id));
+            }
+        }
+        Ok(index)
+    }
+
+    /// Write the index to `key` in `store`.
+    pub fn save(&self, store: &dyn Store, key: &str) -> Result<(), StoreError> {
+        store.put(key, &self.to_bytes())
+    }
+
+    /// Read an index written by [`Self::save`]. `NotFound` when `key` is
+    /// absent, `Other` when it does not hold a valid index.
+    pub fn load(store: &dyn Store, key: &str) -> Result<Self, StoreError> {
+        let bytes = store
+            .get(key)?
+            .ok_or_else(|| StoreError::NotFound(key.to_string()))?;
+        Self::from_bytes(&bytes).map_err(StoreError::Other)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::store::MemStore;
+
+    /// `count` deterministic unit vectors of length `dim` (splitmix64).
+    fn vectors(count: usize, dim: usize) -> Vec<Footprint> {
+        let mut state = 0x9e37_79b9_7f4a_7c15u64;
+        let mut next = || {
+            state = state.wrapping_add(0x9e37_79b9_7f4a_7c15);
+            let mut z = state;
+            z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+            z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+            ((z ^ (z >> 31)) >> 40) as f32 / (1u64 << 24) as f32 - 0.5
+        };
+        (0..count)
+            .map(|_| {
+                let v: Vec<f32> = (0..dim).map(|_| next()).collect();
+                let norm = v.iter().map(|x| x * x).sum::<f32>().sqrt();
+                Footprint(v.into_iter().map(|x| x / norm).collect())
+            })
+            .collect()
+    }
+
+    fn build(footprints: &[Footprint]) -> FootprintIndex {
+        let mut index = FootprintIndex::default();
+        for (i, fp) in footprints.iter().enumerate() {
+            index.insert(&format!("s{}", i), fp).unwrap();
+        }
+        index
+    }
+
+    #[test]
+    fn search_matches_brute_force() {
+        let footprints = vectors(600, 24);
+        let index = build(&footprints);
+        assert_eq!(index.len(), 600);
+
+        let mut hits = 0;
+        for query in footprints.iter().step_by(20) {
+            let mut exact: Vec<(f32, usize)> = footprints
+                .iter()
+                .enumerate()
+                .map(|(i, f)| (query.distance(f), i))
+                .collect();
+            exact.sort_by(|a, b| a.0.total_cmp(&b.0));
+            let found = index.search(query, 10, f32::INFINITY).unwrap();
+            assert_eq!(found.len(), 10);
+            assert_eq!(found[0].distance, 0.0, "a stored footprint finds itself");
+            assert!(found.windows(2).all(|w| w[0].distance <= w[1].distance));
+            hits += exact[..10]
+                .iter()
+                .filter(|(_, i)| found.iter().any(|n| n.id == format!("s{}", i)))
+                .count();
+        }
+        assert!(
+            hits * 100 >= 30 * 10 * 95,
+            "recall@10 below 95%: {}/300",
+            hits
+        );
+    }
+
+    #[test]
+    fn threshold_duplicates_and_dimensions() {
+        let footprints = vectors(50, 8);
+        let mut index = build(&footprints);
+        let near = Footprint(footprints[3].0.iter().map(|x| x * 0.999).collect());
+
+        let found = index.search(&near, 5, 0.01).unwrap();
+        assert_eq!(found.len(), 1);
+        assert_eq!(found[0].id, "s3");
+
+        assert_eq!(
+            index.insert("s3", &near),
+            Err(IndexError::DuplicateId("s3".to_string()))
+        );
+        let short = Footprint(vec![1.0; 4]);
+        assert_eq!(
+            index.insert("short", &short),
+            Err(IndexError::Dimension {
+                expected: 8,
+                found: 4
+            })
+        );
+        assert!(index.search(&short, 1, 1.0).is_err());
+        assert!(FootprintIndex::default()
+            .search(&short, 1, 1.0)
+            .unwrap()
+            .is_empty());
+    }
+
+    #[test]
+    fn round_trips_through_a_store() {
+        let footprints = vectors(200, 16);
+        let index = build(&footprints);
+        let store = MemStore::new();
+        index.save(&store, "library.nufi").unwrap();
+
+        let mut loaded = FootprintIndex::load(&store, "library.nufi").unwrap();
+        for query in footprints.iter().take(10) {
+            assert_eq!(
+                loaded.search(query, 5, 1.0).unwrap(),
+                index.search(query, 5, 1.0).unwrap()
+            );
+        }
+        assert!(loaded.contains("s199"));
+        assert!(loaded.insert("s0", &footprints[0]).is_err());
+        loaded.insert("extra", &footprints[0]).unwrap();
+
+        assert!(matches!(
+            FootprintIndex::load(&store, "missing"),
+            Err(StoreError::NotFound(_))
+        ));
+        store.put("junk", b"NUFI\x01\0\0\0junk").unwrap();
+        assert!(matches!(
+            FootprintIndex::load(&store, "junk"),
+            Err(StoreError::Other(_))
+        ));
+    }
+}
@@ -0,0 +1,258 @@
+//! Footprints of many builds in one contiguous buffer, with all-pairs
+//! distances and top-k neighbours computed in blocks.
+//!
+//! Distances come from `|a|² + |b|² − 2·a·b`, so the inner loop is a dot
+//! product over contiguous rows that the compiler vectorizes. Row blocks run
+//! in parallel and each walks every column block, keeping a tile of rows and
+//! columns hot in cache. Results match [`Footprint::distance`] up to float
+//! rounding.
+//!
+//! [`Footprint::distance`]: crate::fingerprint::Footprint::distance
+
+use std::borrow::Borrow;
+use std::ops::Range;
+
+use rayon::prelude::*;
+
+use crate::fingerprint::footprint::{footprint, FOOTPRINT_DIMS};
+use crate::fingerprint::FingerprintSpec;
+use crate::universal_schematic::UniversalSchematic;
+
+/// Rows handed to one rayon task.
+const ROW_BLOCK: usize = 32;
+/// Columns compared against a row block before moving on, sized so a
+/// column tile (64 × 2 KiB) stays in L2 while the row block sweeps it.
+const COL_BLOCK: usize = 64;
+
+/// Footprints of `schematics`, row `i` being `schematics[i]`'s, in one
+/// `len × FOOTPRINT_DIMS` buffer. Computed in parallel.
+pub fn footprints_batch<S>(schematics: &[S], spec: &FingerprintSpec) -> Vec<f32>
+where
+    S: Borrow<UniversalSchematic> + Sync,
+{
+    let mut rows = vec![0.0f32; schematics.len() * FOOTPRINT_DIMS];
+    rows.par_chunks_mut(FOOTPRINT_DIMS)
+        .zip(schematics.par_iter())
+        .for_each(|(row, schem)| row.copy_from_slice(&footprint(schem.borrow(), spec).0));
+    rows
+}
+
+/// A set of footprints as rows of one contiguous buffer.
+#[derive(Clone, Debug, PartialEq)]
+pub struct FootprintMatrix {
+    rows: Vec<f32>,
+    norms: Vec<f32>,
+}
+
+/// Each row's `k` nearest other rows, nearest first, as two flat `len × k`
+/// arrays. Rows with fewer than `k` others are padded with `u32::MAX` and
+/// `f32::INFINITY`.
+#[derive(Clone, Debug, PartialEq)]
+pub struct TopK {
+    pub k: usize,
+    pub indices: Vec<u32>,
+    pub distances: Vec<f32>,
+}
+
+fn dot(a: &[f32], b: &[f32]) -> f32 {
+    // Eight independent accumulators so the adds don't serialize.
+    let mut acc = [0.0f32; 8];
+    let (ca, cb) = (a.chunks_exact(8), b.chunks_exact(8));
+    let tail: f32 = ca
+        .remainder()
+        .iter()
+        .zip(cb.remainder())
+        .map(|(x, y)| x * y)
+        .sum();
+    for (x, y) in ca.zip(cb) {
+        for lane in 0..8 {
+            acc[lane] += x[lane] * y[lane];
+        }
+    }
+    acc.iter().sum::<f32>() + tail
+}
+
+/// The `k` smallest `(distance, index)` pairs seen so far, sorted.
+struct Nearest {
+    k: usize,
+    items: Vec<(f32, u32)>,
+}
+
+impl Nearest {
+    fn push(&mut self, distance: f32, index: u32) {
+        let item = (distance, index);
+        if self.items.len() == self.k {
+            match self.items.last() {
+                Some(&worst) if item.partial_cmp(&worst) == Some(std::cmp::Ordering::Less) => {}
+                _ => return,
+            }
+        }
+        let at = self
+            .items
+            .partition_point(|x| x.partial_cmp(&item) == Some(std::cmp::Ordering::Less));
+        self.items.insert(at, item);
+        self.items.truncate(self.k);
+    }
+}
+
+impl FootprintMatrix {
+    /// Wrap a `len × FOOTPRINT_DIMS` buffer. `None` if its length is not a
+    /// multiple of [`FOOTPRINT_DIMS`].
+    pub fn from_rows(rows: Vec<f32>) -> Option<Self> {
+        if rows.len() % FOOTPRINT_DIMS != 0 {
+            return None;
+        }
+        let norms = rows
+            .par_chunks(FOOTPRINT_DIMS)
+            .map(|row| dot(row, row))
+            .collect();
+        Some(FootprintMatrix { rows, norms })
+    }
+
+    pub fn from_schematics<S>(schematics: &[S], spec: &FingerprintSpec) -> Self
+    where
+        S: Borrow<UniversalSchematic> + Sync,
+    {
+        Self::from_rows(footprints_batch(schematics, spec)).expect("batch rows are whole")
+    }
+
+    pub fn len(&self) -> usize {
+        self.norms.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.norms.is_empty()
+    }
+
+    /// The whole `len × FOOTPRINT_DIMS` buffer.
+    pub fn as_slice(&self) -> &[f32] {
+        &self.rows
+    }
+
+    pub fn row(&self, i: usize) -> &[f32] {
+        &self.rows[i * FOOTPRINT_DIMS..][..FOOTPRINT_DIMS]
+    }
+
+    fn distance(&self, i: usize, j: usize) -> f32 {
+        let d2 = self.norms[i] + self.norms[j] - 2.0 * dot(self.row(i), self.row(j));
+        d2.max(0.0).sqrt()
+    }
+
+    /// Distances from each row in `rows` to every row, written row-major
+    /// into `out` (`rows.len() × len`). `None` if `rows` is out of range or
+    /// `out` is the wrong size.
+    pub fn distances(&self, rows: Range<usize>, out: &mut [f32]) -> Option<()> {
+        let n = self.len();
+        if rows.start > rows.end || rows.end > n || out.len() != rows.len() * n {
+            return None;
+        }
+        if n == 0 {
+            return Some(());
+        }
+        let start = rows.start;
+        out.par_chunks_mut(n * ROW_BLOCK)
+            .enumerate()
+            .for_each(|(block, out)| {
+                let first = start + block * ROW_BLOCK;
+                for cols in (0..n).step_by(COL_BLOCK) {
+                    let cols = cols..(cols + COL_BLOCK).min(n);
+                    for (r, out_row) in out.chunks_mut(n).enumerate() {
+                        for j in cols.clone() {
+                            out_row[j] = self.distance(first + r, j);
+                        }
+                    }
+                }
+            });
+        Some(())
+    }
+
+    /// Each row's `k` nearest other rows (itself excluded), nearest first;
+    /// ties go to the lower index.
+    pub fn top_k(&self, k: usize) -> TopK {
+        let n = self.len();
+        let mut indices = vec![u32::MAX; n * k];
+        let mut distances = vec![f32::INFINITY; n * k];
+        if k > 0 {
+            indices
+                .par_chunks_mut(k * ROW_BLOCK)
+                .zip(distances.par_chunks_mut(k * ROW_BLOCK))
+                .enumerate()
+                .for_each(|(block, (out_i, out_d))| {
+                    let first = block * ROW_BLOCK;
+                    let count = out_i.len() / k;
+                    let mut nearest: Vec<Nearest> = (0..count)
+                        .map(|_| Nearest {
+                            k,
+                            items: Vec::with_capacity(k + 1),
+                        })
+                        .collect();
+                    for cols in (0..n).step_by(COL_BLOCK) {
+                        let cols = cols..(cols + COL_BLOCK).min(n);
+                        for (r, near) in nearest.iter_mut().enumerate() {
+                            let i = first + r;
+                            for j in cols.clone().filter(|&j| j != i) {
+                                near.push(self.distance(i, j), j as u32);
+                            }
+                        }
+                    }
+                    for (r, near) in nearest.iter().enumerate() {
+                        for (slot, &(d, j)) in near.items.iter().enumerate() {
+                            out_i[r * k + slot] = j;
+                            out_d[r * k + slot] = d;
+                        }
+                    }
+                });
+        }
+        TopK {
+            k,
+            indices,
+            distances,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::fingerprint::testgen::{filled_box, translated};
+
+    #[test]
+    fn batch_rows_match_single_footprints_and_distances() {
+        let spec = FingerprintSpec::shape();
+        let builds = [
+            filled_box((0, 0, 0), (3, 3, 3), "minecraft:stone"),
+            translated(
+                &filled_box((0, 0, 0), (3, 3, 3), "minecraft:stone"),
+                (9, 1, 4),
+            ),
+            filled_box((0, 0, 0), (9, 1, 1), "minecraft:stone"),
+            filled_box((0, 0, 0), (5, 5, 0), "minecraft:stone"),
+        ];
+        let m = FootprintMatrix::from_schematics(&builds, &spec);
+        assert_eq!(m.len(), 4);
+        for (i, b) in builds.iter().enumerate() {
+            assert_eq!(m.row(i), footprint(b, &spec).0.as_slice());
+        }
+
+        let mut all = vec![0.0; 16];
+        m.distances(0..4, &mut all).unwrap();
+        for i in 0..4 {
+            for j in 0..4 {
+                let exact = footprint(&builds[i], &spec).distance(&footprint(&builds[j], &spec));
+                assert!((all[i * 4 + j] - exact).abs() < 1e-3, "{i},{j}");
+            }
+        }
+        assert!(m.distances(1..5, &mut all).is_none());
+
+        let top = m.top_k(2);
+        // The translated copy is row 0's nearest neighbour and vice versa.
+        assert_eq!(top.indices[0], 1);
+        assert_eq!(top.indices[2], 0);
+        assert!(top.distances[0] < 1e-3);
+        assert!(top.distances[0] <= top.distances[1]);
+
+        let padded = m.top_k(5);
+        assert_eq!(padded.indices[3..5], [u32::MAX, u32::MAX]);
+        assert!(FootprintMatrix::from_rows(vec![0.0; FOOTPRINT_DIMS + 1]).is_none());
+    }
+}
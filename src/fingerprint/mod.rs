@@ -1,23 +1,34 @@
 //! Canonical build fingerprinting: exact `Fingerprint`, invariant `Signature`,
-//! and FFT `Footprint`.
+//! and FFT `Footprint`, with a `FingerprintCatalog` for exact-duplicate lookup,
+//! a `FootprintIndex` for near-duplicate search and a `FootprintMatrix` for
+//! all-pairs distances.
 //!
 //! See `docs/superpowers/specs/2026-06-01-fingerprint-engine-design.md`.
 //!
 //! Submodules are declared as they are implemented (each keeps the crate
 //! compiling on its own commit).
 
+pub mod catalog;
 pub mod classifier;
 pub mod footprint;
+pub mod index;
+pub mod matrix;
 pub mod rulesets;
 pub mod symmetry;
 pub mod voxel;
 
+pub use catalog::{FingerprintCatalog, FrozenCatalog};
 pub use footprint::{footprint, Footprint};
+pub use index::{FootprintIndex, Neighbor};
+pub use matrix::{footprints_batch, FootprintMatrix, TopK};
 
 #[cfg(test)]
 pub(crate) mod testgen;
 
+use rayon::prelude::*;
+
 use crate::block_state::BlockState;
+use crate::block_state_registry::StateId;
 use crate::fingerprint::classifier::{Classifier, Token};
 use crate::fingerprint::symmetry::Symmetry;
 use crate::utils::{NbtMap, NbtValue};
@@ -104,7 +115,7 @@ fn write_nbt_value(out: &mut String, v: &NbtValue) {
             out.push(']');
         }
         NbtValue::Compound(m) => {
-            let mut entries: Vec<(&String, &NbtValue)> = m.iter().collect();
+            let mut entries: Vec<_> = m.iter().collect();
             entries.sort_by(|a, b| a.0.cmp(b.0));
             out.push('{');
             for (k, v) in entries {
@@ -120,10 +131,10 @@ fn write_nbt_value(out: &mut String, v: &NbtValue) {
 
 /// Stable hash token for a block entity's NBT payload, or `None` when there
 /// is no payload beyond positional/id keys (an empty tile-entity record must
-/// fingerprint the same as no record at all). Deterministic across HashMap
-/// iteration orders: top-level and nested compound keys are sorted.
+/// fingerprint the same as no record at all). Deterministic across key
+/// orders: top-level and nested compound keys are sorted.
 pub(crate) fn stable_nbt_token(nbt: &NbtMap, ignore_directional: bool) -> Option<Token> {
-    let mut entries: Vec<(&String, &NbtValue)> = nbt
+    let mut entries: Vec<_> = nbt
         .iter()
         .filter(|(k, _)| !is_positional_key(k))
         .filter(|(k, _)| !(ignore_directional && is_directional_key(k)))
@@ -331,12 +342,44 @@ pub fn signature(schem: &UniversalSchematic, spec: &FingerprintSpec) -> Signatur
     let mut count = 0u32;
     let mut mn = (i32::MAX, i32::MAX, i32::MAX);
     let mut mx = (i32::MIN, i32::MIN, i32::MIN);
-    for (pos, block) in schem.iter_blocks() {
-        if let Some(tok) = spec.blocks.tokenize(block) {
-            *histogram.entry(tok).or_default() += 1;
-            count += 1;
-            mn = (mn.0.min(pos.x), mn.1.min(pos.y), mn.2.min(pos.z));
-            mx = (mx.0.max(pos.x), mx.1.max(pos.y), mx.2.max(pos.z));
+    for region in std::iter::once(&schem.default_region).chain(schem.other_regions.values()) {
+        // Tokenize each palette entry once, then count cells by palette
+        // index: no per-cell string work.
+        let tokens: Vec<Option<Token>> = region
+            .palette
+            .iter()
+            .map(|block| spec.blocks.tokenize(block))
+            .collect();
+        let mut counts = vec![0u64; tokens.len()];
+        region.blocks.histogram(&mut counts);
+        let mut kept = 0u32;
+        let mut dropped_non_air = false;
+        for (index, (tok, &n)) in tokens.iter().zip(&counts).enumerate() {
+            match tok {
+                Some(tok) if n > 0 => {
+                    *histogram.entry(tok.clone()).or_default() += n as u32;
+                    kept += n as u32;
+                }
+                None if n > 0 && index != region.air_index() => dropped_non_air = true,
+                _ => {}
+            }
+        }
+        if kept == 0 {
+            continue;
+        }
+        count += kept;
+        // When only air is dropped, the kept cells are the non-air ones and
+        // the walk can stay inside the region's tight bounds.
+        let cells: Box<dyn Iterator<Item = ((i32, i32, i32), usize)>> = if dropped_non_air {
+            Box::new(region.iter_cells())
+        } else {
+            Box::new(region.cells_ne(region.air_index()))
+        };
+        for ((x, y, z), index) in cells {
+            if tokens[index].is_some() {
+                mn = (mn.0.min(x), mn.1.min(y), mn.2.min(z));
+                mx = (mx.0.max(x), mx.1.max(y), mx.2.max(z));
+            }
         }
     }
     let mut dims = if count == 0 {
@@ -425,10 +468,10 @@ pub fn fingerprint(schem: &UniversalSchematic, spec: &FingerprintSpec) -> Finger
     // Resolve the palette once — builds repeat blockstates heavily, so each
     // orbit element only tokenizes the distinct entries, not every cell.
     let mut palette: Vec<&BlockState> = Vec::new();
-    let mut index: HashMap<&BlockState, usize> = HashMap::new();
+    let mut index: HashMap<StateId, usize> = HashMap::new();
     let mut cell_list: Vec<((i32, i32, i32), usize)> = Vec::new();
-    for (pos, block) in schem.iter_blocks() {
-        let id = *index.entry(block).or_insert_with(|| {
+    for (pos, state_id, block) in schem.iter_blocks_with_ids() {
+        let id = *index.entry(state_id).or_insert_with(|| {
             palette.push(block);
             palette.len() - 1
         });
@@ -464,40 +507,40 @@ pub fn fingerprint(schem: &UniversalSchematic, spec: &FingerprintSpec) -> Finger
         }
     }
 
-    let mut best: Option<Vec<u8>> = None;
-    for g in spec.symmetry.elements() {
-        let toks: Vec<Option<Token>> = palette
-            .iter()
-            .map(|b| spec.blocks.tokenize(&g.apply_block(b)))
-            .collect();
-        let mut cells: Vec<((i32, i32, i32), Token)> = Vec::with_capacity(cell_list.len());
-        for (pos, id) in &cell_list {
-            if let Some(tok) = &toks[*id] {
-                let tok = match nbt_by_pos.get(pos) {
-                    Some(nbt) => token_with_nbt(tok, nbt),
-                    None => tok.clone(),
-                };
-                cells.push((g.apply_pos(*pos), tok));
+    // Orbit elements serialize independently on the rayon pool; the
+    // canonical form is the smallest serialization, whichever finds it.
+    let best = elements
+        .par_iter()
+        .filter_map(|g| {
+            let toks: Vec<Option<Token>> = palette
+                .iter()
+                .map(|b| spec.blocks.tokenize(&g.apply_block(b)))
+                .collect();
+            let mut cells: Vec<((i32, i32, i32), Token)> = Vec::with_capacity(cell_list.len());
+            for (pos, id) in &cell_list {
+                if let Some(tok) = &toks[*id] {
+                    let tok = match nbt_by_pos.get(pos) {
+                        Some(nbt) => token_with_nbt(tok, nbt),
+                        None => tok.clone(),
+                    };
+                    cells.push((g.apply_pos(*pos), tok));
+                }
             }
-        }
-        if cells.is_empty() {
-            continue;
-        }
-        let mn = cells
-            .iter()
-            .fold((i32::MAX, i32::MAX, i32::MAX), |m, (p, _)| {
-                (m.0.min(p.0), m.1.min(p.1), m.2.min(p.2))
-            });
-        for (p, _) in cells.iter_mut() {
-            *p = (p.0 - mn.0, p.1 - mn.1, p.2 - mn.2);
-        }
-        cells.sort();
-        let ser = serialize_cells(&cells);
-        best = Some(match best {
-            Some(cur) if cur <= ser => cur,
-            _ => ser,
-        });
-    }
+            if cells.is_empty() {
+                return None;
+            }
+            let mn = cells
+                .iter()
+                .fold((i32::MAX, i32::MAX, i32::MAX), |m, (p, _)| {
+                    (m.0.min(p.0), m.1.min(p.1), m.2.min(p.2))
+                });
+            for (p, _) in cells.iter_mut() {
+                *p = (p.0 - mn.0, p.1 - mn.1, p.2 - mn.2);
+            }
+            cells.sort();
+            Some(serialize_cells(&cells))
+        })
+        .min();
     let bytes = best.unwrap_or_default();
     let hash = blake3::hash(&bytes);
     let mut buf = [0u8; 16];
@@ -543,7 +586,7 @@ fn fingerprint_single_orbit(
 
     let ignore_directional = spec.symmetry != Symmetry::None;
 
-    let mut index: HashMap<&BlockState, u32> = HashMap::new();
+    let mut index: HashMap<StateId, u32> = HashMap::new();
     // Token per palette entry under `g` (`None` = air / ignored, cell dropped).
     let mut toks: Vec<Option<Token>> = Vec::new();
 
@@ -553,8 +596,8 @@ fn fingerprint_single_orbit(
     let mut nbt_tokens: Vec<Token> = Vec::new();
 
     let mut cells: Vec<(i32, i32, i32, u32, u32)> = Vec::new();
-    for (pos, block) in schem.iter_blocks() {
-        let id = *index.entry(block).or_insert_with(|| {
+    for (pos, state_id, block) in schem.iter_blocks_with_ids() {
+        let id = *index.entry(state_id).or_insert_with(|| {
             toks.push(spec.blocks.tokenize(&g.apply_block(block)));
             (toks.len() - 1) as u32
         });
@@ -670,6 +713,19 @@ mod signature_tests {
         let spec = FingerprintSpec::structural();
         assert_eq!(signature(&a, &spec), signature(&b, &spec));
     }
+
+    #[test]
+    fn signature_bounds_skip_dropped_non_air_cells() {
+        // cave_air is a non-air palette entry that every policy drops, so
+        // the tight bounds over-cover the kept cells.
+        let mut a = filled_box((0, 0, 0), (1, 0, 0), "minecraft:stone");
+        a.set_block_str(9, 7, 5, "minecraft:cave_air");
+        a.set_block_str(0, 3, 0, "minecraft:glass");
+        let sig = signature(&a, &FingerprintSpec::exact());
+        assert_eq!(sig.count, 3);
+        assert_eq!(sig.dims_sorted, [1, 2, 4]);
+        assert_eq!(sig.histogram.values().sum::<u32>(), 3);
+    }
 }
 
 #[cfg(test)]
@@ -79,6 +79,11 @@ impl RigidOp {
         RigidOp { steps: vec![] }
     }
 
+    /// True when the operation moves nothing.
+    pub fn is_identity(&self) -> bool {
+        self.steps.is_empty()
+    }
+
     pub fn apply_pos(&self, p: Pos) -> Pos {
         self.steps.iter().fold(p, |acc, s| match *s {
             Step::Rotate(a, d) => rot_pos(acc, a, d),
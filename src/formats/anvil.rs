@@ -1,21 +1,30 @@
 use crate::block_entity::BlockEntity;
 use crate::entity::Entity;
 use crate::formats::error::Result;
+use crate::formats::lz4_block;
+use crate::formats::packed_longs::{self, Layout};
+use crate::nbt::{view as nbt_view, Endian};
 use crate::BlockState;
 use flate2::read::{GzDecoder, ZlibDecoder};
-use flate2::write::ZlibEncoder;
+use flate2::write::{GzEncoder, ZlibEncoder};
 use flate2::Compression;
 use quartz_nbt::io::Flavor;
 use quartz_nbt::{NbtCompound, NbtList, NbtTag};
+use serde::{Deserialize, Serialize};
+use std::cell::Cell;
 use std::io::{Cursor, Read, Seek, SeekFrom, Write};
+use std::ops::Range;
+use std::sync::Arc;
 
 // ─── Data Structures ────────────────────────────────────────────────────────
 
-#[derive(Debug, Clone, Copy, PartialEq)]
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
 pub enum CompressionType {
     Gzip = 1,
     Zlib = 2,
     Uncompressed = 3,
+    /// lz4-java block stream, readable by Minecraft 1.20.5+.
     Lz4 = 4,
 }
 
@@ -25,12 +34,49 @@ impl CompressionType {
             1 => Ok(CompressionType::Gzip),
             2 => Ok(CompressionType::Zlib),
             3 => Ok(CompressionType::Uncompressed),
-            4 => Err("LZ4 compression (type 4) is not supported".into()),
+            4 => Ok(CompressionType::Lz4),
             _ => Err(format!("Unknown compression type: {}", b).into()),
         }
     }
 }
 
+/// How chunks are compressed when a region file is written.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct ChunkCompression {
+    pub codec: CompressionType,
+    /// Deflate level for zlib and gzip; the other codecs ignore it.
+    pub level: Compression,
+}
+
+impl Default for ChunkCompression {
+    /// Zlib at the default level, as vanilla writes.
+    fn default() -> Self {
+        ChunkCompression {
+            codec: CompressionType::Zlib,
+            level: Compression::default(),
+        }
+    }
+}
+
+impl ChunkCompression {
+    fn compress(&self, data: &[u8]) -> Result<Vec<u8>> {
+        Ok(match self.codec {
+            CompressionType::Zlib => {
+                let mut encoder = ZlibEncoder::new(Vec::new(), self.level);
+                encoder.write_all(data)?;
+                encoder.finish()?
+            }
+            CompressionType::Gzip => {
+                let mut encoder = GzEncoder::new(Vec::new(), self.level);
+                encoder.write_all(data)?;
+                encoder.finish()?
+            }
+            CompressionType::Uncompressed => data.to_vec(),
+            CompressionType::Lz4 => lz4_block::compress(data),
+        })
+    }
+}
+
 #[derive(Debug, Clone)]
 pub struct ChunkSection {
     pub y: i8,
@@ -55,6 +101,60 @@ pub struct ChunkData {
     pub entities: Vec<Entity>,
     /// Minimum section Y (e.g. -4 for overworld 1.18+)
     pub y_pos: i32,
+    /// The `Heightmaps` compound as stored in the chunk, or None for chunks
+    /// built in memory. Writers always recompute heightmaps.
+    pub heightmaps: Option<NbtCompound>,
+}
+
+/// Which parts of a chunk to decode. The default decodes everything; any
+/// other projection walks the NBT without building the tags it drops.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ChunkProjection {
+    /// Keep only sections overlapping this inclusive block Y range.
+    pub y_range: Option<(i32, i32)>,
+    pub block_entities: bool,
+    /// Entities stored in the chunk itself and, for world streams, in the
+    /// region's `entities/` file.
+    pub entities: bool,
+    pub biomes: bool,
+}
+
+impl Default for ChunkProjection {
+    fn default() -> Self {
+        ChunkProjection {
+            y_range: None,
+            block_entities: true,
+            entities: true,
+            biomes: true,
+        }
+    }
+}
+
+impl ChunkProjection {
+    /// Block states only: no block entities, entities or biomes.
+    pub fn blocks_only() -> Self {
+        ChunkProjection {
+            y_range: None,
+            block_entities: false,
+            entities: false,
+            biomes: false,
+        }
+    }
+
+    pub fn with_y_range(mut self, min_y: i32, max_y: i32) -> Self {
+        self.y_range = Some((min_y, max_y));
+        self
+    }
+
+    pub fn is_full(&self) -> bool {
+        *self == Self::default()
+    }
+
+    fn keeps_section(&self, y: i8) -> bool {
+        let base = y as i32 * 16;
+        self.y_range
+            .is_none_or(|(min_y, max_y)| base + 15 >= min_y && base <= max_y)
+    }
 }
 
 #[derive(Debug, Clone)]
@@ -141,17 +241,31 @@ pub fn is_mca(data: &[u8]) -> bool {
 impl McaFile {
     /// Parse an MCA region file from raw bytes.
     pub fn from_bytes(data: &[u8], region_x: i32, region_z: i32) -> Result<Self> {
+        Self::from_bytes_where(data, region_x, region_z, |_, _| true)
+    }
+
+    /// Parse an MCA region file, decoding only the chunks for which
+    /// `keep(chunk_x, chunk_z)` holds; the others stay `None`. Off wasm the
+    /// chunks decompress and parse in parallel. The result, including which
+    /// error is returned, does not depend on scheduling.
+    pub fn from_bytes_where(
+        data: &[u8],
+        region_x: i32,
+        region_z: i32,
+        keep: impl Fn(i32, i32) -> bool + Sync,
+    ) -> Result<Self> {
         if data.len() < 8192 {
             return Err("MCA file too small (< 8192 bytes)".into());
         }
 
-        let mut chunks = Vec::with_capacity(1024);
-        for _ in 0..1024 {
-            chunks.push(None);
-        }
+        let decode = |i: u32| -> Result<Option<ChunkData>> {
+            let chunk_x = (region_x * 32) + ((i % 32) as i32);
+            let chunk_z = (region_z * 32) + ((i / 32) as i32);
+            if !keep(chunk_x, chunk_z) {
+                return Ok(None);
+            }
 
-        // Parse location table (first 4096 bytes)
-        for i in 0..1024u32 {
+            // Parse location table (first 4096 bytes)
             let offset = (i as usize) * 4;
             let loc_offset = ((data[offset] as u32) << 16)
                 | ((data[offset + 1] as u32) << 8)
@@ -159,12 +273,12 @@ impl McaFile {
             let sector_count = data[offset + 3] as u32;
 
             if loc_offset < 2 || sector_count == 0 {
-                continue;
+                return Ok(None);
             }
 
             let byte_offset = (loc_offset as usize) * 4096;
             if byte_offset + 5 > data.len() {
-                continue;
+                return Ok(None);
             }
 
             // Read chunk header: 4-byte length + 1-byte compression type
@@ -174,7 +288,7 @@ impl McaFile {
                 | (data[byte_offset + 3] as u32);
 
             if chunk_len <= 1 {
-                continue;
+                return Ok(None);
             }
 
             let compression_byte = data[byte_offset + 4];
@@ -183,32 +297,27 @@ impl McaFile {
             let compressed_start = byte_offset + 5;
             let compressed_len = (chunk_len as usize) - 1;
             if compressed_start + compressed_len > data.len() {
-                continue;
+                return Ok(None);
             }
 
             let compressed_data = &data[compressed_start..compressed_start + compressed_len];
 
-            // Decompress
-            let decompressed = decompress_chunk(compressed_data, compression)?;
+            let nbt = decode_chunk_nbt(compressed_data, compression)?;
 
-            // Parse NBT
-            let (nbt, _) =
-                quartz_nbt::io::read_nbt(&mut Cursor::new(&decompressed), Flavor::Uncompressed)?;
+            // Skip malformed chunks
+            Ok(parse_chunk_nbt(&nbt, chunk_x, chunk_z).ok())
+        };
 
-            // Parse chunk data
-            let chunk_x = (region_x * 32) + ((i % 32) as i32);
-            let chunk_z = (region_z * 32) + ((i / 32) as i32);
+        #[cfg(not(target_arch = "wasm32"))]
+        let slots: Vec<Result<Option<ChunkData>>> = {
+            use rayon::prelude::*;
+            (0..1024u32).into_par_iter().map(decode).collect()
+        };
+        #[cfg(target_arch = "wasm32")]
+        let slots: Vec<Result<Option<ChunkData>>> = (0..1024u32).map(decode).collect();
 
-            match parse_chunk_nbt(&nbt, chunk_x, chunk_z) {
-                Ok(chunk) => {
-                    chunks[i as usize] = Some(chunk);
-                }
-                Err(_e) => {
-                    // Skip malformed chunks
-                    continue;
-                }
-            }
-        }
+        // The first failing slot wins, as in a sequential scan.
+        let chunks = slots.into_iter().collect::<Result<Vec<_>>>()?;
 
         Ok(McaFile {
             chunks,
@@ -271,16 +380,13 @@ impl McaFile {
                 Err(_) => continue,
             };
 
-            let (nbt, _) = match quartz_nbt::io::read_nbt(
-                &mut Cursor::new(&decompressed),
-                Flavor::Uncompressed,
-            ) {
-                Ok(r) => r,
-                Err(_) => continue,
+            // Only xPos/zPos are needed: view the chunk instead of parsing it.
+            let Ok((_, nbt)) = nbt_view::root(&decompressed, Endian::Big) else {
+                continue;
             };
 
             // Try to get xPos/zPos from chunk NBT
-            if let (Ok(cx), Ok(cz)) = (nbt.get::<_, i32>("xPos"), nbt.get::<_, i32>("zPos")) {
+            if let (Some(cx), Some(cz)) = (nbt.get_i32("xPos"), nbt.get_i32("zPos")) {
                 region_x = floor_div(cx, 32);
                 region_z = floor_div(cz, 32);
                 found = true;
@@ -300,23 +406,57 @@ impl McaFile {
 
 fn decompress_chunk(data: &[u8], compression: CompressionType) -> Result<Vec<u8>> {
     let mut decompressed = Vec::new();
+    decompress_chunk_into(data, compression, &mut decompressed)?;
+    Ok(decompressed)
+}
+
+fn decompress_chunk_into(
+    data: &[u8],
+    compression: CompressionType,
+    out: &mut Vec<u8>,
+) -> Result<()> {
     match compression {
         CompressionType::Zlib => {
-            let mut decoder = ZlibDecoder::new(data);
-            decoder.read_to_end(&mut decompressed)?;
+            ZlibDecoder::new(data).read_to_end(out)?;
         }
         CompressionType::Gzip => {
-            let mut decoder = GzDecoder::new(data);
-            decoder.read_to_end(&mut decompressed)?;
-        }
-        CompressionType::Uncompressed => {
-            decompressed = data.to_vec();
-        }
-        CompressionType::Lz4 => {
-            return Err("LZ4 compression is not supported".into());
+            GzDecoder::new(data).read_to_end(out)?;
         }
+        CompressionType::Uncompressed => out.extend_from_slice(data),
+        CompressionType::Lz4 => lz4_block::decompress_into(data, out)?,
     }
-    Ok(decompressed)
+    Ok(())
+}
+
+/// Scratch capacity kept between chunks. Most chunks decompress to well
+/// under this; a rare huge one is freed rather than pinned per thread.
+const CHUNK_SCRATCH_KEEP: usize = 4 << 20;
+
+thread_local! {
+    /// Per-thread decompression arena: cleared, not freed, between chunks,
+    /// so a worker decoding a region reuses one buffer for all its chunks.
+    static CHUNK_SCRATCH: Cell<Vec<u8>> = const { Cell::new(Vec::new()) };
+}
+
+/// Run `f` on the decompressed chunk without allocating a buffer per call:
+/// uncompressed payloads are borrowed as-is, the rest decompress into the
+/// thread's scratch arena. The arena is taken out for the call, so a nested
+/// call just starts a fresh one.
+fn with_decompressed<T>(
+    data: &[u8],
+    compression: CompressionType,
+    f: impl FnOnce(&[u8]) -> Result<T>,
+) -> Result<T> {
+    if compression == CompressionType::Uncompressed {
+        return f(data);
+    }
+    let mut scratch = CHUNK_SCRATCH.take();
+    scratch.clear();
+    let result = decompress_chunk_into(data, compression, &mut scratch).and_then(|()| f(&scratch));
+    if scratch.capacity() <= CHUNK_SCRATCH_KEEP {
+        CHUNK_SCRATCH.set(scratch);
+    }
+    result
 }
 
 fn parse_chunk_nbt(nbt: &NbtCompound, chunk_x: i32, chunk_z: i32) -> Result<ChunkData> {
@@ -377,9 +517,75 @@ fn parse_chunk_nbt(nbt: &NbtCompound, chunk_x: i32, chunk_z: i32) -> Result<Chun
         block_entities,
         entities,
         y_pos,
+        heightmaps: nbt.get::<_, &NbtCompound>("Heightmaps").ok().cloned(),
     })
 }
 
+/// Parse uncompressed chunk NBT, keeping only what `projection` asks for.
+/// The chunk is viewed in place: dropped tags, light arrays and heightmaps
+/// are stepped over without being built, and the kept ones go through
+/// `parse_chunk_nbt` as usual.
+fn parse_chunk_projected(
+    data: &[u8],
+    chunk_x: i32,
+    chunk_z: i32,
+    projection: &ChunkProjection,
+) -> Result<ChunkData> {
+    let (_, chunk) = nbt_view::root(data, Endian::Big)?;
+    let mut root = NbtCompound::new();
+    for (name, tag) in chunk.iter() {
+        let keep = match (tag.type_id(), name.as_str().unwrap_or_default()) {
+            (9, "sections") => {
+                let sections: Vec<NbtTag> = match tag.as_list() {
+                    Some(list) => list
+                        .compounds()
+                        .filter_map(|section| {
+                            read_section_projected(&section, projection).transpose()
+                        })
+                        .collect::<Result<_>>()?,
+                    None => Vec::new(),
+                };
+                root.insert("sections", NbtTag::List(NbtList::from(sections)));
+                continue;
+            }
+            (_, "DataVersion" | "Status" | "xPos" | "zPos" | "yPos" | "Heightmaps") => true,
+            (_, "block_entities") => projection.block_entities,
+            (_, "Entities") => projection.entities,
+            _ => false,
+        };
+        if keep {
+            root.insert(name.to_str()?.into_owned(), tag.to_value()?.to_quartz_nbt());
+        }
+    }
+    parse_chunk_nbt(&root, chunk_x, chunk_z)
+}
+
+/// Build one section compound, or `None` when `projection` drops it (or it
+/// has no `Y`, which `parse_section` would reject anyway). Dropped sections
+/// are never built, wherever `Y` sits among their tags.
+fn read_section_projected(
+    section: &nbt_view::CompoundView<'_>,
+    projection: &ChunkProjection,
+) -> Result<Option<NbtTag>> {
+    let Some(y) = section.get("Y").and_then(|y| y.as_i8()) else {
+        return Ok(None);
+    };
+    if !projection.keeps_section(y) {
+        return Ok(None);
+    }
+    let mut out = NbtCompound::new();
+    out.insert("Y", NbtTag::Byte(y));
+    for key in ["block_states", "biomes"] {
+        if key == "biomes" && !projection.biomes {
+            continue;
+        }
+        if let Some(value) = section.get(key) {
+            out.insert(key, value.to_value()?.to_quartz_nbt());
+        }
+    }
+    Ok(Some(NbtTag::Compound(out)))
+}
+
 fn parse_section(section_nbt: &NbtCompound) -> Result<ChunkSection> {
     let y = section_nbt.get::<_, i8>("Y")?;
 
@@ -445,29 +651,11 @@ pub fn single_biome_compound(biome: &str) -> NbtCompound {
 /// CRITICAL: Entries do NOT span across long boundaries (unlike Litematic).
 /// Each i64 holds floor(64/bits_per_entry) entries, minimum 4 bits per entry.
 pub fn unpack_block_states(packed: &[i64], palette_size: usize) -> Vec<u16> {
-    let bits_per_entry = std::cmp::max(
-        (palette_size as f64).log2().ceil() as u32,
-        4, // Minecraft minimum is 4 bits per entry for chunk sections
-    );
-
-    let entries_per_long = 64 / bits_per_entry;
-    let mask = (1u64 << bits_per_entry) - 1;
-
-    let mut result = Vec::with_capacity(4096);
-
-    for &long_val in packed {
-        let long_unsigned = long_val as u64;
-        for j in 0..entries_per_long {
-            if result.len() >= 4096 {
-                break;
-            }
-            let index = (long_unsigned >> (j * bits_per_entry)) & mask;
-            result.push(index as u16);
-        }
-    }
-
-    // Pad with 0 if we somehow have fewer than 4096
-    result.resize(4096, 0);
+    // Minecraft minimum is 4 bits per entry for chunk sections
+    let bits_per_entry = packed_longs::bits_for(palette_size, 4);
+    // Missing longs leave 0
+    let mut result = vec![0u16; 4096];
+    packed_longs::unpack(packed, bits_per_entry, Layout::Aligned, &mut result);
     result
 }
 
@@ -478,21 +666,19 @@ pub fn pack_block_states(indices: &[u16], palette_size: usize) -> Vec<i64> {
         return Vec::new();
     }
 
-    let bits_per_entry = std::cmp::max((palette_size as f64).log2().ceil() as u32, 4);
-
-    let entries_per_long = 64 / bits_per_entry;
-    let num_longs = 4096_usize.div_ceil(entries_per_long as usize);
-    let mask = (1u64 << bits_per_entry) - 1;
-
-    let mut packed = vec![0i64; num_longs];
-
-    for (i, &index) in indices.iter().enumerate().take(4096) {
-        let long_index = i / entries_per_long as usize;
-        let bit_offset = (i % entries_per_long as usize) as u32 * bits_per_entry;
-        let value = (index as u64) & mask;
-        packed[long_index] |= (value << bit_offset) as i64;
-    }
-
+    let bits_per_entry = packed_longs::bits_for(palette_size, 4);
+    let mut packed = Vec::new();
+    packed_longs::pack(
+        &indices[..indices.len().min(4096)],
+        bits_per_entry,
+        Layout::Aligned,
+        &mut packed,
+    );
+    // Short input still yields a full section's worth of longs
+    packed.resize(
+        packed_longs::packed_len(4096, bits_per_entry, Layout::Aligned),
+        0,
+    );
     packed
 }
 
@@ -582,17 +768,11 @@ pub fn parse_entity_mca(data: &[u8], region_x: i32, region_z: i32) -> Result<Vec
         }
 
         let compressed_data = &data[compressed_start..compressed_start + compressed_len];
-        let decompressed = match decompress_chunk(compressed_data, compression) {
-            Ok(d) => d,
+        let nbt = match decode_chunk_nbt(compressed_data, compression) {
+            Ok(nbt) => nbt,
             Err(_) => continue,
         };
 
-        let (nbt, _) =
-            match quartz_nbt::io::read_nbt(&mut Cursor::new(&decompressed), Flavor::Uncompressed) {
-                Ok(r) => r,
-                Err(_) => continue,
-            };
-
         // Entity chunk NBT: Position is int array [chunkX, chunkZ]
         let (chunk_x, chunk_z) = if let Ok(pos) = nbt.get::<_, &[i32]>("Position") {
             if pos.len() >= 2 {
@@ -649,10 +829,27 @@ fn build_entity_chunk_nbt(chunk: &EntityChunkData, data_version: i32) -> NbtComp
 
 /// Write entity chunks to an MCA file (entities/r.x.z.mca format).
 pub fn write_entity_mca(
+    chunks: &[EntityChunkData],
+    region_x: i32,
+    region_z: i32,
+    data_version: i32,
+) -> Result<Vec<u8>> {
+    write_entity_mca_with(
+        chunks,
+        region_x,
+        region_z,
+        data_version,
+        ChunkCompression::default(),
+    )
+}
+
+/// Write entity chunks to an MCA file, compressing each with `compression`.
+pub fn write_entity_mca_with(
     chunks: &[EntityChunkData],
     _region_x: i32,
     _region_z: i32,
     data_version: i32,
+    compression: ChunkCompression,
 ) -> Result<Vec<u8>> {
     let mut chunk_data_parts: Vec<(u32, Vec<u8>)> = Vec::new();
 
@@ -665,11 +862,7 @@ pub fn write_entity_mca(
         let mut nbt_bytes = Vec::new();
         quartz_nbt::io::write_nbt(&mut nbt_bytes, None, &nbt, Flavor::Uncompressed)?;
 
-        let mut encoder = ZlibEncoder::new(Vec::new(), Compression::default());
-        encoder.write_all(&nbt_bytes)?;
-        let compressed = encoder.finish()?;
-
-        chunk_data_parts.push((index, compressed));
+        chunk_data_parts.push((index, compression.compress(&nbt_bytes)?));
     }
 
     // Sort by index for deterministic output
@@ -698,7 +891,7 @@ pub fn write_entity_mca(
         chunk_sector.push(((chunk_payload_len >> 16) & 0xFF) as u8);
         chunk_sector.push(((chunk_payload_len >> 8) & 0xFF) as u8);
         chunk_sector.push((chunk_payload_len & 0xFF) as u8);
-        chunk_sector.push(2); // zlib
+        chunk_sector.push(compression.codec as u8);
         chunk_sector.extend_from_slice(compressed);
 
         let padded_len = sector_count * 4096;
@@ -721,21 +914,33 @@ pub fn write_entity_mca(
 impl McaFile {
     /// Write the MCA file to bytes.
     pub fn to_bytes(&self) -> Result<Vec<u8>> {
-        let mut chunk_data_parts: Vec<(u32, Vec<u8>)> = Vec::new(); // (index, compressed_nbt)
-
-        for (i, chunk_opt) in self.chunks.iter().enumerate() {
-            if let Some(chunk) = chunk_opt {
-                let nbt = build_chunk_nbt(chunk);
-                let mut nbt_bytes = Vec::new();
-                quartz_nbt::io::write_nbt(&mut nbt_bytes, None, &nbt, Flavor::Uncompressed)?;
+        self.to_bytes_with(ChunkCompression::default())
+    }
 
-                // Compress with zlib
-                let mut encoder = ZlibEncoder::new(Vec::new(), Compression::default());
-                encoder.write_all(&nbt_bytes)?;
-                let compressed = encoder.finish()?;
+    /// Write the MCA file to bytes, compressing each chunk with `compression`.
+    pub fn to_bytes_with(&self, compression: ChunkCompression) -> Result<Vec<u8>> {
+        let encode =
+            |(i, chunk_opt): (usize, &Option<ChunkData>)| -> Result<Option<(u32, Vec<u8>)>> {
+                let Some(chunk) = chunk_opt else {
+                    return Ok(None);
+                };
+                Ok(Some((i as u32, encode_chunk(chunk, compression)?)))
+            };
 
-                chunk_data_parts.push((i as u32, compressed));
-            }
+        // Chunks compress independently; sectors are laid out in order below.
+        #[cfg(not(target_arch = "wasm32"))]
+        let slots: Vec<Result<Option<(u32, Vec<u8>)>>> = {
+            use rayon::prelude::*;
+            self.chunks.par_iter().enumerate().map(encode).collect()
+        };
+        #[cfg(target_arch = "wasm32")]
+        let slots: Vec<Result<Option<(u32, Vec<u8>)>>> =
+            self.chunks.iter().enumerate().map(encode).collect();
+
+        // (index, compressed_nbt)
+        let mut chunk_data_parts: Vec<(u32, Vec<u8>)> = Vec::new();
+        for slot in slots {
+            chunk_data_parts.extend(slot?);
         }
 
         // Build the file: 8KiB header + chunk sectors
@@ -766,8 +971,8 @@ impl McaFile {
             chunk_sector.push(((chunk_payload_len >> 16) & 0xFF) as u8);
             chunk_sector.push(((chunk_payload_len >> 8) & 0xFF) as u8);
             chunk_sector.push((chunk_payload_len & 0xFF) as u8);
-            // Compression type (2 = zlib)
-            chunk_sector.push(2);
+            // Compression type
+            chunk_sector.push(compression.codec as u8);
             // Compressed data
             chunk_sector.extend_from_slice(compressed);
 
@@ -789,6 +994,15 @@ impl McaFile {
     }
 }
 
+/// Serialize and compress one chunk's NBT, as stored after its five-byte
+/// record header in a region file.
+pub fn encode_chunk(chunk: &ChunkData, compression: ChunkCompression) -> Result<Vec<u8>> {
+    let nbt = build_chunk_nbt(chunk);
+    let mut nbt_bytes = Vec::new();
+    quartz_nbt::io::write_nbt(&mut nbt_bytes, None, &nbt, Flavor::Uncompressed)?;
+    compression.compress(&nbt_bytes)
+}
+
 fn build_chunk_nbt(chunk: &ChunkData) -> NbtCompound {
     let mut root = NbtCompound::new();
 
@@ -827,9 +1041,53 @@ fn build_chunk_nbt(chunk: &ChunkData) -> NbtCompound {
 }
 
 fn compute_heightmaps(chunk: &ChunkData) -> NbtCompound {
+    let heights = surface_heights(chunk);
+    let mut heightmaps = NbtCompound::new();
+    heightmaps.insert(
+        "MOTION_BLOCKING",
+        NbtTag::LongArray(pack_heightmap(&heights)),
+    );
+    heightmaps.insert("WORLD_SURFACE", NbtTag::LongArray(pack_heightmap(&heights)));
+    heightmaps
+}
+
+/// One heightmap of `chunk`, as 256 values in `z * 16 + x` order, each the
+/// number of blocks from the chunk's bottom up to and including the highest
+/// counted block (0 for an empty column). Stored heightmaps are decoded;
+/// without them `MOTION_BLOCKING` and `WORLD_SURFACE` are computed from the
+/// sections, counting every non-air block.
+pub fn heightmap_values(chunk: &ChunkData, name: &str) -> Option<Vec<i32>> {
+    if let Some(stored) = &chunk.heightmaps {
+        let packed = stored.get::<_, &[i64]>(name).ok()?;
+        // 1.16 (data version 2566) stopped entries spanning longs.
+        let layout = if chunk.data_version >= 2566 {
+            Layout::Aligned
+        } else {
+            Layout::Spanning
+        };
+        // Entries are wide enough for the world height, which the chunk does
+        // not record. Guess it from the sections; several widths share an
+        // array length when entries do not span longs.
+        let fits = |bits: usize| packed_longs::packed_len(256, bits, layout) == packed.len();
+        let top = chunk.sections.iter().map(|s| s.y as i32 + 1).max();
+        let height = top.map_or(0, |top| (top - chunk.y_pos).max(0) * 16) as usize;
+        let guess = packed_longs::bits_for(height + 1, 1);
+        let bits = if fits(guess) {
+            guess
+        } else {
+            (1..=32).find(|&bits| fits(bits))?
+        };
+        let mut values = vec![0u32; 256];
+        packed_longs::unpack(packed, bits, layout, &mut values);
+        return Some(values.into_iter().map(|v| v as i32).collect());
+    }
+    matches!(name, "MOTION_BLOCKING" | "WORLD_SURFACE").then(|| surface_heights(chunk))
+}
+
+/// Height above the chunk's bottom of each column's highest non-air block.
+fn surface_heights(chunk: &ChunkData) -> Vec<i32> {
     let world_min_y = chunk.y_pos * 16;
-    let mut motion_blocking = vec![0i32; 256];
-    let mut world_surface = vec![0i32; 256];
+    let mut heights = vec![0i32; 256];
 
     // Sort sections by Y descending so we scan from top down
     let mut sorted_sections: Vec<&ChunkSection> = chunk.sections.iter().collect();
@@ -853,44 +1111,22 @@ fn compute_heightmaps(chunk: &ChunkData) -> NbtCompound {
                         "minecraft:air" | "minecraft:cave_air" | "minecraft:void_air"
                     ) {
                         let world_y = section_base_y + ly;
-                        let hm_value = world_y - world_min_y + 1;
-                        motion_blocking[col_idx] = hm_value;
-                        world_surface[col_idx] = hm_value;
+                        heights[col_idx] = world_y - world_min_y + 1;
                         break 'outer;
                     }
                 }
             }
         }
     }
-
-    let mut heightmaps = NbtCompound::new();
-    heightmaps.insert(
-        "MOTION_BLOCKING",
-        NbtTag::LongArray(pack_heightmap(&motion_blocking)),
-    );
-    heightmaps.insert(
-        "WORLD_SURFACE",
-        NbtTag::LongArray(pack_heightmap(&world_surface)),
-    );
-    heightmaps
+    heights
 }
 
 /// Pack 256 heightmap values into a long array (9 bits per entry, entries don't span longs).
 fn pack_heightmap(values: &[i32]) -> Vec<i64> {
-    let bits_per_entry: usize = 9;
-    let entries_per_long = 64 / bits_per_entry; // 7
-    let num_longs = 256_usize.div_ceil(entries_per_long); // 37
-    let mask = (1u64 << bits_per_entry) - 1;
-
-    let mut packed = vec![0i64; num_longs];
-
-    for (i, &value) in values.iter().enumerate().take(256) {
-        let long_index = i / entries_per_long;
-        let bit_offset = (i % entries_per_long) * bits_per_entry;
-        let v = (value as u64) & mask;
-        packed[long_index] |= (v << bit_offset) as i64;
-    }
-
+    let values: Vec<u32> = values.iter().take(256).map(|&v| v as u32).collect();
+    let mut packed = Vec::new();
+    packed_longs::pack(&values, 9, Layout::Aligned, &mut packed);
+    packed.resize(packed_longs::packed_len(256, 9, Layout::Aligned), 0);
     packed
 }
 
@@ -943,21 +1179,11 @@ impl<R: Read + Seek> RegionReader<R> {
         reader
             .read_exact(&mut header)
             .map_err(|_| "MCA file too small (< 4096 byte header)")?;
-        let mut locations = Vec::new();
-        for i in 0..1024u32 {
-            let o = (i as usize) * 4;
-            let loc =
-                ((header[o] as u32) << 16) | ((header[o + 1] as u32) << 8) | (header[o + 2] as u32);
-            let sector_count = header[o + 3];
-            if loc >= 2 && sector_count > 0 {
-                locations.push((i, (loc as u64) * 4096));
-            }
-        }
         Ok(Self {
             reader,
             region_x,
             region_z,
-            locations,
+            locations: parse_locations(&header),
         })
     }
 
@@ -985,20 +1211,21 @@ impl<R: Read + Seek> RegionReader<R> {
     /// Chunk coordinates present in the location table (may include chunks
     /// that later fail to parse).
     pub fn chunk_positions(&self) -> Vec<(i32, i32)> {
-        self.locations
-            .iter()
-            .map(|(i, _)| {
-                (
-                    self.region_x * 32 + (*i % 32) as i32,
-                    self.region_z * 32 + (*i / 32) as i32,
-                )
-            })
-            .collect()
+        chunk_positions(&self.locations, self.region_x, self.region_z)
     }
 
     /// Read and parse one chunk by absolute chunk coordinates.
     /// Ok(None) if the chunk is absent from this region.
     pub fn read_chunk(&mut self, cx: i32, cz: i32) -> Result<Option<ChunkData>> {
+        match self.read_raw_chunk(cx, cz)? {
+            None => Ok(None),
+            Some(raw) => Ok(Some(raw.decode()?)),
+        }
+    }
+
+    /// Read one chunk's compressed payload without decoding it, so the
+    /// decode can run elsewhere. Ok(None) if the chunk is absent.
+    pub fn read_raw_chunk(&mut self, cx: i32, cz: i32) -> Result<Option<RawChunk>> {
         let local_x = cx - self.region_x * 32;
         let local_z = cz - self.region_z * 32;
         if !(0..32).contains(&local_x) || !(0..32).contains(&local_z) {
@@ -1006,14 +1233,28 @@ impl<R: Read + Seek> RegionReader<R> {
         }
         let index = (local_z * 32 + local_x) as u32;
         debug_assert!(index < 1024, "local chunk index out of range");
-        match self.read_chunk_nbt_at(index)? {
-            None => Ok(None),
-            Some(nbt) => Ok(Some(parse_chunk_nbt(&nbt, cx, cz)?)),
-        }
+        Ok(self
+            .read_payload_at(index)?
+            .map(|(compression, data)| RawChunk {
+                cx,
+                cz,
+                compression,
+                data: ChunkBytes::Owned(data),
+            }))
     }
 
     /// Seek to a chunk payload, decompress, and parse the raw NBT.
     fn read_chunk_nbt_at(&mut self, index: u32) -> Result<Option<quartz_nbt::NbtCompound>> {
+        match self.read_payload_at(index)? {
+            None => Ok(None),
+            Some((compression, compressed)) => {
+                Ok(Some(decode_chunk_nbt(&compressed, compression)?))
+            }
+        }
+    }
+
+    /// Seek to a chunk payload and read its compressed bytes.
+    fn read_payload_at(&mut self, index: u32) -> Result<Option<(CompressionType, Vec<u8>)>> {
         let offset = match self.locations.iter().find(|(i, _)| *i == index) {
             Some((_, off)) => *off,
             None => return Ok(None),
@@ -1028,11 +1269,220 @@ impl<R: Read + Seek> RegionReader<R> {
         let compression = CompressionType::from_byte(head[4])?;
         let mut compressed = vec![0u8; (chunk_len as usize) - 1];
         self.reader.read_exact(&mut compressed)?;
-        let decompressed = decompress_chunk(&compressed, compression)?;
-        let (nbt, _) =
-            quartz_nbt::io::read_nbt(&mut Cursor::new(&decompressed), Flavor::Uncompressed)?;
-        Ok(Some(nbt))
+        Ok(Some((compression, compressed)))
+    }
+}
+
+/// Region bytes a [`RegionSlice`] can share with the chunks it hands out.
+pub type SharedRegionBytes = Arc<dyn AsRef<[u8]> + Send + Sync>;
+
+/// A region file held in memory or mapped from disk. The location table is
+/// decoded once and chunk payloads are sliced straight out of the bytes.
+pub struct RegionSlice {
+    bytes: SharedRegionBytes,
+    region_x: i32,
+    region_z: i32,
+    /// (local index 0..1024, absolute byte offset) for present chunks.
+    locations: Vec<(u32, u64)>,
+}
+
+impl RegionSlice {
+    pub fn new(bytes: SharedRegionBytes, region_x: i32, region_z: i32) -> Result<Self> {
+        let locations = parse_locations(region_header((*bytes).as_ref())?);
+        Ok(Self {
+            bytes,
+            region_x,
+            region_z,
+            locations,
+        })
+    }
+
+    /// Map a region file read-only. Where chunk payloads sit in the file in
+    /// canonical order, as in freshly written regions, the mapping is
+    /// advised for sequential reading.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn map_file(path: &std::path::Path, region_x: i32, region_z: i32) -> Result<Self> {
+        let file = std::fs::File::open(path)?;
+        // SAFETY: the mapping is read-only, and callers must not truncate or
+        // rewrite the region while it is open (Minecraft must not be
+        // running on the world).
+        let map = unsafe { memmap2::Mmap::map(&file)? };
+        let locations = parse_locations(region_header(&map)?);
+        // Location order is canonical chunk order. The hint only helps
+        // readahead, so failing to apply it is not an error.
+        #[cfg(unix)]
+        if locations.windows(2).all(|w| w[0].1 < w[1].1) {
+            let _ = map.advise(memmap2::Advice::Sequential);
+        }
+        Ok(Self {
+            bytes: Arc::new(map),
+            region_x,
+            region_z,
+            locations,
+        })
+    }
+
+    pub fn region_position(&self) -> (i32, i32) {
+        (self.region_x, self.region_z)
+    }
+
+    /// Chunk coordinates present in the location table (may include chunks
+    /// that later fail to parse).
+    pub fn chunk_positions(&self) -> Vec<(i32, i32)> {
+        chunk_positions(&self.locations, self.region_x, self.region_z)
+    }
+
+    /// Byte offset of a present chunk's record within the region.
+    pub fn record_offset(&self, cx: i32, cz: i32) -> Option<u64> {
+        let index = self.local_index(cx, cz)?;
+        self.locations
+            .iter()
+            .find(|(i, _)| *i == index)
+            .map(|(_, offset)| *offset)
+    }
+
+    /// A chunk's last-modified time from the region header, in seconds
+    /// since the epoch. None if the chunk is outside the region or the
+    /// header has no timestamp table.
+    pub fn timestamp(&self, cx: i32, cz: i32) -> Option<u32> {
+        let at = 4096 + self.local_index(cx, cz)? as usize * 4;
+        let bytes = (*self.bytes).as_ref().get(at..at + 4)?;
+        Some(u32::from_be_bytes(bytes.try_into().unwrap()))
+    }
+
+    fn local_index(&self, cx: i32, cz: i32) -> Option<u32> {
+        let local_x = cx - self.region_x * 32;
+        let local_z = cz - self.region_z * 32;
+        ((0..32).contains(&local_x) && (0..32).contains(&local_z))
+            .then_some((local_z * 32 + local_x) as u32)
+    }
+
+    /// Read and parse one chunk by absolute chunk coordinates.
+    /// Ok(None) if the chunk is absent from this region.
+    pub fn read_chunk(&self, cx: i32, cz: i32) -> Result<Option<ChunkData>> {
+        match self.raw_chunk(cx, cz)? {
+            None => Ok(None),
+            Some(raw) => Ok(Some(raw.decode()?)),
+        }
+    }
+
+    /// One chunk's compressed payload, sharing the region bytes rather than
+    /// copying them. Ok(None) if the chunk is absent.
+    pub fn raw_chunk(&self, cx: i32, cz: i32) -> Result<Option<RawChunk>> {
+        let offset = match self.record_offset(cx, cz) {
+            Some(offset) => offset as usize,
+            None => return Ok(None),
+        };
+        let data = (*self.bytes).as_ref();
+        let head = data
+            .get(offset..offset + 5)
+            .ok_or("Chunk header is past the end of the region")?;
+        let chunk_len = u32::from_be_bytes([head[0], head[1], head[2], head[3]]) as usize;
+        if chunk_len <= 1 {
+            return Ok(None);
+        }
+        let compression = CompressionType::from_byte(head[4])?;
+        let range = offset + 5..offset + 4 + chunk_len;
+        if range.end > data.len() {
+            return Err("Chunk payload is past the end of the region".into());
+        }
+        Ok(Some(RawChunk {
+            cx,
+            cz,
+            compression,
+            data: ChunkBytes::Shared(self.bytes.clone(), range),
+        }))
+    }
+}
+
+fn region_header(data: &[u8]) -> Result<&[u8; 4096]> {
+    data.get(..4096)
+        .and_then(|header| header.try_into().ok())
+        .ok_or_else(|| "MCA file too small (< 4096 byte header)".into())
+}
+
+/// Present chunks in a region's location table.
+fn parse_locations(header: &[u8; 4096]) -> Vec<(u32, u64)> {
+    let mut locations = Vec::new();
+    for i in 0..1024u32 {
+        let o = (i as usize) * 4;
+        let loc =
+            ((header[o] as u32) << 16) | ((header[o + 1] as u32) << 8) | (header[o + 2] as u32);
+        let sector_count = header[o + 3];
+        if loc >= 2 && sector_count > 0 {
+            locations.push((i, (loc as u64) * 4096));
+        }
     }
+    locations
+}
+
+fn chunk_positions(locations: &[(u32, u64)], region_x: i32, region_z: i32) -> Vec<(i32, i32)> {
+    locations
+        .iter()
+        .map(|(i, _)| {
+            (
+                region_x * 32 + (*i % 32) as i32,
+                region_z * 32 + (*i / 32) as i32,
+            )
+        })
+        .collect()
+}
+
+/// A chunk's still-compressed payload, as read from its region file.
+pub struct RawChunk {
+    pub cx: i32,
+    pub cz: i32,
+    compression: CompressionType,
+    data: ChunkBytes,
+}
+
+enum ChunkBytes {
+    Owned(Vec<u8>),
+    /// A range of region bytes shared with a [`RegionSlice`].
+    Shared(SharedRegionBytes, Range<usize>),
+}
+
+impl RawChunk {
+    fn payload(&self) -> &[u8] {
+        match &self.data {
+            ChunkBytes::Owned(data) => data,
+            ChunkBytes::Shared(bytes, range) => &(**bytes).as_ref()[range.clone()],
+        }
+    }
+
+    /// BLAKE3 of the codec byte and the compressed payload. Equal hashes
+    /// mean byte-identical records, so the chunk need not be decoded to
+    /// know it is unchanged.
+    pub fn content_hash(&self) -> blake3::Hash {
+        let mut hasher = blake3::Hasher::new();
+        hasher.update(&[self.compression as u8]);
+        hasher.update(self.payload());
+        hasher.finalize()
+    }
+
+    /// Decompress and parse the chunk. Needs no access to the region file.
+    pub fn decode(&self) -> Result<ChunkData> {
+        let nbt = decode_chunk_nbt(self.payload(), self.compression)?;
+        parse_chunk_nbt(&nbt, self.cx, self.cz)
+    }
+
+    /// Decompress the chunk and parse only what `projection` keeps.
+    pub fn decode_projected(&self, projection: &ChunkProjection) -> Result<ChunkData> {
+        if projection.is_full() {
+            return self.decode();
+        }
+        with_decompressed(self.payload(), self.compression, |decompressed| {
+            parse_chunk_projected(decompressed, self.cx, self.cz, projection)
+        })
+    }
+}
+
+fn decode_chunk_nbt(compressed: &[u8], compression: CompressionType) -> Result<NbtCompound> {
+    with_decompressed(compressed, compression, |decompressed| {
+        let (nbt, _) =
+            quartz_nbt::io::read_nbt(&mut Cursor::new(decompressed), Flavor::Uncompressed)?;
+        Ok(nbt)
+    })
 }
 
 // ─── Utility ────────────────────────────────────────────────────────────────
@@ -1580,6 +2030,7 @@ mod tests {
             block_entities: vec![be],
             entities: Vec::new(),
             y_pos: -4,
+            heightmaps: None,
         };
 
         let mut chunks: Vec<Option<ChunkData>> = (0..1024).map(|_| None).collect();
@@ -1618,8 +2069,7 @@ mod tests {
             CompressionType::from_byte(3).unwrap(),
             CompressionType::Uncompressed
         );
-        // LZ4 returns error (unsupported)
-        assert!(CompressionType::from_byte(4).is_err());
+        assert_eq!(CompressionType::from_byte(4).unwrap(), CompressionType::Lz4);
         // Unknown type
         assert!(CompressionType::from_byte(5).is_err());
         assert!(CompressionType::from_byte(127).is_err());
@@ -1644,6 +2094,7 @@ mod tests {
             block_entities: Vec::new(),
             entities: Vec::new(),
             y_pos: -4,
+            heightmaps: None,
         };
 
         let mut chunks: Vec<Option<ChunkData>> = (0..1024).map(|_| None).collect();
@@ -1693,6 +2144,7 @@ mod tests {
             block_entities: Vec::new(),
             entities: Vec::new(),
             y_pos: -4,
+            heightmaps: None,
         };
 
         let mut chunks: Vec<Option<ChunkData>> = (0..1024).map(|_| None).collect();
@@ -1757,6 +2209,7 @@ mod tests {
             block_entities: Vec::new(),
             entities: Vec::new(),
             y_pos: -4,
+            heightmaps: None,
         };
 
         let mut chunks: Vec<Option<ChunkData>> = (0..1024).map(|_| None).collect();
@@ -1807,6 +2260,7 @@ mod tests {
             block_entities: Vec::new(),
             entities: Vec::new(),
             y_pos: -4,
+            heightmaps: None,
         }
     }
 
@@ -23,18 +23,25 @@
 //!   WEOffsetX/Y/Z, WEOriginX/Y/Z: int (WorldEdit extensions)
 //! ```
 //!
-//! Array order is `y * Width * Length + z * Width + x`.
+//! Array order is `y * Width * Length + z * Width + x`, which is also region
+//! storage order.
+//!
+//! The reader streams the gzipped NBT and keeps only the fields above: the
+//! three byte arrays are read as raw bytes, never as tags, and are mapped
+//! to region palette indices through a 4096-entry table of every 8-bit
+//! `(id, meta)` pair, so each legacy block is converted once per file.
 
 use flate2::read::GzDecoder;
-use quartz_nbt::io::{read_nbt, Flavor};
-use quartz_nbt::{NbtCompound, NbtList, NbtTag};
-use std::io::{Cursor, Read};
+use quartz_nbt::{NbtCompound, NbtTag};
+use std::io::{BufReader, Read};
+use std::sync::OnceLock;
 
 use crate::block_entity::BlockEntity;
 use crate::block_state::BlockState;
 use crate::entity::Entity;
 use crate::formats::error::Result;
 use crate::formats::manager::SchematicImporter;
+use crate::nbt::{io as nbt_io, Endian, NbtValue};
 use crate::region::Region;
 use crate::universal_schematic::UniversalSchematic;
 
@@ -58,47 +65,141 @@ impl SchematicImporter for ClassicSchematicFormat {
 /// the file has a `Blocks` byte-array and a `Materials` string, and does NOT
 /// have the Sponge-era `Version` or `DataVersion` fields.
 pub fn is_classic_schematic(data: &[u8]) -> bool {
-    let Ok(root) = decompress_and_parse(data) else {
+    let Ok(fields) = read_classic_fields(data, false) else {
         return false;
     };
-    let has_blocks_bytearr = matches!(root.get::<_, &NbtTag>("Blocks"), Ok(NbtTag::ByteArray(_)));
-    let has_materials = root.get::<_, &str>("Materials").is_ok();
-    let no_sponge_version = root.get::<_, i32>("Version").is_err();
-    let no_data_version = root.get::<_, i32>("DataVersion").is_err();
-    has_blocks_bytearr && has_materials && no_sponge_version && no_data_version
+    fields.has_blocks && fields.has_materials && !fields.has_version
+}
+
+/// The root fields of a classic schematic. Byte arrays are only kept when
+/// reading in full.
+#[derive(Default)]
+struct ClassicFields {
+    width: Option<i16>,
+    height: Option<i16>,
+    length: Option<i16>,
+    name: Option<String>,
+    has_blocks: bool,
+    has_materials: bool,
+    /// A Sponge `Version` or `DataVersion` is present.
+    has_version: bool,
+    blocks: Option<Vec<u8>>,
+    data: Option<Vec<u8>>,
+    add_blocks: Option<Vec<u8>>,
+    tile_entities: Vec<NbtCompound>,
+    entities: Vec<NbtCompound>,
 }
 
-fn decompress_and_parse(data: &[u8]) -> Result<NbtCompound> {
-    let mut decoder = GzDecoder::new(data);
-    let mut raw = Vec::new();
-    decoder.read_to_end(&mut raw)?;
-    let (root, _) = read_nbt(&mut Cursor::new(raw), Flavor::Uncompressed)?;
-    Ok(root)
+/// Stream the gzipped NBT of a classic schematic. Without `full`, byte
+/// arrays and lists are stepped over.
+fn read_classic_fields(data: &[u8], full: bool) -> Result<ClassicFields> {
+    const BIG: Endian = Endian::Big;
+    let mut r = BufReader::with_capacity(1 << 16, GzDecoder::new(data));
+    nbt_io::read_root_header(&mut r, BIG)?;
+    let mut fields = ClassicFields::default();
+    while let Some((tag, name)) = nbt_io::read_entry_header(&mut r, BIG)? {
+        match (tag, name.as_str()) {
+            (2, "Width") => fields.width = Some(nbt_io::read_i16(&mut r, BIG)?),
+            (2, "Height") => fields.height = Some(nbt_io::read_i16(&mut r, BIG)?),
+            (2, "Length") => fields.length = Some(nbt_io::read_i16(&mut r, BIG)?),
+            (3, "Version" | "DataVersion") => {
+                fields.has_version = true;
+                nbt_io::skip_payload(&mut r, tag, BIG)?
+            }
+            (8, "Materials") => {
+                fields.has_materials = true;
+                nbt_io::skip_payload(&mut r, tag, BIG)?
+            }
+            (8, "Name") if full => {
+                if let NbtValue::String(value) = nbt_io::read_payload(&mut r, tag, BIG)? {
+                    fields.name = Some(value);
+                }
+            }
+            (7, "Blocks") => {
+                fields.has_blocks = true;
+                if full {
+                    fields.blocks = Some(read_byte_array(&mut r)?);
+                } else {
+                    nbt_io::skip_payload(&mut r, tag, BIG)?
+                }
+            }
+            (7, "Data") if full => fields.data = Some(read_byte_array(&mut r)?),
+            (7, "AddBlocks") if full => fields.add_blocks = Some(read_byte_array(&mut r)?),
+            (9, "TileEntities") if full => fields.tile_entities = read_compound_list(&mut r)?,
+            (9, "Entities") if full => fields.entities = read_compound_list(&mut r)?,
+            _ => nbt_io::skip_payload(&mut r, tag, BIG)?,
+        }
+    }
+    Ok(fields)
+}
+
+/// A byte array payload as raw bytes. The buffer grows with the data read,
+/// so a corrupt length cannot allocate ahead of the stream.
+fn read_byte_array<R: Read>(r: &mut R) -> Result<Vec<u8>> {
+    let len = nbt_io::read_len(r, Endian::Big)?;
+    let mut bytes = Vec::new();
+    r.by_ref().take(len as u64).read_to_end(&mut bytes)?;
+    if bytes.len() != len {
+        return Err("Classic schematic byte array is truncated".into());
+    }
+    Ok(bytes)
+}
+
+/// The compound elements of a list payload.
+fn read_compound_list<R: Read>(r: &mut R) -> Result<Vec<NbtCompound>> {
+    let NbtValue::List(items) = nbt_io::read_payload(r, 9, Endian::Big)? else {
+        return Ok(Vec::new());
+    };
+    Ok(items
+        .into_iter()
+        .filter_map(|item| match item {
+            NbtValue::Compound(map) => Some(map.to_quartz_nbt()),
+            _ => None,
+        })
+        .collect())
+}
+
+/// Block state of every `(id, meta)` pair with an 8-bit id, at
+/// `id << 4 | meta`.
+fn legacy_states() -> &'static [BlockState] {
+    static STATES: OnceLock<Vec<BlockState>> = OnceLock::new();
+    STATES.get_or_init(|| {
+        (0..4096u16)
+            .map(|key| legacy_to_block_state(key >> 4, (key & 0x0F) as u8))
+            .collect()
+    })
+}
+
+/// Table key of a legacy block. Ids past 255 only come from `AddBlocks`
+/// and are all unknown, so they share stone's key.
+#[inline]
+fn legacy_key(id: u16, meta: u8) -> usize {
+    if id < 256 {
+        (id as usize) << 4 | (meta & 0x0F) as usize
+    } else {
+        1 << 4
+    }
 }
 
 /// Read a legacy MCEdit `.schematic` into a `UniversalSchematic`.
 pub fn from_classic_schematic(data: &[u8]) -> Result<UniversalSchematic> {
-    let root = decompress_and_parse(data)?;
+    let fields = read_classic_fields(data, true)?;
 
-    let width = root.get::<_, i16>("Width")? as i32;
-    let height = root.get::<_, i16>("Height")? as i32;
-    let length = root.get::<_, i16>("Length")? as i32;
+    let (Some(width), Some(height), Some(length)) = (fields.width, fields.height, fields.length)
+    else {
+        return Err("Classic schematic is missing Width, Height or Length".into());
+    };
+    let (width, height, length) = (width as i32, height as i32, length as i32);
     if width <= 0 || height <= 0 || length <= 0 {
         return Err("Classic schematic has invalid dimensions".into());
     }
-
-    let blocks = match root.get::<_, &NbtTag>("Blocks")? {
-        NbtTag::ByteArray(v) => v.as_slice(),
-        _ => return Err("Classic schematic 'Blocks' is not a byte array".into()),
-    };
-    let meta_arr = match root.get::<_, &NbtTag>("Data")? {
-        NbtTag::ByteArray(v) => v.as_slice(),
-        _ => return Err("Classic schematic 'Data' is not a byte array".into()),
+    let Some(blocks) = fields.blocks else {
+        return Err("Classic schematic 'Blocks' is missing or not a byte array".into());
     };
-    let add_blocks = match root.get::<_, &NbtTag>("AddBlocks") {
-        Ok(NbtTag::ByteArray(v)) => Some(v.as_slice()),
-        _ => None,
+    let Some(meta_arr) = fields.data else {
+        return Err("Classic schematic 'Data' is missing or not a byte array".into());
     };
+    let add_blocks = fields.add_blocks.as_deref();
 
     let volume = (width as usize) * (height as usize) * (length as usize);
     if blocks.len() != volume || meta_arr.len() != volume {
@@ -107,66 +208,40 @@ pub fn from_classic_schematic(data: &[u8]) -> Result<UniversalSchematic> {
 
     let mut region = Region::new("Main".to_string(), (0, 0, 0), (width, height, length));
 
-    let w = width as usize;
-    let l = length as usize;
-    for idx in 0..volume {
-        let x = (idx % w) as i32;
-        let z = ((idx / w) % l) as i32;
-        let y = (idx / (w * l)) as i32;
-
-        let base_id = blocks[idx] as u8 as u16;
+    // Region palette index of each table key, filled in as keys turn up.
+    let states = legacy_states();
+    let mut remap = [u32::MAX; 4096];
+    let mut indices = Vec::with_capacity(volume);
+    for (idx, (&base, &meta)) in blocks.iter().zip(&meta_arr).enumerate() {
         let high = add_blocks
-            .and_then(|a| a.get(idx / 2).copied())
-            .map(|byte| {
-                let byte = byte as u8;
-                if idx % 2 == 0 {
-                    byte & 0x0F
-                } else {
-                    (byte >> 4) & 0x0F
-                }
-            })
+            .and_then(|a| a.get(idx / 2))
+            .map(|&byte| if idx % 2 == 0 { byte & 0x0F } else { byte >> 4 })
             .unwrap_or(0);
-        let id = base_id | ((high as u16) << 8);
-        let meta = (meta_arr[idx] as u8) & 0x0F;
-
-        if id == 0 {
-            continue; // air — leave the cell at its default
+        let key = legacy_key(base as u16 | (high as u16) << 8, meta);
+        if remap[key] == u32::MAX {
+            remap[key] = region.get_or_insert_in_palette(&states[key]) as u32;
         }
-
-        let block = legacy_to_block_state(id, meta);
-        region.set_block(x, y, z, &block);
+        indices.push(remap[key]);
     }
+    region.write_palette_indices((0, 0, 0), (width - 1, height - 1, length - 1), &indices)?;
 
     // TileEntities: position + Id + opaque NBT payload. Positions in MCEdit are
     // absolute x/y/z relative to the schematic origin (0,0,0).
-    if let Ok(list) = root.get::<_, &NbtList>("TileEntities") {
-        for tag in list.iter() {
-            if let NbtTag::Compound(be_nbt) = tag {
-                if let Some(be) = parse_tile_entity(be_nbt) {
-                    region.add_block_entity(be);
-                }
-            }
+    for be_nbt in &fields.tile_entities {
+        if let Some(be) = parse_tile_entity(be_nbt) {
+            region.add_block_entity(be);
         }
     }
 
     // Entities: positions in `Pos` list of doubles.
-    if let Ok(list) = root.get::<_, &NbtList>("Entities") {
-        for tag in list.iter() {
-            if let NbtTag::Compound(e_nbt) = tag {
-                if let Ok(entity) = Entity::from_nbt(e_nbt) {
-                    region.add_entity(entity);
-                }
-            }
+    for e_nbt in &fields.entities {
+        if let Ok(entity) = Entity::from_nbt(e_nbt) {
+            region.add_entity(entity);
         }
     }
 
-    region.rebuild_non_air_count();
-    region.rebuild_tight_bounds();
-
-    let name = root
-        .get::<_, &str>("Name")
-        .ok()
-        .map(|s| s.to_string())
+    let name = fields
+        .name
         .unwrap_or_else(|| "Classic Schematic".to_string());
     let mut schematic = UniversalSchematic::new(name);
     schematic.set_default_region(region);
@@ -667,6 +742,55 @@ mod tests {
         assert!(!is_classic_schematic(&gz));
     }
 
+    #[test]
+    fn reads_blocks_add_blocks_and_tile_entities() {
+        use flate2::write::GzEncoder;
+        use flate2::Compression;
+        use quartz_nbt::io::{write_nbt, Flavor};
+        use quartz_nbt::NbtList;
+        use std::io::Write;
+
+        // 2x1x2: stone, red wool / an AddBlocks id past 255, air.
+        let mut root = NbtCompound::new();
+        root.insert("Name", NbtTag::String("old".to_string()));
+        root.insert("Width", NbtTag::Short(2));
+        root.insert("Height", NbtTag::Short(1));
+        root.insert("Length", NbtTag::Short(2));
+        root.insert("Materials", NbtTag::String("Alpha".to_string()));
+        root.insert("Blocks", NbtTag::ByteArray(vec![1, 35, 54, 0]));
+        root.insert("Data", NbtTag::ByteArray(vec![0, 14, 0, 0]));
+        root.insert("AddBlocks", NbtTag::ByteArray(vec![0, 0x01]));
+        let mut chest = NbtCompound::new();
+        chest.insert("id", NbtTag::String("Chest".to_string()));
+        chest.insert("x", NbtTag::Int(1));
+        chest.insert("y", NbtTag::Int(0));
+        chest.insert("z", NbtTag::Int(0));
+        root.insert(
+            "TileEntities",
+            NbtTag::List(NbtList::from(vec![NbtTag::Compound(chest)])),
+        );
+        let mut raw = Vec::new();
+        write_nbt(&mut raw, None, &root, Flavor::Uncompressed).unwrap();
+        let mut enc = GzEncoder::new(Vec::new(), Compression::default());
+        enc.write_all(&raw).unwrap();
+        let gz = enc.finish().unwrap();
+
+        assert!(is_classic_schematic(&gz));
+        let schematic = from_classic_schematic(&gz).unwrap();
+        assert_eq!(schematic.metadata.name.as_deref(), Some("old"));
+        let name = |x, z| schematic.get_block(x, 0, z).map(|b| b.name.to_string());
+        assert_eq!(name(0, 0).as_deref(), Some("minecraft:stone"));
+        assert_eq!(name(1, 0).as_deref(), Some("minecraft:red_wool"));
+        // Id 54 | 1 << 8 is unknown, so it is kept as stone.
+        assert_eq!(name(0, 1).as_deref(), Some("minecraft:stone"));
+        assert!(name(1, 1).is_none_or(|n| n == "minecraft:air"));
+        assert_eq!(schematic.default_region.count_blocks(), 3);
+        let chest = schematic
+            .get_block_entity(crate::block_position::BlockPosition { x: 1, y: 0, z: 0 })
+            .unwrap();
+        assert_eq!(chest.id, "minecraft:chest");
+    }
+
     #[test]
     fn legacy_mapping_stone() {
         let bs = legacy_to_block_state(1, 0);
@@ -0,0 +1,159 @@
+//! Gzip output for the NBT exporters, optionally deflated on a thread pool.
+//!
+//! The parallel writer works like pigz. It splits the input into blocks and
+//! deflates each block on its own. Every block except the last ends with a
+//! sync flush, which pads to a byte boundary with an empty stored block, so
+//! the blocks join into one deflate stream. The result is a single gzip
+//! member that any gzip reader accepts. CRCs are computed per block and
+//! combined. Blocks start without the previous block's window, which costs
+//! a little ratio at 1 MiB per block.
+
+use crate::formats::error::Result;
+use flate2::write::GzEncoder;
+use flate2::{Compress, Compression, Crc, FlushCompress, Status};
+use quartz_nbt::io::Flavor;
+use quartz_nbt::NbtCompound;
+use std::io::Write;
+
+/// Input bytes per independently deflated block.
+const PARALLEL_BLOCK: usize = 1 << 20;
+
+/// How an exporter gzips its NBT.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct GzipOptions {
+    pub level: Compression,
+    /// Deflate blocks on the thread pool. Output is valid gzip, but its
+    /// bytes differ from the sequential encoder's.
+    pub parallel: bool,
+}
+
+impl From<Compression> for GzipOptions {
+    fn from(level: Compression) -> Self {
+        GzipOptions {
+            level,
+            parallel: false,
+        }
+    }
+}
+
+/// Serialize `root` as gzipped NBT.
+pub fn write_nbt(root: &NbtCompound, options: GzipOptions) -> Result<Vec<u8>> {
+    if options.parallel {
+        let mut raw = Vec::new();
+        quartz_nbt::io::write_nbt(&mut raw, None, root, Flavor::Uncompressed)?;
+        return compress_parallel(&raw, options.level);
+    }
+    let mut encoder = GzEncoder::new(Vec::new(), options.level);
+    quartz_nbt::io::write_nbt(&mut encoder, None, root, Flavor::Uncompressed)?;
+    Ok(encoder.finish()?)
+}
+
+/// Gzip `data` as one member whose deflate blocks are compressed in
+/// parallel. Inputs of a single block go through the sequential encoder.
+pub fn compress_parallel(data: &[u8], level: Compression) -> Result<Vec<u8>> {
+    if data.len() <= PARALLEL_BLOCK {
+        let mut encoder = GzEncoder::new(Vec::with_capacity(data.len() / 2), level);
+        encoder.write_all(data)?;
+        return Ok(encoder.finish()?);
+    }
+
+    let blocks: Vec<&[u8]> = data.chunks(PARALLEL_BLOCK).collect();
+    let last = blocks.len() - 1;
+    let encode = |(i, block): (usize, &&[u8])| -> Result<(Vec<u8>, Crc)> {
+        let mut crc = Crc::new();
+        crc.update(block);
+        Ok((deflate_block(block, level, i == last)?, crc))
+    };
+
+    #[cfg(not(target_arch = "wasm32"))]
+    let parts: Vec<Result<(Vec<u8>, Crc)>> = {
+        use rayon::prelude::*;
+        blocks.par_iter().enumerate().map(encode).collect()
+    };
+    #[cfg(target_arch = "wasm32")]
+    let parts: Vec<Result<(Vec<u8>, Crc)>> = blocks.iter().enumerate().map(encode).collect();
+
+    // Same header GzEncoder writes: no name, no mtime, unknown OS.
+    let extra_flags = if level.level() >= Compression::best().level() {
+        2
+    } else if level.level() <= Compression::fast().level() {
+        4
+    } else {
+        0
+    };
+    let mut out = Vec::with_capacity(data.len() / 2);
+    out.extend_from_slice(&[0x1f, 0x8b, 8, 0, 0, 0, 0, 0, extra_flags, 0xff]);
+    let mut crc = Crc::new();
+    for part in parts {
+        let (deflated, block_crc) = part?;
+        out.extend_from_slice(&deflated);
+        crc.combine(&block_crc);
+    }
+    out.extend_from_slice(&crc.sum().to_le_bytes());
+    out.extend_from_slice(&crc.amount().to_le_bytes());
+    Ok(out)
+}
+
+/// Raw-deflate one block, ending with a sync flush, or the final block
+/// when `last`.
+fn deflate_block(block: &[u8], level: Compression, last: bool) -> Result<Vec<u8>> {
+    let mut compress = Compress::new(level, false);
+    let flush = if last {
+        FlushCompress::Finish
+    } else {
+        FlushCompress::Sync
+    };
+    let mut out = Vec::with_capacity(block.len() / 2 + 64);
+    loop {
+        if out.len() == out.capacity() {
+            out.reserve(out.capacity());
+        }
+        let consumed = compress.total_in() as usize;
+        let status = compress
+            .compress_vec(&block[consumed..], &mut out, flush)
+            .map_err(|e| format!("Deflate failed: {}", e))?;
+        let drained = compress.total_in() as usize == block.len() && out.len() < out.capacity();
+        match status {
+            Status::StreamEnd => break,
+            _ if !last && drained => break,
+            _ => {}
+        }
+    }
+    Ok(out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use flate2::read::GzDecoder;
+    use std::io::Read;
+
+    #[test]
+    fn parallel_output_is_a_single_gzip_member() {
+        // Three and a half blocks of mildly compressible bytes.
+        let data: Vec<u8> = (0..PARALLEL_BLOCK * 7 / 2)
+            .map(|i| ((i * 31) ^ (i >> 9)) as u8 % 61)
+            .collect();
+
+        for level in [
+            Compression::fast(),
+            Compression::new(6),
+            Compression::best(),
+        ] {
+            let gz = compress_parallel(&data, level).unwrap();
+            assert!(gz.len() < data.len());
+            // GzDecoder stops after the first member, so this also checks
+            // that the blocks joined into one.
+            let mut decoded = Vec::new();
+            GzDecoder::new(&gz[..]).read_to_end(&mut decoded).unwrap();
+            assert_eq!(decoded, data);
+        }
+
+        let small = compress_parallel(b"tiny", Compression::default()).unwrap();
+        let mut decoded = Vec::new();
+        GzDecoder::new(&small[..])
+            .read_to_end(&mut decoded)
+            .unwrap();
+        assert_eq!(decoded, b"tiny");
+    }
+}
@@ -1,26 +1,111 @@
 use crate::block_entity::BlockEntity;
+use crate::block_entity_store::BlockEntityInterner;
+use crate::bounding_box::BoundingBox;
 use crate::entity::Entity;
+use crate::entity_store::EntityInterner;
 use crate::formats::error::Result;
+use crate::formats::gzip::{self, GzipOptions};
+use crate::formats::manager::SchematicInfo;
+use crate::formats::packed_longs::{self, Layout};
+use crate::metadata::Metadata;
+use crate::nbt::view::{self as nbt_view, TagView};
+use crate::nbt::{io as nbt_io, Endian};
 use crate::region::Region;
 use crate::{BlockState, UniversalSchematic};
 use flate2::read::GzDecoder;
 use quartz_nbt::io::Flavor;
 use quartz_nbt::{NbtCompound, NbtList, NbtTag};
+use std::io::{BufReader, Read};
 use std::time::{SystemTime, UNIX_EPOCH};
 
 pub fn is_litematic(data: &[u8]) -> bool {
-    // Stream-decompress directly into NBT parser (no intermediate buffer)
-    let reader = std::io::BufReader::with_capacity(1 << 20, data);
-    let mut gz = GzDecoder::new(reader);
-    let (root, _) = match quartz_nbt::io::read_nbt(&mut gz, Flavor::Uncompressed) {
-        Ok(result) => result,
-        Err(_) => return false,
-    };
+    // Headers only: the regions are never built.
+    read_litematic_header(data).is_ok_and(|header| header.is_complete())
+}
+
+/// Root fields of a litematic that precede or describe its regions.
+#[derive(Default)]
+struct LitematicHeader {
+    version: Option<i32>,
+    data_version: Option<i32>,
+    metadata: Option<NbtCompound>,
+    has_regions: bool,
+}
+
+impl LitematicHeader {
+    fn is_complete(&self) -> bool {
+        self.version.is_some() && self.metadata.is_some() && self.has_regions
+    }
+}
+
+/// Walk the root compound until the version, metadata and regions have all
+/// been seen. Regions are skipped rather than built, and when they come last,
+/// as Litematica writes them, the rest of the stream is never decompressed.
+fn read_litematic_header<R: Read>(data: R) -> Result<LitematicHeader> {
+    const BIG: Endian = Endian::Big;
+    let mut r = BufReader::with_capacity(1 << 16, GzDecoder::new(data));
+    nbt_io::read_root_header(&mut r, BIG)?;
+    let mut header = LitematicHeader::default();
+    while !header.is_complete() {
+        let Some((tag, name)) = nbt_io::read_entry_header(&mut r, BIG)? else {
+            break;
+        };
+        match (tag, name.as_str()) {
+            (3, "Version") => header.version = Some(nbt_io::read_i32(&mut r, BIG)?),
+            (3, "MinecraftDataVersion") => {
+                header.data_version = Some(nbt_io::read_i32(&mut r, BIG)?)
+            }
+            (10, "Metadata") => {
+                header.metadata = Some(nbt_io::read_compound_payload(&mut r, BIG)?.to_quartz_nbt())
+            }
+            (10, "Regions") => {
+                header.has_regions = true;
+                if !header.is_complete() {
+                    nbt_io::skip_payload(&mut r, tag, BIG)?;
+                }
+            }
+            _ => nbt_io::skip_payload(&mut r, tag, BIG)?,
+        }
+    }
+    Ok(header)
+}
+
+/// Probe a litematic from its root fields and `Metadata` alone.
+pub fn probe_litematic(data: &[u8]) -> Result<SchematicInfo> {
+    probe_litematic_reader(data)
+}
 
-    // Check for required fields as per the Litematic format
-    root.get::<_, i32>("Version").is_ok()
-        && root.get::<_, &NbtCompound>("Metadata").is_ok()
-        && root.get::<_, &NbtCompound>("Regions").is_ok()
+/// [`probe_litematic`] over a stream of the gzip-compressed file. Reading
+/// stops once the header fields are seen, so the rest of the stream is left
+/// unread when the regions come last.
+pub fn probe_litematic_reader<R: Read>(reader: R) -> Result<SchematicInfo> {
+    let header = read_litematic_header(reader)?;
+    let metadata = header.metadata.as_ref().ok_or("Missing Metadata")?;
+    let mut info = SchematicInfo {
+        format_version: header.version,
+        ..Default::default()
+    };
+    read_metadata_fields(metadata, &mut info.metadata);
+    info.metadata.lm_version = header.version;
+    info.metadata.mc_version = header.data_version;
+    if let Ok(size) = metadata.get::<_, &NbtCompound>("EnclosingSize") {
+        if let (Ok(x), Ok(y), Ok(z)) = (
+            size.get::<_, i32>("x"),
+            size.get::<_, i32>("y"),
+            size.get::<_, i32>("z"),
+        ) {
+            info.dimensions = Some((x.abs(), y.abs(), z.abs()));
+        }
+    }
+    info.region_count = metadata
+        .get::<_, i32>("RegionCount")
+        .ok()
+        .map(|n| n.max(0) as u32);
+    info.total_blocks = metadata
+        .get::<_, i32>("TotalBlocks")
+        .ok()
+        .map(|n| n.max(0) as u64);
+    Ok(info)
 }
 /// Default compression level for litematic serialization.
 /// Level 3 balances speed (~2x faster than L6) with size (~15% larger than L6).
@@ -37,7 +122,7 @@ const DATA_VERSION_1_18: i32 = 2860; // negative-Y height → Version 6
 const DATA_VERSION_1_19_2: i32 = 3120; // SubVersion=1 first written (within v6)
 const DATA_VERSION_1_20_5: i32 = 3837; // item Components → Version 7
 /// Default target data version when a schematic carries none (latest canonical).
-const DEFAULT_TARGET_DATA_VERSION: i32 = 4790; // 26.1.2
+pub(crate) const DEFAULT_TARGET_DATA_VERSION: i32 = 4790; // 26.1.2
 
 /// The `.litematic` `Version` (and optional `SubVersion`) that Litematica writes
 /// for a given Minecraft data version. v4 (1.12) < 1631 ≤ v5 (1.13–1.17) < 2860 ≤
@@ -80,7 +165,7 @@ pub fn to_litematic_for_data_version(
 
 pub fn to_litematic_with_compression(
     schematic: &UniversalSchematic,
-    compression: flate2::Compression,
+    compression: impl Into<GzipOptions>,
 ) -> Result<Vec<u8>> {
     let mut root = NbtCompound::new();
 
@@ -108,21 +193,32 @@ pub fn to_litematic_with_compression(
     root.insert("Regions", NbtTag::Compound(regions));
 
     // Compress and return the NBT data
-    let mut encoder = flate2::write::GzEncoder::new(Vec::new(), compression);
-    quartz_nbt::io::write_nbt(
-        &mut encoder,
-        None,
-        &root,
-        quartz_nbt::io::Flavor::Uncompressed,
-    )?;
-    Ok(encoder.finish()?)
+    gzip::write_nbt(&root, compression.into())
 }
 
 pub fn from_litematic(data: &[u8]) -> Result<UniversalSchematic> {
-    // Stream-decompress directly into NBT parser (no intermediate buffer)
+    from_litematic_impl(data, None)
+}
+
+/// [`from_litematic`] over a stream of the gzip-compressed file. The
+/// decompressed NBT is read in place, so tags the loader ignores are skipped
+/// without being built.
+pub fn from_litematic_reader<R: Read>(reader: R) -> Result<UniversalSchematic> {
+    from_litematic_impl(reader, None)
+}
+
+/// Load only the part of a litematic inside `bounds`, given in schematic
+/// coordinates. Regions outside the box are skipped, the rest are cut to it
+/// and only the rows inside it are unpacked.
+pub fn from_litematic_bounded(data: &[u8], bounds: &BoundingBox) -> Result<UniversalSchematic> {
+    from_litematic_impl(data, Some(bounds))
+}
+
+fn from_litematic_impl<R: Read>(data: R, clip: Option<&BoundingBox>) -> Result<UniversalSchematic> {
     let reader = std::io::BufReader::with_capacity(1 << 20, data);
-    let mut gz = flate2::read::GzDecoder::new(reader);
-    let (root, _) = quartz_nbt::io::read_nbt(&mut gz, quartz_nbt::io::Flavor::Uncompressed)?;
+    let mut bytes = Vec::new();
+    flate2::read::GzDecoder::new(reader).read_to_end(&mut bytes)?;
+    let root = read_kept_tags(&bytes, clip)?;
 
     let mut schematic = UniversalSchematic::new("Unnamed".to_string());
 
@@ -130,11 +226,79 @@ pub fn from_litematic(data: &[u8]) -> Result<UniversalSchematic> {
     parse_metadata(&root, &mut schematic)?;
 
     // Parse Regions
-    parse_regions(&root, &mut schematic)?;
+    parse_regions(&root, &mut schematic, clip)?;
 
     Ok(schematic)
 }
 
+/// Region tags the reader uses; everything else (pending ticks above all)
+/// is stepped over.
+const REGION_TAGS: [&str; 6] = [
+    "Position",
+    "Size",
+    "BlockStatePalette",
+    "BlockStates",
+    "Entities",
+    "TileEntities",
+];
+
+/// Build the root of decompressed litematic NBT with only the tags the
+/// reader uses. The file is viewed in place, so dropped tags are never
+/// built, and a region entirely outside `clip` keeps only its position
+/// and size.
+fn read_kept_tags(bytes: &[u8], clip: Option<&BoundingBox>) -> Result<NbtCompound> {
+    let (_, file) = nbt_view::root(bytes, Endian::Big)?;
+    let mut root = NbtCompound::new();
+    for (name, tag) in file.iter() {
+        let name = name.to_str()?;
+        let TagView::Compound(regions) = &tag else {
+            root.insert(name.into_owned(), tag.to_value()?.to_quartz_nbt());
+            continue;
+        };
+        if name != "Regions" {
+            root.insert(name.into_owned(), tag.to_value()?.to_quartz_nbt());
+            continue;
+        }
+        let mut kept = NbtCompound::new();
+        for (region_name, region) in regions.iter() {
+            let region_name = region_name.to_str()?.into_owned();
+            let TagView::Compound(region) = &region else {
+                kept.insert(region_name, region.to_value()?.to_quartz_nbt());
+                continue;
+            };
+            let skipped = clip.is_some_and(|clip| {
+                region_bounds(region).is_some_and(|full| full.intersection(clip).is_none())
+            });
+            let mut out = NbtCompound::new();
+            for (key, value) in region.iter() {
+                let wanted = if skipped {
+                    key == *"Position" || key == *"Size"
+                } else {
+                    REGION_TAGS.iter().any(|tag| key == **tag)
+                };
+                if wanted {
+                    out.insert(
+                        key.to_str()?.into_owned(),
+                        value.to_value()?.to_quartz_nbt(),
+                    );
+                }
+            }
+            kept.insert(region_name, NbtTag::Compound(out));
+        }
+        root.insert("Regions", NbtTag::Compound(kept));
+    }
+    Ok(root)
+}
+
+/// The box of a viewed region, when its position and size read cleanly.
+fn region_bounds(region: &nbt_view::CompoundView<'_>) -> Option<BoundingBox> {
+    let vec3 = |name: &str| {
+        let c = region.get_compound(name)?;
+        Some((c.get_i32("x")?, c.get_i32("y")?, c.get_i32("z")?))
+    };
+    BoundingBox::try_from_position_and_size(vec3("Position")?, vec3("Size")?).ok()
+}
+
 fn create_metadata(schematic: &UniversalSchematic, version: i32) -> NbtCompound {
     let mut metadata = NbtCompound::new();
 
@@ -288,48 +452,12 @@ fn create_regions(schematic: &UniversalSchematic, version: i32) -> NbtCompound {
         region_nbt.insert("BlockStatePalette", NbtTag::List(palette));
 
         // Remap block indices and create packed states
-        // Use integer log2 instead of floating-point
-        let bits_per_block = if reordered_palette.len() <= 1 {
-            2 // minimum 2 bits per block per litematic spec
-        } else {
-            std::cmp::max(
-                (usize::BITS - (reordered_palette.len() - 1).leading_zeros()) as usize,
-                2,
-            )
-        };
-        let block_count = compact_region.blocks.len();
-        let expected_len = (block_count * bits_per_block).div_ceil(64);
-
-        let mut packed_states = vec![0i64; expected_len];
-        let mask = (1u64 << bits_per_block) - 1;
-
-        if 64 % bits_per_block == 0 {
-            // Fast path: entries never cross i64 boundaries (bits_per_block = 2, 4, 8, 16, 32)
-            // Batch-pack without per-block division or branching
-            let entries_per_long = 64 / bits_per_block;
-            for (chunk_idx, chunk) in compact_region.blocks.chunks(entries_per_long).enumerate() {
-                let mut packed: u64 = 0;
-                for (i, &block_state) in chunk.iter().enumerate() {
-                    packed |= (index_mapping[block_state] as u64 & mask) << (i * bits_per_block);
-                }
-                packed_states[chunk_idx] = packed as i64;
-            }
-        } else {
-            // Slow path: entries may cross i64 boundaries (bits_per_block = 3, 5, 6, 7, etc.)
-            for (index, &block_state) in compact_region.blocks.iter().enumerate() {
-                let mapped_state = index_mapping[block_state];
-                let bit_index = index * bits_per_block;
-                let start_long_index = bit_index / 64;
-                let end_long_index = (bit_index + bits_per_block - 1) / 64;
-                let start_offset = bit_index % 64;
-                let value = (mapped_state as u64) & mask;
-
-                packed_states[start_long_index] |= (value << start_offset) as i64;
-                if start_long_index != end_long_index {
-                    packed_states[end_long_index] |= (value >> (64 - start_offset)) as i64;
-                }
+        let bits_per_block = packed_longs::bits_for(reordered_palette.len(), 2);
+        let packed_states = compact_region.pack_block_states(bits_per_block, |batch| {
+            for index in batch {
+                *index = index_mapping[*index as usize] as u32;
             }
-        }
+        });
 
         region_nbt.insert("BlockStates", NbtTag::LongArray(packed_states));
 
@@ -338,26 +466,7 @@ fn create_regions(schematic: &UniversalSchematic, version: i32) -> NbtCompound {
             compact_region
                 .entities
                 .iter()
-                .map(|entity| {
-                    let mut entity_nbt = if let NbtTag::Compound(c) = entity.to_nbt() {
-                        c
-                    } else {
-                        NbtCompound::new()
-                    };
-
-                    let rel_x = entity.position.0 - compact_region.position.0 as f64;
-                    let rel_y = entity.position.1 - compact_region.position.1 as f64;
-                    let rel_z = entity.position.2 - compact_region.position.2 as f64;
-
-                    let pos_list = NbtList::from(vec![
-                        NbtTag::Double(rel_x),
-                        NbtTag::Double(rel_y),
-                        NbtTag::Double(rel_z),
-                    ]);
-                    entity_nbt.insert("Pos", NbtTag::List(pos_list));
-
-                    NbtTag::Compound(entity_nbt)
-                })
+                .map(|entity| NbtTag::Compound(region_entity_nbt(entity, compact_region.position)))
                 .collect::<Vec<NbtTag>>(),
         );
         region_nbt.insert("Entities", NbtTag::List(entities));
@@ -368,18 +477,10 @@ fn create_regions(schematic: &UniversalSchematic, version: i32) -> NbtCompound {
                 .block_entities
                 .values()
                 .map(|block_entity| {
-                    let mut block_entity_nbt = block_entity.to_nbt();
-
-                    let rel_x = block_entity.position.0 - compact_region.position.0;
-                    let rel_y = block_entity.position.1 - compact_region.position.1;
-                    let rel_z = block_entity.position.2 - compact_region.position.2;
-
-                    block_entity_nbt.insert("x", NbtTag::Int(rel_x));
-                    block_entity_nbt.insert("y", NbtTag::Int(rel_y));
-                    block_entity_nbt.insert("z", NbtTag::Int(rel_z));
-                    block_entity_nbt.insert("Pos", NbtTag::IntArray(vec![rel_x, rel_y, rel_z]));
-
-                    NbtTag::Compound(block_entity_nbt)
+                    NbtTag::Compound(region_block_entity_nbt(
+                        block_entity,
+                        compact_region.position,
+                    ))
                 })
                 .collect::<Vec<NbtTag>>(),
         );
@@ -399,6 +500,45 @@ fn create_regions(schematic: &UniversalSchematic, version: i32) -> NbtCompound {
     regions
 }
 
+/// A region entity, positioned relative to the region's `origin`.
+pub(crate) fn region_entity_nbt(entity: &Entity, origin: (i32, i32, i32)) -> NbtCompound {
+    let mut entity_nbt = if let NbtTag::Compound(c) = entity.to_nbt() {
+        c
+    } else {
+        NbtCompound::new()
+    };
+
+    let rel_x = entity.position.0 - origin.0 as f64;
+    let rel_y = entity.position.1 - origin.1 as f64;
+    let rel_z = entity.position.2 - origin.2 as f64;
+
+    let pos_list = NbtList::from(vec![
+        NbtTag::Double(rel_x),
+        NbtTag::Double(rel_y),
+        NbtTag::Double(rel_z),
+    ]);
+    entity_nbt.insert("Pos", NbtTag::List(pos_list));
+    entity_nbt
+}
+
+/// A region tile entity, positioned relative to the region's `origin`.
+pub(crate) fn region_block_entity_nbt(
+    block_entity: &BlockEntity,
+    origin: (i32, i32, i32),
+) -> NbtCompound {
+    let mut block_entity_nbt = block_entity.to_nbt();
+
+    let rel_x = block_entity.position.0 - origin.0;
+    let rel_y = block_entity.position.1 - origin.1;
+    let rel_z = block_entity.position.2 - origin.2;
+
+    block_entity_nbt.insert("x", NbtTag::Int(rel_x));
+    block_entity_nbt.insert("y", NbtTag::Int(rel_y));
+    block_entity_nbt.insert("z", NbtTag::Int(rel_z));
+    block_entity_nbt.insert("Pos", NbtTag::IntArray(vec![rel_x, rel_y, rel_z]));
+    block_entity_nbt
+}
+
 fn parse_metadata(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Result<()> {
     // Capture the file's Minecraft data version (root-level, written by Litematica
     // as `MinecraftDataVersion`) so importers know what to forward-convert from.
@@ -408,18 +548,7 @@ fn parse_metadata(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Res
     }
 
     let metadata = root.get::<_, &NbtCompound>("Metadata")?;
-
-    schematic.metadata.name = metadata.get::<_, &str>("Name").ok().map(String::from);
-    schematic.metadata.description = metadata
-        .get::<_, &str>("Description")
-        .ok()
-        .map(String::from);
-    schematic.metadata.author = metadata.get::<_, &str>("Author").ok().map(String::from);
-    schematic.metadata.created = metadata.get::<_, i64>("TimeCreated").ok().map(|t| t as u64);
-    schematic.metadata.modified = metadata
-        .get::<_, i64>("TimeModified")
-        .ok()
-        .map(|t| t as u64);
+    read_metadata_fields(metadata, &mut schematic.metadata);
 
     // We don't need to parse EnclosingSize, TotalVolume, TotalBlocks as they will be recalculated
 
@@ -433,9 +562,30 @@ fn parse_metadata(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Res
     Ok(())
 }
 
-fn parse_regions(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Result<()> {
+/// The descriptive fields of a litematic `Metadata` compound.
+fn read_metadata_fields(metadata: &NbtCompound, out: &mut Metadata) {
+    out.name = metadata.get::<_, &str>("Name").ok().map(String::from);
+    out.description = metadata
+        .get::<_, &str>("Description")
+        .ok()
+        .map(String::from);
+    out.author = metadata.get::<_, &str>("Author").ok().map(String::from);
+    out.created = metadata.get::<_, i64>("TimeCreated").ok().map(|t| t as u64);
+    out.modified = metadata
+        .get::<_, i64>("TimeModified")
+        .ok()
+        .map(|t| t as u64);
+}
+
+fn parse_regions(
+    root: &NbtCompound,
+    schematic: &mut UniversalSchematic,
+    clip: Option<&BoundingBox>,
+) -> Result<()> {
     let regions = root.get::<_, &NbtCompound>("Regions")?;
     let mut loop_count = 0;
+    // Shared across regions: identical block entities load as one template.
+    let mut interner = BlockEntityInterner::new();
     for (name, region_tag) in regions.inner() {
         //if it's the first region we want to override the default region name
         if loop_count == 0 {
@@ -458,7 +608,16 @@ fn parse_regions(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Resu
                 size.get::<_, i32>("z")?,
             );
 
-            let mut region = Region::new(name.to_string(), position, size);
+            let full = BoundingBox::try_from_position_and_size(position, size)?;
+            let keep = match clip.map(|clip| full.intersection(clip)) {
+                Some(Some(keep)) => Some(keep),
+                Some(None) => continue,
+                None => None,
+            };
+            let mut region = match &keep {
+                Some(keep) => Region::new(name.to_string(), keep.min, keep.get_dimensions()),
+                None => Region::new(name.to_string(), position, size),
+            };
 
             // Parse BlockStatePalette
             let palette = region_nbt.get::<_, &NbtList>("BlockStatePalette")?;
@@ -475,8 +634,11 @@ fn parse_regions(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Resu
 
             // Parse BlockStates
             let block_states = region_nbt.get::<_, &[i64]>("BlockStates")?;
-            // region.unpack_block_states(block_states);
-            region.blocks = region.unpack_block_states(block_states);
+            region.blocks = match &keep {
+                Some(keep) => unpack_rows_within(block_states, region.palette.len(), &full, keep),
+                None => region.unpack_block_states(block_states),
+            }
+            .into();
 
             // Rebuild caches after directly setting palette and blocks
             region.rebuild_palette_index();
@@ -492,13 +654,16 @@ fn parse_regions(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Resu
             // so block entities/entities must add the SAME corner to land on their
             // blocks. Adding raw `position` shifted everything by the region height/depth
             // on negative-extent schematics and pushed every container off its block.
-            let min_corner = region.get_bounding_box().min;
+            let min_corner = full.min;
+            let inside =
+                |position: (i32, i32, i32)| keep.as_ref().is_none_or(|k| k.contains(position));
 
             // Parse Entities - positions relative to the region Position/origin
             // corner. This intentionally differs from block entities below:
             // Litematica saves entities from `entityPos - box.getPos1()` and
             // places them back with `origin + regionPos + entityPos`.
             if let Ok(entities_list) = region_nbt.get::<_, &NbtList>("Entities") {
+                let mut interner = EntityInterner::new();
                 region.entities = entities_list
                     .iter()
                     .filter_map(|tag| {
@@ -508,7 +673,9 @@ fn parse_regions(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Resu
                             entity.position.0 += position.0 as f64;
                             entity.position.1 += position.1 as f64;
                             entity.position.2 += position.2 as f64;
-                            Some(entity)
+                            let (x, y, z) = entity.position;
+                            inside((x.floor() as i32, y.floor() as i32, z.floor() as i32))
+                                .then(|| interner.intern(entity))
                         } else {
                             None
                         }
@@ -525,9 +692,14 @@ fn parse_regions(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Resu
                         block_entity.position.0 += min_corner.0;
                         block_entity.position.1 += min_corner.1;
                         block_entity.position.2 += min_corner.2;
+                        let pos = block_entity.position;
+                        if !inside(pos) {
+                            continue;
+                        }
+                        block_entity.strip_position_keys();
                         region
                             .block_entities
-                            .insert(block_entity.position, block_entity);
+                            .insert_shared(pos, interner.intern(block_entity));
                     }
                 }
             }
@@ -539,7 +711,32 @@ fn parse_regions(root: &NbtCompound, schematic: &mut UniversalSchematic) -> Resu
     Ok(())
 }
 
-use crate::formats::manager::{SchematicExporter, SchematicImporter};
+/// Unpack the cells of `keep` from the block states of a region spanning
+/// `full`, one row at a time, in `keep`'s own index order.
+fn unpack_rows_within(
+    block_states: &[i64],
+    palette_len: usize,
+    full: &BoundingBox,
+    keep: &BoundingBox,
+) -> Vec<usize> {
+    let bits = packed_longs::bits_for(palette_len, 2);
+    let (width, height, length) = keep.get_dimensions();
+    let (width, height, length) = (width as usize, height as usize, length as usize);
+    let mut blocks = vec![0; width * height * length];
+    let mut rows = blocks.chunks_exact_mut(width);
+    for y in keep.min.1..=keep.max.1 {
+        for z in keep.min.2..=keep.max.2 {
+            let first = full.coords_to_index(keep.min.0, y, z);
+            let row = rows.next().unwrap();
+            packed_longs::unpack_range(block_states, bits, Layout::Spanning, first, row);
+        }
+    }
+    blocks
+}
+
+use crate::formats::manager::{
+    BoundsSettings, CompressionSettings, SchematicExporter, SchematicImporter,
+};
 
 pub struct LitematicFormat;
 
@@ -555,6 +752,37 @@ impl SchematicImporter for LitematicFormat {
     fn read(&self, data: &[u8]) -> Result<UniversalSchematic> {
         from_litematic(data)
     }
+
+    fn read_with_settings(
+        &self,
+        data: &[u8],
+        settings: Option<&str>,
+    ) -> Result<UniversalSchematic> {
+        match BoundsSettings::from_settings(settings)?.bounds() {
+            Some(bounds) => self.read_bounded(data, &bounds),
+            None => self.read(data),
+        }
+    }
+
+    fn read_bounded(&self, data: &[u8], bounds: &BoundingBox) -> Result<UniversalSchematic> {
+        from_litematic_bounded(data, bounds)
+    }
+
+    fn import_settings_schema(&self) -> Option<String> {
+        serde_json::to_string_pretty(&BoundsSettings::default()).ok()
+    }
+
+    fn probe(&self, data: &[u8]) -> Result<SchematicInfo> {
+        probe_litematic(data)
+    }
+
+    fn read_from(&self, reader: &mut dyn Read) -> Result<UniversalSchematic> {
+        from_litematic_reader(reader)
+    }
+
+    fn probe_from(&self, reader: &mut dyn Read) -> Result<SchematicInfo> {
+        probe_litematic_reader(reader)
+    }
 }
 
 impl SchematicExporter for LitematicFormat {
@@ -577,6 +805,21 @@ impl SchematicExporter for LitematicFormat {
     fn write(&self, schematic: &UniversalSchematic, _version: Option<&str>) -> Result<Vec<u8>> {
         to_litematic(schematic)
     }
+
+    fn write_with_settings(
+        &self,
+        schematic: &UniversalSchematic,
+        _version: Option<&str>,
+        settings: Option<&str>,
+    ) -> Result<Vec<u8>> {
+        let compression =
+            CompressionSettings::from_settings(settings)?.gzip_or(DEFAULT_COMPRESSION)?;
+        to_litematic_with_compression(schematic, compression)
+    }
+
+    fn export_settings_schema(&self) -> Option<String> {
+        serde_json::to_string_pretty(&CompressionSettings::default()).ok()
+    }
 }
 
 #[cfg(test)]
@@ -1007,7 +1250,7 @@ mod tests {
         println!("{:?}", root);
 
         let mut schematic = UniversalSchematic::new("Test Schematic".to_string());
-        parse_regions(&root, &mut schematic).unwrap();
+        parse_regions(&root, &mut schematic, None).unwrap();
 
         assert_eq!(schematic.default_region_name, "TestRegion");
 
@@ -1112,6 +1355,56 @@ mod tests {
         }
     }
 
+    #[test]
+    fn test_bounded_import_unpacks_only_the_box() {
+        use crate::block_entity::BlockEntity;
+
+        let mut schematic = UniversalSchematic::new("Bounded".to_string());
+        for x in 0..37 {
+            for y in 0..5 {
+                for z in 0..6 {
+                    let name = format!("minecraft:test_{}", (x * 7 + y * 3 + z) % 19);
+                    schematic.set_block(x, y, z, &BlockState::new(name));
+                }
+            }
+        }
+        schematic
+            .default_region
+            .add_block_entity(BlockEntity::new("minecraft:chest".to_string(), (30, 2, 3)));
+        schematic
+            .default_region
+            .add_block_entity(BlockEntity::new("minecraft:chest".to_string(), (1, 1, 1)));
+        let data = to_litematic(&schematic).unwrap();
+
+        let bounds = BoundingBox::new((20, 1, 2), (40, 3, 4));
+        let bounded = from_litematic_bounded(&data, &bounds).unwrap();
+        let region = &bounded.default_region;
+        let full = from_litematic(&data).unwrap();
+        assert_eq!(
+            Some(region.get_bounding_box()),
+            full.default_region.get_bounding_box().intersection(&bounds)
+        );
+        for x in 20..37 {
+            for y in 1..4 {
+                for z in 2..5 {
+                    assert_eq!(
+                        bounded.get_block(x, y, z),
+                        full.get_block(x, y, z),
+                        "block at {x},{y},{z}"
+                    );
+                }
+            }
+        }
+        assert_eq!(
+            region.block_entities.keys().collect::<Vec<_>>(),
+            vec![&(30, 2, 3)]
+        );
+
+        let outside = BoundingBox::new((100, 0, 0), (110, 4, 5));
+        let empty = from_litematic_bounded(&data, &outside).unwrap();
+        assert_eq!(empty.total_blocks(), 0);
+    }
+
     /// Test that litematic export stores block entity and entity positions
     /// relative to the region Position, not as absolute coordinates.
     #[test]
@@ -1300,4 +1593,38 @@ mod tests {
             }
         }
     }
+
+    #[test]
+    fn identical_block_entities_load_as_one_template() {
+        use crate::block_entity::BlockEntity;
+        use crate::nbt::NbtValue;
+        use std::sync::Arc;
+
+        let mut schematic = UniversalSchematic::new("Storage".to_string());
+        for x in 0..8 {
+            let lock = if x == 7 { "b" } else { "a" };
+            schematic.set_block(x, 0, 0, &BlockState::new("minecraft:chest".to_string()));
+            schematic.default_region.add_block_entity(
+                BlockEntity::new("minecraft:chest".to_string(), (x, 0, 0))
+                    .with_nbt_data("Lock".to_string(), NbtValue::String(lock.to_string())),
+            );
+        }
+        let loaded = from_litematic(&to_litematic(&schematic).unwrap()).unwrap();
+        let store = &loaded.default_region.block_entities;
+        let nbt = |x| Arc::as_ptr(&store.get(&(x, 0, 0)).unwrap().nbt);
+        assert!((1..7).all(|x| nbt(x) == nbt(0)));
+        assert_ne!(nbt(7), nbt(0));
+        assert!(!store.get(&(3, 0, 0)).unwrap().nbt.contains_key("x"));
+
+        // Writing the shared templates back out keeps every position.
+        let again = from_litematic(&to_litematic(&loaded).unwrap()).unwrap();
+        let mut positions: Vec<_> = again
+            .default_region
+            .get_block_entities_as_list()
+            .iter()
+            .map(|be| be.position)
+            .collect();
+        positions.sort();
+        assert_eq!(positions, (0..8).map(|x| (x, 0, 0)).collect::<Vec<_>>());
+    }
 }
@@ -0,0 +1,137 @@
+//! The LZ4 stream Minecraft (1.20.5+) uses for region chunks of compression
+//! type 4, as written by lz4-java's `LZ4BlockOutputStream`: blocks of at
+//! most 64 KiB, each behind a 21-byte header, ending with an empty block.
+//!
+//! Header: the magic `LZ4Block`, a token (method in the high nibble, log2 of
+//! the block size minus 10 in the low), then little-endian compressed
+//! length, original length and a 28-bit XXH32 checksum of the original
+//! bytes.
+
+use crate::formats::error::Result;
+use xxhash_rust::xxh32::xxh32;
+
+const MAGIC: &[u8; 8] = b"LZ4Block";
+const HEADER_LEN: usize = 21;
+const METHOD_RAW: u8 = 0x10;
+const METHOD_LZ4: u8 = 0x20;
+const LEVEL_BASE: u32 = 10;
+const BLOCK_SIZE: usize = 1 << 16;
+const SEED: u32 = 0x9747_b28c;
+
+fn checksum(data: &[u8]) -> u32 {
+    xxh32(data, SEED) & 0x0FFF_FFFF
+}
+
+fn write_header(out: &mut Vec<u8>, token: u8, compressed: usize, original: usize, check: u32) {
+    out.extend_from_slice(MAGIC);
+    out.push(token);
+    out.extend_from_slice(&(compressed as u32).to_le_bytes());
+    out.extend_from_slice(&(original as u32).to_le_bytes());
+    out.extend_from_slice(&check.to_le_bytes());
+}
+
+/// Compress `data` into an LZ4 block stream. Blocks that do not shrink are
+/// stored raw, as lz4-java does.
+pub fn compress(data: &[u8]) -> Vec<u8> {
+    let level = (BLOCK_SIZE.trailing_zeros() - LEVEL_BASE) as u8;
+    let mut out = Vec::with_capacity(data.len() / 2 + 2 * HEADER_LEN);
+    for block in data.chunks(BLOCK_SIZE) {
+        let compressed = lz4_flex::block::compress(block);
+        let (method, payload) = if compressed.len() < block.len() {
+            (METHOD_LZ4, compressed.as_slice())
+        } else {
+            (METHOD_RAW, block)
+        };
+        write_header(
+            &mut out,
+            method | level,
+            payload.len(),
+            block.len(),
+            checksum(block),
+        );
+        out.extend_from_slice(payload);
+    }
+    write_header(&mut out, METHOD_RAW | level, 0, 0, 0);
+    out
+}
+
+/// Decompress an LZ4 block stream, verifying each block's checksum. The
+/// stream ends at the empty block or at the end of `data`.
+pub fn decompress(data: &[u8]) -> Result<Vec<u8>> {
+    let mut out = Vec::new();
+    decompress_into(data, &mut out)?;
+    Ok(out)
+}
+
+/// [`decompress`] appending to `out`, so a caller can reuse one buffer.
+pub fn decompress_into(data: &[u8], out: &mut Vec<u8>) -> Result<()> {
+    let mut rest = data;
+    while !rest.is_empty() {
+        let header = rest
+            .get(..HEADER_LEN)
+            .filter(|header| header.starts_with(MAGIC))
+            .ok_or("LZ4 block header is malformed")?;
+        let token = header[8];
+        let field = |at: usize| u32::from_le_bytes(header[at..at + 4].try_into().unwrap()) as usize;
+        let (compressed_len, original_len, check) = (field(9), field(13), field(17) as u32);
+        let max_len = 1usize << (LEVEL_BASE + (token & 0x0F) as u32);
+        if original_len > max_len || compressed_len > max_len {
+            return Err("LZ4 block is larger than its declared block size".into());
+        }
+        rest = &rest[HEADER_LEN..];
+        if original_len == 0 && compressed_len == 0 {
+            if check != 0 {
+                return Err("LZ4 end block has a checksum".into());
+            }
+            break;
+        }
+
+        let payload = rest.get(..compressed_len).ok_or("LZ4 block is truncated")?;
+        let start = out.len();
+        match token & 0xF0 {
+            METHOD_RAW if compressed_len == original_len => out.extend_from_slice(payload),
+            METHOD_LZ4 => {
+                out.resize(start + original_len, 0);
+                let written = lz4_flex::block::decompress_into(payload, &mut out[start..])
+                    .map_err(|e| format!("LZ4 block is corrupt: {}", e))?;
+                if written != original_len {
+                    return Err("LZ4 block decoded to the wrong length".into());
+                }
+            }
+            _ => return Err(format!("Unknown LZ4 block token {:#04x}", token).into()),
+        }
+        if checksum(&out[start..]) != check {
+            return Err("LZ4 block checksum mismatch".into());
+        }
+        rest = &rest[compressed_len..];
+    }
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn round_trips_raw_and_compressed_blocks() {
+        // Two full blocks of repetitive data plus an incompressible tail.
+        let mut data: Vec<u8> = (0..2 * BLOCK_SIZE).map(|i| (i / 100) as u8).collect();
+        let mut state = 1u32;
+        data.extend((0..1000).map(|_| {
+            state = state.wrapping_mul(1_103_515_245).wrapping_add(12345);
+            (state >> 16) as u8
+        }));
+
+        let stream = compress(&data);
+        assert!(stream.starts_with(MAGIC));
+        assert_eq!(stream[8], METHOD_LZ4 | 6);
+        assert!(stream.len() < data.len());
+        assert_eq!(decompress(&stream).unwrap(), data);
+
+        let mut corrupt = stream.clone();
+        corrupt[17] ^= 1;
+        assert!(decompress(&corrupt).is_err());
+        assert!(decompress(&stream[..HEADER_LEN + 3]).is_err());
+        assert_eq!(decompress(&compress(&[])).unwrap(), Vec::<u8>::new());
+    }
+}
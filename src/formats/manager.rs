@@ -1,6 +1,139 @@
+use crate::bounding_box::BoundingBox;
 use crate::formats::error::Result;
+use crate::formats::gzip::GzipOptions;
+use crate::metadata::Metadata;
+use crate::telemetry::{self, stage};
 use crate::universal_schematic::UniversalSchematic;
-use std::sync::{Arc, Mutex, OnceLock};
+use flate2::Compression;
+use serde::{Deserialize, Serialize};
+use std::io::Read;
+use std::sync::{Arc, OnceLock, RwLock};
+
+/// Export settings shared by the gzip- and zlib-backed exporters.
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
+pub struct CompressionSettings {
+    /// Deflate level, 0 (store) to 9 (smallest). `None` keeps the format's
+    /// own default.
+    #[serde(default)]
+    pub compression_level: Option<u32>,
+    /// Deflate 1 MiB blocks on the thread pool. Still one gzip member, but
+    /// the bytes differ from a sequential export.
+    #[serde(default)]
+    pub parallel_compression: bool,
+}
+
+impl CompressionSettings {
+    pub fn from_settings(settings: Option<&str>) -> Result<Self> {
+        Ok(settings
+            .map(serde_json::from_str)
+            .transpose()?
+            .unwrap_or_default())
+    }
+
+    /// The requested level, or `default` when none was given.
+    pub fn level_or(&self, default: Compression) -> Result<Compression> {
+        compression_level(self.compression_level, default)
+    }
+
+    /// Gzip options for the requested level and parallelism.
+    pub fn gzip_or(&self, default: Compression) -> Result<GzipOptions> {
+        Ok(GzipOptions {
+            level: self.level_or(default)?,
+            parallel: self.parallel_compression,
+        })
+    }
+}
+
+/// Validate an optional deflate level from export settings.
+pub(crate) fn compression_level(level: Option<u32>, default: Compression) -> Result<Compression> {
+    match level {
+        None => Ok(default),
+        Some(level @ 0..=9) => Ok(Compression::new(level)),
+        Some(level) => Err(format!("Compression level must be 0-9, got {}", level).into()),
+    }
+}
+
+/// Import settings of the importers that can load a sub-volume. The box is
+/// inclusive and applies only when all six bounds are given.
+#[derive(Debug, Clone, Serialize, Deserialize, Default)]
+pub struct BoundsSettings {
+    pub min_x: Option<i32>,
+    pub min_y: Option<i32>,
+    pub min_z: Option<i32>,
+    pub max_x: Option<i32>,
+    pub max_y: Option<i32>,
+    pub max_z: Option<i32>,
+}
+
+impl BoundsSettings {
+    pub fn from_settings(settings: Option<&str>) -> Result<Self> {
+        Ok(settings
+            .map(serde_json::from_str)
+            .transpose()?
+            .unwrap_or_default())
+    }
+
+    pub fn bounds(&self) -> Option<BoundingBox> {
+        match (
+            self.min_x, self.min_y, self.min_z, self.max_x, self.max_y, self.max_z,
+        ) {
+            (Some(min_x), Some(min_y), Some(min_z), Some(max_x), Some(max_y), Some(max_z)) => Some(
+                BoundingBox::new((min_x, min_y, min_z), (max_x, max_y, max_z)),
+            ),
+            _ => None,
+        }
+    }
+}
+
+/// `schematic` cut down to the cells inside `bounds`, for importers that
+/// have no bounded reader of their own.
+fn crop_to_bounds(
+    schematic: &UniversalSchematic,
+    bounds: &BoundingBox,
+) -> Result<UniversalSchematic> {
+    let name = schematic
+        .metadata
+        .name
+        .clone()
+        .unwrap_or_else(|| "Unnamed".to_string());
+    let mut cropped = UniversalSchematic::new(name);
+    cropped.metadata = schematic.metadata.clone();
+    if let Some(keep) = schematic.get_bounding_box().intersection(bounds) {
+        cropped.stamp_box(schematic, &keep, keep.min, &[])?;
+    }
+    Ok(cropped)
+}
+
+/// What [`SchematicImporter::probe`] reports about a file, read from its
+/// header without decoding block data.
+#[derive(Debug, Clone, Default, PartialEq, Serialize)]
+pub struct SchematicInfo {
+    /// Name of the importer that recognised the data.
+    pub format: String,
+    /// The format's own revision: litematic or Sponge `Version`, mcstructure
+    /// `format_version`.
+    pub format_version: Option<i32>,
+    pub metadata: Metadata,
+    /// Enclosing size as (width, height, length).
+    pub dimensions: Option<(i32, i32, i32)>,
+    pub region_count: Option<u32>,
+    /// Non-air block count, when the header records one.
+    pub total_blocks: Option<u64>,
+}
+
+impl SchematicInfo {
+    /// Summary of an already loaded schematic.
+    pub fn from_schematic(schematic: &UniversalSchematic) -> Self {
+        SchematicInfo {
+            format: String::new(),
+            format_version: None,
+            metadata: schematic.metadata.clone(),
+            dimensions: Some(schematic.get_dimensions()),
+            region_count: Some(schematic.get_region_names().len() as u32),
+            total_blocks: Some(schematic.total_blocks().max(0) as u64),
+        }
+    }
+}
 
 pub trait SchematicImporter: Send + Sync {
     fn name(&self) -> String;
@@ -17,6 +150,32 @@ pub trait SchematicImporter: Send + Sync {
     fn import_settings_schema(&self) -> Option<String> {
         None
     }
+    /// The blocks of `data` inside `bounds` (inclusive, in the schematic's
+    /// own coordinates). Formats without a bounded reader load everything
+    /// and crop.
+    fn read_bounded(&self, data: &[u8], bounds: &BoundingBox) -> Result<UniversalSchematic> {
+        crop_to_bounds(&self.read(data)?, bounds)
+    }
+    /// Header fields of `data`. Formats without a header fast path load the
+    /// whole schematic and summarise it.
+    fn probe(&self, data: &[u8]) -> Result<SchematicInfo> {
+        Ok(SchematicInfo::from_schematic(&self.read(data)?))
+    }
+    /// [`read`](Self::read) from a stream of the file's bytes. The default
+    /// buffers the stream; formats that decode incrementally override it.
+    fn read_from(&self, reader: &mut dyn Read) -> Result<UniversalSchematic> {
+        let mut data = Vec::new();
+        reader.read_to_end(&mut data)?;
+        self.read(&data)
+    }
+    /// [`probe`](Self::probe) from a stream of the file's bytes. The default
+    /// buffers the stream; formats with a header fast path override it to
+    /// stop reading once the header is seen.
+    fn probe_from(&self, reader: &mut dyn Read) -> Result<SchematicInfo> {
+        let mut data = Vec::new();
+        reader.read_to_end(&mut data)?;
+        self.probe(&data)
+    }
 }
 
 pub trait SchematicExporter: Send + Sync {
@@ -39,9 +198,11 @@ pub trait SchematicExporter: Send + Sync {
     }
 }
 
+/// Registered formats. Cloning shares the format objects.
+#[derive(Clone)]
 pub struct FormatManager {
-    importers: Vec<Box<dyn SchematicImporter>>,
-    exporters: Vec<Box<dyn SchematicExporter>>,
+    importers: Vec<Arc<dyn SchematicImporter>>,
+    exporters: Vec<Arc<dyn SchematicExporter>>,
 }
 
 impl Default for FormatManager {
@@ -59,11 +220,11 @@ impl FormatManager {
     }
 
     pub fn register_importer<I: SchematicImporter + 'static>(&mut self, importer: I) {
-        self.importers.push(Box::new(importer));
+        self.importers.push(Arc::new(importer));
     }
 
     pub fn register_exporter<E: SchematicExporter + 'static>(&mut self, exporter: E) {
-        self.exporters.push(Box::new(exporter));
+        self.exporters.push(Arc::new(exporter));
     }
 
     pub fn detect_format(&self, data: &[u8]) -> Option<String> {
@@ -75,9 +236,22 @@ impl FormatManager {
         None
     }
 
+    /// The first importer that recognises `head`, which may be just the
+    /// leading bytes of a file: detection reads headers only, so a prefix
+    /// holding them is enough.
+    pub fn importer_for(&self, head: &[u8]) -> Option<&dyn SchematicImporter> {
+        self.importers
+            .iter()
+            .find(|importer| importer.detect(head))
+            .map(|importer| importer.as_ref())
+    }
+
     pub fn read(&self, data: &[u8]) -> Result<UniversalSchematic> {
         for importer in &self.importers {
             if importer.detect(data) {
+                let _stage =
+                    stage!(INFO, "format.read", format = %importer.name(), bytes = data.len());
+                telemetry::count("format.read.bytes", data.len() as u64);
                 return importer.read(data);
             }
         }
@@ -91,12 +265,40 @@ impl FormatManager {
     ) -> Result<UniversalSchematic> {
         for importer in &self.importers {
             if importer.detect(data) {
+                let _stage =
+                    stage!(INFO, "format.read", format = %importer.name(), bytes = data.len());
+                telemetry::count("format.read.bytes", data.len() as u64);
                 return importer.read_with_settings(data, settings);
             }
         }
         Err("Unknown or unsupported schematic format".into())
     }
 
+    /// Detect the format of `data` and load only the blocks inside `bounds`.
+    pub fn read_bounded(&self, data: &[u8], bounds: &BoundingBox) -> Result<UniversalSchematic> {
+        for importer in &self.importers {
+            if importer.detect(data) {
+                let _stage =
+                    stage!(INFO, "format.read", format = %importer.name(), bytes = data.len());
+                telemetry::count("format.read.bytes", data.len() as u64);
+                return importer.read_bounded(data, bounds);
+            }
+        }
+        Err("Unknown or unsupported schematic format".into())
+    }
+
+    /// Detect the format of `data` and read only its header fields.
+    pub fn probe(&self, data: &[u8]) -> Result<SchematicInfo> {
+        for importer in &self.importers {
+            if importer.detect(data) {
+                let mut info = importer.probe(data)?;
+                info.format = importer.name();
+                return Ok(info);
+            }
+        }
+        Err("Unknown or unsupported schematic format".into())
+    }
+
     pub fn write(
         &self,
         format: &str,
@@ -105,7 +307,10 @@ impl FormatManager {
     ) -> Result<Vec<u8>> {
         for exporter in &self.exporters {
             if exporter.name().eq_ignore_ascii_case(format) {
-                return exporter.write(schematic, version);
+                let _stage = stage!(INFO, "format.write", format = %exporter.name());
+                return exporter
+                    .write(schematic, version)
+                    .inspect(|bytes| telemetry::count("format.write.bytes", bytes.len() as u64));
             }
         }
         Err(format!("Unsupported export format: {}", format).into())
@@ -120,7 +325,10 @@ impl FormatManager {
     ) -> Result<Vec<u8>> {
         for exporter in &self.exporters {
             if exporter.name().eq_ignore_ascii_case(format) {
-                return exporter.write_with_settings(schematic, version, settings);
+                let _stage = stage!(INFO, "format.write", format = %exporter.name());
+                return exporter
+                    .write_with_settings(schematic, version, settings)
+                    .inspect(|bytes| telemetry::count("format.write.bytes", bytes.len() as u64));
             }
         }
         Err(format!("Unsupported export format: {}", format).into())
@@ -140,7 +348,10 @@ impl FormatManager {
 
         for exporter in &self.exporters {
             if exporter.extensions().contains(&extension) {
-                return exporter.write(schematic, version);
+                let _stage = stage!(INFO, "format.write", format = %exporter.name());
+                return exporter
+                    .write(schematic, version)
+                    .inspect(|bytes| telemetry::count("format.write.bytes", bytes.len() as u64));
             }
         }
         Err(format!("Could not determine format from extension: .{}", extension).into())
@@ -161,7 +372,10 @@ impl FormatManager {
 
         for exporter in &self.exporters {
             if exporter.extensions().contains(&extension) {
-                return exporter.write_with_settings(schematic, version, settings);
+                let _stage = stage!(INFO, "format.write", format = %exporter.name());
+                return exporter
+                    .write_with_settings(schematic, version, settings)
+                    .inspect(|bytes| telemetry::count("format.write.bytes", bytes.len() as u64));
             }
         }
         Err(format!("Could not determine format from extension: .{}", extension).into())
@@ -212,29 +426,51 @@ impl FormatManager {
     }
 }
 
-pub static MANAGER: OnceLock<Arc<Mutex<FormatManager>>> = OnceLock::new();
-
-pub fn get_manager() -> Arc<Mutex<FormatManager>> {
-    MANAGER
-        .get_or_init(|| {
-            let mut manager = FormatManager::new();
-            manager.register_importer(crate::formats::litematic::LitematicFormat);
-            manager.register_exporter(crate::formats::litematic::LitematicFormat);
-            manager.register_importer(crate::formats::schematic::SchematicFormat);
-            manager.register_exporter(crate::formats::schematic::SchematicFormat);
-            manager.register_importer(crate::formats::mcstructure::McStructureFormat);
-            manager.register_exporter(crate::formats::mcstructure::McStructureFormat);
-            manager.register_importer(crate::formats::snapshot::SnapshotFormat);
-            manager.register_exporter(crate::formats::snapshot::SnapshotFormat);
-            manager.register_importer(crate::formats::structure_snbt::StructureSnbtFormat);
-            manager.register_exporter(crate::formats::structure_snbt::StructureSnbtFormat);
-            // Legacy MCEdit .schematic — import only (format is deprecated)
-            manager.register_importer(crate::formats::classic_schematic::ClassicSchematicFormat);
-            // MCA and WorldZip importers (registered last since detection is header-based)
-            manager.register_importer(crate::formats::world::McaFormat);
-            manager.register_importer(crate::formats::world::WorldZipFormat);
-            manager.register_exporter(crate::formats::world::WorldFormat);
-            Arc::new(Mutex::new(manager))
-        })
+/// The shared registry. Readers take the read lock only to clone the
+/// current snapshot's `Arc`, then detect, load and save with no lock held,
+/// so loads and saves on different threads run in parallel;
+/// [`update_manager`] takes the write lock to publish a new snapshot.
+static MANAGER: OnceLock<RwLock<Arc<FormatManager>>> = OnceLock::new();
+
+/// The shared registry as it is now: a brief read lock and an `Arc` clone.
+/// Formats registered later are not seen by this snapshot.
+pub fn get_manager() -> Arc<FormatManager> {
+    manager_slot()
+        .read()
+        .unwrap_or_else(|e| e.into_inner())
         .clone()
 }
+
+/// Change the shared registry, e.g. to register a format at runtime. `f`
+/// edits a copy that then replaces the registry; calls already holding a
+/// snapshot finish with the old one.
+pub fn update_manager<R>(f: impl FnOnce(&mut FormatManager) -> R) -> R {
+    let mut slot = manager_slot().write().unwrap_or_else(|e| e.into_inner());
+    let mut next = FormatManager::clone(&slot);
+    let result = f(&mut next);
+    *slot = Arc::new(next);
+    result
+}
+
+fn manager_slot() -> &'static RwLock<Arc<FormatManager>> {
+    MANAGER.get_or_init(|| {
+        let mut manager = FormatManager::new();
+        manager.register_importer(crate::formats::litematic::LitematicFormat);
+        manager.register_exporter(crate::formats::litematic::LitematicFormat);
+        manager.register_importer(crate::formats::schematic::SchematicFormat);
+        manager.register_exporter(crate::formats::schematic::SchematicFormat);
+        manager.register_importer(crate::formats::mcstructure::McStructureFormat);
+        manager.register_exporter(crate::formats::mcstructure::McStructureFormat);
+        manager.register_importer(crate::formats::snapshot::SnapshotFormat);
+        manager.register_exporter(crate::formats::snapshot::SnapshotFormat);
+        manager.register_importer(crate::formats::structure_snbt::StructureSnbtFormat);
+        manager.register_exporter(crate::formats::structure_snbt::StructureSnbtFormat);
+        // Legacy MCEdit .schematic — import only (format is deprecated)
+        manager.register_importer(crate::formats::classic_schematic::ClassicSchematicFormat);
+        // MCA and WorldZip importers (registered last since detection is header-based)
+        manager.register_importer(crate::formats::world::McaFormat);
+        manager.register_importer(crate::formats::world::WorldZipFormat);
+        manager.register_exporter(crate::formats::world::WorldFormat);
+        RwLock::new(Arc::new(manager))
+    })
+}
@@ -2,8 +2,8 @@ use crate::block_entity::BlockEntity;
 use crate::blockpedia::block_entity::{BlockEntityTranslator, NbtValue as BpNbtValue};
 use crate::entity::Entity;
 use crate::formats::error::Result;
-use crate::formats::manager::{SchematicExporter, SchematicImporter};
-use crate::nbt::io::{read_nbt, write_nbt};
+use crate::formats::manager::{SchematicExporter, SchematicImporter, SchematicInfo};
+use crate::nbt::io as nbt_io;
 use crate::nbt::{Endian, NbtMap, NbtValue};
 use crate::region::Region;
 use crate::universal_schematic::UniversalSchematic;
@@ -19,21 +19,39 @@ impl SchematicImporter for McStructureFormat {
         "mcstructure".to_string()
     }
 
+    /// Scan the root entries for `format_version`, `size` and `structure`,
+    /// skipping payloads rather than parsing the file.
     fn detect(&self, data: &[u8]) -> bool {
+        const LE: Endian = Endian::Little;
         let mut cursor = Cursor::new(data);
-        match read_nbt(&mut cursor, Endian::Little) {
-            Ok(NbtValue::Compound(root)) => {
-                root.get("format_version").is_some()
-                    && root.get("size").is_some()
-                    && root.get("structure").is_some()
+        if nbt_io::read_root_header(&mut cursor, LE).is_err() {
+            return false;
+        }
+        let mut seen = [false; 3];
+        while let Ok(Some((tag, name))) = nbt_io::read_entry_header(&mut cursor, LE) {
+            match name.as_str() {
+                "format_version" => seen[0] = true,
+                "size" => seen[1] = true,
+                "structure" => seen[2] = true,
+                _ => {}
+            }
+            if seen == [true; 3] {
+                return true;
+            }
+            if nbt_io::skip_payload(&mut cursor, tag, LE).is_err() {
+                return false;
             }
-            _ => false,
         }
+        false
     }
 
     fn read(&self, data: &[u8]) -> Result<UniversalSchematic> {
         from_mcstructure(data)
     }
+
+    fn probe(&self, data: &[u8]) -> Result<SchematicInfo> {
+        probe_mcstructure(data)
+    }
 }
 
 impl SchematicExporter for McStructureFormat {
@@ -58,43 +76,75 @@ impl SchematicExporter for McStructureFormat {
     }
 }
 
-pub fn from_mcstructure(data: &[u8]) -> Result<UniversalSchematic> {
+/// Probe an mcstructure from `format_version` and `size`, skipping the
+/// `structure` compound.
+pub fn probe_mcstructure(data: &[u8]) -> Result<SchematicInfo> {
+    const LE: Endian = Endian::Little;
     let mut cursor = Cursor::new(data);
-    let root_val = read_nbt(&mut cursor, Endian::Little)?;
-    let root = match root_val {
-        NbtValue::Compound(c) => c,
-        _ => return Err("Root is not a compound".into()),
+    nbt_io::read_root_header(&mut cursor, LE)?;
+    let mut info = SchematicInfo {
+        region_count: Some(1),
+        ..Default::default()
     };
+    while info.format_version.is_none() || info.dimensions.is_none() {
+        let Some((tag, name)) = nbt_io::read_entry_header(&mut cursor, LE)? else {
+            break;
+        };
+        match (tag, name.as_str()) {
+            (3, "format_version") => info.format_version = Some(nbt_io::read_i32(&mut cursor, LE)?),
+            (9, "size") => {
+                if let NbtValue::List(size) = nbt_io::read_payload(&mut cursor, tag, LE)? {
+                    if let [NbtValue::Int(x), NbtValue::Int(y), NbtValue::Int(z)] = size.as_slice()
+                    {
+                        info.dimensions = Some((*x, *y, *z));
+                    }
+                }
+            }
+            _ => nbt_io::skip_payload(&mut cursor, tag, LE)?,
+        }
+    }
+    info.dimensions.ok_or("Missing or invalid size")?;
+    Ok(info)
+}
 
-    let size_list = match root.get("size") {
+/// Read a Bedrock `.mcstructure`.
+///
+/// The root and `structure` compounds are pull-parsed: `block_indices`
+/// layers are read as bare int runs straight into index buffers and other
+/// large entries are never built as values. The Bedrock palette is
+/// translated once per file, and every layer is resolved into one index
+/// buffer that is written into the region in a single pass. Water in a
+/// later layer (Bedrock's second layer holds the liquid of a waterlogged
+/// block) waterlogs the block under it instead of replacing it.
+pub fn from_mcstructure(data: &[u8]) -> Result<UniversalSchematic> {
+    const LE: Endian = Endian::Little;
+    let mut cursor = Cursor::new(data);
+    nbt_io::read_root_header(&mut cursor, LE)?;
+
+    let mut size = None;
+    let mut structure = None;
+    while let Some((tag, name)) = nbt_io::read_entry_header(&mut cursor, LE)? {
+        match (tag, name.as_str()) {
+            (_, "size") => size = Some(nbt_io::read_payload(&mut cursor, tag, LE)?),
+            (10, "structure") => structure = Some(read_structure(&mut cursor)?),
+            _ => nbt_io::skip_payload(&mut cursor, tag, LE)?,
+        }
+    }
+
+    let size_list = match size {
         Some(NbtValue::List(l)) => l,
         _ => return Err("Missing or invalid size".into()),
     };
-
-    let mut size_iter = size_list.iter();
-    let width = match size_iter.next() {
-        Some(NbtValue::Int(v)) => *v,
-        _ => 0,
-    };
-    let height = match size_iter.next() {
-        Some(NbtValue::Int(v)) => *v,
-        _ => 0,
-    };
-    let length = match size_iter.next() {
+    let dim = |i: usize| match size_list.get(i) {
         Some(NbtValue::Int(v)) => *v,
         _ => 0,
     };
+    let (width, height, length) = (dim(0), dim(1), dim(2));
 
-    let structure = match root.get("structure") {
-        Some(NbtValue::Compound(c)) => c,
-        _ => return Err("Missing structure compound".into()),
-    };
+    let structure = structure.ok_or("Missing structure compound")?;
 
     // Parse Palette
-    let palette_wrapper = match structure.get("palette") {
-        Some(NbtValue::Compound(c)) => c,
-        _ => return Err("Missing palette".into()),
-    };
+    let palette_wrapper = structure.palette.as_ref().ok_or("Missing palette")?;
     let default_palette = match palette_wrapper.get("default") {
         Some(NbtValue::Compound(c)) => c,
         _ => return Err("Missing default palette".into()),
@@ -130,7 +180,7 @@ pub fn from_mcstructure(data: &[u8]) -> Result<UniversalSchematic> {
                         NbtValue::String(s) => s.clone(),
                         _ => format!("{:?}", val), // Fallback
                     };
-                    properties.push((key.into(), val_str.into()));
+                    properties.push((key.clone(), val_str.into()));
                 }
             }
 
@@ -168,69 +218,10 @@ pub fn from_mcstructure(data: &[u8]) -> Result<UniversalSchematic> {
     // Construct Region
     let mut region = Region::new("Main".to_string(), (0, 0, 0), (width, height, length));
 
-    // Parse Block Indices (Multi-layer support)
-    let block_indices_list = match structure.get("block_indices") {
-        Some(NbtValue::List(l)) => l,
-        _ => return Err("Missing block_indices".into()),
-    };
-
-    for layer in block_indices_list {
-        let indices: Vec<i32> = match layer {
-            NbtValue::List(list) => list
-                .iter()
-                .filter_map(|t| {
-                    if let NbtValue::Int(i) = t {
-                        Some(*i)
-                    } else {
-                        None
-                    }
-                })
-                .collect(),
-            _ => continue,
-        };
-
-        // Set blocks
-        // Indices are ZYX order: X outer, Y middle, Z inner
-        // index = SZ*SY*X + SZ*Y + Z
-        for (i, &palette_idx) in indices.iter().enumerate() {
-            if palette_idx < 0 {
-                continue;
-            } // -1 is void/air-skip
-
-            let i = i as i32;
-            let sz = length;
-            let sy = height;
-
-            if sz == 0 || sy == 0 {
-                continue;
-            }
-
-            let x = i / sz / sy;
-            let y = (i / sz) % sy;
-            let z = i % sz;
-
-            if palette_idx < palette.len() as i32 {
-                let block = palette[palette_idx as usize].clone();
-
-                // Simple merge logic:
-                // If the block is water/lava and we already have a block here,
-                // try to set waterlogged=true instead of overwriting.
-                if (block.name == "minecraft:water" || block.name == "minecraft:flowing_water")
-                    && region.get_block(x, y, z).is_some()
-                {
-                    if let Some(existing_block) = region.get_block(x, y, z) {
-                        if existing_block.name != "minecraft:air" {
-                            let mut updated_block = existing_block.clone();
-                            updated_block.set_property("waterlogged", "true");
-                            region.set_block(x, y, z, &updated_block);
-                            continue;
-                        }
-                    }
-                }
-
-                region.set_block(x, y, z, &block);
-            }
-        }
+    let layers = structure.block_indices.ok_or("Missing block_indices")?;
+    let cells = resolve_layers(&mut region, &palette, &layers, (width, height, length));
+    if !cells.is_empty() {
+        region.write_palette_indices((0, 0, 0), (width - 1, height - 1, length - 1), &cells)?;
     }
 
     // Block Entities
@@ -294,7 +285,7 @@ pub fn from_mcstructure(data: &[u8]) -> Result<UniversalSchematic> {
     }
 
     // Entities
-    if let Some(NbtValue::List(entities_list)) = structure.get("entities") {
+    if let Some(entities_list) = &structure.entities {
         for tag in entities_list.iter() {
             if let NbtValue::Compound(compound) = tag {
                 // Entity::from_nbt expects quartz_nbt::NbtCompound
@@ -318,33 +309,128 @@ pub fn from_mcstructure(data: &[u8]) -> Result<UniversalSchematic> {
     Ok(schematic)
 }
 
+/// The entries of a `structure` compound that the reader uses.
+#[derive(Default)]
+struct StructureEntries {
+    palette: Option<NbtMap>,
+    /// One index per cell per layer, in file order.
+    block_indices: Option<Vec<Vec<i32>>>,
+    entities: Option<Vec<NbtValue>>,
+}
+
+fn read_structure(cursor: &mut Cursor<&[u8]>) -> Result<StructureEntries> {
+    const LE: Endian = Endian::Little;
+    let mut entries = StructureEntries::default();
+    while let Some((tag, name)) = nbt_io::read_entry_header(cursor, LE)? {
+        match (tag, name.as_str()) {
+            (10, "palette") => {
+                entries.palette = Some(nbt_io::read_compound_payload(cursor, LE)?);
+            }
+            (9, "block_indices") => entries.block_indices = Some(read_layers(cursor)?),
+            (9, "entities") => {
+                if let NbtValue::List(list) = nbt_io::read_payload(cursor, tag, LE)? {
+                    entries.entities = Some(list);
+                }
+            }
+            _ => nbt_io::skip_payload(cursor, tag, LE)?,
+        }
+    }
+    Ok(entries)
+}
+
+/// The layers of a `block_indices` list payload. Elements that are not
+/// lists are dropped, and a layer of anything but ints reads as empty.
+fn read_layers(cursor: &mut Cursor<&[u8]>) -> Result<Vec<Vec<i32>>> {
+    const LE: Endian = Endian::Little;
+    let (tag, count) = nbt_io::read_list_header(cursor, LE)?;
+    let mut layers = Vec::new();
+    for _ in 0..count {
+        if tag != 9 {
+            nbt_io::skip_payload(cursor, tag, LE)?;
+            continue;
+        }
+        let (element, len) = nbt_io::read_list_header(cursor, LE)?;
+        let mut layer = Vec::new();
+        if element == 3 {
+            nbt_io::read_i32s(cursor, len, LE, &mut layer)?;
+        } else {
+            for _ in 0..len {
+                nbt_io::skip_payload(cursor, element, LE)?;
+            }
+        }
+        layers.push(layer);
+    }
+    Ok(layers)
+}
+
+/// One `region` palette index per cell of the `width × height × length`
+/// box, in region storage order (x fastest, then z, then y), from the
+/// Bedrock layers (z fastest, then y, then x). Each Bedrock palette entry
+/// is mapped to the region palette once. Layers apply in order, skipping
+/// negative and out-of-range indices; water over a non-air block
+/// waterlogs it instead of replacing it.
+fn resolve_layers(
+    region: &mut Region,
+    palette: &[BlockState],
+    layers: &[Vec<i32>],
+    (width, height, length): (i32, i32, i32),
+) -> Vec<u32> {
+    if width <= 0 || height <= 0 || length <= 0 {
+        return Vec::new();
+    }
+    let (w, h, l) = (width as usize, height as usize, length as usize);
+    let volume = w * h * l;
+    let air = region.air_index() as u32;
+    let mapped: Vec<u32> = palette
+        .iter()
+        .map(|block| region.get_or_insert_in_palette(block) as u32)
+        .collect();
+    let water: Vec<bool> = palette
+        .iter()
+        .map(|block| block.name == "minecraft:water" || block.name == "minecraft:flowing_water")
+        .collect();
+    // Region index of each block's waterlogged form, made on first use.
+    let mut waterlogged: HashMap<u32, u32> = HashMap::new();
+
+    let mut cells = vec![air; volume];
+    for layer in layers {
+        let layer = &layer[..layer.len().min(volume)];
+        // Each run of `length` indices is one (x, y) column along z.
+        for (column, run) in layer.chunks(l).enumerate() {
+            let (x, y) = (column / h, column % h);
+            for (z, &index) in run.iter().enumerate() {
+                if index < 0 || index as usize >= mapped.len() {
+                    continue;
+                }
+                let cell = &mut cells[(y * l + z) * w + x];
+                let current = *cell;
+                if water[index as usize] && current != air {
+                    *cell = *waterlogged.entry(current).or_insert_with(|| {
+                        let mut block = region.palette[current as usize].clone();
+                        block.set_property("waterlogged", "true");
+                        region.get_or_insert_in_palette(&block) as u32
+                    });
+                } else {
+                    *cell = mapped[index as usize];
+                }
+            }
+        }
+    }
+    cells
+}
+
+/// Write a Bedrock `.mcstructure`.
+///
+/// The palette and block entities are built as NBT values, but the block
+/// index layers are written straight from the region's index buffer as int
+/// runs. Waterlogged blocks get water in the second layer, as Bedrock
+/// stores them.
 pub fn to_mcstructure(schematic: &UniversalSchematic) -> Result<Vec<u8>> {
+    const LE: Endian = Endian::Little;
     let merged_region = schematic.get_merged_region();
     let compact_region = merged_region.to_compact();
     let (width, height, length) = compact_region.get_dimensions();
 
-    let mut root = NbtMap::new();
-    root.insert("format_version".to_string(), NbtValue::Int(1));
-
-    let mut size_list = Vec::new();
-    size_list.push(NbtValue::Int(width));
-    size_list.push(NbtValue::Int(height));
-    size_list.push(NbtValue::Int(length));
-    root.insert("size".to_string(), NbtValue::List(size_list));
-
-    let mut origin_list = Vec::new();
-    origin_list.push(NbtValue::Int(0));
-    origin_list.push(NbtValue::Int(0));
-    origin_list.push(NbtValue::Int(0));
-    root.insert(
-        "structure_world_origin".to_string(),
-        NbtValue::List(origin_list),
-    );
-
-    let mut structure = NbtMap::new();
-
-    // Palette
-    let mut palette_compound = NbtMap::new();
     let mut default_palette = NbtMap::new();
     let mut block_palette_list = Vec::new();
     let mut block_position_data = NbtMap::new();
@@ -421,6 +507,27 @@ pub fn to_mcstructure(schematic: &UniversalSchematic) -> Result<Vec<u8>> {
         block_palette_list.push(NbtValue::Compound(block_entry));
     }
 
+    // Waterlogged blocks keep their liquid in the second layer.
+    let waterlogged: Vec<bool> = compact_region
+        .palette
+        .iter()
+        .map(|block| {
+            block
+                .get_property("waterlogged")
+                .is_some_and(|v| v == "true")
+        })
+        .collect();
+    let water_index = block_palette_list.len() as i32;
+    if waterlogged.contains(&true) {
+        let mut water = NbtMap::new();
+        water.insert("name", NbtValue::String("minecraft:water".to_string()));
+        let mut states = NbtMap::new();
+        states.insert("liquid_depth", NbtValue::Int(0));
+        water.insert("states", NbtValue::Compound(states));
+        water.insert("version", NbtValue::Int(17959425));
+        block_palette_list.push(NbtValue::Compound(water));
+    }
+
     default_palette.insert(
         "block_palette".to_string(),
         NbtValue::List(block_palette_list),
@@ -452,7 +559,7 @@ pub fn to_mcstructure(schematic: &UniversalSchematic) -> Result<Vec<u8>> {
             let translated_map = {
                 let mut bp_compound = HashMap::new();
                 for (k, v) in be_data_map.iter() {
-                    bp_compound.insert(k.clone(), to_bp_nbt(v));
+                    bp_compound.insert(k.to_string(), to_bp_nbt(v));
                 }
                 let translated = BlockEntityTranslator::translate_java_to_bedrock(&bp_compound);
                 let mut out = NbtMap::new();
@@ -475,57 +582,72 @@ pub fn to_mcstructure(schematic: &UniversalSchematic) -> Result<Vec<u8>> {
         "block_position_data".to_string(),
         NbtValue::Compound(block_position_data),
     );
+    let mut palette_compound = NbtMap::new();
     palette_compound.insert("default".to_string(), NbtValue::Compound(default_palette));
-    structure.insert("palette".to_string(), NbtValue::Compound(palette_compound));
-
-    // Block Indices
-    let mut indices_list = Vec::new();
-    let volume = (width * height * length) as usize;
-
-    for x in 0..width {
-        for y in 0..height {
-            for z in 0..length {
-                let abs_x = x + compact_region.position.0;
-                let abs_y = y + compact_region.position.1;
-                let abs_z = z + compact_region.position.2;
-
-                let palette_idx =
-                    if let Some(idx) = compact_region.get_block_index(abs_x, abs_y, abs_z) {
-                        idx as i32
-                    } else {
-                        -1
-                    };
-                indices_list.push(NbtValue::Int(palette_idx));
+
+    // Block indices, read from the region in its storage order (x fastest,
+    // then z, then y) and written in Bedrock's (z fastest, then y, then x).
+    let (w, h, l) = (
+        width.max(0) as usize,
+        height.max(0) as usize,
+        length.max(0) as usize,
+    );
+    let volume = w * h * l;
+    let mut cells = vec![0u32; volume];
+    if volume > 0 {
+        let min = compact_region.position;
+        let max = (min.0 + width - 1, min.1 + height - 1, min.2 + length - 1);
+        compact_region.read_palette_indices(min, max, &mut cells)?;
+    }
+    let mut primary = Vec::with_capacity(volume * 4);
+    let mut secondary = Vec::with_capacity(volume * 4);
+    for x in 0..w {
+        for y in 0..h {
+            for z in 0..l {
+                let index = cells[(y * l + z) * w + x];
+                let liquid = match waterlogged.get(index as usize) {
+                    Some(true) => water_index,
+                    _ => -1,
+                };
+                primary.extend_from_slice(&(index as i32).to_le_bytes());
+                secondary.extend_from_slice(&liquid.to_le_bytes());
             }
         }
     }
+    drop(cells);
 
-    let mut block_indices = Vec::new();
-    block_indices.push(NbtValue::List(indices_list));
-
-    let mut secondary_list = Vec::new();
-    for _ in 0..volume {
-        secondary_list.push(NbtValue::Int(-1));
-    }
-    block_indices.push(NbtValue::List(secondary_list));
-
-    structure.insert("block_indices".to_string(), NbtValue::List(block_indices));
-
-    // Entities
     let mut entities_list = Vec::new();
     for entity in &compact_region.entities {
         if let quartz_nbt::NbtTag::Compound(c) = entity.to_nbt() {
             entities_list.push(NbtValue::Compound(NbtMap::from_quartz_nbt(&c)));
         }
     }
-    structure.insert("entities".to_string(), NbtValue::List(entities_list));
 
-    root.insert("structure".to_string(), NbtValue::Compound(structure));
-
-    let mut cursor = Cursor::new(Vec::new());
-    write_nbt(&mut cursor, &root, "", Endian::Little)?;
+    let int_list = |v: [i32; 3]| NbtValue::List(v.into_iter().map(NbtValue::Int).collect());
+    let mut out = Vec::with_capacity(primary.len() * 2 + 4096);
+    nbt_io::write_root_header(&mut out, "", LE)?;
+    nbt_io::write_entry(&mut out, "format_version", &NbtValue::Int(1), LE)?;
+    nbt_io::write_entry(&mut out, "size", &int_list([width, height, length]), LE)?;
+    nbt_io::write_entry(&mut out, "structure_world_origin", &int_list([0, 0, 0]), LE)?;
+
+    nbt_io::write_entry_header(&mut out, 10, "structure", LE)?;
+    nbt_io::write_entry(
+        &mut out,
+        "palette",
+        &NbtValue::Compound(palette_compound),
+        LE,
+    )?;
+    nbt_io::write_entry_header(&mut out, 9, "block_indices", LE)?;
+    nbt_io::write_list_header(&mut out, 9, 2, LE)?;
+    for layer in [&primary, &secondary] {
+        nbt_io::write_list_header(&mut out, 3, volume, LE)?;
+        out.extend_from_slice(layer);
+    }
+    nbt_io::write_entry(&mut out, "entities", &NbtValue::List(entities_list), LE)?;
+    nbt_io::write_end(&mut out)?;
 
-    Ok(cursor.into_inner())
+    nbt_io::write_end(&mut out)?;
+    Ok(out)
 }
 
 fn to_bp_nbt(val: &NbtValue) -> BpNbtValue {
@@ -544,7 +666,7 @@ fn to_bp_nbt(val: &NbtValue) -> BpNbtValue {
         NbtValue::Compound(v) => {
             let mut map = HashMap::new();
             for (k, val) in v.iter() {
-                map.insert(k.clone(), to_bp_nbt(val));
+                map.insert(k.to_string(), to_bp_nbt(val));
             }
             BpNbtValue::Compound(map)
         }
@@ -1,13 +1,23 @@
 pub mod anvil;
 pub mod classic_schematic;
+pub mod columnar;
 pub mod error;
+pub mod gzip;
 pub mod litematic;
+pub mod lz4_block;
 pub mod manager;
 pub mod mcstructure;
+pub mod packed_longs;
 pub mod schematic;
 pub mod snapshot;
+pub mod snapshot_log;
 pub mod structure_snbt;
 pub mod world;
 #[cfg(not(target_arch = "wasm32"))]
+pub mod world_export;
+#[cfg(not(target_arch = "wasm32"))]
+pub mod world_index;
+#[cfg(not(target_arch = "wasm32"))]
 pub mod world_pack;
 pub mod world_stream;
+pub mod world_zip;
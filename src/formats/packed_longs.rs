@@ -0,0 +1,322 @@
+//! Fixed-width indices packed into `i64` arrays.
+//!
+//! Litematica's `BlockStates` let entries run on across long boundaries;
+//! Anvil block states and heightmaps (since 1.16) keep whole entries per
+//! long and leave the top bits as padding. Both layouts share one codec
+//! here. Widths up to 32 bits go through kernels specialised per width, so
+//! every shift and word offset in a group is a constant.
+
+/// How entries are laid out across longs.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Layout {
+    /// Entries continue from one long into the next (Litematica).
+    Spanning,
+    /// Each long holds `64 / bits` whole entries (Anvil).
+    Aligned,
+}
+
+/// An index type the codec reads and writes. Values wider than the entry
+/// are masked when packed.
+pub trait PackedValue: Copy {
+    fn from_bits(bits: u64) -> Self;
+    fn to_bits(self) -> u64;
+}
+
+macro_rules! impl_packed_value {
+    ($($t:ty),*) => {$(
+        impl PackedValue for $t {
+            #[inline(always)]
+            fn from_bits(bits: u64) -> Self {
+                bits as $t
+            }
+            #[inline(always)]
+            fn to_bits(self) -> u64 {
+                self as u64
+            }
+        }
+    )*};
+}
+
+impl_packed_value!(u16, u32, usize);
+
+/// Bits per entry for a palette of `palette_len` entries, at least
+/// `min_bits`.
+pub fn bits_for(palette_len: usize, min_bits: usize) -> usize {
+    let needed = match palette_len {
+        0 | 1 => 0,
+        n => (usize::BITS - (n - 1).leading_zeros()) as usize,
+    };
+    needed.max(min_bits)
+}
+
+/// Number of longs holding `count` entries of `bits` each.
+pub fn packed_len(count: usize, bits: usize, layout: Layout) -> usize {
+    match layout {
+        Layout::Spanning => (count * bits).div_ceil(64),
+        Layout::Aligned => count.div_ceil(64 / bits),
+    }
+}
+
+/// Run `$body` with `$b` bound to `$bits` as a constant when it is 1..=32,
+/// otherwise run `$fallback`.
+macro_rules! with_const_bits {
+    ($bits:expr, $b:ident => $body:expr, _ => $fallback:expr) => {
+        with_const_bits!(@arms $bits, $b => $body, $fallback;
+            1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16
+            17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32)
+    };
+    (@arms $bits:expr, $b:ident => $body:expr, $fallback:expr; $($n:literal)*) => {
+        match $bits {
+            $($n => {
+                const $b: usize = $n;
+                $body
+            })*
+            _ => $fallback,
+        }
+    };
+}
+
+/// Decode entries into `out`, one per slot. Slots past the end of `packed`
+/// are left as they are.
+pub fn unpack<T: PackedValue>(packed: &[i64], bits: usize, layout: Layout, out: &mut [T]) {
+    assert!((1..=64).contains(&bits), "unsupported entry width {bits}");
+    let done = with_const_bits!(bits, B => match layout {
+        Layout::Spanning => unpack_spanning::<B, T>(packed, out),
+        Layout::Aligned => unpack_aligned::<B, T>(packed, out),
+    }, _ => 0);
+    unpack_scalar(packed, bits, layout, 0, out, done);
+}
+
+/// Decode entries `first..first + out.len()` into `out`, leaving slots past
+/// the end of `packed` as they are. Entries up to the next group boundary
+/// are decoded one at a time; the kernels take the rest.
+pub fn unpack_range<T: PackedValue>(
+    packed: &[i64],
+    bits: usize,
+    layout: Layout,
+    first: usize,
+    out: &mut [T],
+) {
+    assert!((1..=64).contains(&bits), "unsupported entry width {bits}");
+    let group = match layout {
+        Layout::Spanning => 64,
+        Layout::Aligned => 64 / bits,
+    };
+    let head = ((group - first % group) % group).min(out.len());
+    unpack_scalar(packed, bits, layout, first, &mut out[..head], 0);
+
+    let start = first + head;
+    let (word, _) = locate(start, bits, layout);
+    let words = packed.get(word..).unwrap_or_default();
+    let rest = &mut out[head..];
+    let done = with_const_bits!(bits, B => match layout {
+        Layout::Spanning => unpack_spanning::<B, T>(words, rest),
+        Layout::Aligned => unpack_aligned::<B, T>(words, rest),
+    }, _ => 0);
+    unpack_scalar(packed, bits, layout, start, rest, done);
+}
+
+/// Append `values` packed at `bits` per entry to `out`. Calls concatenate
+/// when every earlier call packed a multiple of 64 entries (spanning) or of
+/// `64 / bits` entries (aligned).
+pub fn pack<T: PackedValue>(values: &[T], bits: usize, layout: Layout, out: &mut Vec<i64>) {
+    assert!((1..=64).contains(&bits), "unsupported entry width {bits}");
+    let start = out.len();
+    out.resize(start + packed_len(values.len(), bits, layout), 0);
+    let out = &mut out[start..];
+    let done = with_const_bits!(bits, B => match layout {
+        Layout::Spanning => pack_spanning::<B, T>(values, out),
+        Layout::Aligned => pack_aligned::<B, T>(values, out),
+    }, _ => 0);
+    pack_scalar(values, bits, layout, out, done);
+}
+
+#[inline(always)]
+const fn mask(bits: usize) -> u64 {
+    if bits == 64 {
+        u64::MAX
+    } else {
+        (1 << bits) - 1
+    }
+}
+
+/// Word and bit offset of entry `index`.
+#[inline(always)]
+fn locate(index: usize, bits: usize, layout: Layout) -> (usize, usize) {
+    match layout {
+        Layout::Spanning => (index * bits / 64, index * bits % 64),
+        Layout::Aligned => {
+            let per_long = 64 / bits;
+            (index / per_long, index % per_long * bits)
+        }
+    }
+}
+
+/// Every 64 entries fill exactly `BITS` longs, so each group decodes with
+/// constant shifts. Returns the number of entries decoded.
+fn unpack_spanning<const BITS: usize, T: PackedValue>(packed: &[i64], out: &mut [T]) -> usize {
+    let mut done = 0;
+    for (group, words) in out.chunks_exact_mut(64).zip(packed.chunks_exact(BITS)) {
+        for (i, slot) in group.iter_mut().enumerate() {
+            let (word, offset) = (i * BITS / 64, i * BITS % 64);
+            let mut value = words[word] as u64 >> offset;
+            if offset + BITS > 64 {
+                value |= (words[word + 1] as u64) << (64 - offset);
+            }
+            *slot = T::from_bits(value & mask(BITS));
+        }
+        done += 64;
+    }
+    done
+}
+
+fn unpack_aligned<const BITS: usize, T: PackedValue>(packed: &[i64], out: &mut [T]) -> usize {
+    let per_long = 64 / BITS;
+    let mut done = 0;
+    for (group, &word) in out.chunks_exact_mut(per_long).zip(packed) {
+        for (i, slot) in group.iter_mut().enumerate() {
+            *slot = T::from_bits((word as u64 >> (i * BITS)) & mask(BITS));
+        }
+        done += per_long;
+    }
+    done
+}
+
+fn pack_spanning<const BITS: usize, T: PackedValue>(values: &[T], out: &mut [i64]) -> usize {
+    let mut done = 0;
+    for (group, words) in values.chunks_exact(64).zip(out.chunks_exact_mut(BITS)) {
+        let mut acc = [0u64; BITS];
+        for (i, &value) in group.iter().enumerate() {
+            let (word, offset) = (i * BITS / 64, i * BITS % 64);
+            let value = value.to_bits() & mask(BITS);
+            acc[word] |= value << offset;
+            if offset + BITS > 64 {
+                acc[word + 1] |= value >> (64 - offset);
+            }
+        }
+        for (word, acc) in words.iter_mut().zip(acc) {
+            *word = acc as i64;
+        }
+        done += 64;
+    }
+    done
+}
+
+fn pack_aligned<const BITS: usize, T: PackedValue>(values: &[T], out: &mut [i64]) -> usize {
+    let per_long = 64 / BITS;
+    let mut done = 0;
+    for (group, word) in values.chunks_exact(per_long).zip(out) {
+        let mut acc = 0u64;
+        for (i, &value) in group.iter().enumerate() {
+            acc |= (value.to_bits() & mask(BITS)) << (i * BITS);
+        }
+        *word = acc as i64;
+        done += per_long;
+    }
+    done
+}
+
+/// Decode `out[start..]`, one entry at a time. Slot `i` holds entry
+/// `first + i`.
+fn unpack_scalar<T: PackedValue>(
+    packed: &[i64],
+    bits: usize,
+    layout: Layout,
+    first: usize,
+    out: &mut [T],
+    start: usize,
+) {
+    for (index, slot) in out.iter_mut().enumerate().skip(start) {
+        let (word, offset) = locate(first + index, bits, layout);
+        let Some(&low) = packed.get(word) else {
+            return;
+        };
+        let mut value = low as u64 >> offset;
+        if offset + bits > 64 {
+            value |= packed.get(word + 1).map_or(0, |&high| high as u64) << (64 - offset);
+        }
+        *slot = T::from_bits(value & mask(bits));
+    }
+}
+
+/// Pack `values[start..]` into zeroed `out`, one entry at a time.
+fn pack_scalar<T: PackedValue>(
+    values: &[T],
+    bits: usize,
+    layout: Layout,
+    out: &mut [i64],
+    start: usize,
+) {
+    for (index, &value) in values.iter().enumerate().skip(start) {
+        let (word, offset) = locate(index, bits, layout);
+        let value = value.to_bits() & mask(bits);
+        out[word] |= (value << offset) as i64;
+        if offset + bits > 64 {
+            out[word + 1] |= (value >> (64 - offset)) as i64;
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn kernels_match_the_scalar_codec_at_every_width() {
+        for layout in [Layout::Spanning, Layout::Aligned] {
+            for bits in 1..=40 {
+                // Enough entries for several groups plus a ragged tail.
+                let count = 64 * 3 + 29;
+                let values: Vec<u64> = (0..count as u64)
+                    .map(|i| i.wrapping_mul(0x9E37_79B9_7F4A_7C15) & mask(bits))
+                    .collect();
+                let values: Vec<usize> = values.iter().map(|&v| v as usize).collect();
+
+                let mut packed = Vec::new();
+                pack(&values, bits, layout, &mut packed);
+                let mut reference = vec![0i64; packed_len(count, bits, layout)];
+                pack_scalar(&values, bits, layout, &mut reference, 0);
+                assert_eq!(packed, reference, "{layout:?} pack at {bits} bits");
+
+                let mut unpacked = vec![0usize; count];
+                unpack(&packed, bits, layout, &mut unpacked);
+                assert_eq!(unpacked, values, "{layout:?} unpack at {bits} bits");
+            }
+        }
+    }
+
+    #[test]
+    fn ranges_decode_from_any_entry() {
+        for layout in [Layout::Spanning, Layout::Aligned] {
+            for bits in [1, 5, 13, 31, 32] {
+                let count = 64 * 4 + 11;
+                let values: Vec<u32> = (0..count as u64)
+                    .map(|i| (i.wrapping_mul(0x9E37_79B9) & mask(bits)) as u32)
+                    .collect();
+                let mut packed = Vec::new();
+                pack(&values, bits, layout, &mut packed);
+
+                for (first, len) in [(0, count), (3, 70), (64, 64), (100, 167), (count - 1, 1)] {
+                    let mut out = vec![0u32; len];
+                    unpack_range(&packed, bits, layout, first, &mut out);
+                    assert_eq!(
+                        out,
+                        values[first..first + len],
+                        "{layout:?} {bits} bits @ {first}"
+                    );
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn short_input_leaves_the_remaining_slots() {
+        let mut out = [7u16; 20];
+        unpack(&[-1], 5, Layout::Spanning, &mut out);
+        // Twelve entries fit the one long; the thirteenth straddles into the
+        // missing second long and keeps only its low bits.
+        assert_eq!(out[..12], [31; 12]);
+        assert_eq!(out[12], 15);
+        assert_eq!(out[13..], [7; 7]);
+    }
+}
@@ -1,17 +1,24 @@
 use smol_str::SmolStr;
 use std::collections::HashMap;
 use std::fmt;
-use std::io::{BufReader, Read};
+use std::io::{BufRead, BufReader, Read};
+use std::ops::Range;
 
 use crate::block_entity::BlockEntity;
+use crate::block_entity_store::BlockEntityInterner;
+use crate::block_storage::BlockStorage;
+use crate::bounding_box::BoundingBox;
 use crate::entity::Entity;
+use crate::entity_store::EntityInterner;
 use crate::formats::error::Result;
+use crate::formats::gzip::{self, GzipOptions};
+use crate::metadata::Metadata;
+use crate::nbt::view as nbt_view;
+use crate::nbt::{io as nbt_io, Endian, NbtMap, NbtValue};
 use crate::region::Region;
 use crate::{BlockState, UniversalSchematic};
 use flate2::read::GzDecoder;
-use flate2::write::GzEncoder;
 use flate2::Compression;
-use quartz_nbt::io::{read_nbt, Flavor};
 use quartz_nbt::{NbtCompound, NbtList, NbtTag};
 
 // enum for versions of schematics
@@ -52,36 +59,8 @@ impl fmt::Display for SchematicVersion {
 }
 
 pub fn is_schematic(data: &[u8]) -> bool {
-    // Decompress the data
-    let reader = BufReader::with_capacity(1 << 20, data); // 1 MiB buf
-    let mut gz = GzDecoder::new(reader);
-    let (root, _) = match read_nbt(&mut gz, Flavor::Uncompressed) {
-        Ok(result) => result,
-        Err(_) => {
-            return false;
-        }
-    };
-
-    //things should be under Schematic tag if not treat root as the schematic
-    let root = root.get::<_, &NbtCompound>("Schematic").unwrap_or(&root);
-
-    // get tge version of the schematic
-    let version = root.get::<_, i32>("Version");
-    if version.is_err() {
-        return root.get::<_, &NbtCompound>("Blocks").is_ok();
-    }
-
-    // Check if it's a v3 schematic (which has a Blocks compound)
-    if version.unwrap() == 3 {
-        return root.get::<_, &NbtCompound>("Blocks").is_ok();
-    }
-
-    // Otherwise check for v2 format
-    root.get::<_, i32>("DataVersion").is_ok()
-        && root.get::<_, i16>("Width").is_ok()
-        && root.get::<_, i16>("Height").is_ok()
-        && root.get::<_, i16>("Length").is_ok()
-        && root.get::<_, &Vec<i8>>("BlockData").is_ok()
+    // Headers only: block data, palettes and entity lists are skipped.
+    read_sponge_fields(data, SpongeRead::Detect, None).is_ok_and(|fields| fields.is_sponge())
 }
 
 /// Default compression level for schematic serialization.
@@ -103,8 +82,9 @@ pub fn to_schematic_version(
 pub fn to_schematic_with_options(
     schematic: &UniversalSchematic,
     version: SchematicVersion,
-    compression: Compression,
+    compression: impl Into<GzipOptions>,
 ) -> Result<Vec<u8>> {
+    let compression = compression.into();
     match version {
         SchematicVersion::V2 => to_schematic_v2(schematic, compression),
         SchematicVersion::V3 => to_schematic_v3(schematic, compression),
@@ -112,7 +92,7 @@ pub fn to_schematic_with_options(
 }
 
 // Version 3 format (recommended)
-fn to_schematic_v3(schematic: &UniversalSchematic, compression: Compression) -> Result<Vec<u8>> {
+fn to_schematic_v3(schematic: &UniversalSchematic, compression: GzipOptions) -> Result<Vec<u8>> {
     let mut schematic_data = NbtCompound::new();
 
     // Version 3 format
@@ -151,7 +131,7 @@ fn to_schematic_v3(schematic: &UniversalSchematic, compression: Compression) ->
     let remapped_blocks: Vec<u32> = compact_region
         .blocks
         .iter()
-        .map(|&original_id| {
+        .map(|original_id| {
             if original_id < palette_mapping.len() {
                 palette_mapping[original_id] as u32
             } else {
@@ -163,9 +143,7 @@ fn to_schematic_v3(schematic: &UniversalSchematic, compression: Compression) ->
 
     // Encode remapped block data — preallocated to avoid per-block Vec allocations
     let mut block_data: Vec<u8> = Vec::with_capacity(remapped_blocks.len() * 2);
-    for &block_id in &remapped_blocks {
-        encode_varint_into(block_id, &mut block_data);
-    }
+    encode_varints_into(&remapped_blocks, &mut block_data);
 
     // Add block data to Blocks container (renamed from "BlockData" to "Data" in v3)
     // SAFETY: u8 and i8 have identical size, alignment, and representation
@@ -202,18 +180,11 @@ fn to_schematic_v3(schematic: &UniversalSchematic, compression: Compression) ->
     let mut root = NbtCompound::new();
     root.insert("Schematic", NbtTag::Compound(schematic_data));
 
-    let mut encoder = GzEncoder::new(Vec::new(), compression);
-    quartz_nbt::io::write_nbt(
-        &mut encoder,
-        None,
-        &root,
-        quartz_nbt::io::Flavor::Uncompressed,
-    )?;
-    Ok(encoder.finish()?)
+    gzip::write_nbt(&root, compression)
 }
 
 // Version 2 format (legacy compatibility)
-fn to_schematic_v2(schematic: &UniversalSchematic, compression: Compression) -> Result<Vec<u8>> {
+fn to_schematic_v2(schematic: &UniversalSchematic, compression: GzipOptions) -> Result<Vec<u8>> {
     let mut schematic_data = NbtCompound::new();
 
     schematic_data.insert("Version", NbtTag::Int(2)); // Schematic format version 2
@@ -245,8 +216,12 @@ fn to_schematic_v2(schematic: &UniversalSchematic, compression: Compression) ->
 
     // Encode block data — preallocated to avoid per-block Vec allocations
     let mut block_data: Vec<u8> = Vec::with_capacity(compact_region.blocks.len() * 2);
-    for &block_id in &compact_region.blocks {
-        encode_varint_into(block_id as u32, &mut block_data);
+    let total = compact_region.blocks.len();
+    let mut ids = [0u32; 4096];
+    for start in (0..total).step_by(ids.len()) {
+        let n = (total - start).min(ids.len());
+        compact_region.blocks.read_into_u32(start, &mut ids[..n]);
+        encode_varints_into(&ids[..n], &mut block_data);
     }
 
     // SAFETY: u8 and i8 have identical size, alignment, and representation
@@ -278,14 +253,7 @@ fn to_schematic_v2(schematic: &UniversalSchematic, compression: Compression) ->
     let mut root = NbtCompound::new();
     root.insert("Schematic", NbtTag::Compound(schematic_data));
 
-    let mut encoder = GzEncoder::new(Vec::new(), compression);
-    quartz_nbt::io::write_nbt(
-        &mut encoder,
-        None,
-        &root,
-        quartz_nbt::io::Flavor::Uncompressed,
-    )?;
-    Ok(encoder.finish()?)
+    gzip::write_nbt(&root, compression)
 }
 
 // Palette conversion for v3 (creates clean sequential indices)
@@ -395,17 +363,487 @@ fn convert_palette_v2(palette: &Vec<BlockState>) -> (NbtCompound, i32) {
 
     (nbt_palette, max_id)
 }
+/// Fields of a Sponge schematic gathered in one streaming pass. The v3
+/// `Schematic` wrapper and the `Blocks` container are walked into; anything
+/// else is skipped without being built.
+#[derive(Default)]
+struct SpongeFields {
+    version: Option<i32>,
+    data_version: Option<i32>,
+    width: Option<i16>,
+    height: Option<i16>,
+    length: Option<i16>,
+    metadata: Option<NbtCompound>,
+    palette: Option<NbtCompound>,
+    palette_max: Option<i32>,
+    /// Decoded cells and the number of indices read.
+    blocks: Option<(BlockStorage, usize)>,
+    has_v2_block_data: bool,
+    has_blocks_container: bool,
+    /// The `BlockEntities` list payload as read, viewed in place later.
+    block_entities: Option<Vec<u8>>,
+    entities: Option<Vec<NbtCompound>>,
+    /// Set before a full walk to keep only the cells inside this box.
+    clip: Option<BoundingBox>,
+}
+
+impl SpongeFields {
+    fn is_sponge(&self) -> bool {
+        match self.version {
+            // No version, or v3: a Blocks compound
+            None | Some(3) => self.has_blocks_container,
+            // Otherwise the v2 fields
+            Some(_) => {
+                self.data_version.is_some()
+                    && self.width.is_some()
+                    && self.height.is_some()
+                    && self.length.is_some()
+                    && self.has_v2_block_data
+            }
+        }
+    }
+
+    /// Whether the walk can stop before the end of the file.
+    fn is_done(&self, mode: SpongeRead) -> bool {
+        match mode {
+            SpongeRead::Detect => self.version.is_some() && self.is_sponge(),
+            SpongeRead::Probe => {
+                self.version.is_some()
+                    && self.data_version.is_some()
+                    && self.width.is_some()
+                    && self.height.is_some()
+                    && self.length.is_some()
+                    && self.metadata.is_some()
+            }
+            SpongeRead::Full => false,
+        }
+    }
+}
+
+/// How much of a Sponge schematic to read.
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum SpongeRead {
+    /// Scalars and which containers exist, stopping once the format is
+    /// certain.
+    Detect,
+    /// Scalars and `Metadata`, stopping once all of them are seen.
+    Probe,
+    /// Everything, with the block data decoded.
+    Full,
+}
+
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum SpongeLevel {
+    Root,
+    Schematic,
+    Blocks,
+}
+
+/// Stream the gzip-compressed NBT of a Sponge schematic, reading as much
+/// as `mode` asks for.
+fn read_sponge_fields<R: Read>(
+    data: R,
+    mode: SpongeRead,
+    clip: Option<&BoundingBox>,
+) -> Result<SpongeFields> {
+    let mut reader = BufReader::with_capacity(1 << 16, GzDecoder::new(data));
+    nbt_io::read_root_header(&mut reader, Endian::Big)?;
+    let mut fields = SpongeFields {
+        clip: clip.cloned(),
+        ..Default::default()
+    };
+    walk_sponge_compound(&mut reader, SpongeLevel::Root, mode, &mut fields)?;
+    Ok(fields)
+}
+
+/// Walk one compound. Once `fields` is done for `mode` every level returns
+/// at once, leaving the stream mid-compound.
+fn walk_sponge_compound<R: BufRead>(
+    r: &mut R,
+    level: SpongeLevel,
+    mode: SpongeRead,
+    fields: &mut SpongeFields,
+) -> Result<()> {
+    const BIG: Endian = Endian::Big;
+    let full = mode == SpongeRead::Full;
+    while !fields.is_done(mode) {
+        let Some((tag, name)) = nbt_io::read_entry_header(r, BIG)? else {
+            break;
+        };
+        match (tag, name.as_str()) {
+            (10, "Schematic") if level == SpongeLevel::Root => {
+                walk_sponge_compound(r, SpongeLevel::Schematic, mode, fields)?
+            }
+            (10, "Blocks") if level != SpongeLevel::Blocks => {
+                fields.has_blocks_container = true;
+                walk_sponge_compound(r, SpongeLevel::Blocks, mode, fields)?
+            }
+            (3, "Version") => fields.version = Some(nbt_io::read_i32(r, BIG)?),
+            (3, "DataVersion") => fields.data_version = Some(nbt_io::read_i32(r, BIG)?),
+            (3, "PaletteMax") => fields.palette_max = Some(nbt_io::read_i32(r, BIG)?),
+            (2, "Width") => fields.width = Some(nbt_io::read_i16(r, BIG)?),
+            (2, "Height") => fields.height = Some(nbt_io::read_i16(r, BIG)?),
+            (2, "Length") => fields.length = Some(nbt_io::read_i16(r, BIG)?),
+            (7, "BlockData" | "Data") if !full => {
+                fields.has_v2_block_data |= name == "BlockData";
+                nbt_io::skip_payload(r, tag, BIG)?
+            }
+            (7, "BlockData" | "Data") if fields.clip.is_some() => {
+                let len = nbt_io::read_len(r, BIG)?;
+                let (Some(w), Some(h), Some(l)) = (fields.width, fields.height, fields.length)
+                else {
+                    return Err("Bounded loading needs the dimensions before the block data".into());
+                };
+                let size = (w as u16 as usize, h as u16 as usize, l as u16 as usize);
+                let clip = fields.clip.as_ref().unwrap();
+                fields.blocks = Some(read_block_data_clipped(
+                    r,
+                    len,
+                    size,
+                    clip,
+                    fields.palette_max,
+                )?);
+            }
+            (7, "BlockData" | "Data") => {
+                let len = nbt_io::read_len(r, BIG)?;
+                // Dimensions usually precede the cells; if they do not, the
+                // cells are appended and checked against them afterwards.
+                let volume = match (fields.width, fields.height, fields.length) {
+                    (Some(w), Some(h), Some(l)) => (w as u32 as usize)
+                        .checked_mul(h as u32 as usize)
+                        .and_then(|wh| wh.checked_mul(l as u32 as usize)),
+                    _ => None,
+                };
+                fields.blocks = Some(read_block_data(r, len, volume, fields.palette_max)?);
+            }
+            (10, "Metadata") if mode != SpongeRead::Detect => {
+                fields.metadata = Some(nbt_io::read_compound_payload(r, BIG)?.to_quartz_nbt())
+            }
+            (10, "Palette") if full => {
+                fields.palette = Some(nbt_io::read_compound_payload(r, BIG)?.to_quartz_nbt())
+            }
+            (9, "BlockEntities") if full => {
+                let mut raw = Vec::new();
+                nbt_io::read_payload_bytes(r, tag, BIG, &mut raw)?;
+                fields.block_entities = Some(raw);
+            }
+            (9, "Entities") if full && level != SpongeLevel::Blocks => {
+                fields.entities = Some(read_compound_list(r)?)
+            }
+            _ => nbt_io::skip_payload(r, tag, BIG)?,
+        }
+    }
+    Ok(())
+}
+
+/// The compound elements of a list payload.
+fn read_compound_list<R: Read>(r: &mut R) -> Result<Vec<NbtCompound>> {
+    let NbtValue::List(items) = nbt_io::read_payload(r, 9, Endian::Big)? else {
+        return Ok(Vec::new());
+    };
+    Ok(items
+        .into_iter()
+        .filter_map(|item| match item {
+            NbtValue::Compound(map) => Some(map.to_quartz_nbt()),
+            _ => None,
+        })
+        .collect())
+}
+
+/// Bytes per lane of the single-byte varint fast paths.
+const VARINT_LANE: usize = 16;
+
+/// Length of the leading run of whole lanes in `bytes` with no continuation
+/// bit set, each lane checked as one 128-bit word.
+#[inline]
+fn single_byte_run(bytes: &[u8]) -> usize {
+    bytes
+        .chunks_exact(VARINT_LANE)
+        .take_while(|lane| {
+            let word = u128::from_ne_bytes((*lane).try_into().unwrap());
+            word & u128::from_ne_bytes([0x80; VARINT_LANE]) == 0
+        })
+        .count()
+        * VARINT_LANE
+}
+
+/// Decode `len` bytes of varint palette indices straight from the stream.
+/// When the volume is already known the cells are allocated once and
+/// written in place (indices past the volume are only counted); otherwise
+/// they are appended. Returns the cells and the number of indices read.
+fn read_block_data<R: BufRead>(
+    r: &mut R,
+    len: usize,
+    volume: Option<usize>,
+    palette_max: Option<i32>,
+) -> Result<(BlockStorage, usize)> {
+    let mut blocks = match volume {
+        Some(volume) => BlockStorage::try_filled(volume, 0)
+            .map_err(|e| format!("Cannot allocate {} blocks: {}", volume, e))?,
+        None => BlockStorage::new(),
+    };
+    if let Some(max) = palette_max {
+        blocks.ensure_holds(max.max(0) as usize);
+    }
+
+    let mut remaining = len;
+    let mut count = 0;
+    let mut value = 0u32;
+    let mut shift = 0;
+    while remaining > 0 {
+        let buf = r.fill_buf()?;
+        if buf.is_empty() {
+            return Err("Block data is truncated".into());
+        }
+        let take = buf.len().min(remaining);
+        let mut bytes = &buf[..take];
+        while let Some((&byte, rest)) = bytes.split_first() {
+            // Between varints, whole lanes of single-byte varints are the
+            // indices themselves.
+            if shift == 0 {
+                let run = single_byte_run(bytes);
+                if run > 0 {
+                    match volume {
+                        // Past the volume the indices are only counted,
+                        // as on the scalar path below.
+                        Some(volume) if count < volume => {
+                            let fits = run.min(volume - count);
+                            blocks.copy_from_u8(count, &bytes[..fits]);
+                        }
+                        Some(_) => {}
+                        None => blocks.extend_from_u8(&bytes[..run]),
+                    }
+                    count += run;
+                    bytes = &bytes[run..];
+                    continue;
+                }
+            }
+            bytes = rest;
+            value |= ((byte & 0x7F) as u32) << shift;
+            if byte & 0x80 != 0 {
+                shift += 7;
+                if shift >= 32 {
+                    return Err("Varint is too long".into());
+                }
+                continue;
+            }
+            match volume {
+                Some(volume) if count < volume => blocks.set(count, value as usize),
+                Some(_) => {}
+                None => blocks.push(value as usize),
+            }
+            count += 1;
+            value = 0;
+            shift = 0;
+        }
+        r.consume(take);
+        remaining -= take;
+    }
+    Ok((blocks, count))
+}
+
+/// Walks a Sponge volume in storage order (x, then z, then y) and maps each
+/// cell into the kept box.
+struct ClipCursor {
+    size: (usize, usize, usize),
+    min: (usize, usize, usize),
+    max: (usize, usize, usize),
+    pos: (usize, usize, usize),
+}
+
+impl ClipCursor {
+    fn new(size: (usize, usize, usize), keep: &BoundingBox) -> Self {
+        let corner = |(x, y, z): (i32, i32, i32)| (x as usize, y as usize, z as usize);
+        ClipCursor {
+            size,
+            min: corner(keep.min),
+            max: corner(keep.max),
+            pos: (0, 0, 0),
+        }
+    }
+
+    /// How many of the next `n` cells stay in the current row, and where the
+    /// ones inside the box go: their index in the box and their offsets
+    /// within the run.
+    fn row_span(&self, n: usize) -> (usize, Option<(usize, Range<usize>)>) {
+        let (min, max) = (self.min, self.max);
+        let (x, y, z) = self.pos;
+        let span = n.min(self.size.0 - x);
+        if y < min.1 || y > max.1 || z < min.2 || z > max.2 {
+            return (span, None);
+        }
+        let (from, to) = (x.max(min.0), (x + span).min(max.0 + 1));
+        if from >= to {
+            return (span, None);
+        }
+        let (kept_width, kept_length) = (max.0 - min.0 + 1, max.2 - min.2 + 1);
+        let dest = ((y - min.1) * kept_length + (z - min.2)) * kept_width + (from - min.0);
+        (span, Some((dest, from - x..to - x)))
+    }
+
+    /// Step over `n` cells, which must not run past the end of the row.
+    fn advance(&mut self, n: usize) {
+        self.pos.0 += n;
+        if self.pos.0 == self.size.0 {
+            self.pos.0 = 0;
+            self.pos.2 += 1;
+            if self.pos.2 == self.size.2 {
+                self.pos.2 = 0;
+                self.pos.1 += 1;
+            }
+        }
+    }
+
+    fn past_box(&self) -> bool {
+        self.pos.1 > self.max.1
+    }
+}
+
+/// Like [`read_block_data`], but keeps only the cells inside `clip` and
+/// stops decoding once the stream has passed it; the rest of the payload is
+/// skipped unread. Returns the kept cells and their count.
+fn read_block_data_clipped<R: BufRead>(
+    r: &mut R,
+    len: usize,
+    size: (usize, usize, usize),
+    clip: &BoundingBox,
+    palette_max: Option<i32>,
+) -> Result<(BlockStorage, usize)> {
+    let (width, height, length) = size;
+    let full = BoundingBox::new(
+        (0, 0, 0),
+        (width as i32 - 1, height as i32 - 1, length as i32 - 1),
+    );
+    let keep = match full.intersection(clip) {
+        Some(keep) if width * height * length > 0 => keep,
+        _ => {
+            skip_bytes(r, len)?;
+            return Ok((BlockStorage::new(), 0));
+        }
+    };
+    let (kept_width, kept_height, kept_length) = keep.get_dimensions();
+    let volume = kept_width as usize * kept_height as usize * kept_length as usize;
+    let mut blocks = BlockStorage::try_filled(volume, 0)
+        .map_err(|e| format!("Cannot allocate {} blocks: {}", volume, e))?;
+    if let Some(max) = palette_max {
+        blocks.ensure_holds(max.max(0) as usize);
+    }
+
+    let mut cursor = ClipCursor::new(size, &keep);
+    let mut remaining = len;
+    let mut value = 0u32;
+    let mut shift = 0;
+    while remaining > 0 && !cursor.past_box() {
+        let buf = r.fill_buf()?;
+        if buf.is_empty() {
+            return Err("Block data is truncated".into());
+        }
+        let take = buf.len().min(remaining);
+        let mut bytes = &buf[..take];
+        while !bytes.is_empty() && !cursor.past_box() {
+            if shift == 0 {
+                let run = single_byte_run(bytes);
+                if run > 0 {
+                    let (span, kept) = cursor.row_span(run);
+                    if let Some((dest, offsets)) = kept {
+                        blocks.copy_from_u8(dest, &bytes[offsets]);
+                    }
+                    cursor.advance(span);
+                    bytes = &bytes[span..];
+                    continue;
+                }
+            }
+            let byte = bytes[0];
+            bytes = &bytes[1..];
+            value |= ((byte & 0x7F) as u32) << shift;
+            if byte & 0x80 != 0 {
+                shift += 7;
+                if shift >= 32 {
+                    return Err("Varint is too long".into());
+                }
+                continue;
+            }
+            if let (_, Some((dest, _))) = cursor.row_span(1) {
+                blocks.set(dest, value as usize);
+            }
+            cursor.advance(1);
+            value = 0;
+            shift = 0;
+        }
+        let used = take - bytes.len();
+        r.consume(used);
+        remaining -= used;
+    }
+    if !cursor.past_box() {
+        return Err("Block data ends before the requested box".into());
+    }
+    skip_bytes(r, remaining)?;
+    Ok((blocks, volume))
+}
+
+fn skip_bytes<R: BufRead>(r: &mut R, len: usize) -> Result<()> {
+    let skipped = std::io::copy(&mut r.by_ref().take(len as u64), &mut std::io::sink())?;
+    if skipped != len as u64 {
+        return Err("Block data is truncated".into());
+    }
+    Ok(())
+}
+
+/// Probe a Sponge schematic from its dimensions and `Metadata`, without
+/// reading the palette or block data.
+pub fn probe_schematic(data: &[u8]) -> Result<SchematicInfo> {
+    probe_schematic_reader(data)
+}
+
+/// [`probe_schematic`] over a stream of the gzip-compressed file. Reading
+/// stops once the dimensions and `Metadata` are seen.
+pub fn probe_schematic_reader<R: Read>(reader: R) -> Result<SchematicInfo> {
+    let fields = read_sponge_fields(reader, SpongeRead::Probe, None)?;
+    let mut info = SchematicInfo {
+        format_version: Some(fields.version.ok_or("Missing Version")?),
+        region_count: Some(1),
+        ..Default::default()
+    };
+    if let (Some(w), Some(h), Some(l)) = (fields.width, fields.height, fields.length) {
+        // Sponge sizes are unsigned shorts.
+        info.dimensions = Some((w as u16 as i32, h as u16 as i32, l as u16 as i32));
+    }
+    if let Some(metadata) = &fields.metadata {
+        info.metadata = Metadata::from_nbt(metadata)?;
+        // WorldEdit records the creation time as `Date`.
+        if info.metadata.created.is_none() {
+            info.metadata.created = metadata.get::<_, i64>("Date").ok().map(|t| t as u64);
+        }
+    }
+    info.metadata.mc_version = fields.data_version.or(info.metadata.mc_version);
+    Ok(info)
+}
+
 pub fn from_schematic(data: &[u8]) -> Result<UniversalSchematic> {
-    let reader = BufReader::with_capacity(1 << 20, data); // 1 MiB buf
-    let mut gz = GzDecoder::new(reader);
-    let (root, _) = read_nbt(&mut gz, Flavor::Uncompressed)?;
+    from_schematic_impl(data, None)
+}
 
-    let schem = root.get::<_, &NbtCompound>("Schematic").unwrap_or(&root);
-    let schem_version = schem.get::<_, i32>("Version")?;
+/// [`from_schematic`] over a stream of the gzip-compressed file, decoded as
+/// it arrives rather than buffered first.
+pub fn from_schematic_reader<R: Read>(reader: R) -> Result<UniversalSchematic> {
+    from_schematic_impl(reader, None)
+}
+
+/// Load only the part of a Sponge schematic inside `bounds`, given in
+/// schematic coordinates. Cells are still scanned in order up to the end of
+/// the box, but only the box is stored, and entities outside it are
+/// dropped. The region is placed at the box's corner.
+pub fn from_schematic_bounded(data: &[u8], bounds: &BoundingBox) -> Result<UniversalSchematic> {
+    from_schematic_impl(data, Some(bounds))
+}
+
+fn from_schematic_impl<R: Read>(data: R, clip: Option<&BoundingBox>) -> Result<UniversalSchematic> {
+    let fields = read_sponge_fields(data, SpongeRead::Full, clip)?;
+    fields.version.ok_or("Missing Version")?;
 
     let mut definition_regions = HashMap::new();
 
-    let name = if let Ok(metadata) = schem.get::<_, &NbtCompound>("Metadata") {
+    let name = if let Some(metadata) = &fields.metadata {
         if let Ok(json) = metadata.get::<_, &str>("NucleationDefinitions") {
             if let Ok(regions) = serde_json::from_str(json) {
                 definition_regions = regions;
@@ -417,7 +855,7 @@ pub fn from_schematic(data: &[u8]) -> Result<UniversalSchematic> {
     }
     .unwrap_or_else(|| "Unnamed".to_string());
 
-    let mc_version = schem.get::<_, i32>("DataVersion").ok();
+    let mc_version = fields.data_version;
 
     let mut schematic = UniversalSchematic::new(name);
     schematic.definition_regions = definition_regions;
@@ -425,42 +863,68 @@ pub fn from_schematic(data: &[u8]) -> Result<UniversalSchematic> {
     // The Sponge `DataVersion` is the file's source version for conversion.
     schematic.metadata.source_data_version = mc_version;
 
-    let width = schem.get::<_, i16>("Width")? as u32;
-    let height = schem.get::<_, i16>("Height")? as u32;
-    let length = schem.get::<_, i16>("Length")? as u32;
-
-    let block_container = if schem_version == 2 {
-        schem
-    } else {
-        schem.get::<_, &NbtCompound>("Blocks")?
-    };
+    let width = fields.width.ok_or("Missing Width")? as u32;
+    let height = fields.height.ok_or("Missing Height")? as u32;
+    let length = fields.length.ok_or("Missing Length")? as u32;
 
-    let block_palette = parse_block_palette(block_container)?;
+    let palette = fields.palette.as_ref().ok_or("Missing Palette")?;
+    let block_palette = parse_block_palette(palette, fields.palette_max)?;
 
-    let block_data = parse_block_data(block_container, width, height, length)?;
-
-    let mut region = Region::new(
-        "Main".to_string(),
+    let (blocks, count) = fields.blocks.ok_or("Missing block data")?;
+    let full = BoundingBox::new(
         (0, 0, 0),
-        (width as i32, height as i32, length as i32),
+        (width as i32 - 1, height as i32 - 1, length as i32 - 1),
     );
-    region.palette = block_palette;
-    region.blocks = block_data.iter().map(|&x| x as usize).collect();
+    let keep = match clip {
+        Some(clip) => match full.intersection(clip) {
+            Some(keep) => keep,
+            None => return Ok(schematic),
+        },
+        None => full,
+    };
+    let expected_length = (width * height * length) as usize;
+    if clip.is_none() && (count != expected_length || blocks.len() != expected_length) {
+        return Err(format!(
+            "Block data length mismatch: expected {}, got {}",
+            expected_length, count
+        )
+        .into());
+    }
 
-    // Rebuild caches after directly setting palette and blocks
-    region.rebuild_palette_index();
-    region.rebuild_air_index();
+    // The cells were decoded straight into their final storage; only the
+    // counts that depend on the palette's air entry are rebuilt.
+    let mut region = Region::from_parts(
+        "Main".to_string(),
+        keep.min,
+        keep.get_dimensions(),
+        blocks,
+        block_palette,
+        Vec::new(),
+        Default::default(),
+        0,
+        None,
+    );
     region.rebuild_non_air_count();
     region.rebuild_tight_bounds();
 
-    let block_entities = parse_block_entities(block_container)?;
-    for block_entity in block_entities {
-        region.add_block_entity(block_entity);
+    let block_entities = fields.block_entities.ok_or("Missing BlockEntities")?;
+    let mut interner = BlockEntityInterner::new();
+    for mut block_entity in parse_block_entities(&block_entities)? {
+        let pos = block_entity.position;
+        if clip.is_none() || keep.contains(pos) {
+            block_entity.strip_position_keys();
+            region
+                .block_entities
+                .insert_shared(pos, interner.intern(block_entity));
+        }
     }
 
-    let entities = parse_entities(schem)?;
+    let entities = parse_entities(fields.entities.as_deref().unwrap_or_default())?;
     for entity in entities {
-        region.add_entity(entity);
+        let (x, y, z) = entity.position;
+        if clip.is_none() || keep.contains((x.floor() as i32, y.floor() as i32, z.floor() as i32)) {
+            region.add_entity(entity);
+        }
     }
 
     schematic.add_region(region);
@@ -472,11 +936,11 @@ pub fn from_schematic(data: &[u8]) -> Result<UniversalSchematic> {
 fn convert_block_entities(region: &Region) -> NbtList {
     let mut block_entities = NbtList::new();
 
-    for (_, block_entity) in region.block_entities.iter() {
+    for (pos, block_entity) in region.block_entities.iter() {
         let mut nbt = block_entity.to_nbt();
-        let rel_x = block_entity.position.0 - region.position.0;
-        let rel_y = block_entity.position.1 - region.position.1;
-        let rel_z = block_entity.position.2 - region.position.2;
+        let rel_x = pos.0 - region.position.0;
+        let rel_y = pos.1 - region.position.1;
+        let rel_z = pos.2 - region.position.2;
         nbt.insert("Pos", NbtTag::IntArray(vec![rel_x, rel_y, rel_z]));
         block_entities.push(nbt);
     }
@@ -490,18 +954,33 @@ fn convert_block_entities(region: &Region) -> NbtList {
 fn convert_block_entities_v3(region: &Region, data_version: Option<i32>) -> NbtList {
     let mut block_entities = NbtList::new();
 
-    for (_, block_entity) in region.block_entities.iter() {
-        let mut nbt = block_entity.to_nbt_v3(data_version);
-        let rel_x = block_entity.position.0 - region.position.0;
-        let rel_y = block_entity.position.1 - region.position.1;
-        let rel_z = block_entity.position.2 - region.position.2;
-        nbt.insert("Pos", NbtTag::IntArray(vec![rel_x, rel_y, rel_z]));
-        block_entities.push(nbt);
+    for (pos, block_entity) in region.block_entities.iter() {
+        let mut block_entity = block_entity.clone();
+        block_entity.position = pos;
+        block_entities.push(sponge_v3_block_entity(
+            &block_entity,
+            region.position,
+            data_version,
+        ));
     }
 
     block_entities
 }
 
+/// One v3 block entity, positioned relative to `origin`.
+pub(crate) fn sponge_v3_block_entity(
+    block_entity: &BlockEntity,
+    origin: (i32, i32, i32),
+    data_version: Option<i32>,
+) -> NbtCompound {
+    let mut nbt = block_entity.to_nbt_v3(data_version);
+    let rel_x = block_entity.position.0 - origin.0;
+    let rel_y = block_entity.position.1 - origin.1;
+    let rel_z = block_entity.position.2 - origin.2;
+    nbt.insert("Pos", NbtTag::IntArray(vec![rel_x, rel_y, rel_z]));
+    nbt
+}
+
 // Sponge Schematic spec: entity positions are relative to [0,0,0] of the
 // schematic (without the offset applied). We subtract the region position.
 
@@ -568,32 +1047,38 @@ fn convert_entities_v2(region: &Region) -> NbtList {
 fn convert_entities_v3(region: &Region) -> NbtList {
     let mut entities = NbtList::new();
     for entity in &region.entities {
-        let rel = (
-            entity.position.0 - region.position.0 as f64,
-            entity.position.1 - region.position.1 as f64,
-            entity.position.2 - region.position.2 as f64,
-        );
-        let data = vanilla_entity_nbt(entity, rel);
-
-        let pos_list = NbtList::from(vec![
-            NbtTag::Double(rel.0),
-            NbtTag::Double(rel.1),
-            NbtTag::Double(rel.2),
-        ]);
-
-        let mut wrapper = NbtCompound::new();
-        wrapper.insert("Id", NbtTag::String(sponge_entity_id(entity)));
-        wrapper.insert("Pos", NbtTag::List(pos_list));
-        wrapper.insert("Data", NbtTag::Compound(data));
-        entities.push(NbtTag::Compound(wrapper));
+        entities.push(NbtTag::Compound(sponge_v3_entity(entity, region.position)));
     }
     entities
 }
 
-fn parse_block_palette(region_tag: &NbtCompound) -> Result<Vec<BlockState>> {
-    let palette_compound = region_tag.get::<_, &NbtCompound>("Palette")?;
-    let palette_max = region_tag
-        .get::<_, i32>("PaletteMax") // V2
+/// One v3 entity wrapper, positioned relative to `origin`.
+pub(crate) fn sponge_v3_entity(entity: &Entity, origin: (i32, i32, i32)) -> NbtCompound {
+    let rel = (
+        entity.position.0 - origin.0 as f64,
+        entity.position.1 - origin.1 as f64,
+        entity.position.2 - origin.2 as f64,
+    );
+    let data = vanilla_entity_nbt(entity, rel);
+
+    let pos_list = NbtList::from(vec![
+        NbtTag::Double(rel.0),
+        NbtTag::Double(rel.1),
+        NbtTag::Double(rel.2),
+    ]);
+
+    let mut wrapper = NbtCompound::new();
+    wrapper.insert("Id", NbtTag::String(sponge_entity_id(entity)));
+    wrapper.insert("Pos", NbtTag::List(pos_list));
+    wrapper.insert("Data", NbtTag::Compound(data));
+    wrapper
+}
+
+fn parse_block_palette(
+    palette_compound: &NbtCompound,
+    palette_max: Option<i32>,
+) -> Result<Vec<BlockState>> {
+    let palette_max = palette_max // V2
         .unwrap_or(palette_compound.len() as i32) as usize; // V3
     let mut palette = vec![BlockState::new("minecraft:air".to_string()); palette_max + 1];
 
@@ -649,6 +1134,24 @@ fn encode_varint_into(value: u32, buf: &mut Vec<u8>) {
     }
 }
 
+/// Append the varint encoding of every value. Lanes whose values are all
+/// below 128 are narrowed to bytes directly.
+pub(crate) fn encode_varints_into(values: &[u32], buf: &mut Vec<u8>) {
+    let mut lanes = values.chunks_exact(VARINT_LANE);
+    for lane in &mut lanes {
+        if lane.iter().fold(0, |acc, &v| acc | v) < 0x80 {
+            buf.extend(lane.iter().map(|&v| v as u8));
+        } else {
+            for &value in lane {
+                encode_varint_into(value, buf);
+            }
+        }
+    }
+    for &value in lanes.remainder() {
+        encode_varint_into(value, buf);
+    }
+}
+
 fn decode_varint<R: Read>(reader: &mut R) -> Result<u32> {
     let mut result = 0u32;
     let mut shift = 0;
@@ -666,103 +1169,45 @@ fn decode_varint<R: Read>(reader: &mut R) -> Result<u32> {
     }
 }
 
-fn parse_block_data(
-    region_tag: &NbtCompound,
-    width: u32,
-    height: u32,
-    length: u32,
-) -> Result<Vec<u32>> {
-    // V2 = BlockData, V3 = Data
-    let block_data_i8 = region_tag
-        .get::<_, &Vec<i8>>("BlockData")
-        .or(region_tag.get::<_, &Vec<i8>>("Data"))?;
-
-    let mut block_data_u8: &[u8] = unsafe {
-        std::slice::from_raw_parts(block_data_i8.as_ptr() as *const u8, block_data_i8.len())
+/// Block entities from the raw `BlockEntities` list payload. Each compound
+/// is viewed in place and built once, straight into the block entity's own
+/// map, rather than parsed into a tree and copied.
+fn parse_block_entities(raw: &[u8]) -> Result<Vec<BlockEntity>> {
+    let list = nbt_view::payload(raw, 9, Endian::Big)?;
+    let Some(list) = list.as_list() else {
+        return Ok(Vec::new());
     };
-
-    // ---------- fast var-int decode ----------
-    #[inline]
-    fn read_varint(slice: &mut &[u8]) -> Option<u32> {
-        let mut out = 0u32;
-        let mut shift = 0;
-        while !slice.is_empty() {
-            let byte = slice[0];
-            *slice = &slice[1..];
-            out |= ((byte & 0x7F) as u32) << shift;
-            if byte & 0x80 == 0 {
-                return Some(out);
+    let mut block_entities = Vec::with_capacity(list.len());
+    for compound in list.compounds() {
+        // Sponge Schematic v3 wraps block-specific data in a "Data" compound.
+        // Flatten it so consumers (e.g. MCHPRS) can find fields like "Items"
+        // at the top level, matching the vanilla block entity NBT layout.
+        let mut map = NbtMap::new();
+        let mut data = None;
+        for (key, value) in compound.iter() {
+            if key == *"Data" {
+                data = value.as_compound().cloned();
+                continue;
             }
-            shift += 7;
+            map.insert(key.to_str()?, value.to_value()?);
         }
-        None
-    }
-
-    let expected_length = (width * height * length) as usize;
-    let mut block_data: Vec<u32> = Vec::with_capacity(expected_length);
-
-    while let Some(id) = read_varint(&mut block_data_u8) {
-        block_data.push(id);
-    }
-
-    if block_data.len() != expected_length {
-        return Err(format!(
-            "Block data length mismatch: expected {}, got {}",
-            expected_length,
-            block_data.len()
-        )
-        .into());
-    }
-
-    Ok(block_data)
-}
-
-fn parse_block_entities(region_tag: &NbtCompound) -> Result<Vec<BlockEntity>> {
-    let block_entities_list = region_tag.get::<_, &NbtList>("BlockEntities")?;
-    let mut block_entities = Vec::new();
-
-    for tag in block_entities_list.iter() {
-        if let NbtTag::Compound(compound) = tag {
-            // Sponge Schematic v3 wraps block-specific data in a "Data" compound.
-            // Flatten it so consumers (e.g. MCHPRS) can find fields like "Items"
-            // at the top level, matching the vanilla block entity NBT layout.
-            let flattened = if compound.contains_key("Data") {
-                let mut flat = NbtCompound::new();
-                // Copy top-level fields (Id, Pos)
-                for (key, value) in compound.inner() {
-                    if key != "Data" {
-                        flat.insert(key, value.clone());
-                    }
-                }
-                // Merge Data contents into top level
-                if let Ok(data) = compound.get::<_, &NbtCompound>("Data") {
-                    for (key, value) in data.inner() {
-                        flat.insert(key, value.clone());
-                    }
-                }
-                flat
-            } else {
-                compound.clone()
-            };
-            let block_entity = BlockEntity::from_nbt(&flattened);
-            block_entities.push(block_entity);
+        // Data contents override top-level fields (Id, Pos).
+        if let Some(data) = data {
+            for (key, value) in data.iter() {
+                map.insert(key.to_str()?, value.to_value()?);
+            }
         }
+        block_entities.push(BlockEntity::from_nbt_map(map));
     }
-
     Ok(block_entities)
 }
 
-fn parse_entities(region_tag: &NbtCompound) -> Result<Vec<Entity>> {
-    if !region_tag.contains_key("Entities") {
-        return Ok(Vec::new());
-    }
-    let entities_list = region_tag.get::<_, &NbtList>("Entities")?;
+fn parse_entities(compounds: &[NbtCompound]) -> Result<Vec<Entity>> {
     let mut entities = Vec::new();
+    let mut interner = EntityInterner::new();
 
-    for tag in entities_list.iter() {
-        if let NbtTag::Compound(compound) = tag {
-            entities.push(parse_entity_compound(compound)?);
-        }
+    for compound in compounds {
+        entities.push(interner.intern(parse_entity_compound(compound)?));
     }
 
     Ok(entities)
@@ -789,7 +1234,9 @@ fn parse_entity_compound(compound: &NbtCompound) -> std::result::Result<Entity,
     }
 }
 
-use crate::formats::manager::{SchematicExporter, SchematicImporter};
+use crate::formats::manager::{
+    BoundsSettings, CompressionSettings, SchematicExporter, SchematicImporter, SchematicInfo,
+};
 
 pub struct SchematicFormat;
 
@@ -805,6 +1252,37 @@ impl SchematicImporter for SchematicFormat {
     fn read(&self, data: &[u8]) -> Result<UniversalSchematic> {
         from_schematic(data)
     }
+
+    fn read_with_settings(
+        &self,
+        data: &[u8],
+        settings: Option<&str>,
+    ) -> Result<UniversalSchematic> {
+        match BoundsSettings::from_settings(settings)?.bounds() {
+            Some(bounds) => self.read_bounded(data, &bounds),
+            None => self.read(data),
+        }
+    }
+
+    fn read_bounded(&self, data: &[u8], bounds: &BoundingBox) -> Result<UniversalSchematic> {
+        from_schematic_bounded(data, bounds)
+    }
+
+    fn import_settings_schema(&self) -> Option<String> {
+        serde_json::to_string_pretty(&BoundsSettings::default()).ok()
+    }
+
+    fn probe(&self, data: &[u8]) -> Result<SchematicInfo> {
+        probe_schematic(data)
+    }
+
+    fn read_from(&self, reader: &mut dyn Read) -> Result<UniversalSchematic> {
+        from_schematic_reader(reader)
+    }
+
+    fn probe_from(&self, reader: &mut dyn Read) -> Result<SchematicInfo> {
+        probe_schematic_reader(reader)
+    }
 }
 
 impl SchematicExporter for SchematicFormat {
@@ -837,6 +1315,26 @@ impl SchematicExporter for SchematicFormat {
             to_schematic(schematic)
         }
     }
+
+    fn write_with_settings(
+        &self,
+        schematic: &UniversalSchematic,
+        version: Option<&str>,
+        settings: Option<&str>,
+    ) -> Result<Vec<u8>> {
+        let version = match version {
+            Some(v) => SchematicVersion::from_str(v)
+                .ok_or_else(|| format!("Unsupported version: {}", v))?,
+            None => SchematicVersion::get_default(),
+        };
+        let compression =
+            CompressionSettings::from_settings(settings)?.gzip_or(DEFAULT_COMPRESSION)?;
+        to_schematic_with_options(schematic, version, compression)
+    }
+
+    fn export_settings_schema(&self) -> Option<String> {
+        serde_json::to_string_pretty(&CompressionSettings::default()).ok()
+    }
 }
 
 #[cfg(test)]
@@ -848,6 +1346,7 @@ mod tests {
 
     use crate::litematic::{from_litematic, to_litematic};
     use crate::{BlockState, UniversalSchematic};
+    use quartz_nbt::io::{read_nbt, Flavor};
 
     use super::*;
 
@@ -950,11 +1449,147 @@ mod tests {
             "BlockData",
             NbtTag::ByteArray(encoded_block_data.iter().map(|&x| x as i8).collect()),
         );
-
-        let parsed_data = parse_block_data(&nbt, 2, 2, 2).expect("Failed to parse block data");
+        let mut bytes = Vec::new();
+        quartz_nbt::io::write_nbt(&mut bytes, None, &nbt, Flavor::Uncompressed).unwrap();
+
+        // Read as a stream: skip to the array payload, then decode it in a
+        // buffer small enough that varints straddle refills.
+        let mut reader = BufReader::with_capacity(2, bytes.as_slice());
+        nbt_io::read_root_header(&mut reader, Endian::Big).unwrap();
+        let (tag, name) = nbt_io::read_entry_header(&mut reader, Endian::Big)
+            .unwrap()
+            .unwrap();
+        assert_eq!((tag, name.as_str()), (7, "BlockData"));
+        let len = nbt_io::read_len(&mut reader, Endian::Big).unwrap();
+        let (parsed_data, count) =
+            read_block_data(&mut reader, len, Some(8), None).expect("Failed to parse block data");
+        assert_eq!(count, 8);
         assert_eq!(parsed_data, vec![0, 1, 2, 1, 0, 2, 1, 0]);
     }
 
+    #[test]
+    fn test_export_settings_select_level_and_parallel_gzip() {
+        let mut schematic = UniversalSchematic::new("Settings".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        for i in 0..512 {
+            let block = if i % 3 == 0 { &glass } else { &stone };
+            schematic.set_block(i % 8, i / 64, (i / 8) % 8, block);
+        }
+
+        let settings = r#"{"compression_level":9,"parallel_compression":true}"#;
+        let data = SchematicFormat
+            .write_with_settings(&schematic, None, Some(settings))
+            .unwrap();
+        let imported = from_schematic(&data).unwrap();
+        assert_eq!(imported.get_block(3, 0, 3).unwrap().name, "minecraft:glass");
+        assert_eq!(imported.total_blocks(), schematic.total_blocks());
+
+        let bad = r#"{"compression_level":10}"#;
+        assert!(SchematicFormat
+            .write_with_settings(&schematic, None, Some(bad))
+            .is_err());
+    }
+
+    #[test]
+    fn test_varint_lanes_match_scalar_codec() {
+        // Long single-byte runs broken by multi-byte values at unaligned
+        // offsets, with a tail shorter than a lane.
+        let values: Vec<u32> = (0..1000u32)
+            .map(|i| match i % 97 {
+                5 => 300,
+                40 => 70_000,
+                _ => i % 128,
+            })
+            .collect();
+        let mut encoded = Vec::new();
+        encode_varints_into(&values, &mut encoded);
+        let scalar: Vec<u8> = values.iter().flat_map(|&v| encode_varint(v)).collect();
+        assert_eq!(encoded, scalar);
+
+        let expected: Vec<usize> = values.iter().map(|&v| v as usize).collect();
+        for volume in [Some(values.len()), None] {
+            let mut reader = BufReader::with_capacity(37, encoded.as_slice());
+            let (blocks, count) =
+                read_block_data(&mut reader, encoded.len(), volume, None).unwrap();
+            assert_eq!(count, values.len());
+            assert_eq!(blocks, expected);
+        }
+    }
+
+    #[test]
+    fn test_overlong_block_data_is_rejected_not_panicking() {
+        // 40 single-byte indices for a 2×1×2 volume: the first lane fills
+        // the volume and overshoots it, the next lanes start past its end.
+        let block_data: Vec<i8> = (0..40).map(|i| (i % 2) as i8).collect();
+        let mut palette = NbtCompound::new();
+        palette.insert("minecraft:air", NbtTag::Int(0));
+        palette.insert("minecraft:stone", NbtTag::Int(1));
+
+        // Dimensions first, so the volume is known when BlockData is read.
+        let mut root = NbtCompound::new();
+        root.insert("Version", NbtTag::Int(2));
+        root.insert("DataVersion", NbtTag::Int(3700));
+        root.insert("Width", NbtTag::Short(2));
+        root.insert("Height", NbtTag::Short(1));
+        root.insert("Length", NbtTag::Short(2));
+        root.insert("PaletteMax", NbtTag::Int(2));
+        root.insert("Palette", NbtTag::Compound(palette));
+        root.insert("BlockData", NbtTag::ByteArray(block_data));
+
+        let mut encoder = flate2::write::GzEncoder::new(Vec::new(), Compression::fast());
+        quartz_nbt::io::write_nbt(&mut encoder, None, &root, Flavor::Uncompressed).unwrap();
+        let data = encoder.finish().unwrap();
+
+        let err = from_schematic(&data)
+            .err()
+            .expect("overlong block data is an error");
+        assert!(err.to_string().contains("Block data length mismatch"));
+    }
+
+    #[test]
+    fn test_streaming_read_of_hand_built_v2() {
+        let block_data: Vec<i8> = [0u32, 1, 300, 1]
+            .iter()
+            .flat_map(|&v| encode_varint(v))
+            .map(|b| b as i8)
+            .collect();
+        let mut palette = NbtCompound::new();
+        palette.insert("minecraft:air", NbtTag::Int(0));
+        palette.insert("minecraft:stone", NbtTag::Int(1));
+        palette.insert("minecraft:glass", NbtTag::Int(300));
+        let mut chest = NbtCompound::new();
+        chest.insert("Id", NbtTag::String("minecraft:chest".to_string()));
+        chest.insert("Pos", NbtTag::IntArray(vec![1, 0, 0]));
+
+        let mut root = NbtCompound::new();
+        root.insert("BlockData", NbtTag::ByteArray(block_data));
+        root.insert("Version", NbtTag::Int(2));
+        root.insert("DataVersion", NbtTag::Int(3700));
+        root.insert("Width", NbtTag::Short(2));
+        root.insert("Height", NbtTag::Short(1));
+        root.insert("Length", NbtTag::Short(2));
+        root.insert("PaletteMax", NbtTag::Int(301));
+        root.insert("Palette", NbtTag::Compound(palette));
+        root.insert(
+            "BlockEntities",
+            NbtTag::List(NbtList::from(vec![NbtTag::Compound(chest)])),
+        );
+        root.insert("Unused", NbtTag::LongArray(vec![1, 2, 3]));
+
+        let mut encoder = flate2::write::GzEncoder::new(Vec::new(), Compression::fast());
+        quartz_nbt::io::write_nbt(&mut encoder, None, &root, Flavor::Uncompressed).unwrap();
+        let data = encoder.finish().unwrap();
+
+        assert!(is_schematic(&data));
+        let schematic = from_schematic(&data).unwrap();
+        let name = |x, z| schematic.get_block(x, 0, z).map(|b| b.name.to_string());
+        assert_eq!(name(1, 0).as_deref(), Some("minecraft:stone"));
+        assert_eq!(name(0, 1).as_deref(), Some("minecraft:glass"));
+        assert_eq!(schematic.total_blocks(), 3);
+        assert_eq!(schematic.default_region.block_entities.len(), 1);
+    }
+
     #[test]
     fn test_convert_palette_v3() {
         let palette = vec![
@@ -1120,7 +1755,7 @@ mod tests {
         schematic.default_region.add_entity(entity);
 
         // Export to schematic v3
-        let schem_data = to_schematic_v3(&schematic, DEFAULT_COMPRESSION).unwrap();
+        let schem_data = to_schematic_v3(&schematic, DEFAULT_COMPRESSION.into()).unwrap();
 
         // Parse back the raw NBT
         let reader = std::io::BufReader::new(schem_data.as_slice());
@@ -1151,7 +1786,7 @@ mod tests {
 
         // Test entity positions via v2 (v3 has a pre-existing bug where entities
         // are filtered out due to case-sensitive "Id" vs "id" check)
-        let schem_v2_data = to_schematic_v2(&schematic, DEFAULT_COMPRESSION).unwrap();
+        let schem_v2_data = to_schematic_v2(&schematic, DEFAULT_COMPRESSION.into()).unwrap();
         let reader_v2 = std::io::BufReader::new(schem_v2_data.as_slice());
         let mut gz_v2 = GzDecoder::new(reader_v2);
         let (root_v2, _) = read_nbt(&mut gz_v2, Flavor::Uncompressed).unwrap();
@@ -1185,6 +1820,57 @@ mod tests {
         }
     }
 
+    #[test]
+    fn test_bounded_import_keeps_only_the_box() {
+        use crate::block_entity::BlockEntity;
+
+        // Enough states for two-byte varints, so both decode paths run.
+        let mut schematic = UniversalSchematic::new("Bounded".to_string());
+        for x in 0..40 {
+            for y in 0..6 {
+                for z in 0..7 {
+                    let name = format!("minecraft:test_{}", (x * 11 + y * 5 + z) % 150);
+                    schematic.set_block(x, y, z, &BlockState::new(name));
+                }
+            }
+        }
+        schematic
+            .default_region
+            .add_block_entity(BlockEntity::new("minecraft:chest".to_string(), (12, 3, 4)));
+        schematic
+            .default_region
+            .add_block_entity(BlockEntity::new("minecraft:chest".to_string(), (0, 0, 0)));
+        let data = to_schematic(&schematic).unwrap();
+        let full = from_schematic(&data).unwrap();
+
+        let bounds = BoundingBox::new((5, 1, 2), (50, 3, 5));
+        let bounded = from_schematic_bounded(&data, &bounds).unwrap();
+        let region = &bounded.default_region;
+        assert_eq!(
+            Some(region.get_bounding_box()),
+            full.default_region.get_bounding_box().intersection(&bounds)
+        );
+        for x in 5..40 {
+            for y in 1..4 {
+                for z in 2..6 {
+                    assert_eq!(
+                        bounded.get_block(x, y, z),
+                        full.get_block(x, y, z),
+                        "block at {x},{y},{z}"
+                    );
+                }
+            }
+        }
+        assert_eq!(
+            region.block_entities.keys().collect::<Vec<_>>(),
+            vec![&(12, 3, 4)]
+        );
+
+        let outside = BoundingBox::new((0, 10, 0), (5, 12, 5));
+        let empty = from_schematic_bounded(&data, &outside).unwrap();
+        assert_eq!(empty.total_blocks(), 0);
+    }
+
     /// Test sponge schematic roundtrip preserves positions correctly after export/import.
     #[test]
     fn test_schematic_roundtrip_with_offset_positions() {
@@ -1209,7 +1895,7 @@ mod tests {
         schematic.default_region.add_entity(creeper);
 
         // Roundtrip through v2 (v3 has a pre-existing entity export filter bug)
-        let schem_data = to_schematic_v2(&schematic, DEFAULT_COMPRESSION).unwrap();
+        let schem_data = to_schematic_v2(&schematic, DEFAULT_COMPRESSION.into()).unwrap();
         let roundtrip = from_schematic(&schem_data).unwrap();
 
         let rt_region = &roundtrip.default_region;
@@ -1,9 +1,65 @@
-use crate::formats::error::Result;
+//! `.nusn` snapshots: a fast binary cache of a [`UniversalSchematic`].
+//!
+//! Version 1 is a bincode dump of the whole schematic; loading it
+//! deserializes every cell and rescans each region. Version 2 (written by
+//! default) keeps block arrays out of the serialized part:
+//!
+//! ```text
+//! "NUSN" | u32 version = 2 | u64 header length | header (bincode)
+//! padding to 64 | region 0 cells | padding to 64 | region 0 extras | ...
+//! ```
+//!
+//! The header holds metadata, definition regions and, per region, its
+//! palette, non-air count, tight bounds and the offsets (from the end of the
+//! header padding) of its cells and of its entities and block entities.
+//! Cells are the region's palette indices as raw little-endian integers at
+//! their storage width, 64-byte aligned, so a mapped file serves
+//! [`Snapshot::get_block`] straight from the mapping and a load copies each
+//! array once instead of decoding it.
+//!
+//! [`Snapshot`] parses only the header; regions are built on demand
+//! ([`Snapshot::region`], [`Snapshot::to_schematic`]) with one pass over
+//! their cells that checks them against the header instead of rebuilding.
+//!
+//! For deduplicating stores, [`to_chunked_snapshot`] cuts a version 2
+//! snapshot into content-addressed chunks plus a manifest:
+//!
+//! ```text
+//! "NUSM" | u32 version = 1 | manifest (bincode)
+//! ```
+//!
+//! The manifest keeps the snapshot's preamble and header verbatim, and
+//! names, per region, the blake3 hash of each fixed-size chunk of its cells
+//! and of its extras. Edits change cells in place, so a variant of a saved
+//! build shares every chunk it did not touch. [`ChunkManifest::assemble`]
+//! puts the snapshot back together from the chunks.
+
+use crate::block_entity_store::BlockEntityStore;
+use crate::block_storage::BlockStorage;
+use crate::bounding_box::BoundingBox;
+use crate::definition_region::DefinitionRegion;
+use crate::entity::Entity;
+use crate::formats::error::{FormatError, Result};
 use crate::formats::manager::{SchematicExporter, SchematicImporter};
+use crate::metadata::Metadata;
+use crate::region::Region;
 use crate::universal_schematic::UniversalSchematic;
+use crate::BlockState;
+use serde::{Deserialize, Serialize};
+use std::collections::{HashMap, HashSet};
+use std::ops::Range;
 
 const MAGIC: &[u8; 4] = b"NUSN";
-const VERSION: u32 = 1;
+const VERSION_V1: u32 = 1;
+const VERSION: u32 = 2;
+/// Alignment of every data section in a version 2 snapshot.
+const ALIGN: usize = 64;
+/// Magic, version and header length.
+const PREAMBLE: usize = 16;
+const MANIFEST_MAGIC: &[u8; 4] = b"NUSM";
+const MANIFEST_VERSION: u32 = 1;
+/// Default chunk size of [`to_chunked_snapshot`].
+pub const DEFAULT_CHUNK_SIZE: usize = 256 * 1024;
 
 pub struct SnapshotFormat;
 
@@ -31,28 +87,150 @@ impl SchematicExporter for SnapshotFormat {
     }
 
     fn available_versions(&self) -> Vec<String> {
-        vec!["1".to_string()]
+        vec!["1".to_string(), "2".to_string()]
     }
 
     fn default_version(&self) -> String {
-        "1".to_string()
+        "2".to_string()
     }
 
-    fn write(&self, schematic: &UniversalSchematic, _version: Option<&str>) -> Result<Vec<u8>> {
-        to_snapshot(schematic)
+    fn write(&self, schematic: &UniversalSchematic, version: Option<&str>) -> Result<Vec<u8>> {
+        match version {
+            Some("1") => to_snapshot_v1(schematic),
+            None | Some("2") => to_snapshot(schematic),
+            Some(other) => Err(format!("Unsupported snapshot version: {}", other).into()),
+        }
     }
 }
 
+#[derive(Serialize, Deserialize)]
+struct Header {
+    metadata: Metadata,
+    default_region_name: String,
+    definition_regions: HashMap<String, DefinitionRegion>,
+    /// The default region, then the others by key.
+    regions: Vec<RegionEntry>,
+}
+
+#[derive(Serialize, Deserialize)]
+struct RegionEntry {
+    /// Key in `other_regions` (the default region name for the default).
+    key: String,
+    name: String,
+    position: (i32, i32, i32),
+    size: (i32, i32, i32),
+    palette: Vec<BlockState>,
+    non_air_count: u64,
+    tight_bounds: Option<BoundingBox>,
+    /// Bytes per cell.
+    width: u8,
+    cells: Span,
+    /// bincode `(Vec<Entity>, BlockEntityStore)`.
+    extras: Span,
+}
+
+/// Byte range relative to the start of the data sections.
+#[derive(Serialize, Deserialize, Clone, Copy)]
+struct Span {
+    offset: u64,
+    len: u64,
+}
+
+impl Span {
+    fn range(self, base: usize, total: usize) -> Result<Range<usize>> {
+        let start = usize::try_from(self.offset)
+            .ok()
+            .and_then(|offset| base.checked_add(offset));
+        let end = usize::try_from(self.len)
+            .ok()
+            .zip(start)
+            .and_then(|(len, start)| start.checked_add(len));
+        match (start, end) {
+            (Some(start), Some(end)) if end <= total => Ok(start..end),
+            _ => Err("Snapshot section out of range".into()),
+        }
+    }
+}
+
+fn pad_to_align(buf: &mut Vec<u8>) {
+    buf.resize(buf.len().next_multiple_of(ALIGN), 0);
+}
+
 pub fn to_snapshot(schematic: &UniversalSchematic) -> Result<Vec<u8>> {
+    let mut names: Vec<&String> = schematic.other_regions.keys().collect();
+    names.sort();
+    let regions = std::iter::once((&schematic.default_region_name, &schematic.default_region))
+        .chain(
+            names
+                .into_iter()
+                .map(|key| (key, &schematic.other_regions[key])),
+        );
+
+    let mut data = Vec::new();
+    let mut entries = Vec::new();
+    for (key, region) in regions {
+        pad_to_align(&mut data);
+        let start = data.len();
+        let width = region.blocks.write_le_bytes(&mut data);
+        let cells = Span {
+            offset: start as u64,
+            len: (data.len() - start) as u64,
+        };
+        pad_to_align(&mut data);
+        let start = data.len();
+        bincode::serialize_into(&mut data, &(&region.entities, &region.block_entities))?;
+        let extras = Span {
+            offset: start as u64,
+            len: (data.len() - start) as u64,
+        };
+        entries.push(RegionEntry {
+            key: key.clone(),
+            name: region.name.clone(),
+            position: region.position,
+            size: region.size,
+            palette: region.palette.clone(),
+            non_air_count: region.count_non_air_blocks() as u64,
+            tight_bounds: region.get_tight_bounds(),
+            width: width as u8,
+            cells,
+            extras,
+        });
+    }
+
+    let header = bincode::serialize(&Header {
+        metadata: schematic.metadata.clone(),
+        default_region_name: schematic.default_region_name.clone(),
+        definition_regions: schematic.definition_regions.clone(),
+        regions: entries,
+    })?;
+    let mut buf = Vec::with_capacity(PREAMBLE + header.len() + ALIGN + data.len());
+    buf.extend_from_slice(MAGIC);
+    buf.extend_from_slice(&VERSION.to_le_bytes());
+    buf.extend_from_slice(&(header.len() as u64).to_le_bytes());
+    buf.extend_from_slice(&header);
+    pad_to_align(&mut buf);
+    buf.extend_from_slice(&data);
+    Ok(buf)
+}
+
+fn to_snapshot_v1(schematic: &UniversalSchematic) -> Result<Vec<u8>> {
     let payload = bincode::serialize(schematic)?;
     let mut buf = Vec::with_capacity(8 + payload.len());
     buf.extend_from_slice(MAGIC);
-    buf.extend_from_slice(&VERSION.to_le_bytes());
+    buf.extend_from_slice(&VERSION_V1.to_le_bytes());
     buf.extend_from_slice(&payload);
     Ok(buf)
 }
 
+/// Read a snapshot of either version into an owned schematic.
 pub fn from_snapshot(data: &[u8]) -> Result<UniversalSchematic> {
+    match read_version(data)? {
+        VERSION_V1 => from_snapshot_v1(&data[8..]),
+        _ => Snapshot::parse(data)?.to_schematic(),
+    }
+}
+
+fn read_version(data: &[u8]) -> Result<u32> {
     if data.len() < 8 {
         return Err("Snapshot data too short".into());
     }
@@ -60,10 +238,14 @@ pub fn from_snapshot(data: &[u8]) -> Result<UniversalSchematic> {
         return Err("Invalid snapshot magic bytes".into());
     }
     let version = u32::from_le_bytes(data[4..8].try_into()?);
-    if version != VERSION {
+    if version != VERSION_V1 && version != VERSION {
         return Err(format!("Unsupported snapshot version: {}", version).into());
     }
-    let mut schematic: UniversalSchematic = bincode::deserialize(&data[8..])?;
+    Ok(version)
+}
+
+fn from_snapshot_v1(payload: &[u8]) -> Result<UniversalSchematic> {
+    let mut schematic: UniversalSchematic = bincode::deserialize(payload)?;
 
     // Rebuild cached fields that are #[serde(skip)] on Region
     rebuild_region(&mut schematic.default_region);
@@ -81,3 +263,394 @@ fn rebuild_region(region: &mut crate::region::Region) {
     region.rebuild_non_air_count();
     region.rebuild_tight_bounds();
 }
+
+/// Bytes behind a [`Snapshot`]: owned, or a read-only file mapping.
+pub enum SnapshotBytes {
+    Owned(Vec<u8>),
+    #[cfg(not(target_arch = "wasm32"))]
+    Mapped(memmap2::Mmap),
+}
+
+impl AsRef<[u8]> for SnapshotBytes {
+    fn as_ref(&self) -> &[u8] {
+        match self {
+            SnapshotBytes::Owned(bytes) => bytes.as_slice(),
+            #[cfg(not(target_arch = "wasm32"))]
+            SnapshotBytes::Mapped(map) => &map[..],
+        }
+    }
+}
+
+/// A version 2 snapshot with only its header parsed. Reads come straight
+/// from the underlying bytes; regions are built on request.
+pub struct Snapshot<B: AsRef<[u8]> = SnapshotBytes> {
+    bytes: B,
+    header: Header,
+    /// Start of the data sections.
+    base: usize,
+    /// Bounding box of each region, parallel to `header.regions`.
+    bounds: Vec<BoundingBox>,
+}
+
+impl Snapshot {
+    /// Open a `.nusn` file and parse its header. The file is mapped
+    /// read-only (read into memory on wasm, which has no mapping).
+    pub fn open(path: impl AsRef<std::path::Path>) -> Result<Snapshot> {
+        #[cfg(not(target_arch = "wasm32"))]
+        let bytes = {
+            let file = std::fs::File::open(path)?;
+            // SAFETY: the mapping is read-only, and callers must not
+            // truncate or rewrite the file while a snapshot of it is open
+            // (write a new file and rename it over the old one instead).
+            SnapshotBytes::Mapped(unsafe { memmap2::Mmap::map(&file)? })
+        };
+        #[cfg(target_arch = "wasm32")]
+        let bytes = SnapshotBytes::Owned(std::fs::read(path)?);
+        Snapshot::parse(bytes)
+    }
+}
+
+impl<B: AsRef<[u8]>> Snapshot<B> {
+    /// Parse the header of version 2 snapshot bytes and check that every
+    /// region's cells lie inside them and match its volume.
+    pub fn parse(bytes: B) -> Result<Self> {
+        let data = bytes.as_ref();
+        if read_version(data)? != VERSION {
+            return Err("Lazy snapshot access needs a version 2 snapshot".into());
+        }
+        let header_len = data
+            .get(8..PREAMBLE)
+            .map(|len| u64::from_le_bytes(len.try_into().unwrap()))
+            .and_then(|len| usize::try_from(len).ok())
+            .and_then(|len| len.checked_add(PREAMBLE))
+            .filter(|&end| end <= data.len())
+            .ok_or("Snapshot header out of range")?;
+        let header: Header = bincode::deserialize(&data[PREAMBLE..header_len])?;
+        let base = header_len.next_multiple_of(ALIGN);
+
+        let mut bounds = Vec::with_capacity(header.regions.len());
+        for entry in &header.regions {
+            let bbox = BoundingBox::try_from_position_and_size(entry.position, entry.size)?;
+            let cells = entry.cells.range(base, data.len())?;
+            entry.extras.range(base, data.len())?;
+            let expected = usize::try_from(bbox.volume())
+                .ok()
+                .and_then(|volume| volume.checked_mul(entry.width as usize));
+            if !matches!(entry.width, 1 | 2 | 4) || expected != Some(cells.len()) {
+                return Err(format!("Snapshot region '{}' has malformed cells", entry.key).into());
+            }
+            bounds.push(bbox);
+        }
+        Ok(Snapshot {
+            bytes,
+            header,
+            base,
+            bounds,
+        })
+    }
+
+    pub fn metadata(&self) -> &Metadata {
+        &self.header.metadata
+    }
+
+    /// Region keys, the default region first.
+    pub fn region_names(&self) -> impl Iterator<Item = &str> + '_ {
+        self.header.regions.iter().map(|entry| entry.key.as_str())
+    }
+
+    /// The block at a world position, with the precedence of
+    /// [`UniversalSchematic::get_block`]: the default region, then the
+    /// others by key.
+    pub fn get_block(&self, x: i32, y: i32, z: i32) -> Option<&BlockState> {
+        (0..self.header.regions.len()).find_map(|i| self.block_in(i, (x, y, z)))
+    }
+
+    /// The block at a world position in one region.
+    pub fn get_block_in_region(&self, key: &str, x: i32, y: i32, z: i32) -> Option<&BlockState> {
+        self.entry_index(key)
+            .and_then(|i| self.block_in(i, (x, y, z)))
+    }
+
+    fn entry_index(&self, key: &str) -> Option<usize> {
+        self.header
+            .regions
+            .iter()
+            .position(|entry| entry.key == key)
+    }
+
+    fn block_in(&self, i: usize, pos: (i32, i32, i32)) -> Option<&BlockState> {
+        let bbox = &self.bounds[i];
+        if !bbox.contains(pos) {
+            return None;
+        }
+        let entry = &self.header.regions[i];
+        let (w, _, l) = bbox.get_dimensions();
+        let (w, l) = (w as usize, l as usize);
+        let index = (pos.0 - bbox.min.0) as usize
+            + (pos.2 - bbox.min.2) as usize * w
+            + (pos.1 - bbox.min.1) as usize * w * l;
+        let cells = &self.bytes.as_ref()[self.cells_range(entry)];
+        entry
+            .palette
+            .get(BlockStorage::read_le(cells, entry.width as usize, index))
+    }
+
+    fn cells_range(&self, entry: &RegionEntry) -> Range<usize> {
+        let start = self.base + entry.cells.offset as usize;
+        start..start + entry.cells.len as usize
+    }
+
+    /// Build one region, copying its cells once. Cells that do not match
+    /// the header (an index past the palette, a wrong non-air count or
+    /// tight bounds) are an error.
+    pub fn region(&self, key: &str) -> Result<Region> {
+        let i = self
+            .entry_index(key)
+            .ok_or_else(|| format!("Snapshot has no region '{}'", key))?;
+        self.build_region(i)
+    }
+
+    fn build_region(&self, i: usize) -> Result<Region> {
+        let entry = &self.header.regions[i];
+        let data = self.bytes.as_ref();
+        let blocks =
+            BlockStorage::from_le_bytes(&data[self.cells_range(entry)], entry.width as usize)
+                .ok_or("Snapshot cells have an invalid width")?;
+        check_cells(entry, &self.bounds[i], &blocks)?;
+        let extras = entry.extras.range(self.base, data.len())?;
+        let (entities, block_entities): (Vec<Entity>, BlockEntityStore) =
+            bincode::deserialize(&data[extras])?;
+        Ok(Region::from_parts(
+            entry.name.clone(),
+            entry.position,
+            entry.size,
+            blocks,
+            entry.palette.clone(),
+            entities,
+            block_entities,
+            entry.non_air_count as usize,
+            entry.tight_bounds.clone(),
+        ))
+    }
+
+    /// Build the whole schematic.
+    pub fn to_schematic(&self) -> Result<UniversalSchematic> {
+        let mut schematic = UniversalSchematic::new(String::new());
+        schematic.metadata = self.header.metadata.clone();
+        schematic.default_region_name = self.header.default_region_name.clone();
+        schematic.definition_regions = self.header.definition_regions.clone();
+        for (i, entry) in self.header.regions.iter().enumerate() {
+            let region = self.build_region(i)?;
+            if i == 0 {
+                schematic.default_region = region;
+            } else {
+                schematic.other_regions.insert(entry.key.clone(), region);
+            }
+        }
+        Ok(schematic)
+    }
+}
+
+/// Check a region's cells against its header entry in one pass: every cell
+/// must address the palette (or be the no-air sentinel), the non-air count
+/// must match, and the tight bounds must lie in the region and cover every
+/// non-air cell. They may be looser than the cells, as a region's bounds
+/// only grow while it is edited.
+fn check_cells(entry: &RegionEntry, bbox: &BoundingBox, blocks: &BlockStorage) -> Result<()> {
+    let malformed = |what: &str| -> FormatError {
+        format!("Snapshot region '{}' has {}", entry.key, what).into()
+    };
+    let air = entry
+        .palette
+        .iter()
+        .position(|b| b.name == "minecraft:air")
+        .unwrap_or(usize::MAX);
+    let (w, h, l) = bbox.get_dimensions();
+    let mut count = 0u64;
+    let mut content: Option<BoundingBox> = None;
+    let mut cells = blocks.iter();
+    for y in bbox.min.1..bbox.min.1 + h {
+        for z in bbox.min.2..bbox.min.2 + l {
+            for (x, value) in (bbox.min.0..).zip(cells.by_ref().take(w as usize)) {
+                if value == air {
+                    continue;
+                }
+                if value >= entry.palette.len() {
+                    return Err(malformed("a cell outside its palette"));
+                }
+                count += 1;
+                match &mut content {
+                    Some(b) => {
+                        b.min = (b.min.0.min(x), b.min.1.min(y), b.min.2.min(z));
+                        b.max = (b.max.0.max(x), b.max.1.max(y), b.max.2.max(z));
+                    }
+                    None => content = Some(BoundingBox::new((x, y, z), (x, y, z))),
+                }
+            }
+        }
+    }
+    if count != entry.non_air_count {
+        return Err(malformed("a non-air count that does not match its cells"));
+    }
+    let bounds_ok = match (&entry.tight_bounds, &content) {
+        (Some(tight), _) if !(bbox.contains(tight.min) && bbox.contains(tight.max)) => false,
+        (Some(tight), Some(c)) => tight.contains(c.min) && tight.contains(c.max),
+        (Some(_), None) => true,
+        (None, c) => c.is_none(),
+    };
+    if !bounds_ok {
+        return Err(malformed("tight bounds that do not match its cells"));
+    }
+    Ok(())
+}
+
+#[derive(Serialize, Deserialize)]
+struct ManifestBody {
+    /// Snapshot bytes before the data sections: preamble, header, padding.
+    head: Vec<u8>,
+    /// Length of the whole snapshot.
+    len: u64,
+    /// Every region's cells, then its extras. Bytes between sections are
+    /// alignment padding.
+    sections: Vec<ChunkedSpan>,
+}
+
+#[derive(Serialize, Deserialize)]
+struct ChunkedSpan {
+    /// Start within the snapshot.
+    offset: u64,
+    len: u64,
+    /// Hex blake3 hash of each chunk, in order.
+    chunks: Vec<String>,
+}
+
+/// A version 2 snapshot cut into content-addressed chunks.
+pub struct ChunkedSnapshot {
+    /// The encoded [`ChunkManifest`].
+    pub manifest: Vec<u8>,
+    /// `(hex blake3 hash, bytes)` of each distinct chunk, in first-use order.
+    pub chunks: Vec<(String, Vec<u8>)>,
+}
+
+/// Snapshot `schematic` and cut each region's cells and extras into chunks
+/// of `chunk_size` bytes (at least 64).
+pub fn to_chunked_snapshot(
+    schematic: &UniversalSchematic,
+    chunk_size: usize,
+) -> Result<ChunkedSnapshot> {
+    let chunk_size = chunk_size.max(ALIGN);
+    let bytes = to_snapshot(schematic)?;
+    let snapshot = Snapshot::parse(bytes.as_slice())?;
+    let mut seen = HashSet::new();
+    let mut chunks = Vec::new();
+    let mut sections = Vec::with_capacity(snapshot.header.regions.len() * 2);
+    for entry in &snapshot.header.regions {
+        for span in [entry.cells, entry.extras] {
+            let range = span.range(snapshot.base, bytes.len())?;
+            let ids = bytes[range.clone()]
+                .chunks(chunk_size)
+                .map(|chunk| {
+                    let id = blake3::hash(chunk).to_hex().to_string();
+                    if seen.insert(id.clone()) {
+                        chunks.push((id.clone(), chunk.to_vec()));
+                    }
+                    id
+                })
+                .collect();
+            sections.push(ChunkedSpan {
+                offset: range.start as u64,
+                len: span.len,
+                chunks: ids,
+            });
+        }
+    }
+    let body = ManifestBody {
+        head: bytes[..snapshot.base].to_vec(),
+        len: bytes.len() as u64,
+        sections,
+    };
+    let mut manifest = Vec::with_capacity(8 + body.head.len());
+    manifest.extend_from_slice(MANIFEST_MAGIC);
+    manifest.extend_from_slice(&MANIFEST_VERSION.to_le_bytes());
+    bincode::serialize_into(&mut manifest, &body)?;
+    Ok(ChunkedSnapshot { manifest, chunks })
+}
+
+/// Whether `data` starts like a chunk manifest.
+pub fn is_chunk_manifest(data: &[u8]) -> bool {
+    data.len() >= 4 && &data[0..4] == MANIFEST_MAGIC
+}
+
+/// A parsed chunk manifest, written by [`to_chunked_snapshot`].
+pub struct ChunkManifest {
+    body: ManifestBody,
+}
+
+impl ChunkManifest {
+    pub fn parse(data: &[u8]) -> Result<Self> {
+        if data.len() < 8 || !is_chunk_manifest(data) {
+            return Err("Invalid chunk manifest magic bytes".into());
+        }
+        let version = u32::from_le_bytes(data[4..8].try_into()?);
+        if version != MANIFEST_VERSION {
+            return Err(format!("Unsupported chunk manifest version: {}", version).into());
+        }
+        Ok(ChunkManifest {
+            body: bincode::deserialize(&data[8..])?,
+        })
+    }
+
+    /// Distinct chunk hashes, in first-use order.
+    pub fn chunk_ids(&self) -> Vec<&str> {
+        let mut seen = HashSet::new();
+        self.body
+            .sections
+            .iter()
+            .flat_map(|section| &section.chunks)
+            .map(String::as_str)
+            .filter(|id| seen.insert(*id))
+            .collect()
+    }
+
+    /// Rebuild the snapshot bytes from `chunks`, the contents of
+    /// [`chunk_ids`](Self::chunk_ids) in that order. Every chunk is checked
+    /// against its hash.
+    pub fn assemble(&self, chunks: &[Vec<u8>]) -> Result<Vec<u8>> {
+        let ids = self.chunk_ids();
+        if ids.len() != chunks.len() {
+            return Err("Chunk manifest needs one chunk per id".into());
+        }
+        let mut by_id = HashMap::with_capacity(ids.len());
+        for (id, chunk) in ids.into_iter().zip(chunks) {
+            if blake3::hash(chunk).to_hex().as_str() != id {
+                return Err(format!("Chunk {} does not match its hash", id).into());
+            }
+            by_id.insert(id, chunk.as_slice());
+        }
+
+        let len = usize::try_from(self.body.len).map_err(|_| "Chunk manifest too large")?;
+        let head = &self.body.head;
+        if head.len() > len {
+            return Err("Chunk manifest head out of range".into());
+        }
+        let mut out = vec![0u8; len];
+        out[..head.len()].copy_from_slice(head);
+        for section in &self.body.sections {
+            let start = usize::try_from(section.offset).unwrap_or(usize::MAX);
+            let mut at = start;
+            for id in &section.chunks {
+                let chunk = by_id[id.as_str()];
+                let end = at
+                    .checked_add(chunk.len())
+                    .filter(|&end| end <= len)
+                    .ok_or("Chunk manifest section out of range")?;
+                out[at..end].copy_from_slice(chunk);
+                at = end;
+            }
+            if (at - start) as u64 != section.len {
+                return Err("Chunk manifest section has the wrong length".into());
+            }
+        }
+        Ok(out)
+    }
+}
@@ -0,0 +1,429 @@
+//! `.nusl` checkpoint logs: a [snapshot](super::snapshot) of a schematic
+//! followed by deltas appended at each checkpoint.
+//!
+//! ```text
+//! "NUSL" | u32 version = 1 | u64 base length | base (version 2 snapshot)
+//! | u64 record length | record (bincode) | ...
+//! ```
+//!
+//! Each record holds what changed since the one before it. Cells are stored
+//! per section, using the sections a [`Region`] reports from
+//! [`Region::take_changed_sections`]. A region whose layout changed, or one
+//! the log has not seen under its key, is stored whole. Palettes, entities,
+//! block entities, metadata and definition regions are small next to the
+//! cells, so every record repeats them. Record size therefore follows the
+//! edits, not the volume.
+//!
+//! A torn final record, left by a crash during an append, is dropped on
+//! open. Compaction rewrites the log as a lone base next to the file and
+//! renames it over the old one.
+
+use crate::block_entity_store::BlockEntityStore;
+use crate::block_storage::BlockStorage;
+use crate::bounding_box::BoundingBox;
+use crate::definition_region::DefinitionRegion;
+use crate::entity::Entity;
+use crate::formats::error::Result;
+use crate::formats::snapshot::{to_snapshot, Snapshot};
+use crate::metadata::Metadata;
+use crate::region::Region;
+use crate::universal_schematic::UniversalSchematic;
+use crate::BlockState;
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::fs::{File, OpenOptions};
+use std::io::Write;
+use std::path::{Path, PathBuf};
+
+const MAGIC: &[u8; 4] = b"NUSL";
+const VERSION: u32 = 1;
+/// Magic, version and base length.
+const PREAMBLE: usize = 16;
+
+#[derive(Serialize, Deserialize)]
+struct Delta {
+    metadata: Metadata,
+    default_region_name: String,
+    definition_regions: HashMap<String, DefinitionRegion>,
+    /// Every region at this checkpoint, default first. Regions the record
+    /// does not list were removed.
+    regions: Vec<RegionDelta>,
+}
+
+#[derive(Serialize, Deserialize)]
+struct RegionDelta {
+    key: String,
+    name: String,
+    position: (i32, i32, i32),
+    size: (i32, i32, i32),
+    palette: Vec<BlockState>,
+    non_air_count: u64,
+    tight_bounds: Option<BoundingBox>,
+    entities: Vec<Entity>,
+    block_entities: BlockEntityStore,
+    cells: Cells,
+}
+
+#[derive(Serialize, Deserialize)]
+enum Cells {
+    /// Every cell, as a snapshot stores them.
+    All { width: u8, bytes: Vec<u8> },
+    /// Sections written since the previous record, each a box and its
+    /// palette indices in storage order.
+    Sections(Vec<(BoundingBox, Vec<u32>)>),
+}
+
+/// An open checkpoint log. Checkpoints append what changed in the schematic
+/// since the last one; the log compacts itself once its deltas outgrow the
+/// base.
+pub struct SnapshotLog {
+    path: PathBuf,
+    file: File,
+    base_len: u64,
+    /// Bytes appended since the base.
+    delta_len: u64,
+    /// Name and box of each region the log holds, by key.
+    written: HashMap<String, (String, BoundingBox)>,
+    /// A checkpoint failed part way, so the next one compacts instead.
+    stale: bool,
+}
+
+impl SnapshotLog {
+    /// Start a log at `path` holding a full snapshot of `schematic`,
+    /// replacing any file there, and begin tracking its changes.
+    pub fn create(path: impl AsRef<Path>, schematic: &mut UniversalSchematic) -> Result<Self> {
+        let path = path.as_ref().to_path_buf();
+        let base_len = write_base(&path, schematic)?;
+        let file = OpenOptions::new().append(true).open(&path)?;
+        let mut log = SnapshotLog {
+            path,
+            file,
+            base_len,
+            delta_len: 0,
+            written: HashMap::new(),
+            stale: false,
+        };
+        log.start_tracking(schematic);
+        Ok(log)
+    }
+
+    /// Open the log at `path` and restore the schematic from its last
+    /// complete checkpoint. A torn record at the end is cut off. Changes to
+    /// the returned schematic are tracked from here.
+    pub fn open(path: impl AsRef<Path>) -> Result<(Self, UniversalSchematic)> {
+        let path = path.as_ref().to_path_buf();
+        let data = std::fs::read(&path)?;
+        let (mut schematic, base_len, complete) = replay(&data)?;
+        let file = OpenOptions::new().write(true).open(&path)?;
+        file.set_len(complete as u64)?;
+        drop(file);
+        let file = OpenOptions::new().append(true).open(&path)?;
+        let mut log = SnapshotLog {
+            path,
+            file,
+            base_len,
+            delta_len: complete as u64 - (PREAMBLE as u64 + base_len),
+            written: HashMap::new(),
+            stale: false,
+        };
+        log.start_tracking(&mut schematic);
+        Ok((log, schematic))
+    }
+
+    /// Append the changes to `schematic` since the last checkpoint and sync
+    /// the file. Compacts instead when the deltas have grown past the base.
+    pub fn checkpoint(&mut self, schematic: &mut UniversalSchematic) -> Result<()> {
+        if self.stale || self.delta_len > self.base_len {
+            return self.compact(schematic);
+        }
+        let result = self.append(schematic);
+        self.stale = result.is_err();
+        result
+    }
+
+    /// Rewrite the log as a single base snapshot of `schematic`.
+    pub fn compact(&mut self, schematic: &mut UniversalSchematic) -> Result<()> {
+        // Until the new base is in place, the next checkpoint must retry.
+        self.stale = true;
+        let tmp = self.path.with_extension("nusl.tmp");
+        let base_len = write_base(&tmp, schematic)?;
+        std::fs::rename(&tmp, &self.path)?;
+        self.file = OpenOptions::new().append(true).open(&self.path)?;
+        self.base_len = base_len;
+        self.delta_len = 0;
+        self.stale = false;
+        self.start_tracking(schematic);
+        Ok(())
+    }
+
+    /// Bytes of deltas appended since the base was written.
+    pub fn delta_len(&self) -> u64 {
+        self.delta_len
+    }
+
+    fn append(&mut self, schematic: &mut UniversalSchematic) -> Result<()> {
+        let mut keys: Vec<String> = schematic.other_regions.keys().cloned().collect();
+        keys.sort();
+        let mut written = HashMap::with_capacity(keys.len() + 1);
+        let mut regions = Vec::with_capacity(keys.len() + 1);
+        let default_key = schematic.default_region_name.clone();
+        regions.push(self.region_delta(
+            &default_key,
+            &mut schematic.default_region,
+            &mut written,
+        )?);
+        for key in keys {
+            let region = schematic.other_regions.get_mut(&key).expect("listed above");
+            regions.push(self.region_delta(&key, region, &mut written)?);
+        }
+
+        let record = bincode::serialize(&Delta {
+            metadata: schematic.metadata.clone(),
+            default_region_name: default_key,
+            definition_regions: schematic.definition_regions.clone(),
+            regions,
+        })?;
+        let mut framed = Vec::with_capacity(8 + record.len());
+        framed.extend_from_slice(&(record.len() as u64).to_le_bytes());
+        framed.extend_from_slice(&record);
+        self.file.write_all(&framed)?;
+        self.file.sync_data()?;
+        self.delta_len += framed.len() as u64;
+        self.written = written;
+        Ok(())
+    }
+
+    fn region_delta(
+        &self,
+        key: &str,
+        region: &mut Region,
+        written: &mut HashMap<String, (String, BoundingBox)>,
+    ) -> Result<RegionDelta> {
+        let bbox = region.get_bounding_box();
+        let seen = self.written.get(key) == Some(&(region.name.clone(), bbox.clone()));
+        let cells = match region.take_changed_sections().filter(|_| seen) {
+            Some(sections) => {
+                let mut changed = Vec::with_capacity(sections.len());
+                for section in sections {
+                    let mut cells = vec![0; section.volume() as usize];
+                    region.read_palette_indices(section.min, section.max, &mut cells)?;
+                    changed.push((section, cells));
+                }
+                Cells::Sections(changed)
+            }
+            None => {
+                let mut bytes = Vec::new();
+                let width = region.blocks.write_le_bytes(&mut bytes);
+                Cells::All {
+                    width: width as u8,
+                    bytes,
+                }
+            }
+        };
+        written.insert(key.to_string(), (region.name.clone(), bbox));
+        Ok(RegionDelta {
+            key: key.to_string(),
+            name: region.name.clone(),
+            position: region.position,
+            size: region.size,
+            palette: region.get_palette(),
+            non_air_count: region.count_non_air_blocks() as u64,
+            tight_bounds: region.get_tight_bounds(),
+            entities: region.entities.to_vec(),
+            block_entities: region.block_entities.clone(),
+            cells,
+        })
+    }
+
+    /// Note every region as held by the log and clear its change marks.
+    fn start_tracking(&mut self, schematic: &mut UniversalSchematic) {
+        self.written.clear();
+        let default = std::iter::once((
+            &schematic.default_region_name,
+            &mut schematic.default_region,
+        ));
+        for (key, region) in default.chain(schematic.other_regions.iter_mut()) {
+            region.take_changed_sections();
+            self.written.insert(
+                key.clone(),
+                (region.name.clone(), region.get_bounding_box()),
+            );
+        }
+    }
+}
+
+/// Write `"NUSL" | version | base length | snapshot` to `path` and sync it.
+/// Returns the snapshot's length.
+fn write_base(path: &Path, schematic: &UniversalSchematic) -> Result<u64> {
+    let base = to_snapshot(schematic)?;
+    let mut file = File::create(path)?;
+    let mut preamble = Vec::with_capacity(PREAMBLE);
+    preamble.extend_from_slice(MAGIC);
+    preamble.extend_from_slice(&VERSION.to_le_bytes());
+    preamble.extend_from_slice(&(base.len() as u64).to_le_bytes());
+    file.write_all(&preamble)?;
+    file.write_all(&base)?;
+    file.sync_all()?;
+    Ok(base.len() as u64)
+}
+
+/// Load the schematic a checkpoint log ends at, ignoring a torn final
+/// record.
+pub fn from_snapshot_log(data: &[u8]) -> Result<UniversalSchematic> {
+    replay(data).map(|(schematic, _, _)| schematic)
+}
+
+/// The replayed schematic, the base length and the length of the log up to
+/// its last complete record.
+fn replay(data: &[u8]) -> Result<(UniversalSchematic, u64, usize)> {
+    if data.len() < PREAMBLE || &data[0..4] != MAGIC {
+        return Err("Not a snapshot log".into());
+    }
+    let version = u32::from_le_bytes(data[4..8].try_into()?);
+    if version != VERSION {
+        return Err(format!("Unsupported snapshot log version: {}", version).into());
+    }
+    let base_len = u64::from_le_bytes(data[8..PREAMBLE].try_into()?);
+    let base_end = usize::try_from(base_len)
+        .ok()
+        .and_then(|len| len.checked_add(PREAMBLE))
+        .filter(|&end| end <= data.len())
+        .ok_or("Snapshot log base out of range")?;
+    let mut schematic = Snapshot::parse(&data[PREAMBLE..base_end])?.to_schematic()?;
+
+    let mut at = base_end;
+    while let Some(len) = data.get(at..at + 8) {
+        let len = u64::from_le_bytes(len.try_into().unwrap());
+        let record = usize::try_from(len)
+            .ok()
+            .and_then(|len| at.checked_add(8 + len))
+            .and_then(|end| data.get(at + 8..end));
+        let Some(record) = record else {
+            break;
+        };
+        apply(&mut schematic, bincode::deserialize(record)?)?;
+        at += 8 + record.len();
+    }
+    Ok((schematic, base_len, at))
+}
+
+fn apply(schematic: &mut UniversalSchematic, delta: Delta) -> Result<()> {
+    let mut previous: HashMap<String, Region> = std::mem::take(&mut schematic.other_regions);
+    let default = std::mem::replace(
+        &mut schematic.default_region,
+        Region::new(String::new(), (0, 0, 0), (1, 1, 1)),
+    );
+    previous.insert(schematic.default_region_name.clone(), default);
+
+    schematic.metadata = delta.metadata;
+    schematic.default_region_name = delta.default_region_name;
+    schematic.definition_regions = delta.definition_regions;
+    for (i, entry) in delta.regions.into_iter().enumerate() {
+        let blocks = match entry.cells {
+            Cells::All { width, bytes } => BlockStorage::from_le_bytes(&bytes, width as usize)
+                .ok_or("Snapshot log cells have an invalid width")?,
+            Cells::Sections(sections) => {
+                let mut region = previous
+                    .remove(&entry.key)
+                    .filter(|region| (region.position, region.size) == (entry.position, entry.size))
+                    .ok_or_else(|| {
+                        format!("Snapshot log updates region '{}' it never wrote", entry.key)
+                    })?;
+                region.palette = entry.palette.clone();
+                region.rebuild_palette_index();
+                region.rebuild_air_index();
+                for (section, cells) in sections {
+                    region.write_palette_indices(section.min, section.max, &cells)?;
+                }
+                region.blocks
+            }
+        };
+        let region = Region::from_parts(
+            entry.name,
+            entry.position,
+            entry.size,
+            blocks,
+            entry.palette,
+            entry.entities,
+            entry.block_entities,
+            entry.non_air_count as usize,
+            entry.tight_bounds,
+        );
+        if i == 0 {
+            schematic.default_region = region;
+        } else {
+            schematic.other_regions.insert(entry.key, region);
+        }
+    }
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn checkpoints_append_changed_sections_and_replay() {
+        let dir = std::env::temp_dir().join(format!("nuc-snaplog-{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let path = dir.join("build.nusl");
+
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        let mut schematic = UniversalSchematic::new("Checkpoints".to_string());
+        for x in 0..64 {
+            for z in 0..64 {
+                schematic.set_block(x, 0, z, &stone);
+            }
+        }
+        let mut log = SnapshotLog::create(&path, &mut schematic).unwrap();
+        let base = std::fs::metadata(&path).unwrap().len();
+
+        // A handful of writes in one section cost one section, not the volume.
+        for x in 0..4 {
+            schematic.set_block(x, 0, 0, &glass);
+        }
+        log.checkpoint(&mut schematic).unwrap();
+        assert!(
+            log.delta_len() < base / 4,
+            "{} vs {}",
+            log.delta_len(),
+            base
+        );
+
+        // A second region, and growth of the first, are written whole.
+        let mut extra = Region::new("Extra".to_string(), (100, 0, 0), (2, 2, 2));
+        extra.set_block(100, 0, 0, &glass);
+        schematic.add_region(extra);
+        schematic.set_block(-20, 5, -20, &glass);
+        log.checkpoint(&mut schematic).unwrap();
+        schematic.set_block(10, 0, 10, &glass);
+        log.checkpoint(&mut schematic).unwrap();
+
+        // A torn append is dropped on open.
+        let mut file = OpenOptions::new().append(true).open(&path).unwrap();
+        file.write_all(&[9, 0, 0, 0, 0, 0, 0, 0, 1, 2]).unwrap();
+        drop(file);
+
+        let (mut reopened, mut restored) = SnapshotLog::open(&path).unwrap();
+        for (x, y, z) in [
+            (0, 0, 0),
+            (3, 0, 0),
+            (4, 0, 0),
+            (10, 0, 10),
+            (-20, 5, -20),
+            (63, 0, 63),
+        ] {
+            assert_eq!(restored.get_block(x, y, z), schematic.get_block(x, y, z));
+        }
+        assert_eq!(restored.get_block(100, 0, 0), Some(&glass));
+        assert_eq!(restored.total_blocks(), schematic.total_blocks());
+
+        reopened.compact(&mut restored).unwrap();
+        assert_eq!(reopened.delta_len(), 0);
+        let compacted = from_snapshot_log(&std::fs::read(&path).unwrap()).unwrap();
+        assert_eq!(compacted.total_blocks(), schematic.total_blocks());
+
+        std::fs::remove_dir_all(&dir).ok();
+    }
+}
@@ -6,7 +6,8 @@ use crate::formats::manager::{SchematicExporter, SchematicImporter};
 use crate::utils::NbtMap;
 use crate::{BlockState, UniversalSchematic};
 use quartz_nbt::{NbtCompound, NbtList, NbtTag};
-use std::collections::BTreeSet;
+use std::collections::HashMap;
+use std::io::Write;
 
 /// Java structure SNBT source files are rectangular and can be used by data
 /// packs, mod tooling, guides, and GameTest suites. These deliberately generous
@@ -61,30 +62,50 @@ impl SchematicExporter for StructureSnbtFormat {
 }
 
 pub fn to_structure_snbt(schematic: &UniversalSchematic) -> Result<Vec<u8>> {
+    write_structure_snbt(schematic, Vec::new())
+}
+
+/// Write `schematic` as structure SNBT to `out`, one block entry at a time,
+/// and return `out`. Only the palette is kept while writing, so wrap a file
+/// in a `BufWriter` rather than building the text first.
+pub fn write_structure_snbt<W: Write>(schematic: &UniversalSchematic, mut out: W) -> Result<W> {
     let bounds = schematic.get_bounding_box();
     let min = bounds.min;
     let size = checked_bounds_dimensions(bounds.min, bounds.max)?;
-    let volume = checked_structure_volume(size)?;
-    let mut palette = BTreeSet::new();
-    let mut data_entries = Vec::new();
-    data_entries.try_reserve_exact(volume).map_err(|error| {
-        FormatError::Parse(format!(
-            "cannot allocate structure SNBT with {volume} blocks: {error}"
-        ))
-    })?;
+    checked_structure_volume(size)?;
+    let data_version = schematic
+        .metadata
+        .mc_version
+        .or(schematic.metadata.source_data_version)
+        .unwrap_or(crate::dataconverter::CANONICAL_DATA_VERSION);
+    write!(
+        out,
+        "{{DataVersion:{data_version},size:[{},{},{}],data:[",
+        size.0, size.1, size.2
+    )?;
+
+    let air = BlockState::new("minecraft:air");
+    // Each distinct state is formatted and quoted once, on first sight.
+    let mut state_ids: HashMap<&BlockState, usize> = HashMap::new();
+    let mut palette: Vec<String> = Vec::new();
+    let mut separator = "";
     for y in min.1..=bounds.max.1 {
         for z in min.2..=bounds.max.2 {
             for x in min.0..=bounds.max.0 {
-                let state = schematic
-                    .get_block(x, y, z)
-                    .cloned()
-                    .unwrap_or_else(|| BlockState::new("minecraft:air"));
-                let state_string = format_structure_block_state(&state);
-                palette.insert(state_string.clone());
-
-                let mut entry = NbtCompound::new();
-                entry.insert("pos", int_list((x - min.0, y - min.1, z - min.2)));
-                entry.insert("state", NbtTag::String(state_string));
+                let state = schematic.get_block(x, y, z).unwrap_or(&air);
+                let id = *state_ids.entry(state).or_insert_with(|| {
+                    palette.push(NbtTag::String(format_structure_block_state(state)).to_snbt());
+                    palette.len() - 1
+                });
+                write!(
+                    out,
+                    "{separator}{{pos:[{},{},{}],state:{}",
+                    x - min.0,
+                    y - min.1,
+                    z - min.2,
+                    palette[id]
+                )?;
+                separator = ",";
                 if let Some(block_entity) =
                     schematic.get_block_entity_owned(BlockPosition { x, y, z })
                 {
@@ -92,60 +113,37 @@ pub fn to_structure_snbt(schematic: &UniversalSchematic) -> Result<Vec<u8>> {
                     if !nbt.contains_key("id") && !nbt.contains_key("Id") {
                         nbt.insert("id", NbtTag::String(block_entity.id));
                     }
-                    entry.insert("nbt", NbtTag::Compound(nbt));
+                    write!(out, ",nbt:{}", NbtTag::Compound(nbt).to_snbt())?;
                 }
-                data_entries.push(NbtTag::Compound(entry));
+                out.write_all(b"}")?;
             }
         }
     }
 
-    let mut entity_entries = Vec::new();
+    out.write_all(b"],entities:[")?;
+    let mut separator = "";
     for entity in schematic.get_entities_as_list() {
         let relative = (
             entity.position.0 - f64::from(min.0),
             entity.position.1 - f64::from(min.1),
             entity.position.2 - f64::from(min.2),
         );
-        let mut entry = NbtCompound::new();
-        entry.insert(
-            "blockPos",
-            int_list((
-                relative.0.floor() as i32,
-                relative.1.floor() as i32,
-                relative.2.floor() as i32,
-            )),
-        );
-        entry.insert("pos", double_list(relative));
-        entry.insert("nbt", entity.to_nbt());
-        entity_entries.push(NbtTag::Compound(entry));
+        write!(
+            out,
+            "{separator}{{blockPos:[{},{},{}],pos:{},nbt:{}}}",
+            relative.0.floor() as i32,
+            relative.1.floor() as i32,
+            relative.2.floor() as i32,
+            double_list(relative).to_snbt(),
+            entity.to_nbt().to_snbt()
+        )?;
+        separator = ",";
     }
 
-    let data_version = schematic
-        .metadata
-        .mc_version
-        .or(schematic.metadata.source_data_version)
-        .unwrap_or(crate::dataconverter::CANONICAL_DATA_VERSION);
-    let mut root = NbtCompound::new();
-    root.insert("DataVersion", NbtTag::Int(data_version));
-    root.insert("size", int_list(size));
-    root.insert("data", NbtTag::List(NbtList::from(data_entries)));
-    root.insert("entities", NbtTag::List(NbtList::from(entity_entries)));
-    root.insert(
-        "palette",
-        NbtTag::List(NbtList::from(
-            palette.into_iter().map(NbtTag::String).collect::<Vec<_>>(),
-        )),
-    );
-
-    Ok(NbtTag::Compound(root).to_snbt().into_bytes())
-}
-
-fn int_list(value: (i32, i32, i32)) -> NbtTag {
-    NbtTag::List(NbtList::from(vec![
-        NbtTag::Int(value.0),
-        NbtTag::Int(value.1),
-        NbtTag::Int(value.2),
-    ]))
+    palette.sort_unstable();
+    write!(out, "],palette:[{}]}}", palette.join(","))?;
+    out.flush()?;
+    Ok(out)
 }
 
 fn double_list(value: (f64, f64, f64)) -> NbtTag {
@@ -173,7 +171,17 @@ fn format_structure_block_state(state: &BlockState) -> String {
     output
 }
 
+/// Detect structure SNBT. Anything that does not open with a compound, or
+/// never names `DataVersion` and `palette`, is rejected before the text is
+/// parsed; the format manager asks every importer about every file.
 pub fn is_structure_snbt(data: &[u8]) -> bool {
+    let opens_compound = data
+        .iter()
+        .find(|b| !b.is_ascii_whitespace())
+        .is_some_and(|&b| b == b'{');
+    if !opens_compound || !contains(data, b"DataVersion") || !contains(data, b"palette") {
+        return false;
+    }
     let Ok(text) = std::str::from_utf8(data) else {
         return false;
     };
@@ -187,6 +195,12 @@ pub fn is_structure_snbt(data: &[u8]) -> bool {
         && matches!(root.inner().get("palette"), Some(NbtTag::List(_)))
 }
 
+fn contains(haystack: &[u8], needle: &[u8]) -> bool {
+    haystack
+        .windows(needle.len())
+        .any(|window| window == needle)
+}
+
 pub fn from_structure_snbt(data: &[u8]) -> Result<UniversalSchematic> {
     let text = std::str::from_utf8(data)
         .map_err(|error| FormatError::Parse(format!("structure SNBT is not UTF-8: {error}")))?;
@@ -1,11 +1,16 @@
 use crate::block_entity::BlockEntity;
-use crate::block_position::BlockPosition;
+use crate::block_entity_store::BlockEntityInterner;
+use crate::bounding_box::BoundingBox;
 use crate::formats::anvil::{
-    floor_div, floor_mod, is_mca, parse_entity_mca, write_entity_mca, ChunkData, ChunkSection,
-    EntityChunkData, McaFile,
+    floor_div, floor_mod, is_mca, parse_entity_mca, write_entity_mca_with, ChunkCompression,
+    ChunkData, ChunkSection, CompressionType, EntityChunkData, McaFile,
 };
 use crate::formats::error::Result;
-use crate::formats::manager::{SchematicExporter, SchematicImporter};
+use crate::formats::manager::{
+    compression_level, BoundsSettings, SchematicExporter, SchematicImporter,
+};
+use crate::formats::world_zip::{WorldZip, ZipCompression};
+use crate::region::Region;
 use crate::universal_schematic::UniversalSchematic;
 use crate::BlockState;
 use flate2::write::GzEncoder;
@@ -64,6 +69,23 @@ pub struct WorldExportOptions {
     /// from an existing world are never overwritten.
     #[serde(default = "default_biome")]
     pub biome: String,
+    /// Codec for region chunks: "zlib" (vanilla default), "gzip",
+    /// "uncompressed" or "lz4" (readable by 1.20.5+).
+    #[serde(default = "default_chunk_compression")]
+    pub chunk_compression: CompressionType,
+    /// Deflate level 0-9 for zlib and gzip chunks (None = default level).
+    #[serde(default)]
+    pub compression_level: Option<u32>,
+}
+
+impl WorldExportOptions {
+    /// The chunk codec and level these options select.
+    pub fn chunk_codec(&self) -> Result<ChunkCompression> {
+        Ok(ChunkCompression {
+            codec: self.chunk_compression,
+            level: compression_level(self.compression_level, Compression::default())?,
+        })
+    }
 }
 
 fn default_world_name() -> String {
@@ -87,6 +109,9 @@ fn default_day_time() -> Option<i64> {
 fn default_biome() -> String {
     "minecraft:plains".to_string()
 }
+fn default_chunk_compression() -> CompressionType {
+    CompressionType::Zlib
+}
 
 impl Default for WorldExportOptions {
     fn default() -> Self {
@@ -103,33 +128,14 @@ impl Default for WorldExportOptions {
             day_time: default_day_time(),
             disable_mob_spawning: true,
             biome: default_biome(),
+            chunk_compression: default_chunk_compression(),
+            compression_level: None,
         }
     }
 }
 
 /// Settings for world import (bounds filtering).
-#[derive(Debug, Clone, Serialize, Deserialize, Default)]
-pub struct WorldImportSettings {
-    pub min_x: Option<i32>,
-    pub min_y: Option<i32>,
-    pub min_z: Option<i32>,
-    pub max_x: Option<i32>,
-    pub max_y: Option<i32>,
-    pub max_z: Option<i32>,
-}
-
-impl WorldImportSettings {
-    fn bounds(&self) -> Option<(i32, i32, i32, i32, i32, i32)> {
-        match (
-            self.min_x, self.min_y, self.min_z, self.max_x, self.max_y, self.max_z,
-        ) {
-            (Some(min_x), Some(min_y), Some(min_z), Some(max_x), Some(max_y), Some(max_z)) => {
-                Some((min_x, min_y, min_z, max_x, max_y, max_z))
-            }
-            _ => None,
-        }
-    }
-}
+pub type WorldImportSettings = BoundsSettings;
 
 // ─── Format Handlers (for FormatManager auto-detection) ─────────────────────
 
@@ -153,18 +159,17 @@ impl SchematicImporter for McaFormat {
         data: &[u8],
         settings: Option<&str>,
     ) -> Result<UniversalSchematic> {
-        let bounds = settings
-            .map(serde_json::from_str::<WorldImportSettings>)
-            .transpose()?
-            .and_then(|s| s.bounds());
-        match bounds {
-            Some((min_x, min_y, min_z, max_x, max_y, max_z)) => {
-                from_mca_bounded(data, min_x, min_y, min_z, max_x, max_y, max_z)
-            }
-            None => from_mca(data),
+        match BoundsSettings::from_settings(settings)?.bounds() {
+            Some(bounds) => self.read_bounded(data, &bounds),
+            None => self.read(data),
         }
     }
 
+    fn read_bounded(&self, data: &[u8], bounds: &BoundingBox) -> Result<UniversalSchematic> {
+        let (min, max) = (bounds.min, bounds.max);
+        from_mca_bounded(data, min.0, min.1, min.2, max.0, max.1, max.2)
+    }
+
     fn import_settings_schema(&self) -> Option<String> {
         serde_json::to_string_pretty(&WorldImportSettings::default()).ok()
     }
@@ -190,18 +195,17 @@ impl SchematicImporter for WorldZipFormat {
         data: &[u8],
         settings: Option<&str>,
     ) -> Result<UniversalSchematic> {
-        let bounds = settings
-            .map(serde_json::from_str::<WorldImportSettings>)
-            .transpose()?
-            .and_then(|s| s.bounds());
-        match bounds {
-            Some((min_x, min_y, min_z, max_x, max_y, max_z)) => {
-                from_world_zip_bounded(data, min_x, min_y, min_z, max_x, max_y, max_z)
-            }
-            None => from_world_zip(data),
+        match BoundsSettings::from_settings(settings)?.bounds() {
+            Some(bounds) => self.read_bounded(data, &bounds),
+            None => self.read(data),
         }
     }
 
+    fn read_bounded(&self, data: &[u8], bounds: &BoundingBox) -> Result<UniversalSchematic> {
+        let (min, max) = (bounds.min, bounds.max);
+        from_world_zip_bounded(data, min.0, min.1, min.2, max.0, max.1, max.2)
+    }
+
     fn import_settings_schema(&self) -> Option<String> {
         serde_json::to_string_pretty(&WorldImportSettings::default()).ok()
     }
@@ -227,10 +231,7 @@ impl SchematicExporter for WorldFormat {
     }
 
     fn write(&self, schematic: &UniversalSchematic, _version: Option<&str>) -> Result<Vec<u8>> {
-        let opts = WorldExportOptions::default();
-        let files = to_world(schematic, None)?;
-        let prefixed = prefix_world_files(&files, &opts.world_name);
-        zip_world_files(&prefixed)
+        to_world_zip(schematic, None)
     }
 
     fn write_with_settings(
@@ -240,13 +241,7 @@ impl SchematicExporter for WorldFormat {
         settings: Option<&str>,
     ) -> Result<Vec<u8>> {
         let options: Option<WorldExportOptions> = settings.map(serde_json::from_str).transpose()?;
-        let world_name = options
-            .as_ref()
-            .map(|o| o.world_name.clone())
-            .unwrap_or_else(default_world_name);
-        let files = to_world(schematic, options)?;
-        let prefixed = prefix_world_files(&files, &world_name);
-        zip_world_files(&prefixed)
+        to_world_zip(schematic, options)
     }
 
     fn export_settings_schema(&self) -> Option<String> {
@@ -254,36 +249,17 @@ impl SchematicExporter for WorldFormat {
     }
 }
 
-/// Add a wrapper directory prefix to all file paths in a WorldFiles map.
-fn prefix_world_files(files: &WorldFiles, world_name: &str) -> WorldFiles {
-    files
-        .iter()
-        .map(|(k, v)| (format!("{}/{}", world_name, k), v.clone()))
-        .collect()
-}
-
-/// Zip a WorldFiles HashMap into a single byte buffer.
+/// Zip a WorldFiles HashMap into a single byte buffer, entries stored and
+/// in path order.
 pub fn zip_world_files(files: &WorldFiles) -> Result<Vec<u8>> {
-    use std::io::Cursor;
-    use zip::write::SimpleFileOptions;
-    use zip::ZipWriter;
-
-    let buf = Vec::new();
-    let cursor = Cursor::new(buf);
-    let mut zip = ZipWriter::new(cursor);
-    let options = SimpleFileOptions::default().compression_method(zip::CompressionMethod::Stored);
-
     let mut paths: Vec<&String> = files.keys().collect();
     paths.sort();
 
+    let mut zip = WorldZip::new(Vec::new(), ZipCompression::Stored);
     for path in paths {
-        let data = &files[path];
-        zip.start_file(path, options)?;
-        std::io::Write::write_all(&mut zip, data)?;
+        zip.add_file(path.clone(), files[path].clone())?;
     }
-
-    let cursor = zip.finish()?;
-    Ok(cursor.into_inner())
+    zip.finish()
 }
 
 /// Export a schematic as a zipped Minecraft world.
@@ -291,13 +267,27 @@ pub fn to_world_zip(
     schematic: &UniversalSchematic,
     options: Option<WorldExportOptions>,
 ) -> Result<Vec<u8>> {
+    to_world_zip_writer(schematic, options, Vec::new(), ZipCompression::Stored)
+}
+
+/// Export a schematic as a zipped Minecraft world into `out`, under a
+/// `world_name/` directory. Each file goes into the archive as soon as it
+/// is encoded, so the world's files are never all held at once.
+pub fn to_world_zip_writer<W: Write>(
+    schematic: &UniversalSchematic,
+    options: Option<WorldExportOptions>,
+    out: W,
+    compression: ZipCompression,
+) -> Result<W> {
     let world_name = options
         .as_ref()
         .map(|o| o.world_name.clone())
         .unwrap_or_else(default_world_name);
-    let files = to_world(schematic, options)?;
-    let prefixed = prefix_world_files(&files, &world_name);
-    zip_world_files(&prefixed)
+    let mut zip = WorldZip::new(out, compression);
+    to_world_with(schematic, options, |path, data| {
+        zip.add_file(format!("{}/{}", world_name, path), data)
+    })?;
+    zip.finish()
 }
 
 // ─── Import: Single MCA ────────────────────────────────────────────────────
@@ -306,7 +296,7 @@ pub fn to_world_zip(
 pub fn from_mca(data: &[u8]) -> Result<UniversalSchematic> {
     let mca = McaFile::from_bytes_auto(data)?;
     let mut schematic = UniversalSchematic::new("MCA Import".to_string());
-    load_mca_into_schematic(&mca, &mut schematic, None);
+    load_regions_into_schematic(&[Some(mca)], &mut schematic, None);
     Ok(schematic)
 }
 
@@ -323,7 +313,7 @@ pub fn from_mca_bounded(
     let mca = McaFile::from_bytes_auto(data)?;
     let mut schematic = UniversalSchematic::new("MCA Import".to_string());
     let bounds = (min_x, min_y, min_z, max_x, max_y, max_z);
-    load_mca_into_schematic(&mca, &mut schematic, Some(bounds));
+    load_regions_into_schematic(&[Some(mca)], &mut schematic, Some(bounds));
     Ok(schematic)
 }
 
@@ -394,19 +384,22 @@ fn from_world_zip_impl(
         }
     }
 
-    // Process block region files
-    for idx in region_indices {
-        let mut file = archive.by_index(idx)?;
-        let name = file.name().to_string();
-
-        let (rx, rz) = parse_region_filename(&name).unwrap_or((0, 0));
+    // Process block region files, reading a batch out of the archive and
+    // decoding it in parallel
+    for batch in region_indices.chunks(REGION_BATCH) {
+        let mut files = Vec::with_capacity(batch.len());
+        for &idx in batch {
+            let mut file = archive.by_index(idx)?;
+            let name = file.name().to_string();
 
-        let mut mca_data = Vec::new();
-        std::io::Read::read_to_end(&mut file, &mut mca_data)?;
+            let (rx, rz) = parse_region_filename(&name).unwrap_or((0, 0));
 
-        if let Ok(mca) = McaFile::from_bytes(&mca_data, rx, rz) {
-            load_mca_into_schematic(&mca, &mut schematic, bounds);
+            let mut mca_data = Vec::new();
+            std::io::Read::read_to_end(&mut file, &mut mca_data)?;
+            files.push((rx, rz, mca_data));
         }
+        let mcas = decode_regions(&files, bounds);
+        load_regions_into_schematic(&mcas, &mut schematic, bounds);
     }
 
     // Process entity region files (1.17+)
@@ -462,19 +455,26 @@ fn from_world_directory_impl(
 
     let mut schematic = UniversalSchematic::new("World Import".to_string());
 
-    // Process block region files
+    // Process block region files in name order, so the result does not
+    // depend on directory listing order
+    let mut region_paths = Vec::new();
     for entry in std::fs::read_dir(&region_dir)? {
-        let entry = entry?;
-        let file_path = entry.path();
+        let file_path = entry?.path();
         if file_path.extension().is_some_and(|ext| ext == "mca") {
+            region_paths.push(file_path);
+        }
+    }
+    region_paths.sort();
+
+    for batch in region_paths.chunks(REGION_BATCH) {
+        let mut files = Vec::with_capacity(batch.len());
+        for file_path in batch {
             let filename = file_path.file_name().and_then(|n| n.to_str()).unwrap_or("");
             let (rx, rz) = parse_region_filename(filename).unwrap_or((0, 0));
-
-            let mca_data = std::fs::read(&file_path)?;
-            if let Ok(mca) = McaFile::from_bytes(&mca_data, rx, rz) {
-                load_mca_into_schematic(&mca, &mut schematic, bounds);
-            }
+            files.push((rx, rz, std::fs::read(file_path)?));
         }
+        let mcas = decode_regions(&files, bounds);
+        load_regions_into_schematic(&mcas, &mut schematic, bounds);
     }
 
     // Process entity region files (1.17+)
@@ -500,11 +500,71 @@ fn from_world_directory_impl(
 
 // ─── Core Import Helper ────────────────────────────────────────────────────
 
+/// Region files decoded at once. Each file already fans out over its 1024
+/// chunks, so a small batch keeps every core busy while bounding how many
+/// decoded regions are held in memory.
+const REGION_BATCH: usize = 4;
+
+/// Decode `(region_x, region_z, bytes)` region files, in parallel off wasm,
+/// skipping chunks that lie outside `bounds`. Files that fail to parse are
+/// `None`; the output is in input order.
+fn decode_regions(
+    files: &[(i32, i32, Vec<u8>)],
+    bounds: Option<(i32, i32, i32, i32, i32, i32)>,
+) -> Vec<Option<McaFile>> {
+    let decode = |(rx, rz, data): &(i32, i32, Vec<u8>)| {
+        McaFile::from_bytes_where(data, *rx, *rz, |cx, cz| chunk_in_bounds(cx, cz, bounds)).ok()
+    };
+    #[cfg(not(target_arch = "wasm32"))]
+    {
+        use rayon::prelude::*;
+        files.par_iter().map(decode).collect()
+    }
+    #[cfg(target_arch = "wasm32")]
+    {
+        files.iter().map(decode).collect()
+    }
+}
+
+/// Whether chunk `(chunk_x, chunk_z)` has any column inside `bounds`.
+fn chunk_in_bounds(
+    chunk_x: i32,
+    chunk_z: i32,
+    bounds: Option<(i32, i32, i32, i32, i32, i32)>,
+) -> bool {
+    let Some((min_x, _, min_z, max_x, _, max_z)) = bounds else {
+        return true;
+    };
+    let (x0, z0) = (chunk_x * 16, chunk_z * 16);
+    x0 <= max_x && x0 + 15 >= min_x && z0 <= max_z && z0 + 15 >= min_z
+}
+
+/// Load decoded region files in order, growing the default region once to
+/// cover all of them first.
+fn load_regions_into_schematic(
+    mcas: &[Option<McaFile>],
+    schematic: &mut UniversalSchematic,
+    bounds: Option<(i32, i32, i32, i32, i32, i32)>,
+) {
+    let chunks = mcas
+        .iter()
+        .flatten()
+        .flat_map(|mca| mca.chunks.iter().flatten());
+    if let Some((min, max)) = content_box(chunks, bounds) {
+        reserve_default_region(schematic, min, max);
+    }
+    let mut interner = BlockEntityInterner::new();
+    for mca in mcas.iter().flatten() {
+        load_mca_into_schematic(mca, schematic, bounds, &mut interner);
+    }
+}
+
 /// Load chunks from an MCA file into a schematic, optionally filtering by bounds.
 fn load_mca_into_schematic(
     mca: &McaFile,
     schematic: &mut UniversalSchematic,
     bounds: Option<(i32, i32, i32, i32, i32, i32)>,
+    interner: &mut BlockEntityInterner,
 ) {
     for chunk_opt in &mca.chunks {
         if let Some(chunk) = chunk_opt {
@@ -516,57 +576,121 @@ fn load_mca_into_schematic(
                     schematic.metadata.mc_version = Some(chunk.data_version);
                 }
             }
-            load_chunk_into_schematic(chunk, schematic, bounds);
+            load_chunk_into_schematic(chunk, schematic, bounds, interner);
         }
     }
 }
 
+/// The part of `section` of `chunk` inside `bounds`, as an inclusive box, or
+/// `None` when it is empty or the section's palette is all air.
+fn section_box(
+    chunk: &ChunkData,
+    section: &ChunkSection,
+    bounds: Option<(i32, i32, i32, i32, i32, i32)>,
+) -> Option<((i32, i32, i32), (i32, i32, i32))> {
+    if section.palette.iter().all(|block| is_air(&block.name)) {
+        return None;
+    }
+    let mut min = (chunk.x * 16, (section.y as i32) * 16, chunk.z * 16);
+    let mut max = (min.0 + 15, min.1 + 15, min.2 + 15);
+    if let Some((min_x, min_y, min_z, max_x, max_y, max_z)) = bounds {
+        min = (min.0.max(min_x), min.1.max(min_y), min.2.max(min_z));
+        max = (max.0.min(max_x), max.1.min(max_y), max.2.min(max_z));
+    }
+    (min.0 <= max.0 && min.1 <= max.1 && min.2 <= max.2).then_some((min, max))
+}
+
+/// Union of the section boxes of `chunks`.
+fn content_box<'a>(
+    chunks: impl Iterator<Item = &'a ChunkData>,
+    bounds: Option<(i32, i32, i32, i32, i32, i32)>,
+) -> Option<((i32, i32, i32), (i32, i32, i32))> {
+    chunks
+        .flat_map(|chunk| {
+            chunk
+                .sections
+                .iter()
+                .filter_map(move |section| section_box(chunk, section, bounds))
+        })
+        .reduce(|(a_min, a_max), (b_min, b_max)| {
+            (
+                (
+                    a_min.0.min(b_min.0),
+                    a_min.1.min(b_min.1),
+                    a_min.2.min(b_min.2),
+                ),
+                (
+                    a_max.0.max(b_max.0),
+                    a_max.1.max(b_max.1),
+                    a_max.2.max(b_max.2),
+                ),
+            )
+        })
+}
+
+/// Make the default region cover `min..=max`. A region nothing has been
+/// written to yet is placed there outright, as `set_block` would for the
+/// first block; otherwise it grows with the usual slack.
+fn reserve_default_region(
+    schematic: &mut UniversalSchematic,
+    min: (i32, i32, i32),
+    max: (i32, i32, i32),
+) {
+    let region = &mut schematic.default_region;
+    if region.size == (1, 1, 1) && region.is_empty() {
+        let size = (max.0 - min.0 + 1, max.1 - min.1 + 1, max.2 - min.2 + 1);
+        *region = Region::new(schematic.default_region_name.clone(), min, size);
+    } else {
+        region.expand_to_fit(min.0, min.1, min.2);
+        region.expand_to_fit(max.0, max.1, max.2);
+    }
+}
+
 /// Load one parsed chunk into a schematic at absolute world coordinates.
+///
+/// Each section's palette is mapped onto the region's the first time an
+/// entry is seen, so the region palette grows in the same order as placing
+/// the blocks one by one, and cells are written by index. Block entities
+/// go through `interner`, so identical ones across chunks share a template.
 pub(crate) fn load_chunk_into_schematic(
     chunk: &ChunkData,
     schematic: &mut UniversalSchematic,
     bounds: Option<(i32, i32, i32, i32, i32, i32)>,
+    interner: &mut BlockEntityInterner,
 ) {
     let chunk_world_x = chunk.x * 16;
     let chunk_world_z = chunk.z * 16;
 
     for section in &chunk.sections {
+        let Some((min, max)) = section_box(chunk, section, bounds) else {
+            continue;
+        };
+        reserve_default_region(schematic, min, max);
+        let region = &mut schematic.default_region;
         let section_world_y = (section.y as i32) * 16;
 
-        for local_y in 0..16 {
-            for local_z in 0..16 {
-                for local_x in 0..16 {
-                    let world_x = chunk_world_x + local_x;
-                    let world_y = section_world_y + local_y;
-                    let world_z = chunk_world_z + local_z;
-
-                    // Check bounds if specified
-                    if let Some((min_x, min_y, min_z, max_x, max_y, max_z)) = bounds {
-                        if world_x < min_x
-                            || world_x > max_x
-                            || world_y < min_y
-                            || world_y > max_y
-                            || world_z < min_z
-                            || world_z > max_z
-                        {
-                            continue;
-                        }
-                    }
-
+        // Region palette index per section palette entry: `None` until
+        // first seen, then `Some(None)` for air, which is skipped.
+        let mut remap: Vec<Option<Option<usize>>> = vec![None; section.palette.len()];
+        for world_y in min.1..=max.1 {
+            for world_z in min.2..=max.2 {
+                for world_x in min.0..=max.0 {
+                    let local_x = world_x - chunk_world_x;
+                    let local_y = world_y - section_world_y;
+                    let local_z = world_z - chunk_world_z;
                     let idx = (local_y * 16 * 16 + local_z * 16 + local_x) as usize;
                     let palette_idx = section.block_states[idx] as usize;
 
-                    if palette_idx >= section.palette.len() {
-                        continue;
-                    }
-
-                    let block = &section.palette[palette_idx];
-                    // Skip air blocks
-                    if is_air(&block.name) {
+                    let Some(slot) = remap.get_mut(palette_idx) else {
                         continue;
+                    };
+                    let mapped = *slot.get_or_insert_with(|| {
+                        let block = &section.palette[palette_idx];
+                        (!is_air(&block.name)).then(|| region.get_or_insert_in_palette(block))
+                    });
+                    if let Some(index) = mapped {
+                        region.set_block_at_index_unchecked(index, world_x, world_y, world_z);
                     }
-
-                    schematic.set_block(world_x, world_y, world_z, block);
                 }
             }
         }
@@ -580,14 +704,10 @@ pub(crate) fn load_chunk_into_schematic(
                 continue;
             }
         }
-        schematic.default_region.set_block_entity(
-            BlockPosition {
-                x: be.position.0,
-                y: be.position.1,
-                z: be.position.2,
-            },
-            be.clone(),
-        );
+        schematic
+            .default_region
+            .block_entities
+            .insert_shared(be.position, interner.intern(be.clone()));
     }
 
     // Add entities
@@ -658,19 +778,35 @@ pub fn to_world(
     schematic: &UniversalSchematic,
     options: Option<WorldExportOptions>,
 ) -> Result<WorldFiles> {
-    let opts = options.unwrap_or_default();
     let mut files = WorldFiles::new();
+    to_world_with(schematic, options, |path, data| {
+        files.insert(path, data);
+        Ok(())
+    })?;
+    Ok(files)
+}
+
+/// Export a schematic as a Minecraft world, handing each file to `emit`
+/// (relative path, bytes) as soon as it is encoded. Region files come in
+/// region order.
+pub fn to_world_with(
+    schematic: &UniversalSchematic,
+    options: Option<WorldExportOptions>,
+    mut emit: impl FnMut(String, Vec<u8>) -> Result<()>,
+) -> Result<()> {
+    let opts = options.unwrap_or_default();
+    let compression = opts.chunk_codec()?;
 
     // Generate level.dat
     let level_dat = generate_level_dat(&opts)?;
-    files.insert("level.dat".to_string(), level_dat);
+    emit("level.dat".to_string(), level_dat)?;
 
     // Generate session.lock (8-byte timestamp, big-endian)
     let timestamp: i64 = std::time::SystemTime::now()
         .duration_since(std::time::UNIX_EPOCH)
         .unwrap_or_default()
         .as_millis() as i64;
-    files.insert("session.lock".to_string(), timestamp.to_be_bytes().to_vec());
+    emit("session.lock".to_string(), timestamp.to_be_bytes().to_vec())?;
 
     // Collect all blocks from all regions
     let all_regions = schematic.get_all_regions();
@@ -789,6 +925,7 @@ pub fn to_world(
             block_entities,
             entities: Vec::new(),
             y_pos: -4,
+            heightmaps: None,
         };
 
         let region_x = floor_div(*chunk_x, 32);
@@ -801,25 +938,26 @@ pub fn to_world(
     }
 
     // Write each block region as an MCA file
-    for ((rx, rz), chunks) in &region_chunks {
+    let mut region_chunks: Vec<((i32, i32), Vec<ChunkData>)> = region_chunks.into_iter().collect();
+    region_chunks.sort_unstable_by_key(|(key, _)| *key);
+    for ((rx, rz), chunks) in region_chunks {
         let mut mca_chunks: Vec<Option<ChunkData>> = (0..1024).map(|_| None).collect();
 
         for chunk in chunks {
             let local_x = floor_mod(chunk.x, 32) as u32;
             let local_z = floor_mod(chunk.z, 32) as u32;
             let index = (local_x + local_z * 32) as usize;
-            mca_chunks[index] = Some(chunk.clone());
+            mca_chunks[index] = Some(chunk);
         }
 
         let mca = McaFile {
             chunks: mca_chunks,
-            region_x: *rx,
-            region_z: *rz,
+            region_x: rx,
+            region_z: rz,
         };
 
-        let mca_bytes = mca.to_bytes()?;
-        let path = format!("region/r.{}.{}.mca", rx, rz);
-        files.insert(path, mca_bytes);
+        let mca_bytes = mca.to_bytes_with(compression)?;
+        emit(format!("region/r.{}.{}.mca", rx, rz), mca_bytes)?;
     }
 
     // Write entity region files (1.17+ format)
@@ -840,14 +978,16 @@ pub fn to_world(
                 });
         }
 
+        let mut entity_region_chunks: Vec<_> = entity_region_chunks.into_iter().collect();
+        entity_region_chunks.sort_unstable_by_key(|(key, _)| *key);
         for ((rx, rz), chunks) in &entity_region_chunks {
-            let mca_bytes = write_entity_mca(chunks, *rx, *rz, opts.data_version)?;
-            let path = format!("entities/r.{}.{}.mca", rx, rz);
-            files.insert(path, mca_bytes);
+            let mca_bytes =
+                write_entity_mca_with(chunks, *rx, *rz, opts.data_version, compression)?;
+            emit(format!("entities/r.{}.{}.mca", rx, rz), mca_bytes)?;
         }
     }
 
-    Ok(files)
+    Ok(())
 }
 
 /// Write world files to a directory on disk.
@@ -857,17 +997,14 @@ pub fn save_world(
     directory: &Path,
     options: Option<WorldExportOptions>,
 ) -> Result<()> {
-    let files = to_world(schematic, options)?;
-
-    for (path, data) in &files {
+    to_world_with(schematic, options, |path, data| {
         let full_path = directory.join(path);
         if let Some(parent) = full_path.parent() {
             std::fs::create_dir_all(parent)?;
         }
         std::fs::write(&full_path, data)?;
-    }
-
-    Ok(())
+        Ok(())
+    })
 }
 
 // ─── Section Builder ────────────────────────────────────────────────────────
@@ -1199,6 +1336,73 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_world_export_chunk_codecs_roundtrip() {
+        let mut schematic = UniversalSchematic::new("Test".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        for x in 0..40 {
+            schematic.set_block(x, 64, x % 7, &stone);
+        }
+
+        for (codec, byte) in [("zlib", 2), ("gzip", 1), ("uncompressed", 3), ("lz4", 4)] {
+            let json = format!(
+                r#"{{"chunk_compression":"{}","compression_level":9}}"#,
+                codec
+            );
+            let opts: WorldExportOptions = serde_json::from_str(&json).unwrap();
+            let files = to_world(&schematic, Some(opts)).unwrap();
+            let mca = &files["region/r.0.0.mca"];
+
+            // First present chunk: its sector starts with length then codec.
+            let location = mca[..4096]
+                .chunks_exact(4)
+                .find(|entry| entry[3] != 0)
+                .unwrap();
+            let offset = u32::from_be_bytes([0, location[0], location[1], location[2]]) as usize;
+            assert_eq!(mca[offset * 4096 + 4], byte, "{codec}");
+
+            let imported = from_mca(mca).unwrap();
+            assert_eq!(imported.default_region.count_blocks(), 40, "{codec}");
+        }
+
+        let bad: WorldExportOptions = serde_json::from_str(r#"{"compression_level":12}"#).unwrap();
+        assert!(to_world(&schematic, Some(bad)).is_err());
+    }
+
+    #[test]
+    fn test_world_zip_import_across_regions_is_bounded_and_stable() {
+        let mut schematic = UniversalSchematic::new("Test".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        let dirt = BlockState::new("minecraft:dirt".to_string());
+        schematic.set_block(5, 64, 5, &stone);
+        schematic.set_block(20, 64, 5, &dirt);
+        // Other region files: r.1.0 and r.-1.-1.
+        schematic.set_block(600, 64, 5, &glass);
+        schematic.set_block(-3, 70, -3, &dirt);
+        let zip = to_world_zip(&schematic, None).unwrap();
+
+        let imported = from_world_zip(&zip).unwrap();
+        let region = &imported.default_region;
+        assert_eq!(region.count_blocks(), 4);
+        assert_eq!(
+            region.get_block(600, 64, 5).unwrap().name,
+            "minecraft:glass"
+        );
+        assert_eq!(region.get_block(-3, 70, -3).unwrap().name, "minecraft:dirt");
+        let again = from_world_zip(&zip).unwrap();
+        assert_eq!(again.default_region.get_palette(), region.get_palette());
+
+        let bounded = from_world_zip_bounded(&zip, 0, 0, 0, 30, 100, 30).unwrap();
+        let region = &bounded.default_region;
+        assert_eq!(region.count_blocks(), 2);
+        assert_eq!(region.get_block(5, 64, 5).unwrap().name, "minecraft:stone");
+        assert_eq!(region.get_block(20, 64, 5).unwrap().name, "minecraft:dirt");
+        assert!(region
+            .get_block(600, 64, 5)
+            .is_none_or(|block| block.name != "minecraft:glass"));
+    }
+
     #[test]
     fn test_is_air() {
         assert!(is_air("minecraft:air"));
@@ -1228,17 +1432,20 @@ mod tests {
         // Add entities with various NBT data
         let mut creeper = Entity::new("minecraft:creeper".to_string(), (0.5, 64.0, 0.5));
         creeper
-            .nbt
+            .nbt_mut()
             .insert("Health".to_string(), NbtValue::Float(20.0));
-        creeper.nbt.insert("Fuse".to_string(), NbtValue::Short(30));
         creeper
-            .nbt
+            .nbt_mut()
+            .insert("Fuse".to_string(), NbtValue::Short(30));
+        creeper
+            .nbt_mut()
             .insert("ExplosionRadius".to_string(), NbtValue::Byte(3));
         schematic.default_region.add_entity(creeper);
 
         // Entity with passengers (riding)
         let mut pig = Entity::new("minecraft:pig".to_string(), (2.5, 64.0, 2.5));
-        pig.nbt.insert("Health".to_string(), NbtValue::Float(10.0));
+        pig.nbt_mut()
+            .insert("Health".to_string(), NbtValue::Float(10.0));
 
         let mut passenger_nbt = HashMap::new();
         passenger_nbt.insert(
@@ -1253,7 +1460,7 @@ mod tests {
         ]);
         passenger_nbt.insert("Pos".to_string(), passenger_pos);
 
-        pig.nbt.insert(
+        pig.nbt_mut().insert(
             "Passengers".to_string(),
             NbtValue::List(vec![NbtValue::Compound(passenger_nbt)]),
         );
@@ -0,0 +1,580 @@
+//! Export a box of a world to a Sponge v3 or litematic file without
+//! building the schematic in memory.
+//!
+//! Chunks are streamed in, in any order, and their blocks written into a
+//! spool: a file next to the output holding one `u16` palette id per block
+//! of the box, already in the schematic's `(y * length + z) * width + x`
+//! order. The spool is memory-mapped, so its pages belong to the OS rather
+//! than the heap. Once every chunk is in, the palette is known, and the
+//! spool is read start to finish, varint- or long-packed in batches, and
+//! gzipped straight into the output.
+//!
+//! Heap use is one decoded chunk per reading thread, the palette, and the
+//! box's block entities and entities, which are kept until the end because
+//! both formats place them after the block data. The spool needs two bytes
+//! of disk per block of the box and is removed when the export ends.
+
+#![cfg(not(target_arch = "wasm32"))]
+
+use std::collections::HashMap;
+use std::fs::{File, OpenOptions};
+use std::io::{BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::time::{SystemTime, UNIX_EPOCH};
+
+use flate2::write::GzEncoder;
+use flate2::Compression;
+use quartz_nbt::io::Flavor;
+use quartz_nbt::{NbtCompound, NbtList, NbtTag};
+
+use crate::block_entity::BlockEntity;
+use crate::entity::Entity;
+use crate::fingerprint::is_air;
+use crate::formats::anvil::ChunkProjection;
+use crate::formats::error::Result;
+use crate::formats::litematic::{
+    region_block_entity_nbt, region_entity_nbt, schematic_version_for_data_version,
+    DEFAULT_TARGET_DATA_VERSION,
+};
+use crate::formats::packed_longs::{self, Layout};
+use crate::formats::schematic::{encode_varints_into, sponge_v3_block_entity, sponge_v3_entity};
+use crate::formats::world_stream::{WorldChunkView, WorldSource};
+use crate::metadata::Metadata;
+use crate::BlockState;
+
+/// Blocks read from the spool per encoding batch. A multiple of 64, so
+/// packed batches concatenate.
+const BATCH: usize = 1 << 16;
+
+/// Output format of an export.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum SpoolFormat {
+    /// Sponge schematic v3 (`.schem`).
+    SpongeV3,
+    /// Litematica (`.litematic`), as one region.
+    Litematic,
+}
+
+impl SpoolFormat {
+    /// `"schem"`/`"sponge"` or `"litematic"`.
+    pub fn from_name(name: &str) -> Option<Self> {
+        match name {
+            "schem" | "sponge" | "sponge_v3" => Some(SpoolFormat::SpongeV3),
+            "litematic" => Some(SpoolFormat::Litematic),
+            _ => None,
+        }
+    }
+}
+
+/// What an export wrote.
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct SpoolStats {
+    /// Width, height and length of the box.
+    pub size: (i32, i32, i32),
+    /// Palette entries, air included.
+    pub palette_len: usize,
+    pub non_air_blocks: u64,
+    pub block_entities: usize,
+    pub entities: usize,
+}
+
+/// A box of world blocks being collected for export. Create it, add
+/// chunks, then [`finish`](Self::finish) it into a writer.
+pub struct SchematicSpool {
+    min: (i32, i32, i32),
+    max: (i32, i32, i32),
+    /// (width, height, length).
+    size: (usize, usize, usize),
+    path: PathBuf,
+    /// Taken on drop, so the mapping is gone before the file is removed.
+    map: Option<memmap2::MmapMut>,
+    /// Palette id 0 is always air.
+    palette: Vec<BlockState>,
+    ids: HashMap<BlockState, u16>,
+    block_entities: Vec<BlockEntity>,
+    entities: Vec<Entity>,
+    /// Data version of the first chunk added.
+    data_version: Option<i32>,
+}
+
+impl SchematicSpool {
+    /// Start collecting the inclusive box `min..=max`, spooling to a new
+    /// file at `spool_path`.
+    pub fn create(min: (i32, i32, i32), max: (i32, i32, i32), spool_path: &Path) -> Result<Self> {
+        if max.0 < min.0 || max.1 < min.1 || max.2 < min.2 {
+            return Err(format!("Empty export box {:?}..{:?}", min, max).into());
+        }
+        let size = (
+            (max.0 as i64 - min.0 as i64 + 1) as usize,
+            (max.1 as i64 - min.1 as i64 + 1) as usize,
+            (max.2 as i64 - min.2 as i64 + 1) as usize,
+        );
+        let volume = size.0 * size.1 * size.2;
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .truncate(true)
+            .open(spool_path)?;
+        // Unwritten blocks read back as zero, which is air.
+        file.set_len(volume as u64 * 2)?;
+        // SAFETY: the spool is created here and removed on drop; nothing
+        // else is expected to open it.
+        let map = unsafe { memmap2::MmapMut::map_mut(&file) };
+        let map = match map {
+            Ok(map) => map,
+            Err(e) => {
+                drop(file);
+                let _ = std::fs::remove_file(spool_path);
+                return Err(e.into());
+            }
+        };
+        Ok(SchematicSpool {
+            min,
+            max,
+            size,
+            path: spool_path.to_path_buf(),
+            map: Some(map),
+            palette: vec![BlockState::new("minecraft:air")],
+            ids: HashMap::new(),
+            block_entities: Vec::new(),
+            entities: Vec::new(),
+            data_version: None,
+        })
+    }
+
+    /// Projection that reads only what the box needs from each chunk.
+    pub fn projection(&self) -> ChunkProjection {
+        ChunkProjection {
+            y_range: Some((self.min.1, self.max.1)),
+            biomes: false,
+            ..ChunkProjection::default()
+        }
+    }
+
+    /// Copy the part of `view` inside the box into the spool. Adding a
+    /// chunk twice overwrites its blocks but duplicates its block entities
+    /// and entities.
+    pub fn add_chunk(&mut self, view: &WorldChunkView) -> Result<()> {
+        let chunk = &view.data;
+        self.data_version.get_or_insert(chunk.data_version);
+        let (cx16, cz16) = (chunk.x * 16, chunk.z * 16);
+        let x0 = cx16.max(self.min.0);
+        let x1 = (cx16 + 15).min(self.max.0);
+        let z0 = cz16.max(self.min.2);
+        let z1 = (cz16 + 15).min(self.max.2);
+        if x0 > x1 || z0 > z1 {
+            return Ok(());
+        }
+        let (width, _, length) = self.size;
+        let run = (x1 - x0 + 1) as usize;
+
+        for section in &chunk.sections {
+            let base = section.y as i32 * 16;
+            let y0 = base.max(self.min.1);
+            let y1 = (base + 15).min(self.max.1);
+            if y0 > y1 || section.block_states.len() < 4096 {
+                continue;
+            }
+            let mut remap = Vec::with_capacity(section.palette.len());
+            for block in &section.palette {
+                remap.push(self.intern(block)?);
+            }
+            let map = self.map.as_mut().expect("spool is mapped until drop");
+            for y in y0..=y1 {
+                for z in z0..=z1 {
+                    let local = ((y - base) * 256 + (z - cz16) * 16 + (x0 - cx16)) as usize;
+                    let cell = ((y - self.min.1) as usize * length + (z - self.min.2) as usize)
+                        * width
+                        + (x0 - self.min.0) as usize;
+                    let row = &mut map[cell * 2..(cell + run) * 2];
+                    let states = &section.block_states[local..local + run];
+                    for (slot, &state) in row.chunks_exact_mut(2).zip(states) {
+                        let id = remap.get(state as usize).copied().unwrap_or(0);
+                        slot.copy_from_slice(&id.to_le_bytes());
+                    }
+                }
+            }
+        }
+
+        // Same containment rules as the world importer.
+        let (min, max) = (self.min, self.max);
+        let inside = |x: i32, y: i32, z: i32| {
+            (min.0..=max.0).contains(&x)
+                && (min.1..=max.1).contains(&y)
+                && (min.2..=max.2).contains(&z)
+        };
+        self.block_entities.extend(
+            chunk
+                .block_entities
+                .iter()
+                .filter(|be| inside(be.position.0, be.position.1, be.position.2))
+                .cloned(),
+        );
+        self.entities.extend(
+            chunk
+                .entities
+                .iter()
+                .filter(|e| {
+                    inside(
+                        e.position.0 as i32,
+                        e.position.1 as i32,
+                        e.position.2 as i32,
+                    )
+                })
+                .cloned(),
+        );
+        Ok(())
+    }
+
+    fn intern(&mut self, block: &BlockState) -> Result<u16> {
+        if is_air(&block.name) {
+            return Ok(0);
+        }
+        if let Some(&id) = self.ids.get(block) {
+            return Ok(id);
+        }
+        let id = u16::try_from(self.palette.len())
+            .map_err(|_| "Export box holds more than 65535 block states".to_string())?;
+        self.palette.push(block.clone());
+        self.ids.insert(block.clone(), id);
+        Ok(id)
+    }
+
+    /// Write the collected box to `out` as gzipped `format`, named `name`.
+    pub fn finish<W: Write>(
+        self,
+        format: SpoolFormat,
+        name: &str,
+        compression: Compression,
+        out: W,
+    ) -> Result<SpoolStats> {
+        let mut gz = GzEncoder::new(out, compression);
+        let stats = match format {
+            SpoolFormat::SpongeV3 => self.write_sponge(name, &mut gz)?,
+            SpoolFormat::Litematic => self.write_litematic(name, &mut gz)?,
+        };
+        gz.finish()?.flush()?;
+        Ok(stats)
+    }
+
+    fn spool(&self) -> &[u8] {
+        self.map.as_ref().expect("spool is mapped until drop")
+    }
+
+    /// Hand the spool to `f` in batches of up to [`BATCH`] ids.
+    fn for_each_batch(&self, mut f: impl FnMut(&[u32]) -> Result<()>) -> Result<()> {
+        let mut ids = Vec::with_capacity(BATCH);
+        for bytes in self.spool().chunks(BATCH * 2) {
+            ids.clear();
+            ids.extend(
+                bytes
+                    .chunks_exact(2)
+                    .map(|b| u16::from_le_bytes([b[0], b[1]]) as u32),
+            );
+            f(&ids)?;
+        }
+        Ok(())
+    }
+
+    /// Stats, plus the length of the block data as varints.
+    fn scan(&self) -> Result<(SpoolStats, u64)> {
+        let (mut non_air, mut varint_bytes) = (0u64, 0u64);
+        self.for_each_batch(|ids| {
+            non_air += ids.iter().filter(|&&id| id != 0).count() as u64;
+            varint_bytes += ids.iter().map(|&id| varint_len(id)).sum::<u64>();
+            Ok(())
+        })?;
+        let stats = SpoolStats {
+            size: (self.size.0 as i32, self.size.1 as i32, self.size.2 as i32),
+            palette_len: self.palette.len(),
+            non_air_blocks: non_air,
+            block_entities: self.block_entities.len(),
+            entities: self.entities.len(),
+        };
+        Ok((stats, varint_bytes))
+    }
+
+    fn write_sponge<W: Write>(&self, name: &str, out: &mut W) -> Result<SpoolStats> {
+        let (stats, data_len) = self.scan()?;
+        let (width, height, length) = self.size;
+        let mut dims = Vec::with_capacity(3);
+        for (axis, value) in [("Width", width), ("Height", height), ("Length", length)] {
+            let value = u16::try_from(value)
+                .map_err(|_| format!("{} {} does not fit a Sponge schematic", axis, value))?;
+            dims.push((axis, value as i16));
+        }
+        let data_version = self.data_version.unwrap_or(DEFAULT_TARGET_DATA_VERSION);
+
+        begin_compound(out, "")?;
+        begin_compound(out, "Schematic")?;
+        write_entry(out, "Version", NbtTag::Int(3))?;
+        write_entry(out, "DataVersion", NbtTag::Int(data_version))?;
+        for (axis, value) in dims {
+            write_entry(out, axis, NbtTag::Short(value))?;
+        }
+        let offset = vec![self.min.0, self.min.1, self.min.2];
+        write_entry(out, "Offset", NbtTag::IntArray(offset))?;
+
+        begin_compound(out, "Blocks")?;
+        let mut palette = NbtCompound::new();
+        for (id, block) in self.palette.iter().enumerate() {
+            palette.insert(block.to_string(), NbtTag::Int(id as i32));
+        }
+        write_entry(out, "Palette", NbtTag::Compound(palette))?;
+
+        let data_len = i32::try_from(data_len)
+            .map_err(|_| "Block data exceeds the NBT array limit".to_string())?;
+        begin_array(out, 7, "Data", data_len)?;
+        let mut buf = Vec::with_capacity(BATCH * 2);
+        self.for_each_batch(|ids| {
+            buf.clear();
+            encode_varints_into(ids, &mut buf);
+            out.write_all(&buf)?;
+            Ok(())
+        })?;
+
+        let block_entities: Vec<NbtTag> = self
+            .block_entities
+            .iter()
+            .map(|be| NbtTag::Compound(sponge_v3_block_entity(be, self.min, Some(data_version))))
+            .collect();
+        write_entry(
+            out,
+            "BlockEntities",
+            NbtTag::List(NbtList::from(block_entities)),
+        )?;
+        end_compound(out)?;
+
+        let entities: Vec<NbtTag> = self
+            .entities
+            .iter()
+            .map(|entity| NbtTag::Compound(sponge_v3_entity(entity, self.min)))
+            .collect();
+        write_entry(out, "Entities", NbtTag::List(NbtList::from(entities)))?;
+
+        let metadata = Metadata {
+            name: Some(name.to_string()),
+            mc_version: Some(data_version),
+            ..Metadata::default()
+        };
+        write_entry(out, "Metadata", metadata.to_nbt())?;
+        end_compound(out)?;
+        end_compound(out)?;
+        Ok(stats)
+    }
+
+    fn write_litematic<W: Write>(&self, name: &str, out: &mut W) -> Result<SpoolStats> {
+        let (stats, _) = self.scan()?;
+        let (width, height, length) = (stats.size.0, stats.size.1, stats.size.2);
+        let volume = self.size.0 * self.size.1 * self.size.2;
+        let data_version = self.data_version.unwrap_or(DEFAULT_TARGET_DATA_VERSION);
+        let (version, sub_version) = schematic_version_for_data_version(data_version);
+
+        begin_compound(out, "")?;
+        write_entry(out, "Version", NbtTag::Int(version))?;
+        if let Some(sub) = sub_version {
+            write_entry(out, "SubVersion", NbtTag::Int(sub))?;
+        }
+        write_entry(out, "MinecraftDataVersion", NbtTag::Int(data_version))?;
+
+        let now = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .unwrap_or_default()
+            .as_millis() as i64;
+        let mut metadata = NbtCompound::new();
+        metadata.insert("Name", NbtTag::String(name.to_string()));
+        metadata.insert("Description", NbtTag::String(String::new()));
+        metadata.insert("Author", NbtTag::String(String::new()));
+        metadata.insert("TimeCreated", NbtTag::Long(now));
+        metadata.insert("TimeModified", NbtTag::Long(now));
+        metadata.insert("EnclosingSize", xyz_compound(width, height, length));
+        // v4 (1.12) wrote these as TAG_Long; v5+ switched to TAG_Int.
+        if version <= 4 {
+            metadata.insert("TotalVolume", NbtTag::Long(volume as i64));
+            metadata.insert("TotalBlocks", NbtTag::Long(stats.non_air_blocks as i64));
+        } else {
+            metadata.insert("TotalVolume", NbtTag::Int(volume as i32));
+            metadata.insert("TotalBlocks", NbtTag::Int(stats.non_air_blocks as i32));
+        }
+        metadata.insert("RegionCount", NbtTag::Int(1));
+        metadata.insert("Software", NbtTag::String("UniversalSchematic".to_string()));
+        write_entry(out, "Metadata", NbtTag::Compound(metadata))?;
+
+        begin_compound(out, "Regions")?;
+        begin_compound(out, name)?;
+        write_entry(
+            out,
+            "Position",
+            xyz_compound(self.min.0, self.min.1, self.min.2),
+        )?;
+        write_entry(out, "Size", xyz_compound(width, height, length))?;
+        let palette: Vec<NbtTag> = self.palette.iter().map(BlockState::to_nbt).collect();
+        write_entry(
+            out,
+            "BlockStatePalette",
+            NbtTag::List(NbtList::from(palette)),
+        )?;
+
+        let bits = packed_longs::bits_for(self.palette.len(), 2);
+        let longs = i32::try_from(packed_longs::packed_len(volume, bits, Layout::Spanning))
+            .map_err(|_| "Block data exceeds the NBT array limit".to_string())?;
+        begin_array(out, 12, "BlockStates", longs)?;
+        let mut packed = Vec::with_capacity(BATCH * bits / 64 + 1);
+        let mut buf = Vec::with_capacity(packed.capacity() * 8);
+        self.for_each_batch(|ids| {
+            packed.clear();
+            packed_longs::pack(ids, bits, Layout::Spanning, &mut packed);
+            buf.clear();
+            for word in &packed {
+                buf.extend_from_slice(&word.to_be_bytes());
+            }
+            out.write_all(&buf)?;
+            Ok(())
+        })?;
+
+        let entities: Vec<NbtTag> = self
+            .entities
+            .iter()
+            .map(|entity| NbtTag::Compound(region_entity_nbt(entity, self.min)))
+            .collect();
+        write_entry(out, "Entities", NbtTag::List(NbtList::from(entities)))?;
+        let tile_entities: Vec<NbtTag> = self
+            .block_entities
+            .iter()
+            .map(|be| NbtTag::Compound(region_block_entity_nbt(be, self.min)))
+            .collect();
+        write_entry(
+            out,
+            "TileEntities",
+            NbtTag::List(NbtList::from(tile_entities)),
+        )?;
+        write_entry(out, "PendingBlockTicks", NbtTag::List(NbtList::new()))?;
+        if version >= 5 {
+            write_entry(out, "PendingFluidTicks", NbtTag::List(NbtList::new()))?;
+        }
+        end_compound(out)?;
+        end_compound(out)?;
+        end_compound(out)?;
+        Ok(stats)
+    }
+}
+
+impl Drop for SchematicSpool {
+    fn drop(&mut self) {
+        self.map = None;
+        let _ = std::fs::remove_file(&self.path);
+    }
+}
+
+/// Export the box `min..=max` of `source` to `path`. The spool sits beside
+/// `path` while the export runs; chunks are decoded on `threads` workers
+/// (0 = one per core).
+pub fn export_world_box(
+    source: &WorldSource,
+    min: (i32, i32, i32),
+    max: (i32, i32, i32),
+    format: SpoolFormat,
+    path: &Path,
+    threads: usize,
+) -> Result<SpoolStats> {
+    let mut spool = SchematicSpool::create(min, max, &spool_path(path))?;
+    let chunks = source
+        .chunks_bounded_projected(min, max, spool.projection())?
+        .parallel(threads, false);
+    for chunk in chunks {
+        spool.add_chunk(&chunk?)?;
+    }
+    write_spool(spool, format, path)
+}
+
+/// Spool `chunks` and write the box `min..=max` of them to `path`.
+pub fn export_chunks(
+    chunks: impl IntoIterator<Item = Result<WorldChunkView>>,
+    min: (i32, i32, i32),
+    max: (i32, i32, i32),
+    format: SpoolFormat,
+    path: &Path,
+) -> Result<SpoolStats> {
+    let mut spool = SchematicSpool::create(min, max, &spool_path(path))?;
+    for chunk in chunks {
+        spool.add_chunk(&chunk?)?;
+    }
+    write_spool(spool, format, path)
+}
+
+fn write_spool(spool: SchematicSpool, format: SpoolFormat, path: &Path) -> Result<SpoolStats> {
+    let name = path
+        .file_stem()
+        .and_then(|s| s.to_str())
+        .unwrap_or("World Export")
+        .to_string();
+    let out = BufWriter::new(File::create(path)?);
+    // Same level as the in-memory litematic writer.
+    spool.finish(format, &name, Compression::new(3), out)
+}
+
+fn spool_path(path: &Path) -> PathBuf {
+    let mut name = path.as_os_str().to_owned();
+    name.push(".spool");
+    PathBuf::from(name)
+}
+
+fn xyz_compound(x: i32, y: i32, z: i32) -> NbtTag {
+    let mut compound = NbtCompound::new();
+    compound.insert("x", NbtTag::Int(x));
+    compound.insert("y", NbtTag::Int(y));
+    compound.insert("z", NbtTag::Int(z));
+    NbtTag::Compound(compound)
+}
+
+fn varint_len(value: u32) -> u64 {
+    match value {
+        0..=0x7f => 1,
+        0x80..=0x3fff => 2,
+        0x4000..=0x1f_ffff => 3,
+        0x20_0000..=0xfff_ffff => 4,
+        _ => 5,
+    }
+}
+
+/// Write `key: tag` as an entry of the enclosing compound. Quartz writes
+/// the compound `{key: tag}` as a header, the entry and an end tag; the
+/// entry is what lies between.
+fn write_entry<W: Write>(out: &mut W, key: &str, tag: NbtTag) -> Result<()> {
+    let mut wrapper = NbtCompound::new();
+    wrapper.insert(key, tag);
+    let mut bytes = Vec::new();
+    quartz_nbt::io::write_nbt(&mut bytes, Some(""), &wrapper, Flavor::Uncompressed)?;
+    out.write_all(&bytes[3..bytes.len() - 1])?;
+    Ok(())
+}
+
+/// Open a compound named `name`; close it with [`end_compound`].
+fn begin_compound<W: Write>(out: &mut W, name: &str) -> Result<()> {
+    // An empty compound is its header plus an end tag.
+    let mut bytes = Vec::new();
+    quartz_nbt::io::write_nbt(
+        &mut bytes,
+        Some(name),
+        &NbtCompound::new(),
+        Flavor::Uncompressed,
+    )?;
+    out.write_all(&bytes[..bytes.len() - 1])?;
+    Ok(())
+}
+
+fn end_compound<W: Write>(out: &mut W) -> Result<()> {
+    out.write_all(&[0])?;
+    Ok(())
+}
+
+/// Header of an array tag (`7` bytes, `12` longs) whose `len` elements
+/// the caller writes next.
+fn begin_array<W: Write>(out: &mut W, tag: u8, name: &str, len: i32) -> Result<()> {
+    out.write_all(&[tag])?;
+    out.write_all(&(name.len() as u16).to_be_bytes())?;
+    out.write_all(name.as_bytes())?;
+    out.write_all(&len.to_be_bytes())?;
+    Ok(())
+}
@@ -0,0 +1,443 @@
+//! A sidecar index of a world directory's chunks, for random access and
+//! incremental scans.
+//!
+//! ```text
+//! "NUWI" | u32 version = 1 | index (bincode)
+//! ```
+//!
+//! For every chunk the index records where its record sits, the region
+//! header's last-modified time, a hash of the compressed record
+//! ([`RawChunk::content_hash`]) and a summary of its contents: which
+//! sections hold a non-air block, and the block names it uses, as ids into
+//! one palette shared by the whole index.
+//!
+//! [`WorldIndex::update`] brings an index up to date with the world and
+//! reports which chunks changed. Regions whose file length and modification
+//! time match the index are not read at all. In the others every record is
+//! hashed, and only chunks whose hash changed are decoded. Regions are
+//! indexed in parallel.
+//!
+//! Consumers use the index to skip work: [`WorldSource::chunks_at`] streams
+//! just the changed chunks, [`diff_worlds_indexed`] diffs only chunks whose
+//! records differ, and the world segmenter skips empty chunks and regions.
+//!
+//! [`RawChunk::content_hash`]: crate::formats::anvil::RawChunk::content_hash
+//! [`WorldSource::chunks_at`]: crate::formats::world_stream::WorldSource::chunks_at
+//! [`diff_worlds_indexed`]: crate::formats::world_stream::diff_worlds_indexed
+
+#![cfg(not(target_arch = "wasm32"))]
+
+use std::collections::{BTreeMap, HashMap};
+use std::path::Path;
+use std::sync::Arc;
+use std::time::UNIX_EPOCH;
+
+use serde::{Deserialize, Serialize};
+
+use crate::fingerprint::is_air;
+use crate::formats::anvil::{ChunkProjection, RegionSlice};
+use crate::formats::error::Result;
+use crate::formats::world_stream::{chunk_order_key, WorldSource};
+
+const MAGIC: &[u8; 4] = b"NUWI";
+const VERSION: u32 = 1;
+
+/// File name of the sidecar [`WorldIndex::open`] keeps in a world directory.
+pub const SIDECAR_NAME: &str = "nucleation.chunkindex";
+
+/// What the index knows about one chunk.
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+pub struct ChunkEntry {
+    /// Byte offset of the chunk's record in its region file.
+    pub offset: u64,
+    /// Last-modified time from the region header, in epoch seconds.
+    pub timestamp: u32,
+    /// BLAKE3 of the compressed record.
+    pub payload_hash: [u8; 32],
+    /// False when the record failed to decode; the summary below is then
+    /// empty and says nothing about the chunk's contents.
+    pub readable: bool,
+    /// Section Ys holding at least one non-air block, ascending.
+    pub occupied_sections: Vec<i8>,
+    /// Ids into [`WorldIndex::palette`] of the non-air block names in the
+    /// chunk, ascending.
+    pub palette: Vec<u32>,
+}
+
+impl ChunkEntry {
+    /// True when the chunk decoded and holds no non-air block.
+    pub fn is_empty(&self) -> bool {
+        self.readable && self.occupied_sections.is_empty()
+    }
+
+    /// Could the chunk hold non-air blocks in block Y `min_y..=max_y`?
+    /// Unreadable chunks always could.
+    pub fn occupies(&self, min_y: i32, max_y: i32) -> bool {
+        !self.readable
+            || self.occupied_sections.iter().any(|&y| {
+                let (lo, hi) = (y as i32 * 16, y as i32 * 16 + 15);
+                hi >= min_y && lo <= max_y
+            })
+    }
+}
+
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
+struct RegionEntry {
+    /// Region file length and modification time when it was indexed.
+    len: u64,
+    modified: (u64, u32),
+    /// Chunks keyed by local index (`z * 32 + x`), so iteration follows
+    /// canonical chunk order.
+    chunks: BTreeMap<u16, ChunkEntry>,
+}
+
+/// Chunks that [`WorldIndex::update`] found changed.
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct IndexDelta {
+    /// Chunks that are new or whose record changed, in canonical order.
+    pub changed: Vec<(i32, i32)>,
+    /// Chunks that are gone from the world, in canonical order.
+    pub removed: Vec<(i32, i32)>,
+}
+
+impl IndexDelta {
+    pub fn is_empty(&self) -> bool {
+        self.changed.is_empty() && self.removed.is_empty()
+    }
+}
+
+/// Index of a world directory's chunks. See the module docs.
+#[derive(Debug, Clone, Default, PartialEq, Serialize, Deserialize)]
+pub struct WorldIndex {
+    regions: BTreeMap<(i32, i32), RegionEntry>,
+    palette: Vec<String>,
+}
+
+/// One region's freshly indexed chunks. Chunks carried over unchanged keep
+/// their palette ids; new ones carry block names until they are interned.
+struct IndexedRegion {
+    entry: RegionEntry,
+    names: Vec<(u16, Vec<String>)>,
+    changed: Vec<(i32, i32)>,
+    removed: Vec<(i32, i32)>,
+}
+
+impl WorldIndex {
+    /// Index every chunk of the world at `dir`.
+    pub fn build(dir: &Path) -> Result<Self> {
+        let mut index = Self::default();
+        index.update(dir)?;
+        Ok(index)
+    }
+
+    /// Load the sidecar in `dir` (or start empty if there is none or it is
+    /// unreadable), bring it up to date and save it back. Returns the index
+    /// and the chunks that changed since the sidecar was last saved.
+    pub fn open(dir: &Path) -> Result<(Self, IndexDelta)> {
+        let path = dir.join(SIDECAR_NAME);
+        let mut index = if path.is_file() {
+            Self::load(&path).unwrap_or_default()
+        } else {
+            Self::default()
+        };
+        let delta = index.update(dir)?;
+        index.save(&path)?;
+        Ok((index, delta))
+    }
+
+    pub fn load(path: &Path) -> Result<Self> {
+        let bytes = std::fs::read(path)?;
+        if bytes.len() < 8 || &bytes[..4] != MAGIC {
+            return Err("not a world index".into());
+        }
+        let version = u32::from_le_bytes(bytes[4..8].try_into().unwrap());
+        if version != VERSION {
+            return Err(format!("unsupported world index version {}", version).into());
+        }
+        bincode::deserialize(&bytes[8..])
+            .map_err(|e| format!("world index is corrupt: {}", e).into())
+    }
+
+    /// Write the index to `path`, through a temporary file renamed over it.
+    pub fn save(&self, path: &Path) -> Result<()> {
+        let mut bytes = Vec::new();
+        bytes.extend_from_slice(MAGIC);
+        bytes.extend_from_slice(&VERSION.to_le_bytes());
+        bincode::serialize_into(&mut bytes, self)
+            .map_err(|e| format!("world index serialize failed: {}", e))?;
+        let tmp = path.with_extension("chunkindex.tmp");
+        std::fs::write(&tmp, bytes)?;
+        std::fs::rename(&tmp, path)?;
+        Ok(())
+    }
+
+    /// Bring the index up to date with the world at `dir`.
+    pub fn update(&mut self, dir: &Path) -> Result<IndexDelta> {
+        use rayon::prelude::*;
+
+        let source = WorldSource::open_dir(dir)?;
+        let region_dir = dir.join("region");
+        let mut stale = Vec::new();
+        let mut present = Vec::new();
+        for (rx, rz) in source.region_positions()? {
+            let path = region_dir.join(format!("r.{}.{}.mca", rx, rz));
+            let meta = std::fs::metadata(&path)?;
+            let modified = meta
+                .modified()?
+                .duration_since(UNIX_EPOCH)
+                .unwrap_or_default();
+            let stamp = (meta.len(), (modified.as_secs(), modified.subsec_nanos()));
+            present.push((rx, rz));
+            match self.regions.get(&(rx, rz)) {
+                Some(old) if (old.len, old.modified) == stamp => {}
+                _ => stale.push(((rx, rz), path, stamp)),
+            }
+        }
+
+        let mut delta = IndexDelta::default();
+        let gone: Vec<(i32, i32)> = self
+            .regions
+            .keys()
+            .filter(|key| present.binary_search(key).is_err())
+            .copied()
+            .collect();
+        for key in gone {
+            let entry = self.regions.remove(&key).unwrap();
+            delta
+                .removed
+                .extend(entry.chunks.keys().map(|&local| chunk_position(key, local)));
+        }
+
+        let indexed = stale
+            .par_iter()
+            .map(|(key, path, (len, modified))| {
+                index_region(path, *key, self.regions.get(key)).map(|mut region| {
+                    region.entry.len = *len;
+                    region.entry.modified = *modified;
+                    (*key, region)
+                })
+            })
+            .collect::<Result<Vec<_>>>()?;
+
+        let mut ids: HashMap<String, u32> = self
+            .palette
+            .iter()
+            .enumerate()
+            .map(|(i, name)| (name.clone(), i as u32))
+            .collect();
+        for (key, mut region) in indexed {
+            for (local, names) in region.names {
+                let mut palette: Vec<u32> = names
+                    .into_iter()
+                    .map(|name| {
+                        *ids.entry(name).or_insert_with_key(|name| {
+                            self.palette.push(name.clone());
+                            (self.palette.len() - 1) as u32
+                        })
+                    })
+                    .collect();
+                palette.sort_unstable();
+                region.entry.chunks.get_mut(&local).unwrap().palette = palette;
+            }
+            delta.changed.extend(region.changed);
+            delta.removed.extend(region.removed);
+            self.regions.insert(key, region.entry);
+        }
+
+        delta
+            .changed
+            .sort_by_key(|&(cx, cz)| chunk_order_key(cx, cz));
+        delta
+            .removed
+            .sort_by_key(|&(cx, cz)| chunk_order_key(cx, cz));
+        Ok(delta)
+    }
+
+    /// Indexed region positions, sorted.
+    pub fn region_positions(&self) -> Vec<(i32, i32)> {
+        self.regions.keys().copied().collect()
+    }
+
+    pub fn get(&self, cx: i32, cz: i32) -> Option<&ChunkEntry> {
+        let key = (cx.div_euclid(32), cz.div_euclid(32));
+        let local = (cz.rem_euclid(32) * 32 + cx.rem_euclid(32)) as u16;
+        self.regions.get(&key)?.chunks.get(&local)
+    }
+
+    /// Every indexed chunk, in canonical order.
+    pub fn chunks(&self) -> impl Iterator<Item = ((i32, i32), &ChunkEntry)> + '_ {
+        self.regions.iter().flat_map(|(&key, region)| {
+            region
+                .chunks
+                .iter()
+                .map(move |(&local, entry)| (chunk_position(key, local), entry))
+        })
+    }
+
+    /// Block names the palette ids of [`ChunkEntry::palette`] refer to.
+    pub fn palette(&self) -> &[String] {
+        &self.palette
+    }
+
+    /// Chunks that might hold a non-air block, in canonical order.
+    pub fn non_empty_chunks(&self) -> Vec<(i32, i32)> {
+        self.chunks()
+            .filter(|(_, entry)| !entry.is_empty())
+            .map(|(pos, _)| pos)
+            .collect()
+    }
+
+    /// Chunks whose records differ between the two indexes, or that only
+    /// one of them has, in canonical order.
+    pub fn differing(&self, other: &WorldIndex) -> Vec<(i32, i32)> {
+        let mut out: Vec<(i32, i32)> = self
+            .chunks()
+            .filter(|(pos, entry)| {
+                other
+                    .get(pos.0, pos.1)
+                    .is_none_or(|theirs| theirs.payload_hash != entry.payload_hash)
+            })
+            .map(|(pos, _)| pos)
+            .chain(
+                other
+                    .chunks()
+                    .filter(|(pos, _)| self.get(pos.0, pos.1).is_none())
+                    .map(|(pos, _)| pos),
+            )
+            .collect();
+        out.sort_by_key(|&(cx, cz)| chunk_order_key(cx, cz));
+        out
+    }
+}
+
+fn chunk_position((rx, rz): (i32, i32), local: u16) -> (i32, i32) {
+    (rx * 32 + (local % 32) as i32, rz * 32 + (local / 32) as i32)
+}
+
+/// Re-index one region file against its previous entry. Records whose hash
+/// is unchanged keep their old entry; the rest are decoded.
+fn index_region(path: &Path, key: (i32, i32), old: Option<&RegionEntry>) -> Result<IndexedRegion> {
+    let region = RegionSlice::new(Arc::new(std::fs::read(path)?), key.0, key.1)?;
+    let mut out = IndexedRegion {
+        entry: RegionEntry::default(),
+        names: Vec::new(),
+        changed: Vec::new(),
+        removed: Vec::new(),
+    };
+    for (cx, cz) in region.chunk_positions() {
+        let Some(raw) = region.raw_chunk(cx, cz)? else {
+            continue;
+        };
+        let local = (cz.rem_euclid(32) * 32 + cx.rem_euclid(32)) as u16;
+        let payload_hash = *raw.content_hash().as_bytes();
+        let offset = region.record_offset(cx, cz).unwrap_or(0);
+        let timestamp = region.timestamp(cx, cz).unwrap_or(0);
+        if let Some(previous) = old.and_then(|old| old.chunks.get(&local)) {
+            if previous.payload_hash == payload_hash {
+                let mut entry = previous.clone();
+                entry.offset = offset;
+                entry.timestamp = timestamp;
+                out.entry.chunks.insert(local, entry);
+                continue;
+            }
+        }
+
+        let mut entry = ChunkEntry {
+            offset,
+            timestamp,
+            payload_hash,
+            readable: false,
+            occupied_sections: Vec::new(),
+            palette: Vec::new(),
+        };
+        let mut names = Vec::new();
+        if let Ok(chunk) = raw.decode_projected(&ChunkProjection::blocks_only()) {
+            entry.readable = true;
+            for section in &chunk.sections {
+                let solid: Vec<bool> = section.palette.iter().map(|b| !is_air(&b.name)).collect();
+                if section
+                    .block_states
+                    .iter()
+                    .any(|&i| solid.get(i as usize).copied().unwrap_or(false))
+                {
+                    entry.occupied_sections.push(section.y);
+                }
+                names.extend(
+                    section
+                        .palette
+                        .iter()
+                        .filter(|b| !is_air(&b.name))
+                        .map(|b| b.name.to_string()),
+                );
+            }
+            entry.occupied_sections.sort_unstable();
+            names.sort_unstable();
+            names.dedup();
+        }
+        out.entry.chunks.insert(local, entry);
+        out.names.push((local, names));
+        out.changed.push((cx, cz));
+    }
+    if let Some(old) = old {
+        out.removed.extend(
+            old.chunks
+                .keys()
+                .filter(|local| !out.entry.chunks.contains_key(local))
+                .map(|&local| chunk_position(key, local)),
+        );
+    }
+    Ok(out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::formats::world;
+    use crate::formats::world_stream::WorldSink;
+    use crate::{BlockState, UniversalSchematic};
+
+    #[test]
+    fn update_reports_only_changed_chunks() {
+        let mut schem = UniversalSchematic::new("indexed".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        schem.set_block(0, 64, 0, &stone);
+        schem.set_block(20, 64, 0, &stone); // cx=1
+        schem.set_block(530, 3, 7, &stone); // cx=33, region r.1.0
+        let dir = std::env::temp_dir().join("nucleation_world_index_update");
+        let _ = std::fs::remove_dir_all(&dir);
+        world::save_world(&schem, &dir, None).unwrap();
+
+        let (index, delta) = WorldIndex::open(&dir).unwrap();
+        assert_eq!(delta.changed.len(), index.chunks().count());
+        assert!(delta.changed.contains(&(33, 0)));
+        let far = index.get(33, 0).unwrap();
+        assert_eq!(far.occupied_sections, vec![0]);
+        assert!(far.occupies(0, 15) && !far.occupies(16, 300));
+        let names: Vec<&str> = far
+            .palette
+            .iter()
+            .map(|&id| index.palette()[id as usize].as_str())
+            .collect();
+        assert_eq!(names, vec!["minecraft:stone"]);
+
+        // Nothing changed: the sidecar reloads and reports nothing.
+        let (reopened, delta) = WorldIndex::open(&dir).unwrap();
+        assert!(delta.is_empty());
+        assert_eq!(reopened, index);
+
+        let gold = BlockState::new("minecraft:gold_block".to_string());
+        let mut sink = WorldSink::open_existing(&dir).unwrap();
+        sink.patch_chunk(1, 0, |view| {
+            view.set_block(21, 64, 0, &gold);
+        })
+        .unwrap();
+        sink.finish().unwrap();
+
+        let (updated, delta) = WorldIndex::open(&dir).unwrap();
+        assert_eq!(delta.changed, vec![(1, 0)]);
+        assert!(delta.removed.is_empty());
+        assert_eq!(updated.get(33, 0), index.get(33, 0));
+        assert_eq!(updated.differing(&index), vec![(1, 0)]);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
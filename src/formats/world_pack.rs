@@ -21,6 +21,10 @@
 //! live working set is bounded by the *overlap span* of the layout — for the
 //! default non-overlapping grid layout that is exactly one schematic's chunks.
 //!
+//! [`pack_parallel`] runs the same plan on the rayon pool. Placements linked
+//! through shared chunk columns are packed as one group, in order, and
+//! disjoint groups run concurrently into a [`ShardedWorldSink`].
+//!
 //! ## Overlap rule
 //!
 //! Placements are totally ordered by `(key, offset)` ascending and processed in
@@ -41,7 +45,7 @@
 use std::collections::HashMap;
 
 use crate::bounding_box::BoundingBox;
-use crate::formats::world_stream::{WorldChunkView, WorldSink};
+use crate::formats::world_stream::{ShardedWorldSink, WorldChunkView, WorldSink};
 use crate::universal_schematic::UniversalSchematic;
 
 type Result<T> = std::result::Result<T, Box<dyn std::error::Error>>;
@@ -141,7 +145,71 @@ pub fn pack<L>(placements: &[Placement], mut load: L, sink: &mut WorldSink) -> R
 where
     L: FnMut(&Placement) -> Result<UniversalSchematic>,
 {
-    // Total, order-independent processing order: sort indices by (key, offset).
+    let order = processing_order(placements);
+    let mut stats = pack_ordered(placements, &order, &mut load, &mut |view| {
+        sink.write_chunk(view).map_err(Into::into)
+    })?;
+    stats.schematics = placements.len();
+    Ok(stats)
+}
+
+/// Pack `placements` into a [`ShardedWorldSink`] on the rayon pool.
+///
+/// Placements that share a chunk column, directly or through a chain of
+/// others, form one group; groups touch disjoint chunks and are packed
+/// concurrently, each in the same `(key, offset)` order [`pack`] uses. Every
+/// cell therefore resolves to the same placement as in a serial run and the
+/// world is identical. Up to one schematic per worker is live at a time.
+///
+/// `peak_live_chunks` is the largest peak of any single group. The caller
+/// must still call [`ShardedWorldSink::finish`].
+pub fn pack_parallel<L>(
+    placements: &[Placement],
+    load: L,
+    sink: &ShardedWorldSink,
+) -> Result<PackStats>
+where
+    L: Fn(&Placement) -> Result<UniversalSchematic> + Sync,
+{
+    use rayon::prelude::*;
+
+    let order = processing_order(placements);
+    let groups = column_groups(placements, &order);
+    // Errors cross threads as strings: the crate's boxed errors are not `Send`.
+    let parts = groups
+        .par_iter()
+        .map(|group| {
+            pack_ordered(placements, group, &mut |p| load(p), &mut |view| {
+                sink.write_chunk(view).map_err(Into::into)
+            })
+            .map_err(|e| e.to_string())
+        })
+        .collect::<std::result::Result<Vec<PackStats>, String>>()?;
+
+    let mut stats = PackStats {
+        schematics: placements.len(),
+        blocks_written: 0,
+        chunks_written: 0,
+        bounds: None,
+        peak_live_chunks: 0,
+    };
+    for part in parts {
+        stats.blocks_written += part.blocks_written;
+        stats.chunks_written += part.chunks_written;
+        stats.peak_live_chunks = stats.peak_live_chunks.max(part.peak_live_chunks);
+        if let Some(bb) = part.bounds {
+            stats.bounds = Some(match stats.bounds.take() {
+                None => bb,
+                Some(acc) => acc.union(&bb),
+            });
+        }
+    }
+    Ok(stats)
+}
+
+/// Total, order-independent processing order: indices sorted by
+/// `(key, offset)`.
+fn processing_order(placements: &[Placement]) -> Vec<usize> {
     let mut order: Vec<usize> = (0..placements.len()).collect();
     order.sort_by(|&a, &b| {
         let pa = &placements[a];
@@ -150,7 +218,65 @@ where
             .cmp(&pb.key)
             .then_with(|| pa.offset.cmp(&pb.offset))
     });
+    order
+}
 
+/// Split `order` into groups of placements connected through shared chunk
+/// columns. Each group keeps the relative order of `order`; groups are
+/// returned largest first so long chains start early on the pool.
+fn column_groups(placements: &[Placement], order: &[usize]) -> Vec<Vec<usize>> {
+    fn find(parent: &mut [usize], mut i: usize) -> usize {
+        while parent[i] != i {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        i
+    }
+
+    // Union-find over processing positions, joined through the first
+    // position that claimed each column.
+    let mut parent: Vec<usize> = (0..order.len()).collect();
+    let mut owner: HashMap<(i32, i32), usize> = HashMap::new();
+    for (pos, &idx) in order.iter().enumerate() {
+        let (cx0, cz0, cx1, cz1) = placements[idx].chunk_span();
+        for cx in cx0..=cx1 {
+            for cz in cz0..=cz1 {
+                let first = *owner.entry((cx, cz)).or_insert(pos);
+                let (a, b) = (find(&mut parent, first), find(&mut parent, pos));
+                if a != b {
+                    parent[a.max(b)] = a.min(b);
+                }
+            }
+        }
+    }
+
+    let mut groups: Vec<Vec<usize>> = Vec::new();
+    let mut slot: HashMap<usize, usize> = HashMap::new();
+    for (pos, &idx) in order.iter().enumerate() {
+        let root = find(&mut parent, pos);
+        let g = *slot.entry(root).or_insert_with(|| {
+            groups.push(Vec::new());
+            groups.len() - 1
+        });
+        groups[g].push(idx);
+    }
+    groups.sort_by_key(|g| std::cmp::Reverse(g.len()));
+    groups
+}
+
+/// Pack the placements at `order`, in that order, handing each chunk to
+/// `write` once its last toucher in `order` is done. `schematics` is left at
+/// zero for the caller to fill in.
+fn pack_ordered<L, W>(
+    placements: &[Placement],
+    order: &[usize],
+    load: &mut L,
+    write: &mut W,
+) -> Result<PackStats>
+where
+    L: FnMut(&Placement) -> Result<UniversalSchematic>,
+    W: FnMut(&WorldChunkView) -> Result<()>,
+{
     // Plan: for each chunk column, the *last* processing position that touches
     // it. A chunk can be flushed the moment we finish that position.
     let mut last_touch: HashMap<(i32, i32), usize> = HashMap::new();
@@ -165,7 +291,7 @@ where
 
     let mut live: HashMap<(i32, i32), WorldChunkView> = HashMap::new();
     let mut stats = PackStats {
-        schematics: placements.len(),
+        schematics: 0,
         blocks_written: 0,
         chunks_written: 0,
         bounds: None,
@@ -211,7 +337,7 @@ where
         for c in ready {
             let view = live.remove(&c).expect("ready chunk is live");
             stats.blocks_written += view.blocks().count() as u64;
-            sink.write_chunk(&view)?;
+            write(&view)?;
             stats.chunks_written += 1;
         }
     }
@@ -223,7 +349,7 @@ where
     for c in leftover {
         let view = live.remove(&c).unwrap();
         stats.blocks_written += view.blocks().count() as u64;
-        sink.write_chunk(&view)?;
+        write(&view)?;
         stats.chunks_written += 1;
     }
 
@@ -461,6 +587,60 @@ mod tests {
         cleanup(&dir);
     }
 
+    #[test]
+    fn parallel_pack_matches_serial_pack() {
+        // A chain of overlapping placements (one group) plus isolated ones
+        // spread over several regions.
+        let a = schem("a", &[(0, 0, 0, "minecraft:stone"), (20, 0, 0, "minecraft:stone")]);
+        let b = schem("b", &[(0, 0, 0, "minecraft:gold_block"), (20, 0, 0, "minecraft:dirt")]);
+        let mut placements = vec![
+            place("b", (10, 64, 0), &b),
+            place("a", (0, 64, 0), &a),
+            place("a", (30, 64, 0), &a),
+        ];
+        for i in 0..12 {
+            placements.push(place(&format!("s{i:02}"), (600 * i - 3000, 70, 40 * i), &a));
+        }
+        let load = |p: &Placement| Ok(if p.key == "b" { b.clone() } else { a.clone() });
+
+        let serial_dir = tempdir();
+        let mut sink = WorldSink::create(&serial_dir, None).unwrap();
+        let serial = pack(&placements, load, &mut sink).unwrap();
+        sink.finish().unwrap();
+
+        let parallel_dir = tempdir();
+        let sink = ShardedWorldSink::create(&parallel_dir, None, 2).unwrap();
+        let parallel = pack_parallel(&placements, load, &sink).unwrap();
+        sink.finish().unwrap();
+
+        assert_eq!(parallel.schematics, serial.schematics);
+        assert_eq!(parallel.blocks_written, serial.blocks_written);
+        assert_eq!(parallel.chunks_written, serial.chunks_written);
+        assert_eq!(parallel.bounds, serial.bounds);
+        let world = read_world(&parallel_dir);
+        assert_eq!(world, read_world(&serial_dir));
+        // Both "a" placements sort before "b", so b's dirt wins at x = 30.
+        assert_eq!(world.get(&(10, 64, 0)).map(String::as_str), Some("minecraft:gold_block"));
+        assert_eq!(world.get(&(20, 64, 0)).map(String::as_str), Some("minecraft:stone"));
+        assert_eq!(world.get(&(30, 64, 0)).map(String::as_str), Some("minecraft:dirt"));
+        cleanup(&serial_dir);
+        cleanup(&parallel_dir);
+    }
+
+    #[test]
+    fn column_groups_join_chains_and_keep_order() {
+        let a = schem("a", &[(0, 0, 0, "minecraft:stone"), (20, 0, 0, "minecraft:stone")]);
+        // p0 and p2 share no column but are linked through p1.
+        let placements = vec![
+            place("p0", (0, 0, 0), &a),
+            place("p1", (20, 0, 0), &a),
+            place("p2", (40, 0, 0), &a),
+            place("q", (500, 0, 500), &a),
+        ];
+        let order = processing_order(&placements);
+        assert_eq!(column_groups(&placements, &order), vec![vec![0, 1, 2], vec![3]]);
+    }
+
     // --- tiny temp-dir helpers (avoid a dev-dependency) ---
     fn tempdir() -> std::path::PathBuf {
         let mut p = std::env::temp_dir();
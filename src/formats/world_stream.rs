@@ -11,28 +11,49 @@
 //!   underlying archive `Arc<Vec<u8>>` stays alive (shared with the source and
 //!   every entry read) as long as the `WorldSource` or any `ChunkIter`
 //!   derived from it is alive.
+//! * **Mapped directory** sources (`WorldSource::open_dir_mapped`): region
+//!   files are mapped read-only and chunk payloads are sliced from the
+//!   mapping, so pages are the OS's to evict; only decoded chunks are heap.
+//! * **Parallel** iteration (`ChunkIter::parallel`): on top of the above, at
+//!   most `4 * threads` chunks are read ahead — compressed, decoding, or
+//!   decoded and waiting to be yielded.
 
-use std::collections::HashMap;
+#[cfg(not(target_arch = "wasm32"))]
+use std::collections::BTreeMap;
+use std::collections::{HashMap, HashSet};
 use std::io::{Cursor, Read, Seek, SeekFrom};
 #[cfg(not(target_arch = "wasm32"))]
 use std::path::{Path, PathBuf};
 use std::sync::Arc;
+#[cfg(not(target_arch = "wasm32"))]
+use std::sync::{mpsc, Condvar, Mutex};
+#[cfg(not(target_arch = "wasm32"))]
+use std::thread::JoinHandle;
 
 use crate::block_entity::BlockEntity;
+use crate::block_entity_store::BlockEntityInterner;
 use crate::entity::Entity;
-use crate::formats::anvil::{floor_div, parse_entity_mca, ChunkData, RegionReader};
 #[cfg(not(target_arch = "wasm32"))]
-use crate::formats::anvil::{write_entity_mca, EntityChunkData, McaFile};
+use crate::formats::anvil::{
+    encode_chunk, write_entity_mca_with, ChunkCompression, CompressionType, EntityChunkData,
+    McaFile,
+};
+use crate::formats::anvil::{
+    floor_div, heightmap_values, parse_entity_mca, ChunkData, ChunkProjection, RawChunk,
+    RegionReader, RegionSlice,
+};
 use crate::formats::error::Result;
 #[cfg(not(target_arch = "wasm32"))]
 use crate::formats::world::{generate_level_dat, WorldExportOptions};
 use crate::formats::world::{load_chunk_into_schematic, parse_region_filename};
+use crate::telemetry::{self, stage};
 use crate::universal_schematic::UniversalSchematic;
 use crate::BlockState;
 
 /// Trait object alias so ChunkIter can hold file- or memory-backed readers.
-trait ReadSeek: Read + Seek {}
-impl<T: Read + Seek> ReadSeek for T {}
+/// `Send` so a ChunkIter can feed worker threads.
+trait ReadSeek: Read + Seek + Send {}
+impl<T: Read + Seek + Send> ReadSeek for T {}
 
 type Bounds = (i32, i32, i32, i32, i32, i32);
 
@@ -94,7 +115,10 @@ impl Seek for ArcCursor {
 #[derive(Clone)]
 enum SourceKind {
     #[cfg(not(target_arch = "wasm32"))]
-    Directory(PathBuf),
+    Directory {
+        dir: PathBuf,
+        mapped: bool,
+    },
     Zip(Arc<Vec<u8>>),
     Mca(Arc<Vec<u8>>),
 }
@@ -107,18 +131,44 @@ pub struct WorldSource {
 /// One region's worth of lazily readable chunks plus its (eagerly parsed,
 /// per-region) entity data.
 struct CurrentRegion {
-    reader: RegionReader<Box<dyn ReadSeek>>,
+    reader: RegionChunks,
     /// Chunk positions still to yield, canonical order, bounds-filtered.
     positions: std::vec::IntoIter<(i32, i32)>,
     /// Entities from entities/r.X.Z.mca keyed by chunk position (1.17+).
     entities: HashMap<(i32, i32), Vec<Entity>>,
 }
 
+/// Where the open region's chunk payloads come from: a file handle, or
+/// bytes in memory (a zip entry or a mapped file) sliced without copying.
+enum RegionChunks {
+    Stream(RegionReader<Box<dyn ReadSeek>>),
+    Slice(RegionSlice),
+}
+
+impl RegionChunks {
+    fn chunk_positions(&self) -> Vec<(i32, i32)> {
+        match self {
+            RegionChunks::Stream(reader) => reader.chunk_positions(),
+            RegionChunks::Slice(region) => region.chunk_positions(),
+        }
+    }
+
+    fn read_raw_chunk(&mut self, cx: i32, cz: i32) -> Result<Option<RawChunk>> {
+        match self {
+            RegionChunks::Stream(reader) => reader.read_raw_chunk(cx, cz),
+            RegionChunks::Slice(region) => region.raw_chunk(cx, cz),
+        }
+    }
+}
+
 pub struct ChunkIter {
     kind: SourceKind,
     /// Region positions still to open, sorted by (x, z).
     regions: std::vec::IntoIter<(i32, i32)>,
     bounds: Option<Bounds>,
+    /// When set, only these chunk positions are yielded.
+    only: Option<Arc<HashSet<(i32, i32)>>>,
+    projection: ChunkProjection,
     current: Option<CurrentRegion>,
 }
 
@@ -126,14 +176,82 @@ pub struct WorldChunkView {
     pub(crate) data: ChunkData,
 }
 
+/// One section of a [`WorldChunkView`], as stored.
+pub struct SectionSummary<'a> {
+    /// Section Y; the section covers block Ys `y * 16..y * 16 + 16`.
+    pub y: i32,
+    pub palette: &'a [BlockState],
+    /// 4096 palette indices in `y * 256 + z * 16 + x` order.
+    pub block_states: &'a [u16],
+    /// Blocks that are not air.
+    pub non_air: u32,
+}
+
+/// A ChunkIter whose chunks are decoded on worker threads. Reading each
+/// chunk's compressed bytes stays serial (one region file open at a time);
+/// decompression and NBT parsing run on the workers. Items come out in
+/// canonical order when `ordered`, otherwise as soon as they are decoded.
+/// Dropping it stops and joins the workers.
+#[cfg(not(target_arch = "wasm32"))]
+pub struct ParallelChunkIter {
+    shared: Arc<Prefetch>,
+    results: Option<mpsc::Receiver<(u64, Result<WorldChunkView>)>>,
+    workers: Vec<JoinHandle<()>>,
+    ordered: bool,
+    /// Sequence number of the next item to yield when `ordered`.
+    next_seq: u64,
+    /// Decoded items that arrived ahead of `next_seq`.
+    pending: BTreeMap<u64, Result<WorldChunkView>>,
+}
+
+/// Read-ahead state shared by the workers and the consumer.
+#[cfg(not(target_arch = "wasm32"))]
+struct Prefetch {
+    state: Mutex<PrefetchState>,
+    /// Signalled when an item is yielded (freeing read-ahead room) or on
+    /// cancellation.
+    room: Condvar,
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+struct PrefetchState {
+    iter: ChunkIter,
+    /// Items taken from `iter` so far; also the next sequence number.
+    claimed: u64,
+    /// Items handed to the consumer so far.
+    yielded: u64,
+    /// Most items claimed but not yet yielded.
+    depth: u64,
+    /// `iter` has run dry; waiting workers should exit.
+    exhausted: bool,
+    cancelled: bool,
+}
+
 impl WorldSource {
     #[cfg(not(target_arch = "wasm32"))]
     pub fn open_dir(path: &Path) -> Result<Self> {
+        Self::open_dir_impl(path, false)
+    }
+
+    /// Like `open_dir`, but region files are memory-mapped and chunk
+    /// payloads are sliced from the mapping instead of read into buffers.
+    /// The world must not be written to (e.g. by a running server) while
+    /// the source or any iterator over it is alive.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn open_dir_mapped(path: &Path) -> Result<Self> {
+        Self::open_dir_impl(path, true)
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    fn open_dir_impl(path: &Path, mapped: bool) -> Result<Self> {
         if !path.join("region").is_dir() {
             return Err(format!("{} has no region/ subdirectory", path.display()).into());
         }
         Ok(Self {
-            kind: SourceKind::Directory(path.to_path_buf()),
+            kind: SourceKind::Directory {
+                dir: path.to_path_buf(),
+                mapped,
+            },
         })
     }
 
@@ -171,7 +289,7 @@ impl WorldSource {
     pub fn region_positions(&self) -> Result<Vec<(i32, i32)>> {
         let mut positions: Vec<(i32, i32)> = match &self.kind {
             #[cfg(not(target_arch = "wasm32"))]
-            SourceKind::Directory(dir) => {
+            SourceKind::Directory { dir, .. } => {
                 let mut out = Vec::new();
                 for entry in std::fs::read_dir(dir.join("region"))? {
                     let entry = entry?;
@@ -214,15 +332,61 @@ impl WorldSource {
     }
 
     pub fn chunks(&self) -> Result<ChunkIter> {
-        self.chunks_impl(None)
+        self.chunks_impl(None, None, ChunkProjection::default())
+    }
+
+    /// Stream only the chunks at `positions` (those that exist), in
+    /// canonical order. Regions holding none of them are not opened. Pairs
+    /// with [`WorldIndex`](crate::formats::world_index::WorldIndex) deltas
+    /// for incremental scans.
+    pub fn chunks_at(&self, positions: &[(i32, i32)]) -> Result<ChunkIter> {
+        self.chunks_at_projected(positions, ChunkProjection::default())
+    }
+
+    /// Like `chunks_at`, decoding only what `projection` keeps.
+    pub fn chunks_at_projected(
+        &self,
+        positions: &[(i32, i32)],
+        projection: ChunkProjection,
+    ) -> Result<ChunkIter> {
+        let only: HashSet<(i32, i32)> = positions.iter().copied().collect();
+        self.chunks_impl(None, Some(Arc::new(only)), projection)
     }
 
     pub fn chunks_bounded(&self, min: (i32, i32, i32), max: (i32, i32, i32)) -> Result<ChunkIter> {
-        self.chunks_impl(Some((min.0, min.1, min.2, max.0, max.1, max.2)))
+        self.chunks_bounded_projected(min, max, ChunkProjection::default())
+    }
+
+    /// Like `chunks_bounded`, decoding only what `projection` keeps. Without
+    /// entities the region's `entities/` file is never opened. The Y bounds
+    /// do not drop sections by themselves; set `projection.y_range` for that.
+    pub fn chunks_bounded_projected(
+        &self,
+        min: (i32, i32, i32),
+        max: (i32, i32, i32),
+        projection: ChunkProjection,
+    ) -> Result<ChunkIter> {
+        self.chunks_impl(
+            Some((min.0, min.1, min.2, max.0, max.1, max.2)),
+            None,
+            projection,
+        )
     }
 
-    fn chunks_impl(&self, bounds: Option<Bounds>) -> Result<ChunkIter> {
+    fn chunks_impl(
+        &self,
+        bounds: Option<Bounds>,
+        only: Option<Arc<HashSet<(i32, i32)>>>,
+        projection: ChunkProjection,
+    ) -> Result<ChunkIter> {
         let mut regions = self.region_positions()?;
+        if let Some(only) = &only {
+            let wanted: HashSet<(i32, i32)> = only
+                .iter()
+                .map(|&(cx, cz)| (floor_div(cx, 32), floor_div(cz, 32)))
+                .collect();
+            regions.retain(|region| wanted.contains(region));
+        }
         if let Some((min_x, _, min_z, max_x, _, max_z)) = bounds {
             // A region spans 512 blocks; keep regions whose footprint intersects.
             regions.retain(|(rx, rz)| {
@@ -235,6 +399,8 @@ impl WorldSource {
             kind: self.kind.clone(),
             regions: regions.into_iter(),
             bounds,
+            only,
+            projection,
             current: None,
         })
     }
@@ -286,14 +452,22 @@ fn read_zip_region_entry(
 
 impl ChunkIter {
     fn open_region(&self, rx: i32, rz: i32) -> Result<CurrentRegion> {
-        let (reader, entity_chunks): (RegionReader<Box<dyn ReadSeek>>, Vec<_>) = match &self.kind {
+        let (reader, entity_chunks): (RegionChunks, Vec<_>) = match &self.kind {
             #[cfg(not(target_arch = "wasm32"))]
-            SourceKind::Directory(dir) => {
+            SourceKind::Directory { dir, mapped } => {
                 let region_path = dir.join("region").join(format!("r.{}.{}.mca", rx, rz));
-                let file = std::fs::File::open(&region_path)?;
-                let reader = RegionReader::new(Box::new(file) as Box<dyn ReadSeek>, rx, rz)?;
+                let reader = if *mapped {
+                    RegionChunks::Slice(RegionSlice::map_file(&region_path, rx, rz)?)
+                } else {
+                    let file = std::fs::File::open(&region_path)?;
+                    RegionChunks::Stream(RegionReader::new(
+                        Box::new(file) as Box<dyn ReadSeek>,
+                        rx,
+                        rz,
+                    )?)
+                };
                 let entity_path = dir.join("entities").join(format!("r.{}.{}.mca", rx, rz));
-                let entity_chunks = if entity_path.is_file() {
+                let entity_chunks = if self.projection.entities && entity_path.is_file() {
                     let bytes = std::fs::read(&entity_path)?;
                     parse_entity_mca(&bytes, rx, rz).unwrap_or_default()
                 } else {
@@ -304,14 +478,14 @@ impl ChunkIter {
             SourceKind::Zip(data) => {
                 let region_bytes = read_zip_region_entry(data, "region", rx, rz)?
                     .ok_or_else(|| format!("region r.{}.{}.mca not found in zip", rx, rz))?;
-                let reader = RegionReader::new(
-                    Box::new(Cursor::new(region_bytes)) as Box<dyn ReadSeek>,
-                    rx,
-                    rz,
-                )?;
-                let entity_chunks = match read_zip_region_entry(data, "entities", rx, rz)? {
-                    Some(bytes) => parse_entity_mca(&bytes, rx, rz).unwrap_or_default(),
-                    None => Vec::new(),
+                let reader = RegionChunks::Slice(RegionSlice::new(Arc::new(region_bytes), rx, rz)?);
+                let entity_chunks = if self.projection.entities {
+                    match read_zip_region_entry(data, "entities", rx, rz)? {
+                        Some(bytes) => parse_entity_mca(&bytes, rx, rz).unwrap_or_default(),
+                        None => Vec::new(),
+                    }
+                } else {
+                    Vec::new()
                 };
                 (reader, entity_chunks)
             }
@@ -320,7 +494,7 @@ impl ChunkIter {
                     data: data.clone(),
                     pos: 0,
                 }) as Box<dyn ReadSeek>)?;
-                (reader, Vec::new())
+                (RegionChunks::Stream(reader), Vec::new())
             }
         };
 
@@ -328,6 +502,7 @@ impl ChunkIter {
             .chunk_positions()
             .into_iter()
             .filter(|(cx, cz)| chunk_in_bounds(*cx, *cz, &self.bounds))
+            .filter(|pos| self.only.as_ref().is_none_or(|only| only.contains(pos)))
             .collect();
         positions.sort_by_key(|(cx, cz)| chunk_order_key(*cx, *cz));
 
@@ -350,19 +525,17 @@ impl ChunkIter {
     }
 }
 
-impl Iterator for ChunkIter {
-    type Item = Result<WorldChunkView>;
-
-    fn next(&mut self) -> Option<Self::Item> {
+impl ChunkIter {
+    /// Next present chunk, still compressed, with its entities from the
+    /// region's entity file. Same order and error items as `next`.
+    fn next_raw(&mut self) -> Option<Result<(RawChunk, Vec<Entity>)>> {
         loop {
             if let Some(cur) = self.current.as_mut() {
                 if let Some((cx, cz)) = cur.positions.next() {
-                    match cur.reader.read_chunk(cx, cz) {
-                        Ok(Some(mut chunk)) => {
-                            if let Some(extra) = cur.entities.remove(&(cx, cz)) {
-                                chunk.entities.extend(extra);
-                            }
-                            return Some(Ok(WorldChunkView { data: chunk }));
+                    match cur.reader.read_raw_chunk(cx, cz) {
+                        Ok(Some(raw)) => {
+                            let extra = cur.entities.remove(&(cx, cz)).unwrap_or_default();
+                            return Some(Ok((raw, extra)));
                         }
                         Ok(None) => continue, // listed but absent — skip
                         Err(e) => return Some(Err(e)), // corrupt chunk: yield error, continue next call
@@ -377,6 +550,151 @@ impl Iterator for ChunkIter {
             }
         }
     }
+
+    /// Decode chunks on `threads` worker threads (0 = one per core). Yields
+    /// the same items as this iterator; in the same order when `ordered`.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn parallel(self, threads: usize, ordered: bool) -> ParallelChunkIter {
+        let threads = match threads {
+            0 => std::thread::available_parallelism().map_or(1, |n| n.get()),
+            n => n,
+        };
+        let shared = Arc::new(Prefetch {
+            state: Mutex::new(PrefetchState {
+                iter: self,
+                claimed: 0,
+                yielded: 0,
+                depth: threads as u64 * 4,
+                exhausted: false,
+                cancelled: false,
+            }),
+            room: Condvar::new(),
+        });
+        let (sender, results) = mpsc::channel();
+        let workers = (0..threads)
+            .map(|_| {
+                let shared = shared.clone();
+                let sender = sender.clone();
+                std::thread::spawn(move || decode_worker(&shared, &sender))
+            })
+            .collect();
+        ParallelChunkIter {
+            shared,
+            results: Some(results),
+            workers,
+            ordered,
+            next_seq: 0,
+            pending: BTreeMap::new(),
+        }
+    }
+}
+
+fn decode_view(
+    raw: &RawChunk,
+    entities: Vec<Entity>,
+    projection: &ChunkProjection,
+) -> Result<WorldChunkView> {
+    let _stage = stage!(DEBUG, "world.chunk.decode", cx = raw.cx, cz = raw.cz);
+    telemetry::count("world.chunks", 1);
+    let mut chunk = raw.decode_projected(projection)?;
+    chunk.entities.extend(entities);
+    Ok(WorldChunkView { data: chunk })
+}
+
+/// Claim chunks in order while there is read-ahead room and decode them
+/// outside the lock, until the source runs dry or the consumer goes away.
+#[cfg(not(target_arch = "wasm32"))]
+fn decode_worker(shared: &Prefetch, results: &mpsc::Sender<(u64, Result<WorldChunkView>)>) {
+    loop {
+        let (seq, item, projection) = {
+            let mut state = shared.state.lock().unwrap_or_else(|e| e.into_inner());
+            while !state.cancelled
+                && !state.exhausted
+                && state.claimed - state.yielded >= state.depth
+            {
+                state = shared.room.wait(state).unwrap_or_else(|e| e.into_inner());
+            }
+            if state.cancelled || state.exhausted {
+                return;
+            }
+            let Some(item) = state.iter.next_raw() else {
+                state.exhausted = true;
+                shared.room.notify_all();
+                return;
+            };
+            state.claimed += 1;
+            (state.claimed - 1, item, state.iter.projection)
+        };
+        // A panicking decode must still produce its sequence number, or an
+        // ordered consumer would wait for it forever.
+        let view = item.and_then(|(raw, entities)| {
+            std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
+                decode_view(&raw, entities, &projection)
+            }))
+            .unwrap_or_else(|_| {
+                Err(format!("chunk ({}, {}) failed to decode", raw.cx, raw.cz).into())
+            })
+        });
+        if results.send((seq, view)).is_err() {
+            return;
+        }
+    }
+}
+
+impl Iterator for ChunkIter {
+    type Item = Result<WorldChunkView>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let projection = self.projection;
+        self.next_raw()
+            .map(|item| item.and_then(|(raw, entities)| decode_view(&raw, entities, &projection)))
+    }
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+impl Iterator for ParallelChunkIter {
+    type Item = Result<WorldChunkView>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let results = self.results.as_ref()?;
+        let item = if self.ordered {
+            loop {
+                if let Some(item) = self.pending.remove(&self.next_seq) {
+                    self.next_seq += 1;
+                    break item;
+                }
+                // Every claimed item is sent before its worker exits, so a
+                // closed channel means nothing is left.
+                let (seq, item) = results.recv().ok()?;
+                self.pending.insert(seq, item);
+            }
+        } else {
+            results.recv().ok()?.1
+        };
+        self.shared
+            .state
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .yielded += 1;
+        self.shared.room.notify_one();
+        Some(item)
+    }
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+impl Drop for ParallelChunkIter {
+    fn drop(&mut self) {
+        self.shared
+            .state
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+            .cancelled = true;
+        self.shared.room.notify_all();
+        self.results = None;
+        for worker in self.workers.drain(..) {
+            let _ = worker.join();
+        }
+    }
 }
 
 impl WorldChunkView {
@@ -423,6 +741,54 @@ impl WorldChunkView {
         section.palette.get(palette_idx)
     }
 
+    /// Per-section palettes, block indices and non-air counts, by ascending
+    /// section Y.
+    pub fn sections(&self) -> Vec<SectionSummary<'_>> {
+        let mut out: Vec<SectionSummary<'_>> = self
+            .data
+            .sections
+            .iter()
+            .map(|section| {
+                let air: Vec<bool> = section
+                    .palette
+                    .iter()
+                    .map(|b| {
+                        matches!(
+                            b.name.as_str(),
+                            "minecraft:air" | "minecraft:cave_air" | "minecraft:void_air"
+                        )
+                    })
+                    .collect();
+                let non_air = section
+                    .block_states
+                    .iter()
+                    .filter(|&&i| !air.get(i as usize).copied().unwrap_or(true))
+                    .count() as u32;
+                SectionSummary {
+                    y: section.y as i32,
+                    palette: &section.palette,
+                    block_states: &section.block_states,
+                    non_air,
+                }
+            })
+            .collect();
+        out.sort_by_key(|section| section.y);
+        out
+    }
+
+    /// One heightmap (`MOTION_BLOCKING`, `WORLD_SURFACE`, ...) as 256 world
+    /// Ys in `z * 16 + x` order: the Y just above each column's highest
+    /// counted block, or the chunk's bottom Y for an empty column. Read from
+    /// the heightmaps stored in the chunk; a chunk without them (built in
+    /// memory, or edited with `set_block` since it was read) computes the
+    /// two named kinds from its blocks, counting every non-air block. None
+    /// for other kinds it does not store.
+    pub fn heightmap(&self, name: &str) -> Option<Vec<i32>> {
+        let bottom = self.data.y_pos * 16;
+        let values = heightmap_values(&self.data, name)?;
+        Some(values.into_iter().map(|v| bottom + v).collect())
+    }
+
     /// Iterator over non-air blocks as (world_x, world_y, world_z, state).
     pub fn blocks(&self) -> impl Iterator<Item = (i32, i32, i32, &BlockState)> + '_ {
         let cx16 = self.data.x * 16;
@@ -458,7 +824,7 @@ impl WorldChunkView {
 
     /// Merge this chunk into an existing schematic at world coordinates.
     pub fn load_into(&self, schematic: &mut UniversalSchematic) {
-        load_chunk_into_schematic(&self.data, schematic, None);
+        load_chunk_into_schematic(&self.data, schematic, None, &mut BlockEntityInterner::new());
     }
 
     /// This chunk alone as a schematic (bridge to diff/fingerprint/mesh).
@@ -488,6 +854,7 @@ impl WorldChunkView {
                 block_entities: Vec::new(),
                 entities: Vec::new(),
                 y_pos: -4,
+                heightmaps: None,
             },
         }
     }
@@ -500,6 +867,8 @@ impl WorldChunkView {
         if !(0..16).contains(&local_x) || !(0..16).contains(&local_z) {
             return false;
         }
+        // Stored heightmaps no longer describe the chunk.
+        self.data.heightmaps = None;
         let section_y = floor_div(y, 16) as i8;
         if self.data.sections.iter().all(|s| s.y != section_y) {
             self.data
@@ -615,6 +984,9 @@ impl WorldSink {
     /// Start a new world at `dir`. `finish` writes a `level.dat` generated
     /// from `options` (defaults if `None`).
     pub fn create(dir: &Path, options: Option<WorldExportOptions>) -> Result<Self> {
+        if let Some(opts) = &options {
+            opts.chunk_codec()?;
+        }
         std::fs::create_dir_all(dir.join("region"))?;
         Ok(Self {
             dir: dir.to_path_buf(),
@@ -637,6 +1009,13 @@ impl WorldSink {
         })
     }
 
+    /// Chunk codec from the options; open_existing sinks write vanilla zlib.
+    fn compression(&self) -> Result<ChunkCompression> {
+        self.options
+            .as_ref()
+            .map_or_else(|| Ok(ChunkCompression::default()), |o| o.chunk_codec())
+    }
+
     /// Write a chunk into the sink. The chunk is buffered until the active
     /// region changes, at which point the buffered region is flushed (with a
     /// read-merge if the file already exists, so earlier writes to the same
@@ -658,7 +1037,7 @@ impl WorldSink {
     }
 
     /// Read chunk (cx, cz) from its region file, apply `f` to a mutable view,
-    /// and rewrite the region file. Other chunks in the region are untouched.
+    /// and write it back. Other chunks in the region are untouched.
     ///
     /// Only valid on [`open_existing`] sinks. Returns an error if called on a
     /// `create`-mode sink, because the sink may hold unflushed buffered chunks
@@ -671,113 +1050,77 @@ impl WorldSink {
         cz: i32,
         f: impl FnOnce(&mut WorldChunkView),
     ) -> Result<()> {
+        self.patch_chunks([(cx, cz, f)])
+    }
+
+    /// Apply many patches, as [`patch_chunk`] does, grouped by region. Only
+    /// the patched chunks are decoded and re-encoded; a chunk patched more
+    /// than once sees the patches in order. Each region file is updated
+    /// once, in place: a patched chunk goes back into its old sectors when
+    /// it still fits and is appended otherwise, and every other chunk's
+    /// bytes stay as they are. A region is only written once all of its
+    /// patches have applied.
+    ///
+    /// [`patch_chunk`]: WorldSink::patch_chunk
+    pub fn patch_chunks<F: FnOnce(&mut WorldChunkView)>(
+        &mut self,
+        patches: impl IntoIterator<Item = (i32, i32, F)>,
+    ) -> Result<()> {
+        use rayon::prelude::*;
         if self.write_level_dat {
             return Err("patch_chunk is only supported on WorldSink::open_existing sinks".into());
         }
-        let rx = floor_div(cx, 32);
-        let rz = floor_div(cz, 32);
-        let path = self.dir.join("region").join(format!("r.{}.{}.mca", rx, rz));
-        let bytes = std::fs::read(&path)?;
-        let mut mca = McaFile::from_bytes(&bytes, rx, rz)?;
-        let local = ((cz - rz * 32) * 32 + (cx - rx * 32)) as usize;
-        let chunk = mca.chunks[local]
-            .take()
-            .ok_or_else(|| format!("chunk ({}, {}) not present in {}", cx, cz, path.display()))?;
-        let mut view = WorldChunkView { data: chunk };
-        f(&mut view);
-        mca.chunks[local] = Some(view.data);
-        std::fs::write(&path, mca.to_bytes()?)?;
-        Ok(())
-    }
-
-    fn flush_current(&mut self) -> Result<()> {
-        if let Some((rx, rz, mut buffered_chunks)) = self.current.take() {
-            // World-default biome (create-mode sinks only): fill in sections
-            // that carry no biome data. Sections with existing biome data are
-            // never touched; open_existing sinks have no options → pure
-            // passthrough.
-            if let Some(opts) = &self.options {
-                for chunk in buffered_chunks.iter_mut().flatten() {
-                    for section in &mut chunk.sections {
-                        if section.biomes.is_none() {
-                            section.biomes =
-                                Some(crate::formats::anvil::single_biome_compound(&opts.biome));
-                        }
+        let mut by_region: BTreeMap<(i32, i32), Vec<(i32, i32, F)>> = BTreeMap::new();
+        for (cx, cz, f) in patches {
+            by_region
+                .entry((floor_div(cx, 32), floor_div(cz, 32)))
+                .or_default()
+                .push((cx, cz, f));
+        }
+        let compression = self.compression()?;
+        for ((rx, rz), patches) in by_region {
+            let path = self.dir.join("region").join(format!("r.{}.{}.mca", rx, rz));
+            let region = RegionSlice::new(Arc::new(std::fs::read(&path)?), rx, rz)?;
+            let mut edited: BTreeMap<u32, WorldChunkView> = BTreeMap::new();
+            for (cx, cz, f) in patches {
+                let local = ((cz - rz * 32) * 32 + (cx - rx * 32)) as u32;
+                let view = match edited.entry(local) {
+                    std::collections::btree_map::Entry::Occupied(view) => view.into_mut(),
+                    std::collections::btree_map::Entry::Vacant(slot) => {
+                        let raw = region.raw_chunk(cx, cz)?.ok_or_else(|| {
+                            format!("chunk ({}, {}) not present in {}", cx, cz, path.display())
+                        })?;
+                        slot.insert(WorldChunkView {
+                            data: raw.decode()?,
+                        })
                     }
-                }
+                };
+                f(view);
             }
-            // Entities are not part of region chunk NBT (1.17+ layout, same
-            // as world::to_world): split them into entities/r.X.Z.mca.
-            let data_version = buffered_chunks
-                .iter()
-                .flatten()
-                .map(|c| c.data_version)
-                .next()
-                .unwrap_or_else(|| self.options.clone().unwrap_or_default().data_version);
-
-            // Read-merge: if the region file already exists, read it and
-            // overlay only the buffered Some(...) slots onto it.  This
-            // preserves chunks written in earlier flushes for the same region
-            // (i.e. out-of-order A → B → A sequences lose nothing).
-            let region_path = self.dir.join("region").join(format!("r.{}.{}.mca", rx, rz));
-            let final_chunks = if region_path.is_file() {
-                let existing_bytes = std::fs::read(&region_path)?;
-                let mut existing_mca = McaFile::from_bytes(&existing_bytes, rx, rz)?;
-                for (i, slot) in buffered_chunks.into_iter().enumerate() {
-                    if slot.is_some() {
-                        existing_mca.chunks[i] = slot;
-                    }
-                }
-                existing_mca.chunks
-            } else {
-                buffered_chunks
-            };
+            drop(region);
 
-            let entity_chunks: Vec<EntityChunkData> = final_chunks
-                .iter()
-                .flatten()
-                .filter(|c| !c.entities.is_empty())
-                .map(|c| EntityChunkData {
-                    chunk_x: c.x,
-                    chunk_z: c.z,
-                    entities: c.entities.clone(),
+            let records = edited
+                .into_par_iter()
+                .map(|(local, view)| {
+                    let compressed = encode_chunk(&view.data, compression)?;
+                    Ok((local, chunk_record(&compressed, compression.codec)))
                 })
-                .collect();
-
-            let mca = McaFile {
-                chunks: final_chunks,
-                region_x: rx,
-                region_z: rz,
-            };
-            std::fs::write(&region_path, mca.to_bytes()?)?;
-
-            // Read-merge for the entities file as well.
-            let entities_dir = self.dir.join("entities");
-            let entity_path = entities_dir.join(format!("r.{}.{}.mca", rx, rz));
-            let merged_entity_chunks = if entity_path.is_file() {
-                let existing_bytes = std::fs::read(&entity_path)?;
-                let mut existing: Vec<EntityChunkData> =
-                    parse_entity_mca(&existing_bytes, rx, rz).unwrap_or_default();
-                // Buffered entries replace same-position existing entries.
-                for buf_chunk in &entity_chunks {
-                    if let Some(pos) = existing.iter().position(|e| {
-                        e.chunk_x == buf_chunk.chunk_x && e.chunk_z == buf_chunk.chunk_z
-                    }) {
-                        existing[pos] = buf_chunk.clone();
-                    } else {
-                        existing.push(buf_chunk.clone());
-                    }
-                }
-                existing
-            } else {
-                entity_chunks
-            };
+                .collect::<Result<Vec<_>>>()?;
+            patch_region_file(&path, &records)?;
+        }
+        Ok(())
+    }
 
-            if !merged_entity_chunks.is_empty() {
-                std::fs::create_dir_all(&entities_dir)?;
-                let bytes = write_entity_mca(&merged_entity_chunks, rx, rz, data_version)?;
-                std::fs::write(&entity_path, bytes)?;
-            }
+    fn flush_current(&mut self) -> Result<()> {
+        if let Some((rx, rz, buffered_chunks)) = self.current.take() {
+            write_region(
+                &self.dir,
+                self.options.as_ref(),
+                self.compression()?,
+                rx,
+                rz,
+                buffered_chunks,
+            )?;
         }
         Ok(())
     }
@@ -796,6 +1139,355 @@ impl WorldSink {
     }
 }
 
+/// A create-mode [`WorldSink`] for many writer threads and any chunk order.
+/// Up to `max_open` regions are buffered at once; a chunk for any other
+/// region evicts the least recently written one to disk. A region is
+/// written once, at eviction or [`finish`], unless it gets more chunks after
+/// being evicted; those are read-merged into the file as `WorldSink` does.
+/// Chunks compress in parallel within a region, and `finish` writes the
+/// remaining regions in parallel.
+///
+/// [`finish`]: ShardedWorldSink::finish
+#[cfg(not(target_arch = "wasm32"))]
+pub struct ShardedWorldSink {
+    dir: PathBuf,
+    options: Option<WorldExportOptions>,
+    compression: ChunkCompression,
+    max_open: usize,
+    shards: Mutex<Shards>,
+    /// Signalled whenever a region finishes writing.
+    written: Condvar,
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+#[derive(Default)]
+struct Shards {
+    open: HashMap<(i32, i32), RegionShard>,
+    /// Per region being written: (next ticket, ticket allowed to write).
+    /// Writes of one region run in eviction order, so each read-merge sees
+    /// the older chunks and the newer ones win.
+    turns: HashMap<(i32, i32), (u64, u64)>,
+    /// Bumped on every chunk write; orders regions for eviction.
+    clock: u64,
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+impl Shards {
+    fn take_turn(&mut self, key: (i32, i32)) -> u64 {
+        let (next, _) = self.turns.entry(key).or_insert((0, 0));
+        *next += 1;
+        *next - 1
+    }
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+struct RegionShard {
+    chunks: Vec<Option<ChunkData>>,
+    last_write: u64,
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+impl ShardedWorldSink {
+    /// Start a new world at `dir`, keeping at most `max_open_regions` region
+    /// buffers (at least one). `finish` writes a `level.dat` generated from
+    /// `options` (defaults if `None`).
+    pub fn create(
+        dir: &Path,
+        options: Option<WorldExportOptions>,
+        max_open_regions: usize,
+    ) -> Result<Self> {
+        let compression = options
+            .as_ref()
+            .map_or_else(|| Ok(ChunkCompression::default()), |o| o.chunk_codec())?;
+        std::fs::create_dir_all(dir.join("region"))?;
+        Ok(Self {
+            dir: dir.to_path_buf(),
+            options,
+            compression,
+            max_open: max_open_regions.max(1),
+            shards: Mutex::new(Shards::default()),
+            written: Condvar::new(),
+        })
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, Shards> {
+        self.shards.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// Buffer a chunk. If that opens a region beyond `max_open`, this call
+    /// also writes the evicted region before returning.
+    pub fn write_chunk(&self, view: &WorldChunkView) -> Result<()> {
+        let rx = floor_div(view.cx(), 32);
+        let rz = floor_div(view.cz(), 32);
+        let local = ((view.cz() - rz * 32) * 32 + (view.cx() - rx * 32)) as usize;
+        let data = view.data.clone();
+        let evicted = {
+            let mut shards = self.lock();
+            shards.clock += 1;
+            let clock = shards.clock;
+            let evicted =
+                if shards.open.len() >= self.max_open && !shards.open.contains_key(&(rx, rz)) {
+                    let oldest = shards
+                        .open
+                        .iter()
+                        .min_by_key(|(_, shard)| shard.last_write)
+                        .map(|(key, _)| *key);
+                    oldest.and_then(|key| {
+                        let shard = shards.open.remove(&key)?;
+                        Some((key, shards.take_turn(key), shard))
+                    })
+                } else {
+                    None
+                };
+            let shard = shards.open.entry((rx, rz)).or_insert_with(|| RegionShard {
+                chunks: (0..1024).map(|_| None).collect(),
+                last_write: clock,
+            });
+            shard.last_write = clock;
+            shard.chunks[local] = Some(data);
+            evicted
+        };
+        match evicted {
+            Some((key, turn, shard)) => self.write_shard(key, turn, shard.chunks),
+            None => Ok(()),
+        }
+    }
+
+    /// Write an evicted region once every earlier eviction of it is on disk.
+    fn write_shard(
+        &self,
+        key: (i32, i32),
+        turn: u64,
+        chunks: Vec<Option<ChunkData>>,
+    ) -> Result<()> {
+        {
+            let mut shards = self.lock();
+            while shards
+                .turns
+                .get(&key)
+                .is_some_and(|&(_, serving)| serving != turn)
+            {
+                shards = self.written.wait(shards).unwrap_or_else(|e| e.into_inner());
+            }
+        }
+        let result = write_region(
+            &self.dir,
+            self.options.as_ref(),
+            self.compression,
+            key.0,
+            key.1,
+            chunks,
+        );
+        {
+            let mut shards = self.lock();
+            if let Some((next, serving)) = shards.turns.get_mut(&key) {
+                *serving += 1;
+                if serving == next {
+                    shards.turns.remove(&key);
+                }
+            }
+        }
+        self.written.notify_all();
+        result
+    }
+
+    /// Write every buffered region and `level.dat`. Dropping a sink without
+    /// calling `finish` discards the buffered regions.
+    pub fn finish(self) -> Result<()> {
+        use rayon::prelude::*;
+        let open: Vec<_> = {
+            let mut shards = self.lock();
+            let open = std::mem::take(&mut shards.open);
+            open.into_iter()
+                .map(|(key, shard)| (key, shards.take_turn(key), shard))
+                .collect()
+        };
+        open.into_par_iter()
+            .map(|(key, turn, shard)| self.write_shard(key, turn, shard.chunks))
+            .collect::<Result<Vec<()>>>()?;
+        let opts = self.options.clone().unwrap_or_default();
+        let level_dat = generate_level_dat(&opts)?;
+        std::fs::write(self.dir.join("level.dat"), level_dat)?;
+        Ok(())
+    }
+}
+
+/// A chunk as stored in a region file: big-endian length (counting the
+/// codec byte), codec byte, compressed NBT.
+#[cfg(not(target_arch = "wasm32"))]
+fn chunk_record(compressed: &[u8], codec: CompressionType) -> Vec<u8> {
+    let mut record = Vec::with_capacity(compressed.len() + 5);
+    record.extend_from_slice(&(compressed.len() as u32 + 1).to_be_bytes());
+    record.push(codec as u8);
+    record.extend_from_slice(compressed);
+    record
+}
+
+/// Overwrite chunk records (by local index) in an existing region file. A
+/// record reuses its chunk's sectors when it fits in them and is appended
+/// after the last used sector otherwise. Only the new records and the two
+/// header tables are written.
+#[cfg(not(target_arch = "wasm32"))]
+fn patch_region_file(path: &Path, records: &[(u32, Vec<u8>)]) -> Result<()> {
+    use std::io::Write;
+    const SECTOR: u64 = 4096;
+    let mut file = std::fs::OpenOptions::new()
+        .read(true)
+        .write(true)
+        .open(path)?;
+    let mut header = vec![0u8; 2 * SECTOR as usize];
+    file.read_exact(&mut header)
+        .map_err(|_| "MCA file too small (< 8192 byte header)")?;
+    let entry = |header: &[u8], index: usize| -> (u32, u32) {
+        let o = index * 4;
+        let offset = u32::from_be_bytes([0, header[o], header[o + 1], header[o + 2]]);
+        (offset, header[o + 3] as u32)
+    };
+    let mut end = (0..1024)
+        .map(|i| {
+            let (offset, count) = entry(&header, i);
+            offset + count
+        })
+        .max()
+        .unwrap_or(0)
+        .max(2);
+    let now = std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .map_or(0, |d| d.as_secs() as u32);
+
+    for (index, record) in records {
+        let index = *index as usize;
+        let needed = (record.len() as u64).div_ceil(SECTOR) as u32;
+        if needed > 255 {
+            return Err(
+                format!("chunk record of {} bytes exceeds 255 sectors", record.len()).into(),
+            );
+        }
+        let (old_offset, old_count) = entry(&header, index);
+        let offset = if old_offset >= 2 && needed <= old_count {
+            old_offset
+        } else {
+            end += needed;
+            end - needed
+        };
+        let mut padded = record.clone();
+        padded.resize((needed as u64 * SECTOR) as usize, 0);
+        file.seek(SeekFrom::Start(offset as u64 * SECTOR))?;
+        file.write_all(&padded)?;
+
+        let o = index * 4;
+        header[o..o + 3].copy_from_slice(&offset.to_be_bytes()[1..]);
+        header[o + 3] = needed as u8;
+        let t = SECTOR as usize + o;
+        header[t..t + 4].copy_from_slice(&now.to_be_bytes());
+    }
+    file.seek(SeekFrom::Start(0))?;
+    file.write_all(&header)?;
+    Ok(())
+}
+
+/// Write one region's buffered chunks to `region/r.X.Z.mca` and their
+/// entities to `entities/r.X.Z.mca`, merging with files already there.
+#[cfg(not(target_arch = "wasm32"))]
+fn write_region(
+    dir: &Path,
+    options: Option<&WorldExportOptions>,
+    compression: ChunkCompression,
+    rx: i32,
+    rz: i32,
+    mut buffered_chunks: Vec<Option<ChunkData>>,
+) -> Result<()> {
+    // World-default biome (create-mode sinks only): fill in sections
+    // that carry no biome data. Sections with existing biome data are
+    // never touched; open_existing sinks have no options → pure
+    // passthrough.
+    if let Some(opts) = options {
+        for chunk in buffered_chunks.iter_mut().flatten() {
+            for section in &mut chunk.sections {
+                if section.biomes.is_none() {
+                    section.biomes =
+                        Some(crate::formats::anvil::single_biome_compound(&opts.biome));
+                }
+            }
+        }
+    }
+    // Entities are not part of region chunk NBT (1.17+ layout, same
+    // as world::to_world): split them into entities/r.X.Z.mca.
+    let data_version = buffered_chunks
+        .iter()
+        .flatten()
+        .map(|c| c.data_version)
+        .next()
+        .unwrap_or_else(|| options.cloned().unwrap_or_default().data_version);
+
+    // Read-merge: if the region file already exists, read it and
+    // overlay only the buffered Some(...) slots onto it.  This
+    // preserves chunks written in earlier flushes for the same region
+    // (i.e. out-of-order A → B → A sequences lose nothing).
+    let region_path = dir.join("region").join(format!("r.{}.{}.mca", rx, rz));
+    let final_chunks = if region_path.is_file() {
+        let existing_bytes = std::fs::read(&region_path)?;
+        let mut existing_mca = McaFile::from_bytes(&existing_bytes, rx, rz)?;
+        for (i, slot) in buffered_chunks.into_iter().enumerate() {
+            if slot.is_some() {
+                existing_mca.chunks[i] = slot;
+            }
+        }
+        existing_mca.chunks
+    } else {
+        buffered_chunks
+    };
+
+    let entity_chunks: Vec<EntityChunkData> = final_chunks
+        .iter()
+        .flatten()
+        .filter(|c| !c.entities.is_empty())
+        .map(|c| EntityChunkData {
+            chunk_x: c.x,
+            chunk_z: c.z,
+            entities: c.entities.clone(),
+        })
+        .collect();
+
+    let mca = McaFile {
+        chunks: final_chunks,
+        region_x: rx,
+        region_z: rz,
+    };
+    std::fs::write(&region_path, mca.to_bytes_with(compression)?)?;
+
+    // Read-merge for the entities file as well.
+    let entities_dir = dir.join("entities");
+    let entity_path = entities_dir.join(format!("r.{}.{}.mca", rx, rz));
+    let merged_entity_chunks = if entity_path.is_file() {
+        let existing_bytes = std::fs::read(&entity_path)?;
+        let mut existing: Vec<EntityChunkData> =
+            parse_entity_mca(&existing_bytes, rx, rz).unwrap_or_default();
+        // Buffered entries replace same-position existing entries.
+        for buf_chunk in &entity_chunks {
+            if let Some(pos) = existing
+                .iter()
+                .position(|e| e.chunk_x == buf_chunk.chunk_x && e.chunk_z == buf_chunk.chunk_z)
+            {
+                existing[pos] = buf_chunk.clone();
+            } else {
+                existing.push(buf_chunk.clone());
+            }
+        }
+        existing
+    } else {
+        entity_chunks
+    };
+
+    if !merged_entity_chunks.is_empty() {
+        std::fs::create_dir_all(&entities_dir)?;
+        let bytes =
+            write_entity_mca_with(&merged_entity_chunks, rx, rz, data_version, compression)?;
+        std::fs::write(&entity_path, bytes)?;
+    }
+    Ok(())
+}
+
 /// One differing chunk produced by [`diff_worlds`]: the chunk position plus
 /// the block-level [`crate::diff::Diff`] between the two worlds' copies.
 pub struct ChunkDiff {
@@ -804,73 +1496,163 @@ pub struct ChunkDiff {
     pub diff: crate::diff::Diff,
 }
 
+/// Chunks [`diff_worlds`] decodes and diffs together, in parallel off wasm.
+const DIFF_BATCH: usize = 64;
+
+type RawEntry = (RawChunk, Vec<Entity>);
+
+/// Which front(s) one merge-join step of [`diff_worlds`] consumes.
+#[derive(PartialEq)]
+enum DiffSide {
+    A,
+    B,
+    Both,
+}
+
+/// Order key of a stream front; `Some(None)` is a pending stream error.
+fn front_key(front: &Option<Result<RawEntry>>) -> Option<Option<(i32, i32, i32, i32)>> {
+    front.as_ref().map(|item| {
+        item.as_ref()
+            .ok()
+            .map(|(raw, _)| chunk_order_key(raw.cx, raw.cz))
+    })
+}
+
+/// Diff one matched pair of raw chunks, decoding both. `None` when the
+/// decoded chunks turn out identical.
+fn diff_chunk_pair(
+    a: Option<RawEntry>,
+    b: Option<RawEntry>,
+    spec: &crate::diff::DiffSpec,
+) -> Option<Result<ChunkDiff>> {
+    let (cx, cz) = a
+        .as_ref()
+        .or(b.as_ref())
+        .map(|(raw, _)| (raw.cx, raw.cz))
+        .unwrap();
+    let to_schematic = |entry: Option<RawEntry>| -> Result<UniversalSchematic> {
+        match entry {
+            Some((raw, entities)) => {
+                Ok(decode_view(&raw, entities, &ChunkProjection::default())?.to_schematic())
+            }
+            None => Ok(UniversalSchematic::new("empty".to_string())),
+        }
+    };
+    let (sa, sb) = match (to_schematic(a), to_schematic(b)) {
+        (Ok(sa), Ok(sb)) => (sa, sb),
+        (Err(e), _) | (_, Err(e)) => return Some(Err(e)),
+    };
+    let d = crate::diff::diff_identity(&sa, &sb, spec);
+    if d.distance == 0 {
+        return None; // identical chunk — emit nothing
+    }
+    Some(Ok(ChunkDiff { cx, cz, diff: d }))
+}
+
 /// Lockstep merge-join over two canonically ordered chunk streams.
 /// Chunks present in only one world diff against an empty chunk schematic.
-/// Identical chunks (distance == 0) are skipped. Stream errors from either
-/// side are yielded once as error items; iteration continues afterwards.
+/// Identical chunks (distance == 0) are skipped; chunks whose compressed
+/// records hash equal (and whose entities match) are skipped without being
+/// decoded. The rest are decoded and diffed in batches, in parallel off
+/// wasm, and yielded in stream order. Stream and decode errors are yielded
+/// once as error items; iteration continues afterwards.
 pub fn diff_worlds(
     a: &WorldSource,
     b: &WorldSource,
     preset: &str,
 ) -> Result<impl Iterator<Item = Result<ChunkDiff>>> {
-    let spec = crate::diff::DiffSpec::resolve(preset, &Default::default())
-        .ok_or_else(|| format!("unknown diff preset: {}", preset))?;
-    let mut ia = a.chunks()?.peekable();
-    let mut ib = b.chunks()?.peekable();
-    Ok(std::iter::from_fn(move || {
-        loop {
-            // Propagate stream errors as items (one per call, then continue).
-            if matches!(ia.peek(), Some(Err(_))) {
-                match ia.next() {
-                    Some(Err(e)) => return Some(Err(e)),
-                    _ => unreachable!("peeked Err"),
-                }
-            }
-            if matches!(ib.peek(), Some(Err(_))) {
-                match ib.next() {
-                    Some(Err(e)) => return Some(Err(e)),
-                    _ => unreachable!("peeked Err"),
-                }
-            }
-            // Both fronts are Ok (or exhausted) — the Err guards above just
-            // consumed any error item, so every unwrap below (on peeked keys
-            // and on next()) is on a Some(Ok(_)) front. Keep the guards and
-            // these unwraps in sync if this loop is restructured.
-            let ka = ia
-                .peek()
-                .map(|r| r.as_ref().map(|v| chunk_order_key(v.cx(), v.cz())).unwrap());
-            let kb = ib
-                .peek()
-                .map(|r| r.as_ref().map(|v| chunk_order_key(v.cx(), v.cz())).unwrap());
-            let (va, vb) = match (ka, kb) {
-                (None, None) => return None,
-                (Some(_), None) => (Some(ia.next().unwrap().unwrap()), None),
-                (None, Some(_)) => (None, Some(ib.next().unwrap().unwrap())),
-                (Some(x), Some(y)) if x < y => (Some(ia.next().unwrap().unwrap()), None),
-                (Some(x), Some(y)) if x > y => (None, Some(ib.next().unwrap().unwrap())),
-                (Some(_), Some(_)) => (
-                    Some(ia.next().unwrap().unwrap()),
-                    Some(ib.next().unwrap().unwrap()),
-                ),
+    let spec = resolve_diff_spec(preset)?;
+    Ok(diff_chunk_streams(a.chunks()?, b.chunks()?, spec))
+}
+
+/// Like [`diff_worlds`], but only chunks whose records differ between the
+/// two worlds' indexes are read at all. The indexes must be current (see
+/// [`WorldIndex::update`](crate::formats::world_index::WorldIndex::update)).
+#[cfg(not(target_arch = "wasm32"))]
+pub fn diff_worlds_indexed(
+    a: &WorldSource,
+    a_index: &crate::formats::world_index::WorldIndex,
+    b: &WorldSource,
+    b_index: &crate::formats::world_index::WorldIndex,
+    preset: &str,
+) -> Result<impl Iterator<Item = Result<ChunkDiff>>> {
+    let spec = resolve_diff_spec(preset)?;
+    let positions = a_index.differing(b_index);
+    Ok(diff_chunk_streams(
+        a.chunks_at(&positions)?,
+        b.chunks_at(&positions)?,
+        spec,
+    ))
+}
+
+fn resolve_diff_spec(preset: &str) -> Result<crate::diff::DiffSpec> {
+    crate::diff::DiffSpec::resolve(preset, &Default::default())
+        .ok_or_else(|| format!("unknown diff preset: {}", preset).into())
+}
+
+/// The merge-join behind [`diff_worlds`].
+fn diff_chunk_streams(
+    mut ia: ChunkIter,
+    mut ib: ChunkIter,
+    spec: crate::diff::DiffSpec,
+) -> impl Iterator<Item = Result<ChunkDiff>> {
+    let (mut fa, mut fb) = (ia.next_raw(), ib.next_raw());
+    let mut ready = std::collections::VecDeque::new();
+    std::iter::from_fn(move || loop {
+        if let Some(item) = ready.pop_front() {
+            return Some(item);
+        }
+        let mut batch: Vec<Result<(Option<RawEntry>, Option<RawEntry>)>> = Vec::new();
+        while batch.len() < DIFF_BATCH {
+            let side = match (front_key(&fa), front_key(&fb)) {
+                (None, None) => break,
+                // Stream errors go out as soon as they reach a front.
+                (Some(None), _) | (Some(Some(_)), None) => DiffSide::A,
+                (_, Some(None)) | (None, Some(Some(_))) => DiffSide::B,
+                (Some(Some(x)), Some(Some(y))) => match x.cmp(&y) {
+                    std::cmp::Ordering::Less => DiffSide::A,
+                    std::cmp::Ordering::Greater => DiffSide::B,
+                    std::cmp::Ordering::Equal => DiffSide::Both,
+                },
+            };
+            let ea = if side != DiffSide::B {
+                std::mem::replace(&mut fa, ia.next_raw())
+            } else {
+                None
+            };
+            let eb = if side != DiffSide::A {
+                std::mem::replace(&mut fb, ib.next_raw())
+            } else {
+                None
+            };
+            let pair = match (ea.transpose(), eb.transpose()) {
+                (Ok(ea), Ok(eb)) => Ok((ea, eb)),
+                (Err(e), _) | (_, Err(e)) => Err(e),
             };
-            let (cx, cz) = va
-                .as_ref()
-                .or(vb.as_ref())
-                .map(|v| (v.cx(), v.cz()))
-                .unwrap();
-            let sa = va
-                .map(|v| v.to_schematic())
-                .unwrap_or_else(|| UniversalSchematic::new("empty".to_string()));
-            let sb = vb
-                .map(|v| v.to_schematic())
-                .unwrap_or_else(|| UniversalSchematic::new("empty".to_string()));
-            let d = crate::diff::diff_identity(&sa, &sb, &spec);
-            if d.distance == 0 {
-                continue; // identical chunk — emit nothing
+            if let Ok((Some((ra, ents_a)), Some((rb, ents_b)))) = &pair {
+                if ents_a == ents_b && ra.content_hash() == rb.content_hash() {
+                    continue; // byte-identical record — nothing to decode
+                }
             }
-            return Some(Ok(ChunkDiff { cx, cz, diff: d }));
+            batch.push(pair);
+        }
+        if batch.is_empty() {
+            return None;
         }
-    }))
+
+        let diff_pair = |pair: Result<(Option<RawEntry>, Option<RawEntry>)>| match pair {
+            Ok((ea, eb)) => diff_chunk_pair(ea, eb, &spec),
+            Err(e) => Some(Err(e)),
+        };
+        #[cfg(not(target_arch = "wasm32"))]
+        let diffs: Vec<Option<Result<ChunkDiff>>> = {
+            use rayon::prelude::*;
+            batch.into_par_iter().map(diff_pair).collect()
+        };
+        #[cfg(target_arch = "wasm32")]
+        let diffs: Vec<Option<Result<ChunkDiff>>> = batch.into_iter().map(diff_pair).collect();
+        ready.extend(diffs.into_iter().flatten());
+    })
 }
 
 #[cfg(test)]
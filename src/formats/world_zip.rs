@@ -0,0 +1,359 @@
+//! Streaming zip output for world downloads.
+//!
+//! [`WorldZip`] writes entries to any `Write` as they are added, so a world
+//! export never holds its files and the finished archive at the same time.
+//! Stored entries are written as soon as they arrive. Deflated entries are
+//! queued until [`BATCH_BYTES`] of input is waiting, then deflated together
+//! on the thread pool and written in the order they were added. Only the
+//! central directory (one small record per entry) is kept until
+//! [`WorldZip::finish`].
+//!
+//! The target need not seek: every entry is compressed before its local
+//! header is written, so sizes and CRCs are known up front and no data
+//! descriptors are needed. Zip64 records are written only when an entry or
+//! offset outgrows the 32-bit fields.
+
+use crate::formats::error::Result;
+use flate2::write::DeflateEncoder;
+use flate2::{Compression, Crc};
+use std::io::Write;
+#[cfg(not(target_arch = "wasm32"))]
+use std::path::Path;
+
+/// Queued input bytes that trigger a parallel deflate batch.
+const BATCH_BYTES: usize = 64 << 20;
+
+/// Language-encoding flag: names are UTF-8.
+const FLAG_UTF8: u16 = 0x0800;
+/// 1980-01-01 00:00, the timestamp the `zip` crate writes by default.
+const DOS_TIME: u16 = 0;
+const DOS_DATE: u16 = 0x21;
+
+/// How entries are stored in the archive.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ZipCompression {
+    /// Uncompressed. Region files are already compressed per chunk, so
+    /// this is the default for world downloads.
+    Stored,
+    /// Deflated at the given level, entries in parallel.
+    Deflated(Compression),
+}
+
+impl ZipCompression {
+    fn method(self) -> u16 {
+        match self {
+            ZipCompression::Stored => 0,
+            ZipCompression::Deflated(_) => 8,
+        }
+    }
+}
+
+/// Central directory record of a written entry.
+struct Entry {
+    name: String,
+    method: u16,
+    crc: u32,
+    compressed: u64,
+    size: u64,
+    offset: u64,
+}
+
+/// A zip archive written front to back into `W`.
+pub struct WorldZip<W: Write> {
+    out: W,
+    compression: ZipCompression,
+    /// Bytes written to `out` so far.
+    position: u64,
+    entries: Vec<Entry>,
+    /// Entries waiting to be deflated, and their total size.
+    queued: Vec<(String, Vec<u8>)>,
+    queued_bytes: usize,
+}
+
+impl<W: Write> WorldZip<W> {
+    pub fn new(out: W, compression: ZipCompression) -> Self {
+        WorldZip {
+            out,
+            compression,
+            position: 0,
+            entries: Vec::new(),
+            queued: Vec::new(),
+            queued_bytes: 0,
+        }
+    }
+
+    /// Add a file at `name` (a `/`-separated path). Stored files are
+    /// written before this returns; deflated files may wait for a batch.
+    pub fn add_file(&mut self, name: String, data: Vec<u8>) -> Result<()> {
+        match self.compression {
+            ZipCompression::Stored => {
+                let mut crc = Crc::new();
+                crc.update(&data);
+                self.write_entry(name, crc.sum(), data.len() as u64, &data)
+            }
+            ZipCompression::Deflated(_) => {
+                self.queued_bytes += data.len();
+                self.queued.push((name, data));
+                if self.queued_bytes >= BATCH_BYTES {
+                    self.flush_queue()?;
+                }
+                Ok(())
+            }
+        }
+    }
+
+    /// Write the queued entries, then the central directory, and return the
+    /// target.
+    pub fn finish(mut self) -> Result<W> {
+        self.flush_queue()?;
+        let start = self.position;
+        let mut directory = Vec::new();
+        for entry in &self.entries {
+            central_header(&mut directory, entry);
+        }
+        self.out.write_all(&directory)?;
+        self.position += directory.len() as u64;
+        let mut tail = Vec::new();
+        end_of_directory(&mut tail, self.entries.len() as u64, start, self.position);
+        self.out.write_all(&tail)?;
+        self.out.flush()?;
+        Ok(self.out)
+    }
+
+    fn flush_queue(&mut self) -> Result<()> {
+        let ZipCompression::Deflated(level) = self.compression else {
+            return Ok(());
+        };
+        let queued = std::mem::take(&mut self.queued);
+        self.queued_bytes = 0;
+        let deflate = |(name, data): (String, Vec<u8>)| -> Result<(String, u32, u64, Vec<u8>)> {
+            let mut crc = Crc::new();
+            crc.update(&data);
+            let mut encoder = DeflateEncoder::new(Vec::with_capacity(data.len() / 2), level);
+            encoder.write_all(&data)?;
+            Ok((name, crc.sum(), data.len() as u64, encoder.finish()?))
+        };
+
+        #[cfg(not(target_arch = "wasm32"))]
+        let deflated: Vec<Result<(String, u32, u64, Vec<u8>)>> = {
+            use rayon::prelude::*;
+            queued.into_par_iter().map(deflate).collect()
+        };
+        #[cfg(target_arch = "wasm32")]
+        let deflated: Vec<Result<(String, u32, u64, Vec<u8>)>> =
+            queued.into_iter().map(deflate).collect();
+
+        for entry in deflated {
+            let (name, crc, size, bytes) = entry?;
+            self.write_entry(name, crc, size, &bytes)?;
+        }
+        Ok(())
+    }
+
+    fn write_entry(&mut self, name: String, crc: u32, size: u64, bytes: &[u8]) -> Result<()> {
+        let entry = Entry {
+            name,
+            method: self.compression.method(),
+            crc,
+            compressed: bytes.len() as u64,
+            size,
+            offset: self.position,
+        };
+        let mut header = Vec::with_capacity(30 + entry.name.len() + 20);
+        local_header(&mut header, &entry);
+        self.out.write_all(&header)?;
+        self.out.write_all(bytes)?;
+        self.position += (header.len() + bytes.len()) as u64;
+        self.entries.push(entry);
+        Ok(())
+    }
+}
+
+/// Zip the files of a world directory, such as one a
+/// [`WorldSink`](crate::formats::world_stream::WorldSink) has finished,
+/// under `world_name/`. Files are read one at a time (one batch at a time
+/// when deflating), in path order.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn zip_world_dir<W: Write>(
+    dir: &Path,
+    world_name: &str,
+    out: W,
+    compression: ZipCompression,
+) -> Result<W> {
+    let mut files = Vec::new();
+    collect_files(dir, String::new(), &mut files)?;
+    files.sort();
+    let mut zip = WorldZip::new(out, compression);
+    for relative in files {
+        let data = std::fs::read(dir.join(&relative))?;
+        zip.add_file(format!("{}/{}", world_name, relative), data)?;
+    }
+    zip.finish()
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+fn collect_files(dir: &Path, prefix: String, files: &mut Vec<String>) -> Result<()> {
+    for entry in std::fs::read_dir(dir)? {
+        let entry = entry?;
+        let name = entry.file_name().to_string_lossy().into_owned();
+        let relative = format!("{}{}", prefix, name);
+        if entry.file_type()?.is_dir() {
+            collect_files(&entry.path(), format!("{}/", relative), files)?;
+        } else {
+            files.push(relative);
+        }
+    }
+    Ok(())
+}
+
+fn put16(out: &mut Vec<u8>, v: u16) {
+    out.extend_from_slice(&v.to_le_bytes());
+}
+
+fn put32(out: &mut Vec<u8>, v: u32) {
+    out.extend_from_slice(&v.to_le_bytes());
+}
+
+fn put64(out: &mut Vec<u8>, v: u64) {
+    out.extend_from_slice(&v.to_le_bytes());
+}
+
+/// `v` for a 32-bit field, or the zip64 marker.
+fn field32(v: u64) -> u32 {
+    v.min(u32::MAX as u64) as u32
+}
+
+fn needs_zip64(v: u64) -> bool {
+    v >= u32::MAX as u64
+}
+
+fn local_header(out: &mut Vec<u8>, entry: &Entry) {
+    let zip64 = needs_zip64(entry.size) || needs_zip64(entry.compressed);
+    put32(out, 0x0403_4b50);
+    put16(out, if zip64 { 45 } else { 20 });
+    put16(out, FLAG_UTF8);
+    put16(out, entry.method);
+    put16(out, DOS_TIME);
+    put16(out, DOS_DATE);
+    put32(out, entry.crc);
+    if zip64 {
+        put32(out, u32::MAX);
+        put32(out, u32::MAX);
+    } else {
+        put32(out, entry.compressed as u32);
+        put32(out, entry.size as u32);
+    }
+    put16(out, entry.name.len() as u16);
+    put16(out, if zip64 { 20 } else { 0 });
+    out.extend_from_slice(entry.name.as_bytes());
+    if zip64 {
+        put16(out, 0x0001);
+        put16(out, 16);
+        put64(out, entry.size);
+        put64(out, entry.compressed);
+    }
+}
+
+fn central_header(out: &mut Vec<u8>, entry: &Entry) {
+    // The zip64 extra holds only the fields that overflowed, in this order.
+    let mut extra = Vec::new();
+    for v in [entry.size, entry.compressed, entry.offset] {
+        if needs_zip64(v) {
+            put64(&mut extra, v);
+        }
+    }
+    let zip64 = !extra.is_empty();
+    put32(out, 0x0201_4b50);
+    put16(out, if zip64 { 45 } else { 20 });
+    put16(out, if zip64 { 45 } else { 20 });
+    put16(out, FLAG_UTF8);
+    put16(out, entry.method);
+    put16(out, DOS_TIME);
+    put16(out, DOS_DATE);
+    put32(out, entry.crc);
+    put32(out, field32(entry.compressed));
+    put32(out, field32(entry.size));
+    put16(out, entry.name.len() as u16);
+    put16(out, if zip64 { extra.len() as u16 + 4 } else { 0 });
+    // Comment length, disk number, internal and external attributes.
+    put16(out, 0);
+    put16(out, 0);
+    put16(out, 0);
+    put32(out, 0);
+    put32(out, field32(entry.offset));
+    out.extend_from_slice(entry.name.as_bytes());
+    if zip64 {
+        put16(out, 0x0001);
+        put16(out, extra.len() as u16);
+        out.extend_from_slice(&extra);
+    }
+}
+
+/// The end-of-central-directory record for a directory of `count` entries
+/// spanning `start..end`, preceded by its zip64 form when a field overflows.
+fn end_of_directory(out: &mut Vec<u8>, count: u64, start: u64, end: u64) {
+    let size = end - start;
+    if count >= u16::MAX as u64 || needs_zip64(start) || needs_zip64(size) {
+        put32(out, 0x0606_4b50);
+        put64(out, 44);
+        put16(out, 45);
+        put16(out, 45);
+        put32(out, 0);
+        put32(out, 0);
+        put64(out, count);
+        put64(out, count);
+        put64(out, size);
+        put64(out, start);
+        // Locator: disk 0, record at `end`, one disk.
+        put32(out, 0x0706_4b50);
+        put32(out, 0);
+        put64(out, end);
+        put32(out, 1);
+    }
+    put32(out, 0x0605_4b50);
+    put16(out, 0);
+    put16(out, 0);
+    put16(out, count.min(u16::MAX as u64) as u16);
+    put16(out, count.min(u16::MAX as u64) as u16);
+    put32(out, field32(size));
+    put32(out, field32(start));
+    put16(out, 0);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::{Cursor, Read};
+
+    #[test]
+    fn archives_read_back_with_the_zip_crate() {
+        let files: Vec<(String, Vec<u8>)> = vec![
+            ("w/level.dat".into(), b"level".repeat(100)),
+            (
+                "w/region/r.0.0.mca".into(),
+                (0..50_000u32).map(|i| (i % 251) as u8).collect(),
+            ),
+            ("w/empty".into(), Vec::new()),
+        ];
+        for compression in [
+            ZipCompression::Stored,
+            ZipCompression::Deflated(Compression::fast()),
+        ] {
+            let mut zip = WorldZip::new(Vec::new(), compression);
+            for (name, data) in &files {
+                zip.add_file(name.clone(), data.clone()).unwrap();
+            }
+            let bytes = zip.finish().unwrap();
+
+            let mut archive = zip::ZipArchive::new(Cursor::new(bytes)).unwrap();
+            assert_eq!(archive.len(), files.len());
+            for (i, (name, data)) in files.iter().enumerate() {
+                let mut entry = archive.by_index(i).unwrap();
+                assert_eq!(entry.name(), name);
+                let mut read = Vec::new();
+                entry.read_to_end(&mut read).unwrap();
+                assert_eq!(&read, data);
+            }
+        }
+    }
+}
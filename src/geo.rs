@@ -6,10 +6,21 @@
 //! the blocks. That keeps the schematic engine free of HTTP and lets the same
 //! logic run against any data source.
 
+use std::collections::HashMap;
+
+use rayon::prelude::*;
+
 use crate::block_state::BlockState;
-use crate::building::{PolygonPrism, Shape};
+use crate::building::{PolygonPrism, Shape, Spans};
+#[cfg(not(target_arch = "wasm32"))]
+use crate::formats::world_stream::{WorldChunkView, WorldSink};
 use crate::universal_schematic::UniversalSchematic;
 
+/// Heightmap rows rasterized per rayon task.
+const TILE_ROWS: usize = 16;
+/// Tiles held in memory between write passes, per worker thread.
+const TILES_PER_THREAD: usize = 4;
+
 /// One extrudable footprint: a closed polygon in the X/Z plane, a Y span, and
 /// the block to fill it with.
 pub struct Footprint {
@@ -24,6 +35,9 @@ pub struct Footprint {
 /// (the way `building:part` refinements sit on top of a base outline). When
 /// `base_block` is `Some`, a one-block slab is laid at y=0 across the whole
 /// footprint bounding rectangle first — the ground plane.
+///
+/// Footprint outlines are rasterized into x runs in parallel; each run is then
+/// written as one box through the footprint's whole Y span.
 pub fn extrude_footprints(
     name: &str,
     footprints: &[Footprint],
@@ -31,7 +45,8 @@ pub fn extrude_footprints(
 ) -> UniversalSchematic {
     let mut s = UniversalSchematic::new(name.to_string());
 
-    if let Some(base) = base_block.filter(|b| !b.is_empty()) {
+    let mut base = None;
+    if let Some(block) = base_block.filter(|b| !b.is_empty()) {
         let (mut lo_x, mut lo_z) = (f64::INFINITY, f64::INFINITY);
         let (mut hi_x, mut hi_z) = (f64::NEG_INFINITY, f64::NEG_INFINITY);
         for f in footprints {
@@ -43,31 +58,211 @@ pub fn extrude_footprints(
             }
         }
         if lo_x.is_finite() {
-            let bs = BlockState::new(base);
-            for x in lo_x.floor() as i32..=hi_x.ceil() as i32 {
-                for z in lo_z.floor() as i32..=hi_z.ceil() as i32 {
-                    s.set_block(x, 0, z, &bs);
-                }
-            }
+            let min = (lo_x.floor() as i32, 0, lo_z.floor() as i32);
+            let max = (hi_x.ceil() as i32, 0, hi_z.ceil() as i32);
+            base = Some((min, max, BlockState::new(block)));
         }
     }
 
     let mut order: Vec<usize> = (0..footprints.len()).collect();
     order.sort_by_key(|&i| footprints[i].y_max);
-    for &i in &order {
-        let f = &footprints[i];
-        if f.polygon.len() < 3 {
+    // Per footprint, in fill order: its Y span and the runs of each z row.
+    let stamps: Vec<(i32, i32, Vec<(i32, Spans)>)> = order
+        .par_iter()
+        .map(|&i| {
+            let f = &footprints[i];
+            if f.polygon.len() < 3 {
+                return (0, 0, Vec::new());
+            }
+            let prism = PolygonPrism::new(f.polygon.clone(), f.y_min, f.y_max);
+            let (_, y0, z0, _, y1, z1) = prism.bounds();
+            let rows = (z0..=z1)
+                .map(|z| (z, Spans::of(&prism, y0, z)))
+                .filter(|(_, spans)| !spans.is_empty())
+                .collect();
+            (y0, y1, rows)
+        })
+        .collect();
+
+    let mut bounds: Option<((i32, i32, i32), (i32, i32, i32))> =
+        base.as_ref().map(|(min, max, _)| (*min, *max));
+    for (y0, y1, rows) in &stamps {
+        for (z, spans) in rows {
+            let runs = spans.as_slice();
+            let (x0, x1) = (runs[0].0, runs[runs.len() - 1].1);
+            let (lo, hi) = bounds.get_or_insert(((x0, *y0, *z), (x1 - 1, *y1, *z)));
+            *lo = (lo.0.min(x0), lo.1.min(*y0), lo.2.min(*z));
+            *hi = (hi.0.max(x1 - 1), hi.1.max(*y1), hi.2.max(*z));
+        }
+    }
+    let Some((min, max)) = bounds else {
+        return s;
+    };
+    s.ensure_bounds(min, max);
+
+    let region = &mut s.default_region;
+    if let Some((min, max, block)) = &base {
+        let index = region.get_or_insert_palette_by_state(block);
+        region.fill_uniform(*min, *max, index);
+    }
+    for (&i, (y0, y1, rows)) in order.iter().zip(&stamps) {
+        if rows.is_empty() {
             continue;
         }
-        let bs = BlockState::new(f.block.as_str());
-        let prism = PolygonPrism::new(f.polygon.clone(), f.y_min, f.y_max);
-        prism.for_each_point(|x, y, z| {
-            s.set_block(x, y, z, &bs);
-        });
+        let block = BlockState::new(footprints[i].block.as_str());
+        let index = region.get_or_insert_palette_by_state(&block);
+        for (z, spans) in rows {
+            for (x0, x1) in spans.iter() {
+                region.fill_uniform((x0, *y0, *z), (x1 - 1, *y1, *z), index);
+            }
+        }
     }
     s
 }
 
+/// A heightmap sample that converts to a column height in blocks. Lets the
+/// terrain builders take integer heights or raw floating-point DEM samples
+/// (rounded to the nearest block) without copying the grid.
+pub trait Elevation: Copy + Sync {
+    fn blocks(self) -> i32;
+}
+
+impl Elevation for i32 {
+    fn blocks(self) -> i32 {
+        self
+    }
+}
+
+impl Elevation for f32 {
+    /// Nearest block; NaN (a DEM's no-data) becomes 0.
+    fn blocks(self) -> i32 {
+        self.round() as i32
+    }
+}
+
+/// The columns of a heightmap and the blocks they are made of.
+struct Terrain<'a, H> {
+    heights: &'a [H],
+    width: usize,
+    depth: usize,
+    surface_blocks: &'a [String],
+    subsurface: BlockState,
+    surface_depth: i32,
+}
+
+/// One tile of heightmap rows as blocks: a local palette in the order the
+/// blocks first appear column by column, and the `(x0, x1, id)` runs of every
+/// `(y, z)` row from y = 0 up to the tile's highest column.
+struct TerrainTile {
+    palette: Vec<BlockState>,
+    rows: Vec<(i32, i32, Vec<(i32, i32, u32)>)>,
+}
+
+impl<'a, H: Elevation> Terrain<'a, H> {
+    fn new(
+        heights: &'a [H],
+        width: usize,
+        surface_blocks: &'a [String],
+        subsurface_block: &str,
+        surface_depth: i32,
+    ) -> Option<Self> {
+        if width == 0 || surface_blocks.is_empty() {
+            return None;
+        }
+        Some(Self {
+            heights,
+            width,
+            depth: heights.len() / width,
+            surface_blocks,
+            subsurface: BlockState::new(subsurface_block),
+            surface_depth: surface_depth.max(1),
+        })
+    }
+
+    fn height(&self, idx: usize) -> i32 {
+        self.heights[idx].blocks().max(0)
+    }
+
+    fn surface_name(&self, idx: usize) -> &'a str {
+        self.surface_blocks[idx.min(self.surface_blocks.len() - 1)].as_str()
+    }
+
+    fn max_height(&self) -> i32 {
+        self.heights[..self.width * self.depth]
+            .par_iter()
+            .map(|h| h.blocks().max(0))
+            .max()
+            .unwrap_or(0)
+    }
+
+    /// Rasterize columns `x0..x1` of rows `z0..z1`. The top
+    /// `surface_depth` blocks of a column are its surface block, everything
+    /// below is the subsurface block.
+    fn tile(&self, z0: usize, z1: usize, x0: usize, x1: usize) -> TerrainTile {
+        let mut palette = Vec::new();
+        let mut sub_id = None;
+        let mut surface_ids: HashMap<&str, u32> = HashMap::new();
+        let mut rows = Vec::new();
+        let mut columns: Vec<(i32, u32, u32)> = Vec::with_capacity(x1 - x0);
+        for gz in z0..z1 {
+            columns.clear();
+            for gx in x0..x1 {
+                let idx = gz * self.width + gx;
+                let h = self.height(idx);
+                let sub = if h - self.surface_depth >= 0 {
+                    *sub_id.get_or_insert_with(|| {
+                        palette.push(self.subsurface.clone());
+                        (palette.len() - 1) as u32
+                    })
+                } else {
+                    u32::MAX
+                };
+                let name = self.surface_name(idx);
+                let surf = *surface_ids.entry(name).or_insert_with(|| {
+                    palette.push(BlockState::new(name));
+                    (palette.len() - 1) as u32
+                });
+                columns.push((h, sub, surf));
+            }
+            let top = columns.iter().map(|c| c.0).max().unwrap_or(-1);
+            for y in 0..=top {
+                let mut runs: Vec<(i32, i32, u32)> = Vec::new();
+                for (i, &(h, sub, surf)) in columns.iter().enumerate() {
+                    let id = if y > h {
+                        continue;
+                    } else if y > h - self.surface_depth {
+                        surf
+                    } else {
+                        sub
+                    };
+                    let x = (x0 + i) as i32;
+                    match runs.last_mut() {
+                        Some(run) if run.1 == x && run.2 == id => run.1 = x + 1,
+                        _ => runs.push((x, x + 1, id)),
+                    }
+                }
+                rows.push((y, gz as i32, runs));
+            }
+        }
+        TerrainTile { palette, rows }
+    }
+
+    /// Rasterize every tile in parallel, handing them to `write` in row order
+    /// a batch at a time.
+    fn for_each_tile(&self, mut write: impl FnMut(TerrainTile)) {
+        let batch = TILE_ROWS * TILES_PER_THREAD * rayon::current_num_threads();
+        for start in (0..self.depth).step_by(batch) {
+            let end = (start + batch).min(self.depth);
+            let starts: Vec<usize> = (start..end).step_by(TILE_ROWS).collect();
+            let tiles: Vec<TerrainTile> = starts
+                .par_iter()
+                .map(|&z0| self.tile(z0, (z0 + TILE_ROWS).min(end), 0, self.width))
+                .collect();
+            tiles.into_iter().for_each(&mut write);
+        }
+    }
+}
+
 /// Raise terrain columns from a row-major heightmap of per-column heights
 /// (in blocks), `width` columns per row. Each column rises to its height; the
 /// top `surface_depth` blocks are the column's surface block, everything below
@@ -77,40 +272,110 @@ pub fn extrude_footprints(
 /// one entry per column, row-major and the same length as `heights` — that's
 /// how a heightmap gets painted with elevation/slope bands (snow, scree,
 /// meadow) without any per-voxel callback.
-pub fn heightmap_terrain(
+///
+/// Heights may be integer blocks or raw `f32` elevation samples. Tiles of rows
+/// are rasterized into runs in parallel and written with bulk region fills;
+/// blocks and palette order are the same as placing each column bottom-up.
+pub fn heightmap_terrain<H: Elevation>(
     name: &str,
-    heights: &[i32],
+    heights: &[H],
     width: usize,
     surface_blocks: &[String],
     subsurface_block: &str,
     surface_depth: i32,
 ) -> UniversalSchematic {
     let mut s = UniversalSchematic::new(name.to_string());
-    if width == 0 || surface_blocks.is_empty() {
+    let Some(terrain) = Terrain::new(
+        heights,
+        width,
+        surface_blocks,
+        subsurface_block,
+        surface_depth,
+    ) else {
+        return s;
+    };
+    if terrain.depth == 0 {
         return s;
     }
-    let sub = BlockState::new(subsurface_block);
-    let surface_depth = surface_depth.max(1);
-    let uniform = surface_blocks.len() == 1;
-    let depth = heights.len() / width;
-    for gz in 0..depth {
-        for gx in 0..width {
-            let idx = gz * width + gx;
-            let h = heights[idx].max(0);
-            let surf = if uniform {
-                BlockState::new(surface_blocks[0].as_str())
-            } else {
-                BlockState::new(surface_blocks[idx.min(surface_blocks.len() - 1)].as_str())
-            };
-            for y in 0..=h {
-                let bs = if y > h - surface_depth { &surf } else { &sub };
-                s.set_block(gx as i32, y, gz as i32, bs);
+    s.ensure_bounds(
+        (0, 0, 0),
+        (
+            width as i32 - 1,
+            terrain.max_height(),
+            terrain.depth as i32 - 1,
+        ),
+    );
+    let region = &mut s.default_region;
+    terrain.for_each_tile(|tile| {
+        let resolved: Vec<usize> = tile
+            .palette
+            .iter()
+            .map(|block| region.get_or_insert_palette_by_state(block))
+            .collect();
+        for (y, z, runs) in &tile.rows {
+            for &(x0, x1, id) in runs {
+                region.fill_uniform((x0, *y, *z), (x1 - 1, *y, *z), resolved[id as usize]);
             }
         }
-    }
+    });
     s
 }
 
+/// [`heightmap_terrain`] streamed straight into a world instead of a
+/// schematic: the grid's column (0, 0) lands on block (0, 0), and chunks are
+/// built in parallel a region (32×32 chunks) at a time and written to `sink`
+/// in region order, so memory stays at one region of chunks however large
+/// the grid. The caller still calls [`WorldSink::finish`].
+#[cfg(not(target_arch = "wasm32"))]
+pub fn heightmap_terrain_to_world<H: Elevation>(
+    sink: &mut WorldSink,
+    heights: &[H],
+    width: usize,
+    surface_blocks: &[String],
+    subsurface_block: &str,
+    surface_depth: i32,
+) -> crate::formats::error::Result<()> {
+    let Some(terrain) = Terrain::new(
+        heights,
+        width,
+        surface_blocks,
+        subsurface_block,
+        surface_depth,
+    ) else {
+        return Ok(());
+    };
+    let chunks_x = width.div_ceil(16) as i32;
+    let chunks_z = terrain.depth.div_ceil(16) as i32;
+    for rz in 0..chunks_z.div_ceil(32) {
+        for rx in 0..chunks_x.div_ceil(32) {
+            let chunks: Vec<(i32, i32)> = (rz * 32..(rz * 32 + 32).min(chunks_z))
+                .flat_map(|cz| (rx * 32..(rx * 32 + 32).min(chunks_x)).map(move |cx| (cx, cz)))
+                .collect();
+            let views: Vec<WorldChunkView> = chunks
+                .par_iter()
+                .map(|&(cx, cz)| {
+                    let (x0, z0) = (cx as usize * 16, cz as usize * 16);
+                    let tile =
+                        terrain.tile(z0, (z0 + 16).min(terrain.depth), x0, (x0 + 16).min(width));
+                    let mut view = WorldChunkView::new(cx, cz);
+                    for (y, z, runs) in &tile.rows {
+                        for &(x0, x1, id) in runs {
+                            for x in x0..x1 {
+                                view.set_block(x, *y, *z, &tile.palette[id as usize]);
+                            }
+                        }
+                    }
+                    view
+                })
+                .collect();
+            for view in &views {
+                sink.write_chunk(view)?;
+            }
+        }
+    }
+    Ok(())
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -186,4 +451,95 @@ mod tests {
         assert_eq!(s.get_block(1, 3, 0).unwrap().name, "minecraft:gravel");
         assert_eq!(s.get_block(0, 0, 0).unwrap().name, "minecraft:stone");
     }
+
+    #[test]
+    fn tiled_heightmap_matches_column_by_column_placement() {
+        // Not a multiple of the tile size either way, with a flat pit, bare
+        // surface-only columns and per-column bands.
+        let (width, depth) = (37usize, 41usize);
+        let heights: Vec<f32> = (0..width * depth)
+            .map(|i| {
+                let (x, z) = ((i % width) as f32, (i / width) as f32);
+                if (10.0..14.0).contains(&x) {
+                    -3.0
+                } else {
+                    (x * 0.37).sin() * 6.0 + (z * 0.21).cos() * 5.0 + 6.4
+                }
+            })
+            .collect();
+        let bands = [
+            "minecraft:snow_block",
+            "minecraft:gravel",
+            "minecraft:grass_block",
+        ];
+        let surfaces: Vec<String> = heights
+            .iter()
+            .map(|&h| bands[(h.max(0.0) as usize / 4).min(2)].to_string())
+            .collect();
+
+        let mut expected = UniversalSchematic::new("a".to_string());
+        let stone = BlockState::new("minecraft:stone");
+        for gz in 0..depth {
+            for gx in 0..width {
+                let idx = gz * width + gx;
+                let h = (heights[idx].round() as i32).max(0);
+                let surf = BlockState::new(surfaces[idx].as_str());
+                for y in 0..=h {
+                    let bs = if y > h - 2 { &surf } else { &stone };
+                    expected.set_block(gx as i32, y, gz as i32, bs);
+                }
+            }
+        }
+
+        let s = heightmap_terrain("b", &heights, width, &surfaces, "minecraft:stone", 2);
+        assert_eq!(
+            s.default_region.get_palette(),
+            expected.default_region.get_palette()
+        );
+        assert_eq!(s.total_blocks(), expected.total_blocks());
+        for x in -1..=width as i32 {
+            for z in -1..=depth as i32 {
+                for y in -1..20 {
+                    assert_eq!(s.get_block(x, y, z), expected.get_block(x, y, z));
+                }
+            }
+        }
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn heightmap_streams_into_a_world() {
+        use crate::formats::world_stream::WorldSource;
+
+        // Spans two chunks along x and a partial chunk along z.
+        let (width, depth) = (20usize, 5usize);
+        let heights: Vec<i32> = (0..width * depth)
+            .map(|i| 64 + (i % width) as i32 / 4)
+            .collect();
+        let surface = ["minecraft:grass_block".to_string()];
+
+        let mut dir = std::env::temp_dir();
+        let n = std::time::SystemTime::now()
+            .duration_since(std::time::UNIX_EPOCH)
+            .unwrap()
+            .as_nanos();
+        dir.push(format!("nucleation_geo_terrain_{n}"));
+        let mut sink = WorldSink::create(&dir, None).unwrap();
+        heightmap_terrain_to_world(&mut sink, &heights, width, &surface, "minecraft:stone", 1)
+            .unwrap();
+        sink.finish().unwrap();
+
+        let expected = heightmap_terrain("t", &heights, width, &surface, "minecraft:stone", 1);
+        let mut written = 0;
+        for chunk in WorldSource::open_dir(&dir).unwrap().chunks().unwrap() {
+            for (x, y, z, state) in chunk.unwrap().blocks() {
+                if state.name != "minecraft:air" {
+                    assert_eq!(expected.get_block(x, y, z), Some(state), "at {x},{y},{z}");
+                    written += 1;
+                }
+            }
+        }
+        assert_eq!(written, expected.total_blocks());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
 }
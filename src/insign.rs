@@ -4,7 +4,9 @@ use crate::block_entity::BlockEntity;
 use crate::universal_schematic::UniversalSchematic;
 use insign::{compile, Error as CompileError};
 use serde_json::Value as JsonValue;
-// use std::collections::HashMap;
+use std::borrow::Borrow;
+use std::collections::{HashMap, VecDeque};
+use std::sync::{Arc, Mutex, OnceLock};
 
 /// Sign input for Insign compilation
 #[derive(Debug, Clone)]
@@ -77,18 +79,19 @@ pub fn extract_signs(schematic: &UniversalSchematic) -> Vec<SignInput> {
     // Get all regions and their block entities
     let all_regions = schematic.get_all_regions();
 
+    // Signs sharing a template are recognised and decoded once.
     for region in all_regions.values() {
-        for (pos, block_entity) in region.block_entities.iter() {
-            // Check if this is a sign block entity
+        let found = region.block_entities.filter_map_templates(|block_entity| {
             if block_entity.id.contains("sign") {
-                if let Some(text) = extract_sign_text(block_entity) {
-                    signs.push(SignInput {
-                        pos: [pos.0, pos.1, pos.2],
-                        text,
-                    });
-                }
+                extract_sign_text(block_entity)
+            } else {
+                None
             }
-        }
+        });
+        signs.extend(found.into_iter().map(|(pos, text)| SignInput {
+            pos: [pos.0, pos.1, pos.2],
+            text,
+        }));
     }
 
     // Sort by position for deterministic order (x, y, z)
@@ -114,6 +117,159 @@ pub fn compile_schematic_insign(schematic: &UniversalSchematic) -> Result<JsonVa
     compile_insign(signs)
 }
 
+// ─── Typed regions ──────────────────────────────────────────────────────────
+
+/// One compiled Insign region: its absolute, inclusive boxes and its
+/// metadata. Wildcard and `$global` entries have no boxes.
+#[derive(Debug, Clone, PartialEq)]
+pub struct InsignRegion {
+    pub name: String,
+    pub boxes: Vec<([i32; 3], [i32; 3])>,
+    pub metadata: Vec<(String, JsonValue)>,
+}
+
+/// A metadata value as text: strings unquoted, anything else as JSON.
+pub fn metadata_text(value: &JsonValue) -> String {
+    match value {
+        JsonValue::String(s) => s.clone(),
+        _ => value.to_string(),
+    }
+}
+
+/// The regions of a compiled Insign JSON object, in its key order.
+/// Malformed boxes are skipped and missing coordinates read as 0.
+pub fn regions_from_json(value: &JsonValue) -> Vec<InsignRegion> {
+    let Some(regions) = value.as_object() else {
+        return Vec::new();
+    };
+    let corner = |v: &JsonValue| -> Option<[i32; 3]> {
+        match v.as_array()?.as_slice() {
+            [x, y, z] => Some([x, y, z].map(|c| c.as_i64().unwrap_or(0) as i32)),
+            _ => None,
+        }
+    };
+    regions
+        .iter()
+        .map(|(name, data)| InsignRegion {
+            name: name.clone(),
+            boxes: data
+                .get("bounding_boxes")
+                .and_then(|v| v.as_array())
+                .into_iter()
+                .flatten()
+                .filter_map(|bbox| match bbox.as_array()?.as_slice() {
+                    [min, max, ..] => Some((corner(min)?, corner(max)?)),
+                    _ => None,
+                })
+                .collect(),
+            metadata: data
+                .get("metadata")
+                .and_then(|v| v.as_object())
+                .into_iter()
+                .flatten()
+                .map(|(key, value)| (key.clone(), value.clone()))
+                .collect(),
+        })
+        .collect()
+}
+
+// ─── Region cache ───────────────────────────────────────────────────────────
+//
+// A schematic library compiles many schematics whose signs repeat (copies of
+// one module, re-exports of one build). Compilation depends only on the
+// signs, so the cache is keyed by them: extraction still runs per schematic,
+// but the DSL is compiled once per distinct sign set. Same shape as the
+// typed executor's Insign cache.
+
+/// Distinct sign sets kept by the region cache before the oldest is evicted.
+pub const INSIGN_REGION_CACHE_CAPACITY: usize = 256;
+
+type SignKey = Vec<([i32; 3], String)>;
+
+#[derive(Default)]
+struct RegionCache {
+    entries: HashMap<SignKey, Arc<Vec<InsignRegion>>>,
+    /// Insertion order, for eviction.
+    order: VecDeque<SignKey>,
+}
+
+fn region_cache() -> &'static Mutex<RegionCache> {
+    static CACHE: OnceLock<Mutex<RegionCache>> = OnceLock::new();
+    CACHE.get_or_init(Default::default)
+}
+
+/// Compile a schematic's signs to typed regions through a process-wide
+/// cache keyed by the signs, so identical sign sets compile once.
+pub fn compile_schematic_regions(
+    schematic: &UniversalSchematic,
+) -> Result<Arc<Vec<InsignRegion>>, CompileError> {
+    let key: SignKey = extract_signs(schematic)
+        .into_iter()
+        .map(|s| (s.pos, s.text))
+        .collect();
+    let cached = region_cache()
+        .lock()
+        .unwrap_or_else(|e| e.into_inner())
+        .entries
+        .get(&key)
+        .cloned();
+    if let Some(regions) = cached {
+        return Ok(regions);
+    }
+
+    // Compiled outside the lock; a concurrent miss on the same key compiles
+    // it twice, and the later one returns the first one's result.
+    let compiled = compile(&key)?;
+    let json = serde_json::to_value(compiled).expect("Failed to serialize Insign output");
+    let regions = Arc::new(regions_from_json(&json));
+    let mut cache = region_cache().lock().unwrap_or_else(|e| e.into_inner());
+    if let Some(existing) = cache.entries.get(&key) {
+        return Ok(Arc::clone(existing));
+    }
+    if cache.order.len() >= INSIGN_REGION_CACHE_CAPACITY {
+        if let Some(oldest) = cache.order.pop_front() {
+            cache.entries.remove(&oldest);
+        }
+    }
+    cache.order.push_back(key.clone());
+    cache.entries.insert(key, Arc::clone(&regions));
+    Ok(regions)
+}
+
+/// [`compile_schematic_regions`] for every schematic, in parallel. Results
+/// are in input order; a failed compilation carries its error message.
+pub fn compile_schematics_regions<S: Borrow<UniversalSchematic> + Sync>(
+    schematics: &[S],
+) -> Vec<Result<Arc<Vec<InsignRegion>>, String>> {
+    let compile_one =
+        |schematic: &S| compile_schematic_regions(schematic.borrow()).map_err(|e| e.to_string());
+    #[cfg(not(target_arch = "wasm32"))]
+    {
+        use rayon::prelude::*;
+        schematics.par_iter().map(compile_one).collect()
+    }
+    #[cfg(target_arch = "wasm32")]
+    {
+        schematics.iter().map(compile_one).collect()
+    }
+}
+
+/// Number of sign sets currently in the region cache.
+pub fn region_cache_len() -> usize {
+    region_cache()
+        .lock()
+        .unwrap_or_else(|e| e.into_inner())
+        .entries
+        .len()
+}
+
+/// Drop every entry from the region cache.
+pub fn clear_region_cache() {
+    let mut cache = region_cache().lock().unwrap_or_else(|e| e.into_inner());
+    cache.entries.clear();
+    cache.order.clear();
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -673,4 +829,54 @@ mod tests {
         let error_msg = format!("{}", result.unwrap_err());
         assert!(error_msg.contains("Unknown region") || error_msg.contains("nonexistent"));
     }
+
+    // ====================================================================================
+    // TYPED REGIONS AND BATCH TESTS
+    // ====================================================================================
+
+    fn sign_schematic(text: &str, positions: &[(i32, i32, i32)]) -> UniversalSchematic {
+        let mut schematic = UniversalSchematic::new("Test".to_string());
+        let mut sign = BlockEntity::new("minecraft:sign".to_string(), positions[0]);
+        sign.nbt_mut().insert(
+            "Text1".to_string(),
+            NbtValue::String(format!(r#"{{"text":"{}"}}"#, text)),
+        );
+        // One shared template at every position, as a loader interning
+        // identical signs would store them.
+        schematic
+            .default_region
+            .block_entities
+            .insert_template(positions, std::sync::Arc::new(sign));
+        schematic
+    }
+
+    #[test]
+    fn test_shared_sign_templates_are_extracted_at_every_position() {
+        let schematic = sign_schematic("@a=ac([0,0,0],[1,1,1])", &[(5, 0, 0), (0, 0, 0)]);
+        let signs = extract_signs(&schematic);
+        let positions: Vec<[i32; 3]> = signs.iter().map(|s| s.pos).collect();
+        assert_eq!(positions, vec![[0, 0, 0], [5, 0, 0]]);
+        assert!(signs.iter().all(|s| s.text == "@a=ac([0,0,0],[1,1,1])"));
+    }
+
+    #[test]
+    fn test_batch_compiles_typed_regions_and_caches_sign_sets() {
+        let good = sign_schematic("@cpu=ac([0,0,0],[3,2,1])", &[(0, 64, 0)]);
+        let bad = sign_schematic("@invalid syntax here", &[(0, 64, 0)]);
+        let results = compile_schematics_regions(&[&good, &bad, &good]);
+        assert_eq!(results.len(), 3);
+        assert!(results[1].is_err());
+
+        let regions = results[0].as_ref().unwrap();
+        assert_eq!(
+            **regions,
+            regions_from_json(&compile_schematic_insign(&good).unwrap())
+        );
+        let cpu = regions.iter().find(|r| r.name == "cpu").unwrap();
+        assert_eq!(cpu.boxes, vec![([0, 0, 0], [3, 2, 1])]);
+        // The same signs come back from the cache.
+        let again = compile_schematic_regions(&good).unwrap();
+        assert!(Arc::ptr_eq(&again, results[0].as_ref().unwrap()));
+        assert!(region_cache_len() >= 1);
+    }
 }
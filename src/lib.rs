@@ -8,20 +8,26 @@ pub mod blockpedia;
 pub mod animation;
 pub mod block_entity;
 pub mod block_entity_store;
+pub mod block_storage;
 pub mod block_position;
 mod block_state;
+pub mod block_state_registry;
+pub mod block_string_cache;
 mod bounding_box;
+mod box_index;
 pub mod building;
 mod chunk;
 pub mod dataconverter;
 pub mod definition_region;
 pub mod diff;
 mod entity;
+pub mod entity_store;
 pub mod fingerprint;
 pub mod formats;
 pub mod geo;
 pub mod insign;
 mod item;
+mod memory;
 mod metadata;
 pub mod nbt;
 mod print_utils;
@@ -31,6 +37,7 @@ pub mod sdf;
 pub mod selection;
 pub mod store;
 pub mod store_io;
+pub mod telemetry;
 mod transforms;
 mod universal_schematic;
 pub mod utils;
@@ -77,11 +84,26 @@ mod wasm_entropy {
 #[cfg(target_arch = "wasm32")]
 getrandom::register_custom_getrandom!(wasm_entropy::getrandom_fallback);
 
+// Opt-in global allocators for the built library (see the `mimalloc` / `jemalloc`
+// features). wasm32 keeps its default allocator; jemalloc does not build on MSVC.
+#[cfg(all(feature = "mimalloc", not(target_arch = "wasm32")))]
+#[global_allocator]
+static GLOBAL: mimalloc::MiMalloc = mimalloc::MiMalloc;
+#[cfg(all(
+    feature = "jemalloc",
+    not(feature = "mimalloc"),
+    not(target_arch = "wasm32"),
+    not(target_env = "msvc")
+))]
+#[global_allocator]
+static GLOBAL: tikv_jemallocator::Jemalloc = tikv_jemallocator::Jemalloc;
+
 // Public re-exports
 pub use block_state::BlockState;
 pub use bounding_box::BoundingBox;
 pub use entity::{ArmorStandEquipment, Entity};
 pub use formats::{litematic, schematic, world_stream};
+pub use memory::{MemoryUsage, RegionMemory};
 #[cfg(not(target_arch = "wasm32"))]
 pub use formats::world_pack;
 pub use print_utils::{format_json_schematic, format_schematic};
@@ -94,4 +116,4 @@ pub use selection::{
     Connectivity, Continue, Limits, Mask, NotAirMask, NotMask, OrMask, StopReason, VisitedSet,
 };
 pub use store::{MemStore, Store, StoreError};
-pub use universal_schematic::UniversalSchematic;
+pub use universal_schematic::{SchematicCacheStats, UniversalSchematic};
@@ -0,0 +1,85 @@
+//! Heap accounting for schematics.
+//!
+//! Figures are estimates of what each part holds on the heap, in the same
+//! terms as [`BlockStorage::heap_bytes`](crate::block_storage::BlockStorage::heap_bytes):
+//! live elements times their size, excluding spare capacity and allocator
+//! overhead. Hash tables count one entry plus one control byte per element.
+//! Data shared through an `Arc` is counted once by the structure that owns
+//! it, so figures for a region and its clone overlap.
+
+use serde::Serialize;
+use smol_str::SmolStr;
+use std::collections::HashMap;
+use std::mem::size_of;
+
+/// Longest string a `SmolStr` stores inline.
+const SMOL_STR_INLINE: usize = 23;
+
+/// Heap bytes for the elements of a vector.
+#[inline]
+pub(crate) fn vec_bytes<T>(v: &[T]) -> usize {
+    std::mem::size_of_val(v)
+}
+
+/// Heap bytes for the entry table of a hash map, excluding heap data owned
+/// by its keys and values.
+#[inline]
+pub(crate) fn table_bytes<K, V, S>(map: &HashMap<K, V, S>) -> usize {
+    map.len() * (size_of::<(K, V)>() + 1)
+}
+
+/// Heap bytes for an `Arc<T>` allocation, excluding heap data owned by `T`.
+#[inline]
+pub(crate) fn arc_bytes<T>() -> usize {
+    2 * size_of::<usize>() + size_of::<T>()
+}
+
+/// Heap bytes for a `SmolStr`: zero when inline, otherwise the shared
+/// `Arc<str>` allocation (two counters plus the bytes).
+#[inline]
+pub(crate) fn smol_str_bytes(s: &SmolStr) -> usize {
+    if s.len() > SMOL_STR_INLINE {
+        2 * size_of::<usize>() + s.len()
+    } else {
+        0
+    }
+}
+
+/// Heap usage of one [`Region`](crate::Region), in bytes.
+#[derive(Debug, Clone, Default, PartialEq, Eq, Serialize)]
+pub struct RegionMemory {
+    pub name: String,
+    /// Palette indices of every cell, including sparse sections.
+    pub blocks: usize,
+    /// Palette entries and their reverse lookup tables.
+    pub palette: usize,
+    pub block_entities: usize,
+    pub entities: usize,
+    /// Name, per-section counts and other bookkeeping.
+    pub other: usize,
+}
+
+impl RegionMemory {
+    pub fn total(&self) -> usize {
+        self.blocks + self.palette + self.block_entities + self.entities + self.other
+    }
+}
+
+/// Heap usage of a [`UniversalSchematic`](crate::UniversalSchematic), in
+/// bytes, split by component and by region.
+#[derive(Debug, Clone, Default, PartialEq, Eq, Serialize)]
+pub struct MemoryUsage {
+    pub total: usize,
+    pub block_arrays: usize,
+    pub palettes: usize,
+    pub block_entities: usize,
+    pub entities: usize,
+    pub definition_regions: usize,
+    /// Plain-id cache used by `set_block_str`. The parse cache behind
+    /// `set_block_from_string` is process-wide and not counted here.
+    pub block_state_cache: usize,
+    /// Metadata, region names and region bookkeeping.
+    pub other: usize,
+    /// Default region first, then the others by name.
+    pub regions: Vec<RegionMemory>,
+}
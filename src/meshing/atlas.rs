@@ -0,0 +1,327 @@
+//! [`PackAtlas`]: a shared texture atlas built once per resource pack,
+//! persisted as a blob next to `.nucm` caches, and extended as new block
+//! states appear, instead of being rebuilt from a schematic per request.
+//!
+//! [`PackAtlas::build`] covers one state per variant key and per multipart
+//! case of every blockstate file in the pack, plus each block's default
+//! state. States outside that (an unusual multipart combination, say) are
+//! added by [`PackAtlas::extend`], which discovers only their textures and
+//! repacks the atlas only if one is new. A repack moves every region, so
+//! meshes made against the old atlas must be remeshed; `extend` says when.
+//!
+//! Blob layout (little-endian):
+//!
+//! ```text
+//! magic "NUCA" | version u32 = 1 | atlas_max_size u32
+//! | pack_id (u32 len + UTF-8)
+//! | texture_count u32, each (u32 len + UTF-8)      sorted, as packed
+//! | state_count u32, each name (u32 len + UTF-8),
+//!       property_count u32, each key and value (u32 len + UTF-8)
+//! | atlas (the .nucm atlas layout)
+//! ```
+
+use std::collections::{BTreeSet, HashSet};
+use std::io::{Cursor, Write};
+use std::path::Path;
+
+use schematic_mesher::TextureAtlas;
+
+use super::cache::{
+    read_atlas, read_bytes, read_str, read_u32, write_atlas, write_bytes, write_str, write_u32,
+    CacheError,
+};
+use super::{
+    build_atlas_from_textures, discover_state_textures, MeshConfig, ResourcePackSource, Result,
+};
+use crate::{BlockState, UniversalSchematic};
+
+const MAGIC: &[u8; 4] = b"NUCA";
+const VERSION: u32 = 1;
+
+/// A texture atlas for a resource pack, with the textures and block states
+/// it covers.
+#[derive(Clone)]
+pub struct PackAtlas {
+    pack_id: String,
+    config: MeshConfig,
+    atlas: TextureAtlas,
+    /// Every texture in the atlas, in packing order.
+    textures: BTreeSet<String>,
+    /// Non-air states whose textures are all in the atlas.
+    states: HashSet<BlockState>,
+}
+
+impl PackAtlas {
+    /// Build the atlas for every blockstate in `pack`. `pack_id` names the
+    /// pack's content (see [`ResourcePackSource::fingerprint`]) and is kept
+    /// with the blob so a stale one can be told apart.
+    pub fn build(
+        pack: &ResourcePackSource,
+        config: &MeshConfig,
+        pack_id: impl Into<String>,
+    ) -> Result<Self> {
+        let mut atlas = Self::empty(config, pack_id);
+        atlas.extend(pack_states(pack).iter(), pack)?;
+        Ok(atlas)
+    }
+
+    /// An atlas covering nothing yet.
+    pub fn empty(config: &MeshConfig, pack_id: impl Into<String>) -> Self {
+        PackAtlas {
+            pack_id: pack_id.into(),
+            config: config.clone(),
+            atlas: TextureAtlas::empty(),
+            textures: BTreeSet::new(),
+            states: HashSet::new(),
+        }
+    }
+
+    /// Cover `states` as well. Returns whether the atlas was repacked: only
+    /// then do meshes made against it need remeshing.
+    pub fn extend<'s>(
+        &mut self,
+        states: impl IntoIterator<Item = &'s BlockState>,
+        pack: &ResourcePackSource,
+    ) -> Result<bool> {
+        let unseen: HashSet<&BlockState> = states
+            .into_iter()
+            .filter(|state| state.name != "minecraft:air" && !self.states.contains(*state))
+            .collect();
+        if unseen.is_empty() {
+            return Ok(false);
+        }
+        let before = self.textures.len();
+        self.textures.extend(discover_state_textures(
+            unseen.iter().copied(),
+            pack,
+            &self.config,
+        ));
+        let repacked = self.textures.len() != before;
+        if repacked {
+            self.atlas = build_atlas_from_textures(&self.textures, pack, &self.config)?;
+        }
+        self.states.extend(unseen.into_iter().cloned());
+        Ok(repacked)
+    }
+
+    /// [`Self::extend`] with every palette state of `schematic`.
+    pub fn extend_for_schematic(
+        &mut self,
+        schematic: &UniversalSchematic,
+        pack: &ResourcePackSource,
+    ) -> Result<bool> {
+        let palettes = std::iter::once(&schematic.default_region)
+            .chain(schematic.other_regions.values())
+            .flat_map(|region| region.palette.iter());
+        self.extend(palettes, pack)
+    }
+
+    /// Whether `state`'s textures are known to be in the atlas.
+    pub fn covers(&self, state: &BlockState) -> bool {
+        state.name == "minecraft:air" || self.states.contains(state)
+    }
+
+    pub fn atlas(&self) -> &TextureAtlas {
+        &self.atlas
+    }
+
+    /// The config textures are discovered and packed with.
+    pub fn config(&self) -> &MeshConfig {
+        &self.config
+    }
+
+    pub fn pack_id(&self) -> &str {
+        &self.pack_id
+    }
+
+    /// Number of covered states.
+    pub fn state_count(&self) -> usize {
+        self.states.len()
+    }
+
+    /// The atlas and what it covers as a blob.
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut buf = Vec::new();
+        self.write(&mut buf)
+            .expect("writing to Vec<u8> should not fail");
+        buf
+    }
+
+    fn write(&self, w: &mut impl Write) -> std::result::Result<(), CacheError> {
+        write_bytes(w, MAGIC)?;
+        write_u32(w, VERSION)?;
+        write_u32(w, self.config.atlas_max_size)?;
+        write_str(w, &self.pack_id)?;
+        write_u32(w, self.textures.len() as u32)?;
+        for texture in &self.textures {
+            write_str(w, texture)?;
+        }
+        // Sorted, so one atlas always writes the same bytes.
+        let mut states: Vec<&BlockState> = self.states.iter().collect();
+        states.sort_by_cached_key(|state| state.to_string());
+        write_u32(w, states.len() as u32)?;
+        for state in states {
+            write_str(w, &state.name)?;
+            write_u32(w, state.properties.len() as u32)?;
+            for (key, value) in &state.properties {
+                write_str(w, key)?;
+                write_str(w, value)?;
+            }
+        }
+        write_atlas(w, &self.atlas)
+    }
+
+    /// Read a blob from [`Self::to_bytes`]. `config` is used for later
+    /// extension; its atlas size replaces the one stored.
+    pub fn from_bytes(data: &[u8], config: &MeshConfig) -> std::result::Result<Self, CacheError> {
+        let mut r = Cursor::new(data);
+        if read_bytes(&mut r, 4)? != MAGIC {
+            return Err(CacheError::InvalidMagic);
+        }
+        let version = read_u32(&mut r)?;
+        if version != VERSION {
+            return Err(CacheError::UnsupportedVersion(version));
+        }
+        let _atlas_max_size = read_u32(&mut r)?;
+        let pack_id = read_str(&mut r)?;
+        let textures = (0..read_u32(&mut r)?)
+            .map(|_| read_str(&mut r))
+            .collect::<std::result::Result<BTreeSet<_>, _>>()?;
+        let mut states = HashSet::new();
+        for _ in 0..read_u32(&mut r)? {
+            let mut state = BlockState::new(read_str(&mut r)?);
+            for _ in 0..read_u32(&mut r)? {
+                let key = read_str(&mut r)?;
+                let value = read_str(&mut r)?;
+                state.properties.push((key.into(), value.into()));
+            }
+            states.insert(state);
+        }
+        let atlas = read_atlas(&mut r)?;
+        Ok(PackAtlas {
+            pack_id,
+            config: config.clone(),
+            atlas,
+            textures,
+            states,
+        })
+    }
+
+    pub fn save(&self, path: &Path) -> std::result::Result<(), CacheError> {
+        std::fs::write(path, self.to_bytes())?;
+        Ok(())
+    }
+
+    pub fn load(path: &Path, config: &MeshConfig) -> std::result::Result<Self, CacheError> {
+        Self::from_bytes(&std::fs::read(path)?, config)
+    }
+}
+
+/// One state per variant key and per multipart case of every blockstate in
+/// `pack`, plus each block's default state.
+fn pack_states(pack: &ResourcePackSource) -> Vec<BlockState> {
+    let mut states = Vec::new();
+    for name in pack.list_blockstates() {
+        states.push(BlockState::new(name.clone()));
+        let Some(json) = pack.get_blockstate_json(&name) else {
+            continue;
+        };
+        let Ok(def) = serde_json::from_str::<serde_json::Value>(&json) else {
+            continue;
+        };
+        if let Some(variants) = def["variants"].as_object() {
+            for key in variants.keys().filter(|key| !key.is_empty()) {
+                let mut state = BlockState::new(name.clone());
+                for pair in key.split(',') {
+                    if let Some((k, v)) = pair.split_once('=') {
+                        state.properties.push((k.into(), v.into()));
+                    }
+                }
+                states.push(state);
+            }
+        }
+        for case in def["multipart"].as_array().into_iter().flatten() {
+            // `OR` takes its first alternative, and `a|b` its first value:
+            // enough to reach the case's model.
+            let when = match case["when"].get("OR").and_then(|or| or.get(0)) {
+                Some(first) => first,
+                None => &case["when"],
+            };
+            let Some(conditions) = when.as_object() else {
+                continue;
+            };
+            let mut state = BlockState::new(name.clone());
+            for (k, v) in conditions {
+                if let Some(v) = v.as_str() {
+                    let first = v.split('|').next().unwrap_or(v);
+                    state.properties.push((k.as_str().into(), first.into()));
+                }
+            }
+            states.push(state);
+        }
+    }
+    states.sort_by_cached_key(|state| state.to_string());
+    states.dedup();
+    states
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use schematic_mesher::ResourcePack;
+
+    fn pack() -> ResourcePackSource {
+        let mut pack = ResourcePackSource::from_resource_pack(ResourcePack::new());
+        pack.add_blockstate_json(
+            "minecraft:lever",
+            r#"{"variants":{"face=floor,powered=false":{"model":"block/lever"},
+                "face=wall,powered=true":{"model":"block/lever_on"}}}"#,
+        )
+        .unwrap();
+        pack
+    }
+
+    #[test]
+    fn pack_states_follow_variant_keys() {
+        let names: Vec<String> = pack_states(&pack())
+            .iter()
+            .map(ToString::to_string)
+            .collect();
+        assert_eq!(
+            names,
+            [
+                "minecraft:lever",
+                "minecraft:lever[face=floor,powered=false]",
+                "minecraft:lever[face=wall,powered=true]",
+            ]
+        );
+    }
+
+    #[test]
+    fn extension_skips_covered_states_and_blobs_roundtrip() {
+        let pack = pack();
+        let config = MeshConfig::default();
+        let mut atlas = PackAtlas::build(&pack, &config, "lever-pack").unwrap();
+        assert_eq!(atlas.state_count(), 3);
+        let lever = BlockState::new("minecraft:lever".to_string());
+        assert!(atlas.covers(&lever));
+        assert!(!atlas.extend([&lever], &pack).unwrap());
+
+        let stone = BlockState::new("minecraft:stone".to_string());
+        assert!(!atlas.covers(&stone));
+        atlas.extend([&stone], &pack).unwrap();
+        assert!(atlas.covers(&stone));
+
+        let blob = atlas.to_bytes();
+        let loaded = PackAtlas::from_bytes(&blob, &config).unwrap();
+        assert_eq!(loaded.pack_id(), "lever-pack");
+        assert_eq!(loaded.state_count(), 4);
+        assert!(loaded.covers(&stone));
+        assert_eq!(loaded.atlas().pixels, atlas.atlas().pixels);
+        assert_eq!(loaded.to_bytes(), blob);
+        assert!(matches!(
+            PackAtlas::from_bytes(b"NUCM", &config),
+            Err(CacheError::InvalidMagic)
+        ));
+    }
+}
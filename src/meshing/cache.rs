@@ -23,6 +23,13 @@
 //! this allows fast loading. Atlas pixels are deflate-compressed via `flate2`
 //! since RGBA image data compresses ~3-4x.
 //!
+//! Version 3 ([`serialize_meshes_v3`], read with [`MeshCache`]) adds a chunk
+//! directory after the header, so single chunks can be found by coordinate
+//! and level of detail and decoded alone. Its vertex arrays are full-precision
+//! and 16-byte aligned, so a mapped file can be uploaded without copying.
+//! Bodies may be LZ4-compressed per chunk instead, and vertices may be stored
+//! in the 20-byte [`super::compact`] form, which stays aligned and in place.
+//!
 //! # Example
 //!
 //! ```ignore
@@ -44,6 +51,8 @@ use schematic_mesher::{BoundingBox, MeshLayer, MeshOutput, TextureAtlas};
 use std::collections::HashMap;
 use std::io::{self, Cursor, Read, Write};
 
+use super::compact::{CompactLayer, PositionQuantization, VertexFormat};
+
 const MAGIC: &[u8; 4] = b"NUCM";
 const FORMAT_VERSION: u32 = 2;
 
@@ -71,8 +80,8 @@ impl std::fmt::Display for CacheError {
             CacheError::UnsupportedVersion(v) => {
                 write!(
                     f,
-                    "unsupported cache version: {} (expected {})",
-                    v, FORMAT_VERSION
+                    "unsupported cache version: {} (expected at most {})",
+                    v, V3_VERSION
                 )
             }
             CacheError::InvalidData(msg) => write!(f, "invalid cache data: {}", msg),
@@ -103,10 +112,15 @@ impl From<io::Error> for CacheError {
 /// [`serialize_meshes_with_atlas`].
 pub fn serialize_meshes(meshes: &[MeshOutput]) -> Vec<u8> {
     let mut buf = Vec::new();
-    write_meshes_v2(&mut buf, meshes, None).expect("writing to Vec<u8> should not fail");
+    serialize_meshes_into(&mut buf, meshes);
     buf
 }
 
+/// [`serialize_meshes`], appending to `buf` so its capacity can be reused.
+pub fn serialize_meshes_into(buf: &mut Vec<u8>, meshes: &[MeshOutput]) {
+    write_meshes_v2(buf, meshes, None).expect("writing to Vec<u8> should not fail");
+}
+
 /// Serialize meshes with a shared global atlas (NUCM v2 with `has_shared_atlas` flag).
 ///
 /// The shared atlas is stored once in the header. Per-chunk atlas data is omitted
@@ -120,8 +134,12 @@ pub fn serialize_meshes_with_atlas(meshes: &[MeshOutput], atlas: &TextureAtlas)
 
 /// Deserialize a slice of bytes (`.nucm` format) back into `Vec<MeshOutput>`.
 ///
-/// Handles both v1 and v2 formats automatically.
+/// Handles v1, v2 and v3 formats automatically. For reading only some chunks
+/// of a v3 file, use [`MeshCache`].
 pub fn deserialize_meshes(data: &[u8]) -> Result<Vec<MeshOutput>, CacheError> {
+    if data.len() >= 8 && &data[0..4] == MAGIC && u32_at(data, 4) == V3_VERSION {
+        return MeshCache::parse(data)?.chunks();
+    }
     let mut cursor = Cursor::new(data);
     read_meshes_auto(&mut cursor)
 }
@@ -144,7 +162,7 @@ pub fn save_cached_mesh_with_atlas(
     Ok(())
 }
 
-/// Load meshes from a `.nucm` cache file (handles v1 and v2 automatically).
+/// Load meshes from a `.nucm` cache file (handles v1, v2 and v3 automatically).
 pub fn load_cached_mesh(path: &std::path::Path) -> Result<Vec<MeshOutput>, CacheError> {
     let data = std::fs::read(path)?;
     deserialize_meshes(&data)
@@ -152,11 +170,11 @@ pub fn load_cached_mesh(path: &std::path::Path) -> Result<Vec<MeshOutput>, Cache
 
 // ─── Wire helpers ───────────────────────────────────────────────────────────
 
-fn write_u8(w: &mut impl Write, v: u8) -> io::Result<()> {
+pub(super) fn write_u8(w: &mut impl Write, v: u8) -> io::Result<()> {
     w.write_all(&[v])
 }
 
-fn write_u32(w: &mut impl Write, v: u32) -> io::Result<()> {
+pub(super) fn write_u32(w: &mut impl Write, v: u32) -> io::Result<()> {
     w.write_all(&v.to_le_bytes())
 }
 
@@ -168,17 +186,23 @@ fn write_f32(w: &mut impl Write, v: f32) -> io::Result<()> {
     w.write_all(&v.to_le_bytes())
 }
 
-fn write_bytes(w: &mut impl Write, data: &[u8]) -> io::Result<()> {
+pub(super) fn write_bytes(w: &mut impl Write, data: &[u8]) -> io::Result<()> {
     w.write_all(data)
 }
 
-fn read_u8(r: &mut impl Read) -> Result<u8, CacheError> {
+/// A u32 length, then UTF-8.
+pub(super) fn write_str(w: &mut impl Write, s: &str) -> io::Result<()> {
+    write_u32(w, s.len() as u32)?;
+    write_bytes(w, s.as_bytes())
+}
+
+pub(super) fn read_u8(r: &mut impl Read) -> Result<u8, CacheError> {
     let mut buf = [0u8; 1];
     r.read_exact(&mut buf)?;
     Ok(buf[0])
 }
 
-fn read_u32(r: &mut impl Read) -> Result<u32, CacheError> {
+pub(super) fn read_u32(r: &mut impl Read) -> Result<u32, CacheError> {
     let mut buf = [0u8; 4];
     r.read_exact(&mut buf)?;
     Ok(u32::from_le_bytes(buf))
@@ -196,12 +220,18 @@ fn read_f32(r: &mut impl Read) -> Result<f32, CacheError> {
     Ok(f32::from_le_bytes(buf))
 }
 
-fn read_bytes(r: &mut impl Read, len: usize) -> Result<Vec<u8>, CacheError> {
+pub(super) fn read_bytes(r: &mut impl Read, len: usize) -> Result<Vec<u8>, CacheError> {
     let mut buf = vec![0u8; len];
     r.read_exact(&mut buf)?;
     Ok(buf)
 }
 
+pub(super) fn read_str(r: &mut impl Read) -> Result<String, CacheError> {
+    let len = read_u32(r)? as usize;
+    String::from_utf8(read_bytes(r, len)?)
+        .map_err(|e| CacheError::InvalidData(format!("invalid string: {e}")))
+}
+
 // ─── Top-level serialize / deserialize ──────────────────────────────────────
 
 /// Write v2 format. If `shared_atlas` is Some, stores atlas once in header.
@@ -723,7 +753,7 @@ fn read_layer(r: &mut impl Read) -> Result<MeshLayer, CacheError> {
 
 // ─── TextureAtlas ───────────────────────────────────────────────────────────
 
-fn write_atlas(w: &mut impl Write, atlas: &TextureAtlas) -> Result<(), CacheError> {
+pub(super) fn write_atlas(w: &mut impl Write, atlas: &TextureAtlas) -> Result<(), CacheError> {
     write_u32(w, atlas.width)?;
     write_u32(w, atlas.height)?;
 
@@ -751,7 +781,7 @@ fn write_atlas(w: &mut impl Write, atlas: &TextureAtlas) -> Result<(), CacheErro
     Ok(())
 }
 
-fn read_atlas(r: &mut impl Read) -> Result<TextureAtlas, CacheError> {
+pub(super) fn read_atlas(r: &mut impl Read) -> Result<TextureAtlas, CacheError> {
     let width = read_u32(r)?;
     let height = read_u32(r)?;
 
@@ -877,6 +907,582 @@ fn read_animated_texture(r: &mut impl Read) -> Result<AnimatedTextureExport, Cac
     })
 }
 
+// ─── v3: chunk directory, random access ─────────────────────────────────────
+//
+// ```text
+// Header (32 bytes):
+//   magic "NUCM" | version u32 = 3 | flags u32 | chunk_count u32
+//   | atlas_offset u64 | atlas_len u64      (shared atlas, 0/0 if none)
+// Directory (chunk_count × 64 bytes, at offset 32):
+//   cx, cy, cz i32 | lod u8 | codec u8 | has_coord u8 | vertex_format u8
+//   | bounds min, max f32×3 | offset u64 | len u64 | raw_len u64
+// Shared atlas (write_atlas layout), then each chunk body, all 16-aligned.
+// ```
+//
+// A chunk body starts with a 48-byte header: vertex and index counts of the
+// three layers (u32×6), atlas_mode u32 (0 = shared, 1 = own), atlas_len u32,
+// anim_len u32 and a reserved u32. The layers follow as raw little-endian
+// arrays, each padded to 16 bytes: positions f32×3, normals f32×3, uvs f32×2,
+// colors f32×4, indices u32. With vertex_format 1 (compact) the header is
+// followed by the position quantization (origin f32×3, steps per block f32)
+// and the arrays are positions u16×4, normals i8×4, uvs u16×2, colors u8×4,
+// indices u32; see `super::compact`. The chunk's own atlas and its animated textures
+// come last. Uncompressed bodies (codec 0) can be mapped and uploaded as is;
+// codec 1 bodies are one LZ4 block of the same layout.
+
+const V3_VERSION: u32 = 3;
+const V3_HEADER_LEN: usize = 32;
+const V3_ENTRY_LEN: usize = 64;
+const V3_BODY_HEADER_LEN: usize = 48;
+const V3_ALIGN: usize = 16;
+/// Origin and steps per block after the header of a compact body.
+const V3_QUANTIZATION_LEN: usize = 16;
+
+const CODEC_RAW: u8 = 0;
+const CODEC_LZ4: u8 = 1;
+
+/// Options for [`serialize_meshes_v3`].
+#[derive(Debug, Clone, Copy, Default)]
+pub struct V3Options<'a> {
+    /// Store this atlas once, and write every chunk against it.
+    pub shared_atlas: Option<&'a TextureAtlas>,
+    /// LZ4-compress each chunk body. Smaller, but chunks can no longer be
+    /// read in place through [`MeshCache::raw_layers`].
+    pub compress: bool,
+    /// Store vertices as `f32` or in the compact quantized form.
+    pub vertex_format: VertexFormat,
+}
+
+/// One chunk's directory entry in a v3 cache.
+#[derive(Debug, Clone)]
+pub struct ChunkEntry {
+    pub chunk_coord: Option<(i32, i32, i32)>,
+    pub lod_level: u8,
+    pub bounds: BoundingBox,
+    /// Whether the body is LZ4-compressed.
+    pub compressed: bool,
+    /// Layout of the body's vertex arrays.
+    pub vertex_format: VertexFormat,
+    /// Byte range of the body in the file.
+    pub offset: u64,
+    pub len: u64,
+    raw_len: u64,
+}
+
+/// The raw little-endian arrays of one layer, borrowed from the cache bytes.
+/// Per-vertex sizes are for [`VertexFormat::Float`], then
+/// [`VertexFormat::Compact`].
+#[derive(Debug, Clone, Copy)]
+pub struct RawLayer<'a> {
+    /// `f32×3` or `u16×4` per vertex.
+    pub positions: &'a [u8],
+    /// `f32×3` or `i8×4` per vertex.
+    pub normals: &'a [u8],
+    /// `f32×2` or `u16×2` per vertex.
+    pub uvs: &'a [u8],
+    /// `f32×4` or `u8×4` per vertex.
+    pub colors: &'a [u8],
+    /// `u32` per index.
+    pub indices: &'a [u8],
+}
+
+/// Bytes behind a [`MeshCache`]: owned, or a read-only file mapping.
+pub enum CacheBytes {
+    Owned(Vec<u8>),
+    #[cfg(not(target_arch = "wasm32"))]
+    Mapped(memmap2::Mmap),
+}
+
+impl AsRef<[u8]> for CacheBytes {
+    fn as_ref(&self) -> &[u8] {
+        match self {
+            CacheBytes::Owned(bytes) => bytes.as_slice(),
+            #[cfg(not(target_arch = "wasm32"))]
+            CacheBytes::Mapped(map) => &map[..],
+        }
+    }
+}
+
+/// A v3 cache with only its header and directory parsed. Chunks are decoded
+/// on request, so a viewer reads just the ones it shows.
+pub struct MeshCache<B: AsRef<[u8]> = CacheBytes> {
+    bytes: B,
+    entries: Vec<ChunkEntry>,
+    shared_atlas: Option<TextureAtlas>,
+}
+
+impl MeshCache {
+    /// Open a v3 `.nucm` file and parse its directory. The file is mapped
+    /// read-only (read into memory on wasm, which has no mapping).
+    pub fn open(path: impl AsRef<std::path::Path>) -> Result<MeshCache, CacheError> {
+        #[cfg(not(target_arch = "wasm32"))]
+        let bytes = {
+            let file = std::fs::File::open(path)?;
+            // SAFETY: the mapping is read-only, and callers must not
+            // truncate or rewrite the file while a cache of it is open
+            // (write a new file and rename it over the old one instead).
+            CacheBytes::Mapped(unsafe { memmap2::Mmap::map(&file)? })
+        };
+        #[cfg(target_arch = "wasm32")]
+        let bytes = CacheBytes::Owned(std::fs::read(path)?);
+        MeshCache::parse(bytes)
+    }
+}
+
+impl<B: AsRef<[u8]>> MeshCache<B> {
+    /// Parse the header, directory and shared atlas of v3 cache bytes, and
+    /// check that every chunk body lies inside them.
+    pub fn parse(bytes: B) -> Result<Self, CacheError> {
+        let data = bytes.as_ref();
+        let header = data
+            .get(..V3_HEADER_LEN)
+            .ok_or_else(|| CacheError::InvalidData("truncated v3 header".into()))?;
+        if &header[0..4] != MAGIC {
+            return Err(CacheError::InvalidMagic);
+        }
+        let version = u32_at(header, 4);
+        if version != V3_VERSION {
+            return Err(CacheError::UnsupportedVersion(version));
+        }
+        let flags = u32_at(header, 8);
+        let count = u32_at(header, 12) as usize;
+        let atlas_range = (u64_at(header, 16), u64_at(header, 24));
+
+        let directory = count
+            .checked_mul(V3_ENTRY_LEN)
+            .and_then(|len| data.get(V3_HEADER_LEN..V3_HEADER_LEN + len))
+            .ok_or_else(|| CacheError::InvalidData("v3 directory out of range".into()))?;
+        let entries = directory
+            .chunks_exact(V3_ENTRY_LEN)
+            .map(|raw| {
+                let entry = ChunkEntry {
+                    chunk_coord: (raw[14] == 1)
+                        .then(|| (i32_at(raw, 0), i32_at(raw, 4), i32_at(raw, 8))),
+                    lod_level: raw[12],
+                    bounds: BoundingBox::new(
+                        [f32_at(raw, 16), f32_at(raw, 20), f32_at(raw, 24)],
+                        [f32_at(raw, 28), f32_at(raw, 32), f32_at(raw, 36)],
+                    ),
+                    compressed: match raw[13] {
+                        CODEC_RAW => false,
+                        CODEC_LZ4 => true,
+                        codec => {
+                            return Err(CacheError::InvalidData(format!(
+                                "unknown chunk codec {codec}"
+                            )))
+                        }
+                    },
+                    vertex_format: match raw[15] {
+                        0 => VertexFormat::Float,
+                        1 => VertexFormat::Compact,
+                        format => {
+                            return Err(CacheError::InvalidData(format!(
+                                "unknown vertex format {format}"
+                            )))
+                        }
+                    },
+                    offset: u64_at(raw, 40),
+                    len: u64_at(raw, 48),
+                    raw_len: u64_at(raw, 56),
+                };
+                slice_at(data, entry.offset, entry.len)?;
+                Ok(entry)
+            })
+            .collect::<Result<Vec<_>, CacheError>>()?;
+
+        let shared_atlas = if flags & FLAG_HAS_SHARED_ATLAS != 0 {
+            let atlas = slice_at(data, atlas_range.0, atlas_range.1)?;
+            Some(read_atlas(&mut Cursor::new(atlas))?)
+        } else {
+            None
+        };
+        Ok(MeshCache {
+            bytes,
+            entries,
+            shared_atlas,
+        })
+    }
+
+    /// Every chunk's directory entry, in the order they were written.
+    pub fn entries(&self) -> &[ChunkEntry] {
+        &self.entries
+    }
+
+    /// Index of the chunk at `coord` and `lod_level`.
+    pub fn find(&self, coord: (i32, i32, i32), lod_level: u8) -> Option<usize> {
+        self.entries
+            .iter()
+            .position(|e| e.chunk_coord == Some(coord) && e.lod_level == lod_level)
+    }
+
+    /// The shared atlas, if the cache was written with one.
+    pub fn shared_atlas(&self) -> Option<&TextureAtlas> {
+        self.shared_atlas.as_ref()
+    }
+
+    /// Decode chunk `index`.
+    pub fn chunk(&self, index: usize) -> Result<MeshOutput, CacheError> {
+        let entry = self.entry(index)?;
+        let stored = slice_at(self.bytes.as_ref(), entry.offset, entry.len)?;
+        if entry.compressed {
+            let body = lz4_flex::block::decompress(stored, entry.raw_len as usize)
+                .map_err(|e| CacheError::InvalidData(format!("chunk body: {e}")))?;
+            decode_body(entry, &body, self.shared_atlas.as_ref())
+        } else {
+            decode_body(entry, stored, self.shared_atlas.as_ref())
+        }
+    }
+
+    /// The opaque, cutout and transparent arrays of uncompressed chunk
+    /// `index`, borrowed in place: uploadable without a copy, and 16-byte
+    /// aligned within the file. `None` for a compressed chunk.
+    pub fn raw_layers(&self, index: usize) -> Result<Option<[RawLayer<'_>; 3]>, CacheError> {
+        let entry = self.entry(index)?;
+        if entry.compressed {
+            return Ok(None);
+        }
+        let body = slice_at(self.bytes.as_ref(), entry.offset, entry.len)?;
+        let layout = BodyLayout::parse(body, entry.vertex_format)?;
+        Ok(Some(layout.layers.map(|spans| RawLayer {
+            positions: &body[spans[0].clone()],
+            normals: &body[spans[1].clone()],
+            uvs: &body[spans[2].clone()],
+            colors: &body[spans[3].clone()],
+            indices: &body[spans[4].clone()],
+        })))
+    }
+
+    /// How compact positions of chunk `index` map to world space; `None` for
+    /// a float chunk.
+    pub fn quantization(&self, index: usize) -> Result<Option<PositionQuantization>, CacheError> {
+        let entry = self.entry(index)?;
+        if entry.vertex_format == VertexFormat::Float {
+            return Ok(None);
+        }
+        // The quantization sits right after the body header, inside the
+        // first LZ4 bytes of a compressed body too, so decode just the body.
+        let stored = slice_at(self.bytes.as_ref(), entry.offset, entry.len)?;
+        let body = if entry.compressed {
+            std::borrow::Cow::Owned(
+                lz4_flex::block::decompress(stored, entry.raw_len as usize)
+                    .map_err(|e| CacheError::InvalidData(format!("chunk body: {e}")))?,
+            )
+        } else {
+            std::borrow::Cow::Borrowed(stored)
+        };
+        read_quantization(&body).map(Some)
+    }
+
+    /// Decode every chunk.
+    pub fn chunks(&self) -> Result<Vec<MeshOutput>, CacheError> {
+        (0..self.entries.len()).map(|i| self.chunk(i)).collect()
+    }
+
+    fn entry(&self, index: usize) -> Result<&ChunkEntry, CacheError> {
+        self.entries
+            .get(index)
+            .ok_or_else(|| CacheError::InvalidData(format!("no chunk {index}")))
+    }
+}
+
+/// Serialize meshes to the random-access v3 format.
+pub fn serialize_meshes_v3(meshes: &[MeshOutput], options: V3Options<'_>) -> Vec<u8> {
+    let directory_end = V3_HEADER_LEN + meshes.len() * V3_ENTRY_LEN;
+    let mut buf = vec![0u8; directory_end];
+    buf[0..4].copy_from_slice(MAGIC);
+    buf[4..8].copy_from_slice(&V3_VERSION.to_le_bytes());
+    buf[12..16].copy_from_slice(&(meshes.len() as u32).to_le_bytes());
+
+    if let Some(atlas) = options.shared_atlas {
+        pad_to(&mut buf, V3_ALIGN);
+        let start = buf.len();
+        write_atlas(&mut buf, atlas).expect("writing to Vec<u8> should not fail");
+        buf[8..12].copy_from_slice(&FLAG_HAS_SHARED_ATLAS.to_le_bytes());
+        buf[16..24].copy_from_slice(&(start as u64).to_le_bytes());
+        buf[24..32].copy_from_slice(&((buf.len() - start) as u64).to_le_bytes());
+    }
+
+    for (i, mesh) in meshes.iter().enumerate() {
+        let body = encode_body(mesh, options.shared_atlas.is_some(), options.vertex_format);
+        let raw_len = body.len() as u64;
+        let (codec, stored) = if options.compress {
+            (CODEC_LZ4, lz4_flex::block::compress(&body))
+        } else {
+            (CODEC_RAW, body)
+        };
+        pad_to(&mut buf, V3_ALIGN);
+        let offset = buf.len() as u64;
+        buf.extend_from_slice(&stored);
+
+        let at = V3_HEADER_LEN + i * V3_ENTRY_LEN;
+        let entry = &mut buf[at..at + V3_ENTRY_LEN];
+        let (cx, cy, cz) = mesh.chunk_coord.unwrap_or((0, 0, 0));
+        for (k, v) in [cx, cy, cz].into_iter().enumerate() {
+            entry[k * 4..k * 4 + 4].copy_from_slice(&v.to_le_bytes());
+        }
+        entry[12] = mesh.lod_level;
+        entry[13] = codec;
+        entry[14] = mesh.chunk_coord.is_some() as u8;
+        entry[15] = (options.vertex_format == VertexFormat::Compact) as u8;
+        let corners = mesh.bounds.min.iter().chain(&mesh.bounds.max);
+        for (k, v) in corners.enumerate() {
+            entry[16 + k * 4..20 + k * 4].copy_from_slice(&v.to_le_bytes());
+        }
+        entry[40..48].copy_from_slice(&offset.to_le_bytes());
+        entry[48..56].copy_from_slice(&(stored.len() as u64).to_le_bytes());
+        entry[56..64].copy_from_slice(&raw_len.to_le_bytes());
+    }
+    buf
+}
+
+/// Serialize meshes to the v3 format and write them to a file.
+pub fn save_cached_mesh_v3(
+    meshes: &[MeshOutput],
+    options: V3Options<'_>,
+    path: &std::path::Path,
+) -> Result<(), CacheError> {
+    std::fs::write(path, serialize_meshes_v3(meshes, options))?;
+    Ok(())
+}
+
+fn encode_body(mesh: &MeshOutput, uses_shared_atlas: bool, format: VertexFormat) -> Vec<u8> {
+    let layers = [&mesh.opaque, &mesh.cutout, &mesh.transparent];
+    let mut atlas = Vec::new();
+    if !uses_shared_atlas {
+        write_atlas(&mut atlas, &mesh.atlas).expect("writing to Vec<u8> should not fail");
+    }
+    let mut anims = Vec::new();
+    write_u32(&mut anims, mesh.animated_textures.len() as u32)
+        .expect("writing to Vec<u8> should not fail");
+    for anim in &mesh.animated_textures {
+        write_animated_texture(&mut anims, anim).expect("writing to Vec<u8> should not fail");
+    }
+
+    let mut buf = Vec::with_capacity(V3_BODY_HEADER_LEN);
+    for layer in layers {
+        buf.extend_from_slice(&(layer.vertex_count() as u32).to_le_bytes());
+        buf.extend_from_slice(&(layer.indices.len() as u32).to_le_bytes());
+    }
+    let atlas_mode = !uses_shared_atlas as u32;
+    for v in [atlas_mode, atlas.len() as u32, anims.len() as u32, 0] {
+        buf.extend_from_slice(&v.to_le_bytes());
+    }
+    pad_to(&mut buf, V3_ALIGN);
+
+    if format == VertexFormat::Compact {
+        let quantization = PositionQuantization::for_bounds(mesh.bounds.min, mesh.bounds.max);
+        for v in quantization
+            .origin
+            .iter()
+            .chain([&quantization.steps_per_block])
+        {
+            buf.extend_from_slice(&v.to_le_bytes());
+        }
+        for layer in layers {
+            let compact = CompactLayer::from_layer(layer, &quantization);
+            for v in compact.positions.iter().flatten() {
+                buf.extend_from_slice(&v.to_le_bytes());
+            }
+            pad_to(&mut buf, V3_ALIGN);
+            buf.extend(compact.normals.iter().flatten().map(|&v| v as u8));
+            pad_to(&mut buf, V3_ALIGN);
+            for v in compact.uvs.iter().flatten() {
+                buf.extend_from_slice(&v.to_le_bytes());
+            }
+            pad_to(&mut buf, V3_ALIGN);
+            buf.extend(compact.colors.iter().flatten());
+            pad_to(&mut buf, V3_ALIGN);
+            for index in &compact.indices {
+                buf.extend_from_slice(&index.to_le_bytes());
+            }
+            pad_to(&mut buf, V3_ALIGN);
+        }
+        buf.extend_from_slice(&atlas);
+        buf.extend_from_slice(&anims);
+        return buf;
+    }
+
+    for layer in layers {
+        let floats = |buf: &mut Vec<u8>, values: &mut dyn Iterator<Item = f32>| {
+            for v in values {
+                buf.extend_from_slice(&v.to_le_bytes());
+            }
+            pad_to(buf, V3_ALIGN);
+        };
+        floats(&mut buf, &mut layer.positions.iter().flatten().copied());
+        floats(&mut buf, &mut layer.normals.iter().flatten().copied());
+        floats(&mut buf, &mut layer.uvs.iter().flatten().copied());
+        floats(&mut buf, &mut layer.colors.iter().flatten().copied());
+        for index in &layer.indices {
+            buf.extend_from_slice(&index.to_le_bytes());
+        }
+        pad_to(&mut buf, V3_ALIGN);
+    }
+    buf.extend_from_slice(&atlas);
+    buf.extend_from_slice(&anims);
+    buf
+}
+
+/// Where the arrays of an uncompressed body lie.
+struct BodyLayout {
+    /// Per layer: positions, normals, uvs, colors and indices.
+    layers: [[std::ops::Range<usize>; 5]; 3],
+    own_atlas: Option<std::ops::Range<usize>>,
+    anims: std::ops::Range<usize>,
+}
+
+impl BodyLayout {
+    fn parse(body: &[u8], format: VertexFormat) -> Result<Self, CacheError> {
+        let header = body
+            .get(..V3_BODY_HEADER_LEN)
+            .ok_or_else(|| CacheError::InvalidData("truncated chunk body".into()))?;
+        let (mut at, sizes) = match format {
+            VertexFormat::Float => (V3_BODY_HEADER_LEN, [12, 12, 8, 16]),
+            VertexFormat::Compact => (V3_BODY_HEADER_LEN + V3_QUANTIZATION_LEN, [8, 4, 4, 4]),
+        };
+        let mut span = |len: usize| {
+            let range = at..at + len;
+            at = (at + len).next_multiple_of(V3_ALIGN);
+            range
+        };
+        let layers = [0, 1, 2].map(|layer| {
+            let vertices = u32_at(header, layer * 8) as usize;
+            let indices = u32_at(header, layer * 8 + 4) as usize;
+            [
+                span(vertices * sizes[0]),
+                span(vertices * sizes[1]),
+                span(vertices * sizes[2]),
+                span(vertices * sizes[3]),
+                span(indices * 4),
+            ]
+        });
+        let atlas_len = u32_at(header, 28) as usize;
+        let anims_len = u32_at(header, 32) as usize;
+        let atlas = at..at + atlas_len;
+        let anims = atlas.end..atlas.end + anims_len;
+        if anims.end > body.len() {
+            return Err(CacheError::InvalidData("chunk body size mismatch".into()));
+        }
+        Ok(BodyLayout {
+            layers,
+            own_atlas: (u32_at(header, 24) == 1).then_some(atlas),
+            anims,
+        })
+    }
+}
+
+fn decode_body(
+    entry: &ChunkEntry,
+    body: &[u8],
+    shared_atlas: Option<&TextureAtlas>,
+) -> Result<MeshOutput, CacheError> {
+    let layout = BodyLayout::parse(body, entry.vertex_format)?;
+    let [opaque, cutout, transparent] = match entry.vertex_format {
+        VertexFormat::Float => layout.layers.map(|spans| MeshLayer {
+            positions: bytes_to_f32x3(&body[spans[0].clone()]),
+            normals: bytes_to_f32x3(&body[spans[1].clone()]),
+            uvs: bytes_to_f32x2(&body[spans[2].clone()]),
+            colors: bytes_to_f32x4(&body[spans[3].clone()]),
+            indices: bytes_to_u32(&body[spans[4].clone()]),
+        }),
+        VertexFormat::Compact => {
+            let quantization = read_quantization(body)?;
+            layout.layers.map(|spans| {
+                let u16s = |range: std::ops::Range<usize>| {
+                    body[range]
+                        .chunks_exact(2)
+                        .map(|c| u16::from_le_bytes([c[0], c[1]]))
+                        .collect::<Vec<_>>()
+                };
+                let bytes = |range: std::ops::Range<usize>| {
+                    body[range]
+                        .chunks_exact(4)
+                        .map(|c| [c[0], c[1], c[2], c[3]])
+                };
+                CompactLayer {
+                    positions: u16s(spans[0].clone())
+                        .chunks_exact(4)
+                        .map(|c| [c[0], c[1], c[2], c[3]])
+                        .collect(),
+                    normals: bytes(spans[1].clone())
+                        .map(|c| c.map(|v| v as i8))
+                        .collect(),
+                    uvs: u16s(spans[2].clone())
+                        .chunks_exact(2)
+                        .map(|c| [c[0], c[1]])
+                        .collect(),
+                    colors: bytes(spans[3].clone()).collect(),
+                    indices: bytes_to_u32(&body[spans[4].clone()]),
+                }
+                .to_layer(&quantization)
+            })
+        }
+    };
+    let atlas = match layout.own_atlas {
+        Some(range) => read_atlas(&mut Cursor::new(&body[range]))?,
+        None => shared_atlas.cloned().ok_or_else(|| {
+            CacheError::InvalidData("chunk references shared atlas but none was provided".into())
+        })?,
+    };
+    let mut anims = Cursor::new(&body[layout.anims]);
+    let anim_count = read_u32(&mut anims)? as usize;
+    let animated_textures = (0..anim_count)
+        .map(|_| read_animated_texture(&mut anims))
+        .collect::<Result<Vec<_>, CacheError>>()?;
+
+    Ok(MeshOutput {
+        opaque,
+        cutout,
+        transparent,
+        atlas,
+        greedy_materials: Vec::new(),
+        animated_textures,
+        bounds: entry.bounds,
+        chunk_coord: entry.chunk_coord,
+        lod_level: entry.lod_level,
+    })
+}
+
+/// The position quantization after a compact body's header.
+fn read_quantization(body: &[u8]) -> Result<PositionQuantization, CacheError> {
+    let block = body
+        .get(V3_BODY_HEADER_LEN..V3_BODY_HEADER_LEN + V3_QUANTIZATION_LEN)
+        .ok_or_else(|| CacheError::InvalidData("truncated chunk body".into()))?;
+    Ok(PositionQuantization {
+        origin: [f32_at(block, 0), f32_at(block, 4), f32_at(block, 8)],
+        steps_per_block: f32_at(block, 12),
+    })
+}
+
+fn pad_to(buf: &mut Vec<u8>, align: usize) {
+    buf.resize(buf.len().next_multiple_of(align), 0);
+}
+
+/// `data[offset..offset + len]`, or an error if that is out of range.
+fn slice_at(data: &[u8], offset: u64, len: u64) -> Result<&[u8], CacheError> {
+    usize::try_from(offset)
+        .ok()
+        .zip(usize::try_from(len).ok())
+        .and_then(|(start, len)| data.get(start..start.checked_add(len)?))
+        .ok_or_else(|| CacheError::InvalidData("chunk body out of range".into()))
+}
+
+fn u32_at(data: &[u8], at: usize) -> u32 {
+    u32::from_le_bytes(data[at..at + 4].try_into().unwrap())
+}
+
+fn i32_at(data: &[u8], at: usize) -> i32 {
+    i32::from_le_bytes(data[at..at + 4].try_into().unwrap())
+}
+
+fn u64_at(data: &[u8], at: usize) -> u64 {
+    u64::from_le_bytes(data[at..at + 8].try_into().unwrap())
+}
+
+fn f32_at(data: &[u8], at: usize) -> f32 {
+    f32::from_le_bytes(data[at..at + 4].try_into().unwrap())
+}
+
 // ─── Byte ↔ typed-array conversions ─────────────────────────────────────────
 
 fn bytes_to_f32x3(data: &[u8]) -> Vec<[f32; 3]> {
@@ -1233,6 +1839,100 @@ mod tests {
         assert_eq!(restored[1].atlas.pixels, shared_atlas.pixels);
     }
 
+    #[test]
+    fn v3_chunks_are_found_and_read_alone() {
+        let meshes: Vec<MeshOutput> = [(0, 0), (1, 0), (1, 1)]
+            .into_iter()
+            .map(|(x, lod)| {
+                let mut m = make_test_mesh_output();
+                m.chunk_coord = Some((x, 0, -3));
+                m.lod_level = lod;
+                m
+            })
+            .collect();
+        let atlas = meshes[0].atlas.clone();
+
+        for (shared_atlas, compress) in [(None, false), (Some(&atlas), false), (None, true)] {
+            let data = serialize_meshes_v3(
+                &meshes,
+                V3Options {
+                    shared_atlas,
+                    compress,
+                    ..V3Options::default()
+                },
+            );
+            let cache = MeshCache::parse(data.as_slice()).unwrap();
+            assert_eq!(cache.entries().len(), 3);
+            assert_eq!(cache.shared_atlas().is_some(), shared_atlas.is_some());
+
+            let index = cache.find((1, 0, -3), 1).expect("chunk listed");
+            let chunk = cache.chunk(index).unwrap();
+            assert_eq!(chunk.lod_level, 1);
+            assert_eq!(chunk.bounds.max, meshes[2].bounds.max);
+            // Full precision: no quantization in v3.
+            assert_eq!(chunk.opaque.positions, meshes[2].opaque.positions);
+            assert_eq!(chunk.cutout.indices, meshes[2].cutout.indices);
+            assert_eq!(chunk.atlas.pixels, atlas.pixels);
+            assert_eq!(chunk.animated_textures.len(), 1);
+            assert!(cache.find((2, 0, -3), 0).is_none());
+
+            match cache.raw_layers(index).unwrap() {
+                Some([opaque, ..]) => {
+                    assert_eq!(opaque.positions.len(), 6 * 12);
+                    let offset = opaque.positions.as_ptr() as usize - data.as_ptr() as usize;
+                    assert_eq!(offset % 16, 0);
+                }
+                None => assert!(compress),
+            }
+            assert_eq!(deserialize_meshes(&data).unwrap().len(), 3);
+        }
+    }
+
+    #[test]
+    fn v3_compact_chunks_shrink_and_dequantize() {
+        let mesh = make_test_mesh_output();
+        let float = serialize_meshes_v3(&[mesh.clone()], V3Options::default());
+        for compress in [false, true] {
+            let options = V3Options {
+                vertex_format: VertexFormat::Compact,
+                compress,
+                ..V3Options::default()
+            };
+            let data = serialize_meshes_v3(&[mesh.clone()], options);
+            let cache = MeshCache::parse(data.as_slice()).unwrap();
+            assert_eq!(cache.entries()[0].vertex_format, VertexFormat::Compact);
+            let q = cache.quantization(0).unwrap().expect("compact chunk");
+            assert_eq!(q.origin, [0.0, 0.0, 0.0]);
+
+            let chunk = cache.chunk(0).unwrap();
+            assert_f32_approx(
+                &chunk.opaque.positions,
+                &mesh.opaque.positions,
+                1.0 / q.steps_per_block,
+                "compact positions",
+            );
+            assert_eq!(chunk.cutout.indices, mesh.cutout.indices);
+            if !compress {
+                let [opaque, ..] = cache.raw_layers(0).unwrap().unwrap();
+                assert_eq!(opaque.positions.len(), 6 * 8);
+                assert!(data.len() < float.len());
+            }
+        }
+        let float = MeshCache::parse(float.as_slice()).unwrap();
+        assert!(float.quantization(0).unwrap().is_none());
+    }
+
+    #[test]
+    fn v3_rejects_bodies_past_the_end() {
+        let mut data = serialize_meshes_v3(&[make_test_mesh_output()], V3Options::default());
+        let len_at = V3_HEADER_LEN + 48;
+        data[len_at..len_at + 8].copy_from_slice(&u64::MAX.to_le_bytes());
+        assert!(matches!(
+            MeshCache::parse(data.as_slice()),
+            Err(CacheError::InvalidData(_))
+        ));
+    }
+
     #[test]
     fn truncated_data_is_rejected() {
         let data = serialize_meshes(&[make_test_mesh_output()]);
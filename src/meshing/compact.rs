@@ -0,0 +1,503 @@
+//! Compact vertex format for mesh export, selected by
+//! [`MeshConfig::vertex_format`](super::MeshConfig::vertex_format).
+//!
+//! A float vertex is 48 bytes (position, normal, UV, RGBA color). A compact
+//! vertex is 20:
+//!
+//! - position: `u16×4` fixed point relative to an integer origin, at a
+//!   power-of-two number of steps per block (256 for meshes up to 255 blocks
+//!   across, which is finer than the 1/16 grid block models use). `w` is 0.
+//! - normal: `i8×4` signed-normalized, `w` is 0.
+//! - UV: `u16×2` unsigned-normalized atlas coordinates.
+//! - color: `u8×4` unsigned-normalized RGBA.
+//!
+//! Every stream is 4-byte aligned per vertex, so each maps onto a GPU vertex
+//! format directly (`uint16x4`, `snorm8x4`, `unorm16x2`, `unorm8x4`).
+//! [`to_compact_glb`] writes the same streams into a GLB using
+//! `KHR_mesh_quantization`, undoing the position scale in the node transform.
+
+use serde::{Deserialize, Serialize};
+use serde_json::json;
+
+use super::{MeshError, MeshLayer, MeshOutput, Result, TextureData};
+
+/// How exported vertices are stored.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default, Serialize, Deserialize)]
+#[serde(rename_all = "snake_case")]
+pub enum VertexFormat {
+    /// `f32` positions, normals, UVs and colors (48 bytes per vertex).
+    #[default]
+    Float,
+    /// Quantized streams (20 bytes per vertex); see the module docs.
+    Compact,
+}
+
+/// Finest position step: 1/256 of a block.
+const MAX_STEPS_PER_BLOCK: f32 = 256.0;
+
+/// Maps compact positions back to world space:
+/// `world = origin + position / steps_per_block`.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct PositionQuantization {
+    /// Whole-block corner the positions are measured from.
+    pub origin: [f32; 3],
+    /// Fixed-point steps per block, a power of two.
+    pub steps_per_block: f32,
+}
+
+impl PositionQuantization {
+    /// The finest quantization that holds every point in `min..=max`.
+    pub fn for_bounds(min: [f32; 3], max: [f32; 3]) -> Self {
+        let origin = min.map(f32::floor);
+        let extent = (0..3).map(|i| max[i] - origin[i]).fold(0.0f32, f32::max);
+        let mut steps = MAX_STEPS_PER_BLOCK;
+        while extent * steps > u16::MAX as f32 && steps > f32::MIN_POSITIVE {
+            steps /= 2.0;
+        }
+        PositionQuantization {
+            origin,
+            steps_per_block: steps,
+        }
+    }
+
+    /// The quantization for a set of positions (the unit one if empty).
+    pub fn covering<'a>(positions: impl IntoIterator<Item = &'a [f32; 3]>) -> Self {
+        let mut min = [f32::INFINITY; 3];
+        let mut max = [f32::NEG_INFINITY; 3];
+        for p in positions {
+            for i in 0..3 {
+                min[i] = min[i].min(p[i]);
+                max[i] = max[i].max(p[i]);
+            }
+        }
+        if min[0] > max[0] {
+            return Self::for_bounds([0.0; 3], [0.0; 3]);
+        }
+        Self::for_bounds(min, max)
+    }
+
+    pub fn quantize(&self, p: [f32; 3]) -> [u16; 4] {
+        let q = |i: usize| {
+            ((p[i] - self.origin[i]) * self.steps_per_block)
+                .round()
+                .clamp(0.0, u16::MAX as f32) as u16
+        };
+        [q(0), q(1), q(2), 0]
+    }
+
+    pub fn dequantize(&self, q: [u16; 4]) -> [f32; 3] {
+        [0, 1, 2].map(|i| self.origin[i] + q[i] as f32 / self.steps_per_block)
+    }
+}
+
+/// One layer's vertex streams in the compact format.
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct CompactLayer {
+    pub positions: Vec<[u16; 4]>,
+    pub normals: Vec<[i8; 4]>,
+    pub uvs: Vec<[u16; 2]>,
+    pub colors: Vec<[u8; 4]>,
+    pub indices: Vec<u32>,
+}
+
+impl CompactLayer {
+    /// Quantize `layer`'s vertices with `quantization`.
+    pub fn from_layer(layer: &MeshLayer, quantization: &PositionQuantization) -> Self {
+        CompactLayer {
+            positions: layer
+                .positions
+                .iter()
+                .map(|&p| quantization.quantize(p))
+                .collect(),
+            normals: layer.normals.iter().map(|&n| pack_normal(n)).collect(),
+            uvs: layer.uvs.iter().map(|&uv| uv.map(unorm16)).collect(),
+            colors: layer.colors.iter().map(|&c| c.map(unorm8)).collect(),
+            indices: layer.indices.clone(),
+        }
+    }
+
+    /// Expand back to a float layer.
+    pub fn to_layer(&self, quantization: &PositionQuantization) -> MeshLayer {
+        MeshLayer {
+            positions: self
+                .positions
+                .iter()
+                .map(|&q| quantization.dequantize(q))
+                .collect(),
+            normals: self.normals.iter().map(|&n| unpack_normal(n)).collect(),
+            uvs: self
+                .uvs
+                .iter()
+                .map(|uv| uv.map(|v| v as f32 / u16::MAX as f32))
+                .collect(),
+            colors: self
+                .colors
+                .iter()
+                .map(|c| c.map(|v| v as f32 / u8::MAX as f32))
+                .collect(),
+            indices: self.indices.clone(),
+        }
+    }
+
+    pub fn vertex_count(&self) -> usize {
+        self.positions.len()
+    }
+
+    /// Bytes of vertex and index data.
+    pub fn byte_len(&self) -> usize {
+        self.vertex_count() * COMPACT_VERTEX_BYTES + self.indices.len() * 4
+    }
+}
+
+/// Bytes per compact vertex across all four streams.
+pub const COMPACT_VERTEX_BYTES: usize = 8 + 4 + 4 + 4;
+
+/// A whole mesh's layers in the compact format, sharing one quantization.
+#[derive(Debug, Clone, PartialEq)]
+pub struct CompactMesh {
+    pub quantization: PositionQuantization,
+    pub opaque: CompactLayer,
+    pub cutout: CompactLayer,
+    pub transparent: CompactLayer,
+}
+
+impl CompactMesh {
+    /// Quantize `mesh` against its bounds.
+    pub fn from_mesh(mesh: &MeshOutput) -> Self {
+        let quantization = PositionQuantization::for_bounds(mesh.bounds.min, mesh.bounds.max);
+        CompactMesh {
+            opaque: CompactLayer::from_layer(&mesh.opaque, &quantization),
+            cutout: CompactLayer::from_layer(&mesh.cutout, &quantization),
+            transparent: CompactLayer::from_layer(&mesh.transparent, &quantization),
+            quantization,
+        }
+    }
+
+    pub fn layers(&self) -> [&CompactLayer; 3] {
+        [&self.opaque, &self.cutout, &self.transparent]
+    }
+
+    pub fn byte_len(&self) -> usize {
+        self.layers().iter().map(|layer| layer.byte_len()).sum()
+    }
+}
+
+fn unorm16(v: f32) -> u16 {
+    (v.clamp(0.0, 1.0) * u16::MAX as f32).round() as u16
+}
+
+fn unorm8(v: f32) -> u8 {
+    (v.clamp(0.0, 1.0) * u8::MAX as f32).round() as u8
+}
+
+fn pack_normal(n: [f32; 3]) -> [i8; 4] {
+    let s = |v: f32| (v.clamp(-1.0, 1.0) * 127.0).round() as i8;
+    [s(n[0]), s(n[1]), s(n[2]), 0]
+}
+
+fn unpack_normal(n: [i8; 4]) -> [f32; 3] {
+    let v = [n[0], n[1], n[2]].map(|c| (c as f32 / 127.0).max(-1.0));
+    let len = (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]).sqrt();
+    if len > 0.0 {
+        v.map(|c| c / len)
+    } else {
+        v
+    }
+}
+
+// ─── GLB ────────────────────────────────────────────────────────────────────
+
+const GLB_MAGIC: &[u8; 4] = b"glTF";
+const CHUNK_JSON: u32 = 0x4E4F_534A;
+const CHUNK_BIN: u32 = 0x004E_4942;
+
+const ARRAY_BUFFER: u32 = 34962;
+const ELEMENT_ARRAY_BUFFER: u32 = 34963;
+const BYTE: u32 = 5120;
+const UNSIGNED_BYTE: u32 = 5121;
+const UNSIGNED_SHORT: u32 = 5123;
+const UNSIGNED_INT: u32 = 5125;
+const NEAREST: u32 = 9728;
+const CLAMP_TO_EDGE: u32 = 33071;
+
+/// Binary glTF of `mesh` with compact vertex streams and the atlas embedded
+/// as PNG: one primitive per non-empty layer, with opaque, alpha-masked and
+/// blended materials. Requires `KHR_mesh_quantization` in the viewer.
+///
+/// Only the atlas is carried, not greedy-meshing materials, so mesh with
+/// greedy meshing off for this export.
+pub fn to_compact_glb(mesh: &MeshOutput) -> Result<Vec<u8>> {
+    let compact = CompactMesh::from_mesh(mesh);
+    let png = TextureData::new(
+        mesh.atlas.width,
+        mesh.atlas.height,
+        mesh.atlas.pixels.clone(),
+    )
+    .to_png()
+    .map_err(|e| MeshError::Export(format!("PNG encode error: {e}")))?;
+
+    let mut bin = Vec::new();
+    let mut views = Vec::new();
+    let mut accessors = Vec::new();
+    let mut view = |bin: &mut Vec<u8>, bytes: &[u8], stride: Option<usize>, target: u32| {
+        let offset = bin.len();
+        bin.extend_from_slice(bytes);
+        bin.resize(bin.len().next_multiple_of(4), 0);
+        let mut v = json!({ "buffer": 0, "byteOffset": offset, "byteLength": bytes.len() });
+        if let Some(stride) = stride {
+            v["byteStride"] = json!(stride);
+        }
+        if target != 0 {
+            v["target"] = json!(target);
+        }
+        views.push(v);
+        views.len() - 1
+    };
+
+    let image_view = view(&mut bin, &png, None, 0);
+    let mut primitives = Vec::new();
+    let materials = [
+        json!({ "name": "opaque", "alphaMode": "OPAQUE" }),
+        json!({ "name": "cutout", "alphaMode": "MASK", "alphaCutoff": 0.5, "doubleSided": true }),
+        json!({ "name": "transparent", "alphaMode": "BLEND", "doubleSided": true }),
+    ];
+    for (material, layer) in compact.layers().into_iter().enumerate() {
+        if layer.indices.is_empty() {
+            continue;
+        }
+        let count = layer.vertex_count();
+        let (mut min, mut max) = ([u16::MAX; 3], [0u16; 3]);
+        for p in &layer.positions {
+            for i in 0..3 {
+                min[i] = min[i].min(p[i]);
+                max[i] = max[i].max(p[i]);
+            }
+        }
+        let mut accessor = |view: usize, component: u32, ty: &str, normalized: bool| {
+            accessors.push(json!({
+                "bufferView": view,
+                "componentType": component,
+                "normalized": normalized,
+                "count": count,
+                "type": ty,
+            }));
+            accessors.len() - 1
+        };
+        let v = view(
+            &mut bin,
+            bytemuck::cast_slice(&layer.positions),
+            Some(8),
+            ARRAY_BUFFER,
+        );
+        let position = accessor(v, UNSIGNED_SHORT, "VEC3", false);
+        let v = view(
+            &mut bin,
+            bytemuck::cast_slice(&layer.normals),
+            Some(4),
+            ARRAY_BUFFER,
+        );
+        let normal = accessor(v, BYTE, "VEC3", true);
+        let v = view(
+            &mut bin,
+            bytemuck::cast_slice(&layer.uvs),
+            Some(4),
+            ARRAY_BUFFER,
+        );
+        let uv = accessor(v, UNSIGNED_SHORT, "VEC2", true);
+        let v = view(
+            &mut bin,
+            bytemuck::cast_slice(&layer.colors),
+            Some(4),
+            ARRAY_BUFFER,
+        );
+        let color = accessor(v, UNSIGNED_BYTE, "VEC4", true);
+        let v = view(
+            &mut bin,
+            bytemuck::cast_slice(&layer.indices),
+            None,
+            ELEMENT_ARRAY_BUFFER,
+        );
+        accessors.push(json!({
+            "bufferView": v,
+            "componentType": UNSIGNED_INT,
+            "count": layer.indices.len(),
+            "type": "SCALAR",
+        }));
+        let indices = accessors.len() - 1;
+        accessors[position]["min"] = json!(min);
+        accessors[position]["max"] = json!(max);
+        primitives.push(json!({
+            "attributes": {
+                "POSITION": position,
+                "NORMAL": normal,
+                "TEXCOORD_0": uv,
+                "COLOR_0": color,
+            },
+            "indices": indices,
+            "material": material,
+        }));
+    }
+
+    let q = compact.quantization;
+    let scale = [1.0 / q.steps_per_block; 3];
+    let (meshes, nodes) = if primitives.is_empty() {
+        (json!([]), json!([]))
+    } else {
+        (
+            json!([{ "primitives": primitives }]),
+            json!([{
+                "mesh": 0,
+                "translation": q.origin,
+                "scale": scale,
+            }]),
+        )
+    };
+    let scene_nodes: Vec<usize> = (0..nodes.as_array().map_or(0, Vec::len)).collect();
+    let materials: Vec<_> = materials
+        .into_iter()
+        .map(|mut m| {
+            m["pbrMetallicRoughness"] = json!({
+                "baseColorTexture": { "index": 0 },
+                "metallicFactor": 0.0,
+                "roughnessFactor": 1.0,
+            });
+            m
+        })
+        .collect();
+    let doc = json!({
+        "asset": { "version": "2.0", "generator": "nucleation" },
+        "extensionsUsed": ["KHR_mesh_quantization"],
+        "extensionsRequired": ["KHR_mesh_quantization"],
+        "scene": 0,
+        "scenes": [{ "nodes": scene_nodes }],
+        "nodes": nodes,
+        "meshes": meshes,
+        "materials": materials,
+        "textures": [{ "sampler": 0, "source": 0 }],
+        "samplers": [{
+            "magFilter": NEAREST,
+            "minFilter": NEAREST,
+            "wrapS": CLAMP_TO_EDGE,
+            "wrapT": CLAMP_TO_EDGE,
+        }],
+        "images": [{ "bufferView": image_view, "mimeType": "image/png" }],
+        "buffers": [{ "byteLength": bin.len() }],
+        "bufferViews": views,
+        "accessors": accessors,
+    });
+
+    let mut json = serde_json::to_vec(&doc).map_err(|e| MeshError::Export(e.to_string()))?;
+    json.resize(json.len().next_multiple_of(4), b' ');
+    let total = 12 + 8 + json.len() + 8 + bin.len();
+    let mut glb = Vec::with_capacity(total);
+    glb.extend_from_slice(GLB_MAGIC);
+    glb.extend_from_slice(&2u32.to_le_bytes());
+    glb.extend_from_slice(&(total as u32).to_le_bytes());
+    glb.extend_from_slice(&(json.len() as u32).to_le_bytes());
+    glb.extend_from_slice(&CHUNK_JSON.to_le_bytes());
+    glb.extend_from_slice(&json);
+    glb.extend_from_slice(&(bin.len() as u32).to_le_bytes());
+    glb.extend_from_slice(&CHUNK_BIN.to_le_bytes());
+    glb.extend_from_slice(&bin);
+    Ok(glb)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use schematic_mesher::{BoundingBox, TextureAtlas};
+    use std::collections::HashMap;
+
+    fn layer(offset: f32) -> MeshLayer {
+        MeshLayer {
+            positions: vec![
+                [offset, 0.0, 0.0],
+                [offset + 0.0625, 1.0, 0.0],
+                [offset, 1.0, 0.5],
+            ],
+            normals: vec![[0.0, 1.0, 0.0], [1.0, 0.0, 0.0], [0.0, 0.0, -1.0]],
+            uvs: vec![[0.0, 0.0], [0.25, 0.5], [1.0, 1.0]],
+            colors: vec![[1.0, 0.5, 0.25, 1.0]; 3],
+            indices: vec![0, 1, 2],
+        }
+    }
+
+    fn mesh() -> MeshOutput {
+        MeshOutput {
+            opaque: layer(-3.0),
+            cutout: layer(12.0),
+            transparent: MeshLayer::default(),
+            atlas: TextureAtlas {
+                width: 2,
+                height: 2,
+                pixels: vec![255u8; 2 * 2 * 4],
+                regions: HashMap::new(),
+            },
+            greedy_materials: Vec::new(),
+            animated_textures: Vec::new(),
+            bounds: BoundingBox::new([-3.0, 0.0, 0.0], [12.0625, 1.0, 0.5]),
+            chunk_coord: None,
+            lod_level: 0,
+        }
+    }
+
+    #[test]
+    fn compact_layers_roundtrip_within_a_step() {
+        let mesh = mesh();
+        let compact = CompactMesh::from_mesh(&mesh);
+        assert_eq!(compact.quantization.origin, [-3.0, 0.0, 0.0]);
+        assert_eq!(compact.quantization.steps_per_block, 256.0);
+
+        let back = compact.opaque.to_layer(&compact.quantization);
+        // 1/16 grid positions and axis normals come back exactly.
+        assert_eq!(back.positions, mesh.opaque.positions);
+        assert_eq!(back.normals, mesh.opaque.normals);
+        for (a, b) in back
+            .uvs
+            .iter()
+            .flatten()
+            .zip(mesh.opaque.uvs.iter().flatten())
+        {
+            assert!((a - b).abs() <= 1.0 / 65535.0);
+        }
+        for (a, b) in back
+            .colors
+            .iter()
+            .flatten()
+            .zip(mesh.opaque.colors.iter().flatten())
+        {
+            assert!((a - b).abs() <= 1.0 / 255.0);
+        }
+        assert_eq!(compact.opaque.byte_len(), 3 * COMPACT_VERTEX_BYTES + 12);
+    }
+
+    #[test]
+    fn large_extents_lower_the_position_resolution() {
+        let q = PositionQuantization::for_bounds([0.5, 0.0, 0.0], [1000.0, 1.0, 1.0]);
+        assert_eq!(q.steps_per_block, 64.0);
+        assert_eq!(
+            q.dequantize(q.quantize([1000.0, 1.0, 1.0])),
+            [1000.0, 1.0, 1.0]
+        );
+    }
+
+    #[test]
+    fn compact_glb_declares_quantized_attributes() {
+        let glb = to_compact_glb(&mesh()).unwrap();
+        assert_eq!(&glb[0..4], b"glTF");
+        assert_eq!(
+            u32::from_le_bytes(glb[8..12].try_into().unwrap()) as usize,
+            glb.len()
+        );
+
+        let json_len = u32::from_le_bytes(glb[12..16].try_into().unwrap()) as usize;
+        let doc: serde_json::Value = serde_json::from_slice(&glb[20..20 + json_len]).unwrap();
+        assert_eq!(doc["extensionsRequired"][0], "KHR_mesh_quantization");
+        let primitives = doc["meshes"][0]["primitives"].as_array().unwrap();
+        assert_eq!(primitives.len(), 2);
+        let position =
+            &doc["accessors"][primitives[0]["attributes"]["POSITION"].as_u64().unwrap() as usize];
+        assert_eq!(position["componentType"], UNSIGNED_SHORT);
+        assert_eq!(doc["nodes"][0]["scale"][0], 1.0 / 256.0);
+    }
+}
@@ -7,14 +7,14 @@
 use std::collections::{HashMap, HashSet};
 use std::io::Write;
 
+use flate2::Compression;
 use schematic_mesher::resolver::{resolve_block, ModelResolver};
 use schematic_mesher::resource_pack::TextureData;
 use schematic_mesher::{Direction, InputBlock, ResourcePack};
 use serde::{Deserialize, Serialize};
-use zip::write::SimpleFileOptions;
-use zip::ZipWriter;
 
 use super::{MeshError, ResourcePackSource, Result};
+use crate::formats::world_zip::{WorldZip, ZipCompression};
 use crate::{Region, UniversalSchematic};
 
 /// Maximum dimension for Minecraft item models (coordinate range: -16 to 32 = 48).
@@ -177,6 +177,7 @@ impl ItemModelResult {
 /// Merges all models and textures into a single ZIP. Item definitions are grouped
 /// by item type — multiple schematics bound to the same item (e.g., paper) will
 /// share one item definition file with multiple `custom_model_data` cases.
+/// See [`write_resource_pack`] for texture sharing.
 ///
 /// # Example
 /// ```ignore
@@ -185,89 +186,142 @@ impl ItemModelResult {
 /// let zip = build_resource_pack(&[&result1, &result2])?;
 /// ```
 pub fn build_resource_pack(results: &[&ItemModelResult]) -> Result<Vec<u8>> {
+    write_resource_pack(results, Vec::new())
+}
+
+/// Stream the resource pack of [`build_resource_pack`] into `out` (a file or
+/// a store writer) and return it.
+///
+/// Entries are deflated in parallel batches and written as they finish, so
+/// the archive is never held whole. A texture whose PNG bytes match one
+/// already written, from any model, is not written again: the models using
+/// it point at the first copy, so blocks shared across a shop's worth of
+/// models are stored once.
+pub fn write_resource_pack<W: Write>(results: &[&ItemModelResult], out: W) -> Result<W> {
     if results.is_empty() {
         return Err(MeshError::Export("No results to pack".to_string()));
     }
+    let export = |e: crate::formats::error::FormatError| MeshError::Export(e.to_string());
 
-    let mut buf = Vec::new();
-    {
-        let mut zip = ZipWriter::new(std::io::Cursor::new(&mut buf));
-        let options =
-            SimpleFileOptions::default().compression_method(zip::CompressionMethod::Deflated);
-
-        // pack.mcmeta
-        zip.start_file("pack.mcmeta", options)
-            .map_err(|e| MeshError::Export(e.to_string()))?;
-        zip.write_all(br#"{"pack":{"pack_format":46,"description":"Generated by Nucleation"}}"#)
-            .map_err(|e| MeshError::Export(e.to_string()))?;
-
-        // Group results by item type for combined item definitions
-        let mut item_cases: HashMap<String, Vec<serde_json::Value>> = HashMap::new();
-
-        for result in results {
-            // Model JSON
-            let model_path = format!(
-                "assets/{}/models/item/{}.json",
-                result.config.namespace, result.config.model_name
-            );
-            zip.start_file(&model_path, options)
-                .map_err(|e| MeshError::Export(e.to_string()))?;
-            zip.write_all(result.model_json.as_bytes())
-                .map_err(|e| MeshError::Export(e.to_string()))?;
-
-            // Texture PNGs
-            for (tex_name, png_data) in &result.textures {
-                let tex_path = format!(
-                    "assets/{}/textures/item/{}/{}.png",
-                    result.config.namespace, result.config.model_name, tex_name
-                );
-                zip.start_file(&tex_path, options)
-                    .map_err(|e| MeshError::Export(e.to_string()))?;
-                zip.write_all(png_data)
-                    .map_err(|e| MeshError::Export(e.to_string()))?;
-            }
-
-            // Collect item definition case
-            let case = serde_json::json!({
-                "when": result.config.custom_model_data,
-                "model": {
-                    "type": "minecraft:model",
-                    "model": format!("{}:item/{}", result.config.namespace, result.config.model_name)
-                }
-            });
-            item_cases
-                .entry(result.config.item.clone())
-                .or_default()
-                .push(case);
+    let mut zip = WorldZip::new(out, ZipCompression::Deflated(Compression::default()));
+    zip.add_file(
+        "pack.mcmeta".to_string(),
+        br#"{"pack":{"pack_format":46,"description":"Generated by Nucleation"}}"#.to_vec(),
+    )
+    .map_err(export)?;
+
+    // Group results by item type for combined item definitions
+    let mut item_cases: HashMap<String, Vec<serde_json::Value>> = HashMap::new();
+    let mut model_paths: HashSet<String> = HashSet::new();
+    // Texture reference of the first copy of each distinct PNG.
+    let mut written: HashMap<&[u8], String> = HashMap::new();
+
+    for result in results {
+        let namespace = &result.config.namespace;
+        let model_name = &result.config.model_name;
+        let model_path = format!("assets/{}/models/item/{}.json", namespace, model_name);
+        if !model_paths.insert(model_path.clone()) {
+            return Err(MeshError::Export(format!("Duplicate model {}", model_path)));
         }
 
-        // Write item definition files (one per unique item type)
-        for (item, cases) in &item_cases {
-            let item_def_path = format!("assets/minecraft/items/{}.json", item);
-            let item_def = serde_json::json!({
-                "model": {
-                    "type": "minecraft:select",
-                    "property": "minecraft:custom_model_data",
-                    "fallback": {
-                        "type": "minecraft:model",
-                        "model": format!("minecraft:item/{}", item)
-                    },
-                    "cases": cases
+        // Texture PNGs, in name order so the first copy is deterministic
+        let mut tex_names: Vec<&String> = result.textures.keys().collect();
+        tex_names.sort();
+        let mut redirects: HashMap<String, String> = HashMap::new();
+        for tex_name in tex_names {
+            let png_data = &result.textures[tex_name];
+            let reference = format!("{}:item/{}/{}", namespace, model_name, tex_name);
+            match written.get(png_data.as_slice()) {
+                Some(first) => {
+                    redirects.insert(reference, first.clone());
                 }
-            });
-            zip.start_file(&item_def_path, options)
-                .map_err(|e| MeshError::Export(e.to_string()))?;
-            zip.write_all(
-                serde_json::to_string_pretty(&item_def)
-                    .unwrap_or_default()
-                    .as_bytes(),
-            )
-            .map_err(|e| MeshError::Export(e.to_string()))?;
+                None => {
+                    let tex_path = format!(
+                        "assets/{}/textures/item/{}/{}.png",
+                        namespace, model_name, tex_name
+                    );
+                    zip.add_file(tex_path, png_data.clone()).map_err(export)?;
+                    written.insert(png_data.as_slice(), reference);
+                }
+            }
         }
 
-        zip.finish().map_err(|e| MeshError::Export(e.to_string()))?;
+        // Model JSON
+        let model_json = if redirects.is_empty() {
+            result.model_json.clone()
+        } else {
+            redirect_textures(&result.model_json, &redirects)
+        };
+        zip.add_file(model_path, model_json.into_bytes())
+            .map_err(export)?;
+
+        // Collect item definition case
+        let case = serde_json::json!({
+            "when": result.config.custom_model_data,
+            "model": {
+                "type": "minecraft:model",
+                "model": format!("{}:item/{}", namespace, model_name)
+            }
+        });
+        item_cases
+            .entry(result.config.item.clone())
+            .or_default()
+            .push(case);
+    }
+
+    // Write item definition files (one per unique item type)
+    for (item, cases) in &item_cases {
+        let item_def_path = format!("assets/minecraft/items/{}.json", item);
+        let item_def = serde_json::json!({
+            "model": {
+                "type": "minecraft:select",
+                "property": "minecraft:custom_model_data",
+                "fallback": {
+                    "type": "minecraft:model",
+                    "model": format!("minecraft:item/{}", item)
+                },
+                "cases": cases
+            }
+        });
+        zip.add_file(
+            item_def_path,
+            serde_json::to_string_pretty(&item_def)
+                .unwrap_or_default()
+                .into_bytes(),
+        )
+        .map_err(export)?;
+    }
+
+    zip.finish().map_err(export)
+}
+
+/// `model_json` with the texture references in `redirects` replaced.
+fn redirect_textures(model_json: &str, redirects: &HashMap<String, String>) -> String {
+    let Ok(mut model) = serde_json::from_str::<serde_json::Value>(model_json) else {
+        return model_json.to_string();
+    };
+    if let Some(textures) = model.get_mut("textures").and_then(|t| t.as_object_mut()) {
+        for value in textures.values_mut() {
+            if let Some(target) = value.as_str().and_then(|r| redirects.get(r)) {
+                *value = serde_json::Value::String(target.clone());
+            }
+        }
     }
-    Ok(buf)
+    serde_json::to_string_pretty(&model).unwrap_or_else(|_| model_json.to_string())
+}
+
+/// Generate the item models of many schematics against one loaded pack, in
+/// parallel. Results are in input order; a schematic that fails yields its
+/// error without stopping the others.
+pub fn to_item_models(
+    pack: &ResourcePackSource,
+    jobs: &[(&UniversalSchematic, &ItemModelConfig)],
+) -> Vec<Result<ItemModelResult>> {
+    use rayon::prelude::*;
+
+    jobs.par_iter()
+        .map(|(schematic, config)| schematic.to_item_model(pack, config))
+        .collect()
 }
 
 // ─── Block info cache ───────────────────────────────────────────────────────
@@ -2124,3 +2178,69 @@ fn merge_planes(
         }
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::{Cursor, Read};
+
+    fn result(model_name: &str, textures: &[(&str, &[u8])]) -> ItemModelResult {
+        let config = ItemModelConfig::new(model_name);
+        let tex_map: serde_json::Map<String, serde_json::Value> = textures
+            .iter()
+            .enumerate()
+            .map(|(i, (name, _))| {
+                let value = format!("{}:item/{}/{}", config.namespace, model_name, name);
+                (format!("tex{}", i), serde_json::Value::String(value))
+            })
+            .collect();
+        ItemModelResult {
+            model_json: serde_json::json!({ "textures": tex_map, "elements": [] }).to_string(),
+            textures: textures
+                .iter()
+                .map(|(name, png)| (name.to_string(), png.to_vec()))
+                .collect(),
+            stats: ItemModelStats {
+                element_count: 0,
+                texture_count: textures.len(),
+                plane_count: 0,
+                dimensions: (1, 1, 1),
+                scale: (1.0, 1.0, 1.0),
+            },
+            config,
+        }
+    }
+
+    #[test]
+    fn identical_textures_are_written_once_across_models() {
+        let a = result("a", &[("atlas_0", b"page a"), ("block_stone", b"stone")]);
+        let b = result("b", &[("atlas_0", b"page b"), ("block_stone", b"stone")]);
+        let bytes = write_resource_pack(&[&a, &b], Vec::new()).unwrap();
+
+        let mut archive = zip::ZipArchive::new(Cursor::new(bytes)).unwrap();
+        let names: HashSet<String> = archive.file_names().map(str::to_string).collect();
+        assert!(names.contains("assets/nucleation/textures/item/a/block_stone.png"));
+        assert!(!names.contains("assets/nucleation/textures/item/b/block_stone.png"));
+        assert!(names.contains("assets/nucleation/textures/item/b/atlas_0.png"));
+
+        let mut model = String::new();
+        archive
+            .by_name("assets/nucleation/models/item/b.json")
+            .unwrap()
+            .read_to_string(&mut model)
+            .unwrap();
+        let model: serde_json::Value = serde_json::from_str(&model).unwrap();
+        let textures: HashSet<&str> = model["textures"]
+            .as_object()
+            .unwrap()
+            .values()
+            .filter_map(|v| v.as_str())
+            .collect();
+        assert_eq!(
+            textures,
+            HashSet::from(["nucleation:item/b/atlas_0", "nucleation:item/a/block_stone"])
+        );
+
+        assert!(write_resource_pack(&[&a, &a], Vec::new()).is_err());
+    }
+}
@@ -63,20 +63,32 @@ use schematic_mesher::{
     RawMeshData, ResourcePack, TextureAtlas,
 };
 
+pub mod atlas;
 pub mod cache;
+pub mod compact;
 pub mod item_model;
+mod pack_cache;
 mod resource_pack_compat;
+pub mod reuse;
+pub mod session;
 
+pub use atlas::PackAtlas;
 // Re-export the real MeshOutput and MeshLayer types from schematic-mesher.
+pub use compact::{CompactLayer, CompactMesh, PositionQuantization, VertexFormat};
 pub use item_model::{
-    build_resource_pack, ItemModelConfig, ItemModelResult, ItemModelScale, ItemModelStats,
+    build_resource_pack, to_item_models, write_resource_pack, ItemModelConfig, ItemModelResult,
+    ItemModelScale, ItemModelStats,
 };
 pub use schematic_mesher::{MeshLayer, MeshOutput};
+pub use reuse::{ChunkMeshCache, ReuseStats};
+pub use session::MeshSession;
 use serde::{Deserialize, Serialize};
-use std::collections::HashMap;
+use std::collections::{HashMap, HashSet};
 use std::path::Path;
 
+use crate::bounding_box::BoundingBox;
 use crate::entity::{Entity, NbtValue};
+use crate::universal_schematic::ChunkLoadingStrategy;
 use crate::{BlockState, Region, UniversalSchematic};
 
 /// Error type for meshing operations.
@@ -90,6 +102,8 @@ pub enum MeshError {
     Export(String),
     #[error("IO error: {0}")]
     Io(#[from] std::io::Error),
+    #[error("Meshing cancelled")]
+    Cancelled,
 }
 
 pub type Result<T> = std::result::Result<T, MeshError>;
@@ -164,6 +178,66 @@ impl ResourcePackSource {
         Ok(Self::with_mesher_texture_aliases(pack))
     }
 
+    /// Load a pack from [`to_cache_bytes`](Self::to_cache_bytes) output:
+    /// no unzipping or PNG decoding, and textures are decompressed in
+    /// parallel.
+    pub fn from_cache_bytes(data: &[u8]) -> std::result::Result<Self, cache::CacheError> {
+        Ok(Self::with_mesher_texture_aliases(pack_cache::read_pack(data)?))
+    }
+
+    /// The parsed pack (blockstates, models and decoded RGBA textures) as a
+    /// binary cache for [`from_cache_bytes`](Self::from_cache_bytes).
+    pub fn to_cache_bytes(&self) -> Vec<u8> {
+        pack_cache::write_pack(self)
+    }
+
+    /// [`from_bytes`](Self::from_bytes) through a directory of pack caches
+    /// keyed by the archive's content hash. A hit maps the cached pack and
+    /// skips normalization, unzipping and PNG decoding; a miss, or an entry
+    /// that does not read back, loads the archive and writes the entry for
+    /// the next process. Failing to write the entry does not fail the load.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn from_bytes_cached(data: &[u8], cache_dir: &Path) -> Result<Self> {
+        let entry = cache_dir.join(pack_cache::cache_name(data));
+        if let Ok(pack) = pack_cache::read_pack_file(&entry) {
+            return Ok(Self::with_mesher_texture_aliases(pack));
+        }
+        let source = Self::from_bytes(data)?;
+        let _ = std::fs::create_dir_all(cache_dir)
+            .and_then(|()| pack_cache::write_pack_file(&entry, &source.to_cache_bytes()));
+        Ok(source)
+    }
+
+    /// [`from_file`](Self::from_file) through
+    /// [`from_bytes_cached`](Self::from_bytes_cached). Pack directories are
+    /// loaded uncached.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn from_file_cached<P: AsRef<Path>>(path: P, cache_dir: &Path) -> Result<Self> {
+        if path.as_ref().is_file() {
+            return Self::from_bytes_cached(&std::fs::read(path)?, cache_dir);
+        }
+        Self::from_file(path)
+    }
+
+    /// [`from_bytes_cached`](Self::from_bytes_cached) with the entries kept
+    /// in `store` under `prefix`, for workers that share a store rather than
+    /// a disk.
+    pub fn from_bytes_cached_in_store(
+        data: &[u8],
+        store: &dyn crate::store::Store,
+        prefix: &str,
+    ) -> Result<Self> {
+        let key = format!("{}{}", prefix, pack_cache::cache_name(data));
+        if let Ok(Some(bytes)) = store.get(&key) {
+            if let Ok(pack) = pack_cache::read_pack(&bytes) {
+                return Ok(Self::with_mesher_texture_aliases(pack));
+            }
+        }
+        let source = Self::from_bytes(data)?;
+        let _ = store.put(&key, &source.to_cache_bytes());
+        Ok(source)
+    }
+
     /// Create a ResourcePackSource from an already-loaded ResourcePack.
     pub fn from_resource_pack(pack: ResourcePack) -> Self {
         Self::with_mesher_texture_aliases(pack)
@@ -212,6 +286,43 @@ impl ResourcePackSource {
         names
     }
 
+    /// A hex blake3 digest of the pack's blockstates, models and textures,
+    /// stable across processes: the pack id for a [`ChunkMeshCache`]. Hashes
+    /// every texture's pixels, so compute it once per loaded pack.
+    pub fn fingerprint(&self) -> String {
+        let mut h = blake3::Hasher::new();
+        let mut field = |bytes: &[u8]| {
+            h.update(&(bytes.len() as u64).to_le_bytes());
+            h.update(bytes);
+        };
+        let sorted = |mut names: Vec<String>| {
+            names.sort_unstable();
+            names
+        };
+        for name in sorted(self.list_blockstates()) {
+            field(name.as_bytes());
+            let json = self.get_blockstate_json(&name).unwrap_or_default();
+            field(json.as_bytes());
+        }
+        for name in sorted(self.list_models()) {
+            field(name.as_bytes());
+            // Through `Value`, whose maps are sorted, so field order is stable.
+            let model = self.pack.get_model(&name).and_then(|m| serde_json::to_value(m).ok());
+            field(model.unwrap_or_default().to_string().as_bytes());
+        }
+        for name in sorted(self.list_textures()) {
+            field(name.as_bytes());
+            if let Some(tex) = self.pack.get_texture(&name) {
+                let flags = [tex.width, tex.height, tex.is_animated as u32, tex.frame_count];
+                for v in flags {
+                    field(&v.to_le_bytes());
+                }
+                field(&tex.pixels);
+            }
+        }
+        h.finalize().to_hex().to_string()
+    }
+
     /// Get a blockstate definition as JSON. Returns None if not found.
     /// Since BlockstateDefinition doesn't implement Serialize, we manually build JSON.
     pub fn get_blockstate_json(&self, name: &str) -> Option<String> {
@@ -312,8 +423,19 @@ pub struct MeshConfig {
     pub cull_occluded_blocks: bool,
     /// Merge adjacent coplanar faces into larger quads (reduces triangle count).
     pub greedy_meshing: bool,
+    /// Downsampled levels of detail to mesh per chunk alongside full detail:
+    /// level `n` merges `2^n` cells a side. At most [`MAX_LOD_LEVEL`]. Used
+    /// by [`UniversalSchematic::mesh_by_chunk_size`], which skips levels
+    /// whose factor does not divide the chunk size.
+    pub lod_levels: u8,
+    /// How [`RawMeshExport`] and GLB export through [`MeshExporter`] store
+    /// vertices: `f32` streams, or the 20-byte [`compact`] form.
+    pub vertex_format: VertexFormat,
 }
 
+/// Deepest level of detail [`MeshConfig::lod_levels`] allows (8× merging).
+pub const MAX_LOD_LEVEL: u8 = 3;
+
 impl Default for MeshConfig {
     fn default() -> Self {
         Self {
@@ -324,6 +446,8 @@ impl Default for MeshConfig {
             atlas_max_size: 4096,
             cull_occluded_blocks: true,
             greedy_meshing: false,
+            lod_levels: 0,
+            vertex_format: VertexFormat::Float,
         }
     }
 }
@@ -376,6 +500,19 @@ impl MeshConfig {
         self
     }
 
+    /// Mesh `levels` downsampled levels of detail per chunk, clamped to
+    /// [`MAX_LOD_LEVEL`].
+    pub fn with_lod_levels(mut self, levels: u8) -> Self {
+        self.lod_levels = levels.min(MAX_LOD_LEVEL);
+        self
+    }
+
+    /// Set the vertex format for raw and GLB export.
+    pub fn with_vertex_format(mut self, format: VertexFormat) -> Self {
+        self.vertex_format = format;
+        self
+    }
+
     fn to_mesher_config(&self) -> MesherConfig {
         let mut config = MesherConfig::default();
         config.cull_hidden_faces = self.cull_hidden_faces;
@@ -414,33 +551,93 @@ pub struct ChunkMeshResult {
     pub total_vertex_count: usize,
     /// Total triangle count across all meshes.
     pub total_triangle_count: usize,
+    /// Downsampled meshes from [`MeshConfig::lod_levels`], each tagged with
+    /// its `chunk_coord` and `lod_level`. Not counted in the totals.
+    pub lods: Vec<MeshOutput>,
 }
 
 /// Result of raw mesh export for custom rendering.
+///
+/// The vertex streams stay in the mesher's `[f32; N]` arrays and are viewed
+/// as flat `f32` slices, so callers (and the bridge's borrowed-slice
+/// accessors) read them without re-flattening or copying. With
+/// [`VertexFormat::Compact`] the compact streams are built too, and
+/// [`RawMeshExport::compact`] returns them.
 #[derive(Debug)]
 pub struct RawMeshExport {
     pub(crate) inner: RawMeshData,
+    compact: Option<(PositionQuantization, CompactLayer)>,
 }
 
 impl RawMeshExport {
-    /// Vertex positions (3 floats per vertex).
+    pub(crate) fn from_raw(inner: RawMeshData, format: VertexFormat) -> Self {
+        let mut export = Self {
+            inner,
+            compact: None,
+        };
+        if format == VertexFormat::Compact {
+            export.compact = Some(export.build_compact());
+        }
+        export
+    }
+
+    fn build_compact(&self) -> (PositionQuantization, CompactLayer) {
+        let layer = MeshLayer {
+            positions: self.inner.positions.clone(),
+            normals: self.inner.normals.clone(),
+            uvs: self.inner.uvs.clone(),
+            colors: self.inner.colors.clone(),
+            indices: self.inner.indices.clone(),
+        };
+        let quantization = PositionQuantization::covering(&layer.positions);
+        let compact = CompactLayer::from_layer(&layer, &quantization);
+        (quantization, compact)
+    }
+
+    /// The compact streams and the quantization that maps their positions
+    /// back to world space, if exported with [`VertexFormat::Compact`].
+    pub fn compact(&self) -> Option<(&PositionQuantization, &CompactLayer)> {
+        self.compact.as_ref().map(|(q, layer)| (q, layer))
+    }
+
+    /// Vertex positions (3 floats per vertex), borrowed.
+    pub fn positions(&self) -> &[f32] {
+        bytemuck::cast_slice(&self.inner.positions)
+    }
+
+    /// Vertex normals (3 floats per vertex), borrowed.
+    pub fn normals(&self) -> &[f32] {
+        bytemuck::cast_slice(&self.inner.normals)
+    }
+
+    /// Texture coordinates (2 floats per vertex), borrowed.
+    pub fn uvs(&self) -> &[f32] {
+        bytemuck::cast_slice(&self.inner.uvs)
+    }
+
+    /// Vertex colors (4 floats per vertex, RGBA), borrowed.
+    pub fn colors(&self) -> &[f32] {
+        bytemuck::cast_slice(&self.inner.colors)
+    }
+
+    /// An owned copy of [`positions`](Self::positions).
     pub fn positions_flat(&self) -> Vec<f32> {
-        self.inner.positions_flat()
+        self.positions().to_vec()
     }
 
-    /// Vertex normals (3 floats per vertex).
+    /// An owned copy of [`normals`](Self::normals).
     pub fn normals_flat(&self) -> Vec<f32> {
-        self.inner.normals_flat()
+        self.normals().to_vec()
     }
 
-    /// Texture coordinates (2 floats per vertex).
+    /// An owned copy of [`uvs`](Self::uvs).
     pub fn uvs_flat(&self) -> Vec<f32> {
-        self.inner.uvs_flat()
+        self.uvs().to_vec()
     }
 
-    /// Vertex colors (4 floats per vertex, RGBA).
+    /// An owned copy of [`colors`](Self::colors).
     pub fn colors_flat(&self) -> Vec<f32> {
-        self.inner.colors_flat()
+        self.colors().to_vec()
     }
 
     /// Triangle indices.
@@ -543,19 +740,37 @@ impl BlockSource for RegionBlockSource {
     }
 }
 
-/// Adapter for chunk-based meshing.
-struct ChunkBlockSource {
-    blocks: HashMap<MesherBlockPosition, InputBlock>,
+/// Adapter for chunk-based meshing, borrowing the chunk's blocks.
+struct ChunkBlockSource<'a> {
+    blocks: &'a HashMap<MesherBlockPosition, InputBlock>,
     bounds: MesherBoundingBox,
 }
 
-impl ChunkBlockSource {
-    fn new(blocks: HashMap<MesherBlockPosition, InputBlock>, bounds: MesherBoundingBox) -> Self {
+impl<'a> ChunkBlockSource<'a> {
+    fn new(
+        blocks: &'a HashMap<MesherBlockPosition, InputBlock>,
+        bounds: MesherBoundingBox,
+    ) -> Self {
         Self { blocks, bounds }
     }
+
+    /// A source over `blocks`, bounded by the blocks themselves.
+    fn fitted(blocks: &'a HashMap<MesherBlockPosition, InputBlock>) -> Self {
+        let mut min = [f32::MAX; 3];
+        let mut max = [f32::MIN; 3];
+        for pos in blocks.keys() {
+            min[0] = min[0].min(pos.x as f32);
+            min[1] = min[1].min(pos.y as f32);
+            min[2] = min[2].min(pos.z as f32);
+            max[0] = max[0].max(pos.x as f32 + 1.0);
+            max[1] = max[1].max(pos.y as f32 + 1.0);
+            max[2] = max[2].max(pos.z as f32 + 1.0);
+        }
+        Self::new(blocks, MesherBoundingBox::new(min, max))
+    }
 }
 
-impl BlockSource for ChunkBlockSource {
+impl BlockSource for ChunkBlockSource<'_> {
     fn get_block(&self, pos: MesherBlockPosition) -> Option<&InputBlock> {
         self.blocks.get(&pos)
     }
@@ -578,6 +793,344 @@ impl BlockSource for ChunkBlockSource {
     }
 }
 
+/// One region's cells, with an `InputBlock` per palette entry (`None` for air).
+struct DenseLayer<'a> {
+    region: &'a Region,
+    table: Vec<Option<InputBlock>>,
+}
+
+/// Block count and inclusive block-space extent of one occupied chunk.
+#[derive(Clone, Copy)]
+struct ChunkExtent {
+    count: usize,
+    min: [i32; 3],
+    max: [i32; 3],
+}
+
+impl ChunkExtent {
+    fn empty() -> Self {
+        Self {
+            count: 0,
+            min: [i32::MAX; 3],
+            max: [i32::MIN; 3],
+        }
+    }
+
+    fn include(&mut self, p: [i32; 3]) {
+        self.count += 1;
+        for axis in 0..3 {
+            self.min[axis] = self.min[axis].min(p[axis]);
+            self.max[axis] = self.max[axis].max(p[axis]);
+        }
+    }
+
+    /// Whether `p` lies within the extent grown by `pad` on every side.
+    fn contains(&self, p: [i32; 3], pad: i32) -> bool {
+        (0..3).all(|a| p[a] >= self.min[a] - pad && p[a] <= self.max[a] + pad)
+    }
+
+    fn bounds(&self) -> MesherBoundingBox {
+        MesherBoundingBox::new(
+            self.min.map(|v| v as f32),
+            self.max.map(|v| v as f32 + 1.0),
+        )
+    }
+}
+
+/// A schematic's blocks split into chunks, read in place from each region's
+/// palette-index cells. Building it allocates one `InputBlock` per palette
+/// entry rather than one per voxel; only entities are stored per position.
+struct DenseChunks<'a> {
+    /// Default region first; a later layer's block wins where regions overlap.
+    layers: Vec<DenseLayer<'a>>,
+    /// Occupied chunks, largest first.
+    chunks: Vec<((i32, i32, i32), ChunkExtent)>,
+    entities: HashMap<(i32, i32, i32), HashMap<MesherBlockPosition, InputBlock>>,
+}
+
+impl<'a> DenseChunks<'a> {
+    fn new(schematic: &'a UniversalSchematic, chunk_size: i32) -> Self {
+        Self::build(schematic, chunk_size, None)
+    }
+
+    /// Only the chunks in `coords`. Blocks elsewhere are still read as
+    /// neighbour padding.
+    fn covering(
+        schematic: &'a UniversalSchematic,
+        chunk_size: i32,
+        coords: &HashSet<(i32, i32, i32)>,
+    ) -> Self {
+        Self::build(schematic, chunk_size, Some(coords))
+    }
+
+    fn build(
+        schematic: &'a UniversalSchematic,
+        chunk_size: i32,
+        only: Option<&HashSet<(i32, i32, i32)>>,
+    ) -> Self {
+        let chunk_of = |x: i32, y: i32, z: i32| {
+            (
+                x.div_euclid(chunk_size),
+                y.div_euclid(chunk_size),
+                z.div_euclid(chunk_size),
+            )
+        };
+        let mut layers = Vec::with_capacity(1 + schematic.other_regions.len());
+        let mut extents: HashMap<(i32, i32, i32), ChunkExtent> = HashMap::new();
+        let mut entities: HashMap<_, HashMap<MesherBlockPosition, InputBlock>> = HashMap::new();
+
+        let regions = std::iter::once(&schematic.default_region)
+            .chain(schematic.other_regions.values());
+        for region in regions {
+            let table: Vec<Option<InputBlock>> = region
+                .palette
+                .iter()
+                .map(|state| (!is_air_state(state)).then(|| block_state_to_input_block(state)))
+                .collect();
+
+            let air = region.air_index();
+            let mut count = |bounds: &BoundingBox| {
+                for ((x, y, z), palette_index) in region.cells_ne_in(bounds, air) {
+                    if table[palette_index].is_some() {
+                        extents
+                            .entry(chunk_of(x, y, z))
+                            .or_insert_with(ChunkExtent::empty)
+                            .include([x, y, z]);
+                    }
+                }
+            };
+            match only {
+                None => region.occupied_sections().for_each(|section| count(&section)),
+                Some(coords) => {
+                    let bbox = region.get_bounding_box();
+                    for &(cx, cy, cz) in coords {
+                        let min = (cx * chunk_size, cy * chunk_size, cz * chunk_size);
+                        let max = (
+                            min.0 + chunk_size - 1,
+                            min.1 + chunk_size - 1,
+                            min.2 + chunk_size - 1,
+                        );
+                        if let Some(bounds) = BoundingBox::new(min, max).intersection(&bbox) {
+                            count(&bounds);
+                        }
+                    }
+                }
+            }
+
+            for entity in &region.entities {
+                let x = entity.position.0.floor() as i32;
+                let y = entity.position.1.floor() as i32;
+                let z = entity.position.2.floor() as i32;
+                let coord = chunk_of(x, y, z);
+                if only.is_some_and(|coords| !coords.contains(&coord)) {
+                    continue;
+                }
+                extents
+                    .entry(coord)
+                    .or_insert_with(ChunkExtent::empty)
+                    .include([x, y, z]);
+                entities
+                    .entry(coord)
+                    .or_default()
+                    .entry(MesherBlockPosition::new(x, y, z))
+                    .or_insert_with(|| entity_to_input_block(entity));
+            }
+
+            layers.push(DenseLayer { region, table });
+        }
+
+        let mut chunks: Vec<_> = extents.into_iter().collect();
+        chunks.sort_unstable_by_key(|(coord, extent)| (std::cmp::Reverse(extent.count), *coord));
+        Self {
+            layers,
+            chunks,
+            entities,
+        }
+    }
+
+    /// The non-air block at `(x, y, z)` in any region, ignoring entities.
+    fn block_at(&self, x: i32, y: i32, z: i32) -> Option<&InputBlock> {
+        let (layer, index) = self.block_entry_at(x, y, z)?;
+        self.layers[layer].table[index].as_ref()
+    }
+
+    /// Layer and palette index of the block [`Self::block_at`] returns.
+    fn block_entry_at(&self, x: i32, y: i32, z: i32) -> Option<(usize, usize)> {
+        self.layers.iter().enumerate().rev().find_map(|(i, layer)| {
+            let index = layer.region.get_block_index(x, y, z)?;
+            layer.table.get(index)?.as_ref().map(|_| (i, index))
+        })
+    }
+
+    /// A block source over the `i`th chunk of [`Self::chunks`].
+    fn source(&self, i: usize) -> DenseChunkSource<'_> {
+        let (coord, extent) = self.chunks[i];
+        DenseChunkSource {
+            chunks: self,
+            extent,
+            entities: self.entities.get(&coord),
+        }
+    }
+}
+
+/// Block source over one chunk of a [`DenseChunks`]. Blocks one cell past the
+/// chunk's extent are visible to `get_block` too, so faces against a
+/// neighbouring chunk's blocks are culled as in a whole-schematic mesh.
+struct DenseChunkSource<'a> {
+    chunks: &'a DenseChunks<'a>,
+    extent: ChunkExtent,
+    entities: Option<&'a HashMap<MesherBlockPosition, InputBlock>>,
+}
+
+impl<'a> DenseChunkSource<'a> {
+    /// The chunk's own block or entity at `pos`.
+    fn own(&self, pos: MesherBlockPosition) -> Option<&'a InputBlock> {
+        self.chunks
+            .block_at(pos.x, pos.y, pos.z)
+            .or_else(|| self.entities?.get(&pos))
+    }
+}
+
+impl BlockSource for DenseChunkSource<'_> {
+    fn get_block(&self, pos: MesherBlockPosition) -> Option<&InputBlock> {
+        let p = [pos.x, pos.y, pos.z];
+        if self.extent.contains(p, 0) {
+            self.own(pos)
+        } else if self.extent.contains(p, 1) {
+            self.chunks.block_at(pos.x, pos.y, pos.z)
+        } else {
+            None
+        }
+    }
+
+    fn iter_blocks(&self) -> Box<dyn Iterator<Item = (MesherBlockPosition, &InputBlock)> + '_> {
+        // Walking the extent in x, y, z order keeps chunk meshes deterministic.
+        let ChunkExtent { min, max, .. } = self.extent;
+        Box::new((min[0]..=max[0]).flat_map(move |x| {
+            (min[1]..=max[1]).flat_map(move |y| {
+                (min[2]..=max[2]).filter_map(move |z| {
+                    let pos = MesherBlockPosition::new(x, y, z);
+                    self.own(pos).map(|block| (pos, block))
+                })
+            })
+        }))
+    }
+
+    fn bounds(&self) -> MesherBoundingBox {
+        self.extent.bounds()
+    }
+}
+
+/// One chunk of a [`DenseChunks`] downsampled for a level of detail. Each
+/// `factor`³ cell, aligned to world multiples of `factor`, becomes one block
+/// at the cell's coarse position: the cell's most common non-air block (the
+/// first seen on a tie). Entities are left out, and neighbouring chunks are
+/// not consulted, so faces on chunk seams are kept.
+struct LodBlockSource<'a> {
+    blocks: HashMap<MesherBlockPosition, &'a InputBlock>,
+    /// Keys of `blocks` in x, y, z order.
+    order: Vec<MesherBlockPosition>,
+    bounds: MesherBoundingBox,
+}
+
+impl<'a> LodBlockSource<'a> {
+    fn new(chunks: &'a DenseChunks<'a>, extent: &ChunkExtent, factor: i32) -> Self {
+        // Distinct blocks of each cell with their counts, in first-seen order.
+        let mut cells: HashMap<MesherBlockPosition, Vec<(&'a InputBlock, u32)>> = HashMap::new();
+        let mut order = Vec::new();
+        for x in extent.min[0]..=extent.max[0] {
+            for y in extent.min[1]..=extent.max[1] {
+                for z in extent.min[2]..=extent.max[2] {
+                    let Some(block) = chunks.block_at(x, y, z) else {
+                        continue;
+                    };
+                    let cell = MesherBlockPosition::new(
+                        x.div_euclid(factor),
+                        y.div_euclid(factor),
+                        z.div_euclid(factor),
+                    );
+                    let counts = cells.entry(cell).or_insert_with(|| {
+                        order.push(cell);
+                        Vec::new()
+                    });
+                    match counts.iter_mut().find(|(b, _)| std::ptr::eq(*b, block)) {
+                        Some((_, n)) => *n += 1,
+                        None => counts.push((block, 1)),
+                    }
+                }
+            }
+        }
+        order.sort_unstable_by_key(|p| (p.x, p.y, p.z));
+
+        let blocks = cells
+            .into_iter()
+            .map(|(cell, counts)| {
+                let mut best = counts[0];
+                for &candidate in &counts[1..] {
+                    if candidate.1 > best.1 {
+                        best = candidate;
+                    }
+                }
+                (cell, best.0)
+            })
+            .collect();
+        let coarse = |v: i32| v.div_euclid(factor) as f32;
+        let bounds = MesherBoundingBox::new(
+            extent.min.map(coarse),
+            extent.max.map(|v| coarse(v) + 1.0),
+        );
+        Self {
+            blocks,
+            order,
+            bounds,
+        }
+    }
+}
+
+impl BlockSource for LodBlockSource<'_> {
+    fn get_block(&self, pos: MesherBlockPosition) -> Option<&InputBlock> {
+        self.blocks.get(&pos).copied()
+    }
+
+    fn iter_blocks(&self) -> Box<dyn Iterator<Item = (MesherBlockPosition, &InputBlock)> + '_> {
+        Box::new(self.order.iter().map(|pos| (*pos, self.blocks[pos])))
+    }
+
+    fn bounds(&self) -> MesherBoundingBox {
+        self.bounds
+    }
+}
+
+/// The levels of detail to mesh for `config`: those whose merge factor
+/// divides `chunk_size`, so no coarse cell straddles two chunks.
+fn lod_levels_for(config: &MeshConfig, chunk_size: i32) -> impl Iterator<Item = u8> {
+    (1..=config.lod_levels.min(MAX_LOD_LEVEL))
+        .filter(move |level| chunk_size % (1 << level) == 0)
+}
+
+/// Mesh chunk `i` of `dense` at `level`, scaled back to world coordinates.
+fn mesh_lod(mesher: &Mesher, dense: &DenseChunks<'_>, i: usize, level: u8) -> Result<MeshOutput> {
+    let (coord, extent) = dense.chunks[i];
+    let factor = 1i32 << level;
+    let source = LodBlockSource::new(dense, &extent, factor);
+    let output = mesher
+        .mesh(&source)
+        .map_err(|e| MeshError::Meshing(e.to_string()))?;
+    let mut mesh = mesh_output_from_mesher(output, Some(coord));
+    let scale = factor as f32;
+    for layer in [&mut mesh.opaque, &mut mesh.cutout, &mut mesh.transparent] {
+        for p in &mut layer.positions {
+            *p = p.map(|v| v * scale);
+        }
+    }
+    mesh.bounds = MesherBoundingBox::new(
+        mesh.bounds.min.map(|v| v * scale),
+        mesh.bounds.max.map(|v| v * scale),
+    );
+    mesh.lod_level = level;
+    Ok(mesh)
+}
+
 /// Flat, palette-indexed block source for whole-schematic meshing.
 ///
 /// The mesher only *iterates* the source, so a `Vec` beats a hash map (no
@@ -635,6 +1188,12 @@ impl BlockSource for VecBlockSource {
 /// `red_mushroom_block` renders the pale porous inside instead of its red cap.
 /// Seed the input with the block's canonical `default_state` first, then let
 /// any explicit properties from the schematic override it.
+/// Whether meshing skips `state`: any air block (`cave_air` and `void_air`
+/// too), by the block table's flags.
+fn is_air_state(state: &BlockState) -> bool {
+    crate::blockpedia::block_flags(&state.name).is_some_and(|f| f.is_air())
+}
+
 fn block_state_to_input_block(block_state: &BlockState) -> InputBlock {
     let mut input = InputBlock::new(block_state.name.to_string());
     if let Some(facts) = crate::blockpedia::get_block(&block_state.name) {
@@ -844,6 +1403,66 @@ pub enum MeshPhase {
     Complete,
 }
 
+/// Chunk order and culling for [`UniversalSchematic::mesh_chunks_ordered`].
+#[derive(Debug, Clone, Copy)]
+pub struct MeshOrder {
+    /// Order to mesh chunks in, as for chunk iteration.
+    /// `DistanceToCamera` meshes front to back and gives the camera position
+    /// `view` and `skip_occluded` use.
+    pub strategy: ChunkLoadingStrategy,
+    /// View direction and half field of view in radians. Chunks in that cone
+    /// from the camera come first, each group in `strategy` order.
+    pub view: Option<([f32; 3], f32)>,
+    /// Drop chunks every neighbouring cell of which is an opaque full cube:
+    /// nothing in them can be seen from outside. A chunk the camera is in or
+    /// touching is always kept.
+    pub skip_occluded: bool,
+}
+
+impl Default for MeshOrder {
+    fn default() -> Self {
+        MeshOrder {
+            strategy: ChunkLoadingStrategy::Default,
+            view: None,
+            skip_occluded: false,
+        }
+    }
+}
+
+impl MeshOrder {
+    fn camera(&self) -> Option<[f32; 3]> {
+        match self.strategy {
+            ChunkLoadingStrategy::DistanceToCamera(x, y, z) => Some([x, y, z]),
+            _ => None,
+        }
+    }
+}
+
+/// Cooperative cancellation flag for chunk meshing. Clones share the flag;
+/// meshing checks it between chunks and stops with [`MeshError::Cancelled`].
+#[derive(Clone, Debug, Default)]
+pub struct CancelToken(std::sync::Arc<std::sync::atomic::AtomicBool>);
+
+impl CancelToken {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// A token that reads and sets `flag`, e.g. a bridge job's own
+    /// cancellation flag.
+    pub(crate) fn from_flag(flag: std::sync::Arc<std::sync::atomic::AtomicBool>) -> Self {
+        Self(flag)
+    }
+
+    pub fn cancel(&self) {
+        self.0.store(true, std::sync::atomic::Ordering::Relaxed);
+    }
+
+    pub fn is_cancelled(&self) -> bool {
+        self.0.load(std::sync::atomic::Ordering::Relaxed)
+    }
+}
+
 /// Progress update emitted during chunk meshing.
 #[derive(Clone, Debug)]
 pub struct MeshProgress {
@@ -871,28 +1490,39 @@ pub fn build_global_atlas(
     pack: &ResourcePackSource,
     config: &MeshConfig,
 ) -> Result<TextureAtlas> {
-    let mesher_config = config.to_mesher_config();
-
     // Collect all unique block states from all regions' palettes
     let mut unique_states: std::collections::HashSet<BlockState> = std::collections::HashSet::new();
     for state in &schematic.default_region.palette {
-        if state.name != "minecraft:air" {
+        if !is_air_state(state) {
             unique_states.insert(state.clone());
         }
     }
     for region in schematic.other_regions.values() {
         for state in &region.palette {
-            if state.name != "minecraft:air" {
+            if !is_air_state(state) {
                 unique_states.insert(state.clone());
             }
         }
     }
 
-    // Convert unique states to InputBlocks and discover textures via the mesher
+    if unique_states.is_empty() {
+        return Ok(TextureAtlas::empty());
+    }
+    let texture_refs = discover_state_textures(unique_states.iter(), pack, config);
+    build_atlas_from_textures(&texture_refs, pack, config)
+}
+
+/// Texture references the models of `states` use, found by meshing one of
+/// each through the mesher's texture discovery.
+fn discover_state_textures<'s>(
+    states: impl Iterator<Item = &'s BlockState>,
+    pack: &ResourcePackSource,
+    config: &MeshConfig,
+) -> std::collections::BTreeSet<String> {
     // We create a small synthetic block source with one of each unique block state
     let mut blocks = HashMap::new();
     let mut pos_idx = 0i32;
-    for state in &unique_states {
+    for state in states {
         let pos = MesherBlockPosition::new(pos_idx, 0, 0);
         let input = block_state_to_input_block(state);
         blocks.insert(pos, input);
@@ -900,26 +1530,34 @@ pub fn build_global_atlas(
     }
 
     if blocks.is_empty() {
-        return Ok(TextureAtlas::empty());
+        return Default::default();
     }
 
     let bounds = MesherBoundingBox::new([0.0, 0.0, 0.0], [pos_idx as f32, 1.0, 1.0]);
 
     // Use a config with no culling for texture discovery
-    let mut discovery_config = mesher_config.clone();
+    let mut discovery_config = config.to_mesher_config();
     discovery_config.cull_hidden_faces = false;
     discovery_config.cull_occluded_blocks = false;
 
-    let source = ChunkBlockSource::new(blocks, bounds);
+    let source = ChunkBlockSource::new(&blocks, bounds);
     let mesher = Mesher::with_config(pack.pack.clone(), discovery_config);
 
-    let texture_refs = mesher.discover_textures(&source);
+    mesher.discover_textures(&source).into_iter().collect()
+}
 
-    // Build atlas from discovered textures
+/// Pack the first frame of every texture in `texture_refs` (in order) into
+/// one atlas.
+fn build_atlas_from_textures<'t>(
+    texture_refs: impl IntoIterator<Item = &'t String>,
+    pack: &ResourcePackSource,
+    config: &MeshConfig,
+) -> Result<TextureAtlas> {
+    let mesher_config = config.to_mesher_config();
     let mut atlas_builder =
         AtlasBuilder::new(mesher_config.atlas_max_size, mesher_config.atlas_padding);
 
-    for texture_ref in &texture_refs {
+    for texture_ref in texture_refs {
         if let Some(texture) = pack.pack.get_texture(texture_ref) {
             atlas_builder.add_texture(texture_ref.clone(), texture.first_frame());
         }
@@ -1061,7 +1699,7 @@ impl UniversalSchematic {
     ) -> Result<RawMeshExport> {
         let output = self.compute_mesh_output(pack, config)?;
         let raw = export_raw(&output);
-        Ok(RawMeshExport { inner: raw })
+        Ok(RawMeshExport::from_raw(raw, config.vertex_format))
     }
 
     /// Generate one mesh per region.
@@ -1115,43 +1753,15 @@ impl UniversalSchematic {
         chunk_size: i32,
     ) -> Result<ChunkMeshResult> {
         let mesher_config = config.to_mesher_config();
-
-        // Collect all blocks from all regions into chunks
-        let mut chunks: HashMap<(i32, i32, i32), HashMap<MesherBlockPosition, InputBlock>> =
-            HashMap::new();
-
-        // Process default region
-        collect_region_blocks_by_chunk(&self.default_region, &mut chunks, chunk_size);
-
-        // Process other regions
-        for region in self.other_regions.values() {
-            collect_region_blocks_by_chunk(region, &mut chunks, chunk_size);
-        }
+        let dense = DenseChunks::new(self, chunk_size);
 
         let mut meshes = HashMap::new();
+        let mut lods = Vec::new();
         let mut total_vertex_count = 0;
         let mut total_triangle_count = 0;
 
-        for (chunk_coord, blocks) in chunks {
-            if blocks.is_empty() {
-                continue;
-            }
-
-            // Calculate bounds for this chunk
-            let mut min = [f32::MAX; 3];
-            let mut max = [f32::MIN; 3];
-
-            for pos in blocks.keys() {
-                min[0] = min[0].min(pos.x as f32);
-                min[1] = min[1].min(pos.y as f32);
-                min[2] = min[2].min(pos.z as f32);
-                max[0] = max[0].max(pos.x as f32 + 1.0);
-                max[1] = max[1].max(pos.y as f32 + 1.0);
-                max[2] = max[2].max(pos.z as f32 + 1.0);
-            }
-
-            let bounds = MesherBoundingBox::new(min, max);
-            let source = ChunkBlockSource::new(blocks, bounds);
+        for (i, &(chunk_coord, _)) in dense.chunks.iter().enumerate() {
+            let source = dense.source(i);
 
             let mesher = Mesher::with_config(pack.pack.clone(), mesher_config.clone());
             let output = mesher
@@ -1163,12 +1773,17 @@ impl UniversalSchematic {
             total_vertex_count += result.total_vertices();
             total_triangle_count += result.total_triangles();
             meshes.insert(chunk_coord, result);
+
+            for level in lod_levels_for(config, chunk_size) {
+                lods.push(mesh_lod(&mesher, &dense, i, level)?);
+            }
         }
 
         Ok(ChunkMeshResult {
             meshes,
             total_vertex_count,
             total_triangle_count,
+            lods,
         })
     }
 
@@ -1209,7 +1824,7 @@ impl UniversalSchematic {
         let mesher_config = config.to_mesher_config();
         let region = region_name.and_then(|name| self.get_region(name));
         let entities = region
-            .map(|region| region.entities.clone())
+            .map(|region| region.entities.to_vec())
             .unwrap_or_else(|| self.get_entities_as_list());
         let mut out = Vec::with_capacity(groups.len());
 
@@ -1256,7 +1871,7 @@ impl UniversalSchematic {
             }
 
             let bounds = MesherBoundingBox::new(min, max);
-            let source = ChunkBlockSource::new(blocks, bounds);
+            let source = ChunkBlockSource::new(&blocks, bounds);
             let mesher = Mesher::with_config(pack.pack.clone(), mesher_config.clone());
             let output = mesher
                 .mesh(&source)
@@ -1282,11 +1897,11 @@ impl UniversalSchematic {
     ///         cx, cy, cz, mesh.total_triangles());
     /// }
     /// ```
-    /// Mesh the schematic in parallel using `std::thread::scope`.
+    /// Mesh the schematic in parallel on a work-stealing pool.
     ///
     /// Splits the schematic into chunks of `chunk_size` blocks, then meshes
-    /// each chunk on a separate thread (up to `max_threads` concurrently).
-    /// Returns all chunk meshes as a `Vec<MeshOutput>`.
+    /// them on up to `max_threads` workers, largest chunk first. Returns all
+    /// chunk meshes as a `Vec<MeshOutput>`.
     ///
     /// This is the fastest path for large schematics. Each chunk gets its own
     /// texture atlas, so the caller must handle multiple atlases when rendering.
@@ -1307,70 +1922,129 @@ impl UniversalSchematic {
         chunk_size: i32,
         max_threads: usize,
     ) -> Result<Vec<MeshOutput>> {
-        let mesher_config = config.to_mesher_config();
+        self.mesh_chunks_parallel_cancellable(
+            pack,
+            config,
+            chunk_size,
+            max_threads,
+            &CancelToken::new(),
+        )
+    }
 
-        let mut chunks: HashMap<(i32, i32, i32), HashMap<MesherBlockPosition, InputBlock>> =
-            HashMap::new();
+    /// [`mesh_chunks_parallel`](Self::mesh_chunks_parallel) that stops with
+    /// [`MeshError::Cancelled`] once `cancel` is set. The flag is checked
+    /// before each chunk, so no chunk starts after it is set; finished chunk
+    /// meshes are dropped.
+    ///
+    /// Chunks run on a work-stealing pool of `max_threads` workers, largest
+    /// first, so a dense chunk never holds up the tail of the run. Each worker
+    /// builds one mesher and reuses it for every chunk it takes. Meshes come
+    /// back in that largest-first order.
+    ///
+    /// Chunks read blocks straight from the regions' palette-index cells, and
+    /// see one cell into their neighbours so faces between chunks are culled.
+    pub fn mesh_chunks_parallel_cancellable(
+        &self,
+        pack: &ResourcePackSource,
+        config: &MeshConfig,
+        chunk_size: i32,
+        max_threads: usize,
+        cancel: &CancelToken,
+    ) -> Result<Vec<MeshOutput>> {
+        self.mesh_dense_parallel(pack, config, chunk_size, max_threads, cancel, None)
+    }
 
-        collect_region_blocks_by_chunk(&self.default_region, &mut chunks, chunk_size);
-        for region in self.other_regions.values() {
-            collect_region_blocks_by_chunk(region, &mut chunks, chunk_size);
-        }
+    /// [`mesh_chunks_parallel`](Self::mesh_chunks_parallel) that takes each
+    /// chunk from `cache` when a chunk with the same blocks, neighbour border
+    /// and config was meshed before, and adds the chunks it meshes. See
+    /// [`reuse`] for what the key covers.
+    pub fn mesh_chunks_parallel_cached(
+        &self,
+        pack: &ResourcePackSource,
+        config: &MeshConfig,
+        chunk_size: i32,
+        max_threads: usize,
+        cache: &ChunkMeshCache,
+    ) -> Result<Vec<MeshOutput>> {
+        let cancel = CancelToken::new();
+        self.mesh_dense_parallel(pack, config, chunk_size, max_threads, &cancel, Some(cache))
+    }
 
-        let chunk_list: Vec<_> = chunks.into_iter().filter(|(_, b)| !b.is_empty()).collect();
+    fn mesh_dense_parallel(
+        &self,
+        pack: &ResourcePackSource,
+        config: &MeshConfig,
+        chunk_size: i32,
+        max_threads: usize,
+        cancel: &CancelToken,
+        cache: Option<&ChunkMeshCache>,
+    ) -> Result<Vec<MeshOutput>> {
+        use rayon::prelude::*;
 
-        if chunk_list.is_empty() {
+        let mesher_config = config.to_mesher_config();
+
+        let dense = DenseChunks::new(self, chunk_size);
+        if dense.chunks.is_empty() {
             return Err(MeshError::Meshing("No blocks to mesh".to_string()));
         }
+        let stage = crate::telemetry::stage!(
+            INFO,
+            "mesh.chunks",
+            chunks = dense.chunks.len(),
+            chunk_size,
+            max_threads,
+            cached = cache.is_some()
+        );
+        crate::telemetry::count("mesh.chunks", dense.chunks.len() as u64);
+        let parent = stage.0.id();
+        if cancel.is_cancelled() {
+            return Err(MeshError::Cancelled);
+        }
+        let reuse = cache.map(|cache| cache.pass(&dense, config));
+
+        let mesh_all = || {
+            (0..dense.chunks.len())
+                .into_par_iter()
+                .map_init(
+                    || Mesher::with_config(pack.pack.clone(), mesher_config.clone()),
+                    |mesher, i| {
+                        if cancel.is_cancelled() {
+                            return Err(MeshError::Cancelled);
+                        }
+                        let coord = dense.chunks[i].0;
+                        let _stage = crate::telemetry::stage!(
+                            DEBUG,
+                            parent: parent.clone(),
+                            "mesh.chunk",
+                            x = coord.0,
+                            y = coord.1,
+                            z = coord.2
+                        );
+                        let mesh = || match mesher.mesh(&dense.source(i)) {
+                            Ok(output) => Ok(mesh_output_from_mesher(output, Some(coord))),
+                            Err(e) => Err(MeshError::Meshing(e.to_string())),
+                        };
+                        match &reuse {
+                            Some(reuse) => reuse.mesh_chunk(i, mesh),
+                            None => mesh(),
+                        }
+                    },
+                )
+                .collect::<Result<Vec<_>>>()
+        };
 
+        // The global pool serves callers that allow at least as many threads;
+        // a tighter cap gets a pool of its own.
         let max_threads = max_threads.max(1);
-        let pack_ref = &pack.pack;
-        let config_ref = &mesher_config;
-
-        // Use std::thread::scope for safe parallel meshing without extra dependencies
-        let results: Vec<Result<MeshOutput>> = std::thread::scope(|scope| {
-            let mut handles = Vec::new();
-
-            for batch in chunk_list.chunks(max_threads) {
-                let batch_handles: Vec<_> = batch
-                    .iter()
-                    .map(|(chunk_coord, blocks)| {
-                        let coord = *chunk_coord;
-                        scope.spawn(move || {
-                            let mut min = [f32::MAX; 3];
-                            let mut max = [f32::MIN; 3];
-                            for pos in blocks.keys() {
-                                min[0] = min[0].min(pos.x as f32);
-                                min[1] = min[1].min(pos.y as f32);
-                                min[2] = min[2].min(pos.z as f32);
-                                max[0] = max[0].max(pos.x as f32 + 1.0);
-                                max[1] = max[1].max(pos.y as f32 + 1.0);
-                                max[2] = max[2].max(pos.z as f32 + 1.0);
-                            }
-
-                            let bounds = MesherBoundingBox::new(min, max);
-                            let source = ChunkBlockSource::new(blocks.clone(), bounds);
-                            let mesher = Mesher::with_config(pack_ref.clone(), config_ref.clone());
-
-                            match mesher.mesh(&source) {
-                                Ok(output) => Ok(mesh_output_from_mesher(output, Some(coord))),
-                                Err(e) => Err(MeshError::Meshing(e.to_string())),
-                            }
-                        })
-                    })
-                    .collect();
-
-                // Wait for this batch to complete before spawning next batch
-                for handle in batch_handles {
-                    handles.push(handle.join().expect("Mesh thread panicked"));
-                }
-            }
-
-            handles
-        });
-
-        // Collect results, propagating first error
-        results.into_iter().collect()
+        if max_threads >= rayon::current_num_threads() {
+            mesh_all()
+        } else {
+            rayon::ThreadPoolBuilder::new()
+                .num_threads(max_threads)
+                .build()
+                .map_err(|e| MeshError::Meshing(e.to_string()))?
+                .install(mesh_all)
+        }
     }
 
     pub fn mesh_chunks(
@@ -1396,8 +2070,10 @@ impl UniversalSchematic {
             config: config.to_mesher_config(),
             shared_atlas: None,
             progress_callback: None,
+            cancel: None,
             vertices_so_far: 0,
             triangles_so_far: 0,
+            skipped: 0,
         }
     }
 
@@ -1430,12 +2106,120 @@ impl UniversalSchematic {
             config: config.to_mesher_config(),
             shared_atlas: Some(atlas),
             progress_callback: None,
+            cancel: None,
             vertices_so_far: 0,
             triangles_so_far: 0,
+            skipped: 0,
+        }
+    }
+
+    /// [`mesh_chunks`](Self::mesh_chunks) (or, with `atlas`,
+    /// [`mesh_chunks_with_atlas`](Self::mesh_chunks_with_atlas)) yielding
+    /// chunks in `order`, so a viewer streaming them shows the nearest, visible
+    /// ones first. Chunks `order` culls are counted by
+    /// [`NucleationChunkIter::skipped_count`].
+    pub fn mesh_chunks_ordered(
+        &self,
+        pack: &ResourcePackSource,
+        config: &MeshConfig,
+        chunk_size: i32,
+        atlas: Option<TextureAtlas>,
+        order: &MeshOrder,
+    ) -> NucleationChunkIter {
+        let mut iter = match atlas {
+            Some(atlas) => self.mesh_chunks_with_atlas(pack, config, chunk_size, atlas),
+            None => self.mesh_chunks(pack, config, chunk_size),
+        };
+        let camera = order.camera();
+        if order.skip_occluded {
+            let before = iter.chunks.len();
+            iter.chunks
+                .retain(|(coord, _)| !self.chunk_is_sealed(*coord, chunk_size, camera));
+            iter.skipped = before - iter.chunks.len();
+        }
+        let size = (chunk_size, chunk_size, chunk_size);
+        self.order_chunks(&mut iter.chunks, |(coord, _)| *coord, size, order.strategy);
+        if let (Some(eye), Some((forward, half_fov))) = (camera, order.view) {
+            // A stable sort, so each group keeps the strategy order.
+            iter.chunks.sort_by_key(|(coord, _)| {
+                !chunk_in_view(*coord, chunk_size, eye, forward, half_fov)
+            });
+        }
+        iter
+    }
+
+    /// Whether every cell bordering chunk `coord` from outside seals it from
+    /// view, with `camera` (if any) outside that shell.
+    fn chunk_is_sealed(
+        &self,
+        coord: (i32, i32, i32),
+        chunk_size: i32,
+        camera: Option<[f32; 3]>,
+    ) -> bool {
+        let lo = [coord.0, coord.1, coord.2].map(|c| c * chunk_size - 1);
+        let hi = lo.map(|c| c + chunk_size + 1);
+        let inside = |eye: [f32; 3]| {
+            (0..3).all(|a| eye[a] >= lo[a] as f32 && eye[a] < (hi[a] + 1) as f32)
+        };
+        if camera.is_some_and(inside) {
+            return false;
+        }
+        let seals = |x, y, z| self.get_block(x, y, z).is_some_and(seals_view);
+        for x in lo[0]..=hi[0] {
+            for y in lo[1]..=hi[1] {
+                if x == lo[0] || x == hi[0] || y == lo[1] || y == hi[1] {
+                    if !(lo[2]..=hi[2]).all(|z| seals(x, y, z)) {
+                        return false;
+                    }
+                } else if !seals(x, y, lo[2]) || !seals(x, y, hi[2]) {
+                    return false;
+                }
+            }
         }
+        true
     }
 }
 
+/// Whether a chunk, as a sphere around its centre, overlaps the cone of
+/// half angle `half_fov` from `eye` along `forward`.
+fn chunk_in_view(
+    coord: (i32, i32, i32),
+    chunk_size: i32,
+    eye: [f32; 3],
+    forward: [f32; 3],
+    half_fov: f32,
+) -> bool {
+    let size = chunk_size as f32;
+    let centre = [coord.0, coord.1, coord.2].map(|c| (c as f32 + 0.5) * size);
+    let d = [centre[0] - eye[0], centre[1] - eye[1], centre[2] - eye[2]];
+    let dist = d.iter().map(|v| v * v).sum::<f32>().sqrt();
+    let len = forward.iter().map(|f| f * f).sum::<f32>().sqrt();
+    let radius = size * 3f32.sqrt() / 2.0;
+    if dist <= radius || len == 0.0 {
+        return true;
+    }
+    let cos = (d[0] * forward[0] + d[1] * forward[1] + d[2] * forward[2]) / (dist * len);
+    cos.clamp(-1.0, 1.0).acos() <= half_fov + (radius / dist).asin()
+}
+
+/// Whether `state` is an opaque full cube, judged by name. Errs towards
+/// `false`: a wrong `false` only keeps a hidden chunk.
+fn seals_view(state: &BlockState) -> bool {
+    const FULL: &[&str] = &[
+        "stone", "_planks", "_ore", "dirt", "_bricks", "_wool", "_concrete", "terracotta",
+        "deepslate", "netherrack", "sand", "gravel", "_log", "_wood", "obsidian", "bedrock",
+        "clay", "basalt", "calcite", "tuff", "granite", "diorite", "andesite", "prismarine",
+        "_block",
+    ];
+    const NOT_FULL: &[&str] = &[
+        "slab", "stairs", "wall", "fence", "button", "pressure_plate", "glass", "ice", "leaves",
+        "slime", "honey", "grindstone", "pointed_dripstone", "redstone_wire", "_pane",
+    ];
+    let name = state.name.as_str();
+    FULL.iter().any(|suffix| name.ends_with(suffix))
+        && !NOT_FULL.iter().any(|part| name.contains(part))
+}
+
 /// Lazy iterator that yields one [`MeshOutput`] per chunk.
 ///
 /// Created by [`UniversalSchematic::mesh_chunks`] or
@@ -1453,9 +2237,13 @@ pub struct NucleationChunkIter {
     shared_atlas: Option<TextureAtlas>,
     /// Optional progress callback invoked after each chunk.
     progress_callback: Option<Box<dyn Fn(MeshProgress)>>,
+    /// Optional cancellation flag checked before each chunk.
+    cancel: Option<CancelToken>,
     /// Running totals for progress reporting.
     vertices_so_far: u64,
     triangles_so_far: u64,
+    /// Chunks dropped as occluded by [`UniversalSchematic::mesh_chunks_ordered`].
+    skipped: usize,
 }
 
 impl NucleationChunkIter {
@@ -1464,6 +2252,11 @@ impl NucleationChunkIter {
         self.chunks.len()
     }
 
+    /// Chunks left out as occluded (see [`MeshOrder::skip_occluded`]).
+    pub fn skipped_count(&self) -> usize {
+        self.skipped
+    }
+
     /// How many chunks have already been yielded.
     pub fn chunks_yielded(&self) -> usize {
         self.index
@@ -1485,6 +2278,13 @@ impl NucleationChunkIter {
     pub fn set_progress_callback(&mut self, cb: Box<dyn Fn(MeshProgress)>) {
         self.progress_callback = Some(cb);
     }
+
+    /// Stop early once `token` is cancelled: the next call to `next` frees
+    /// the remaining chunk block maps and yields one
+    /// `Err(MeshError::Cancelled)`, after which the iterator is exhausted.
+    pub fn set_cancel_token(&mut self, token: CancelToken) {
+        self.cancel = Some(token);
+    }
 }
 
 impl Iterator for NucleationChunkIter {
@@ -1494,24 +2294,16 @@ impl Iterator for NucleationChunkIter {
         if self.index >= self.chunks.len() {
             return None;
         }
+        if self.cancel.as_ref().is_some_and(CancelToken::is_cancelled) {
+            self.chunks = Vec::new();
+            self.index = 0;
+            return Some(Err(MeshError::Cancelled));
+        }
 
         let (chunk_coord, ref blocks) = self.chunks[self.index];
         self.index += 1;
 
-        // Calculate bounds for this chunk
-        let mut min = [f32::MAX; 3];
-        let mut max = [f32::MIN; 3];
-        for pos in blocks.keys() {
-            min[0] = min[0].min(pos.x as f32);
-            min[1] = min[1].min(pos.y as f32);
-            min[2] = min[2].min(pos.z as f32);
-            max[0] = max[0].max(pos.x as f32 + 1.0);
-            max[1] = max[1].max(pos.y as f32 + 1.0);
-            max[2] = max[2].max(pos.z as f32 + 1.0);
-        }
-
-        let bounds = MesherBoundingBox::new(min, max);
-        let source = ChunkBlockSource::new(blocks.clone(), bounds);
+        let source = ChunkBlockSource::fitted(blocks);
 
         // Inject shared atlas into per-chunk config if available
         let mut chunk_config = self.config.clone();
@@ -1612,7 +2404,7 @@ fn collect_region_blocks(
     let base = palette.len() as u32;
     let mut is_air: Vec<bool> = Vec::with_capacity(region.palette.len());
     for state in &region.palette {
-        is_air.push(state.name == "minecraft:air");
+        is_air.push(is_air_state(state));
         palette.push(block_state_to_input_block(state));
     }
 
@@ -1670,10 +2462,15 @@ fn collect_region_blocks_by_chunk(
     chunks: &mut HashMap<(i32, i32, i32), HashMap<MesherBlockPosition, InputBlock>>,
     chunk_size: i32,
 ) {
-    for index in 0..region.volume() {
-        let (x, y, z) = region.index_to_coords(index);
-        if let Some(block_state) = region.get_block(x, y, z) {
-            if block_state.name != "minecraft:air" {
+    // Only sections holding non-air blocks are scanned, and air runs within
+    // their rows are skipped.
+    let palette = &region.palette;
+    let air = region.air_index();
+    let is_air: Vec<bool> = palette.iter().map(is_air_state).collect();
+    for section in region.occupied_sections() {
+        for ((x, y, z), palette_index) in region.cells_ne_in(&section, air) {
+            let block_state = &palette[palette_index];
+            if !is_air[palette_index] {
                 let chunk_x = x.div_euclid(chunk_size);
                 let chunk_y = y.div_euclid(chunk_size);
                 let chunk_z = z.div_euclid(chunk_size);
@@ -1754,7 +2551,8 @@ use crate::formats::manager::SchematicExporter;
 /// A format exporter that produces mesh data (GLB, USDZ) through the FormatManager.
 ///
 /// Unlike other exporters, MeshExporter is stateful — it holds a loaded resource pack.
-/// Register it with `FormatManager::register_exporter` after loading a resource pack.
+/// Register it with `FormatManager::register_exporter` after loading a resource pack
+/// (on the shared registry, through `formats::manager::update_manager`).
 pub struct MeshExporter {
     pack: ResourcePackSource,
 }
@@ -1806,8 +2604,13 @@ impl SchematicExporter for MeshExporter {
                 let mesh = schematic
                     .to_mesh(&self.pack, &config)
                     .map_err(|e| crate::formats::error::FormatError::Parse(e.to_string()))?;
-                mesh.to_glb()
-                    .map_err(|e| crate::formats::error::FormatError::Parse(e.to_string()))
+                match config.vertex_format {
+                    VertexFormat::Float => {
+                        mesh.to_glb().map_err(|e| MeshError::Export(e.to_string()))
+                    }
+                    VertexFormat::Compact => compact::to_compact_glb(&mesh),
+                }
+                .map_err(|e| crate::formats::error::FormatError::Parse(e.to_string()))
             }
             "usdz" => {
                 let mesh = schematic
@@ -1843,6 +2646,13 @@ mod tests {
         assert!((config.ao_intensity - 0.6).abs() < 0.001);
     }
 
+    #[test]
+    fn vertex_format_is_read_from_export_settings() {
+        let config: MeshConfig = serde_json::from_str(r#"{"vertex_format":"compact"}"#).unwrap();
+        assert_eq!(config.vertex_format, VertexFormat::Compact);
+        assert_eq!(MeshConfig::default().vertex_format, VertexFormat::Float);
+    }
+
     #[test]
     fn test_block_state_to_input_block() {
         let block_state = BlockState::new("minecraft:oak_stairs".to_string())
@@ -2026,6 +2836,141 @@ mod tests {
         assert!(result.is_err());
     }
 
+    #[test]
+    fn cancelled_chunk_meshing_stops_before_the_next_chunk() {
+        let mut schematic = UniversalSchematic::new("cancel".to_string());
+        for x in 0..40 {
+            schematic.set_block(x, 0, 0, &BlockState::new("minecraft:stone".to_string()));
+        }
+        let pack = ResourcePackSource::from_resource_pack(ResourcePack::new());
+        let config = MeshConfig::default();
+        let token = CancelToken::new();
+        token.cancel();
+
+        let mut iter = schematic.mesh_chunks(&pack, &config, 16);
+        assert_eq!(iter.chunk_count(), 3);
+        iter.set_cancel_token(token.clone());
+        assert!(matches!(iter.next(), Some(Err(MeshError::Cancelled))));
+        assert!(iter.next().is_none());
+        assert_eq!(iter.size_hint(), (0, Some(0)));
+
+        let parallel = schematic.mesh_chunks_parallel_cancellable(&pack, &config, 16, 2, &token);
+        assert!(matches!(parallel, Err(MeshError::Cancelled)));
+    }
+
+    #[test]
+    fn ordered_chunks_stream_front_to_back_and_skip_sealed_ones() {
+        let mut schematic = UniversalSchematic::new("ordered".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        for x in 0..48 {
+            for y in 0..48 {
+                for z in 0..48 {
+                    schematic.set_block(x, y, z, &stone);
+                }
+            }
+        }
+        let pack = ResourcePackSource::from_resource_pack(ResourcePack::new());
+        let config = MeshConfig::default();
+        let outside = MeshOrder {
+            strategy: ChunkLoadingStrategy::DistanceToCamera(-100.0, 24.0, 24.0),
+            view: Some(([1.0, 0.0, 0.0], 0.2)),
+            skip_occluded: true,
+        };
+        let iter = schematic.mesh_chunks_ordered(&pack, &config, 16, None, &outside);
+        // Only the middle chunk of 27 is walled in on every side.
+        assert_eq!((iter.chunk_count(), iter.skipped_count()), (26, 1));
+        assert_eq!(iter.chunks[0].0, (0, 1, 1));
+        assert!(iter.chunks.iter().all(|(coord, _)| *coord != (1, 1, 1)));
+
+        let inside = MeshOrder {
+            strategy: ChunkLoadingStrategy::DistanceToCamera(24.0, 24.0, 24.0),
+            ..outside
+        };
+        let iter = schematic.mesh_chunks_ordered(&pack, &config, 16, None, &inside);
+        assert_eq!((iter.chunk_count(), iter.skipped_count()), (27, 0));
+        assert_eq!(iter.chunks[0].0, (1, 1, 1));
+    }
+
+    #[test]
+    fn dense_chunks_match_collected_chunk_blocks() {
+        let mut schematic = UniversalSchematic::new("dense".to_string());
+        for x in 0..20 {
+            for y in 0..3 {
+                let name = if y == 1 { "minecraft:glass" } else { "minecraft:stone" };
+                schematic.set_block(x, y, 0, &BlockState::new(name.to_string()));
+            }
+        }
+        schematic.set_block(5, 1, 0, &BlockState::new("minecraft:air".to_string()));
+
+        let mut collected = HashMap::new();
+        collect_region_blocks_by_chunk(&schematic.default_region, &mut collected, 16);
+        let dense = DenseChunks::new(&schematic, 16);
+        assert_eq!(dense.chunks.len(), collected.len());
+        assert_eq!(dense.chunks[0].0, (0, 0, 0), "the fuller chunk comes first");
+
+        for i in 0..dense.chunks.len() {
+            let source = dense.source(i);
+            let blocks: Vec<_> = source
+                .iter_blocks()
+                .map(|(pos, block)| ((pos.x, pos.y, pos.z), block.name.clone()))
+                .collect();
+            let mut expected: Vec<_> = collected[&dense.chunks[i].0]
+                .iter()
+                .map(|(pos, block)| ((pos.x, pos.y, pos.z), block.name.clone()))
+                .collect();
+            expected.sort();
+            assert_eq!(blocks, expected);
+        }
+
+        // The second chunk sees the first chunk's edge column, and no further.
+        let tail = dense.source(1);
+        assert!(tail.get_block(MesherBlockPosition::new(15, 0, 0)).is_some());
+        assert!(tail.get_block(MesherBlockPosition::new(14, 0, 0)).is_none());
+        assert!(dense.source(0).get_block(MesherBlockPosition::new(5, 1, 0)).is_none());
+    }
+
+    #[test]
+    fn lod_cells_take_their_most_common_block() {
+        let mut schematic = UniversalSchematic::new("lod".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        for x in 0..4 {
+            for y in 0..2 {
+                for z in 0..2 {
+                    schematic.set_block(x, y, z, &stone);
+                }
+            }
+        }
+        let glass = BlockState::new("minecraft:glass".to_string());
+        schematic.set_block(0, 0, 0, &glass);
+        schematic.set_block(2, 0, 0, &glass);
+        schematic.set_block(3, 0, 0, &glass);
+        schematic.set_block(2, 1, 0, &glass);
+        schematic.set_block(3, 1, 0, &glass);
+        schematic.set_block(5, 0, 0, &glass);
+
+        // Cell (1, 0, 0) ties four to four; glass was seen first.
+        let dense = DenseChunks::new(&schematic, 16);
+        let lod = LodBlockSource::new(&dense, &dense.chunks[0].1, 2);
+        let cells: Vec<_> = lod
+            .iter_blocks()
+            .map(|(pos, block)| ((pos.x, pos.y, pos.z), block.name.clone()))
+            .collect();
+        assert_eq!(
+            cells,
+            [
+                ((0, 0, 0), "minecraft:stone".to_string()),
+                ((1, 0, 0), "minecraft:glass".to_string()),
+                ((2, 0, 0), "minecraft:glass".to_string()),
+            ]
+        );
+        assert_eq!(lod.bounds().max, [3.0, 1.0, 1.0]);
+
+        let config = MeshConfig::default().with_lod_levels(9);
+        assert_eq!(config.lod_levels, MAX_LOD_LEVEL);
+        assert_eq!(lod_levels_for(&config, 16).collect::<Vec<_>>(), [1, 2, 3]);
+        assert_eq!(lod_levels_for(&config, 12).collect::<Vec<_>>(), [1, 2]);
+    }
+
     #[test]
     fn resource_pack_aliases_the_vanilla_armor_stand_texture_for_the_entity_mesher() {
         use schematic_mesher::resource_pack::TextureData;
@@ -2206,6 +3151,7 @@ mod tests {
             meshes: HashMap::new(),
             total_vertex_count: 0,
             total_triangle_count: 0,
+            lods: Vec::new(),
         };
         assert!(result.meshes.is_empty());
     }
@@ -0,0 +1,323 @@
+//! Binary cache of a loaded resource pack: blockstates and models as JSON,
+//! textures as decoded RGBA, so a worker skips unzipping and PNG decoding on
+//! boot. Written by [`ResourcePackSource::to_cache_bytes`] and read back by
+//! [`ResourcePackSource::from_cache_bytes`].
+//!
+//! Layout (little-endian, strings are u32 length + UTF-8):
+//!
+//! ```text
+//! magic "NUCP" | version u32 = 1
+//! | blockstate_count u32, each name | JSON
+//! | model_count u32, each name | JSON
+//! | texture_count u32, each name | width u32 | height u32 | animated u8
+//!       | frame_count u32 | raw_len u32 | lz4_len u32 | lz4 RGBA block
+//! ```
+//!
+//! Entries are sorted by name, so one pack always writes the same bytes.
+//! [`cache_name`] keys a cache by the content hash of the archive it was
+//! loaded from, for the `*_cached` loaders on
+//! [`ResourcePackSource`].
+//! Textures are compressed and decompressed in parallel, and JSON is parsed
+//! in parallel. Animated textures keep their frame strip and frame count;
+//! `.mcmeta` timing is not stored and falls back to the mesher's default.
+
+use std::io::{Cursor, Read, Write};
+#[cfg(not(target_arch = "wasm32"))]
+use std::path::Path;
+
+use rayon::prelude::*;
+use schematic_mesher::resource_pack::TextureData;
+use schematic_mesher::{BlockModel, BlockstateDefinition, ResourcePack};
+
+use super::cache::{
+    read_bytes, read_str, read_u32, read_u8, write_bytes, write_str, write_u32, write_u8,
+    CacheError,
+};
+use super::{split_resource_name, ResourcePackSource};
+
+const MAGIC: &[u8; 4] = b"NUCP";
+const VERSION: u32 = 1;
+
+/// A texture's header with its stored block, before decompression.
+struct StoredTexture<'a> {
+    name: String,
+    width: u32,
+    height: u32,
+    animated: bool,
+    frame_count: u32,
+    raw_len: u32,
+    block: &'a [u8],
+}
+
+pub(super) fn write_pack(source: &ResourcePackSource) -> Vec<u8> {
+    let sorted = |mut names: Vec<String>| {
+        names.sort_unstable();
+        names
+    };
+    let blockstates: Vec<(String, String)> = sorted(source.list_blockstates())
+        .into_iter()
+        .filter_map(|name| {
+            let json = source.get_blockstate_json(&name)?;
+            Some((name, json))
+        })
+        .collect();
+    let models: Vec<(String, String)> = sorted(source.list_models())
+        .into_iter()
+        .filter_map(|name| {
+            let json = source.get_model_json(&name)?;
+            Some((name, json))
+        })
+        .collect();
+    let textures: Vec<(String, &TextureData, Vec<u8>)> = sorted(source.list_textures())
+        .into_par_iter()
+        .filter_map(|name| {
+            let tex = source.pack.get_texture(&name)?;
+            let block = lz4_flex::block::compress(&tex.pixels);
+            Some((name, tex, block))
+        })
+        .collect();
+
+    let mut buf = Vec::new();
+    write_entries(&mut buf, &blockstates, &models, &textures)
+        .expect("writing to Vec<u8> should not fail");
+    buf
+}
+
+/// Cache entry name for a pack archive: its blake3 digest and the cache
+/// version, so a format change misses instead of misreading.
+pub(super) fn cache_name(archive: &[u8]) -> String {
+    format!("{}.v{}.nucp", blake3::hash(archive).to_hex(), VERSION)
+}
+
+/// Read a cache file, mapped read-only.
+#[cfg(not(target_arch = "wasm32"))]
+pub(super) fn read_pack_file(path: &Path) -> Result<ResourcePack, CacheError> {
+    let file = std::fs::File::open(path)?;
+    // SAFETY: the mapping is read-only and dropped before this returns, and
+    // `write_pack_file` replaces entries by renaming, never in place.
+    let map = unsafe { memmap2::Mmap::map(&file)? };
+    read_pack(&map)
+}
+
+/// Write a cache file through a temporary file and a rename, so a worker
+/// loading the same pack never maps a half-written entry.
+#[cfg(not(target_arch = "wasm32"))]
+pub(super) fn write_pack_file(path: &Path, bytes: &[u8]) -> std::io::Result<()> {
+    let tmp = path.with_extension(format!("tmp{}", std::process::id()));
+    std::fs::write(&tmp, bytes)?;
+    std::fs::rename(&tmp, path)
+}
+
+fn write_entries(
+    w: &mut impl Write,
+    blockstates: &[(String, String)],
+    models: &[(String, String)],
+    textures: &[(String, &TextureData, Vec<u8>)],
+) -> std::io::Result<()> {
+    write_bytes(w, MAGIC)?;
+    write_u32(w, VERSION)?;
+    for entries in [blockstates, models] {
+        write_u32(w, entries.len() as u32)?;
+        for (name, json) in entries {
+            write_str(w, name)?;
+            write_str(w, json)?;
+        }
+    }
+    write_u32(w, textures.len() as u32)?;
+    for (name, tex, block) in textures {
+        write_str(w, name)?;
+        write_u32(w, tex.width)?;
+        write_u32(w, tex.height)?;
+        write_u8(w, tex.is_animated as u8)?;
+        write_u32(w, tex.frame_count)?;
+        write_u32(w, tex.pixels.len() as u32)?;
+        write_u32(w, block.len() as u32)?;
+        write_bytes(w, block)?;
+    }
+    Ok(())
+}
+
+pub(super) fn read_pack(data: &[u8]) -> Result<ResourcePack, CacheError> {
+    let mut r = Cursor::new(data);
+    if read_bytes(&mut r, 4)? != MAGIC {
+        return Err(CacheError::InvalidMagic);
+    }
+    let version = read_u32(&mut r)?;
+    if version != VERSION {
+        return Err(CacheError::UnsupportedVersion(version));
+    }
+    let blockstates = read_json_entries(&mut r)?;
+    let models = read_json_entries(&mut r)?;
+    let mut stored = Vec::new();
+    for _ in 0..read_u32(&mut r)? {
+        let name = read_str(&mut r)?;
+        let width = read_u32(&mut r)?;
+        let height = read_u32(&mut r)?;
+        let animated = read_u8(&mut r)? != 0;
+        let frame_count = read_u32(&mut r)?;
+        let raw_len = read_u32(&mut r)?;
+        let block_len = read_u32(&mut r)? as usize;
+        // Borrow the block instead of copying it; it is decompressed below.
+        let start = r.position() as usize;
+        let block = data
+            .get(start..start + block_len)
+            .ok_or_else(|| CacheError::InvalidData(format!("texture {name} runs past the end")))?;
+        r.set_position((start + block_len) as u64);
+        stored.push(StoredTexture {
+            name,
+            width,
+            height,
+            animated,
+            frame_count,
+            raw_len,
+            block,
+        });
+    }
+
+    let blockstates = blockstates
+        .into_par_iter()
+        .map(|(name, json)| Ok((parse::<BlockstateDefinition>(&name, &json)?, name)))
+        .collect::<Result<Vec<_>, CacheError>>()?;
+    let models = models
+        .into_par_iter()
+        .map(|(name, json)| Ok((parse::<BlockModel>(&name, &json)?, name)))
+        .collect::<Result<Vec<_>, CacheError>>()?;
+    let textures = stored
+        .into_par_iter()
+        .map(decode_texture)
+        .collect::<Result<Vec<_>, CacheError>>()?;
+
+    let mut pack = ResourcePack::new();
+    for (def, name) in blockstates {
+        let (namespace, path) = resource_name(&name)?;
+        pack.add_blockstate(&namespace, &path, def);
+    }
+    for (model, name) in models {
+        let (namespace, path) = resource_name(&name)?;
+        pack.add_model(&namespace, &path, model);
+    }
+    for (texture, name) in textures {
+        let (namespace, path) = resource_name(&name)?;
+        pack.add_texture(&namespace, &path, texture);
+    }
+    Ok(pack)
+}
+
+fn decode_texture(stored: StoredTexture<'_>) -> Result<(TextureData, String), CacheError> {
+    let pixels = lz4_flex::block::decompress(stored.block, stored.raw_len as usize)
+        .map_err(|e| CacheError::InvalidData(format!("texture {}: {e}", stored.name)))?;
+    let expected = stored.width as usize * stored.height as usize * 4;
+    if pixels.len() != expected {
+        return Err(CacheError::InvalidData(format!(
+            "texture {}: {} bytes for {}x{}",
+            stored.name,
+            pixels.len(),
+            stored.width,
+            stored.height
+        )));
+    }
+    let mut texture = TextureData::new(stored.width, stored.height, pixels);
+    texture.is_animated = stored.animated;
+    texture.frame_count = stored.frame_count;
+    Ok((texture, stored.name))
+}
+
+fn read_json_entries(r: &mut impl Read) -> Result<Vec<(String, String)>, CacheError> {
+    (0..read_u32(r)?)
+        .map(|_| Ok((read_str(r)?, read_str(r)?)))
+        .collect()
+}
+
+fn parse<T: serde::de::DeserializeOwned>(name: &str, json: &str) -> Result<T, CacheError> {
+    serde_json::from_str(json).map_err(|e| CacheError::InvalidData(format!("{name}: {e}")))
+}
+
+fn resource_name(name: &str) -> Result<(String, String), CacheError> {
+    split_resource_name(name).map_err(|e| CacheError::InvalidData(e.to_string()))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn packs_roundtrip_through_the_cache() {
+        let mut source = ResourcePackSource::from_resource_pack(ResourcePack::new());
+        source
+            .add_blockstate_json(
+                "minecraft:stone",
+                r#"{"variants":{"":{"model":"block/stone"}}}"#,
+            )
+            .unwrap();
+        source
+            .add_model_json(
+                "minecraft:block/stone",
+                r#"{"parent":"block/cube_all","textures":{"all":"block/stone"}}"#,
+            )
+            .unwrap();
+        source
+            .add_texture(
+                "minecraft:block/stone",
+                2,
+                1,
+                vec![1, 2, 3, 255, 4, 5, 6, 255],
+            )
+            .unwrap();
+
+        let bytes = source.to_cache_bytes();
+        let loaded = ResourcePackSource::from_cache_bytes(&bytes).unwrap();
+        assert_eq!(loaded.fingerprint(), source.fingerprint());
+        assert_eq!(loaded.to_cache_bytes(), bytes);
+        assert_eq!(
+            loaded.get_texture_pixels("minecraft:block/stone"),
+            Some(&[1, 2, 3, 255, 4, 5, 6, 255][..])
+        );
+
+        let truncated = &bytes[..bytes.len() - 3];
+        assert!(ResourcePackSource::from_cache_bytes(truncated).is_err());
+        assert!(matches!(
+            ResourcePackSource::from_cache_bytes(b"NUCM"),
+            Err(CacheError::InvalidMagic)
+        ));
+    }
+
+    fn pack_zip(model: &str) -> Vec<u8> {
+        let mut out = Cursor::new(Vec::new());
+        let mut zip = zip::ZipWriter::new(&mut out);
+        let options = zip::write::SimpleFileOptions::default();
+        zip.start_file("pack.mcmeta", options).unwrap();
+        zip.write_all(br#"{"pack":{"pack_format":46,"description":""}}"#)
+            .unwrap();
+        zip.start_file("assets/minecraft/blockstates/stone.json", options)
+            .unwrap();
+        zip.write_all(format!(r#"{{"variants":{{"":{{"model":"{model}"}}}}}}"#).as_bytes())
+            .unwrap();
+        zip.finish().unwrap();
+        out.into_inner()
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn pack_loads_are_cached_by_archive_content() {
+        let dir = std::env::temp_dir().join(format!("nuc-packcache-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        let stone = pack_zip("block/stone");
+        let loaded = ResourcePackSource::from_bytes_cached(&stone, &dir).unwrap();
+        let entry = dir.join(cache_name(&stone));
+        assert!(entry.is_file());
+
+        // A hit is served from the entry: plant another pack's cache there.
+        let granite = ResourcePackSource::from_bytes(&pack_zip("block/granite")).unwrap();
+        std::fs::write(&entry, granite.to_cache_bytes()).unwrap();
+        let hit = ResourcePackSource::from_bytes_cached(&stone, &dir).unwrap();
+        assert_eq!(hit.fingerprint(), granite.fingerprint());
+        assert_ne!(hit.fingerprint(), loaded.fingerprint());
+
+        // A corrupt entry is rebuilt.
+        std::fs::write(&entry, b"NUCP").unwrap();
+        let rebuilt = ResourcePackSource::from_bytes_cached(&stone, &dir).unwrap();
+        assert_eq!(rebuilt.fingerprint(), loaded.fingerprint());
+        assert_eq!(std::fs::read(&entry).unwrap(), loaded.to_cache_bytes());
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+}
@@ -0,0 +1,410 @@
+//! [`ChunkMeshCache`]: chunk meshes keyed by what they were meshed from, so
+//! a chunk whose blocks repeat elsewhere — in the same schematic, another
+//! schematic, or another process sharing a [`Store`] — is meshed once.
+//!
+//! A key is the blake3 hash of:
+//! - the pack id and the [`MeshConfig`], as JSON;
+//! - the size of the chunk's occupied extent;
+//! - every cell of that extent grown by one, so the neighbour border that
+//!   face culling and ambient occlusion read is part of the key. Cells are
+//!   hashed by block state, not palette index, so keys match across
+//!   schematics;
+//! - the chunk's entities, by position within the extent.
+//!
+//! Meshes are kept relative to the extent's minimum corner and moved into
+//! place on every hit, so a repeat anywhere in the world, not only at the
+//! same chunk offset, is a hit. Each mesh keeps the atlas it was meshed with.
+//! Block models that pick a random variant by position get the variant of
+//! the first occurrence.
+//!
+//! Hits are looked up in memory (least recently used eviction past
+//! [`ChunkMeshCache::with_max_entries`]), then in the store. A failing store
+//! is logged and treated as a miss: the chunk is meshed as if uncached.
+
+use std::collections::{BTreeMap, HashMap};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+
+use schematic_mesher::InputBlock;
+
+use super::cache::{serialize_meshes_v3, MeshCache, V3Options};
+use super::{DenseChunks, MeshConfig, MeshOutput, Result};
+use crate::store::Store;
+
+/// Default [`ChunkMeshCache::with_max_entries`].
+pub const DEFAULT_MAX_ENTRIES: usize = 4096;
+
+type Key = [u8; 32];
+
+/// Lookups since the cache was built.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct ReuseStats {
+    /// Chunks served from memory.
+    pub memory_hits: u64,
+    /// Chunks served from the store.
+    pub store_hits: u64,
+    /// Chunks meshed.
+    pub misses: u64,
+}
+
+#[derive(Default)]
+struct Memory {
+    meshes: HashMap<Key, (Arc<MeshOutput>, u64)>,
+    /// `tick -> key`, oldest first.
+    order: BTreeMap<u64, Key>,
+    clock: u64,
+}
+
+impl Memory {
+    fn get(&mut self, key: &Key) -> Option<Arc<MeshOutput>> {
+        self.clock += 1;
+        let (mesh, tick) = self.meshes.get_mut(key)?;
+        self.order.remove(tick);
+        *tick = self.clock;
+        self.order.insert(self.clock, *key);
+        Some(mesh.clone())
+    }
+
+    fn insert(&mut self, key: Key, mesh: Arc<MeshOutput>, max_entries: usize) {
+        self.clock += 1;
+        if let Some((_, tick)) = self.meshes.insert(key, (mesh, self.clock)) {
+            self.order.remove(&tick);
+        }
+        self.order.insert(self.clock, key);
+        while self.meshes.len() > max_entries {
+            let Some((_, victim)) = self.order.pop_first() else {
+                break;
+            };
+            self.meshes.remove(&victim);
+        }
+    }
+}
+
+/// Chunk meshes shared by content. Pass one to
+/// [`UniversalSchematic::mesh_chunks_parallel_cached`](crate::UniversalSchematic::mesh_chunks_parallel_cached);
+/// it is safe to share across threads and calls.
+pub struct ChunkMeshCache {
+    pack_id: String,
+    max_entries: usize,
+    memory: Mutex<Memory>,
+    store: Option<(Arc<dyn Store>, String)>,
+    memory_hits: AtomicU64,
+    store_hits: AtomicU64,
+    misses: AtomicU64,
+}
+
+impl ChunkMeshCache {
+    /// An in-memory cache for meshes made with the pack named `pack_id`.
+    /// Every distinct pack content needs a distinct id; see
+    /// [`ResourcePackSource::fingerprint`](super::ResourcePackSource::fingerprint).
+    pub fn new(pack_id: impl Into<String>) -> Self {
+        Self {
+            pack_id: pack_id.into(),
+            max_entries: DEFAULT_MAX_ENTRIES,
+            memory: Mutex::new(Memory::default()),
+            store: None,
+            memory_hits: AtomicU64::new(0),
+            store_hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        }
+    }
+
+    /// Also keep meshes in `store`, as v3 `.nucm` objects under `prefix`.
+    pub fn with_store(mut self, store: Arc<dyn Store>, prefix: impl Into<String>) -> Self {
+        self.store = Some((store, prefix.into()));
+        self
+    }
+
+    /// Keep at most `max_entries` meshes in memory (at least 1).
+    pub fn with_max_entries(mut self, max_entries: usize) -> Self {
+        self.max_entries = max_entries.max(1);
+        self
+    }
+
+    pub fn stats(&self) -> ReuseStats {
+        ReuseStats {
+            memory_hits: self.memory_hits.load(Ordering::Relaxed),
+            store_hits: self.store_hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+        }
+    }
+
+    /// Meshes held in memory.
+    pub fn len(&self) -> usize {
+        self.lock().meshes.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    fn lock(&self) -> std::sync::MutexGuard<'_, Memory> {
+        self.memory.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// Start a meshing pass over `dense` with `config`.
+    pub(super) fn pass<'c>(
+        &'c self,
+        dense: &'c DenseChunks<'c>,
+        config: &MeshConfig,
+    ) -> ReusePass<'c> {
+        let mut salt = blake3::Hasher::new();
+        salt.update(self.pack_id.as_bytes());
+        salt.update(&[0]);
+        salt.update(&serde_json::to_vec(config).unwrap_or_default());
+        let digests = dense
+            .layers
+            .iter()
+            .map(|layer| {
+                layer
+                    .table
+                    .iter()
+                    .map(|block| block.as_ref().map(block_digest))
+                    .collect()
+            })
+            .collect();
+        ReusePass {
+            cache: self,
+            dense,
+            salt: *salt.finalize().as_bytes(),
+            digests,
+        }
+    }
+
+    fn lookup(&self, key: &Key) -> Option<Arc<MeshOutput>> {
+        if let Some(mesh) = self.lock().get(key) {
+            self.memory_hits.fetch_add(1, Ordering::Relaxed);
+            return Some(mesh);
+        }
+        let (store, prefix) = self.store.as_ref()?;
+        let object = store_key(prefix, key);
+        let bytes = match store.get(&object) {
+            Ok(bytes) => bytes?,
+            Err(e) => {
+                log::warn!("chunk mesh cache: reading {object}: {e}");
+                return None;
+            }
+        };
+        let mesh = match MeshCache::parse(bytes.as_slice()).and_then(|cache| cache.chunk(0)) {
+            Ok(mesh) => Arc::new(mesh),
+            Err(e) => {
+                log::warn!("chunk mesh cache: decoding {object}: {e}");
+                return None;
+            }
+        };
+        self.store_hits.fetch_add(1, Ordering::Relaxed);
+        self.lock().insert(*key, mesh.clone(), self.max_entries);
+        Some(mesh)
+    }
+
+    fn insert(&self, key: Key, mesh: Arc<MeshOutput>) {
+        if let Some((store, prefix)) = &self.store {
+            let object = store_key(prefix, &key);
+            let bytes = serialize_meshes_v3(std::slice::from_ref(&*mesh), V3Options::default());
+            if let Err(e) = store.put_if_absent(&object, &bytes) {
+                log::warn!("chunk mesh cache: writing {object}: {e}");
+            }
+        }
+        self.lock().insert(key, mesh, self.max_entries);
+    }
+}
+
+fn store_key(prefix: &str, key: &Key) -> String {
+    format!("{prefix}{}.nucm", blake3::Hash::from(*key).to_hex())
+}
+
+/// A block's state, hashed independently of any palette.
+fn block_digest(block: &InputBlock) -> [u8; 8] {
+    let mut properties: Vec<_> = block.properties.iter().collect();
+    properties.sort();
+    let mut h = blake3::Hasher::new();
+    h.update(block.name.as_bytes());
+    for (key, value) in properties {
+        h.update(&[0]);
+        h.update(key.as_bytes());
+        h.update(&[1]);
+        h.update(value.as_bytes());
+    }
+    h.finalize().as_bytes()[..8].try_into().unwrap()
+}
+
+/// One meshing pass through a [`ChunkMeshCache`].
+pub(super) struct ReusePass<'c> {
+    cache: &'c ChunkMeshCache,
+    dense: &'c DenseChunks<'c>,
+    salt: Key,
+    /// Per layer, per palette entry: the block's digest, `None` for air.
+    digests: Vec<Vec<Option<[u8; 8]>>>,
+}
+
+impl ReusePass<'_> {
+    /// The mesh of chunk `i`, from the cache or from `mesh` on a miss.
+    pub(super) fn mesh_chunk(
+        &self,
+        i: usize,
+        mesh: impl FnOnce() -> Result<MeshOutput>,
+    ) -> Result<MeshOutput> {
+        let (coord, extent) = self.dense.chunks[i];
+        let anchor = extent.min.map(|v| v as f32);
+        let key = self.key(i);
+        if let Some(cached) = self.cache.lookup(&key) {
+            let mut placed = (*cached).clone();
+            translate(&mut placed, anchor);
+            placed.chunk_coord = Some(coord);
+            return Ok(placed);
+        }
+
+        self.cache.misses.fetch_add(1, Ordering::Relaxed);
+        let output = mesh()?;
+        let mut relative = output.clone();
+        translate(&mut relative, anchor.map(|v| -v));
+        relative.chunk_coord = None;
+        self.cache.insert(key, Arc::new(relative));
+        Ok(output)
+    }
+
+    fn key(&self, i: usize) -> Key {
+        let (coord, extent) = self.dense.chunks[i];
+        let (min, max) = (extent.min, extent.max);
+        let mut h = blake3::Hasher::new();
+        h.update(&self.salt);
+        for axis in 0..3 {
+            h.update(&(max[axis] - min[axis]).to_le_bytes());
+        }
+        for x in min[0] - 1..=max[0] + 1 {
+            for y in min[1] - 1..=max[1] + 1 {
+                for z in min[2] - 1..=max[2] + 1 {
+                    match self.dense.block_entry_at(x, y, z) {
+                        Some((layer, index)) => {
+                            h.update(&[1]);
+                            h.update(&self.digests[layer][index].unwrap_or_default());
+                        }
+                        None => {
+                            h.update(&[0]);
+                        }
+                    }
+                }
+            }
+        }
+        if let Some(entities) = self.dense.entities.get(&coord) {
+            let mut placed: Vec<_> = entities
+                .iter()
+                .map(|(pos, block)| {
+                    let offset = [pos.x - min[0], pos.y - min[1], pos.z - min[2]];
+                    (offset, block_digest(block))
+                })
+                .collect();
+            placed.sort_unstable();
+            for (offset, digest) in placed {
+                for v in offset {
+                    h.update(&v.to_le_bytes());
+                }
+                h.update(&digest);
+            }
+        }
+        *h.finalize().as_bytes()
+    }
+}
+
+/// Move every vertex and the bounds of `mesh` by `by`.
+fn translate(mesh: &mut MeshOutput, by: [f32; 3]) {
+    for layer in [&mut mesh.opaque, &mut mesh.cutout, &mut mesh.transparent] {
+        for p in &mut layer.positions {
+            for axis in 0..3 {
+                p[axis] += by[axis];
+            }
+        }
+    }
+    for axis in 0..3 {
+        mesh.bounds.min[axis] += by[axis];
+        mesh.bounds.max[axis] += by[axis];
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::meshing::ResourcePackSource;
+    use crate::store::MemStore;
+    use crate::{BlockState, UniversalSchematic};
+    use schematic_mesher::ResourcePack;
+
+    fn stamped(offsets: &[i32]) -> UniversalSchematic {
+        let mut schematic = UniversalSchematic::new("stamps".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        for &dx in offsets {
+            schematic.set_block(dx + 2, 1, 2, &stone);
+            schematic.set_block(dx + 3, 1, 2, &glass);
+            schematic.set_block(dx + 2, 2, 2, &stone);
+        }
+        schematic
+    }
+
+    #[test]
+    fn repeated_chunks_are_meshed_once_and_moved_into_place() {
+        let pack = ResourcePackSource::from_resource_pack(ResourcePack::new());
+        let config = MeshConfig::default();
+        let cache = ChunkMeshCache::new("empty-pack");
+
+        // One worker, so no two workers miss the same key at once.
+        let schematic = stamped(&[0, 16, 32, 64]);
+        let mut cached = schematic
+            .mesh_chunks_parallel_cached(&pack, &config, 16, 1, &cache)
+            .unwrap();
+        assert_eq!(cache.stats().misses, 1);
+        assert_eq!(cache.stats().memory_hits, 3);
+
+        let mut fresh = schematic
+            .mesh_chunks_parallel(&pack, &config, 16, 1)
+            .unwrap();
+        for meshes in [&mut cached, &mut fresh] {
+            meshes.sort_by_key(|m| m.chunk_coord);
+        }
+        for (a, b) in cached.iter().zip(&fresh) {
+            assert_eq!(a.chunk_coord, b.chunk_coord);
+            assert_eq!(a.opaque.positions, b.opaque.positions);
+            assert_eq!(a.bounds.min, b.bounds.min);
+        }
+
+        // The same chunk interior against a different neighbour is a
+        // different key.
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let mut lone = UniversalSchematic::new("lone".to_string());
+        lone.set_block(15, 1, 2, &stone);
+        lone.mesh_chunks_parallel_cached(&pack, &config, 16, 1, &cache)
+            .unwrap();
+        assert_eq!(cache.stats().misses, 2);
+        let mut bordered = lone.clone();
+        bordered.set_block(16, 1, 2, &BlockState::new("minecraft:glass".to_string()));
+        bordered
+            .mesh_chunks_parallel_cached(&pack, &config, 16, 1, &cache)
+            .unwrap();
+        assert_eq!(cache.stats().misses, 4);
+    }
+
+    #[test]
+    fn meshes_are_shared_through_the_store() {
+        let pack = ResourcePackSource::from_resource_pack(ResourcePack::new());
+        let config = MeshConfig::default();
+        let store: Arc<dyn Store> = Arc::new(MemStore::new());
+        let first = ChunkMeshCache::new("p").with_store(store.clone(), "meshes/");
+        stamped(&[0])
+            .mesh_chunks_parallel_cached(&pack, &config, 16, 1, &first)
+            .unwrap();
+        assert_eq!(store.list("meshes/").unwrap().len(), 1);
+
+        // A fresh process (empty memory) finds it in the store; a different
+        // pack id does not.
+        let second = ChunkMeshCache::new("p").with_store(store.clone(), "meshes/");
+        stamped(&[48])
+            .mesh_chunks_parallel_cached(&pack, &config, 16, 1, &second)
+            .unwrap();
+        assert_eq!(second.stats().store_hits, 1);
+        let other = ChunkMeshCache::new("q").with_store(store, "meshes/");
+        stamped(&[0])
+            .mesh_chunks_parallel_cached(&pack, &config, 16, 1, &other)
+            .unwrap();
+        assert_eq!(other.stats().misses, 1);
+    }
+}
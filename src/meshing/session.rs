@@ -0,0 +1,315 @@
+//! [`MeshSession`]: per-chunk meshes of a schematic kept up to date across
+//! edits, so an editor remeshes only the chunks a stroke touched.
+//!
+//! Edits are found through [`Region::take_changed_cells`]. Each box of
+//! written cells is grown by one cell before it is mapped to chunks, because
+//! face culling and ambient occlusion read one cell into the neighbouring
+//! chunk. The session owns the change marks: pairing it with another
+//! consumer of them on the same schematic (a checkpoint log) hides edits from
+//! both.
+//!
+//! All chunks are meshed against one shared [`PackAtlas`], built from the
+//! region palettes or handed in by [`MeshSession::with_atlas`]. A block state
+//! the atlas has not seen extends it; only if that brings in a new texture is
+//! the atlas repacked and everything remeshed, as it is for a region that was
+//! added, removed or resized. Entity edits are not tracked; call
+//! [`MeshSession::remesh_all`] after them.
+
+use std::collections::{HashMap, HashSet};
+
+use rayon::prelude::*;
+use schematic_mesher::{Mesher, MesherConfig, ResourcePack, TextureAtlas};
+
+use super::{
+    mesh_output_from_mesher, ChunkMeshResult, DenseChunks, MeshConfig, MeshError, MeshOutput,
+    PackAtlas, ResourcePackSource, Result,
+};
+use crate::bounding_box::BoundingBox;
+use crate::{Region, UniversalSchematic};
+
+type ChunkCoord = (i32, i32, i32);
+
+/// Per-chunk meshes of one schematic, remeshed incrementally by
+/// [`MeshSession::update`].
+pub struct MeshSession {
+    pack: ResourcePack,
+    /// The atlas's config with the atlas itself filled in.
+    mesher_config: MesherConfig,
+    chunk_size: i32,
+    atlas: PackAtlas,
+    /// Name and box of every region the meshes were built from, by key.
+    regions: HashMap<String, (String, BoundingBox)>,
+    meshes: HashMap<ChunkCoord, MeshOutput>,
+}
+
+impl MeshSession {
+    /// Mesh all of `schematic` in `chunk_size` chunks and start tracking its
+    /// edits.
+    pub fn new(
+        schematic: &mut UniversalSchematic,
+        pack: &ResourcePackSource,
+        config: &MeshConfig,
+        chunk_size: i32,
+    ) -> Result<Self> {
+        Self::with_atlas(schematic, pack, PackAtlas::empty(config, ""), chunk_size)
+    }
+
+    /// [`MeshSession::new`] starting from a prebuilt atlas (one from
+    /// [`PackAtlas::build`] or [`PackAtlas::load`]), whose config meshes the
+    /// chunks. The atlas is extended, never rebuilt.
+    pub fn with_atlas(
+        schematic: &mut UniversalSchematic,
+        pack: &ResourcePackSource,
+        atlas: PackAtlas,
+        chunk_size: i32,
+    ) -> Result<Self> {
+        if chunk_size <= 0 {
+            return Err(MeshError::Meshing(format!(
+                "chunk size must be positive, got {chunk_size}"
+            )));
+        }
+        let mut session = MeshSession {
+            pack: pack.pack.clone(),
+            mesher_config: atlas.config().to_mesher_config(),
+            chunk_size,
+            atlas,
+            regions: HashMap::new(),
+            meshes: HashMap::new(),
+        };
+        session.remesh_all_from(schematic, pack)?;
+        Ok(session)
+    }
+
+    /// Remesh the chunks edited since the last call (or since
+    /// [`MeshSession::new`]) and return their coordinates, sorted. A chunk
+    /// that became empty is dropped and still reported.
+    pub fn update(
+        &mut self,
+        schematic: &mut UniversalSchematic,
+        pack: &ResourcePackSource,
+    ) -> Result<Vec<ChunkCoord>> {
+        let Some(dirty) = self.take_dirty_chunks(schematic) else {
+            return self.remesh_all_from(schematic, pack);
+        };
+        if self.atlas.extend_for_schematic(schematic, pack)? {
+            return self.remesh_all_from(schematic, pack);
+        }
+        if dirty.is_empty() {
+            return Ok(Vec::new());
+        }
+
+        let dense = DenseChunks::covering(schematic, self.chunk_size, &dirty);
+        let fresh = self.mesh(&dense)?;
+        let mut changed: Vec<ChunkCoord> = dirty
+            .into_iter()
+            .filter(|coord| self.meshes.remove(coord).is_some() || fresh.contains_key(coord))
+            .collect();
+        changed.sort_unstable();
+        self.meshes.extend(fresh);
+        Ok(changed)
+    }
+
+    /// Remesh every chunk, extending the atlas first, and return the
+    /// coordinates of every chunk meshed before or now, sorted.
+    pub fn remesh_all(
+        &mut self,
+        schematic: &mut UniversalSchematic,
+        pack: &ResourcePackSource,
+    ) -> Result<Vec<ChunkCoord>> {
+        self.remesh_all_from(schematic, pack)
+    }
+
+    /// The current mesh of every non-empty chunk.
+    pub fn meshes(&self) -> &HashMap<ChunkCoord, MeshOutput> {
+        &self.meshes
+    }
+
+    /// The atlas every chunk mesh samples.
+    pub fn atlas(&self) -> &TextureAtlas {
+        self.atlas.atlas()
+    }
+
+    /// The atlas with the states it covers, to save for the next session.
+    pub fn pack_atlas(&self) -> &PackAtlas {
+        &self.atlas
+    }
+
+    pub fn chunk_size(&self) -> i32 {
+        self.chunk_size
+    }
+
+    /// A snapshot of the current meshes.
+    pub fn to_chunk_mesh_result(&self) -> ChunkMeshResult {
+        ChunkMeshResult {
+            meshes: self.meshes.clone(),
+            total_vertex_count: self.meshes.values().map(MeshOutput::total_vertices).sum(),
+            total_triangle_count: self.meshes.values().map(MeshOutput::total_triangles).sum(),
+            lods: Vec::new(),
+        }
+    }
+
+    fn remesh_all_from(
+        &mut self,
+        schematic: &mut UniversalSchematic,
+        pack: &ResourcePackSource,
+    ) -> Result<Vec<ChunkCoord>> {
+        // Clear the change marks first: everything is remeshed below.
+        self.regions = regions_mut(schematic)
+            .map(|(key, region)| {
+                region.take_changed_cells();
+                (
+                    key.clone(),
+                    (region.name.clone(), region.get_bounding_box()),
+                )
+            })
+            .collect();
+        self.atlas.extend_for_schematic(schematic, pack)?;
+        self.mesher_config.pre_built_atlas = Some(self.atlas.atlas().clone());
+
+        let dense = DenseChunks::new(schematic, self.chunk_size);
+        let fresh = self.mesh(&dense)?;
+        let mut changed: Vec<ChunkCoord> =
+            self.meshes.keys().chain(fresh.keys()).copied().collect();
+        changed.sort_unstable();
+        changed.dedup();
+        self.meshes = fresh;
+        Ok(changed)
+    }
+
+    /// Chunks holding or bordering a cell written since the last call, or
+    /// `None` if the regions were added, removed or relaid out.
+    fn take_dirty_chunks(
+        &mut self,
+        schematic: &mut UniversalSchematic,
+    ) -> Option<HashSet<ChunkCoord>> {
+        let mut dirty = HashSet::new();
+        let mut seen = 0;
+        let mut relaid = false;
+        for (key, region) in regions_mut(schematic) {
+            // Every region is drained, even after a relayout is found, so the
+            // next call starts clean.
+            let written = region.take_changed_cells();
+            let known =
+                self.regions.get(key) == Some(&(region.name.clone(), region.get_bounding_box()));
+            seen += 1;
+            match written.filter(|_| known) {
+                Some(boxes) => {
+                    for cells in boxes {
+                        self.mark_around(&cells, &mut dirty);
+                    }
+                }
+                None => relaid = true,
+            }
+        }
+        (!relaid && seen == self.regions.len()).then_some(dirty)
+    }
+
+    /// Mark every chunk `cells`, grown by one cell, overlaps.
+    fn mark_around(&self, cells: &BoundingBox, dirty: &mut HashSet<ChunkCoord>) {
+        let lo = |v: i32| (v - 1).div_euclid(self.chunk_size);
+        let hi = |v: i32| (v + 1).div_euclid(self.chunk_size);
+        let (min, max) = (cells.min, cells.max);
+        for cx in lo(min.0)..=hi(max.0) {
+            for cy in lo(min.1)..=hi(max.1) {
+                for cz in lo(min.2)..=hi(max.2) {
+                    dirty.insert((cx, cy, cz));
+                }
+            }
+        }
+    }
+
+    /// Mesh every chunk of `dense` against the shared atlas, one mesher per
+    /// worker.
+    fn mesh(&self, dense: &DenseChunks<'_>) -> Result<HashMap<ChunkCoord, MeshOutput>> {
+        (0..dense.chunks.len())
+            .into_par_iter()
+            .map_init(
+                || Mesher::with_config(self.pack.clone(), self.mesher_config.clone()),
+                |mesher, i| {
+                    let coord = dense.chunks[i].0;
+                    let output = mesher
+                        .mesh(&dense.source(i))
+                        .map_err(|e| MeshError::Meshing(e.to_string()))?;
+                    Ok((coord, mesh_output_from_mesher(output, Some(coord))))
+                },
+            )
+            .collect()
+    }
+}
+
+/// Every region by key, default first.
+fn regions_mut(
+    schematic: &mut UniversalSchematic,
+) -> impl Iterator<Item = (&String, &mut Region)> + '_ {
+    std::iter::once((
+        &schematic.default_region_name,
+        &mut schematic.default_region,
+    ))
+    .chain(schematic.other_regions.iter_mut())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::BlockState;
+
+    fn stone() -> BlockState {
+        BlockState::new("minecraft:stone".to_string())
+    }
+
+    fn empty_pack() -> ResourcePackSource {
+        ResourcePackSource::from_resource_pack(ResourcePack::new())
+    }
+
+    #[test]
+    fn edits_remesh_only_touched_chunks_and_their_neighbours() {
+        let mut schematic = UniversalSchematic::new("session".to_string());
+        for x in 0..48 {
+            schematic.set_block(x, 0, 0, &stone());
+        }
+        let pack = empty_pack();
+        let mut session = MeshSession::new(&mut schematic, &pack, &MeshConfig::default(), 16)
+            .expect("initial mesh");
+        assert_eq!(session.meshes().len(), 3);
+        assert!(session.update(&mut schematic, &pack).unwrap().is_empty());
+
+        // An interior edit touches its own chunk only; one on a chunk face
+        // touches the neighbour across it too.
+        schematic.set_block(8, 0, 0, &BlockState::new("minecraft:air".to_string()));
+        assert_eq!(session.update(&mut schematic, &pack).unwrap(), [(0, 0, 0)]);
+        schematic.set_block(16, 0, 0, &stone());
+        assert_eq!(
+            session.update(&mut schematic, &pack).unwrap(),
+            [(0, 0, 0), (1, 0, 0)]
+        );
+        assert_eq!(session.meshes().len(), 3);
+    }
+
+    #[test]
+    fn new_block_states_and_emptied_chunks_are_reported() {
+        let mut schematic = UniversalSchematic::new("session".to_string());
+        for x in 0..32 {
+            schematic.set_block(x, 0, 0, &stone());
+        }
+        let pack = empty_pack();
+        let mut session =
+            MeshSession::new(&mut schematic, &pack, &MeshConfig::default(), 16).unwrap();
+
+        // A state new to the atlas but bringing no new texture (the pack is
+        // empty) leaves it alone, so only the edited chunk is remeshed.
+        schematic.set_block(3, 0, 0, &BlockState::new("minecraft:glass".to_string()));
+        assert_eq!(session.update(&mut schematic, &pack).unwrap(), [(0, 0, 0)]);
+        assert_eq!(session.pack_atlas().state_count(), 2);
+
+        let air = BlockState::new("minecraft:air".to_string());
+        for x in 16..32 {
+            schematic.set_block(x, 0, 0, &air);
+        }
+        assert_eq!(
+            session.update(&mut schematic, &pack).unwrap(),
+            [(0, 0, 0), (1, 0, 0)]
+        );
+        assert!(!session.meshes().contains_key(&(1, 0, 0)));
+        assert!(MeshSession::new(&mut schematic, &pack, &MeshConfig::default(), 0).is_err());
+    }
+}
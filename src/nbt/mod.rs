@@ -1,8 +1,13 @@
+use crate::memory;
 use quartz_nbt::{self, NbtCompound, NbtTag};
+use rustc_hash::FxHasher;
 use serde::{Deserialize, Serialize};
-use std::collections::HashMap;
+use smol_str::SmolStr;
+use std::hash::{Hash, Hasher};
 // use std::io::{Error, ErrorKind, Read, Write};
 
+pub mod view;
+
 #[derive(Clone, Copy, Debug, PartialEq, Eq)]
 pub enum Endian {
     Big,
@@ -25,69 +30,253 @@ pub enum NbtValue {
     LongArray(Vec<i64>),
 }
 
-#[derive(Clone, Debug, PartialEq, Serialize, Deserialize)]
-pub struct NbtMap(HashMap<String, NbtValue>);
-
-impl Default for NbtMap {
-    fn default() -> Self {
-        Self::new()
-    }
-}
+/// An NBT compound: entries in insertion order, looked up by a linear scan.
+///
+/// Block-entity and item compounds hold a handful of keys, where scanning a
+/// short vector beats hashing, and their keys (`id`, `Items`, `Slot`, ...)
+/// fit inline in a [`SmolStr`] without a heap allocation. Equality ignores
+/// order, and serde sees a plain map, as it did when this wrapped a
+/// `HashMap`.
+#[derive(Clone, Default)]
+pub struct NbtMap(Vec<(SmolStr, NbtValue)>);
 
 impl NbtMap {
     pub fn new() -> Self {
-        NbtMap(HashMap::new())
+        NbtMap(Vec::new())
+    }
+
+    pub fn with_capacity(capacity: usize) -> Self {
+        NbtMap(Vec::with_capacity(capacity))
     }
 
-    pub fn insert(&mut self, key: String, value: NbtValue) -> Option<NbtValue> {
-        self.0.insert(key, value)
+    fn position(&self, key: &str) -> Option<usize> {
+        self.0.iter().position(|(k, _)| k == key)
+    }
+
+    /// Set `key`, keeping its place if it was already present.
+    pub fn insert(&mut self, key: impl Into<SmolStr>, value: NbtValue) -> Option<NbtValue> {
+        let key = key.into();
+        match self.position(&key) {
+            Some(i) => Some(std::mem::replace(&mut self.0[i].1, value)),
+            None => {
+                self.0.push((key, value));
+                None
+            }
+        }
     }
 
     pub fn get(&self, key: &str) -> Option<&NbtValue> {
-        self.0.get(key)
+        self.0.iter().find(|(k, _)| k == key).map(|(_, v)| v)
     }
 
     pub fn get_mut(&mut self, key: &str) -> Option<&mut NbtValue> {
-        self.0.get_mut(key)
+        self.0.iter_mut().find(|(k, _)| k == key).map(|(_, v)| v)
+    }
+
+    pub fn contains_key(&self, key: &str) -> bool {
+        self.position(key).is_some()
     }
 
+    /// Remove `key`, keeping the order of the rest.
     pub fn remove(&mut self, key: &str) -> Option<NbtValue> {
-        self.0.remove(key)
+        let i = self.position(key)?;
+        Some(self.0.remove(i).1)
     }
 
-    pub fn iter(&self) -> std::collections::hash_map::Iter<'_, String, NbtValue> {
-        self.0.iter()
+    pub fn retain(&mut self, mut f: impl FnMut(&str, &mut NbtValue) -> bool) {
+        self.0.retain_mut(|(k, v)| f(k, v));
     }
 
-    pub fn iter_mut(&mut self) -> std::collections::hash_map::IterMut<'_, String, NbtValue> {
-        self.0.iter_mut()
+    pub fn len(&self) -> usize {
+        self.0.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.0.is_empty()
+    }
+
+    /// Heap bytes held by the map, its keys and its values.
+    pub fn heap_bytes(&self) -> usize {
+        memory::vec_bytes(&self.0)
+            + self
+                .0
+                .iter()
+                .map(|(k, v)| k.is_heap_allocated() as usize * k.len() + v.heap_bytes())
+                .sum::<usize>()
+    }
+
+    pub fn iter(&self) -> Iter<'_> {
+        Iter(self.0.iter())
+    }
+
+    pub fn iter_mut(&mut self) -> IterMut<'_> {
+        IterMut(self.0.iter_mut())
     }
 
     pub fn from_quartz_nbt(compound: &NbtCompound) -> Self {
-        let mut map = NbtMap::new();
-        for (key, value) in compound.inner().iter() {
-            let nbt_value = NbtValue::from_quartz_nbt(value);
-            map.insert(key.clone(), nbt_value);
-        }
-        map
+        // Quartz keys are already unique.
+        NbtMap(
+            compound
+                .inner()
+                .iter()
+                .map(|(key, value)| (SmolStr::from(key), NbtValue::from_quartz_nbt(value)))
+                .collect(),
+        )
     }
 
     pub fn to_quartz_nbt(&self) -> NbtCompound {
         let mut compound = NbtCompound::new();
         for (key, value) in self.iter() {
-            compound.insert(key, value.to_quartz_nbt());
+            compound.insert(key.as_str(), value.to_quartz_nbt());
         }
         compound
     }
+}
+
+impl std::fmt::Debug for NbtMap {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        struct Entries<'a>(&'a NbtMap);
+
+        impl std::fmt::Debug for Entries<'_> {
+            fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+                f.debug_map().entries(self.0.iter()).finish()
+            }
+        }
+
+        f.debug_tuple("NbtMap").field(&Entries(self)).finish()
+    }
+}
 
-    pub fn inner(&self) -> &HashMap<String, NbtValue> {
-        &self.0
+impl PartialEq for NbtMap {
+    fn eq(&self, other: &Self) -> bool {
+        self.len() == other.len() && self.iter().all(|(k, v)| other.get(k) == Some(v))
     }
 }
 
+/// Agrees with the order-blind equality: each entry is hashed on its own and
+/// the results are summed.
+impl Hash for NbtMap {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        let mut sum = 0u64;
+        for (key, value) in self.iter() {
+            let mut entry = FxHasher::default();
+            key.hash(&mut entry);
+            value.hash(&mut entry);
+            sum = sum.wrapping_add(entry.finish());
+        }
+        state.write_usize(self.len());
+        state.write_u64(sum);
+    }
+}
+
+/// Floats hash by bit pattern with both zeros folded together, so values
+/// that compare equal hash alike.
+impl Hash for NbtValue {
+    fn hash<H: Hasher>(&self, state: &mut H) {
+        std::mem::discriminant(self).hash(state);
+        match self {
+            NbtValue::Byte(v) => v.hash(state),
+            NbtValue::Short(v) => v.hash(state),
+            NbtValue::Int(v) => v.hash(state),
+            NbtValue::Long(v) => v.hash(state),
+            NbtValue::Float(v) => (if *v == 0.0 { 0 } else { v.to_bits() }).hash(state),
+            NbtValue::Double(v) => (if *v == 0.0 { 0 } else { v.to_bits() }).hash(state),
+            NbtValue::ByteArray(v) => v.hash(state),
+            NbtValue::String(v) => v.hash(state),
+            NbtValue::List(v) => v.hash(state),
+            NbtValue::Compound(v) => v.hash(state),
+            NbtValue::IntArray(v) => v.hash(state),
+            NbtValue::LongArray(v) => v.hash(state),
+        }
+    }
+}
+
+impl<K: Into<SmolStr>> FromIterator<(K, NbtValue)> for NbtMap {
+    fn from_iter<I: IntoIterator<Item = (K, NbtValue)>>(iter: I) -> Self {
+        let mut map = NbtMap::new();
+        map.extend(iter);
+        map
+    }
+}
+
+impl<K: Into<SmolStr>> Extend<(K, NbtValue)> for NbtMap {
+    fn extend<I: IntoIterator<Item = (K, NbtValue)>>(&mut self, iter: I) {
+        for (key, value) in iter {
+            self.insert(key, value);
+        }
+    }
+}
+
+impl Serialize for NbtMap {
+    fn serialize<S: serde::Serializer>(&self, serializer: S) -> Result<S::Ok, S::Error> {
+        serializer.collect_map(self.iter())
+    }
+}
+
+impl<'de> Deserialize<'de> for NbtMap {
+    fn deserialize<D: serde::Deserializer<'de>>(deserializer: D) -> Result<Self, D::Error> {
+        struct MapVisitor;
+
+        impl<'de> serde::de::Visitor<'de> for MapVisitor {
+            type Value = NbtMap;
+
+            fn expecting(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+                f.write_str("an NBT compound")
+            }
+
+            fn visit_map<A: serde::de::MapAccess<'de>>(
+                self,
+                mut access: A,
+            ) -> Result<NbtMap, A::Error> {
+                let mut map = NbtMap::with_capacity(access.size_hint().unwrap_or(0).min(64));
+                while let Some((key, value)) = access.next_entry::<SmolStr, NbtValue>()? {
+                    map.insert(key, value);
+                }
+                Ok(map)
+            }
+        }
+
+        deserializer.deserialize_map(MapVisitor)
+    }
+}
+
+/// Borrowing iterator over an [`NbtMap`], in insertion order.
+pub struct Iter<'a>(std::slice::Iter<'a, (SmolStr, NbtValue)>);
+
+impl<'a> Iterator for Iter<'a> {
+    type Item = (&'a SmolStr, &'a NbtValue);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        self.0.next().map(|(k, v)| (k, v))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        self.0.size_hint()
+    }
+}
+
+impl ExactSizeIterator for Iter<'_> {}
+
+/// Iterator over an [`NbtMap`] with mutable values, in insertion order.
+pub struct IterMut<'a>(std::slice::IterMut<'a, (SmolStr, NbtValue)>);
+
+impl<'a> Iterator for IterMut<'a> {
+    type Item = (&'a SmolStr, &'a mut NbtValue);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        self.0.next().map(|(k, v)| (&*k, v))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        self.0.size_hint()
+    }
+}
+
+impl ExactSizeIterator for IterMut<'_> {}
+
 impl IntoIterator for NbtMap {
-    type Item = (String, NbtValue);
-    type IntoIter = std::collections::hash_map::IntoIter<String, NbtValue>;
+    type Item = (SmolStr, NbtValue);
+    type IntoIter = std::vec::IntoIter<(SmolStr, NbtValue)>;
 
     fn into_iter(self) -> Self::IntoIter {
         self.0.into_iter()
@@ -95,25 +284,40 @@ impl IntoIterator for NbtMap {
 }
 
 impl<'a> IntoIterator for &'a NbtMap {
-    type Item = (&'a String, &'a NbtValue);
-    type IntoIter = std::collections::hash_map::Iter<'a, String, NbtValue>;
+    type Item = (&'a SmolStr, &'a NbtValue);
+    type IntoIter = Iter<'a>;
 
     fn into_iter(self) -> Self::IntoIter {
-        self.0.iter()
+        self.iter()
     }
 }
 
 impl<'a> IntoIterator for &'a mut NbtMap {
-    type Item = (&'a String, &'a mut NbtValue);
-    type IntoIter = std::collections::hash_map::IterMut<'a, String, NbtValue>;
+    type Item = (&'a SmolStr, &'a mut NbtValue);
+    type IntoIter = IterMut<'a>;
 
     fn into_iter(self) -> Self::IntoIter {
-        self.0.iter_mut()
+        self.iter_mut()
     }
 }
 
 // Conversion functions
 impl NbtValue {
+    /// Heap bytes held by the value, including nested lists and compounds.
+    pub fn heap_bytes(&self) -> usize {
+        match self {
+            NbtValue::ByteArray(v) => memory::vec_bytes(v),
+            NbtValue::String(s) => s.len(),
+            NbtValue::List(items) => {
+                memory::vec_bytes(items) + items.iter().map(NbtValue::heap_bytes).sum::<usize>()
+            }
+            NbtValue::Compound(map) => map.heap_bytes(),
+            NbtValue::IntArray(v) => memory::vec_bytes(v),
+            NbtValue::LongArray(v) => memory::vec_bytes(v),
+            _ => 0,
+        }
+    }
+
     pub fn from_quartz_nbt(tag: &NbtTag) -> Self {
         match tag {
             NbtTag::Byte(v) => NbtValue::Byte(*v),
@@ -254,7 +458,7 @@ pub mod io {
         Ok(buf[0])
     }
 
-    fn read_i16<R: Read>(r: &mut R, endian: Endian) -> IoResult<i16> {
+    pub fn read_i16<R: Read>(r: &mut R, endian: Endian) -> IoResult<i16> {
         let mut buf = [0; 2];
         r.read_exact(&mut buf)?;
         match endian {
@@ -263,7 +467,7 @@ pub mod io {
         }
     }
 
-    fn read_i32<R: Read>(r: &mut R, endian: Endian) -> IoResult<i32> {
+    pub fn read_i32<R: Read>(r: &mut R, endian: Endian) -> IoResult<i32> {
         let mut buf = [0; 4];
         r.read_exact(&mut buf)?;
         match endian {
@@ -300,13 +504,47 @@ pub mod io {
     }
 
     fn read_string<R: Read>(r: &mut R, endian: Endian) -> IoResult<String> {
-        let len = read_i16(r, endian)? as usize;
+        let len = read_i16(r, endian)? as u16 as usize;
         let mut buf = vec![0; len];
         r.read_exact(&mut buf)?;
-        String::from_utf8(buf).map_err(|e| Error::new(ErrorKind::InvalidData, e))
+        String::from_utf8(buf).or_else(|e| {
+            decode_modified_utf8(e.as_bytes())
+                .ok_or_else(|| Error::new(ErrorKind::InvalidData, e.utf8_error()))
+        })
+    }
+
+    /// Decode Java's modified UTF-8, which Java-written NBT strings use: NUL
+    /// is `C0 80` and supplementary characters are surrogate pairs, each
+    /// half a three-byte sequence.
+    pub(crate) fn decode_modified_utf8(bytes: &[u8]) -> Option<String> {
+        let mut units = Vec::with_capacity(bytes.len());
+        let mut i = 0;
+        while i < bytes.len() {
+            let lead = bytes[i] as u16;
+            let continuation = |k: usize| {
+                bytes
+                    .get(i + k)
+                    .filter(|&&b| b & 0xC0 == 0x80)
+                    .map(|&b| b as u16 & 0x3F)
+            };
+            let (unit, len) = match lead {
+                0x00..=0x7F => (lead, 1),
+                0xC0..=0xDF => (((lead & 0x1F) << 6) | continuation(1)?, 2),
+                0xE0..=0xEF => (
+                    ((lead & 0x0F) << 12) | (continuation(1)? << 6) | continuation(2)?,
+                    3,
+                ),
+                _ => return None,
+            };
+            units.push(unit);
+            i += len;
+        }
+        String::from_utf16(&units).ok()
     }
 
-    fn read_payload<R: Read>(r: &mut R, type_id: u8, endian: Endian) -> IoResult<NbtValue> {
+    /// Read the payload of a tag whose type id (and name) were already
+    /// consumed.
+    pub fn read_payload<R: Read>(r: &mut R, type_id: u8, endian: Endian) -> IoResult<NbtValue> {
         match type_id {
             1 => Ok(NbtValue::Byte(read_u8(r)? as i8)),
             2 => Ok(NbtValue::Short(read_i16(r, endian)?)),
@@ -332,20 +570,7 @@ pub mod io {
                 }
                 Ok(NbtValue::List(list))
             }
-            10 => {
-                // Compound
-                let mut map = NbtMap::new();
-                loop {
-                    let tag_id = read_u8(r)?;
-                    if tag_id == 0 {
-                        break;
-                    }
-                    let name = read_string(r, endian)?;
-                    let tag = read_payload(r, tag_id, endian)?;
-                    map.insert(name, tag);
-                }
-                Ok(NbtValue::Compound(map))
-            }
+            10 => Ok(NbtValue::Compound(read_compound_payload(r, endian)?)),
             11 => {
                 // IntArray
                 let len = read_i32(r, endian)? as usize;
@@ -371,6 +596,175 @@ pub mod io {
         }
     }
 
+    /// Read the payload of a compound tag whose type id (and name) were
+    /// already consumed.
+    pub fn read_compound_payload<R: Read>(r: &mut R, endian: Endian) -> IoResult<NbtMap> {
+        let mut map = NbtMap::new();
+        loop {
+            let tag_id = read_u8(r)?;
+            if tag_id == 0 {
+                break;
+            }
+            let name = read_string(r, endian)?;
+            let tag = read_payload(r, tag_id, endian)?;
+            map.insert(name, tag);
+        }
+        Ok(map)
+    }
+
+    // Pull parsing: walk a compound one entry at a time and skip what the
+    // caller does not need, instead of building the whole tree.
+
+    /// The next entry of a compound: its type id and name, or `None` at the
+    /// compound's end tag. Follow with [`read_payload`] or [`skip_payload`].
+    pub fn read_entry_header<R: Read>(r: &mut R, endian: Endian) -> IoResult<Option<(u8, String)>> {
+        let tag_id = read_u8(r)?;
+        if tag_id == 0 {
+            return Ok(None);
+        }
+        Ok(Some((tag_id, read_string(r, endian)?)))
+    }
+
+    /// Read the root tag header, which must be a compound, and return its
+    /// name. Entries follow ([`read_entry_header`]).
+    pub fn read_root_header<R: Read>(r: &mut R, endian: Endian) -> IoResult<String> {
+        if read_u8(r)? != 10 {
+            return Err(Error::new(
+                ErrorKind::InvalidData,
+                "Root tag must be compound",
+            ));
+        }
+        read_string(r, endian)
+    }
+
+    /// Element type id and count at the start of a list payload. The
+    /// elements follow as bare payloads.
+    pub fn read_list_header<R: Read>(r: &mut R, endian: Endian) -> IoResult<(u8, usize)> {
+        let tag_id = read_u8(r)?;
+        Ok((tag_id, read_len(r, endian)?))
+    }
+
+    /// Element count prefix of an array or list payload.
+    pub fn read_len<R: Read>(r: &mut R, endian: Endian) -> IoResult<usize> {
+        let len = read_i32(r, endian)?;
+        usize::try_from(len)
+            .map_err(|_| Error::new(ErrorKind::InvalidData, format!("Negative length: {}", len)))
+    }
+
+    fn skip_bytes<R: Read>(r: &mut R, n: u64) -> IoResult<()> {
+        let skipped = std::io::copy(&mut r.by_ref().take(n), &mut std::io::sink())?;
+        if skipped < n {
+            return Err(Error::from(ErrorKind::UnexpectedEof));
+        }
+        Ok(())
+    }
+
+    /// Payload size of fixed-size tag types.
+    fn fixed_size(type_id: u8) -> Option<u64> {
+        match type_id {
+            1 => Some(1),
+            2 => Some(2),
+            3 | 5 => Some(4),
+            4 | 6 => Some(8),
+            _ => None,
+        }
+    }
+
+    /// Consume the payload of a tag without building it.
+    pub fn skip_payload<R: Read>(r: &mut R, type_id: u8, endian: Endian) -> IoResult<()> {
+        if let Some(size) = fixed_size(type_id) {
+            return skip_bytes(r, size);
+        }
+        match type_id {
+            7 | 11 | 12 => {
+                let element = match type_id {
+                    7 => 1,
+                    11 => 4,
+                    _ => 8,
+                };
+                let len = read_len(r, endian)? as u64;
+                skip_bytes(r, len * element)
+            }
+            8 => {
+                let len = read_i16(r, endian)? as u16;
+                skip_bytes(r, len as u64)
+            }
+            9 => {
+                let tag_id = read_u8(r)?;
+                let len = read_len(r, endian)?;
+                if let Some(size) = fixed_size(tag_id) {
+                    return skip_bytes(r, len as u64 * size);
+                }
+                for _ in 0..len {
+                    skip_payload(r, tag_id, endian)?;
+                }
+                Ok(())
+            }
+            10 => loop {
+                let tag_id = read_u8(r)?;
+                if tag_id == 0 {
+                    return Ok(());
+                }
+                let name_len = read_i16(r, endian)? as u16;
+                skip_bytes(r, name_len as u64)?;
+                skip_payload(r, tag_id, endian)?;
+            },
+            _ => Err(Error::new(
+                ErrorKind::InvalidData,
+                format!("Unknown tag id: {}", type_id),
+            )),
+        }
+    }
+
+    /// Copy the payload of a tag, unparsed, onto `out`, for a
+    /// [`view`](super::view) to read in place.
+    pub fn read_payload_bytes<R: Read>(
+        r: &mut R,
+        type_id: u8,
+        endian: Endian,
+        out: &mut Vec<u8>,
+    ) -> IoResult<()> {
+        struct Tee<'a, R> {
+            inner: &'a mut R,
+            out: &'a mut Vec<u8>,
+        }
+        impl<R: Read> Read for Tee<'_, R> {
+            fn read(&mut self, buf: &mut [u8]) -> IoResult<usize> {
+                let n = self.inner.read(buf)?;
+                self.out.extend_from_slice(&buf[..n]);
+                Ok(n)
+            }
+        }
+        skip_payload(&mut Tee { inner: r, out }, type_id, endian)
+    }
+
+    /// Read `len` bare int payloads, such as the elements of an int list
+    /// after [`read_list_header`], onto `out` in one pass over the bytes.
+    pub fn read_i32s<R: Read>(
+        r: &mut R,
+        len: usize,
+        endian: Endian,
+        out: &mut Vec<i32>,
+    ) -> IoResult<()> {
+        // Bounded chunks, so a corrupt length fails at end of input rather
+        // than allocating up front.
+        let mut buf = vec![0u8; len.min(1 << 14) * 4];
+        let mut left = len;
+        while left > 0 {
+            let n = left.min(buf.len() / 4);
+            r.read_exact(&mut buf[..n * 4])?;
+            out.extend(buf[..n * 4].chunks_exact(4).map(|b| {
+                let b = [b[0], b[1], b[2], b[3]];
+                match endian {
+                    Endian::Big => i32::from_be_bytes(b),
+                    Endian::Little => i32::from_le_bytes(b),
+                }
+            }));
+            left -= n;
+        }
+        Ok(())
+    }
+
     pub fn read_nbt<R: Read>(r: &mut R, endian: Endian) -> IoResult<NbtValue> {
         let tag_id = read_u8(r)?;
         if tag_id != 10 {
@@ -470,15 +864,7 @@ pub mod io {
                 }
                 Ok(())
             }
-            NbtValue::Compound(v) => {
-                for (name, tag) in v.iter() {
-                    write_u8(w, get_tag_id(tag))?;
-                    write_string(w, name, endian)?;
-                    write_payload(w, tag, endian)?;
-                }
-                write_u8(w, 0)?; // End tag
-                Ok(())
-            }
+            NbtValue::Compound(v) => write_compound_payload(w, v, endian),
             NbtValue::IntArray(v) => {
                 write_i32(w, v.len() as i32, endian)?;
                 for &i in v {
@@ -504,7 +890,64 @@ pub mod io {
     ) -> IoResult<()> {
         write_u8(w, 10)?; // Root Compound
         write_string(w, root_name, endian)?;
-        write_payload(w, &NbtValue::Compound(root.clone()), endian)
+        write_compound_payload(w, root, endian)
+    }
+
+    // Push writing: emit a compound entry by entry, so large payloads can
+    // be written without building them as values.
+
+    /// Start the root compound. Write its entries, then [`write_end`].
+    pub fn write_root_header<W: Write>(w: &mut W, name: &str, endian: Endian) -> IoResult<()> {
+        write_u8(w, 10)?;
+        write_string(w, name, endian)
+    }
+
+    /// Type id and name of a compound entry; its payload follows.
+    pub fn write_entry_header<W: Write>(
+        w: &mut W,
+        type_id: u8,
+        name: &str,
+        endian: Endian,
+    ) -> IoResult<()> {
+        write_u8(w, type_id)?;
+        write_string(w, name, endian)
+    }
+
+    /// A whole compound entry.
+    pub fn write_entry<W: Write>(
+        w: &mut W,
+        name: &str,
+        tag: &NbtValue,
+        endian: Endian,
+    ) -> IoResult<()> {
+        write_entry_header(w, get_tag_id(tag), name, endian)?;
+        write_payload(w, tag, endian)
+    }
+
+    /// Element type id and count at the start of a list payload; the
+    /// elements follow as bare payloads.
+    pub fn write_list_header<W: Write>(
+        w: &mut W,
+        type_id: u8,
+        len: usize,
+        endian: Endian,
+    ) -> IoResult<()> {
+        write_u8(w, type_id)?;
+        write_i32(w, len as i32, endian)
+    }
+
+    /// End tag closing a compound.
+    pub fn write_end<W: Write>(w: &mut W) -> IoResult<()> {
+        write_u8(w, 0)
+    }
+
+    fn write_compound_payload<W: Write>(w: &mut W, map: &NbtMap, endian: Endian) -> IoResult<()> {
+        for (name, tag) in map.iter() {
+            write_u8(w, get_tag_id(tag))?;
+            write_string(w, name, endian)?;
+            write_payload(w, tag, endian)?;
+        }
+        write_u8(w, 0) // End tag
     }
 }
 
@@ -545,3 +988,45 @@ mod snbt_roundtrip_tests {
         );
     }
 }
+
+#[cfg(test)]
+mod map_tests {
+    use super::*;
+
+    #[test]
+    fn entries_keep_insertion_order_and_compare_as_a_set() {
+        let mut map = NbtMap::new();
+        map.insert("id", NbtValue::String("minecraft:chest".to_string()));
+        map.insert("Items", NbtValue::List(Vec::new()));
+        map.insert("Lock", NbtValue::String(String::new()));
+        assert_eq!(
+            map.insert("Items", NbtValue::Int(1)),
+            Some(NbtValue::List(Vec::new()))
+        );
+        assert_eq!(
+            map.remove("id"),
+            Some(NbtValue::String("minecraft:chest".to_string()))
+        );
+        map.insert("id", NbtValue::String("minecraft:barrel".to_string()));
+        let keys: Vec<&str> = map.iter().map(|(k, _)| k.as_str()).collect();
+        assert_eq!(keys, ["Items", "Lock", "id"]);
+        assert!(map.contains_key("Lock") && !map.contains_key("lock"));
+
+        let reversed: NbtMap = map.clone().into_iter().rev().collect();
+        assert_eq!(reversed, map);
+        let mut fewer = map.clone();
+        fewer.retain(|k, _| k != "Lock");
+        assert_ne!(fewer, map);
+        assert_eq!(fewer.len(), 2);
+    }
+
+    #[test]
+    fn serializes_as_a_plain_map() {
+        let mut map = NbtMap::new();
+        map.insert("Slot", NbtValue::Byte(3));
+        let json = serde_json::to_string(&map).unwrap();
+        assert_eq!(json, r#"{"Slot":{"Byte":3}}"#);
+        assert_eq!(serde_json::from_str::<NbtMap>(&json).unwrap(), map);
+        assert_eq!(format!("{map:?}"), r#"NbtMap({"Slot": Byte(3)})"#);
+    }
+}
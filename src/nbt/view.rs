@@ -0,0 +1,567 @@
+//! Borrowed views over binary NBT.
+//!
+//! A view reads tags straight out of the decoded bytes: names and strings
+//! are byte slices, numeric arrays are converted from the file's byte
+//! order only when an element is read, and a compound is not indexed
+//! until something is looked up in it. Readers use views to find the few
+//! fields they keep and to step over the rest without allocating, then
+//! materialize only what they keep ([`TagView::to_value`]).
+//!
+//! Bounds are checked once, when a view is created: a compound or list
+//! view always covers a well-formed payload, so walking it cannot fail.
+//! Strings are Java's modified UTF-8; names are compared byte for byte,
+//! which matches for every name without NUL or characters outside the
+//! BMP.
+
+use super::io::decode_modified_utf8;
+use super::{Endian, NbtMap, NbtValue};
+use std::borrow::Cow;
+use std::cell::OnceCell;
+use std::io::{Error, ErrorKind, Result as IoResult};
+
+fn invalid(message: &str) -> Error {
+    Error::new(ErrorKind::InvalidData, message.to_string())
+}
+
+fn take(bytes: &[u8], at: usize, n: usize) -> Option<&[u8]> {
+    bytes.get(at..at.checked_add(n)?)
+}
+
+fn read_u16(bytes: &[u8], at: usize, endian: Endian) -> Option<u16> {
+    let b: [u8; 2] = take(bytes, at, 2)?.try_into().ok()?;
+    Some(match endian {
+        Endian::Big => u16::from_be_bytes(b),
+        Endian::Little => u16::from_le_bytes(b),
+    })
+}
+
+fn read_len(bytes: &[u8], at: usize, endian: Endian) -> Option<usize> {
+    usize::try_from(i32::element(take(bytes, at, 4)?, endian)).ok()
+}
+
+/// Payload size of fixed-size tag types.
+fn fixed_size(type_id: u8) -> Option<usize> {
+    match type_id {
+        1 => Some(1),
+        2 => Some(2),
+        3 | 5 => Some(4),
+        4 | 6 => Some(8),
+        _ => None,
+    }
+}
+
+/// Length of the payload of type `type_id` at `bytes[at..]`, or `None` if
+/// it is truncated or malformed.
+fn payload_len(bytes: &[u8], at: usize, type_id: u8, endian: Endian) -> Option<usize> {
+    if let Some(size) = fixed_size(type_id) {
+        return take(bytes, at, size).map(|_| size);
+    }
+    let len = match type_id {
+        7 | 11 | 12 => {
+            let element = match type_id {
+                7 => 1,
+                11 => 4,
+                _ => 8,
+            };
+            4 + read_len(bytes, at, endian)?.checked_mul(element)?
+        }
+        8 => 2 + read_u16(bytes, at, endian)? as usize,
+        9 => {
+            let element = *bytes.get(at)?;
+            let count = read_len(bytes, at + 1, endian)?;
+            let mut end = at + 5;
+            if let Some(size) = fixed_size(element) {
+                end = end.checked_add(count.checked_mul(size)?)?;
+            } else if count > 0 {
+                for _ in 0..count {
+                    end += payload_len(bytes, end, element, endian)?;
+                }
+            }
+            end - at
+        }
+        10 => {
+            let mut end = at;
+            loop {
+                let tag = *bytes.get(end)?;
+                end += 1;
+                if tag == 0 {
+                    break;
+                }
+                end += 2 + read_u16(bytes, end, endian)? as usize;
+                end += payload_len(bytes, end, tag, endian)?;
+            }
+            end - at
+        }
+        _ => return None,
+    };
+    take(bytes, at, len).map(|_| len)
+}
+
+/// A string or tag name, undecoded.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct StrView<'a>(&'a [u8]);
+
+impl<'a> StrView<'a> {
+    pub fn as_bytes(&self) -> &'a [u8] {
+        self.0
+    }
+
+    /// The string, if its bytes are plain UTF-8 (almost always).
+    pub fn as_str(&self) -> Option<&'a str> {
+        std::str::from_utf8(self.0).ok()
+    }
+
+    /// The string, decoding modified UTF-8 only when it is not plain UTF-8.
+    pub fn to_str(&self) -> IoResult<Cow<'a, str>> {
+        match self.as_str() {
+            Some(s) => Ok(Cow::Borrowed(s)),
+            None => decode_modified_utf8(self.0)
+                .map(Cow::Owned)
+                .ok_or_else(|| invalid("String is not valid modified UTF-8")),
+        }
+    }
+}
+
+impl PartialEq<str> for StrView<'_> {
+    fn eq(&self, other: &str) -> bool {
+        self.0 == other.as_bytes()
+    }
+}
+
+/// A numeric array element.
+pub trait ArrayElement: Copy {
+    const SIZE: usize;
+    /// Decode exactly `SIZE` bytes.
+    fn element(bytes: &[u8], endian: Endian) -> Self;
+}
+
+macro_rules! array_element {
+    ($($t:ty),*) => {$(
+        impl ArrayElement for $t {
+            const SIZE: usize = std::mem::size_of::<$t>();
+            #[inline]
+            fn element(bytes: &[u8], endian: Endian) -> Self {
+                let b = bytes.try_into().expect("element width");
+                match endian {
+                    Endian::Big => <$t>::from_be_bytes(b),
+                    Endian::Little => <$t>::from_le_bytes(b),
+                }
+            }
+        }
+    )*};
+}
+
+array_element!(i16, i32, i64, f32, f64);
+
+/// An int or long array, read element by element.
+#[derive(Clone, Copy, Debug)]
+pub struct ArrayView<'a, T> {
+    bytes: &'a [u8],
+    endian: Endian,
+    _element: std::marker::PhantomData<T>,
+}
+
+impl<'a, T: ArrayElement> ArrayView<'a, T> {
+    fn new(bytes: &'a [u8], endian: Endian) -> Self {
+        Self {
+            bytes,
+            endian,
+            _element: std::marker::PhantomData,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.bytes.len() / T::SIZE
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.bytes.is_empty()
+    }
+
+    pub fn get(&self, index: usize) -> Option<T> {
+        take(self.bytes, index.checked_mul(T::SIZE)?, T::SIZE).map(|b| T::element(b, self.endian))
+    }
+
+    pub fn iter(&self) -> impl ExactSizeIterator<Item = T> + 'a {
+        let endian = self.endian;
+        self.bytes
+            .chunks_exact(T::SIZE)
+            .map(move |b| T::element(b, endian))
+    }
+
+    pub fn to_vec(&self) -> Vec<T> {
+        self.iter().collect()
+    }
+
+    /// The raw elements, in the file's byte order.
+    pub fn as_bytes(&self) -> &'a [u8] {
+        self.bytes
+    }
+}
+
+/// One tag's payload.
+#[derive(Clone, Debug)]
+pub enum TagView<'a> {
+    Byte(i8),
+    Short(i16),
+    Int(i32),
+    Long(i64),
+    Float(f32),
+    Double(f64),
+    ByteArray(&'a [i8]),
+    String(StrView<'a>),
+    List(ListView<'a>),
+    Compound(CompoundView<'a>),
+    IntArray(ArrayView<'a, i32>),
+    LongArray(ArrayView<'a, i64>),
+}
+
+impl<'a> TagView<'a> {
+    /// The payload of type `type_id` that starts `bytes`, and its length.
+    fn read(bytes: &'a [u8], type_id: u8, endian: Endian) -> Option<(Self, usize)> {
+        let len = payload_len(bytes, 0, type_id, endian)?;
+        let payload = &bytes[..len];
+        let tag = match type_id {
+            1 => TagView::Byte(payload[0] as i8),
+            2 => TagView::Short(i16::element(payload, endian)),
+            3 => TagView::Int(i32::element(payload, endian)),
+            4 => TagView::Long(i64::element(payload, endian)),
+            5 => TagView::Float(f32::element(payload, endian)),
+            6 => TagView::Double(f64::element(payload, endian)),
+            7 => TagView::ByteArray(bytemuck::cast_slice(&payload[4..])),
+            8 => TagView::String(StrView(&payload[2..])),
+            9 => TagView::List(ListView {
+                element: payload[0],
+                len: read_len(payload, 1, endian)?,
+                bytes: &payload[5..],
+                endian,
+            }),
+            10 => TagView::Compound(CompoundView::new(payload, endian)),
+            11 => TagView::IntArray(ArrayView::new(&payload[4..], endian)),
+            12 => TagView::LongArray(ArrayView::new(&payload[4..], endian)),
+            _ => return None,
+        };
+        Some((tag, len))
+    }
+
+    pub fn type_id(&self) -> u8 {
+        match self {
+            TagView::Byte(_) => 1,
+            TagView::Short(_) => 2,
+            TagView::Int(_) => 3,
+            TagView::Long(_) => 4,
+            TagView::Float(_) => 5,
+            TagView::Double(_) => 6,
+            TagView::ByteArray(_) => 7,
+            TagView::String(_) => 8,
+            TagView::List(_) => 9,
+            TagView::Compound(_) => 10,
+            TagView::IntArray(_) => 11,
+            TagView::LongArray(_) => 12,
+        }
+    }
+
+    pub fn as_i8(&self) -> Option<i8> {
+        match self {
+            TagView::Byte(v) => Some(*v),
+            _ => None,
+        }
+    }
+
+    pub fn as_i32(&self) -> Option<i32> {
+        match self {
+            TagView::Int(v) => Some(*v),
+            _ => None,
+        }
+    }
+
+    pub fn as_i64(&self) -> Option<i64> {
+        match self {
+            TagView::Long(v) => Some(*v),
+            _ => None,
+        }
+    }
+
+    pub fn as_str(&self) -> Option<StrView<'a>> {
+        match self {
+            TagView::String(s) => Some(*s),
+            _ => None,
+        }
+    }
+
+    pub fn as_list(&self) -> Option<&ListView<'a>> {
+        match self {
+            TagView::List(l) => Some(l),
+            _ => None,
+        }
+    }
+
+    pub fn as_compound(&self) -> Option<&CompoundView<'a>> {
+        match self {
+            TagView::Compound(c) => Some(c),
+            _ => None,
+        }
+    }
+
+    pub fn as_int_array(&self) -> Option<ArrayView<'a, i32>> {
+        match self {
+            TagView::IntArray(a) => Some(*a),
+            _ => None,
+        }
+    }
+
+    pub fn as_long_array(&self) -> Option<ArrayView<'a, i64>> {
+        match self {
+            TagView::LongArray(a) => Some(*a),
+            _ => None,
+        }
+    }
+
+    /// Build the owned value. Fails only on a string that is not valid
+    /// modified UTF-8.
+    pub fn to_value(&self) -> IoResult<NbtValue> {
+        Ok(match self {
+            TagView::Byte(v) => NbtValue::Byte(*v),
+            TagView::Short(v) => NbtValue::Short(*v),
+            TagView::Int(v) => NbtValue::Int(*v),
+            TagView::Long(v) => NbtValue::Long(*v),
+            TagView::Float(v) => NbtValue::Float(*v),
+            TagView::Double(v) => NbtValue::Double(*v),
+            TagView::ByteArray(v) => NbtValue::ByteArray(v.to_vec()),
+            TagView::String(s) => NbtValue::String(s.to_str()?.into_owned()),
+            TagView::List(l) => {
+                let mut items = Vec::with_capacity(l.len());
+                for item in l.iter() {
+                    items.push(item.to_value()?);
+                }
+                NbtValue::List(items)
+            }
+            TagView::Compound(c) => NbtValue::Compound(c.to_map()?),
+            TagView::IntArray(a) => NbtValue::IntArray(a.to_vec()),
+            TagView::LongArray(a) => NbtValue::LongArray(a.to_vec()),
+        })
+    }
+}
+
+/// A list's elements, each read when iterated.
+#[derive(Clone, Debug)]
+pub struct ListView<'a> {
+    element: u8,
+    len: usize,
+    /// The element payloads, back to back.
+    bytes: &'a [u8],
+    endian: Endian,
+}
+
+impl<'a> ListView<'a> {
+    /// Element type id (0 or any id for an empty list).
+    pub fn element_type(&self) -> u8 {
+        self.element
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = TagView<'a>> + 'a {
+        let (bytes, element, endian) = (self.bytes, self.element, self.endian);
+        let mut at = 0;
+        (0..self.len).map_while(move |_| {
+            let (tag, len) = TagView::read(&bytes[at..], element, endian)?;
+            at += len;
+            Some(tag)
+        })
+    }
+
+    /// The compound elements (none unless the list holds compounds).
+    pub fn compounds(&self) -> impl Iterator<Item = CompoundView<'a>> + 'a {
+        self.iter().filter_map(|tag| match tag {
+            TagView::Compound(c) => Some(c),
+            _ => None,
+        })
+    }
+}
+
+/// A compound's entries, indexed by name on the first lookup.
+#[derive(Clone, Debug)]
+pub struct CompoundView<'a> {
+    /// The entries through the end tag.
+    bytes: &'a [u8],
+    endian: Endian,
+    index: OnceCell<Vec<(StrView<'a>, TagView<'a>)>>,
+}
+
+impl<'a> CompoundView<'a> {
+    fn new(bytes: &'a [u8], endian: Endian) -> Self {
+        Self {
+            bytes,
+            endian,
+            index: OnceCell::new(),
+        }
+    }
+
+    /// Walk the entries in file order without building the index.
+    pub fn iter(&self) -> impl Iterator<Item = (StrView<'a>, TagView<'a>)> + 'a {
+        let (bytes, endian) = (self.bytes, self.endian);
+        let mut at = 0;
+        std::iter::from_fn(move || {
+            let tag = *bytes.get(at)?;
+            if tag == 0 {
+                return None;
+            }
+            let name_len = read_u16(bytes, at + 1, endian)? as usize;
+            let name = StrView(take(bytes, at + 3, name_len)?);
+            at += 3 + name_len;
+            let (value, len) = TagView::read(&bytes[at..], tag, endian)?;
+            at += len;
+            Some((name, value))
+        })
+    }
+
+    /// The entry named `name`. The first lookup indexes the compound, so
+    /// several lookups cost one walk.
+    pub fn get(&self, name: &str) -> Option<&TagView<'a>> {
+        self.index
+            .get_or_init(|| self.iter().collect())
+            .iter()
+            .find(|(n, _)| *n == *name)
+            .map(|(_, tag)| tag)
+    }
+
+    pub fn get_i32(&self, name: &str) -> Option<i32> {
+        self.get(name)?.as_i32()
+    }
+
+    pub fn get_str(&self, name: &str) -> Option<StrView<'a>> {
+        self.get(name)?.as_str()
+    }
+
+    pub fn get_compound(&self, name: &str) -> Option<&CompoundView<'a>> {
+        self.get(name)?.as_compound()
+    }
+
+    pub fn get_list(&self, name: &str) -> Option<&ListView<'a>> {
+        self.get(name)?.as_list()
+    }
+
+    pub fn len(&self) -> usize {
+        match self.index.get() {
+            Some(index) => index.len(),
+            None => self.iter().count(),
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.bytes.first().is_none_or(|&tag| tag == 0)
+    }
+
+    /// The compound's payload as stored, for copying it through unchanged.
+    pub fn as_bytes(&self) -> &'a [u8] {
+        self.bytes
+    }
+
+    /// Build the owned map.
+    pub fn to_map(&self) -> IoResult<NbtMap> {
+        let mut map = NbtMap::new();
+        for (name, value) in self.iter() {
+            map.insert(name.to_str()?, value.to_value()?);
+        }
+        Ok(map)
+    }
+}
+
+/// View the root compound of `bytes`, returning its name and entries.
+pub fn root(bytes: &[u8], endian: Endian) -> IoResult<(StrView<'_>, CompoundView<'_>)> {
+    if bytes.first() != Some(&10) {
+        return Err(invalid("Root tag must be compound"));
+    }
+    let name_len = read_u16(bytes, 1, endian).ok_or_else(|| invalid("Truncated root name"))?;
+    let name = take(bytes, 3, name_len as usize).ok_or_else(|| invalid("Truncated root name"))?;
+    let rest = &bytes[3 + name_len as usize..];
+    match TagView::read(rest, 10, endian) {
+        Some((TagView::Compound(c), _)) => Ok((StrView(name), c)),
+        _ => Err(invalid("Truncated or malformed NBT")),
+    }
+}
+
+/// View a bare payload of type `type_id` (as captured by
+/// [`read_payload_bytes`](super::io::read_payload_bytes)).
+pub fn payload(bytes: &[u8], type_id: u8, endian: Endian) -> IoResult<TagView<'_>> {
+    TagView::read(bytes, type_id, endian)
+        .map(|(tag, _)| tag)
+        .ok_or_else(|| invalid("Truncated or malformed NBT"))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::nbt::io::write_nbt;
+
+    fn sample() -> NbtMap {
+        let mut inner = NbtMap::new();
+        inner.insert("id".to_string(), NbtValue::String("minecraft:chest".into()));
+        inner.insert("Pos".to_string(), NbtValue::IntArray(vec![1, -2, 3]));
+        let mut root = NbtMap::new();
+        root.insert("DataVersion".to_string(), NbtValue::Int(3700));
+        root.insert(
+            "States".to_string(),
+            NbtValue::LongArray(vec![i64::MIN, -1, 0, 42]),
+        );
+        root.insert("Bytes".to_string(), NbtValue::ByteArray(vec![-1, 0, 7]));
+        root.insert(
+            "Entities".to_string(),
+            NbtValue::List(vec![
+                NbtValue::Compound(inner.clone()),
+                NbtValue::Compound(NbtMap::new()),
+            ]),
+        );
+        root.insert(
+            "Floats".to_string(),
+            NbtValue::List(vec![NbtValue::Float(0.5), NbtValue::Float(-3.0)]),
+        );
+        root.insert("Inner".to_string(), NbtValue::Compound(inner));
+        root.insert("Empty".to_string(), NbtValue::List(Vec::new()));
+        root
+    }
+
+    #[test]
+    fn views_read_what_the_owned_reader_reads() {
+        for endian in [Endian::Big, Endian::Little] {
+            let map = sample();
+            let mut bytes = Vec::new();
+            write_nbt(&mut bytes, &map, "root", endian).unwrap();
+
+            let (name, view) = root(&bytes, endian).unwrap();
+            assert_eq!(name.as_str(), Some("root"));
+            assert_eq!(view.to_map().unwrap(), map);
+            assert_eq!(view.len(), map.iter().count());
+            assert_eq!(view.get_i32("DataVersion"), Some(3700));
+            let states = view.get("States").unwrap().as_long_array().unwrap();
+            assert_eq!(states.len(), 4);
+            assert_eq!(states.get(0), Some(i64::MIN));
+            assert_eq!(states.get(4), None);
+            assert_eq!(states.to_vec(), vec![i64::MIN, -1, 0, 42]);
+            let inner = view.get_compound("Inner").unwrap();
+            assert_eq!(
+                inner.get_str("id").unwrap().as_str(),
+                Some("minecraft:chest")
+            );
+            assert_eq!(
+                inner.get("Pos").unwrap().as_int_array().unwrap().to_vec(),
+                vec![1, -2, 3]
+            );
+            let entities = view.get_list("Entities").unwrap();
+            assert_eq!(entities.compounds().count(), 2);
+            assert!(view.get("Missing").is_none());
+
+            // Every truncation is caught when the view is made.
+            for cut in 0..bytes.len() {
+                assert!(root(&bytes[..cut], endian).is_err(), "cut at {cut}");
+            }
+        }
+    }
+}
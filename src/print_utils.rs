@@ -46,7 +46,7 @@ pub fn format_region(name: &str, region: &Region) -> String {
     output.push_str(&format!("    Size: {:?}\n", region.size));
     output.push_str("    Blocks:\n");
     for i in 0..region.blocks.len() {
-        let block_palette_index = region.blocks[i];
+        let block_palette_index = region.blocks.at(i);
         let block_position = region.index_to_coords(i);
         let block_state = region.palette.get(block_palette_index).unwrap();
         output.push_str(&format!(
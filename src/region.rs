@@ -1,32 +1,49 @@
 use crate::block_entity::BlockEntity;
 use crate::block_entity_store::BlockEntityStore;
 use crate::block_position::BlockPosition;
+use crate::block_state_registry::StateId;
+use crate::block_storage::BlockStorage;
 use crate::bounding_box::BoundingBox;
 use crate::entity::Entity;
+use crate::entity_store::{EntityInterner, EntityStore};
+use crate::formats::packed_longs::{self, Layout};
+use crate::memory::{self, RegionMemory};
 use crate::BlockState;
 use quartz_nbt::{NbtCompound, NbtList, NbtTag};
 use rustc_hash::FxHashMap;
 use serde::{Deserialize, Serialize};
+use std::borrow::Cow;
 use std::collections::HashMap;
+use std::sync::OnceLock;
 
 /// Re-exported alias kept for downstream Rust crates that referenced the
 /// previous concrete map type. New code should use `BlockEntityStore`.
 pub type BlockEntityMap = BlockEntityStore;
 
+/// Minimum per-axis slack [`Region::expand_to_fit`] allocates past a block
+/// placed outside the bounds.
+pub const MIN_GROWTH: i32 = 64;
+
 #[derive(Serialize, Deserialize, Debug, Clone)]
 pub struct Region {
     pub name: String,
     pub position: (i32, i32, i32),
     pub size: (i32, i32, i32),
-    pub blocks: Vec<usize>,
+    /// Palette index per cell, x fastest, then z, then y. Stored at the
+    /// narrowest width the palette allows; see [`BlockStorage`].
+    pub blocks: BlockStorage,
     pub(crate) palette: Vec<BlockState>,
-    pub entities: Vec<Entity>,
+    pub entities: EntityStore,
     pub block_entities: BlockEntityStore,
     /// Reverse palette lookup keyed by BlockState. FxHashMap because the
     /// palette is hit on every `set_block` call and BlockState's std
     /// hash is wasted cycles on a small-cardinality set.
     #[serde(skip, default = "FxHashMap::default")]
     palette_index: FxHashMap<BlockState, usize>,
+    /// Interned id of each palette entry, kept in step with `palette_index`.
+    /// Lets merges and comparisons across regions work on `u32`s.
+    #[serde(skip)]
+    palette_ids: Vec<StateId>,
 
     #[serde(skip)]
     bbox: BoundingBox,
@@ -52,6 +69,97 @@ pub struct Region {
     cached_air_index: usize,
     #[serde(skip)]
     non_air_count: usize,
+    /// Non-air count per 16³ section, built on first query and then kept in
+    /// step by writes; see [`SectionCounts`]. Reset whenever the layout or
+    /// the blocks change wholesale.
+    #[serde(skip)]
+    sections: OnceLock<SectionCounts>,
+    /// Sections written since the last [`Region::take_changed_sections`];
+    /// `None` until that is first called.
+    #[serde(skip)]
+    dirty: Option<DirtySections>,
+}
+
+/// Edge of the sections [`Region::occupied_sections`] reports.
+pub const SECTION_EDGE: i32 = 16;
+
+/// Non-air cell count of every `SECTION_EDGE`³ section of a region's box.
+/// Sections are aligned to the box minimum, so translating a region keeps
+/// them. Indexed x fastest, then z, then y, like the cells.
+#[derive(Debug, Clone, Default)]
+struct SectionCounts {
+    /// Sections along x, y and z.
+    dims: (usize, usize, usize),
+    counts: Vec<u32>,
+}
+
+impl SectionCounts {
+    #[inline]
+    fn index(&self, (sx, sy, sz): (usize, usize, usize)) -> usize {
+        sx + sz * self.dims.0 + sy * self.dims.0 * self.dims.2
+    }
+}
+
+/// Sections written since changes were last taken, indexed like
+/// [`SectionCounts`].
+#[derive(Debug, Clone, Default)]
+struct DirtySections {
+    dims: (usize, usize, usize),
+    /// Per section, one more than its position in `order`, or 0 if unwritten.
+    slots: Vec<u32>,
+    /// The marked sections in the order they were first written, each with
+    /// the inclusive box of the cells written in it.
+    order: Vec<(usize, (i32, i32, i32), (i32, i32, i32))>,
+    /// The layout or the cells changed wholesale.
+    all: bool,
+}
+
+impl DirtySections {
+    fn new(dims: (usize, usize, usize)) -> Self {
+        DirtySections {
+            dims,
+            slots: vec![0; dims.0 * dims.1 * dims.2],
+            order: Vec::new(),
+            all: false,
+        }
+    }
+
+    /// Record writes to the cells `min..=max`, which lie in one section.
+    #[inline]
+    fn mark(
+        &mut self,
+        (sx, sy, sz): (usize, usize, usize),
+        min: (i32, i32, i32),
+        max: (i32, i32, i32),
+    ) {
+        if self.all {
+            return;
+        }
+        let index = sx + sz * self.dims.0 + sy * self.dims.0 * self.dims.2;
+        match self.slots[index] {
+            0 => {
+                self.order.push((index, min, max));
+                self.slots[index] = self.order.len() as u32;
+            }
+            slot => {
+                let (_, lo, hi) = &mut self.order[slot as usize - 1];
+                *lo = (lo.0.min(min.0), lo.1.min(min.1), lo.2.min(min.2));
+                *hi = (hi.0.max(max.0), hi.1.max(max.1), hi.2.max(max.2));
+            }
+        }
+    }
+}
+
+/// One source of a layered merge (see `Region::compose_layers`).
+struct MergeLayer<'a> {
+    region: &'a Region,
+    /// Box of `region` to copy; must lie inside its bounding box.
+    bounds: BoundingBox,
+    /// Maps `region`'s palette into the merged one (`None`: identity).
+    remap: Option<Vec<usize>>,
+    /// Source value that leaves the destination untouched (air, for merges
+    /// where it must not overwrite).
+    skip: Option<usize>,
 }
 
 impl Region {
@@ -66,6 +174,33 @@ impl Region {
         name: String,
         position: (i32, i32, i32),
         size: (i32, i32, i32),
+    ) -> Result<Self, String> {
+        Self::try_new_with(name, position, size, false)
+    }
+
+    /// Construct a region on sparse section storage: only 16³ sections that
+    /// receive blocks are allocated, so a mostly-air build over a huge
+    /// footprint costs memory per written section rather than per cell, and
+    /// growing it never copies. See [`BlockStorage::sparse`].
+    pub fn new_sparse(name: String, position: (i32, i32, i32), size: (i32, i32, i32)) -> Self {
+        Self::try_new_sparse(name, position, size).expect("region bounds exceed supported limits")
+    }
+
+    /// Like [`Region::new_sparse`], but reports invalid bounds instead of
+    /// panicking.
+    pub fn try_new_sparse(
+        name: String,
+        position: (i32, i32, i32),
+        size: (i32, i32, i32),
+    ) -> Result<Self, String> {
+        Self::try_new_with(name, position, size, true)
+    }
+
+    fn try_new_with(
+        name: String,
+        position: (i32, i32, i32),
+        size: (i32, i32, i32),
+        sparse: bool,
     ) -> Result<Self, String> {
         let bounding_box = BoundingBox::try_from_position_and_size(position, size)?;
         let dimension = |min: i32, max: i32, axis: &str| {
@@ -89,14 +224,17 @@ impl Region {
         let mut palette_index: FxHashMap<BlockState, usize> = FxHashMap::default();
 
         let air = BlockState::new("minecraft:air".to_string());
+        let palette_ids = vec![StateId::of(&air)];
         palette.push(air.clone());
         palette_index.insert(air, 0);
 
-        let mut blocks = Vec::new();
-        blocks
-            .try_reserve_exact(volume)
-            .map_err(|error| format!("Cannot allocate region with {volume} blocks: {error}"))?;
-        blocks.resize(volume, 0);
+        let blocks = if sparse {
+            let (w, h, l) = dimensions;
+            BlockStorage::sparse(bounding_box.min, (w as usize, h as usize, l as usize), 0)
+        } else {
+            BlockStorage::try_filled(volume, 0)
+                .map_err(|error| format!("Cannot allocate region with {volume} blocks: {error}"))?
+        };
 
         let mut region = Region {
             name,
@@ -105,7 +243,8 @@ impl Region {
             blocks,
             palette,
             palette_index,
-            entities: Vec::new(),
+            palette_ids,
+            entities: EntityStore::new(),
             block_entities: BlockEntityStore::default(),
             bbox: bounding_box,
             tight_bounds: None,
@@ -114,12 +253,56 @@ impl Region {
             cached_width_x_length: 0,
             cached_air_index: 0,
             non_air_count: 0,
+            sections: OnceLock::new(),
+            dirty: None,
         };
         region.rebuild_bbox();
         region.rebuild_air_index();
         Ok(region)
     }
 
+    /// Assemble a region from stored parts. `non_air_count` and
+    /// `tight_bounds` are taken as given, so loads that store them (snapshots)
+    /// skip the scans; other callers pass placeholders and rebuild them.
+    /// `blocks` must cover the bounding box.
+    #[allow(clippy::too_many_arguments)]
+    pub(crate) fn from_parts(
+        name: String,
+        position: (i32, i32, i32),
+        size: (i32, i32, i32),
+        blocks: BlockStorage,
+        palette: Vec<BlockState>,
+        entities: Vec<Entity>,
+        block_entities: BlockEntityStore,
+        non_air_count: usize,
+        tight_bounds: Option<BoundingBox>,
+    ) -> Region {
+        let mut region = Region {
+            name,
+            position,
+            size,
+            blocks,
+            palette,
+            entities: entities.into(),
+            block_entities,
+            palette_index: FxHashMap::default(),
+            palette_ids: Vec::new(),
+            bbox: BoundingBox::from_position_and_size(position, size),
+            tight_bounds,
+            cached_width: 0,
+            cached_length: 0,
+            cached_width_x_length: 0,
+            cached_air_index: 0,
+            non_air_count,
+            sections: OnceLock::new(),
+            dirty: None,
+        };
+        region.rebuild_palette_index();
+        region.rebuild_bbox();
+        region.rebuild_air_index();
+        region
+    }
+
     #[inline(always)]
     pub fn rebuild_bbox(&mut self) {
         self.bbox = BoundingBox::from_position_and_size(self.position, self.size);
@@ -130,34 +313,384 @@ impl Region {
         self.cached_length = l64;
         // i64 multiplication: w × l can exceed i32::MAX (e.g. 50k × 50k = 2.5e9).
         self.cached_width_x_length = w64 * l64;
+        self.reset_sections();
     }
 
     /// Recompute cached_air_index from the palette.
     pub(crate) fn rebuild_air_index(&mut self) {
-        self.cached_air_index = self
+        let air = self
             .palette
             .iter()
             .position(|b| b.name == "minecraft:air")
             .unwrap_or(usize::MAX);
+        if air != self.cached_air_index {
+            self.sections.take();
+        }
+        self.cached_air_index = air;
     }
 
-    /// Recount non-air blocks by scanning the blocks array.
+    /// Recount non-air blocks by scanning the blocks array (only the stored
+    /// sections, for sparse storage).
     pub(crate) fn rebuild_non_air_count(&mut self) {
+        self.reset_sections();
+        let air = self.cached_air_index;
+        let len = self.blocks.len();
+        self.non_air_count = len - self.blocks.count_in_range(0..len, air);
+    }
+
+    /// Drop the section counts and mark every section changed, after the
+    /// layout or the cells change wholesale.
+    fn reset_sections(&mut self) {
+        self.sections.take();
+        if let Some(dirty) = &mut self.dirty {
+            dirty.all = true;
+        }
+    }
+
+    fn section_dims(&self) -> (usize, usize, usize) {
+        let (w, h, l) = self.bbox.get_dimensions();
+        let edge = SECTION_EDGE as usize;
+        (
+            (w as usize).div_ceil(edge),
+            (h as usize).div_ceil(edge),
+            (l as usize).div_ceil(edge),
+        )
+    }
+
+    /// Record a write to the cell at `(x, y, z)`.
+    #[inline]
+    fn mark_dirty(&mut self, x: i32, y: i32, z: i32) {
+        let section = self.section_of(x, y, z);
+        if let Some(dirty) = &mut self.dirty {
+            dirty.mark(section, (x, y, z), (x, y, z));
+        }
+    }
+
+    /// Record a write to every cell of the inclusive box `min..=max`.
+    fn mark_dirty_box(&mut self, min: (i32, i32, i32), max: (i32, i32, i32)) {
+        if self.dirty.is_none() {
+            return;
+        }
+        let lo = self.section_of(min.0, min.1, min.2);
+        let hi = self.section_of(max.0, max.1, max.2);
+        let origin = self.bbox.min;
+        let edge = SECTION_EDGE;
+        // The part of `min..=max` along one axis inside section `s`.
+        let clip = |s: usize, origin: i32, lo: i32, hi: i32| {
+            let start = origin + s as i32 * edge;
+            (lo.max(start), hi.min(start + edge - 1))
+        };
+        let dirty = self.dirty.as_mut().expect("checked above");
+        for sy in lo.1..=hi.1 {
+            let y = clip(sy, origin.1, min.1, max.1);
+            for sz in lo.2..=hi.2 {
+                let z = clip(sz, origin.2, min.2, max.2);
+                for sx in lo.0..=hi.0 {
+                    let x = clip(sx, origin.0, min.0, max.0);
+                    dirty.mark((sx, sy, sz), (x.0, y.0, z.0), (x.1, y.1, z.1));
+                }
+            }
+        }
+    }
+
+    /// World boxes of the `SECTION_EDGE`³ sections written since the last
+    /// call, in the order they were first written, and start tracking from
+    /// now. `None` means everything must be treated as changed: this is the
+    /// first call, or the layout or the cells changed wholesale (growth,
+    /// merges, transforms, or writes through `blocks` followed by a
+    /// rebuild). Writes through `blocks` that skip the rebuilds are not seen.
+    pub fn take_changed_sections(&mut self) -> Option<Vec<BoundingBox>> {
+        let dirty = self.take_dirty()?;
+        let (dx, _, dz) = dirty.dims;
+        Some(
+            dirty
+                .order
+                .into_iter()
+                .map(|(index, _, _)| {
+                    let section = (index % dx, index / (dx * dz), index / dx % dz);
+                    let (min, max) = self.section_box(section);
+                    BoundingBox::new(min, max)
+                })
+                .collect(),
+        )
+    }
+
+    /// [`Region::take_changed_sections`], but reporting the tight box of the
+    /// cells written in each changed section rather than the whole section.
+    /// Both take the same change marks.
+    pub fn take_changed_cells(&mut self) -> Option<Vec<BoundingBox>> {
+        let dirty = self.take_dirty()?;
+        Some(
+            dirty
+                .order
+                .into_iter()
+                .map(|(_, min, max)| BoundingBox::new(min, max))
+                .collect(),
+        )
+    }
+
+    /// The change marks, replaced by fresh ones, or `None` if everything
+    /// must be treated as changed.
+    fn take_dirty(&mut self) -> Option<DirtySections> {
+        let fresh = DirtySections::new(self.section_dims());
+        let dirty = std::mem::replace(&mut self.dirty, Some(fresh))?;
+        if dirty.all || dirty.dims != self.section_dims() {
+            return None;
+        }
+        Some(dirty)
+    }
+
+    /// Per-section non-air counts, counted on first use.
+    fn section_counts(&self) -> &SectionCounts {
+        self.sections.get_or_init(|| self.count_sections())
+    }
+
+    /// Count every section in one pass over the rows, one vectorized range
+    /// count per row segment.
+    fn count_sections(&self) -> SectionCounts {
+        let (w, h, l) = self.bbox.get_dimensions();
+        let edge = SECTION_EDGE as usize;
+        let (w, h, l) = (w as usize, h as usize, l as usize);
+        let dims = self.section_dims();
+        let mut sections = SectionCounts {
+            dims,
+            counts: vec![0; dims.0 * dims.1 * dims.2],
+        };
+        let air = self.cached_air_index;
+        for dy in 0..h {
+            for dz in 0..l {
+                let row = dy * w * l + dz * w;
+                for sx in 0..dims.0 {
+                    let segment = row + sx * edge..row + ((sx + 1) * edge).min(w);
+                    let solid = segment.len() - self.blocks.count_in_range(segment, air);
+                    let index = sections.index((sx, dy / edge, dz / edge));
+                    sections.counts[index] += solid as u32;
+                }
+            }
+        }
+        sections
+    }
+
+    /// Section (relative to the box minimum) holding a cell of the region.
+    #[inline]
+    fn section_of(&self, x: i32, y: i32, z: i32) -> (usize, usize, usize) {
+        let edge = SECTION_EDGE;
+        (
+            ((x - self.bbox.min.0) / edge) as usize,
+            ((y - self.bbox.min.1) / edge) as usize,
+            ((z - self.bbox.min.2) / edge) as usize,
+        )
+    }
+
+    /// Record one cell of `(x, y, z)` turning solid (`+1`) or air (`-1`).
+    #[inline]
+    fn bump_section(&mut self, x: i32, y: i32, z: i32, delta: i32) {
+        let section = self.section_of(x, y, z);
+        if let Some(sections) = self.sections.get_mut() {
+            let index = sections.index(section);
+            sections.counts[index] = sections.counts[index].wrapping_add_signed(delta);
+        }
+    }
+
+    /// Recount the sections touching the inclusive box `min..=max` after a
+    /// bulk write. A no-op until the counts have been built.
+    fn recount_sections(&mut self, min: (i32, i32, i32), max: (i32, i32, i32)) {
+        if self.sections.get().is_none() {
+            return;
+        }
+        let lo = self.section_of(min.0, min.1, min.2);
+        let hi = self.section_of(max.0, max.1, max.2);
         let air = self.cached_air_index;
-        self.non_air_count = self.blocks.iter().filter(|&&b| b != air).count();
+        let mut recounted = Vec::new();
+        for sy in lo.1..=hi.1 {
+            for sz in lo.2..=hi.2 {
+                for sx in lo.0..=hi.0 {
+                    let (bmin, bmax) = self.section_box((sx, sy, sz));
+                    let row_len = (bmax.0 - bmin.0 + 1) as usize;
+                    let mut solid = 0;
+                    for y in bmin.1..=bmax.1 {
+                        for z in bmin.2..=bmax.2 {
+                            let start = self.coords_to_index(bmin.0, y, z);
+                            let row = start..start + row_len;
+                            solid += row_len - self.blocks.count_in_range(row, air);
+                        }
+                    }
+                    recounted.push(((sx, sy, sz), solid as u32));
+                }
+            }
+        }
+        let sections = self.sections.get_mut().expect("checked above");
+        for (section, solid) in recounted {
+            let index = sections.index(section);
+            sections.counts[index] = solid;
+        }
+    }
+
+    /// World box of a section, clipped to the region.
+    fn section_box(
+        &self,
+        (sx, sy, sz): (usize, usize, usize),
+    ) -> ((i32, i32, i32), (i32, i32, i32)) {
+        let edge = SECTION_EDGE;
+        let min = (
+            self.bbox.min.0 + sx as i32 * edge,
+            self.bbox.min.1 + sy as i32 * edge,
+            self.bbox.min.2 + sz as i32 * edge,
+        );
+        let max = (
+            (min.0 + edge - 1).min(self.bbox.max.0),
+            (min.1 + edge - 1).min(self.bbox.max.1),
+            (min.2 + edge - 1).min(self.bbox.max.2),
+        );
+        (min, max)
+    }
+
+    /// World boxes of the `SECTION_EDGE`³ sections (aligned to the region's
+    /// minimum corner, clipped to its box) that hold at least one non-air
+    /// block, in storage order. The first call counts every section. After
+    /// that, writes keep the counts current and this is O(sections).
+    pub fn occupied_sections(&self) -> impl Iterator<Item = BoundingBox> + '_ {
+        let sections = self.section_counts();
+        let (dx, _, dz) = sections.dims;
+        sections
+            .counts
+            .iter()
+            .enumerate()
+            .filter(|&(_, &count)| count > 0)
+            .map(move |(index, _)| {
+                let section = (index % dx, index / (dx * dz), index / dx % dz);
+                let (min, max) = self.section_box(section);
+                BoundingBox::new(min, max)
+            })
+    }
+
+    /// Whether the inclusive box `min..=max` may hold a non-air block of this
+    /// region. `false` is exact, because every section the box touches is
+    /// empty. `true` only means some touched section has a block. Costs one
+    /// lookup per touched section.
+    pub fn may_have_blocks_in(&self, min: (i32, i32, i32), max: (i32, i32, i32)) -> bool {
+        let clip_min = (
+            min.0.max(self.bbox.min.0),
+            min.1.max(self.bbox.min.1),
+            min.2.max(self.bbox.min.2),
+        );
+        let clip_max = (
+            max.0.min(self.bbox.max.0),
+            max.1.min(self.bbox.max.1),
+            max.2.min(self.bbox.max.2),
+        );
+        if clip_min.0 > clip_max.0 || clip_min.1 > clip_max.1 || clip_min.2 > clip_max.2 {
+            return false;
+        }
+        let lo = self.section_of(clip_min.0, clip_min.1, clip_min.2);
+        let hi = self.section_of(clip_max.0, clip_max.1, clip_max.2);
+        let sections = self.section_counts();
+        (lo.1..=hi.1).any(|sy| {
+            (lo.2..=hi.2)
+                .any(|sz| (lo.0..=hi.0).any(|sx| sections.counts[sections.index((sx, sy, sz))] > 0))
+        })
     }
 
     /// Rebuild tight bounds by scanning all blocks
     /// This is typically called after deserialization
     pub fn rebuild_tight_bounds(&mut self) {
-        self.tight_bounds = None;
         let air = self.cached_air_index;
-
-        for index in 0..self.blocks.len() {
-            if self.blocks[index] != air {
-                let (x, y, z) = self.index_to_coords(index);
-                self.update_tight_bounds(x, y, z);
+        let mut bounds: Option<BoundingBox> = None;
+        self.blocks.for_each_index_ne(air, |index| {
+            let (x, y, z) = self.index_to_coords(index);
+            match &mut bounds {
+                Some(bounds) => {
+                    bounds.min = (
+                        bounds.min.0.min(x),
+                        bounds.min.1.min(y),
+                        bounds.min.2.min(z),
+                    );
+                    bounds.max = (
+                        bounds.max.0.max(x),
+                        bounds.max.1.max(y),
+                        bounds.max.2.max(z),
+                    );
+                }
+                None => bounds = Some(BoundingBox::new((x, y, z), (x, y, z))),
             }
+        });
+        self.tight_bounds = bounds;
+    }
+
+    /// Whether blocks live on sparse section storage ([`Region::new_sparse`]).
+    pub fn is_sparse(&self) -> bool {
+        self.blocks.is_sparse()
+    }
+
+    /// Move blocks onto sparse section storage, keeping only sections that
+    /// hold non-air blocks. A no-op if already sparse.
+    pub fn make_sparse(&mut self) {
+        if self.blocks.is_sparse() {
+            return;
+        }
+        let (w, h, l) = self.size;
+        self.blocks = self.blocks.to_sparse(
+            self.position,
+            (w as usize, h as usize, l as usize),
+            self.cached_air_index,
+        );
+    }
+
+    /// Move blocks back onto dense storage (one cell per position). A no-op
+    /// if already dense.
+    pub fn make_dense(&mut self) {
+        if self.blocks.is_sparse() {
+            self.blocks = self.blocks.to_dense();
+        }
+    }
+
+    /// All-`fill` storage for `bbox`, on the same backend as this region.
+    fn blank_blocks(&self, bbox: &BoundingBox, fill: usize) -> BlockStorage {
+        if self.blocks.is_sparse() {
+            let (w, h, l) = bbox.get_dimensions();
+            BlockStorage::sparse(bbox.min, (w as usize, h as usize, l as usize), fill)
+        } else {
+            BlockStorage::filled(bbox.volume() as usize, fill)
+        }
+    }
+
+    /// Fill `new_blocks` (laid out over `new_bbox`) with a permutation of
+    /// this region's cells: the cell at offset (x, y, z) from `new_bbox.min`
+    /// takes old cell `origin + x * sx + y * sy + z * sz`. Dense storage is
+    /// written one Y slab per task with tiled strided reads; sparse storage
+    /// moves only its non-air cells, through `map` (old index to new index).
+    fn permute_blocks_into(
+        &self,
+        new_blocks: &mut BlockStorage,
+        new_bbox: &BoundingBox,
+        origin: usize,
+        (sx, sy, sz): (isize, isize, isize),
+        map: impl Fn(usize) -> usize,
+    ) {
+        if new_blocks.is_sparse() {
+            self.blocks
+                .for_each_index_ne(self.cached_air_index, |index| {
+                    new_blocks.set(map(index), self.blocks.at(index));
+                });
+            return;
+        }
+        let (w, _, l) = new_bbox.get_dimensions();
+        let (w, l) = (w as usize, l as usize);
+        new_blocks.for_each_slab(w * l, |dy, slab| {
+            let start = origin as isize + dy as isize * sy;
+            slab.gather(0, w, l, &self.blocks, start as usize, sx, sz);
+        });
+    }
+
+    /// Carry tight bounds through a flip or quarter turn of positions, which
+    /// maps a box onto a box, instead of rescanning the blocks.
+    fn map_tight_bounds(&mut self, f: impl Fn((i32, i32, i32)) -> (i32, i32, i32)) {
+        if let Some(bounds) = &self.tight_bounds {
+            let (a, b) = (f(bounds.min), f(bounds.max));
+            self.tight_bounds = Some(BoundingBox::new(
+                (a.0.min(b.0), a.1.min(b.1), a.2.min(b.2)),
+                (a.0.max(b.0), a.1.max(b.1), a.2.max(b.2)),
+            ));
         }
     }
 
@@ -168,6 +701,7 @@ impl Region {
                 let index = self.palette.len();
                 self.palette.push(block.clone());
                 self.palette_index.insert(block.clone(), index);
+                self.palette_ids.push(StateId::of(block));
                 index
             }
         }
@@ -177,6 +711,12 @@ impl Region {
         self.non_air_count == 0
     }
 
+    /// Palette index of `minecraft:air` (`usize::MAX` when the palette has
+    /// none); box reads fill unallocated cells with it.
+    pub fn air_index(&self) -> usize {
+        self.cached_air_index
+    }
+
     pub fn has_non_air_blocks(&self) -> bool {
         self.non_air_count > 0
     }
@@ -185,12 +725,91 @@ impl Region {
         self.non_air_count
     }
 
+    /// Heap bytes held by the region, by component. See [`crate::memory`].
+    pub fn memory_usage(&self) -> RegionMemory {
+        // Index keys are clones of the palette: their names share its
+        // `SmolStr` allocations, their property vectors do not.
+        let index_keys: usize = self
+            .palette_index
+            .keys()
+            .map(|state| memory::vec_bytes(&state.properties))
+            .sum();
+        let palette = memory::vec_bytes(&self.palette)
+            + self
+                .palette
+                .iter()
+                .map(BlockState::heap_bytes)
+                .sum::<usize>()
+            + memory::table_bytes(&self.palette_index)
+            + index_keys
+            + memory::vec_bytes(&self.palette_ids);
+        let entities = self.entities.heap_bytes();
+        let sections = self
+            .sections
+            .get()
+            .map_or(0, |sections| memory::vec_bytes(&sections.counts));
+        RegionMemory {
+            name: self.name.clone(),
+            blocks: self.blocks.heap_bytes(),
+            palette,
+            block_entities: self.block_entities.heap_bytes(),
+            entities,
+            other: self.name.len() + sections,
+        }
+    }
+
     pub(crate) fn rebuild_palette_index(&mut self) {
         self.palette_index =
             FxHashMap::with_capacity_and_hasher(self.palette.len(), Default::default());
         for (index, block) in self.palette.iter().enumerate() {
             self.palette_index.insert(block.clone(), index);
         }
+        self.palette_ids = StateId::of_all(&self.palette);
+    }
+
+    /// Collapse palette entries holding the same state onto the first of
+    /// them, rewriting the cells that pointed at the later copies. Returns
+    /// whether anything was merged. Version conversion can map several old
+    /// states to one new one; without this the palette keeps every copy and
+    /// lookups by state only ever find one of them.
+    pub(crate) fn dedup_palette(&mut self) -> bool {
+        let ids = StateId::of_all(&self.palette);
+        let mut first: FxHashMap<StateId, usize> =
+            FxHashMap::with_capacity_and_hasher(ids.len(), Default::default());
+        let remap: Vec<usize> = ids
+            .iter()
+            .map(|&id| {
+                let next = first.len();
+                *first.entry(id).or_insert(next)
+            })
+            .collect();
+        if first.len() == self.palette.len() {
+            return false;
+        }
+        let mut palette = Vec::with_capacity(first.len());
+        for (index, block) in std::mem::take(&mut self.palette).into_iter().enumerate() {
+            if remap[index] == palette.len() {
+                palette.push(block);
+            }
+        }
+        self.palette = palette;
+        self.blocks.remap_values(&remap);
+        self.rebuild_palette_index();
+        self.rebuild_air_index();
+        // A merged copy of air counted as non-air before.
+        self.rebuild_non_air_count();
+        true
+    }
+
+    /// Interned ids of the palette, parallel to [`Region::get_palette`].
+    /// Computed on the fly if the cache is out of step (a region
+    /// deserialized without `rebuild_palette_index`).
+    pub fn palette_ids(&self) -> Cow<'_, [StateId]> {
+        if self.palette_ids.len() == self.palette.len() {
+            Cow::Borrowed(&self.palette_ids)
+        } else {
+            Cow::Owned(StateId::of_all(&self.palette))
+        }
     }
 
     pub fn get_block_entities_as_list(&self) -> Vec<BlockEntity> {
@@ -211,16 +830,18 @@ impl Region {
 
         let index = self.coords_to_index(x, y, z);
         let palette_index = self.get_or_insert_in_palette(block);
-        let old_palette_index = self.blocks[index];
-        self.blocks[index] = palette_index;
+        let old_palette_index = self.blocks.replace(index, palette_index);
+        self.mark_dirty(x, y, z);
 
         // Update non_air_count based on old vs new block
         let old_is_air = old_palette_index == self.cached_air_index;
         let new_is_air = palette_index == self.cached_air_index;
         if old_is_air && !new_is_air {
             self.non_air_count += 1;
+            self.bump_section(x, y, z, 1);
         } else if !old_is_air && new_is_air {
             self.non_air_count -= 1;
+            self.bump_section(x, y, z, -1);
         }
 
         // Update tight bounds if this is a non-air block
@@ -231,6 +852,129 @@ impl Region {
         true
     }
 
+    /// Set every redstone wire's `north`, `south`, `east` and `west` from its
+    /// neighbours in this region; see
+    /// [`UniversalSchematic::fix_redstone_connectivity_for_region`](crate::UniversalSchematic::fix_redstone_connectivity_for_region).
+    ///
+    /// Wire, connectable and opaque blocks are told apart once per palette
+    /// entry. Wire cells are found by palette index, one y-layer per task in
+    /// parallel, and their neighbours are read straight from storage. Each
+    /// distinct wire state and set of connections resolves to a palette entry
+    /// once, and only cells whose state changes are written.
+    pub(crate) fn fix_redstone_connectivity(&mut self) {
+        use crate::universal_schematic::{is_opaque, is_redstone_connectable};
+        use rayon::prelude::*;
+
+        const WIRE: u8 = 1;
+        const CONNECTS: u8 = 2;
+        const OPAQUE: u8 = 4;
+        const SIDE: u8 = 1;
+        const UP: u8 = 2;
+        // North, south, east, west: opposite sides differ in the lowest bit.
+        const DIRECTIONS: [(&str, i32, i32); 4] = [
+            ("north", 0, -1),
+            ("south", 0, 1),
+            ("east", 1, 0),
+            ("west", -1, 0),
+        ];
+
+        let kinds: Vec<u8> = self
+            .palette
+            .iter()
+            .map(|b| {
+                (b.name == "minecraft:redstone_wire") as u8 * WIRE
+                    | is_redstone_connectable(b) as u8 * CONNECTS
+                    | is_opaque(b) as u8 * OPAQUE
+            })
+            .collect();
+        if !kinds.iter().any(|k| k & WIRE != 0) {
+            return;
+        }
+
+        let region = &*self;
+        let kind_at = |x: i32, y: i32, z: i32| -> Option<u8> {
+            region
+                .is_in_region(x, y, z)
+                .then(|| kinds[region.blocks.at(region.coords_to_index(x, y, z))])
+        };
+        let is = |kind: Option<u8>, flag: u8| kind.is_some_and(|k| k & flag != 0);
+        // Two bits per direction: 0 none, SIDE or UP.
+        let connections = |x: i32, y: i32, z: i32| -> u8 {
+            let open_above = !is(kind_at(x, y + 1, z), OPAQUE);
+            let mut sides = [0u8; 4];
+            for (side, &(_, dx, dz)) in sides.iter_mut().zip(&DIRECTIONS) {
+                let level = kind_at(x + dx, y, z + dz);
+                *side = if is(level, CONNECTS)
+                    || (is(kind_at(x + dx, y - 1, z + dz), WIRE)
+                        && level.is_some_and(|k| k & OPAQUE == 0))
+                {
+                    SIDE
+                } else if open_above && is(kind_at(x + dx, y + 1, z + dz), WIRE) {
+                    UP
+                } else {
+                    0
+                };
+            }
+            // A wire with a single connection runs straight through.
+            if sides.iter().filter(|&&s| s != 0).count() == 1 {
+                let connected = sides.iter().position(|&s| s != 0).unwrap();
+                sides[connected ^ 1] = SIDE;
+            }
+            sides
+                .iter()
+                .enumerate()
+                .fold(0, |code, (i, &s)| code | s << (2 * i))
+        };
+
+        let min = self.bbox.min;
+        let width = self.cached_width as usize;
+        let layer = self.cached_width_x_length as usize;
+        let height = (self.bbox.max.1 - min.1 + 1) as usize;
+        let wires: Vec<(usize, usize, u8)> = (0..height)
+            .into_par_iter()
+            .flat_map_iter(|dy| {
+                let mut cells = vec![0u32; layer];
+                region.blocks.read_into_u32(dy * layer, &mut cells);
+                let y = min.1 + dy as i32;
+                cells
+                    .into_iter()
+                    .enumerate()
+                    .filter(|&(_, p)| kinds[p as usize] & WIRE != 0)
+                    .map(|(i, p)| {
+                        let (x, z) = (min.0 + (i % width) as i32, min.2 + (i / width) as i32);
+                        (dy * layer + i, p as usize, connections(x, y, z))
+                    })
+                    .collect::<Vec<_>>()
+            })
+            .collect();
+
+        let mut resolved: FxHashMap<(usize, u8), usize> = FxHashMap::default();
+        for (index, old, code) in wires {
+            let new = match resolved.get(&(old, code)) {
+                Some(&new) => new,
+                None => {
+                    let mut state = self.palette[old].clone();
+                    for (i, (direction, _, _)) in DIRECTIONS.iter().enumerate() {
+                        let value = match code >> (2 * i) & 3 {
+                            SIDE => "side",
+                            UP => "up",
+                            _ => "none",
+                        };
+                        state.set_property(*direction, value);
+                    }
+                    let new = self.get_or_insert_in_palette(&state);
+                    resolved.insert((old, code), new);
+                    new
+                }
+            };
+            if new != old {
+                self.blocks.replace(index, new);
+                let (x, y, z) = self.index_to_coords(index);
+                self.mark_dirty(x, y, z);
+            }
+        }
+    }
+
     pub fn set_block_entity(&mut self, position: BlockPosition, block_entity: BlockEntity) -> bool {
         self.block_entities
             .insert((position.x, position.y, position.z), block_entity);
@@ -273,6 +1017,44 @@ impl Region {
         )
     }
 
+    /// Every cell as `((x, y, z), palette_index)`, in storage order (x
+    /// fastest, then z, then y). Coordinates are stepped, not divided out of
+    /// the index.
+    pub fn iter_cells(&self) -> impl Iterator<Item = ((i32, i32, i32), usize)> + '_ {
+        CellCoords::new(&self.bbox).zip(self.blocks.iter())
+    }
+
+    /// The cells whose palette index is not `value`, in storage order. When
+    /// `value` is the air index only the tight bounds are walked.
+    pub fn cells_ne(&self, value: usize) -> CellsNe<'_> {
+        let bounds = match &self.tight_bounds {
+            Some(tight) if value == self.cached_air_index => tight.clone(),
+            _ => self.bbox.clone(),
+        };
+        self.cells_ne_in(&bounds, value)
+    }
+
+    /// [`Region::cells_ne`] restricted to `bounds`, which must lie inside the
+    /// region's bounding box.
+    pub fn cells_ne_in(&self, bounds: &BoundingBox, value: usize) -> CellsNe<'_> {
+        let row_len = (bounds.max.0 - bounds.min.0 + 1) as usize;
+        let layer_start = self.coords_to_index(bounds.min.0, bounds.min.1, bounds.min.2);
+        CellsNe {
+            blocks: &self.blocks,
+            value,
+            bounds: bounds.clone(),
+            row_len,
+            row_stride: self.cached_width as usize,
+            layer_stride: self.cached_width_x_length as usize,
+            y: bounds.min.1,
+            z: bounds.min.2,
+            layer_start,
+            row_start: layer_start,
+            cursor: layer_start,
+            row_end: layer_start + row_len,
+        }
+    }
+
     #[inline(always)]
     pub fn is_in_region(&self, x: i32, y: i32, z: i32) -> bool {
         self.bbox.contains((x, y, z))
@@ -393,26 +1175,22 @@ impl Region {
                     let dz_dst = (z - tb_min_z) as usize;
                     let src_start = dy_src * old_w * old_l + dz_src * old_w + x_off_src;
                     let dst_start = dy_dst * compact_w * compact_l + dz_dst * compact_w;
-                    compact.blocks[dst_start..dst_start + row_len]
-                        .copy_from_slice(&self.blocks[src_start..src_start + row_len]);
+                    compact
+                        .blocks
+                        .copy_range_from(dst_start, &self.blocks, src_start, row_len);
                 }
             }
         }
 
         #[cfg(not(target_arch = "wasm32"))]
         {
-            use rayon::prelude::*;
-            use rayon::slice::ParallelSliceMut;
             let y_slice_size = compact_w * compact_l;
-            let src_blocks = &self.blocks;
             let bbox_min_y = self.bbox.min.1;
             let bbox_min_z = self.bbox.min.2;
 
             compact
                 .blocks
-                .par_chunks_mut(y_slice_size)
-                .enumerate()
-                .for_each(|(dy_dst, dst_y_slice)| {
+                .par_copy_slabs(&self.blocks, y_slice_size, |dy_dst, dst_y_slice| {
                     let y = tb_min_y + dy_dst as i32;
                     let dy_src = (y - bbox_min_y) as usize;
 
@@ -423,8 +1201,7 @@ impl Region {
                         let src_start = dy_src * old_w * old_l + dz_src * old_w + x_off_src;
                         let dst_start_in_slice = dz_dst * compact_w;
 
-                        dst_y_slice[dst_start_in_slice..dst_start_in_slice + row_len]
-                            .copy_from_slice(&src_blocks[src_start..src_start + row_len]);
+                        dst_y_slice.copy(dst_start_in_slice, src_start, row_len);
                     }
                 });
         }
@@ -433,7 +1210,11 @@ impl Region {
         compact.tight_bounds = Some(tight_bounds.clone());
 
         for (pos, be) in self.block_entities.iter() {
-            compact.block_entities.insert(pos, be.clone());
+            // Shared templates carry a stale position; writers of the compact
+            // copy read `position`, so pin it to the storage key.
+            let mut be = be.clone();
+            be.position = pos;
+            compact.block_entities.insert(pos, be);
         }
         for entity in &self.entities {
             compact.entities.push(entity.clone());
@@ -487,18 +1268,16 @@ impl Region {
                         let src_start = dy_src * old_w * old_l + dz_src * old_w + x_off_src;
                         let dst_start =
                             dy_dst * compact_w * compact_l + dz_dst * compact_w + x_off_dst;
-                        compact.blocks[dst_start..dst_start + row_len]
-                            .copy_from_slice(&self.blocks[src_start..src_start + row_len]);
+                        compact
+                            .blocks
+                            .copy_range_from(dst_start, &self.blocks, src_start, row_len);
                     }
                 }
             }
 
             #[cfg(not(target_arch = "wasm32"))]
             {
-                use rayon::prelude::*;
-                use rayon::slice::ParallelSliceMut;
                 let y_slice_size = compact_w * compact_l;
-                let src_blocks = &self.blocks;
                 let bbox_min_y = self.bbox.min.1;
                 let bbox_min_z = self.bbox.min.2;
                 let content_min_y = content_pos.1;
@@ -506,9 +1285,7 @@ impl Region {
 
                 compact
                     .blocks
-                    .par_chunks_mut(y_slice_size)
-                    .enumerate()
-                    .for_each(|(dy_dst, dst_y_slice)| {
+                    .par_copy_slabs(&self.blocks, y_slice_size, |dy_dst, dst_y_slice| {
                         let y = content_min_y + dy_dst as i32;
                         if y < tb_min_y || y > tb_max_y {
                             return;
@@ -522,8 +1299,7 @@ impl Region {
                             let src_start = dy_src * old_w * old_l + dz_src * old_w + x_off_src;
                             let dst_start_in_slice = dz_dst * compact_w + x_off_dst;
 
-                            dst_y_slice[dst_start_in_slice..dst_start_in_slice + row_len]
-                                .copy_from_slice(&src_blocks[src_start..src_start + row_len]);
+                            dst_y_slice.copy(dst_start_in_slice, src_start, row_len);
                         }
                     });
             }
@@ -533,7 +1309,11 @@ impl Region {
         compact.tight_bounds = self.tight_bounds.clone();
 
         for (pos, be) in self.block_entities.iter() {
-            compact.block_entities.insert(pos, be.clone());
+            // Shared templates carry a stale position; writers of the compact
+            // copy read `position`, so pin it to the storage key.
+            let mut be = be.clone();
+            be.position = pos;
+            compact.block_entities.insert(pos, be);
         }
         for entity in &self.entities {
             compact.entities.push(entity.clone());
@@ -548,7 +1328,7 @@ impl Region {
         }
 
         let index = self.coords_to_index(x, y, z);
-        let block_index = self.blocks[index];
+        let block_index = self.blocks.at(index);
         let palette_index = self.palette.get(block_index);
         palette_index
     }
@@ -559,7 +1339,7 @@ impl Region {
         }
 
         let index = self.coords_to_index(x, y, z);
-        let block_index = self.blocks[index];
+        let block_index = self.blocks.at(index);
         Some(block_index)
     }
 
@@ -567,6 +1347,15 @@ impl Region {
         self.size.0 as usize * self.size.1 as usize * self.size.2 as usize
     }
 
+    /// Grow the allocated bounds to include `(x, y, z)`.
+    ///
+    /// Growth is geometric per axis, like `Vec` doubling: each axis the point
+    /// falls outside grows past it by the axis' current extent (at least
+    /// [`MIN_GROWTH`]), so a sweep of `set_block` calls marching along one
+    /// axis re-lays out the array O(log n) times rather than once per step.
+    /// The slack is allocated air outside the logical content, which
+    /// `get_tight_bounds` tracks and `to_compact` trims to at save time.
+    /// Use [`Region::ensure_bounds`] to grow to an exact, known shape.
     pub fn expand_to_fit(&mut self, x: i32, y: i32, z: i32) {
         let current_bounding_box = self.get_bounding_box();
 
@@ -574,58 +1363,27 @@ impl Region {
             return;
         }
 
-        let current_volume = current_bounding_box.volume();
-        let current_size = current_bounding_box.get_dimensions();
-
-        // Choose expansion strategy based on current size
-        let expansion_size = if current_volume < 1000 {
-            // Small regions: fixed large expansion
-            (64, 64, 64)
-        } else if current_volume < 100_000 {
-            // Medium regions: proportional expansion
-            (current_size.0 / 2, current_size.1 / 2, current_size.2 / 2)
-        } else {
-            // Large regions: chunk-based expansion
-            (128, 128, 128)
-        };
-
-        let new_min = (
-            if x < current_bounding_box.min.0 {
-                x - expansion_size.0
-            } else {
-                current_bounding_box.min.0
-            },
-            if y < current_bounding_box.min.1 {
-                y - expansion_size.1
-            } else {
-                current_bounding_box.min.1
-            },
-            if z < current_bounding_box.min.2 {
-                z - expansion_size.2
-            } else {
-                current_bounding_box.min.2
-            },
-        );
-
-        let new_max = (
-            if x > current_bounding_box.max.0 {
-                x + expansion_size.0
+        let (min, max) = (current_bounding_box.min, current_bounding_box.max);
+        let size = current_bounding_box.get_dimensions();
+        let grow = |p: i32, min: i32, max: i32, extent: i32| {
+            let slack = i64::from(extent.max(MIN_GROWTH));
+            let lo = if p < min {
+                (i64::from(p) - slack).max(i64::from(i32::MIN)) as i32
             } else {
-                current_bounding_box.max.0
-            },
-            if y > current_bounding_box.max.1 {
-                y + expansion_size.1
+                min
+            };
+            let hi = if p > max {
+                (i64::from(p) + slack).min(i64::from(i32::MAX)) as i32
             } else {
-                current_bounding_box.max.1
-            },
-            if z > current_bounding_box.max.2 {
-                z + expansion_size.2
-            } else {
-                current_bounding_box.max.2
-            },
-        );
+                max
+            };
+            (lo, hi)
+        };
+        let (min_x, max_x) = grow(x, min.0, max.0, size.0);
+        let (min_y, max_y) = grow(y, min.1, max.1, size.1);
+        let (min_z, max_z) = grow(z, min.2, max.2, size.2);
 
-        let new_bounding_box = BoundingBox::new(new_min, new_max);
+        let new_bounding_box = BoundingBox::new((min_x, min_y, min_z), (max_x, max_y, max_z));
         self.expand_to_bounding_box(new_bounding_box);
     }
 
@@ -677,8 +1435,19 @@ impl Region {
             return;
         }
 
+        if self.blocks.is_sparse() {
+            // Sections are keyed by world position: nothing moves.
+            let (w, h, l) = new_size;
+            self.blocks
+                .rebound(new_position, (w as usize, h as usize, l as usize));
+            self.position = new_position;
+            self.size = new_size;
+            self.rebuild_bbox();
+            return;
+        }
+
         let air_id = self.cached_air_index;
-        let mut new_blocks = vec![air_id; new_bounding_box.volume() as usize];
+        let mut new_blocks = BlockStorage::filled(new_bounding_box.volume() as usize, air_id);
 
         // Phase 2: Row-level copy instead of per-element coords
         let old_w = self.cached_width as usize;
@@ -699,8 +1468,7 @@ impl Region {
             for dz in 0..old_l {
                 let src_start = dy * old_w * old_l + dz * old_w;
                 let dst_start = (dy + y_off) * new_w * new_l + (dz + z_off) * new_w + x_off;
-                new_blocks[dst_start..dst_start + old_w]
-                    .copy_from_slice(&self.blocks[src_start..src_start + old_w]);
+                new_blocks.copy_range_from(dst_start, &self.blocks, src_start, old_w);
             }
         }
 
@@ -710,98 +1478,193 @@ impl Region {
         self.rebuild_bbox();
     }
     fn calculate_bits_per_block(&self) -> usize {
-        let palette_size = self.palette.len();
-        if palette_size <= 1 {
-            2
-        } else {
-            std::cmp::max(
-                (usize::BITS - (palette_size - 1).leading_zeros()) as usize,
-                2,
-            )
-        }
+        packed_longs::bits_for(self.palette.len(), 2)
     }
 
-    pub fn merge(&mut self, other: &Region) {
-        let combined_bounding_box = self.get_bounding_box().union(&other.get_bounding_box());
-        let new_size = combined_bounding_box.get_dimensions();
-        let new_position = combined_bounding_box.min;
-
-        let (new_w, _, new_l) = new_size;
-        let new_w = new_w as usize;
-        let new_l = new_l as usize;
-
-        let mut new_blocks = vec![0usize; combined_bounding_box.volume() as usize];
+    /// This region's palette extended with `other`'s missing states, plus the
+    /// table mapping each of `other`'s palette indices into it. Existing
+    /// indices of `self` stay valid.
+    ///
+    /// States are matched by interned id, so no `BlockState` is hashed or
+    /// cloned except the ones `other` adds.
+    fn merged_palette(&self, other: &Region) -> (Vec<BlockState>, Vec<usize>) {
         let mut new_palette = self.palette.clone();
-        let mut reverse_new_palette: HashMap<BlockState, usize> = HashMap::new();
-        for (index, block) in self.palette.iter().enumerate() {
-            reverse_new_palette.insert(block.clone(), index);
-        }
+        let mut lookup = self.palette_lookup();
+        let other_remap = other.append_palette_to(&mut new_palette, &mut lookup);
+        (new_palette, other_remap)
+    }
 
-        // Phase 5: Pre-build remap table for self (identity since palette is same)
-        // For self, palette indices are identity, so just row-copy with offset
-        {
-            let old_w = self.cached_width as usize;
-            let old_l = self.cached_length as usize;
-            let (_, old_h, _) = self.bbox.get_dimensions();
-            let old_h = old_h as usize;
-
-            let x_off = (self.bbox.min.0 - combined_bounding_box.min.0) as usize;
-            let y_off = (self.bbox.min.1 - combined_bounding_box.min.1) as usize;
-            let z_off = (self.bbox.min.2 - combined_bounding_box.min.2) as usize;
-
-            for dy in 0..old_h {
-                for dz in 0..old_l {
-                    let src_start = dy * old_w * old_l + dz * old_w;
-                    let dst_start = (dy + y_off) * new_w * new_l + (dz + z_off) * new_w + x_off;
-                    new_blocks[dst_start..dst_start + old_w]
-                        .copy_from_slice(&self.blocks[src_start..src_start + old_w]);
-                }
-            }
+    /// Id → index lookup over this region's palette (the last index wins for
+    /// duplicated states, as in `palette_index`).
+    fn palette_lookup(&self) -> FxHashMap<StateId, usize> {
+        let mut lookup =
+            FxHashMap::with_capacity_and_hasher(self.palette.len(), Default::default());
+        for (index, &id) in self.palette_ids().iter().enumerate() {
+            lookup.insert(id, index);
         }
-
-        // Phase 5: Pre-build remap table for other palette
-        let other_air_index = other.cached_air_index;
-        let mut other_remap: Vec<usize> = Vec::with_capacity(other.palette.len());
-        for (idx, block) in other.palette.iter().enumerate() {
-            if let Some(&existing) = reverse_new_palette.get(block) {
-                other_remap.push(existing);
+        lookup
+    }
+
+    /// Append the states of this region's palette missing from `palette`
+    /// (indexed by `lookup`) and return the remap from this palette into it.
+    fn append_palette_to(
+        &self,
+        palette: &mut Vec<BlockState>,
+        lookup: &mut FxHashMap<StateId, usize>,
+    ) -> Vec<usize> {
+        let mut remap: Vec<usize> = Vec::with_capacity(self.palette.len());
+        for (block, &id) in self.palette.iter().zip(self.palette_ids().iter()) {
+            if let Some(&existing) = lookup.get(&id) {
+                remap.push(existing);
             } else {
-                let new_idx = new_palette.len();
-                new_palette.push(block.clone());
-                reverse_new_palette.insert(block.clone(), new_idx);
-                other_remap.push(new_idx);
+                let new_idx = palette.len();
+                palette.push(block.clone());
+                lookup.insert(id, new_idx);
+                remap.push(new_idx);
             }
-            // Mark air indices in remap for skip check
-            let _ = idx;
         }
-
-        // Copy other blocks using remap table, row by row
-        {
-            let other_w = other.cached_width as usize;
-            let other_l = other.cached_length as usize;
-            let (_, other_h, _) = other.bbox.get_dimensions();
-            let other_h = other_h as usize;
-
-            let x_off = (other.bbox.min.0 - combined_bounding_box.min.0) as usize;
-            let y_off = (other.bbox.min.1 - combined_bounding_box.min.1) as usize;
-            let z_off = (other.bbox.min.2 - combined_bounding_box.min.2) as usize;
-
-            for dy in 0..other_h {
-                for dz in 0..other_l {
-                    let src_start = dy * other_w * other_l + dz * other_w;
-                    let dst_start = (dy + y_off) * new_w * new_l + (dz + z_off) * new_w + x_off;
-                    for dx in 0..other_w {
-                        let src_idx = other.blocks[src_start + dx];
-                        if src_idx == other_air_index {
-                            continue; // Skip air from other region
+        remap
+    }
+
+    /// Dense storage for `bbox` built from `layers`, applied in order (later
+    /// layers win). Every layer's palette remap is computed up front, so the
+    /// copy is row-level and runs over Y slabs in parallel; slabs a layer does
+    /// not reach are skipped for it. Cells no layer writes hold 0.
+    fn compose_layers(
+        bbox: &BoundingBox,
+        palette_len: usize,
+        layers: &[MergeLayer],
+    ) -> BlockStorage {
+        let (w, _, l) = bbox.get_dimensions();
+        let (w, l) = (w as usize, l as usize);
+        let mut blocks = BlockStorage::filled(bbox.volume() as usize, 0);
+        blocks.ensure_holds(palette_len.saturating_sub(1));
+        blocks.for_each_slab(w * l, |dy, slab| {
+            let y = bbox.min.1 + dy as i32;
+            for layer in layers {
+                let bounds = &layer.bounds;
+                if y < bounds.min.1 || y > bounds.max.1 {
+                    continue;
+                }
+                let row_len = (bounds.max.0 - bounds.min.0 + 1) as usize;
+                let dst_x = (bounds.min.0 - bbox.min.0) as usize;
+                for z in bounds.min.2..=bounds.max.2 {
+                    let src_start = layer.region.coords_to_index(bounds.min.0, y, z);
+                    let dst_start = (z - bbox.min.2) as usize * w + dst_x;
+                    match (&layer.remap, layer.skip) {
+                        (None, None) => {
+                            slab.copy_from(dst_start, &layer.region.blocks, src_start, row_len)
                         }
-                        new_blocks[dst_start + dx] = other_remap[src_idx];
+                        (remap, skip) => slab.copy_remapped(
+                            dst_start,
+                            &layer.region.blocks,
+                            src_start,
+                            row_len,
+                            remap.as_deref(),
+                            skip,
+                        ),
                     }
                 }
             }
+        });
+        blocks
+    }
+
+    /// Merge `layers` (lowest precedence first) into one new region in a
+    /// single pass. Equivalent to cloning the first and calling
+    /// `merge_with_precedence` with each later one in turn, which re-copies
+    /// the whole combined volume per layer: every later layer overwrites its
+    /// tight bounds verbatim, air included.
+    pub(crate) fn merge_layers(name: String, layers: &[&Region]) -> Region {
+        let (base, rest) = layers.split_first().expect("merge_layers needs a region");
+        let bbox = rest.iter().fold(base.get_bounding_box(), |bbox, region| {
+            bbox.union(&region.get_bounding_box())
+        });
+
+        let mut palette = base.palette.clone();
+        let mut lookup = base.palette_lookup();
+        // Rows outside the base's content are already the fill value when
+        // its air is palette entry 0.
+        let base_bounds = match &base.tight_bounds {
+            Some(tight) if base.cached_air_index == 0 => tight.clone(),
+            _ => base.get_bounding_box(),
+        };
+        let mut plan = vec![MergeLayer {
+            region: base,
+            bounds: base_bounds,
+            remap: None,
+            skip: None,
+        }];
+        for region in rest {
+            let remap = Some(region.append_palette_to(&mut palette, &mut lookup));
+            // Without tight bounds there is no visible box to overwrite;
+            // fall back to copying the non-air cells of the whole region.
+            plan.push(match &region.tight_bounds {
+                Some(tight) => MergeLayer {
+                    region,
+                    bounds: tight.clone(),
+                    remap,
+                    skip: None,
+                },
+                None => MergeLayer {
+                    region,
+                    bounds: region.get_bounding_box(),
+                    remap,
+                    skip: Some(region.cached_air_index),
+                },
+            });
         }
+        let blocks = Self::compose_layers(&bbox, palette.len(), &plan);
+
+        // Sparse construction allocates nothing; the composed blocks replace
+        // its storage.
+        let (position, size) = bbox.to_position_and_size();
+        let mut merged = Region::new_sparse(name, position, size);
+        merged.blocks = blocks;
+        merged.palette = palette;
+        merged.rebuild_palette_index();
+        merged.rebuild_air_index();
+        merged.rebuild_non_air_count();
+        merged.rebuild_tight_bounds();
+        for region in layers {
+            merged.merge_entities(region);
+            merged.merge_block_entities(region);
+        }
+        merged
+    }
+
+    pub fn merge(&mut self, other: &Region) {
+        let combined_bounding_box = self.get_bounding_box().union(&other.get_bounding_box());
+        if self.blocks.is_sparse() {
+            self.merge_sparse(other, combined_bounding_box);
+            return;
+        }
+        let (new_palette, other_remap) = self.merged_palette(other);
+
+        // Self keeps its indices and copies its whole box. Other's air never
+        // overwrites, so only rows inside its content are visited.
+        let layers = [
+            MergeLayer {
+                region: self,
+                bounds: self.get_bounding_box(),
+                remap: None,
+                skip: None,
+            },
+            MergeLayer {
+                region: other,
+                bounds: other
+                    .tight_bounds
+                    .clone()
+                    .unwrap_or_else(|| other.get_bounding_box()),
+                remap: Some(other_remap),
+                skip: Some(other.cached_air_index),
+            },
+        ];
+        let new_blocks = Self::compose_layers(&combined_bounding_box, new_palette.len(), &layers);
+        drop(layers);
 
         // Update region properties
+        let (new_position, new_size) = combined_bounding_box.to_position_and_size();
         self.position = new_position;
         self.size = new_size;
         self.blocks = new_blocks;
@@ -812,12 +1675,51 @@ impl Region {
         self.rebuild_palette_index();
         self.rebuild_air_index();
         self.rebuild_non_air_count();
+        self.include_tight_bounds(other);
 
         // Merge entities and block entities
         self.merge_entities(other);
         self.merge_block_entities(other);
     }
 
+    /// Grow tight bounds to cover `other`'s (after merging its blocks in).
+    fn include_tight_bounds(&mut self, other: &Region) {
+        if let Some(bounds) = other.tight_bounds.clone() {
+            self.update_tight_bounds(bounds.min.0, bounds.min.1, bounds.min.2);
+            self.update_tight_bounds(bounds.max.0, bounds.max.1, bounds.max.2);
+        }
+    }
+
+    /// [`Region::merge`] for sparse storage: grow in place (an O(1) rebound)
+    /// and write only `other`'s non-air cells, instead of rebuilding the
+    /// combined volume.
+    fn merge_sparse(&mut self, other: &Region, combined_bounding_box: BoundingBox) {
+        let (new_palette, other_remap) = self.merged_palette(other);
+        self.expand_to_bounding_box(combined_bounding_box);
+
+        let blocks = &mut self.blocks;
+        let (base, w, wl) = (self.bbox.min, self.cached_width, self.cached_width_x_length);
+        other
+            .blocks
+            .for_each_index_ne(other.cached_air_index, |src_index| {
+                let (x, y, z) = other.index_to_coords(src_index);
+                let dx = i64::from(x - base.0);
+                let dy = i64::from(y - base.1);
+                let dz = i64::from(z - base.2);
+                let index = (dx + dz * w + dy * wl) as usize;
+                blocks.set(index, other_remap[other.blocks.at(src_index)]);
+            });
+
+        self.palette = new_palette;
+        self.rebuild_palette_index();
+        self.rebuild_air_index();
+        self.rebuild_non_air_count();
+        self.include_tight_bounds(other);
+
+        self.merge_entities(other);
+        self.merge_block_entities(other);
+    }
+
     /// Merge `other` as a higher-precedence region. Unlike the general merge,
     /// air cells inside `other`'s allocated portion of its visible content
     /// bounds overwrite lower-precedence blocks, matching composite reads.
@@ -925,7 +1827,7 @@ impl Region {
         );
 
         let mut blocks_tag = NbtCompound::new();
-        for (index, &block_index) in self.blocks.iter().enumerate() {
+        for (index, block_index) in self.blocks.iter().enumerate() {
             let (x, y, z) = self.index_to_coords(index);
             blocks_tag.insert(
                 format!("{},{},{}", x, y, z),
@@ -952,6 +1854,8 @@ impl Region {
 
         let mut block_entities_tag = NbtCompound::new();
         for ((x, y, z), block_entity) in self.block_entities.iter() {
+            let mut block_entity = block_entity.clone();
+            block_entity.position = (x, y, z);
             block_entities_tag.insert(format!("{},{},{}", x, y, z), block_entity.to_nbt());
         }
         tag.insert("BlockEntities", NbtTag::Compound(block_entities_tag));
@@ -992,14 +1896,14 @@ impl Region {
         let blocks_tag = nbt
             .get::<_, &NbtCompound>("Blocks")
             .map_err(|e| format!("Failed to get Blocks: {}", e))?;
-        let mut blocks = vec![0; (size.0 * size.1 * size.2) as usize];
+        let mut blocks = BlockStorage::filled((size.0 * size.1 * size.2) as usize, 0);
         for (key, value) in blocks_tag.inner() {
             if let NbtTag::Int(index) = value {
                 let coords: Vec<i32> = key.split(',').map(|s| s.parse::<i32>().unwrap()).collect();
                 if coords.len() == 3 {
                     let block_index =
                         (coords[1] * size.0 * size.2 + coords[2] * size.0 + coords[0]) as usize;
-                    blocks[block_index] = *index as usize;
+                    blocks.set(block_index, *index as usize);
                 }
             }
         }
@@ -1007,6 +1911,7 @@ impl Region {
         let entities_tag = nbt
             .get::<_, &NbtList>("Entities")
             .map_err(|e| format!("Failed to get Entities: {}", e))?;
+        let mut interner = EntityInterner::new();
         let entities = entities_tag
             .iter()
             .filter_map(|tag| {
@@ -1016,6 +1921,7 @@ impl Region {
                     None
                 }
             })
+            .map(|entity| interner.intern(entity))
             .collect();
 
         let block_entities_tag = nbt
@@ -1041,6 +1947,7 @@ impl Region {
             entities,
             block_entities,
             palette_index: FxHashMap::default(),
+            palette_ids: Vec::new(),
             bbox: BoundingBox::from_position_and_size(position, size),
             tight_bounds: None,
             cached_width: 0,
@@ -1048,6 +1955,8 @@ impl Region {
             cached_width_x_length: 0,
             cached_air_index: 0,
             non_air_count: 0,
+            sections: OnceLock::new(),
+            dirty: None,
         };
 
         region.rebuild_palette_index();
@@ -1101,83 +2010,39 @@ impl Region {
     }
 
     pub fn unpack_block_states(&self, packed_states: &[i64]) -> Vec<usize> {
-        let bits_per_block = self.calculate_bits_per_block();
-        let mask: u64 = (1u64 << bits_per_block) - 1;
-        let volume = self.volume();
-
-        let mut blocks = Vec::with_capacity(volume);
-
-        if 64 % bits_per_block == 0 {
-            // Fast path: entries never cross i64 boundaries (bits_per_block = 2, 4, 8, 16, 32)
-            let entries_per_long = 64 / bits_per_block;
-            let mut remaining = volume;
-            for &packed in packed_states {
-                let packed_u64 = packed as u64;
-                let count = remaining.min(entries_per_long);
-                for i in 0..count {
-                    blocks.push(((packed_u64 >> (i * bits_per_block)) & mask) as usize);
-                }
-                remaining -= count;
-            }
-        } else {
-            // Slow path: entries may cross i64 boundaries
-            for index in 0..volume {
-                let bit_index = index * bits_per_block;
-                let start_long_index = bit_index / 64;
-                let start_offset = bit_index % 64;
-
-                let value = if start_offset + bits_per_block <= 64 {
-                    ((packed_states[start_long_index] as u64) >> start_offset) & mask
-                } else {
-                    let low_bits = ((packed_states[start_long_index] as u64) >> start_offset)
-                        & ((1u64 << (64 - start_offset)) - 1);
-                    let high_bits = (packed_states[start_long_index + 1] as u64)
-                        & ((1u64 << (bits_per_block - (64 - start_offset))) - 1);
-                    low_bits | (high_bits << (64 - start_offset))
-                };
-
-                blocks.push(value as usize);
-            }
-        }
-
+        let mut blocks = vec![0; self.volume()];
+        packed_longs::unpack(
+            packed_states,
+            self.calculate_bits_per_block(),
+            Layout::Spanning,
+            &mut blocks,
+        );
         blocks
     }
 
     pub(crate) fn create_packed_block_states(&self) -> Vec<i64> {
-        let bits_per_block = self.calculate_bits_per_block();
-        let size = self.blocks.len();
-        let expected_len = (size * bits_per_block).div_ceil(64);
-
-        let mut packed_states = vec![0i64; expected_len];
-        let mask: u64 = (1u64 << bits_per_block) - 1;
-
-        if 64 % bits_per_block == 0 {
-            // Fast path: entries never cross i64 boundaries (bits_per_block = 2, 4, 8, 16, 32)
-            let entries_per_long = 64 / bits_per_block;
-            for (chunk_idx, chunk) in self.blocks.chunks(entries_per_long).enumerate() {
-                let mut packed: u64 = 0;
-                for (i, &block_state) in chunk.iter().enumerate() {
-                    packed |= (block_state as u64 & mask) << (i * bits_per_block);
-                }
-                packed_states[chunk_idx] = packed as i64;
-            }
-        } else {
-            // Slow path: entries may cross i64 boundaries
-            for (index, &block_state) in self.blocks.iter().enumerate() {
-                let bit_index = index * bits_per_block;
-                let start_long_index = bit_index / 64;
-                let end_long_index = (bit_index + bits_per_block - 1) / 64;
-                let start_offset = bit_index % 64;
-                let value = (block_state as u64) & mask;
-
-                packed_states[start_long_index] |= (value << start_offset) as i64;
-                if start_long_index != end_long_index {
-                    packed_states[end_long_index] |= (value >> (64 - start_offset)) as i64;
-                }
-            }
+        self.pack_block_states(self.calculate_bits_per_block(), |_| {})
+    }
+
+    /// Pack every cell in Litematica's spanning layout at `bits` per entry,
+    /// passing each batch of indices through `remap` first.
+    pub(crate) fn pack_block_states(
+        &self,
+        bits: usize,
+        mut remap: impl FnMut(&mut [u32]),
+    ) -> Vec<i64> {
+        let total = self.blocks.len();
+        let mut packed =
+            Vec::with_capacity(packed_longs::packed_len(total, bits, Layout::Spanning));
+        // A multiple of 64 entries, so successive batches concatenate.
+        let mut batch = [0u32; 4096];
+        for start in (0..total).step_by(batch.len()) {
+            let n = (total - start).min(batch.len());
+            self.blocks.read_into_u32(start, &mut batch[..n]);
+            remap(&mut batch[..n]);
+            packed_longs::pack(&batch[..n], bits, Layout::Spanning, &mut packed);
         }
-
-        packed_states
+        packed
     }
 
     pub fn get_palette(&self) -> Vec<BlockState> {
@@ -1195,7 +2060,7 @@ impl Region {
     pub fn count_block_types(&self) -> HashMap<BlockState, usize> {
         let mut block_counts = HashMap::new();
         for block_index in &self.blocks {
-            let block_state = &self.palette[*block_index];
+            let block_state = &self.palette[block_index];
             *block_counts.entry(block_state.clone()).or_insert(0) += 1;
         }
         block_counts
@@ -1215,39 +2080,32 @@ impl Region {
     pub fn flip_x(&mut self) {
         use crate::transforms::{transform_block_state_flip, Axis};
 
-        // Phase 3: Reverse each X-row in-place
+        // Reverse each X-row in place, one Y slab per task.
         let w = self.cached_width as usize;
-        let l = self.cached_length as usize;
         let wl = self.cached_width_x_length as usize;
-        let (_, h, _) = self.bbox.get_dimensions();
-        let h = h as usize;
-        let mut new_blocks = self.blocks.clone();
-
-        for dy in 0..h {
-            for dz in 0..l {
-                let start = dy * wl + dz * w;
-                new_blocks[start..start + w].reverse();
-            }
-        }
+        self.blocks
+            .for_each_slab(wl, |_, slab| slab.reverse_rows(w));
 
         // Transform block state properties
         let mut new_palette = Vec::with_capacity(self.palette.len());
         for block_state in &self.palette {
             new_palette.push(transform_block_state_flip(block_state, Axis::X));
         }
+        // Mirroring moves cells across section edges unless the size is a
+        // multiple of the section edge.
+        self.reset_sections();
 
-        self.blocks = new_blocks;
+        // Transforms keep air as air, so the non-air count is unchanged.
         self.palette = new_palette;
         self.rebuild_palette_index();
         self.rebuild_air_index();
-        self.rebuild_non_air_count();
-        self.rebuild_tight_bounds();
 
-        // Transform block entities — pure position remap, no palette work.
+        // Transform tight bounds and block entities — pure position remaps.
         let max_x = self.bbox.max.0;
         let min_x = self.bbox.min.0;
-        self.block_entities
-            .remap_positions(|(x, y, z)| (max_x - (x - min_x), y, z));
+        let flip = move |(x, y, z): (i32, i32, i32)| (max_x - (x - min_x), y, z);
+        self.map_tight_bounds(flip);
+        self.block_entities.remap_positions(flip);
 
         // Transform entities
         for entity in &mut self.entities {
@@ -1260,40 +2118,35 @@ impl Region {
     pub fn flip_y(&mut self) {
         use crate::transforms::{transform_block_state_flip, Axis};
 
-        // Phase 3: Swap Y-layers using swap_nonoverlapping
+        // Phase 3: Swap Y-layers in place
         let wl = self.cached_width_x_length as usize;
         let (_, h, _) = self.bbox.get_dimensions();
         let h = h as usize;
-        let mut new_blocks = self.blocks.clone();
 
-        // Swap layer dy with layer (h-1-dy)
-        let ptr = new_blocks.as_mut_ptr();
+        // Swap layer dy with layer (h-1-dy); non-overlapping because
+        // dy < h/2 <= mirror_dy
         for dy in 0..h / 2 {
             let mirror_dy = h - 1 - dy;
-            let off_a = dy * wl;
-            let off_b = mirror_dy * wl;
-            // Safety: non-overlapping because dy < h/2 < mirror_dy
-            unsafe {
-                std::ptr::swap_nonoverlapping(ptr.add(off_a), ptr.add(off_b), wl);
-            }
+            self.blocks.swap_ranges(dy * wl, mirror_dy * wl, wl);
         }
 
         let mut new_palette = Vec::with_capacity(self.palette.len());
         for block_state in &self.palette {
             new_palette.push(transform_block_state_flip(block_state, Axis::Y));
         }
+        // Mirroring moves cells across section edges unless the size is a
+        // multiple of the section edge.
+        self.reset_sections();
 
-        self.blocks = new_blocks;
         self.palette = new_palette;
         self.rebuild_palette_index();
         self.rebuild_air_index();
-        self.rebuild_non_air_count();
-        self.rebuild_tight_bounds();
 
         let max_y = self.bbox.max.1;
         let min_y = self.bbox.min.1;
-        self.block_entities
-            .remap_positions(|(x, y, z)| (x, max_y - (y - min_y), z));
+        let flip = move |(x, y, z): (i32, i32, i32)| (x, max_y - (y - min_y), z);
+        self.map_tight_bounds(flip);
+        self.block_entities.remap_positions(flip);
 
         for entity in &mut self.entities {
             let rel_y = entity.position.1 - self.bbox.min.1 as f64;
@@ -1305,43 +2158,28 @@ impl Region {
     pub fn flip_z(&mut self) {
         use crate::transforms::{transform_block_state_flip, Axis};
 
-        // Phase 3: Swap Z-rows within each Y-layer
+        // Mirror the Z-rows of each Y-layer, one layer per task.
         let w = self.cached_width as usize;
-        let l = self.cached_length as usize;
         let wl = self.cached_width_x_length as usize;
-        let (_, h, _) = self.bbox.get_dimensions();
-        let h = h as usize;
-        let mut new_blocks = self.blocks.clone();
-
-        let ptr = new_blocks.as_mut_ptr();
-        for dy in 0..h {
-            let layer_off = dy * wl;
-            for dz in 0..l / 2 {
-                let mirror_dz = l - 1 - dz;
-                let off_a = layer_off + dz * w;
-                let off_b = layer_off + mirror_dz * w;
-                unsafe {
-                    std::ptr::swap_nonoverlapping(ptr.add(off_a), ptr.add(off_b), w);
-                }
-            }
-        }
+        self.blocks.for_each_slab(wl, |_, slab| slab.mirror_rows(w));
 
         let mut new_palette = Vec::with_capacity(self.palette.len());
         for block_state in &self.palette {
             new_palette.push(transform_block_state_flip(block_state, Axis::Z));
         }
+        // Mirroring moves cells across section edges unless the size is a
+        // multiple of the section edge.
+        self.reset_sections();
 
-        self.blocks = new_blocks;
         self.palette = new_palette;
         self.rebuild_palette_index();
         self.rebuild_air_index();
-        self.rebuild_non_air_count();
-        self.rebuild_tight_bounds();
 
         let max_z = self.bbox.max.2;
         let min_z = self.bbox.min.2;
-        self.block_entities
-            .remap_positions(|(x, y, z)| (x, y, max_z - (z - min_z)));
+        let flip = move |(x, y, z): (i32, i32, i32)| (x, y, max_z - (z - min_z));
+        self.map_tight_bounds(flip);
+        self.block_entities.remap_positions(flip);
 
         for entity in &mut self.entities {
             let rel_z = entity.position.2 - self.bbox.min.2 as f64;
@@ -1390,6 +2228,8 @@ impl Region {
             })
             .transpose()?;
 
+        // Sections are relative to the box minimum, so they move along.
+        let sections = std::mem::take(&mut self.sections);
         self.position = new_position;
         self.tight_bounds = new_tight_bounds;
         self.block_entities
@@ -1400,6 +2240,7 @@ impl Region {
             entity.position.2 += dz as f64;
         }
         self.rebuild_bbox();
+        self.sections = sections;
         Ok(())
     }
 
@@ -1434,26 +2275,25 @@ impl Region {
         let new_size = (old_size_z, size_y, old_size_x);
         let new_bbox = BoundingBox::try_from_position_and_size(position, new_size)?;
 
-        let new_volume = new_bbox.volume() as usize;
         let air_index = self.cached_air_index;
-        let mut new_blocks = vec![air_index; new_volume];
-
-        // Transform each block position
-        for index in 0..self.blocks.len() {
-            let (x, y, z) = old_bbox.index_to_coords(index);
-
-            let rel_x = x - old_bbox.min.0;
-            let rel_z = z - old_bbox.min.2;
-
-            let new_rel_x = old_size_z - 1 - rel_z;
-            let new_rel_z = rel_x;
-
-            let new_x = new_bbox.min.0 + new_rel_x;
-            let new_z = new_bbox.min.2 + new_rel_z;
-
-            let new_index = new_bbox.coords_to_index(new_x, y, new_z);
-            new_blocks[new_index] = self.blocks[index];
-        }
+        let mut new_blocks = self.blank_blocks(&new_bbox, air_index);
+        new_blocks.ensure_holds(self.palette.len().saturating_sub(1));
+
+        // New (x, y, z) reads old (z, y, size_z - 1 - x).
+        let (ow, ol) = (old_size_x as usize, old_size_z as usize);
+        let strides = (-(ow as isize), (ow * ol) as isize, 1);
+        self.permute_blocks_into(
+            &mut new_blocks,
+            &new_bbox,
+            (ol - 1) * ow,
+            strides,
+            |index| {
+                let (x, y, z) = old_bbox.index_to_coords(index);
+                let new_x = new_bbox.min.0 + old_size_z - 1 - (z - old_bbox.min.2);
+                let new_z = new_bbox.min.2 + (x - old_bbox.min.0);
+                new_bbox.coords_to_index(new_x, y, new_z)
+            },
+        );
 
         let mut new_palette = Vec::with_capacity(self.palette.len());
         for block_state in &self.palette {
@@ -1469,8 +2309,6 @@ impl Region {
         self.rebuild_bbox();
         self.rebuild_palette_index();
         self.rebuild_air_index();
-        self.rebuild_non_air_count();
-        self.rebuild_tight_bounds();
 
         // Transform block entities — pure position remap.
         let old_min_x = old_bbox.min.0;
@@ -1478,13 +2316,15 @@ impl Region {
         let new_min_x = new_bbox_clone.min.0;
         let new_min_z = new_bbox_clone.min.2;
         let osize_z = old_size_z;
-        self.block_entities.remap_positions(move |(x, y, z)| {
+        let rotate = move |(x, y, z): (i32, i32, i32)| {
             let rel_x = x - old_min_x;
             let rel_z = z - old_min_z;
             let new_rel_x = osize_z - 1 - rel_z;
             let new_rel_z = rel_x;
             (new_min_x + new_rel_x, y, new_min_z + new_rel_z)
-        });
+        };
+        self.map_tight_bounds(rotate);
+        self.block_entities.remap_positions(rotate);
 
         // Transform entities
         for entity in &mut self.entities {
@@ -1525,25 +2365,25 @@ impl Region {
         let new_size = (size_x, old_size_z, old_size_y);
         let new_bbox = BoundingBox::try_from_position_and_size(position, new_size)?;
 
-        let new_volume = new_bbox.volume() as usize;
         let air_index = self.cached_air_index;
-        let mut new_blocks = vec![air_index; new_volume];
-
-        for index in 0..self.blocks.len() {
-            let (x, y, z) = old_bbox.index_to_coords(index);
-
-            let rel_y = y - old_bbox.min.1;
-            let rel_z = z - old_bbox.min.2;
-
-            let new_rel_y = old_size_z - 1 - rel_z;
-            let new_rel_z = rel_y;
-
-            let new_y = new_bbox.min.1 + new_rel_y;
-            let new_z = new_bbox.min.2 + new_rel_z;
-
-            let new_index = new_bbox.coords_to_index(x, new_y, new_z);
-            new_blocks[new_index] = self.blocks[index];
-        }
+        let mut new_blocks = self.blank_blocks(&new_bbox, air_index);
+        new_blocks.ensure_holds(self.palette.len().saturating_sub(1));
+
+        // New (x, y, z) reads old (x, z, size_z - 1 - y).
+        let (ow, ol) = (size_x as usize, old_size_z as usize);
+        let strides = (1, -(ow as isize), (ow * ol) as isize);
+        self.permute_blocks_into(
+            &mut new_blocks,
+            &new_bbox,
+            (ol - 1) * ow,
+            strides,
+            |index| {
+                let (x, y, z) = old_bbox.index_to_coords(index);
+                let new_y = new_bbox.min.1 + old_size_z - 1 - (z - old_bbox.min.2);
+                let new_z = new_bbox.min.2 + (y - old_bbox.min.1);
+                new_bbox.coords_to_index(x, new_y, new_z)
+            },
+        );
 
         let mut new_palette = Vec::with_capacity(self.palette.len());
         for block_state in &self.palette {
@@ -1559,21 +2399,21 @@ impl Region {
         self.rebuild_bbox();
         self.rebuild_palette_index();
         self.rebuild_air_index();
-        self.rebuild_non_air_count();
-        self.rebuild_tight_bounds();
 
         let old_min_y = old_bbox.min.1;
         let old_min_z = old_bbox.min.2;
         let new_min_y = new_bbox_clone.min.1;
         let new_min_z = new_bbox_clone.min.2;
         let osize_z = old_size_z;
-        self.block_entities.remap_positions(move |(x, y, z)| {
+        let rotate = move |(x, y, z): (i32, i32, i32)| {
             let rel_y = y - old_min_y;
             let rel_z = z - old_min_z;
             let new_rel_y = osize_z - 1 - rel_z;
             let new_rel_z = rel_y;
             (x, new_min_y + new_rel_y, new_min_z + new_rel_z)
-        });
+        };
+        self.map_tight_bounds(rotate);
+        self.block_entities.remap_positions(rotate);
 
         for entity in &mut self.entities {
             let rel_y = entity.position.1 - old_bbox.min.1 as f64;
@@ -1613,25 +2453,26 @@ impl Region {
         let new_size = (old_size_y, old_size_x, size_z);
         let new_bbox = BoundingBox::try_from_position_and_size(position, new_size)?;
 
-        let new_volume = new_bbox.volume() as usize;
         let air_index = self.cached_air_index;
-        let mut new_blocks = vec![air_index; new_volume];
-
-        for index in 0..self.blocks.len() {
-            let (x, y, z) = old_bbox.index_to_coords(index);
-
-            let rel_x = x - old_bbox.min.0;
-            let rel_y = y - old_bbox.min.1;
-
-            let new_rel_x = old_size_y - 1 - rel_y;
-            let new_rel_y = rel_x;
-
-            let new_x = new_bbox.min.0 + new_rel_x;
-            let new_y = new_bbox.min.1 + new_rel_y;
-
-            let new_index = new_bbox.coords_to_index(new_x, new_y, z);
-            new_blocks[new_index] = self.blocks[index];
-        }
+        let mut new_blocks = self.blank_blocks(&new_bbox, air_index);
+        new_blocks.ensure_holds(self.palette.len().saturating_sub(1));
+
+        // New (x, y, z) reads old (y, size_y - 1 - x, z).
+        let (ow, ol) = (old_size_x as usize, size_z as usize);
+        let wl = (ow * ol) as isize;
+        let origin = (old_size_y as usize - 1) * ow * ol;
+        self.permute_blocks_into(
+            &mut new_blocks,
+            &new_bbox,
+            origin,
+            (-wl, 1, ow as isize),
+            |index| {
+                let (x, y, z) = old_bbox.index_to_coords(index);
+                let new_x = new_bbox.min.0 + old_size_y - 1 - (y - old_bbox.min.1);
+                let new_y = new_bbox.min.1 + (x - old_bbox.min.0);
+                new_bbox.coords_to_index(new_x, new_y, z)
+            },
+        );
 
         let mut new_palette = Vec::with_capacity(self.palette.len());
         for block_state in &self.palette {
@@ -1647,21 +2488,21 @@ impl Region {
         self.rebuild_bbox();
         self.rebuild_palette_index();
         self.rebuild_air_index();
-        self.rebuild_non_air_count();
-        self.rebuild_tight_bounds();
 
         let old_min_x = old_bbox.min.0;
         let old_min_y = old_bbox.min.1;
         let new_min_x = new_bbox_clone.min.0;
         let new_min_y = new_bbox_clone.min.1;
         let osize_y = old_size_y;
-        self.block_entities.remap_positions(move |(x, y, z)| {
+        let rotate = move |(x, y, z): (i32, i32, i32)| {
             let rel_x = x - old_min_x;
             let rel_y = y - old_min_y;
             let new_rel_x = osize_y - 1 - rel_y;
             let new_rel_y = rel_x;
             (new_min_x + new_rel_x, new_min_y + new_rel_y, z)
-        });
+        };
+        self.map_tight_bounds(rotate);
+        self.block_entities.remap_positions(rotate);
 
         for entity in &mut self.entities {
             let rel_x = entity.position.0 - old_bbox.min.0 as f64;
@@ -1691,6 +2532,7 @@ impl Region {
         let index = self.palette.len();
         let block = BlockState::new(name.to_string());
         self.palette_index.insert(block.clone(), index);
+        self.palette_ids.push(StateId::of(&block));
         self.palette.push(block);
         index
     }
@@ -1705,6 +2547,7 @@ impl Region {
         }
         let index = self.palette.len();
         self.palette_index.insert(state.clone(), index);
+        self.palette_ids.push(StateId::of(state));
         self.palette.push(state.clone());
         index
     }
@@ -1714,15 +2557,17 @@ impl Region {
     #[inline(always)]
     pub fn set_block_at_index_unchecked(&mut self, palette_index: usize, x: i32, y: i32, z: i32) {
         let index = self.coords_to_index(x, y, z);
-        let old_palette_index = self.blocks[index];
-        self.blocks[index] = palette_index;
+        let old_palette_index = self.blocks.replace(index, palette_index);
+        self.mark_dirty(x, y, z);
 
         let old_is_air = old_palette_index == self.cached_air_index;
         let new_is_air = palette_index == self.cached_air_index;
         if old_is_air && !new_is_air {
             self.non_air_count += 1;
+            self.bump_section(x, y, z, 1);
         } else if !old_is_air && new_is_air {
             self.non_air_count -= 1;
+            self.bump_section(x, y, z, -1);
         }
 
         if !new_is_air {
@@ -1738,7 +2583,7 @@ impl Region {
             return None;
         }
         let index = self.coords_to_index(x, y, z);
-        let block_index = self.blocks[index];
+        let block_index = self.blocks.at(index);
         self.palette.get(block_index).map(|bs| bs.name.as_str())
     }
 
@@ -1764,51 +2609,44 @@ impl Region {
 
         let mut air_delta: i64 = 0;
 
-        for y in min.1..=max.1 {
-            let dy = (y - base_y) as i64;
-            for z in min.2..=max.2 {
-                let dz = (z - base_z) as i64;
-                let row_start = (dx_min + dz * w + dy * wl) as usize;
-                let row_end = row_start + row_len;
-                let row = &mut self.blocks[row_start..row_end];
-
-                // Count air blocks being replaced/created for delta tracking
-                // Phase 2: Manual SIMD-style chunking (8 elements at a time)
-                let mut chunks = row.chunks_exact(8);
-                for chunk in &mut chunks {
-                    let mut is_air_count = 0;
-                    is_air_count += (chunk[0] == self.cached_air_index) as i64;
-                    is_air_count += (chunk[1] == self.cached_air_index) as i64;
-                    is_air_count += (chunk[2] == self.cached_air_index) as i64;
-                    is_air_count += (chunk[3] == self.cached_air_index) as i64;
-                    is_air_count += (chunk[4] == self.cached_air_index) as i64;
-                    is_air_count += (chunk[5] == self.cached_air_index) as i64;
-                    is_air_count += (chunk[6] == self.cached_air_index) as i64;
-                    is_air_count += (chunk[7] == self.cached_air_index) as i64;
-
+        // Sparse storage collapses fully covered sections to one value.
+        let air = self.cached_air_index;
+        if let Some(replaced_air) = self.blocks.fill_box(min, max, palette_index, air) {
+            let volume = Self::box_volume(min, max).unwrap_or(0) as i64;
+            air_delta = if new_is_air {
+                -(volume - replaced_air as i64)
+            } else {
+                replaced_air as i64
+            };
+        } else {
+            for y in min.1..=max.1 {
+                let dy = (y - base_y) as i64;
+                for z in min.2..=max.2 {
+                    let dz = (z - base_z) as i64;
+                    let row_start = (dx_min + dz * w + dy * wl) as usize;
+                    let row = row_start..row_start + row_len;
+
+                    // Count air blocks being replaced/created for delta tracking;
+                    // the count runs over the narrow cells and vectorizes.
+                    let is_air_count = self
+                        .blocks
+                        .count_in_range(row.clone(), self.cached_air_index)
+                        as i64;
                     if !new_is_air {
                         air_delta += is_air_count;
                     } else {
-                        air_delta -= 8 - is_air_count;
+                        air_delta -= row_len as i64 - is_air_count;
                     }
-                }
 
-                // Handle remainder
-                for &old in chunks.remainder() {
-                    let old_is_air = old == self.cached_air_index;
-                    if old_is_air && !new_is_air {
-                        air_delta += 1;
-                    } else if !old_is_air && new_is_air {
-                        air_delta -= 1;
-                    }
+                    self.blocks.fill_range(row, palette_index);
                 }
-
-                row.fill(palette_index);
             }
         }
 
         // Batch update non_air_count
         self.non_air_count = (self.non_air_count as i64 + air_delta) as usize;
+        self.recount_sections(min, max);
+        self.mark_dirty_box(min, max);
 
         // Update tight bounds once for the entire fill
         if !new_is_air {
@@ -1816,6 +2654,210 @@ impl Region {
             self.update_tight_bounds(max.0, max.1, max.2);
         }
     }
+
+    /// Number of cells in the inclusive box `min..=max`, or an error if the box
+    /// is inverted or its volume does not fit in memory.
+    pub(crate) fn box_volume(min: (i32, i32, i32), max: (i32, i32, i32)) -> Result<usize, String> {
+        if min.0 > max.0 || min.1 > max.1 || min.2 > max.2 {
+            return Err(format!("inverted box {min:?}..={max:?}"));
+        }
+        let extent = |lo: i32, hi: i32| (i64::from(hi) - i64::from(lo) + 1) as u64;
+        extent(min.0, max.0)
+            .checked_mul(extent(min.1, max.1))
+            .and_then(|v| v.checked_mul(extent(min.2, max.2)))
+            .and_then(|v| usize::try_from(v).ok())
+            .ok_or_else(|| "box volume exceeds addressable memory".to_string())
+    }
+
+    /// Copy the palette indices of the inclusive box `min..=max` into `out`, in
+    /// the region's storage order (x fastest, then z, then y). Cells outside the
+    /// allocated bounds read as the air index. `out.len()` must equal the box
+    /// volume; indices refer to [`Region::get_palette`].
+    pub fn read_palette_indices(
+        &self,
+        min: (i32, i32, i32),
+        max: (i32, i32, i32),
+        out: &mut [u32],
+    ) -> Result<(), String> {
+        let volume = Self::box_volume(min, max)?;
+        if out.len() != volume {
+            return Err(format!(
+                "output holds {} indices, box needs {volume}",
+                out.len()
+            ));
+        }
+        let air = self.cached_air_index as u32;
+        let row_len = (max.0 - min.0 + 1) as usize;
+        // X overlap of the box with the allocated bounds, as offsets into a row.
+        let x_lo = min.0.max(self.bbox.min.0);
+        let x_hi = max.0.min(self.bbox.max.0);
+        let mut rows = out.chunks_exact_mut(row_len);
+        for y in min.1..=max.1 {
+            for z in min.2..=max.2 {
+                let row = rows.next().expect("row count matches box volume");
+                if x_lo > x_hi || !self.is_in_region(x_lo, y, z) {
+                    row.fill(air);
+                    continue;
+                }
+                let lead = (x_lo - min.0) as usize;
+                let span = (x_hi - x_lo + 1) as usize;
+                row[..lead].fill(air);
+                row[lead + span..].fill(air);
+                let start = self.coords_to_index(x_lo, y, z);
+                self.blocks
+                    .read_into_u32(start, &mut row[lead..lead + span]);
+            }
+        }
+        Ok(())
+    }
+
+    /// Overwrite the inclusive box `min..=max` with palette indices laid out
+    /// like [`Region::read_palette_indices`]. The region grows once to cover the
+    /// box; every index is validated against the palette before anything is
+    /// written, so a bad index leaves the region untouched.
+    pub fn write_palette_indices(
+        &mut self,
+        min: (i32, i32, i32),
+        max: (i32, i32, i32),
+        indices: &[u32],
+    ) -> Result<(), String> {
+        let volume = Self::box_volume(min, max)?;
+        if indices.len() != volume {
+            return Err(format!("got {} indices, box needs {volume}", indices.len()));
+        }
+        let palette_len = self.palette.len();
+        if let Some(bad) = indices.iter().find(|&&i| i as usize >= palette_len) {
+            return Err(format!(
+                "palette index {bad} out of range (palette has {palette_len} entries)"
+            ));
+        }
+        if volume == 0 {
+            return Ok(());
+        }
+        self.ensure_bounds(min, max);
+        self.blocks.ensure_holds(palette_len - 1);
+
+        let air = self.cached_air_index;
+        let row_len = (max.0 - min.0 + 1) as usize;
+        let mut air_delta: i64 = 0;
+        let mut rows = indices.chunks_exact(row_len);
+        for y in min.1..=max.1 {
+            for z in min.2..=max.2 {
+                let row = rows.next().expect("row count matches box volume");
+                let start = self.coords_to_index(min.0, y, z);
+                let mut first_solid = None;
+                let mut last_solid = 0;
+                for (dx, &src) in row.iter().enumerate() {
+                    let new = src as usize;
+                    let old = self.blocks.replace(start + dx, new);
+                    air_delta += (old == air) as i64 - (new == air) as i64;
+                    if new != air {
+                        if first_solid.is_none() {
+                            first_solid = Some(dx);
+                        }
+                        last_solid = dx;
+                    }
+                }
+                if let Some(first) = first_solid {
+                    self.update_tight_bounds(min.0 + first as i32, y, z);
+                    self.update_tight_bounds(min.0 + last_solid as i32, y, z);
+                }
+            }
+        }
+        self.non_air_count = (self.non_air_count as i64 + air_delta) as usize;
+        self.recount_sections(min, max);
+        self.mark_dirty_box(min, max);
+        Ok(())
+    }
+}
+
+/// Coordinates of a box's cells in storage order, stepped one axis at a
+/// time.
+struct CellCoords {
+    min: (i32, i32, i32),
+    max: (i32, i32, i32),
+    next: Option<(i32, i32, i32)>,
+}
+
+impl CellCoords {
+    fn new(bounds: &BoundingBox) -> Self {
+        CellCoords {
+            min: bounds.min,
+            max: bounds.max,
+            next: Some(bounds.min),
+        }
+    }
+}
+
+impl Iterator for CellCoords {
+    type Item = (i32, i32, i32);
+
+    #[inline]
+    fn next(&mut self) -> Option<Self::Item> {
+        let current = self.next?;
+        let (x, y, z) = current;
+        self.next = if x < self.max.0 {
+            Some((x + 1, y, z))
+        } else if z < self.max.2 {
+            Some((self.min.0, y, z + 1))
+        } else if y < self.max.1 {
+            Some((self.min.0, y + 1, self.min.2))
+        } else {
+            None
+        };
+        Some(current)
+    }
+}
+
+/// Cells of a box whose palette index differs from a given value, as
+/// `((x, y, z), palette_index)` in storage order. Made by
+/// [`Region::cells_ne`]. Each row is searched with
+/// [`BlockStorage::find_ne`], so a run of the skipped value costs a compare
+/// per cell and nothing else.
+pub struct CellsNe<'a> {
+    blocks: &'a BlockStorage,
+    value: usize,
+    bounds: BoundingBox,
+    row_len: usize,
+    row_stride: usize,
+    layer_stride: usize,
+    y: i32,
+    z: i32,
+    /// Storage index of `(bounds.min.0, y, bounds.min.2)`.
+    layer_start: usize,
+    /// Storage index of `(bounds.min.0, y, z)`.
+    row_start: usize,
+    cursor: usize,
+    row_end: usize,
+}
+
+impl Iterator for CellsNe<'_> {
+    type Item = ((i32, i32, i32), usize);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        loop {
+            if let Some((index, value)) = self.blocks.find_ne(self.cursor..self.row_end, self.value)
+            {
+                self.cursor = index + 1;
+                let x = self.bounds.min.0 + (index - self.row_start) as i32;
+                return Some(((x, self.y, self.z), value));
+            }
+            if self.z < self.bounds.max.2 {
+                self.z += 1;
+                self.row_start += self.row_stride;
+            } else if self.y < self.bounds.max.1 {
+                self.y += 1;
+                self.z = self.bounds.min.2;
+                self.layer_start += self.layer_stride;
+                self.row_start = self.layer_start;
+            } else {
+                self.cursor = self.row_end;
+                return None;
+            }
+            self.cursor = self.row_start;
+            self.row_end = self.row_start + self.row_len;
+        }
+    }
 }
 
 #[cfg(test)]
@@ -1893,11 +2935,12 @@ mod tests {
             name: "Test".to_string(),
             position: (0, 0, 0),
             size: (16, 1, 1),
-            blocks: blocks.clone(),
+            blocks: BlockStorage::from(blocks.clone()),
             palette,
-            entities: Vec::new(),
+            entities: EntityStore::new(),
             block_entities: BlockEntityStore::default(),
             palette_index: FxHashMap::default(),
+            palette_ids: Vec::new(),
             bbox: BoundingBox::from_position_and_size((0, 0, 0), (16, 1, 1)),
             tight_bounds: None,
             cached_width: 16,
@@ -1905,6 +2948,8 @@ mod tests {
             cached_width_x_length: 16,
             cached_air_index: 0,
             non_air_count: 16,
+            sections: OnceLock::new(),
+            dirty: None,
         };
         let packed_states = region.create_packed_block_states();
         assert_eq!(packed_states.len(), 2);
@@ -1936,11 +2981,12 @@ mod tests {
             name: "huge".to_string(),
             position: (-47472, -64, -5216),
             size: (82448, 384, 18944),
-            blocks: Vec::new(), // we never actually index into this
+            blocks: BlockStorage::new(), // we never actually index into this
             palette: vec![BlockState::new("minecraft:air".to_string())],
-            entities: Vec::new(),
+            entities: EntityStore::new(),
             block_entities: BlockEntityStore::default(),
             palette_index: FxHashMap::default(),
+            palette_ids: Vec::new(),
             bbox: BoundingBox::new((-47472, -64, -5216), (34975, 319, 13727)),
             tight_bounds: None,
             cached_width: width,
@@ -1948,6 +2994,8 @@ mod tests {
             cached_width_x_length: wl,
             cached_air_index: 0,
             non_air_count: 0,
+            sections: OnceLock::new(),
+            dirty: None,
         };
 
         // The problematic point: dy=300 makes `dy * wl ≈ 4.7e11` — well past
@@ -1977,6 +3025,189 @@ mod tests {
         assert_eq!(region.palette[0].name, "minecraft:air");
     }
 
+    #[test]
+    fn test_block_storage_widens_past_256_states() {
+        let mut region = Region::new("Test".to_string(), (0, 0, 0), (20, 1, 20));
+        assert_eq!(region.blocks.width_bytes(), 1);
+        let state = |i: i32| BlockState::new(format!("minecraft:b{}", i));
+        for i in 0..300 {
+            region.set_block(i % 20, 0, i / 20, &state(i));
+        }
+        assert_eq!(region.blocks.width_bytes(), 2);
+        for i in 0..300 {
+            assert_eq!(region.get_block(i % 20, 0, i / 20), Some(&state(i)));
+        }
+        assert_eq!(region.count_blocks(), 300);
+        // Compaction keeps the wider cells intact.
+        let compact = region.to_compact();
+        assert_eq!(compact.get_block(19, 0, 14), Some(&state(299)));
+    }
+
+    #[test]
+    fn test_palette_ids_track_palette_through_merge() {
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        let mut a = Region::new("A".to_string(), (0, 0, 0), (2, 1, 1));
+        a.set_block(0, 0, 0, &stone);
+        let mut b = Region::new("B".to_string(), (2, 0, 0), (2, 1, 1));
+        b.set_block(2, 0, 0, &glass);
+        b.set_block(3, 0, 0, &stone);
+
+        a.merge(&b);
+        assert_eq!(a.get_palette().len(), 3);
+        assert_eq!(
+            a.palette_ids().as_ref(),
+            StateId::of_all(&a.palette).as_slice()
+        );
+        assert_eq!(a.palette_ids()[1], b.palette_ids()[2]);
+        assert_eq!(a.get_block(3, 0, 0), Some(&stone));
+        assert_eq!(a.get_block(2, 0, 0), Some(&glass));
+    }
+
+    #[test]
+    fn test_sparse_region_matches_dense_for_far_apart_builds() {
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        let mut sparse = Region::new_sparse("Test".to_string(), (0, 0, 0), (1, 1, 1));
+        let mut dense = Region::new("Test".to_string(), (0, 0, 0), (1, 1, 1));
+        for region in [&mut sparse, &mut dense] {
+            region.set_block(0, 0, 0, &stone);
+            region.set_block(-90, 40, 120, &glass);
+            region.fill_uniform((0, 16, 0), (31, 31, 15), 1);
+        }
+        assert!(sparse.is_sparse());
+        // The first block, the glass, and the two sections the fill covers
+        // (stored as one value each).
+        assert_eq!(sparse.blocks.section_count(), 4);
+        assert!(sparse.blocks.heap_bytes() < 64 * 1024);
+        assert_eq!(sparse.count_non_air_blocks(), dense.count_non_air_blocks());
+        assert_eq!(sparse.get_tight_bounds(), dense.get_tight_bounds());
+        assert_eq!(sparse.get_block(-90, 40, 120), Some(&glass));
+        assert_eq!(sparse.get_block(5, 20, 5), Some(&stone));
+
+        let mut other = Region::new("Other".to_string(), (200, 0, 0), (2, 2, 2));
+        other.set_block(201, 1, 1, &glass);
+        sparse.merge(&other);
+        dense.merge(&other);
+        sparse.rotate_y(90);
+        dense.rotate_y(90);
+        assert_eq!(sparse.get_bounding_box(), dense.get_bounding_box());
+        assert_eq!(sparse.blocks, dense.blocks);
+        assert_eq!(sparse.count_non_air_blocks(), dense.count_non_air_blocks());
+
+        let compact = sparse.to_compact();
+        assert!(!compact.is_sparse());
+        assert_eq!(compact.blocks, dense.to_compact().blocks);
+    }
+
+    #[test]
+    fn test_merge_layers_matches_sequential_precedence_merges() {
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        let air = BlockState::new("minecraft:air".to_string());
+        let mut low = Region::new("Low".to_string(), (0, 0, 0), (4, 4, 4));
+        low.set_block(0, 0, 0, &stone);
+        low.set_block(3, 3, 3, &stone);
+        let mut mid = Region::new("Mid".to_string(), (2, 2, 2), (6, 2, 2));
+        mid.set_block(2, 2, 2, &glass);
+        mid.set_block(4, 3, 3, &air);
+        mid.set_block(7, 3, 3, &glass);
+        let mut high = Region::new("High".to_string(), (-3, 1, 0), (1, 1, 1));
+        high.set_block(-3, 1, 0, &stone);
+
+        let mut sequential = low.clone();
+        sequential.merge_with_precedence(&mid);
+        sequential.merge_with_precedence(&high);
+        let layered = Region::merge_layers("Low".to_string(), &[&low, &mid, &high]);
+
+        assert_eq!(layered.get_bounding_box(), sequential.get_bounding_box());
+        assert_eq!(layered.get_tight_bounds(), sequential.get_tight_bounds());
+        assert_eq!(
+            layered.count_non_air_blocks(),
+            sequential.count_non_air_blocks()
+        );
+        let bbox = layered.get_bounding_box();
+        for y in bbox.min.1..=bbox.max.1 {
+            for z in bbox.min.2..=bbox.max.2 {
+                for x in bbox.min.0..=bbox.max.0 {
+                    assert_eq!(layered.get_block(x, y, z), sequential.get_block(x, y, z));
+                }
+            }
+        }
+        // Mid's air inside its content bounds masks low's stone.
+        assert_eq!(layered.get_block(3, 3, 3), Some(&air));
+    }
+
+    #[test]
+    fn test_section_counts_follow_writes() {
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let air = BlockState::new("minecraft:air".to_string());
+        let mut region = Region::new("Test".to_string(), (-8, 0, 0), (40, 20, 33));
+        assert_eq!(region.occupied_sections().count(), 0);
+        assert!(!region.may_have_blocks_in((-8, 0, 0), (31, 19, 32)));
+
+        region.set_block(-8, 0, 0, &stone);
+        region.set_block(30, 19, 32, &stone);
+        region.fill_uniform((0, 2, 0), (20, 3, 4), 1);
+        region.set_block(-8, 0, 0, &air);
+        region
+            .write_palette_indices((9, 18, 20), (9, 18, 20), &[1])
+            .unwrap();
+        region.translate(5, 0, 0).unwrap();
+
+        let occupied: Vec<_> = region.occupied_sections().collect();
+        let fresh = region.count_sections();
+        let counted = region.section_counts();
+        assert_eq!(counted.counts, fresh.counts);
+        assert_eq!(
+            counted.counts.iter().map(|&c| c as usize).sum::<usize>(),
+            region.count_non_air_blocks()
+        );
+        // Region min x is -3: sections start at -3, 13 and 29.
+        assert!(occupied.contains(&BoundingBox::new((29, 16, 32), (36, 19, 32))));
+        assert!(!region.may_have_blocks_in((13, 16, 0), (28, 19, 15)));
+        assert!(region.may_have_blocks_in((14, 18, 20), (14, 18, 20)));
+    }
+
+    #[test]
+    fn test_changed_sections_follow_writes() {
+        let mut region = Region::new("Test".to_string(), (0, 0, 0), (40, 20, 40));
+        let stone = BlockState::new("minecraft:stone".to_string());
+        assert_eq!(region.take_changed_sections(), None);
+        assert_eq!(region.take_changed_sections(), Some(Vec::new()));
+
+        region.set_block(35, 0, 1, &stone);
+        region.fill_uniform((1, 1, 1), (17, 2, 2), 0);
+        region.set_block(35, 0, 2, &stone);
+        assert_eq!(
+            region.take_changed_sections(),
+            Some(vec![
+                BoundingBox::new((32, 0, 0), (39, 15, 15)),
+                BoundingBox::new((0, 0, 0), (15, 15, 15)),
+                BoundingBox::new((16, 0, 0), (31, 15, 15)),
+            ])
+        );
+
+        region.set_block(35, 0, 1, &stone);
+        region.fill_uniform((1, 1, 1), (17, 2, 2), 0);
+        region.set_block(35, 3, 2, &stone);
+        assert_eq!(
+            region.take_changed_cells(),
+            Some(vec![
+                BoundingBox::new((35, 0, 1), (35, 3, 2)),
+                BoundingBox::new((1, 1, 1), (15, 2, 2)),
+                BoundingBox::new((16, 1, 1), (17, 2, 2)),
+            ])
+        );
+
+        // Growing moves the section grid, so everything counts as changed.
+        region.set_block(-1, 0, 0, &stone);
+        assert_eq!(region.take_changed_sections(), None);
+        region.flip_x();
+        assert_eq!(region.take_changed_sections(), None);
+        assert_eq!(region.take_changed_sections(), Some(Vec::new()));
+    }
+
     #[test]
     fn test_set_and_get_block() {
         let mut region = Region::new("Test".to_string(), (0, 0, 0), (2, 2, 2));
@@ -2232,6 +3463,29 @@ mod tests {
         assert_eq!(region.get_block(10, 10, 10), Some(&stone));
     }
 
+    #[test]
+    fn test_expand_to_fit_grows_geometrically_along_a_sweep() {
+        let mut region = Region::new("Test".to_string(), (0, 0, 0), (1, 1, 1));
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let mut relayouts = 0;
+        for x in 0..20_000 {
+            let before = region.get_bounding_box();
+            region.set_block(x, 0, 0, &stone);
+            if region.get_bounding_box() != before {
+                relayouts += 1;
+            }
+        }
+        // Doubling from 1: a handful of re-layouts, not one per 64 blocks.
+        assert!(relayouts <= 12, "{relayouts} re-layouts");
+        assert_eq!(region.get_dimensions().1, 1);
+        assert!(region.get_dimensions().0 < 2 * 20_000 + MIN_GROWTH);
+
+        // Saving trims the slack back to the content.
+        let compact = region.to_compact();
+        assert_eq!(compact.get_dimensions(), (20_000, 1, 1));
+        assert_eq!(compact.count_non_air_blocks(), 20_000);
+    }
+
     #[test]
     fn test_expand_to_fit_corner_to_corner() {
         let mut region = Region::new("Test".to_string(), (0, 0, 0), (2, 2, 2));
@@ -2775,6 +4029,42 @@ mod tests {
         assert_eq!(region.get_block(-10, -10, -10), Some(&stone));
     }
 
+    #[test]
+    fn test_transforms_match_sparse_and_keep_tight_bounds() {
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let dirt = BlockState::new("minecraft:dirt".to_string());
+        for axis in 0..3 {
+            // Tall enough that a gather spans more than one 32-cell tile.
+            let mut dense = Region::new("Test".to_string(), (3, -2, 5), (37, 6, 41));
+            for i in 0..200 {
+                let (x, y, z) = (3 + i * 7 % 37, -2 + i % 6, 5 + i * 13 % 41);
+                let block = if i % 3 == 0 { &dirt } else { &stone };
+                dense.set_block(x, y, z, block);
+            }
+            let mut sparse = dense.clone();
+            sparse.make_sparse();
+            for region in [&mut dense, &mut sparse] {
+                match axis {
+                    0 => region.rotate_x(90),
+                    1 => region.rotate_y(270),
+                    _ => region.rotate_z(180),
+                }
+                region.flip_x();
+                region.flip_z();
+            }
+            assert_eq!(dense.get_bounding_box(), sparse.get_bounding_box());
+            assert_eq!(dense.blocks, sparse.blocks);
+
+            let tight = dense.get_tight_bounds();
+            let count = dense.count_non_air_blocks();
+            dense.rebuild_tight_bounds();
+            dense.rebuild_non_air_count();
+            assert_eq!(dense.get_tight_bounds(), tight);
+            assert_eq!(dense.count_non_air_blocks(), count);
+            assert_eq!(sparse.get_tight_bounds(), tight);
+        }
+    }
+
     // ══════════════════════════════════════════════════════════════════
     // Phase 3: Flip correctness — double flip must restore original
     // ══════════════════════════════════════════════════════════════════
@@ -3107,6 +4397,48 @@ mod tests {
         assert_eq!(deserialized.get_block(2, 2, 2), Some(&stone));
     }
 
+    #[test]
+    fn test_palette_index_box_roundtrip() {
+        let mut region = Region::new("Test".to_string(), (0, 0, 0), (2, 2, 2));
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let dirt = BlockState::new("minecraft:dirt".to_string());
+        let stone_idx = region.get_or_insert_in_palette(&stone) as u32;
+        let dirt_idx = region.get_or_insert_in_palette(&dirt) as u32;
+
+        // 3x1x2 box reaching past the allocated bounds on +X and +Z.
+        let indices = [stone_idx, 0, dirt_idx, 0, dirt_idx, stone_idx];
+        region
+            .write_palette_indices((0, 1, 0), (2, 1, 1), &indices)
+            .unwrap();
+        assert_eq!(region.get_block(0, 1, 0), Some(&stone));
+        assert_eq!(region.get_block(2, 1, 0), Some(&dirt));
+        assert_eq!(region.get_block(2, 1, 1), Some(&stone));
+        assert_eq!(region.count_blocks(), 4);
+        assert_eq!(region.get_tight_bounds().unwrap().max, (2, 1, 1));
+
+        let mut out = vec![u32::MAX; 6];
+        region
+            .read_palette_indices((0, 1, 0), (2, 1, 1), &mut out)
+            .unwrap();
+        assert_eq!(out, indices);
+
+        // A box wholly outside the allocation reads as air.
+        let mut outside = vec![u32::MAX; 2];
+        region
+            .read_palette_indices((-5, -5, -5), (-4, -5, -5), &mut outside)
+            .unwrap();
+        assert_eq!(outside, vec![0, 0]);
+
+        // Wrong length or bad palette index is rejected without mutation.
+        assert!(region
+            .write_palette_indices((0, 0, 0), (0, 0, 0), &[99])
+            .is_err());
+        assert!(region
+            .read_palette_indices((0, 0, 0), (1, 0, 0), &mut [0u32; 3])
+            .is_err());
+        assert_eq!(region.count_blocks(), 4);
+    }
+
     #[test]
     fn test_full_solid_fill_then_clear() {
         let mut region = Region::new("Test".to_string(), (0, 0, 0), (4, 4, 4));
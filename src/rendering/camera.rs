@@ -105,6 +105,82 @@ pub fn project_point(
     Some((px, py))
 }
 
+/// Restrict `view_proj` to one tile of the image it frames: the pixel
+/// rectangle `x0..x0 + tile_width`, `y0..y0 + tile_height` of a
+/// `full_width × full_height` image (origin top-left) fills the whole
+/// viewport. Rendering every tile at tile size reproduces the full image.
+pub fn tile_view_proj(
+    view_proj: [[f32; 4]; 4],
+    full_width: u32,
+    full_height: u32,
+    x0: u32,
+    y0: u32,
+    tile_width: u32,
+    tile_height: u32,
+) -> [[f32; 4]; 4] {
+    let (fw, fh) = (full_width as f32, full_height as f32);
+    let (tw, th) = (tile_width as f32, tile_height as f32);
+    // The tile's NDC bounds in the full image; NDC y points up.
+    let (left, right) = (
+        2.0 * x0 as f32 / fw - 1.0,
+        2.0 * (x0 as f32 + tw) / fw - 1.0,
+    );
+    let (bottom, top) = (
+        1.0 - 2.0 * (y0 as f32 + th) / fh,
+        1.0 - 2.0 * y0 as f32 / fh,
+    );
+    let crop = [
+        [2.0 / (right - left), 0.0, 0.0, 0.0],
+        [0.0, 2.0 / (top - bottom), 0.0, 0.0],
+        [0.0, 0.0, 1.0, 0.0],
+        [
+            -(right + left) / (right - left),
+            -(top + bottom) / (top - bottom),
+            0.0,
+            1.0,
+        ],
+    ];
+    mat4_mul(crop, view_proj)
+}
+
+/// The six clip planes of a view-projection matrix, as `[a, b, c, d]` with
+/// `a·x + b·y + c·z + d >= 0` on the inside. Depth is wgpu's `0..=1` range.
+pub fn frustum_planes(view_proj: &[[f32; 4]; 4]) -> [[f32; 4]; 6] {
+    let row = |j: usize| {
+        [
+            view_proj[0][j],
+            view_proj[1][j],
+            view_proj[2][j],
+            view_proj[3][j],
+        ]
+    };
+    let (r0, r1, r2, r3) = (row(0), row(1), row(2), row(3));
+    let add = |a: [f32; 4], b: [f32; 4]| [a[0] + b[0], a[1] + b[1], a[2] + b[2], a[3] + b[3]];
+    let sub = |a: [f32; 4], b: [f32; 4]| [a[0] - b[0], a[1] - b[1], a[2] - b[2], a[3] - b[3]];
+    [
+        add(r3, r0),
+        sub(r3, r0),
+        add(r3, r1),
+        sub(r3, r1),
+        r2,
+        sub(r3, r2),
+    ]
+}
+
+/// Whether an axis-aligned box may be visible through `planes`.
+///
+/// Conservative: a box is only rejected when it lies wholly outside one
+/// plane, so some boxes near the frustum's edges are kept although unseen.
+pub fn aabb_in_frustum(planes: &[[f32; 4]; 6], min: [f32; 3], max: [f32; 3]) -> bool {
+    planes.iter().all(|p| {
+        // The corner furthest along the plane normal.
+        let x = if p[0] >= 0.0 { max[0] } else { min[0] };
+        let y = if p[1] >= 0.0 { max[1] } else { min[1] };
+        let z = if p[2] >= 0.0 { max[2] } else { min[2] };
+        p[0] * x + p[1] * y + p[2] * z + p[3] >= 0.0
+    })
+}
+
 pub fn compute_view_proj(
     bounds_min: [f32; 3],
     bounds_max: [f32; 3],
@@ -528,3 +604,73 @@ mod view_proj_tests {
         assert!(project_point(&vp, [0.0, 0.0, 1000.0], 400, 400).is_none());
     }
 }
+
+#[cfg(test)]
+mod frustum_tests {
+    use super::*;
+
+    #[test]
+    fn fitted_model_is_inside_and_far_boxes_are_culled() {
+        let (min, max) = ([0.0, 0.0, 0.0], [16.0, 16.0, 16.0]);
+        for projection in [Projection::Perspective, Projection::Orthographic] {
+            let camera = CameraConfig {
+                projection,
+                ..CameraConfig::default()
+            };
+            let (view_proj, _) = compute_view_proj(min, max, 1.0, &camera);
+            let planes = frustum_planes(&view_proj);
+            assert!(aabb_in_frustum(&planes, min, max));
+            assert!(aabb_in_frustum(&planes, [4.0; 3], [5.0; 3]));
+            assert!(!aabb_in_frustum(
+                &planes,
+                [1000.0, 0.0, 0.0],
+                [1016.0, 16.0, 16.0]
+            ));
+            assert!(!aabb_in_frustum(
+                &planes,
+                [0.0, -1000.0, 0.0],
+                [16.0, -984.0, 16.0]
+            ));
+        }
+    }
+
+    #[test]
+    fn zoomed_in_camera_culls_the_edges_of_the_model() {
+        let (min, max) = ([-64.0, 0.0, -64.0], [64.0, 8.0, 64.0]);
+        let camera = CameraConfig {
+            zoom: 8.0,
+            ..CameraConfig::default()
+        };
+        let (view_proj, _) = compute_view_proj(min, max, 1.0, &camera);
+        let planes = frustum_planes(&view_proj);
+        assert!(aabb_in_frustum(&planes, [-1.0, 0.0, -1.0], [1.0, 8.0, 1.0]));
+        assert!(!aabb_in_frustum(
+            &planes,
+            [-64.0, 0.0, 48.0],
+            [-48.0, 8.0, 64.0]
+        ));
+    }
+}
+
+#[cfg(test)]
+mod tile_tests {
+    use super::*;
+
+    #[test]
+    fn tiles_place_points_at_their_full_image_pixels() {
+        let camera = CameraConfig {
+            projection: Projection::Orthographic,
+            ..CameraConfig::default()
+        };
+        let (full, _) = compute_view_proj([0.0; 3], [32.0, 8.0, 32.0], 2.0, &camera);
+        let (width, height, tile) = (1000, 500, 256);
+        for point in [[3.0, 1.0, 7.0], [16.0, 4.0, 16.0], [30.0, 7.5, 2.0]] {
+            let (px, py) = project_point(&full, point, width, height).unwrap();
+            let (tx, ty) = ((px as u32 / tile) * tile, (py as u32 / tile) * tile);
+            let cropped = tile_view_proj(full, width, height, tx, ty, tile, tile);
+            let (qx, qy) = project_point(&cropped, point, tile, tile).unwrap();
+            assert!((qx + tx as f32 - px).abs() < 1e-2, "{qx} + {tx} vs {px}");
+            assert!((qy + ty as f32 - py).abs() < 1e-2, "{qy} + {ty} vs {py}");
+        }
+    }
+}
@@ -3,11 +3,15 @@
 //! Extracted from `examples/render_schematic.rs`. Supports headless (offscreen)
 //! and windowed rendering with optional HDRI environment maps.
 
+use std::collections::HashMap;
+
 use wgpu::util::DeviceExt;
 
 use crate::meshing::{MeshLayer, MeshOutput};
 
-use super::camera::{compute_view_proj, merged_bounds, CameraConfig};
+use super::camera::{
+    aabb_in_frustum, compute_view_proj, frustum_planes, mat4_inverse, merged_bounds, CameraConfig,
+};
 use super::hdri::HdriData;
 use super::RenderError;
 
@@ -50,10 +54,11 @@ struct Uniforms {
     light: [f32; 4],  // xyz = world direction, w = directional intensity
 }
 
-/// Per-draw animation state, mirroring `DrawUniforms` in the shader.
+/// Per-instance animation state, mirroring `InstanceInput` in the shader.
+/// Records are packed back to back in the instance vertex buffer.
 ///
-/// WGSL aligns each `mat3x3` column to 16 bytes, so the normal matrix is stored
-/// as three padded `vec4`s rather than three `vec3`s.
+/// The normal matrix columns are padded to `vec4`s, so each attribute starts
+/// 16-byte aligned; the shader reads the first three floats of each.
 #[repr(C)]
 #[derive(Copy, Clone, bytemuck::Pod, bytemuck::Zeroable)]
 struct DrawUniforms {
@@ -99,6 +104,110 @@ impl DrawUniforms {
             emissive: p.emissive,
         }
     }
+
+    /// This state applied to geometry stored relative to `origin`, i.e. the
+    /// model matrix followed by a translation to `origin`.
+    fn placed(mut self, origin: [f32; 3]) -> Self {
+        let m = self.model;
+        for row in 0..4 {
+            self.model[3][row] =
+                m[0][row] * origin[0] + m[1][row] * origin[1] + m[2][row] * origin[2] + m[3][row];
+        }
+        self
+    }
+}
+
+/// Shader locations 4..=12 over one `DrawUniforms` record: the model
+/// columns, the padded normal-matrix columns, tint and emissive.
+const INSTANCE_ATTRIBUTES: [wgpu::VertexAttribute; 9] = {
+    let formats = [
+        wgpu::VertexFormat::Float32x4,
+        wgpu::VertexFormat::Float32x4,
+        wgpu::VertexFormat::Float32x4,
+        wgpu::VertexFormat::Float32x4,
+        wgpu::VertexFormat::Float32x3,
+        wgpu::VertexFormat::Float32x3,
+        wgpu::VertexFormat::Float32x3,
+        wgpu::VertexFormat::Float32x4,
+        wgpu::VertexFormat::Float32x4,
+    ];
+    let mut attributes = [wgpu::VertexAttribute {
+        format: wgpu::VertexFormat::Float32x4,
+        offset: 0,
+        shader_location: 0,
+    }; 9];
+    let mut i = 0;
+    while i < 9 {
+        attributes[i] = wgpu::VertexAttribute {
+            format: formats[i],
+            offset: 16 * i as u64,
+            shader_location: 4 + i as u32,
+        };
+        i += 1;
+    }
+    attributes
+};
+
+/// Where a mesh's geometry is stored relative to: the floor of its bounds
+/// minimum, so integer block offsets survive the subtraction exactly.
+fn mesh_origin(mesh: &MeshOutput) -> [f32; 3] {
+    mesh.bounds.min.map(f32::floor)
+}
+
+fn local_positions(layer: &MeshLayer, origin: [f32; 3]) -> Vec<[f32; 3]> {
+    layer
+        .positions
+        .iter()
+        .map(|p| [p[0] - origin[0], p[1] - origin[1], p[2] - origin[2]])
+        .collect()
+}
+
+/// Group meshes that are translated copies of each other (stacked or
+/// stamped structures), keyed by a hash of their geometry relative to
+/// [`mesh_origin`] and their atlas. Returns the geometry index of every mesh
+/// and the number of distinct geometries; geometry `g` is first used by the
+/// mesh it was numbered after.
+fn dedupe_meshes(meshes: &[MeshOutput]) -> (Vec<usize>, usize) {
+    let mut seen: HashMap<[u8; 32], usize> = HashMap::new();
+    let geometry = meshes
+        .iter()
+        .map(|mesh| {
+            let origin = mesh_origin(mesh);
+            let mut hasher = blake3::Hasher::new();
+            hasher.update(&mesh.atlas.width.to_le_bytes());
+            hasher.update(&mesh.atlas.height.to_le_bytes());
+            hasher.update(&mesh.atlas.pixels);
+            for layer in [&mesh.opaque, &mesh.cutout, &mesh.transparent] {
+                hasher.update(&(layer.positions.len() as u64).to_le_bytes());
+                hasher.update(bytemuck::cast_slice(&local_positions(layer, origin)));
+                hasher.update(layer.normals_bytes());
+                hasher.update(layer.uvs_bytes());
+                hasher.update(layer.colors_bytes());
+                hasher.update(&(layer.indices.len() as u64).to_le_bytes());
+                hasher.update(layer.indices_bytes());
+            }
+            let next = seen.len();
+            *seen.entry(hasher.finalize().into()).or_insert(next)
+        })
+        .collect();
+    (geometry, seen.len())
+}
+
+/// Instance buffer contents: every chunk's pose (identity past the end of
+/// `poses`) placed at its origin, at its slot.
+fn instance_records(chunks: &[ChunkGpuData], poses: &[crate::animation::Pose]) -> Vec<u8> {
+    let size = std::mem::size_of::<DrawUniforms>();
+    let mut bytes = vec![0u8; size * chunks.len()];
+    for (i, chunk) in chunks.iter().enumerate() {
+        let record = poses
+            .get(i)
+            .map(DrawUniforms::from_pose)
+            .unwrap_or_else(DrawUniforms::identity)
+            .placed(chunk.origin);
+        let at = chunk.slot as usize * size;
+        bytes[at..at + size].copy_from_slice(bytemuck::bytes_of(&record));
+    }
+    bytes
 }
 
 /// Interleaved `[x, y, z, r, g, b, a]` line vertices for a reference grid and,
@@ -296,6 +405,71 @@ mod grid_tests {
     }
 }
 
+/// A wgpu instance for offscreen rendering on any backend.
+pub(crate) fn headless_instance() -> wgpu::Instance {
+    // wgpu 30: `InstanceDescriptor` is passed by value and has no `Default`
+    // (its `display` field is a boxed trait object), so spell it out.
+    wgpu::Instance::new(wgpu::InstanceDescriptor {
+        backends: wgpu::Backends::all(),
+        flags: wgpu::InstanceFlags::default(),
+        memory_budget_thresholds: Default::default(),
+        backend_options: Default::default(),
+        display: None,
+    })
+}
+
+/// Pick an adapter (hardware first, then software) and open a device on it
+/// with the features the render pipelines need.
+pub(crate) async fn open_device(
+    instance: &wgpu::Instance,
+    surface: Option<&wgpu::Surface<'_>>,
+) -> Result<(wgpu::Adapter, wgpu::Device, wgpu::Queue), RenderError> {
+    // Graceful GPU fallback: hardware → software → error
+    // wgpu 30: `request_adapter` returns `Result`, not `Option`.
+    let adapter = match instance
+        .request_adapter(&wgpu::RequestAdapterOptions {
+            power_preference: wgpu::PowerPreference::HighPerformance,
+            compatible_surface: surface,
+            force_fallback_adapter: false,
+            ..Default::default()
+        })
+        .await
+    {
+        Ok(a) => a,
+        Err(_) => {
+            // Try software fallback
+            instance
+                .request_adapter(&wgpu::RequestAdapterOptions {
+                    power_preference: wgpu::PowerPreference::LowPower,
+                    compatible_surface: surface,
+                    force_fallback_adapter: true,
+                    ..Default::default()
+                })
+                .await
+                .map_err(|_| RenderError::NoGpuAdapter)?
+        }
+    };
+
+    // wgpu 30: single-argument `request_device` (the trace path moved into
+    // the descriptor), and `DeviceDescriptor` has no `Default`.
+    let (device, queue) = adapter
+        .request_device(&wgpu::DeviceDescriptor {
+            label: Some("render_device"),
+            // Timestamp queries only back opt-in profiling, so take them
+            // where the adapter has them rather than requiring them.
+            required_features: wgpu::Features::FLOAT32_FILTERABLE
+                | (adapter.features() & wgpu::Features::TIMESTAMP_QUERY),
+            required_limits: wgpu::Limits::default(),
+            experimental_features: wgpu::ExperimentalFeatures::disabled(),
+            memory_hints: wgpu::MemoryHints::default(),
+            trace: wgpu::Trace::Off,
+        })
+        .await
+        .map_err(|e| RenderError::DeviceCreation(e.to_string()))?;
+
+    Ok((adapter, device, queue))
+}
+
 struct LayerBuffers {
     positions: wgpu::Buffer,
     normals: wgpu::Buffer,
@@ -305,13 +479,54 @@ struct LayerBuffers {
     index_count: u32,
 }
 
-struct ChunkGpuData {
+// Uploaded geometry, shared by every mesh that is a translated copy of it.
+struct GeometryGpuData {
     texture_bg: wgpu::BindGroup,
     opaque: Option<LayerBuffers>,
     cutout: Option<LayerBuffers>,
     transparent: Option<LayerBuffers>,
 }
 
+struct ChunkGpuData {
+    geometry: usize,
+    // Translation from the shared geometry's local space to this mesh.
+    origin: [f32; 3],
+    // Record in the instance buffer; the instances of one geometry are
+    // contiguous, so visible runs draw with one call.
+    slot: u32,
+    // Unposed world-space bounds, for frustum culling.
+    bounds_min: [f32; 3],
+    bounds_max: [f32; 3],
+}
+
+// Start/end timestamps of the main render pass, resolved and copied to a
+// mappable buffer in the same submission.
+struct GpuTimer {
+    query_set: wgpu::QuerySet,
+    resolve: wgpu::Buffer,
+    read: wgpu::Buffer,
+    period_ns: f32,
+}
+
+/// Counters and timings of the last [`GpuRenderer::render_frame`].
+#[derive(Clone, Copy, Debug, Default)]
+pub struct FrameProfile {
+    /// CPU time encoding the frame and submitting it.
+    pub encode_ms: f64,
+    /// From submission until the readback buffer mapped: GPU work and the
+    /// copy back to the host.
+    pub gpu_wait_ms: f64,
+    /// Copying the rows out of the mapped readback buffer.
+    pub readback_ms: f64,
+    /// Render pass duration from GPU timestamps. Only measured with
+    /// [`GpuRenderer::set_profiling`] on and a device that has timestamp
+    /// queries.
+    pub gpu_pass_ms: Option<f64>,
+    pub draw_calls: usize,
+    pub triangles: u64,
+    pub bytes_read_back: u64,
+}
+
 /// GPU renderer for schematics. Supports both headless and windowed modes.
 ///
 /// For headless rendering, use [`GpuRenderer::new`]. For windowed rendering
@@ -328,15 +543,25 @@ pub struct GpuRenderer {
     hdri_bg: wgpu::BindGroup,
     hdri_enabled: bool,
     dummy_atlas_bg: wgpu::BindGroup,
-    // Per-draw animation state, addressed with a dynamic offset per chunk.
-    draw_buf: wgpu::Buffer,
-    draw_bg: wgpu::BindGroup,
-    draw_stride: u32,
+    // Per-instance animation state, one `DrawUniforms` record per chunk.
+    instance_buf: wgpu::Buffer,
     // Optional world-space reference grid.
     line_pipeline: wgpu::RenderPipeline,
     grid: std::cell::Cell<Option<super::GridConfig>>,
+    view_proj: std::cell::Cell<Option<[[f32; 4]; 4]>>,
     gizmos: std::cell::RefCell<Vec<crate::animation::GizmoLine>>,
+    geometries: Vec<GeometryGpuData>,
     chunks_gpu: Vec<ChunkGpuData>,
+    // Meshes whose pose moves them off their bounds; never frustum culled.
+    moved: std::cell::RefCell<Vec<bool>>,
+    drawn_chunks: std::cell::Cell<usize>,
+    draw_calls: std::cell::Cell<usize>,
+    triangles: std::cell::Cell<u64>,
+    // Opt-in profiling state.
+    profiling: std::cell::Cell<bool>,
+    timer: Option<GpuTimer>,
+    last_profile: std::cell::Cell<FrameProfile>,
+    uploaded_bytes: u64,
     // Headless-only (None in windowed mode)
     render_target: Option<wgpu::Texture>,
     render_target_view: Option<wgpu::TextureView>,
@@ -357,16 +582,7 @@ impl GpuRenderer {
         height: u32,
         hdri: Option<&HdriData>,
     ) -> Result<Self, RenderError> {
-        // wgpu 30: `InstanceDescriptor` is passed by value and has no `Default`
-        // (its `display` field is a boxed trait object), so spell it out.
-        let instance = wgpu::Instance::new(wgpu::InstanceDescriptor {
-            backends: wgpu::Backends::all(),
-            flags: wgpu::InstanceFlags::default(),
-            memory_budget_thresholds: Default::default(),
-            backend_options: Default::default(),
-            display: None,
-        });
-        Self::create(meshes, width, height, hdri, &instance, None).await
+        Self::create(meshes, width, height, hdri, &headless_instance(), None).await
     }
 
     /// Windowed constructor — caller provides instance + surface.
@@ -389,46 +605,64 @@ impl GpuRenderer {
         instance: &wgpu::Instance,
         surface: Option<&wgpu::Surface<'_>>,
     ) -> Result<Self, RenderError> {
-        // Graceful GPU fallback: hardware → software → error
-        // wgpu 30: `request_adapter` returns `Result`, not `Option`.
-        let adapter = match instance
-            .request_adapter(&wgpu::RequestAdapterOptions {
-                power_preference: wgpu::PowerPreference::HighPerformance,
-                compatible_surface: surface,
-                force_fallback_adapter: false,
-                ..Default::default()
-            })
-            .await
-        {
-            Ok(a) => a,
-            Err(_) => {
-                // Try software fallback
-                instance
-                    .request_adapter(&wgpu::RequestAdapterOptions {
-                        power_preference: wgpu::PowerPreference::LowPower,
-                        compatible_surface: surface,
-                        force_fallback_adapter: true,
-                        ..Default::default()
-                    })
-                    .await
-                    .map_err(|_| RenderError::NoGpuAdapter)?
-            }
+        let (adapter, device, queue) = open_device(instance, surface).await?;
+
+        let color_format = if let Some(s) = surface {
+            let caps = s.get_capabilities(&adapter);
+            caps.formats
+                .iter()
+                .copied()
+                .find(|f| f.is_srgb())
+                .unwrap_or(caps.formats[0])
+        } else {
+            wgpu::TextureFormat::Rgba8UnormSrgb
         };
+        Ok(Self::build(
+            meshes,
+            width,
+            height,
+            hdri,
+            device,
+            queue,
+            color_format,
+            surface.is_none(),
+        ))
+    }
 
-        // wgpu 30: single-argument `request_device` (the trace path moved into
-        // the descriptor), and `DeviceDescriptor` has no `Default`.
-        let (device, queue) = adapter
-            .request_device(&wgpu::DeviceDescriptor {
-                label: Some("render_device"),
-                required_features: wgpu::Features::FLOAT32_FILTERABLE,
-                required_limits: wgpu::Limits::default(),
-                experimental_features: wgpu::ExperimentalFeatures::disabled(),
-                memory_hints: wgpu::MemoryHints::default(),
-                trace: wgpu::Trace::Off,
-            })
-            .await
-            .map_err(|e| RenderError::DeviceCreation(e.to_string()))?;
+    /// Headless renderer on a device the caller already owns, such as one
+    /// of a [`super::pool::RenderPool`]'s contexts. Skips adapter and device
+    /// creation, which dominate start-up for small scenes.
+    pub fn with_device(
+        meshes: &[MeshOutput],
+        width: u32,
+        height: u32,
+        hdri: Option<&HdriData>,
+        device: wgpu::Device,
+        queue: wgpu::Queue,
+    ) -> Self {
+        Self::build(
+            meshes,
+            width,
+            height,
+            hdri,
+            device,
+            queue,
+            wgpu::TextureFormat::Rgba8UnormSrgb,
+            true,
+        )
+    }
 
+    #[allow(clippy::too_many_arguments)]
+    fn build(
+        meshes: &[MeshOutput],
+        width: u32,
+        height: u32,
+        hdri: Option<&HdriData>,
+        device: wgpu::Device,
+        queue: wgpu::Queue,
+        color_format: wgpu::TextureFormat,
+        headless: bool,
+    ) -> Self {
         let shader = device.create_shader_module(wgpu::ShaderModuleDescriptor {
             label: Some("render_shader"),
             source: wgpu::ShaderSource::Wgsl(SHADER_SRC.into()),
@@ -490,37 +724,25 @@ impl GpuRenderer {
                     ty: wgpu::BindingType::Sampler(wgpu::SamplerBindingType::Filtering),
                     count: None,
                 },
-            ],
-        });
-
-        // Per-draw uniforms: one aligned slot per mesh, selected with a dynamic
-        // offset so the whole scene needs a single buffer and bind group.
-        let draw_bgl = device.create_bind_group_layout(&wgpu::BindGroupLayoutDescriptor {
-            label: Some("draw_bgl"),
-            entries: &[wgpu::BindGroupLayoutEntry {
-                binding: 0,
-                visibility: wgpu::ShaderStages::VERTEX | wgpu::ShaderStages::FRAGMENT,
-                ty: wgpu::BindingType::Buffer {
-                    ty: wgpu::BufferBindingType::Uniform,
-                    has_dynamic_offset: true,
-                    min_binding_size: wgpu::BufferSize::new(
-                        std::mem::size_of::<DrawUniforms>() as u64
-                    ),
+                // Prefiltered diffuse irradiance, same mapping as binding 0.
+                wgpu::BindGroupLayoutEntry {
+                    binding: 2,
+                    visibility: wgpu::ShaderStages::FRAGMENT,
+                    ty: wgpu::BindingType::Texture {
+                        sample_type: wgpu::TextureSampleType::Float { filterable: true },
+                        view_dimension: wgpu::TextureViewDimension::D2,
+                        multisampled: false,
+                    },
+                    count: None,
                 },
-                count: None,
-            }],
+            ],
         });
 
         let mesh_pipeline_layout = device.create_pipeline_layout(&wgpu::PipelineLayoutDescriptor {
             label: Some("mesh_pipeline_layout"),
             // wgpu 30: layouts are `Option`-wrapped (gaps allowed) and
             // `push_constant_ranges` was replaced by immediates.
-            bind_group_layouts: &[
-                Some(&uniform_bgl),
-                Some(&texture_bgl),
-                Some(&hdri_bgl),
-                Some(&draw_bgl),
-            ],
+            bind_group_layouts: &[Some(&uniform_bgl), Some(&texture_bgl), Some(&hdri_bgl)],
             ..Default::default()
         });
 
@@ -540,14 +762,14 @@ impl GpuRenderer {
             ..Default::default()
         });
 
-        let (hdri_tex_view, hdri_enabled) = if let Some(hdr) = hdri {
+        let upload_rgba32f = |label: &str, width: u32, height: u32, pixels: &[f32]| {
             let size = wgpu::Extent3d {
-                width: hdr.width,
-                height: hdr.height,
+                width,
+                height,
                 depth_or_array_layers: 1,
             };
             let tex = device.create_texture(&wgpu::TextureDescriptor {
-                label: Some("hdri"),
+                label: Some(label),
                 size,
                 mip_level_count: 1,
                 sample_count: 1,
@@ -556,7 +778,6 @@ impl GpuRenderer {
                 usage: wgpu::TextureUsages::TEXTURE_BINDING | wgpu::TextureUsages::COPY_DST,
                 view_formats: &[],
             });
-            let pixel_bytes: &[u8] = bytemuck::cast_slice(&hdr.pixels_rgba32f);
             queue.write_texture(
                 wgpu::TexelCopyTextureInfo {
                     texture: &tex,
@@ -564,51 +785,42 @@ impl GpuRenderer {
                     origin: wgpu::Origin3d::ZERO,
                     aspect: wgpu::TextureAspect::All,
                 },
-                pixel_bytes,
+                bytemuck::cast_slice(pixels),
                 wgpu::TexelCopyBufferLayout {
                     offset: 0,
-                    bytes_per_row: Some(hdr.width * 16),
-                    rows_per_image: Some(hdr.height),
+                    bytes_per_row: Some(width * 16),
+                    rows_per_image: Some(height),
                 },
                 size,
             );
+            tex.create_view(&wgpu::TextureViewDescriptor::default())
+        };
+
+        let (hdri_tex_view, irradiance_view, hdri_enabled) = if let Some(hdr) = hdri {
+            // Maps built by hand may lack the irradiance; loaded ones carry it.
+            let computed;
+            let irradiance = if hdr.irradiance_rgba32f.is_empty() {
+                computed =
+                    super::hdri::convolve_irradiance(hdr.width, hdr.height, &hdr.pixels_rgba32f);
+                &computed
+            } else {
+                &hdr.irradiance_rgba32f
+            };
             (
-                tex.create_view(&wgpu::TextureViewDescriptor::default()),
+                upload_rgba32f("hdri", hdr.width, hdr.height, &hdr.pixels_rgba32f),
+                upload_rgba32f(
+                    "hdri_irradiance",
+                    super::hdri::IRRADIANCE_WIDTH,
+                    super::hdri::IRRADIANCE_HEIGHT,
+                    irradiance,
+                ),
                 true,
             )
         } else {
-            let size = wgpu::Extent3d {
-                width: 1,
-                height: 1,
-                depth_or_array_layers: 1,
-            };
-            let tex = device.create_texture(&wgpu::TextureDescriptor {
-                label: Some("hdri_dummy"),
-                size,
-                mip_level_count: 1,
-                sample_count: 1,
-                dimension: wgpu::TextureDimension::D2,
-                format: wgpu::TextureFormat::Rgba32Float,
-                usage: wgpu::TextureUsages::TEXTURE_BINDING | wgpu::TextureUsages::COPY_DST,
-                view_formats: &[],
-            });
-            queue.write_texture(
-                wgpu::TexelCopyTextureInfo {
-                    texture: &tex,
-                    mip_level: 0,
-                    origin: wgpu::Origin3d::ZERO,
-                    aspect: wgpu::TextureAspect::All,
-                },
-                bytemuck::cast_slice(&[0.0f32, 0.0, 0.0, 1.0]),
-                wgpu::TexelCopyBufferLayout {
-                    offset: 0,
-                    bytes_per_row: Some(16),
-                    rows_per_image: Some(1),
-                },
-                size,
-            );
+            let black = [0.0f32, 0.0, 0.0, 1.0];
             (
-                tex.create_view(&wgpu::TextureViewDescriptor::default()),
+                upload_rgba32f("hdri_dummy", 1, 1, &black),
+                upload_rgba32f("hdri_irradiance_dummy", 1, 1, &black),
                 false,
             )
         };
@@ -625,6 +837,10 @@ impl GpuRenderer {
                     binding: 1,
                     resource: wgpu::BindingResource::Sampler(&hdri_sampler),
                 },
+                wgpu::BindGroupEntry {
+                    binding: 2,
+                    resource: wgpu::BindingResource::TextureView(&irradiance_view),
+                },
             ],
         });
 
@@ -667,23 +883,17 @@ impl GpuRenderer {
                     shader_location: 3,
                 }],
             }),
+            Some(wgpu::VertexBufferLayout {
+                array_stride: std::mem::size_of::<DrawUniforms>() as u64,
+                step_mode: wgpu::VertexStepMode::Instance,
+                attributes: &INSTANCE_ATTRIBUTES,
+            }),
         ];
 
-        // --- Color format ---
-        let color_format = if let Some(s) = surface {
-            let caps = s.get_capabilities(&adapter);
-            caps.formats
-                .iter()
-                .copied()
-                .find(|f| f.is_srgb())
-                .unwrap_or(caps.formats[0])
-        } else {
-            wgpu::TextureFormat::Rgba8UnormSrgb
-        };
         let depth_format = wgpu::TextureFormat::Depth32Float;
 
         // --- Render targets (headless only) ---
-        let (render_target, render_target_view) = if surface.is_none() {
+        let (render_target, render_target_view) = if headless {
             let rt = device.create_texture(&wgpu::TextureDescriptor {
                 label: Some("render_target"),
                 size: wgpu::Extent3d {
@@ -893,44 +1103,52 @@ impl GpuRenderer {
         });
 
         // --- Upload chunk data ---
-        let upload_layer = |layer: &MeshLayer, label: &str| -> Option<LayerBuffers> {
-            if layer.is_empty() {
-                return None;
-            }
-            Some(LayerBuffers {
-                positions: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
-                    label: Some(&format!("{}_pos", label)),
-                    contents: layer.positions_bytes(),
-                    usage: wgpu::BufferUsages::VERTEX,
-                }),
-                normals: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
-                    label: Some(&format!("{}_norm", label)),
-                    contents: layer.normals_bytes(),
-                    usage: wgpu::BufferUsages::VERTEX,
-                }),
-                uvs: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
-                    label: Some(&format!("{}_uv", label)),
-                    contents: layer.uvs_bytes(),
-                    usage: wgpu::BufferUsages::VERTEX,
-                }),
-                colors: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
-                    label: Some(&format!("{}_col", label)),
-                    contents: layer.colors_bytes(),
-                    usage: wgpu::BufferUsages::VERTEX,
-                }),
-                indices: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
-                    label: Some(&format!("{}_idx", label)),
-                    contents: layer.indices_bytes(),
-                    usage: wgpu::BufferUsages::INDEX,
-                }),
-                index_count: layer.indices.len() as u32,
-            })
-        };
+        let upload_layer =
+            |layer: &MeshLayer, origin: [f32; 3], label: &str| -> Option<LayerBuffers> {
+                if layer.is_empty() {
+                    return None;
+                }
+                Some(LayerBuffers {
+                    positions: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
+                        label: Some(&format!("{}_pos", label)),
+                        contents: bytemuck::cast_slice(&local_positions(layer, origin)),
+                        usage: wgpu::BufferUsages::VERTEX,
+                    }),
+                    normals: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
+                        label: Some(&format!("{}_norm", label)),
+                        contents: layer.normals_bytes(),
+                        usage: wgpu::BufferUsages::VERTEX,
+                    }),
+                    uvs: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
+                        label: Some(&format!("{}_uv", label)),
+                        contents: layer.uvs_bytes(),
+                        usage: wgpu::BufferUsages::VERTEX,
+                    }),
+                    colors: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
+                        label: Some(&format!("{}_col", label)),
+                        contents: layer.colors_bytes(),
+                        usage: wgpu::BufferUsages::VERTEX,
+                    }),
+                    indices: device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
+                        label: Some(&format!("{}_idx", label)),
+                        contents: layer.indices_bytes(),
+                        usage: wgpu::BufferUsages::INDEX,
+                    }),
+                    index_count: layer.indices.len() as u32,
+                })
+            };
 
-        let chunks_gpu: Vec<ChunkGpuData> = meshes
+        // Translated copies share one upload and draw as instances of it.
+        let (geometry_of, geometry_count) = dedupe_meshes(meshes);
+        let mut first_use = vec![usize::MAX; geometry_count];
+        for (i, &g) in geometry_of.iter().enumerate().rev() {
+            first_use[g] = i;
+        }
+        let geometries: Vec<GeometryGpuData> = first_use
             .iter()
-            .enumerate()
-            .map(|(i, mesh)| {
+            .map(|&i| {
+                let mesh = &meshes[i];
+                let origin = mesh_origin(mesh);
                 let atlas_size = wgpu::Extent3d {
                     width: mesh.atlas.width,
                     height: mesh.atlas.height,
@@ -978,11 +1196,40 @@ impl GpuRenderer {
                 });
 
                 let label = format!("c{}", i);
-                ChunkGpuData {
+                GeometryGpuData {
                     texture_bg,
-                    opaque: upload_layer(&mesh.opaque, &format!("{}_opaque", label)),
-                    cutout: upload_layer(&mesh.cutout, &format!("{}_cutout", label)),
-                    transparent: upload_layer(&mesh.transparent, &format!("{}_transparent", label)),
+                    opaque: upload_layer(&mesh.opaque, origin, &format!("{}_opaque", label)),
+                    cutout: upload_layer(&mesh.cutout, origin, &format!("{}_cutout", label)),
+                    transparent: upload_layer(
+                        &mesh.transparent,
+                        origin,
+                        &format!("{}_transparent", label),
+                    ),
+                }
+            })
+            .collect();
+
+        // Number instance slots geometry by geometry, in mesh order within each.
+        let mut next_slot = vec![0u32; geometry_count];
+        for &g in &geometry_of {
+            next_slot[g] += 1;
+        }
+        let mut base = 0;
+        for count in next_slot.iter_mut() {
+            (*count, base) = (base, base + *count);
+        }
+        let chunks_gpu: Vec<ChunkGpuData> = meshes
+            .iter()
+            .zip(&geometry_of)
+            .map(|(mesh, &geometry)| {
+                let slot = next_slot[geometry];
+                next_slot[geometry] += 1;
+                ChunkGpuData {
+                    geometry,
+                    origin: mesh_origin(mesh),
+                    slot,
+                    bounds_min: mesh.bounds.min,
+                    bounds_max: mesh.bounds.max,
                 }
             })
             .collect();
@@ -1019,7 +1266,7 @@ impl GpuRenderer {
         });
 
         // Staging buffer (headless only)
-        let (staging_buffer, padded_bytes_per_row) = if surface.is_none() {
+        let (staging_buffer, padded_bytes_per_row) = if headless {
             let bytes_per_pixel = 4u32;
             let unpadded_bytes_per_row = bytes_per_pixel * width;
             let align = wgpu::COPY_BYTES_PER_ROW_ALIGNMENT;
@@ -1037,40 +1284,62 @@ impl GpuRenderer {
 
         let (bounds_min, bounds_max) = merged_bounds(meshes);
 
-        // One aligned slot per mesh. Alignment comes from the device rather
-        // than a hardcoded 256, so this is correct on every backend.
-        let align = device.limits().min_uniform_buffer_offset_alignment;
-        let draw_stride = {
-            let sz = std::mem::size_of::<DrawUniforms>() as u32;
-            sz.div_ceil(align) * align
-        };
-        let slots = chunks_gpu.len().max(1) as u64;
-        let identity = DrawUniforms::identity();
-        let mut init = vec![0u8; (draw_stride as u64 * slots) as usize];
-        for i in 0..slots as usize {
-            let off = i * draw_stride as usize;
-            init[off..off + std::mem::size_of::<DrawUniforms>()]
-                .copy_from_slice(bytemuck::bytes_of(&identity));
+        let mut records = instance_records(&chunks_gpu, &[]);
+        if records.is_empty() {
+            // Keep the buffer non-empty so it can always be bound.
+            records = bytemuck::bytes_of(&DrawUniforms::identity()).to_vec();
         }
-        let draw_buf = device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
-            label: Some("draw_uniforms"),
-            contents: &init,
-            usage: wgpu::BufferUsages::UNIFORM | wgpu::BufferUsages::COPY_DST,
+        let instance_buf = device.create_buffer_init(&wgpu::util::BufferInitDescriptor {
+            label: Some("instances"),
+            contents: &records,
+            usage: wgpu::BufferUsages::VERTEX | wgpu::BufferUsages::COPY_DST,
         });
-        let draw_bg = device.create_bind_group(&wgpu::BindGroupDescriptor {
-            label: Some("draw_bg"),
-            layout: &draw_bgl,
-            entries: &[wgpu::BindGroupEntry {
-                binding: 0,
-                resource: wgpu::BindingResource::Buffer(wgpu::BufferBinding {
-                    buffer: &draw_buf,
-                    offset: 0,
-                    size: wgpu::BufferSize::new(std::mem::size_of::<DrawUniforms>() as u64),
+        let uploaded_bytes = records.len() as u64
+            + first_use
+                .iter()
+                .map(|&i| {
+                    let mesh = &meshes[i];
+                    let layers = [&mesh.opaque, &mesh.cutout, &mesh.transparent];
+                    mesh.atlas.pixels.len() as u64
+                        + layers
+                            .iter()
+                            .map(|layer| {
+                                (layer.positions_bytes().len()
+                                    + layer.normals_bytes().len()
+                                    + layer.uvs_bytes().len()
+                                    + layer.colors_bytes().len()
+                                    + layer.indices_bytes().len())
+                                    as u64
+                            })
+                            .sum::<u64>()
+                })
+                .sum::<u64>();
+
+        let timer = device
+            .features()
+            .contains(wgpu::Features::TIMESTAMP_QUERY)
+            .then(|| GpuTimer {
+                query_set: device.create_query_set(&wgpu::QuerySetDescriptor {
+                    label: Some("pass_timestamps"),
+                    ty: wgpu::QueryType::Timestamp,
+                    count: 2,
                 }),
-            }],
-        });
+                resolve: device.create_buffer(&wgpu::BufferDescriptor {
+                    label: Some("timestamp_resolve"),
+                    size: 16,
+                    usage: wgpu::BufferUsages::QUERY_RESOLVE | wgpu::BufferUsages::COPY_SRC,
+                    mapped_at_creation: false,
+                }),
+                read: device.create_buffer(&wgpu::BufferDescriptor {
+                    label: Some("timestamp_read"),
+                    size: 16,
+                    usage: wgpu::BufferUsages::COPY_DST | wgpu::BufferUsages::MAP_READ,
+                    mapped_at_creation: false,
+                }),
+                period_ns: queue.get_timestamp_period(),
+            });
 
-        Ok(Self {
+        Self {
             device,
             queue,
             color_format,
@@ -1082,12 +1351,20 @@ impl GpuRenderer {
             hdri_bg,
             hdri_enabled,
             dummy_atlas_bg,
-            draw_buf,
-            draw_bg,
-            draw_stride,
+            instance_buf,
             line_pipeline,
             grid: std::cell::Cell::new(None),
+            view_proj: std::cell::Cell::new(None),
             gizmos: std::cell::RefCell::new(Vec::new()),
+            moved: std::cell::RefCell::new(vec![false; chunks_gpu.len()]),
+            drawn_chunks: std::cell::Cell::new(0),
+            draw_calls: std::cell::Cell::new(0),
+            triangles: std::cell::Cell::new(0),
+            profiling: std::cell::Cell::new(false),
+            timer,
+            last_profile: std::cell::Cell::new(FrameProfile::default()),
+            uploaded_bytes,
+            geometries,
             chunks_gpu,
             render_target,
             render_target_view,
@@ -1098,7 +1375,7 @@ impl GpuRenderer {
             padded_bytes_per_row,
             bounds_min,
             bounds_max,
-        })
+        }
     }
 
     /// Encode the full render pass into `encoder`.
@@ -1112,8 +1389,10 @@ impl GpuRenderer {
         height: u32,
     ) {
         let aspect = width as f32 / height as f32;
-        let (view_proj, inv_view_proj) =
-            compute_view_proj(self.bounds_min, self.bounds_max, aspect, camera);
+        let (view_proj, inv_view_proj) = match self.view_proj.get() {
+            Some(view_proj) => (view_proj, mat4_inverse(view_proj)),
+            None => compute_view_proj(self.bounds_min, self.bounds_max, aspect, camera),
+        };
 
         let hdri_intensity = if self.hdri_enabled { 2.5f32 } else { 0.0 };
         let hdri_flag = if self.hdri_enabled { 1.0f32 } else { 0.0 };
@@ -1199,8 +1478,14 @@ impl GpuRenderer {
             (buf, count)
         });
 
+        let timer = self.timer.as_ref().filter(|_| self.profiling.get());
         let mut pass = encoder.begin_render_pass(&wgpu::RenderPassDescriptor {
             label: Some("render_pass"),
+            timestamp_writes: timer.map(|t| wgpu::RenderPassTimestampWrites {
+                query_set: &t.query_set,
+                beginning_of_pass_write_index: Some(0),
+                end_of_pass_write_index: Some(1),
+            }),
             color_attachments: &[Some(wgpu::RenderPassColorAttachment {
                 depth_slice: None,
                 view: color_view,
@@ -1230,49 +1515,67 @@ impl GpuRenderer {
             pass.draw(0..3, 0..1);
         }
 
-        // 2) Mesh layers
-        let draw_layer = |pass: &mut wgpu::RenderPass,
-                          pipeline: &wgpu::RenderPipeline,
-                          uniform_bg: &wgpu::BindGroup,
-                          texture_bg: &wgpu::BindGroup,
-                          bufs: &Option<LayerBuffers>,
-                          chunk_index: usize| {
-            if let Some(b) = bufs {
-                let draw_offset = (chunk_index as u32) * self.draw_stride;
+        // 2) Mesh layers, skipping chunks wholly outside the view.
+        let planes = frustum_planes(&view_proj);
+        let visible: Vec<usize> = {
+            let moved = self.moved.borrow();
+            self.chunks_gpu
+                .iter()
+                .enumerate()
+                .filter(|(i, chunk)| {
+                    moved[*i] || aabb_in_frustum(&planes, chunk.bounds_min, chunk.bounds_max)
+                })
+                .map(|(i, _)| i)
+                .collect()
+        };
+        self.drawn_chunks.set(visible.len());
+
+        // Visible instances per geometry as runs of consecutive slots, so a
+        // geometry whose copies are all in view draws with one call.
+        let mut runs: Vec<Vec<std::ops::Range<u32>>> = vec![Vec::new(); self.geometries.len()];
+        for &i in &visible {
+            let chunk = &self.chunks_gpu[i];
+            let geometry_runs = &mut runs[chunk.geometry];
+            match geometry_runs.last_mut() {
+                Some(run) if run.end == chunk.slot => run.end += 1,
+                _ => geometry_runs.push(chunk.slot..chunk.slot + 1),
+            }
+        }
+        let draw_calls = std::cell::Cell::new(0);
+        let triangles = std::cell::Cell::new(0u64);
+        let draw_layer =
+            |pass: &mut wgpu::RenderPass,
+             pipeline: &wgpu::RenderPipeline,
+             uniform_bg: &wgpu::BindGroup,
+             layer: fn(&GeometryGpuData) -> &Option<LayerBuffers>| {
                 pass.set_pipeline(pipeline);
                 pass.set_bind_group(0, uniform_bg, &[]);
-                pass.set_bind_group(1, texture_bg, &[]);
                 pass.set_bind_group(2, &self.hdri_bg, &[]);
-                pass.set_bind_group(3, &self.draw_bg, &[draw_offset]);
-                pass.set_vertex_buffer(0, b.positions.slice(..));
-                pass.set_vertex_buffer(1, b.normals.slice(..));
-                pass.set_vertex_buffer(2, b.uvs.slice(..));
-                pass.set_vertex_buffer(3, b.colors.slice(..));
-                pass.set_index_buffer(b.indices.slice(..), wgpu::IndexFormat::Uint32);
-                pass.draw_indexed(0..b.index_count, 0, 0..1);
-            }
-        };
+                pass.set_vertex_buffer(4, self.instance_buf.slice(..));
+                for (geometry, geometry_runs) in self.geometries.iter().zip(&runs) {
+                    let Some(b) = layer(geometry) else {
+                        continue;
+                    };
+                    if geometry_runs.is_empty() {
+                        continue;
+                    }
+                    pass.set_bind_group(1, &geometry.texture_bg, &[]);
+                    pass.set_vertex_buffer(0, b.positions.slice(..));
+                    pass.set_vertex_buffer(1, b.normals.slice(..));
+                    pass.set_vertex_buffer(2, b.uvs.slice(..));
+                    pass.set_vertex_buffer(3, b.colors.slice(..));
+                    pass.set_index_buffer(b.indices.slice(..), wgpu::IndexFormat::Uint32);
+                    for run in geometry_runs {
+                        pass.draw_indexed(0..b.index_count, 0, run.clone());
+                        draw_calls.set(draw_calls.get() + 1);
+                        triangles
+                            .set(triangles.get() + (b.index_count / 3) as u64 * run.len() as u64);
+                    }
+                }
+            };
 
-        for (i, chunk) in self.chunks_gpu.iter().enumerate() {
-            draw_layer(
-                &mut pass,
-                &self.opaque_pipeline,
-                &opaque_bg,
-                &chunk.texture_bg,
-                &chunk.opaque,
-                i,
-            );
-        }
-        for (i, chunk) in self.chunks_gpu.iter().enumerate() {
-            draw_layer(
-                &mut pass,
-                &self.cutout_pipeline,
-                &cutout_bg,
-                &chunk.texture_bg,
-                &chunk.cutout,
-                i,
-            );
-        }
+        draw_layer(&mut pass, &self.opaque_pipeline, &opaque_bg, |g| &g.opaque);
+        draw_layer(&mut pass, &self.cutout_pipeline, &cutout_bg, |g| &g.cutout);
         // Grid after the opaque/cutout depth is laid down (so blocks occlude it)
         // but before transparent geometry (so glass blends over it).
         if let Some((buf, count)) = &world_lines {
@@ -1281,16 +1584,19 @@ impl GpuRenderer {
             pass.set_vertex_buffer(0, buf.slice(..));
             pass.draw(0..*count, 0..1);
         }
+        draw_layer(
+            &mut pass,
+            &self.transparent_pipeline,
+            &transparent_bg,
+            |g| &g.transparent,
+        );
+        self.draw_calls.set(draw_calls.get());
+        self.triangles.set(triangles.get());
 
-        for (i, chunk) in self.chunks_gpu.iter().enumerate() {
-            draw_layer(
-                &mut pass,
-                &self.transparent_pipeline,
-                &transparent_bg,
-                &chunk.texture_bg,
-                &chunk.transparent,
-                i,
-            );
+        drop(pass);
+        if let Some(t) = timer {
+            encoder.resolve_query_set(&t.query_set, 0..2, &t.resolve, 0);
+            encoder.copy_buffer_to_buffer(&t.resolve, 0, &t.read, 0, 16);
         }
     }
 
@@ -1308,24 +1614,59 @@ impl GpuRenderer {
     /// `MeshOutput` per animation group). Extra poses are ignored; meshes past
     /// the end of `poses` keep the identity pose.
     ///
-    /// Cheap enough to call once per frame — it writes one uniform buffer and
+    /// Cheap enough to call once per frame — it writes one instance buffer and
     /// touches no geometry, which is what makes rendering an animation from a
     /// single [`GpuRenderer`] worthwhile.
     pub fn set_poses(&self, poses: &[crate::animation::Pose]) {
         if self.chunks_gpu.is_empty() {
             return;
         }
-        let slot = std::mem::size_of::<DrawUniforms>();
-        let mut bytes = vec![0u8; self.draw_stride as usize * self.chunks_gpu.len()];
-        for i in 0..self.chunks_gpu.len() {
-            let u = poses
+        let identity = DrawUniforms::identity().model;
+        let mut moved = self.moved.borrow_mut();
+        for (i, moved) in moved.iter_mut().enumerate() {
+            *moved = poses
                 .get(i)
-                .map(DrawUniforms::from_pose)
-                .unwrap_or_else(DrawUniforms::identity);
-            let off = i * self.draw_stride as usize;
-            bytes[off..off + slot].copy_from_slice(bytemuck::bytes_of(&u));
+                .is_some_and(|p| DrawUniforms::from_pose(p).model != identity);
         }
-        self.queue.write_buffer(&self.draw_buf, 0, &bytes);
+        self.queue.write_buffer(
+            &self.instance_buf,
+            0,
+            &instance_records(&self.chunks_gpu, poses),
+        );
+    }
+
+    /// How many meshes the last encoded frame drew; the rest were outside
+    /// the view frustum.
+    pub fn drawn_chunk_count(&self) -> usize {
+        self.drawn_chunks.get()
+    }
+
+    /// Number of distinct geometries uploaded. Meshes that are translated
+    /// copies of each other share one and draw as instances of it.
+    pub fn unique_mesh_count(&self) -> usize {
+        self.geometries.len()
+    }
+
+    /// Indexed draw calls issued for the last encoded frame.
+    pub fn draw_call_count(&self) -> usize {
+        self.draw_calls.get()
+    }
+
+    /// Record GPU timestamps around the render pass of each frame, reported
+    /// in [`FrameProfile::gpu_pass_ms`]. Off by default.
+    pub fn set_profiling(&self, enabled: bool) {
+        self.profiling.set(enabled);
+    }
+
+    /// Counters and timings of the last [`Self::render_frame`].
+    pub fn last_frame_profile(&self) -> FrameProfile {
+        self.last_profile.get()
+    }
+
+    /// Geometry, atlas and instance bytes uploaded when the renderer was
+    /// built.
+    pub fn uploaded_bytes(&self) -> u64 {
+        self.uploaded_bytes
     }
 
     /// Reset every mesh to the identity pose.
@@ -1339,6 +1680,13 @@ impl GpuRenderer {
         self.grid.set(grid);
     }
 
+    /// Draw with this view-projection instead of the one fitted from the
+    /// camera and mesh bounds (`None` restores the fit). Used to render one
+    /// tile of a larger image; see [`super::camera::tile_view_proj`].
+    pub fn set_view_proj(&self, view_proj: Option<[[f32; 4]; 4]>) {
+        self.view_proj.set(view_proj);
+    }
+
     /// Replace world-space explanatory lines for the next frame.
     pub fn set_gizmos(&self, gizmos: &[crate::animation::GizmoLine]) {
         self.gizmos.replace(gizmos.to_vec());
@@ -1350,6 +1698,7 @@ impl GpuRenderer {
         })?;
         let render_target_view = self.render_target_view.as_ref().unwrap();
         let staging_buffer = self.staging_buffer.as_ref().unwrap();
+        let started = std::time::Instant::now();
 
         let mut encoder = self
             .device
@@ -1389,17 +1738,38 @@ impl GpuRenderer {
         );
 
         self.queue.submit(std::iter::once(encoder.finish()));
+        let submitted = std::time::Instant::now();
 
         let buffer_slice = staging_buffer.slice(..);
         let (sender, receiver) = std::sync::mpsc::channel();
         buffer_slice.map_async(wgpu::MapMode::Read, move |result| {
             sender.send(result).unwrap();
         });
+        let timer = self.timer.as_ref().filter(|_| self.profiling.get());
+        let timestamps = timer.map(|t| {
+            let (sender, receiver) = std::sync::mpsc::channel();
+            t.read
+                .slice(..)
+                .map_async(wgpu::MapMode::Read, move |result| {
+                    let _ = sender.send(result);
+                });
+            receiver
+        });
         let _ = self.device.poll(wgpu::PollType::wait_indefinitely());
         receiver
             .recv()
             .unwrap()
             .map_err(|e| RenderError::RenderFailed(format!("Failed to map buffer: {}", e)))?;
+        let mapped = std::time::Instant::now();
+        let gpu_pass_ms = timer.zip(timestamps).and_then(|(t, receiver)| {
+            receiver.try_recv().ok()?.ok()?;
+            let ticks = t.read.slice(..).get_mapped_range().ok().map(|data| {
+                let tick = |at: usize| u64::from_le_bytes(data[at..at + 8].try_into().unwrap());
+                tick(8).saturating_sub(tick(0))
+            });
+            t.read.unmap();
+            Some(ticks? as f64 * t.period_ns as f64 / 1e6)
+        });
 
         // wgpu 30: `get_mapped_range` is fallible.
         let data = buffer_slice
@@ -1416,9 +1786,249 @@ impl GpuRenderer {
 
         drop(data);
         staging_buffer.unmap();
+
+        let ms =
+            |from: std::time::Instant, to: std::time::Instant| (to - from).as_secs_f64() * 1000.0;
+        self.last_profile.set(FrameProfile {
+            encode_ms: ms(started, submitted),
+            gpu_wait_ms: ms(submitted, mapped),
+            readback_ms: mapped.elapsed().as_secs_f64() * 1000.0,
+            gpu_pass_ms,
+            draw_calls: self.draw_calls.get(),
+            triangles: self.triangles.get(),
+            bytes_read_back: (self.padded_bytes_per_row * self.height) as u64,
+        });
         Ok(pixels)
     }
 
+    /// Render several views of the same meshes and return their RGBA
+    /// pixels, in order. Headless mode only.
+    ///
+    /// Views are encoded back to back into one command encoder, each copied
+    /// into its slot of a shared readback buffer, and submitted together, so
+    /// the GPU runs them without a CPU round trip between views. Batches are
+    /// split only where the readback buffer would pass the device's buffer
+    /// size limit. Each view draws with its own grid; the renderer's grid is
+    /// restored afterwards.
+    pub fn render_frames(
+        &self,
+        views: &[(CameraConfig, Option<super::GridConfig>)],
+    ) -> Result<Vec<Vec<u8>>, RenderError> {
+        let render_target = self.render_target.as_ref().ok_or_else(|| {
+            RenderError::RenderFailed("render_frames requires headless mode".into())
+        })?;
+        let render_target_view = self.render_target_view.as_ref().unwrap();
+        let frame_bytes = self.padded_bytes_per_row as u64 * self.height as u64;
+        let per_batch = (self.device.limits().max_buffer_size / frame_bytes.max(1)).max(1) as usize;
+        let saved_grid = self.grid.get();
+
+        let mut frames = Vec::with_capacity(views.len());
+        for batch in views.chunks(per_batch) {
+            let staging = self.device.create_buffer(&wgpu::BufferDescriptor {
+                label: Some("batch_staging"),
+                size: frame_bytes * batch.len() as u64,
+                usage: wgpu::BufferUsages::COPY_DST | wgpu::BufferUsages::MAP_READ,
+                mapped_at_creation: false,
+            });
+            let mut encoder = self
+                .device
+                .create_command_encoder(&wgpu::CommandEncoderDescriptor {
+                    label: Some("batch_encoder"),
+                });
+            for (i, (camera, grid)) in batch.iter().enumerate() {
+                self.grid.set(*grid);
+                self.render_to_view(
+                    &mut encoder,
+                    render_target_view,
+                    &self.depth_view,
+                    camera,
+                    self.width,
+                    self.height,
+                );
+                encoder.copy_texture_to_buffer(
+                    wgpu::TexelCopyTextureInfo {
+                        texture: render_target,
+                        mip_level: 0,
+                        origin: wgpu::Origin3d::ZERO,
+                        aspect: wgpu::TextureAspect::All,
+                    },
+                    wgpu::TexelCopyBufferInfo {
+                        buffer: &staging,
+                        layout: wgpu::TexelCopyBufferLayout {
+                            offset: frame_bytes * i as u64,
+                            bytes_per_row: Some(self.padded_bytes_per_row),
+                            rows_per_image: Some(self.height),
+                        },
+                    },
+                    wgpu::Extent3d {
+                        width: self.width,
+                        height: self.height,
+                        depth_or_array_layers: 1,
+                    },
+                );
+            }
+            self.grid.set(saved_grid);
+            self.queue.submit(std::iter::once(encoder.finish()));
+
+            let slice = staging.slice(..);
+            let (sender, receiver) = std::sync::mpsc::channel();
+            slice.map_async(wgpu::MapMode::Read, move |result| {
+                sender.send(result).unwrap();
+            });
+            let _ = self.device.poll(wgpu::PollType::wait_indefinitely());
+            receiver
+                .recv()
+                .unwrap()
+                .map_err(|e| RenderError::RenderFailed(format!("Failed to map buffer: {}", e)))?;
+            let data = slice.get_mapped_range().map_err(|e| {
+                RenderError::RenderFailed(format!("Failed to read mapped buffer: {e}"))
+            })?;
+            let row_bytes = 4 * self.width as usize;
+            for i in 0..batch.len() {
+                let frame = &data[i * frame_bytes as usize..];
+                let mut pixels = Vec::with_capacity(row_bytes * self.height as usize);
+                for row in frame
+                    .chunks(self.padded_bytes_per_row as usize)
+                    .take(self.height as usize)
+                {
+                    pixels.extend_from_slice(&row[..row_bytes]);
+                }
+                frames.push(pixels);
+            }
+            drop(data);
+            staging.unmap();
+        }
+        Ok(frames)
+    }
+
+    /// Render `frame_count` frames and hand each one's RGBA pixels to
+    /// `consume`, in order, while later frames are still on the GPU.
+    /// Headless mode only.
+    ///
+    /// Readback cycles through a ring of `ring` staging buffers. Frame *i* is
+    /// submitted and its buffer mapped asynchronously; `consume` only waits
+    /// for frame *i − ring + 1*, so the GPU keeps rendering while the caller
+    /// writes a finished frame out. `prepare(i)` runs just before frame *i* is
+    /// encoded and may set poses, gizmos or the grid for it.
+    ///
+    /// When rows need no padding `consume` reads straight from the mapped
+    /// buffer; otherwise the rows are packed into one scratch buffer reused
+    /// for every frame.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn render_stream(
+        &self,
+        frame_count: usize,
+        ring: usize,
+        mut prepare: impl FnMut(usize) -> Result<CameraConfig, RenderError>,
+        mut consume: impl FnMut(usize, &[u8]) -> Result<(), RenderError>,
+    ) -> Result<(), RenderError> {
+        type Pending = (
+            usize,
+            wgpu::SubmissionIndex,
+            std::sync::mpsc::Receiver<Result<(), wgpu::BufferAsyncError>>,
+        );
+
+        let render_target = self.render_target.as_ref().ok_or_else(|| {
+            RenderError::RenderFailed("render_stream requires headless mode".into())
+        })?;
+        let render_target_view = self.render_target_view.as_ref().unwrap();
+        let frame_bytes = self.padded_bytes_per_row as u64 * self.height as u64;
+        let row_bytes = 4 * self.width as usize;
+        let slots: Vec<wgpu::Buffer> = (0..ring.max(1).min(frame_count))
+            .map(|_| {
+                self.device.create_buffer(&wgpu::BufferDescriptor {
+                    label: Some("stream_staging"),
+                    size: frame_bytes,
+                    usage: wgpu::BufferUsages::COPY_DST | wgpu::BufferUsages::MAP_READ,
+                    mapped_at_creation: false,
+                })
+            })
+            .collect();
+        let mut scratch = Vec::new();
+
+        let mut read_back = |(index, submission, receiver): Pending| -> Result<(), RenderError> {
+            let _ = self.device.poll(wgpu::PollType::Wait {
+                submission_index: Some(submission),
+                timeout: None,
+            });
+            receiver
+                .recv()
+                .unwrap()
+                .map_err(|e| RenderError::RenderFailed(format!("Failed to map buffer: {}", e)))?;
+            let staging = &slots[index % slots.len()];
+            let data = staging.slice(..).get_mapped_range().map_err(|e| {
+                RenderError::RenderFailed(format!("Failed to read mapped buffer: {e}"))
+            })?;
+            let result = if self.padded_bytes_per_row as usize == row_bytes {
+                consume(index, &data)
+            } else {
+                scratch.clear();
+                for row in data.chunks(self.padded_bytes_per_row as usize) {
+                    scratch.extend_from_slice(&row[..row_bytes]);
+                }
+                consume(index, &scratch)
+            };
+            drop(data);
+            staging.unmap();
+            result
+        };
+
+        let mut pending: std::collections::VecDeque<Pending> = Default::default();
+        for index in 0..frame_count {
+            if pending.len() == slots.len() {
+                read_back(pending.pop_front().unwrap())?;
+            }
+            let camera = prepare(index)?;
+            let staging = &slots[index % slots.len()];
+            let mut encoder = self
+                .device
+                .create_command_encoder(&wgpu::CommandEncoderDescriptor {
+                    label: Some("stream_encoder"),
+                });
+            self.render_to_view(
+                &mut encoder,
+                render_target_view,
+                &self.depth_view,
+                &camera,
+                self.width,
+                self.height,
+            );
+            encoder.copy_texture_to_buffer(
+                wgpu::TexelCopyTextureInfo {
+                    texture: render_target,
+                    mip_level: 0,
+                    origin: wgpu::Origin3d::ZERO,
+                    aspect: wgpu::TextureAspect::All,
+                },
+                wgpu::TexelCopyBufferInfo {
+                    buffer: staging,
+                    layout: wgpu::TexelCopyBufferLayout {
+                        offset: 0,
+                        bytes_per_row: Some(self.padded_bytes_per_row),
+                        rows_per_image: Some(self.height),
+                    },
+                },
+                wgpu::Extent3d {
+                    width: self.width,
+                    height: self.height,
+                    depth_or_array_layers: 1,
+                },
+            );
+            let submission = self.queue.submit(std::iter::once(encoder.finish()));
+            let (sender, receiver) = std::sync::mpsc::channel();
+            staging
+                .slice(..)
+                .map_async(wgpu::MapMode::Read, move |result| {
+                    let _ = sender.send(result);
+                });
+            pending.push_back((index, submission, receiver));
+        }
+        while let Some(frame) = pending.pop_front() {
+            read_back(frame)?;
+        }
+        Ok(())
+    }
+
     /// Recreate the depth texture for a new window size.
     pub fn recreate_depth(&mut self, width: u32, height: u32) {
         self.width = width;
@@ -1440,6 +2050,41 @@ impl GpuRenderer {
         self.depth_view = depth_texture.create_view(&wgpu::TextureViewDescriptor::default());
     }
 
+    /// Resize a headless renderer's colour target, readback buffer and depth
+    /// texture, keeping the device, pipelines and uploaded meshes. No-op in
+    /// windowed mode, where the surface owns the colour target.
+    pub fn resize_headless(&mut self, width: u32, height: u32) {
+        if self.render_target.is_none() || (width, height) == (self.width, self.height) {
+            return;
+        }
+        let rt = self.device.create_texture(&wgpu::TextureDescriptor {
+            label: Some("render_target"),
+            size: wgpu::Extent3d {
+                width,
+                height,
+                depth_or_array_layers: 1,
+            },
+            mip_level_count: 1,
+            sample_count: 1,
+            dimension: wgpu::TextureDimension::D2,
+            format: self.color_format,
+            usage: wgpu::TextureUsages::RENDER_ATTACHMENT | wgpu::TextureUsages::COPY_SRC,
+            view_formats: &[],
+        });
+        self.render_target_view = Some(rt.create_view(&wgpu::TextureViewDescriptor::default()));
+        self.render_target = Some(rt);
+
+        let align = wgpu::COPY_BYTES_PER_ROW_ALIGNMENT;
+        self.padded_bytes_per_row = (4 * width).div_ceil(align) * align;
+        self.staging_buffer = Some(self.device.create_buffer(&wgpu::BufferDescriptor {
+            label: Some("staging"),
+            size: (self.padded_bytes_per_row * height) as u64,
+            usage: wgpu::BufferUsages::COPY_DST | wgpu::BufferUsages::MAP_READ,
+            mapped_at_creation: false,
+        }));
+        self.recreate_depth(width, height);
+    }
+
     /// Capture a screenshot from the current camera. Works in any mode.
     pub fn screenshot(&self, camera: &CameraConfig) -> Result<Vec<u8>, RenderError> {
         let tex = self.device.create_texture(&wgpu::TextureDescriptor {
@@ -1580,3 +2225,64 @@ mod clear_color_tests {
         assert!((c.a - 1.0).abs() < 1e-6);
     }
 }
+
+#[cfg(test)]
+mod instancing_tests {
+    use super::*;
+    use schematic_mesher::{BoundingBox, TextureAtlas};
+
+    fn cube_at(offset: [f32; 3], pixel: u8) -> MeshOutput {
+        let corners = [[0.0, 0.0, 0.0], [1.0, 0.0, 0.0], [1.0, 1.0, 0.0]];
+        let positions: Vec<[f32; 3]> = corners
+            .iter()
+            .map(|c| [c[0] + offset[0], c[1] + offset[1], c[2] + offset[2]])
+            .collect();
+        let max = [offset[0] + 1.0, offset[1] + 1.0, offset[2]];
+        MeshOutput {
+            opaque: MeshLayer {
+                positions,
+                normals: vec![[0.0, 0.0, 1.0]; 3],
+                uvs: vec![[0.0, 0.0]; 3],
+                colors: vec![[1.0; 4]; 3],
+                indices: vec![0, 1, 2],
+            },
+            cutout: MeshLayer::default(),
+            transparent: MeshLayer::default(),
+            atlas: TextureAtlas {
+                width: 1,
+                height: 1,
+                pixels: vec![pixel; 4],
+                regions: HashMap::new(),
+            },
+            greedy_materials: Vec::new(),
+            animated_textures: Vec::new(),
+            bounds: BoundingBox::new(offset, max),
+            chunk_coord: None,
+            lod_level: 0,
+        }
+    }
+
+    #[test]
+    fn translated_copies_share_geometry() {
+        let meshes = [
+            cube_at([0.0, 0.0, 0.0], 7),
+            cube_at([16.0, 0.0, -32.0], 7),
+            cube_at([0.0, 0.0, 0.0], 9),
+            cube_at([48.0, 64.0, 0.0], 7),
+        ];
+        let (geometry, count) = dedupe_meshes(&meshes);
+        assert_eq!(count, 2);
+        assert_eq!(geometry, vec![0, 0, 1, 0]);
+    }
+
+    #[test]
+    fn placement_restores_world_positions() {
+        let origin = [16.0, -3.0, 48.0];
+        let model = DrawUniforms::identity().placed(origin).model;
+        let local = [0.5f32, 1.0, 0.25];
+        for row in 0..3 {
+            let world: f32 = (0..3).map(|c| model[c][row] * local[c]).sum::<f32>() + model[3][row];
+            assert_eq!(world, local[row] + origin[row]);
+        }
+    }
+}
@@ -1,13 +1,151 @@
-//! HDRI environment map loading.
+//! HDRI environment map loading, prefiltering and caching.
+//!
+//! Decoding a large HDR image dominates renderer start-up, and a service
+//! renders with the same few environments over and over. Loaded maps carry a
+//! small prefiltered diffuse irradiance map, and can be kept in an
+//! in-process cache keyed by the source's hash ([`load_hdri_cached`]) or
+//! written to a binary cache file ([`HdriData::to_cache_bytes`]).
+//!
+//! Cache layout (little-endian):
+//!
+//! ```text
+//! magic "NUCH" | version u32 = 1 | source_hash [u8; 32]
+//! | width u32 | height u32 | pixels f32 × width·height·4
+//! | irradiance_width u32 | irradiance_height u32 | irradiance f32 × w·h·4
+//! ```
+
+use std::collections::HashMap;
+use std::sync::{Arc, Mutex, OnceLock};
+
+use rayon::prelude::*;
 
 use super::RenderError;
 
+/// Size of the prefiltered irradiance map. Diffuse lighting varies slowly
+/// over directions, so a small equirectangular map holds all of it.
+pub const IRRADIANCE_WIDTH: u32 = 32;
+pub const IRRADIANCE_HEIGHT: u32 = 16;
+
+/// Resolution the environment is box-filtered to before convolution.
+const SOURCE_WIDTH: usize = 64;
+const SOURCE_HEIGHT: usize = 32;
+
+const MAGIC: &[u8; 4] = b"NUCH";
+const VERSION: u32 = 1;
+
 /// HDRI environment map data (RGBA f32 pixels).
 pub struct HdriData {
     pub width: u32,
     pub height: u32,
     /// RGBA f32 pixel data (4 floats per pixel)
     pub pixels_rgba32f: Vec<f32>,
+    /// Cosine-convolved diffuse irradiance over π, as an equirectangular
+    /// `IRRADIANCE_WIDTH × IRRADIANCE_HEIGHT` RGBA f32 map, so a uniform
+    /// environment keeps its radiance. Empty until [`HdriData::prefilter`].
+    pub irradiance_rgba32f: Vec<f32>,
+    /// blake3 hash of the encoded source image, or zero if unknown.
+    pub source_hash: [u8; 32],
+}
+
+impl HdriData {
+    /// Compute the irradiance map if it is missing.
+    pub fn prefilter(&mut self) {
+        if self.irradiance_rgba32f.is_empty() {
+            self.irradiance_rgba32f =
+                convolve_irradiance(self.width, self.height, &self.pixels_rgba32f);
+        }
+    }
+
+    /// Serialize the map and its irradiance to the binary cache format.
+    /// Prefilter first, or the irradiance is stored empty.
+    pub fn to_cache_bytes(&self) -> Vec<u8> {
+        let floats = self.pixels_rgba32f.len() + self.irradiance_rgba32f.len();
+        let mut buf = Vec::with_capacity(60 + floats * 4);
+        buf.extend_from_slice(MAGIC);
+        buf.extend_from_slice(&VERSION.to_le_bytes());
+        buf.extend_from_slice(&self.source_hash);
+        let (irradiance_width, irradiance_height) = if self.irradiance_rgba32f.is_empty() {
+            (0, 0)
+        } else {
+            (IRRADIANCE_WIDTH, IRRADIANCE_HEIGHT)
+        };
+        for (width, height, pixels) in [
+            (self.width, self.height, &self.pixels_rgba32f),
+            (
+                irradiance_width,
+                irradiance_height,
+                &self.irradiance_rgba32f,
+            ),
+        ] {
+            buf.extend_from_slice(&width.to_le_bytes());
+            buf.extend_from_slice(&height.to_le_bytes());
+            for value in pixels {
+                buf.extend_from_slice(&value.to_le_bytes());
+            }
+        }
+        buf
+    }
+
+    /// Read a map written by [`HdriData::to_cache_bytes`]. A map stored
+    /// without irradiance is prefiltered on load.
+    pub fn from_cache_bytes(data: &[u8]) -> Result<Self, RenderError> {
+        let mut rest = data;
+        if take(&mut rest, 4)? != MAGIC {
+            return Err(invalid_cache("bad magic"));
+        }
+        let version = take_u32(&mut rest)?;
+        if version != VERSION {
+            return Err(invalid_cache(&format!("unsupported version {version}")));
+        }
+        let source_hash: [u8; 32] = take(&mut rest, 32)?.try_into().unwrap();
+        let (width, height, pixels_rgba32f) = take_image(&mut rest)?;
+        let (irradiance_width, irradiance_height, irradiance_rgba32f) = take_image(&mut rest)?;
+        if !irradiance_rgba32f.is_empty()
+            && (irradiance_width, irradiance_height) != (IRRADIANCE_WIDTH, IRRADIANCE_HEIGHT)
+        {
+            return Err(invalid_cache("irradiance map size"));
+        }
+        let mut hdri = HdriData {
+            width,
+            height,
+            pixels_rgba32f,
+            irradiance_rgba32f,
+            source_hash,
+        };
+        hdri.prefilter();
+        Ok(hdri)
+    }
+}
+
+fn invalid_cache(what: &str) -> RenderError {
+    RenderError::RenderFailed(format!("invalid HDRI cache: {what}"))
+}
+
+fn take<'a>(rest: &mut &'a [u8], len: usize) -> Result<&'a [u8], RenderError> {
+    if rest.len() < len {
+        return Err(invalid_cache("truncated"));
+    }
+    let (head, tail) = rest.split_at(len);
+    *rest = tail;
+    Ok(head)
+}
+
+fn take_u32(rest: &mut &[u8]) -> Result<u32, RenderError> {
+    Ok(u32::from_le_bytes(take(rest, 4)?.try_into().unwrap()))
+}
+
+fn take_image(rest: &mut &[u8]) -> Result<(u32, u32, Vec<f32>), RenderError> {
+    let width = take_u32(rest)?;
+    let height = take_u32(rest)?;
+    let len = (width as usize)
+        .checked_mul(height as usize)
+        .and_then(|n| n.checked_mul(16))
+        .ok_or_else(|| invalid_cache("dimensions overflow"))?;
+    let pixels = take(rest, len)?
+        .chunks_exact(4)
+        .map(|b| f32::from_le_bytes(b.try_into().unwrap()))
+        .collect();
+    Ok((width, height, pixels))
 }
 
 /// Load an HDRI environment map from a file path.
@@ -17,7 +155,7 @@ pub fn load_hdri(path: &str) -> Result<HdriData, RenderError> {
     load_hdri_from_bytes(&data)
 }
 
-/// Load an HDRI environment map from bytes.
+/// Load an HDRI environment map from bytes and prefilter it.
 pub fn load_hdri_from_bytes(data: &[u8]) -> Result<HdriData, RenderError> {
     let img = image::load_from_memory(data)
         .map_err(|e| RenderError::RenderFailed(format!("Failed to load HDRI: {}", e)))?;
@@ -33,9 +171,208 @@ pub fn load_hdri_from_bytes(data: &[u8]) -> Result<HdriData, RenderError> {
         rgba.push(1.0);
     }
 
-    Ok(HdriData {
+    let mut hdri = HdriData {
         width: w,
         height: h,
         pixels_rgba32f: rgba,
-    })
+        irradiance_rgba32f: Vec::new(),
+        source_hash: *blake3::hash(data).as_bytes(),
+    };
+    hdri.prefilter();
+    Ok(hdri)
+}
+
+fn loaded() -> &'static Mutex<HashMap<[u8; 32], Arc<HdriData>>> {
+    static LOADED: OnceLock<Mutex<HashMap<[u8; 32], Arc<HdriData>>>> = OnceLock::new();
+    LOADED.get_or_init(Default::default)
+}
+
+/// [`load_hdri_from_bytes`] through an in-process cache keyed by the hash of
+/// `data`: each distinct image is decoded and prefiltered once per process.
+pub fn load_hdri_cached(data: &[u8]) -> Result<Arc<HdriData>, RenderError> {
+    let key = *blake3::hash(data).as_bytes();
+    if let Some(hdri) = loaded().lock().ok().and_then(|m| m.get(&key).cloned()) {
+        return Ok(hdri);
+    }
+    let hdri = Arc::new(load_hdri_from_bytes(data)?);
+    if let Ok(mut map) = loaded().lock() {
+        return Ok(Arc::clone(map.entry(key).or_insert(hdri)));
+    }
+    Ok(hdri)
+}
+
+/// Load the HDRI at `path` through the in-process cache and a binary cache
+/// file in `cache_dir` (named by the source's hash). A missing or unreadable
+/// cache file is rebuilt from the source; failing to write one is ignored.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn load_hdri_with_cache_dir(
+    path: &str,
+    cache_dir: &std::path::Path,
+) -> Result<Arc<HdriData>, RenderError> {
+    let data = std::fs::read(path).map_err(RenderError::Io)?;
+    let key = *blake3::hash(&data).as_bytes();
+    if let Some(hdri) = loaded().lock().ok().and_then(|m| m.get(&key).cloned()) {
+        return Ok(hdri);
+    }
+    let hex: String = key.iter().map(|b| format!("{b:02x}")).collect();
+    let cache_path = cache_dir.join(format!("{hex}.nuch"));
+    let cached = std::fs::read(&cache_path)
+        .ok()
+        .and_then(|bytes| HdriData::from_cache_bytes(&bytes).ok())
+        .filter(|hdri| hdri.source_hash == key);
+    let hdri = match cached {
+        Some(hdri) => hdri,
+        None => {
+            let hdri = load_hdri_from_bytes(&data)?;
+            let tmp = cache_dir.join(format!("{hex}.nuch.{}.tmp", std::process::id()));
+            if std::fs::create_dir_all(cache_dir).is_ok()
+                && std::fs::write(&tmp, hdri.to_cache_bytes()).is_ok()
+                && std::fs::rename(&tmp, &cache_path).is_err()
+            {
+                let _ = std::fs::remove_file(&tmp);
+            }
+            hdri
+        }
+    };
+    let hdri = Arc::new(hdri);
+    if let Ok(mut map) = loaded().lock() {
+        return Ok(Arc::clone(map.entry(key).or_insert(hdri)));
+    }
+    Ok(hdri)
+}
+
+/// World direction of the centre of equirectangular texel `(x, y)`, using
+/// the shader's mapping (`u = atan2(z, x) / 2π + ½`, `v = acos(y) / π`).
+fn texel_direction(x: usize, y: usize, width: usize, height: usize) -> [f32; 3] {
+    let phi = ((x as f32 + 0.5) / width as f32 - 0.5) * std::f32::consts::TAU;
+    let theta = (y as f32 + 0.5) / height as f32 * std::f32::consts::PI;
+    [
+        theta.sin() * phi.cos(),
+        theta.cos(),
+        theta.sin() * phi.sin(),
+    ]
+}
+
+/// Box-filter the map to `SOURCE_WIDTH × SOURCE_HEIGHT`, then integrate
+/// `L·max(0, n·ω) dω / π` over it for every output texel direction `n`.
+pub(super) fn convolve_irradiance(width: u32, height: u32, pixels: &[f32]) -> Vec<f32> {
+    let (width, height) = (width as usize, height as usize);
+    let mut sums = vec![[0.0f32; 3]; SOURCE_WIDTH * SOURCE_HEIGHT];
+    let mut counts = vec![0u32; SOURCE_WIDTH * SOURCE_HEIGHT];
+    for y in 0..height {
+        let sy = y * SOURCE_HEIGHT / height.max(1);
+        for x in 0..width {
+            let cell = sy * SOURCE_WIDTH + x * SOURCE_WIDTH / width.max(1);
+            let p = &pixels[(y * width + x) * 4..][..3];
+            for c in 0..3 {
+                sums[cell][c] += p[c];
+            }
+            counts[cell] += 1;
+        }
+    }
+
+    // (direction, radiance × solid angle) per filtered texel.
+    let texel_area =
+        std::f32::consts::TAU / SOURCE_WIDTH as f32 * std::f32::consts::PI / SOURCE_HEIGHT as f32;
+    let samples: Vec<([f32; 3], [f32; 3])> = (0..SOURCE_WIDTH * SOURCE_HEIGHT)
+        .filter(|&i| counts[i] > 0)
+        .map(|i| {
+            let (x, y) = (i % SOURCE_WIDTH, i / SOURCE_WIDTH);
+            let dir = texel_direction(x, y, SOURCE_WIDTH, SOURCE_HEIGHT);
+            let weight = texel_area * (1.0 - dir[1] * dir[1]).max(0.0).sqrt() / counts[i] as f32;
+            (dir, sums[i].map(|v| v * weight))
+        })
+        .collect();
+
+    let (out_w, out_h) = (IRRADIANCE_WIDTH as usize, IRRADIANCE_HEIGHT as usize);
+    (0..out_w * out_h)
+        .into_par_iter()
+        .flat_map_iter(|i| {
+            let n = texel_direction(i % out_w, i / out_w, out_w, out_h);
+            let mut e = [0.0f32; 3];
+            for (dir, radiance) in &samples {
+                let cos = n[0] * dir[0] + n[1] * dir[1] + n[2] * dir[2];
+                if cos > 0.0 {
+                    for c in 0..3 {
+                        e[c] += radiance[c] * cos;
+                    }
+                }
+            }
+            let inv_pi = std::f32::consts::FRAC_1_PI;
+            [e[0] * inv_pi, e[1] * inv_pi, e[2] * inv_pi, 1.0]
+        })
+        .collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn uniform(width: u32, height: u32, value: f32) -> HdriData {
+        HdriData {
+            width,
+            height,
+            pixels_rgba32f: [value, value, value, 1.0].repeat((width * height) as usize),
+            irradiance_rgba32f: Vec::new(),
+            source_hash: [0; 32],
+        }
+    }
+
+    #[test]
+    fn uniform_environment_keeps_its_radiance() {
+        let mut hdri = uniform(128, 64, 2.0);
+        hdri.prefilter();
+        assert_eq!(
+            hdri.irradiance_rgba32f.len(),
+            (IRRADIANCE_WIDTH * IRRADIANCE_HEIGHT * 4) as usize
+        );
+        for texel in hdri.irradiance_rgba32f.chunks_exact(4) {
+            assert!((texel[0] - 2.0).abs() < 0.05, "{texel:?}");
+        }
+    }
+
+    #[test]
+    fn sky_lights_upward_normals_more_than_downward() {
+        // Bright upper hemisphere, black lower one.
+        let mut hdri = uniform(64, 32, 0.0);
+        for y in 0..16 {
+            for x in 0..64 {
+                hdri.pixels_rgba32f[(y * 64 + x) * 4..][..3].copy_from_slice(&[1.0; 3]);
+            }
+        }
+        hdri.prefilter();
+        let row = |y: usize| hdri.irradiance_rgba32f[y * IRRADIANCE_WIDTH as usize * 4];
+        assert!(row(0) > 0.9, "top {}", row(0));
+        assert!(row(IRRADIANCE_HEIGHT as usize - 1) < 0.1);
+    }
+
+    #[test]
+    fn cache_bytes_round_trip_and_reject_damage() {
+        let mut hdri = uniform(4, 2, 0.5);
+        hdri.source_hash = [7; 32];
+        hdri.prefilter();
+        let bytes = hdri.to_cache_bytes();
+        let loaded = HdriData::from_cache_bytes(&bytes).unwrap();
+        assert_eq!((loaded.width, loaded.height), (4, 2));
+        assert_eq!(loaded.pixels_rgba32f, hdri.pixels_rgba32f);
+        assert_eq!(loaded.irradiance_rgba32f, hdri.irradiance_rgba32f);
+        assert_eq!(loaded.source_hash, [7; 32]);
+        assert!(HdriData::from_cache_bytes(&bytes[..bytes.len() - 1]).is_err());
+        assert!(HdriData::from_cache_bytes(b"NUCM").is_err());
+    }
+
+    #[test]
+    fn in_process_cache_decodes_each_image_once() {
+        let image = image::Rgb32FImage::from_pixel(4, 2, image::Rgb([0.25, 0.5, 1.0]));
+        let mut encoded = std::io::Cursor::new(Vec::new());
+        image::DynamicImage::ImageRgb32F(image)
+            .write_to(&mut encoded, image::ImageFormat::OpenExr)
+            .unwrap();
+        let encoded = encoded.into_inner();
+        let first = load_hdri_cached(&encoded).unwrap();
+        let second = load_hdri_cached(&encoded).unwrap();
+        assert!(Arc::ptr_eq(&first, &second));
+        assert_eq!(first.pixels_rgba32f[..4], [0.25, 0.5, 1.0, 1.0]);
+        assert!(!first.irradiance_rgba32f.is_empty());
+    }
 }
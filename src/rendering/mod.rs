@@ -14,14 +14,22 @@ pub mod camera;
 pub mod gpu;
 pub mod hdri;
 #[cfg(not(target_arch = "wasm32"))]
+pub mod pool;
+#[cfg(not(target_arch = "wasm32"))]
+pub mod tiles;
+#[cfg(not(target_arch = "wasm32"))]
 pub mod video;
 
+#[cfg(not(target_arch = "wasm32"))]
+pub use pool::{RenderContext, RenderPool, RenderPoolStats, RenderTicket};
+#[cfg(not(target_arch = "wasm32"))]
+pub use tiles::{render_tile_pyramid, render_tiles, Tile};
 #[cfg(not(target_arch = "wasm32"))]
 pub use video::{VideoCodec, VideoConfig};
 
 pub use camera::CameraConfig;
 pub use camera::Projection;
-pub use gpu::GpuRenderer;
+pub use gpu::{FrameProfile, GpuRenderer};
 pub use hdri::HdriData;
 
 use crate::meshing::MeshOutput;
@@ -62,6 +70,61 @@ impl Default for GridConfig {
     }
 }
 
+/// zlib effort for PNG output. `Fast` trades file size for encode time,
+/// which dominates per-thumbnail latency at large sizes.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum PngCompression {
+    #[default]
+    Default,
+    Fast,
+    Best,
+}
+
+/// PNG row filter. `Adaptive` picks per row and compresses best; a fixed
+/// filter (or none) is cheaper to encode.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum PngFilter {
+    NoFilter,
+    Sub,
+    Up,
+    Avg,
+    Paeth,
+    #[default]
+    Adaptive,
+}
+
+/// Image format produced by the encoding entry points ([`encode_image`],
+/// [`render_meshes_png`], [`RenderSession::render_png`], ...).
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum ImageFormat {
+    Png {
+        compression: PngCompression,
+        filter: PngFilter,
+    },
+    /// QOI: lossless, several times faster to encode than PNG, somewhat
+    /// larger output.
+    Qoi,
+}
+
+impl ImageFormat {
+    /// File extension, without the dot.
+    pub fn extension(&self) -> &'static str {
+        match self {
+            Self::Png { .. } => "png",
+            Self::Qoi => "qoi",
+        }
+    }
+}
+
+impl Default for ImageFormat {
+    fn default() -> Self {
+        Self::Png {
+            compression: PngCompression::Default,
+            filter: PngFilter::Adaptive,
+        }
+    }
+}
+
 /// Render configuration.
 #[derive(Clone)]
 pub struct RenderConfig {
@@ -93,6 +156,9 @@ pub struct RenderConfig {
     pub directional_intensity: f32,
     /// Unlit floor for non-HDRI rendering, in `0..=1`.
     pub ambient_light: f32,
+    /// Encoding of image output. Default: PNG with the `image` crate's
+    /// default compression and adaptive filtering.
+    pub format: ImageFormat,
 }
 
 impl Default for RenderConfig {
@@ -112,6 +178,7 @@ impl Default for RenderConfig {
             light_direction: [0.3, 1.0, 0.5],
             directional_intensity: 1.0,
             ambient_light: 0.4,
+            format: ImageFormat::default(),
         }
     }
 }
@@ -246,13 +313,41 @@ pub async fn render_meshes_async(
 ///
 /// Frame times come from [`crate::animation::Timeline::frame_times`], so the
 /// output is deterministic and regenerating it is byte-identical.
+///
+/// Frames are read back through a ring of [`READBACK_RING`] staging buffers
+/// (see [`GpuRenderer::render_stream`]): while `consume` handles frame *i*,
+/// the following frames are already rendering.
 #[cfg(not(target_arch = "wasm32"))]
 pub fn render_animation_stream(
     meshes: &[MeshOutput],
     frames: &[crate::animation::Frame],
     config: &RenderConfig,
     hdri: Option<&HdriData>,
-    mut consume: impl FnMut(usize, &[u8]) -> Result<(), RenderError>,
+    consume: impl FnMut(usize, &[u8]) -> Result<(), RenderError>,
+) -> Result<(), RenderError> {
+    render_animation_source(
+        meshes,
+        frames.len(),
+        |index| std::borrow::Cow::Borrowed(&frames[index]),
+        config,
+        hdri,
+        consume,
+    )
+}
+
+/// [`render_animation_stream`] over frames produced on demand.
+///
+/// `frame_at(i)` is called once per frame, in order, just before frame *i* is
+/// encoded, so a long capture never holds all of its frames, and sampling the
+/// next frame overlaps the GPU work of the ones still in the readback ring.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn render_animation_source<'a>(
+    meshes: &[MeshOutput],
+    frame_count: usize,
+    mut frame_at: impl FnMut(usize) -> std::borrow::Cow<'a, crate::animation::Frame>,
+    config: &RenderConfig,
+    hdri: Option<&HdriData>,
+    consume: impl FnMut(usize, &[u8]) -> Result<(), RenderError>,
 ) -> Result<(), RenderError> {
     pollster::block_on(async {
         let renderer = GpuRenderer::new(meshes, config.width, config.height, hdri).await?;
@@ -260,7 +355,8 @@ pub fn render_animation_stream(
         let base = config.to_camera();
         let mut poses = vec![crate::animation::Pose::IDENTITY; meshes.len()];
 
-        for (index, frame) in frames.iter().enumerate() {
+        let prepare = |index: usize| -> Result<CameraConfig, RenderError> {
+            let frame = frame_at(index);
             poses
                 .iter_mut()
                 .for_each(|pose| *pose = crate::animation::Pose::IDENTITY);
@@ -272,7 +368,7 @@ pub fn render_animation_stream(
             renderer.set_poses(&poses);
             renderer.set_gizmos(&frame.gizmos);
 
-            let camera = match &frame.camera {
+            Ok(match &frame.camera {
                 Some(camera_pose) => {
                     let mut frame_config = config.clone();
                     frame_config.yaw += camera_pose.yaw;
@@ -281,14 +377,18 @@ pub fn render_animation_stream(
                     frame_config.to_camera()
                 }
                 None => base.clone(),
-            };
-            let pixels = renderer.render_frame(&camera)?;
-            consume(index, &pixels)?;
-        }
-        Ok(())
+            })
+        };
+        renderer.render_stream(frame_count, READBACK_RING, prepare, consume)
     })
 }
 
+/// Staging buffers in flight while streaming animation frames back from the
+/// GPU. Three keeps one frame rendering, one reading back and one being
+/// consumed.
+#[cfg(not(target_arch = "wasm32"))]
+pub const READBACK_RING: usize = 3;
+
 #[cfg(not(target_arch = "wasm32"))]
 pub fn render_animation(
     meshes: &[MeshOutput],
@@ -304,7 +404,8 @@ pub fn render_animation(
     Ok(output)
 }
 
-/// Render an animation straight to numbered PNG files (`{prefix}{i:04}.png`).
+/// Render an animation straight to numbered PNG files (`{prefix}{i:04}.png`),
+/// or files of another `config.format` with its extension.
 ///
 /// The naming matches what `ffmpeg -i 'f%04d.png'` expects, which is how the
 /// README media pipeline assembles GIFs.
@@ -318,8 +419,8 @@ pub fn render_animation_to_files(
 ) -> Result<Vec<String>, RenderError> {
     let mut paths = Vec::with_capacity(frames.len());
     render_animation_stream(meshes, frames, config, hdri, |index, pixels| {
-        let path = format!("{prefix}{index:04}.png");
-        let png = encode_png(pixels, config.width, config.height)?;
+        let path = format!("{prefix}{index:04}.{}", config.format.extension());
+        let png = encode_image(pixels, config.width, config.height, config.format)?;
         std::fs::write(&path, &png).map_err(RenderError::Io)?;
         paths.push(path);
         Ok(())
@@ -384,25 +485,164 @@ pub fn render_meshes(
     pollster::block_on(render_meshes_async(meshes, config, hdri))
 }
 
-/// Render meshes to PNG bytes (synchronous, native only).
+/// Render meshes to image bytes in `config.format` — PNG unless another
+/// format is selected (synchronous, native only).
+///
+/// With `NUCLEATION_RENDER_PROFILE` set, prints the [`RenderStats`] of each
+/// call to stderr as JSON.
 #[cfg(not(target_arch = "wasm32"))]
 pub fn render_meshes_png(
     meshes: &[MeshOutput],
     config: &RenderConfig,
     hdri: Option<&HdriData>,
 ) -> Result<Vec<u8>, RenderError> {
+    if std::env::var("NUCLEATION_RENDER_PROFILE").is_ok() {
+        let (image, stats) = render_meshes_png_profiled(meshes, config, hdri)?;
+        eprintln!("PROFILE\trender\t{}", stats.to_json());
+        return Ok(image);
+    }
     let pixels = render_meshes(meshes, config, hdri)?;
-    encode_png(&pixels, config.width, config.height)
+    encode_image(&pixels, config.width, config.height, config.format)
+}
+
+/// Where the time and bytes of one render went. Times are in milliseconds.
+#[derive(Clone, Debug, Default, serde::Serialize)]
+pub struct RenderStats {
+    /// Meshing, when the caller meshed as part of the request.
+    pub mesh_ms: f64,
+    /// Adapter and device creation.
+    pub device_ms: f64,
+    /// Pipeline creation and geometry/atlas upload.
+    pub upload_ms: f64,
+    /// CPU time encoding and submitting the frame.
+    pub encode_ms: f64,
+    /// Submission until the pixels were mappable (GPU work and transfer).
+    pub gpu_wait_ms: f64,
+    /// Render pass time from GPU timestamps; `None` where the device has no
+    /// timestamp queries.
+    pub gpu_pass_ms: Option<f64>,
+    pub readback_ms: f64,
+    /// Image encoding in `config.format`.
+    pub image_encode_ms: f64,
+    pub total_ms: f64,
+    pub bytes_uploaded: u64,
+    pub bytes_read_back: u64,
+    pub meshes: usize,
+    /// Distinct geometries after instancing translated copies.
+    pub unique_meshes: usize,
+    pub draw_calls: usize,
+    pub triangles: u64,
+}
+
+impl RenderStats {
+    pub fn to_json(&self) -> String {
+        serde_json::to_string(self).unwrap_or_default()
+    }
+}
+
+/// [`render_meshes_png`] with GPU timestamps on, returning the image and
+/// where its time went. `mesh_ms` is left for the caller to fill in.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn render_meshes_png_profiled(
+    meshes: &[MeshOutput],
+    config: &RenderConfig,
+    hdri: Option<&HdriData>,
+) -> Result<(Vec<u8>, RenderStats), RenderError> {
+    use std::time::Instant;
+    let ms = |since: Instant| since.elapsed().as_secs_f64() * 1000.0;
+
+    let started = Instant::now();
+    let (_, device, queue) = pollster::block_on(gpu::open_device(&gpu::headless_instance(), None))?;
+    let device_ms = ms(started);
+
+    let uploading = Instant::now();
+    let renderer =
+        GpuRenderer::with_device(meshes, config.width, config.height, hdri, device, queue);
+    let upload_ms = ms(uploading);
+
+    renderer.set_grid(config.grid);
+    renderer.set_profiling(true);
+    let pixels = renderer.render_frame(&config.to_camera())?;
+    let frame = renderer.last_frame_profile();
+
+    let encoding = Instant::now();
+    let image = encode_image(&pixels, config.width, config.height, config.format)?;
+    let stats = RenderStats {
+        mesh_ms: 0.0,
+        device_ms,
+        upload_ms,
+        encode_ms: frame.encode_ms,
+        gpu_wait_ms: frame.gpu_wait_ms,
+        gpu_pass_ms: frame.gpu_pass_ms,
+        readback_ms: frame.readback_ms,
+        image_encode_ms: ms(encoding),
+        total_ms: ms(started),
+        bytes_uploaded: renderer.uploaded_bytes(),
+        bytes_read_back: frame.bytes_read_back,
+        meshes: renderer.mesh_count(),
+        unique_meshes: renderer.unique_mesh_count(),
+        draw_calls: frame.draw_calls,
+        triangles: frame.triangles,
+    };
+    Ok((image, stats))
 }
 
 /// Encode RGBA pixels to PNG bytes.
 pub fn encode_png(pixels: &[u8], width: u32, height: u32) -> Result<Vec<u8>, RenderError> {
-    let img = image::RgbaImage::from_raw(width, height, pixels.to_vec())
-        .ok_or_else(|| RenderError::PngEncode("Failed to create image from pixels".into()))?;
-    let mut buf = std::io::Cursor::new(Vec::new());
-    img.write_to(&mut buf, image::ImageFormat::Png)
-        .map_err(|e| RenderError::PngEncode(e.to_string()))?;
-    Ok(buf.into_inner())
+    encode_image(pixels, width, height, ImageFormat::default())
+}
+
+/// Encode RGBA pixels in `format`. Borrows the pixels; nothing is copied
+/// before the encoder runs.
+pub fn encode_image(
+    pixels: &[u8],
+    width: u32,
+    height: u32,
+    format: ImageFormat,
+) -> Result<Vec<u8>, RenderError> {
+    use image::codecs::png::{CompressionType, FilterType, PngEncoder};
+    use image::ImageEncoder;
+
+    if pixels.len() as u64 != width as u64 * height as u64 * 4 {
+        return Err(RenderError::PngEncode(
+            "Failed to create image from pixels".into(),
+        ));
+    }
+    let mut buf = Vec::new();
+    let result = match format {
+        ImageFormat::Png {
+            compression,
+            filter,
+        } => {
+            let compression = match compression {
+                PngCompression::Default => CompressionType::Default,
+                PngCompression::Fast => CompressionType::Fast,
+                PngCompression::Best => CompressionType::Best,
+            };
+            let filter = match filter {
+                PngFilter::NoFilter => FilterType::NoFilter,
+                PngFilter::Sub => FilterType::Sub,
+                PngFilter::Up => FilterType::Up,
+                PngFilter::Avg => FilterType::Avg,
+                PngFilter::Paeth => FilterType::Paeth,
+                PngFilter::Adaptive => FilterType::Adaptive,
+            };
+            PngEncoder::new_with_quality(&mut buf, compression, filter).write_image(
+                pixels,
+                width,
+                height,
+                image::ColorType::Rgba8,
+            )
+        }
+        ImageFormat::Qoi => image::codecs::qoi::QoiEncoder::new(&mut buf).write_image(
+            pixels,
+            width,
+            height,
+            image::ColorType::Rgba8,
+        ),
+    };
+    result.map_err(|e| RenderError::PngEncode(e.to_string()))?;
+    Ok(buf)
 }
 
 /// Encode deterministic RGBA animation frames as an infinitely looping GIF.
@@ -452,6 +692,96 @@ pub fn write_animation_gif(
     std::fs::write(path, gif).map_err(RenderError::Io)
 }
 
+// ─── RenderSession ──────────────────────────────────────────────────────────
+
+/// Meshes uploaded to one [`GpuRenderer`] and rendered from many cameras.
+///
+/// [`render_meshes`] stands up a device, builds pipelines and uploads the
+/// geometry for every image; a session pays that once, so each further view
+/// costs one frame and a readback. A config of another size resizes the
+/// render target in place.
+#[cfg(not(target_arch = "wasm32"))]
+pub struct RenderSession {
+    renderer: GpuRenderer,
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+impl RenderSession {
+    /// Upload `meshes` for rendering at `width` × `height` to start with.
+    pub fn new(
+        meshes: &[MeshOutput],
+        width: u32,
+        height: u32,
+        hdri: Option<&HdriData>,
+    ) -> Result<Self, RenderError> {
+        let renderer = pollster::block_on(GpuRenderer::new(meshes, width, height, hdri))?;
+        Ok(Self { renderer })
+    }
+
+    /// Mesh `schematic` as [`crate::UniversalSchematic::render`] does and
+    /// upload the result.
+    pub fn for_schematic(
+        schematic: &crate::UniversalSchematic,
+        pack: &crate::meshing::ResourcePackSource,
+        mesh_config: &crate::meshing::MeshConfig,
+        width: u32,
+        height: u32,
+    ) -> Result<Self, RenderError> {
+        let meshes = schematic
+            .mesh_chunks_parallel(pack, mesh_config, 64, num_cpus())
+            .map_err(|e| RenderError::RenderFailed(e.to_string()))?;
+        Self::new(&meshes, width, height, None)
+    }
+
+    /// Render one view to RGBA pixels.
+    pub fn render(&mut self, config: &RenderConfig) -> Result<Vec<u8>, RenderError> {
+        self.renderer.resize_headless(config.width, config.height);
+        self.renderer.set_grid(config.grid);
+        self.renderer.render_frame(&config.to_camera())
+    }
+
+    /// Render one view to image bytes in `config.format`.
+    pub fn render_png(&mut self, config: &RenderConfig) -> Result<Vec<u8>, RenderError> {
+        let pixels = self.render(config)?;
+        encode_image(&pixels, config.width, config.height, config.format)
+    }
+
+    /// Render several views in one GPU submission (see
+    /// [`GpuRenderer::render_frames`]) and encode them in parallel, each in
+    /// its own config's format. Every config must have the same size.
+    pub fn render_views_png(
+        &mut self,
+        configs: &[RenderConfig],
+    ) -> Result<Vec<Vec<u8>>, RenderError> {
+        use rayon::prelude::*;
+
+        let Some(first) = configs.first() else {
+            return Ok(Vec::new());
+        };
+        let (width, height) = (first.width, first.height);
+        if configs
+            .iter()
+            .any(|c| (c.width, c.height) != (width, height))
+        {
+            return Err(RenderError::RenderFailed(
+                "views rendered together must share one size".into(),
+            ));
+        }
+        self.renderer.resize_headless(width, height);
+        let views: Vec<_> = configs.iter().map(|c| (c.to_camera(), c.grid)).collect();
+        self.renderer
+            .render_frames(&views)?
+            .par_iter()
+            .zip(configs)
+            .map(|(pixels, config)| encode_image(pixels, width, height, config.format))
+            .collect()
+    }
+
+    pub fn renderer(&self) -> &GpuRenderer {
+        &self.renderer
+    }
+}
+
 // ─── High-level API on UniversalSchematic ───────────────────────────────────
 
 #[cfg(not(target_arch = "wasm32"))]
@@ -469,14 +799,14 @@ impl crate::UniversalSchematic {
         render_meshes(&meshes, config, None)
     }
 
-    /// Render this schematic to PNG bytes.
+    /// Render this schematic to image bytes in `config.format` (PNG by default).
     pub fn render_png(
         &self,
         pack: &crate::meshing::ResourcePackSource,
         config: &RenderConfig,
     ) -> Result<Vec<u8>, RenderError> {
         let pixels = self.render(pack, config)?;
-        encode_png(&pixels, config.width, config.height)
+        encode_image(&pixels, config.width, config.height, config.format)
     }
 
     /// Render this schematic and save as a PNG file.
@@ -575,6 +905,25 @@ mod config_tests {
         assert!(gif.windows(11).any(|w| w == b"NETSCAPE2.0"));
     }
 
+    #[test]
+    fn image_formats_round_trip_pixels() {
+        let pixels: Vec<u8> = (0..4 * 4 * 4).map(|i| (i * 7) as u8).collect();
+        let fast = ImageFormat::Png {
+            compression: PngCompression::Fast,
+            filter: PngFilter::NoFilter,
+        };
+        for (format, kind) in [
+            (ImageFormat::default(), image::ImageFormat::Png),
+            (fast, image::ImageFormat::Png),
+            (ImageFormat::Qoi, image::ImageFormat::Qoi),
+        ] {
+            let bytes = encode_image(&pixels, 4, 4, format).unwrap();
+            let decoded = image::load_from_memory_with_format(&bytes, kind).unwrap();
+            assert_eq!(decoded.to_rgba8().into_raw(), pixels, "{format:?}");
+        }
+        assert!(encode_image(&pixels, 4, 5, ImageFormat::Qoi).is_err());
+    }
+
     #[test]
     fn to_camera_propagates_projection_and_background() {
         let mut c = RenderConfig::default();
@@ -0,0 +1,291 @@
+//! A fixed set of GPU contexts shared by render requests from many threads.
+//!
+//! Opening a device is the slowest part of a one-off render, and a device per
+//! request multiplies that by the request rate. A [`RenderPool`] opens
+//! `contexts` devices once, each driven by its own worker thread; requests
+//! queue on the pool and run on whichever context frees up first. Completion
+//! is either a [`RenderTicket`] to wait on or a callback run on the worker.
+
+use std::collections::VecDeque;
+use std::sync::mpsc;
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant};
+
+use super::gpu::{headless_instance, open_device};
+use super::{encode_image, GpuRenderer, HdriData, RenderConfig, RenderError};
+use crate::meshing::MeshOutput;
+
+/// One pooled device and queue, handed to each request that runs on it.
+pub struct RenderContext {
+    pub device: wgpu::Device,
+    pub queue: wgpu::Queue,
+    /// Position of this context in the pool, `0..contexts`.
+    pub index: usize,
+}
+
+impl RenderContext {
+    /// Upload `meshes` to a headless renderer on this context's device.
+    pub fn renderer(
+        &self,
+        meshes: &[MeshOutput],
+        width: u32,
+        height: u32,
+        hdri: Option<&HdriData>,
+    ) -> GpuRenderer {
+        GpuRenderer::with_device(
+            meshes,
+            width,
+            height,
+            hdri,
+            self.device.clone(),
+            self.queue.clone(),
+        )
+    }
+
+    /// Render one view to RGBA pixels.
+    pub fn render(
+        &self,
+        meshes: &[MeshOutput],
+        config: &RenderConfig,
+        hdri: Option<&HdriData>,
+    ) -> Result<Vec<u8>, RenderError> {
+        let renderer = self.renderer(meshes, config.width, config.height, hdri);
+        renderer.set_grid(config.grid);
+        renderer.render_frame(&config.to_camera())
+    }
+}
+
+/// Point-in-time counters of a [`RenderPool`].
+#[derive(Clone, Debug, Default)]
+pub struct RenderPoolStats {
+    pub contexts: usize,
+    /// Requests waiting for a context.
+    pub queued: usize,
+    /// Requests running on a context now.
+    pub running: usize,
+    pub completed: u64,
+    pub failed: u64,
+    /// Mean and worst time from submission until a context picked the
+    /// request up, over every finished request.
+    pub mean_queue_wait: Duration,
+    pub max_queue_wait: Duration,
+    /// Mean time a request held its context.
+    pub mean_render_time: Duration,
+}
+
+type Task = Box<dyn FnOnce(&RenderContext) -> bool + Send>;
+
+struct Queue {
+    tasks: VecDeque<(Instant, Task)>,
+    shutdown: bool,
+}
+
+#[derive(Default)]
+struct Totals {
+    running: usize,
+    completed: u64,
+    failed: u64,
+    queue_wait: Duration,
+    max_queue_wait: Duration,
+    render_time: Duration,
+}
+
+struct Shared {
+    queue: Mutex<Queue>,
+    ready: Condvar,
+    totals: Mutex<Totals>,
+}
+
+struct Inner {
+    shared: Arc<Shared>,
+    workers: Vec<JoinHandle<()>>,
+}
+
+impl Drop for Inner {
+    fn drop(&mut self) {
+        if let Ok(mut queue) = self.shared.queue.lock() {
+            queue.shutdown = true;
+        }
+        self.shared.ready.notify_all();
+        // The last handle may be dropped by a callback on a worker itself,
+        // which must not wait for its own thread.
+        let current = std::thread::current().id();
+        for worker in self.workers.drain(..) {
+            if worker.thread().id() != current {
+                let _ = worker.join();
+            }
+        }
+    }
+}
+
+/// A pool of GPU contexts with a shared request queue. Cloning is cheap and
+/// shares the pool; the workers stop once the last clone is dropped, after
+/// finishing the requests already queued.
+#[derive(Clone)]
+pub struct RenderPool {
+    inner: Arc<Inner>,
+}
+
+impl RenderPool {
+    /// Open `contexts` devices (at least one) and start a worker per device.
+    pub fn new(contexts: usize) -> Result<Self, RenderError> {
+        let instance = headless_instance();
+        let shared = Arc::new(Shared {
+            queue: Mutex::new(Queue {
+                tasks: VecDeque::new(),
+                shutdown: false,
+            }),
+            ready: Condvar::new(),
+            totals: Mutex::new(Totals::default()),
+        });
+        let mut workers = Vec::with_capacity(contexts.max(1));
+        for index in 0..contexts.max(1) {
+            let (_, device, queue) = pollster::block_on(open_device(&instance, None))?;
+            let context = RenderContext {
+                device,
+                queue,
+                index,
+            };
+            let shared = Arc::clone(&shared);
+            let worker = std::thread::Builder::new()
+                .name(format!("nucleation-render-{index}"))
+                .spawn(move || run_worker(&shared, &context))
+                .map_err(|e| RenderError::DeviceCreation(e.to_string()))?;
+            workers.push(worker);
+        }
+        Ok(Self {
+            inner: Arc::new(Inner { shared, workers }),
+        })
+    }
+
+    /// Queue `work` for the next free context and call `done` with its result
+    /// on the worker thread. A panic in `work` is reported to `done` as
+    /// [`RenderError::RenderFailed`].
+    pub fn submit_with<T, W, D>(&self, work: W, done: D)
+    where
+        W: FnOnce(&RenderContext) -> Result<T, RenderError> + Send + 'static,
+        D: FnOnce(Result<T, RenderError>) + Send + 'static,
+    {
+        let task: Task = Box::new(move |context| {
+            let result = std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| work(context)))
+                .unwrap_or_else(|_| Err(RenderError::RenderFailed("render task panicked".into())));
+            let ok = result.is_ok();
+            done(result);
+            ok
+        });
+        let shared = &self.inner.shared;
+        if let Ok(mut queue) = shared.queue.lock() {
+            queue.tasks.push_back((Instant::now(), task));
+        }
+        shared.ready.notify_one();
+    }
+
+    /// Queue `work` and return a ticket for its result.
+    pub fn submit<T, W>(&self, work: W) -> RenderTicket<T>
+    where
+        T: Send + 'static,
+        W: FnOnce(&RenderContext) -> Result<T, RenderError> + Send + 'static,
+    {
+        let (sender, receiver) = mpsc::channel();
+        self.submit_with(work, move |result| {
+            let _ = sender.send(result);
+        });
+        RenderTicket { receiver }
+    }
+
+    /// Queue one view of `meshes` and return a ticket for the image, encoded
+    /// in `config.format`. Encoding runs on the worker too.
+    pub fn render(
+        &self,
+        meshes: Vec<MeshOutput>,
+        config: RenderConfig,
+        hdri: Option<Arc<HdriData>>,
+    ) -> RenderTicket<Vec<u8>> {
+        self.submit(move |context| {
+            let pixels = context.render(&meshes, &config, hdri.as_deref())?;
+            encode_image(&pixels, config.width, config.height, config.format)
+        })
+    }
+
+    pub fn stats(&self) -> RenderPoolStats {
+        let shared = &self.inner.shared;
+        let queued = shared.queue.lock().map(|q| q.tasks.len()).unwrap_or(0);
+        let Ok(totals) = shared.totals.lock() else {
+            return RenderPoolStats::default();
+        };
+        let finished = (totals.completed + totals.failed).max(1) as u32;
+        RenderPoolStats {
+            contexts: self.inner.workers.len(),
+            queued,
+            running: totals.running,
+            completed: totals.completed,
+            failed: totals.failed,
+            mean_queue_wait: totals.queue_wait / finished,
+            max_queue_wait: totals.max_queue_wait,
+            mean_render_time: totals.render_time / finished,
+        }
+    }
+}
+
+fn run_worker(shared: &Shared, context: &RenderContext) {
+    loop {
+        let (submitted, task) = {
+            let Ok(queue) = shared.queue.lock() else {
+                return;
+            };
+            let Ok(mut queue) = shared
+                .ready
+                .wait_while(queue, |q| q.tasks.is_empty() && !q.shutdown)
+            else {
+                return;
+            };
+            match queue.tasks.pop_front() {
+                Some(next) => next,
+                None => return,
+            }
+        };
+        let started = Instant::now();
+        if let Ok(mut totals) = shared.totals.lock() {
+            totals.running += 1;
+        }
+        let ok = task(context);
+        if let Ok(mut totals) = shared.totals.lock() {
+            let wait = started - submitted;
+            totals.running -= 1;
+            if ok {
+                totals.completed += 1;
+            } else {
+                totals.failed += 1;
+            }
+            totals.queue_wait += wait;
+            totals.max_queue_wait = totals.max_queue_wait.max(wait);
+            totals.render_time += started.elapsed();
+        }
+    }
+}
+
+/// The pending result of a [`RenderPool::submit`].
+pub struct RenderTicket<T> {
+    receiver: mpsc::Receiver<Result<T, RenderError>>,
+}
+
+impl<T> RenderTicket<T> {
+    /// Block until the request has run.
+    pub fn wait(self) -> Result<T, RenderError> {
+        self.receiver
+            .recv()
+            .unwrap_or_else(|_| Err(RenderError::RenderFailed("render pool shut down".into())))
+    }
+
+    /// The result if the request has run, else the ticket back.
+    pub fn try_take(self) -> Result<Result<T, RenderError>, Self> {
+        match self.receiver.try_recv() {
+            Ok(result) => Ok(result),
+            Err(mpsc::TryRecvError::Empty) => Err(self),
+            Err(mpsc::TryRecvError::Disconnected) => Ok(Err(RenderError::RenderFailed(
+                "render pool shut down".into(),
+            ))),
+        }
+    }
+}
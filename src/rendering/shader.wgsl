@@ -10,18 +10,25 @@ struct Uniforms {
     light: vec4<f32>,
 };
 
-// Per-draw animation state. Written by the animation layer as a `Pose`; an
-// un-animated draw supplies the identity value, which is a no-op in the maths
-// below so posed and un-posed rendering agree bit for bit.
-struct DrawUniforms {
-    model: mat4x4<f32>,
+// Per-instance animation state, one record per placed mesh in an instance
+// vertex buffer (mirroring `DrawUniforms` in `gpu.rs`). Translated copies of a
+// mesh share geometry and differ only in this record. An un-animated mesh's
+// record is its placement with neutral tint and no emission, so posed and
+// un-posed rendering agree bit for bit.
+struct InstanceInput {
+    @location(4) model_0: vec4<f32>,
+    @location(5) model_1: vec4<f32>,
+    @location(6) model_2: vec4<f32>,
+    @location(7) model_3: vec4<f32>,
     // Inverse-transpose of the model's upper 3x3. Required, or rotated and
     // non-uniformly scaled geometry shades wrong.
-    normal_mat: mat3x3<f32>,
+    @location(8) normal_0: vec3<f32>,
+    @location(9) normal_1: vec3<f32>,
+    @location(10) normal_2: vec3<f32>,
     // Multiplied into the base colour. Identity is (1, 1, 1, 1).
-    tint: vec4<f32>,
+    @location(11) tint: vec4<f32>,
     // Added after lighting. Identity is (0, 0, 0, 0).
-    emissive: vec4<f32>,
+    @location(12) emissive: vec4<f32>,
 };
 
 @group(0) @binding(0) var<uniform> uniforms: Uniforms;
@@ -29,7 +36,7 @@ struct DrawUniforms {
 @group(1) @binding(1) var atlas_sampler: sampler;
 @group(2) @binding(0) var hdri_texture: texture_2d<f32>;
 @group(2) @binding(1) var hdri_sampler: sampler;
-@group(3) @binding(0) var<uniform> draw: DrawUniforms;
+@group(2) @binding(2) var hdri_irradiance: texture_2d<f32>;
 
 // ─── Mesh rendering ─────────────────────────────────────────────────────────
 
@@ -45,40 +52,49 @@ struct VertexOutput {
     @location(0) world_normal: vec3<f32>,
     @location(1) uv: vec2<f32>,
     @location(2) color: vec4<f32>,
+    @location(3) @interpolate(flat) tint: vec4<f32>,
+    @location(4) @interpolate(flat) emissive: vec4<f32>,
 };
 
 @vertex
-fn vs_main(in: VertexInput) -> VertexOutput {
+fn vs_main(in: VertexInput, inst: InstanceInput) -> VertexOutput {
     var out: VertexOutput;
-    let world = draw.model * vec4<f32>(in.position, 1.0);
+    let model = mat4x4<f32>(inst.model_0, inst.model_1, inst.model_2, inst.model_3);
+    let normal_mat = mat3x3<f32>(inst.normal_0, inst.normal_1, inst.normal_2);
+    let world = model * vec4<f32>(in.position, 1.0);
     out.clip_position = uniforms.view_proj * world;
-    out.world_normal = draw.normal_mat * in.normal;
+    out.world_normal = normal_mat * in.normal;
     out.uv = in.uv;
     out.color = in.color;
+    out.tint = inst.tint;
+    out.emissive = inst.emissive;
     return out;
 }
 
-// Sample HDRI equirectangular map from a world-space direction.
-fn sample_hdri(dir: vec3<f32>) -> vec3<f32> {
+// Equirectangular UV of a world-space direction.
+fn equirect_uv(dir: vec3<f32>) -> vec2<f32> {
     let d = normalize(dir);
     let u = atan2(d.z, d.x) * 0.15915494 + 0.5; // 1/(2*pi)
     let v = acos(clamp(d.y, -1.0, 1.0)) * 0.31830989; // 1/pi
-    return textureSampleLevel(hdri_texture, hdri_sampler, vec2<f32>(u, v), 0.0).rgb;
+    return vec2<f32>(u, v);
+}
+
+// Sample HDRI equirectangular map from a world-space direction.
+fn sample_hdri(dir: vec3<f32>) -> vec3<f32> {
+    return textureSampleLevel(hdri_texture, hdri_sampler, equirect_uv(dir), 0.0).rgb;
 }
 
-// Rough diffuse IBL: sample HDRI in the normal direction (approximation).
+// Diffuse IBL from the irradiance map prefiltered on the CPU (cosine
+// convolution over pi, see `hdri.rs`).
 fn hdri_diffuse(normal: vec3<f32>) -> vec3<f32> {
-    // Sample at a higher mip (or just the base — equirect doesn't have mips,
-    // so this is a rough approximation). For proper IBL we'd precompute an
-    // irradiance map, but for a PoC this looks decent.
-    return sample_hdri(normal);
+    return textureSampleLevel(hdri_irradiance, hdri_sampler, equirect_uv(normal), 0.0).rgb;
 }
 
 @fragment
 fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {
     let tex_color = textureSample(atlas_texture, atlas_sampler, in.uv);
     let material_alpha = tex_color.a * in.color.a;
-    let base_color = tex_color * in.color * draw.tint;
+    let base_color = tex_color * in.color * in.tint;
     if base_color.a <= 0.0001 {
         discard;
     }
@@ -108,13 +124,13 @@ fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {
         ambient_color = base_color.rgb * max(ibl + 0.35 * directional_intensity * n_dot_l, min_ambient);
         // Tonemap mesh colors too (matches skybox)
         let mapped = ambient_color / (ambient_color + vec3<f32>(1.0));
-        return vec4<f32>(mapped + draw.emissive.rgb, base_color.a);
+        return vec4<f32>(mapped + in.emissive.rgb, base_color.a);
     } else {
         // Fallback: simple directional lighting
         let n_dot_l = max(dot(n, light_dir), 0.0);
         let ambient = uniforms.params.w;
         lighting = ambient + (1.0 - ambient) * directional_intensity * n_dot_l;
-        return vec4<f32>(base_color.rgb * lighting + draw.emissive.rgb, base_color.a);
+        return vec4<f32>(base_color.rgb * lighting + in.emissive.rgb, base_color.a);
     }
 }
 
@@ -0,0 +1,180 @@
+//! Tiled rendering of images too large for one render target.
+//!
+//! The image is framed exactly as a single `width × height` render would be,
+//! then drawn tile by tile into a fixed `tile_size²` target: each tile's
+//! view-projection is the full one cropped to its pixel rectangle
+//! ([`camera::tile_view_proj`]), and frustum culling skips every mesh outside
+//! the tile. GPU and host memory stay bounded by the tile size, so 32k × 32k
+//! orthographic maps render on ordinary devices.
+
+use std::path::{Path, PathBuf};
+
+use rayon::prelude::*;
+
+use super::camera::{self, compute_view_proj, merged_bounds};
+use super::{encode_image, GpuRenderer, HdriData, RenderConfig, RenderError, READBACK_RING};
+use crate::meshing::MeshOutput;
+
+/// Where a tile sits in a tiled render.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct Tile {
+    /// Column and row of the tile, from the top-left.
+    pub x: u32,
+    pub y: u32,
+    pub columns: u32,
+    pub rows: u32,
+    /// Pixels of the tile inside the image. Tiles on the right and bottom
+    /// edges can be smaller than the tile size; the rest is transparent.
+    pub width: u32,
+    pub height: u32,
+}
+
+/// Render `config.width × config.height` as `tile_size²` tiles, row by row,
+/// and hand each tile's RGBA pixels (always `tile_size²`) to `consume`.
+pub fn render_tiles(
+    meshes: &[MeshOutput],
+    config: &RenderConfig,
+    tile_size: u32,
+    hdri: Option<&HdriData>,
+    mut consume: impl FnMut(Tile, &[u8]) -> Result<(), RenderError>,
+) -> Result<(), RenderError> {
+    let tile_size = tile_size.max(1);
+    let (width, height) = (config.width.max(1), config.height.max(1));
+    let (columns, rows) = (width.div_ceil(tile_size), height.div_ceil(tile_size));
+    let (bounds_min, bounds_max) = merged_bounds(meshes);
+    let camera = config.to_camera();
+    let (full, _) = compute_view_proj(
+        bounds_min,
+        bounds_max,
+        width as f32 / height as f32,
+        &camera,
+    );
+    let tile_at = |index: usize| {
+        let (x, y) = (index as u32 % columns, index as u32 / columns);
+        Tile {
+            x,
+            y,
+            columns,
+            rows,
+            width: tile_size.min(width - x * tile_size),
+            height: tile_size.min(height - y * tile_size),
+        }
+    };
+
+    pollster::block_on(async {
+        let renderer = GpuRenderer::new(meshes, tile_size, tile_size, hdri).await?;
+        renderer.set_grid(config.grid);
+        let prepare = |index: usize| -> Result<_, RenderError> {
+            let tile = tile_at(index);
+            renderer.set_view_proj(Some(camera::tile_view_proj(
+                full,
+                width,
+                height,
+                tile.x * tile_size,
+                tile.y * tile_size,
+                tile_size,
+                tile_size,
+            )));
+            Ok(camera.clone())
+        };
+        let mut edge = Vec::new();
+        let tile_count = (columns * rows) as usize;
+        renderer.render_stream(tile_count, READBACK_RING, prepare, |index, pixels| {
+            let tile = tile_at(index);
+            if (tile.width, tile.height) == (tile_size, tile_size) {
+                return consume(tile, pixels);
+            }
+            // Clear what lies past the image edge.
+            edge.clear();
+            edge.extend_from_slice(pixels);
+            for (row, line) in edge.chunks_exact_mut(4 * tile_size as usize).enumerate() {
+                let keep = if (row as u32) < tile.height {
+                    4 * tile.width as usize
+                } else {
+                    0
+                };
+                line[keep..].fill(0);
+            }
+            consume(tile, &edge)
+        })
+    })
+}
+
+/// Render a tiled image into an XYZ ("slippy map") pyramid under `dir`:
+/// `{dir}/{z}/{x}/{y}.{ext}`, with `ext` from `config.format`.
+///
+/// The full-resolution tiles form the deepest zoom level, whose grid is the
+/// next power of two covering the image; each coarser level halves it, down
+/// to one tile at zoom 0. Tiles wholly outside the image are not written.
+/// Returns the deepest zoom.
+pub fn render_tile_pyramid(
+    meshes: &[MeshOutput],
+    config: &RenderConfig,
+    tile_size: u32,
+    hdri: Option<&HdriData>,
+    dir: &Path,
+) -> Result<u32, RenderError> {
+    let tile_size = tile_size.max(1);
+    let format = config.format;
+    let path = |z: u32, x: u32, y: u32| -> PathBuf {
+        dir.join(z.to_string())
+            .join(x.to_string())
+            .join(format!("{y}.{}", format.extension()))
+    };
+    let write = |path: PathBuf, pixels: &[u8]| -> Result<(), RenderError> {
+        let bytes = encode_image(pixels, tile_size, tile_size, format)?;
+        if let Some(parent) = path.parent() {
+            std::fs::create_dir_all(parent).map_err(RenderError::Io)?;
+        }
+        std::fs::write(path, bytes).map_err(RenderError::Io)
+    };
+
+    let (columns, rows) = (
+        config.width.max(1).div_ceil(tile_size),
+        config.height.max(1).div_ceil(tile_size),
+    );
+    let max_zoom = columns.max(rows).next_power_of_two().trailing_zeros();
+    render_tiles(meshes, config, tile_size, hdri, |tile, pixels| {
+        write(path(max_zoom, tile.x, tile.y), pixels)
+    })?;
+
+    let side = tile_size as usize;
+    for z in (0..max_zoom).rev() {
+        let shift = max_zoom - z;
+        let (level_columns, level_rows) = (columns.div_ceil(1 << shift), rows.div_ceil(1 << shift));
+        (0..level_columns * level_rows)
+            .into_par_iter()
+            .try_for_each(|index| {
+                let (x, y) = (index % level_columns, index / level_columns);
+                // Box-filter the (up to) four children into one tile.
+                let mut out = vec![0u8; side * side * 4];
+                for (dx, dy) in [(0, 0), (1, 0), (0, 1), (1, 1)] {
+                    let Ok(bytes) = std::fs::read(path(z + 1, 2 * x + dx, 2 * y + dy)) else {
+                        continue;
+                    };
+                    let child = image::load_from_memory(&bytes)
+                        .map_err(|e| RenderError::PngEncode(e.to_string()))?
+                        .to_rgba8();
+                    let child = child.as_raw();
+                    let (ox, oy) = (dx as usize * side / 2, dy as usize * side / 2);
+                    for py in 0..side / 2 {
+                        for px in 0..side / 2 {
+                            let mut sum = [0u32; 4];
+                            for (sx, sy) in [(0, 0), (1, 0), (0, 1), (1, 1)] {
+                                let at = ((2 * py + sy) * side + 2 * px + sx) * 4;
+                                for c in 0..4 {
+                                    sum[c] += child[at + c] as u32;
+                                }
+                            }
+                            let at = ((oy + py) * side + ox + px) * 4;
+                            for c in 0..4 {
+                                out[at + c] = (sum[c] / 4) as u8;
+                            }
+                        }
+                    }
+                }
+                write(path(z, x, y), &out)
+            })?;
+    }
+    Ok(max_zoom)
+}
@@ -29,9 +29,11 @@
 //!     .build()?;
 //! ```
 
+pub mod image;
 pub mod palettes;
 
-use crate::UniversalSchematic;
+use crate::bounding_box::BoundingBox;
+use crate::{BlockState, UniversalSchematic};
 use std::collections::HashMap;
 
 /// Palette entry - either a block or a sub-schematic
@@ -43,6 +45,34 @@ pub enum PaletteEntry {
     Schematic(UniversalSchematic),
 }
 
+/// A schematic palette entry prepared once per build: the box holding its
+/// content, and its air states, which stamping skips.
+struct Template {
+    bounds: Option<BoundingBox>,
+    air: Vec<BlockState>,
+}
+
+impl Template {
+    fn new(schematic: &UniversalSchematic) -> Self {
+        let regions =
+            || std::iter::once(&schematic.default_region).chain(schematic.other_regions.values());
+        let bounds = regions()
+            .filter_map(|region| region.get_tight_bounds())
+            .reduce(|a, b| a.union(&b));
+        let mut air: Vec<BlockState> = Vec::new();
+        for state in regions().flat_map(|region| region.palette.iter()) {
+            let name = state
+                .name
+                .strip_prefix("minecraft:")
+                .unwrap_or(state.name.as_str());
+            if matches!(name, "air" | "cave_air" | "void_air") && !air.contains(state) {
+                air.push(state.clone());
+            }
+        }
+        Self { bounds, air }
+    }
+}
+
 /// Builder for creating schematics from ASCII art
 pub struct SchematicBuilder {
     /// Character to palette entry mapping (blocks or schematics)
@@ -406,6 +436,9 @@ impl SchematicBuilder {
             }
         }
 
+        let mut parsed: HashMap<char, BlockState> = HashMap::new();
+        let mut templates: HashMap<char, Template> = HashMap::new();
+
         // Iterate through layers (Y), rows (Z), and columns (X)
         for (y, layer) in self.layers.iter().enumerate() {
             for (z, line) in layer.iter().enumerate() {
@@ -418,54 +451,40 @@ impl SchematicBuilder {
 
                         match entry {
                             PaletteEntry::Block(block_str) => {
-                                // Place a single block
-                                match UniversalSchematic::parse_block_string(block_str) {
-                                    Ok((block_state, _)) => {
-                                        schematic.set_block(
-                                            world_x,
-                                            world_y,
-                                            world_z,
-                                            &block_state,
-                                        );
-                                    }
-                                    Err(e) => {
-                                        return Err(format!(
-                                            "Failed to parse block '{}' for character '{}' at ({}, {}, {}): {}",
-                                            block_str, ch, x, y, z, e
-                                        ));
+                                // Parse each character's block once, not once per cell
+                                if !parsed.contains_key(&ch) {
+                                    match UniversalSchematic::parse_block_string(block_str) {
+                                        Ok((block_state, _)) => {
+                                            parsed.insert(ch, block_state);
+                                        }
+                                        Err(e) => {
+                                            return Err(format!(
+                                                "Failed to parse block '{}' for character '{}' at ({}, {}, {}): {}",
+                                                block_str, ch, x, y, z, e
+                                            ));
+                                        }
                                     }
                                 }
+                                schematic.set_block(world_x, world_y, world_z, &parsed[&ch]);
                             }
                             PaletteEntry::Schematic(sub_schematic) => {
-                                // Place an entire sub-schematic
-                                // Copy all NON-AIR blocks from the sub-schematic, offset by the current position
-                                // Skip air blocks to avoid overwriting blocks from adjacent schematics
-                                for (pos, block_state) in sub_schematic.iter_blocks() {
-                                    // Skip air blocks
-                                    if block_state.name.contains("air") {
-                                        continue;
-                                    }
-                                    schematic.set_block(
-                                        pos.x + world_x,
-                                        pos.y + world_y,
-                                        pos.z + world_z,
-                                        &block_state.clone(),
-                                    );
-                                }
-
-                                // Copy block entities too
-                                for block_entity in
-                                    sub_schematic.default_region.get_block_entities_as_list()
-                                {
-                                    let pos = block_entity.position;
-                                    schematic.set_block_entity(
-                                        crate::block_position::BlockPosition {
-                                            x: pos.0 + world_x,
-                                            y: pos.1 + world_y,
-                                            z: pos.2 + world_z,
-                                        },
-                                        block_entity.clone(),
-                                    );
+                                // Stamp the sub-schematic through the bulk copy path.
+                                // Its air is excluded so it never overwrites blocks
+                                // from adjacent schematics.
+                                let template = templates
+                                    .entry(ch)
+                                    .or_insert_with(|| Template::new(sub_schematic));
+                                if let Some(bounds) = &template.bounds {
+                                    schematic.stamp_box(
+                                        sub_schematic,
+                                        bounds,
+                                        (
+                                            bounds.min.0 + world_x,
+                                            bounds.min.1 + world_y,
+                                            bounds.min.2 + world_z,
+                                        ),
+                                        &template.air,
+                                    )?;
                                 }
                             }
                         }
@@ -1380,4 +1399,43 @@ cc
             panic!("Expected tight bounds");
         }
     }
+
+    #[test]
+    fn test_schematic_palette_stamps_non_air_blocks_and_block_entities() {
+        use crate::block_entity::BlockEntity;
+        use crate::block_position::BlockPosition;
+
+        // A 3-wide template: stairs, an air gap, and a chest with a block entity
+        let mut template = UniversalSchematic::new("template".to_string());
+        template.set_block_str(0, 0, 0, "minecraft:oak_stairs[facing=east]");
+        template.set_block_str(1, 0, 0, "minecraft:air");
+        template.set_block_str(2, 0, 0, "minecraft:chest");
+        template.set_block_entity(
+            BlockPosition { x: 2, y: 0, z: 0 },
+            BlockEntity::new("minecraft:chest".to_string(), (2, 0, 0)),
+        );
+
+        let tiled = SchematicBuilder::empty()
+            .map_schematic('T', template)
+            .layers(&[&["TT"]])
+            .build()
+            .unwrap();
+
+        for base in [0, 3] {
+            assert_eq!(
+                tiled.get_block(base, 0, 0).unwrap().name.as_str(),
+                "minecraft:oak_stairs"
+            );
+            assert!(tiled
+                .get_block(base + 1, 0, 0)
+                .map_or(true, |b| b.name.as_str() == "minecraft:air"));
+            assert!(tiled
+                .get_block_entity(BlockPosition {
+                    x: base + 2,
+                    y: 0,
+                    z: 0
+                })
+                .is_some());
+        }
+    }
 }
@@ -0,0 +1,450 @@
+//! Image-driven schematic building: pixel art, map art and heightmaps
+//!
+//! [`ImageBuilder`] is the bulk counterpart of
+//! [`SchematicBuilder`](super::SchematicBuilder) for content that starts as
+//! pixels. Instead of one character per block, it takes an RGBA buffer and
+//! snaps the whole image to a [`BlockPalette`] in one batch
+//! ([`BlockPalette::closest_indices`]). The result is written straight into
+//! the region as palette indices: a flat image is a single
+//! `write_palette_indices` call, and staircased or heightmapped columns go
+//! cell by cell without parsing a block string per cell.
+//!
+//! # Example
+//!
+//! ```ignore
+//! use nucleation::building::shared_palette_by_name;
+//! use nucleation::schematic_builder::image::{ImageBuilder, MapShading};
+//!
+//! let wall = ImageBuilder::new(shared_palette_by_name("concrete")?)
+//!     .shading(MapShading::Staircase)
+//!     .build_rgba(&pixels, 128, 128)?;
+//! ```
+
+use crate::building::BlockPalette;
+use crate::UniversalSchematic;
+use std::sync::Arc;
+
+/// Where the image lies.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum ImageOrientation {
+    /// On the ground: pixel column -> X, pixel row -> Z (north at the top),
+    /// as a map item shows it.
+    #[default]
+    Floor,
+    /// Upright, facing south: pixel column -> X, pixel row -> Y (top row
+    /// highest), at Z = 0.
+    Wall,
+}
+
+/// How map-art shading is produced. Only meaningful on the floor.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum MapShading {
+    /// Every block at one height, matched against the plain palette colors.
+    #[default]
+    Flat,
+    /// Each block is placed one higher, level or one lower than its
+    /// northern neighbour, so a map renders it in the light, normal or dark
+    /// shade. The image is matched against all three shades of every
+    /// palette block at once. A support row is placed north of the first
+    /// pixel row for the first row to shade against.
+    Staircase,
+}
+
+/// Map shade brightness factors, in the game's order: dark, normal, light.
+const SHADES: [f32; 3] = [180.0 / 255.0, 220.0 / 255.0, 1.0];
+
+/// Pixels with alpha below this are left empty.
+const ALPHA_CUTOFF: u8 = 128;
+
+/// Builds a schematic from an image buffer.
+#[derive(Clone)]
+pub struct ImageBuilder {
+    name: String,
+    palette: Arc<BlockPalette>,
+    dither: bool,
+    orientation: ImageOrientation,
+    shading: MapShading,
+    offset: (i32, i32, i32),
+    /// Placed under every staircased block and as the support row.
+    support: String,
+    /// Block under the surface of heightmap columns.
+    fill: String,
+}
+
+impl ImageBuilder {
+    /// A builder matching pixels against `palette` (see
+    /// [`crate::building::shared_palette_by_name`] for the presets).
+    pub fn new(palette: Arc<BlockPalette>) -> Self {
+        Self {
+            name: "image".to_string(),
+            palette,
+            dither: false,
+            orientation: ImageOrientation::Floor,
+            shading: MapShading::Flat,
+            offset: (0, 0, 0),
+            support: "minecraft:stone".to_string(),
+            fill: "minecraft:stone".to_string(),
+        }
+    }
+
+    /// Set the name of the schematic
+    pub fn name(mut self, name: impl Into<String>) -> Self {
+        self.name = name.into();
+        self
+    }
+
+    /// Use the palette's ordered (Bayer) dither between the two nearest
+    /// blocks instead of a hard nearest match.
+    pub fn dither(mut self, dither: bool) -> Self {
+        self.dither = dither;
+        self
+    }
+
+    pub fn orientation(mut self, orientation: ImageOrientation) -> Self {
+        self.orientation = orientation;
+        self
+    }
+
+    pub fn shading(mut self, shading: MapShading) -> Self {
+        self.shading = shading;
+        self
+    }
+
+    /// Set the offset for the schematic in world coordinates
+    pub fn offset(mut self, x: i32, y: i32, z: i32) -> Self {
+        self.offset = (x, y, z);
+        self
+    }
+
+    /// Block used for the staircase support row (default stone).
+    pub fn support_block(mut self, block: impl Into<String>) -> Self {
+        self.support = block.into();
+        self
+    }
+
+    /// Block filling heightmap columns below their surface (default stone).
+    pub fn fill_block(mut self, block: impl Into<String>) -> Self {
+        self.fill = block.into();
+        self
+    }
+
+    /// Build from `rgba`, four bytes per pixel, `width` pixels per row,
+    /// rows top to bottom.
+    pub fn build_rgba(
+        &self,
+        rgba: &[u8],
+        width: usize,
+        height: usize,
+    ) -> Result<UniversalSchematic, String> {
+        let rgb = Self::rgb_of(rgba, width, height)?;
+        if self.palette.is_empty() {
+            return Err("Image palette is empty".to_string());
+        }
+        let mut schematic = UniversalSchematic::new(self.name.clone());
+        if width == 0 || height == 0 {
+            return Ok(schematic);
+        }
+        match self.shading {
+            MapShading::Flat => self.place_flat(&mut schematic, rgba, &rgb, width, height)?,
+            MapShading::Staircase => {
+                if self.orientation == ImageOrientation::Wall {
+                    return Err("Staircase shading needs a floor image".to_string());
+                }
+                self.place_staircase(&mut schematic, rgba, &rgb, width, height);
+            }
+        }
+        Ok(schematic)
+    }
+
+    /// Build terrain from `heights` (one per pixel, row-major, in blocks;
+    /// 0 leaves the column empty). Columns are made of the fill block. When
+    /// `rgba` is given, each column's top block is that pixel matched
+    /// against the palette instead; transparent pixels keep the fill
+    /// block. Orientation and shading do not apply.
+    pub fn build_heightmap(
+        &self,
+        heights: &[u16],
+        width: usize,
+        height: usize,
+        rgba: Option<&[u8]>,
+    ) -> Result<UniversalSchematic, String> {
+        if heights.len() != width * height {
+            return Err(format!(
+                "got {} heights for a {width}x{height} map",
+                heights.len()
+            ));
+        }
+        let tops = match rgba {
+            Some(_) if self.palette.is_empty() => {
+                return Err("Image palette is empty".to_string());
+            }
+            Some(rgba) => {
+                let rgb = Self::rgb_of(rgba, width, height)?;
+                let indices = self.palette.closest_indices(&rgb, width, self.dither);
+                Some((rgba, indices))
+            }
+            None => None,
+        };
+        let mut schematic = UniversalSchematic::new(self.name.clone());
+        let tallest = heights.iter().copied().max().unwrap_or(0) as i32;
+        if tallest == 0 {
+            return Ok(schematic);
+        }
+        let (ox, oy, oz) = self.offset;
+        let region = &mut schematic.default_region;
+        region.ensure_bounds(
+            (ox, oy, oz),
+            (
+                ox + width as i32 - 1,
+                oy + tallest - 1,
+                oz + height as i32 - 1,
+            ),
+        );
+        let fill = region.get_or_insert_palette_by_name(&self.fill);
+        let ids: Vec<&str> = self.palette.block_ids().collect();
+        let mut mapped = vec![None; ids.len()];
+        for (i, &h) in heights.iter().enumerate() {
+            if h == 0 {
+                continue;
+            }
+            let (x, z) = (ox + (i % width) as i32, oz + (i / width) as i32);
+            let top = match &tops {
+                Some((rgba, indices)) if rgba[i * 4 + 3] >= ALPHA_CUTOFF => {
+                    let p = indices[i] as usize;
+                    *mapped[p].get_or_insert_with(|| region.get_or_insert_palette_by_name(ids[p]))
+                }
+                _ => fill,
+            };
+            let top_y = oy + h as i32 - 1;
+            for y in oy..top_y {
+                region.set_block_at_index_unchecked(fill, x, y, z);
+            }
+            region.set_block_at_index_unchecked(top, x, top_y, z);
+        }
+        Ok(schematic)
+    }
+
+    /// The RGB bytes of `rgba` after checking its size.
+    fn rgb_of(rgba: &[u8], width: usize, height: usize) -> Result<Vec<u8>, String> {
+        if rgba.len() != width * height * 4 {
+            return Err(format!(
+                "got {} bytes for a {width}x{height} RGBA image",
+                rgba.len()
+            ));
+        }
+        Ok(rgba
+            .chunks_exact(4)
+            .flat_map(|px| [px[0], px[1], px[2]])
+            .collect())
+    }
+
+    /// One layer: a single palette-index write over the image's box.
+    fn place_flat(
+        &self,
+        schematic: &mut UniversalSchematic,
+        rgba: &[u8],
+        rgb: &[u8],
+        width: usize,
+        height: usize,
+    ) -> Result<(), String> {
+        let indices = self.palette.closest_indices(rgb, width, self.dither);
+        let region = &mut schematic.default_region;
+        let ids: Vec<&str> = self.palette.block_ids().collect();
+        let mut mapped = vec![None; ids.len()];
+        let air = region.air_index() as u32;
+        let cells: Vec<u32> = indices
+            .iter()
+            .enumerate()
+            .map(|(i, &p)| {
+                if rgba[i * 4 + 3] < ALPHA_CUTOFF {
+                    return air;
+                }
+                let p = p as usize;
+                *mapped[p]
+                    .get_or_insert_with(|| region.get_or_insert_palette_by_name(ids[p]) as u32)
+            })
+            .collect();
+        let (ox, oy, oz) = self.offset;
+        let (w, h) = (width as i32, height as i32);
+        match self.orientation {
+            // Storage order is x, then z: pixel order as is.
+            ImageOrientation::Floor => {
+                region.write_palette_indices((ox, oy, oz), (ox + w - 1, oy, oz + h - 1), &cells)
+            }
+            // x, then y upwards: bottom pixel row first.
+            ImageOrientation::Wall => {
+                let upright: Vec<u32> =
+                    cells.chunks_exact(width).rev().flatten().copied().collect();
+                region.write_palette_indices((ox, oy, oz), (ox + w - 1, oy + h - 1, oz), &upright)
+            }
+        }
+    }
+
+    /// Map-art staircase: shade picks each block's step from its northern
+    /// neighbour, then every column is lowered to start at the offset.
+    fn place_staircase(
+        &self,
+        schematic: &mut UniversalSchematic,
+        rgba: &[u8],
+        rgb: &[u8],
+        width: usize,
+        height: usize,
+    ) {
+        let shaded = self.palette.with_shades(&SHADES);
+        let indices = shaded.closest_indices(rgb, width, self.dither);
+
+        // Relative heights per column; the support row sits at 0. A
+        // transparent pixel is left empty and the next block steps from the
+        // last placed height.
+        let mut steps = vec![0i32; width * height];
+        let mut lowest = vec![0i32; width];
+        let mut highest = vec![0i32; width];
+        for x in 0..width {
+            let mut y = 0;
+            for z in 0..height {
+                let i = z * width + x;
+                if rgba[i * 4 + 3] < ALPHA_CUTOFF {
+                    continue;
+                }
+                y += indices[i] as i32 % SHADES.len() as i32 - 1;
+                steps[i] = y;
+                lowest[x] = lowest[x].min(y);
+                highest[x] = highest[x].max(y);
+            }
+        }
+        let tallest = (0..width)
+            .map(|x| highest[x] - lowest[x])
+            .max()
+            .unwrap_or(0);
+
+        // One extra layer below for supports, one extra row north.
+        let (ox, oy, oz) = self.offset;
+        let region = &mut schematic.default_region;
+        region.ensure_bounds(
+            (ox, oy, oz - 1),
+            (
+                ox + width as i32 - 1,
+                oy + tallest + 1,
+                oz + height as i32 - 1,
+            ),
+        );
+        let support = region.get_or_insert_palette_by_name(&self.support);
+        let ids: Vec<&str> = self.palette.block_ids().collect();
+        let mut mapped = vec![None; ids.len()];
+        for x in 0..width {
+            // Lowest step lands on the support layer's top, at oy + 1.
+            let base = oy + 1 - lowest[x];
+            let wx = ox + x as i32;
+            region.set_block_at_index_unchecked(support, wx, base, oz - 1);
+            region.set_block_at_index_unchecked(support, wx, base - 1, oz - 1);
+            for z in 0..height {
+                let i = z * width + x;
+                if rgba[i * 4 + 3] < ALPHA_CUTOFF {
+                    continue;
+                }
+                let p = indices[i] as usize / SHADES.len();
+                let block =
+                    *mapped[p].get_or_insert_with(|| region.get_or_insert_palette_by_name(ids[p]));
+                let (wy, wz) = (base + steps[i], oz + z as i32);
+                region.set_block_at_index_unchecked(block, wx, wy, wz);
+                region.set_block_at_index_unchecked(support, wx, wy - 1, wz);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn wool() -> Arc<BlockPalette> {
+        Arc::new(BlockPalette::from_block_ids([
+            "minecraft:white_wool",
+            "minecraft:black_wool",
+        ]))
+    }
+
+    fn rgba(pixels: &[[u8; 4]]) -> Vec<u8> {
+        pixels.iter().flatten().copied().collect()
+    }
+
+    #[test]
+    fn flat_images_land_on_the_floor_or_the_wall() {
+        const W: [u8; 4] = [255, 255, 255, 255];
+        const B: [u8; 4] = [0, 0, 0, 255];
+        const T: [u8; 4] = [0, 0, 0, 0];
+        let image = rgba(&[W, B, T, B, W, W]);
+        let name =
+            |s: &UniversalSchematic, x, y, z| s.get_block(x, y, z).map(|b| b.name.to_string());
+
+        let floor = ImageBuilder::new(wool()).build_rgba(&image, 3, 2).unwrap();
+        assert_eq!(
+            name(&floor, 0, 0, 0).as_deref(),
+            Some("minecraft:white_wool")
+        );
+        assert_eq!(
+            name(&floor, 1, 0, 0).as_deref(),
+            Some("minecraft:black_wool")
+        );
+        assert_eq!(
+            name(&floor, 0, 0, 1).as_deref(),
+            Some("minecraft:black_wool")
+        );
+        assert_eq!(floor.default_region.count_non_air_blocks(), 5);
+
+        let wall = ImageBuilder::new(wool())
+            .orientation(ImageOrientation::Wall)
+            .offset(10, 64, 0)
+            .build_rgba(&image, 3, 2)
+            .unwrap();
+        // Top pixel row is the higher one.
+        assert_eq!(
+            name(&wall, 10, 65, 0).as_deref(),
+            Some("minecraft:white_wool")
+        );
+        assert_eq!(
+            name(&wall, 10, 64, 0).as_deref(),
+            Some("minecraft:black_wool")
+        );
+        assert_eq!(
+            name(&wall, 12, 64, 0).as_deref(),
+            Some("minecraft:white_wool")
+        );
+        assert!(ImageBuilder::new(wool()).build_rgba(&image, 4, 2).is_err());
+    }
+
+    #[test]
+    fn staircases_step_by_shade_and_heightmaps_fill_columns() {
+        let white = [255, 255, 255, 255];
+        let dim = [180, 180, 180, 255];
+        // Full white is white wool's light shade, 180 grey its dark one.
+        let image = rgba(&[white, white, dim]);
+        let stairs = ImageBuilder::new(wool())
+            .shading(MapShading::Staircase)
+            .build_rgba(&image, 1, 3)
+            .unwrap();
+        let top = |z| {
+            (0..8)
+                .rev()
+                .find(|&y| {
+                    stairs
+                        .get_block(0, y, z)
+                        .is_some_and(|b| b.name == "minecraft:white_wool")
+                })
+                .unwrap()
+        };
+        assert_eq!(top(1) - top(0), 1);
+        assert_eq!(top(2) - top(1), -1);
+        assert!(stairs
+            .get_block(0, top(0) - 1, -1)
+            .is_some_and(|b| b.name == "minecraft:stone"));
+
+        let terrain = ImageBuilder::new(wool())
+            .build_heightmap(&[3, 0], 2, 1, Some(&rgba(&[[0, 0, 0, 255], white])))
+            .unwrap();
+        let at = |x, y| terrain.get_block(x, y, 0).map(|b| b.name.to_string());
+        assert_eq!(at(0, 0).as_deref(), Some("minecraft:stone"));
+        assert_eq!(at(0, 2).as_deref(), Some("minecraft:black_wool"));
+        assert_eq!(terrain.default_region.count_non_air_blocks(), 3);
+    }
+}
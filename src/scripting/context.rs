@@ -0,0 +1,212 @@
+//! Reusable script VMs with the bindings already registered.
+//!
+//! `run_lua_code` and `run_js_code` build a VM and register the `Schematic`
+//! and palette bindings on every call, which for a short script costs more
+//! than the script. A [`ScriptContext`] warms one VM per engine on first use
+//! and keeps it, restoring the globals after each run so runs cannot see one
+//! another. [`run_code`](super::run_code) goes through one context per
+//! thread; the VMs are not `Send`.
+//!
+//! Each run is held to the context's [`ScriptLimits`].
+//!
+//! ## Compiled scripts
+//!
+//! Each VM keeps the scripts it has compiled, keyed by a hash of the source,
+//! so a template run again skips the compiler. Templates take their inputs
+//! through the `params` global (see [`ScriptContext::run_code_with_params`])
+//! instead of being re-rendered per job, which would defeat the cache.
+
+use crate::scripting::shared::ScriptingSchematic;
+use rustc_hash::{FxHashMap, FxHasher};
+use std::hash::{Hash, Hasher};
+
+#[cfg(feature = "scripting-js")]
+use crate::scripting::js_engine::JsVm;
+#[cfg(feature = "scripting-lua")]
+use crate::scripting::lua_engine::LuaVm;
+
+/// Per-run ceilings; `None` is unlimited.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct ScriptLimits {
+    /// VM instructions a run may execute. Checked every 1000 instructions in
+    /// Lua and every 10000 interrupt ticks (calls and loop iterations) in JS,
+    /// so a run stops at the first check past the limit.
+    pub max_instructions: Option<u64>,
+    /// Bytes the VM heap may grow to, including the bindings.
+    pub max_memory: Option<usize>,
+}
+
+/// Compiled scripts each VM keeps. When full, the cache starts over rather
+/// than tracking recency; job queues cycle through far fewer templates.
+const COMPILED_CAPACITY: usize = 1024;
+
+/// One VM's compiled scripts by source hash. Sources are kept and compared
+/// on a hit, so a hash collision compiles instead of running the wrong
+/// script.
+pub(crate) struct CompiledCache<F> {
+    entries: FxHashMap<u64, (Box<str>, F)>,
+}
+
+impl<F> Default for CompiledCache<F> {
+    fn default() -> Self {
+        Self {
+            entries: FxHashMap::default(),
+        }
+    }
+}
+
+impl<F: Clone> CompiledCache<F> {
+    /// The compiled form of `code`: cached, or `compile(code)` on a miss.
+    pub(crate) fn get_or_compile<E>(
+        &mut self,
+        code: &str,
+        compile: impl FnOnce(&str) -> Result<F, E>,
+    ) -> Result<F, E> {
+        let mut hasher = FxHasher::default();
+        code.hash(&mut hasher);
+        let key = hasher.finish();
+        if let Some((source, compiled)) = self.entries.get(&key) {
+            if **source == *code {
+                return Ok(compiled.clone());
+            }
+        }
+        let compiled = compile(code)?;
+        if self.entries.len() >= COMPILED_CAPACITY {
+            self.entries.clear();
+        }
+        self.entries.insert(key, (code.into(), compiled.clone()));
+        Ok(compiled)
+    }
+
+    pub(crate) fn len(&self) -> usize {
+        self.entries.len()
+    }
+}
+
+/// An engine VM a [`ScriptContext`] can keep between runs.
+pub(crate) trait WarmVm: Sized {
+    /// A fresh VM with the bindings registered.
+    fn warm() -> Result<Self, String>;
+    /// Run `code` with `params` as the `params` global, returning the
+    /// schematic it assigns to `result`.
+    fn run(
+        &mut self,
+        code: &str,
+        limits: &ScriptLimits,
+        params: Option<&serde_json::Value>,
+    ) -> Result<Option<ScriptingSchematic>, String>;
+    /// Scripts compiled and kept so far.
+    fn compiled_scripts(&self) -> usize;
+    /// Put the globals back the way [`warm`](Self::warm) left them.
+    fn reset(&mut self) -> Result<(), String>;
+}
+
+/// Warm script VMs, one per engine, reused across runs.
+#[derive(Default)]
+pub struct ScriptContext {
+    limits: ScriptLimits,
+    #[cfg(feature = "scripting-lua")]
+    lua: Option<LuaVm>,
+    #[cfg(feature = "scripting-js")]
+    js: Option<JsVm>,
+}
+
+impl ScriptContext {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn with_limits(limits: ScriptLimits) -> Self {
+        Self {
+            limits,
+            ..Self::default()
+        }
+    }
+
+    pub fn limits(&self) -> ScriptLimits {
+        self.limits
+    }
+
+    pub fn set_limits(&mut self, limits: ScriptLimits) {
+        self.limits = limits;
+    }
+
+    /// Whether `engine` ("lua" or "js") is compiled in.
+    pub fn supports(engine: &str) -> bool {
+        match engine {
+            "lua" => cfg!(feature = "scripting-lua"),
+            "js" => cfg!(feature = "scripting-js"),
+            _ => false,
+        }
+    }
+
+    /// Run `code` with `engine` ("lua" or "js") on its warm VM, warming one
+    /// first if needed. Returns the schematic the script assigns to `result`.
+    pub fn run_code(
+        &mut self,
+        engine: &str,
+        code: &str,
+    ) -> Result<Option<ScriptingSchematic>, String> {
+        self.run(engine, code, None)
+    }
+
+    /// [`run_code`](Self::run_code) with `params` readable by the script as
+    /// the `params` global (a Lua table or JS object).
+    pub fn run_code_with_params(
+        &mut self,
+        engine: &str,
+        code: &str,
+        params: &serde_json::Value,
+    ) -> Result<Option<ScriptingSchematic>, String> {
+        self.run(engine, code, Some(params))
+    }
+
+    /// Scripts `engine`'s VM has compiled and kept; 0 before its first run.
+    pub fn compiled_scripts(&self, engine: &str) -> usize {
+        match engine {
+            #[cfg(feature = "scripting-lua")]
+            "lua" => self.lua.as_ref().map_or(0, WarmVm::compiled_scripts),
+
+            #[cfg(feature = "scripting-js")]
+            "js" => self.js.as_ref().map_or(0, WarmVm::compiled_scripts),
+
+            _ => 0,
+        }
+    }
+
+    fn run(
+        &mut self,
+        engine: &str,
+        code: &str,
+        params: Option<&serde_json::Value>,
+    ) -> Result<Option<ScriptingSchematic>, String> {
+        match engine {
+            #[cfg(feature = "scripting-lua")]
+            "lua" => run_warm(&mut self.lua, code, &self.limits, params),
+
+            #[cfg(feature = "scripting-js")]
+            "js" => run_warm(&mut self.js, code, &self.limits, params),
+
+            _ => Err(format!("Unsupported scripting engine: {}", engine)),
+        }
+    }
+}
+
+/// Run on the VM in `slot`. A VM that fails to reset is dropped, and the next
+/// run warms a new one.
+fn run_warm<V: WarmVm>(
+    slot: &mut Option<V>,
+    code: &str,
+    limits: &ScriptLimits,
+    params: Option<&serde_json::Value>,
+) -> Result<Option<ScriptingSchematic>, String> {
+    let mut vm = match slot.take() {
+        Some(vm) => vm,
+        None => V::warm()?,
+    };
+    let outcome = vm.run(code, limits, params);
+    if vm.reset().is_ok() {
+        *slot = Some(vm);
+    }
+    outcome
+}
@@ -1,8 +1,15 @@
+use crate::scripting::context::{CompiledCache, ScriptLimits, WarmVm};
 use crate::scripting::shared::ScriptingSchematic;
 use rquickjs::{
-    class::Trace, CatchResultExt, Class, Context, Ctx, Function, JsLifetime, Result as JsResult,
-    Runtime,
+    class::Trace, CatchResultExt, Class, Context, Ctx, FromJs, Function, JsLifetime, Object,
+    Persistent, Result as JsResult, Runtime, TypedArray, Value,
 };
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+
+/// Interrupt ticks QuickJS counts down between calls to the interrupt
+/// handler (`JS_INTERRUPT_COUNTER_INIT`).
+const INTERRUPT_INTERVAL: u64 = 10_000;
 
 #[rquickjs::class]
 pub struct JsSchematic {
@@ -27,6 +34,23 @@ fn make_js_err(msg: &str) -> rquickjs::Error {
     }
 }
 
+/// A numeric buffer argument, given as an `Int32Array` or a plain array.
+fn i32_buffer(value: Value<'_>) -> JsResult<Vec<i32>> {
+    match TypedArray::<i32>::from_js(value.ctx(), value.clone()) {
+        Ok(array) => Ok(array.as_ref().to_vec()),
+        Err(_) => Vec::from_js(value.ctx(), value),
+    }
+}
+
+/// A palette index buffer argument, given as a `Uint32Array` or a plain
+/// array.
+fn u32_buffer(value: Value<'_>) -> JsResult<Vec<u32>> {
+    match TypedArray::<u32>::from_js(value.ctx(), value.clone()) {
+        Ok(array) => Ok(array.as_ref().to_vec()),
+        Err(_) => Vec::from_js(value.ctx(), value),
+    }
+}
+
 #[rquickjs::methods]
 impl JsSchematic {
     // -- Constructor --
@@ -77,6 +101,62 @@ impl JsSchematic {
         self.inner.get_block(x, y, z)
     }
 
+    // -- Bulk --
+    pub fn prepare_block(&mut self, block: String) -> rquickjs::Result<u32> {
+        self.inner
+            .prepare_block(&block)
+            .map_err(|e| make_js_err(&e))
+    }
+
+    pub fn place_batch<'js>(
+        &mut self,
+        positions: Value<'js>,
+        indices: Value<'js>,
+    ) -> rquickjs::Result<usize> {
+        let positions = i32_buffer(positions)?;
+        let indices = u32_buffer(indices)?;
+        self.inner
+            .place_batch(&positions, &indices)
+            .map_err(|e| make_js_err(&e))
+    }
+
+    pub fn read_indices<'js>(
+        &self,
+        ctx: Ctx<'js>,
+        min_x: i32,
+        min_y: i32,
+        min_z: i32,
+        max_x: i32,
+        max_y: i32,
+        max_z: i32,
+    ) -> JsResult<TypedArray<'js, u32>> {
+        let indices = self
+            .inner
+            .read_indices((min_x, min_y, min_z), (max_x, max_y, max_z))
+            .map_err(|e| make_js_err(&e))?;
+        TypedArray::new(ctx, indices)
+    }
+
+    pub fn write_indices<'js>(
+        &mut self,
+        min_x: i32,
+        min_y: i32,
+        min_z: i32,
+        max_x: i32,
+        max_y: i32,
+        max_z: i32,
+        indices: Value<'js>,
+    ) -> rquickjs::Result<()> {
+        let indices = u32_buffer(indices)?;
+        self.inner
+            .write_indices((min_x, min_y, min_z), (max_x, max_y, max_z), &indices)
+            .map_err(|e| make_js_err(&e))
+    }
+
+    pub fn indices_palette(&self) -> Vec<String> {
+        self.inner.indices_palette()
+    }
+
     // -- Building --
     pub fn fill_cuboid(
         &mut self,
@@ -264,32 +344,157 @@ pub fn run_js_script(path: &str) -> Result<Option<ScriptingSchematic>, String> {
 }
 
 /// Run JS source code.
+///
+/// Builds a VM for this one call; [`ScriptContext`](crate::scripting::ScriptContext)
+/// keeps one warm instead.
 pub fn run_js_code(code: &str) -> Result<Option<ScriptingSchematic>, String> {
-    let rt = Runtime::new().map_err(|e| format!("JS runtime error: {}", e))?;
-    let ctx = Context::full(&rt).map_err(|e| format!("JS context error: {}", e))?;
+    JsVm::warm()?.run(code, &ScriptLimits::default(), None)
+}
 
-    ctx.with(|ctx| {
-        setup_js(&ctx).map_err(|e| format!("JS setup error: {}", e))?;
+/// A QuickJS runtime and context with the bindings registered, reusable
+/// across runs.
+///
+/// Scripts run inside a function, so their `let`, `const` and `var`
+/// declarations are locals that go away with the run instead of global
+/// bindings the next run would collide with.
+pub(crate) struct JsVm {
+    /// The enumerable globals as `setup_js` left them. This and `compiled`
+    /// are declared first so they are dropped before the runtime they live in.
+    baseline: Persistent<Object<'static>>,
+    /// Each script compiled to the function it runs in.
+    compiled: CompiledCache<Persistent<Function<'static>>>,
+    context: Context,
+    runtime: Runtime,
+    /// Interrupt handler calls so far this run.
+    interrupts: Arc<AtomicU64>,
+    /// The limits the runtime is configured for.
+    limits: ScriptLimits,
+}
+
+impl JsVm {
+    fn apply_limits(&mut self, limits: &ScriptLimits) {
+        if self.limits == *limits {
+            return;
+        }
+        self.limits = *limits;
+        self.runtime
+            .set_memory_limit(limits.max_memory.unwrap_or(usize::MAX));
+        match limits.max_instructions {
+            Some(max) => {
+                let interrupts = self.interrupts.clone();
+                self.runtime.set_interrupt_handler(Some(Box::new(move || {
+                    interrupts.fetch_add(1, Ordering::Relaxed) * INTERRUPT_INTERVAL >= max
+                })));
+            }
+            None => self.runtime.set_interrupt_handler(None),
+        }
+    }
+}
 
-        // Pre-declare `result` so scripts can assign to it without `var`/`let`
-        ctx.globals()
-            .set("result", rquickjs::Value::new_undefined(ctx.clone()))
+impl WarmVm for JsVm {
+    fn warm() -> Result<Self, String> {
+        let runtime = Runtime::new().map_err(|e| format!("JS runtime error: {}", e))?;
+        let context = Context::full(&runtime).map_err(|e| format!("JS context error: {}", e))?;
+        let baseline = context
+            .with(|ctx| -> JsResult<_> {
+                setup_js(&ctx)?;
+                // Pre-declare `result` so scripts can assign to it without `var`/`let`
+                ctx.globals()
+                    .set("result", Value::new_undefined(ctx.clone()))?;
+                let baseline = Object::new(ctx.clone())?;
+                for prop in ctx.globals().props::<String, Value>() {
+                    let (key, value) = prop?;
+                    baseline.set(key, value)?;
+                }
+                Ok(Persistent::save(&ctx, baseline))
+            })
             .map_err(|e| format!("JS setup error: {}", e))?;
+        Ok(Self {
+            baseline,
+            compiled: CompiledCache::default(),
+            context,
+            runtime,
+            interrupts: Arc::default(),
+            limits: ScriptLimits::default(),
+        })
+    }
 
-        ctx.eval::<(), _>(code)
-            .catch(&ctx)
-            .map_err(|e| format!("JS execution error: {}", e))?;
-
-        // Try to extract a `result` global if set
-        let result: Option<Class<JsSchematic>> = ctx.globals().get("result").ok();
-        match result {
-            Some(cls) => {
-                let borrow = cls.borrow();
-                let cloned = borrow.inner.inner.clone();
-                drop(borrow);
-                Ok(Some(ScriptingSchematic { inner: cloned }))
+    fn run(
+        &mut self,
+        code: &str,
+        limits: &ScriptLimits,
+        params: Option<&serde_json::Value>,
+    ) -> Result<Option<ScriptingSchematic>, String> {
+        self.apply_limits(limits);
+        let params = params.map(serde_json::Value::to_string);
+        let compiled = &mut self.compiled;
+
+        self.context.with(|ctx| {
+            if let Some(params) = params {
+                let params = ctx
+                    .json_parse(params)
+                    .map_err(|e| format!("JS setup error: {}", e))?;
+                ctx.globals()
+                    .set("params", params)
+                    .map_err(|e| format!("JS setup error: {}", e))?;
             }
-            None => Ok(None),
-        }
-    })
+            let script = compiled
+                .get_or_compile(code, |code| {
+                    let source = format!("(function () {{\n{}\n}})", code);
+                    ctx.eval::<Function, _>(source)
+                        .catch(&ctx)
+                        .map(|f| Persistent::save(&ctx, f))
+                        .map_err(|e| format!("JS execution error: {}", e))
+                })?
+                .restore(&ctx)
+                .map_err(|e| format!("JS execution error: {}", e))?;
+            self.interrupts.store(0, Ordering::Relaxed);
+            script
+                .call::<_, ()>(())
+                .catch(&ctx)
+                .map_err(|e| format!("JS execution error: {}", e))?;
+
+            // Try to extract a `result` global if set
+            let result: Option<Class<JsSchematic>> = ctx.globals().get("result").ok();
+            match result {
+                Some(cls) => {
+                    let borrow = cls.borrow();
+                    let cloned = borrow.inner.inner.clone();
+                    drop(borrow);
+                    Ok(Some(ScriptingSchematic { inner: cloned }))
+                }
+                None => Ok(None),
+            }
+        })
+    }
+
+    fn reset(&mut self) -> Result<(), String> {
+        self.context
+            .with(|ctx| -> JsResult<()> {
+                let globals = ctx.globals();
+                let baseline = self.baseline.clone().restore(&ctx)?;
+                let mut added = Vec::new();
+                for key in globals.keys::<String>() {
+                    let key = key?;
+                    if !baseline.contains_key(key.as_str())? {
+                        added.push(key);
+                    }
+                }
+                for key in added {
+                    globals.remove(key)?;
+                }
+                for prop in baseline.props::<String, Value>() {
+                    let (key, value) = prop?;
+                    globals.set(key, value)?;
+                }
+                Ok(())
+            })
+            .map_err(|e| format!("JS reset error: {}", e))?;
+        self.runtime.run_gc();
+        Ok(())
+    }
+
+    fn compiled_scripts(&self) -> usize {
+        self.compiled.len()
+    }
 }
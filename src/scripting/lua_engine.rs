@@ -1,8 +1,12 @@
+use crate::scripting::context::{CompiledCache, ScriptLimits, WarmVm};
 use crate::scripting::shared::ScriptingSchematic;
 use mlua::prelude::*;
-use std::cell::RefCell;
+use std::cell::{Cell, RefCell};
 use std::rc::Rc;
 
+/// Instructions between limit checks.
+const HOOK_INTERVAL: u32 = 1000;
+
 /// Lua-side handle to a ScriptingSchematic, using Rc<RefCell<>> for interior mutability.
 struct LuaSchematic(Rc<RefCell<ScriptingSchematic>>);
 
@@ -39,6 +43,56 @@ impl LuaUserData for LuaSchematic {
             Ok(this.0.borrow().get_block(x, y, z))
         });
 
+        // -- Bulk (indices are 0-based palette indices, not Lua positions) --
+        methods.add_method_mut("prepare_block", |_, this, block: String| {
+            this.0
+                .borrow_mut()
+                .prepare_block(&block)
+                .map_err(LuaError::external)
+        });
+        methods.add_method_mut(
+            "place_batch",
+            |_, this, (positions, indices): (Vec<i32>, Vec<u32>)| {
+                this.0
+                    .borrow_mut()
+                    .place_batch(&positions, &indices)
+                    .map_err(LuaError::external)
+            },
+        );
+        methods.add_method(
+            "read_indices",
+            |_,
+             this,
+             (min_x, min_y, min_z, max_x, max_y, max_z): (i32, i32, i32, i32, i32, i32)| {
+                this.0
+                    .borrow()
+                    .read_indices((min_x, min_y, min_z), (max_x, max_y, max_z))
+                    .map_err(LuaError::external)
+            },
+        );
+        methods.add_method_mut(
+            "write_indices",
+            |_,
+             this,
+             (min_x, min_y, min_z, max_x, max_y, max_z, indices): (
+                i32,
+                i32,
+                i32,
+                i32,
+                i32,
+                i32,
+                Vec<u32>,
+            )| {
+                this.0
+                    .borrow_mut()
+                    .write_indices((min_x, min_y, min_z), (max_x, max_y, max_z), &indices)
+                    .map_err(LuaError::external)
+            },
+        );
+        methods.add_method("indices_palette", |_, this, ()| {
+            Ok(this.0.borrow().indices_palette())
+        });
+
         // -- Building --
         methods.add_method_mut(
             "fill_cuboid",
@@ -253,26 +307,176 @@ pub fn run_lua_script(path: &str) -> Result<Option<ScriptingSchematic>, String>
 
 /// Run Lua source code. If the code assigns to the global `result`, its
 /// inner ScriptingSchematic is extracted and returned.
+///
+/// Builds a VM for this one call; [`ScriptContext`](crate::scripting::ScriptContext)
+/// keeps one warm instead.
 pub fn run_lua_code(code: &str) -> Result<Option<ScriptingSchematic>, String> {
-    let lua = Lua::new();
-    setup_lua(&lua).map_err(|e| format!("Lua setup error: {}", e))?;
+    LuaVm::warm()?.run(code, &ScriptLimits::default(), None)
+}
 
-    lua.load(code)
-        .exec()
-        .map_err(|e| format!("Lua execution error: {}", e))?;
+/// `value` as a Lua value: objects and arrays become tables (arrays
+/// 1-based), null becomes nil.
+fn json_to_lua(lua: &Lua, value: &serde_json::Value) -> LuaResult<LuaValue> {
+    use serde_json::Value as Json;
+    Ok(match value {
+        Json::Null => LuaValue::Nil,
+        Json::Bool(b) => LuaValue::Boolean(*b),
+        Json::Number(n) => match n.as_i64() {
+            Some(i) => LuaValue::Integer(i),
+            None => LuaValue::Number(n.as_f64().unwrap_or(f64::NAN)),
+        },
+        Json::String(s) => LuaValue::String(lua.create_string(s)?),
+        Json::Array(items) => {
+            let table = lua.create_table_with_capacity(items.len(), 0)?;
+            for (i, item) in items.iter().enumerate() {
+                table.raw_set(i + 1, json_to_lua(lua, item)?)?;
+            }
+            LuaValue::Table(table)
+        }
+        Json::Object(fields) => {
+            let table = lua.create_table_with_capacity(0, fields.len())?;
+            for (key, item) in fields {
+                table.raw_set(key.as_str(), json_to_lua(lua, item)?)?;
+            }
+            LuaValue::Table(table)
+        }
+    })
+}
+
+/// A Lua VM with the bindings registered, reusable across runs.
+pub(crate) struct LuaVm {
+    lua: Lua,
+    /// The globals as `setup_lua` left them.
+    baseline: LuaTable,
+    /// Limit checks so far this run, `HOOK_INTERVAL` instructions apart.
+    checks: Rc<Cell<u64>>,
+    /// The limits the hook was installed for.
+    limits: ScriptLimits,
+    compiled: CompiledCache<LuaFunction>,
+}
 
-    // Check if the script set a global `result`
-    let result: Option<mlua::AnyUserData> = lua.globals().get("result").ok();
+impl LuaVm {
+    fn apply_limits(&mut self, limits: &ScriptLimits) -> LuaResult<()> {
+        if self.limits == *limits {
+            return Ok(());
+        }
+        self.limits = *limits;
+        // Where mlua owns the allocator this fails allocations past the limit
+        // outright; the hook below catches the rest.
+        let _ = self.lua.set_memory_limit(limits.max_memory.unwrap_or(0));
+        if limits.max_instructions.is_none() && limits.max_memory.is_none() {
+            self.lua.remove_hook();
+            return self.lua.load("if jit then jit.on() end").exec();
+        }
+        let checks = self.checks.clone();
+        let limits = *limits;
+        self.lua.set_hook(
+            mlua::HookTriggers::new().every_nth_instruction(HOOK_INTERVAL),
+            move |lua, _| {
+                checks.set(checks.get() + 1);
+                if limits
+                    .max_instructions
+                    .is_some_and(|max| checks.get() * HOOK_INTERVAL as u64 > max)
+                {
+                    return Err(LuaError::runtime("instruction limit exceeded"));
+                }
+                if limits.max_memory.is_some_and(|max| lua.used_memory() > max) {
+                    return Err(LuaError::runtime("memory limit exceeded"));
+                }
+                Ok(mlua::VmState::Continue)
+            },
+        );
+        // LuaJIT skips count hooks inside compiled traces, so the hook only
+        // sees every instruction with the JIT off.
+        self.lua
+            .load("if jit then jit.off() jit.flush() end")
+            .exec()
+    }
+}
 
-    match result {
-        Some(ud) => {
-            let ls = ud
-                .borrow::<LuaSchematic>()
-                .map_err(|e| format!("Failed to extract result: {}", e))?;
-            let cloned = ls.0.borrow().inner.clone();
-            drop(ls);
-            Ok(Some(ScriptingSchematic { inner: cloned }))
+impl WarmVm for LuaVm {
+    fn warm() -> Result<Self, String> {
+        let setup_err = |e: LuaError| format!("Lua setup error: {}", e);
+        let lua = Lua::new();
+        setup_lua(&lua).map_err(setup_err)?;
+        let baseline = lua.create_table().map_err(setup_err)?;
+        for pair in lua.globals().pairs::<LuaValue, LuaValue>() {
+            let (key, value) = pair.map_err(setup_err)?;
+            baseline.raw_set(key, value).map_err(setup_err)?;
         }
-        None => Ok(None),
+        Ok(Self {
+            lua,
+            baseline,
+            checks: Rc::default(),
+            limits: ScriptLimits::default(),
+            compiled: CompiledCache::default(),
+        })
+    }
+
+    fn run(
+        &mut self,
+        code: &str,
+        limits: &ScriptLimits,
+        params: Option<&serde_json::Value>,
+    ) -> Result<Option<ScriptingSchematic>, String> {
+        let setup_err = |e: LuaError| format!("Lua setup error: {}", e);
+        self.apply_limits(limits).map_err(setup_err)?;
+        if let Some(params) = params {
+            let params = json_to_lua(&self.lua, params).map_err(setup_err)?;
+            self.lua
+                .globals()
+                .set("params", params)
+                .map_err(setup_err)?;
+        }
+        let chunk = self
+            .compiled
+            .get_or_compile(code, |code| self.lua.load(code).into_function())
+            .map_err(|e| format!("Lua execution error: {}", e))?;
+        self.checks.set(0);
+
+        chunk
+            .call::<()>(())
+            .map_err(|e| format!("Lua execution error: {}", e))?;
+
+        // Check if the script set a global `result`
+        let result: Option<mlua::AnyUserData> = self.lua.globals().get("result").ok();
+
+        match result {
+            Some(ud) => {
+                let ls = ud
+                    .borrow::<LuaSchematic>()
+                    .map_err(|e| format!("Failed to extract result: {}", e))?;
+                let cloned = ls.0.borrow().inner.clone();
+                drop(ls);
+                Ok(Some(ScriptingSchematic { inner: cloned }))
+            }
+            None => Ok(None),
+        }
+    }
+
+    fn reset(&mut self) -> Result<(), String> {
+        let reset = || -> LuaResult<()> {
+            let globals = self.lua.globals();
+            let mut added = Vec::new();
+            for pair in globals.clone().pairs::<LuaValue, LuaValue>() {
+                let (key, _) = pair?;
+                if self.baseline.raw_get::<LuaValue>(key.clone())?.is_nil() {
+                    added.push(key);
+                }
+            }
+            for key in added {
+                globals.raw_set(key, LuaValue::Nil)?;
+            }
+            for pair in self.baseline.clone().pairs::<LuaValue, LuaValue>() {
+                let (key, value) = pair?;
+                globals.raw_set(key, value)?;
+            }
+            self.lua.gc_collect()
+        };
+        reset().map_err(|e| format!("Lua reset error: {}", e))
+    }
+
+    fn compiled_scripts(&self) -> usize {
+        self.compiled.len()
     }
 }
@@ -1,3 +1,4 @@
+pub mod context;
 pub mod shared;
 
 #[cfg(feature = "scripting-lua")]
@@ -6,37 +7,70 @@ pub mod lua_engine;
 #[cfg(feature = "scripting-js")]
 pub mod js_engine;
 
+pub use context::{ScriptContext, ScriptLimits};
 pub use shared::ScriptingSchematic;
 
-/// Auto-detect script engine by file extension and run the script.
+use std::cell::RefCell;
+
+thread_local! {
+    /// The warm VMs behind [`run_code`] and [`run_script`].
+    static CONTEXT: RefCell<ScriptContext> = RefCell::new(ScriptContext::new());
+}
+
+/// Auto-detect script engine by file extension and run the script on this
+/// thread's warm VM, so a script file run again is not recompiled.
 /// Returns the resulting schematic if the script produces one.
 pub fn run_script(path: &str) -> Result<Option<ScriptingSchematic>, String> {
+    let (engine, code) = read_script(path)?;
+    run_code(engine, &code)
+}
+
+/// [`run_script`] with `params` as the script's `params` global.
+pub fn run_script_with_params(
+    path: &str,
+    params: &serde_json::Value,
+) -> Result<Option<ScriptingSchematic>, String> {
+    let (engine, code) = read_script(path)?;
+    run_code_with_params(engine, &code, params)
+}
+
+/// The engine for `path`'s extension and the script's source.
+fn read_script(path: &str) -> Result<(&'static str, String), String> {
     let ext = std::path::Path::new(path)
         .extension()
         .and_then(|s| s.to_str())
         .unwrap_or("")
         .to_lowercase();
 
-    match ext.as_str() {
+    let engine = match ext.as_str() {
         #[cfg(feature = "scripting-lua")]
-        "lua" => lua_engine::run_lua_script(path),
+        "lua" => "lua",
 
         #[cfg(feature = "scripting-js")]
-        "js" => js_engine::run_js_script(path),
+        "js" => "js",
 
-        _ => Err(format!("Unsupported script extension: .{}", ext)),
-    }
+        _ => return Err(format!("Unsupported script extension: .{}", ext)),
+    };
+    let code =
+        std::fs::read_to_string(path).map_err(|e| format!("Failed to read script: {}", e))?;
+    Ok((engine, code))
 }
 
-/// Run code with a specific engine name ("lua" or "js").
+/// Run code with a specific engine name ("lua" or "js"), on this thread's
+/// warm VM for that engine (see [`ScriptContext`]).
 pub fn run_code(engine: &str, code: &str) -> Result<Option<ScriptingSchematic>, String> {
-    match engine {
-        #[cfg(feature = "scripting-lua")]
-        "lua" => lua_engine::run_lua_code(code),
-
-        #[cfg(feature = "scripting-js")]
-        "js" => js_engine::run_js_code(code),
+    CONTEXT.with(|context| context.borrow_mut().run_code(engine, code))
+}
 
-        _ => Err(format!("Unsupported scripting engine: {}", engine)),
-    }
+/// [`run_code`] with `params` as the script's `params` global.
+pub fn run_code_with_params(
+    engine: &str,
+    code: &str,
+    params: &serde_json::Value,
+) -> Result<Option<ScriptingSchematic>, String> {
+    CONTEXT.with(|context| {
+        context
+            .borrow_mut()
+            .run_code_with_params(engine, code, params)
+    })
 }
@@ -1,4 +1,4 @@
-use crate::building::{palette_by_name, BuildingTool, Cuboid, SolidBrush, Sphere};
+use crate::building::{shared_palette_by_name, BuildingTool, Cuboid, SolidBrush, Sphere};
 use crate::formats::manager::get_manager;
 use crate::BlockState;
 use crate::UniversalSchematic;
@@ -14,7 +14,7 @@ pub fn palette_gradient_ids(
     end: (u8, u8, u8),
     steps: usize,
 ) -> Result<Vec<String>, String> {
-    let palette = palette_by_name(name)?;
+    let palette = shared_palette_by_name(name)?;
     if palette.is_empty() {
         return Err(format!("Palette '{name}' is empty"));
     }
@@ -24,7 +24,7 @@ pub fn palette_gradient_ids(
 /// The named preset palette's block ids, sorted by perceptual lightness
 /// (dark → light) — a ready-to-index ramp.
 pub fn palette_block_ids(name: &str) -> Result<Vec<String>, String> {
-    Ok(palette_by_name(name)?
+    Ok(shared_palette_by_name(name)?
         .sorted_by_lightness()
         .block_ids()
         .map(str::to_string)
@@ -34,7 +34,7 @@ pub fn palette_block_ids(name: &str) -> Result<Vec<String>, String> {
 /// The named preset palette's block whose color is closest (Oklab) to the
 /// given RGB.
 pub fn palette_closest_block(name: &str, r: u8, g: u8, b: u8) -> Result<String, String> {
-    palette_by_name(name)?
+    shared_palette_by_name(name)?
         .find_closest(&crate::blockpedia::ExtendedColorData::from_rgb(r, g, b))
         .ok_or_else(|| format!("Palette '{name}' is empty"))
 }
@@ -58,7 +58,6 @@ impl ScriptingSchematic {
     pub fn from_file(path: &str) -> Result<Self, String> {
         let data = std::fs::read(path).map_err(|e| format!("Failed to read file: {}", e))?;
         let manager = get_manager();
-        let manager = manager.lock().map_err(|e| format!("Lock error: {}", e))?;
         let schematic = manager
             .read(&data)
             .map_err(|e| format!("Failed to parse schematic: {}", e))?;
@@ -105,6 +104,119 @@ impl ScriptingSchematic {
         self.inner.get_block(x, y, z).map(|b| b.to_string())
     }
 
+    // -- Bulk --
+    //
+    // Palette-index entry points mirroring the bridge's `prepare_block`,
+    // `place_batch`, `read_indices` and `write_indices`: a script resolves each
+    // block string once and then moves whole buffers of indices per call.
+
+    /// The default region's palette index for `block` (a name or
+    /// `name[k=v,...]`), adding it if missing. Block entity data is not
+    /// accepted here; use `set_block` for those.
+    pub fn prepare_block(&mut self, block: &str) -> Result<u32, String> {
+        let (state, nbt) = UniversalSchematic::parse_block_string(block)?;
+        if nbt.is_some() {
+            return Err(format!("'{block}': block entity data needs set_block"));
+        }
+        Ok(self
+            .inner
+            .default_region
+            .get_or_insert_palette_by_state(&state) as u32)
+    }
+
+    /// Place `indices[i]` (from [`prepare_block`](Self::prepare_block)) at the
+    /// i-th position of the flat `positions` (`[x0, y0, z0, x1, ...]`). Every
+    /// entry is validated first and the region grows once to the batch's
+    /// bounds. Block entities at the positions are removed, as `set_block`
+    /// does. Returns the number of blocks placed.
+    pub fn place_batch(&mut self, positions: &[i32], indices: &[u32]) -> Result<usize, String> {
+        if positions.len() != indices.len() * 3 {
+            return Err(format!(
+                "{} coordinates for {} indices; expected three per index",
+                positions.len(),
+                indices.len()
+            ));
+        }
+        let region = &mut self.inner.default_region;
+        let palette_len = region.palette.len();
+        if let Some(bad) = indices.iter().find(|&&i| i as usize >= palette_len) {
+            return Err(format!(
+                "palette index {bad} out of range (palette has {palette_len} entries)"
+            ));
+        }
+        let Some(first) = positions.chunks_exact(3).next() else {
+            return Ok(0);
+        };
+        let first = (first[0], first[1], first[2]);
+        let (mut min, mut max) = (first, first);
+        for p in positions.chunks_exact(3) {
+            min = (min.0.min(p[0]), min.1.min(p[1]), min.2.min(p[2]));
+            max = (max.0.max(p[0]), max.1.max(p[1]), max.2.max(p[2]));
+        }
+        region.ensure_bounds(min, max);
+        let has_block_entities = !region.block_entities.is_empty();
+        for (p, &index) in positions.chunks_exact(3).zip(indices) {
+            region.set_block_at_index_unchecked(index as usize, p[0], p[1], p[2]);
+            if has_block_entities {
+                region.block_entities.remove(&(p[0], p[1], p[2]));
+            }
+        }
+        Ok(indices.len())
+    }
+
+    /// The default region's palette indices for the inclusive box
+    /// `min..=max`, x fastest, then z, then y. Cells outside the region read
+    /// as air. Indices refer to [`indices_palette`](Self::indices_palette).
+    pub fn read_indices(
+        &self,
+        min: (i32, i32, i32),
+        max: (i32, i32, i32),
+    ) -> Result<Vec<u32>, String> {
+        let volume = crate::region::Region::box_volume(min, max)?;
+        let mut out = vec![0; volume];
+        self.inner
+            .default_region
+            .read_palette_indices(min, max, &mut out)?;
+        Ok(out)
+    }
+
+    /// Overwrite the inclusive box `min..=max` with indices laid out like
+    /// [`read_indices`](Self::read_indices). Every index is validated before
+    /// anything is written. Block entities inside the box are removed.
+    pub fn write_indices(
+        &mut self,
+        min: (i32, i32, i32),
+        max: (i32, i32, i32),
+        indices: &[u32],
+    ) -> Result<(), String> {
+        let region = &mut self.inner.default_region;
+        region.write_palette_indices(min, max, indices)?;
+        let inside: Vec<(i32, i32, i32)> = region
+            .block_entities
+            .keys()
+            .filter(|p| {
+                (min.0..=max.0).contains(&p.0)
+                    && (min.1..=max.1).contains(&p.1)
+                    && (min.2..=max.2).contains(&p.2)
+            })
+            .copied()
+            .collect();
+        for p in inside {
+            region.block_entities.remove(&p);
+        }
+        Ok(())
+    }
+
+    /// The default region's palette as block-state strings, in index order.
+    pub fn indices_palette(&self) -> Vec<String> {
+        self.inner
+            .default_region
+            .palette
+            .iter()
+            .map(|bs| bs.to_string())
+            .collect()
+    }
+
     // -- Building --
 
     pub fn fill_cuboid(&mut self, min: (i32, i32, i32), max: (i32, i32, i32), block_name: &str) {
@@ -165,7 +277,6 @@ impl ScriptingSchematic {
 
     pub fn to_schematic(&self) -> Result<Vec<u8>, String> {
         let manager = get_manager();
-        let manager = manager.lock().map_err(|e| format!("Lock error: {}", e))?;
         manager
             .write("schematic", &self.inner, None)
             .map_err(|e| format!("Export error: {}", e))
@@ -173,7 +284,6 @@ impl ScriptingSchematic {
 
     pub fn to_litematic(&self) -> Result<Vec<u8>, String> {
         let manager = get_manager();
-        let manager = manager.lock().map_err(|e| format!("Lock error: {}", e))?;
         manager
             .write("litematic", &self.inner, None)
             .map_err(|e| format!("Export error: {}", e))
@@ -181,7 +291,6 @@ impl ScriptingSchematic {
 
     pub fn save_as(&self, format: &str) -> Result<Vec<u8>, String> {
         let manager = get_manager();
-        let manager = manager.lock().map_err(|e| format!("Lock error: {}", e))?;
         manager
             .write(format, &self.inner, None)
             .map_err(|e| format!("Export error: {}", e))
@@ -189,7 +298,6 @@ impl ScriptingSchematic {
 
     pub fn save_to_file(&self, path: &str) -> Result<(), String> {
         let manager = get_manager();
-        let manager = manager.lock().map_err(|e| format!("Lock error: {}", e))?;
         let data = manager
             .write_auto(path, &self.inner, None)
             .map_err(|e| format!("Export error: {}", e))?;
@@ -4,7 +4,9 @@
 //! transforms, and seeded noise modifiers ([`SdfNode`]), plus a sampler that
 //! rasterizes a tree into a [`crate::UniversalSchematic`] with declarative
 //! [`MaterialRules`] (depth-based shells, absolute Y bands, noise gates,
-//! palette-driven gradient fills, and surface scatter).
+//! palette-driven gradient fills, and surface scatter). Hot paths evaluate a
+//! tree through [`SdfTape`], which compiles it once into a flat instruction
+//! tape run over packets of points.
 //!
 //! Every binding (FFI, Python, WASM, JVM) exposes the same two entry points:
 //! `from_sdf(sdf_json, rules_json[, bounds])` and `sdf_eval(sdf_json, x, y, z)`,
@@ -36,12 +38,16 @@
 mod node;
 pub mod noise;
 mod sampler;
+mod tape;
 
 pub use node::{Aabb, Axis, SdfNode};
+#[cfg(not(target_arch = "wasm32"))]
+pub use sampler::sample_to_world;
 pub use sampler::{
     auto_bounds, sample_to_schematic, FillRule, GradientAxis, GradientFill, MaterialRules,
     NoiseCondition, PaletteSpec, RampMode, Range, SampleBounds, SurfaceRule, When,
 };
+pub use tape::{SdfTape, PACKET};
 
 #[cfg(test)]
 mod tests;
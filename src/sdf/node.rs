@@ -278,12 +278,12 @@ fn default_octaves() -> u32 {
 }
 
 #[inline]
-fn len3(x: f32, y: f32, z: f32) -> f32 {
+pub(super) fn len3(x: f32, y: f32, z: f32) -> f32 {
     (x * x + y * y + z * z).sqrt()
 }
 
 #[inline]
-fn len2(x: f32, y: f32) -> f32 {
+pub(super) fn len2(x: f32, y: f32) -> f32 {
     (x * x + y * y).sqrt()
 }
 
@@ -294,7 +294,7 @@ fn mix(a: f32, b: f32, t: f32) -> f32 {
 
 /// iq polynomial smooth min.
 #[inline]
-fn smin(a: f32, b: f32, k: f32) -> f32 {
+pub(super) fn smin(a: f32, b: f32, k: f32) -> f32 {
     if k <= 0.0 {
         return a.min(b);
     }
@@ -303,12 +303,12 @@ fn smin(a: f32, b: f32, k: f32) -> f32 {
 }
 
 #[inline]
-fn smax(a: f32, b: f32, k: f32) -> f32 {
+pub(super) fn smax(a: f32, b: f32, k: f32) -> f32 {
     -smin(-a, -b, k)
 }
 
 /// Column-major 3x3 rotation helpers (row-vector free, plain arrays).
-fn rot_matrix(deg: [f32; 3]) -> [[f32; 3]; 3] {
+pub(super) fn rot_matrix(deg: [f32; 3]) -> [[f32; 3]; 3] {
     let (rx, ry, rz) = (
         deg[0].to_radians(),
         deg[1].to_radians(),
@@ -327,7 +327,7 @@ fn rot_matrix(deg: [f32; 3]) -> [[f32; 3]; 3] {
 
 /// Multiply the TRANSPOSE (= inverse for rotations) of `m` with `p`.
 #[inline]
-fn inv_rotate(m: &[[f32; 3]; 3], p: [f32; 3]) -> [f32; 3] {
+pub(super) fn inv_rotate(m: &[[f32; 3]; 3], p: [f32; 3]) -> [f32; 3] {
     [
         m[0][0] * p[0] + m[1][0] * p[1] + m[2][0] * p[2],
         m[0][1] * p[0] + m[1][1] * p[1] + m[2][1] * p[2],
@@ -344,6 +344,39 @@ fn rotate_point(m: &[[f32; 3]; 3], p: [f32; 3]) -> [f32; 3] {
     ]
 }
 
+/// Fold `v` into the repeat cell around the origin (`spacing` ≤ 0 leaves it
+/// alone; `count` clamps the cell index).
+#[inline]
+pub(super) fn repeat_coord(v: f32, s: f32, n: Option<u32>) -> f32 {
+    if s <= 0.0 {
+        return v;
+    }
+    let cell = (v / s).round();
+    let cell = match n {
+        Some(n) => cell.clamp(-(n as f32), n as f32),
+        None => cell,
+    };
+    v - s * cell
+}
+
+/// Domain-warp offset added to the sample point by a `Warp` node.
+#[inline]
+pub(super) fn warp_offset(
+    x: f32,
+    y: f32,
+    z: f32,
+    amplitude: f32,
+    frequency: f32,
+    seed: i32,
+) -> [f32; 3] {
+    let (fx, fy, fz) = (x * frequency, y * frequency, z * frequency);
+    [
+        (value_noise3(fx, fy, fz, seed) * 2.0 - 1.0) * amplitude,
+        (value_noise3(fx, fy, fz, seed.wrapping_add(7919)) * 2.0 - 1.0) * amplitude,
+        (value_noise3(fx, fy, fz, seed.wrapping_add(104_729)) * 2.0 - 1.0) * amplitude,
+    ]
+}
+
 impl SdfNode {
     /// Parse a node tree from its JSON representation.
     pub fn from_json(json: &str) -> Result<SdfNode, String> {
@@ -542,22 +575,11 @@ impl SdfNode {
                 spacing,
                 count,
             } => {
-                let map = |v: f32, s: f32, n: Option<u32>| -> f32 {
-                    if s <= 0.0 {
-                        return v;
-                    }
-                    let cell = (v / s).round();
-                    let cell = match n {
-                        Some(n) => cell.clamp(-(n as f32), n as f32),
-                        None => cell,
-                    };
-                    v - s * cell
-                };
                 let n = count.map(|c| (c[0], c[1], c[2]));
                 child.eval(
-                    map(x, spacing[0], n.map(|c| c.0)),
-                    map(y, spacing[1], n.map(|c| c.1)),
-                    map(z, spacing[2], n.map(|c| c.2)),
+                    repeat_coord(x, spacing[0], n.map(|c| c.0)),
+                    repeat_coord(y, spacing[1], n.map(|c| c.1)),
+                    repeat_coord(z, spacing[2], n.map(|c| c.2)),
                 )
             }
 
@@ -575,25 +597,7 @@ impl SdfNode {
                 frequency,
                 seed,
             } => {
-                let wx = (value_noise3(x * frequency, y * frequency, z * frequency, *seed) * 2.0
-                    - 1.0)
-                    * amplitude;
-                let wy = (value_noise3(
-                    x * frequency,
-                    y * frequency,
-                    z * frequency,
-                    seed.wrapping_add(7919),
-                ) * 2.0
-                    - 1.0)
-                    * amplitude;
-                let wz = (value_noise3(
-                    x * frequency,
-                    y * frequency,
-                    z * frequency,
-                    seed.wrapping_add(104_729),
-                ) * 2.0
-                    - 1.0)
-                    * amplitude;
+                let [wx, wy, wz] = warp_offset(x, y, z, *amplitude, *frequency, *seed);
                 child.eval(x + wx, y + wy, z + wz)
             }
             SdfNode::Cells {
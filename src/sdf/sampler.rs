@@ -7,9 +7,14 @@
 
 use super::node::SdfNode;
 use super::noise::{fbm2, hash01_2, hash01_3};
+use super::tape::SdfTape;
 use crate::building::{palette_by_name, BlockPalette};
-use crate::UniversalSchematic;
+#[cfg(not(target_arch = "wasm32"))]
+use crate::formats::world_stream::{ShardedWorldSink, WorldChunkView};
+use crate::{BlockState, UniversalSchematic};
+use rayon::prelude::*;
 use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
 
 /// Inclusive numeric range; either bound may be omitted.
 #[derive(Debug, Clone, Default, Serialize, Deserialize)]
@@ -185,18 +190,19 @@ struct ResolvedGradient {
 }
 
 impl ResolvedGradient {
-    fn pick(&self, x: i32, y: i32, z: i32, depth: i32) -> &str {
+    /// Index into `ids` of the step at this voxel.
+    fn step(&self, x: i32, y: i32, z: i32, depth: i32) -> usize {
         let v = match self.axis {
             GradientAxis::Y => y,
             GradientAxis::Depth => depth,
         };
         if self.max == self.min || self.ids.len() == 1 {
-            return &self.ids[0];
+            return 0;
         }
         let t = ((v - self.min) as f32 / (self.max - self.min) as f32).clamp(0.0, 1.0);
         let pos = t * (self.ids.len() - 1) as f32;
         if !self.dither {
-            return &self.ids[pos.round() as usize];
+            return pos.round() as usize;
         }
         // Ordered dithering between the two neighboring steps: the
         // fractional position becomes a per-voxel Bayer-thresholded choice.
@@ -213,9 +219,9 @@ impl ResolvedGradient {
         let bz = ((z + (y >> 2)) & 3) as usize;
         let threshold = (BAYER[bx][bz] + 0.5) / 16.0;
         if frac > threshold {
-            &self.ids[hi]
+            hi
         } else {
-            &self.ids[lo]
+            lo
         }
     }
 }
@@ -293,7 +299,167 @@ pub fn auto_bounds(node: &SdfNode) -> Result<SampleBounds, String> {
     })
 }
 
-const MAX_SAMPLE_VOLUME: i64 = 512 * 512 * 512;
+/// Octree pruning makes empty and solid space nearly free, so the cap
+/// guards pathological requests rather than ordinary terrain.
+const MAX_SAMPLE_VOLUME: i64 = 4096 * 4096 * 4096;
+
+/// Columns classified together; blocks are still emitted in x-then-z order.
+const SLAB: i32 = 16;
+/// Octree cells no longer than this on every axis are sampled voxel by voxel.
+const LEAF_EDGE: i32 = 8;
+
+/// Hierarchical inside/outside classification of one x-slab of the sampling
+/// volume. Each octree cell is bounded with [`SdfTape::eval_interval`] over
+/// its voxel centers: cells wholly outside are dropped, cells wholly inside
+/// become solid spans, and only cells straddling the surface are subdivided
+/// down to [`LEAF_EDGE`] and evaluated per voxel. The result per column is
+/// the same set of solid voxels a dense scan finds.
+struct Octree<'a> {
+    tape: &'a SdfTape,
+    bounds: SampleBounds,
+    slab_x: i32,
+    /// Solid `(bottom, top)` y-spans per slab column, indexed
+    /// `(x - slab_x) * depth + (z - min_z)`; sorted and merged after
+    /// classification.
+    spans: Vec<Vec<(i32, i32)>>,
+    xs: Vec<f32>,
+    ys: Vec<f32>,
+    zs: Vec<f32>,
+    dist: Vec<f32>,
+}
+
+impl<'a> Octree<'a> {
+    fn new(tape: &'a SdfTape, bounds: SampleBounds) -> Self {
+        Octree {
+            tape,
+            bounds,
+            slab_x: bounds.min[0],
+            spans: Vec::new(),
+            xs: Vec::new(),
+            ys: Vec::new(),
+            zs: Vec::new(),
+            dist: Vec::new(),
+        }
+    }
+
+    fn depth(&self) -> usize {
+        (self.bounds.max[2] - self.bounds.min[2] + 1) as usize
+    }
+
+    fn index(&self, x: i32, z: i32) -> usize {
+        (x - self.slab_x) as usize * self.depth() + (z - self.bounds.min[2]) as usize
+    }
+
+    /// Solid runs of column `(x, z)`, bottom first, none touching.
+    fn runs(&self, x: i32, z: i32) -> &[(i32, i32)] {
+        &self.spans[self.index(x, z)]
+    }
+
+    fn classify_slab(&mut self, x0: i32, x1: i32) {
+        self.slab_x = x0;
+        let columns = (x1 - x0 + 1) as usize * self.depth();
+        self.spans.iter_mut().for_each(Vec::clear);
+        self.spans.resize_with(columns, Vec::new);
+        let (min, max) = (self.bounds.min, self.bounds.max);
+        self.visit([x0, min[1], min[2]], [x1, max[1], max[2]]);
+        for spans in &mut self.spans[..columns] {
+            spans.sort_unstable();
+            let mut merged: Vec<(i32, i32)> = Vec::with_capacity(spans.len());
+            for &(lo, hi) in spans.iter() {
+                match merged.last_mut() {
+                    Some(last) if lo <= last.1 + 1 => last.1 = last.1.max(hi),
+                    _ => merged.push((lo, hi)),
+                }
+            }
+            *spans = merged;
+        }
+    }
+
+    fn visit(&mut self, lo: [i32; 3], hi: [i32; 3]) {
+        let centers = |v: [i32; 3]| [v[0] as f32 + 0.5, v[1] as f32 + 0.5, v[2] as f32 + 0.5];
+        let (min, max) = (centers(lo), centers(hi));
+        let (d_lo, d_hi) = self.tape.eval_interval(min, max);
+        // Interval bounds are exact up to float rounding, which grows with
+        // the coordinates; cells this close to zero are sampled instead.
+        let scale = (0..3).fold(1.0f32, |m, a| m.max(min[a].abs()).max(max[a].abs()));
+        let margin = 1e-4 * scale;
+        if d_lo > margin {
+            return;
+        }
+        if d_hi < -margin {
+            for x in lo[0]..=hi[0] {
+                for z in lo[2]..=hi[2] {
+                    let i = self.index(x, z);
+                    self.spans[i].push((lo[1], hi[1]));
+                }
+            }
+            return;
+        }
+        if (0..3).all(|a| hi[a] - lo[a] < LEAF_EDGE) {
+            self.sample(lo, hi);
+            return;
+        }
+        // Halve every axis longer than one voxel.
+        let halves = |a: usize| {
+            if hi[a] > lo[a] {
+                let mid = lo[a] + (hi[a] - lo[a]) / 2;
+                vec![(lo[a], mid), (mid + 1, hi[a])]
+            } else {
+                vec![(lo[a], hi[a])]
+            }
+        };
+        for &(x0, x1) in &halves(0) {
+            for &(y0, y1) in &halves(1) {
+                for &(z0, z1) in &halves(2) {
+                    self.visit([x0, y0, z0], [x1, y1, z1]);
+                }
+            }
+        }
+    }
+
+    /// Evaluate every voxel center of a leaf cell in one batch.
+    fn sample(&mut self, lo: [i32; 3], hi: [i32; 3]) {
+        self.xs.clear();
+        self.ys.clear();
+        self.zs.clear();
+        for x in lo[0]..=hi[0] {
+            for z in lo[2]..=hi[2] {
+                for y in lo[1]..=hi[1] {
+                    self.xs.push(x as f32 + 0.5);
+                    self.ys.push(y as f32 + 0.5);
+                    self.zs.push(z as f32 + 0.5);
+                }
+            }
+        }
+        self.dist.resize(self.xs.len(), 0.0);
+        self.tape
+            .eval_batch(&self.xs, &self.ys, &self.zs, &mut self.dist);
+        let height = (hi[1] - lo[1] + 1) as usize;
+        let mut i = 0;
+        for x in lo[0]..=hi[0] {
+            for z in lo[2]..=hi[2] {
+                let at = self.index(x, z);
+                let spans = &mut self.spans[at];
+                let column = &self.dist[i..i + height];
+                i += height;
+                let mut run: Option<i32> = None;
+                for (y, d) in (lo[1]..).zip(column) {
+                    match (*d <= 0.0, run) {
+                        (true, None) => run = Some(y),
+                        (false, Some(start)) => {
+                            spans.push((start, y - 1));
+                            run = None;
+                        }
+                        _ => {}
+                    }
+                }
+                if let Some(start) = run {
+                    spans.push((start, hi[1]));
+                }
+            }
+        }
+    }
+}
 
 /// Sample the SDF into a new schematic. Blocks are placed at integer
 /// coordinates whose cell center (x+0.5, y+0.5, z+0.5) lies inside the
@@ -304,15 +470,7 @@ pub fn sample_to_schematic(
     bounds: Option<SampleBounds>,
     name: &str,
 ) -> Result<UniversalSchematic, String> {
-    let bounds = match bounds {
-        Some(b) => b,
-        None => auto_bounds(node)?,
-    };
-    for a in 0..3 {
-        if bounds.min[a] > bounds.max[a] {
-            return Err(format!("Degenerate sampling bounds on axis {a}"));
-        }
-    }
+    let bounds = checked_bounds(node, bounds)?;
     let volume = (bounds.max[0] - bounds.min[0] + 1) as i64
         * (bounds.max[1] - bounds.min[1] + 1) as i64
         * (bounds.max[2] - bounds.min[2] + 1) as i64;
@@ -322,75 +480,146 @@ pub fn sample_to_schematic(
         ));
     }
 
-    // Validate every fill rule up front and pre-resolve gradients into
-    // ready-to-index block ramps (one find_closest per ramp step, not per
-    // sampled position).
-    let resolved: Vec<Option<ResolvedGradient>> = rules
-        .fill
-        .iter()
-        .map(resolve_fill)
-        .collect::<Result<_, String>>()?;
-
+    let resolved = resolve_fills(rules)?;
+    let materials = Materials::new(rules, &resolved);
+    let tape = SdfTape::compile(node);
     let mut schematic = UniversalSchematic::new(name.to_string());
-    let default_fill = "minecraft:stone";
-    let height = (bounds.max[1] - bounds.min[1] + 1) as usize;
-    let mut solid = vec![false; height];
+    let mut palette: Vec<Option<usize>> = vec![None; materials.names.len()];
+
+    // Slabs sample in parallel; each batch is written in slab order so the
+    // schematic (palette order included) matches a sequential x-then-z scan.
+    let slabs: Vec<i32> = (bounds.min[0]..=bounds.max[0])
+        .step_by(SLAB as usize)
+        .collect();
+    let batch = rayon::current_num_threads().max(1) * 2;
+    for group in slabs.chunks(batch) {
+        let tiles: Vec<Tile> = group
+            .par_iter()
+            .map(|&x0| sample_slab(&tape, rules, &resolved, &materials, bounds, x0))
+            .collect();
+        let Some((min, max)) = tiles.iter().filter_map(|t| t.bounds).reduce(union_span) else {
+            continue;
+        };
+        if schematic.default_region.is_empty() {
+            // An empty region is rebuilt by ensure_bounds, palette and all.
+            palette.fill(None);
+        }
+        schematic.ensure_bounds(min, max);
+        for tile in &tiles {
+            tile.write(&mut schematic, &materials, &mut palette);
+        }
+    }
 
-    for x in bounds.min[0]..=bounds.max[0] {
-        for z in bounds.min[2]..=bounds.max[2] {
-            let fx = x as f32 + 0.5;
-            let fz = z as f32 + 0.5;
+    Ok(schematic)
+}
 
-            for (i, s) in solid.iter_mut().enumerate() {
-                let y = bounds.min[1] + i as i32;
-                *s = node.eval(fx, y as f32 + 0.5, fz) <= 0.0;
+/// Sample the SDF straight into a world, chunk column by chunk column,
+/// without building a schematic. Each rayon task classifies and
+/// material-fills one 16×16 column of the sampling box exactly as
+/// [`sample_to_schematic`] would, and hands the finished chunk to `sink`.
+/// Peak sampling memory is one chunk column per thread (plus the regions
+/// `sink` buffers), so the volume is not capped.
+///
+/// Chunks are produced region by region in order, so each region fills up
+/// and is written once; blocks are identical to the schematic path.
+/// Block-entity NBT in rule block strings is not carried into the world.
+/// The caller still calls [`ShardedWorldSink::finish`].
+#[cfg(not(target_arch = "wasm32"))]
+pub fn sample_to_world(
+    node: &SdfNode,
+    rules: &MaterialRules,
+    bounds: Option<SampleBounds>,
+    sink: &ShardedWorldSink,
+) -> Result<(), String> {
+    let bounds = checked_bounds(node, bounds)?;
+    let resolved = resolve_fills(rules)?;
+    let materials = Materials::new(rules, &resolved);
+    let tape = SdfTape::compile(node);
+    // Names the block-string parser rejects are skipped, as set_block_str
+    // skips them on the schematic path.
+    let blocks: Vec<Option<BlockState>> = materials
+        .names
+        .iter()
+        .map(|name| {
+            if name.contains(['[', ']', '{', '}']) {
+                UniversalSchematic::parse_block_string(name)
+                    .ok()
+                    .map(|(state, _)| state)
+            } else {
+                Some(BlockState::new(name.to_string()))
             }
-
-            // Walk runs top→bottom; depth is measured from each run's top.
-            let mut i = height as i32 - 1;
-            while i >= 0 {
-                if !solid[i as usize] {
-                    i -= 1;
-                    continue;
+        })
+        .collect();
+
+    let chunk = |v: i32| v.div_euclid(16);
+    let (cx0, cx1) = (chunk(bounds.min[0]), chunk(bounds.max[0]));
+    let (cz0, cz1) = (chunk(bounds.min[2]), chunk(bounds.max[2]));
+    for rz in cz0.div_euclid(32)..=cz1.div_euclid(32) {
+        for rx in cx0.div_euclid(32)..=cx1.div_euclid(32) {
+            let chunks: Vec<(i32, i32)> = (cz0.max(rz * 32)..=cz1.min(rz * 32 + 31))
+                .flat_map(|cz| (cx0.max(rx * 32)..=cx1.min(rx * 32 + 31)).map(move |cx| (cx, cz)))
+                .collect();
+            chunks.par_iter().try_for_each(|&(cx, cz)| {
+                let column = SampleBounds {
+                    min: [
+                        (cx * 16).max(bounds.min[0]),
+                        bounds.min[1],
+                        (cz * 16).max(bounds.min[2]),
+                    ],
+                    max: [
+                        (cx * 16 + 15).min(bounds.max[0]),
+                        bounds.max[1],
+                        (cz * 16 + 15).min(bounds.max[2]),
+                    ],
+                };
+                let tile = sample_slab(&tape, rules, &resolved, &materials, column, column.min[0]);
+                if tile.runs.is_empty() {
+                    return Ok(());
                 }
-                let run_top = i;
-                while i >= 0 && solid[i as usize] {
-                    i -= 1;
-                }
-                let run_bottom = i + 1;
-
-                let surface_y = bounds.min[1] + run_top;
-                let mut surface_block: Option<&str> = None;
-                for yi in (run_bottom..=run_top).rev() {
-                    let y = bounds.min[1] + yi;
-                    let depth = surface_y - y;
-                    let block = pick_fill(rules, &resolved, x, y, z, depth).unwrap_or(default_fill);
-                    if yi == run_top {
-                        surface_block = Some(block);
+                let mut view = WorldChunkView::new(cx, cz);
+                tile.for_each_block(|x, y, z, id| {
+                    if let Some(block) = &blocks[id as usize] {
+                        view.set_block(x, y, z, block);
                     }
-                    schematic.set_block_str(x, y, z, block);
-                }
+                });
+                sink.write_chunk(&view).map_err(|e| e.to_string())
+            })?;
+        }
+    }
+    Ok(())
+}
 
-                // Decorations sit on the air block above the run top.
-                if (run_top as usize) < height - 1 || surface_y == bounds.max[1] {
-                    apply_surface(rules, &mut schematic, x, surface_y, z, surface_block);
-                }
-            }
+/// Explicit or automatic sampling bounds, rejected when empty on any axis.
+fn checked_bounds(node: &SdfNode, bounds: Option<SampleBounds>) -> Result<SampleBounds, String> {
+    let bounds = match bounds {
+        Some(b) => b,
+        None => auto_bounds(node)?,
+    };
+    for a in 0..3 {
+        if bounds.min[a] > bounds.max[a] {
+            return Err(format!("Degenerate sampling bounds on axis {a}"));
         }
     }
+    Ok(bounds)
+}
 
-    Ok(schematic)
+/// Validate every fill rule up front and pre-resolve gradients into
+/// ready-to-index block ramps (one find_closest per ramp step, not per
+/// sampled position).
+fn resolve_fills(rules: &MaterialRules) -> Result<Vec<Option<ResolvedGradient>>, String> {
+    rules.fill.iter().map(resolve_fill).collect()
 }
 
-fn pick_fill<'a>(
-    rules: &'a MaterialRules,
-    resolved: &'a [Option<ResolvedGradient>],
+fn pick_fill(
+    rules: &MaterialRules,
+    resolved: &[Option<ResolvedGradient>],
+    materials: &Materials,
     x: i32,
     y: i32,
     z: i32,
     depth: i32,
-) -> Option<&'a str> {
-    for (rule, gradient) in rules.fill.iter().zip(resolved) {
+) -> Option<u32> {
+    for (i, (rule, gradient)) in rules.fill.iter().zip(resolved).enumerate() {
         let matches = match &rule.when {
             None => true,
             Some(w) => {
@@ -405,29 +634,29 @@ fn pick_fill<'a>(
         };
         if matches {
             return Some(match gradient {
-                Some(g) => g.pick(x, y, z, depth),
-                // resolve_fill guarantees a rule without gradient has a block.
-                None => rule.block.as_deref().unwrap_or(""),
+                Some(g) => materials.fill[i][g.step(x, y, z, depth)],
+                None => materials.fill[i][0],
             });
         }
     }
     None
 }
 
-fn apply_surface(
+/// The scatter block decorating the run whose top is at `surface_y`, if any.
+fn pick_surface(
     rules: &MaterialRules,
-    schematic: &mut UniversalSchematic,
+    materials: &Materials,
     x: i32,
     surface_y: i32,
     z: i32,
-    surface_block: Option<&str>,
-) {
-    for rule in &rules.surface {
+    surface_block: u32,
+) -> Option<u32> {
+    for (i, rule) in rules.surface.iter().enumerate() {
         if rule.blocks.is_empty() || rule.density <= 0.0 {
             continue;
         }
-        if let (Some(on), Some(sb)) = (&rule.on, surface_block) {
-            if !sb.starts_with(on.as_str()) {
+        if let Some(on) = &rule.on {
+            if !materials.names[surface_block as usize].starts_with(on.as_str()) {
                 continue;
             }
         }
@@ -439,8 +668,170 @@ fn apply_surface(
                 rule.seed.wrapping_add(1),
             );
             let idx = ((pick * rule.blocks.len() as f32) as usize).min(rule.blocks.len() - 1);
-            schematic.set_block_str(x, surface_y + 1, z, &rule.blocks[idx]);
-            return; // first matching scatter rule wins per column
+            return Some(materials.surface[i][idx]); // first matching scatter rule wins per column
+        }
+    }
+    None
+}
+
+const DEFAULT_FILL: &str = "minecraft:stone";
+
+/// Every block name the rules can place, interned up front so sampling
+/// threads emit compact ids and each name meets the palette once.
+struct Materials<'a> {
+    names: Vec<&'a str>,
+    /// Per fill rule: its block, or its gradient's steps.
+    fill: Vec<Vec<u32>>,
+    /// Per surface rule: its scatter blocks.
+    surface: Vec<Vec<u32>>,
+    default: u32,
+}
+
+impl<'a> Materials<'a> {
+    fn new(rules: &'a MaterialRules, resolved: &'a [Option<ResolvedGradient>]) -> Self {
+        let mut index: HashMap<&'a str, u32> = HashMap::new();
+        let mut names = Vec::new();
+        let mut intern = |name: &'a str| {
+            *index.entry(name).or_insert_with(|| {
+                names.push(name);
+                (names.len() - 1) as u32
+            })
+        };
+        let default = intern(DEFAULT_FILL);
+        let fill = rules
+            .fill
+            .iter()
+            .zip(resolved)
+            .map(|(rule, gradient)| match gradient {
+                Some(g) => g.ids.iter().map(|id| intern(id)).collect(),
+                // resolve_fill guarantees a rule without gradient has a block.
+                None => vec![intern(rule.block.as_deref().unwrap_or(""))],
+            })
+            .collect();
+        let surface = rules
+            .surface
+            .iter()
+            .map(|rule| rule.blocks.iter().map(|b| intern(b)).collect())
+            .collect();
+        Materials {
+            names,
+            fill,
+            surface,
+            default,
+        }
+    }
+}
+
+/// Inclusive `(min, max)` corners of a box of blocks.
+type Span = ((i32, i32, i32), (i32, i32, i32));
+
+fn union_span((a0, a1): Span, (b0, b1): Span) -> Span {
+    (
+        (a0.0.min(b0.0), a0.1.min(b0.1), a0.2.min(b0.2)),
+        (a1.0.max(b1.0), a1.1.max(b1.1), a1.2.max(b1.2)),
+    )
+}
+
+/// One solid run of a sampled column.
+struct TileRun {
+    x: i32,
+    z: i32,
+    top: i32,
+    /// Cells in the run; their ids follow top-down in [`Tile::cells`].
+    len: usize,
+    decoration: Option<u32>,
+}
+
+/// One slab's sampled blocks as material ids, in placement order.
+#[derive(Default)]
+struct Tile {
+    runs: Vec<TileRun>,
+    cells: Vec<u32>,
+    /// Inclusive bounds of everything placed, decorations included.
+    bounds: Option<Span>,
+}
+
+impl Tile {
+    fn include(&mut self, span: Span) {
+        self.bounds = Some(match self.bounds {
+            None => span,
+            Some(b) => union_span(b, span),
+        });
+    }
+
+    /// Place the tile's blocks. The schematic must already cover
+    /// [`Self::bounds`]; `palette` caches each material's palette index.
+    fn write(
+        &self,
+        schematic: &mut UniversalSchematic,
+        materials: &Materials,
+        palette: &mut [Option<usize>],
+    ) {
+        let mut place = |x: i32, y: i32, z: i32, id: u32| {
+            let name = materials.names[id as usize];
+            // Property and NBT strings go through the block-string parser.
+            if name.contains(['[', ']', '{', '}']) {
+                schematic.set_block_str(x, y, z, name);
+                return;
+            }
+            let region = &mut schematic.default_region;
+            let index = *palette[id as usize].get_or_insert_with(|| {
+                region.get_or_insert_palette_by_state(&BlockState::new(name.to_string()))
+            });
+            region.set_block_at_index_unchecked(index, x, y, z);
+        };
+        self.for_each_block(&mut place);
+    }
+
+    /// Every placed block as `(x, y, z, material id)`, in placement order.
+    fn for_each_block(&self, mut f: impl FnMut(i32, i32, i32, u32)) {
+        let mut cells = self.cells.iter();
+        for run in &self.runs {
+            for (y, &id) in (0..run.len).map(|k| run.top - k as i32).zip(&mut cells) {
+                f(run.x, y, run.z, id);
+            }
+            if let Some(id) = run.decoration {
+                f(run.x, run.top + 1, run.z, id);
+            }
+        }
+    }
+}
+
+/// Classify and material-fill the `SLAB` columns starting at `x0`.
+fn sample_slab(
+    tape: &SdfTape,
+    rules: &MaterialRules,
+    resolved: &[Option<ResolvedGradient>],
+    materials: &Materials,
+    bounds: SampleBounds,
+    x0: i32,
+) -> Tile {
+    let x1 = (x0 + SLAB - 1).min(bounds.max[0]);
+    let mut octree = Octree::new(tape, bounds);
+    octree.classify_slab(x0, x1);
+    let mut tile = Tile::default();
+    for x in x0..=x1 {
+        for z in bounds.min[2]..=bounds.max[2] {
+            // Walk runs top→bottom; depth is measured from each run's top.
+            for &(bottom, top) in octree.runs(x, z).iter().rev() {
+                for y in (bottom..=top).rev() {
+                    let id = pick_fill(rules, resolved, materials, x, y, z, top - y)
+                        .unwrap_or(materials.default);
+                    tile.cells.push(id);
+                }
+                let surface = tile.cells[tile.cells.len() - (top - bottom + 1) as usize];
+                // Decorations sit on the air block above the run top.
+                let decoration = pick_surface(rules, materials, x, top, z, surface);
+                tile.include(((x, bottom, z), (x, top + decoration.is_some() as i32, z)));
+                tile.runs.push(TileRun {
+                    x,
+                    z,
+                    top,
+                    len: (top - bottom + 1) as usize,
+                    decoration,
+                });
+            }
         }
     }
+    tile
 }
@@ -0,0 +1,963 @@
+//! Compiled SDF evaluation: a [`SdfNode`] tree flattened into a linear tape
+//! of instructions that runs over packets of points.
+//!
+//! Walking the tree costs a match and a pointer chase per node per point, and
+//! [`SdfNode::eval`] recomputes per-node constants (rotation matrices, box
+//! insets, capsule axes) on every call. [`SdfTape::compile`] does that work
+//! once: constants are folded into the instructions and identity transforms
+//! are dropped. Evaluation then runs each instruction as a tight loop over up
+//! to [`PACKET`] points held in structure-of-arrays registers, which the
+//! compiler vectorizes.
+//!
+//! [`SdfTape::eval_interval`] runs the same tape over a box instead of a
+//! point, bounding the distance so samplers can skip space that is wholly
+//! inside or outside the surface.
+//!
+//! Every instruction performs the same float operations in the same order as
+//! the tree walk, so a tape's distances are bit-for-bit those of
+//! [`SdfNode::eval`] and sampling stays deterministic.
+
+use super::node::{
+    inv_rotate, len2, len3, repeat_coord, rot_matrix, smax, smin, warp_offset, Axis, CellMode,
+};
+use super::noise::fbm3;
+use super::SdfNode;
+
+/// Points evaluated per instruction dispatch.
+pub const PACKET: usize = 64;
+
+/// A coordinate transform; pushes a new frame derived from the current one.
+#[derive(Debug, Clone)]
+enum Frame {
+    Translate([f32; 3]),
+    Rotate([[f32; 3]; 3]),
+    /// Divides by the (already zero-guarded) factor.
+    Scale(f32),
+    Mirror(usize),
+    Repeat {
+        spacing: [f32; 3],
+        count: Option<[u32; 3]>,
+    },
+    Warp {
+        amplitude: f32,
+        frequency: f32,
+        seed: i32,
+    },
+}
+
+/// A primitive evaluated at the current frame, with its constants folded.
+#[derive(Debug, Clone)]
+enum Prim {
+    Sphere {
+        radius: f32,
+    },
+    Box {
+        /// `half_extents - r`.
+        inner: [f32; 3],
+        r: f32,
+    },
+    Torus {
+        major: f32,
+        minor: f32,
+    },
+    Capsule {
+        a: [f32; 3],
+        ba: [f32; 3],
+        /// `|ba|²`, or `None` for a degenerate segment.
+        dot_ba: Option<f32>,
+        radius: f32,
+    },
+    CappedCylinder {
+        radius: f32,
+        half_height: f32,
+    },
+    Plane {
+        normal: [f32; 3],
+        /// `max(|normal|, 1e-9)`.
+        len: f32,
+        offset: f32,
+    },
+    Ellipsoid {
+        radii: [f32; 3],
+        /// Squared radii.
+        radii2: [f32; 3],
+        /// Distance at the center, where the gradient term vanishes.
+        center: f32,
+    },
+    /// Branchy or rarely hot primitives evaluated point by point.
+    Leaf(SdfNode),
+}
+
+/// Pops `b`, then combines it into `a` on top of the stack.
+#[derive(Debug, Clone, Copy)]
+enum Binary {
+    Min,
+    Max,
+    Subtract,
+    SmoothUnion(f32),
+    SmoothSubtract(f32),
+    SmoothIntersect(f32),
+}
+
+/// Rewrites the top value in place.
+#[derive(Debug, Clone, Copy)]
+enum Unary {
+    /// `d - radius`.
+    Round(f32),
+    /// `|d| - thickness`.
+    Shell(f32),
+    /// `d * factor`, closing a `Scale` frame.
+    Mul(f32),
+    /// `d + fbm(p) * amplitude` at the current frame.
+    Displace {
+        amplitude: f32,
+        frequency: f32,
+        seed: i32,
+        octaves: u32,
+    },
+}
+
+#[derive(Debug, Clone)]
+enum Op {
+    Push(Frame),
+    Pop,
+    Const(f32),
+    Prim(Prim),
+    Binary(Binary),
+    Unary(Unary),
+}
+
+/// An [`SdfNode`] tree compiled for repeated evaluation.
+#[derive(Debug, Clone)]
+pub struct SdfTape {
+    ops: Vec<Op>,
+    /// Deepest frame index (0 is the input points).
+    frames: usize,
+    /// Deepest value stack.
+    values: usize,
+}
+
+#[derive(Default)]
+struct Compiler {
+    ops: Vec<Op>,
+    frame: usize,
+    value: usize,
+    max_frame: usize,
+    max_value: usize,
+}
+
+impl Compiler {
+    fn emit(&mut self, op: Op) {
+        match &op {
+            Op::Push(_) => {
+                self.frame += 1;
+                self.max_frame = self.max_frame.max(self.frame);
+            }
+            Op::Pop => self.frame -= 1,
+            Op::Const(_) | Op::Prim(_) => {
+                self.value += 1;
+                self.max_value = self.max_value.max(self.value);
+            }
+            Op::Binary(_) => self.value -= 1,
+            Op::Unary(_) => {}
+        }
+        self.ops.push(op);
+    }
+
+    fn framed(&mut self, frame: Frame, child: &SdfNode) {
+        self.emit(Op::Push(frame));
+        self.node(child);
+        self.emit(Op::Pop);
+    }
+
+    fn binary(&mut self, a: &SdfNode, b: &SdfNode, op: Binary) {
+        self.node(a);
+        self.node(b);
+        self.emit(Op::Binary(op));
+    }
+
+    fn node(&mut self, node: &SdfNode) {
+        match node {
+            SdfNode::Sphere { radius } => self.emit(Op::Prim(Prim::Sphere { radius: *radius })),
+            SdfNode::Box {
+                half_extents: b,
+                rounding,
+            } => {
+                let r = rounding.max(0.0).min(b[0].min(b[1]).min(b[2]));
+                self.emit(Op::Prim(Prim::Box {
+                    inner: [b[0] - r, b[1] - r, b[2] - r],
+                    r,
+                }))
+            }
+            SdfNode::Torus {
+                major_radius,
+                minor_radius,
+            } => self.emit(Op::Prim(Prim::Torus {
+                major: *major_radius,
+                minor: *minor_radius,
+            })),
+            SdfNode::Capsule { a, b, radius } => {
+                let ba = [b[0] - a[0], b[1] - a[1], b[2] - a[2]];
+                let dot_ba = ba[0] * ba[0] + ba[1] * ba[1] + ba[2] * ba[2];
+                self.emit(Op::Prim(Prim::Capsule {
+                    a: *a,
+                    ba,
+                    dot_ba: (dot_ba > 0.0).then_some(dot_ba),
+                    radius: *radius,
+                }))
+            }
+            SdfNode::CappedCylinder {
+                radius,
+                half_height,
+            } => self.emit(Op::Prim(Prim::CappedCylinder {
+                radius: *radius,
+                half_height: *half_height,
+            })),
+            SdfNode::Plane { normal: n, offset } => self.emit(Op::Prim(Prim::Plane {
+                normal: *n,
+                len: len3(n[0], n[1], n[2]).max(1e-9),
+                offset: *offset,
+            })),
+            SdfNode::Ellipsoid { radii: r } => self.emit(Op::Prim(Prim::Ellipsoid {
+                radii: *r,
+                radii2: [r[0] * r[0], r[1] * r[1], r[2] * r[2]],
+                center: -r[0].min(r[1]).min(r[2]),
+            })),
+            SdfNode::CappedCone { .. }
+            | SdfNode::Octahedron { .. }
+            | SdfNode::HexPrism { .. }
+            | SdfNode::SuperPrism { .. }
+            | SdfNode::Cells { .. } => self.emit(Op::Prim(Prim::Leaf(node.clone()))),
+
+            // `fold(INF, min)` keeps its seed so NaN children fold the same way.
+            SdfNode::Union { children } => {
+                self.emit(Op::Const(f32::INFINITY));
+                for c in children {
+                    self.node(c);
+                    self.emit(Op::Binary(Binary::Min));
+                }
+            }
+            SdfNode::Intersect { children } => {
+                self.emit(Op::Const(f32::NEG_INFINITY));
+                for c in children {
+                    self.node(c);
+                    self.emit(Op::Binary(Binary::Max));
+                }
+            }
+            SdfNode::Subtract { a, b } => self.binary(a, b, Binary::Subtract),
+            SdfNode::SmoothUnion { a, b, k } => self.binary(a, b, Binary::SmoothUnion(*k)),
+            SdfNode::SmoothSubtract { a, b, k } => self.binary(a, b, Binary::SmoothSubtract(*k)),
+            SdfNode::SmoothIntersect { a, b, k } => self.binary(a, b, Binary::SmoothIntersect(*k)),
+
+            SdfNode::Round { child, radius } => {
+                self.node(child);
+                // `d - 0.0` is `d` for every `d`, including `-0.0`.
+                if radius.to_bits() != 0 {
+                    self.emit(Op::Unary(Unary::Round(*radius)));
+                }
+            }
+            SdfNode::Shell { child, thickness } => {
+                self.node(child);
+                self.emit(Op::Unary(Unary::Shell(*thickness)));
+            }
+
+            SdfNode::Translate { child, offset } => {
+                if offset.iter().all(|o| o.to_bits() == 0) {
+                    self.node(child);
+                } else {
+                    self.framed(Frame::Translate(*offset), child);
+                }
+            }
+            SdfNode::Rotate { child, angles } => {
+                self.framed(Frame::Rotate(rot_matrix(*angles)), child)
+            }
+            SdfNode::Scale { child, factor } => {
+                let f = if *factor == 0.0 { 1e-9 } else { *factor };
+                if f == 1.0 {
+                    self.node(child);
+                } else {
+                    self.framed(Frame::Scale(f), child);
+                    self.emit(Op::Unary(Unary::Mul(f.abs())));
+                }
+            }
+            SdfNode::Mirror { child, axis } => {
+                let i = match axis {
+                    Axis::X => 0,
+                    Axis::Y => 1,
+                    Axis::Z => 2,
+                };
+                self.framed(Frame::Mirror(i), child)
+            }
+            SdfNode::Repeat {
+                child,
+                spacing,
+                count,
+            } => {
+                if spacing.iter().all(|&s| s <= 0.0) {
+                    self.node(child);
+                } else {
+                    self.framed(
+                        Frame::Repeat {
+                            spacing: *spacing,
+                            count: *count,
+                        },
+                        child,
+                    );
+                }
+            }
+            SdfNode::Displace {
+                child,
+                amplitude,
+                frequency,
+                seed,
+                octaves,
+            } => {
+                self.node(child);
+                self.emit(Op::Unary(Unary::Displace {
+                    amplitude: *amplitude,
+                    frequency: *frequency,
+                    seed: *seed,
+                    octaves: *octaves,
+                }));
+            }
+            SdfNode::Warp {
+                child,
+                amplitude,
+                frequency,
+                seed,
+            } => self.framed(
+                Frame::Warp {
+                    amplitude: *amplitude,
+                    frequency: *frequency,
+                    seed: *seed,
+                },
+                child,
+            ),
+        }
+    }
+}
+
+/// Register file for one packet: `frames + 1` coordinate frames of three
+/// axes each, then the value stack, every register `stride` lanes wide.
+struct Registers {
+    stride: usize,
+    frames: Vec<f32>,
+    values: Vec<f32>,
+}
+
+impl Registers {
+    fn new(tape: &SdfTape, stride: usize) -> Self {
+        Registers {
+            stride,
+            frames: vec![0.0; (tape.frames + 1) * 3 * stride],
+            values: vec![0.0; tape.values.max(1) * stride],
+        }
+    }
+}
+
+/// The three axes of a frame, each `n` lanes long.
+fn axes(frame: &[f32], stride: usize, n: usize) -> [&[f32]; 3] {
+    [
+        &frame[..n],
+        &frame[stride..stride + n],
+        &frame[2 * stride..2 * stride + n],
+    ]
+}
+
+fn axes_mut(frame: &mut [f32], stride: usize, n: usize) -> [&mut [f32]; 3] {
+    let (x, rest) = frame.split_at_mut(stride);
+    let (y, z) = rest.split_at_mut(stride);
+    [&mut x[..n], &mut y[..n], &mut z[..n]]
+}
+
+impl Frame {
+    fn apply(&self, [x, y, z]: [&[f32]; 3], [ox, oy, oz]: [&mut [f32]; 3]) {
+        let n = ox.len();
+        match self {
+            Frame::Translate(o) => {
+                for i in 0..n {
+                    ox[i] = x[i] - o[0];
+                    oy[i] = y[i] - o[1];
+                    oz[i] = z[i] - o[2];
+                }
+            }
+            Frame::Rotate(m) => {
+                for i in 0..n {
+                    let p = inv_rotate(m, [x[i], y[i], z[i]]);
+                    ox[i] = p[0];
+                    oy[i] = p[1];
+                    oz[i] = p[2];
+                }
+            }
+            Frame::Scale(f) => {
+                for i in 0..n {
+                    ox[i] = x[i] / f;
+                    oy[i] = y[i] / f;
+                    oz[i] = z[i] / f;
+                }
+            }
+            Frame::Mirror(axis) => {
+                ox.copy_from_slice(x);
+                oy.copy_from_slice(y);
+                oz.copy_from_slice(z);
+                let out = match axis {
+                    0 => ox,
+                    1 => oy,
+                    _ => oz,
+                };
+                for v in out.iter_mut() {
+                    *v = v.abs();
+                }
+            }
+            Frame::Repeat { spacing, count } => {
+                let n3 = count.map(|c| (c[0], c[1], c[2]));
+                for i in 0..n {
+                    ox[i] = repeat_coord(x[i], spacing[0], n3.map(|c| c.0));
+                    oy[i] = repeat_coord(y[i], spacing[1], n3.map(|c| c.1));
+                    oz[i] = repeat_coord(z[i], spacing[2], n3.map(|c| c.2));
+                }
+            }
+            Frame::Warp {
+                amplitude,
+                frequency,
+                seed,
+            } => {
+                for i in 0..n {
+                    let [wx, wy, wz] = warp_offset(x[i], y[i], z[i], *amplitude, *frequency, *seed);
+                    ox[i] = x[i] + wx;
+                    oy[i] = y[i] + wy;
+                    oz[i] = z[i] + wz;
+                }
+            }
+        }
+    }
+}
+
+impl Prim {
+    fn eval(&self, [x, y, z]: [&[f32]; 3], out: &mut [f32]) {
+        let n = out.len();
+        match self {
+            Prim::Sphere { radius } => {
+                for i in 0..n {
+                    out[i] = len3(x[i], y[i], z[i]) - radius;
+                }
+            }
+            Prim::Box { inner, r } => {
+                for i in 0..n {
+                    let qx = x[i].abs() - inner[0];
+                    let qy = y[i].abs() - inner[1];
+                    let qz = z[i].abs() - inner[2];
+                    let outside = len3(qx.max(0.0), qy.max(0.0), qz.max(0.0));
+                    let inside = qx.max(qy.max(qz)).min(0.0);
+                    out[i] = outside + inside - r;
+                }
+            }
+            Prim::Torus { major, minor } => {
+                for i in 0..n {
+                    let qx = len2(x[i], z[i]) - major;
+                    out[i] = len2(qx, y[i]) - minor;
+                }
+            }
+            Prim::Capsule {
+                a,
+                ba,
+                dot_ba,
+                radius,
+            } => {
+                for i in 0..n {
+                    let pa = [x[i] - a[0], y[i] - a[1], z[i] - a[2]];
+                    let h = match dot_ba {
+                        Some(d) => {
+                            ((pa[0] * ba[0] + pa[1] * ba[1] + pa[2] * ba[2]) / d).clamp(0.0, 1.0)
+                        }
+                        None => 0.0,
+                    };
+                    out[i] = len3(pa[0] - ba[0] * h, pa[1] - ba[1] * h, pa[2] - ba[2] * h) - radius;
+                }
+            }
+            Prim::CappedCylinder {
+                radius,
+                half_height,
+            } => {
+                for i in 0..n {
+                    let dx = len2(x[i], z[i]) - radius;
+                    let dy = y[i].abs() - half_height;
+                    out[i] = dx.max(dy).min(0.0) + len2(dx.max(0.0), dy.max(0.0));
+                }
+            }
+            Prim::Plane {
+                normal,
+                len,
+                offset,
+            } => {
+                for i in 0..n {
+                    out[i] =
+                        (x[i] * normal[0] + y[i] * normal[1] + z[i] * normal[2]) / len + offset;
+                }
+            }
+            Prim::Ellipsoid {
+                radii: r,
+                radii2: r2,
+                center,
+            } => {
+                for i in 0..n {
+                    let k0 = len3(x[i] / r[0], y[i] / r[1], z[i] / r[2]);
+                    let k1 = len3(x[i] / r2[0], y[i] / r2[1], z[i] / r2[2]);
+                    out[i] = if k1 > 0.0 {
+                        k0 * (k0 - 1.0) / k1
+                    } else {
+                        *center
+                    };
+                }
+            }
+            Prim::Leaf(node) => {
+                for i in 0..n {
+                    out[i] = node.eval(x[i], y[i], z[i]);
+                }
+            }
+        }
+    }
+}
+
+impl Binary {
+    fn apply(self, a: &mut [f32], b: &[f32]) {
+        match self {
+            Binary::Min => a.iter_mut().zip(b).for_each(|(a, b)| *a = a.min(*b)),
+            Binary::Max => a.iter_mut().zip(b).for_each(|(a, b)| *a = a.max(*b)),
+            Binary::Subtract => a.iter_mut().zip(b).for_each(|(a, b)| *a = a.max(-b)),
+            Binary::SmoothUnion(k) => a.iter_mut().zip(b).for_each(|(a, b)| *a = smin(*a, *b, k)),
+            Binary::SmoothSubtract(k) => {
+                a.iter_mut().zip(b).for_each(|(a, b)| *a = smax(*a, -b, k))
+            }
+            Binary::SmoothIntersect(k) => {
+                a.iter_mut().zip(b).for_each(|(a, b)| *a = smax(*a, *b, k))
+            }
+        }
+    }
+}
+
+impl Unary {
+    fn apply(self, v: &mut [f32], [x, y, z]: [&[f32]; 3]) {
+        match self {
+            Unary::Round(r) => v.iter_mut().for_each(|v| *v -= r),
+            Unary::Shell(t) => v.iter_mut().for_each(|v| *v = v.abs() - t),
+            Unary::Mul(f) => v.iter_mut().for_each(|v| *v *= f),
+            Unary::Displace {
+                amplitude,
+                frequency,
+                seed,
+                octaves,
+            } => {
+                for (i, v) in v.iter_mut().enumerate() {
+                    *v += fbm3(x[i], y[i], z[i], seed, frequency, octaves) * amplitude;
+                }
+            }
+        }
+    }
+}
+
+/// A closed range of `f32`, used to bound a tape over a box. `EVERYTHING`
+/// stands in whenever a bound cannot be established (or went NaN).
+#[derive(Debug, Clone, Copy)]
+struct Iv {
+    lo: f32,
+    hi: f32,
+}
+
+impl Iv {
+    const EVERYTHING: Iv = Iv {
+        lo: f32::NEG_INFINITY,
+        hi: f32::INFINITY,
+    };
+
+    fn new(lo: f32, hi: f32) -> Iv {
+        if lo.is_nan() || hi.is_nan() {
+            Iv::EVERYTHING
+        } else {
+            Iv { lo, hi }
+        }
+    }
+
+    fn point(v: f32) -> Iv {
+        Iv::new(v, v)
+    }
+
+    fn add(self, o: Iv) -> Iv {
+        Iv::new(self.lo + o.lo, self.hi + o.hi)
+    }
+
+    fn sub(self, o: Iv) -> Iv {
+        Iv::new(self.lo - o.hi, self.hi - o.lo)
+    }
+
+    fn neg(self) -> Iv {
+        Iv::new(-self.hi, -self.lo)
+    }
+
+    fn mul(self, o: Iv) -> Iv {
+        let p = [
+            self.lo * o.lo,
+            self.lo * o.hi,
+            self.hi * o.lo,
+            self.hi * o.hi,
+        ];
+        if p.iter().any(|v| v.is_nan()) {
+            return Iv::EVERYTHING;
+        }
+        Iv::new(
+            p.iter().copied().fold(f32::INFINITY, f32::min),
+            p.iter().copied().fold(f32::NEG_INFINITY, f32::max),
+        )
+    }
+
+    fn div(self, o: Iv) -> Iv {
+        if o.lo <= 0.0 && o.hi >= 0.0 {
+            return Iv::EVERYTHING;
+        }
+        self.mul(Iv::new(1.0 / o.hi, 1.0 / o.lo))
+    }
+
+    fn abs(self) -> Iv {
+        if self.lo >= 0.0 {
+            self
+        } else if self.hi <= 0.0 {
+            self.neg()
+        } else {
+            Iv::new(0.0, (-self.lo).max(self.hi))
+        }
+    }
+
+    fn sqr(self) -> Iv {
+        let a = self.abs();
+        Iv::new(a.lo * a.lo, a.hi * a.hi)
+    }
+
+    fn sqrt(self) -> Iv {
+        Iv::new(self.lo.max(0.0).sqrt(), self.hi.max(0.0).sqrt())
+    }
+
+    /// Monotone for a non-negative base and `p >= 1`.
+    fn powf(self, p: f32) -> Iv {
+        Iv::new(self.lo.max(0.0).powf(p), self.hi.max(0.0).powf(p))
+    }
+
+    fn min(self, o: Iv) -> Iv {
+        Iv::new(self.lo.min(o.lo), self.hi.min(o.hi))
+    }
+
+    fn max(self, o: Iv) -> Iv {
+        Iv::new(self.lo.max(o.lo), self.hi.max(o.hi))
+    }
+
+    fn widen(self, r: f32) -> Iv {
+        Iv::new(self.lo - r, self.hi + r)
+    }
+}
+
+fn iv_len3(x: Iv, y: Iv, z: Iv) -> Iv {
+    x.sqr().add(y.sqr()).add(z.sqr()).sqrt()
+}
+
+fn iv_len2(x: Iv, y: Iv) -> Iv {
+    x.sqr().add(y.sqr()).sqrt()
+}
+
+impl Frame {
+    fn bound(&self, [x, y, z]: [Iv; 3]) -> [Iv; 3] {
+        match self {
+            Frame::Translate(o) => [
+                x.sub(Iv::point(o[0])),
+                y.sub(Iv::point(o[1])),
+                z.sub(Iv::point(o[2])),
+            ],
+            Frame::Rotate(m) => {
+                let p = [x, y, z];
+                let col = |j: usize| {
+                    (0..3).fold(Iv::point(0.0), |acc, i| {
+                        acc.add(p[i].mul(Iv::point(m[i][j])))
+                    })
+                };
+                [col(0), col(1), col(2)]
+            }
+            Frame::Scale(f) => {
+                let f = Iv::point(*f);
+                [x.div(f), y.div(f), z.div(f)]
+            }
+            Frame::Mirror(axis) => {
+                let mut p = [x, y, z];
+                p[*axis] = p[*axis].abs();
+                p
+            }
+            Frame::Repeat { spacing, count } => {
+                let map = |v: Iv, a: usize| {
+                    let s = spacing[a];
+                    if s <= 0.0 {
+                        return v;
+                    }
+                    // The cell index is monotone in `v`, so the folded
+                    // coordinate lies between the extremes of each end.
+                    let cell = |v: f32| {
+                        let c = (v / s).round();
+                        match count {
+                            Some(n) => c.clamp(-(n[a] as f32), n[a] as f32),
+                            None => c,
+                        }
+                    };
+                    let out = Iv::new(v.lo - s * cell(v.hi), v.hi - s * cell(v.lo));
+                    match count {
+                        Some(_) => out,
+                        None => Iv::new(out.lo.max(-0.5 * s), out.hi.min(0.5 * s)),
+                    }
+                };
+                [map(x, 0), map(y, 1), map(z, 2)]
+            }
+            // value_noise3 is in [0, 1), so each offset is within ±amplitude.
+            Frame::Warp { amplitude, .. } => {
+                let a = amplitude.abs();
+                [x.widen(a), y.widen(a), z.widen(a)]
+            }
+        }
+    }
+}
+
+/// Bound a distance-exact (1-Lipschitz) primitive by its value at the box
+/// center plus the half-diagonal.
+fn lipschitz(prim: &Prim, [x, y, z]: [Iv; 3]) -> Iv {
+    let c = [
+        0.5 * (x.lo + x.hi),
+        0.5 * (y.lo + y.hi),
+        0.5 * (z.lo + z.hi),
+    ];
+    let r = len3(
+        0.5 * (x.hi - x.lo),
+        0.5 * (y.hi - y.lo),
+        0.5 * (z.hi - z.lo),
+    );
+    if !(c.iter().all(|v| v.is_finite()) && r.is_finite()) {
+        return Iv::EVERYTHING;
+    }
+    let mut d = [0.0];
+    prim.eval([&[c[0]], &[c[1]], &[c[2]]], &mut d);
+    Iv::new(d[0] - r, d[0] + r)
+}
+
+impl Prim {
+    fn bound(&self, p: [Iv; 3]) -> Iv {
+        let [x, y, z] = p;
+        match self {
+            Prim::Ellipsoid {
+                radii: r, radii2, ..
+            } => {
+                let k0 = iv_len3(
+                    x.div(Iv::point(r[0])),
+                    y.div(Iv::point(r[1])),
+                    z.div(Iv::point(r[2])),
+                );
+                let k1 = iv_len3(
+                    x.div(Iv::point(radii2[0])),
+                    y.div(Iv::point(radii2[1])),
+                    z.div(Iv::point(radii2[2])),
+                );
+                if k1.lo > 0.0 {
+                    k0.mul(k0.sub(Iv::point(1.0))).div(k1)
+                } else {
+                    Iv::EVERYTHING
+                }
+            }
+            Prim::Leaf(SdfNode::SuperPrism {
+                half_extents: b,
+                exponent,
+            }) => {
+                if !(b[0] > 0.0 && b[2] > 0.0) {
+                    return Iv::EVERYTHING;
+                }
+                let e = exponent.max(1.0);
+                let s = x
+                    .abs()
+                    .div(Iv::point(b[0]))
+                    .powf(e)
+                    .add(z.abs().div(Iv::point(b[2])).powf(e));
+                let d_xz = s
+                    .powf(1.0 / e)
+                    .sub(Iv::point(1.0))
+                    .mul(Iv::point(b[0].min(b[2])));
+                let d_y = y.abs().sub(Iv::point(b[1]));
+                let zero = Iv::point(0.0);
+                d_xz.max(d_y)
+                    .min(zero)
+                    .add(iv_len2(d_xz.max(zero), d_y.max(zero)))
+            }
+            Prim::Leaf(SdfNode::Cells {
+                mode, threshold, ..
+            }) => match mode {
+                // Seed distances and their gaps are non-negative.
+                CellMode::F1 | CellMode::F2 | CellMode::F2MinusF1 => {
+                    Iv::new(-threshold, f32::INFINITY)
+                }
+                CellMode::Value => Iv::new(-threshold, 1.0 - threshold),
+            },
+            _ => lipschitz(self, p),
+        }
+    }
+}
+
+impl Binary {
+    fn bound(self, a: Iv, b: Iv) -> Iv {
+        // The polynomial smooth min lies within k/4 below the hard min.
+        let smin = |a: Iv, b: Iv, k: f32| {
+            let m = a.min(b);
+            if k <= 0.0 {
+                m
+            } else {
+                Iv::new(m.lo - 0.25 * k, m.hi)
+            }
+        };
+        let smax = |a: Iv, b: Iv, k: f32| smin(a.neg(), b.neg(), k).neg();
+        match self {
+            Binary::Min => a.min(b),
+            Binary::Max => a.max(b),
+            Binary::Subtract => a.max(b.neg()),
+            Binary::SmoothUnion(k) => smin(a, b, k),
+            Binary::SmoothSubtract(k) => smax(a, b.neg(), k),
+            Binary::SmoothIntersect(k) => smax(a, b, k),
+        }
+    }
+}
+
+impl Unary {
+    fn bound(self, v: Iv) -> Iv {
+        match self {
+            Unary::Round(r) => v.sub(Iv::point(r)),
+            Unary::Shell(t) => v.abs().sub(Iv::point(t)),
+            Unary::Mul(f) => v.mul(Iv::point(f)),
+            // fbm3 is in [-1, 1].
+            Unary::Displace { amplitude, .. } => v.widen(amplitude.abs()),
+        }
+    }
+}
+
+impl SdfTape {
+    /// Flatten `node` into a tape.
+    pub fn compile(node: &SdfNode) -> SdfTape {
+        let mut c = Compiler::default();
+        c.node(node);
+        SdfTape {
+            ops: c.ops,
+            frames: c.max_frame,
+            values: c.max_value,
+        }
+    }
+
+    /// Signed distance at a point; equal to [`SdfNode::eval`] on the source tree.
+    pub fn eval(&self, x: f32, y: f32, z: f32) -> f32 {
+        let mut out = [0.0];
+        self.run(&mut Registers::new(self, 1), &[x], &[y], &[z], &mut out);
+        out[0]
+    }
+
+    /// Conservative `(lo, hi)` bounds on the distance anywhere in the box
+    /// `[min, max]`, by interval arithmetic over the tape (distance-exact
+    /// primitives are bounded through their Lipschitz constant). Bounds are
+    /// infinite where nothing can be said, e.g. around noise cells.
+    pub fn eval_interval(&self, min: [f32; 3], max: [f32; 3]) -> (f32, f32) {
+        let mut frames = Vec::with_capacity(self.frames + 1);
+        frames.push([
+            Iv::new(min[0], max[0]),
+            Iv::new(min[1], max[1]),
+            Iv::new(min[2], max[2]),
+        ]);
+        let mut values: Vec<Iv> = Vec::with_capacity(self.values);
+        for op in &self.ops {
+            let p = *frames.last().expect("the input frame is never popped");
+            match op {
+                Op::Push(t) => frames.push(t.bound(p)),
+                Op::Pop => {
+                    frames.pop();
+                }
+                Op::Const(c) => values.push(Iv::point(*c)),
+                Op::Prim(prim) => values.push(prim.bound(p)),
+                Op::Binary(op) => {
+                    let b = values.pop().expect("binary op has two operands");
+                    let a = values.last_mut().expect("binary op has two operands");
+                    *a = op.bound(*a, b);
+                }
+                Op::Unary(op) => {
+                    let v = values.last_mut().expect("unary op has an operand");
+                    *v = op.bound(*v);
+                }
+            }
+        }
+        let v = values[0];
+        (v.lo, v.hi)
+    }
+
+    /// Signed distances at `(xs[i], ys[i], zs[i])` into `out[i]`, a packet of
+    /// [`PACKET`] points at a time.
+    ///
+    /// # Panics
+    /// If the four slices differ in length.
+    pub fn eval_batch(&self, xs: &[f32], ys: &[f32], zs: &[f32], out: &mut [f32]) {
+        assert!(
+            xs.len() == out.len() && ys.len() == out.len() && zs.len() == out.len(),
+            "eval_batch slices must have equal lengths"
+        );
+        let mut regs = Registers::new(self, PACKET.min(out.len()).max(1));
+        for (start, out) in (0..).step_by(PACKET).zip(out.chunks_mut(PACKET)) {
+            let end = start + out.len();
+            self.run(
+                &mut regs,
+                &xs[start..end],
+                &ys[start..end],
+                &zs[start..end],
+                out,
+            );
+        }
+    }
+
+    fn run(&self, regs: &mut Registers, xs: &[f32], ys: &[f32], zs: &[f32], out: &mut [f32]) {
+        let n = out.len();
+        let stride = regs.stride;
+        let width = 3 * stride;
+        let [x, y, z] = axes_mut(&mut regs.frames[..width], stride, n);
+        x.copy_from_slice(xs);
+        y.copy_from_slice(ys);
+        z.copy_from_slice(zs);
+
+        let mut frame = 0;
+        let mut top = 0;
+        for op in &self.ops {
+            match op {
+                Op::Push(t) => {
+                    let (src, dst) = regs.frames.split_at_mut((frame + 1) * width);
+                    t.apply(
+                        axes(&src[frame * width..], stride, n),
+                        axes_mut(&mut dst[..width], stride, n),
+                    );
+                    frame += 1;
+                }
+                Op::Pop => frame -= 1,
+                Op::Const(c) => {
+                    regs.values[top * stride..][..n].fill(*c);
+                    top += 1;
+                }
+                Op::Prim(p) => {
+                    p.eval(
+                        axes(&regs.frames[frame * width..], stride, n),
+                        &mut regs.values[top * stride..][..n],
+                    );
+                    top += 1;
+                }
+                Op::Binary(b) => {
+                    top -= 1;
+                    let (a, rest) = regs.values.split_at_mut(top * stride);
+                    b.apply(&mut a[(top - 1) * stride..][..n], &rest[..n]);
+                }
+                Op::Unary(u) => u.apply(
+                    &mut regs.values[(top - 1) * stride..][..n],
+                    axes(&regs.frames[frame * width..], stride, n),
+                ),
+            }
+        }
+        out.copy_from_slice(&regs.values[..n]);
+    }
+}
@@ -393,3 +393,187 @@ fn cells_distance_modes_are_nonnegative() {
         }
     }
 }
+
+#[test]
+fn tape_matches_tree_bit_for_bit() {
+    let tree = SdfNode::from_json(
+        r#"{"type":"union","children":[
+          {"type":"smoothUnion","k":2.0,
+           "a":{"type":"box","halfExtents":[4,3,5],"rounding":1},
+           "b":{"type":"translate","offset":[3,2,-1],
+                "child":{"type":"rotate","angles":[20,45,-10],
+                         "child":{"type":"torus","majorRadius":4,"minorRadius":1.5}}}},
+          {"type":"subtract",
+           "a":{"type":"scale","factor":1.5,"child":{"type":"ellipsoid","radii":[3,2,4]}},
+           "b":{"type":"capsule","a":[-2,0,0],"b":[2,1,0],"radius":0.75}},
+          {"type":"smoothSubtract","k":1.0,
+           "a":{"type":"cappedCylinder","radius":3,"halfHeight":2},
+           "b":{"type":"mirror","axis":"x",
+                "child":{"type":"translate","offset":[2,0,0],"child":{"type":"sphere","radius":1.5}}}},
+          {"type":"smoothIntersect","k":0.5,
+           "a":{"type":"plane","normal":[0.2,1,0.1],"offset":1},
+           "b":{"type":"repeat","spacing":[6,0,6],"count":[2,0,2],
+                "child":{"type":"round","radius":0.5,"child":{"type":"octahedron","size":2}}}},
+          {"type":"displace","amplitude":1.5,"frequency":0.2,"seed":9,
+           "child":{"type":"warp","amplitude":2,"frequency":0.1,"seed":3,
+                    "child":{"type":"shell","thickness":0.5,
+                             "child":{"type":"cappedCone","halfHeight":3,"r1":2,"r2":1}}}},
+          {"type":"intersect","children":[
+            {"type":"hexPrism","radius":3,"halfHeight":2},
+            {"type":"superPrism","halfExtents":[4,2,4],"exponent":4},
+            {"type":"cells","frequency":0.3,"seed":5,"threshold":0.1}]},
+          {"type":"intersect","children":[]}
+        ]}"#,
+    )
+    .unwrap();
+    let tape = SdfTape::compile(&tree);
+
+    // 150 points: two full packets and a ragged tail.
+    let pts: Vec<[f32; 3]> = (0..150)
+        .map(|i| {
+            let t = i as f32;
+            [
+                (t * 0.37).sin() * 9.0,
+                (t * 0.11).cos() * 7.0 - 1.0,
+                t * 0.13 - 9.5,
+            ]
+        })
+        .collect();
+    let xs: Vec<f32> = pts.iter().map(|p| p[0]).collect();
+    let ys: Vec<f32> = pts.iter().map(|p| p[1]).collect();
+    let zs: Vec<f32> = pts.iter().map(|p| p[2]).collect();
+    let mut out = vec![0.0; pts.len()];
+    tape.eval_batch(&xs, &ys, &zs, &mut out);
+    for (p, d) in pts.iter().zip(&out) {
+        let expected = tree.eval(p[0], p[1], p[2]);
+        assert_eq!(d.to_bits(), expected.to_bits(), "{p:?}");
+        assert_eq!(tape.eval(p[0], p[1], p[2]).to_bits(), expected.to_bits());
+    }
+}
+
+#[test]
+fn octree_sampling_matches_a_dense_scan() {
+    let carved = SdfNode::from_json(
+        r#"{"type":"subtract",
+            "a":{"type":"rotate","angles":[15,30,0],
+                 "child":{"type":"box","halfExtents":[14,9,11],"rounding":2}},
+            "b":{"type":"repeat","spacing":[7,0,7],"count":[2,0,2],
+                 "child":{"type":"warp","amplitude":1.5,"frequency":0.2,"seed":4,
+                          "child":{"type":"sphere","radius":2.5}}}}"#,
+    )
+    .unwrap();
+    for tree in [island_tree(), carved] {
+        let bounds = auto_bounds(&tree).unwrap();
+        let schematic =
+            sample_to_schematic(&tree, &MaterialRules::default(), Some(bounds), "t").unwrap();
+        let mut solid = 0;
+        for x in bounds.min[0]..=bounds.max[0] {
+            for y in bounds.min[1]..=bounds.max[1] {
+                for z in bounds.min[2]..=bounds.max[2] {
+                    let expected = tree.eval(x as f32 + 0.5, y as f32 + 0.5, z as f32 + 0.5) <= 0.0;
+                    let placed = schematic
+                        .get_block(x, y, z)
+                        .is_some_and(|b| b.name != "minecraft:air");
+                    assert_eq!(placed, expected, "({x}, {y}, {z})");
+                    solid += expected as usize;
+                }
+            }
+        }
+        assert!(solid > 1000);
+    }
+}
+
+#[test]
+fn tape_intervals_contain_point_values() {
+    let tree = island_tree();
+    let tape = SdfTape::compile(&tree);
+    for i in 0..40 {
+        let t = i as f32;
+        let min = [t * 1.7 - 30.0, t * 2.3 - 10.0, 25.0 - t * 1.3];
+        let max = [min[0] + 6.0, min[1] + 3.0, min[2] + 9.0];
+        let (lo, hi) = tape.eval_interval(min, max);
+        for s in 0..27 {
+            let f = [
+                (s % 3) as f32 / 2.0,
+                (s / 3 % 3) as f32 / 2.0,
+                (s / 9) as f32 / 2.0,
+            ];
+            let p: Vec<f32> = (0..3).map(|a| min[a] + (max[a] - min[a]) * f[a]).collect();
+            let d = tree.eval(p[0], p[1], p[2]);
+            assert!(lo <= d + 1e-3 && d - 1e-3 <= hi, "{d} not in [{lo}, {hi}]");
+        }
+    }
+}
+
+#[test]
+fn parallel_sampling_places_property_blocks_and_scatter() {
+    let rules = MaterialRules::from_json(
+        r#"{
+        "fill": [
+            {"when": {"depthBelowSurface": {"min": 0, "max": 0}}, "block": "minecraft:oak_log[axis=y]"},
+            {"block": "minecraft:dirt"}
+        ],
+        "surface": [{"density": 1.0, "blocks": ["minecraft:torch"], "seed": 1}]
+    }"#,
+    )
+    .unwrap();
+    // Wide enough in x for several slabs.
+    let slab = SdfNode::from_json(r#"{"type":"box","halfExtents":[40,3,5]}"#).unwrap();
+    let schematic = sample_to_schematic(&slab, &rules, None, "slab").unwrap();
+    let top = schematic.get_block(-30, 2, 0).unwrap();
+    assert_eq!(top.name, "minecraft:oak_log");
+    assert_eq!(top.get_property("axis").map(|v| v.as_str()), Some("y"));
+    assert_eq!(
+        schematic.get_block(30, 0, 4).unwrap().name,
+        "minecraft:dirt"
+    );
+    assert_eq!(
+        schematic.get_block(0, 3, 0).unwrap().name,
+        "minecraft:torch"
+    );
+    // 80×6×10 solid cells plus a torch on each of the 80×10 columns.
+    assert_eq!(schematic.total_blocks(), 80 * 6 * 10 + 80 * 10);
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+#[test]
+fn world_sampling_matches_the_schematic() {
+    use crate::formats::world_stream::{ShardedWorldSink, WorldSource};
+
+    let rules = MaterialRules::from_json(
+        r#"{
+        "fill": [
+            {"when": {"depthBelowSurface": {"min": 0, "max": 0}}, "block": "minecraft:oak_log[axis=y]"},
+            {"block": "minecraft:dirt"}
+        ],
+        "surface": [{"density": 0.3, "blocks": ["minecraft:torch"], "seed": 7}]
+    }"#,
+    )
+    .unwrap();
+    // Off-grid and spanning negative chunks on both axes.
+    let node = SdfNode::from_json(
+        r#"{"type":"translate","offset":[-5,70,9],"child":{"type":"sphere","radius":19}}"#,
+    )
+    .unwrap();
+    let expected = sample_to_schematic(&node, &rules, None, "ball").unwrap();
+
+    let mut dir = std::env::temp_dir();
+    let n = std::time::SystemTime::now()
+        .duration_since(std::time::UNIX_EPOCH)
+        .unwrap()
+        .as_nanos();
+    dir.push(format!("nucleation_sdf_world_{n}"));
+    let sink = ShardedWorldSink::create(&dir, None, 2).unwrap();
+    sample_to_world(&node, &rules, None, &sink).unwrap();
+    sink.finish().unwrap();
+
+    let mut written = 0;
+    for chunk in WorldSource::open_dir(&dir).unwrap().chunks().unwrap() {
+        for (x, y, z, state) in chunk.unwrap().blocks() {
+            assert_eq!(expected.get_block(x, y, z), Some(state), "at {x},{y},{z}");
+            written += 1;
+        }
+    }
+    assert_eq!(written, expected.total_blocks());
+    let _ = std::fs::remove_dir_all(&dir);
+}
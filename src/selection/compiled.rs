@@ -0,0 +1,197 @@
+//! Masks compiled to chunk bitsets.
+//!
+//! A [`NotAirMask`] or [`BlocklistMask`] test is a region lookup plus a
+//! block-name comparison, and a flood makes one per neighbour of every block
+//! it reaches. A [`CompiledMask`] evaluates a mask once over a box into
+//! 4096-bit chunk words laid out like [`VisitedSet`], after which a test is a
+//! chunk lookup and a bit probe.
+//!
+//! Schematic masks compile through the palette: the predicate runs once per
+//! palette entry, and each region's cells are set by palette index. When air
+//! fails the predicate only the non-air runs of a region are walked.
+//!
+//! [`NotAirMask`]: super::mask::NotAirMask
+//! [`BlocklistMask`]: super::mask::BlocklistMask
+
+use super::mask::Mask;
+use super::visited::{chunk_key, ChunkKey, VisitedSet, CHUNK_BITS, CHUNK_VOLUME, WORDS_PER_CHUNK};
+use crate::bounding_box::BoundingBox;
+use crate::region::Region;
+use crate::universal_schematic::UniversalSchematic;
+use crate::BlockState;
+use rayon::prelude::*;
+
+/// A mask frozen over a box: cells outside the box never pass.
+pub struct CompiledMask {
+    bits: VisitedSet,
+}
+
+impl CompiledMask {
+    /// `mask` over `bounds`, tested once per cell, a chunk per task on the
+    /// rayon pool.
+    pub fn compile<M: Mask>(mask: &M, bounds: &BoundingBox) -> Self {
+        let chunks: Vec<(ChunkKey, [u64; WORDS_PER_CHUNK])> = chunk_keys(bounds)
+            .into_par_iter()
+            .filter_map(|key| chunk_bits(key, bounds, mask).map(|bits| (key, bits)))
+            .collect();
+        Self {
+            bits: VisitedSet::from_chunks(chunks),
+        }
+    }
+
+    /// The cells of `schematic` in `bounds` whose block passes `accept`, as
+    /// `schematic.get_block` resolves them. `accept` runs once per palette
+    /// entry of each region, never per cell.
+    pub fn from_blocks(
+        schematic: &UniversalSchematic,
+        bounds: &BoundingBox,
+        accept: impl Fn(&BlockState) -> bool,
+    ) -> Self {
+        let regions: Vec<&Region> = std::iter::once(&schematic.default_region)
+            .chain(UniversalSchematic::sorted_named_regions(schematic))
+            .collect();
+        let mut bits = VisitedSet::new();
+        for (i, region) in regions.iter().enumerate() {
+            let Some(clip) = region.get_bounding_box().intersection(bounds) else {
+                continue;
+            };
+            let passes: Vec<bool> = region.palette.iter().map(&accept).collect();
+            let air = region.air_index();
+            let skip = if passes.get(air) == Some(&false) {
+                air
+            } else {
+                usize::MAX
+            };
+            // A cell covered by an earlier region resolves there.
+            let earlier = &regions[..i];
+            for ((x, y, z), index) in region.cells_ne_in(&clip, skip) {
+                if passes[index] && !earlier.iter().any(|r| r.is_in_region(x, y, z)) {
+                    bits.insert(x, y, z);
+                }
+            }
+        }
+        Self { bits }
+    }
+
+    /// Chunks holding at least one passing cell.
+    pub fn chunk_count(&self) -> usize {
+        self.bits.chunk_count()
+    }
+}
+
+impl Mask for CompiledMask {
+    #[inline]
+    fn test(&self, x: i32, y: i32, z: i32) -> bool {
+        self.bits.contains(x, y, z)
+    }
+}
+
+/// Keys of every chunk that `bounds` touches, in scan order (y, z, x).
+pub(super) fn chunk_keys(bounds: &BoundingBox) -> Vec<ChunkKey> {
+    let lo = chunk_key(bounds.min.0, bounds.min.1, bounds.min.2);
+    let hi = chunk_key(bounds.max.0, bounds.max.1, bounds.max.2);
+    (lo.1..=hi.1)
+        .flat_map(|cy| (lo.2..=hi.2).flat_map(move |cz| (lo.0..=hi.0).map(move |cx| (cx, cy, cz))))
+        .collect()
+}
+
+/// Local `(x, y, z)` of a linear cell index within a chunk (y high, z mid,
+/// x low, the [`VisitedSet`] layout).
+#[inline]
+pub(super) fn local(linear: usize) -> (i32, i32, i32) {
+    (
+        (linear & 15) as i32,
+        (linear >> 8) as i32,
+        ((linear >> 4) & 15) as i32,
+    )
+}
+
+/// The cells of chunk `key` inside `bounds` that pass `mask`, by linear
+/// index; `None` if none do.
+pub(super) fn chunk_bits<M: Mask>(
+    key: ChunkKey,
+    bounds: &BoundingBox,
+    mask: &M,
+) -> Option<[u64; WORDS_PER_CHUNK]> {
+    let origin = (
+        key.0 << CHUNK_BITS,
+        key.1 << CHUNK_BITS,
+        key.2 << CHUNK_BITS,
+    );
+    let mut bits = [0u64; WORDS_PER_CHUNK];
+    for i in 0..CHUNK_VOLUME {
+        let (lx, ly, lz) = local(i);
+        let (x, y, z) = (origin.0 + lx, origin.1 + ly, origin.2 + lz);
+        if bounds.contains((x, y, z)) && mask.test(x, y, z) {
+            bits[i / 64] |= 1 << (i % 64);
+        }
+    }
+    bits.iter().any(|&w| w != 0).then_some(bits)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::selection::connectivity::Connectivity;
+    use crate::selection::flood::{flood, Limits};
+    use crate::selection::iter_bounds;
+    use crate::selection::mask::{AndMask, BlocklistMask, NotAirMask};
+
+    #[test]
+    fn compiled_masks_match_their_sources() {
+        let mut schem = UniversalSchematic::new("test".to_string());
+        let stone = BlockState::new("minecraft:stone");
+        let glass = BlockState::new("minecraft:glass");
+        for x in -3..20 {
+            for y in 0..3 {
+                schem.set_block(
+                    x,
+                    y,
+                    (x * 7 + y).rem_euclid(5),
+                    if x % 4 == 0 { &glass } else { &stone },
+                );
+            }
+        }
+        // A named region behind the default one and partly outside it.
+        let mut extra = Region::new("extra".to_string(), (18, 0, 0), (6, 2, 2));
+        for x in 18..24 {
+            extra.set_block(x, 1, 1, &glass);
+        }
+        schem.other_regions.insert("extra".to_string(), extra);
+
+        let bounds = BoundingBox::new((-5, -1, -1), (22, 3, 5));
+        let not_air = NotAirMask::new(&schem);
+        let stone_only = BlocklistMask::allow(&schem, ["minecraft:stone"]);
+        let not_stone = |b: &BlockState| b.get_name() != "minecraft:stone";
+        let not_stone_at = |x: i32, y: i32, z: i32| schem.get_block(x, y, z).is_some_and(not_stone);
+        let pairs: [(&dyn Mask, CompiledMask); 4] = [
+            (&not_air, not_air.compile(&bounds)),
+            (&stone_only, stone_only.compile(&bounds)),
+            // Air passes, so every cell of every region is walked.
+            (
+                &not_stone_at,
+                CompiledMask::from_blocks(&schem, &bounds, not_stone),
+            ),
+            (&not_air, CompiledMask::compile(&not_air, &bounds)),
+        ];
+        for (source, compiled) in &pairs {
+            for p in iter_bounds(&bounds) {
+                assert_eq!(compiled.test(p.x, p.y, p.z), source.test(p.x, p.y, p.z));
+            }
+        }
+        assert!(not_air.test(23, 1, 1) && !pairs[0].1.test(23, 1, 1));
+
+        let in_bounds = |x: i32, y: i32, z: i32| bounds.contains((x, y, z));
+        let seed = crate::block_position::BlockPosition::new(1, 0, 2);
+        let limits = Limits::unbounded();
+        let direct = flood(
+            seed,
+            &AndMask(NotAirMask::new(&schem), in_bounds),
+            Connectivity::Corner,
+            &limits,
+        );
+        let compiled = flood(seed, &pairs[0].1, Connectivity::Corner, &limits);
+        assert!(direct.blocks.len() > 1);
+        assert_eq!(compiled.blocks.len(), direct.blocks.len());
+    }
+}
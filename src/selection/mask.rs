@@ -4,6 +4,8 @@
 //! at integer block coordinates. Adapter masks (`Not`, `And`, `Or`) compose
 //! primitives without allocating.
 
+use crate::bounding_box::BoundingBox;
+use crate::selection::compiled::CompiledMask;
 use crate::universal_schematic::UniversalSchematic;
 use crate::BlockState;
 
@@ -37,6 +39,11 @@ impl<'a> NotAirMask<'a> {
     pub fn new(schematic: &'a UniversalSchematic) -> Self {
         Self { schematic }
     }
+
+    /// This mask as a bitset over `bounds`, tested once per palette entry.
+    pub fn compile(&self, bounds: &BoundingBox) -> CompiledMask {
+        CompiledMask::from_blocks(self.schematic, bounds, |b| !is_air(b))
+    }
 }
 
 impl<'a> Mask for NotAirMask<'a> {
@@ -79,6 +86,13 @@ impl<'a> BlocklistMask<'a> {
             names: names.into_iter().map(Into::into).collect(),
         }
     }
+
+    /// This mask as a bitset over `bounds`, tested once per palette entry.
+    pub fn compile(&self, bounds: &BoundingBox) -> CompiledMask {
+        CompiledMask::from_blocks(self.schematic, bounds, |b| {
+            self.names.iter().any(|n| n == b.get_name())
+        })
+    }
 }
 
 impl<'a> Mask for BlocklistMask<'a> {
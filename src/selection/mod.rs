@@ -9,24 +9,30 @@
 //! Both are mask-driven: callers supply a [`Mask`] (the predicate) and a
 //! [`Connectivity`] choice (which neighbours count as connected). Adapter
 //! masks for the common cases — non-air over a [`UniversalSchematic`],
-//! allow-lists, boolean combinators — live in [`mask`].
+//! allow-lists, boolean combinators — live in [`mask`]. Large selections
+//! should compile their mask to a [`CompiledMask`] bitset first.
 //!
 //! The design follows RedstoneTools' `/that` selector but generalises it
 //! from a single-target selector to a streaming whole-volume scanner with
 //! a shared visited set, so every block in the input is touched at most
-//! once across the entire pass.
+//! once across the entire pass. [`connected_components_par`] runs the same
+//! sweep over a bounded volume on the rayon pool, chunk by chunk.
 
+pub mod compiled;
 pub mod connectivity;
 pub mod flood;
 pub mod mask;
+pub mod parallel;
 pub mod visited;
 
+pub use compiled::CompiledMask;
 pub use connectivity::Connectivity;
 pub use flood::{
     connected_components, connected_components_collect, flood, flood_with_visited, iter_bounds,
     Component, Continue, Limits, StopReason,
 };
 pub use mask::{AndMask, BlocklistMask, Mask, NotAirMask, NotMask, OrMask};
+pub use parallel::connected_components_par;
 pub use visited::VisitedSet;
 
 #[cfg(test)]
@@ -0,0 +1,314 @@
+//! Parallel whole-volume component labeling.
+//!
+//! [`connected_components_par`] yields exactly what the serial
+//! [`connected_components`] yields for a sweep of a bounded volume: the same
+//! components, in the same order, each holding its blocks in the same BFS
+//! order. The work runs on the rayon pool in three passes:
+//!
+//! 1. Each 16³ chunk of the volume (the [`VisitedSet`] chunk grid) tests the
+//!    mask on its cells and labels them with a chunk-local union-find.
+//! 2. Labels that touch across chunk faces, edges or corners are merged. A
+//!    component's seed is the minimum of its chunks' first cells in
+//!    [`iter_bounds`] order, which is the cell the serial sweep starts it
+//!    from.
+//! 3. Components are flooded from their seeds over the occupancy found in
+//!    pass 1, a batch at a time, and handed to the callback in seed order.
+//!
+//! The mask is tested once per cell, all in pass 1. One component still
+//! floods on one thread, because its BFS order is part of the output.
+//!
+//! [`connected_components`]: super::flood::connected_components
+//! [`iter_bounds`]: super::flood::iter_bounds
+
+use super::compiled::{chunk_bits, chunk_keys, local};
+use super::connectivity::Connectivity;
+use super::flood::{flood, Component, Continue, Limits};
+use super::mask::Mask;
+use super::visited::{
+    chunk_key, index_in_chunk, ChunkKey, VisitedSet, CHUNK_BITS, CHUNK_VOLUME, WORDS_PER_CHUNK,
+};
+use crate::block_position::BlockPosition;
+use crate::bounding_box::BoundingBox;
+use rayon::prelude::*;
+use rustc_hash::{FxHashMap, FxHashSet};
+
+/// Components flooded per batch, per worker thread.
+const BATCH_PER_THREAD: usize = 4;
+/// Label of a cell outside the mask.
+const NONE: u16 = u16::MAX;
+
+/// One chunk after pass 1.
+struct LabeledChunk {
+    key: ChunkKey,
+    occupied: [u64; WORDS_PER_CHUNK],
+    /// Chunk-local component of each cell, by linear index; [`NONE`] outside
+    /// the mask. A chunk has at most 2048 components, so `u16` holds them.
+    labels: Box<[u16]>,
+    /// First cell, by linear index, of each local component.
+    firsts: Vec<u16>,
+    /// Global label of local component 0.
+    base: u32,
+}
+
+impl LabeledChunk {
+    fn origin(&self) -> (i32, i32, i32) {
+        (
+            self.key.0 << CHUNK_BITS,
+            self.key.1 << CHUNK_BITS,
+            self.key.2 << CHUNK_BITS,
+        )
+    }
+}
+
+fn find<T: Copy + Into<usize>>(parent: &mut [T], mut i: usize) -> usize {
+    while parent[i].into() != i {
+        let grandparent = parent[parent[i].into()];
+        parent[i] = grandparent;
+        i = grandparent.into();
+    }
+    i
+}
+
+/// Pass 1 for the chunk at `key`; `None` if no cell passes the mask.
+fn label_chunk<M: Mask>(
+    key: ChunkKey,
+    bounds: &BoundingBox,
+    mask: &M,
+    offsets: &[(i32, i32, i32)],
+) -> Option<LabeledChunk> {
+    let occupied = chunk_bits(key, bounds, mask)?;
+    let is_set = |bits: &[u64; WORDS_PER_CHUNK], i: usize| bits[i / 64] >> (i % 64) & 1 != 0;
+
+    // Union toward the lower index, so every root is its component's first
+    // cell in scan order.
+    let mut parent: Vec<u16> = (0..CHUNK_VOLUME as u16).collect();
+    for i in (0..CHUNK_VOLUME).filter(|&i| is_set(&occupied, i)) {
+        let (lx, ly, lz) = local(i);
+        for &(dx, dy, dz) in offsets {
+            let (nx, ny, nz) = (lx + dx, ly + dy, lz + dz);
+            if !(0..16).contains(&nx) || !(0..16).contains(&ny) || !(0..16).contains(&nz) {
+                continue;
+            }
+            let j = (ny << 8 | nz << 4 | nx) as usize;
+            if !is_set(&occupied, j) {
+                continue;
+            }
+            let (a, b) = (find(&mut parent, i), find(&mut parent, j));
+            if a != b {
+                parent[a.max(b)] = a.min(b) as u16;
+            }
+        }
+    }
+
+    let mut labels = vec![NONE; CHUNK_VOLUME].into_boxed_slice();
+    let mut firsts = Vec::new();
+    for i in (0..CHUNK_VOLUME).filter(|&i| is_set(&occupied, i)) {
+        let root = find(&mut parent, i);
+        labels[i] = if root == i {
+            firsts.push(i as u16);
+            (firsts.len() - 1) as u16
+        } else {
+            labels[root]
+        };
+    }
+    Some(LabeledChunk {
+        key,
+        occupied,
+        labels,
+        firsts,
+        base: 0,
+    })
+}
+
+/// Global label pairs that touch across `chunk`'s boundary. Each pair is
+/// reported from both sides, which is harmless for the union.
+fn boundary_pairs(
+    chunk: &LabeledChunk,
+    chunks: &[LabeledChunk],
+    index: &FxHashMap<ChunkKey, usize>,
+    offsets: &[(i32, i32, i32)],
+) -> FxHashSet<(u32, u32)> {
+    let origin = chunk.origin();
+    let mut pairs = FxHashSet::default();
+    for i in 0..CHUNK_VOLUME {
+        let label = chunk.labels[i];
+        let (lx, ly, lz) = local(i);
+        if label == NONE || [lx, ly, lz].iter().all(|&c| c > 0 && c < 15) {
+            continue;
+        }
+        for &(dx, dy, dz) in offsets {
+            let (x, y, z) = (origin.0 + lx + dx, origin.1 + ly + dy, origin.2 + lz + dz);
+            let key = chunk_key(x, y, z);
+            if key == chunk.key {
+                continue;
+            }
+            let Some(&other) = index.get(&key) else {
+                continue;
+            };
+            let other = &chunks[other];
+            let (word, bit) = index_in_chunk(x, y, z);
+            let j = word * 64 + bit as usize;
+            if other.labels[j] != NONE {
+                let a = chunk.base + u32::from(label);
+                let b = other.base + u32::from(other.labels[j]);
+                pairs.insert((a.min(b), a.max(b)));
+            }
+        }
+    }
+    pairs
+}
+
+/// Every connected component of the cells in `bounds` that pass `mask`, in
+/// parallel. Yields exactly what
+/// `connected_components(iter_bounds(bounds), &in_bounds_mask, connectivity,
+/// &Limits::unbounded(), on_component)` would, where `in_bounds_mask` is
+/// `mask` restricted to `bounds`. Components go to `on_component` on the
+/// calling thread, in order, as each batch finishes. Returns the number of
+/// components produced.
+///
+/// Floods are never capped here: under [`Limits`] the serial result depends
+/// on the order the floods run in.
+pub fn connected_components_par<M, F>(
+    bounds: &BoundingBox,
+    mask: &M,
+    connectivity: Connectivity,
+    mut on_component: F,
+) -> usize
+where
+    M: Mask,
+    F: FnMut(Component) -> Continue,
+{
+    let offsets = connectivity.offsets();
+
+    // Pass 1.
+    let mut chunks: Vec<LabeledChunk> = chunk_keys(bounds)
+        .into_par_iter()
+        .filter_map(|key| label_chunk(key, bounds, mask, offsets))
+        .collect();
+    let mut labels = 0u32;
+    for chunk in &mut chunks {
+        chunk.base = labels;
+        labels += chunk.firsts.len() as u32;
+    }
+    let index: FxHashMap<ChunkKey, usize> =
+        chunks.iter().enumerate().map(|(i, c)| (c.key, i)).collect();
+
+    // Pass 2.
+    let pairs: Vec<FxHashSet<(u32, u32)>> = chunks
+        .par_iter()
+        .map(|chunk| boundary_pairs(chunk, &chunks, &index, offsets))
+        .collect();
+    let mut parent: Vec<usize> = (0..labels as usize).collect();
+    for &(a, b) in pairs.iter().flatten() {
+        let (a, b) = (find(&mut parent, a as usize), find(&mut parent, b as usize));
+        if a != b {
+            parent[a.max(b)] = a.min(b);
+        }
+    }
+    // Seed per root, keyed in scan order (y, z, x).
+    let mut seeds: FxHashMap<usize, (i32, i32, i32)> = FxHashMap::default();
+    for chunk in &chunks {
+        let origin = chunk.origin();
+        for (l, &first) in chunk.firsts.iter().enumerate() {
+            let (lx, ly, lz) = local(first as usize);
+            let key = (origin.1 + ly, origin.2 + lz, origin.0 + lx);
+            let root = find(&mut parent, (chunk.base + l as u32) as usize);
+            seeds
+                .entry(root)
+                .and_modify(|seed| *seed = (*seed).min(key))
+                .or_insert(key);
+        }
+    }
+    let mut seeds: Vec<BlockPosition> = seeds
+        .into_values()
+        .map(|(y, z, x)| BlockPosition::new(x, y, z))
+        .collect();
+    seeds.sort_unstable_by_key(|p| (p.y, p.z, p.x));
+
+    // Pass 3.
+    let occupied = VisitedSet::from_chunks(chunks.into_iter().map(|c| (c.key, c.occupied)));
+    let in_mask = |x: i32, y: i32, z: i32| occupied.contains(x, y, z);
+    let batch = rayon::current_num_threads() * BATCH_PER_THREAD;
+    let mut count = 0;
+    for seeds in seeds.chunks(batch) {
+        let components: Vec<Component> = seeds
+            .par_iter()
+            .map(|&seed| flood(seed, &in_mask, connectivity, &Limits::unbounded()))
+            .collect();
+        for component in components {
+            count += 1;
+            if on_component(component) == Continue::Stop {
+                return count;
+            }
+        }
+    }
+    count
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::selection::flood::{connected_components, iter_bounds};
+
+    #[test]
+    fn matches_the_serial_sweep() {
+        let bounds = BoundingBox::new((-20, -3, -18), (21, 19, 17));
+        // Sparse pseudo-random cells, plus a rod across three chunk seams.
+        let mask = |x: i32, y: i32, z: i32| {
+            let h = (x.wrapping_mul(73_856_093)
+                ^ y.wrapping_mul(19_349_663)
+                ^ z.wrapping_mul(83_492_791)) as u32;
+            h % 12 == 0 || (y == 5 && z == 0)
+        };
+        let in_bounds = |x: i32, y: i32, z: i32| bounds.contains((x, y, z)) && mask(x, y, z);
+
+        for connectivity in [
+            Connectivity::Face,
+            Connectivity::Edge,
+            Connectivity::EdgeMid,
+            Connectivity::Corner,
+        ] {
+            let mut serial = Vec::new();
+            connected_components(
+                iter_bounds(&bounds),
+                &in_bounds,
+                connectivity,
+                &Limits::unbounded(),
+                |c| {
+                    serial.push(c);
+                    Continue::Yes
+                },
+            );
+            let mut parallel = Vec::new();
+            let count = connected_components_par(&bounds, &mask, connectivity, |c| {
+                parallel.push(c);
+                Continue::Yes
+            });
+            assert_eq!(count, serial.len());
+            assert!(serial.len() > 1);
+            let xyz = |c: &Component| -> Vec<(i32, i32, i32)> {
+                c.blocks.iter().map(|b| (b.x, b.y, b.z)).collect()
+            };
+            for (p, s) in parallel.iter().zip(&serial) {
+                assert_eq!(
+                    (p.seed.x, p.seed.y, p.seed.z),
+                    (s.seed.x, s.seed.y, s.seed.z)
+                );
+                assert_eq!(p.bounds, s.bounds);
+                assert_eq!(xyz(p), xyz(s));
+                assert_eq!(p.stop_reason, s.stop_reason);
+            }
+        }
+
+        let mut seen = 0;
+        let count = connected_components_par(&bounds, &mask, Connectivity::Face, |_| {
+            seen += 1;
+            if seen == 3 {
+                Continue::Stop
+            } else {
+                Continue::Yes
+            }
+        });
+        assert_eq!((count, seen), (3, 3));
+    }
+}
@@ -6,13 +6,13 @@
 
 use std::collections::HashMap;
 
-const CHUNK_BITS: u32 = 4;
+pub(super) const CHUNK_BITS: u32 = 4;
 const CHUNK_SIDE: i32 = 1 << CHUNK_BITS; // 16
 const CHUNK_MASK: i32 = CHUNK_SIDE - 1; // 15
-const CHUNK_VOLUME: usize = 1 << (CHUNK_BITS * 3); // 4096
-const WORDS_PER_CHUNK: usize = CHUNK_VOLUME / 64; // 64
+pub(super) const CHUNK_VOLUME: usize = 1 << (CHUNK_BITS * 3); // 4096
+pub(super) const WORDS_PER_CHUNK: usize = CHUNK_VOLUME / 64; // 64
 
-type ChunkKey = (i32, i32, i32);
+pub(super) type ChunkKey = (i32, i32, i32);
 
 /// A sparse 3D bitset over `i32` block coordinates.
 ///
@@ -30,6 +30,16 @@ impl VisitedSet {
         }
     }
 
+    /// A set made of whole chunk bitsets, laid out as [`index_in_chunk`]
+    /// places cells.
+    pub(super) fn from_chunks(
+        chunks: impl IntoIterator<Item = (ChunkKey, [u64; WORDS_PER_CHUNK])>,
+    ) -> Self {
+        Self {
+            chunks: chunks.into_iter().collect(),
+        }
+    }
+
     /// Approximate live memory footprint, in bytes. Useful for diagnostics.
     pub fn approx_bytes(&self) -> usize {
         // each entry: key (12B) + bitset (512B); ignore hashmap bookkeeping
@@ -71,14 +81,14 @@ impl VisitedSet {
 }
 
 #[inline]
-fn chunk_key(x: i32, y: i32, z: i32) -> ChunkKey {
+pub(super) fn chunk_key(x: i32, y: i32, z: i32) -> ChunkKey {
     // arithmetic shift gives correct floor-div behaviour for negatives in
     // two's complement, which is what we want for chunk coordinates.
     (x >> CHUNK_BITS, y >> CHUNK_BITS, z >> CHUNK_BITS)
 }
 
 #[inline]
-fn index_in_chunk(x: i32, y: i32, z: i32) -> (usize, u32) {
+pub(super) fn index_in_chunk(x: i32, y: i32, z: i32) -> (usize, u32) {
     let lx = (x & CHUNK_MASK) as u32;
     let ly = (y & CHUNK_MASK) as u32;
     let lz = (z & CHUNK_MASK) as u32;
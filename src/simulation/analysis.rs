@@ -4,20 +4,27 @@
 //! These kernels return **data, not verdicts**: counts, components, depths and
 //! fan metrics. They deliberately contain NO classification/naming logic (e.g.
 //! "this is a 4-bit adder") — that interpretation lives in downstream Python.
-//! Everything is pure Rust over the `Vec<RedstoneNode>` adjacency; no petgraph.
+//! Everything is pure Rust; no petgraph.
 //!
-//! The graph stores INCOMING edges on each node (`node.inputs`, where
-//! `link.from` is the source node id). Several kernels need out-adjacency, so we
-//! invert `inputs` into an out-adjacency list exactly once and reuse it.
-
-use super::graph::{RedstoneGraph, RedstoneNodeKind};
+//! The kernels run on [`CompactGraph`], whose edges are compressed sparse
+//! rows in both directions, so a 500k-node graph is walked without a
+//! `Vec` per node. The [`RedstoneGraph`] methods convert once and delegate.
+//! Weak components never share an edge, so the SCC/depth kernels run per
+//! weak component, in parallel; [`AnalysisSession`] keeps those per-component
+//! results (and the fingerprint colours) across successive exports.
+
+use super::fingerprint::{
+    combine_labels, initial_label, refined_label, GraphFingerprintSpec, RedstoneFingerprint,
+};
+use super::graph::{CompactGraph, RedstoneGraph, NODE_HAS_POS, NODE_KIND_NAMES};
+use rayon::prelude::*;
 use serde::{Deserialize, Serialize};
-use std::collections::BTreeMap;
+use std::collections::{BTreeMap, HashMap};
 
 /// Aggregate, serde-serializable feature vector for a [`RedstoneGraph`].
 ///
-/// Computed by [`RedstoneGraph::features`], which derives the SCC decomposition
-/// once and reuses it for every cycle/depth metric.
+/// Computed by [`CompactGraph::features`], which derives the SCC
+/// decomposition once and reuses it for every cycle/depth metric.
 #[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
 pub struct GraphFeatures {
     pub node_count: usize,
@@ -52,183 +59,191 @@ impl GraphFeatures {
     }
 }
 
-/// Stable discriminant name for a node kind (payload such as repeater delay or
-/// comparator mode is ignored — one bucket per discriminant).
-fn kind_name(kind: &RedstoneNodeKind) -> &'static str {
-    match kind {
-        RedstoneNodeKind::Repeater { .. } => "Repeater",
-        RedstoneNodeKind::Comparator { .. } => "Comparator",
-        RedstoneNodeKind::Torch => "Torch",
-        RedstoneNodeKind::Lamp => "Lamp",
-        RedstoneNodeKind::Button => "Button",
-        RedstoneNodeKind::Lever => "Lever",
-        RedstoneNodeKind::PressurePlate => "PressurePlate",
-        RedstoneNodeKind::Trapdoor => "Trapdoor",
-        RedstoneNodeKind::Wire => "Wire",
-        RedstoneNodeKind::Constant => "Constant",
-        RedstoneNodeKind::NoteBlock => "NoteBlock",
-    }
-}
-
-/// Per-node weight used by `delay_weighted_depth`: a Repeater contributes its
-/// configured `delay` (1..=4 redstone ticks); every other node contributes 1.
-fn delay_weight(kind: &RedstoneNodeKind) -> u32 {
-    match kind {
-        RedstoneNodeKind::Repeater { delay } => u32::from(*delay),
-        _ => 1,
-    }
-}
+/// Kind codes (indices into [`NODE_KIND_NAMES`]) used below.
+const REPEATER: u8 = 0;
+const INPUT_KINDS: [&str; 3] = ["Lever", "Button", "PressurePlate"];
+const OUTPUT_KINDS: [&str; 3] = ["Lamp", "Trapdoor", "NoteBlock"];
 
 impl RedstoneGraph {
-    /// Out-adjacency list (node id -> ids it feeds), inverted from `inputs`.
-    fn out_adjacency(&self) -> Vec<Vec<usize>> {
-        let n = self.nodes.len();
-        let mut out: Vec<Vec<usize>> = vec![Vec::new(); n];
-        for node in &self.nodes {
-            for link in &node.inputs {
-                // `link.from` feeds `node.id`.
-                if link.from < n {
-                    out[link.from].push(node.id);
-                }
-            }
-        }
-        out
-    }
-
     /// Stable kind name -> count. One bucket per discriminant; kind-specific
     /// payload (repeater delay, comparator mode) is ignored.
     pub fn node_kind_counts(&self) -> BTreeMap<String, usize> {
-        let mut counts: BTreeMap<String, usize> = BTreeMap::new();
-        for node in &self.nodes {
-            *counts.entry(kind_name(&node.kind).to_string()).or_insert(0) += 1;
-        }
-        counts
+        self.to_compact().node_kind_counts()
     }
 
-    /// Strongly connected components via an **iterative** Tarjan's algorithm
-    /// (explicit work stack — safe on very large/deep graphs). Each inner vec is
-    /// the set of node ids in one SCC. Component order is unspecified but the
-    /// decomposition is deterministic for a given graph.
+    /// See [`CompactGraph::strongly_connected_components`].
     pub fn strongly_connected_components(&self) -> Vec<Vec<usize>> {
-        let n = self.nodes.len();
-        let out = self.out_adjacency();
-        self.tarjan_scc(&out, n)
+        self.to_compact().strongly_connected_components()
     }
 
-    /// Iterative Tarjan SCC over a precomputed out-adjacency.
-    fn tarjan_scc(&self, out: &[Vec<usize>], n: usize) -> Vec<Vec<usize>> {
-        const UNVISITED: usize = usize::MAX;
-        let mut index = vec![UNVISITED; n];
-        let mut lowlink = vec![0usize; n];
-        let mut on_stack = vec![false; n];
-        let mut stack: Vec<usize> = Vec::new();
-        let mut next_index = 0usize;
-        let mut sccs: Vec<Vec<usize>> = Vec::new();
+    /// See [`CompactGraph::has_cycles`].
+    pub fn has_cycles(&self) -> bool {
+        self.to_compact().has_cycles()
+    }
 
-        // Each work-stack frame tracks a node and how far through its successors
-        // we've recursed (the position resumes the "for child" loop iteratively).
-        let mut work: Vec<(usize, usize)> = Vec::new();
+    /// A graph is combinational iff it has no cycles.
+    pub fn is_combinational(&self) -> bool {
+        !self.has_cycles()
+    }
 
-        for root in 0..n {
-            if index[root] != UNVISITED {
-                continue;
-            }
-            work.push((root, 0));
-
-            while let Some(&(v, child_pos)) = work.last() {
-                if child_pos == 0 {
-                    // First time we touch `v`: assign its index/lowlink.
-                    index[v] = next_index;
-                    lowlink[v] = next_index;
-                    next_index += 1;
-                    stack.push(v);
-                    on_stack[v] = true;
-                }
+    /// See [`CompactGraph::weakly_connected_components`].
+    pub fn weakly_connected_components(&self) -> usize {
+        self.to_compact().weakly_connected_components()
+    }
 
-                let mut recursed = false;
-                let mut pos = child_pos;
-                while pos < out[v].len() {
-                    let w = out[v][pos];
-                    if index[w] == UNVISITED {
-                        // Descend into w; resume v's loop at pos+1 afterwards.
-                        *work.last_mut().unwrap() = (v, pos + 1);
-                        work.push((w, 0));
-                        recursed = true;
-                        break;
-                    } else if on_stack[w] {
-                        lowlink[v] = lowlink[v].min(index[w]);
-                    }
-                    pos += 1;
-                }
-                if recursed {
-                    continue;
-                }
+    /// See [`CompactGraph::critical_path`].
+    pub fn critical_path(&self) -> u32 {
+        self.to_compact().critical_path()
+    }
 
-                // Done with all of v's successors.
-                if lowlink[v] == index[v] {
-                    // v is an SCC root: pop until v.
-                    let mut component = Vec::new();
-                    loop {
-                        let w = stack.pop().unwrap();
-                        on_stack[w] = false;
-                        component.push(w);
-                        if w == v {
-                            break;
-                        }
-                    }
-                    sccs.push(component);
-                }
+    /// See [`CompactGraph::delay_weighted_depth`].
+    pub fn delay_weighted_depth(&self) -> u32 {
+        self.to_compact().delay_weighted_depth()
+    }
 
-                // Pop v; propagate its lowlink to its parent (if any).
-                work.pop();
-                if let Some(&(parent, _)) = work.last() {
-                    lowlink[parent] = lowlink[parent].min(lowlink[v]);
-                }
-            }
-        }
+    /// Maximum incoming edge count over all nodes.
+    pub fn max_fan_in(&self) -> usize {
+        self.nodes.iter().map(|n| n.inputs.len()).max().unwrap_or(0)
+    }
 
-        sccs
+    /// Maximum outgoing edge count over all nodes.
+    pub fn max_fan_out(&self) -> usize {
+        self.to_compact().max_fan_out()
     }
 
-    /// True if the graph contains a directed cycle: any SCC of size > 1, OR any
-    /// node that lists itself among its own inputs (a self-loop).
-    pub fn has_cycles(&self) -> bool {
-        // Self-loop check is cheap; do it first.
-        for node in &self.nodes {
-            if node.inputs.iter().any(|l| l.from == node.id) {
-                return true;
-            }
+    /// See [`CompactGraph::features`].
+    pub fn features(&self) -> GraphFeatures {
+        self.to_compact().features()
+    }
+}
+
+/// Strongly connected components in the order Tarjan's algorithm completes
+/// them. A component is completed only after every component it reaches, so
+/// descending index is a topological order of the condensation.
+struct Components {
+    /// Component of each node, by index within the analysed part.
+    comp_of: Vec<u32>,
+    /// Members (node ids) of component `c` are
+    /// `members[starts[c]..starts[c + 1]]`.
+    members: Vec<u32>,
+    starts: Vec<u32>,
+}
+
+impl Components {
+    fn count(&self) -> usize {
+        self.starts.len() - 1
+    }
+
+    fn members(&self, c: usize) -> &[u32] {
+        &self.members[self.starts[c] as usize..self.starts[c + 1] as usize]
+    }
+
+    fn has_cycle(&self) -> bool {
+        (0..self.count()).any(|c| self.members(c).len() > 1)
+    }
+}
+
+/// Weakly connected components. No edge leaves one, so each is analysed on
+/// its own: in parallel, and reused across [`AnalysisSession`] updates when
+/// none of its nodes changed.
+struct WeakComponents {
+    /// Component of each node.
+    of: Vec<u32>,
+    /// Members of component `c`, ascending, are
+    /// `members[starts[c]..starts[c + 1]]`.
+    members: Vec<u32>,
+    starts: Vec<u32>,
+    /// Each node's index within its component's members.
+    local: Vec<u32>,
+}
+
+impl WeakComponents {
+    fn count(&self) -> usize {
+        self.starts.len() - 1
+    }
+
+    fn members(&self, c: usize) -> &[u32] {
+        &self.members[self.starts[c] as usize..self.starts[c + 1] as usize]
+    }
+}
+
+/// The cycle and depth metrics of one weak component.
+#[derive(Clone, Copy)]
+struct ComponentSummary {
+    scc_count: u32,
+    largest_scc: u32,
+    has_cycles: bool,
+    critical_path: u32,
+    delay_weighted_depth: u32,
+}
+
+impl CompactGraph {
+    /// Node count per kind code, indexed like [`NODE_KIND_NAMES`].
+    pub fn kind_counts(&self) -> [usize; NODE_KIND_NAMES.len()] {
+        let mut counts = [0usize; NODE_KIND_NAMES.len()];
+        for &kind in &self.kinds {
+            counts[kind as usize] += 1;
         }
-        self.strongly_connected_components()
+        counts
+    }
+
+    /// Stable kind name -> count, for the kinds present.
+    pub fn node_kind_counts(&self) -> BTreeMap<String, usize> {
+        NODE_KIND_NAMES
             .iter()
-            .any(|scc| scc.len() > 1)
+            .zip(self.kind_counts())
+            .filter(|(_, count)| *count > 0)
+            .map(|(name, count)| (name.to_string(), count))
+            .collect()
     }
 
-    /// A graph is combinational iff it has no cycles.
-    pub fn is_combinational(&self) -> bool {
-        !self.has_cycles()
+    pub fn fan_in(&self, node: usize) -> usize {
+        (self.in_offsets[node + 1] - self.in_offsets[node]) as usize
+    }
+
+    pub fn fan_out(&self, node: usize) -> usize {
+        (self.out_offsets[node + 1] - self.out_offsets[node]) as usize
+    }
+
+    pub fn max_fan_in(&self) -> usize {
+        (0..self.node_count())
+            .into_par_iter()
+            .map(|i| self.fan_in(i))
+            .max()
+            .unwrap_or(0)
+    }
+
+    pub fn max_fan_out(&self) -> usize {
+        (0..self.node_count())
+            .into_par_iter()
+            .map(|i| self.fan_out(i))
+            .max()
+            .unwrap_or(0)
+    }
+
+    /// Strongly connected components via an **iterative** Tarjan's algorithm
+    /// (explicit work stack — safe on very large/deep graphs). Each inner vec is
+    /// the set of node ids in one SCC. Component order is unspecified but the
+    /// decomposition is deterministic for a given graph.
+    pub fn strongly_connected_components(&self) -> Vec<Vec<usize>> {
+        let all: Vec<u32> = (0..self.node_count() as u32).collect();
+        let components = self.tarjan(&all, &all);
+        (0..components.count())
+            .map(|c| components.members(c).iter().map(|&v| v as usize).collect())
+            .collect()
+    }
+
+    /// True if the graph contains a directed cycle: any SCC of size > 1, OR any
+    /// node that feeds itself (a self-loop).
+    pub fn has_cycles(&self) -> bool {
+        let weak = self.weak_components();
+        self.summaries(&weak).iter().any(|s| s.has_cycles)
     }
 
     /// Number of weakly connected components: connected components when every
     /// directed edge is treated as undirected. Computed with union-find.
     pub fn weakly_connected_components(&self) -> usize {
-        let n = self.nodes.len();
-        if n == 0 {
-            return 0;
-        }
-        let mut uf = UnionFind::new(n);
-        for node in &self.nodes {
-            for link in &node.inputs {
-                if link.from < n {
-                    uf.union(node.id, link.from);
-                }
-            }
-        }
-        let mut roots = std::collections::HashSet::new();
-        for i in 0..n {
-            roots.insert(uf.find(i));
-        }
-        roots.len()
+        self.weak_components().count()
     }
 
     /// Longest path through the graph measured in **node count**, computed over
@@ -242,7 +257,9 @@ impl RedstoneGraph {
     /// the number of nodes on the longest directed path. The value is 0 for an
     /// empty graph and 1 for a single isolated node.
     pub fn critical_path(&self) -> u32 {
-        self.longest_weighted_path(WeightMode::NodeCount)
+        let weak = self.weak_components();
+        let summaries = self.summaries(&weak);
+        summaries.iter().map(|s| s.critical_path).max().unwrap_or(0)
     }
 
     /// Same longest-path-over-condensation metric as [`Self::critical_path`], but
@@ -251,173 +268,545 @@ impl RedstoneGraph {
     /// super-node weight is the sum of its members' delay weights. This
     /// approximates redstone-tick propagation delay along the deepest chain.
     pub fn delay_weighted_depth(&self) -> u32 {
-        self.longest_weighted_path(WeightMode::Delay)
-    }
-
-    /// Maximum incoming edge count over all nodes.
-    pub fn max_fan_in(&self) -> usize {
-        self.nodes.iter().map(|n| n.inputs.len()).max().unwrap_or(0)
-    }
-
-    /// Maximum outgoing edge count over all nodes.
-    pub fn max_fan_out(&self) -> usize {
-        self.out_adjacency()
+        let weak = self.weak_components();
+        let summaries = self.summaries(&weak);
+        summaries
             .iter()
-            .map(|o| o.len())
+            .map(|s| s.delay_weighted_depth)
             .max()
             .unwrap_or(0)
     }
 
-    /// Aggregate feature vector. The SCC decomposition (and the out-adjacency it
-    /// derives from) is computed once and reused for every cycle/depth metric.
+    /// Aggregate feature vector. The graph is split into weak components
+    /// once, and each component's SCC decomposition is computed once (in
+    /// parallel across components) and reused for every cycle/depth metric.
     pub fn features(&self) -> GraphFeatures {
-        let n = self.nodes.len();
-        let out = self.out_adjacency();
-        let sccs = self.tarjan_scc(&out, n);
-
-        // Self-loop detection (Tarjan reports a singleton SCC for a self-looping
-        // node, so check inputs explicitly).
-        let has_self_loop = self
-            .nodes
-            .iter()
-            .any(|node| node.inputs.iter().any(|l| l.from == node.id));
-        let has_cycles = has_self_loop || sccs.iter().any(|scc| scc.len() > 1);
-
-        let scc_count = sccs.len();
-        let largest_scc = sccs.iter().map(|s| s.len()).max().unwrap_or(0);
-
-        let critical_path = self.longest_path_with_sccs(&out, &sccs, WeightMode::NodeCount);
-        let delay_weighted_depth = self.longest_path_with_sccs(&out, &sccs, WeightMode::Delay);
-
-        let max_fan_in = self.max_fan_in();
-        let max_fan_out = out.iter().map(|o| o.len()).max().unwrap_or(0);
-
-        let mut approx_input_count = 0usize;
-        let mut approx_output_count = 0usize;
-        for node in &self.nodes {
-            match node.kind {
-                RedstoneNodeKind::Lever
-                | RedstoneNodeKind::Button
-                | RedstoneNodeKind::PressurePlate => approx_input_count += 1,
-                RedstoneNodeKind::Lamp
-                | RedstoneNodeKind::Trapdoor
-                | RedstoneNodeKind::NoteBlock => approx_output_count += 1,
-                _ => {}
-            }
-        }
+        let weak = self.weak_components();
+        let summaries = self.summaries(&weak);
+        self.features_from(&weak, &summaries)
+    }
+
+    fn features_from(
+        &self,
+        weak: &WeakComponents,
+        summaries: &[ComponentSummary],
+    ) -> GraphFeatures {
+        let has_cycles = summaries.iter().any(|s| s.has_cycles);
+        let kind_counts = self.kind_counts();
+        let count_of = |names: &[&str]| -> usize {
+            NODE_KIND_NAMES
+                .iter()
+                .zip(kind_counts)
+                .filter(|(name, _)| names.contains(*name))
+                .map(|(_, count)| count)
+                .sum()
+        };
+        let max = |metric: fn(&ComponentSummary) -> u32| -> u32 {
+            summaries.iter().map(metric).max().unwrap_or(0)
+        };
 
         GraphFeatures {
-            node_count: n,
+            node_count: self.node_count(),
             edge_count: self.edge_count(),
             node_kind_counts: self.node_kind_counts(),
             has_cycles,
             is_combinational: !has_cycles,
+            critical_path: max(|s| s.critical_path),
+            delay_weighted_depth: max(|s| s.delay_weighted_depth),
+            scc_count: summaries.iter().map(|s| s.scc_count as usize).sum(),
+            largest_scc: max(|s| s.largest_scc) as usize,
+            weakly_connected_components: weak.count(),
+            max_fan_in: self.max_fan_in(),
+            max_fan_out: self.max_fan_out(),
+            approx_input_count: count_of(&INPUT_KINDS),
+            approx_output_count: count_of(&OUTPUT_KINDS),
+        }
+    }
+
+    /// Union-find over the edges, then members grouped per component in
+    /// order of each component's lowest node id.
+    fn weak_components(&self) -> WeakComponents {
+        let n = self.node_count();
+        let mut uf = UnionFind::new(n);
+        for (&src, &dst) in self.edge_sources.iter().zip(&self.edge_targets) {
+            uf.union(src as usize, dst as usize);
+        }
+        const NONE: u32 = u32::MAX;
+        let mut id_of_root = vec![NONE; n];
+        let mut of = vec![0u32; n];
+        let mut sizes: Vec<u32> = Vec::new();
+        for v in 0..n {
+            let root = uf.find(v);
+            if id_of_root[root] == NONE {
+                id_of_root[root] = sizes.len() as u32;
+                sizes.push(0);
+            }
+            of[v] = id_of_root[root];
+            sizes[of[v] as usize] += 1;
+        }
+        let mut starts = Vec::with_capacity(sizes.len() + 1);
+        starts.push(0u32);
+        for size in &sizes {
+            starts.push(starts.last().unwrap() + size);
+        }
+        let mut next = starts.clone();
+        let mut members = vec![0u32; n];
+        let mut local = vec![0u32; n];
+        for v in 0..n {
+            let c = of[v] as usize;
+            members[next[c] as usize] = v as u32;
+            local[v] = next[c] - starts[c];
+            next[c] += 1;
+        }
+        WeakComponents {
+            of,
+            members,
+            starts,
+            local,
+        }
+    }
+
+    /// [`ComponentSummary`] of every weak component, in parallel.
+    fn summaries(&self, weak: &WeakComponents) -> Vec<ComponentSummary> {
+        (0..weak.count())
+            .into_par_iter()
+            .map(|c| self.summarize(weak.members(c), &weak.local))
+            .collect()
+    }
+
+    /// Cycle and depth metrics of the part of the graph made of `nodes`
+    /// (ascending, closed under edges), where `local[v]` is v's index in
+    /// `nodes`.
+    fn summarize(&self, nodes: &[u32], local: &[u32]) -> ComponentSummary {
+        let components = self.tarjan(nodes, local);
+        // Tarjan reports a singleton SCC for a self-looping node, so check
+        // the edges explicitly.
+        let self_loop = nodes
+            .iter()
+            .any(|&v| self.successors(v as usize).contains(&v));
+        let (critical_path, delay_weighted_depth) = rayon::join(
+            || self.longest_path(local, &components, WeightMode::NodeCount),
+            || self.longest_path(local, &components, WeightMode::Delay),
+        );
+        ComponentSummary {
+            scc_count: components.count() as u32,
+            largest_scc: (0..components.count())
+                .map(|c| components.members(c).len() as u32)
+                .max()
+                .unwrap_or(0),
+            has_cycles: self_loop || components.has_cycle(),
             critical_path,
             delay_weighted_depth,
-            scc_count,
-            largest_scc,
-            weakly_connected_components: self.weakly_connected_components(),
-            max_fan_in,
-            max_fan_out,
-            approx_input_count,
-            approx_output_count,
         }
     }
 
-    /// Convenience entry: derive SCCs then delegate to the shared longest-path
-    /// routine.
-    fn longest_weighted_path(&self, mode: WeightMode) -> u32 {
-        let n = self.nodes.len();
-        let out = self.out_adjacency();
-        let sccs = self.tarjan_scc(&out, n);
-        self.longest_path_with_sccs(&out, &sccs, mode)
+    /// Per-node weight under `mode`: a Repeater contributes its configured
+    /// `delay` (1..=4 redstone ticks) for [`WeightMode::Delay`]; everything
+    /// else contributes 1.
+    fn weight(&self, node: usize, mode: WeightMode) -> u32 {
+        match mode {
+            WeightMode::Delay if self.kinds[node] == REPEATER => u32::from(self.params[node]),
+            _ => 1,
+        }
     }
 
-    /// Longest weighted path over the condensation DAG.
-    ///
-    /// Builds the SCC-component mapping, the per-component weight (sum of member
-    /// node weights under `mode`), and the condensation's edges, then does a
-    /// topological-order DP (the condensation is always acyclic).
-    fn longest_path_with_sccs(
-        &self,
-        out: &[Vec<usize>],
-        sccs: &[Vec<usize>],
-        mode: WeightMode,
-    ) -> u32 {
-        let n = self.nodes.len();
-        if n == 0 {
-            return 0;
-        }
-        let c = sccs.len();
+    /// Iterative Tarjan over the out-edge rows of `nodes` (ascending, closed
+    /// under edges), where `local[v]` is v's index in `nodes`.
+    fn tarjan(&self, nodes: &[u32], local: &[u32]) -> Components {
+        const UNVISITED: u32 = u32::MAX;
+        let n = nodes.len();
+        let mut index = vec![UNVISITED; n];
+        let mut lowlink = vec![0u32; n];
+        let mut on_stack = vec![false; n];
+        let mut stack: Vec<u32> = Vec::new();
+        let mut next_index = 0u32;
+        let mut components = Components {
+            comp_of: vec![0; n],
+            members: Vec::with_capacity(n),
+            starts: vec![0],
+        };
+
+        // Each work-stack frame is a (local) node and the position of the
+        // next out-edge to follow (the "for child" loop, resumed
+        // iteratively).
+        let mut work: Vec<(u32, u32)> = Vec::new();
 
-        // node id -> component index.
-        let mut comp_of = vec![0usize; n];
-        for (ci, scc) in sccs.iter().enumerate() {
-            for &node_id in scc {
-                comp_of[node_id] = ci;
+        for root in 0..n {
+            if index[root] != UNVISITED {
+                continue;
             }
-        }
+            index[root] = next_index;
+            lowlink[root] = next_index;
+            next_index += 1;
+            stack.push(root as u32);
+            on_stack[root] = true;
+            work.push((root as u32, self.out_offsets[nodes[root] as usize]));
+
+            while let Some(frame) = work.last_mut() {
+                let v = frame.0 as usize;
+                if frame.1 < self.out_offsets[nodes[v] as usize + 1] {
+                    let w = local[self.out_targets[frame.1 as usize] as usize] as usize;
+                    frame.1 += 1;
+                    if index[w] == UNVISITED {
+                        // Descend into w; v resumes at its next edge afterwards.
+                        index[w] = next_index;
+                        lowlink[w] = next_index;
+                        next_index += 1;
+                        stack.push(w as u32);
+                        on_stack[w] = true;
+                        work.push((w as u32, self.out_offsets[nodes[w] as usize]));
+                    } else if on_stack[w] {
+                        lowlink[v] = lowlink[v].min(index[w]);
+                    }
+                    continue;
+                }
 
-        // Per-component weight under the requested mode.
-        let mut weight = vec![0u32; c];
-        for (ci, scc) in sccs.iter().enumerate() {
-            let mut w = 0u32;
-            for &node_id in scc {
-                w = w.saturating_add(match mode {
-                    WeightMode::NodeCount => 1,
-                    WeightMode::Delay => delay_weight(&self.nodes[node_id].kind),
-                });
+                // Done with all of v's successors.
+                work.pop();
+                if lowlink[v] == index[v] {
+                    // v is an SCC root: pop until v.
+                    let c = components.count() as u32;
+                    loop {
+                        let w = stack.pop().unwrap() as usize;
+                        on_stack[w] = false;
+                        components.comp_of[w] = c;
+                        components.members.push(nodes[w]);
+                        if w == v {
+                            break;
+                        }
+                    }
+                    components.starts.push(components.members.len() as u32);
+                }
+                // Propagate v's lowlink to its parent (if any).
+                if let Some(&(parent, _)) = work.last() {
+                    let parent = parent as usize;
+                    lowlink[parent] = lowlink[parent].min(lowlink[v]);
+                }
             }
-            weight[ci] = w;
         }
 
-        // Condensation edges (dedup self-edges between same component).
-        let mut cond_out: Vec<Vec<usize>> = vec![Vec::new(); c];
-        let mut indeg = vec![0usize; c];
-        // Track existing edges to avoid duplicate counting of indegree.
-        let mut seen: std::collections::HashSet<(usize, usize)> = std::collections::HashSet::new();
-        for u in 0..n {
-            let cu = comp_of[u];
-            for &v in &out[u] {
-                let cv = comp_of[v];
-                if cu != cv && seen.insert((cu, cv)) {
-                    cond_out[cu].push(cv);
-                    indeg[cv] += 1;
+        components
+    }
+
+    /// Longest weighted path over the condensation DAG: a DP over the
+    /// components in topological (descending completion) order, where each
+    /// component weighs the sum of its members' weights under `mode`.
+    fn longest_path(&self, local: &[u32], components: &Components, mode: WeightMode) -> u32 {
+        let c = components.count();
+        let weight: Vec<u32> = (0..c)
+            .map(|ci| {
+                components.members(ci).iter().fold(0u32, |w, &node| {
+                    w.saturating_add(self.weight(node as usize, mode))
+                })
+            })
+            .collect();
+
+        // best[u] = max path-weight ending at component u (inclusive).
+        let mut best = weight.clone();
+        for ci in (0..c).rev() {
+            let bu = best[ci];
+            for &node in components.members(ci) {
+                for &succ in self.successors(node as usize) {
+                    let cv = components.comp_of[local[succ as usize] as usize] as usize;
+                    if cv != ci {
+                        best[cv] = best[cv].max(bu.saturating_add(weight[cv]));
+                    }
                 }
             }
         }
 
-        // Kahn topological order over the condensation.
-        let mut queue: Vec<usize> = (0..c).filter(|&i| indeg[i] == 0).collect();
-        let mut topo: Vec<usize> = Vec::with_capacity(c);
-        let mut indeg_mut = indeg.clone();
-        let mut head = 0;
-        while head < queue.len() {
-            let u = queue[head];
-            head += 1;
-            topo.push(u);
-            for &v in &cond_out[u] {
-                indeg_mut[v] -= 1;
-                if indeg_mut[v] == 0 {
-                    queue.push(v);
-                }
+        best.into_iter().max().unwrap_or(0)
+    }
+}
+
+/// Features and fingerprints of successive exports of one build, updated
+/// incrementally.
+///
+/// Nodes are matched to the previous export by position. A node is *clean*
+/// when its match has the same kind, payload, state and edges (to matched
+/// nodes, with the same kind and strength); anything else is *dirty*. On
+/// [`AnalysisSession::update`]:
+///
+/// - a weak component whose nodes are all clean and match one whole previous
+///   component keeps that component's SCC/depth summary; the rest are
+///   re-analysed in parallel;
+/// - for every spec fingerprinted so far, round `r` of the WL colouring is
+///   recomputed only for nodes within `r` edges of a dirty node and copied
+///   for the rest, so the fingerprint follows from the stored final colours
+///   without a full re-walk.
+///
+/// Node ids may change freely between exports.
+pub struct AnalysisSession {
+    graph: CompactGraph,
+    weak: WeakComponents,
+    summaries: Vec<ComponentSummary>,
+    features: GraphFeatures,
+    /// WL colours of every round, per spec fingerprinted so far, kept in
+    /// step with `graph`.
+    labels: Vec<(GraphFingerprintSpec, Vec<Vec<u128>>)>,
+    reused_components: usize,
+    dirty_nodes: usize,
+}
+
+impl AnalysisSession {
+    /// Analyse `graph` from scratch.
+    pub fn new(graph: CompactGraph) -> Self {
+        let weak = graph.weak_components();
+        let summaries = graph.summaries(&weak);
+        let features = graph.features_from(&weak, &summaries);
+        AnalysisSession {
+            graph,
+            weak,
+            summaries,
+            features,
+            labels: Vec::new(),
+            reused_components: 0,
+            dirty_nodes: 0,
+        }
+    }
+
+    /// Move to the next export of the build and return its features.
+    pub fn update(&mut self, graph: CompactGraph) -> &GraphFeatures {
+        let old_of = match_nodes(&self.graph, &graph);
+        let weak = graph.weak_components();
+
+        // Previous component a new one can be reused from, if any.
+        let reusable = |c: usize| -> Option<usize> {
+            let members = weak.members(c);
+            let first = old_of[members[0] as usize];
+            if first == UNMATCHED {
+                return None;
             }
+            let old_c = self.weak.of[first as usize] as usize;
+            let same = self.weak.members(old_c).len() == members.len()
+                && members.iter().all(|&v| {
+                    let u = old_of[v as usize];
+                    u != UNMATCHED && self.weak.of[u as usize] as usize == old_c
+                });
+            same.then_some(old_c)
+        };
+        let summaries: Vec<(ComponentSummary, bool)> = (0..weak.count())
+            .into_par_iter()
+            .map(|c| match reusable(c) {
+                Some(old_c) => (self.summaries[old_c], true),
+                None => (graph.summarize(weak.members(c), &weak.local), false),
+            })
+            .collect();
+        self.reused_components = summaries.iter().filter(|(_, reused)| *reused).count();
+        let summaries: Vec<ComponentSummary> = summaries.into_iter().map(|(s, _)| s).collect();
+
+        let depth = self
+            .labels
+            .iter()
+            .map(|(spec, _)| spec.iterations)
+            .max()
+            .unwrap_or(0);
+        let dist = dirty_distance(&graph, &old_of, depth);
+        self.dirty_nodes = old_of.iter().filter(|&&u| u == UNMATCHED).count();
+        for (spec, rounds) in &mut self.labels {
+            *rounds = recolour(&graph, spec, rounds, &old_of, &dist);
         }
 
-        // DP: best[u] = max path-weight ending at component u (inclusive).
-        let mut best = weight.clone();
-        for &u in &topo {
-            let bu = best[u];
-            for &v in &cond_out[u] {
-                let cand = bu.saturating_add(weight[v]);
-                if cand > best[v] {
-                    best[v] = cand;
+        self.features = graph.features_from(&weak, &summaries);
+        self.graph = graph;
+        self.weak = weak;
+        self.summaries = summaries;
+        &self.features
+    }
+
+    /// Features of the current export.
+    pub fn features(&self) -> &GraphFeatures {
+        &self.features
+    }
+
+    pub fn graph(&self) -> &CompactGraph {
+        &self.graph
+    }
+
+    /// Fingerprint of the current export under `spec`. The first call for a
+    /// spec colours the whole graph; later updates keep its colours current.
+    pub fn fingerprint(&mut self, spec: &GraphFingerprintSpec) -> RedstoneFingerprint {
+        let at = match self.labels.iter().position(|(s, _)| s == spec) {
+            Some(at) => at,
+            None => {
+                let rounds = self.graph.fingerprint_rounds(spec);
+                self.labels.push((*spec, rounds));
+                self.labels.len() - 1
+            }
+        };
+        let last = self.labels[at].1.last().cloned().unwrap_or_default();
+        combine_labels(self.graph.node_count(), self.graph.edge_count(), last)
+    }
+
+    /// Weak components the last update carried over unchanged.
+    pub fn reused_components(&self) -> usize {
+        self.reused_components
+    }
+
+    /// Nodes of the current export without a clean match in the previous
+    /// one.
+    pub fn dirty_nodes(&self) -> usize {
+        self.dirty_nodes
+    }
+}
+
+/// [`match_nodes`] entry of a node with no clean match.
+const UNMATCHED: u32 = u32::MAX;
+
+/// For each node of `new`, the node of `old` at the same position if both
+/// are clean (see [`AnalysisSession`]), else [`UNMATCHED`].
+fn match_nodes(old: &CompactGraph, new: &CompactGraph) -> Vec<u32> {
+    let by_pos = |g: &CompactGraph| -> HashMap<[i32; 3], u32> {
+        let mut map = HashMap::with_capacity(g.node_count());
+        for v in 0..g.node_count() {
+            if g.flags[v] & NODE_HAS_POS == 0 {
+                continue;
+            }
+            let pos = [0, 1, 2].map(|i| g.positions[v * 3 + i]);
+            // Shared positions are ambiguous: match neither.
+            map.entry(pos)
+                .and_modify(|id| *id = UNMATCHED)
+                .or_insert(v as u32);
+        }
+        map
+    };
+    let old_by_pos = by_pos(old);
+    let new_by_pos = by_pos(new);
+    let candidate: Vec<u32> = (0..new.node_count())
+        .map(|v| {
+            if new.flags[v] & NODE_HAS_POS == 0 {
+                return UNMATCHED;
+            }
+            let pos = [0, 1, 2].map(|i| new.positions[v * 3 + i]);
+            if new_by_pos.get(&pos) != Some(&(v as u32)) {
+                return UNMATCHED;
+            }
+            old_by_pos.get(&pos).copied().unwrap_or(UNMATCHED)
+        })
+        .collect();
+
+    (0..new.node_count())
+        .into_par_iter()
+        .map(|v| {
+            let u = candidate[v];
+            let clean = u != UNMATCHED
+                && same_node(old, u as usize, new, v)
+                && same_edges(
+                    old.incoming(u as usize).map(|e| (old.edge_sources[e], e)),
+                    new.incoming(v).map(|e| (new.edge_sources[e], e)),
+                    old,
+                    new,
+                    &candidate,
+                )
+                && same_edges(
+                    old.outgoing(u as usize)
+                        .iter()
+                        .map(|&e| (old.edge_targets[e as usize], e as usize)),
+                    new.outgoing(v)
+                        .iter()
+                        .map(|&e| (new.edge_targets[e as usize], e as usize)),
+                    old,
+                    new,
+                    &candidate,
+                );
+            if clean {
+                u
+            } else {
+                UNMATCHED
+            }
+        })
+        .collect()
+}
+
+fn same_node(old: &CompactGraph, u: usize, new: &CompactGraph, v: usize) -> bool {
+    old.kinds[u] == new.kinds[v]
+        && old.params[u] == new.params[v]
+        && old.far_inputs[u] == new.far_inputs[v]
+        && old.output_strengths[u] == new.output_strengths[v]
+        && old.flags[u] == new.flags[v]
+}
+
+/// Whether two edge lists, as `(neighbour, edge index)`, are the same
+/// multiset once `new` neighbours are mapped through `candidate`.
+fn same_edges(
+    old_edges: impl Iterator<Item = (u32, usize)>,
+    new_edges: impl Iterator<Item = (u32, usize)>,
+    old: &CompactGraph,
+    new: &CompactGraph,
+    candidate: &[u32],
+) -> bool {
+    let mut a: Vec<(u32, u8, u8)> = old_edges
+        .map(|(n, e)| (n, old.edge_kinds[e], old.edge_weights[e]))
+        .collect();
+    let mut b: Vec<(u32, u8, u8)> = new_edges
+        .map(|(n, e)| {
+            (
+                candidate[n as usize],
+                new.edge_kinds[e],
+                new.edge_weights[e],
+            )
+        })
+        .collect();
+    if a.len() != b.len() || b.iter().any(|&(n, _, _)| n == UNMATCHED) {
+        return false;
+    }
+    a.sort_unstable();
+    b.sort_unstable();
+    a == b
+}
+
+/// Undirected edge distance from each node of `graph` to the nearest
+/// unmatched one, searched up to `depth`; nodes further away get
+/// `u32::MAX`.
+fn dirty_distance(graph: &CompactGraph, old_of: &[u32], depth: u32) -> Vec<u32> {
+    let mut dist: Vec<u32> = old_of
+        .iter()
+        .map(|&u| if u == UNMATCHED { 0 } else { u32::MAX })
+        .collect();
+    let mut frontier: Vec<usize> = (0..dist.len()).filter(|&v| dist[v] == 0).collect();
+    for d in 1..=depth {
+        let mut next = Vec::new();
+        for &v in &frontier {
+            for &w in graph.predecessors(v).iter().chain(graph.successors(v)) {
+                if dist[w as usize] == u32::MAX {
+                    dist[w as usize] = d;
+                    next.push(w as usize);
                 }
             }
         }
+        frontier = next;
+    }
+    dist
+}
 
-        best.into_iter().max().unwrap_or(0)
+/// `old_rounds` (the previous export's WL colours under `spec`) moved to
+/// `graph`: round `r` is recomputed for nodes within `r` edges of a dirty
+/// node and copied from the matched node otherwise.
+fn recolour(
+    graph: &CompactGraph,
+    spec: &GraphFingerprintSpec,
+    old_rounds: &[Vec<u128>],
+    old_of: &[u32],
+    dist: &[u32],
+) -> Vec<Vec<u128>> {
+    let n = graph.node_count();
+    let mut rounds: Vec<Vec<u128>> = Vec::with_capacity(old_rounds.len());
+    for (r, old) in old_rounds.iter().enumerate() {
+        let labels = (0..n)
+            .into_par_iter()
+            .map(|v| {
+                if dist[v] > r as u32 {
+                    old[old_of[v] as usize]
+                } else if r == 0 {
+                    initial_label(graph, v, spec)
+                } else {
+                    refined_label(graph, v, &rounds[r - 1], spec)
+                }
+            })
+            .collect();
+        rounds.push(labels);
     }
+    rounds
 }
 
 /// Weighting strategy for the longest-path kernels.
@@ -469,6 +858,7 @@ mod tests {
     use super::*;
     use crate::simulation::graph::{
         ComparatorMode, LinkKind, RedstoneGraph, RedstoneLink, RedstoneNode, RedstoneNodeKind,
+        NODE_HAS_POS, NODE_POWERED,
     };
     use crate::simulation::MchprsWorld;
     use crate::{BlockState, UniversalSchematic};
@@ -668,7 +1058,98 @@ mod tests {
         );
     }
 
-    // ---- test 7: features JSON round-trip --------------------------------
+    // ---- test 7: compact rows ---------------------------------------------
+
+    #[test]
+    fn test_compact_rows_and_kernels() {
+        // Lever(0) -> Repeater(1) <-> Torch(2) -> Comparator(3), plus a link
+        // from a node that does not exist.
+        let mut graph = RedstoneGraph {
+            nodes: vec![
+                node(0, RedstoneNodeKind::Lever, vec![]),
+                node(1, RedstoneNodeKind::Repeater { delay: 3 }, vec![0, 2]),
+                node(2, RedstoneNodeKind::Torch, vec![1]),
+                node(
+                    3,
+                    RedstoneNodeKind::Comparator {
+                        mode: ComparatorMode::Subtract,
+                        far_input: Some(7),
+                    },
+                    vec![2, 9],
+                ),
+            ],
+        };
+        graph.nodes[2].pos = Some((4, 5, 6));
+        graph.nodes[2].powered = true;
+
+        let g = graph.to_compact();
+        assert_eq!(
+            g.in_offsets,
+            vec![0, 0, 2, 3, 4],
+            "the dangling link is dropped"
+        );
+        assert_eq!(g.edge_sources, vec![0, 2, 1, 2]);
+        assert_eq!(g.edge_targets, vec![1, 1, 2, 3]);
+        assert_eq!(g.successors(2), &[1, 3]);
+        assert_eq!(g.predecessors(1), &[0, 2]);
+        assert_eq!(NODE_KIND_NAMES[g.kinds[3] as usize], "Comparator");
+        assert_eq!((g.params[1], g.params[3], g.far_inputs[3]), (3, 1, 7));
+        assert_eq!(g.flags[2], NODE_HAS_POS | NODE_POWERED);
+        assert_eq!(&g.positions[6..9], &[4, 5, 6]);
+
+        let f = g.features();
+        assert!(f.has_cycles);
+        assert_eq!((f.scc_count, f.largest_scc), (3, 2));
+        // Lever, the repeater/torch loop (3 + 1), then the comparator.
+        assert_eq!(f.critical_path, 4);
+        assert_eq!(f.delay_weighted_depth, 6);
+        assert_eq!((f.max_fan_in, f.max_fan_out), (2, 2));
+        assert_eq!(f.weakly_connected_components, 1);
+    }
+
+    // ---- test 8: incremental session ----------------------------------------
+
+    /// Two separate chains, lever -> torch -> lamp along z = 0 and lever ->
+    /// repeater -> lamp along z = 5, with the second chain's nodes numbered
+    /// first when `b_first`.
+    fn two_chains(delay: u8, b_first: bool) -> RedstoneGraph {
+        let (a, b) = if b_first { (3, 0) } else { (0, 3) };
+        let mut nodes = vec![
+            node(a, RedstoneNodeKind::Lever, vec![]),
+            node(a + 1, RedstoneNodeKind::Torch, vec![a]),
+            node(a + 2, RedstoneNodeKind::Lamp, vec![a + 1]),
+            node(b, RedstoneNodeKind::Lever, vec![]),
+            node(b + 1, RedstoneNodeKind::Repeater { delay }, vec![b]),
+            node(b + 2, RedstoneNodeKind::Lamp, vec![b + 1]),
+        ];
+        for (i, n) in nodes.iter_mut().enumerate() {
+            n.pos = Some(((i % 3) as i32, 0, if i < 3 { 0 } else { 5 }));
+        }
+        nodes.sort_by_key(|n| n.id);
+        RedstoneGraph { nodes }
+    }
+
+    #[test]
+    fn test_session_updates_match_a_fresh_analysis() {
+        let spec = GraphFingerprintSpec::exact();
+        let mut session = AnalysisSession::new(two_chains(2, false).to_compact());
+        session.fingerprint(&spec);
+
+        // Retime the repeater and renumber every node.
+        let next = two_chains(4, true);
+        let features = session.update(next.to_compact()).clone();
+        assert_eq!(features, next.features());
+        assert_eq!(features.delay_weighted_depth, 6);
+        assert_eq!(session.dirty_nodes(), 1, "only the repeater changed");
+        assert_eq!(session.reused_components(), 1, "the torch chain is reused");
+        assert_eq!(session.fingerprint(&spec), next.fingerprint(&spec));
+        assert_ne!(
+            session.fingerprint(&spec),
+            two_chains(2, false).fingerprint(&spec)
+        );
+    }
+
+    // ---- test 9: features JSON round-trip --------------------------------
 
     #[test]
     fn test_features_json_round_trip() {
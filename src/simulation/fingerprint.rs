@@ -17,7 +17,11 @@
 //! the deliverable here. As with any WL scheme, a shared hash is strong
 //! (collision-resistant) evidence of isomorphism but not a proof.
 
-use super::graph::{ComparatorMode, LinkKind, RedstoneGraph, RedstoneNode, RedstoneNodeKind};
+use super::graph::{
+    CompactGraph, RedstoneGraph, NODE_FACING_DIODE, NODE_POWERED, NODE_REPEATER_LOCKED,
+    NO_FAR_INPUT,
+};
+use rayon::prelude::*;
 
 /// 128-bit Weisfeiler-Lehman fingerprint of a redstone graph.
 ///
@@ -121,166 +125,172 @@ fn hash128(bytes: &[u8]) -> u128 {
     u128::from_le_bytes(buf)
 }
 
-/// Discriminant byte for a node kind. Stable, never derived from `pos`/`id`.
-fn kind_discriminant(kind: &RedstoneNodeKind) -> u8 {
-    match kind {
-        RedstoneNodeKind::Repeater { .. } => 0,
-        RedstoneNodeKind::Comparator { .. } => 1,
-        RedstoneNodeKind::Torch => 2,
-        RedstoneNodeKind::Lamp => 3,
-        RedstoneNodeKind::Button => 4,
-        RedstoneNodeKind::Lever => 5,
-        RedstoneNodeKind::PressurePlate => 6,
-        RedstoneNodeKind::Trapdoor => 7,
-        RedstoneNodeKind::Wire => 8,
-        RedstoneNodeKind::Constant => 9,
-        RedstoneNodeKind::NoteBlock => 10,
-    }
-}
-
-/// Initial WL colour for a node from its masked features.
-fn initial_label(node: &RedstoneNode, spec: &GraphFingerprintSpec) -> u128 {
+/// Initial WL colour for `node` from its masked features. The kind code is
+/// [`CompactGraph::kinds`], a stable discriminant never derived from
+/// `pos`/`id`.
+pub(crate) fn initial_label(g: &CompactGraph, node: usize, spec: &GraphFingerprintSpec) -> u128 {
     let mut buf: Vec<u8> = Vec::with_capacity(16);
     buf.push(0xA0); // domain tag: "initial node label"
-    buf.push(kind_discriminant(&node.kind));
-
-    match &node.kind {
-        RedstoneNodeKind::Repeater { delay } => {
-            if spec.include_delay {
-                buf.push(0xD0);
-                buf.push(*delay);
-            }
-        }
-        RedstoneNodeKind::Comparator { mode, far_input } => {
-            if spec.include_comparator_mode {
-                buf.push(0xC0);
-                buf.push(match mode {
-                    ComparatorMode::Compare => 0,
-                    ComparatorMode::Subtract => 1,
-                });
-                // far_input: presence flag + value (0 when absent).
-                buf.push(far_input.is_some() as u8);
-                buf.push(far_input.unwrap_or(0));
-            }
-        }
-        _ => {}
+    let kind = g.kinds[node];
+    buf.push(kind);
+
+    if kind == REPEATER && spec.include_delay {
+        buf.push(0xD0);
+        buf.push(g.params[node]);
+    }
+    if kind == COMPARATOR && spec.include_comparator_mode {
+        buf.push(0xC0);
+        buf.push(g.params[node]);
+        // far_input: presence flag + value (0 when absent).
+        let far_input = g.far_inputs[node];
+        buf.push((far_input != NO_FAR_INPUT) as u8);
+        buf.push(if far_input == NO_FAR_INPUT {
+            0
+        } else {
+            far_input
+        });
     }
 
+    let flags = g.flags[node];
     if spec.include_facing {
         buf.push(0xF0);
-        buf.push(node.facing_diode as u8);
+        buf.push((flags & NODE_FACING_DIODE != 0) as u8);
     }
 
     if spec.include_state {
         buf.push(0x50);
-        buf.push(node.powered as u8);
-        buf.push(node.repeater_locked as u8);
-        buf.push(node.output_strength);
+        buf.push((flags & NODE_POWERED != 0) as u8);
+        buf.push((flags & NODE_REPEATER_LOCKED != 0) as u8);
+        buf.push(g.output_strengths[node]);
     }
 
     hash128(&buf)
 }
 
-/// Colour for a single edge (link kind, and strength if enabled).
-fn link_label(kind: LinkKind, strength: u8, spec: &GraphFingerprintSpec) -> u8 {
-    // Pack into a single discriminant byte: 2 bits kind, optional strength tag.
-    // We keep it a byte for compact, deterministic serialization; strength is
-    // appended separately by the caller when enabled.
-    let _ = (strength, spec);
-    match kind {
-        LinkKind::Default => 0,
-        LinkKind::Side => 1,
-    }
-}
+/// Kind codes with spec-dependent payload (indices into
+/// [`NODE_KIND_NAMES`](super::graph::NODE_KIND_NAMES)).
+const REPEATER: u8 = 0;
+const COMPARATOR: u8 = 1;
 
 /// Direction tags for the WL neighbour multiset.
 const DIR_IN: u8 = 0x01;
 const DIR_OUT: u8 = 0x02;
 
-impl RedstoneGraph {
-    /// Weisfeiler-Lehman fingerprint of this graph under `spec`.
-    ///
-    /// Order-independent and position-independent: shuffling `nodes` (with
-    /// consistent re-indexing) or translating the build yields the same value.
-    pub fn fingerprint(&self, spec: &GraphFingerprintSpec) -> RedstoneFingerprint {
-        let n = self.nodes.len();
-
-        // Precompute out-adjacency once: out_edges[from] = Vec<(to, kind, strength)>.
-        // `inputs` holds incoming edges (from -> this), so we invert them.
-        let mut out_edges: Vec<Vec<(usize, LinkKind, u8)>> = vec![Vec::new(); n];
-        for node in &self.nodes {
-            let to = node.id;
-            for link in &node.inputs {
-                if link.from < n {
-                    out_edges[link.from].push((to, link.kind, link.strength));
-                }
-            }
-        }
+/// One neighbour-edge tuple, serialized: direction, link kind (0 default, 1
+/// side), strength if the spec enables it, then the neighbour's label. The
+/// length is fixed per spec, so comparing whole arrays orders them like the
+/// serialized bytes.
+type EdgeKey = [u8; 19];
 
-        // Round 0 colours.
-        let mut labels: Vec<u128> = self
-            .nodes
-            .iter()
-            .map(|node| initial_label(node, spec))
-            .collect();
+fn encode_edge(
+    dir: u8,
+    g: &CompactGraph,
+    edge: usize,
+    neighbour_label: u128,
+    spec: &GraphFingerprintSpec,
+) -> EdgeKey {
+    let mut e = [0u8; 19];
+    e[0] = dir;
+    e[1] = g.edge_kinds[edge];
+    let at = if spec.include_link_strength {
+        e[2] = g.edge_weights[edge];
+        3
+    } else {
+        2
+    };
+    e[at..at + 16].copy_from_slice(&neighbour_label.to_le_bytes());
+    e
+}
 
-        // WL refinement rounds.
-        for _ in 0..spec.iterations {
-            let mut next: Vec<u128> = Vec::with_capacity(n);
-            for node in &self.nodes {
-                let idx = node.id;
-
-                // Multiset of (direction, link_label[, strength], neighbour_label).
-                let mut neigh: Vec<Vec<u8>> = Vec::new();
-
-                // Incoming edges: (IN, link, neighbour=link.from).
-                for link in &node.inputs {
-                    if link.from >= n {
-                        continue;
-                    }
-                    neigh.push(encode_edge(
-                        DIR_IN,
-                        link.kind,
-                        link.strength,
-                        labels[link.from],
-                        spec,
-                    ));
-                }
-                // Outgoing edges: (OUT, link, neighbour=to).
-                for &(to, kind, strength) in &out_edges[idx] {
-                    neigh.push(encode_edge(DIR_OUT, kind, strength, labels[to], spec));
-                }
+/// The next WL colour of `node` from the previous round's `labels`.
+pub(crate) fn refined_label(
+    g: &CompactGraph,
+    node: usize,
+    labels: &[u128],
+    spec: &GraphFingerprintSpec,
+) -> u128 {
+    // Multiset of (direction, link[, strength], neighbour label): incoming
+    // edges from their sources, outgoing edges to their targets.
+    let mut neigh: Vec<EdgeKey> = Vec::new();
+    for edge in g.incoming(node) {
+        let from = g.edge_sources[edge] as usize;
+        neigh.push(encode_edge(DIR_IN, g, edge, labels[from], spec));
+    }
+    for &edge in g.outgoing(node) {
+        let to = g.edge_targets[edge as usize] as usize;
+        neigh.push(encode_edge(DIR_OUT, g, edge as usize, labels[to], spec));
+    }
 
-                // Sort the multiset → canonical / node-ordering independent.
-                neigh.sort_unstable();
+    // Sort the multiset → canonical / node-ordering independent.
+    neigh.sort_unstable();
+
+    let len = if spec.include_link_strength { 19 } else { 18 };
+    let mut buf: Vec<u8> = Vec::with_capacity(20 + neigh.len() * (len + 4));
+    buf.push(0xB0); // domain tag: "refined node label"
+    buf.extend_from_slice(&labels[node].to_le_bytes());
+    buf.extend_from_slice(&(neigh.len() as u32).to_le_bytes());
+    for e in &neigh {
+        buf.extend_from_slice(&(len as u32).to_le_bytes());
+        buf.extend_from_slice(&e[..len]);
+    }
+    hash128(&buf)
+}
 
-                let mut buf: Vec<u8> = Vec::with_capacity(17 + neigh.len() * 18);
-                buf.push(0xB0); // domain tag: "refined node label"
-                buf.extend_from_slice(&labels[idx].to_le_bytes());
-                buf.extend_from_slice(&(neigh.len() as u32).to_le_bytes());
-                for e in &neigh {
-                    buf.extend_from_slice(&(e.len() as u32).to_le_bytes());
-                    buf.extend_from_slice(e);
-                }
-                next.push(hash128(&buf));
-            }
-            labels = next;
-        }
+/// Graph fingerprint = hash(node_count, edge_count, sorted final labels).
+pub(crate) fn combine_labels(
+    node_count: usize,
+    edge_count: usize,
+    mut labels: Vec<u128>,
+) -> RedstoneFingerprint {
+    labels.sort_unstable();
+    let mut buf: Vec<u8> = Vec::with_capacity(17 + labels.len() * 16);
+    buf.push(0xC1); // domain tag: "graph fingerprint"
+    buf.extend_from_slice(&(node_count as u64).to_le_bytes());
+    buf.extend_from_slice(&(edge_count as u64).to_le_bytes());
+    for l in &labels {
+        buf.extend_from_slice(&l.to_le_bytes());
+    }
+    RedstoneFingerprint(hash128(&buf))
+}
 
-        // Graph fingerprint = hash(node_count, edge_count, sorted final labels).
-        let edge_count: usize = self.nodes.iter().map(|nd| nd.inputs.len()).sum();
-        let mut final_labels = labels;
-        final_labels.sort_unstable();
-
-        let mut buf: Vec<u8> = Vec::with_capacity(16 + final_labels.len() * 16);
-        buf.push(0xC1); // domain tag: "graph fingerprint"
-        buf.extend_from_slice(&(n as u64).to_le_bytes());
-        buf.extend_from_slice(&(edge_count as u64).to_le_bytes());
-        for l in &final_labels {
-            buf.extend_from_slice(&l.to_le_bytes());
+impl CompactGraph {
+    /// The WL colours of every node after each round under `spec`: entry 0
+    /// is the initial colours, the last entry the final ones. Each round
+    /// colours the nodes in parallel.
+    pub fn fingerprint_rounds(&self, spec: &GraphFingerprintSpec) -> Vec<Vec<u128>> {
+        let n = self.node_count();
+        let mut rounds = Vec::with_capacity(spec.iterations as usize + 1);
+        rounds.push(
+            (0..n)
+                .into_par_iter()
+                .map(|node| initial_label(self, node, spec))
+                .collect::<Vec<_>>(),
+        );
+        for _ in 0..spec.iterations {
+            let labels = rounds.last().unwrap();
+            let next = (0..n)
+                .into_par_iter()
+                .map(|node| refined_label(self, node, labels, spec))
+                .collect();
+            rounds.push(next);
         }
+        rounds
+    }
+
+    /// Weisfeiler-Lehman fingerprint of this graph under `spec`.
+    pub fn fingerprint(&self, spec: &GraphFingerprintSpec) -> RedstoneFingerprint {
+        let last = self.fingerprint_rounds(spec).pop().unwrap_or_default();
+        combine_labels(self.node_count(), self.edge_count(), last)
+    }
+}
 
-        RedstoneFingerprint(hash128(&buf))
+impl RedstoneGraph {
+    /// Weisfeiler-Lehman fingerprint of this graph under `spec`.
+    ///
+    /// Order-independent and position-independent: shuffling `nodes` (with
+    /// consistent re-indexing) or translating the build yields the same value.
+    pub fn fingerprint(&self, spec: &GraphFingerprintSpec) -> RedstoneFingerprint {
+        self.to_compact().fingerprint(spec)
     }
 
     /// Convenience: equal `structural` fingerprints.
@@ -290,29 +300,10 @@ impl RedstoneGraph {
     }
 }
 
-/// Serialize one neighbour-edge tuple into a comparable, deterministic byte
-/// vector. Includes strength bytes only when the spec enables them.
-fn encode_edge(
-    dir: u8,
-    kind: LinkKind,
-    strength: u8,
-    neighbour_label: u128,
-    spec: &GraphFingerprintSpec,
-) -> Vec<u8> {
-    let mut e = Vec::with_capacity(19);
-    e.push(dir);
-    e.push(link_label(kind, strength, spec));
-    if spec.include_link_strength {
-        e.push(strength);
-    }
-    e.extend_from_slice(&neighbour_label.to_le_bytes());
-    e
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::simulation::graph::{RedstoneLink, RedstoneNode, RedstoneNodeKind};
+    use crate::simulation::graph::{LinkKind, RedstoneLink, RedstoneNode, RedstoneNodeKind};
     use crate::simulation::MchprsWorld;
     use crate::{BlockState, UniversalSchematic};
 
@@ -141,24 +141,207 @@ impl RedstoneGraph {
         }
         serde_json::to_string(&views).map_err(|e| e.to_string())
     }
+
+    /// The graph as flat typed arrays (see [`CompactGraph`]). Links whose
+    /// source is out of range are dropped.
+    pub fn to_compact(&self) -> CompactGraph {
+        let n = self.nodes.len();
+        let edges = self.edge_count();
+        let mut g = CompactGraph {
+            kinds: Vec::with_capacity(n),
+            params: Vec::with_capacity(n),
+            far_inputs: Vec::with_capacity(n),
+            output_strengths: Vec::with_capacity(n),
+            flags: Vec::with_capacity(n),
+            positions: Vec::with_capacity(n * 3),
+            alias_offsets: Vec::with_capacity(n + 1),
+            aliased_blocks: Vec::new(),
+            in_offsets: Vec::with_capacity(n + 1),
+            edge_sources: Vec::with_capacity(edges),
+            edge_targets: Vec::with_capacity(edges),
+            edge_weights: Vec::with_capacity(edges),
+            edge_kinds: Vec::with_capacity(edges),
+            out_offsets: Vec::new(),
+            out_targets: Vec::new(),
+            out_edges: Vec::new(),
+        };
+        g.alias_offsets.push(0);
+        g.in_offsets.push(0);
+        for (id, node) in self.nodes.iter().enumerate() {
+            let (param, far_input) = match &node.kind {
+                RedstoneNodeKind::Repeater { delay } => (*delay, NO_FAR_INPUT),
+                RedstoneNodeKind::Comparator { mode, far_input } => {
+                    (*mode as u8, far_input.unwrap_or(NO_FAR_INPUT))
+                }
+                _ => (0, NO_FAR_INPUT),
+            };
+            g.kinds.push(node_kind_code(&node.kind));
+            g.params.push(param);
+            g.far_inputs.push(far_input);
+            g.output_strengths.push(node.output_strength);
+            g.flags.push(
+                (node.pos.is_some() as u8 * NODE_HAS_POS)
+                    | (node.powered as u8 * NODE_POWERED)
+                    | (node.repeater_locked as u8 * NODE_REPEATER_LOCKED)
+                    | (node.facing_diode as u8 * NODE_FACING_DIODE),
+            );
+            let (x, y, z) = node.pos.unwrap_or_default();
+            g.positions.extend_from_slice(&[x, y, z]);
+            for &(x, y, z) in &node.aliased_blocks {
+                g.aliased_blocks.extend_from_slice(&[x, y, z]);
+            }
+            g.alias_offsets.push((g.aliased_blocks.len() / 3) as u32);
+            for link in node.inputs.iter().filter(|link| link.from < n) {
+                g.edge_sources.push(link.from as u32);
+                g.edge_targets.push(id as u32);
+                g.edge_weights.push(link.strength);
+                g.edge_kinds.push(link.kind as u8);
+            }
+            g.in_offsets.push(g.edge_sources.len() as u32);
+        }
+        g.build_out_edges();
+        g
+    }
 }
 
-fn node_kind_name(kind: &RedstoneNodeKind) -> &'static str {
+/// Kind names in [`CompactGraph::kinds`] code order.
+pub const NODE_KIND_NAMES: [&str; 11] = [
+    "Repeater",
+    "Comparator",
+    "Torch",
+    "Lamp",
+    "Button",
+    "Lever",
+    "PressurePlate",
+    "Trapdoor",
+    "Wire",
+    "Constant",
+    "NoteBlock",
+];
+
+/// [`CompactGraph::far_inputs`] entry of a node without a far input.
+pub const NO_FAR_INPUT: u8 = u8::MAX;
+
+/// [`CompactGraph::flags`] bits.
+pub const NODE_HAS_POS: u8 = 1;
+pub const NODE_POWERED: u8 = 2;
+pub const NODE_REPEATER_LOCKED: u8 = 4;
+pub const NODE_FACING_DIODE: u8 = 8;
+
+/// A [`RedstoneGraph`] as flat typed arrays: one entry per node, and edges
+/// in compressed sparse rows both ways. This is what the bindings export
+/// instead of JSON, and what the [`analysis`](super::analysis) kernels run
+/// on. Node `i` is `RedstoneGraph::nodes[i]`.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct CompactGraph {
+    /// Kind code, an index into [`NODE_KIND_NAMES`].
+    pub kinds: Vec<u8>,
+    /// Repeater delay, comparator mode (0 compare, 1 subtract), else 0.
+    pub params: Vec<u8>,
+    /// Comparator far input, else [`NO_FAR_INPUT`].
+    pub far_inputs: Vec<u8>,
+    pub output_strengths: Vec<u8>,
+    /// `NODE_*` bits.
+    pub flags: Vec<u8>,
+    /// `x, y, z` per node; zero when the node has no position.
+    pub positions: Vec<i32>,
+    /// Node `i`'s aliased blocks are `alias_offsets[i]..alias_offsets[i + 1]`
+    /// of `aliased_blocks`, three ints each.
+    pub alias_offsets: Vec<u32>,
+    pub aliased_blocks: Vec<i32>,
+    /// Node `i`'s incoming edges are `in_offsets[i]..in_offsets[i + 1]` of
+    /// the `edge_*` arrays, in `inputs` order.
+    pub in_offsets: Vec<u32>,
+    pub edge_sources: Vec<u32>,
+    pub edge_targets: Vec<u32>,
+    /// Signal-strength loss along the edge.
+    pub edge_weights: Vec<u8>,
+    /// 0 default, 1 side.
+    pub edge_kinds: Vec<u8>,
+    /// Node `i` feeds `out_targets[out_offsets[i]..out_offsets[i + 1]]`, in
+    /// target order.
+    pub out_offsets: Vec<u32>,
+    pub out_targets: Vec<u32>,
+    /// Index into the `edge_*` arrays of each `out_targets` entry.
+    pub out_edges: Vec<u32>,
+}
+
+impl CompactGraph {
+    pub fn node_count(&self) -> usize {
+        self.kinds.len()
+    }
+
+    pub fn edge_count(&self) -> usize {
+        self.edge_sources.len()
+    }
+
+    /// Nodes feeding `node`.
+    pub fn predecessors(&self, node: usize) -> &[u32] {
+        &self.edge_sources[self.in_offsets[node] as usize..self.in_offsets[node + 1] as usize]
+    }
+
+    /// Nodes `node` feeds.
+    pub fn successors(&self, node: usize) -> &[u32] {
+        &self.out_targets[self.out_offsets[node] as usize..self.out_offsets[node + 1] as usize]
+    }
+
+    /// Edge indices of `node`'s incoming edges, in `predecessors` order.
+    pub fn incoming(&self, node: usize) -> std::ops::Range<usize> {
+        self.in_offsets[node] as usize..self.in_offsets[node + 1] as usize
+    }
+
+    /// Edge indices of `node`'s outgoing edges, in `successors` order.
+    pub fn outgoing(&self, node: usize) -> &[u32] {
+        &self.out_edges[self.out_offsets[node] as usize..self.out_offsets[node + 1] as usize]
+    }
+
+    /// Invert the incoming rows into the `out_*` arrays with a
+    /// counting sort over sources. Edges are stored by target, so each
+    /// source's targets come out ascending.
+    fn build_out_edges(&mut self) {
+        let n = self.node_count();
+        let mut offsets = vec![0u32; n + 1];
+        for &src in &self.edge_sources {
+            offsets[src as usize + 1] += 1;
+        }
+        for i in 0..n {
+            offsets[i + 1] += offsets[i];
+        }
+        let mut next = offsets.clone();
+        let mut targets = vec![0u32; self.edge_count()];
+        let mut edges = vec![0u32; self.edge_count()];
+        for (edge, (&src, &dst)) in self.edge_sources.iter().zip(&self.edge_targets).enumerate() {
+            let slot = &mut next[src as usize];
+            targets[*slot as usize] = dst;
+            edges[*slot as usize] = edge as u32;
+            *slot += 1;
+        }
+        self.out_offsets = offsets;
+        self.out_targets = targets;
+        self.out_edges = edges;
+    }
+}
+
+fn node_kind_code(kind: &RedstoneNodeKind) -> u8 {
     match kind {
-        RedstoneNodeKind::Repeater { .. } => "Repeater",
-        RedstoneNodeKind::Comparator { .. } => "Comparator",
-        RedstoneNodeKind::Torch => "Torch",
-        RedstoneNodeKind::Lamp => "Lamp",
-        RedstoneNodeKind::Button => "Button",
-        RedstoneNodeKind::Lever => "Lever",
-        RedstoneNodeKind::PressurePlate => "PressurePlate",
-        RedstoneNodeKind::Trapdoor => "Trapdoor",
-        RedstoneNodeKind::Wire => "Wire",
-        RedstoneNodeKind::Constant => "Constant",
-        RedstoneNodeKind::NoteBlock => "NoteBlock",
+        RedstoneNodeKind::Repeater { .. } => 0,
+        RedstoneNodeKind::Comparator { .. } => 1,
+        RedstoneNodeKind::Torch => 2,
+        RedstoneNodeKind::Lamp => 3,
+        RedstoneNodeKind::Button => 4,
+        RedstoneNodeKind::Lever => 5,
+        RedstoneNodeKind::PressurePlate => 6,
+        RedstoneNodeKind::Trapdoor => 7,
+        RedstoneNodeKind::Wire => 8,
+        RedstoneNodeKind::Constant => 9,
+        RedstoneNodeKind::NoteBlock => 10,
     }
 }
 
+fn node_kind_name(kind: &RedstoneNodeKind) -> &'static str {
+    NODE_KIND_NAMES[node_kind_code(kind) as usize]
+}
+
 fn comparator_mode_name(mode: &ComparatorMode) -> &'static str {
     match mode {
         ComparatorMode::Compare => "Compare",
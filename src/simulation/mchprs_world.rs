@@ -3,7 +3,7 @@ use crate::UniversalSchematic;
 use mchprs_blocks::{block_entities::BlockEntity, blocks::Block, BlockPos};
 use mchprs_redpiler::Compiler;
 use mchprs_world::{storage::Chunk, TickEntry, TickPriority, World};
-use std::collections::HashMap;
+use std::collections::{HashMap, HashSet};
 use thiserror::Error;
 
 #[derive(Error, Debug)]
@@ -38,6 +38,40 @@ impl Default for SimulationOptions {
     }
 }
 
+/// What a [`SignalProbe`] reads at each of its positions.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum ProbeKind {
+    /// [`MchprsWorld::get_signal_strength`]
+    SignalStrength,
+    /// [`MchprsWorld::get_redstone_power`]
+    RedstonePower,
+    /// [`MchprsWorld::is_lit`], as 0 or 1
+    Lit,
+}
+
+/// A fixed set of positions read together with [`MchprsWorld::read_probe`].
+/// Positions are normalized once, when the probe is made.
+#[derive(Debug, Clone)]
+pub struct SignalProbe {
+    kind: ProbeKind,
+    positions: Vec<BlockPos>,
+}
+
+impl SignalProbe {
+    pub fn kind(&self) -> ProbeKind {
+        self.kind
+    }
+
+    /// Number of positions read.
+    pub fn len(&self) -> usize {
+        self.positions.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.positions.is_empty()
+    }
+}
+
 /// Custom IO state change event
 #[derive(Debug, Clone)]
 pub struct CustomIoChange {
@@ -61,6 +95,10 @@ pub struct MchprsWorld {
     /// Minimum coordinates of the schematic for coordinate normalization
     /// MCHPRS expects coordinates starting from 0, so we normalize schematic coords
     pub(crate) min_coords: (i32, i32, i32),
+    /// Normalized positions whose block changed since the last sync.
+    dirty: HashSet<BlockPos>,
+    /// Whether the schematic has had its first, full sync.
+    synced: bool,
 }
 
 impl MchprsWorld {
@@ -102,6 +140,8 @@ impl MchprsWorld {
             custom_io_states: HashMap::new(),
             custom_io_changes: Vec::new(),
             min_coords,
+            dirty: HashSet::new(),
+            synced: false,
         };
 
         world.initialize_chunks()?;
@@ -292,7 +332,7 @@ impl MchprsWorld {
                 let mut converted = std::collections::HashMap::new();
                 for (k, v) in map {
                     if let Some(cv) = Self::convert_nbt_value(v) {
-                        converted.insert(k, cv);
+                        converted.insert(k.to_string(), cv);
                     }
                 }
                 Some(Value::Compound(converted))
@@ -369,7 +409,10 @@ impl MchprsWorld {
 
     /// Gets the redstone power level at a position (in schematic coordinates)
     pub fn get_redstone_power(&self, pos: BlockPos) -> u8 {
-        let normalized_pos = self.normalize_pos(pos);
+        self.redstone_power_at(self.normalize_pos(pos))
+    }
+
+    fn redstone_power_at(&self, normalized_pos: BlockPos) -> u8 {
         self.get_block(normalized_pos)
             .properties()
             .get("power")
@@ -411,7 +454,10 @@ impl MchprsWorld {
     /// # Returns
     /// The current signal strength (0-15), or 0 if not a valid component
     pub fn get_signal_strength(&self, pos: BlockPos) -> u8 {
-        let normalized_pos = self.normalize_pos(pos);
+        self.signal_strength_at(self.normalize_pos(pos))
+    }
+
+    fn signal_strength_at(&self, normalized_pos: BlockPos) -> u8 {
         if let Some(signal) = self.compiler.get_signal_strength(normalized_pos) {
             // If we have a non-zero signal from the compiler, return it.
             // If it's 0, we fall back to checking block state (for things like lamps).
@@ -423,7 +469,7 @@ impl MchprsWorld {
         // Fallback: Check if block is a lit lamp (or other lit component)
         // This is useful for blocks that consume power but don't emit it in the graph (like lamps)
         // Note: This relies on the world being flushed to be accurate!
-        if self.is_lit(pos) {
+        if self.lit_at(normalized_pos) {
             return 15;
         }
 
@@ -483,6 +529,74 @@ impl MchprsWorld {
             .collect()
     }
 
+    /// Register `positions` (schematic coordinates) for repeated batch reads
+    /// of `kind` with [`Self::read_probe`].
+    pub fn probe(&self, positions: &[(i32, i32, i32)], kind: ProbeKind) -> SignalProbe {
+        SignalProbe {
+            kind,
+            positions: positions
+                .iter()
+                .map(|&(x, y, z)| self.normalize_pos(BlockPos::new(x, y, z)))
+                .collect(),
+        }
+    }
+
+    /// Read every position of `probe` into `out`, which must be exactly as
+    /// long as the probe. Like the single-position getters, this reads
+    /// flushed block state for power and lamps; flush after ticking.
+    pub fn read_probe(&self, probe: &SignalProbe, out: &mut [u8]) -> Result<(), String> {
+        if out.len() != probe.positions.len() {
+            return Err(format!(
+                "Probe has {} positions, output holds {}",
+                probe.positions.len(),
+                out.len()
+            ));
+        }
+        let positions = probe.positions.iter();
+        match probe.kind {
+            ProbeKind::SignalStrength => {
+                for (slot, &pos) in out.iter_mut().zip(positions) {
+                    *slot = self.signal_strength_at(pos);
+                }
+            }
+            ProbeKind::RedstonePower => {
+                for (slot, &pos) in out.iter_mut().zip(positions) {
+                    *slot = self.redstone_power_at(pos);
+                }
+            }
+            ProbeKind::Lit => {
+                for (slot, &pos) in out.iter_mut().zip(positions) {
+                    *slot = self.lit_at(pos) as u8;
+                }
+            }
+        }
+        Ok(())
+    }
+
+    /// Whether [`Self::get_graph_signals_batch`] reads `positions` exactly
+    /// as a flushed [`Self::get_signals_batch`] would: every position is a
+    /// redpiler node other than a lamp. Lamps keep graph power 0 and only
+    /// show up through their flushed `lit` state; positions without a node
+    /// have to be read from flushed block state too.
+    pub fn graph_readable(&self, positions: &[(i32, i32, i32)]) -> bool {
+        positions.iter().all(|&(x, y, z)| {
+            let pos = self.normalize_pos(BlockPos::new(x, y, z));
+            self.compiler.get_signal_strength(pos).is_some()
+                && self.get_block(pos).get_name() != "redstone_lamp"
+        })
+    }
+
+    /// Signal strengths straight from the redpiler graph, without a flush.
+    /// Only matches [`Self::get_signals_batch`] for positions that pass
+    /// [`Self::graph_readable`]; others read as 0.
+    pub fn get_graph_signals_batch(&self, positions: &[(i32, i32, i32)], out: &mut Vec<u8>) {
+        out.clear();
+        out.extend(positions.iter().map(|&(x, y, z)| {
+            let pos = self.normalize_pos(BlockPos::new(x, y, z));
+            self.compiler.get_signal_strength(pos).unwrap_or(0)
+        }));
+    }
+
     /// Checks if a position has a node in the redpiler graph (DEBUG)
     #[cfg(test)]
     pub fn has_node(&self, pos: BlockPos) -> bool {
@@ -524,6 +638,8 @@ impl MchprsWorld {
 
     /// Advances the simulation by the specified number of ticks
     pub fn tick(&mut self, number_of_ticks: u32) {
+        let _stage = crate::telemetry::stage!(DEBUG, "simulation.tick", ticks = number_of_ticks);
+        crate::telemetry::count("simulation.ticks", number_of_ticks as u64);
         for _ in 0..number_of_ticks {
             self.compiler.tick();
         }
@@ -531,6 +647,7 @@ impl MchprsWorld {
 
     /// Flushes pending changes from the compiler to the world
     pub fn flush(&mut self) {
+        let _stage = crate::telemetry::stage!(DEBUG, "simulation.flush");
         let mut temp_compiler = std::mem::take(&mut self.compiler);
         temp_compiler.flush(self);
         self.compiler = temp_compiler;
@@ -545,7 +662,10 @@ impl MchprsWorld {
 
     /// Checks if a redstone lamp is lit at the given position (in schematic coordinates)
     pub fn is_lit(&self, pos: BlockPos) -> bool {
-        let normalized_pos = self.normalize_pos(pos);
+        self.lit_at(self.normalize_pos(pos))
+    }
+
+    fn lit_at(&self, normalized_pos: BlockPos) -> bool {
         self.get_block(normalized_pos)
             .properties()
             .get("lit")
@@ -583,13 +703,44 @@ impl MchprsWorld {
     /// from the MCHPRS simulation back to the schematic.
     ///
     /// Call this after running simulation if you want to export the resulting state.
+    ///
+    /// The first sync rewrites every block; later ones rewrite only blocks
+    /// the simulation changed since the previous sync.
     pub fn sync_to_schematic(&mut self) {
+        self.sync_blocks(|_, _| {});
+    }
+
+    /// [`Self::sync_to_schematic`], returning the blocks it wrote as
+    /// (schematic position, new state), ordered by position. The first sync
+    /// reports every non-air block; later ones only what changed since.
+    pub fn sync_changes(&mut self) -> Vec<((i32, i32, i32), crate::BlockState)> {
+        let mut changes = Vec::new();
+        self.sync_blocks(|pos, block_state| changes.push((pos, block_state.clone())));
+        changes
+    }
+
+    fn sync_blocks(&mut self, mut record: impl FnMut((i32, i32, i32), &crate::BlockState)) {
         self.flush();
-        let bounding_box = self.schematic.get_bounding_box();
         let (min_x, min_y, min_z) = self.min_coords;
+
+        if self.synced {
+            let mut dirty: Vec<BlockPos> = self.dirty.drain().collect();
+            dirty.sort_unstable_by_key(|pos| (pos.x, pos.y, pos.z));
+            for normalized_pos in dirty {
+                let block_state = self.block_state_at(normalized_pos);
+                let pos = (
+                    normalized_pos.x + min_x,
+                    normalized_pos.y + min_y,
+                    normalized_pos.z + min_z,
+                );
+                self.schematic.set_block(pos.0, pos.1, pos.2, &block_state);
+                record(pos, &block_state);
+            }
+            return;
+        }
+
+        let bounding_box = self.schematic.get_bounding_box();
         let (max_x, max_y, max_z) = bounding_box.max;
-        let _custom_io_set: std::collections::HashSet<_> =
-            self.options.custom_io.iter().cloned().collect();
 
         // Iterate using actual schematic coordinates
         for x in min_x..=max_x {
@@ -597,34 +748,41 @@ impl MchprsWorld {
                 for z in min_z..=max_z {
                     // Normalize position for MCHPRS access
                     let normalized_pos = self.normalize_pos(BlockPos::new(x, y, z));
-                    let _raw_id = self.get_block_raw(normalized_pos);
-                    let block = self.get_block(normalized_pos);
 
                     // Skip air blocks
-                    if block.get_id() == 0 {
+                    if self.get_block_raw(normalized_pos) == 0 {
                         continue;
                     }
 
-                    // Get block name with minecraft: prefix
-                    let name = format!("minecraft:{}", block.get_name());
-
-                    // Get all properties from the MCHPRS block
-                    let mut properties: Vec<(smol_str::SmolStr, smol_str::SmolStr)> = block
-                        .properties()
-                        .iter()
-                        .map(|(k, v)| (smol_str::SmolStr::new(k), smol_str::SmolStr::new(v)))
-                        .collect();
-                    // Sort properties for canonical ordering (MCHPRS returns HashMap with non-deterministic order)
-                    properties.sort_by(|a, b| a.0.cmp(&b.0));
-
-                    // Create BlockState and update schematic
-                    let mut block_state = crate::BlockState::new(name);
-                    block_state.properties = properties;
-
+                    let block_state = self.block_state_at(normalized_pos);
                     self.schematic.set_block(x, y, z, &block_state);
+                    record((x, y, z), &block_state);
                 }
             }
         }
+        self.dirty.clear();
+        self.synced = true;
+    }
+
+    /// The MCHPRS block at `normalized_pos` as a schematic block state.
+    fn block_state_at(&self, normalized_pos: BlockPos) -> crate::BlockState {
+        let block = self.get_block(normalized_pos);
+
+        // Get block name with minecraft: prefix
+        let name = format!("minecraft:{}", block.get_name());
+
+        // Get all properties from the MCHPRS block
+        let mut properties: Vec<(smol_str::SmolStr, smol_str::SmolStr)> = block
+            .properties()
+            .iter()
+            .map(|(k, v)| (smol_str::SmolStr::new(k), smol_str::SmolStr::new(v)))
+            .collect();
+        // Sort properties for canonical ordering (MCHPRS returns HashMap with non-deterministic order)
+        properties.sort_by(|a, b| a.0.cmp(&b.0));
+
+        let mut block_state = crate::BlockState::new(name);
+        block_state.properties = properties;
+        block_state
     }
 
     /// Gets a reference to the underlying schematic
@@ -720,12 +878,11 @@ impl World for MchprsWorld {
     fn set_block_raw(&mut self, pos: BlockPos, block: u32) -> bool {
         let chunk_key = self.get_chunk_key(pos);
         if let Some(chunk) = self.chunks.get_mut(&chunk_key) {
-            chunk.set_block(
-                (pos.x & 15) as u32,
-                pos.y as u32,
-                (pos.z & 15) as u32,
-                block,
-            )
+            let (x, y, z) = ((pos.x & 15) as u32, pos.y as u32, (pos.z & 15) as u32);
+            if chunk.get_block(x, y, z) != block {
+                self.dirty.insert(pos);
+            }
+            chunk.set_block(x, y, z, block)
         } else {
             false
         }
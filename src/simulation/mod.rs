@@ -33,14 +33,17 @@ mod tests;
 mod truth_table;
 pub mod typed_executor;
 
-pub use analysis::GraphFeatures;
+pub use analysis::{AnalysisSession, GraphFeatures};
 pub use circuit_builder::CircuitBuilder;
 pub use fingerprint::{GraphFingerprintSpec, RedstoneFingerprint};
 pub use graph::{
-    ComparatorMode, LinkKind, RedstoneGraph, RedstoneLink, RedstoneNode, RedstoneNodeKind,
+    CompactGraph, ComparatorMode, LinkKind, RedstoneGraph, RedstoneLink, RedstoneNode,
+    RedstoneNodeKind,
 };
-pub use mchprs_world::{CustomIoChange, MchprsWorld, MchprsWorldError, SimulationOptions};
-pub use truth_table::generate_truth_table;
+pub use mchprs_world::{
+    CustomIoChange, MchprsWorld, MchprsWorldError, ProbeKind, SignalProbe, SimulationOptions,
+};
+pub use truth_table::{compute_truth_table, generate_truth_table, TruthTable};
 
 // Re-export commonly used MCHPRS types for convenience
 pub use mchprs_blocks::BlockPos;
@@ -220,6 +220,69 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_probe_reads_match_single_reads() {
+        use super::super::ProbeKind;
+
+        let schematic = create_simple_redstone_line();
+        let mut world = MchprsWorld::new(schematic).expect("World creation failed");
+        world.on_use_block(BlockPos::new(0, 1, 0));
+        world.tick(20);
+        world.flush();
+
+        let positions: Vec<(i32, i32, i32)> = (1..16).map(|x| (x, 1, 0)).collect();
+        for kind in [
+            ProbeKind::SignalStrength,
+            ProbeKind::RedstonePower,
+            ProbeKind::Lit,
+        ] {
+            let probe = world.probe(&positions, kind);
+            let mut out = vec![0u8; probe.len()];
+            world.read_probe(&probe, &mut out).unwrap();
+            for (&(x, y, z), &read) in positions.iter().zip(&out) {
+                let pos = BlockPos::new(x, y, z);
+                let expected = match kind {
+                    ProbeKind::SignalStrength => world.get_signal_strength(pos),
+                    ProbeKind::RedstonePower => world.get_redstone_power(pos),
+                    ProbeKind::Lit => world.is_lit(pos) as u8,
+                };
+                assert_eq!(read, expected, "{:?} at x={}", kind, x);
+            }
+            assert!(world.read_probe(&probe, &mut out[1..]).is_err());
+        }
+    }
+
+    #[test]
+    fn test_sync_changes_reports_only_changed_blocks() {
+        let schematic = create_simple_redstone_line();
+        let mut world = MchprsWorld::new(schematic).expect("World creation failed");
+
+        // The first sync writes every block.
+        let first = world.sync_changes();
+        assert_eq!(first.len(), 32);
+
+        world.on_use_block(BlockPos::new(0, 1, 0));
+        world.tick(20);
+        let changes = world.sync_changes();
+        let positions: Vec<(i32, i32, i32)> = changes.iter().map(|(pos, _)| *pos).collect();
+        assert!(positions.contains(&(0, 1, 0)), "lever should be reported");
+        assert!(positions.contains(&(15, 1, 0)), "lamp should be reported");
+        assert!(
+            positions.iter().all(|&(_, y, _)| y == 1),
+            "concrete never changes"
+        );
+        let mut sorted = positions.clone();
+        sorted.sort();
+        assert_eq!(positions, sorted);
+
+        let (_, lamp) = changes.iter().find(|(pos, _)| *pos == (15, 1, 0)).unwrap();
+        assert_eq!(lamp.get_property("lit").map(|v| v.as_str()), Some("true"));
+        let synced = world.get_schematic().get_block(15, 1, 0).unwrap();
+        assert_eq!(synced.get_property("lit").map(|v| v.as_str()), Some("true"));
+
+        assert!(world.sync_changes().is_empty());
+    }
+
     #[test]
     fn test_world_state_persistence() {
         let schematic = create_simple_redstone_line();
@@ -2,8 +2,71 @@ use super::MchprsWorld;
 use crate::UniversalSchematic;
 use mchprs_blocks::BlockPos;
 use mchprs_world::World;
+use rayon::prelude::*;
 use std::collections::HashMap;
 
+/// Ticks each input combination runs before its outputs are read.
+const SETTLE_TICKS: u32 = 20;
+
+/// A truth table over a circuit's levers (inputs) and redstone lamps
+/// (outputs), one row per input combination.
+///
+/// Row `r` toggles lever `i` when bit `i` of `r` is set, so row 0 is the
+/// circuit as built. Only the lever states and outputs are stored,
+/// bit-packed: a table over 16 inputs and 8 outputs is 64 KiB rather than
+/// 65 536 hash maps.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct TruthTable {
+    /// Lever positions, in the order of the row-index bits.
+    pub inputs: Vec<BlockPos>,
+    /// Whether each lever was already on in the schematic.
+    initially_on: Vec<bool>,
+    /// Lamp positions.
+    pub outputs: Vec<BlockPos>,
+    /// Output `j` of row `r` is bit `r * outputs.len() + j`.
+    bits: Vec<u64>,
+}
+
+impl TruthTable {
+    /// Number of rows (`2^inputs`).
+    pub fn len(&self) -> usize {
+        1 << self.inputs.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        false
+    }
+
+    /// Input `index` of `row`: whether that lever was on.
+    pub fn input(&self, row: usize, index: usize) -> bool {
+        (row >> index & 1 == 1) != self.initially_on[index]
+    }
+
+    /// Output `index` of `row`: whether that lamp was lit.
+    pub fn output(&self, row: usize, index: usize) -> bool {
+        let bit = row * self.outputs.len() + index;
+        self.bits[bit / 64] >> (bit % 64) & 1 == 1
+    }
+
+    /// The table as one map per row, keyed `"Input i"` / `"Output j"`.
+    pub fn to_rows(&self) -> Vec<HashMap<String, bool>> {
+        (0..self.len())
+            .map(|row| {
+                let inputs =
+                    (0..self.inputs.len()).map(|i| (format!("Input {}", i), self.input(row, i)));
+                let outputs =
+                    (0..self.outputs.len()).map(|j| (format!("Output {}", j), self.output(row, j)));
+                inputs.chain(outputs).collect()
+            })
+            .collect()
+    }
+
+    /// [`Self::to_rows`] as a JSON array of objects.
+    pub fn to_json(&self) -> String {
+        serde_json::to_string(&self.to_rows()).unwrap_or_else(|_| "[]".to_string())
+    }
+}
+
 /// Generates a truth table for a redstone circuit
 ///
 /// Automatically finds all levers (inputs) and redstone lamps (outputs)
@@ -23,13 +86,25 @@ use std::collections::HashMap;
 /// }
 /// ```
 pub fn generate_truth_table(schematic: &UniversalSchematic) -> Vec<HashMap<String, bool>> {
-    let mut world = match MchprsWorld::new(schematic.clone()) {
-        Ok(w) => w,
+    match compute_truth_table(schematic) {
+        Ok(table) => table.to_rows(),
         Err(e) => {
-            log::error!("Failed to create world: {}", e);
-            return Vec::new();
+            log::error!("Failed to generate truth table: {}", e);
+            Vec::new()
         }
-    };
+    }
+}
+
+/// Generates a bit-packed [`TruthTable`], running input combinations in
+/// parallel.
+///
+/// Every combination starts from the freshly compiled circuit, so latches
+/// and other state never leak between rows. The compiled backend cannot be
+/// snapshotted, so each row still compiles its own world; the first row
+/// reuses the world that found the inputs and outputs, and the rest are
+/// spread over the rayon pool.
+pub fn compute_truth_table(schematic: &UniversalSchematic) -> Result<TruthTable, String> {
+    let world = MchprsWorld::new(schematic.clone())?;
 
     // Find all levers and lamps
     let (inputs, outputs) = find_inputs_and_outputs(&world);
@@ -37,40 +112,48 @@ pub fn generate_truth_table(schematic: &UniversalSchematic) -> Vec<HashMap<Strin
     log::debug!("Inputs: {:?}", inputs);
     log::debug!("Outputs: {:?}", outputs);
 
-    let mut truth_table = Vec::new();
-    let input_combinations = generate_input_combinations(inputs.len());
-
-    for combination in input_combinations {
+    if inputs.len() >= usize::BITS as usize {
+        return Err(format!(
+            "Too many inputs for a truth table: {}",
+            inputs.len()
+        ));
+    }
+    let rows = 1usize << inputs.len();
+    let initially_on = inputs
+        .iter()
+        .map(|&pos| world.get_lever_power(pos))
+        .collect();
+    let run = |mut world: MchprsWorld, row: usize| -> Vec<bool> {
         // Set lever states for this combination
         for (i, &input_pos) in inputs.iter().enumerate() {
-            if combination[i] {
+            if row >> i & 1 == 1 {
                 world.on_use_block(input_pos);
             }
         }
 
         // Run simulation
-        world.tick(20);
+        world.tick(SETTLE_TICKS);
         world.flush();
 
-        // Record results
-        let mut result = HashMap::new();
-        for (i, &input_pos) in inputs.iter().enumerate() {
-            result.insert(format!("Input {}", i), world.get_lever_power(input_pos));
-        }
-        for (i, &output_pos) in outputs.iter().enumerate() {
-            result.insert(format!("Output {}", i), world.is_lit(output_pos));
-        }
+        outputs.iter().map(|&pos| world.is_lit(pos)).collect()
+    };
 
-        truth_table.push(result);
+    let first = run(world, 0);
+    let rest = (1..rows)
+        .into_par_iter()
+        .map(|row| Ok(run(MchprsWorld::new(schematic.clone())?, row)))
+        .collect::<Result<Vec<_>, String>>()?;
 
-        // Reset world for next combination
-        world = match MchprsWorld::new(schematic.clone()) {
-            Ok(w) => w,
-            Err(_) => return truth_table, // Return what we have so far
-        };
+    let mut bits = vec![0u64; (rows * outputs.len()).div_ceil(64)];
+    for (bit, lit) in std::iter::once(first).chain(rest).flatten().enumerate() {
+        bits[bit / 64] |= (lit as u64) << (bit % 64);
     }
-
-    truth_table
+    Ok(TruthTable {
+        inputs,
+        initially_on,
+        outputs,
+        bits,
+    })
 }
 
 /// Finds all levers (inputs) and redstone lamps (outputs) in the circuit
@@ -97,24 +180,31 @@ fn find_inputs_and_outputs(world: &MchprsWorld) -> (Vec<BlockPos>, Vec<BlockPos>
     (inputs, outputs)
 }
 
-/// Generates all possible boolean combinations for n inputs
-fn generate_input_combinations(num_inputs: usize) -> Vec<Vec<bool>> {
-    (0..2usize.pow(num_inputs as u32))
-        .map(|i| (0..num_inputs).map(|j| (i & (1 << j)) != 0).collect())
-        .collect()
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
 
     #[test]
-    fn test_input_combinations() {
-        let combos = generate_input_combinations(2);
-        assert_eq!(combos.len(), 4);
-        assert_eq!(combos[0], vec![false, false]);
-        assert_eq!(combos[1], vec![true, false]);
-        assert_eq!(combos[2], vec![false, true]);
-        assert_eq!(combos[3], vec![true, true]);
+    fn test_row_bits_index_inputs() {
+        let table = TruthTable {
+            inputs: vec![BlockPos::new(0, 0, 0), BlockPos::new(1, 0, 0)],
+            initially_on: vec![false, false],
+            outputs: vec![BlockPos::new(2, 0, 0)],
+            bits: vec![0b1000],
+        };
+        assert_eq!(table.len(), 4);
+        assert!(!table.input(0, 0) && !table.input(0, 1));
+        assert!(table.input(1, 0) && !table.input(1, 1));
+        assert!(!table.input(2, 0) && table.input(2, 1));
+        assert!(table.input(3, 0) && table.input(3, 1));
+        assert_eq!(
+            (0..4).map(|row| table.output(row, 0)).collect::<Vec<_>>(),
+            vec![false, false, false, true]
+        );
+
+        let rows = table.to_rows();
+        assert_eq!(rows[3]["Input 1"], true);
+        assert_eq!(rows[3]["Output 0"], true);
+        assert_eq!(rows[2]["Output 0"], false);
     }
 }
@@ -14,13 +14,20 @@
 //! in as a new version of this same container.
 //!
 //! ## Determinism
-//! Ports are sorted by name, but `UniversalSchematic` serializes `HashMap`
-//! fields in iteration order, so the bytes are NOT stable across processes.
-//! Content-hash dedupe should keep using the source schematic bytes.
+//! The same build inputs give the same bytes in every process, so a blob's
+//! hash can address it. Ports are sorted by name and custom IO positions by
+//! coordinate. The `.schem` writer emits block-entity NBT and definition
+//! metadata in `HashMap` iteration order, which is seeded per process, so
+//! [`canonical_schem`] rewrites it with every compound's keys sorted, block
+//! entities sorted by position and the definition JSON re-serialized with
+//! sorted keys. The palette keeps the schematic's own order: two schematics
+//! with the same blocks but a different palette history still differ.
 
 use super::{IoMapping, StateMode};
 use crate::simulation::SimulationOptions;
 use crate::UniversalSchematic;
+use quartz_nbt::io::Flavor;
+use quartz_nbt::{NbtCompound, NbtList, NbtTag};
 use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
 
@@ -100,15 +107,19 @@ pub(super) fn encode(
     state_mode: StateMode,
     options: &SimulationOptions,
 ) -> Result<Vec<u8>, String> {
+    let schem = crate::formats::schematic::to_schematic(schematic)
+        .map_err(|e| format!("schematic encode: {}", e))?;
+    let mut custom_io: Vec<(i32, i32, i32)> =
+        options.custom_io.iter().map(|p| (p.x, p.y, p.z)).collect();
+    custom_io.sort_unstable();
     let data = CompiledCircuit {
-        schematic_schem: crate::formats::schematic::to_schematic(schematic)
-            .map_err(|e| format!("schematic encode: {}", e))?,
+        schematic_schem: canonical_schem(&schem)?,
         inputs: ports_to_entries(inputs),
         outputs: ports_to_entries(outputs),
         state_mode: state_mode_to_u8(state_mode),
         optimize: options.optimize,
         io_only: options.io_only,
-        custom_io: options.custom_io.iter().map(|p| (p.x, p.y, p.z)).collect(),
+        custom_io,
     };
     let body = bincode::serialize(&data).map_err(|e| format!("compiled encode: {}", e))?;
     let mut out = Vec::with_capacity(8 + body.len());
@@ -118,6 +129,69 @@ pub(super) fn encode(
     Ok(out)
 }
 
+/// Rewrite gzipped `.schem` bytes so they no longer depend on `HashMap`
+/// iteration order (see the module docs).
+fn canonical_schem(schem: &[u8]) -> Result<Vec<u8>, String> {
+    let (root, name) =
+        quartz_nbt::io::read_nbt(&mut std::io::Cursor::new(schem), Flavor::GzCompressed)
+            .map_err(|e| format!("schematic canonicalize: {}", e))?;
+    let root = match canonical_tag(NbtTag::Compound(root)) {
+        NbtTag::Compound(root) => root,
+        _ => unreachable!("a compound stays a compound"),
+    };
+    let mut out = Vec::with_capacity(schem.len());
+    quartz_nbt::io::write_nbt(&mut out, Some(name.as_str()), &root, Flavor::GzCompressed)
+        .map_err(|e| format!("schematic canonicalize: {}", e))?;
+    Ok(out)
+}
+
+fn canonical_tag(tag: NbtTag) -> NbtTag {
+    match tag {
+        NbtTag::Compound(compound) => {
+            let mut entries: Vec<(String, NbtTag)> = compound
+                .iter()
+                .map(|(key, value)| (key.clone(), value.clone()))
+                .collect();
+            entries.sort_unstable_by(|a, b| a.0.cmp(&b.0));
+            let mut sorted = NbtCompound::new();
+            for (key, value) in entries {
+                let value = match (key.as_str(), value) {
+                    ("BlockEntities", NbtTag::List(list)) => NbtTag::List(sorted_by_pos(list)),
+                    ("NucleationDefinitions", NbtTag::String(json)) => {
+                        // serde_json's map is ordered, so a round trip sorts keys.
+                        let json = serde_json::from_str::<serde_json::Value>(&json)
+                            .and_then(|value| serde_json::to_string(&value))
+                            .unwrap_or(json);
+                        NbtTag::String(json)
+                    }
+                    (_, value) => canonical_tag(value),
+                };
+                sorted.insert(key, value);
+            }
+            NbtTag::Compound(sorted)
+        }
+        NbtTag::List(list) => NbtTag::List(NbtList::from(
+            list.iter()
+                .map(|tag| canonical_tag(tag.clone()))
+                .collect::<Vec<_>>(),
+        )),
+        tag => tag,
+    }
+}
+
+/// Canonicalize block entities and order them by their `Pos`.
+fn sorted_by_pos(list: NbtList) -> NbtList {
+    let mut entities: Vec<NbtTag> = list.iter().map(|tag| canonical_tag(tag.clone())).collect();
+    entities.sort_by_cached_key(|tag| match tag {
+        NbtTag::Compound(entity) => match entity.get::<_, &NbtTag>("Pos") {
+            Ok(NbtTag::IntArray(pos)) => pos.clone(),
+            _ => Vec::new(),
+        },
+        _ => Vec::new(),
+    });
+    NbtList::from(entities)
+}
+
 #[allow(clippy::type_complexity)]
 pub(super) fn decode(
     bytes: &[u8],
@@ -265,6 +339,29 @@ cc··cccccc
         }
     }
 
+    #[test]
+    fn compiled_bytes_do_not_depend_on_hash_map_order() {
+        let build = || {
+            let mut schematic = full_adder_with_insign();
+            // Block-entity NBT lives in a per-process-seeded HashMap.
+            let nbt: std::collections::HashMap<String, String> = (0..8)
+                .map(|i| (format!("Key{}", i), i.to_string()))
+                .collect();
+            schematic
+                .set_block_with_nbt(9, 0, 9, "minecraft:barrel[facing=up]", nbt)
+                .unwrap();
+            create_executor_from_insign(&schematic)
+                .unwrap()
+                .to_compiled_bytes()
+                .unwrap()
+        };
+        let first = build();
+        for _ in 0..4 {
+            assert_eq!(build(), first);
+        }
+        assert!(TypedCircuitExecutor::from_compiled_bytes(&first).is_ok());
+    }
+
     #[test]
     fn compiled_rejects_bad_magic_and_version() {
         let schematic = full_adder_with_insign();
@@ -2,6 +2,7 @@
 //!
 //! Main executor that manages the simulation and handles typed IO.
 
+use super::watch::OutputWatch;
 use super::{IoLayout, IoMapping, Value};
 use crate::simulation::MchprsWorld;
 use std::collections::HashMap;
@@ -119,7 +120,113 @@ pub struct ExecutionResult {
     pub condition_met: bool,
 }
 
+/// Whether `world` was compiled with `options`, i.e. is what
+/// [`TypedCircuitExecutor::reset`] would build, provided it has not run yet.
+fn compiled_with(world: &MchprsWorld, options: &crate::simulation::SimulationOptions) -> bool {
+    let compiled = &world.options;
+    compiled.optimize == options.optimize
+        && compiled.io_only == options.io_only
+        && compiled.custom_io.len() == options.custom_io.len()
+        && compiled
+            .custom_io
+            .iter()
+            .all(|pos| options.custom_io.contains(pos))
+}
+
+/// Input vectors for [`TypedCircuitExecutor::execute_batch`], stored as
+/// columns: one `u64` per vector for each input port.
+#[derive(Debug, Clone, Default)]
+pub struct InputBatch {
+    len: usize,
+    columns: Vec<(String, Vec<u64>)>,
+}
+
+impl InputBatch {
+    /// An empty batch of `len` vectors.
+    pub fn new(len: usize) -> Self {
+        Self {
+            len,
+            columns: Vec::new(),
+        }
+    }
+
+    /// Set (or replace) the column of input `name`; it must hold exactly one
+    /// raw value per vector.
+    pub fn set_column(&mut self, name: &str, values: Vec<u64>) -> Result<(), String> {
+        if values.len() != self.len {
+            return Err(format!(
+                "Column {} has {} values, batch has {} vectors",
+                name,
+                values.len(),
+                self.len
+            ));
+        }
+        match self.columns.iter_mut().find(|(n, _)| n == name) {
+            Some((_, column)) => *column = values,
+            None => self.columns.push((name.to_string(), values)),
+        }
+        Ok(())
+    }
+
+    /// Number of vectors.
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// The vectors in `range`, as a batch of their own.
+    pub fn rows(&self, range: std::ops::Range<usize>) -> InputBatch {
+        InputBatch {
+            len: range.len(),
+            columns: self
+                .columns
+                .iter()
+                .map(|(name, column)| (name.clone(), column[range.clone()].to_vec()))
+                .collect(),
+        }
+    }
+}
+
+/// Columnar results of [`TypedCircuitExecutor::execute_batch`].
+#[derive(Debug, Clone)]
+pub struct BatchResult {
+    pub len: usize,
+    /// Output port names, sorted; `outputs[i]` is the column of
+    /// `output_names[i]`.
+    pub output_names: Vec<String>,
+    /// Raw binary encoding of each output per vector.
+    pub outputs: Vec<Vec<u64>>,
+    pub ticks_elapsed: Vec<u32>,
+    pub condition_met: Vec<bool>,
+}
+
+impl BatchResult {
+    /// The column of output `name`.
+    pub fn output(&self, name: &str) -> Option<&[u64]> {
+        let index = self.output_names.iter().position(|n| n == name)?;
+        Some(&self.outputs[index])
+    }
+
+    /// Append the vectors of `other`, which must have the same outputs.
+    pub fn append(&mut self, other: BatchResult) {
+        debug_assert_eq!(self.output_names, other.output_names);
+        self.len += other.len;
+        for (column, more) in self.outputs.iter_mut().zip(other.outputs) {
+            column.extend(more);
+        }
+        self.ticks_elapsed.extend(other.ticks_elapsed);
+        self.condition_met.extend(other.condition_met);
+    }
+}
+
 /// Typed circuit executor
+///
+/// A world handed to a constructor that was compiled with the executor's
+/// simulation options is taken to be fresh, and serves the first stateless
+/// execution without a reset.
 pub struct TypedCircuitExecutor {
     world: MchprsWorld,
     inputs: HashMap<String, IoMapping>,
@@ -129,6 +236,10 @@ pub struct TypedCircuitExecutor {
     original_schematic: crate::UniversalSchematic,
     /// Store simulation options for resetting
     simulation_options: crate::simulation::SimulationOptions,
+    /// The world is exactly as compiled: no inputs set and no ticks run
+    /// since construction or the last reset, so a stateless execution can
+    /// use it without recompiling.
+    pristine: bool,
 }
 
 impl TypedCircuitExecutor {
@@ -160,11 +271,12 @@ impl TypedCircuitExecutor {
         };
 
         Self {
-            world,
             inputs,
             outputs,
             state_mode: StateMode::Stateless,
             original_schematic,
+            pristine: compiled_with(&world, &simulation_options),
+            world,
             simulation_options,
         }
     }
@@ -197,11 +309,12 @@ impl TypedCircuitExecutor {
         }
 
         Self {
-            world,
             inputs,
             outputs,
             state_mode: StateMode::Stateless,
             original_schematic,
+            pristine: compiled_with(&world, &simulation_options),
+            world,
             simulation_options,
         }
     }
@@ -229,11 +342,12 @@ impl TypedCircuitExecutor {
         };
 
         Self {
-            world,
             inputs: layout.inputs,
             outputs: layout.outputs,
             state_mode: StateMode::Stateless,
             original_schematic,
+            pristine: compiled_with(&world, &simulation_options),
+            world,
             simulation_options,
         }
     }
@@ -265,11 +379,12 @@ impl TypedCircuitExecutor {
         }
 
         Self {
-            world,
             inputs: layout.inputs,
             outputs: layout.outputs,
             state_mode: StateMode::Stateless,
             original_schematic,
+            pristine: compiled_with(&world, &simulation_options),
+            world,
             simulation_options,
         }
     }
@@ -309,19 +424,7 @@ impl TypedCircuitExecutor {
         inputs: HashMap<String, Value>,
         mode: ExecutionMode,
     ) -> Result<ExecutionResult, String> {
-        // Handle state management
-        match self.state_mode {
-            StateMode::Stateless => {
-                // Always reset for stateless mode
-                self.reset()?;
-            }
-            StateMode::Stateful => {
-                // Preserve state - do nothing
-            }
-            StateMode::Manual => {
-                // User controls reset - do nothing
-            }
-        }
+        self.begin_execution()?;
 
         // Encode and set all inputs
         for (name, value) in inputs {
@@ -340,41 +443,145 @@ impl TypedCircuitExecutor {
         // Flush the compiler state to ensure input signals are propagated
         self.world.flush();
 
-        // Execute based on mode
-        let (ticks_elapsed, condition_met) = match mode {
+        let (ticks_elapsed, condition_met) = self.run(&mode)?;
+
+        // Read all outputs
+        let outputs = self.read_outputs()?;
+
+        Ok(ExecutionResult {
+            outputs,
+            ticks_elapsed,
+            condition_met,
+        })
+    }
+
+    /// Execute the circuit once per row of a columnar batch.
+    ///
+    /// Each input column holds one port's raw binary encoding per vector
+    /// (the [`IoType`](super::IoType) bits, LSB first, as a `u64`), so ports
+    /// up to 64 bits wide can be batched. Ports are resolved once up front
+    /// and values never pass through [`Value`] or a per-vector map. Inputs
+    /// without a column keep whatever the state mode leaves them at.
+    /// Outputs come back the same way, one column per output port in name
+    /// order.
+    pub fn execute_batch(
+        &mut self,
+        inputs: &InputBatch,
+        mode: &ExecutionMode,
+    ) -> Result<BatchResult, String> {
+        let input_ports = inputs
+            .columns
+            .iter()
+            .map(|(name, _)| {
+                self.inputs
+                    .get(name)
+                    .cloned()
+                    .ok_or_else(|| format!("Unknown input: {}", name))
+            })
+            .collect::<Result<Vec<_>, _>>()?;
+        let mut output_names: Vec<String> = self.outputs.keys().cloned().collect();
+        output_names.sort();
+        let output_ports: Vec<IoMapping> = output_names
+            .iter()
+            .map(|name| self.outputs[name].clone())
+            .collect();
+        for (name, port) in inputs
+            .columns
+            .iter()
+            .map(|(name, _)| name)
+            .zip(&input_ports)
+            .chain(output_names.iter().zip(&output_ports))
+        {
+            if port.io_type.bit_count() > 64 {
+                return Err(format!("Port {} is wider than 64 bits", name));
+            }
+        }
+
+        let mut result = BatchResult {
+            len: inputs.len,
+            output_names,
+            outputs: vec![Vec::with_capacity(inputs.len); output_ports.len()],
+            ticks_elapsed: Vec::with_capacity(inputs.len),
+            condition_met: Vec::with_capacity(inputs.len),
+        };
+        let mut bits = Vec::with_capacity(64);
+        for row in 0..inputs.len {
+            self.begin_execution()?;
+            for (port, (_, column)) in input_ports.iter().zip(&inputs.columns) {
+                let raw = column[row];
+                bits.clear();
+                bits.extend((0..port.io_type.bit_count()).map(|i| (raw >> i) & 1 == 1));
+                let nibbles = port.layout.spread_bits(&bits)?;
+                self.world.set_signals_batch(&port.positions, &nibbles)?;
+            }
+            self.world.flush();
+
+            let (ticks_elapsed, condition_met) = self.run(mode)?;
+            self.world.flush();
+            for (port, column) in output_ports.iter().zip(&mut result.outputs) {
+                let nibbles = self.world.get_signals_batch(&port.positions);
+                let raw = port
+                    .layout
+                    .collect_bits(&nibbles)?
+                    .iter()
+                    .enumerate()
+                    .fold(0u64, |raw, (i, &bit)| raw | (bit as u64) << i);
+                column.push(raw);
+            }
+            result.ticks_elapsed.push(ticks_elapsed);
+            result.condition_met.push(condition_met);
+        }
+        Ok(result)
+    }
+
+    /// Apply the state mode before an execution.
+    fn begin_execution(&mut self) -> Result<(), String> {
+        match self.state_mode {
+            StateMode::Stateless => {
+                // Reset unless the world is still as compiled. A reset is a
+                // full redpiler recompile: the backend's node state cannot
+                // be copied or restored at the pinned MCHPRS revision.
+                if !self.pristine {
+                    self.reset()?;
+                }
+            }
+            StateMode::Stateful => {
+                // Preserve state - do nothing
+            }
+            StateMode::Manual => {
+                // User controls reset - do nothing
+            }
+        }
+        self.pristine = false;
+        Ok(())
+    }
+
+    /// Advance the simulation as `mode` says, returning the ticks elapsed and
+    /// whether its condition was met.
+    fn run(&mut self, mode: &ExecutionMode) -> Result<(u32, bool), String> {
+        match *mode {
             ExecutionMode::FixedTicks { ticks } => {
                 self.world.tick(ticks);
-                (ticks, true)
+                Ok((ticks, true))
             }
 
             ExecutionMode::UntilCondition {
-                output_name,
-                condition,
+                ref output_name,
+                ref condition,
                 max_ticks,
                 check_interval,
-            } => {
-                self.execute_until_condition(&output_name, &condition, max_ticks, check_interval)?
-            }
+            } => self.execute_until_condition(output_name, condition, max_ticks, check_interval),
 
             ExecutionMode::UntilChange {
                 max_ticks,
                 check_interval,
-            } => self.execute_until_change(max_ticks, check_interval)?,
+            } => self.execute_until_change(max_ticks, check_interval),
 
             ExecutionMode::UntilStable {
                 stable_ticks,
                 max_ticks,
-            } => self.execute_until_stable(stable_ticks, max_ticks)?,
-        };
-
-        // Read all outputs
-        let outputs = self.read_outputs()?;
-
-        Ok(ExecutionResult {
-            outputs,
-            ticks_elapsed,
-            condition_met,
-        })
+            } => self.execute_until_stable(stable_ticks, max_ticks),
+        }
     }
 
     /// Reset the simulation by recreating the world
@@ -384,6 +591,7 @@ impl TypedCircuitExecutor {
             self.original_schematic.clone(),
             self.simulation_options.clone(),
         )?;
+        self.pristine = true;
         Ok(())
     }
 
@@ -394,6 +602,7 @@ impl TypedCircuitExecutor {
 
     /// Get a mutable reference to the world (for advanced use)
     pub fn world_mut(&mut self) -> &mut MchprsWorld {
+        self.pristine = false;
         &mut self.world
     }
 
@@ -411,6 +620,7 @@ impl TypedCircuitExecutor {
     /// // Read outputs manually
     /// ```
     pub fn tick(&mut self, ticks: u32) {
+        self.pristine = false;
         self.world.tick(ticks);
     }
 
@@ -433,6 +643,7 @@ impl TypedCircuitExecutor {
             .ok_or_else(|| format!("Unknown input: {}", name))?;
 
         let nibbles = mapping.encode(value)?;
+        self.pristine = false;
         self.world.set_signals_batch(&mapping.positions, &nibbles)?;
         Ok(())
     }
@@ -510,6 +721,12 @@ impl TypedCircuitExecutor {
         self.world.get_schematic()
     }
 
+    /// Sync the simulation state back to the schematic, returning only the
+    /// blocks that changed. See [`MchprsWorld::sync_changes`].
+    pub fn sync_changes(&mut self) -> Vec<((i32, i32, i32), crate::BlockState)> {
+        self.world.sync_changes()
+    }
+
     /// Read all outputs from the world
     fn read_outputs(&mut self) -> Result<HashMap<String, Value>, String> {
         // Flush the compiler state to ensure block states (like lamps) are up to date
@@ -531,6 +748,9 @@ impl TypedCircuitExecutor {
     }
 
     /// Execute until a specific output condition is met
+    ///
+    /// Only `output_name` is sampled, and the condition is re-evaluated only
+    /// when its decoded value changes.
     fn execute_until_condition(
         &mut self,
         output_name: &str,
@@ -538,7 +758,14 @@ impl TypedCircuitExecutor {
         max_ticks: u32,
         check_interval: u32,
     ) -> Result<(u32, bool), String> {
+        let port = self
+            .outputs
+            .get(output_name)
+            .cloned()
+            .ok_or_else(|| format!("Unknown output: {}", output_name))?;
+        let mut watch = OutputWatch::new(&mut self.world, vec![port]);
         let mut ticks_elapsed = 0;
+        let mut met = None;
 
         while ticks_elapsed < max_ticks {
             // Tick the simulation
@@ -546,12 +773,11 @@ impl TypedCircuitExecutor {
             ticks_elapsed += check_interval;
 
             // Check the condition
-            let outputs = self.read_outputs()?;
-            let output_value = outputs
-                .get(output_name)
-                .ok_or_else(|| format!("Unknown output: {}", output_name))?;
-
-            if condition.check(output_value) {
+            let changed = watch.update(&mut self.world)?;
+            if met.is_none() || changed {
+                met = Some(condition.check(watch.value(0)?));
+            }
+            if met == Some(true) {
                 return Ok((ticks_elapsed, true));
             }
         }
@@ -566,23 +792,19 @@ impl TypedCircuitExecutor {
         max_ticks: u32,
         check_interval: u32,
     ) -> Result<(u32, bool), String> {
+        let ports = self.outputs.values().cloned().collect();
+        let mut watch = OutputWatch::new(&mut self.world, ports);
         let mut ticks_elapsed = 0;
-        let initial_outputs = self.read_outputs()?;
 
         while ticks_elapsed < max_ticks {
             // Tick the simulation
             self.world.tick(check_interval);
             ticks_elapsed += check_interval;
 
-            // Check if any output changed
-            let current_outputs = self.read_outputs()?;
-
-            for (name, initial_value) in &initial_outputs {
-                if let Some(current_value) = current_outputs.get(name) {
-                    if initial_value != current_value {
-                        return Ok((ticks_elapsed, true));
-                    }
-                }
+            // Until now every sample decoded to the initial outputs, so a
+            // change since the last sample is a change from the start.
+            if watch.update(&mut self.world)? {
+                return Ok((ticks_elapsed, true));
             }
         }
 
@@ -596,9 +818,10 @@ impl TypedCircuitExecutor {
         stable_ticks: u32,
         max_ticks: u32,
     ) -> Result<(u32, bool), String> {
+        let ports = self.outputs.values().cloned().collect();
+        let mut watch = OutputWatch::new(&mut self.world, ports);
         let mut ticks_elapsed = 0;
         let mut stable_count = 0;
-        let mut last_outputs = self.read_outputs()?;
 
         while ticks_elapsed < max_ticks {
             // Tick the simulation
@@ -606,19 +829,15 @@ impl TypedCircuitExecutor {
             ticks_elapsed += 1;
 
             // Check if outputs are the same as last tick
-            let current_outputs = self.read_outputs()?;
-
-            if current_outputs == last_outputs {
+            if watch.update(&mut self.world)? {
+                // Outputs changed, reset stable counter
+                stable_count = 0;
+            } else {
                 stable_count += 1;
                 if stable_count >= stable_ticks {
                     return Ok((ticks_elapsed, true));
                 }
-            } else {
-                // Outputs changed, reset stable counter
-                stable_count = 0;
             }
-
-            last_outputs = current_outputs;
         }
 
         // Timeout - not stable
@@ -647,4 +866,115 @@ mod tests {
         // Just test that it compiles
         drop(executor);
     }
+
+    #[test]
+    fn stateless_execution_reuses_the_freshly_compiled_world() {
+        let mut schematic = UniversalSchematic::new("test".to_string());
+        schematic.set_block(0, 0, 0, &BlockState::new("minecraft:stone".to_string()));
+        let world = MchprsWorld::new(schematic).unwrap();
+        let mut executor = TypedCircuitExecutor::new(world, HashMap::new(), HashMap::new());
+        assert!(executor.pristine);
+
+        let mode = ExecutionMode::FixedTicks { ticks: 2 };
+        executor.execute(HashMap::new(), mode.clone()).unwrap();
+        assert!(!executor.pristine);
+        executor.reset().unwrap();
+        assert!(executor.pristine);
+        executor.tick(1);
+        assert!(!executor.pristine);
+    }
+
+    /// A NOT gate with a bool input sign at z=2 and output sign at z=0.
+    fn not_gate() -> TypedCircuitExecutor {
+        use crate::schematic_builder::SchematicBuilder;
+        use crate::simulation::typed_executor::insign_io::create_executor_from_insign;
+
+        let template = "# Base layer\nc\nc\nc\n\n# Logic layer\n│\n▲\n│\n";
+        let mut schematic = SchematicBuilder::from_template(template)
+            .unwrap()
+            .build()
+            .unwrap();
+        for (z, name, kind) in [(2, "in", "input"), (0, "out", "output")] {
+            let mut nbt = HashMap::new();
+            let lines = [
+                format!("@io.{name}=rc([0,-1,0],[0,-1,0])"),
+                format!("#io.{name}:type=\\\"{kind}\\\""),
+                format!("#io.{name}:data_type=\\\"bool\\\""),
+                String::new(),
+            ];
+            for (i, line) in lines.iter().enumerate() {
+                nbt.insert(format!("Text{}", i + 1), format!("{{\"text\":\"{line}\"}}"));
+            }
+            schematic
+                .set_block_with_nbt(0, 2, z, "minecraft:oak_sign[rotation=0]", nbt)
+                .unwrap();
+        }
+        create_executor_from_insign(&schematic).unwrap()
+    }
+
+    #[test]
+    fn batch_execution_matches_per_vector_execution() {
+        let mut executor = not_gate();
+        let mode = ExecutionMode::FixedTicks { ticks: 20 };
+
+        let mut batch = InputBatch::new(3);
+        batch.set_column("in", vec![0, 1, 0]).unwrap();
+        assert!(batch.set_column("in", vec![1]).is_err());
+        let result = executor.execute_batch(&batch, &mode).unwrap();
+        assert_eq!(result.output("out"), Some(&[1, 0, 1][..]));
+        assert_eq!(result.ticks_elapsed, vec![20; 3]);
+
+        let single = executor
+            .execute(
+                HashMap::from([("in".to_string(), Value::Bool(true))]),
+                mode.clone(),
+            )
+            .unwrap();
+        assert_eq!(single.outputs["out"], Value::Bool(false));
+
+        let mut unknown = InputBatch::new(1);
+        unknown.set_column("nope", vec![0]).unwrap();
+        assert!(executor.execute_batch(&unknown, &mode).is_err());
+    }
+
+    #[test]
+    fn until_modes_stop_on_the_watched_outputs() {
+        let mut executor = not_gate();
+        let inputs = HashMap::from([("in".to_string(), Value::Bool(true))]);
+
+        let until_off = ExecutionMode::UntilCondition {
+            output_name: "out".to_string(),
+            condition: OutputCondition::Equals(Value::Bool(false)),
+            max_ticks: 20,
+            check_interval: 1,
+        };
+        let result = executor.execute(inputs.clone(), until_off).unwrap();
+        assert!(result.condition_met);
+        assert!(result.ticks_elapsed < 20);
+        assert_eq!(result.outputs["out"], Value::Bool(false));
+
+        let until_change = ExecutionMode::UntilChange {
+            max_ticks: 20,
+            check_interval: 1,
+        };
+        let changed = executor.execute(inputs.clone(), until_change).unwrap();
+        assert!(changed.condition_met);
+        assert_eq!(changed.ticks_elapsed, result.ticks_elapsed);
+
+        let until_stable = ExecutionMode::UntilStable {
+            stable_ticks: 5,
+            max_ticks: 40,
+        };
+        let stable = executor.execute(inputs, until_stable).unwrap();
+        assert!(stable.condition_met);
+        assert_eq!(stable.ticks_elapsed, result.ticks_elapsed + 5);
+
+        let unknown = ExecutionMode::UntilCondition {
+            output_name: "nope".to_string(),
+            condition: OutputCondition::Equals(Value::Bool(false)),
+            max_ticks: 20,
+            check_interval: 1,
+        };
+        assert!(executor.execute(HashMap::new(), unknown).is_err());
+    }
 }
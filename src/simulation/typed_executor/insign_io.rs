@@ -1,11 +1,13 @@
 /// Insign IO integration for TypedCircuitExecutor
 /// Parses Insign DSL regions and creates IoLayout with distance-based position sorting
 use crate::simulation::typed_executor::{
-    IoLayoutBuilder, IoType, LayoutFunction, TypedCircuitExecutor,
+    IoLayout, IoLayoutBuilder, IoType, LayoutFunction, TypedCircuitExecutor,
 };
 use crate::simulation::MchprsWorld;
 use crate::universal_schematic::UniversalSchematic;
 use crate::{insign, BlockState};
+use std::collections::{HashMap, VecDeque};
+use std::sync::{Arc, Mutex, OnceLock};
 
 /// Sort strategy for ordering extracted redstone positions
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -349,10 +351,11 @@ pub fn parse_io_layout_from_insign(
     Ok(builder)
 }
 
-/// Create TypedCircuitExecutor from Insign annotations in a schematic
-pub fn create_executor_from_insign(
+/// Extract the IO layout from a schematic's Insign annotations and strip the
+/// signs, giving the schematic to simulate.
+fn prepare_insign(
     schematic: &UniversalSchematic,
-) -> Result<TypedCircuitExecutor, InsignIoError> {
+) -> Result<(UniversalSchematic, IoLayout), InsignIoError> {
     // Extract signs from schematic
     let signs = insign::extract_signs(schematic);
 
@@ -371,12 +374,43 @@ pub fn create_executor_from_insign(
         schematic_without_signs.set_block(pos[0], pos[1], pos[2], &air_block);
     }
 
-    // Create MchprsWorld
-    let world = MchprsWorld::new(schematic_without_signs)
-        .map_err(|e| InsignIoError::SchematicError(e.to_string()))?;
+    Ok((schematic_without_signs, layout))
+}
 
-    // Create executor
-    Ok(TypedCircuitExecutor::from_layout(world, layout))
+/// Build the executor for a [`prepare_insign`] result.
+fn build_from_prepared(
+    schematic_without_signs: UniversalSchematic,
+    layout: IoLayout,
+    options: Option<crate::simulation::SimulationOptions>,
+) -> Result<TypedCircuitExecutor, InsignIoError> {
+    match options {
+        None => {
+            // Create MchprsWorld
+            let world = MchprsWorld::new(schematic_without_signs)
+                .map_err(|e| InsignIoError::SchematicError(e.to_string()))?;
+
+            // Create executor
+            Ok(TypedCircuitExecutor::from_layout(world, layout))
+        }
+        Some(options) => {
+            // Create MchprsWorld with options
+            let world = MchprsWorld::with_options(schematic_without_signs, options.clone())
+                .map_err(|e| InsignIoError::SchematicError(e.to_string()))?;
+
+            // Create executor with the same options so reset() preserves them
+            Ok(TypedCircuitExecutor::from_layout_with_options(
+                world, layout, options,
+            ))
+        }
+    }
+}
+
+/// Create TypedCircuitExecutor from Insign annotations in a schematic
+pub fn create_executor_from_insign(
+    schematic: &UniversalSchematic,
+) -> Result<TypedCircuitExecutor, InsignIoError> {
+    let (schematic_without_signs, layout) = prepare_insign(schematic)?;
+    build_from_prepared(schematic_without_signs, layout, None)
 }
 
 /// Create a TypedCircuitExecutor from Insign annotations with custom simulation options
@@ -384,32 +418,119 @@ pub fn create_executor_from_insign_with_options(
     schematic: &UniversalSchematic,
     options: crate::simulation::SimulationOptions,
 ) -> Result<TypedCircuitExecutor, InsignIoError> {
-    // Extract signs from schematic
-    let signs = insign::extract_signs(schematic);
+    let (schematic_without_signs, layout) = prepare_insign(schematic)?;
+    build_from_prepared(schematic_without_signs, layout, Some(options))
+}
 
-    // Convert to input format
-    let input: Vec<([i32; 3], String)> = signs.into_iter().map(|s| (s.pos, s.text)).collect();
+// ─── Insign cache ────────────────────────────────────────────────────────────
+//
+// Servers that build executors for many submitted circuits often see the
+// same schematic again. The cache keeps each distinct schematic's
+// sign-stripped copy and IO layout, so repeats skip sign extraction, DSL
+// compilation and layout building. The redpiler graph cannot be cloned, so
+// each executor still compiles its own world.
+
+/// Distinct schematics kept by the Insign cache before the oldest is evicted.
+pub const INSIGN_CACHE_CAPACITY: usize = 256;
+
+/// Exact fingerprint, which is translation invariant, plus the origin that
+/// IO positions are absolute against, plus the simulation options.
+#[derive(Clone, PartialEq, Eq, Hash)]
+struct InsignCacheKey {
+    fingerprint: crate::fingerprint::Fingerprint,
+    origin: (i32, i32, i32),
+    options: Option<(bool, bool, Vec<(i32, i32, i32)>)>,
+}
 
-    // Parse IO layout
-    let builder = parse_io_layout_from_insign(&input, schematic)?;
-    let layout = builder.build();
+#[derive(Default)]
+struct InsignCache {
+    entries: HashMap<InsignCacheKey, Arc<(UniversalSchematic, IoLayout)>>,
+    /// Insertion order, for eviction.
+    order: VecDeque<InsignCacheKey>,
+}
 
-    // Create a copy of the schematic without signs (MCHPRS might not support all sign block types)
-    let mut schematic_without_signs = schematic.clone();
-    for (pos, _) in &input {
-        // Replace sign blocks with air
-        let air_block = crate::BlockState::new("minecraft:air");
-        schematic_without_signs.set_block(pos[0], pos[1], pos[2], &air_block);
-    }
+fn insign_cache() -> &'static Mutex<InsignCache> {
+    static CACHE: OnceLock<Mutex<InsignCache>> = OnceLock::new();
+    CACHE.get_or_init(Default::default)
+}
 
-    // Create MchprsWorld with options
-    let world = MchprsWorld::with_options(schematic_without_signs, options.clone())
-        .map_err(|e| InsignIoError::SchematicError(e.to_string()))?;
+fn cached_executor(
+    schematic: &UniversalSchematic,
+    options: Option<crate::simulation::SimulationOptions>,
+) -> Result<TypedCircuitExecutor, InsignIoError> {
+    let key = InsignCacheKey {
+        fingerprint: crate::fingerprint::fingerprint(
+            schematic,
+            &crate::fingerprint::FingerprintSpec::exact(),
+        ),
+        origin: schematic.get_bounding_box().min,
+        options: options.as_ref().map(|o| {
+            let mut custom_io: Vec<_> = o.custom_io.iter().map(|p| (p.x, p.y, p.z)).collect();
+            custom_io.sort_unstable();
+            (o.optimize, o.io_only, custom_io)
+        }),
+    };
+
+    let cached = insign_cache()
+        .lock()
+        .unwrap_or_else(|e| e.into_inner())
+        .entries
+        .get(&key)
+        .cloned();
+    let prepared = match cached {
+        Some(prepared) => prepared,
+        None => {
+            // Prepared outside the lock; a concurrent miss on the same key
+            // just prepares it twice.
+            let prepared = Arc::new(prepare_insign(schematic)?);
+            let mut cache = insign_cache().lock().unwrap_or_else(|e| e.into_inner());
+            if !cache.entries.contains_key(&key) {
+                if cache.order.len() >= INSIGN_CACHE_CAPACITY {
+                    if let Some(oldest) = cache.order.pop_front() {
+                        cache.entries.remove(&oldest);
+                    }
+                }
+                cache.order.push_back(key.clone());
+                cache.entries.insert(key, Arc::clone(&prepared));
+            }
+            prepared
+        }
+    };
+    let (schematic_without_signs, layout) = &*prepared;
+    build_from_prepared(schematic_without_signs.clone(), layout.clone(), options)
+}
 
-    // Create executor with the same options so reset() preserves them
-    Ok(TypedCircuitExecutor::from_layout_with_options(
-        world, layout, options,
-    ))
+/// [`create_executor_from_insign`] through a process-wide cache keyed by the
+/// schematic's exact fingerprint, so identical schematics are parsed once.
+pub fn create_executor_from_insign_cached(
+    schematic: &UniversalSchematic,
+) -> Result<TypedCircuitExecutor, InsignIoError> {
+    cached_executor(schematic, None)
+}
+
+/// [`create_executor_from_insign_with_options`] through the same cache as
+/// [`create_executor_from_insign_cached`]; the options are part of the key.
+pub fn create_executor_from_insign_with_options_cached(
+    schematic: &UniversalSchematic,
+    options: crate::simulation::SimulationOptions,
+) -> Result<TypedCircuitExecutor, InsignIoError> {
+    cached_executor(schematic, Some(options))
+}
+
+/// Number of schematics currently in the Insign cache.
+pub fn insign_cache_len() -> usize {
+    insign_cache()
+        .lock()
+        .unwrap_or_else(|e| e.into_inner())
+        .entries
+        .len()
+}
+
+/// Drop every entry from the Insign cache.
+pub fn clear_insign_cache() {
+    let mut cache = insign_cache().lock().unwrap_or_else(|e| e.into_inner());
+    cache.entries.clear();
+    cache.order.clear();
 }
 
 #[cfg(test)]
@@ -1061,4 +1182,57 @@ cc··cccccc
             }
         }
     }
+
+    #[test]
+    fn test_cached_executor_matches_uncached() {
+        use crate::simulation::typed_executor::{ExecutionMode, Value};
+
+        // A NOT gate with bool IO signs `in` (z=2) and `out` (z=0).
+        let template = "# Base layer\nc\nc\nc\n\n# Logic layer\n│\n▲\n│\n";
+        let mut schematic = SchematicBuilder::from_template(template)
+            .unwrap()
+            .build()
+            .unwrap();
+        for (z, name, kind) in [(2, "in", "input"), (0, "out", "output")] {
+            let mut nbt = HashMap::new();
+            let lines = [
+                format!("@io.{name}=rc([0,-1,0],[0,-1,0])"),
+                format!("#io.{name}:type=\\\"{kind}\\\""),
+                format!("#io.{name}:data_type=\\\"bool\\\""),
+                String::new(),
+            ];
+            for (i, line) in lines.iter().enumerate() {
+                nbt.insert(format!("Text{}", i + 1), format!("{{\"text\":\"{line}\"}}"));
+            }
+            schematic
+                .set_block_with_nbt(0, 2, z, "minecraft:oak_sign[rotation=0]", nbt)
+                .unwrap();
+        }
+
+        let mut uncached = create_executor_from_insign(&schematic).unwrap();
+        let mut first = create_executor_from_insign_cached(&schematic).unwrap();
+        let mut second = create_executor_from_insign_cached(&schematic).unwrap();
+        assert!(insign_cache_len() >= 1);
+
+        let mode = ExecutionMode::FixedTicks { ticks: 10 };
+        for input in [false, true] {
+            let inputs = HashMap::from([("in".to_string(), Value::Bool(input))]);
+            let expected = uncached.execute(inputs.clone(), mode.clone()).unwrap();
+            for executor in [&mut first, &mut second] {
+                let result = executor.execute(inputs.clone(), mode.clone()).unwrap();
+                assert_eq!(result.outputs, expected.outputs);
+                assert_eq!(result.outputs["out"], Value::Bool(!input));
+            }
+        }
+
+        let options = crate::simulation::SimulationOptions {
+            optimize: false,
+            ..Default::default()
+        };
+        let mut unoptimized =
+            create_executor_from_insign_with_options_cached(&schematic, options).unwrap();
+        let inputs = HashMap::from([("in".to_string(), Value::Bool(true))]);
+        let result = unoptimized.execute(inputs, mode).unwrap();
+        assert_eq!(result.outputs["out"], Value::Bool(false));
+    }
 }
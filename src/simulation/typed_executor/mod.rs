@@ -105,6 +105,16 @@
 //! executor.execute(inputs2, mode)?;  // Continues from previous state
 //! ```
 //!
+//! ## Parallel Batches
+//!
+//! ```ignore
+//! // One instance per core, each running a share of the vectors
+//! let pool = ExecutorPool::from_executor(&executor, 0)?;
+//! let mut batch = InputBatch::new(256);
+//! batch.set_column("a", (0..256).collect())?;
+//! let result = pool.execute_batch(&batch, &ExecutionMode::FixedTicks { ticks: 20 })?;
+//! ```
+//!
 //! ## Auto Layout Inference
 //!
 //! ```ignore
@@ -121,8 +131,11 @@ mod io_layout_builder;
 mod io_mapping;
 mod io_type;
 mod layout_function;
+#[cfg(not(target_arch = "wasm32"))]
+mod pool;
 pub mod sort_strategy;
 mod value;
+mod watch;
 
 #[cfg(test)]
 mod tests;
@@ -133,16 +146,19 @@ mod integration_tests;
 // Public API
 pub use compiled::{COMPILED_MAGIC, COMPILED_VERSION};
 pub use executor::{
-    ExecutionMode, ExecutionResult, IoLayoutInfo, LayoutInfo, OutputCondition, StateMode,
-    TypedCircuitExecutor,
+    BatchResult, ExecutionMode, ExecutionResult, InputBatch, IoLayoutInfo, LayoutInfo,
+    OutputCondition, StateMode, TypedCircuitExecutor,
 };
 pub use insign_io::{
-    create_executor_from_insign, create_executor_from_insign_with_options,
-    parse_io_layout_from_insign, InsignIoError,
+    clear_insign_cache, create_executor_from_insign, create_executor_from_insign_cached,
+    create_executor_from_insign_with_options, create_executor_from_insign_with_options_cached,
+    insign_cache_len, parse_io_layout_from_insign, InsignIoError, INSIGN_CACHE_CAPACITY,
 };
 pub use io_layout_builder::{IoLayout, IoLayoutBuilder};
 pub use io_mapping::IoMapping;
 pub use io_type::IoType;
 pub use layout_function::LayoutFunction;
+#[cfg(not(target_arch = "wasm32"))]
+pub use pool::ExecutorPool;
 pub use sort_strategy::SortStrategy;
 pub use value::Value;
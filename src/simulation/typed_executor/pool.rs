@@ -0,0 +1,269 @@
+//! Parallel batch execution across several executor instances.
+//!
+//! An [`ExecutorPool`] owns one [`TypedCircuitExecutor`] per worker thread,
+//! all restored from the same compiled-circuit container (see
+//! [`super::compiled`]), so schematic parsing, insign extraction and layout
+//! building happen once. The redpiler compile itself still runs once per
+//! worker, in parallel: mchprs' backend state cannot be cloned at the pinned
+//! revision. Each executor lives and dies on its own thread, so the backend
+//! never has to be `Send`.
+//!
+//! [`ExecutorPool::execute_batch`] splits a batch into small row chunks that
+//! idle workers claim from a shared cursor, so a worker stuck on slow
+//! vectors (long `UntilCondition` runs) does not hold up the rest. Results
+//! come back in input order.
+//!
+//! Every worker applies the container's [`super::StateMode`] to its own
+//! instance. With the default `Stateless` mode each vector is independent;
+//! under `Stateful` a vector's result depends on which worker ran the
+//! vectors before it.
+
+use super::{BatchResult, ExecutionMode, InputBatch, TypedCircuitExecutor};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::mpsc;
+use std::sync::Arc;
+use std::thread::JoinHandle;
+
+/// Rows claimed per chunk are sized so each worker takes about this many
+/// chunks per batch: enough to balance uneven vectors, few enough that the
+/// per-chunk overhead stays negligible.
+const CHUNKS_PER_WORKER: usize = 8;
+
+type ChunkResult = Result<(usize, BatchResult), String>;
+
+struct Job {
+    inputs: Arc<InputBatch>,
+    mode: Arc<ExecutionMode>,
+    chunk: usize,
+    next: Arc<AtomicUsize>,
+    results: mpsc::Sender<ChunkResult>,
+}
+
+/// A fixed set of worker threads, each driving its own instance of one
+/// compiled circuit.
+pub struct ExecutorPool {
+    jobs: Vec<mpsc::Sender<Job>>,
+    handles: Vec<JoinHandle<()>>,
+    output_names: Vec<String>,
+}
+
+impl ExecutorPool {
+    /// Start `workers` instances restored from [`TypedCircuitExecutor::to_compiled_bytes`]
+    /// output (`0` means one per core). Fails if any instance fails to build.
+    pub fn from_compiled_bytes(bytes: &[u8], workers: usize) -> Result<Self, String> {
+        let workers = if workers == 0 {
+            std::thread::available_parallelism().map_or(1, |n| n.get())
+        } else {
+            workers
+        };
+        let bytes: Arc<[u8]> = bytes.into();
+        let (ready_tx, ready_rx) = mpsc::channel::<Result<Vec<String>, String>>();
+        let mut pool = ExecutorPool {
+            jobs: Vec::with_capacity(workers),
+            handles: Vec::with_capacity(workers),
+            output_names: Vec::new(),
+        };
+        for index in 0..workers {
+            let (job_tx, job_rx) = mpsc::channel::<Job>();
+            let bytes = Arc::clone(&bytes);
+            let ready = ready_tx.clone();
+            let handle = std::thread::Builder::new()
+                .name(format!("nucleation-executor-{}", index))
+                .spawn(move || {
+                    let mut executor = match TypedCircuitExecutor::from_compiled_bytes(&bytes) {
+                        Ok(executor) => executor,
+                        Err(e) => {
+                            let _ = ready.send(Err(e));
+                            return;
+                        }
+                    };
+                    let mut names: Vec<String> = executor
+                        .output_names()
+                        .into_iter()
+                        .map(String::from)
+                        .collect();
+                    names.sort();
+                    let _ = ready.send(Ok(names));
+                    drop(ready);
+                    for job in job_rx {
+                        run_job(&mut executor, &job);
+                    }
+                })
+                .map_err(|e| format!("Failed to start executor worker: {}", e))?;
+            pool.jobs.push(job_tx);
+            pool.handles.push(handle);
+        }
+        drop(ready_tx);
+        for _ in 0..workers {
+            match ready_rx.recv() {
+                Ok(Ok(names)) => pool.output_names = names,
+                Ok(Err(e)) => return Err(e),
+                Err(_) => return Err("Executor worker panicked during startup".to_string()),
+            }
+        }
+        Ok(pool)
+    }
+
+    /// Start `workers` instances of the circuit `executor` was built from.
+    /// Only its build inputs are copied, not its current simulation state.
+    pub fn from_executor(executor: &TypedCircuitExecutor, workers: usize) -> Result<Self, String> {
+        Self::from_compiled_bytes(&executor.to_compiled_bytes()?, workers)
+    }
+
+    /// Number of worker instances.
+    pub fn worker_count(&self) -> usize {
+        self.jobs.len()
+    }
+
+    /// [`TypedCircuitExecutor::execute_batch`] spread across the workers.
+    /// The result is in input order; on error, the first error received is
+    /// returned and unclaimed rows are skipped.
+    pub fn execute_batch(
+        &self,
+        inputs: &InputBatch,
+        mode: &ExecutionMode,
+    ) -> Result<BatchResult, String> {
+        let len = inputs.len();
+        let mut result = BatchResult {
+            len: 0,
+            output_names: self.output_names.clone(),
+            outputs: vec![Vec::with_capacity(len); self.output_names.len()],
+            ticks_elapsed: Vec::with_capacity(len),
+            condition_met: Vec::with_capacity(len),
+        };
+        if len == 0 {
+            return Ok(result);
+        }
+
+        let chunk = len.div_ceil(self.jobs.len() * CHUNKS_PER_WORKER).max(1);
+        let inputs = Arc::new(inputs.clone());
+        let mode = Arc::new(mode.clone());
+        let next = Arc::new(AtomicUsize::new(0));
+        let (results_tx, results_rx) = mpsc::channel();
+        for jobs in &self.jobs {
+            let job = Job {
+                inputs: Arc::clone(&inputs),
+                mode: Arc::clone(&mode),
+                chunk,
+                next: Arc::clone(&next),
+                results: results_tx.clone(),
+            };
+            jobs.send(job)
+                .map_err(|_| "Executor worker is gone".to_string())?;
+        }
+        drop(results_tx);
+
+        let mut chunks = Vec::with_capacity(len.div_ceil(chunk));
+        let mut first_error = None;
+        // Ends once every worker has dropped its job (and its sender).
+        for received in results_rx {
+            match received {
+                Ok(chunk) => chunks.push(chunk),
+                Err(e) => {
+                    next.store(len, Ordering::Relaxed);
+                    first_error.get_or_insert(e);
+                }
+            }
+        }
+        if let Some(e) = first_error {
+            return Err(e);
+        }
+        if chunks.iter().map(|(_, c)| c.len).sum::<usize>() != len {
+            return Err("Executor worker panicked".to_string());
+        }
+
+        chunks.sort_unstable_by_key(|(start, _)| *start);
+        for (_, chunk) in chunks {
+            result.append(chunk);
+        }
+        Ok(result)
+    }
+}
+
+/// Claim and run chunks of `job` until its rows run out.
+fn run_job(executor: &mut TypedCircuitExecutor, job: &Job) {
+    let len = job.inputs.len();
+    loop {
+        let start = job.next.fetch_add(job.chunk, Ordering::Relaxed);
+        if start >= len {
+            return;
+        }
+        let rows = job.inputs.rows(start..(start + job.chunk).min(len));
+        let result = executor
+            .execute_batch(&rows, &job.mode)
+            .map(|result| (start, result));
+        if job.results.send(result).is_err() {
+            return;
+        }
+    }
+}
+
+impl Drop for ExecutorPool {
+    fn drop(&mut self) {
+        // Closing the job channels ends each worker's loop.
+        self.jobs.clear();
+        for handle in self.handles.drain(..) {
+            let _ = handle.join();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::schematic_builder::SchematicBuilder;
+    use crate::simulation::typed_executor::create_executor_from_insign;
+    use std::collections::HashMap;
+
+    /// A NOT gate with bool IO signs `in` (z=2) and `out` (z=0).
+    fn not_gate() -> TypedCircuitExecutor {
+        let template = "# Base layer\nc\nc\nc\n\n# Logic layer\n│\n▲\n│\n";
+        let mut schematic = SchematicBuilder::from_template(template)
+            .unwrap()
+            .build()
+            .unwrap();
+        for (z, name, kind) in [(2, "in", "input"), (0, "out", "output")] {
+            let mut nbt = HashMap::new();
+            let lines = [
+                format!("@io.{name}=rc([0,-1,0],[0,-1,0])"),
+                format!("#io.{name}:type=\\\"{kind}\\\""),
+                format!("#io.{name}:data_type=\\\"bool\\\""),
+                String::new(),
+            ];
+            for (i, line) in lines.iter().enumerate() {
+                nbt.insert(format!("Text{}", i + 1), format!("{{\"text\":\"{line}\"}}"));
+            }
+            schematic
+                .set_block_with_nbt(0, 2, z, "minecraft:oak_sign[rotation=0]", nbt)
+                .unwrap();
+        }
+        create_executor_from_insign(&schematic).unwrap()
+    }
+
+    #[test]
+    fn pooled_batch_matches_a_single_executor_in_input_order() {
+        let mut executor = not_gate();
+        let pool = ExecutorPool::from_executor(&executor, 3).unwrap();
+        assert_eq!(pool.worker_count(), 3);
+
+        let values: Vec<u64> = (0..50).map(|i| (i * 7 % 3 == 0) as u64).collect();
+        let mut batch = InputBatch::new(values.len());
+        batch.set_column("in", values.clone()).unwrap();
+        let mode = ExecutionMode::FixedTicks { ticks: 10 };
+
+        let pooled = pool.execute_batch(&batch, &mode).unwrap();
+        let single = executor.execute_batch(&batch, &mode).unwrap();
+        assert_eq!(pooled.len, values.len());
+        assert_eq!(pooled.output_names, single.output_names);
+        assert_eq!(pooled.outputs, single.outputs);
+        let expected: Vec<u64> = values.iter().map(|v| 1 - v).collect();
+        assert_eq!(pooled.output("out"), Some(&expected[..]));
+
+        let empty = pool.execute_batch(&InputBatch::new(0), &mode).unwrap();
+        assert_eq!(empty.output("out"), Some(&[][..]));
+
+        let mut unknown = InputBatch::new(4);
+        unknown.set_column("nope", vec![0; 4]).unwrap();
+        assert!(pool.execute_batch(&unknown, &mode).is_err());
+    }
+}
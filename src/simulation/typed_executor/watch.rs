@@ -0,0 +1,89 @@
+//! Output watching for the `Until*` execution modes.
+//!
+//! Polling used to flush the world (a sweep over the whole schematic volume)
+//! and decode every output into a [`Value`] at each check. An
+//! [`OutputWatch`] instead samples only the watched outputs' raw signals.
+//! When every watched position is a redpiler node it reads them straight
+//! from the graph with no flush at all. A port's signals are decoded only
+//! when they differ from the previous sample, so a check where nothing
+//! moved costs one signal read per watched position.
+
+use super::{IoMapping, Value};
+use crate::simulation::MchprsWorld;
+
+pub(super) struct OutputWatch {
+    ports: Vec<IoMapping>,
+    /// `signals[starts[i]..starts[i + 1]]` belongs to `ports[i]`.
+    starts: Vec<usize>,
+    positions: Vec<(i32, i32, i32)>,
+    from_graph: bool,
+    signals: Vec<u8>,
+    sample: Vec<u8>,
+    /// Decoded `signals` per port, filled on demand.
+    values: Vec<Option<Value>>,
+}
+
+impl OutputWatch {
+    /// Watch `ports`, taking their current signals as the baseline.
+    pub(super) fn new(world: &mut MchprsWorld, ports: Vec<IoMapping>) -> Self {
+        let mut starts = Vec::with_capacity(ports.len() + 1);
+        let mut positions = Vec::new();
+        for port in &ports {
+            starts.push(positions.len());
+            positions.extend_from_slice(&port.positions);
+        }
+        starts.push(positions.len());
+        let mut watch = OutputWatch {
+            values: vec![None; ports.len()],
+            ports,
+            starts,
+            from_graph: world.graph_readable(&positions),
+            positions,
+            signals: Vec::new(),
+            sample: Vec::new(),
+        };
+        watch.read(world);
+        std::mem::swap(&mut watch.signals, &mut watch.sample);
+        watch
+    }
+
+    fn read(&mut self, world: &mut MchprsWorld) {
+        if self.from_graph {
+            world.get_graph_signals_batch(&self.positions, &mut self.sample);
+        } else {
+            world.flush();
+            self.sample = world.get_signals_batch(&self.positions);
+        }
+    }
+
+    /// Sample the watched outputs again. Returns whether any port's decoded
+    /// value differs from the previous sample.
+    pub(super) fn update(&mut self, world: &mut MchprsWorld) -> Result<bool, String> {
+        self.read(world);
+        let mut changed = false;
+        for i in 0..self.ports.len() {
+            let range = self.starts[i]..self.starts[i + 1];
+            if self.signals[range.clone()] == self.sample[range.clone()] {
+                continue;
+            }
+            let old = match self.values[i].take() {
+                Some(value) => value,
+                None => self.ports[i].decode(&self.signals[range.clone()])?,
+            };
+            let new = self.ports[i].decode(&self.sample[range])?;
+            changed |= old != new;
+            self.values[i] = Some(new);
+        }
+        std::mem::swap(&mut self.signals, &mut self.sample);
+        Ok(changed)
+    }
+
+    /// Decoded value of port `index` as of the last sample.
+    pub(super) fn value(&mut self, index: usize) -> Result<&Value, String> {
+        if self.values[index].is_none() {
+            let range = self.starts[index]..self.starts[index + 1];
+            self.values[index] = Some(self.ports[index].decode(&self.signals[range])?);
+        }
+        Ok(self.values[index].as_ref().expect("decoded above"))
+    }
+}
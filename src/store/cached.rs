@@ -0,0 +1,466 @@
+//! Read-through cache [`Store`] wrapper: a fast local tier (a [`MemStore`] or
+//! [`FsStore`]) in front of a remote store, so hot objects are served
+//! locally and only misses travel over the network.
+//!
+//! The local tier holds copies under the same keys, bounded by
+//! [`CacheConfig::max_bytes`] with least-recently-used eviction. Each copy
+//! remembers the remote's [`Store::version`] at fetch time and is
+//! revalidated against it (a `HEAD`, not a refetch) once it is older than
+//! [`CacheConfig::revalidate_after`]. Over a remote without versions, copies
+//! are trusted until evicted.
+//!
+//! Writes and deletes through the wrapper go to the remote and drop the
+//! local copy. Writes made behind its back are picked up at the next
+//! revalidation. The index lives in memory, so give the local tier a
+//! dedicated location: copies left over from an earlier process are ignored
+//! and overwritten, never served.
+//!
+//! [`MemStore`]: super::MemStore
+//! [`FsStore`]: super::FsStore
+
+use std::collections::{BTreeMap, HashMap};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, MutexGuard};
+use std::time::{Duration, Instant};
+
+use super::{Result, Store, StoreError};
+
+/// Default [`CacheConfig::max_bytes`]: 256 MiB.
+pub const DEFAULT_MAX_BYTES: u64 = 256 * 1024 * 1024;
+
+/// Default [`CacheConfig::revalidate_after`].
+pub const DEFAULT_REVALIDATE_AFTER: Duration = Duration::from_secs(30);
+
+/// Sizing and freshness for a [`CachedStore`].
+#[derive(Clone, Debug)]
+pub struct CacheConfig {
+    /// Total bytes the local tier may hold. Objects larger than this are
+    /// never cached.
+    pub max_bytes: u64,
+    /// How long a copy is served without checking the remote version.
+    pub revalidate_after: Duration,
+}
+
+impl Default for CacheConfig {
+    fn default() -> Self {
+        Self {
+            max_bytes: DEFAULT_MAX_BYTES,
+            revalidate_after: DEFAULT_REVALIDATE_AFTER,
+        }
+    }
+}
+
+/// Counters since the cache was built, plus its current occupancy.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct CacheStats {
+    /// Reads served from the local tier.
+    pub hits: u64,
+    /// Reads that went to the remote.
+    pub misses: u64,
+    /// Version checks against the remote.
+    pub revalidations: u64,
+    /// Copies dropped to stay under `max_bytes`.
+    pub evictions: u64,
+    /// Copies currently held.
+    pub entries: u64,
+    /// Bytes currently held.
+    pub bytes: u64,
+}
+
+struct Entry {
+    size: u64,
+    /// Remote version at fetch time; `None` for an unversioned remote.
+    version: Option<String>,
+    checked: Instant,
+    tick: u64,
+}
+
+/// Which keys the local tier holds, in recency order.
+#[derive(Default)]
+struct Index {
+    entries: HashMap<String, Entry>,
+    /// `tick -> key`, oldest first.
+    order: BTreeMap<u64, String>,
+    bytes: u64,
+    clock: u64,
+}
+
+impl Index {
+    fn touch(&mut self, key: &str) {
+        self.clock += 1;
+        if let Some(entry) = self.entries.get_mut(key) {
+            self.order.remove(&entry.tick);
+            entry.tick = self.clock;
+            self.order.insert(self.clock, key.to_string());
+        }
+    }
+
+    fn remove(&mut self, key: &str) -> bool {
+        match self.entries.remove(key) {
+            Some(entry) => {
+                self.order.remove(&entry.tick);
+                self.bytes -= entry.size;
+                true
+            }
+            None => false,
+        }
+    }
+
+    /// Record `key`, returning the least recently used keys evicted to fit
+    /// it under `max_bytes`.
+    fn insert(
+        &mut self,
+        key: &str,
+        size: u64,
+        version: Option<String>,
+        max_bytes: u64,
+    ) -> Vec<String> {
+        self.remove(key);
+        let mut evicted = Vec::new();
+        while self.bytes + size > max_bytes {
+            let Some((_, victim)) = self.order.pop_first() else {
+                break;
+            };
+            if let Some(entry) = self.entries.remove(&victim) {
+                self.bytes -= entry.size;
+            }
+            evicted.push(victim);
+        }
+        self.clock += 1;
+        self.entries.insert(
+            key.to_string(),
+            Entry {
+                size,
+                version,
+                checked: Instant::now(),
+                tick: self.clock,
+            },
+        );
+        self.order.insert(self.clock, key.to_string());
+        self.bytes += size;
+        evicted
+    }
+}
+
+/// A read-through cache over `remote`, keeping copies in `local`.
+pub struct CachedStore {
+    remote: Arc<dyn Store>,
+    local: Arc<dyn Store>,
+    config: CacheConfig,
+    index: Mutex<Index>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    revalidations: AtomicU64,
+    evictions: AtomicU64,
+}
+
+impl CachedStore {
+    /// Cache `remote` in `local`, which should be empty and used by nothing
+    /// else.
+    pub fn new(remote: Arc<dyn Store>, local: Arc<dyn Store>, config: CacheConfig) -> Self {
+        Self {
+            remote,
+            local,
+            config,
+            index: Mutex::new(Index::default()),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            revalidations: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        }
+    }
+
+    /// The store behind the cache.
+    pub fn remote(&self) -> &dyn Store {
+        self.remote.as_ref()
+    }
+
+    /// Hit / miss / eviction counters and current occupancy.
+    pub fn stats(&self) -> CacheStats {
+        let index = self.lock();
+        CacheStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            revalidations: self.revalidations.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+            entries: index.entries.len() as u64,
+            bytes: index.bytes,
+        }
+    }
+
+    fn lock(&self) -> MutexGuard<'_, Index> {
+        self.index.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    /// The remote version of `key`: `None` if the remote has no versions,
+    /// `Some(None)` if the key is absent there.
+    fn remote_version(&self, key: &str) -> Result<Option<Option<String>>> {
+        match self.remote.version(key) {
+            Ok(version) => Ok(Some(version)),
+            Err(StoreError::Unsupported(_)) => Ok(None),
+            Err(e) => Err(e),
+        }
+    }
+
+    /// Whether the local copy of `key` may be served, revalidating it first
+    /// if it has gone unchecked for `revalidate_after`.
+    fn fresh(&self, key: &str) -> Result<bool> {
+        let stale = {
+            let mut index = self.lock();
+            let Some(entry) = index.entries.get(key) else {
+                return Ok(false);
+            };
+            let stale =
+                entry.version.is_some() && entry.checked.elapsed() >= self.config.revalidate_after;
+            let stale = stale.then(|| entry.version.clone());
+            index.touch(key);
+            stale
+        };
+        if let Some(cached) = stale {
+            self.revalidations.fetch_add(1, Ordering::Relaxed);
+            let current = self.remote.version(key)?;
+            let mut index = self.lock();
+            match index.entries.get_mut(key) {
+                Some(entry) if current == cached => entry.checked = Instant::now(),
+                _ => {
+                    index.remove(key);
+                    drop(index);
+                    let _ = self.local.delete(key);
+                    return Ok(false);
+                }
+            }
+        }
+        Ok(true)
+    }
+
+    /// Copy `bytes` into the local tier, evicting as needed. A local tier
+    /// that refuses the write just leaves the key uncached.
+    fn admit(&self, key: &str, bytes: &[u8], version: Option<String>) {
+        let size = bytes.len() as u64;
+        if size > self.config.max_bytes || self.local.put(key, bytes).is_err() {
+            return;
+        }
+        let evicted = self
+            .lock()
+            .insert(key, size, version, self.config.max_bytes);
+        self.evictions
+            .fetch_add(evicted.len() as u64, Ordering::Relaxed);
+        for victim in evicted {
+            let _ = self.local.delete(&victim);
+        }
+    }
+
+    /// Drop the local copy of `key`, if any.
+    fn invalidate(&self, key: &str) {
+        if self.lock().remove(key) {
+            let _ = self.local.delete(key);
+        }
+    }
+}
+
+impl Store for CachedStore {
+    fn get(&self, key: &str) -> Result<Option<Vec<u8>>> {
+        if self.fresh(key)? {
+            if let Ok(Some(bytes)) = self.local.get(key) {
+                self.hits.fetch_add(1, Ordering::Relaxed);
+                return Ok(Some(bytes));
+            }
+            // The local tier lost the copy; refetch it.
+            self.lock().remove(key);
+        }
+        self.misses.fetch_add(1, Ordering::Relaxed);
+        // Read the version before the bytes: if the object changes in
+        // between, the copy is tagged stale and refetched, never the reverse.
+        let version = match self.remote_version(key)? {
+            Some(None) => return Ok(None),
+            Some(Some(version)) => Some(version),
+            None => None,
+        };
+        let bytes = self.remote.get(key)?;
+        if let Some(bytes) = &bytes {
+            self.admit(key, bytes, version);
+        }
+        Ok(bytes)
+    }
+
+    fn put(&self, key: &str, bytes: &[u8]) -> Result<()> {
+        self.remote.put(key, bytes)?;
+        self.invalidate(key);
+        Ok(())
+    }
+
+    fn exists(&self, key: &str) -> Result<bool> {
+        if self.fresh(key)? {
+            return Ok(true);
+        }
+        self.remote.exists(key)
+    }
+
+    fn delete(&self, key: &str) -> Result<()> {
+        self.remote.delete(key)?;
+        self.invalidate(key);
+        Ok(())
+    }
+
+    fn list(&self, prefix: &str) -> Result<Vec<String>> {
+        self.remote.list(prefix)
+    }
+
+    fn health(&self) -> Result<()> {
+        self.remote.health()
+    }
+
+    fn put_if_absent(&self, key: &str, bytes: &[u8]) -> Result<bool> {
+        let written = self.remote.put_if_absent(key, bytes)?;
+        if written {
+            self.invalidate(key);
+        }
+        Ok(written)
+    }
+
+    fn version(&self, key: &str) -> Result<Option<String>> {
+        self.remote.version(key)
+    }
+
+    /// Served from a fresh local copy when there is one. Misses read the
+    /// range from the remote without caching the object.
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+        if self.fresh(key)? {
+            if let Ok(Some(range)) = self.local.get_range(key, offset, len) {
+                self.hits.fetch_add(1, Ordering::Relaxed);
+                return Ok(Some(range));
+            }
+            self.lock().remove(key);
+        }
+        self.misses.fetch_add(1, Ordering::Relaxed);
+        self.remote.get_range(key, offset, len)
+    }
+
+    fn put_many(&self, items: &[(&str, &[u8])]) -> Result<()> {
+        self.remote.put_many(items)?;
+        for (key, _) in items {
+            self.invalidate(key);
+        }
+        Ok(())
+    }
+
+    fn delete_many(&self, keys: &[&str]) -> Result<()> {
+        self.remote.delete_many(keys)?;
+        for key in keys {
+            self.invalidate(key);
+        }
+        Ok(())
+    }
+
+    fn list_paginated(
+        &self,
+        prefix: &str,
+        after: Option<&str>,
+        limit: usize,
+    ) -> Result<(Vec<String>, Option<String>)> {
+        self.remote.list_paginated(prefix, after, limit)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::store::{CasStore, MemStore};
+
+    /// A versioned remote (content hashes) plus a handle to write behind the
+    /// cache's back.
+    fn versioned() -> (CasStore, CachedStore) {
+        let remote = CasStore::new(Arc::new(MemStore::new()));
+        let cache = CachedStore::new(
+            Arc::new(remote.clone()),
+            Arc::new(MemStore::new()),
+            CacheConfig::default(),
+        );
+        (remote, cache)
+    }
+
+    #[test]
+    fn cached_store_satisfies_contract() {
+        let (_, cache) = versioned();
+        crate::store::contract::run_contract(&cache);
+        let unversioned = CachedStore::new(
+            Arc::new(MemStore::new()),
+            Arc::new(MemStore::new()),
+            CacheConfig::default(),
+        );
+        crate::store::contract::run_contract(&unversioned);
+    }
+
+    #[test]
+    fn repeat_reads_hit_the_local_tier() {
+        let (remote, cache) = versioned();
+        remote.put("castle.schem", b"castle").unwrap();
+        assert_eq!(cache.get("castle.schem").unwrap(), Some(b"castle".to_vec()));
+        assert_eq!(cache.get("castle.schem").unwrap(), Some(b"castle".to_vec()));
+        assert_eq!(
+            cache.get_range("castle.schem", 1, 3).unwrap(),
+            Some(b"ast".to_vec())
+        );
+        let stats = cache.stats();
+        assert_eq!((stats.hits, stats.misses), (2, 1));
+        assert_eq!((stats.entries, stats.bytes), (1, 6));
+
+        // Writes through the cache drop the copy.
+        cache.put("castle.schem", b"keep").unwrap();
+        assert_eq!(cache.stats().entries, 0);
+        assert_eq!(cache.get("castle.schem").unwrap(), Some(b"keep".to_vec()));
+    }
+
+    #[test]
+    fn stale_copies_are_revalidated_against_the_remote() {
+        let remote = CasStore::new(Arc::new(MemStore::new()));
+        let cache = CachedStore::new(
+            Arc::new(remote.clone()),
+            Arc::new(MemStore::new()),
+            CacheConfig {
+                revalidate_after: Duration::ZERO,
+                ..CacheConfig::default()
+            },
+        );
+        remote.put("k", b"old").unwrap();
+        cache.get("k").unwrap();
+        assert_eq!(cache.get("k").unwrap(), Some(b"old".to_vec()));
+        assert_eq!(cache.stats().hits, 1);
+
+        remote.put("k", b"new").unwrap();
+        assert_eq!(cache.get("k").unwrap(), Some(b"new".to_vec()));
+        remote.delete("k").unwrap();
+        assert_eq!(cache.get("k").unwrap(), None);
+        let stats = cache.stats();
+        assert_eq!((stats.hits, stats.misses, stats.revalidations), (1, 3, 3));
+    }
+
+    #[test]
+    fn least_recently_used_copies_are_evicted() {
+        let remote = MemStore::new();
+        let local = MemStore::new();
+        let cache = CachedStore::new(
+            Arc::new(remote.clone()),
+            Arc::new(local.clone()),
+            CacheConfig {
+                max_bytes: 10,
+                ..CacheConfig::default()
+            },
+        );
+        remote.put("a", b"aaaa").unwrap();
+        remote.put("b", b"bbbb").unwrap();
+        remote.put("c", b"cccc").unwrap();
+        remote.put("huge", &[0u8; 11]).unwrap();
+        cache.get("a").unwrap();
+        cache.get("b").unwrap();
+        cache.get("a").unwrap();
+        cache.get("c").unwrap();
+        // `b` was least recently used; `huge` never fits.
+        cache.get("huge").unwrap();
+        let mut held = local.list("").unwrap();
+        held.sort();
+        assert_eq!(held, ["a", "c"]);
+        let stats = cache.stats();
+        assert_eq!((stats.evictions, stats.entries, stats.bytes), (1, 2, 8));
+    }
+}
@@ -0,0 +1,279 @@
+//! Content-addressed [`Store`] wrapper: each object is stored once, as a blob
+//! named by its blake3 hash, and every key is a small pointer record naming
+//! its blob. Saving a duplicate under a new key writes only the pointer.
+//!
+//! Layout inside the wrapped store:
+//! - `refs/<key>` holds `blake3:<hex>`, the hash of the key's current bytes.
+//! - `blobs/<hex[..2]>/<hex>` holds the bytes, written with
+//!   [`Store::put_if_absent`] after an `exists` check, so a blob that is
+//!   already present is never uploaded again.
+//!
+//! Deleting a key removes only its pointer; blobs may be shared. Reclaim
+//! unreferenced blobs with [`CasStore::collect_garbage`].
+
+use std::collections::HashSet;
+use std::io::Read;
+use std::sync::Arc;
+
+use super::{Result, Store, StoreError};
+
+const REFS: &str = "refs/";
+const BLOBS: &str = "blobs/";
+const POINTER_PREFIX: &str = "blake3:";
+
+/// A deduplicating store over `inner`. Cloning shares the inner store.
+#[derive(Clone)]
+pub struct CasStore {
+    inner: Arc<dyn Store>,
+}
+
+impl CasStore {
+    /// Wrap `inner`, keeping pointers under `refs/` and blobs under `blobs/`.
+    pub fn new(inner: Arc<dyn Store>) -> Self {
+        Self { inner }
+    }
+
+    /// The wrapped store.
+    pub fn inner(&self) -> &dyn Store {
+        self.inner.as_ref()
+    }
+
+    fn ref_key(key: &str) -> String {
+        format!("{REFS}{key}")
+    }
+
+    fn blob_key(hex: &str) -> String {
+        format!("{BLOBS}{}/{hex}", &hex[..2])
+    }
+
+    /// Write `bytes` as a blob unless it already exists, returning its
+    /// pointer record.
+    fn stash(&self, bytes: &[u8]) -> Result<String> {
+        let hex = blake3::hash(bytes).to_hex();
+        let blob = Self::blob_key(&hex);
+        if !self.inner.exists(&blob)? {
+            // Another writer may store the same blob meanwhile; either copy
+            // is the same bytes.
+            self.inner.put_if_absent(&blob, bytes)?;
+        }
+        Ok(format!("{POINTER_PREFIX}{hex}"))
+    }
+
+    /// The blob key a pointer record names.
+    fn resolve_pointer(key: &str, record: &[u8]) -> Result<String> {
+        std::str::from_utf8(record)
+            .ok()
+            .and_then(|r| r.strip_prefix(POINTER_PREFIX))
+            .filter(|hex| hex.len() == 64 && hex.bytes().all(|b| b.is_ascii_hexdigit()))
+            .map(Self::blob_key)
+            .ok_or_else(|| StoreError::Other(format!("corrupt pointer record for {key:?}")))
+    }
+
+    /// The blob key behind `key`, or `None` if the key is absent.
+    fn blob_for(&self, key: &str) -> Result<Option<String>> {
+        self.inner
+            .get(&Self::ref_key(key))?
+            .map(|record| Self::resolve_pointer(key, &record))
+            .transpose()
+    }
+
+    fn dangling(key: &str) -> StoreError {
+        StoreError::Other(format!("pointer for {key:?} names a missing blob"))
+    }
+
+    /// Delete every blob no pointer names. Returns how many were removed.
+    ///
+    /// Not safe alongside writers: a concurrent `put` may reuse a blob after
+    /// it was found unreferenced. Run it while the library is quiescent.
+    pub fn collect_garbage(&self) -> Result<usize> {
+        let mut live = HashSet::new();
+        for ref_key in self.inner.list(REFS)? {
+            if let Some(record) = self.inner.get(&ref_key)? {
+                live.insert(Self::resolve_pointer(&ref_key[REFS.len()..], &record)?);
+            }
+        }
+        let dead: Vec<String> = self
+            .inner
+            .list(BLOBS)?
+            .into_iter()
+            .filter(|blob| !live.contains(blob))
+            .collect();
+        let dead_refs: Vec<&str> = dead.iter().map(String::as_str).collect();
+        self.inner.delete_many(&dead_refs)?;
+        Ok(dead.len())
+    }
+}
+
+impl Store for CasStore {
+    fn get(&self, key: &str) -> Result<Option<Vec<u8>>> {
+        match self.blob_for(key)? {
+            Some(blob) => self
+                .inner
+                .get(&blob)?
+                .map(Some)
+                .ok_or_else(|| Self::dangling(key)),
+            None => Ok(None),
+        }
+    }
+
+    fn put(&self, key: &str, bytes: &[u8]) -> Result<()> {
+        let pointer = self.stash(bytes)?;
+        self.inner.put(&Self::ref_key(key), pointer.as_bytes())
+    }
+
+    fn exists(&self, key: &str) -> Result<bool> {
+        self.inner.exists(&Self::ref_key(key))
+    }
+
+    /// The pointer record itself: the content hash changes with the bytes.
+    fn version(&self, key: &str) -> Result<Option<String>> {
+        Ok(self
+            .inner
+            .get(&Self::ref_key(key))?
+            .map(|record| String::from_utf8_lossy(&record).into_owned()))
+    }
+
+    fn delete(&self, key: &str) -> Result<()> {
+        self.inner.delete(&Self::ref_key(key))
+    }
+
+    fn list(&self, prefix: &str) -> Result<Vec<String>> {
+        Ok(self
+            .inner
+            .list(&Self::ref_key(prefix))?
+            .into_iter()
+            .map(|k| k[REFS.len()..].to_string())
+            .collect())
+    }
+
+    fn health(&self) -> Result<()> {
+        self.inner.health()
+    }
+
+    fn put_if_absent(&self, key: &str, bytes: &[u8]) -> Result<bool> {
+        let pointer = self.stash(bytes)?;
+        self.inner
+            .put_if_absent(&Self::ref_key(key), pointer.as_bytes())
+    }
+
+    fn list_paginated(
+        &self,
+        prefix: &str,
+        after: Option<&str>,
+        limit: usize,
+    ) -> Result<(Vec<String>, Option<String>)> {
+        let after = after.map(Self::ref_key);
+        let (page, next) =
+            self.inner
+                .list_paginated(&Self::ref_key(prefix), after.as_deref(), limit)?;
+        let strip = |k: String| k[REFS.len()..].to_string();
+        Ok((page.into_iter().map(strip).collect(), next.map(strip)))
+    }
+
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+        match self.blob_for(key)? {
+            Some(blob) => self
+                .inner
+                .get_range(&blob, offset, len)?
+                .map(Some)
+                .ok_or_else(|| Self::dangling(key)),
+            None => Ok(None),
+        }
+    }
+
+    /// Two batched round-trips: every pointer, then every blob.
+    fn get_many(&self, keys: &[&str]) -> Result<Vec<Option<Vec<u8>>>> {
+        let refs: Vec<String> = keys.iter().map(|k| Self::ref_key(k)).collect();
+        let refs: Vec<&str> = refs.iter().map(String::as_str).collect();
+        let blobs = keys
+            .iter()
+            .zip(self.inner.get_many(&refs)?)
+            .map(|(key, record)| {
+                record
+                    .map(|record| Self::resolve_pointer(key, &record))
+                    .transpose()
+            })
+            .collect::<Result<Vec<Option<String>>>>()?;
+        let wanted: Vec<&str> = blobs.iter().flatten().map(String::as_str).collect();
+        let mut fetched = self.inner.get_many(&wanted)?.into_iter();
+        keys.iter()
+            .zip(&blobs)
+            .map(|(key, blob)| match blob {
+                Some(_) => fetched
+                    .next()
+                    .flatten()
+                    .map(Some)
+                    .ok_or_else(|| Self::dangling(key)),
+                None => Ok(None),
+            })
+            .collect()
+    }
+
+    fn exists_many(&self, keys: &[&str]) -> Result<Vec<bool>> {
+        let refs: Vec<String> = keys.iter().map(|k| Self::ref_key(k)).collect();
+        let refs: Vec<&str> = refs.iter().map(String::as_str).collect();
+        self.inner.exists_many(&refs)
+    }
+
+    fn delete_many(&self, keys: &[&str]) -> Result<()> {
+        let refs: Vec<String> = keys.iter().map(|k| Self::ref_key(k)).collect();
+        let refs: Vec<&str> = refs.iter().map(String::as_str).collect();
+        self.inner.delete_many(&refs)
+    }
+
+    fn reader(&self, key: &str) -> Result<Box<dyn Read + '_>> {
+        match self.blob_for(key)? {
+            Some(blob) => self.inner.reader(&blob),
+            None => Err(StoreError::NotFound(key.to_string())),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::store::MemStore;
+
+    #[test]
+    fn cas_store_satisfies_contract() {
+        crate::store::contract::run_contract(&CasStore::new(Arc::new(MemStore::new())));
+    }
+
+    #[test]
+    fn duplicates_share_one_blob() {
+        let inner = MemStore::new();
+        let cas = CasStore::new(Arc::new(inner.clone()));
+        cas.put("builds/a.schem", b"castle").unwrap();
+        cas.put("mirror/b.schem", b"castle").unwrap();
+        cas.put("builds/c.schem", b"tower").unwrap();
+        assert_eq!(inner.list(BLOBS).unwrap().len(), 2);
+        assert_eq!(cas.get("mirror/b.schem").unwrap(), Some(b"castle".to_vec()));
+
+        let mut keys = cas.list("builds/").unwrap();
+        keys.sort();
+        assert_eq!(keys, ["builds/a.schem", "builds/c.schem"]);
+
+        // Deleting one key keeps the shared blob; garbage collection frees a
+        // blob only once nothing points at it.
+        cas.delete("builds/a.schem").unwrap();
+        assert_eq!(cas.collect_garbage().unwrap(), 0);
+        cas.delete("mirror/b.schem").unwrap();
+        assert_eq!(cas.collect_garbage().unwrap(), 1);
+        assert_eq!(cas.get("builds/c.schem").unwrap(), Some(b"tower".to_vec()));
+    }
+
+    #[test]
+    fn corrupt_and_dangling_pointers_are_errors() {
+        let inner = MemStore::new();
+        let cas = CasStore::new(Arc::new(inner.clone()));
+        inner.put("refs/bad", b"not a pointer").unwrap();
+        assert!(cas.get("bad").is_err());
+
+        cas.put("gone", b"bytes").unwrap();
+        for blob in inner.list(BLOBS).unwrap() {
+            inner.delete(&blob).unwrap();
+        }
+        assert!(cas.get("gone").is_err());
+        assert!(cas.get_many(&["gone"]).is_err());
+    }
+}
@@ -7,7 +7,7 @@
 
 use std::io::{Read, Write};
 
-use super::{Store, StoreError};
+use super::{Result, Store, StoreError, StoreOp, StoreOutcome};
 
 /// Exercise the full `Store` contract against a fresh, empty `store`.
 ///
@@ -25,6 +25,10 @@ pub fn run_contract(store: &dyn Store) {
     writer_commits_on_flush(store);
     put_if_absent_is_atomic(store);
     list_paginated_walks_keyset(store);
+    batch_ops_match_single_key_ops(store);
+    submitted_ops_complete(store);
+    get_range_reads_a_slice(store);
+    version_tracks_rewrites(store);
 }
 
 fn health_reports_usable(store: &dyn Store) {
@@ -205,3 +209,153 @@ fn list_paginated_walks_keyset(store: &dyn Store) {
         store.delete(k).expect("cleanup");
     }
 }
+
+fn batch_ops_match_single_key_ops(store: &dyn Store) {
+    assert_eq!(store.get_many(&[]).expect("empty get_many"), Vec::new());
+    store.put_many(&[]).expect("empty put_many");
+    store.delete_many(&[]).expect("empty delete_many");
+
+    store
+        .put_many(&[("batch/a", b"1"), ("batch/b", b"2"), ("batch/a", b"3")])
+        .expect("put_many");
+    assert_eq!(
+        store.get("batch/a").expect("get"),
+        Some(b"3".to_vec()),
+        "the last pair for a repeated key wins"
+    );
+
+    let keys = ["batch/b", "batch/missing", "batch/a", "batch/b"];
+    assert_eq!(
+        store.get_many(&keys).expect("get_many"),
+        vec![
+            Some(b"2".to_vec()),
+            None,
+            Some(b"3".to_vec()),
+            Some(b"2".to_vec())
+        ],
+        "get_many answers in input order, repeats included"
+    );
+    assert_eq!(
+        store.exists_many(&keys).expect("exists_many"),
+        vec![true, false, true, true]
+    );
+
+    store
+        .delete_many(&["batch/a", "batch/missing"])
+        .expect("delete_many skips missing keys");
+    assert_eq!(
+        store
+            .exists_many(&["batch/a", "batch/b"])
+            .expect("exists_many"),
+        vec![false, true]
+    );
+    store.delete_many(&["batch/b"]).expect("cleanup");
+}
+
+fn submitted_ops_complete(store: &dyn Store) {
+    let submit = |op: StoreOp| -> Result<StoreOutcome> {
+        let (tx, rx) = std::sync::mpsc::channel();
+        store.submit(
+            op,
+            Box::new(move |result| {
+                let _ = tx.send(result);
+            }),
+        );
+        rx.recv_timeout(std::time::Duration::from_secs(30))
+            .expect("submit must call its completion")
+    };
+
+    let key = "contract/submit";
+    assert_eq!(
+        submit(StoreOp::Put(key.into(), b"async".to_vec())).expect("put"),
+        StoreOutcome::Done
+    );
+    assert_eq!(
+        submit(StoreOp::Get(key.into())).expect("get"),
+        StoreOutcome::Value(Some(b"async".to_vec()))
+    );
+    assert_eq!(
+        submit(StoreOp::Exists(key.into())).expect("exists"),
+        StoreOutcome::Exists(true)
+    );
+    assert_eq!(
+        submit(StoreOp::Delete(key.into())).expect("delete"),
+        StoreOutcome::Done
+    );
+    assert_eq!(
+        submit(StoreOp::Get(key.into())).expect("get after delete"),
+        StoreOutcome::Value(None)
+    );
+
+    // Many in flight at once, all completing.
+    let (tx, rx) = std::sync::mpsc::channel();
+    for i in 0..64 {
+        let tx = tx.clone();
+        store.submit(
+            StoreOp::Exists(format!("contract/submit-absent/{i}")),
+            Box::new(move |result| {
+                let _ = tx.send(result);
+            }),
+        );
+    }
+    drop(tx);
+    let answers: Vec<_> = rx.iter().collect();
+    assert_eq!(answers.len(), 64, "every submitted op must complete");
+    assert!(answers
+        .into_iter()
+        .all(|r| r.expect("exists") == StoreOutcome::Exists(false)));
+}
+
+fn get_range_reads_a_slice(store: &dyn Store) {
+    let key = "contract/range";
+    let data: Vec<u8> = (0..1000).map(|i| (i % 251) as u8).collect();
+    store.put(key, &data).expect("put");
+    assert_eq!(
+        store.get_range(key, 100, 50).expect("range"),
+        Some(data[100..150].to_vec())
+    );
+    assert_eq!(
+        store.get_range(key, 990, 50).expect("range past the end"),
+        Some(data[990..].to_vec()),
+        "a range running past the end is cut short"
+    );
+    assert_eq!(
+        store.get_range(key, 5000, 10).expect("offset past the end"),
+        Some(Vec::new())
+    );
+    assert_eq!(
+        store.get_range(key, 0, 0).expect("empty range"),
+        Some(Vec::new())
+    );
+    assert_eq!(
+        store
+            .get_range("contract/absent-range", 0, 10)
+            .expect("missing"),
+        None,
+        "get_range on a missing key must be Ok(None)"
+    );
+    store.delete(key).expect("cleanup");
+}
+
+fn version_tracks_rewrites(store: &dyn Store) {
+    let key = "contract/version";
+    let first = match store.version(key) {
+        Err(StoreError::Unsupported(_)) => return,
+        other => other.expect("version of a missing key"),
+    };
+    assert_eq!(first, None, "version of a missing key must be Ok(None)");
+    store.put(key, b"one").expect("put");
+    let one = store.version(key).expect("version").expect("present");
+    assert_eq!(
+        store.version(key).expect("version").as_deref(),
+        Some(one.as_str()),
+        "version must be stable while the object is unchanged"
+    );
+    store.put(key, b"second").expect("rewrite");
+    assert_ne!(
+        store.version(key).expect("version").as_deref(),
+        Some(one.as_str()),
+        "a rewrite must change the version"
+    );
+    store.delete(key).expect("cleanup");
+}
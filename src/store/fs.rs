@@ -1,6 +1,7 @@
 //! Filesystem-backed [`Store`], rooted at a directory. Keys map to paths under
 //! the root; path traversal (`..`) is rejected. Native targets only.
 
+use std::io::{Read, Seek, SeekFrom};
 use std::path::{Path, PathBuf};
 use std::sync::atomic::{AtomicU64, Ordering};
 
@@ -43,6 +44,93 @@ impl FsStore {
         }
         Ok(path)
     }
+
+    /// Up to `limit` keys under `prefix` and strictly after `after`, in
+    /// ascending order.
+    fn walk(&self, prefix: &str, after: Option<&str>, limit: usize) -> Result<Vec<String>> {
+        // Start in the deepest directory the prefix names in full. A
+        // component no key can contain means nothing matches.
+        let base = prefix.rfind('/').map_or("", |i| &prefix[..=i]);
+        let mut dir = self.root.clone();
+        for comp in base
+            .strip_suffix('/')
+            .into_iter()
+            .flat_map(|b| b.split('/'))
+        {
+            if comp.is_empty() || comp == "." || comp == ".." || comp.contains('\\') {
+                return Ok(Vec::new());
+            }
+            dir.push(comp);
+        }
+        let mut walk = Walk {
+            prefix,
+            after,
+            limit,
+            out: Vec::new(),
+        };
+        if limit > 0 && dir.is_dir() {
+            walk.visit(&dir, base)?;
+        }
+        Ok(walk.out)
+    }
+}
+
+/// A depth-first walk that yields keys in ascending order.
+///
+/// Sorting each directory by `name/` for subdirectories and `name` for files
+/// makes depth-first order match key order, since every key in a
+/// subdirectory shares its `name/` prefix. Subtrees outside `prefix` or
+/// wholly at or before `after` are never opened.
+struct Walk<'a> {
+    prefix: &'a str,
+    after: Option<&'a str>,
+    limit: usize,
+    out: Vec<String>,
+}
+
+impl Walk<'_> {
+    /// Visit `dir`, whose keys all start with `parent` (`""` or `a/b/`).
+    /// Returns `false` once `limit` keys are collected.
+    fn visit(&mut self, dir: &Path, parent: &str) -> Result<bool> {
+        let mut entries = Vec::new();
+        for entry in std::fs::read_dir(dir)? {
+            let entry = entry?;
+            let file_type = entry.file_type()?;
+            let name = entry.file_name();
+            let name = name
+                .to_str()
+                .ok_or_else(|| StoreError::InvalidKey("non-UTF-8 path".into()))?;
+            if file_type.is_dir() {
+                entries.push((format!("{parent}{name}/"), Some(entry.path())));
+            } else if file_type.is_file() && !name.starts_with(TMP_PREFIX) {
+                entries.push((format!("{parent}{name}"), None));
+            }
+        }
+        entries.sort_unstable_by(|a, b| a.0.cmp(&b.0));
+
+        for (key, subdir) in entries {
+            match subdir {
+                Some(path) => {
+                    let in_prefix = key.starts_with(self.prefix) || self.prefix.starts_with(&key);
+                    let not_before = self
+                        .after
+                        .is_none_or(|a| key.as_str() > a || a.starts_with(&key));
+                    if in_prefix && not_before && !self.visit(&path, &key)? {
+                        return Ok(false);
+                    }
+                }
+                None => {
+                    if key.starts_with(self.prefix) && self.after.is_none_or(|a| key.as_str() > a) {
+                        self.out.push(key);
+                        if self.out.len() >= self.limit {
+                            return Ok(false);
+                        }
+                    }
+                }
+            }
+        }
+        Ok(true)
+    }
 }
 
 impl Store for FsStore {
@@ -55,6 +143,19 @@ impl Store for FsStore {
         }
     }
 
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+        let path = self.path_for(key)?;
+        let mut file = match std::fs::File::open(&path) {
+            Ok(file) => file,
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => return Ok(None),
+            Err(e) => return Err(e.into()),
+        };
+        file.seek(SeekFrom::Start(offset))?;
+        let mut bytes = Vec::new();
+        file.take(len).read_to_end(&mut bytes)?;
+        Ok(Some(bytes))
+    }
+
     fn put(&self, key: &str, bytes: &[u8]) -> Result<()> {
         let path = self.path_for(key)?;
         let parent = path.parent().unwrap_or(&self.root);
@@ -77,6 +178,23 @@ impl Store for FsStore {
         Ok(self.path_for(key)?.is_file())
     }
 
+    /// Length and modification time; a rewrite renames a new file into
+    /// place, so either changing marks a new version.
+    fn version(&self, key: &str) -> Result<Option<String>> {
+        let meta = match std::fs::metadata(self.path_for(key)?) {
+            Ok(meta) if meta.is_file() => meta,
+            Ok(_) => return Ok(None),
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => return Ok(None),
+            Err(e) => return Err(e.into()),
+        };
+        let mtime = meta
+            .modified()?
+            .duration_since(std::time::UNIX_EPOCH)
+            .unwrap_or_default()
+            .as_nanos();
+        Ok(Some(format!("{}-{mtime}", meta.len())))
+    }
+
     fn put_if_absent(&self, key: &str, bytes: &[u8]) -> Result<bool> {
         use std::io::Write;
         let path = self.path_for(key)?;
@@ -106,55 +224,45 @@ impl Store for FsStore {
         }
     }
 
+    /// Walks only the directories that can hold keys under `prefix`; the
+    /// keys come back sorted.
     fn list(&self, prefix: &str) -> Result<Vec<String>> {
-        let mut out = Vec::new();
-        if self.root.is_dir() {
-            collect_keys(&self.root, &self.root, &mut out)?;
-        }
-        out.retain(|k| k.starts_with(prefix));
-        Ok(out)
+        self.walk(prefix, None, usize::MAX)
     }
 
     fn health(&self) -> Result<()> {
         std::fs::create_dir_all(&self.root)?;
         Ok(())
     }
-}
 
-/// Recursively collect `/`-joined keys for every file under `dir`, relative to
-/// `base`, skipping in-progress temp files.
-fn collect_keys(base: &Path, dir: &Path, out: &mut Vec<String>) -> Result<()> {
-    for entry in std::fs::read_dir(dir)? {
-        let entry = entry?;
-        let path = entry.path();
-        let file_type = entry.file_type()?;
-        if file_type.is_dir() {
-            collect_keys(base, &path, out)?;
-        } else if file_type.is_file() {
-            if let Some(name) = path.file_name().and_then(|n| n.to_str()) {
-                if name.starts_with(TMP_PREFIX) {
-                    continue;
-                }
-            }
-            let rel = path
-                .strip_prefix(base)
-                .map_err(|e| StoreError::Other(e.to_string()))?;
-            let mut key_parts = Vec::new();
-            for comp in rel.components() {
-                match comp {
-                    std::path::Component::Normal(os) => {
-                        let s = os
-                            .to_str()
-                            .ok_or_else(|| StoreError::InvalidKey("non-UTF-8 path".into()))?;
-                        key_parts.push(s);
-                    }
-                    _ => return Err(StoreError::Other("unexpected path component".into())),
-                }
+    /// A sorted walk that skips subtrees at or before `after` and stops after
+    /// `limit` keys, so a page reads only the directories it crosses.
+    fn list_paginated(
+        &self,
+        prefix: &str,
+        after: Option<&str>,
+        limit: usize,
+    ) -> Result<(Vec<String>, Option<String>)> {
+        let page = self.walk(prefix, after, limit)?;
+        let next = if limit > 0 && page.len() == limit {
+            page.last().cloned()
+        } else {
+            None
+        };
+        Ok((page, next))
+    }
+
+    /// Native streaming read: the open file itself.
+    fn reader(&self, key: &str) -> Result<Box<dyn Read + '_>> {
+        let path = self.path_for(key)?;
+        match std::fs::File::open(&path) {
+            Ok(file) => Ok(Box::new(file)),
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => {
+                Err(StoreError::NotFound(key.to_string()))
             }
-            out.push(key_parts.join("/"));
+            Err(e) => Err(e.into()),
         }
     }
-    Ok(())
 }
 
 #[cfg(test)]
@@ -172,4 +280,52 @@ mod tests {
         crate::store::contract::run_contract(&FsStore::new(&dir));
         let _ = std::fs::remove_dir_all(&dir);
     }
+
+    fn temp_root(tag: &str) -> PathBuf {
+        let dir =
+            std::env::temp_dir().join(format!("nucleation-fsstore-{tag}-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        dir
+    }
+
+    #[test]
+    fn walk_order_matches_key_order() {
+        let dir = temp_root("order");
+        let store = FsStore::new(&dir);
+        for key in ["a/x", "a.b", "a0", "a/b/c", "b", "a/b.c"] {
+            store.put(key, b"v").unwrap();
+        }
+        let mut expected = store.list("").unwrap();
+        expected.sort();
+        assert_eq!(store.list("").unwrap(), expected);
+        assert_eq!(store.list("a/b").unwrap(), ["a/b.c", "a/b/c"]);
+
+        let (page, next) = store.list_paginated("a", Some("a.b"), 2).unwrap();
+        assert_eq!(page, ["a/b.c", "a/b/c"]);
+        let (page, next) = store.list_paginated("a", next.as_deref(), 2).unwrap();
+        assert_eq!(page, ["a/x", "a0"]);
+        let (page, next) = store.list_paginated("a", next.as_deref(), 2).unwrap();
+        assert!(page.is_empty() && next.is_none());
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn listing_never_opens_directories_outside_the_prefix() {
+        use std::os::unix::ffi::OsStrExt;
+        let dir = temp_root("scoped");
+        let store = FsStore::new(&dir);
+        store.put("keep/a", b"v").unwrap();
+        store.put("other/b", b"v").unwrap();
+        // Walking into `other/` would fail on this name.
+        let bad = dir.join("other").join(std::ffi::OsStr::from_bytes(b"\xff"));
+        std::fs::write(bad, b"v").unwrap();
+
+        assert!(store.list("").is_err());
+        assert_eq!(store.list("keep/").unwrap(), ["keep/a"]);
+        assert_eq!(store.list("ke").unwrap(), ["keep/a"]);
+        let (page, _) = store.list_paginated("", None, 1).unwrap();
+        assert_eq!(page, ["keep/a"]);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
 }
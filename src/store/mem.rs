@@ -72,6 +72,27 @@ impl Store for MemStore {
             .collect())
     }
 
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+        Ok(self.read()?.get(key).map(|bytes| {
+            let start = offset.min(bytes.len() as u64) as usize;
+            let end = offset.saturating_add(len).min(bytes.len() as u64) as usize;
+            bytes[start..end].to_vec()
+        }))
+    }
+
+    fn get_many(&self, keys: &[&str]) -> Result<Vec<Option<Vec<u8>>>> {
+        let map = self.read()?;
+        Ok(keys.iter().map(|k| map.get(*k).cloned()).collect())
+    }
+
+    fn put_many(&self, items: &[(&str, &[u8])]) -> Result<()> {
+        let mut map = self.write()?;
+        for (k, v) in items {
+            map.insert(k.to_string(), v.to_vec());
+        }
+        Ok(())
+    }
+
     fn health(&self) -> Result<()> {
         // Reachable iff the lock isn't poisoned.
         self.read().map(|_| ())
@@ -24,6 +24,23 @@ pub use error::StoreError;
 pub mod mem;
 pub use mem::MemStore;
 
+pub mod cas;
+pub use cas::CasStore;
+
+#[cfg(not(target_arch = "wasm32"))]
+pub mod cached;
+#[cfg(not(target_arch = "wasm32"))]
+pub use cached::{CacheConfig, CacheStats, CachedStore};
+
+mod op;
+pub use op::{Completion, StoreOp, StoreOutcome};
+
+mod range;
+pub use range::RangeReader;
+
+mod traced;
+pub use traced::TracedStore;
+
 #[cfg(all(feature = "store-fs", not(target_arch = "wasm32")))]
 pub mod fs;
 #[cfg(all(feature = "store-fs", not(target_arch = "wasm32")))]
@@ -49,6 +66,11 @@ pub mod pg;
 #[cfg(feature = "store-pg")]
 pub use pg::{PgConfig, PgStore};
 
+#[cfg(not(target_arch = "wasm32"))]
+mod pool;
+#[cfg(not(target_arch = "wasm32"))]
+pub use pool::{evict, open_shared, HEALTH_INTERVAL};
+
 /// Backend-agnostic behavioural contract suite. Public when `store-testkit` is
 /// enabled so integration tests (e.g. testcontainers) can exercise any backend.
 #[cfg(any(test, feature = "store-testkit"))]
@@ -102,6 +124,60 @@ pub trait Store: Send + Sync {
         }
     }
 
+    /// Up to `len` bytes of `key` starting at byte `offset`, or `None` if the
+    /// key is absent. A range running past the end of the object is cut
+    /// short, so an `offset` at or beyond the end yields an empty vec.
+    ///
+    /// The default fetches the whole object and slices it. S3 (`Range`),
+    /// the filesystem (seek), Redis (`GETRANGE`) and Postgres (`substring`)
+    /// transfer only the range.
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+        Ok(self.get(key)?.map(|bytes| {
+            let start = offset.min(bytes.len() as u64) as usize;
+            let end = offset.saturating_add(len).min(bytes.len() as u64) as usize;
+            bytes[start..end].to_vec()
+        }))
+    }
+
+    /// An opaque tag that changes whenever the object at `key` is rewritten,
+    /// or `None` if the key is absent. Lets a cache revalidate its copy
+    /// without refetching the bytes.
+    ///
+    /// The default is [`StoreError::Unsupported`]. S3 returns the object's
+    /// ETag, the filesystem its length and mtime, and [`CasStore`] the
+    /// content hash.
+    fn version(&self, key: &str) -> Result<Option<String>> {
+        let _ = key;
+        Err(StoreError::Unsupported("object versions".into()))
+    }
+
+    /// Fetch every key in `keys`, in order: `out[i]` is `get(keys[i])`.
+    ///
+    /// The default issues one [`Store::get`] per key. Networked backends
+    /// override it to cut round-trips (Redis `MGET`, Postgres `= ANY($1)`,
+    /// concurrent S3 `GET`s).
+    fn get_many(&self, keys: &[&str]) -> Result<Vec<Option<Vec<u8>>>> {
+        keys.iter().map(|k| self.get(k)).collect()
+    }
+
+    /// Store every `(key, bytes)` pair. When a key repeats, the last pair
+    /// wins. Not atomic: on error some pairs may already be written.
+    fn put_many(&self, items: &[(&str, &[u8])]) -> Result<()> {
+        items.iter().try_for_each(|(k, v)| self.put(k, v))
+    }
+
+    /// Presence of every key in `keys`, in order: `out[i]` is
+    /// `exists(keys[i])`.
+    fn exists_many(&self, keys: &[&str]) -> Result<Vec<bool>> {
+        keys.iter().map(|k| self.exists(k)).collect()
+    }
+
+    /// Remove every key in `keys`; missing keys are skipped, as with
+    /// [`Store::delete`].
+    fn delete_many(&self, keys: &[&str]) -> Result<()> {
+        keys.iter().try_for_each(|k| self.delete(k))
+    }
+
     /// A keyset page of keys under `prefix`, sorted ascending, starting strictly
     /// after `after` (exclusive), at most `limit` keys. Returns the page plus a
     /// cursor to pass as the next `after` when more keys may remain (`None` once
@@ -130,6 +206,15 @@ pub trait Store: Send + Sync {
         Ok((page, next))
     }
 
+    /// Start `op` without waiting for it; `done` receives its result.
+    ///
+    /// The default runs `op` inline and calls `done` before returning. The
+    /// async-SDK backends override it to spawn `op` on their runtime and
+    /// return at once, so a caller can keep many operations in flight.
+    fn submit(&self, op: StoreOp, done: Completion) {
+        done(op.run_blocking(self));
+    }
+
     /// Streaming read of `key`. The default buffers via [`Store::get`];
     /// backends with native streaming may override.
     fn reader(&self, key: &str) -> Result<Box<dyn Read + '_>> {
@@ -239,16 +324,51 @@ mod block_on_tests {
     }
 }
 
-/// Construct a store from a URL/DSN.
+/// Construct a store from a URL/DSN. Each call connects afresh; use
+/// [`open_shared`] to reuse one connection per URL.
 ///
 /// Supported schemes depend on enabled features:
 /// `mem://`, `file:///abs/path` (with `store-fs`), and — once their features
-/// are enabled — `s3://`, `redis://`, `postgres://`.
+/// are enabled — `s3://`, `redis://`, `postgres://`. `cas://<url>` wraps the
+/// store at `<url>` in a deduplicating [`CasStore`], e.g.
+/// `cas://s3://bucket/library`. `cache+<url>` puts a read-through
+/// [`CachedStore`] in front of it, e.g. `cache+s3://bucket/library`: the local
+/// tier is an [`FsStore`] under `NUC_STORE_CACHE_DIR` when that is set (with
+/// `store-fs`), otherwise memory, bounded by `NUC_STORE_CACHE_BYTES`.
+///
+/// The store comes back inside a [`TracedStore`], so its reads and writes
+/// show up as `store.*` spans and metrics.
 pub fn open(url: &str) -> Result<Box<dyn Store>> {
+    Ok(Box::new(TracedStore::new(open_backend(url)?)))
+}
+
+fn open_backend(url: &str) -> Result<Box<dyn Store>> {
     if url == "mem://" || url.starts_with("mem://") {
         return Ok(Box::new(MemStore::new()));
     }
 
+    if let Some(inner) = url.strip_prefix("cas://") {
+        return Ok(Box::new(CasStore::new(open_backend(inner)?.into())));
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    if let Some(inner) = url.strip_prefix("cache+") {
+        let remote: std::sync::Arc<dyn Store> = open_backend(inner)?.into();
+        let local: std::sync::Arc<dyn Store> = match std::env::var("NUC_STORE_CACHE_DIR") {
+            #[cfg(feature = "store-fs")]
+            Ok(dir) => std::sync::Arc::new(FsStore::new(dir)),
+            _ => std::sync::Arc::new(MemStore::new()),
+        };
+        let mut config = CacheConfig::default();
+        if let Some(max) = std::env::var("NUC_STORE_CACHE_BYTES")
+            .ok()
+            .and_then(|v| v.parse().ok())
+        {
+            config.max_bytes = max;
+        }
+        return Ok(Box::new(CachedStore::new(remote, local, config)));
+    }
+
     #[cfg(all(feature = "store-fs", not(target_arch = "wasm32")))]
     if let Some(path) = url.strip_prefix("file://") {
         return Ok(Box::new(FsStore::new(path)));
@@ -295,6 +415,13 @@ pub fn open(url: &str) -> Result<Box<dyn Store>> {
     )))
 }
 
+/// [`open`] as a shareable handle. Only `mem://` stores exist on wasm, and
+/// each open is a fresh store, so there is nothing to cache.
+#[cfg(target_arch = "wasm32")]
+pub fn open_shared(url: &str) -> Result<std::sync::Arc<dyn Store>> {
+    open(url).map(std::sync::Arc::from)
+}
+
 #[cfg(test)]
 mod open_tests {
     use super::*;
@@ -306,6 +433,30 @@ mod open_tests {
         assert_eq!(store.get("k").expect("get"), Some(b"v".to_vec()));
     }
 
+    #[test]
+    fn cas_scheme_wraps_the_inner_store() {
+        let store = open("cas://mem://").expect("open cas");
+        store.put("a", b"same").expect("put");
+        store.put("b", b"same").expect("put");
+        assert_eq!(store.get("b").expect("get"), Some(b"same".to_vec()));
+        assert!(matches!(
+            open("cas://ftp://host"),
+            Err(StoreError::Unsupported(_))
+        ));
+    }
+
+    #[test]
+    fn cache_scheme_wraps_the_remote_store() {
+        let store = open("cache+cas://mem://").expect("open cache");
+        store.put("a", b"v").expect("put");
+        assert_eq!(store.get("a").expect("get"), Some(b"v".to_vec()));
+        assert_eq!(store.get("a").expect("get"), Some(b"v".to_vec()));
+        assert!(matches!(
+            open("cache+ftp://host"),
+            Err(StoreError::Unsupported(_))
+        ));
+    }
+
     #[test]
     fn unknown_scheme_is_unsupported() {
         match open("ftp://host/path") {
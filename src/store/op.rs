@@ -0,0 +1,61 @@
+//! Non-blocking submission for [`Store`]: [`Store::submit`] queues one
+//! [`StoreOp`] and reports its [`StoreOutcome`] through a [`Completion`]
+//! instead of returning it.
+//!
+//! The async-SDK backends (S3 / Redis / Postgres) run submitted operations as
+//! tasks on their own runtime, so any number can be in flight without a
+//! thread parked per operation. Every other backend completes inline, before
+//! `submit` returns.
+
+use super::{Result, Store};
+
+/// One single-key store operation, owned so it can outlive the submitting
+/// call.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub enum StoreOp {
+    /// [`Store::get`].
+    Get(String),
+    /// [`Store::put`].
+    Put(String, Vec<u8>),
+    /// [`Store::exists`].
+    Exists(String),
+    /// [`Store::delete`].
+    Delete(String),
+}
+
+/// What a [`StoreOp`] produced.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub enum StoreOutcome {
+    /// The object read by [`StoreOp::Get`], or `None` if absent.
+    Value(Option<Vec<u8>>),
+    /// The answer to [`StoreOp::Exists`].
+    Exists(bool),
+    /// [`StoreOp::Put`] or [`StoreOp::Delete`] finished.
+    Done,
+}
+
+/// Receives the result of a submitted operation. Called exactly once, unless
+/// the backend shuts down first, in which case it is dropped uncalled. For
+/// runtime-backed stores it runs on a runtime worker thread, so it must not
+/// block.
+pub type Completion = Box<dyn FnOnce(Result<StoreOutcome>) + Send>;
+
+impl StoreOp {
+    /// The key this operation targets.
+    pub fn key(&self) -> &str {
+        match self {
+            StoreOp::Get(k) | StoreOp::Put(k, _) | StoreOp::Exists(k) | StoreOp::Delete(k) => k,
+        }
+    }
+
+    /// Run the operation through `store`'s blocking methods. The default
+    /// [`Store::submit`] is exactly this, completed inline.
+    pub fn run_blocking<S: Store + ?Sized>(&self, store: &S) -> Result<StoreOutcome> {
+        match self {
+            StoreOp::Get(k) => store.get(k).map(StoreOutcome::Value),
+            StoreOp::Put(k, v) => store.put(k, v).map(|()| StoreOutcome::Done),
+            StoreOp::Exists(k) => store.exists(k).map(StoreOutcome::Exists),
+            StoreOp::Delete(k) => store.delete(k).map(|()| StoreOutcome::Done),
+        }
+    }
+}
@@ -2,12 +2,13 @@
 //! (`key TEXT PRIMARY KEY, data BYTEA`). Wraps async `tokio-postgres` with an
 //! internal tokio runtime so the public surface stays synchronous.
 
+use std::collections::{HashMap, HashSet};
 use std::sync::Arc;
 
 use tokio::runtime::Runtime;
 use tokio_postgres::{Client, NoTls};
 
-use super::{Result, Store, StoreError};
+use super::{Completion, Result, Store, StoreError, StoreOp, StoreOutcome};
 
 /// Connection settings for a [`PgStore`].
 #[derive(Clone, Debug)]
@@ -89,70 +90,159 @@ impl PgStore {
     }
 }
 
+async fn fetch(client: &Client, table: &str, full: &str) -> Result<Option<Vec<u8>>> {
+    let sql = format!("SELECT data FROM {table} WHERE key = $1");
+    let row = client
+        .query_opt(&sql, &[&full])
+        .await
+        .map_err(|e| StoreError::Connection(e.to_string()))?;
+    Ok(row.map(|r| r.get::<_, Vec<u8>>(0)))
+}
+
+async fn upsert(client: &Client, table: &str, full: &str, bytes: &[u8]) -> Result<()> {
+    let sql = format!(
+        "INSERT INTO {table} (key, data) VALUES ($1, $2) \
+         ON CONFLICT (key) DO UPDATE SET data = EXCLUDED.data"
+    );
+    client
+        .execute(&sql, &[&full, &bytes])
+        .await
+        .map(|_| ())
+        .map_err(|e| StoreError::Connection(e.to_string()))
+}
+
+async fn has_row(client: &Client, table: &str, full: &str) -> Result<bool> {
+    let sql = format!("SELECT 1 FROM {table} WHERE key = $1");
+    let row = client
+        .query_opt(&sql, &[&full])
+        .await
+        .map_err(|e| StoreError::Connection(e.to_string()))?;
+    Ok(row.is_some())
+}
+
+async fn remove(client: &Client, table: &str, full: &str) -> Result<()> {
+    let sql = format!("DELETE FROM {table} WHERE key = $1");
+    client
+        .execute(&sql, &[&full])
+        .await
+        .map(|_| ())
+        .map_err(|e| StoreError::Connection(e.to_string()))
+}
+
 impl Store for PgStore {
     fn get(&self, key: &str) -> Result<Option<Vec<u8>>> {
         let full = self.full(key);
-        let sql = format!("SELECT data FROM {} WHERE key = $1", self.table);
-        crate::store::block_on(&self.rt, async {
-            let row = self
-                .client
-                .query_opt(&sql, &[&full])
-                .await
-                .map_err(|e| StoreError::Connection(e.to_string()))?;
-            Ok(row.map(|r| r.get::<_, Vec<u8>>(0)))
-        })
+        crate::store::block_on(&self.rt, fetch(&self.client, &self.table, &full))
     }
 
     fn put(&self, key: &str, bytes: &[u8]) -> Result<()> {
+        let full = self.full(key);
+        crate::store::block_on(&self.rt, upsert(&self.client, &self.table, &full, bytes))
+    }
+
+    fn exists(&self, key: &str) -> Result<bool> {
+        let full = self.full(key);
+        crate::store::block_on(&self.rt, has_row(&self.client, &self.table, &full))
+    }
+
+    fn put_if_absent(&self, key: &str, bytes: &[u8]) -> Result<bool> {
         let full = self.full(key);
         let data = bytes.to_vec();
         let sql = format!(
-            "INSERT INTO {} (key, data) VALUES ($1, $2) \
-             ON CONFLICT (key) DO UPDATE SET data = EXCLUDED.data",
+            "INSERT INTO {} (key, data) VALUES ($1, $2) ON CONFLICT (key) DO NOTHING",
             self.table
         );
         crate::store::block_on(&self.rt, async {
-            self.client
+            let n = self
+                .client
                 .execute(&sql, &[&full, &data])
                 .await
-                .map(|_| ())
-                .map_err(|e| StoreError::Connection(e.to_string()))
+                .map_err(|e| StoreError::Connection(e.to_string()))?;
+            Ok(n == 1) // 1 row inserted = written; 0 = key already existed
         })
     }
 
-    fn exists(&self, key: &str) -> Result<bool> {
+    fn delete(&self, key: &str) -> Result<()> {
+        let full = self.full(key);
+        crate::store::block_on(&self.rt, remove(&self.client, &self.table, &full))
+    }
+
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
         let full = self.full(key);
-        let sql = format!("SELECT 1 FROM {} WHERE key = $1", self.table);
+        // `substring` is 1-based and takes `int`; bytea values never exceed
+        // 1 GiB, so clamping keeps every in-bounds range exact.
+        let from = i32::try_from(offset.saturating_add(1)).unwrap_or(i32::MAX);
+        let count = i32::try_from(len).unwrap_or(i32::MAX);
+        let sql = format!(
+            "SELECT substring(data FROM $2 FOR $3) FROM {} WHERE key = $1",
+            self.table
+        );
         crate::store::block_on(&self.rt, async {
             let row = self
                 .client
-                .query_opt(&sql, &[&full])
+                .query_opt(&sql, &[&full, &from, &count])
                 .await
                 .map_err(|e| StoreError::Connection(e.to_string()))?;
-            Ok(row.is_some())
+            Ok(row.map(|r| r.get::<_, Vec<u8>>(0)))
         })
     }
 
-    fn put_if_absent(&self, key: &str, bytes: &[u8]) -> Result<bool> {
-        let full = self.full(key);
-        let data = bytes.to_vec();
+    fn get_many(&self, keys: &[&str]) -> Result<Vec<Option<Vec<u8>>>> {
+        let full: Vec<String> = keys.iter().map(|k| self.full(k)).collect();
+        let sql = format!("SELECT key, data FROM {} WHERE key = ANY($1)", self.table);
+        crate::store::block_on(&self.rt, async {
+            let rows = self
+                .client
+                .query(&sql, &[&full])
+                .await
+                .map_err(|e| StoreError::Connection(e.to_string()))?;
+            let found: HashMap<String, Vec<u8>> = rows
+                .into_iter()
+                .map(|r| (r.get::<_, String>(0), r.get::<_, Vec<u8>>(1)))
+                .collect();
+            Ok(full.iter().map(|k| found.get(k).cloned()).collect())
+        })
+    }
+
+    fn put_many(&self, items: &[(&str, &[u8])]) -> Result<()> {
+        // `ON CONFLICT DO UPDATE` rejects a key twice in one statement, so keep
+        // only the last pair per key.
+        let mut last: HashMap<String, &[u8]> = HashMap::with_capacity(items.len());
+        for (k, v) in items {
+            last.insert(self.full(k), *v);
+        }
+        let (keys, data): (Vec<String>, Vec<&[u8]>) = last.into_iter().unzip();
         let sql = format!(
-            "INSERT INTO {} (key, data) VALUES ($1, $2) ON CONFLICT (key) DO NOTHING",
+            "INSERT INTO {} (key, data) SELECT * FROM UNNEST($1::text[], $2::bytea[]) \
+             ON CONFLICT (key) DO UPDATE SET data = EXCLUDED.data",
             self.table
         );
         crate::store::block_on(&self.rt, async {
-            let n = self
+            self.client
+                .execute(&sql, &[&keys, &data])
+                .await
+                .map(|_| ())
+                .map_err(|e| StoreError::Connection(e.to_string()))
+        })
+    }
+
+    fn exists_many(&self, keys: &[&str]) -> Result<Vec<bool>> {
+        let full: Vec<String> = keys.iter().map(|k| self.full(k)).collect();
+        let sql = format!("SELECT key FROM {} WHERE key = ANY($1)", self.table);
+        crate::store::block_on(&self.rt, async {
+            let rows = self
                 .client
-                .execute(&sql, &[&full, &data])
+                .query(&sql, &[&full])
                 .await
                 .map_err(|e| StoreError::Connection(e.to_string()))?;
-            Ok(n == 1) // 1 row inserted = written; 0 = key already existed
+            let found: HashSet<String> = rows.iter().map(|r| r.get::<_, String>(0)).collect();
+            Ok(full.iter().map(|k| found.contains(k)).collect())
         })
     }
 
-    fn delete(&self, key: &str) -> Result<()> {
-        let full = self.full(key);
-        let sql = format!("DELETE FROM {} WHERE key = $1", self.table);
+    fn delete_many(&self, keys: &[&str]) -> Result<()> {
+        let full: Vec<String> = keys.iter().map(|k| self.full(k)).collect();
+        let sql = format!("DELETE FROM {} WHERE key = ANY($1)", self.table);
         crate::store::block_on(&self.rt, async {
             self.client
                 .execute(&sql, &[&full])
@@ -218,6 +308,31 @@ impl Store for PgStore {
         })
     }
 
+    /// Spawns `op` on the store's runtime and returns at once. Submitted
+    /// statements pipeline over the one client connection.
+    fn submit(&self, op: StoreOp, done: Completion) {
+        // The task owns a client handle, never the runtime: a task that
+        // dropped the last runtime handle would shut it down from inside.
+        let client = Arc::clone(&self.client);
+        let table = self.table.clone();
+        let full = self.full(op.key());
+        self.rt.spawn(async move {
+            let result = match op {
+                StoreOp::Get(_) => fetch(&client, &table, &full).await.map(StoreOutcome::Value),
+                StoreOp::Put(_, bytes) => upsert(&client, &table, &full, &bytes)
+                    .await
+                    .map(|()| StoreOutcome::Done),
+                StoreOp::Exists(_) => has_row(&client, &table, &full)
+                    .await
+                    .map(StoreOutcome::Exists),
+                StoreOp::Delete(_) => remove(&client, &table, &full)
+                    .await
+                    .map(|()| StoreOutcome::Done),
+            };
+            done(result);
+        });
+    }
+
     fn health(&self) -> Result<()> {
         crate::store::block_on(&self.rt, self.client.execute("SELECT 1", &[]))
             .map(|_| ())
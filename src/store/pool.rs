@@ -0,0 +1,202 @@
+//! A process-wide cache of opened stores, keyed by URL, so repeated opens of
+//! one bucket or DSN share a single connection (and, for the async-SDK
+//! backends, a single runtime and client) instead of building a new one per
+//! call.
+//!
+//! A cached store is health-checked when it is handed out and its last check
+//! is older than [`HEALTH_INTERVAL`]. A store that fails the check is
+//! dropped and reconnected. Connecting holds only that URL's slot, so a slow
+//! connect never blocks opens of other URLs.
+
+use std::collections::HashMap;
+use std::sync::{Arc, Mutex, OnceLock};
+use std::time::{Duration, Instant};
+
+use super::{open, Result, Store};
+
+/// How long a cached store is handed out without a fresh health check.
+pub const HEALTH_INTERVAL: Duration = Duration::from_secs(30);
+
+struct Cached {
+    store: Arc<dyn Store>,
+    checked: Instant,
+}
+
+/// One URL's entry. Its lock is held while connecting or health-checking.
+type Slot = Arc<Mutex<Option<Cached>>>;
+
+static POOL: OnceLock<Mutex<HashMap<String, Slot>>> = OnceLock::new();
+
+fn pool() -> &'static Mutex<HashMap<String, Slot>> {
+    POOL.get_or_init(|| Mutex::new(HashMap::new()))
+}
+
+/// [`open`], sharing one store per URL across the process.
+///
+/// `mem://` (bare or under `cas://` / `cache+`) is never cached: each open is
+/// a fresh, empty store, as with [`open`].
+pub fn open_shared(url: &str) -> Result<Arc<dyn Store>> {
+    if is_ephemeral(url) {
+        return open(url).map(Arc::from);
+    }
+    checkout(url, HEALTH_INTERVAL, || open(url).map(Arc::from))
+}
+
+/// Whether `url` names a `mem://` store once its wrappers are peeled off.
+fn is_ephemeral(mut url: &str) -> bool {
+    while let Some(inner) = url
+        .strip_prefix("cas://")
+        .or_else(|| url.strip_prefix("cache+"))
+    {
+        url = inner;
+    }
+    url.starts_with("mem://")
+}
+
+/// Drop the cached store for `url`, if any. The next [`open_shared`]
+/// reconnects; handles already given out keep working. Returns whether a
+/// store was cached.
+pub fn evict(url: &str) -> bool {
+    let slot = pool().lock().unwrap_or_else(|e| e.into_inner()).remove(url);
+    slot.is_some_and(|slot| slot.lock().unwrap_or_else(|e| e.into_inner()).is_some())
+}
+
+fn checkout(
+    key: &str,
+    interval: Duration,
+    connect: impl FnOnce() -> Result<Arc<dyn Store>>,
+) -> Result<Arc<dyn Store>> {
+    let slot = pool()
+        .lock()
+        .unwrap_or_else(|e| e.into_inner())
+        .entry(key.to_string())
+        .or_default()
+        .clone();
+    let mut cached = slot.lock().unwrap_or_else(|e| e.into_inner());
+
+    if let Some(entry) = cached.as_mut() {
+        if entry.checked.elapsed() < interval {
+            return Ok(entry.store.clone());
+        }
+        if entry.store.health().is_ok() {
+            entry.checked = Instant::now();
+            return Ok(entry.store.clone());
+        }
+        *cached = None;
+    }
+
+    // A failed connect leaves the slot empty, so the next call retries.
+    let store = connect()?;
+    *cached = Some(Cached {
+        store: store.clone(),
+        checked: Instant::now(),
+    });
+    Ok(store)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::store::{MemStore, StoreError};
+    use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+
+    /// A MemStore whose health check fails while `down` is set.
+    struct Flaky {
+        inner: MemStore,
+        down: Arc<AtomicBool>,
+    }
+
+    impl Store for Flaky {
+        fn get(&self, key: &str) -> Result<Option<Vec<u8>>> {
+            self.inner.get(key)
+        }
+        fn put(&self, key: &str, bytes: &[u8]) -> Result<()> {
+            self.inner.put(key, bytes)
+        }
+        fn exists(&self, key: &str) -> Result<bool> {
+            self.inner.exists(key)
+        }
+        fn delete(&self, key: &str) -> Result<()> {
+            self.inner.delete(key)
+        }
+        fn list(&self, prefix: &str) -> Result<Vec<String>> {
+            self.inner.list(prefix)
+        }
+        fn health(&self) -> Result<()> {
+            if self.down.load(Ordering::SeqCst) {
+                Err(StoreError::Connection("down".into()))
+            } else {
+                Ok(())
+            }
+        }
+    }
+
+    #[test]
+    fn reuses_healthy_stores_and_reconnects_unhealthy_ones() {
+        let key = "test://pool/health";
+        let down = Arc::new(AtomicBool::new(false));
+        let connects = AtomicUsize::new(0);
+        let connect = || {
+            connects.fetch_add(1, Ordering::SeqCst);
+            Ok(Arc::new(Flaky {
+                inner: MemStore::new(),
+                down: down.clone(),
+            }) as Arc<dyn Store>)
+        };
+
+        let first = checkout(key, Duration::ZERO, connect).unwrap();
+        first.put("k", b"v").unwrap();
+        let again = checkout(key, Duration::ZERO, connect).unwrap();
+        assert!(Arc::ptr_eq(&first, &again));
+        assert_eq!(connects.load(Ordering::SeqCst), 1);
+
+        down.store(true, Ordering::SeqCst);
+        // Within the interval the cached store is handed out unchecked.
+        let unchecked = checkout(key, Duration::from_secs(3600), connect).unwrap();
+        assert!(Arc::ptr_eq(&first, &unchecked));
+        let replaced = checkout(key, Duration::ZERO, connect).unwrap();
+        assert!(!Arc::ptr_eq(&first, &replaced));
+        assert_eq!(connects.load(Ordering::SeqCst), 2);
+        assert_eq!(replaced.get("k").unwrap(), None);
+
+        assert!(evict(key));
+        assert!(!evict(key));
+    }
+
+    #[test]
+    fn failed_connects_are_not_cached() {
+        let key = "test://pool/failing";
+        let failed = checkout(key, HEALTH_INTERVAL, || {
+            Err(StoreError::Connection("refused".into()))
+        });
+        assert!(failed.is_err());
+        let store = checkout(key, HEALTH_INTERVAL, || {
+            Ok(Arc::new(MemStore::new()) as Arc<dyn Store>)
+        })
+        .unwrap();
+        store.put("k", b"v").unwrap();
+        evict(key);
+    }
+
+    #[test]
+    fn mem_urls_are_never_shared() {
+        let a = open_shared("mem://").unwrap();
+        let b = open_shared("mem://").unwrap();
+        assert!(!Arc::ptr_eq(&a, &b));
+        assert!(!evict("mem://"));
+        assert!(is_ephemeral("cache+cas://mem://"));
+        assert!(!is_ephemeral("cache+s3://bucket"));
+    }
+
+    #[cfg(feature = "store-fs")]
+    #[test]
+    fn file_urls_share_one_store() {
+        let dir = std::env::temp_dir().join(format!("nucleation-pool-fs-{}", std::process::id()));
+        let url = format!("file://{}", dir.display());
+        let a = open_shared(&url).unwrap();
+        let b = open_shared(&url).unwrap();
+        assert!(Arc::ptr_eq(&a, &b));
+        evict(&url);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -0,0 +1,184 @@
+//! [`RangeReader`]: `Read + Seek` over one stored object through
+//! [`Store::get_range`], so seek-driven readers (MCA region files, header
+//! probes) fetch only the windows they touch rather than the whole object.
+
+use std::io::{self, Read, Seek, SeekFrom};
+
+use super::Store;
+
+/// Bytes fetched per window by [`RangeReader::new`].
+pub const DEFAULT_WINDOW: usize = 64 * 1024;
+
+/// A seekable reader over the object at `key`. Each read outside the current
+/// window fetches the next `window` bytes (or the whole read, if larger) with
+/// one [`Store::get_range`] call.
+///
+/// The key is not checked up front: a missing object surfaces as a
+/// [`io::ErrorKind::NotFound`] error on the first read. The object's length is
+/// never fetched, so [`SeekFrom::End`] is unsupported.
+pub struct RangeReader<'a> {
+    store: &'a dyn Store,
+    key: String,
+    pos: u64,
+    window: Vec<u8>,
+    window_start: u64,
+    window_size: usize,
+}
+
+impl<'a> RangeReader<'a> {
+    /// A reader over `key` fetching [`DEFAULT_WINDOW`] bytes at a time.
+    pub fn new(store: &'a dyn Store, key: impl Into<String>) -> Self {
+        Self::with_window(store, key, DEFAULT_WINDOW)
+    }
+
+    /// A reader over `key` fetching `window` bytes (at least 1) at a time.
+    pub fn with_window(store: &'a dyn Store, key: impl Into<String>, window: usize) -> Self {
+        Self {
+            store,
+            key: key.into(),
+            pos: 0,
+            window: Vec::new(),
+            window_start: 0,
+            window_size: window.max(1),
+        }
+    }
+
+    /// Bytes of the current window at or after `pos`.
+    fn buffered(&self) -> &[u8] {
+        let end = self.window_start + self.window.len() as u64;
+        if self.pos < self.window_start || self.pos >= end {
+            return &[];
+        }
+        &self.window[(self.pos - self.window_start) as usize..]
+    }
+
+    fn fill(&mut self, want: usize) -> io::Result<()> {
+        let len = want.max(self.window_size) as u64;
+        self.window = self
+            .store
+            .get_range(&self.key, self.pos, len)
+            .map_err(|e| io::Error::other(e.to_string()))?
+            .ok_or_else(|| {
+                io::Error::new(
+                    io::ErrorKind::NotFound,
+                    format!("key not found: {}", self.key),
+                )
+            })?;
+        self.window_start = self.pos;
+        Ok(())
+    }
+}
+
+impl Read for RangeReader<'_> {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        if buf.is_empty() {
+            return Ok(0);
+        }
+        if self.buffered().is_empty() {
+            self.fill(buf.len())?;
+        }
+        let available = self.buffered();
+        let n = buf.len().min(available.len());
+        buf[..n].copy_from_slice(&available[..n]);
+        self.pos += n as u64;
+        Ok(n)
+    }
+}
+
+impl Seek for RangeReader<'_> {
+    fn seek(&mut self, pos: SeekFrom) -> io::Result<u64> {
+        self.pos = match pos {
+            SeekFrom::Start(n) => n,
+            SeekFrom::Current(delta) => self
+                .pos
+                .checked_add_signed(delta)
+                .ok_or_else(|| io::Error::new(io::ErrorKind::InvalidInput, "seek before start"))?,
+            SeekFrom::End(_) => {
+                return Err(io::Error::new(
+                    io::ErrorKind::Unsupported,
+                    "RangeReader does not know the object length",
+                ))
+            }
+        };
+        Ok(self.pos)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::store::{MemStore, Result};
+    use std::sync::atomic::{AtomicU64, Ordering};
+
+    /// A MemStore that counts the bytes handed out by `get_range`.
+    #[derive(Default)]
+    struct Counting {
+        inner: MemStore,
+        fetched: AtomicU64,
+    }
+
+    impl Store for Counting {
+        fn get(&self, key: &str) -> Result<Option<Vec<u8>>> {
+            self.inner.get(key)
+        }
+        fn put(&self, key: &str, bytes: &[u8]) -> Result<()> {
+            self.inner.put(key, bytes)
+        }
+        fn exists(&self, key: &str) -> Result<bool> {
+            self.inner.exists(key)
+        }
+        fn delete(&self, key: &str) -> Result<()> {
+            self.inner.delete(key)
+        }
+        fn list(&self, prefix: &str) -> Result<Vec<String>> {
+            self.inner.list(prefix)
+        }
+        fn health(&self) -> Result<()> {
+            Ok(())
+        }
+        fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+            let range = self.inner.get_range(key, offset, len)?;
+            if let Some(bytes) = &range {
+                self.fetched
+                    .fetch_add(bytes.len() as u64, Ordering::Relaxed);
+            }
+            Ok(range)
+        }
+    }
+
+    #[test]
+    fn seeks_fetch_only_the_touched_windows() {
+        let store = Counting::default();
+        let data: Vec<u8> = (0..1_000_000u32).map(|i| (i % 251) as u8).collect();
+        store.put("big", &data).unwrap();
+
+        let mut reader = RangeReader::with_window(&store, "big", 4096);
+        let mut buf = [0u8; 16];
+        reader.seek(SeekFrom::Start(500_000)).unwrap();
+        reader.read_exact(&mut buf).unwrap();
+        assert_eq!(&buf[..], &data[500_000..500_016]);
+        reader.seek(SeekFrom::Current(-8)).unwrap();
+        reader.read_exact(&mut buf).unwrap();
+        assert_eq!(&buf[..], &data[500_008..500_024]);
+        assert_eq!(store.fetched.load(Ordering::Relaxed), 4096);
+
+        // A read straddling the end of the window refetches from there.
+        reader.seek(SeekFrom::Start(500_000 + 4090)).unwrap();
+        reader.read_exact(&mut buf).unwrap();
+        assert_eq!(&buf[..], &data[504_090..504_106]);
+
+        let mut tail = Vec::new();
+        reader.seek(SeekFrom::Start(999_990)).unwrap();
+        reader.read_to_end(&mut tail).unwrap();
+        assert_eq!(tail, &data[999_990..]);
+        assert!(reader.seek(SeekFrom::End(0)).is_err());
+    }
+
+    #[test]
+    fn missing_keys_fail_on_first_read() {
+        let store = MemStore::new();
+        let mut reader = RangeReader::new(&store, "absent");
+        let err = reader.read(&mut [0u8; 4]).unwrap_err();
+        assert_eq!(err.kind(), io::ErrorKind::NotFound);
+    }
+}
@@ -7,7 +7,11 @@ use std::sync::Arc;
 use redis::AsyncCommands;
 use tokio::runtime::Runtime;
 
-use super::{Result, Store, StoreError};
+use super::{Completion, Result, Store, StoreError, StoreOp, StoreOutcome};
+
+/// Keys per `MGET` / `DEL` / pipeline in the batch operations, bounding the
+/// size of a single request and reply.
+const BATCH: usize = 1000;
 
 /// Connection settings for a [`RedisStore`].
 #[derive(Clone, Debug)]
@@ -56,6 +60,27 @@ impl RedisStore {
     }
 }
 
+/// Run one [`StoreOp`] against `full`, the op's prefixed key.
+async fn run(
+    conn: &mut redis::aio::MultiplexedConnection,
+    op: StoreOp,
+    full: &str,
+) -> Result<StoreOutcome> {
+    let conn_err = |e: redis::RedisError| StoreError::Connection(e.to_string());
+    Ok(match op {
+        StoreOp::Get(_) => StoreOutcome::Value(conn.get(full).await.map_err(conn_err)?),
+        StoreOp::Put(_, bytes) => {
+            let _: () = conn.set(full, bytes).await.map_err(conn_err)?;
+            StoreOutcome::Done
+        }
+        StoreOp::Exists(_) => StoreOutcome::Exists(conn.exists(full).await.map_err(conn_err)?),
+        StoreOp::Delete(_) => {
+            let _: i64 = conn.del(full).await.map_err(conn_err)?;
+            StoreOutcome::Done
+        }
+    })
+}
+
 impl Store for RedisStore {
     fn get(&self, key: &str) -> Result<Option<Vec<u8>>> {
         let full = self.full(key);
@@ -121,6 +146,107 @@ impl Store for RedisStore {
         })
     }
 
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+        let full = self.full(key);
+        let mut conn = self.conn.clone();
+        crate::store::block_on(&self.rt, async move {
+            // `GETRANGE` answers "" for a missing key, so pipeline an `EXISTS`
+            // to tell the two apart. Its end index is inclusive.
+            let mut pipe = redis::pipe();
+            pipe.exists(&full);
+            if len > 0 {
+                let start = i64::try_from(offset).unwrap_or(i64::MAX);
+                let end = i64::try_from(offset.saturating_add(len - 1)).unwrap_or(i64::MAX);
+                pipe.getrange(&full, start as isize, end as isize);
+            }
+            let (found, bytes): (bool, Option<Vec<u8>>) = if len > 0 {
+                pipe.query_async(&mut conn)
+                    .await
+                    .map_err(|e| StoreError::Connection(e.to_string()))?
+            } else {
+                let (found,): (bool,) = pipe
+                    .query_async(&mut conn)
+                    .await
+                    .map_err(|e| StoreError::Connection(e.to_string()))?;
+                (found, None)
+            };
+            Ok(found.then(|| bytes.unwrap_or_default()))
+        })
+    }
+
+    fn get_many(&self, keys: &[&str]) -> Result<Vec<Option<Vec<u8>>>> {
+        let full: Vec<String> = keys.iter().map(|k| self.full(k)).collect();
+        let mut conn = self.conn.clone();
+        crate::store::block_on(&self.rt, async move {
+            let mut out = Vec::with_capacity(full.len());
+            for chunk in full.chunks(BATCH) {
+                // `cmd("MGET")` rather than `conn.mget`, which sends a plain
+                // `GET` for a single key and so decodes a non-array reply.
+                let values: Vec<Option<Vec<u8>>> = redis::cmd("MGET")
+                    .arg(chunk)
+                    .query_async(&mut conn)
+                    .await
+                    .map_err(|e| StoreError::Connection(e.to_string()))?;
+                out.extend(values);
+            }
+            Ok(out)
+        })
+    }
+
+    fn put_many(&self, items: &[(&str, &[u8])]) -> Result<()> {
+        let full: Vec<(String, &[u8])> = items.iter().map(|(k, v)| (self.full(k), *v)).collect();
+        let mut conn = self.conn.clone();
+        crate::store::block_on(&self.rt, async move {
+            for chunk in full.chunks(BATCH) {
+                // One `MSET` per chunk: later pairs overwrite earlier ones.
+                let mut cmd = redis::cmd("MSET");
+                for (k, v) in chunk {
+                    cmd.arg(k).arg(*v);
+                }
+                let _: () = cmd
+                    .query_async(&mut conn)
+                    .await
+                    .map_err(|e| StoreError::Connection(e.to_string()))?;
+            }
+            Ok(())
+        })
+    }
+
+    fn exists_many(&self, keys: &[&str]) -> Result<Vec<bool>> {
+        let full: Vec<String> = keys.iter().map(|k| self.full(k)).collect();
+        let mut conn = self.conn.clone();
+        crate::store::block_on(&self.rt, async move {
+            let mut out = Vec::with_capacity(full.len());
+            for chunk in full.chunks(BATCH) {
+                // Multi-key `EXISTS` only returns a count, so pipeline one per key.
+                let mut pipe = redis::pipe();
+                for k in chunk {
+                    pipe.exists(k);
+                }
+                let found: Vec<bool> = pipe
+                    .query_async(&mut conn)
+                    .await
+                    .map_err(|e| StoreError::Connection(e.to_string()))?;
+                out.extend(found);
+            }
+            Ok(out)
+        })
+    }
+
+    fn delete_many(&self, keys: &[&str]) -> Result<()> {
+        let full: Vec<String> = keys.iter().map(|k| self.full(k)).collect();
+        let mut conn = self.conn.clone();
+        crate::store::block_on(&self.rt, async move {
+            for chunk in full.chunks(BATCH) {
+                let _: i64 = conn
+                    .del(chunk)
+                    .await
+                    .map_err(|e| StoreError::Connection(e.to_string()))?;
+            }
+            Ok(())
+        })
+    }
+
     fn list(&self, prefix: &str) -> Result<Vec<String>> {
         let pattern = format!("{}{}*", self.prefix, prefix);
         let strip_len = self.prefix.len();
@@ -150,6 +276,18 @@ impl Store for RedisStore {
         })
     }
 
+    /// Spawns `op` on the store's runtime and returns at once. The task
+    /// shares the multiplexed connection, so submitted commands pipeline.
+    fn submit(&self, op: StoreOp, done: Completion) {
+        // The task owns a connection clone, never the runtime: a task that
+        // dropped the last runtime handle would shut it down from inside.
+        let mut conn = self.conn.clone();
+        let full = self.full(op.key());
+        self.rt.spawn(async move {
+            done(run(&mut conn, op, &full).await);
+        });
+    }
+
     fn health(&self) -> Result<()> {
         let mut conn = self.conn.clone();
         crate::store::block_on(&self.rt, async move {
@@ -6,6 +6,7 @@
 //! credentials, e.g. for MinIO) or via `s3://bucket/prefix` through
 //! [`super::open`], which fills credentials from the environment.
 
+use std::collections::VecDeque;
 use std::fmt;
 use std::io::{Read, Write};
 use std::sync::Arc;
@@ -13,15 +14,28 @@ use std::sync::Arc;
 use aws_sdk_s3::config::{BehaviorVersion, Credentials, Region};
 use aws_sdk_s3::error::ProvideErrorMetadata;
 use aws_sdk_s3::primitives::ByteStream;
-use aws_sdk_s3::types::{CompletedMultipartUpload, CompletedPart};
+use aws_sdk_s3::types::{CompletedMultipartUpload, CompletedPart, Delete, ObjectIdentifier};
 use aws_sdk_s3::Client;
-use futures_util::TryStreamExt;
+use futures_util::{stream, StreamExt, TryStreamExt};
 use tokio::runtime::Runtime;
+use tokio::task::JoinHandle;
 
-use super::{Result, Store, StoreError};
+use super::{Completion, Result, Store, StoreError, StoreOp, StoreOutcome};
 
 /// S3 multipart minimum part size (except the final part).
-const PART_SIZE: usize = 5 * 1024 * 1024;
+pub const MIN_PART_SIZE: usize = 5 * 1024 * 1024;
+
+/// Default [`S3Config::part_size`].
+pub const DEFAULT_PART_SIZE: usize = 8 * 1024 * 1024;
+
+/// Default [`S3Config::transfer_window`].
+pub const DEFAULT_TRANSFER_WINDOW: usize = 8;
+
+/// Default cap on concurrent requests issued by one batch call.
+pub const DEFAULT_MAX_IN_FLIGHT: usize = 32;
+
+/// Most keys a single `DeleteObjects` request accepts.
+const DELETE_BATCH: usize = 1000;
 
 /// Connection settings for an [`S3Store`].
 #[derive(Clone)]
@@ -40,6 +54,15 @@ pub struct S3Config {
     pub secret_key: Option<String>,
     /// Use path-style addressing (required by MinIO).
     pub force_path_style: bool,
+    /// Most requests one batch call (`get_many`, `put_many`, `exists_many`)
+    /// keeps in flight at once. Clamped to at least 1.
+    pub max_in_flight: usize,
+    /// Multipart part size for [`Store::writer`] and ranged chunk size for
+    /// [`Store::reader`]. Clamped to at least [`MIN_PART_SIZE`].
+    pub part_size: usize,
+    /// Parts one writer uploads, or chunks one reader prefetches, at once.
+    /// Clamped to at least 1.
+    pub transfer_window: usize,
 }
 
 impl S3Config {
@@ -53,6 +76,9 @@ impl S3Config {
             access_key: None,
             secret_key: None,
             force_path_style: false,
+            max_in_flight: DEFAULT_MAX_IN_FLIGHT,
+            part_size: DEFAULT_PART_SIZE,
+            transfer_window: DEFAULT_TRANSFER_WINDOW,
         }
     }
 }
@@ -68,6 +94,9 @@ impl fmt::Debug for S3Config {
             .field("access_key", &self.access_key.as_deref().map(|_| "***"))
             .field("secret_key", &self.secret_key.as_deref().map(|_| "***"))
             .field("force_path_style", &self.force_path_style)
+            .field("max_in_flight", &self.max_in_flight)
+            .field("part_size", &self.part_size)
+            .field("transfer_window", &self.transfer_window)
             .finish()
     }
 }
@@ -79,6 +108,9 @@ pub struct S3Store {
     client: Client,
     bucket: String,
     prefix: String,
+    max_in_flight: usize,
+    part_size: usize,
+    transfer_window: usize,
 }
 
 impl S3Store {
@@ -121,6 +153,9 @@ impl S3Store {
             client,
             bucket: cfg.bucket,
             prefix,
+            max_in_flight: cfg.max_in_flight.max(1),
+            part_size: cfg.part_size.max(MIN_PART_SIZE),
+            transfer_window: cfg.transfer_window.max(1),
         })
     }
 
@@ -152,6 +187,129 @@ impl S3Store {
     }
 }
 
+async fn fetch(client: &Client, bucket: &str, full: &str) -> Result<Option<Vec<u8>>> {
+    match client.get_object().bucket(bucket).key(full).send().await {
+        Ok(out) => {
+            let data = out
+                .body
+                .collect()
+                .await
+                .map_err(|e| StoreError::Io(e.to_string()))?;
+            Ok(Some(data.into_bytes().to_vec()))
+        }
+        Err(e) => {
+            if e.as_service_error().map(|se| se.is_no_such_key()) == Some(true) {
+                Ok(None)
+            } else {
+                Err(StoreError::Connection(e.to_string()))
+            }
+        }
+    }
+}
+
+/// One ranged `GET` answer.
+struct Chunk {
+    bytes: Vec<u8>,
+    /// The object's full length, from `Content-Range`.
+    total: Option<u64>,
+    etag: Option<String>,
+}
+
+/// `GET` bytes `offset..offset + len` (`len > 0`), or `None` if the object is
+/// absent. An offset at or past the end yields an empty chunk. With
+/// `if_match`, a changed object fails instead of mixing versions.
+async fn fetch_range(
+    client: &Client,
+    bucket: &str,
+    full: &str,
+    offset: u64,
+    len: u64,
+    if_match: Option<&str>,
+) -> Result<Option<Chunk>> {
+    let range = format!("bytes={}-{}", offset, offset.saturating_add(len - 1));
+    let request = client
+        .get_object()
+        .bucket(bucket)
+        .key(full)
+        .range(range)
+        .set_if_match(if_match.map(str::to_string));
+    match request.send().await {
+        Ok(out) => {
+            let total = out
+                .content_range()
+                .and_then(|r| r.rsplit('/').next())
+                .and_then(|t| t.parse().ok());
+            let etag = out.e_tag().map(str::to_string);
+            let data = out
+                .body
+                .collect()
+                .await
+                .map_err(|e| StoreError::Io(e.to_string()))?;
+            Ok(Some(Chunk {
+                bytes: data.into_bytes().to_vec(),
+                total,
+                etag,
+            }))
+        }
+        Err(e) => {
+            let service = e.as_service_error();
+            if service.map(|se| se.is_no_such_key()) == Some(true) {
+                Ok(None)
+            } else if service.and_then(|se| se.code()) == Some("InvalidRange") {
+                // 416: the offset is at or past the end of the object.
+                Ok(Some(Chunk {
+                    bytes: Vec::new(),
+                    total: None,
+                    etag: None,
+                }))
+            } else {
+                Err(StoreError::Connection(e.to_string()))
+            }
+        }
+    }
+}
+
+async fn upload(client: &Client, bucket: &str, full: &str, bytes: &[u8]) -> Result<()> {
+    client
+        .put_object()
+        .bucket(bucket)
+        .key(full)
+        .body(ByteStream::from(bytes.to_vec()))
+        .send()
+        .await
+        .map(|_| ())
+        .map_err(|e| StoreError::Connection(e.to_string()))
+}
+
+async fn head(client: &Client, bucket: &str, full: &str) -> Result<bool> {
+    etag(client, bucket, full).await.map(|tag| tag.is_some())
+}
+
+/// The object's ETag (empty if S3 sent none), or `None` if it is absent.
+async fn etag(client: &Client, bucket: &str, full: &str) -> Result<Option<String>> {
+    match client.head_object().bucket(bucket).key(full).send().await {
+        Ok(out) => Ok(Some(out.e_tag().unwrap_or_default().to_string())),
+        Err(e) => {
+            if e.as_service_error().map(|se| se.is_not_found()) == Some(true) {
+                Ok(None)
+            } else {
+                Err(StoreError::Connection(e.to_string()))
+            }
+        }
+    }
+}
+
+async fn remove(client: &Client, bucket: &str, full: &str) -> Result<()> {
+    client
+        .delete_object()
+        .bucket(bucket)
+        .key(full)
+        .send()
+        .await
+        .map(|_| ())
+        .map_err(|e| StoreError::Connection(e.to_string()))
+}
+
 fn normalize_prefix(prefix: &str) -> String {
     if prefix.is_empty() || prefix.ends_with('/') {
         prefix.to_string()
@@ -163,84 +321,124 @@ fn normalize_prefix(prefix: &str) -> String {
 impl Store for S3Store {
     fn get(&self, key: &str) -> Result<Option<Vec<u8>>> {
         let full = self.full(key);
-        crate::store::block_on(&self.rt, async {
-            match self
-                .client
-                .get_object()
-                .bucket(&self.bucket)
-                .key(&full)
-                .send()
-                .await
-            {
-                Ok(out) => {
-                    let data = out
-                        .body
-                        .collect()
-                        .await
-                        .map_err(|e| StoreError::Io(e.to_string()))?;
-                    Ok(Some(data.into_bytes().to_vec()))
-                }
-                Err(e) => {
-                    if e.as_service_error().map(|se| se.is_no_such_key()) == Some(true) {
-                        Ok(None)
-                    } else {
-                        Err(StoreError::Connection(e.to_string()))
-                    }
-                }
-            }
-        })
+        crate::store::block_on(&self.rt, fetch(&self.client, &self.bucket, &full))
     }
 
     fn put(&self, key: &str, bytes: &[u8]) -> Result<()> {
         let full = self.full(key);
-        let body = ByteStream::from(bytes.to_vec());
-        crate::store::block_on(&self.rt, async {
-            self.client
-                .put_object()
-                .bucket(&self.bucket)
-                .key(&full)
-                .body(body)
-                .send()
-                .await
-                .map(|_| ())
-                .map_err(|e| StoreError::Connection(e.to_string()))
-        })
+        crate::store::block_on(&self.rt, upload(&self.client, &self.bucket, &full, bytes))
     }
 
     fn exists(&self, key: &str) -> Result<bool> {
         let full = self.full(key);
+        crate::store::block_on(&self.rt, head(&self.client, &self.bucket, &full))
+    }
+
+    fn version(&self, key: &str) -> Result<Option<String>> {
+        let full = self.full(key);
+        crate::store::block_on(&self.rt, etag(&self.client, &self.bucket, &full))
+    }
+
+    fn delete(&self, key: &str) -> Result<()> {
+        let full = self.full(key);
+        crate::store::block_on(&self.rt, remove(&self.client, &self.bucket, &full))
+    }
+
+    /// A ranged `GET`, so only the requested bytes cross the network.
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+        if len == 0 {
+            // An HTTP range can't be empty; existence is all that's asked.
+            return Ok(self.exists(key)?.then(Vec::new));
+        }
+        let full = self.full(key);
+        let chunk = crate::store::block_on(
+            &self.rt,
+            fetch_range(&self.client, &self.bucket, &full, offset, len, None),
+        )?;
+        Ok(chunk.map(|c| c.bytes))
+    }
+
+    /// Concurrent `GET`s, at most `max_in_flight` at once.
+    fn get_many(&self, keys: &[&str]) -> Result<Vec<Option<Vec<u8>>>> {
+        let full: Vec<String> = keys.iter().map(|k| self.full(k)).collect();
         crate::store::block_on(&self.rt, async {
-            match self
-                .client
-                .head_object()
-                .bucket(&self.bucket)
-                .key(&full)
-                .send()
+            stream::iter(full.iter().map(|k| fetch(&self.client, &self.bucket, k)))
+                .buffered(self.max_in_flight)
+                .try_collect::<Vec<_>>()
                 .await
-            {
-                Ok(_) => Ok(true),
-                Err(e) => {
-                    if e.as_service_error().map(|se| se.is_not_found()) == Some(true) {
-                        Ok(false)
-                    } else {
-                        Err(StoreError::Connection(e.to_string()))
-                    }
-                }
-            }
         })
     }
 
-    fn delete(&self, key: &str) -> Result<()> {
-        let full = self.full(key);
+    /// Concurrent `PUT`s, at most `max_in_flight` at once. Only the last pair
+    /// for a repeated key is sent, so concurrent uploads never race.
+    fn put_many(&self, items: &[(&str, &[u8])]) -> Result<()> {
+        let last: std::collections::HashMap<&str, usize> = items
+            .iter()
+            .enumerate()
+            .map(|(i, (k, _))| (*k, i))
+            .collect();
+        let uploads: Vec<(String, &[u8])> = items
+            .iter()
+            .enumerate()
+            .filter(|(i, (k, _))| last[k] == *i)
+            .map(|(_, (k, v))| (self.full(k), *v))
+            .collect();
         crate::store::block_on(&self.rt, async {
-            self.client
-                .delete_object()
-                .bucket(&self.bucket)
-                .key(&full)
-                .send()
+            stream::iter(
+                uploads
+                    .iter()
+                    .map(|(k, v)| upload(&self.client, &self.bucket, k, v)),
+            )
+            .buffer_unordered(self.max_in_flight)
+            .try_collect::<Vec<()>>()
+            .await
+            .map(|_| ())
+        })
+    }
+
+    /// Concurrent `HEAD`s, at most `max_in_flight` at once.
+    fn exists_many(&self, keys: &[&str]) -> Result<Vec<bool>> {
+        let full: Vec<String> = keys.iter().map(|k| self.full(k)).collect();
+        crate::store::block_on(&self.rt, async {
+            stream::iter(full.iter().map(|k| head(&self.client, &self.bucket, k)))
+                .buffered(self.max_in_flight)
+                .try_collect::<Vec<_>>()
                 .await
-                .map(|_| ())
-                .map_err(|e| StoreError::Connection(e.to_string()))
+        })
+    }
+
+    /// `DeleteObjects`, up to 1000 keys per request.
+    fn delete_many(&self, keys: &[&str]) -> Result<()> {
+        crate::store::block_on(&self.rt, async {
+            for chunk in keys.chunks(DELETE_BATCH) {
+                let objects = chunk
+                    .iter()
+                    .map(|k| ObjectIdentifier::builder().key(self.full(k)).build())
+                    .collect::<std::result::Result<Vec<_>, _>>()
+                    .map_err(|e| StoreError::Other(e.to_string()))?;
+                let delete = Delete::builder()
+                    .set_objects(Some(objects))
+                    .quiet(true)
+                    .build()
+                    .map_err(|e| StoreError::Other(e.to_string()))?;
+                let resp = self
+                    .client
+                    .delete_objects()
+                    .bucket(&self.bucket)
+                    .delete(delete)
+                    .send()
+                    .await
+                    .map_err(|e| StoreError::Connection(e.to_string()))?;
+                // Quiet mode reports only failures; missing keys are not one.
+                if let Some(err) = resp.errors().first() {
+                    return Err(StoreError::Connection(format!(
+                        "DeleteObjects failed for {:?}: {}",
+                        err.key().unwrap_or_default(),
+                        err.message().unwrap_or_default()
+                    )));
+                }
+            }
+            Ok(())
         })
     }
 
@@ -350,6 +548,32 @@ impl Store for S3Store {
         })
     }
 
+    /// Spawns `op` on the store's runtime and returns at once.
+    fn submit(&self, op: StoreOp, done: Completion) {
+        // The task owns clones of the client, never the runtime: a task that
+        // dropped the last runtime handle would shut it down from inside.
+        let client = self.client.clone();
+        let bucket = self.bucket.clone();
+        let full = self.full(op.key());
+        self.rt.spawn(async move {
+            let result = match op {
+                StoreOp::Get(_) => fetch(&client, &bucket, &full)
+                    .await
+                    .map(StoreOutcome::Value),
+                StoreOp::Put(_, bytes) => upload(&client, &bucket, &full, &bytes)
+                    .await
+                    .map(|()| StoreOutcome::Done),
+                StoreOp::Exists(_) => head(&client, &bucket, &full)
+                    .await
+                    .map(StoreOutcome::Exists),
+                StoreOp::Delete(_) => remove(&client, &bucket, &full)
+                    .await
+                    .map(|()| StoreOutcome::Done),
+            };
+            done(result);
+        });
+    }
+
     fn health(&self) -> Result<()> {
         crate::store::block_on(&self.rt, async {
             self.client
@@ -362,40 +586,45 @@ impl Store for S3Store {
         })
     }
 
-    /// Native streaming read: pulls the object body chunk-by-chunk instead of
-    /// buffering the whole object in memory.
+    /// Native streaming read in `part_size` ranged `GET`s, keeping up to
+    /// `transfer_window` chunks in flight ahead of the reader. An object of
+    /// one chunk or less costs a single request. Every later chunk is pinned
+    /// to the first one's ETag, so an object rewritten mid-read fails the read
+    /// rather than mixing versions.
     fn reader(&self, key: &str) -> Result<Box<dyn Read + '_>> {
         let full = self.full(key);
-        let body = crate::store::block_on(&self.rt, async {
-            match self
-                .client
-                .get_object()
-                .bucket(&self.bucket)
-                .key(&full)
-                .send()
-                .await
-            {
-                Ok(out) => Ok(out.body),
-                Err(e) => {
-                    if e.as_service_error().map(|se| se.is_no_such_key()) == Some(true) {
-                        Err(StoreError::NotFound(full.clone()))
-                    } else {
-                        Err(StoreError::Connection(e.to_string()))
-                    }
-                }
-            }
-        })?;
+        let first = crate::store::block_on(
+            &self.rt,
+            fetch_range(
+                &self.client,
+                &self.bucket,
+                &full,
+                0,
+                self.part_size as u64,
+                None,
+            ),
+        )?
+        .ok_or_else(|| StoreError::NotFound(full.clone()))?;
+        let total = first.total.unwrap_or(first.bytes.len() as u64);
         Ok(Box::new(S3Reader {
             rt: self.rt.clone(),
-            body,
-            leftover: Vec::new(),
+            client: self.client.clone(),
+            bucket: self.bucket.clone(),
+            key: full,
+            etag: first.etag,
+            chunk_size: self.part_size as u64,
+            next_offset: first.bytes.len() as u64,
+            total,
+            window: self.transfer_window,
+            pending: VecDeque::new(),
+            current: first.bytes,
             pos: 0,
         }))
     }
 
-    /// Native streaming write: uploads in 5 MiB multipart chunks as data
-    /// arrives, so the whole object is never buffered. Small writes fall back
-    /// to a single `put_object` on commit.
+    /// Native streaming write: uploads `part_size` multipart parts as data
+    /// arrives, up to `transfer_window` at once, so the whole object is never
+    /// buffered. Small writes fall back to a single `put_object` on commit.
     fn writer(&self, key: &str) -> Result<Box<dyn Write + '_>> {
         Ok(Box::new(S3Writer {
             rt: self.rt.clone(),
@@ -403,7 +632,10 @@ impl Store for S3Store {
             bucket: self.bucket.clone(),
             key: self.full(key),
             buf: Vec::new(),
+            part_size: self.part_size,
+            window: self.transfer_window,
             upload_id: None,
+            in_flight: VecDeque::new(),
             parts: Vec::new(),
             next_part: 1,
             committed: false,
@@ -411,44 +643,115 @@ impl Store for S3Store {
     }
 }
 
-/// Sync [`Read`] adapter over the async S3 `ByteStream`.
+/// Sync [`Read`] adapter prefetching ranged `GET`s on the store's runtime.
 struct S3Reader {
     rt: Arc<Runtime>,
-    body: ByteStream,
-    leftover: Vec<u8>,
+    client: Client,
+    bucket: String,
+    key: String,
+    etag: Option<String>,
+    chunk_size: u64,
+    /// Start of the next chunk to request.
+    next_offset: u64,
+    total: u64,
+    window: usize,
+    pending: VecDeque<JoinHandle<Result<Option<Chunk>>>>,
+    current: Vec<u8>,
     pos: usize,
 }
 
+impl S3Reader {
+    /// Request chunks until `window` are in flight or the object is covered.
+    fn prefetch(&mut self) {
+        while self.pending.len() < self.window && self.next_offset < self.total {
+            let (client, bucket, key) =
+                (self.client.clone(), self.bucket.clone(), self.key.clone());
+            let etag = self.etag.clone();
+            let (offset, len) = (self.next_offset, self.chunk_size);
+            // Tasks own client clones, never the runtime.
+            self.pending.push_back(self.rt.spawn(async move {
+                fetch_range(&client, &bucket, &key, offset, len, etag.as_deref()).await
+            }));
+            self.next_offset += len;
+        }
+    }
+}
+
 impl Read for S3Reader {
     fn read(&mut self, out: &mut [u8]) -> std::io::Result<usize> {
-        if self.pos >= self.leftover.len() {
-            match crate::store::block_on(&self.rt, self.body.try_next()) {
-                Ok(Some(chunk)) => {
-                    self.leftover = chunk.to_vec();
-                    self.pos = 0;
-                }
-                Ok(None) => return Ok(0),
-                Err(e) => return Err(std::io::Error::other(e.to_string())),
+        while self.pos >= self.current.len() {
+            self.prefetch();
+            let Some(next) = self.pending.pop_front() else {
+                return Ok(0);
+            };
+            let chunk = crate::store::block_on(&self.rt, next)
+                .map_err(std::io::Error::other)?
+                .map_err(|e| std::io::Error::other(e.to_string()))?
+                .ok_or_else(|| {
+                    std::io::Error::new(
+                        std::io::ErrorKind::NotFound,
+                        format!("{} was deleted mid-read", self.key),
+                    )
+                })?;
+            if chunk.bytes.is_empty() {
+                return Ok(0);
             }
+            self.current = chunk.bytes;
+            self.pos = 0;
         }
-        if self.leftover.is_empty() {
-            return Ok(0);
-        }
-        let n = out.len().min(self.leftover.len() - self.pos);
-        out[..n].copy_from_slice(&self.leftover[self.pos..self.pos + n]);
+        let n = out.len().min(self.current.len() - self.pos);
+        out[..n].copy_from_slice(&self.current[self.pos..self.pos + n]);
         self.pos += n;
         Ok(n)
     }
 }
 
-/// Streaming multipart [`Write`] adapter for S3.
+impl Drop for S3Reader {
+    fn drop(&mut self) {
+        for task in &self.pending {
+            task.abort();
+        }
+    }
+}
+
+async fn upload_part(
+    client: Client,
+    bucket: String,
+    key: String,
+    upload_id: String,
+    part_number: i32,
+    bytes: Vec<u8>,
+) -> std::io::Result<CompletedPart> {
+    let etag = client
+        .upload_part()
+        .bucket(bucket)
+        .key(key)
+        .upload_id(upload_id)
+        .part_number(part_number)
+        .body(ByteStream::from(bytes))
+        .send()
+        .await
+        .map_err(|e| std::io::Error::other(e.to_string()))?
+        .e_tag;
+    Ok(CompletedPart::builder()
+        .part_number(part_number)
+        .set_e_tag(etag)
+        .build())
+}
+
+/// Streaming multipart [`Write`] adapter for S3, uploading up to `window`
+/// parts concurrently.
 struct S3Writer {
     rt: Arc<Runtime>,
     client: Client,
     bucket: String,
     key: String,
     buf: Vec<u8>,
+    part_size: usize,
+    window: usize,
     upload_id: Option<String>,
+    /// Uploads in part order, oldest first.
+    in_flight: VecDeque<JoinHandle<std::io::Result<CompletedPart>>>,
     parts: Vec<CompletedPart>,
     next_part: i32,
     committed: bool,
@@ -474,29 +777,78 @@ impl S3Writer {
         Ok(id)
     }
 
+    /// Wait for the oldest in-flight part.
+    fn finish_oldest(&mut self) -> std::io::Result<()> {
+        if let Some(task) = self.in_flight.pop_front() {
+            let part = crate::store::block_on(&self.rt, task).map_err(std::io::Error::other)??;
+            self.parts.push(part);
+        }
+        Ok(())
+    }
+
+    /// Start uploading `bytes` as the next part, first waiting for room in
+    /// the window.
     fn upload_one(&mut self, bytes: Vec<u8>) -> std::io::Result<()> {
         let upload_id = self.ensure_multipart()?;
+        while self.in_flight.len() >= self.window {
+            self.finish_oldest()?;
+        }
         let part_number = self.next_part;
         self.next_part += 1;
-        let etag = crate::store::block_on(
+        self.in_flight.push_back(self.rt.spawn(upload_part(
+            self.client.clone(),
+            self.bucket.clone(),
+            self.key.clone(),
+            upload_id,
+            part_number,
+            bytes,
+        )));
+        Ok(())
+    }
+
+    /// Cancel every in-flight part and abort the upload, so S3 keeps no
+    /// orphaned parts. The writer is finished afterwards.
+    fn abort(&mut self) {
+        self.committed = true;
+        for task in self.in_flight.drain(..) {
+            task.abort();
+        }
+        if let Some(upload_id) = self.upload_id.take() {
+            let _ = crate::store::block_on(
+                &self.rt,
+                self.client
+                    .abort_multipart_upload()
+                    .bucket(&self.bucket)
+                    .key(&self.key)
+                    .upload_id(upload_id)
+                    .send(),
+            );
+        }
+    }
+
+    fn complete(&mut self) -> std::io::Result<()> {
+        if !self.buf.is_empty() {
+            let last = std::mem::take(&mut self.buf);
+            self.upload_one(last)?;
+        }
+        while !self.in_flight.is_empty() {
+            self.finish_oldest()?;
+        }
+        let completed = CompletedMultipartUpload::builder()
+            .set_parts(Some(std::mem::take(&mut self.parts)))
+            .build();
+        let upload_id = self.upload_id.clone().unwrap();
+        crate::store::block_on(
             &self.rt,
             self.client
-                .upload_part()
+                .complete_multipart_upload()
                 .bucket(&self.bucket)
                 .key(&self.key)
-                .upload_id(&upload_id)
-                .part_number(part_number)
-                .body(ByteStream::from(bytes))
+                .upload_id(upload_id)
+                .multipart_upload(completed)
                 .send(),
         )
-        .map_err(|e| std::io::Error::other(e.to_string()))?
-        .e_tag;
-        self.parts.push(
-            CompletedPart::builder()
-                .part_number(part_number)
-                .set_e_tag(etag)
-                .build(),
-        );
+        .map_err(|e| std::io::Error::other(e.to_string()))?;
         Ok(())
     }
 
@@ -517,26 +869,9 @@ impl S3Writer {
                     .send(),
             )
             .map_err(|e| std::io::Error::other(e.to_string()))?;
-        } else {
-            if !self.buf.is_empty() {
-                let last = std::mem::take(&mut self.buf);
-                self.upload_one(last)?;
-            }
-            let completed = CompletedMultipartUpload::builder()
-                .set_parts(Some(self.parts.clone()))
-                .build();
-            let upload_id = self.upload_id.clone().unwrap();
-            crate::store::block_on(
-                &self.rt,
-                self.client
-                    .complete_multipart_upload()
-                    .bucket(&self.bucket)
-                    .key(&self.key)
-                    .upload_id(upload_id)
-                    .multipart_upload(completed)
-                    .send(),
-            )
-            .map_err(|e| std::io::Error::other(e.to_string()))?;
+        } else if let Err(e) = self.complete() {
+            self.abort();
+            return Err(e);
         }
         self.committed = true;
         Ok(())
@@ -545,10 +880,16 @@ impl S3Writer {
 
 impl Write for S3Writer {
     fn write(&mut self, data: &[u8]) -> std::io::Result<usize> {
+        if self.committed {
+            return Err(std::io::Error::other("S3 upload already finished"));
+        }
         self.buf.extend_from_slice(data);
-        while self.buf.len() >= PART_SIZE {
-            let part: Vec<u8> = self.buf.drain(..PART_SIZE).collect();
-            self.upload_one(part)?;
+        while self.buf.len() >= self.part_size {
+            let part: Vec<u8> = self.buf.drain(..self.part_size).collect();
+            if let Err(e) = self.upload_one(part) {
+                self.abort();
+                return Err(e);
+            }
         }
         Ok(data.len())
     }
@@ -576,13 +917,17 @@ mod tests {
         let endpoint = std::env::var("NUC_TEST_S3_ENDPOINT")
             .unwrap_or_else(|_| "http://localhost:9000".to_string());
         let cfg = S3Config {
-            bucket: "nucleation-test".to_string(),
             prefix: format!("t{}/", std::process::id()),
             region: Some("us-east-1".to_string()),
             endpoint: Some(endpoint),
             access_key: Some("minioadmin".to_string()),
             secret_key: Some("minioadmin".to_string()),
             force_path_style: true,
+            // Small parts and a narrow window so the 11 MiB roundtrip below
+            // uploads and prefetches several parts concurrently.
+            part_size: MIN_PART_SIZE,
+            transfer_window: 2,
+            ..S3Config::new("nucleation-test")
         };
         let store = S3Store::connect(cfg).ok()?;
         store.ensure_bucket().ok()?;
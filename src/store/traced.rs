@@ -0,0 +1,131 @@
+//! [`Store`] wrapper that traces reads and writes. [`open`](super::open)
+//! puts one around every store it builds.
+//!
+//! `get`, `get_range`, `get_many`, `put` and `put_many` each run in a
+//! `store.*` span carrying the key (or key count), and feed the
+//! [`telemetry`](crate::telemetry) registry: one duration histogram per
+//! operation, plus `store.get.bytes`, `store.get.misses` and
+//! `store.put.bytes`. Every other call is forwarded untouched, so backend
+//! overrides (ranged reads, batched round-trips, async `submit`) keep working.
+
+use std::io::{Read, Write};
+
+use super::{Completion, Result, Store, StoreOp};
+use crate::telemetry::{self, stage};
+
+pub struct TracedStore<S: Store + ?Sized> {
+    inner: Box<S>,
+}
+
+impl<S: Store + ?Sized> TracedStore<S> {
+    pub fn new(inner: Box<S>) -> Self {
+        Self { inner }
+    }
+
+    pub fn inner(&self) -> &S {
+        &self.inner
+    }
+}
+
+fn count_read(bytes: &Option<Vec<u8>>) {
+    match bytes {
+        Some(bytes) => telemetry::count("store.get.bytes", bytes.len() as u64),
+        None => telemetry::count("store.get.misses", 1),
+    }
+}
+
+impl<S: Store + ?Sized> Store for TracedStore<S> {
+    fn get(&self, key: &str) -> Result<Option<Vec<u8>>> {
+        let _stage = stage!(DEBUG, "store.get", key);
+        self.inner.get(key).inspect(count_read)
+    }
+
+    fn put(&self, key: &str, bytes: &[u8]) -> Result<()> {
+        let _stage = stage!(DEBUG, "store.put", key, bytes = bytes.len());
+        telemetry::count("store.put.bytes", bytes.len() as u64);
+        self.inner.put(key, bytes)
+    }
+
+    fn exists(&self, key: &str) -> Result<bool> {
+        self.inner.exists(key)
+    }
+
+    fn delete(&self, key: &str) -> Result<()> {
+        self.inner.delete(key)
+    }
+
+    fn list(&self, prefix: &str) -> Result<Vec<String>> {
+        self.inner.list(prefix)
+    }
+
+    fn health(&self) -> Result<()> {
+        self.inner.health()
+    }
+
+    fn put_if_absent(&self, key: &str, bytes: &[u8]) -> Result<bool> {
+        self.inner.put_if_absent(key, bytes)
+    }
+
+    fn get_range(&self, key: &str, offset: u64, len: u64) -> Result<Option<Vec<u8>>> {
+        let _stage = stage!(DEBUG, "store.get_range", key, offset, len);
+        self.inner.get_range(key, offset, len).inspect(count_read)
+    }
+
+    fn version(&self, key: &str) -> Result<Option<String>> {
+        self.inner.version(key)
+    }
+
+    fn get_many(&self, keys: &[&str]) -> Result<Vec<Option<Vec<u8>>>> {
+        let _stage = stage!(DEBUG, "store.get_many", keys = keys.len());
+        self.inner
+            .get_many(keys)
+            .inspect(|all| all.iter().for_each(count_read))
+    }
+
+    fn put_many(&self, items: &[(&str, &[u8])]) -> Result<()> {
+        let bytes: usize = items.iter().map(|(_, v)| v.len()).sum();
+        let _stage = stage!(DEBUG, "store.put_many", keys = items.len(), bytes);
+        telemetry::count("store.put.bytes", bytes as u64);
+        self.inner.put_many(items)
+    }
+
+    fn exists_many(&self, keys: &[&str]) -> Result<Vec<bool>> {
+        self.inner.exists_many(keys)
+    }
+
+    fn delete_many(&self, keys: &[&str]) -> Result<()> {
+        self.inner.delete_many(keys)
+    }
+
+    fn list_paginated(
+        &self,
+        prefix: &str,
+        after: Option<&str>,
+        limit: usize,
+    ) -> Result<(Vec<String>, Option<String>)> {
+        self.inner.list_paginated(prefix, after, limit)
+    }
+
+    fn submit(&self, op: StoreOp, done: Completion) {
+        self.inner.submit(op, done)
+    }
+
+    fn reader(&self, key: &str) -> Result<Box<dyn Read + '_>> {
+        self.inner.reader(key)
+    }
+
+    fn writer(&self, key: &str) -> Result<Box<dyn Write + '_>> {
+        self.inner.writer(key)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::store::MemStore;
+
+    #[test]
+    fn traced_store_satisfies_contract() {
+        crate::store::contract::run_contract(&TracedStore::new(Box::new(MemStore::new())));
+    }
+}
@@ -7,7 +7,12 @@
 
 use std::error::Error;
 use std::path::PathBuf;
+use std::sync::Arc;
 
+use crate::formats::manager::{FormatManager, SchematicImporter, SchematicInfo};
+use crate::formats::snapshot::{
+    from_snapshot, is_chunk_manifest, to_chunked_snapshot, ChunkManifest, DEFAULT_CHUNK_SIZE,
+};
 use crate::store::{self, Store, StoreError};
 use crate::universal_schematic::UniversalSchematic;
 
@@ -15,15 +20,16 @@ use crate::universal_schematic::UniversalSchematic;
 pub enum Target {
     /// A local filesystem path (plain paths and `file://`).
     Local(PathBuf),
-    /// A remote store plus the object key within it.
-    Remote(Box<dyn Store>, String),
+    /// A remote store plus the object key within it. The store is shared
+    /// with every other URI naming the same bucket.
+    Remote(Arc<dyn Store>, String),
 }
 
 /// Resolve a URI/path into a [`Target`].
 ///
 /// - no scheme, or `file://` → [`Target::Local`]
 /// - `s3://bucket/key` → [`Target::Remote`] (the whole path after the bucket is
-///   the key)
+///   the key), through the shared connection cache ([`store::open_shared`])
 /// - `redis://` / `postgres://` / `mem://` single-strings are rejected: their
 ///   URL has no slot for an object key, so open them with an explicit store
 ///   (`UniversalSchematic::from_store`).
@@ -40,7 +46,7 @@ pub fn resolve(uri: &str) -> Result<Target, StoreError> {
                         "S3 URI needs an object key: s3://{rest}/key.schem"
                     ))
                 })?;
-            let store = store::open(&format!("s3://{bucket}"))?;
+            let store = store::open_shared(&format!("s3://{bucket}"))?;
             Ok(Target::Remote(store, key.to_string()))
         }
         Some((scheme @ ("redis" | "rediss" | "postgres" | "postgresql" | "mem"), _)) => {
@@ -56,22 +62,128 @@ pub fn resolve(uri: &str) -> Result<Target, StoreError> {
 }
 
 fn read_manager(bytes: &[u8]) -> Result<UniversalSchematic, Box<dyn Error>> {
-    let arc = crate::formats::manager::get_manager();
-    let manager = arc
-        .lock()
-        .map_err(|_| "format manager lock poisoned".to_string())?;
+    let manager = crate::formats::manager::get_manager();
     Ok(manager.read(bytes)?)
 }
 
+fn probe_manager(bytes: &[u8]) -> Result<SchematicInfo, Box<dyn Error>> {
+    let manager = crate::formats::manager::get_manager();
+    Ok(manager.probe(bytes)?)
+}
+
+/// Read the header fields of the schematic at a file path or store URI
+/// (format, dimensions, name/author, versions) without decoding its blocks.
+pub fn probe(uri: &str) -> Result<SchematicInfo, Box<dyn Error>> {
+    match resolve(uri)? {
+        Target::Local(path) => probe_manager(&std::fs::read(path)?),
+        Target::Remote(store, key) => probe_store(store.as_ref(), &key),
+    }
+}
+
+/// Leading bytes fetched to detect a stored schematic's format. Detection
+/// reads headers only, so this covers every format whose header fields come
+/// before its bulk data.
+const SNIFF_LEN: u64 = 64 * 1024;
+
+/// How [`sniff`] found the object at a key.
+enum Sniffed<'m> {
+    /// The whole object fit in the sniffed prefix.
+    Whole(Vec<u8>),
+    /// The prefix identifies the format; stream the object through it.
+    Stream(&'m dyn SchematicImporter),
+    /// The prefix was not enough to tell; fetch the whole object.
+    Unknown,
+    /// A chunked snapshot's whole manifest.
+    Chunked(Vec<u8>),
+}
+
+/// Fetch the head of `key` and find the importer that recognises it, so the
+/// object can be streamed into that importer rather than downloaded first.
+fn sniff<'m>(
+    manager: &'m FormatManager,
+    store: &dyn Store,
+    key: &str,
+) -> Result<Sniffed<'m>, Box<dyn Error>> {
+    let head = store
+        .get_range(key, 0, SNIFF_LEN)?
+        .ok_or_else(|| StoreError::NotFound(key.to_string()))?;
+    if is_chunk_manifest(&head) {
+        let manifest = if (head.len() as u64) < SNIFF_LEN {
+            head
+        } else {
+            store
+                .get(key)?
+                .ok_or_else(|| StoreError::NotFound(key.to_string()))?
+        };
+        return Ok(Sniffed::Chunked(manifest));
+    }
+    if (head.len() as u64) < SNIFF_LEN {
+        return Ok(Sniffed::Whole(head));
+    }
+    Ok(manager
+        .importer_for(&head)
+        .map_or(Sniffed::Unknown, Sniffed::Stream))
+}
+
+/// [`probe`] for a schematic in an explicit store at `key`. Formats with a
+/// header fast path stop reading the object once the header is seen.
+pub fn probe_store(store: &dyn Store, key: &str) -> Result<SchematicInfo, Box<dyn Error>> {
+    let manager = crate::formats::manager::get_manager();
+    match sniff(&manager, store, key)? {
+        Sniffed::Whole(bytes) => Ok(manager.probe(&bytes)?),
+        Sniffed::Stream(importer) => {
+            let mut info = importer.probe_from(&mut store.reader(key)?)?;
+            info.format = importer.name();
+            Ok(info)
+        }
+        Sniffed::Unknown => {
+            let bytes = store
+                .get(key)?
+                .ok_or_else(|| StoreError::NotFound(key.to_string()))?;
+            probe_manager(&bytes)
+        }
+        Sniffed::Chunked(manifest) => {
+            // The manifest header has no summary of its own; build one.
+            let mut info = SchematicInfo::from_schematic(&load_chunked(store, &manifest)?);
+            info.format = "snapshot".to_string();
+            Ok(info)
+        }
+    }
+}
+
+/// Where chunked snapshots keep their chunks, shared by every manifest in
+/// the store.
+const CHUNK_PREFIX: &str = "chunks/";
+
+/// File extension that [`UniversalSchematic::save_to_store`] saves as a
+/// chunked snapshot.
+const CHUNKED_EXTENSION: &str = ".nusm";
+
+fn chunk_key(id: &str) -> String {
+    format!("{CHUNK_PREFIX}{}/{id}", &id[..2])
+}
+
+/// Fetch every chunk `manifest` names in one batched read and rebuild the
+/// schematic.
+fn load_chunked(store: &dyn Store, manifest: &[u8]) -> Result<UniversalSchematic, Box<dyn Error>> {
+    let manifest = ChunkManifest::parse(manifest)?;
+    let keys: Vec<String> = manifest.chunk_ids().into_iter().map(chunk_key).collect();
+    let refs: Vec<&str> = keys.iter().map(String::as_str).collect();
+    let chunks = store
+        .get_many(&refs)?
+        .into_iter()
+        .zip(&keys)
+        .map(|(chunk, key)| chunk.ok_or_else(|| StoreError::NotFound(key.clone())))
+        .collect::<Result<Vec<_>, _>>()?;
+    Ok(from_snapshot(&manifest.assemble(&chunks)?)?)
+}
+
 fn write_manager(
     schematic: &UniversalSchematic,
     key_or_path: &str,
     version: Option<&str>,
 ) -> Result<Vec<u8>, Box<dyn Error>> {
-    let arc = crate::formats::manager::get_manager();
-    let manager = arc
-        .lock()
-        .map_err(|_| "format manager lock poisoned".to_string())?;
+    let manager = crate::formats::manager::get_manager();
     match manager.write_auto(key_or_path, schematic, version) {
         Ok(bytes) => Ok(bytes),
         // No usable format extension (a bare store key like "builds/castle",
@@ -94,12 +206,23 @@ impl UniversalSchematic {
         }
     }
 
-    /// Load a schematic from an explicit store at `key` (works for any backend).
+    /// Load a schematic from an explicit store at `key` (works for any
+    /// backend). Once its head identifies the format, the object is decoded
+    /// straight from [`Store::reader`], so backends that stream (S3, the
+    /// filesystem) never hold the compressed file in memory.
     pub fn from_store(store: &dyn Store, key: &str) -> Result<Self, Box<dyn Error>> {
-        let bytes = store
-            .get(key)?
-            .ok_or_else(|| StoreError::NotFound(key.to_string()))?;
-        read_manager(&bytes)
+        let manager = crate::formats::manager::get_manager();
+        match sniff(&manager, store, key)? {
+            Sniffed::Whole(bytes) => Ok(manager.read(&bytes)?),
+            Sniffed::Stream(importer) => Ok(importer.read_from(&mut store.reader(key)?)?),
+            Sniffed::Unknown => {
+                let bytes = store
+                    .get(key)?
+                    .ok_or_else(|| StoreError::NotFound(key.to_string()))?;
+                read_manager(&bytes)
+            }
+            Sniffed::Chunked(manifest) => load_chunked(store, &manifest),
+        }
     }
 
     /// Save to a file path or store URI. Format is inferred from the extension;
@@ -116,17 +239,47 @@ impl UniversalSchematic {
     }
 
     /// Save to an explicit store at `key`. Format inferred from the key's
-    /// extension.
+    /// extension; a `.nusm` key is saved with [`Self::save_chunked`].
     pub fn save_to_store(
         &self,
         store: &dyn Store,
         key: &str,
         version: Option<&str>,
     ) -> Result<(), Box<dyn Error>> {
+        if key.ends_with(CHUNKED_EXTENSION) {
+            self.save_chunked(store, key)?;
+            return Ok(());
+        }
         let bytes = write_manager(self, key, version)?;
         store.put(key, &bytes)?;
         Ok(())
     }
+
+    /// Save as a chunked snapshot: a manifest at `key` naming content-hashed
+    /// chunks under `chunks/`. Chunks the store already holds are not
+    /// uploaded again, so saving a variant of a stored build uploads only
+    /// the chunks its edits touched. [`Self::from_store`] reads the manifest
+    /// back, fetching its chunks in one batch.
+    ///
+    /// Returns how many chunks were uploaded. Deleting a manifest leaves its
+    /// chunks, which other manifests may share.
+    pub fn save_chunked(&self, store: &dyn Store, key: &str) -> Result<usize, Box<dyn Error>> {
+        let chunked = to_chunked_snapshot(self, DEFAULT_CHUNK_SIZE)?;
+        let keys: Vec<String> = chunked.chunks.iter().map(|(id, _)| chunk_key(id)).collect();
+        let refs: Vec<&str> = keys.iter().map(String::as_str).collect();
+        let present = store.exists_many(&refs)?;
+        let missing: Vec<(&str, &[u8])> = refs
+            .iter()
+            .zip(&chunked.chunks)
+            .zip(present)
+            .filter(|(_, present)| !present)
+            .map(|((key, (_, bytes)), _)| (*key, bytes.as_slice()))
+            .collect();
+        store.put_many(&missing)?;
+        // The manifest goes last, so it never names a chunk not yet stored.
+        store.put(key, &chunked.manifest)?;
+        Ok(missing.len())
+    }
 }
 
 #[cfg(test)]
@@ -167,6 +320,112 @@ mod tests {
         let _ = std::fs::remove_dir_all(&dir);
     }
 
+    #[test]
+    fn probe_reads_headers_from_store() {
+        let store = MemStore::new();
+        let mut schematic = sample();
+        schematic.metadata.author = Some("probe".to_string());
+        schematic.set_block(3, 1, 2, &BlockState::new("minecraft:dirt".to_string()));
+        for key in ["a.litematic", "a.schem"] {
+            schematic.save_to_store(&store, key, None).unwrap();
+            let info = probe_store(&store, key).unwrap();
+            assert_eq!(info.dimensions, Some((4, 2, 3)), "{key}");
+            assert_eq!(info.metadata.author.as_deref(), Some("probe"), "{key}");
+            assert!(info.format_version.is_some(), "{key}");
+        }
+        assert_eq!(
+            probe_store(&store, "a.litematic").unwrap().format,
+            "litematic"
+        );
+        assert_eq!(probe_store(&store, "a.schem").unwrap().format, "schematic");
+        schematic
+            .save_to_store(&store, "a.mcstructure", None)
+            .unwrap();
+        let info = probe_store(&store, "a.mcstructure").unwrap();
+        assert_eq!(
+            (info.format.as_str(), info.dimensions),
+            ("mcstructure", Some((4, 2, 3)))
+        );
+        assert!(probe_store(&store, "missing.schem").is_err());
+    }
+
+    #[test]
+    fn large_objects_stream_into_the_detected_importer() {
+        let store = MemStore::new();
+        let palette: Vec<BlockState> = (0..64)
+            .map(|i| BlockState::new(format!("minecraft:test_{i}")))
+            .collect();
+        let mut schematic = UniversalSchematic::new("big".to_string());
+        for x in 0..64i32 {
+            for y in 0..64i32 {
+                for z in 0..64i32 {
+                    let h = (x as u32).wrapping_mul(73_856_093)
+                        ^ (y as u32).wrapping_mul(19_349_663)
+                        ^ (z as u32).wrapping_mul(83_492_791);
+                    schematic.set_block(x, y, z, &palette[(h % 64) as usize]);
+                }
+            }
+        }
+        let manager = crate::formats::manager::get_manager();
+        for key in ["big.schem", "big.litematic"] {
+            schematic.save_to_store(&store, key, None).unwrap();
+            let head = store.get_range(key, 0, SNIFF_LEN).unwrap().unwrap();
+            assert_eq!(head.len() as u64, SNIFF_LEN, "{key} outgrows the head");
+            assert!(manager.importer_for(&head).is_some(), "{key} detected");
+            let loaded = UniversalSchematic::from_store(&store, key).unwrap();
+            for (x, y, z) in [(0, 0, 0), (5, 6, 7), (63, 63, 63)] {
+                assert_eq!(
+                    loaded.get_block(x, y, z),
+                    schematic.get_block(x, y, z),
+                    "{key}"
+                );
+            }
+            let info = probe_store(&store, key).unwrap();
+            assert_eq!(info.dimensions, Some((64, 64, 64)), "{key}");
+        }
+    }
+
+    #[test]
+    fn chunked_variants_upload_only_changed_chunks() {
+        let store = MemStore::new();
+        // 300 states need 2-byte cells: 64³ cells span two default chunks.
+        let palette: Vec<BlockState> = (0..300)
+            .map(|i| BlockState::new(format!("minecraft:test_{i}")))
+            .collect();
+        let mut base = UniversalSchematic::new("base".to_string());
+        for x in 0..64i32 {
+            for y in 0..64i32 {
+                for z in 0..64i32 {
+                    base.set_block(x, y, z, &palette[((x + y * 7 + z * 13) % 300) as usize]);
+                }
+            }
+        }
+        let first = base.save_chunked(&store, "builds/base.nusm").unwrap();
+        assert!(first >= 3, "cells and extras upload on the first save");
+
+        let mut variant = base.clone();
+        variant.set_block(63, 63, 63, &palette[0]);
+        variant
+            .save_to_store(&store, "builds/variant.nusm", None)
+            .unwrap();
+        assert_eq!(store.list(CHUNK_PREFIX).unwrap().len(), first + 1);
+
+        let loaded = UniversalSchematic::from_store(&store, "builds/variant.nusm").unwrap();
+        for (x, y, z) in [(0, 0, 0), (10, 20, 30), (63, 63, 63)] {
+            assert_eq!(loaded.get_block(x, y, z), variant.get_block(x, y, z));
+        }
+        let info = probe_store(&store, "builds/base.nusm").unwrap();
+        assert_eq!(
+            (info.format.as_str(), info.region_count),
+            ("snapshot", Some(1))
+        );
+
+        for chunk in store.list(CHUNK_PREFIX).unwrap() {
+            store.delete(&chunk).unwrap();
+        }
+        assert!(UniversalSchematic::from_store(&store, "builds/base.nusm").is_err());
+    }
+
     #[test]
     fn resolve_rules() {
         assert!(matches!(resolve("build.schem").unwrap(), Target::Local(_)));
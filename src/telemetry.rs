@@ -0,0 +1,281 @@
+//! Tracing spans and process-wide metrics for the hot paths.
+//!
+//! Each instrumented stage (format read/write, parallel chunk meshing, world
+//! chunk decode, store get/put, simulation ticks, segmentation phases) opens
+//! a `tracing` span named like `format.read`, with its sizes and counts as
+//! fields. Any subscriber sees them: the stderr one from [`init_subscriber`],
+//! or an OpenTelemetry layer the host installs itself. With no subscriber a
+//! span is a cached disabled-callsite check.
+//!
+//! Beside the spans, stages feed a registry of counters and histograms. It is
+//! off until [`set_enabled`] turns it on, so a default build pays one relaxed
+//! load per stage. A stage's histogram holds its durations in microseconds
+//! under the stage's name; sizes go to counters whose names end in their unit
+//! (`format.read.bytes`, `mesh.chunks`). [`snapshot`] reads everything back,
+//! and [`MetricsSnapshot::to_json`] is what the bindings export.
+//!
+//! Durations are not measured on wasm32, where `Instant::now` panics; the
+//! counters still work there.
+
+use std::collections::BTreeMap;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Mutex, OnceLock};
+
+use rustc_hash::FxHashMap;
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+
+/// Turn metric recording on or off. Spans are unaffected: they are governed
+/// by whichever subscriber is installed.
+pub fn set_enabled(enabled: bool) {
+    ENABLED.store(enabled, Ordering::Relaxed);
+}
+
+pub fn is_enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/// Install a stderr subscriber filtered by `filter`, in `RUST_LOG` syntax
+/// (e.g. `nucleation=debug`). Fails if a global subscriber is already set.
+pub fn init_subscriber(filter: &str) -> Result<(), String> {
+    tracing_subscriber::fmt()
+        .with_env_filter(tracing_subscriber::EnvFilter::new(filter))
+        .with_span_events(tracing_subscriber::fmt::format::FmtSpan::CLOSE)
+        .with_writer(std::io::stderr)
+        .try_init()
+        .map_err(|e| e.to_string())
+}
+
+/// Bucket `i` counts values with bit length `i`: 0, then `[2^(i-1), 2^i)`.
+const BUCKETS: usize = 65;
+
+#[derive(Clone)]
+struct Histogram {
+    count: u64,
+    sum: u64,
+    min: u64,
+    max: u64,
+    buckets: [u64; BUCKETS],
+}
+
+impl Histogram {
+    fn new() -> Self {
+        Self {
+            count: 0,
+            sum: 0,
+            min: u64::MAX,
+            max: 0,
+            buckets: [0; BUCKETS],
+        }
+    }
+
+    fn record(&mut self, value: u64) {
+        self.count += 1;
+        self.sum = self.sum.saturating_add(value);
+        self.min = self.min.min(value);
+        self.max = self.max.max(value);
+        self.buckets[(u64::BITS - value.leading_zeros()) as usize] += 1;
+    }
+
+    /// Upper bound of the bucket holding the `q` quantile, capped at `max`.
+    fn quantile(&self, q: f64) -> u64 {
+        let rank = ((self.count as f64 * q).ceil() as u64).max(1);
+        let mut seen = 0;
+        for (i, &n) in self.buckets.iter().enumerate() {
+            seen += n;
+            if seen >= rank {
+                let upper = if i == 0 { 0 } else { (1u128 << i) - 1 };
+                return (upper as u64).min(self.max);
+            }
+        }
+        self.max
+    }
+
+    fn summary(&self) -> HistogramSummary {
+        HistogramSummary {
+            count: self.count,
+            sum: self.sum,
+            min: if self.count == 0 { 0 } else { self.min },
+            max: self.max,
+            p50: self.quantile(0.5),
+            p90: self.quantile(0.9),
+            p99: self.quantile(0.99),
+        }
+    }
+}
+
+#[derive(Default)]
+struct Registry {
+    counters: FxHashMap<&'static str, u64>,
+    histograms: FxHashMap<&'static str, Histogram>,
+}
+
+fn registry() -> &'static Mutex<Registry> {
+    static REGISTRY: OnceLock<Mutex<Registry>> = OnceLock::new();
+    REGISTRY.get_or_init(Default::default)
+}
+
+/// Add `n` to the counter `name`. No-op while recording is off.
+pub fn count(name: &'static str, n: u64) {
+    if !is_enabled() {
+        return;
+    }
+    let mut registry = registry().lock().unwrap_or_else(|e| e.into_inner());
+    *registry.counters.entry(name).or_insert(0) += n;
+}
+
+/// Record `value` in the histogram `name`. No-op while recording is off.
+pub fn record(name: &'static str, value: u64) {
+    if !is_enabled() {
+        return;
+    }
+    let mut registry = registry().lock().unwrap_or_else(|e| e.into_inner());
+    registry
+        .histograms
+        .entry(name)
+        .or_insert_with(Histogram::new)
+        .record(value);
+}
+
+/// Clear every counter and histogram.
+pub fn reset() {
+    let mut registry = registry().lock().unwrap_or_else(|e| e.into_inner());
+    registry.counters.clear();
+    registry.histograms.clear();
+}
+
+/// One histogram's totals and bucketed quantiles. Quantiles are bucket upper
+/// bounds, so they are within a factor of two of the true value.
+#[derive(Clone, Debug, Default, PartialEq, Eq, serde::Serialize)]
+pub struct HistogramSummary {
+    pub count: u64,
+    pub sum: u64,
+    pub min: u64,
+    pub max: u64,
+    pub p50: u64,
+    pub p90: u64,
+    pub p99: u64,
+}
+
+/// Every counter and histogram at one moment, sorted by name.
+#[derive(Clone, Debug, Default, PartialEq, Eq, serde::Serialize)]
+pub struct MetricsSnapshot {
+    pub counters: BTreeMap<String, u64>,
+    pub histograms: BTreeMap<String, HistogramSummary>,
+}
+
+impl MetricsSnapshot {
+    pub fn to_json(&self) -> String {
+        serde_json::to_string(self).unwrap_or_default()
+    }
+}
+
+pub fn snapshot() -> MetricsSnapshot {
+    let registry = registry().lock().unwrap_or_else(|e| e.into_inner());
+    MetricsSnapshot {
+        counters: registry
+            .counters
+            .iter()
+            .map(|(name, n)| (name.to_string(), *n))
+            .collect(),
+        histograms: registry
+            .histograms
+            .iter()
+            .map(|(name, h)| (name.to_string(), h.summary()))
+            .collect(),
+    }
+}
+
+/// Records the time until it is dropped, in microseconds, in the histogram
+/// `name`. Reads no clock while recording is off.
+pub struct Timer {
+    name: &'static str,
+    #[cfg(not(target_arch = "wasm32"))]
+    started: Option<std::time::Instant>,
+}
+
+impl Timer {
+    pub fn start(name: &'static str) -> Self {
+        Self {
+            name,
+            #[cfg(not(target_arch = "wasm32"))]
+            started: is_enabled().then(std::time::Instant::now),
+        }
+    }
+}
+
+impl Drop for Timer {
+    fn drop(&mut self) {
+        #[cfg(not(target_arch = "wasm32"))]
+        if let Some(started) = self.started {
+            record(self.name, started.elapsed().as_micros() as u64);
+        }
+        #[cfg(target_arch = "wasm32")]
+        let _ = self.name;
+    }
+}
+
+/// Open a stage: an entered span at `$level` plus a [`Timer`], both under
+/// `$name`. Bind the result for the stage's extent:
+///
+/// ```ignore
+/// let _stage = stage!(INFO, "format.read", bytes = data.len());
+/// ```
+///
+/// Work fanned out to other threads does not inherit the current span; pass
+/// the outer stage's id as `parent: id.clone()` to keep the tree intact.
+macro_rules! stage {
+    ($level:ident, parent: $parent:expr, $name:literal $(, $($fields:tt)+)?) => {
+        (
+            tracing::span!(parent: $parent, tracing::Level::$level, $name $(, $($fields)+)?)
+                .entered(),
+            $crate::telemetry::Timer::start($name),
+        )
+    };
+    ($level:ident, $name:literal $(, $($fields:tt)+)?) => {
+        (
+            tracing::span!(tracing::Level::$level, $name $(, $($fields)+)?).entered(),
+            $crate::telemetry::Timer::start($name),
+        )
+    };
+}
+pub(crate) use stage;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn histogram_quantiles_fall_in_the_right_buckets() {
+        let mut h = Histogram::new();
+        for v in 1..=100 {
+            h.record(v);
+        }
+        let s = h.summary();
+        assert_eq!((s.count, s.sum, s.min, s.max), (100, 5050, 1, 100));
+        // 50 lies in [32, 64), 90 and 99 in [64, 128) capped at the max.
+        assert_eq!((s.p50, s.p90, s.p99), (63, 100, 100));
+        assert_eq!(Histogram::new().summary(), HistogramSummary::default());
+    }
+
+    #[test]
+    fn stages_record_only_while_enabled() {
+        // The registry is process-wide, so this test owns its names.
+        set_enabled(false);
+        count("test.disabled", 1);
+        set_enabled(true);
+        count("test.enabled.bytes", 7);
+        count("test.enabled.bytes", 5);
+        {
+            let _stage = stage!(DEBUG, "test.stage", items = 3);
+        }
+        set_enabled(false);
+
+        let snapshot = snapshot();
+        assert!(!snapshot.counters.contains_key("test.disabled"));
+        assert_eq!(snapshot.counters["test.enabled.bytes"], 12);
+        #[cfg(not(target_arch = "wasm32"))]
+        assert_eq!(snapshot.histograms["test.stage"].count, 1);
+        assert!(snapshot.to_json().contains("\"test.enabled.bytes\":12"));
+    }
+}
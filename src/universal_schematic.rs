@@ -1,13 +1,17 @@
 use crate::block_entity::BlockEntity;
 use crate::block_position::BlockPosition;
+use crate::block_state_registry::StateId;
+use crate::block_string_cache::{self, BlockStringCacheStats};
 use crate::bounding_box::BoundingBox;
-use crate::chunk::Chunk;
+use crate::chunk::{Chunk, ChunkedBlocks};
 use crate::definition_region::DefinitionRegion;
 use crate::entity::Entity;
+use crate::memory::{self, MemoryUsage};
 use crate::metadata::Metadata;
 use crate::region::Region;
 // use crate::utils::block_string::{parse_custom_name, parse_items_array};
 // use crate::utils::enhanced_nbt_parser::parse_enhanced_nbt;
+use crate::utils::block_string::split_block_string;
 use crate::utils::NbtMap;
 use crate::utils::NbtValue;
 use crate::BlockState;
@@ -32,13 +36,17 @@ pub struct UniversalSchematic {
     /// on every set_block call.
     #[serde(skip, default = "FxHashMap::default")]
     block_state_cache: FxHashMap<String, BlockState>,
-    /// Full-block-string cache used by `set_block_from_string` to skip
-    /// property and NBT parsing on repeated placements of the same string
-    /// (e.g. filling 100k identical chests). The NbtMap is Arc-shared with
-    /// every BlockEntity placed from it; `BlockEntity::nbt_mut` copies on
-    /// write, so sharing is invisible to callers.
-    #[serde(skip, default = "FxHashMap::default")]
-    block_string_cache: FxHashMap<String, (BlockState, Option<std::sync::Arc<NbtMap>>)>,
+}
+
+/// What [`UniversalSchematic::cache_stats`] reports.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct SchematicCacheStats {
+    /// Plain ids cached on this schematic by `set_block_str`.
+    pub block_states: usize,
+    pub block_state_capacity: usize,
+    /// The process-wide parse cache behind `set_block_from_string`, shared
+    /// by every schematic.
+    pub block_strings: BlockStringCacheStats,
 }
 
 #[derive(Debug, Clone)]
@@ -49,12 +57,110 @@ pub struct ChunkIndices {
     pub blocks: Vec<(BlockPosition, usize)>, // (position, palette_index)
 }
 
+/// Strategy-ordered walk over the chunk grid of every region, created by
+/// [`UniversalSchematic::chunk_cursor`].
+///
+/// Unlike [`UniversalSchematic::iter_chunks_indices`], which buckets every
+/// block before the first chunk is returned, the cursor only orders chunk
+/// coordinates up front and reads one chunk's palette indices per
+/// [`advance`](Self::advance). The cursor holds no borrow; pass the same,
+/// unmodified schematic to every `advance` call.
+#[derive(Debug, Clone)]
+pub struct ChunkCursor {
+    chunk_size: (i32, i32, i32),
+    /// Slot 0 is the default region, then named regions by name.
+    region_names: Vec<String>,
+    order: Vec<(usize, (i32, i32, i32))>,
+    next: usize,
+    current: Option<(usize, (i32, i32, i32))>,
+    indices: Vec<u32>,
+}
+
+impl ChunkCursor {
+    /// Move to the next chunk that holds at least one non-air block and load
+    /// its palette indices. Returns `false` once the walk is exhausted.
+    pub fn advance(&mut self, schematic: &UniversalSchematic) -> bool {
+        self.current = None;
+        let volume =
+            self.chunk_size.0 as usize * self.chunk_size.1 as usize * self.chunk_size.2 as usize;
+        while let Some(&(slot, chunk)) = self.order.get(self.next) {
+            self.next += 1;
+            let Some(region) = schematic.get_region(&self.region_names[slot]) else {
+                continue;
+            };
+            let (min, max) = self.chunk_box(chunk);
+            if !region.may_have_blocks_in(min, max) {
+                continue;
+            }
+            self.indices.resize(volume, 0);
+            if region
+                .read_palette_indices(min, max, &mut self.indices)
+                .is_err()
+            {
+                continue;
+            }
+            let air = region.air_index() as u32;
+            if self.indices.iter().all(|&i| i == air) {
+                continue;
+            }
+            self.current = Some((slot, chunk));
+            return true;
+        }
+        self.indices.clear();
+        false
+    }
+
+    /// Chunk coordinate of the current chunk.
+    pub fn chunk(&self) -> Option<(i32, i32, i32)> {
+        self.current.map(|(_, chunk)| chunk)
+    }
+
+    /// Name of the region the current chunk belongs to; its palette is the
+    /// one [`indices`](Self::indices) refers to.
+    pub fn region_name(&self) -> Option<&str> {
+        self.current
+            .map(|(slot, _)| self.region_names[slot].as_str())
+    }
+
+    /// Minimum block corner of the current chunk.
+    pub fn chunk_min(&self) -> Option<(i32, i32, i32)> {
+        self.current.map(|(_, chunk)| self.chunk_box(chunk).0)
+    }
+
+    pub fn chunk_size(&self) -> (i32, i32, i32) {
+        self.chunk_size
+    }
+
+    /// Palette indices of the current chunk, laid out x fastest, then z, then
+    /// y (as [`Region::read_palette_indices`]). Empty before the first
+    /// `advance` and after the last.
+    pub fn indices(&self) -> &[u32] {
+        if self.current.is_some() {
+            &self.indices
+        } else {
+            &[]
+        }
+    }
+
+    /// Chunks not yet visited (an upper bound: all-air chunks are skipped).
+    pub fn remaining(&self) -> usize {
+        self.order.len() - self.next
+    }
+
+    fn chunk_box(&self, chunk: (i32, i32, i32)) -> ((i32, i32, i32), (i32, i32, i32)) {
+        let (w, h, l) = self.chunk_size;
+        let min = (chunk.0 * w, chunk.1 * h, chunk.2 * l);
+        (min, (min.0 + w - 1, min.1 + h - 1, min.2 + l - 1))
+    }
+}
+
 #[derive(Debug, Clone)]
 pub struct AllPalettes {
     pub default_palette: Vec<BlockState>,
     pub region_palettes: HashMap<String, Vec<BlockState>>,
 }
 
+#[derive(Debug, Clone, Copy)]
 pub enum ChunkLoadingStrategy {
     Default,
     DistanceToCamera(f32, f32, f32), // Camera position
@@ -65,6 +171,47 @@ pub enum ChunkLoadingStrategy {
 }
 pub type SimpleBlockMapping = (&'static str, Vec<(&'static str, &'static str)>);
 
+/// Remapped index of an excluded source block: the destination cell is kept.
+const STAMP_SKIP: u32 = u32::MAX;
+/// Cells per slab of a bulk stamp, bounding its index buffers.
+const STAMP_SLAB_CELLS: usize = 1 << 22;
+
+/// One source region of a bulk stamp, its palette remapped into the
+/// destination's.
+struct StampLayer<'a> {
+    region: &'a Region,
+    /// Source cells the region supplies, unless an earlier layer's box holds
+    /// them.
+    bounds: BoundingBox,
+    /// Source palette index to destination palette index, or [`STAMP_SKIP`].
+    remap: Vec<u32>,
+    /// `remap` is the identity and skips nothing, so rows copy verbatim.
+    identity: bool,
+}
+
+impl StampLayer<'_> {
+    /// Whether the layer writes source cell `pos`, which its bounds hold.
+    fn writes(&self, pos: (i32, i32, i32)) -> bool {
+        self.region
+            .get_block_index(pos.0, pos.1, pos.2)
+            .is_some_and(|index| self.remap.get(index).is_some_and(|&r| r != STAMP_SKIP))
+    }
+
+    /// Copy a row of source indices over destination indices.
+    fn copy_row(&self, src: &[u32], dst: &mut [u32]) {
+        if self.identity {
+            dst.copy_from_slice(src);
+            return;
+        }
+        for (d, &s) in dst.iter_mut().zip(src) {
+            let mapped = self.remap.get(s as usize).copied().unwrap_or(STAMP_SKIP);
+            if mapped != STAMP_SKIP {
+                *d = mapped;
+            }
+        }
+    }
+}
+
 impl UniversalSchematic {
     pub fn new(name: String) -> Self {
         let default_region_name = "Main".to_string();
@@ -78,7 +225,6 @@ impl UniversalSchematic {
             default_region_name,
             definition_regions: HashMap::new(),
             block_state_cache: FxHashMap::default(),
-            block_string_cache: FxHashMap::default(),
         }
     }
 
@@ -256,7 +402,7 @@ impl UniversalSchematic {
             return Err("Region name cannot be empty".to_string());
         }
 
-        let (block_state, nbt) = self.parse_block_string_cached(block_name)?;
+        let (block_state, nbt) = Self::parse_block_string_cached(block_name)?;
         if !self.set_block_in_region(region_name, x, y, z, &block_state) {
             return Ok(false);
         }
@@ -505,14 +651,14 @@ impl UniversalSchematic {
         // Add blocks from default region
         let default_palette = self.default_region.get_palette();
         for block_index in &self.default_region.blocks {
-            blocks.push(default_palette[*block_index].clone());
+            blocks.push(default_palette[block_index].clone());
         }
 
         // Add blocks from named regions in stable order.
         for region in Self::sorted_named_regions(self) {
             let region_palette = region.get_palette();
             for block_index in &region.blocks {
-                blocks.push(region_palette[*block_index].clone());
+                blocks.push(region_palette[block_index].clone());
             }
         }
         blocks
@@ -675,6 +821,58 @@ impl UniversalSchematic {
         total
     }
 
+    /// Heap bytes held by the schematic, by component and by region. See
+    /// [`crate::memory`] for what the figures cover.
+    pub fn memory_usage(&self) -> MemoryUsage {
+        let mut usage = MemoryUsage::default();
+        let mut names: Vec<&String> = self.other_regions.keys().collect();
+        names.sort();
+        let regions = std::iter::once(&self.default_region)
+            .chain(names.into_iter().map(|name| &self.other_regions[name]));
+        for region in regions {
+            let region = region.memory_usage();
+            usage.block_arrays += region.blocks;
+            usage.palettes += region.palette;
+            usage.block_entities += region.block_entities;
+            usage.entities += region.entities;
+            usage.other += region.other;
+            usage.regions.push(region);
+        }
+
+        usage.definition_regions = memory::table_bytes(&self.definition_regions)
+            + self
+                .definition_regions
+                .iter()
+                .map(|(name, region)| name.len() + region.heap_bytes())
+                .sum::<usize>();
+
+        let states: usize = self
+            .block_state_cache
+            .iter()
+            .map(|(key, state)| key.len() + state.heap_bytes())
+            .sum();
+        usage.block_state_cache = memory::table_bytes(&self.block_state_cache) + states;
+
+        let metadata = &self.metadata;
+        usage.other += [&metadata.name, &metadata.author, &metadata.description]
+            .into_iter()
+            .flatten()
+            .map(String::len)
+            .sum::<usize>()
+            + self.default_region_name.len()
+            + memory::table_bytes(&self.other_regions)
+            + self.other_regions.keys().map(String::len).sum::<usize>();
+
+        usage.total = usage.block_arrays
+            + usage.palettes
+            + usage.block_entities
+            + usage.entities
+            + usage.definition_regions
+            + usage.block_state_cache
+            + usage.other;
+        usage
+    }
+
     pub fn total_volume(&self) -> i32 {
         let mut total = self.default_region.volume() as i32;
         total += self
@@ -800,155 +998,32 @@ impl UniversalSchematic {
         }
     }
 
+    /// Set the `north`/`south`/`east`/`west` connections of every redstone
+    /// wire in `region_name` from its neighbours: a side connects to a
+    /// connectable block beside it or to wire one below (unless a solid
+    /// block is in the way), and goes `up` to wire one above when the block
+    /// over the wire is not opaque. A wire with a single connection also
+    /// connects on the opposite side.
     pub fn fix_redstone_connectivity_for_region(&mut self, region_name: &str) {
-        let (min, max) = {
-            let region = match self.get_region(region_name) {
-                Some(r) => r,
-                None => return,
-            };
-            let (width, height, length) = region.size;
-            let (pos_x, pos_y, pos_z) = region.position;
-            (
-                (pos_x, pos_y, pos_z),
-                (pos_x + width, pos_y + height, pos_z + length),
-            )
-        };
-
-        for y in min.1..max.1 {
-            for x in min.0..max.0 {
-                for z in min.2..max.2 {
-                    let block = match self.get_block_from_region(region_name, x, y, z) {
-                        Some(b) if b.name == "minecraft:redstone_wire" => b.clone(),
-                        _ => continue,
-                    };
-
-                    let mut new_block = block.clone();
-                    let directions = [
-                        ("north", 0, -1),
-                        ("south", 0, 1),
-                        ("east", 1, 0),
-                        ("west", -1, 0),
-                    ];
-
-                    let mut connection_states = Vec::new();
-                    let mut connected_count = 0;
-
-                    for (dir, dx, dz) in directions {
-                        let side_val = if self.should_connect_redstone(region_name, x, y, z, dx, dz)
-                        {
-                            "side"
-                        } else if self.should_connect_redstone_up(region_name, x, y, z, dx, dz) {
-                            "up"
-                        } else {
-                            "none"
-                        };
-
-                        if side_val != "none" {
-                            connected_count += 1;
-                        }
-                        connection_states.push((dir, side_val.to_string()));
-                    }
-
-                    // Fix single connection issue: if only 1 connected, opposite becomes side
-                    if connected_count == 1 {
-                        // Find the connected one
-                        if let Some(idx) =
-                            connection_states.iter().position(|(_, val)| val != "none")
-                        {
-                            // 0=north, 1=south, 2=east, 3=west
-                            // Opposites: 0<->1, 2<->3
-                            let opposite_idx = match idx {
-                                0 => 1,
-                                1 => 0,
-                                2 => 3,
-                                3 => 2,
-                                _ => unreachable!(),
-                            };
-
-                            // Force opposite to be "side"
-                            connection_states[opposite_idx].1 = "side".to_string();
-                        }
-                    }
-
-                    for (dir, val) in connection_states {
-                        new_block.set_property(dir, val);
-                    }
-
-                    self.set_block_in_region(region_name, x, y, z, &new_block);
-                }
-            }
+        if let Some(region) = self.get_region_mut(region_name) {
+            region.fix_redstone_connectivity();
         }
     }
 
-    fn should_connect_redstone(
-        &self,
-        region_name: &str,
-        x: i32,
-        y: i32,
-        z: i32,
-        dx: i32,
-        dz: i32,
-    ) -> bool {
-        // Same level
-        if let Some(neighbor) = self.get_block_from_region(region_name, x + dx, y, z + dz) {
-            if is_redstone_connectable(neighbor) {
-                return true;
-            }
-        }
-        // One level down
-        if let Some(neighbor_down) = self.get_block_from_region(region_name, x + dx, y - 1, z + dz)
-        {
-            if neighbor_down.name == "minecraft:redstone_wire" {
-                // Only if the block above neighbor_down is air or non-opaque
-                if let Some(above_neighbor_down) =
-                    self.get_block_from_region(region_name, x + dx, y, z + dz)
-                {
-                    if !is_opaque(above_neighbor_down) {
-                        return true;
-                    }
-                }
-            }
-        }
-        false
-    }
-
-    fn should_connect_redstone_up(
-        &self,
-        region_name: &str,
-        x: i32,
-        y: i32,
-        z: i32,
-        dx: i32,
-        dz: i32,
-    ) -> bool {
-        // One level up
-        // Only if the block above the current wire is not opaque
-        if let Some(above_current) = self.get_block_from_region(region_name, x, y + 1, z) {
-            if is_opaque(above_current) {
-                return false;
-            }
-        }
-
-        if let Some(neighbor_up) = self.get_block_from_region(region_name, x + dx, y + 1, z + dz) {
-            if neighbor_up.name == "minecraft:redstone_wire" {
-                return true;
-            }
-        }
-        false
-    }
-
     pub fn get_merged_region(&self) -> Region {
         let named_regions = Self::sorted_named_regions(self);
-        let mut merged_region = match named_regions.last() {
-            Some(region) => (*region).clone(),
-            None => return self.default_region.clone(),
-        };
-
-        for region in named_regions[..named_regions.len() - 1].iter().rev() {
-            merged_region.merge_with_precedence(region);
+        if named_regions.is_empty() {
+            return self.default_region.clone();
         }
-        merged_region.merge_with_precedence(&self.default_region);
-        merged_region.name = self.default_region_name.clone();
+
+        // Lowest precedence first: the last named region, up to the default.
+        let layers: Vec<&Region> = named_regions
+            .iter()
+            .rev()
+            .copied()
+            .chain(std::iter::once(&self.default_region))
+            .collect();
+        let mut merged_region = Region::merge_layers(self.default_region_name.clone(), &layers);
         merged_region.entities = self
             .default_region
             .entities
@@ -1125,62 +1200,23 @@ impl UniversalSchematic {
             default_region_name,
             definition_regions,
             block_state_cache: FxHashMap::default(),
-            block_string_cache: FxHashMap::default(),
         })
     }
 
     pub fn import_insign_regions(&mut self) -> Result<(), String> {
-        let json_value = crate::insign::compile_schematic_insign(self)
+        let regions = crate::insign::compile_schematic_regions(self)
             .map_err(|e| format!("Insign compilation error: {}", e))?;
 
-        if let Some(regions_map) = json_value.as_object() {
-            for (name, data) in regions_map {
-                let mut def_region = DefinitionRegion::new();
-
-                // Parse bounding boxes
-                if let Some(boxes) = data.get("bounding_boxes").and_then(|v| v.as_array()) {
-                    for bbox_json in boxes {
-                        if let Some(coords) = bbox_json.as_array() {
-                            if coords.len() >= 2 {
-                                let min_arr = coords[0].as_array();
-                                let max_arr = coords[1].as_array();
-
-                                if let (Some(min), Some(max)) = (min_arr, max_arr) {
-                                    if min.len() == 3 && max.len() == 3 {
-                                        let min_tuple = (
-                                            min[0].as_i64().unwrap_or(0) as i32,
-                                            min[1].as_i64().unwrap_or(0) as i32,
-                                            min[2].as_i64().unwrap_or(0) as i32,
-                                        );
-                                        let max_tuple = (
-                                            max[0].as_i64().unwrap_or(0) as i32,
-                                            max[1].as_i64().unwrap_or(0) as i32,
-                                            max[2].as_i64().unwrap_or(0) as i32,
-                                        );
-                                        def_region.add_bounds(min_tuple, max_tuple);
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-
-                // Parse metadata
-                if let Some(meta) = data.get("metadata").and_then(|v| v.as_object()) {
-                    for (key, value) in meta {
-                        // Convert value to string
-                        let val_str = match value {
-                            serde_json::Value::String(s) => s.clone(),
-                            serde_json::Value::Number(n) => n.to_string(),
-                            serde_json::Value::Bool(b) => b.to_string(),
-                            _ => value.to_string(),
-                        };
-                        def_region.set_metadata(key, val_str);
-                    }
-                }
-
-                self.definition_regions.insert(name.clone(), def_region);
+        for region in regions.iter() {
+            let mut def_region = DefinitionRegion::new();
+            for (min, max) in &region.boxes {
+                def_region.add_bounds((min[0], min[1], min[2]), (max[0], max[1], max[2]));
+            }
+            for (key, value) in &region.metadata {
+                def_region.set_metadata(key, crate::insign::metadata_text(value));
             }
+            self.definition_regions
+                .insert(region.name.clone(), def_region);
         }
 
         Ok(())
@@ -1390,34 +1426,12 @@ impl UniversalSchematic {
         block_counts
     }
 
-    fn sorted_named_regions(source: &UniversalSchematic) -> Vec<&Region> {
+    pub(crate) fn sorted_named_regions(source: &UniversalSchematic) -> Vec<&Region> {
         let mut regions: Vec<_> = source.other_regions.iter().collect();
         regions.sort_by(|(left, _), (right, _)| left.cmp(right));
         regions.into_iter().map(|(_, region)| region).collect()
     }
 
-    fn source_region_at<'a>(
-        source: &'a UniversalSchematic,
-        named_regions: &[&'a Region],
-        x: i32,
-        y: i32,
-        z: i32,
-    ) -> Option<&'a Region> {
-        fn contains_visible_content(region: &Region, x: i32, y: i32, z: i32) -> bool {
-            region
-                .get_tight_bounds()
-                .is_some_and(|bounds| bounds.contains((x, y, z)))
-        }
-
-        if contains_visible_content(&source.default_region, x, y, z) {
-            return Some(&source.default_region);
-        }
-        named_regions
-            .iter()
-            .copied()
-            .find(|region| contains_visible_content(region, x, y, z))
-    }
-
     pub(crate) fn region_stamp_bounds(region: &Region) -> Option<BoundingBox> {
         let mut bounds = region.get_tight_bounds();
         for entity in &region.entities {
@@ -1460,40 +1474,185 @@ impl UniversalSchematic {
         ))
     }
 
-    fn stamp_cell_from_region(
+    /// Remap `region`'s palette into the default region's, once per stamp.
+    fn stamp_layer<'a>(
         &mut self,
-        source_region: &Region,
-        source: (i32, i32, i32),
-        destination: (i32, i32, i32),
+        region: &'a Region,
+        bounds: BoundingBox,
         excluded_blocks: &[BlockState],
-    ) {
-        let Some(block) = source_region.get_block(source.0, source.1, source.2) else {
-            return;
-        };
-        if excluded_blocks.contains(block) {
-            return;
+    ) -> StampLayer<'a> {
+        let remap: Vec<u32> = region
+            .palette
+            .iter()
+            .map(|block| {
+                if excluded_blocks.contains(block) {
+                    STAMP_SKIP
+                } else {
+                    self.default_region.get_or_insert_in_palette(block) as u32
+                }
+            })
+            .collect();
+        // Cells a sparse region never allocated read as its air index, which
+        // must be a palette entry for rows to copy verbatim.
+        let identity = region.air_index() < remap.len()
+            && remap.iter().enumerate().all(|(i, &r)| r as usize == i);
+        StampLayer {
+            region,
+            bounds,
+            remap,
+            identity,
         }
-        let destination = BlockPosition {
-            x: destination.0,
-            y: destination.1,
-            z: destination.2,
+    }
+
+    /// Write the source `boxes`, in precedence order, into the default
+    /// region shifted by `offset`, which the caller has checked keeps every
+    /// box in range. A cell comes from the first region whose box holds it;
+    /// an excluded block there keeps the destination cell. Cells move as
+    /// palette-index rows one slab at a time: each region's palette is
+    /// remapped once, rows under an identity remap are a `memcpy`, and the
+    /// rest go through the remap table. Written cells drop their block
+    /// entities and take the source's, sharing its templates.
+    fn stamp_layers(
+        &mut self,
+        boxes: Vec<(&Region, BoundingBox)>,
+        offset: (i64, i64, i64),
+        excluded_blocks: &[BlockState],
+    ) -> Result<(), String> {
+        let Some(union) = boxes
+            .iter()
+            .map(|(_, bounds)| bounds.clone())
+            .reduce(|a, b| a.union(&b))
+        else {
+            return Ok(());
         };
-        self.set_block(destination.x, destination.y, destination.z, block);
-        self.remove_block_entity((destination.x, destination.y, destination.z));
-        let source = BlockPosition {
-            x: source.0,
-            y: source.1,
-            z: source.2,
+        let shift = |p: (i32, i32, i32)| {
+            (
+                (p.0 as i64 + offset.0) as i32,
+                (p.1 as i64 + offset.1) as i32,
+                (p.2 as i64 + offset.2) as i32,
+            )
+        };
+        let unshift = |p: (i32, i32, i32)| {
+            (
+                (p.0 as i64 - offset.0) as i32,
+                (p.1 as i64 - offset.1) as i32,
+                (p.2 as i64 - offset.2) as i32,
+            )
         };
-        if let Some(block_entity) = source_region.get_block_entity(source) {
-            let mut copied = block_entity.clone();
-            copied.position = (destination.x, destination.y, destination.z);
-            self.set_block_entity(destination, copied);
+        if self.default_region.size == (1, 1, 1) && self.default_region.is_empty() {
+            // As in `set_block`: an untouched default region moves to the
+            // stamp instead of growing from the origin.
+            self.default_region = Region::new(
+                self.default_region_name.clone(),
+                shift(union.min),
+                (1, 1, 1),
+            );
+        }
+        let layers: Vec<StampLayer> = boxes
+            .into_iter()
+            .map(|(region, bounds)| self.stamp_layer(region, bounds, excluded_blocks))
+            .collect();
+
+        let width = (union.max.0 as i64 - union.min.0 as i64 + 1) as usize;
+        let length = (union.max.2 as i64 - union.min.2 as i64 + 1) as usize;
+        let slab_height = (STAMP_SLAB_CELLS / (width * length)).clamp(1, i32::MAX as usize) as i64;
+        // X spans, in source coordinates, that earlier layers supply on a row.
+        let mut covered: Vec<(i64, i64)> = Vec::new();
+        let mut y0 = union.min.1 as i64;
+        while y0 <= union.max.1 as i64 {
+            let y1 = (y0 + slab_height - 1).min(union.max.1 as i64);
+            let slab = BoundingBox::new(
+                (union.min.0, y0 as i32, union.min.2),
+                (union.max.0, y1 as i32, union.max.2),
+            );
+            let (dest_min, dest_max) = (shift(slab.min), shift(slab.max));
+            let mut cells = vec![0u32; width * length * (y1 - y0 + 1) as usize];
+            self.default_region
+                .read_palette_indices(dest_min, dest_max, &mut cells)?;
+            for (k, layer) in layers.iter().enumerate() {
+                let Some(part) = layer.bounds.intersection(&slab) else {
+                    continue;
+                };
+                let (w, h, l) = part.get_dimensions();
+                let mut src = vec![0u32; w as usize * h as usize * l as usize];
+                layer
+                    .region
+                    .read_palette_indices(part.min, part.max, &mut src)?;
+                let mut rows = src.chunks_exact(w as usize);
+                for y in part.min.1..=part.max.1 {
+                    for z in part.min.2..=part.max.2 {
+                        let row = rows.next().expect("row count matches box volume");
+                        covered.clear();
+                        covered.extend(
+                            layers[..k]
+                                .iter()
+                                .map(|earlier| &earlier.bounds)
+                                .filter(|b| {
+                                    (b.min.1..=b.max.1).contains(&y)
+                                        && (b.min.2..=b.max.2).contains(&z)
+                                })
+                                .map(|b| (b.min.0 as i64, b.max.0 as i64)),
+                        );
+                        covered.sort_unstable();
+                        let base = ((y as i64 - y0) as usize * length
+                            + (z as i64 - union.min.2 as i64) as usize)
+                            * width;
+                        let mut copy = |from: i64, to: i64| {
+                            let s = (from - part.min.0 as i64) as usize;
+                            let e = (to - part.min.0 as i64) as usize + 1;
+                            let d = base + (from - union.min.0 as i64) as usize;
+                            layer.copy_row(&row[s..e], &mut cells[d..d + e - s]);
+                        };
+                        let end = part.max.0 as i64;
+                        let mut x = part.min.0 as i64;
+                        for &(lo, hi) in &covered {
+                            if lo > x {
+                                copy(x, (lo - 1).min(end));
+                            }
+                            x = x.max(hi + 1);
+                        }
+                        if x <= end {
+                            copy(x, end);
+                        }
+                    }
+                }
+            }
+            self.default_region
+                .write_palette_indices(dest_min, dest_max, &cells)?;
+            y0 = y1 + 1;
+        }
+
+        // A source cell's block entity goes with its block, from the layer
+        // that supplies the cell.
+        let owner = |pos: (i32, i32, i32)| layers.iter().position(|l| l.bounds.contains(pos));
+        let written = |pos: (i32, i32, i32)| owner(pos).is_some_and(|k| layers[k].writes(pos));
+        let dest = BoundingBox::new(shift(union.min), shift(union.max));
+        let store = &mut self.default_region.block_entities;
+        let volume = width * length * (union.max.1 as i64 - union.min.1 as i64 + 1) as usize;
+        if store.len() <= volume {
+            store.retain(|&pos| !(dest.contains(pos) && written(unshift(pos))));
+        } else {
+            for y in union.min.1..=union.max.1 {
+                for z in union.min.2..=union.max.2 {
+                    for x in union.min.0..=union.max.0 {
+                        if written((x, y, z)) {
+                            store.remove(&shift((x, y, z)));
+                        }
+                    }
+                }
+            }
         }
+        for (k, layer) in layers.iter().enumerate() {
+            store.copy_shared_from(&layer.region.block_entities, |pos| {
+                (owner(pos) == Some(k) && layer.writes(pos)).then(|| shift(pos))
+            });
+        }
+        Ok(())
     }
 
     /// Stamp a merged schematic box into the default region. Excluded source blocks are skipped,
     /// preserving the destination. Written cells, including air, clear stale block entities.
+    /// Block entities copied in share the source's templates, so their `position` may be stale.
     pub fn stamp_box(
         &mut self,
         source: &UniversalSchematic,
@@ -1505,24 +1664,13 @@ impl UniversalSchematic {
         Self::stamp_destination(bounds.min, offset)?;
         Self::stamp_destination(bounds.max, offset)?;
         let named_regions = Self::sorted_named_regions(source);
-        for x in bounds.min.0..=bounds.max.0 {
-            for y in bounds.min.1..=bounds.max.1 {
-                for z in bounds.min.2..=bounds.max.2 {
-                    let Some(source_region) =
-                        Self::source_region_at(source, &named_regions, x, y, z)
-                    else {
-                        continue;
-                    };
-                    let destination = Self::stamp_destination((x, y, z), offset)?;
-                    self.stamp_cell_from_region(
-                        source_region,
-                        (x, y, z),
-                        destination,
-                        excluded_blocks,
-                    );
-                }
-            }
-        }
+        // A cell comes from the default region if its content box holds the
+        // cell, else from the first named region by name whose box does.
+        let boxes = std::iter::once(&source.default_region)
+            .chain(named_regions.iter().copied())
+            .filter_map(|region| Some((region, region.get_tight_bounds()?.intersection(bounds)?)))
+            .collect();
+        self.stamp_layers(boxes, offset, excluded_blocks)?;
         for entity in source.default_region.entities.iter().chain(
             named_regions
                 .iter()
@@ -1563,19 +1711,15 @@ impl UniversalSchematic {
         let offset = Self::stamp_offset(&bounds, target);
         Self::stamp_destination(bounds.min, offset)?;
         Self::stamp_destination(bounds.max, offset)?;
-        for x in bounds.min.0..=bounds.max.0 {
-            for y in bounds.min.1..=bounds.max.1 {
-                for z in bounds.min.2..=bounds.max.2 {
-                    let destination = Self::stamp_destination((x, y, z), offset)?;
-                    self.stamp_cell_from_region(
-                        source_region,
-                        (x, y, z),
-                        destination,
-                        excluded_blocks,
-                    );
-                }
-            }
-        }
+        // Entity positions can widen the stamp bounds past the blocks; only
+        // the allocated cells are stamped.
+        let boxes = source_region
+            .get_bounding_box()
+            .intersection(&bounds)
+            .map(|cells| (source_region, cells))
+            .into_iter()
+            .collect();
+        self.stamp_layers(boxes, offset, excluded_blocks)?;
         for entity in &source_region.entities {
             let mut copied = entity.clone();
             copied.position = (
@@ -1604,119 +1748,124 @@ impl UniversalSchematic {
         chunk_height: i32,
         chunk_length: i32,
     ) -> Vec<Chunk> {
-        use std::collections::HashMap;
-        let mut chunk_map: HashMap<(i32, i32, i32), Vec<BlockPosition>> = HashMap::new();
-
-        // Helper function to get chunk coordinate
-        let get_chunk_coord = |pos: i32, chunk_size: i32| -> i32 {
-            let offset = if pos < 0 { chunk_size - 1 } else { 0 };
-            (pos - offset) / chunk_size
-        };
-
-        // Process default region - skip air blocks for consistency with split_into_chunks_indices
-        for (index, &palette_index) in self.default_region.blocks.iter().enumerate() {
-            if palette_index == 0 {
-                continue; // Skip air blocks
-            }
-
-            let (x, y, z) = self.default_region.index_to_coords(index);
-            let chunk_x = get_chunk_coord(x, chunk_width);
-            let chunk_y = get_chunk_coord(y, chunk_height);
-            let chunk_z = get_chunk_coord(z, chunk_length);
-            let chunk_key = (chunk_x, chunk_y, chunk_z);
-
-            chunk_map
-                .entry(chunk_key)
-                .or_default()
-                .push(BlockPosition { x, y, z });
-        }
-
-        // Process other regions - skip air blocks for consistency with split_into_chunks_indices
-        for region in self.other_regions.values() {
-            for (index, &palette_index) in region.blocks.iter().enumerate() {
-                if palette_index == 0 {
-                    continue; // Skip air blocks
-                }
-
-                let (x, y, z) = region.index_to_coords(index);
-                let chunk_x = get_chunk_coord(x, chunk_width);
-                let chunk_y = get_chunk_coord(y, chunk_height);
-                let chunk_z = get_chunk_coord(z, chunk_length);
-                let chunk_key = (chunk_x, chunk_y, chunk_z);
-
-                chunk_map
-                    .entry(chunk_key)
-                    .or_default()
-                    .push(BlockPosition { x, y, z });
-            }
-        }
-
-        chunk_map
-            .into_iter()
+        self.group_into_chunks((chunk_width, chunk_height, chunk_length), |pos, _| pos)
+            .iter()
             .map(|((chunk_x, chunk_y, chunk_z), positions)| Chunk {
                 chunk_x,
                 chunk_y,
                 chunk_z,
-                positions,
+                positions: positions.to_vec(),
             })
             .collect()
     }
 
-    pub fn iter_blocks(&self) -> impl Iterator<Item = (BlockPosition, &BlockState)> {
-        // Create an iterator that chains default region and other regions
-        let default_iter = self.default_region.blocks.iter().enumerate().filter_map(
-            move |(index, block_index)| {
-                let (x, y, z) = self.default_region.index_to_coords(index);
-                Some((
-                    BlockPosition { x, y, z },
-                    &self.default_region.palette[*block_index],
-                ))
-            },
-        );
-
-        let other_iter = self.other_regions.values().flat_map(|region| {
-            region
-                .blocks
-                .iter()
-                .enumerate()
-                .filter_map(move |(index, block_index)| {
-                    let (x, y, z) = region.index_to_coords(index);
-                    Some((BlockPosition { x, y, z }, &region.palette[*block_index]))
-                })
-        });
-
-        default_iter.chain(other_iter)
+    /// Non-air blocks of every region as `(position, palette_index)`,
+    /// grouped by chunk into borrowed slices of one buffer. Palette indices
+    /// refer to the block's own region, as in [`Self::iter_blocks_indices`].
+    pub fn chunked_blocks(
+        &self,
+        chunk_width: i32,
+        chunk_height: i32,
+        chunk_length: i32,
+    ) -> ChunkedBlocks<(BlockPosition, usize)> {
+        self.group_into_chunks((chunk_width, chunk_height, chunk_length), |pos, index| {
+            (pos, index)
+        })
     }
 
-    pub fn iter_blocks_indices(&self) -> impl Iterator<Item = (BlockPosition, usize)> + '_ {
-        // Iterator for default region - returns palette indices directly
-        let default_iter = self.default_region.blocks.iter().enumerate().filter_map(
-            move |(index, &palette_index)| {
-                // Skip air blocks (usually index 0) to reduce data transfer
-                if palette_index == 0 {
-                    return None;
+    /// Collect `make(position, palette_index)` for every cell whose index is
+    /// not 0 (air), region by region and chunk by chunk, each chunk's cells
+    /// in storage order. Only chunks inside a region's scanned box are
+    /// visited, and air runs within a row are skipped in one search.
+    fn group_into_chunks<T: Copy>(
+        &self,
+        chunk_size: (i32, i32, i32),
+        make: impl Fn(BlockPosition, usize) -> T,
+    ) -> ChunkedBlocks<T> {
+        let (cw, ch, cl) = chunk_size;
+        let mut items = Vec::new();
+        let mut runs = Vec::new();
+        let lo = |v: i32, size: i32| v.div_euclid(size);
+        let chunk_span = |c: i32, size: i32| {
+            let min = c.saturating_mul(size);
+            (min, min.saturating_add(size - 1))
+        };
+        for region in std::iter::once(&self.default_region).chain(self.other_regions.values()) {
+            // With air at index 0, tight bounds and section counts describe
+            // exactly the cells to collect.
+            let air_is_zero = region.air_index() == 0;
+            let scan = match region.get_tight_bounds() {
+                Some(tight) if air_is_zero => tight,
+                _ => region.get_bounding_box(),
+            };
+            for cy in lo(scan.min.1, ch)..=lo(scan.max.1, ch) {
+                let (y0, y1) = chunk_span(cy, ch);
+                for cz in lo(scan.min.2, cl)..=lo(scan.max.2, cl) {
+                    let (z0, z1) = chunk_span(cz, cl);
+                    for cx in lo(scan.min.0, cw)..=lo(scan.max.0, cw) {
+                        let (x0, x1) = chunk_span(cx, cw);
+                        let cell_box = BoundingBox::new(
+                            (x0.max(scan.min.0), y0.max(scan.min.1), z0.max(scan.min.2)),
+                            (x1.min(scan.max.0), y1.min(scan.max.1), z1.min(scan.max.2)),
+                        );
+                        if air_is_zero && !region.may_have_blocks_in(cell_box.min, cell_box.max) {
+                            continue;
+                        }
+                        let start = items.len();
+                        items.extend(
+                            region
+                                .cells_ne_in(&cell_box, 0)
+                                .map(|((x, y, z), index)| make(BlockPosition { x, y, z }, index)),
+                        );
+                        if items.len() > start {
+                            runs.push(((cx, cy, cz), start..items.len()));
+                        }
+                    }
                 }
-                let (x, y, z) = self.default_region.index_to_coords(index);
-                Some((BlockPosition { x, y, z }, palette_index))
-            },
-        );
+            }
+        }
+        ChunkedBlocks::from_runs(items, runs)
+    }
 
-        // Iterator for other regions
-        let other_iter = self.other_regions.values().flat_map(|region| {
-            region
-                .blocks
-                .iter()
-                .enumerate()
-                .filter_map(move |(index, &palette_index)| {
-                    if palette_index == 0 {
-                        return None;
-                    }
-                    let (x, y, z) = region.index_to_coords(index);
-                    Some((BlockPosition { x, y, z }, palette_index))
+    pub fn iter_blocks(&self) -> impl Iterator<Item = (BlockPosition, &BlockState)> {
+        std::iter::once(&self.default_region)
+            .chain(self.other_regions.values())
+            .flat_map(|region| {
+                region.iter_cells().map(move |((x, y, z), block_index)| {
+                    (BlockPosition { x, y, z }, &region.palette[block_index])
+                })
+            })
+    }
+
+    /// Every cell of [`UniversalSchematic::iter_blocks`], in the same order,
+    /// with the block's interned [`StateId`]. Lets callers group cells by
+    /// state with integer keys instead of hashing each `BlockState`.
+    pub fn iter_blocks_with_ids(
+        &self,
+    ) -> impl Iterator<Item = (BlockPosition, StateId, &BlockState)> {
+        std::iter::once(&self.default_region)
+            .chain(self.other_regions.values())
+            .flat_map(|region| {
+                let ids = region.palette_ids();
+                region.iter_cells().map(move |((x, y, z), block_index)| {
+                    (
+                        BlockPosition { x, y, z },
+                        ids[block_index],
+                        &region.palette[block_index],
+                    )
                 })
-        });
+            })
+    }
 
-        default_iter.chain(other_iter)
+    pub fn iter_blocks_indices(&self) -> impl Iterator<Item = (BlockPosition, usize)> + '_ {
+        // Skip air blocks (usually index 0) to reduce data transfer
+        std::iter::once(&self.default_region)
+            .chain(self.other_regions.values())
+            .flat_map(|region| {
+                region
+                    .cells_ne(0)
+                    .map(|((x, y, z), palette_index)| (BlockPosition { x, y, z }, palette_index))
+            })
     }
 
     pub fn iter_chunks_indices(
@@ -1726,147 +1875,150 @@ impl UniversalSchematic {
         chunk_length: i32,
         strategy: Option<ChunkLoadingStrategy>,
     ) -> impl Iterator<Item = ChunkIndices> + '_ {
-        let chunks = self.split_into_chunks_indices(chunk_width, chunk_height, chunk_length);
-
-        // Apply sorting based on strategy (same logic as before)
-        let mut ordered_chunks = chunks;
+        let mut ordered_chunks =
+            self.split_into_chunks_indices(chunk_width, chunk_height, chunk_length);
         if let Some(strategy) = strategy {
-            match strategy {
-                ChunkLoadingStrategy::Default => {
-                    // Default order - no sorting needed
-                }
-                ChunkLoadingStrategy::DistanceToCamera(cam_x, cam_y, cam_z) => {
-                    ordered_chunks.sort_by(|a, b| {
-                        let a_center_x = (a.chunk_x * chunk_width) + (chunk_width / 2);
-                        let a_center_y = (a.chunk_y * chunk_height) + (chunk_height / 2);
-                        let a_center_z = (a.chunk_z * chunk_length) + (chunk_length / 2);
-
-                        let b_center_x = (b.chunk_x * chunk_width) + (chunk_width / 2);
-                        let b_center_y = (b.chunk_y * chunk_height) + (chunk_height / 2);
-                        let b_center_z = (b.chunk_z * chunk_length) + (chunk_length / 2);
-
-                        let a_dist = (a_center_x as f32 - cam_x).powi(2)
-                            + (a_center_y as f32 - cam_y).powi(2)
-                            + (a_center_z as f32 - cam_z).powi(2);
-
-                        let b_dist = (b_center_x as f32 - cam_x).powi(2)
-                            + (b_center_y as f32 - cam_y).powi(2)
-                            + (b_center_z as f32 - cam_z).powi(2);
-
-                        a_dist
-                            .partial_cmp(&b_dist)
-                            .unwrap_or(std::cmp::Ordering::Equal)
-                    });
-                }
-                ChunkLoadingStrategy::TopDown => {
-                    ordered_chunks.sort_by(|a, b| b.chunk_y.cmp(&a.chunk_y));
-                }
-                ChunkLoadingStrategy::BottomUp => {
-                    ordered_chunks.sort_by(|a, b| a.chunk_y.cmp(&b.chunk_y));
-                }
-                ChunkLoadingStrategy::CenterOutward => {
-                    let (width, height, depth) = self.get_dimensions();
-                    let center_x = (width / 2) / chunk_width;
-                    let center_y = (height / 2) / chunk_height;
-                    let center_z = (depth / 2) / chunk_length;
-
-                    ordered_chunks.sort_by(|a, b| {
-                        let a_dist = (a.chunk_x - center_x).pow(2)
-                            + (a.chunk_y - center_y).pow(2)
-                            + (a.chunk_z - center_z).pow(2);
-
-                        let b_dist = (b.chunk_x - center_x).pow(2)
-                            + (b.chunk_y - center_y).pow(2)
-                            + (b.chunk_z - center_z).pow(2);
-
-                        a_dist.cmp(&b_dist)
-                    });
-                }
-                ChunkLoadingStrategy::Random => {
-                    use std::collections::hash_map::DefaultHasher;
-                    use std::hash::{Hash, Hasher};
-
-                    let mut hasher = DefaultHasher::new();
-                    if let Some(name) = &self.metadata.name {
-                        name.hash(&mut hasher);
-                    } else {
-                        "Default".hash(&mut hasher);
-                    }
-                    let seed = hasher.finish();
+            self.order_chunks(
+                &mut ordered_chunks,
+                |c| (c.chunk_x, c.chunk_y, c.chunk_z),
+                (chunk_width, chunk_height, chunk_length),
+                strategy,
+            );
+        }
+        ordered_chunks.into_iter()
+    }
 
-                    let mut rng = rand::rngs::StdRng::seed_from_u64(seed);
-                    use rand::seq::SliceRandom;
-                    ordered_chunks.shuffle(&mut rng);
+    /// Sort `items` (anything keyed by a chunk coordinate) by `strategy`, the
+    /// ordering shared by [`Self::iter_chunks_indices`] and [`ChunkCursor`].
+    pub(crate) fn order_chunks<T>(
+        &self,
+        items: &mut [T],
+        coord: impl Fn(&T) -> (i32, i32, i32),
+        chunk_size: (i32, i32, i32),
+        strategy: ChunkLoadingStrategy,
+    ) {
+        let (chunk_width, chunk_height, chunk_length) = chunk_size;
+        match strategy {
+            ChunkLoadingStrategy::Default => {
+                // Default order - no sorting needed
+            }
+            ChunkLoadingStrategy::DistanceToCamera(cam_x, cam_y, cam_z) => {
+                let dist = |c: (i32, i32, i32)| {
+                    let center_x = (c.0 * chunk_width) + (chunk_width / 2);
+                    let center_y = (c.1 * chunk_height) + (chunk_height / 2);
+                    let center_z = (c.2 * chunk_length) + (chunk_length / 2);
+                    (center_x as f32 - cam_x).powi(2)
+                        + (center_y as f32 - cam_y).powi(2)
+                        + (center_z as f32 - cam_z).powi(2)
+                };
+                items.sort_by(|a, b| {
+                    dist(coord(a))
+                        .partial_cmp(&dist(coord(b)))
+                        .unwrap_or(std::cmp::Ordering::Equal)
+                });
+            }
+            ChunkLoadingStrategy::TopDown => {
+                items.sort_by(|a, b| coord(b).1.cmp(&coord(a).1));
+            }
+            ChunkLoadingStrategy::BottomUp => {
+                items.sort_by(|a, b| coord(a).1.cmp(&coord(b).1));
+            }
+            ChunkLoadingStrategy::CenterOutward => {
+                let (width, height, depth) = self.get_dimensions();
+                let center_x = (width / 2) / chunk_width;
+                let center_y = (height / 2) / chunk_height;
+                let center_z = (depth / 2) / chunk_length;
+                let dist = |c: (i32, i32, i32)| {
+                    (c.0 - center_x).pow(2) + (c.1 - center_y).pow(2) + (c.2 - center_z).pow(2)
+                };
+                items.sort_by(|a, b| dist(coord(a)).cmp(&dist(coord(b))));
+            }
+            ChunkLoadingStrategy::Random => {
+                use std::collections::hash_map::DefaultHasher;
+                use std::hash::{Hash, Hasher};
+
+                let mut hasher = DefaultHasher::new();
+                if let Some(name) = &self.metadata.name {
+                    name.hash(&mut hasher);
+                } else {
+                    "Default".hash(&mut hasher);
                 }
+                let seed = hasher.finish();
+
+                let mut rng = rand::rngs::StdRng::seed_from_u64(seed);
+                use rand::seq::SliceRandom;
+                items.shuffle(&mut rng);
             }
         }
-
-        ordered_chunks.into_iter()
     }
 
-    fn split_into_chunks_indices(
+    /// A [`ChunkCursor`] over every region, ordered by `strategy`. Only chunk
+    /// coordinates are computed here; block data is read as the cursor
+    /// advances. Errors when a chunk dimension is not positive.
+    pub fn chunk_cursor(
         &self,
         chunk_width: i32,
         chunk_height: i32,
         chunk_length: i32,
-    ) -> Vec<ChunkIndices> {
-        use std::collections::HashMap;
-        let mut chunk_map: HashMap<(i32, i32, i32), Vec<(BlockPosition, usize)>> = HashMap::new();
-
-        // Helper function to get chunk coordinate
-        let get_chunk_coord = |pos: i32, chunk_size: i32| -> i32 {
-            let offset = if pos < 0 { chunk_size - 1 } else { 0 };
-            (pos - offset) / chunk_size
-        };
-
-        // Process default region
-        for (index, &palette_index) in self.default_region.blocks.iter().enumerate() {
-            if palette_index == 0 {
-                continue; // Skip air blocks
-            }
-
-            let (x, y, z) = self.default_region.index_to_coords(index);
-            let chunk_x = get_chunk_coord(x, chunk_width);
-            let chunk_y = get_chunk_coord(y, chunk_height);
-            let chunk_z = get_chunk_coord(z, chunk_length);
-            let chunk_key = (chunk_x, chunk_y, chunk_z);
-
-            chunk_map
-                .entry(chunk_key)
-                .or_default()
-                .push((BlockPosition { x, y, z }, palette_index));
+        strategy: ChunkLoadingStrategy,
+    ) -> Result<ChunkCursor, String> {
+        let chunk_size = (chunk_width, chunk_height, chunk_length);
+        if chunk_width <= 0 || chunk_height <= 0 || chunk_length <= 0 {
+            return Err(format!("chunk size must be positive, got {chunk_size:?}"));
         }
+        (chunk_width as usize)
+            .checked_mul(chunk_height as usize)
+            .and_then(|v| v.checked_mul(chunk_length as usize))
+            .ok_or_else(|| format!("chunk size {chunk_size:?} overflows"))?;
 
-        // Process other regions
-        for region in self.other_regions.values() {
-            for (index, &palette_index) in region.blocks.iter().enumerate() {
-                if palette_index == 0 {
-                    continue; // Skip air blocks
-                }
+        let mut region_names = vec![self.default_region_name.clone()];
+        let mut named: Vec<&String> = self.other_regions.keys().collect();
+        named.sort();
+        region_names.extend(named.into_iter().cloned());
 
-                let (x, y, z) = region.index_to_coords(index);
-                let chunk_x = get_chunk_coord(x, chunk_width);
-                let chunk_y = get_chunk_coord(y, chunk_height);
-                let chunk_z = get_chunk_coord(z, chunk_length);
-                let chunk_key = (chunk_x, chunk_y, chunk_z);
-
-                chunk_map
-                    .entry(chunk_key)
-                    .or_default()
-                    .push((BlockPosition { x, y, z }, palette_index));
+        let mut order = Vec::new();
+        for (slot, name) in region_names.iter().enumerate() {
+            let Some(bounds) = self.get_region(name).and_then(|r| r.get_tight_bounds()) else {
+                continue;
+            };
+            let lo = |v: i32, size: i32| v.div_euclid(size);
+            for cy in lo(bounds.min.1, chunk_height)..=lo(bounds.max.1, chunk_height) {
+                for cz in lo(bounds.min.2, chunk_length)..=lo(bounds.max.2, chunk_length) {
+                    for cx in lo(bounds.min.0, chunk_width)..=lo(bounds.max.0, chunk_width) {
+                        order.push((slot, (cx, cy, cz)));
+                    }
+                }
             }
         }
+        self.order_chunks(&mut order, |entry| entry.1, chunk_size, strategy);
+
+        Ok(ChunkCursor {
+            chunk_size,
+            region_names,
+            order,
+            next: 0,
+            current: None,
+            indices: Vec::new(),
+        })
+    }
 
-        chunk_map
-            .into_iter()
+    fn split_into_chunks_indices(
+        &self,
+        chunk_width: i32,
+        chunk_height: i32,
+        chunk_length: i32,
+    ) -> Vec<ChunkIndices> {
+        self.chunked_blocks(chunk_width, chunk_height, chunk_length)
+            .iter()
             .map(|((chunk_x, chunk_y, chunk_z), blocks)| ChunkIndices {
                 chunk_x,
                 chunk_y,
                 chunk_z,
-                blocks,
+                blocks: blocks.to_vec(),
             })
             .collect()
     }
+
     pub fn get_all_palettes(&self) -> AllPalettes {
         let mut all_palettes = AllPalettes {
             default_palette: self.default_region.palette.clone(),
@@ -1921,7 +2073,7 @@ impl UniversalSchematic {
                     for z in start_z..end_z {
                         for x in start_x..end_x {
                             let index = region.coords_to_index(x, y, z);
-                            if let Some(&palette_index) = region.blocks.get(index) {
+                            if let Some(palette_index) = region.blocks.get(index) {
                                 // Skip if it matches the air index
                                 let is_air = match air_index {
                                     Some(idx) => palette_index == idx,
@@ -1956,106 +2108,16 @@ impl UniversalSchematic {
         chunk_length: i32,
         strategy: Option<ChunkLoadingStrategy>,
     ) -> impl Iterator<Item = Chunk> + '_ {
-        let chunks = self.split_into_chunks(chunk_width, chunk_height, chunk_length);
-
-        // Apply sorting based on strategy
-        let mut ordered_chunks = chunks;
+        let mut ordered_chunks = self.split_into_chunks(chunk_width, chunk_height, chunk_length);
         if let Some(strategy) = strategy {
-            match strategy {
-                ChunkLoadingStrategy::Default => {
-                    // Default order - no sorting needed
-                }
-                ChunkLoadingStrategy::DistanceToCamera(cam_x, cam_y, cam_z) => {
-                    // Sort by distance to camera
-                    ordered_chunks.sort_by(|a, b| {
-                        let a_center_x = (a.chunk_x * chunk_width) + (chunk_width / 2);
-                        let a_center_y = (a.chunk_y * chunk_height) + (chunk_height / 2);
-                        let a_center_z = (a.chunk_z * chunk_length) + (chunk_length / 2);
-
-                        let b_center_x = (b.chunk_x * chunk_width) + (chunk_width / 2);
-                        let b_center_y = (b.chunk_y * chunk_height) + (chunk_height / 2);
-                        let b_center_z = (b.chunk_z * chunk_length) + (chunk_length / 2);
-
-                        let a_dist = (a_center_x as f32 - cam_x).powi(2)
-                            + (a_center_y as f32 - cam_y).powi(2)
-                            + (a_center_z as f32 - cam_z).powi(2);
-
-                        let b_dist = (b_center_x as f32 - cam_x).powi(2)
-                            + (b_center_y as f32 - cam_y).powi(2)
-                            + (b_center_z as f32 - cam_z).powi(2);
-
-                        // Sort by ascending distance (closest first)
-                        a_dist
-                            .partial_cmp(&b_dist)
-                            .unwrap_or(std::cmp::Ordering::Equal)
-                    });
-                }
-                ChunkLoadingStrategy::TopDown => {
-                    // Sort by y-coordinate, highest first
-                    ordered_chunks.sort_by(|a, b| b.chunk_y.cmp(&a.chunk_y));
-                }
-                ChunkLoadingStrategy::BottomUp => {
-                    // Sort by y-coordinate, lowest first
-                    ordered_chunks.sort_by(|a, b| a.chunk_y.cmp(&b.chunk_y));
-                }
-                ChunkLoadingStrategy::CenterOutward => {
-                    // Calculate schematic center in chunk coordinates
-                    let (width, height, depth) = self.get_dimensions();
-                    let center_x = (width / 2) / chunk_width;
-                    let center_y = (height / 2) / chunk_height;
-                    let center_z = (depth / 2) / chunk_length;
-
-                    // Sort by distance from center
-                    ordered_chunks.sort_by(|a, b| {
-                        let a_dist = (a.chunk_x - center_x).pow(2)
-                            + (a.chunk_y - center_y).pow(2)
-                            + (a.chunk_z - center_z).pow(2);
-
-                        let b_dist = (b.chunk_x - center_x).pow(2)
-                            + (b.chunk_y - center_y).pow(2)
-                            + (b.chunk_z - center_z).pow(2);
-
-                        a_dist.cmp(&b_dist)
-                    });
-                }
-                ChunkLoadingStrategy::Random => {
-                    // Shuffle the chunks using a deterministic seed
-                    use std::collections::hash_map::DefaultHasher;
-                    use std::hash::{Hash, Hasher};
-
-                    let mut hasher = DefaultHasher::new();
-                    if let Some(name) = &self.metadata.name {
-                        name.hash(&mut hasher);
-                    } else {
-                        "Default".hash(&mut hasher);
-                    }
-                    let seed = hasher.finish();
-
-                    let mut rng = rand::rngs::StdRng::seed_from_u64(seed);
-                    use rand::seq::SliceRandom;
-                    ordered_chunks.shuffle(&mut rng);
-                }
-            }
+            self.order_chunks(
+                &mut ordered_chunks,
+                |c| (c.chunk_x, c.chunk_y, c.chunk_z),
+                (chunk_width, chunk_height, chunk_length),
+                strategy,
+            );
         }
-
-        // Process each chunk like in the original implementation
-        ordered_chunks.into_iter().map(move |chunk| {
-            let positions = chunk.positions;
-            let blocks = positions
-                .into_iter()
-                .filter_map(|pos| {
-                    self.get_block(pos.x, pos.y, pos.z)
-                        .map(|block| (pos, block))
-                })
-                .collect::<Vec<_>>();
-
-            Chunk {
-                chunk_x: chunk.chunk_x,
-                chunk_y: chunk.chunk_y,
-                chunk_z: chunk.chunk_z,
-                positions: blocks.iter().map(|(pos, _)| *pos).collect(),
-            }
-        })
+        ordered_chunks.into_iter()
     }
 
     // Keep the original method for backward compatibility
@@ -2068,32 +2130,22 @@ impl UniversalSchematic {
         self.iter_chunks(chunk_width, chunk_height, chunk_length, None)
     }
 
-    fn parse_block_string_cached(
-        &mut self,
-        block_string: &str,
-    ) -> Result<(BlockState, Option<std::sync::Arc<NbtMap>>), String> {
-        if let Some((state, nbt)) = self.block_string_cache.get(block_string) {
-            return Ok((state.clone(), nbt.clone()));
-        }
-
-        let (mut block_state, nbt_data) = Self::parse_block_string(block_string)?;
-        if block_state.name == "minecraft:jukebox" {
-            let has_record = nbt_data
-                .as_ref()
-                .is_some_and(|nbt| nbt.contains_key("RecordItem"));
-            block_state.set_property("has_record", has_record.to_string());
-        }
-
-        let nbt = nbt_data.map(|data| {
-            let mut map = NbtMap::new();
-            for (key, value) in data {
-                map.insert(key, value);
+    /// Parse through the process-wide [`block_string_cache`], so repeated
+    /// placements of the same string (e.g. filling 100k identical chests)
+    /// skip property and NBT parsing.
+    fn parse_block_string_cached(block_string: &str) -> Result<block_string_cache::Parsed, String> {
+        block_string_cache::get_or_parse(block_string, |block_string| {
+            let (mut block_state, nbt_data) = Self::parse_block_string(block_string)?;
+            if block_state.name == "minecraft:jukebox" {
+                let has_record = nbt_data
+                    .as_ref()
+                    .is_some_and(|nbt| nbt.contains_key("RecordItem"));
+                block_state.set_property("has_record", has_record.to_string());
             }
-            std::sync::Arc::new(map)
-        });
-        self.block_string_cache
-            .insert(block_string.to_string(), (block_state.clone(), nbt.clone()));
-        Ok((block_state, nbt))
+            let nbt =
+                nbt_data.map(|data| std::sync::Arc::new(data.into_iter().collect::<NbtMap>()));
+            Ok((block_state, nbt))
+        })
     }
 
     pub fn set_block_from_string(
@@ -2103,7 +2155,7 @@ impl UniversalSchematic {
         z: i32,
         block_string: &str,
     ) -> Result<bool, String> {
-        let (block_state, nbt) = self.parse_block_string_cached(block_string)?;
+        let (block_state, nbt) = Self::parse_block_string_cached(block_string)?;
 
         // Set the basic block first
         if !self.set_block(x, y, z, &block_state) {
@@ -2176,47 +2228,21 @@ impl UniversalSchematic {
     pub fn parse_block_string(
         block_string: &str,
     ) -> Result<(BlockState, Option<HashMap<String, NbtValue>>), String> {
-        Self::validate_block_string_delimiters(block_string)?;
-        let (block_state_str, nbt_str) = match block_string.split_once('{') {
-            Some((block_state, nbt)) => {
-                let nbt = nbt
-                    .strip_suffix('}')
-                    .ok_or("Missing block entity closing brace")?;
-                (block_state.trim(), Some(nbt))
-            }
-            None => (block_string.trim(), None),
-        };
-
-        // Parse block state
-        let block_state = if block_state_str.contains('[') {
-            let mut state_parts = block_state_str.splitn(2, '[');
-            let block_name = state_parts.next().unwrap();
-            let properties_str = state_parts
-                .next()
-                .ok_or("Missing properties closing bracket")?
-                .strip_suffix(']')
-                .ok_or("Missing properties closing bracket")?;
-
-            let mut properties = Vec::new();
-            for prop in properties_str.split(',') {
-                let (key, value) = prop
-                    .split_once('=')
-                    .ok_or("Missing property key or value")?;
-                let key = key.trim();
-                let value = value.trim().trim_matches(|c| c == '\'' || c == '"');
-                if key.is_empty() || value.is_empty() || value.contains('=') {
-                    return Err("Malformed block property".to_string());
-                }
-                properties.push((SmolStr::from(key), SmolStr::from(value)));
+        let parts = split_block_string(block_string)?;
+
+        let block_state = match parts.properties {
+            Some(_) => {
+                let properties = parts
+                    .properties()
+                    .map(|prop| prop.map(|(key, value)| (SmolStr::from(key), SmolStr::from(value))))
+                    .collect::<Result<Vec<_>, String>>()?;
+                BlockState::new(parts.name).with_properties(properties)
             }
-
-            BlockState::new(block_name.to_string()).with_properties(properties)
-        } else {
-            BlockState::new(block_state_str.to_string())
+            None => BlockState::new(parts.name),
         };
 
         // Parse NBT data if present using enhanced parser
-        let nbt_data = if let Some(nbt_str) = nbt_str {
+        let nbt_data = if let Some(nbt_str) = parts.nbt {
             let parsed = crate::utils::parse_enhanced_nbt(block_state.get_name(), nbt_str)?;
             if parsed.is_empty() {
                 None
@@ -2230,51 +2256,6 @@ impl UniversalSchematic {
         Ok((block_state, nbt_data))
     }
 
-    fn validate_block_string_delimiters(block_string: &str) -> Result<(), String> {
-        let mut stack = Vec::new();
-        let mut quote = None;
-        let mut escaped = false;
-
-        for c in block_string.chars() {
-            if quote.is_some() && c == '\\' && !escaped {
-                escaped = true;
-                continue;
-            }
-            if matches!(c, '\'' | '"') && !escaped {
-                match quote {
-                    Some(active) if active == c => quote = None,
-                    None => quote = Some(c),
-                    _ => {}
-                }
-                continue;
-            }
-            if quote.is_none() {
-                match (c, stack.last().copied()) {
-                    ('[' | '{', _) => stack.push(c),
-                    (']', Some('[')) | ('}', Some('{')) => {
-                        stack.pop();
-                    }
-                    (']', _) => {
-                        return Err("Unmatched or misordered ']' in block string".to_string());
-                    }
-                    ('}', _) => {
-                        return Err("Unmatched or misordered '}' in block string".to_string());
-                    }
-                    _ => {}
-                }
-            }
-            escaped = false;
-        }
-
-        if quote.is_some() {
-            return Err("Unterminated quoted string in block string".to_string());
-        }
-        if !stack.is_empty() {
-            return Err("Unclosed delimiter in block string".to_string());
-        }
-        Ok(())
-    }
-
     pub fn create_schematic_from_region(&self, bounds: &BoundingBox) -> Self {
         let mut new_schematic =
             UniversalSchematic::new(format!("Region_{}", self.default_region_name));
@@ -2303,11 +2284,7 @@ impl UniversalSchematic {
                     let pos = BlockPosition { x, y, z };
                     if let Some(block_entity) = self.get_block_entity(pos) {
                         let mut new_block_entity = block_entity.clone();
-                        new_block_entity.position = (
-                            block_entity.position.0 + offset.0,
-                            block_entity.position.1 + offset.1,
-                            block_entity.position.2 + offset.2,
-                        );
+                        new_block_entity.position = (x + offset.0, y + offset.1, z + offset.2);
                         new_schematic.set_block_entity(
                             BlockPosition {
                                 x: x + offset.0,
@@ -2372,17 +2349,20 @@ impl UniversalSchematic {
         new_schematic
     }
 
+    /// Clear this schematic's plain-id cache. The shared block-string cache
+    /// is left alone; see [`block_string_cache::clear`].
     pub fn clear_block_state_cache(&mut self) {
         self.block_state_cache.clear();
-        self.block_string_cache.clear();
     }
 
-    /// Get cache statistics for debugging
-    pub fn cache_stats(&self) -> (usize, usize) {
-        (
-            self.block_state_cache.len(),
-            self.block_state_cache.capacity(),
-        )
+    /// Occupancy of this schematic's plain-id cache, and hit rates of the
+    /// shared block-string cache.
+    pub fn cache_stats(&self) -> SchematicCacheStats {
+        SchematicCacheStats {
+            block_states: self.block_state_cache.len(),
+            block_state_capacity: self.block_state_cache.capacity(),
+            block_strings: block_string_cache::stats(),
+        }
     }
 
     // Transformation methods (convenience wrappers for the default region)
@@ -2404,6 +2384,17 @@ impl UniversalSchematic {
         Self::checked_coord(target as i64 - current as i64)
     }
 
+    /// Move every region onto sparse, copy-on-write section storage (see
+    /// [`Region::make_sparse`]). Clones of the schematic then share block
+    /// sections and copy only the 16³ sections they write to, which makes a
+    /// base that is cloned and lightly edited many times cheap to clone.
+    pub fn make_sparse(&mut self) {
+        self.default_region.make_sparse();
+        for region in self.other_regions.values_mut() {
+            region.make_sparse();
+        }
+    }
+
     /// Flip the default region along the X axis.
     pub fn flip_x(&mut self) {
         self.default_region.flip_x();
@@ -2707,21 +2698,18 @@ impl UniversalSchematic {
 }
 
 pub fn is_redstone_connectable(block: &BlockState) -> bool {
-    let name = block.name.as_str();
-    name == "minecraft:redstone_wire"
-        || name == "minecraft:repeater"
-        || name == "minecraft:comparator"
-        || name == "minecraft:observer"
-        || name == "minecraft:target"
+    crate::blockpedia::block_flags(&block.name).is_some_and(|f| f.is_redstone_connectable())
 }
 
+/// Whether `block` is a full, non-transparent cube by the block table; ids
+/// outside the table fall back to a name check.
 pub fn is_opaque(block: &BlockState) -> bool {
+    if let Some(flags) = crate::blockpedia::block_flags(&block.name) {
+        return flags.is_opaque();
+    }
     let name = block.name.as_str();
     // Simplified opaque check - most common non-opaque blocks
-    !(name == "minecraft:air"
-        || name == "minecraft:cave_air"
-        || name == "minecraft:void_air"
-        || name.contains("glass")
+    !(name.contains("glass")
         || name.contains("slab")
         || name.contains("stairs")
         || name.contains("fence")
@@ -2732,12 +2720,7 @@ pub fn is_opaque(block: &BlockState) -> bool {
         || name.contains("torch")
         || name.contains("button")
         || name.contains("pressure_plate")
-        || name.contains("sign")
-        || name == "minecraft:redstone_wire"
-        || name == "minecraft:repeater"
-        || name == "minecraft:comparator"
-        || name == "minecraft:lever"
-        || name == "minecraft:hopper")
+        || name.contains("sign"))
 }
 
 #[cfg(test)]
@@ -2745,9 +2728,68 @@ mod tests {
     use super::*;
 
     use crate::item::ItemStack;
+    use crate::memory::RegionMemory;
     use quartz_nbt::io::{read_nbt, write_nbt};
     use std::io::Cursor;
 
+    #[test]
+    fn block_flags_drive_opacity_and_wire_connections() {
+        let block = |name: &str| BlockState::new(name.to_string());
+        assert!(is_opaque(&block("minecraft:stone")));
+        for name in [
+            "minecraft:air",
+            "minecraft:glass",
+            "minecraft:oak_leaves",
+            "minecraft:white_carpet",
+            "minecraft:oak_slab",
+        ] {
+            assert!(!is_opaque(&block(name)), "{name}");
+        }
+        // Ids outside the block table fall back to the name check.
+        assert!(is_opaque(&block("mymod:marble")));
+        assert!(!is_opaque(&block("mymod:marble_slab")));
+
+        assert!(is_redstone_connectable(&block("minecraft:repeater")));
+        assert!(!is_redstone_connectable(&block("minecraft:stone")));
+    }
+
+    #[test]
+    fn redstone_connectivity_follows_neighbours_and_slopes() {
+        let mut s = UniversalSchematic::new("wires".to_string());
+        let wire = BlockState::new("minecraft:redstone_wire".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        // A run along x at y = 0 climbing onto stone at x = 3.
+        for x in 0..3 {
+            s.set_block(x, 0, 0, &wire);
+        }
+        s.set_block(3, 0, 0, &stone);
+        s.set_block(3, 1, 0, &wire);
+        // A lone wire, and the region's far corner so y = 2 is open air.
+        s.set_block(0, 0, 4, &wire);
+        s.set_block(5, 2, 5, &BlockState::new("minecraft:air".to_string()));
+        s.fix_redstone_connectivity();
+
+        let sides = |x, y, z| -> Vec<String> {
+            let block = s.get_block(x, y, z).unwrap();
+            ["north", "south", "east", "west"]
+                .iter()
+                .map(|d| block.get_property(d).unwrap().to_string())
+                .collect()
+        };
+        // One connection: the opposite side joins it.
+        assert_eq!(sides(0, 0, 0), ["none", "none", "side", "side"]);
+        assert_eq!(sides(1, 0, 0), ["none", "none", "side", "side"]);
+        assert_eq!(sides(2, 0, 0), ["none", "none", "up", "side"]);
+        // The top wire reaches down to (2, 0, 0) beside the stone.
+        assert_eq!(sides(3, 1, 0), ["none", "none", "side", "side"]);
+        assert_eq!(sides(0, 0, 4), ["none", "none", "none", "none"]);
+
+        // Already connected wire is left as it is.
+        let palette = s.default_region.palette.len();
+        s.fix_redstone_connectivity();
+        assert_eq!(s.default_region.palette.len(), palette);
+    }
+
     #[test]
     fn named_region_block_strings_parse_and_replace_block_entities() {
         let mut schematic = UniversalSchematic::new("regions".to_string());
@@ -3348,10 +3390,10 @@ mod tests {
 
     #[test]
     fn copy_region_fast_path_matches_slow_path() {
-        // The single-region source takes the palette-mapped fast path; adding
-        // a dummy other-region forces the per-block slow path. Both must
-        // produce identical targets, including exclusions, air overwrites,
-        // and cells outside the source region staying untouched.
+        // A dummy other-region adds a second stamp layer that supplies no
+        // cell of the box. Both sources must produce identical targets,
+        // including exclusions, air overwrites, and cells outside the source
+        // region staying untouched.
         let build_source = |extra_region: bool| {
             let mut src = UniversalSchematic::new("src".to_string());
             src.set_block_str(0, 0, 0, "minecraft:stone");
@@ -3423,6 +3465,78 @@ mod tests {
         );
     }
 
+    #[test]
+    fn stamp_box_layers_regions_and_shares_block_entity_templates() {
+        let mut source = UniversalSchematic::new("source".to_string());
+        for x in 0..4 {
+            source.set_block_str(x, 0, 0, "minecraft:stone");
+        }
+        source.set_block_str(1, 0, 0, "minecraft:dirt");
+        for x in 2..8 {
+            source
+                .try_set_block_in_region_str("alpha", x, 0, 0, "minecraft:gold_block")
+                .unwrap();
+        }
+        // (3, 0, 0) belongs to Main, so alpha's block entity there is hidden.
+        source
+            .other_regions
+            .get_mut("alpha")
+            .unwrap()
+            .block_entities
+            .insert_template(
+                &[(3, 0, 0), (6, 0, 0), (7, 0, 0)],
+                std::sync::Arc::new(BlockEntity::new("minecraft:chest".to_string(), (6, 0, 0))),
+            );
+
+        let mut destination = UniversalSchematic::new("destination".to_string());
+        for z in [0, 2] {
+            destination.set_block_str(11, 0, z, "minecraft:emerald_block");
+            destination.set_block_entity(
+                BlockPosition { x: 11, y: 0, z },
+                BlockEntity::new("minecraft:barrel".to_string(), (11, 0, z)),
+            );
+            destination.set_block_entity(
+                BlockPosition { x: 14, y: 0, z },
+                BlockEntity::new("minecraft:barrel".to_string(), (14, 0, z)),
+            );
+        }
+        let excluded = [BlockState::new("minecraft:dirt".to_string())];
+        let bounds = BoundingBox::new((0, 0, 0), (7, 0, 0));
+        for z in [0, 2] {
+            destination
+                .stamp_box(&source, &bounds, (10, 0, z), &excluded)
+                .unwrap();
+        }
+
+        let template = source.other_regions["alpha"]
+            .block_entities
+            .get(&(6, 0, 0))
+            .unwrap();
+        let expected = [
+            "minecraft:stone",
+            "minecraft:emerald_block",
+            "minecraft:stone",
+            "minecraft:stone",
+            "minecraft:gold_block",
+            "minecraft:gold_block",
+            "minecraft:gold_block",
+            "minecraft:gold_block",
+        ];
+        for z in [0, 2] {
+            for (i, name) in expected.iter().enumerate() {
+                let x = 10 + i as i32;
+                assert_eq!(destination.get_block(x, 0, z).unwrap().name, *name);
+            }
+            let at = |x| destination.get_block_entity(BlockPosition { x, y: 0, z });
+            assert_eq!(at(11).unwrap().id, "minecraft:barrel");
+            assert!(at(13).is_none());
+            assert!(at(14).is_none());
+            for x in [16, 17] {
+                assert!(std::ptr::eq(at(x).unwrap(), template));
+            }
+        }
+    }
+
     #[test]
     fn litematic_load_captures_source_data_version() {
         // Stamp a known data version, round-trip through litematic, and confirm
@@ -4352,6 +4466,117 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_chunk_cursor_matches_iter_chunks_indices() {
+        let mut schematic = UniversalSchematic::new("Cursor Test".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        for x in -20..20 {
+            for y in 0..40 {
+                if (x + y) % 7 == 0 {
+                    schematic.set_block(x, y, 3, &stone);
+                }
+            }
+        }
+
+        let expected: Vec<_> = schematic
+            .iter_chunks_indices(16, 16, 16, Some(ChunkLoadingStrategy::BottomUp))
+            .collect();
+        let mut cursor = schematic
+            .chunk_cursor(16, 16, 16, ChunkLoadingStrategy::BottomUp)
+            .unwrap();
+        assert!(cursor.indices().is_empty());
+
+        let mut visited = 0;
+        let mut last_y = i32::MIN;
+        while cursor.advance(&schematic) {
+            let (cx, cy, cz) = cursor.chunk().unwrap();
+            assert!(cy >= last_y, "bottom-up order must not descend");
+            last_y = cy;
+            assert_eq!(cursor.indices().len(), 16 * 16 * 16);
+            assert_eq!(cursor.region_name(), Some("Main"));
+
+            let chunk = expected
+                .iter()
+                .find(|c| (c.chunk_x, c.chunk_y, c.chunk_z) == (cx, cy, cz))
+                .expect("cursor chunk must exist in iter_chunks_indices");
+            let min = cursor.chunk_min().unwrap();
+            for (pos, palette_index) in &chunk.blocks {
+                let (dx, dy, dz) = (pos.x - min.0, pos.y - min.1, pos.z - min.2);
+                let i = (dx + dz * 16 + dy * 16 * 16) as usize;
+                assert_eq!(cursor.indices()[i] as usize, *palette_index);
+            }
+            visited += 1;
+        }
+        assert_eq!(visited, expected.len());
+        assert_eq!(cursor.remaining(), 0);
+        assert!(cursor.chunk().is_none());
+        assert!(schematic
+            .chunk_cursor(0, 16, 16, ChunkLoadingStrategy::Default)
+            .is_err());
+    }
+
+    #[test]
+    fn test_block_iterators_match_index_decoding() {
+        let mut schematic = UniversalSchematic::new("Iter Test".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        let glass = BlockState::new("minecraft:glass".to_string());
+        for i in 0..300 {
+            let block = if i % 2 == 0 { &stone } else { &glass };
+            schematic.set_block(i * 7 % 45 - 20, i % 19, i * 3 % 33 - 5, block);
+        }
+        schematic.set_block_in_region("Wing", 18, 2, -4, &glass);
+
+        let mut decoded = Vec::new();
+        let mut decoded_non_air = Vec::new();
+        for region in
+            std::iter::once(&schematic.default_region).chain(schematic.other_regions.values())
+        {
+            for (index, palette_index) in region.blocks.iter().enumerate() {
+                let (x, y, z) = region.index_to_coords(index);
+                decoded.push(((x, y, z), palette_index));
+                if palette_index != 0 {
+                    decoded_non_air.push(((x, y, z), palette_index));
+                }
+            }
+        }
+        let cells: Vec<_> = schematic
+            .iter_blocks()
+            .map(|(p, block)| ((p.x, p.y, p.z), block.clone()))
+            .collect();
+        assert_eq!(cells.len(), decoded.len());
+        for (((pos, block), (expected_pos, _)), region_block) in cells
+            .iter()
+            .zip(&decoded)
+            .zip(schematic.iter_blocks_with_ids())
+        {
+            assert_eq!(pos, expected_pos);
+            assert_eq!(block, region_block.2);
+        }
+        let indices: Vec<_> = schematic
+            .iter_blocks_indices()
+            .map(|(p, i)| ((p.x, p.y, p.z), i))
+            .collect();
+        assert_eq!(indices, decoded_non_air);
+
+        let chunked = schematic.chunked_blocks(16, 8, 16);
+        assert_eq!(chunked.block_count(), decoded_non_air.len());
+        for ((cx, cy, cz), blocks) in chunked.iter() {
+            assert!(!blocks.is_empty());
+            for (pos, _) in blocks {
+                assert_eq!(
+                    (
+                        pos.x.div_euclid(16),
+                        pos.y.div_euclid(8),
+                        pos.z.div_euclid(16)
+                    ),
+                    (cx, cy, cz)
+                );
+            }
+        }
+        let chunks = schematic.split_into_chunks(16, 8, 16);
+        assert_eq!(chunks.len(), chunked.len());
+    }
+
     #[test]
     fn test_exact_chunk_dimensions() {
         // Test case 1: 16x16x16 cube with 16x16x16 chunks should produce exactly 1 chunk
@@ -4642,4 +4867,44 @@ mod tests {
             _ => panic!("Expected String variant"),
         }
     }
+
+    #[test]
+    fn test_memory_usage_sums_its_components() {
+        let mut schematic = UniversalSchematic::new("Memory Test".to_string());
+        let empty = schematic.memory_usage();
+        for x in 0..40 {
+            schematic.set_block_str(x, 0, 0, "minecraft:stone");
+        }
+        schematic
+            .set_block_from_string(1, 1, 1, "minecraft:chest[facing=north]{items=[diamond]}")
+            .unwrap();
+        schematic.set_block_in_region("Wing", 60, 0, 0, &BlockState::new("minecraft:glass"));
+        schematic.add_entity(Entity::new("minecraft:pig".to_string(), (0.5, 1.0, 0.5)));
+        schematic.definition_regions.insert(
+            "input".to_string(),
+            DefinitionRegion::from_bounds((0, 0, 0), (3, 0, 0)),
+        );
+
+        let usage = schematic.memory_usage();
+        assert!(usage.block_arrays > empty.block_arrays);
+        assert!(usage.palettes > empty.palettes);
+        assert!(usage.block_entities > 0);
+        assert!(usage.entities > 0);
+        assert!(usage.definition_regions > 0);
+        assert!(usage.block_state_cache > 0);
+        assert_eq!(
+            usage
+                .regions
+                .iter()
+                .map(|r| r.name.as_str())
+                .collect::<Vec<_>>(),
+            vec![schematic.default_region_name.as_str(), "Wing"]
+        );
+        assert_eq!(
+            usage.block_arrays,
+            usage.regions.iter().map(|r| r.blocks).sum::<usize>()
+        );
+        let regions: usize = usage.regions.iter().map(RegionMemory::total).sum();
+        assert!(usage.total > regions + usage.definition_regions + usage.block_state_cache);
+    }
 }
@@ -58,6 +58,130 @@ pub fn parse_block_string(block_string: &str) -> Result<(BlockState, Option<NbtM
     Ok((block_state, nbt_data))
 }
 
+/// The parts of a `name[props]{nbt}` block string, borrowed from it.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub(crate) struct BlockStringParts<'a> {
+    /// Block id, with leading whitespace trimmed.
+    pub name: &'a str,
+    /// Everything between the brackets, if there are any.
+    pub properties: Option<&'a str>,
+    /// Everything between the outer braces, if there are any.
+    pub nbt: Option<&'a str>,
+}
+
+impl<'a> BlockStringParts<'a> {
+    /// The `key=value` pairs of the properties, keys trimmed and values
+    /// trimmed and unquoted.
+    pub fn properties(&self) -> impl Iterator<Item = Result<(&'a str, &'a str), String>> {
+        self.properties
+            .into_iter()
+            .flat_map(|props| props.split(','))
+            .map(|prop| {
+                let (key, value) = prop
+                    .split_once('=')
+                    .ok_or("Missing property key or value")?;
+                let key = key.trim();
+                let value = value.trim().trim_matches(|c| c == '\'' || c == '"');
+                if key.is_empty() || value.is_empty() || value.contains('=') {
+                    return Err("Malformed block property".to_string());
+                }
+                Ok((key, value))
+            })
+    }
+}
+
+/// Split a block string into its parts in one pass over its bytes, checking
+/// that brackets and braces nest and quotes close (a backslash escapes the
+/// next character inside quotes). Nothing is allocated unless it fails.
+///
+/// The block-entity part starts at the first `{` and must run to the end of
+/// the string; the properties, if any, must close the part before it.
+pub(crate) fn split_block_string(block_string: &str) -> Result<BlockStringParts<'_>, String> {
+    // Open delimiters as a bit stack, 1 for a brace: no string worth
+    // parsing nests deeper than 64.
+    let mut open: u64 = 0;
+    let mut depth = 0u32;
+    let mut quote = None;
+    let mut escaped = false;
+    let mut brace = None;
+    let mut bracket = None;
+
+    // Every delimiter is ASCII, so scanning bytes never splits a character.
+    for (i, &b) in block_string.as_bytes().iter().enumerate() {
+        if b == b'{' && brace.is_none() {
+            brace = Some(i);
+        } else if b == b'[' && bracket.is_none() && brace.is_none() {
+            bracket = Some(i);
+        }
+        if quote.is_some() && b == b'\\' && !escaped {
+            escaped = true;
+            continue;
+        }
+        if matches!(b, b'\'' | b'"') && !escaped {
+            match quote {
+                Some(active) if active == b => quote = None,
+                None => quote = Some(b),
+                _ => {}
+            }
+            continue;
+        }
+        if quote.is_none() {
+            match b {
+                b'[' | b'{' => {
+                    if depth == u64::BITS {
+                        return Err("Block string nests too deeply".to_string());
+                    }
+                    open = open << 1 | u64::from(b == b'{');
+                    depth += 1;
+                }
+                b']' | b'}' => {
+                    if depth == 0 || (open & 1 == 1) != (b == b'}') {
+                        return Err(format!(
+                            "Unmatched or misordered '{}' in block string",
+                            b as char
+                        ));
+                    }
+                    open >>= 1;
+                    depth -= 1;
+                }
+                _ => {}
+            }
+        }
+        escaped = false;
+    }
+    if quote.is_some() {
+        return Err("Unterminated quoted string in block string".to_string());
+    }
+    if depth != 0 {
+        return Err("Unclosed delimiter in block string".to_string());
+    }
+
+    let (state, nbt) = match brace {
+        Some(at) => {
+            let nbt = block_string[at + 1..]
+                .strip_suffix('}')
+                .ok_or("Missing block entity closing brace")?;
+            (block_string[..at].trim(), Some(nbt))
+        }
+        None => (block_string.trim(), None),
+    };
+    let (name, properties) = match bracket {
+        Some(_) => {
+            let (name, props) = state.split_once('[').unwrap_or((state, ""));
+            let props = props
+                .strip_suffix(']')
+                .ok_or("Missing properties closing bracket")?;
+            (name, Some(props))
+        }
+        None => (state, None),
+    };
+    Ok(BlockStringParts {
+        name,
+        properties,
+        nbt,
+    })
+}
+
 pub fn parse_items_array(nbt_str: &str) -> Result<Vec<NbtValue>, String> {
     // Find the Items array
     let items_start = nbt_str.find("Items:[").ok_or("Missing Items array")?;
@@ -271,6 +395,40 @@ mod tests {
         }
     }
 
+    #[test]
+    fn test_split_block_string() {
+        let parts =
+            split_block_string(r#" minecraft:chest[facing=north, type='left']{CustomName:'a}[b'}"#)
+                .unwrap();
+        assert_eq!(parts.name, "minecraft:chest");
+        assert_eq!(
+            parts.properties().collect::<Result<Vec<_>, _>>().unwrap(),
+            vec![("facing", "north"), ("type", "left")]
+        );
+        assert_eq!(parts.nbt, Some("CustomName:'a}[b'"));
+
+        let plain = split_block_string("minecraft:stone ").unwrap();
+        assert_eq!(
+            (plain.name, plain.properties, plain.nbt),
+            ("minecraft:stone", None, None)
+        );
+
+        for bad in [
+            "minecraft:stone}",
+            "minecraft:stone[facing=north}",
+            "minecraft:chest{a:[1]",
+            "minecraft:chest{CustomName:'x}",
+            "minecraft:chest{a:1} ",
+            "minecraft:stone[a=b]x",
+        ] {
+            assert!(split_block_string(bad).is_err(), "{bad}");
+        }
+        let deep = format!("minecraft:chest{{a:{}{}}}", "[".repeat(64), "]".repeat(64));
+        assert!(split_block_string(&deep).is_err());
+        let parts = split_block_string("minecraft:stone[=north]").unwrap();
+        assert!(parts.properties().any(|p| p.is_err()));
+    }
+
     #[test]
     fn test_parse_custom_name() {
         let test_cases = [
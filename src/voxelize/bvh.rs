@@ -0,0 +1,312 @@
+//! Bounding-volume hierarchy over a mesh's triangles.
+//!
+//! Median splits on the longest centroid axis, four triangles per leaf,
+//! nodes in depth-first order (a node's left child follows it). Answers
+//! the three queries [`MeshShape`](super::MeshShape) needs — triangles on
+//! an axis ray, triangles near a box, nearest triangle to a point — in
+//! logarithmic time and without per-query allocation, however large or
+//! unevenly sized the triangles are.
+
+use super::model::MeshTriangle;
+use rayon::prelude::*;
+
+/// Triangles per leaf.
+const LEAF: usize = 4;
+/// Traversal stack depth; median splits keep the tree far shallower.
+const STACK: usize = 96;
+
+#[derive(Clone, Copy, Debug)]
+struct Node {
+    min: [f32; 3],
+    max: [f32; 3],
+    /// Leaf: first slot in `order`. Internal: index of the right child.
+    first: u32,
+    /// Triangles in a leaf; 0 for internal nodes.
+    count: u32,
+}
+
+pub(super) struct Bvh {
+    nodes: Vec<Node>,
+    /// Triangle indices, leaf by leaf.
+    order: Vec<u32>,
+}
+
+fn triangle_box(tri: &MeshTriangle) -> ([f32; 3], [f32; 3]) {
+    let mut min = [f32::INFINITY; 3];
+    let mut max = [f32::NEG_INFINITY; 3];
+    for p in &tri.positions {
+        for a in 0..3 {
+            min[a] = min[a].min(p[a]);
+            max[a] = max[a].max(p[a]);
+        }
+    }
+    (min, max)
+}
+
+/// Squared distance from `p` to the box `[min, max]`.
+fn box_distance2(p: [f32; 3], min: &[f32; 3], max: &[f32; 3]) -> f32 {
+    let mut d2 = 0.0;
+    for a in 0..3 {
+        let d = (min[a] - p[a]).max(p[a] - max[a]).max(0.0);
+        d2 += d * d;
+    }
+    d2
+}
+
+/// Whether a candidate `d2` away (squared) could still beat `bound`. The
+/// slack keeps rounding from pruning a triangle that ties.
+fn within(d2: f32, bound: f32) -> bool {
+    d2 <= bound * bound * 1.0001 + 1e-10
+}
+
+impl Bvh {
+    pub(super) fn build(triangles: &[MeshTriangle]) -> Self {
+        let boxes: Vec<([f32; 3], [f32; 3])> = triangles.par_iter().map(triangle_box).collect();
+        let mut order: Vec<u32> = (0..triangles.len() as u32).collect();
+        let mut nodes = Vec::with_capacity(2 * triangles.len() / LEAF + 1);
+        if !order.is_empty() {
+            build_node(&boxes, &mut order, 0, &mut nodes);
+        }
+        Self { nodes, order }
+    }
+
+    /// Depth-first walk of the nodes `enter` accepts, handing every triangle
+    /// of an accepted leaf to `f`.
+    fn visit(&self, enter: impl Fn(&[f32; 3], &[f32; 3]) -> bool, mut f: impl FnMut(u32)) {
+        if self.nodes.is_empty() {
+            return;
+        }
+        let mut stack = [0u32; STACK];
+        let mut len = 1;
+        while len > 0 {
+            len -= 1;
+            let i = stack[len] as usize;
+            let node = &self.nodes[i];
+            if !enter(&node.min, &node.max) {
+                continue;
+            }
+            if node.count > 0 {
+                let first = node.first as usize;
+                for &t in &self.order[first..first + node.count as usize] {
+                    f(t);
+                }
+            } else {
+                stack[len] = node.first;
+                stack[len + 1] = i as u32 + 1;
+                len += 2;
+            }
+        }
+    }
+
+    /// Every triangle whose box the ray from `origin` toward +`axis` passes
+    /// through (triangles behind the origin included only if their box
+    /// reaches past it).
+    pub(super) fn for_each_on_ray(&self, origin: [f32; 3], axis: usize, f: impl FnMut(u32)) {
+        let (p1, p2) = ((axis + 1) % 3, (axis + 2) % 3);
+        self.visit(
+            |min, max| {
+                max[axis] >= origin[axis]
+                    && min[p1] <= origin[p1]
+                    && origin[p1] <= max[p1]
+                    && min[p2] <= origin[p2]
+                    && origin[p2] <= max[p2]
+            },
+            f,
+        );
+    }
+
+    /// Every triangle whose box overlaps `[lo, hi]`.
+    pub(super) fn for_each_in_box(&self, lo: [f32; 3], hi: [f32; 3], f: impl FnMut(u32)) {
+        self.visit(
+            |min, max| (0..3).all(|a| min[a] <= hi[a] && lo[a] <= max[a]),
+            f,
+        );
+    }
+
+    /// The triangle nearest `p` within `limit`, as `(index, closest point,
+    /// distance)`, with `closest(t)` giving a triangle's closest point and
+    /// distance. Nearer children are searched first and subtrees farther
+    /// than the best so far are skipped. Ties go to the lower index.
+    pub(super) fn nearest(
+        &self,
+        p: [f32; 3],
+        limit: f32,
+        closest: impl Fn(u32) -> ([f32; 3], f32),
+    ) -> Option<(usize, [f32; 3], f32)> {
+        if self.nodes.is_empty() {
+            return None;
+        }
+        let mut best: Option<(usize, [f32; 3], f32)> = None;
+        let mut stack = [(0u32, 0f32); STACK];
+        let mut len = 1;
+        while len > 0 {
+            len -= 1;
+            let (i, d2) = stack[len];
+            let bound = best.map_or(limit, |b| b.2);
+            if !within(d2, bound) {
+                continue;
+            }
+            let node = &self.nodes[i as usize];
+            if node.count > 0 {
+                let first = node.first as usize;
+                for &t in &self.order[first..first + node.count as usize] {
+                    let (q, dist) = closest(t);
+                    if dist > limit {
+                        continue;
+                    }
+                    let better = best
+                        .is_none_or(|(bi, _, bd)| dist < bd || (dist == bd && (t as usize) < bi));
+                    if better {
+                        best = Some((t as usize, q, dist));
+                    }
+                }
+            } else {
+                let (l, r) = (i + 1, node.first);
+                let dl = box_distance2(p, &self.nodes[l as usize].min, &self.nodes[l as usize].max);
+                let dr = box_distance2(p, &self.nodes[r as usize].min, &self.nodes[r as usize].max);
+                // Push the farther child first so the nearer one pops next.
+                let (near, far) = if dl <= dr {
+                    ((l, dl), (r, dr))
+                } else {
+                    ((r, dr), (l, dl))
+                };
+                stack[len] = far;
+                stack[len + 1] = near;
+                len += 2;
+            }
+        }
+        best
+    }
+}
+
+/// Lay out the subtree over `order` (whose first slot is `offset` in the
+/// full order) and return its root's index.
+fn build_node(
+    boxes: &[([f32; 3], [f32; 3])],
+    order: &mut [u32],
+    offset: usize,
+    nodes: &mut Vec<Node>,
+) -> usize {
+    let mut min = [f32::INFINITY; 3];
+    let mut max = [f32::NEG_INFINITY; 3];
+    let mut cmin = [f32::INFINITY; 3];
+    let mut cmax = [f32::NEG_INFINITY; 3];
+    for &t in order.iter() {
+        let (lo, hi) = &boxes[t as usize];
+        for a in 0..3 {
+            min[a] = min[a].min(lo[a]);
+            max[a] = max[a].max(hi[a]);
+            let c = (lo[a] + hi[a]) * 0.5;
+            cmin[a] = cmin[a].min(c);
+            cmax[a] = cmax[a].max(c);
+        }
+    }
+    let at = nodes.len();
+    nodes.push(Node {
+        min,
+        max,
+        first: offset as u32,
+        count: order.len() as u32,
+    });
+    if order.len() <= LEAF {
+        return at;
+    }
+
+    let axis = (0..3)
+        .max_by(|&a, &b| (cmax[a] - cmin[a]).total_cmp(&(cmax[b] - cmin[b])))
+        .unwrap_or(0);
+    let centroid = |t: &u32| {
+        let (lo, hi) = &boxes[*t as usize];
+        (lo[axis] + hi[axis]) * 0.5
+    };
+    let mid = order.len() / 2;
+    order.select_nth_unstable_by(mid, |a, b| centroid(a).total_cmp(&centroid(b)));
+    let (left, right) = order.split_at_mut(mid);
+    build_node(boxes, left, offset, nodes);
+    let right = build_node(boxes, right, offset + mid, nodes);
+    nodes[at].first = right as u32;
+    nodes[at].count = 0;
+    at
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn queries_match_brute_force() {
+        let mut state = 0x9e37_79b9_7f4a_7c15u64;
+        let mut next = || {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            (state >> 40) as f32 / (1u64 << 24) as f32 * 20.0
+        };
+        let triangles: Vec<MeshTriangle> = (0..200)
+            .map(|_| {
+                let c = [next(), next(), next()];
+                let mut p = [c; 3];
+                for v in &mut p[1..] {
+                    for a in 0..3 {
+                        v[a] += next() * 0.2 - 2.0;
+                    }
+                }
+                MeshTriangle {
+                    positions: p,
+                    uvs: None,
+                    material: None,
+                }
+            })
+            .collect();
+        let bvh = Bvh::build(&triangles);
+        let boxes: Vec<_> = triangles.iter().map(triangle_box).collect();
+        // Vertex distance stands in for the exact triangle distance.
+        let closest = |p: [f32; 3], t: u32| {
+            triangles[t as usize]
+                .positions
+                .iter()
+                .map(|&q| (q, box_distance2(p, &q, &q).sqrt()))
+                .min_by(|a, b| a.1.total_cmp(&b.1))
+                .unwrap()
+        };
+
+        for _ in 0..200 {
+            let p = [next(), next(), next()];
+            let mut expected: Option<(usize, [f32; 3], f32)> = None;
+            for t in 0..triangles.len() {
+                let (q, d) = closest(p, t as u32);
+                if expected.is_none_or(|e| d < e.2) {
+                    expected = Some((t, q, d));
+                }
+            }
+            assert_eq!(bvh.nearest(p, f32::INFINITY, |t| closest(p, t)), expected);
+            assert_eq!(
+                bvh.nearest(p, 1.5, |t| closest(p, t)),
+                expected.filter(|e| e.2 <= 1.5)
+            );
+
+            for axis in 0..3 {
+                // Leaves hand over all their triangles, so hits may be a
+                // superset; every triangle whose box the ray meets is in it.
+                let mut hits = Vec::new();
+                bvh.for_each_on_ray(p, axis, |t| hits.push(t as usize));
+                hits.sort_unstable();
+                hits.dedup();
+                let (p1, p2) = ((axis + 1) % 3, (axis + 2) % 3);
+                let want = (0..triangles.len())
+                    .filter(|&t| {
+                        let (lo, hi) = &boxes[t];
+                        hi[axis] >= p[axis]
+                            && (lo[p1]..=hi[p1]).contains(&p[p1])
+                            && (lo[p2]..=hi[p2]).contains(&p[p2])
+                    })
+                    .collect::<Vec<_>>();
+                assert!(want.iter().all(|t| hits.binary_search(t).is_ok()));
+            }
+        }
+
+        assert!(Bvh::build(&[])
+            .nearest([0.0; 3], 1.0, |_| unreachable!())
+            .is_none());
+    }
+}
@@ -7,14 +7,19 @@
 //! any brush via the building tool or run [`voxelize_textured`] to sample the
 //! model's textures into palette blocks.
 
+mod bvh;
 mod model;
 mod shape;
 
 pub use model::{MeshModel, MeshTriangle, TextureImage};
 pub use shape::MeshShape;
 
+use std::collections::HashMap;
+
+use rayon::prelude::*;
+
 use crate::blockpedia::ExtendedColorData;
-use crate::building::{BlockPalette, Shape};
+use crate::building::{fill, BlockPalette, FillMode, Shape};
 use crate::{BlockState, UniversalSchematic};
 
 /// Fallback color for voxels with no texture information (mid-gray).
@@ -31,12 +36,31 @@ pub fn voxelize_textured(
     schematic_name: &str,
 ) -> UniversalSchematic {
     let mut schematic = UniversalSchematic::new(schematic_name.to_string());
-    model_shape.for_each_point(|x, y, z| {
-        let rgb = model_shape.surface_color(x, y, z).unwrap_or(FALLBACK_RGB);
-        let target = ExtendedColorData::from_rgb(rgb[0], rgb[1], rgb[2]);
-        if let Some(id) = palette.find_closest(&target) {
-            schematic.set_block(x, y, z, &BlockState::new(id));
-        }
-    });
+    let mut points = Vec::new();
+    model_shape.for_each_point(|x, y, z| points.push((x, y, z)));
+    let colors: Vec<[u8; 3]> = points
+        .par_iter()
+        .map(|&(x, y, z)| model_shape.surface_color(x, y, z).unwrap_or(FALLBACK_RGB))
+        .collect();
+
+    // Textures repeat a limited set of colors; match each one once.
+    let mut distinct = colors.clone();
+    distinct.sort_unstable();
+    distinct.dedup();
+    let matched: HashMap<[u8; 3], Option<BlockState>> = distinct
+        .into_par_iter()
+        .map(|rgb| {
+            let target = ExtendedColorData::from_rgb(rgb[0], rgb[1], rgb[2]);
+            (rgb, palette.find_closest(&target).map(BlockState::new))
+        })
+        .collect();
+
+    fill::paint_points(
+        &mut schematic,
+        model_shape.bounds(),
+        &points,
+        &FillMode::Replace,
+        |i| matched[&colors[i]].clone(),
+    );
     schematic
 }
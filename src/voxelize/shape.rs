@@ -1,90 +1,13 @@
 //! [`MeshShape`]: a fitted [`MeshModel`] as a building [`Shape`], with a
-//! uniform-grid spatial index for ray parity tests and nearest-triangle
-//! queries (normals + texture lookups).
+//! triangle BVH for ray parity tests and nearest-triangle queries
+//! (normals + texture lookups).
 
+use super::bvh::Bvh;
 use super::model::{MeshModel, MeshTriangle, TextureImage};
 use crate::building::Shape;
 use rayon::prelude::*;
 use std::sync::{Arc, OnceLock};
 
-/// Uniform spatial grid over the triangles (cell size = 1 voxel).
-struct TriGrid {
-    min: [f32; 3],
-    dims: [i32; 3],
-    /// `dims.x * dims.y * dims.z` buckets of triangle indices.
-    cells: Vec<Vec<u32>>,
-}
-
-impl TriGrid {
-    const CELL: f32 = 1.0;
-
-    fn build(triangles: &[MeshTriangle], min: [f32; 3], max: [f32; 3]) -> Self {
-        let dims = [
-            (((max[0] - min[0]) / Self::CELL).ceil() as i32).max(1),
-            (((max[1] - min[1]) / Self::CELL).ceil() as i32).max(1),
-            (((max[2] - min[2]) / Self::CELL).ceil() as i32).max(1),
-        ];
-        let mut cells = vec![Vec::new(); (dims[0] * dims[1] * dims[2]) as usize];
-        for (idx, tri) in triangles.iter().enumerate() {
-            let mut tmin = [f32::INFINITY; 3];
-            let mut tmax = [f32::NEG_INFINITY; 3];
-            for p in &tri.positions {
-                for a in 0..3 {
-                    tmin[a] = tmin[a].min(p[a]);
-                    tmax[a] = tmax[a].max(p[a]);
-                }
-            }
-            let lo = [
-                Self::clamp_axis(dims, 0, ((tmin[0] - min[0]) / Self::CELL).floor() as i32),
-                Self::clamp_axis(dims, 1, ((tmin[1] - min[1]) / Self::CELL).floor() as i32),
-                Self::clamp_axis(dims, 2, ((tmin[2] - min[2]) / Self::CELL).floor() as i32),
-            ];
-            let hi = [
-                Self::clamp_axis(dims, 0, ((tmax[0] - min[0]) / Self::CELL).floor() as i32),
-                Self::clamp_axis(dims, 1, ((tmax[1] - min[1]) / Self::CELL).floor() as i32),
-                Self::clamp_axis(dims, 2, ((tmax[2] - min[2]) / Self::CELL).floor() as i32),
-            ];
-            for cx in lo[0]..=hi[0] {
-                for cy in lo[1]..=hi[1] {
-                    for cz in lo[2]..=hi[2] {
-                        let i = ((cx * dims[1] + cy) * dims[2] + cz) as usize;
-                        cells[i].push(idx as u32);
-                    }
-                }
-            }
-        }
-        Self { min, dims, cells }
-    }
-
-    fn clamp_axis(dims: [i32; 3], axis: usize, v: i32) -> i32 {
-        v.clamp(0, dims[axis] - 1)
-    }
-
-    fn cell_of(&self, p: [f32; 3]) -> [i32; 3] {
-        [
-            Self::clamp_axis(
-                self.dims,
-                0,
-                ((p[0] - self.min[0]) / Self::CELL).floor() as i32,
-            ),
-            Self::clamp_axis(
-                self.dims,
-                1,
-                ((p[1] - self.min[1]) / Self::CELL).floor() as i32,
-            ),
-            Self::clamp_axis(
-                self.dims,
-                2,
-                ((p[2] - self.min[2]) / Self::CELL).floor() as i32,
-            ),
-        ]
-    }
-
-    fn bucket(&self, c: [i32; 3]) -> &[u32] {
-        &self.cells[((c[0] * self.dims[1] + c[1]) * self.dims[2] + c[2]) as usize]
-    }
-}
-
 /// A triangle mesh (loaded from GLB/OBJ, already [`MeshModel::fit`]ted into
 /// voxel space) usable as a building [`Shape`].
 ///
@@ -100,7 +23,7 @@ impl TriGrid {
 /// capture few voxel centers. That is the geometrically correct answer, not
 /// a bug; scale the model up or use a single-surface mesh for a filled solid.
 ///
-/// Cloning is cheap (the triangle data and grid are shared via `Arc`).
+/// Cloning is cheap (the triangle data and BVH are shared via `Arc`).
 #[derive(Clone)]
 pub struct MeshShape {
     data: Arc<MeshData>,
@@ -124,7 +47,7 @@ pub struct MeshShape {
 struct MeshData {
     triangles: Vec<MeshTriangle>,
     materials: Vec<Option<TextureImage>>,
-    grid: TriGrid,
+    bvh: Bvh,
     /// Inclusive voxel bounds of the fitted AABB.
     bounds: (i32, i32, i32, i32, i32, i32),
     aabb_min: [f32; 3],
@@ -132,12 +55,14 @@ struct MeshData {
 }
 
 const JITTER: f32 = 1e-4;
+/// Voxel columns along x per parallel shell-rasterization task.
+const SHELL_SLAB: i32 = 8;
 
 impl MeshShape {
     /// Index a (typically fitted) model for voxel queries.
     pub fn new(model: MeshModel) -> Self {
         let (min, max) = model.aabb().unwrap_or(([0.0; 3], [0.0; 3]));
-        let grid = TriGrid::build(&model.triangles, min, max);
+        let bvh = Bvh::build(&model.triangles);
         // Voxel (x, y, z) covers [x, x+1); keep every voxel whose cube
         // intersects the AABB.
         let bounds = (
@@ -155,7 +80,7 @@ impl MeshShape {
             data: Arc::new(MeshData {
                 triangles: model.triangles,
                 materials: model.materials,
-                grid,
+                bvh,
                 bounds,
                 aabb_min: min,
                 aabb_max: max,
@@ -169,7 +94,7 @@ impl MeshShape {
     }
 
     /// Parity (crossing count mod 2) of an axis-aligned ray from `origin`
-    /// toward +axis, walked through the grid row.
+    /// toward +axis.
     fn axis_ray_parity(&self, origin: [f32; 3], axis: usize) -> bool {
         let d = &self.data;
         // Jitter the two perpendicular axes to avoid hitting edges/vertices.
@@ -181,86 +106,32 @@ impl MeshShape {
         o[p1] += JITTER;
         o[p2] -= 1.31 * JITTER;
 
-        let start = d.grid.cell_of(o);
-        let mut candidates: Vec<u32> = Vec::new();
-        let mut c = start;
-        for a in start[axis]..d.grid.dims[axis] {
-            c[axis] = a;
-            candidates.extend_from_slice(d.grid.bucket(c));
-        }
-        candidates.sort_unstable();
-        candidates.dedup();
-
         let mut dir = [0f32; 3];
         dir[axis] = 1.0;
         let mut crossings = 0u32;
-        for &t in &candidates {
+        d.bvh.for_each_on_ray(o, axis, |t| {
             if ray_triangle_t(o, dir, &d.triangles[t as usize].positions).is_some_and(|t| t > 1e-6)
             {
                 crossings += 1;
             }
-        }
+        });
         crossings % 2 == 1
     }
 
-    /// Nearest triangle to `p`: `(triangle index, closest point, distance)`.
-    /// Grid-accelerated expanding-ring search. `None` for an empty mesh.
-    /// `nearest_triangle`, but allowed to give up early once no triangle
-    /// can be within `limit` — the cheap query the shell test needs.
+    /// Nearest triangle to `p` within `limit`: `(triangle index, closest
+    /// point, distance)`. Subtrees farther than `limit` are never opened,
+    /// which makes this the cheap query the shell test needs.
     fn nearest_triangle_within(&self, p: [f32; 3], limit: f32) -> Option<(usize, [f32; 3], f32)> {
-        let hit = self.nearest_triangle(p)?;
-        (hit.2 <= limit).then_some(hit)
+        let d = &self.data;
+        d.bvh.nearest(p, limit, |t| {
+            let q = closest_point_on_triangle(p, &d.triangles[t as usize].positions);
+            (q, distance(p, q))
+        })
     }
 
+    /// Nearest triangle to `p`. `None` for an empty mesh.
     fn nearest_triangle(&self, p: [f32; 3]) -> Option<(usize, [f32; 3], f32)> {
-        let d = &self.data;
-        if d.triangles.is_empty() {
-            return None;
-        }
-        let start = d.grid.cell_of(p);
-        let max_r = d.grid.dims[0].max(d.grid.dims[1]).max(d.grid.dims[2]);
-        let mut best: Option<(usize, [f32; 3], f32)> = None;
-        let mut seen = vec![false; d.triangles.len()];
-        for r in 0..=max_r {
-            // Any cell beyond Chebyshev ring `r` is at least `(r) * CELL`
-            // away from a point inside the start cell's ring-0 cube, so once
-            // the best distance is under that we can stop.
-            if let Some((_, _, dist)) = best {
-                if dist <= (r as f32 - 1.0).max(0.0) * TriGrid::CELL {
-                    break;
-                }
-            }
-            let mut any_cell = false;
-            for cx in (start[0] - r).max(0)..=(start[0] + r).min(d.grid.dims[0] - 1) {
-                for cy in (start[1] - r).max(0)..=(start[1] + r).min(d.grid.dims[1] - 1) {
-                    for cz in (start[2] - r).max(0)..=(start[2] + r).min(d.grid.dims[2] - 1) {
-                        let on_shell = (cx - start[0]).abs() == r
-                            || (cy - start[1]).abs() == r
-                            || (cz - start[2]).abs() == r;
-                        if !on_shell {
-                            continue;
-                        }
-                        any_cell = true;
-                        for &t in d.grid.bucket([cx, cy, cz]) {
-                            let ti = t as usize;
-                            if seen[ti] {
-                                continue;
-                            }
-                            seen[ti] = true;
-                            let q = closest_point_on_triangle(p, &d.triangles[ti].positions);
-                            let dist = distance(p, q);
-                            if best.is_none_or(|(_, _, bd)| dist < bd) {
-                                best = Some((ti, q, dist));
-                            }
-                        }
-                    }
-                }
-            }
-            if !any_cell && best.is_some() {
-                break;
-            }
-        }
-        best
+        self.nearest_triangle_within(p, f32::INFINITY)
     }
 
     /// A copy of this shape that also claims voxels whose center lies
@@ -388,25 +259,15 @@ impl MeshShape {
                         o[p1] = (lo1 + i1 as i32) as f32 + 0.5 + JITTER;
                         o[p2] = (lo2 + i2 as i32) as f32 + 0.5 - 1.31 * JITTER;
 
-                        let start = d.grid.cell_of(o);
-                        let mut candidates: Vec<u32> = Vec::new();
-                        let mut c = start;
-                        for a in 0..d.grid.dims[axis] {
-                            c[axis] = a;
-                            candidates.extend_from_slice(d.grid.bucket(c));
-                        }
-                        candidates.sort_unstable();
-                        candidates.dedup();
-
                         let mut dir = [0f32; 3];
                         dir[axis] = 1.0;
-                        let mut ts: Vec<f32> = candidates
-                            .iter()
-                            .filter_map(|&t| {
+                        let mut ts: Vec<f32> = Vec::new();
+                        d.bvh.for_each_on_ray(o, axis, |t| {
+                            ts.extend(
                                 ray_triangle_t(o, dir, &d.triangles[t as usize].positions)
-                                    .filter(|&t| t > 1e-6)
-                            })
-                            .collect();
+                                    .filter(|&t| t > 1e-6),
+                            );
+                        });
                         ts.sort_unstable_by(|a, b| a.partial_cmp(b).unwrap());
                         (i1, i2, ts)
                     })
@@ -439,46 +300,69 @@ impl MeshShape {
             drop(votes);
         }
 
-        // Shell: rasterize each triangle's neighborhood.
+        // Shell: x-slabs in parallel, each rasterizing the neighborhoods of
+        // just the triangles the BVH finds within reach of it.
         if self.shell > 0.0 {
             let shell = self.shell;
-            let extra: Vec<Vec<usize>> = d
-                .triangles
+            let slabs: Vec<i32> = (x0..=x1).step_by(SHELL_SLAB as usize).collect();
+            let extra: Vec<Vec<usize>> = slabs
                 .par_iter()
-                .map(|tri| {
+                .map(|&sx| {
+                    let sx1 = (sx + SHELL_SLAB - 1).min(x1);
                     let mut out = Vec::new();
-                    let mut tmin = [f32::INFINITY; 3];
-                    let mut tmax = [f32::NEG_INFINITY; 3];
-                    for pt in &tri.positions {
-                        for a in 0..3 {
-                            tmin[a] = tmin[a].min(pt[a]);
-                            tmax[a] = tmax[a].max(pt[a]);
-                        }
-                    }
-                    let lo = [
-                        ((tmin[0] - shell).floor() as i32).max(x0),
-                        ((tmin[1] - shell).floor() as i32).max(y0),
-                        ((tmin[2] - shell).floor() as i32).max(z0),
-                    ];
-                    let hi = [
-                        ((tmax[0] + shell).ceil() as i32).min(x1),
-                        ((tmax[1] + shell).ceil() as i32).min(y1),
-                        ((tmax[2] + shell).ceil() as i32).min(z1),
-                    ];
-                    for x in lo[0]..=hi[0] {
-                        for y in lo[1]..=hi[1] {
-                            for z in lo[2]..=hi[2] {
-                                let c = [x as f32 + 0.5, y as f32 + 0.5, z as f32 + 0.5];
-                                let q = closest_point_on_triangle(c, &tri.positions);
-                                if distance(c, q) <= shell {
-                                    let idx = (((x - x0) as usize) * dims.1 + (y - y0) as usize)
-                                        * dims.2
-                                        + (z - z0) as usize;
-                                    out.push(idx);
+                    d.bvh.for_each_in_box(
+                        [
+                            sx as f32 + 0.5 - shell,
+                            f32::NEG_INFINITY,
+                            f32::NEG_INFINITY,
+                        ],
+                        [sx1 as f32 + 0.5 + shell, f32::INFINITY, f32::INFINITY],
+                        |t| {
+                            let tri = &d.triangles[t as usize].positions;
+                            let mut tmin = [f32::INFINITY; 3];
+                            let mut tmax = [f32::NEG_INFINITY; 3];
+                            for pt in tri {
+                                for a in 0..3 {
+                                    tmin[a] = tmin[a].min(pt[a]);
+                                    tmax[a] = tmax[a].max(pt[a]);
                                 }
                             }
-                        }
-                    }
+                            let lo = [
+                                ((tmin[0] - shell).floor() as i32).max(sx),
+                                ((tmin[1] - shell).floor() as i32).max(y0),
+                                ((tmin[2] - shell).floor() as i32).max(z0),
+                            ];
+                            let hi = [
+                                ((tmax[0] + shell).ceil() as i32).min(sx1),
+                                ((tmax[1] + shell).ceil() as i32).min(y1),
+                                ((tmax[2] + shell).ceil() as i32).min(z1),
+                            ];
+                            // Voxels farther from the triangle's plane than
+                            // the shell can't be within it of the triangle.
+                            let n = cross(sub(tri[1], tri[0]), sub(tri[2], tri[0]));
+                            let n_len = dot(n, n).sqrt();
+                            for x in lo[0]..=hi[0] {
+                                for y in lo[1]..=hi[1] {
+                                    for z in lo[2]..=hi[2] {
+                                        let c = [x as f32 + 0.5, y as f32 + 0.5, z as f32 + 0.5];
+                                        if n_len > 0.0
+                                            && dot(n, sub(c, tri[0])).abs() > (shell + 1e-4) * n_len
+                                        {
+                                            continue;
+                                        }
+                                        let q = closest_point_on_triangle(c, tri);
+                                        if distance(c, q) <= shell {
+                                            let idx = (((x - x0) as usize) * dims.1
+                                                + (y - y0) as usize)
+                                                * dims.2
+                                                + (z - z0) as usize;
+                                            out.push(idx);
+                                        }
+                                    }
+                                }
+                            }
+                        },
+                    );
                     out
                 })
                 .collect();
@@ -0,0 +1,157 @@
+//! Shard checkpoints: the hand-off between the map and reduce phases of a
+//! distributed run.
+//!
+//! A map worker segments one shard of tile ids
+//! ([`WorldSegmenter::map_shard`](crate::world_segment::runner::WorldSegmenter::map_shard))
+//! and writes everything the reduce phase needs to one file:
+//!
+//! ```text
+//! "NUSC" | u32 version = 1 | u64 header offset | block records | header (bincode)
+//! ```
+//!
+//! All integers are little-endian. Block records start at byte 16 and use
+//! the spill run layout: 16 bytes each, `x, y, z` as `i32` and a `u32` index
+//! into the header's palette, sorted by `ClusterId` then position. The
+//! header is a bincode [`CheckpointHeader`]; it comes after the records
+//! because the per-cluster index is only known once they are written. The
+//! header offset is patched in last, so a checkpoint whose writer died
+//! mid-way reads as offset 0 and is rejected.
+//!
+//! Reduce
+//! ([`WorldSegmenter::reduce_shards`](crate::world_segment::runner::WorldSegmenter::reduce_shards))
+//! parses only the headers: it merges the stitch states and serves each
+//! cluster's blocks straight from the checkpoint file when its build is
+//! materialized, so it never holds every shard's blocks at once.
+//!
+//! [`WorldSegmenter::run_incremental`](crate::world_segment::runner::WorldSegmenter::run_incremental)
+//! keeps one checkpoint per tile in a directory, named by
+//! [`tile_checkpoint_path`].
+
+use std::collections::BTreeMap;
+use std::fs::File;
+use std::io::{BufReader, BufWriter, Read, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+
+use serde::{Deserialize, Serialize};
+
+use crate::block_state::BlockState;
+use crate::world_segment::ids::{ClusterId, ContentId, TileId};
+use crate::world_segment::spill::{ClusterBlocks, RECORD_BYTES};
+use crate::world_segment::stitch::StitchState;
+
+pub const MAGIC: &[u8; 4] = b"NUSC";
+pub const VERSION: u32 = 1;
+/// Magic, version and header offset.
+const PREAMBLE: u64 = 16;
+
+/// Everything in a checkpoint except the block records.
+#[derive(Clone, Debug, Serialize, Deserialize)]
+pub struct CheckpointHeader {
+    /// `SegConfig::config_hash` of the job that wrote it. Reduce refuses
+    /// to mix checkpoints from different configs, profiles or hints.
+    pub config_hash: ContentId,
+    /// `SegmentJob::min_y`, which fixes the global cell grid.
+    pub min_y: i32,
+    /// The shard's tile ids, ascending, including ids the source had no
+    /// data for. No tile may appear in two shards of one run.
+    pub tiles: Vec<TileId>,
+    pub stitch: StitchState,
+    pub palette: Vec<BlockState>,
+    /// Cluster -> (byte offset from the start of the file, block count).
+    pub index: BTreeMap<ClusterId, (u64, u64)>,
+}
+
+/// The per-tile checkpoint for `id` in `dir`: `tile.<x>.<z>.nusc`.
+pub fn tile_checkpoint_path(dir: &Path, id: TileId) -> PathBuf {
+    dir.join(format!("tile.{}.{}.nusc", id.x, id.z))
+}
+
+/// Tile ids with a per-tile checkpoint in `dir`, ascending. A missing
+/// directory has none.
+pub fn tile_checkpoints(dir: &Path) -> std::io::Result<Vec<TileId>> {
+    if !dir.exists() {
+        return Ok(Vec::new());
+    }
+    let mut ids = Vec::new();
+    for entry in std::fs::read_dir(dir)? {
+        let name = entry?.file_name();
+        let Some(coords) = name
+            .to_str()
+            .and_then(|n| n.strip_prefix("tile."))
+            .and_then(|n| n.strip_suffix(".nusc"))
+        else {
+            continue;
+        };
+        if let Some((x, z)) = coords.split_once('.') {
+            if let (Ok(x), Ok(z)) = (x.parse(), z.parse()) {
+                ids.push(TileId { x, z });
+            }
+        }
+    }
+    ids.sort();
+    Ok(ids)
+}
+
+fn invalid(message: impl Into<String>) -> std::io::Error {
+    std::io::Error::new(std::io::ErrorKind::InvalidData, message.into())
+}
+
+/// Write a checkpoint to `path`, with every block in `blocks` (resident
+/// and spilled) in its record section.
+pub fn write_checkpoint(
+    path: &Path,
+    config_hash: ContentId,
+    min_y: i32,
+    tiles: Vec<TileId>,
+    stitch: StitchState,
+    blocks: &mut ClusterBlocks,
+) -> std::io::Result<()> {
+    let mut out = BufWriter::new(File::create(path)?);
+    out.write_all(MAGIC)?;
+    out.write_all(&VERSION.to_le_bytes())?;
+    out.write_all(&0u64.to_le_bytes())?;
+    let (palette, index) = blocks.export(&mut out, PREAMBLE)?;
+    let header = CheckpointHeader { config_hash, min_y, tiles, stitch, palette, index };
+    let header_offset = out.stream_position()?;
+    bincode::serialize_into(&mut out, &header).map_err(|e| invalid(e.to_string()))?;
+    out.seek(SeekFrom::Start(8))?;
+    out.write_all(&header_offset.to_le_bytes())?;
+    out.flush()?;
+    Ok(())
+}
+
+/// An opened checkpoint: its parsed header and the file its block records
+/// are read from.
+pub struct Checkpoint {
+    pub header: CheckpointHeader,
+    pub file: File,
+}
+
+impl Checkpoint {
+    pub fn open(path: &Path) -> std::io::Result<Checkpoint> {
+        let mut file = File::open(path)?;
+        let mut preamble = [0u8; PREAMBLE as usize];
+        file.read_exact(&mut preamble)?;
+        if &preamble[0..4] != MAGIC {
+            return Err(invalid("not a segmentation checkpoint"));
+        }
+        let version = u32::from_le_bytes(preamble[4..8].try_into().unwrap());
+        if version != VERSION {
+            return Err(invalid(format!("unsupported checkpoint version {}", version)));
+        }
+        let header_offset = u64::from_le_bytes(preamble[8..16].try_into().unwrap());
+        if header_offset < PREAMBLE {
+            return Err(invalid("incomplete checkpoint"));
+        }
+        file.seek(SeekFrom::Start(header_offset))?;
+        let header: CheckpointHeader = bincode::deserialize_from(BufReader::new(&mut file))
+            .map_err(|e| invalid(e.to_string()))?;
+        for &(offset, count) in header.index.values() {
+            let end = count.checked_mul(RECORD_BYTES as u64).and_then(|n| n.checked_add(offset));
+            if offset < PREAMBLE || end.map_or(true, |end| end > header_offset) {
+                return Err(invalid("checkpoint index out of range"));
+            }
+        }
+        Ok(Checkpoint { header, file })
+    }
+}
@@ -3,20 +3,30 @@
 //! Segmentation runs on a grid `1/C^3` the size of the tile, which is what
 //! makes closing affordable over a whole world.
 
-/// A sparse set of occupied cells of edge `cell_size`.
+/// A dense bitset of occupied cells of edge `cell_size`.
 ///
-/// `BTreeSet` rather than a dense `Vec<bool>`: after substrate subtraction the
-/// data is overwhelmingly empty, so a dense array over the tile volume would
-/// scan ~1.5M cells per pass on a real region to find a handful of occupied
-/// ones. The ordered set also gives sorted iteration for free, which is what
-/// component labelling relies on to stay order-independent.
+/// Cells are packed 64 to a word along Z, one run of words per `(x, y)` row,
+/// so a whole region at `cell_size = 4` is ~25k words (~200 KiB) however
+/// many blocks it holds. Every pass works a word at a time: dilation is a
+/// separable cube kernel applied as shifted ORs per axis, and labelling is a
+/// single union-find scan. Both visit words, never per-cell tree lookups.
+/// Word order is `(x, y, z)` order, so iterating set bits is sorted for free,
+/// which is what component labelling relies on to stay order-independent.
+///
+/// The bitset is allocated on the first mark, so a grid used only for its
+/// coordinate transform costs nothing.
 #[derive(Clone)]
 pub struct OccupancyGrid {
     /// World coordinate of the low corner of cell `(0, 0, 0)`.
     origin: (i32, i32, i32),
     dims: (usize, usize, usize),
     cell_size: u32,
-    occupied: std::collections::BTreeSet<(i32, i32, i32)>,
+    /// Words per `(x, y)` row: `ceil(dims.2 / 64)`.
+    row_words: usize,
+    /// Bit `z % 64` of word `(x * dims.1 + y) * row_words + z / 64`. Empty
+    /// until the first cell is marked.
+    bits: Vec<u64>,
+    count: usize,
 }
 
 impl OccupancyGrid {
@@ -26,7 +36,9 @@ impl OccupancyGrid {
             origin,
             dims,
             cell_size,
-            occupied: std::collections::BTreeSet::new(),
+            row_words: dims.2.div_ceil(64),
+            bits: Vec::new(),
+            count: 0,
         }
     }
 
@@ -39,7 +51,7 @@ impl OccupancyGrid {
     }
 
     pub fn count(&self) -> usize {
-        self.occupied.len()
+        self.count
     }
 
     /// Cell containing a world coordinate.
@@ -65,6 +77,17 @@ impl OccupancyGrid {
             && (cell.2 as usize) < self.dims.2
     }
 
+    fn word_len(&self) -> usize {
+        self.dims.0 * self.dims.1 * self.row_words
+    }
+
+    /// Word index and bit mask of an in-bounds cell.
+    fn locate(&self, cell: (i32, i32, i32)) -> (usize, u64) {
+        let row = cell.0 as usize * self.dims.1 + cell.1 as usize;
+        let z = cell.2 as usize;
+        (row * self.row_words + z / 64, 1u64 << (z % 64))
+    }
+
     /// Mark the cell containing this world coordinate. Out-of-range is ignored.
     pub fn mark(&mut self, x: i32, y: i32, z: i32) {
         let cell = self.cell_of(x, y, z);
@@ -72,81 +95,182 @@ impl OccupancyGrid {
     }
 
     pub fn mark_cell(&mut self, cell: (i32, i32, i32)) {
-        if self.in_bounds(cell) {
-            self.occupied.insert(cell);
+        if !self.in_bounds(cell) {
+            return;
+        }
+        if self.bits.is_empty() {
+            self.bits = vec![0; self.word_len()];
+        }
+        let (word, mask) = self.locate(cell);
+        if self.bits[word] & mask == 0 {
+            self.bits[word] |= mask;
+            self.count += 1;
         }
     }
 
     pub fn is_occupied(&self, cell: (i32, i32, i32)) -> bool {
-        self.occupied.contains(&cell)
+        if self.bits.is_empty() || !self.in_bounds(cell) {
+            return false;
+        }
+        let (word, mask) = self.locate(cell);
+        self.bits[word] & mask != 0
     }
 
     /// Occupied cells in ascending `(x, y, z)` order.
     ///
-    /// `BTreeSet` iteration is already sorted, so this is O(occupied) and the
-    /// ordering guarantee costs nothing.
+    /// Words are laid out in `(x, y, z)` order, so a scan of set bits is
+    /// already sorted.
     pub fn occupied_cells(&self) -> impl Iterator<Item = (i32, i32, i32)> + '_ {
-        self.occupied.iter().copied()
+        set_bits(&self.bits).map(move |bit| self.cell_at(bit))
     }
 
-    /// Chebyshev dilation by `radius` cells — a cube kernel.
+    /// Cell of the `bit`-th bit of the bitset.
+    fn cell_at(&self, bit: usize) -> (i32, i32, i32) {
+        let (word, offset) = (bit / 64, bit % 64);
+        let row = word / self.row_words;
+        let z = (word % self.row_words) * 64 + offset;
+        ((row / self.dims.1) as i32, (row % self.dims.1) as i32, z as i32)
+    }
+
+    /// Chebyshev dilation by `radius` cells — a cube kernel, clipped to the
+    /// grid.
+    ///
+    /// The cube is separable, so this dilates along Z, then Y, then X. Each
+    /// axis takes `radius` unit steps: a unit step along Z is a one-bit shift
+    /// each way with carries between a row's words, and along X or Y it ORs
+    /// each row with its two neighbouring rows. A unit step never leaves the
+    /// grid, and the grid is convex, so clipping after every step gives the
+    /// same cells as clipping once at the end.
     pub fn dilated(&self, radius: u32) -> OccupancyGrid {
-        let mut out = OccupancyGrid::new(self.origin, self.dims, self.cell_size);
-        if radius == 0 {
-            out.occupied = self.occupied.clone();
+        let mut out = self.clone();
+        if radius == 0 || self.bits.is_empty() {
             return out;
         }
-        let r = radius as i32;
-        for cell in &self.occupied {
-            for dx in -r..=r {
-                for dy in -r..=r {
-                    for dz in -r..=r {
-                        out.mark_cell((cell.0 + dx, cell.1 + dy, cell.2 + dz));
+        let row_words = self.row_words;
+        let rows_per_x = self.dims.1;
+        let mut scratch = vec![0u64; out.bits.len()];
+        // Bits of a row's last word that lie inside the grid.
+        let tail_mask = match self.dims.2 % 64 {
+            0 => u64::MAX,
+            n => (1u64 << n) - 1,
+        };
+
+        for _ in 0..radius {
+            for row in out.bits.chunks_exact_mut(row_words) {
+                let mut carry_up = 0u64;
+                for w in 0..row_words {
+                    let word = row[w];
+                    let next = if w + 1 < row_words { row[w + 1] } else { 0 };
+                    row[w] = word | word << 1 | carry_up | word >> 1 | next << 63;
+                    carry_up = word >> 63;
+                }
+                row[row_words - 1] &= tail_mask;
+            }
+        }
+        // Y neighbours are one row apart within an X slab; X neighbours are a
+        // whole slab apart.
+        for (axis_len, row_stride) in [(self.dims.1, 1), (self.dims.0, rows_per_x)] {
+            let stride = row_stride * row_words;
+            for _ in 0..radius {
+                scratch.copy_from_slice(&out.bits);
+                for (i, word) in out.bits.iter_mut().enumerate() {
+                    let along = (i / stride) % axis_len;
+                    if along > 0 {
+                        *word |= scratch[i - stride];
+                    }
+                    if along + 1 < axis_len {
+                        *word |= scratch[i + stride];
                     }
                 }
             }
         }
+
+        out.count = out.bits.iter().map(|w| w.count_ones() as usize).sum();
         out
     }
 
-    /// Label 6-connected components with a flood fill seeded in sorted cell
+    /// Label 6-connected components with one union-find pass in sorted cell
     /// order.
+    ///
+    /// Each occupied cell is unioned with its occupied `-x`, `-y` and `-z`
+    /// neighbours, and a set's root is always its smallest (first-scanned)
+    /// member. Labels are then handed out in order of each component's first
+    /// cell, i.e. its lexicographic minimum, which is also its anchor.
     pub fn label_components(&self) -> ComponentLabels {
-        let mut labels: std::collections::BTreeMap<(i32, i32, i32), u32> = std::collections::BTreeMap::new();
-        let mut anchors: Vec<(i32, i32, i32)> = Vec::new();
-
-        // Sorted order: the first cell reached for a component is by
-        // construction its lexicographic minimum, so it is also the anchor.
-        for seed in self.occupied_cells().collect::<Vec<_>>() {
-            if labels.contains_key(&seed) {
-                continue;
+        // rank[w] = occupied cells before word w, so a cell's union-find slot
+        // is its position in the sorted scan.
+        let mut rank = Vec::with_capacity(self.bits.len());
+        let mut total = 0u32;
+        for word in &self.bits {
+            rank.push(total);
+            total += word.count_ones();
+        }
+        let slot_of = |cell: (i32, i32, i32)| -> Option<u32> {
+            if !self.is_occupied(cell) {
+                return None;
             }
-            let label = anchors.len() as u32;
-            anchors.push(seed);
-
-            let mut stack = vec![seed];
-            labels.insert(seed, label);
-            while let Some(cell) = stack.pop() {
-                const NEIGHBOURS: [(i32, i32, i32); 6] = [
-                    (1, 0, 0), (-1, 0, 0),
-                    (0, 1, 0), (0, -1, 0),
-                    (0, 0, 1), (0, 0, -1),
-                ];
-                for (dx, dy, dz) in NEIGHBOURS {
-                    let n = (cell.0 + dx, cell.1 + dy, cell.2 + dz);
-                    if self.is_occupied(n) && !labels.contains_key(&n) {
-                        labels.insert(n, label);
-                        stack.push(n);
-                    }
+            let (word, mask) = self.locate(cell);
+            Some(rank[word] + (self.bits[word] & (mask - 1)).count_ones())
+        };
+
+        let mut parent: Vec<u32> = (0..total).collect();
+        fn find(parent: &mut [u32], mut x: u32) -> u32 {
+            while parent[x as usize] != x {
+                // Path halving.
+                parent[x as usize] = parent[parent[x as usize] as usize];
+                x = parent[x as usize];
+            }
+            x
+        }
+        for (slot, cell) in self.occupied_cells().enumerate() {
+            let slot = slot as u32;
+            for n in [
+                (cell.0 - 1, cell.1, cell.2),
+                (cell.0, cell.1 - 1, cell.2),
+                (cell.0, cell.1, cell.2 - 1),
+            ] {
+                let Some(other) = slot_of(n) else { continue };
+                let (a, b) = (find(&mut parent, slot), find(&mut parent, other));
+                // The smaller slot stays root.
+                if a < b {
+                    parent[b as usize] = a;
+                } else if b < a {
+                    parent[a as usize] = b;
                 }
             }
         }
 
-        ComponentLabels { labels, anchors }
+        let mut labels: Vec<u32> = Vec::with_capacity(total as usize);
+        let mut anchors: Vec<(i32, i32, i32)> = Vec::new();
+        for (slot, cell) in self.occupied_cells().enumerate() {
+            let root = find(&mut parent, slot as u32) as usize;
+            if root == slot {
+                labels.push(anchors.len() as u32);
+                anchors.push(cell);
+            } else {
+                // The root precedes every other member, so it is labelled.
+                labels.push(labels[root]);
+            }
+        }
+
+        ComponentLabels { grid: self.clone(), rank, labels, anchors }
     }
 }
 
-use std::collections::BTreeMap;
+/// Indices of the set bits of `words`, ascending.
+fn set_bits(words: &[u64]) -> impl Iterator<Item = usize> + '_ {
+    words.iter().enumerate().flat_map(|(w, &word)| {
+        let mut rest = word;
+        std::iter::from_fn(move || {
+            if rest == 0 {
+                return None;
+            }
+            let bit = rest.trailing_zeros() as usize;
+            rest &= rest - 1;
+            Some(w * 64 + bit)
+        })
+    })
+}
 
 /// Component labels over an occupancy grid.
 ///
@@ -154,13 +278,23 @@ use std::collections::BTreeMap;
 /// used as identity. Identity is `anchor_of`, which is a property of the
 /// component's contents and therefore independent of scan order.
 pub struct ComponentLabels {
-    labels: BTreeMap<(i32, i32, i32), u32>,
+    /// The labelled grid; a cell's label is indexed by its sorted rank.
+    grid: OccupancyGrid,
+    /// Occupied cells before each word of `grid`.
+    rank: Vec<u32>,
+    /// Label per occupied cell, in sorted cell order.
+    labels: Vec<u32>,
     anchors: Vec<(i32, i32, i32)>,
 }
 
 impl ComponentLabels {
     pub fn label_of(&self, cell: (i32, i32, i32)) -> Option<u32> {
-        self.labels.get(&cell).copied()
+        if !self.grid.is_occupied(cell) {
+            return None;
+        }
+        let (word, mask) = self.grid.locate(cell);
+        let slot = self.rank[word] + (self.grid.bits[word] & (mask - 1)).count_ones();
+        Some(self.labels[slot as usize])
     }
 
     pub fn component_count(&self) -> usize {
@@ -174,13 +308,14 @@ impl ComponentLabels {
 
     /// All labelled cells, ascending by cell coordinate.
     pub fn cells(&self) -> impl Iterator<Item = ((i32, i32, i32), u32)> + '_ {
-        self.labels.iter().map(|(c, l)| (*c, *l))
+        self.grid.occupied_cells().zip(self.labels.iter().copied())
     }
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use std::collections::BTreeMap;
 
     fn grid() -> OccupancyGrid {
         // 64^3 blocks at cell size 4 -> 16^3 cells, origin at world (0,0,0).
@@ -305,4 +440,81 @@ mod tests {
         g.mark_cell((0, 0, 0));
         assert!(g.label_components().label_of((9, 9, 9)).is_none());
     }
+
+    /// Deterministic scatter of cells over a grid whose Z rows span three
+    /// words, so shifts must carry across word boundaries.
+    fn scattered() -> OccupancyGrid {
+        let mut g = OccupancyGrid::new((0, 0, 0), (9, 6, 150), 1);
+        let mut state = 0x9e37_79b9u32;
+        for _ in 0..60 {
+            state = state.wrapping_mul(1_664_525).wrapping_add(1_013_904_223);
+            let c = ((state >> 8) % 9, (state >> 12) % 6, (state >> 16) % 150);
+            g.mark_cell((c.0 as i32, c.1 as i32, c.2 as i32));
+        }
+        for c in [(0, 0, 63), (0, 0, 64), (8, 5, 149), (4, 3, 127), (4, 3, 128)] {
+            g.mark_cell(c);
+        }
+        g
+    }
+
+    #[test]
+    fn word_parallel_dilation_matches_per_cell_dilation() {
+        let g = scattered();
+        for radius in 1..=3 {
+            let r = radius as i32;
+            let mut expected = std::collections::BTreeSet::new();
+            for cell in g.occupied_cells() {
+                for dx in -r..=r {
+                    for dy in -r..=r {
+                        for dz in -r..=r {
+                            let n = (cell.0 + dx, cell.1 + dy, cell.2 + dz);
+                            if g.in_bounds(n) {
+                                expected.insert(n);
+                            }
+                        }
+                    }
+                }
+            }
+            let d = g.dilated(radius);
+            assert_eq!(d.occupied_cells().collect::<Vec<_>>(), expected.into_iter().collect::<Vec<_>>());
+            assert_eq!(d.count(), d.occupied_cells().count(), "radius {radius}");
+        }
+    }
+
+    #[test]
+    fn union_find_labels_match_a_sorted_flood_fill() {
+        let g = scattered().dilated(1);
+        let labels = g.label_components();
+
+        // Reference: flood fill seeded in sorted order, as labelling used to be.
+        let mut expected: BTreeMap<(i32, i32, i32), u32> = BTreeMap::new();
+        let mut next = 0;
+        for seed in g.occupied_cells() {
+            if expected.contains_key(&seed) {
+                continue;
+            }
+            let mut stack = vec![seed];
+            expected.insert(seed, next);
+            while let Some(c) = stack.pop() {
+                for n in [
+                    (c.0 + 1, c.1, c.2), (c.0 - 1, c.1, c.2),
+                    (c.0, c.1 + 1, c.2), (c.0, c.1 - 1, c.2),
+                    (c.0, c.1, c.2 + 1), (c.0, c.1, c.2 - 1),
+                ] {
+                    if g.is_occupied(n) && !expected.contains_key(&n) {
+                        expected.insert(n, next);
+                        stack.push(n);
+                    }
+                }
+            }
+            assert_eq!(labels.anchor_of(next), seed);
+            next += 1;
+        }
+
+        assert_eq!(labels.component_count(), next as usize);
+        assert_eq!(labels.cells().collect::<BTreeMap<_, _>>(), expected);
+        for (cell, label) in &expected {
+            assert_eq!(labels.label_of(*cell), Some(*label));
+        }
+    }
 }
@@ -0,0 +1,553 @@
+//! Random access into a `.tar.gz` world archive through a gzip access-point
+//! index (the zlib `zran` technique).
+//!
+//! Building the index inflates the archive once, stopping at every deflate
+//! block boundary. Every `span` bytes of output it records an access point:
+//! where the next block starts in the compressed stream (a byte offset plus
+//! the 0-7 leftover bits of the byte before it) and the 32 KiB of output
+//! before it, which is all the back-reference history a fresh inflater
+//! needs. The same pass walks the tar headers and records the uncompressed
+//! offset and size of every region entry.
+//!
+//! Reading an entry seeks to the last access point at or before it, primes
+//! a raw inflater with the leftover bits and the window, and inflates at
+//! most `span` bytes of lead-in to reach it. Every read opens its own file
+//! handle, so any number of threads or processes can decompress the same
+//! archive at once.
+//!
+//! The index is kept next to the archive as `<archive>.nuzx`:
+//!
+//! ```text
+//! "NUZX" | u32 version = 1 | GzIndex (bincode)
+//! ```
+//!
+//! It records the archive's length and modification time and is rebuilt
+//! when either changes. Windows are stored deflated. Only the first gzip
+//! member is indexed, matching what the streaming path reads.
+
+use std::ffi::c_int;
+use std::fs::File;
+use std::io::{self, BufReader, Read, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+use std::time::UNIX_EPOCH;
+
+use serde::{Deserialize, Serialize};
+
+use crate::world_segment::targz_source::parse_region_coords;
+
+pub const MAGIC: &[u8; 4] = b"NUZX";
+pub const VERSION: u32 = 1;
+/// Output bytes between access points: the most a read inflates and
+/// throws away before reaching its entry.
+pub const DEFAULT_SPAN: u64 = 4 << 20;
+/// Deflate's back-reference distance.
+const WINDOW: usize = 32 * 1024;
+const CHUNK: usize = 64 * 1024;
+
+fn invalid(message: impl Into<String>) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, message.into())
+}
+
+fn truncated() -> io::Error {
+    io::Error::new(io::ErrorKind::UnexpectedEof, "gzip stream ends early")
+}
+
+/// A zlib inflate stream. flate2 exposes neither `Z_BLOCK` nor
+/// `inflatePrime`, so this drives the zlib-rs backend flate2 already links
+/// through its zlib-compatible API.
+struct Inflater {
+    /// Boxed: zlib keeps a pointer back to the stream, so it must not move.
+    strm: Box<libz_rs_sys::z_stream>,
+}
+
+impl Inflater {
+    /// `window_bits` as for `inflateInit2`: 31 expects a gzip header, -15
+    /// is raw deflate.
+    fn new(window_bits: c_int) -> io::Result<Inflater> {
+        // SAFETY: an all-zero z_stream (no allocator, no input) is the
+        // state zlib expects before init.
+        let mut strm: Box<libz_rs_sys::z_stream> = Box::new(unsafe { std::mem::zeroed() });
+        // SAFETY: `strm` is a live, pinned z_stream; the version and size
+        // are the library's own.
+        let ret = unsafe {
+            libz_rs_sys::inflateInit2_(
+                &mut *strm,
+                window_bits,
+                libz_rs_sys::zlibVersion(),
+                std::mem::size_of::<libz_rs_sys::z_stream>() as c_int,
+            )
+        };
+        if ret != libz_rs_sys::Z_OK {
+            return Err(invalid(format!("inflateInit2 failed ({})", ret)));
+        }
+        Ok(Inflater { strm })
+    }
+
+    /// Inflate from `input` into `output`. Returns bytes consumed, bytes
+    /// produced and whether the deflate stream ended.
+    fn inflate(
+        &mut self,
+        input: &[u8],
+        output: &mut [u8],
+        flush: c_int,
+    ) -> io::Result<(usize, usize, bool)> {
+        let avail_in = input.len().min(u32::MAX as usize);
+        let avail_out = output.len().min(u32::MAX as usize);
+        self.strm.next_in = input.as_ptr() as *mut u8;
+        self.strm.avail_in = avail_in as u32;
+        self.strm.next_out = output.as_mut_ptr();
+        self.strm.avail_out = avail_out as u32;
+        // SAFETY: next_in and next_out point into live slices at least as
+        // long as avail_in and avail_out.
+        let ret = unsafe { libz_rs_sys::inflate(&mut *self.strm, flush) };
+        let consumed = avail_in - self.strm.avail_in as usize;
+        let produced = avail_out - self.strm.avail_out as usize;
+        match ret {
+            libz_rs_sys::Z_OK | libz_rs_sys::Z_BUF_ERROR => Ok((consumed, produced, false)),
+            libz_rs_sys::Z_STREAM_END => Ok((consumed, produced, true)),
+            libz_rs_sys::Z_NEED_DICT => Err(invalid("deflate stream needs a preset dictionary")),
+            _ => Err(invalid(format!("corrupt deflate stream ({})", ret))),
+        }
+    }
+
+    /// After a `Z_BLOCK` inflate: 128 at a block boundary, plus 64 after
+    /// the last block, plus the unused bit count of the last input byte.
+    fn data_type(&self) -> c_int {
+        self.strm.data_type
+    }
+
+    /// Feed the low `bits` bits of `value` ahead of the next input byte.
+    fn prime(&mut self, bits: u8, value: u8) -> io::Result<()> {
+        // SAFETY: the stream was initialised in `new`.
+        let ret =
+            unsafe { libz_rs_sys::inflatePrime(&mut *self.strm, bits as c_int, value as c_int) };
+        if ret != libz_rs_sys::Z_OK {
+            return Err(invalid(format!("inflatePrime failed ({})", ret)));
+        }
+        Ok(())
+    }
+
+    fn set_dictionary(&mut self, dictionary: &[u8]) -> io::Result<()> {
+        // SAFETY: the stream was initialised in `new`; `dictionary` is live
+        // for the call and zlib copies it.
+        let ret = unsafe {
+            libz_rs_sys::inflateSetDictionary(
+                &mut *self.strm,
+                dictionary.as_ptr(),
+                dictionary.len() as u32,
+            )
+        };
+        if ret != libz_rs_sys::Z_OK {
+            return Err(invalid(format!("inflateSetDictionary failed ({})", ret)));
+        }
+        Ok(())
+    }
+}
+
+impl Drop for Inflater {
+    fn drop(&mut self) {
+        // SAFETY: ends the stream `new` initialised (a no-op error if it
+        // never was).
+        unsafe {
+            libz_rs_sys::inflateEnd(&mut *self.strm);
+        }
+    }
+}
+
+/// A place a raw inflater can start from.
+#[derive(Clone, Debug, Serialize, Deserialize)]
+pub struct AccessPoint {
+    /// Uncompressed offset of the block that starts here.
+    pub out: u64,
+    /// Compressed offset of the first whole byte of the block.
+    pub input: u64,
+    /// Bits at the top of the byte before `input` that belong to the
+    /// block (0-7).
+    pub bits: u8,
+    /// The up to 32 KiB of output before `out`, deflated.
+    window: Vec<u8>,
+}
+
+impl AccessPoint {
+    fn window(&self) -> io::Result<Vec<u8>> {
+        let mut window = Vec::with_capacity(WINDOW);
+        flate2::read::DeflateDecoder::new(&self.window[..]).read_to_end(&mut window)?;
+        Ok(window)
+    }
+}
+
+/// A region entry of the archive, located in the uncompressed tar stream.
+#[derive(Clone, Debug, PartialEq, Eq, Serialize, Deserialize)]
+pub struct TarEntry {
+    pub name: String,
+    /// Uncompressed offset of the entry's data.
+    pub offset: u64,
+    pub size: u64,
+}
+
+/// Length and modification time (ns since the epoch) of an archive.
+type Stamp = (u64, Option<u64>);
+
+fn stamp(archive: &Path) -> io::Result<Stamp> {
+    let meta = std::fs::metadata(archive)?;
+    let modified = meta
+        .modified()
+        .ok()
+        .and_then(|t| t.duration_since(UNIX_EPOCH).ok())
+        .map(|d| d.as_nanos() as u64);
+    Ok((meta.len(), modified))
+}
+
+/// Access points and region entries of one `.tar.gz`.
+#[derive(Clone, Debug, Serialize, Deserialize)]
+pub struct GzIndex {
+    stamp: Stamp,
+    pub span: u64,
+    /// Ascending by `out`; the first is at output offset 0.
+    pub points: Vec<AccessPoint>,
+    /// Region entries (by name) in archive order.
+    pub entries: Vec<TarEntry>,
+}
+
+/// `<archive>.nuzx`.
+pub fn index_path(archive: &Path) -> PathBuf {
+    let mut name = archive.as_os_str().to_owned();
+    name.push(".nuzx");
+    PathBuf::from(name)
+}
+
+impl GzIndex {
+    /// Inflate `archive` once, recording an access point every `span`
+    /// output bytes and every region entry.
+    pub fn build(archive: &Path, span: u64) -> io::Result<GzIndex> {
+        let stamp = stamp(archive)?;
+        let mut indexer = Indexer::new(File::open(archive)?, span)?;
+        let mut entries = Vec::new();
+        {
+            let mut tar = tar::Archive::new(&mut indexer);
+            for entry in tar.entries()? {
+                let entry = entry?;
+                let name = entry.path()?.to_string_lossy().to_string();
+                if parse_region_coords(&name).is_some() {
+                    let (offset, size) = (entry.raw_file_position(), entry.size());
+                    entries.push(TarEntry { name, offset, size });
+                }
+            }
+        }
+        Ok(GzIndex { stamp, span, points: indexer.points, entries })
+    }
+
+    pub fn load(path: &Path) -> io::Result<GzIndex> {
+        let bytes = std::fs::read(path)?;
+        if bytes.len() < 8 || &bytes[..4] != MAGIC {
+            return Err(invalid("not a gzip index"));
+        }
+        let version = u32::from_le_bytes(bytes[4..8].try_into().unwrap());
+        if version != VERSION {
+            return Err(invalid(format!("unsupported gzip index version {}", version)));
+        }
+        bincode::deserialize(&bytes[8..]).map_err(|e| invalid(e.to_string()))
+    }
+
+    /// Write the index to `path`, through a temporary file renamed over it.
+    pub fn save(&self, path: &Path) -> io::Result<()> {
+        let mut bytes = Vec::new();
+        bytes.extend_from_slice(MAGIC);
+        bytes.extend_from_slice(&VERSION.to_le_bytes());
+        bincode::serialize_into(&mut bytes, self).map_err(|e| invalid(e.to_string()))?;
+        let tmp = path.with_extension("nuzx.tmp");
+        std::fs::write(&tmp, bytes)?;
+        std::fs::rename(&tmp, path)?;
+        Ok(())
+    }
+
+    /// The saved index of `archive` if it is still current, else a fresh
+    /// one, saved for next time. A failed save is reported, not fatal: a
+    /// read-only archive directory still gets random access.
+    pub fn open_or_build(archive: &Path, span: u64) -> io::Result<GzIndex> {
+        let path = index_path(archive);
+        let current = stamp(archive)?;
+        if let Ok(index) = GzIndex::load(&path) {
+            if index.stamp == current && index.span == span {
+                return Ok(index);
+            }
+        }
+        let index = GzIndex::build(archive, span)?;
+        if let Err(e) = index.save(&path) {
+            eprintln!("world_segment: could not save gzip index {}: {e}", path.display());
+        }
+        Ok(index)
+    }
+
+    /// `len` uncompressed bytes of `archive` from `offset`, inflated from
+    /// the nearest access point on a file handle of its own.
+    pub fn read_at(&self, archive: &Path, offset: u64, len: u64) -> io::Result<Vec<u8>> {
+        let point = match self.points.partition_point(|p| p.out <= offset) {
+            0 => return Err(invalid("gzip index has no access points")),
+            i => &self.points[i - 1],
+        };
+        let mut file = BufReader::new(File::open(archive)?);
+        let mut inflater = Inflater::new(-15)?;
+        if point.bits > 0 {
+            file.seek(SeekFrom::Start(point.input - 1))?;
+            let mut byte = [0u8];
+            file.read_exact(&mut byte)?;
+            inflater.prime(point.bits, byte[0] >> (8 - point.bits))?;
+        } else {
+            file.seek(SeekFrom::Start(point.input))?;
+        }
+        let window = point.window()?;
+        if !window.is_empty() {
+            inflater.set_dictionary(&window)?;
+        }
+
+        let mut skip = offset - point.out;
+        let mut out = Vec::with_capacity(len as usize);
+        let mut scratch = vec![0u8; WINDOW];
+        let mut input = vec![0u8; CHUNK];
+        let (mut pos, mut filled) = (0, 0);
+        while skip > 0 || (out.len() as u64) < len {
+            if pos == filled {
+                filled = file.read(&mut input)?;
+                pos = 0;
+                if filled == 0 {
+                    return Err(truncated());
+                }
+            }
+            let (consumed, end) = if skip > 0 {
+                let want = skip.min(WINDOW as u64) as usize;
+                let (consumed, produced, end) = inflater.inflate(
+                    &input[pos..filled],
+                    &mut scratch[..want],
+                    libz_rs_sys::Z_NO_FLUSH,
+                )?;
+                skip -= produced as u64;
+                (consumed, end)
+            } else {
+                let start = out.len();
+                let want = (len - start as u64).min(CHUNK as u64) as usize;
+                out.resize(start + want, 0);
+                let (consumed, produced, end) = inflater.inflate(
+                    &input[pos..filled],
+                    &mut out[start..],
+                    libz_rs_sys::Z_NO_FLUSH,
+                )?;
+                out.truncate(start + produced);
+                (consumed, end)
+            };
+            pos += consumed;
+            if end && (skip > 0 || (out.len() as u64) < len) {
+                return Err(truncated());
+            }
+        }
+        Ok(out)
+    }
+}
+
+/// The uncompressed tar stream of a gzip file, recording access points as
+/// it goes. Output is inflated into a 32 KiB ring, so the window for a new
+/// access point is always the ring itself.
+struct Indexer<R> {
+    input: R,
+    inflater: Inflater,
+    buf: Vec<u8>,
+    pos: usize,
+    filled: usize,
+    ring: Vec<u8>,
+    /// Next write position in `ring`.
+    head: usize,
+    /// Whether `ring` has filled at least once.
+    wrapped: bool,
+    /// Inflated bytes in `ring` not yet read out.
+    pending: (usize, usize),
+    total_in: u64,
+    total_out: u64,
+    span: u64,
+    points: Vec<AccessPoint>,
+    done: bool,
+}
+
+impl<R: Read> Indexer<R> {
+    fn new(input: R, span: u64) -> io::Result<Indexer<R>> {
+        Ok(Indexer {
+            input,
+            inflater: Inflater::new(31)?,
+            buf: vec![0u8; CHUNK],
+            pos: 0,
+            filled: 0,
+            ring: vec![0u8; WINDOW],
+            head: 0,
+            wrapped: false,
+            pending: (0, 0),
+            total_in: 0,
+            total_out: 0,
+            span,
+            points: Vec::new(),
+            done: false,
+        })
+    }
+
+    /// Inflate up to the next block boundary or the end of the ring.
+    fn step(&mut self) -> io::Result<()> {
+        if self.pos == self.filled {
+            self.filled = self.input.read(&mut self.buf)?;
+            self.pos = 0;
+            if self.filled == 0 {
+                return Err(truncated());
+            }
+        }
+        if self.head == WINDOW {
+            self.head = 0;
+            self.wrapped = true;
+        }
+        let (consumed, produced, end) = self.inflater.inflate(
+            &self.buf[self.pos..self.filled],
+            &mut self.ring[self.head..],
+            libz_rs_sys::Z_BLOCK,
+        )?;
+        self.pos += consumed;
+        self.total_in += consumed as u64;
+        self.pending = (self.head, self.head + produced);
+        self.head += produced;
+        self.total_out += produced as u64;
+        if end {
+            self.done = true;
+            return Ok(());
+        }
+        let data_type = self.inflater.data_type();
+        let due = self.points.last().map_or(true, |p| self.total_out - p.out > self.span);
+        if data_type & 128 != 0 && data_type & 64 == 0 && due {
+            self.add_point((data_type & 7) as u8)?;
+        }
+        Ok(())
+    }
+
+    fn add_point(&mut self, bits: u8) -> io::Result<()> {
+        let mut encoder =
+            flate2::write::DeflateEncoder::new(Vec::new(), flate2::Compression::fast());
+        if self.wrapped {
+            encoder.write_all(&self.ring[self.head..])?;
+        }
+        encoder.write_all(&self.ring[..self.head])?;
+        self.points.push(AccessPoint {
+            out: self.total_out,
+            input: self.total_in,
+            bits,
+            window: encoder.finish()?,
+        });
+        Ok(())
+    }
+}
+
+impl<R: Read> Read for Indexer<R> {
+    fn read(&mut self, out: &mut [u8]) -> io::Result<usize> {
+        while self.pending.0 == self.pending.1 && !self.done {
+            self.step()?;
+        }
+        let (start, end) = self.pending;
+        let n = out.len().min(end - start);
+        out[..n].copy_from_slice(&self.ring[start..start + n]);
+        self.pending.0 += n;
+        Ok(n)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Half noise, half runs, so deflate emits many blocks of both kinds.
+    fn entry_bytes(seed: u64, len: usize) -> Vec<u8> {
+        let mut state = seed.wrapping_mul(6364136223846793005).wrapping_add(1);
+        let mut bytes = Vec::with_capacity(len);
+        while bytes.len() < len {
+            state = state.wrapping_mul(6364136223846793005).wrapping_add(1442695040888963407);
+            let b = (state >> 33) as u8;
+            if state >> 63 == 0 {
+                bytes.push(b);
+            } else {
+                bytes.extend(std::iter::repeat(b).take((b % 24) as usize));
+            }
+        }
+        bytes.truncate(len);
+        bytes
+    }
+
+    fn write_archive(path: &Path, entries: &[(&str, Vec<u8>)]) {
+        let mut tar_bytes = Vec::new();
+        {
+            let mut builder = tar::Builder::new(&mut tar_bytes);
+            for (name, data) in entries {
+                let mut header = tar::Header::new_gnu();
+                header.set_size(data.len() as u64);
+                header.set_mode(0o644);
+                header.set_cksum();
+                builder.append_data(&mut header, name, &data[..]).unwrap();
+            }
+            builder.finish().unwrap();
+        }
+        let mut encoder =
+            flate2::write::GzEncoder::new(Vec::new(), flate2::Compression::default());
+        encoder.write_all(&tar_bytes).unwrap();
+        std::fs::write(path, encoder.finish().unwrap()).unwrap();
+    }
+
+    #[test]
+    fn indexed_reads_match_archive_entries() {
+        let path = std::env::temp_dir().join("nucleation_test_gz_index_reads.tar.gz");
+        let entries = vec![
+            ("world/region/r.0.0.mca", entry_bytes(1, 300_000)),
+            ("world/level.dat", entry_bytes(2, 5_000)),
+            ("world/region/r.1.0.mca", entry_bytes(3, 700_000)),
+            ("world/region/r.-1.2.mca", entry_bytes(4, 90_000)),
+        ];
+        write_archive(&path, &entries);
+
+        let index = GzIndex::build(&path, 64 * 1024).unwrap();
+        assert!(index.points.len() > 4, "a small span yields many access points");
+        assert!(index.points.iter().any(|p| p.bits != 0), "some points start mid-byte");
+        let names: Vec<&str> = index.entries.iter().map(|e| e.name.as_str()).collect();
+        assert_eq!(
+            names,
+            ["world/region/r.0.0.mca", "world/region/r.1.0.mca", "world/region/r.-1.2.mca"]
+        );
+
+        // Readers on other threads, each with its own cursor.
+        std::thread::scope(|scope| {
+            for entry in &index.entries {
+                let (index, path) = (&index, &path);
+                let expected = &entries.iter().find(|(n, _)| *n == entry.name).unwrap().1;
+                scope.spawn(move || {
+                    let data = index.read_at(path, entry.offset, entry.size).unwrap();
+                    assert_eq!(&data, expected, "{}", entry.name);
+                });
+            }
+        });
+        // A read that starts between access points, deep inside an entry.
+        let entry = &index.entries[1];
+        let data = index.read_at(&path, entry.offset + 200_001, 1_000).unwrap();
+        assert_eq!(data, entries[2].1[200_001..201_001]);
+
+        std::fs::remove_file(&path).ok();
+    }
+
+    #[test]
+    fn saved_index_is_reused_until_the_archive_changes() {
+        let path = std::env::temp_dir().join("nucleation_test_gz_index_sidecar.tar.gz");
+        write_archive(&path, &[("region/r.0.0.mca", entry_bytes(5, 50_000))]);
+        let sidecar = index_path(&path);
+        std::fs::remove_file(&sidecar).ok();
+
+        let built = GzIndex::open_or_build(&path, DEFAULT_SPAN).unwrap();
+        assert!(sidecar.exists());
+        let loaded = GzIndex::open_or_build(&path, DEFAULT_SPAN).unwrap();
+        assert_eq!(loaded.entries, built.entries);
+
+        write_archive(&path, &[("region/r.0.0.mca", entry_bytes(6, 80_000))]);
+        let rebuilt = GzIndex::open_or_build(&path, DEFAULT_SPAN).unwrap();
+        assert_eq!(rebuilt.entries[0].size, 80_000);
+
+        std::fs::remove_file(&path).ok();
+        std::fs::remove_file(&sidecar).ok();
+    }
+}
@@ -0,0 +1,179 @@
+//! Stage timings and throughput of a segmentation run, for capacity
+//! planning.
+//!
+//! Metrics are collected beside the pipeline and never fed into it: a run's
+//! builds and [`RunStats`](crate::world_segment::runner::RunStats) are the
+//! same whether or not anyone reads them. That is why they are a separate
+//! struct — `RunStats` is compared across serial, parallel and sharded runs,
+//! and wall-clock times never match.
+
+use std::time::Duration;
+
+use crate::world_segment::spill::RECORD_BYTES;
+
+/// How often [`Progress`] passes metrics to its callback while a run is
+/// going. The final metrics are always reported.
+pub const PROGRESS_INTERVAL: Duration = Duration::from_secs(1);
+
+/// What a run spent its time on, and how much it moved.
+///
+/// Stage times are summed over workers, so on a parallel run `segment` and
+/// `stitch` are CPU time and can exceed `total`.
+#[derive(Clone, Debug, Default, PartialEq)]
+pub struct RunMetrics {
+    /// Reading and decoding tiles from the source.
+    pub decode: Duration,
+    /// Segmenting tiles and retaining their blocks (including spills).
+    pub segment: Duration,
+    /// Merging stitch states and resolving them into builds.
+    pub stitch: Duration,
+    /// Identity matching, scoring, gathering blocks and building schematics.
+    pub materialize: Duration,
+    /// Time inside the caller's `emit`.
+    pub emit: Duration,
+    /// Wall-clock time since the run started.
+    pub total: Duration,
+    /// Tiles segmented so far.
+    pub tiles: u64,
+    /// Blocks in those tiles.
+    pub blocks: u64,
+    /// Builds emitted so far.
+    pub builds: u64,
+    /// The most blocks retained in memory at once by any one worker.
+    pub peak_retained_blocks: u64,
+    /// Largest `StitchState::margin_len` while stitching.
+    pub peak_margin_entries: u64,
+    /// `StitchState::margin_len` once every tile was merged.
+    pub final_margin_entries: u64,
+    /// Spill runs written.
+    pub spilled_runs: u64,
+    /// Blocks written to spill runs.
+    pub spilled_blocks: u64,
+}
+
+fn per_sec(count: u64, elapsed: Duration) -> f64 {
+    let secs = elapsed.as_secs_f64();
+    if secs > 0.0 {
+        count as f64 / secs
+    } else {
+        0.0
+    }
+}
+
+impl RunMetrics {
+    pub fn tiles_per_sec(&self) -> f64 {
+        per_sec(self.tiles, self.total)
+    }
+
+    pub fn blocks_per_sec(&self) -> f64 {
+        per_sec(self.blocks, self.total)
+    }
+
+    /// Bytes written to spill runs.
+    pub fn spilled_bytes(&self) -> u64 {
+        self.spilled_blocks * RECORD_BYTES as u64
+    }
+
+    /// Fold in another worker's metrics: times and counts add, peaks take
+    /// the larger. `total` and the spill and final-margin figures are set
+    /// by the runner, not summed.
+    pub fn absorb(&mut self, other: &RunMetrics) {
+        self.decode += other.decode;
+        self.segment += other.segment;
+        self.stitch += other.stitch;
+        self.materialize += other.materialize;
+        self.emit += other.emit;
+        self.tiles += other.tiles;
+        self.blocks += other.blocks;
+        self.builds += other.builds;
+        self.peak_retained_blocks = self.peak_retained_blocks.max(other.peak_retained_blocks);
+        self.peak_margin_entries = self.peak_margin_entries.max(other.peak_margin_entries);
+    }
+}
+
+/// A monotonic clock. wasm32 has none, so there every reading is zero and
+/// only the counters in [`RunMetrics`] mean anything.
+#[derive(Clone, Copy)]
+pub(crate) struct Clock {
+    #[cfg(not(target_arch = "wasm32"))]
+    started: std::time::Instant,
+}
+
+impl Clock {
+    pub(crate) fn start() -> Clock {
+        Clock {
+            #[cfg(not(target_arch = "wasm32"))]
+            started: std::time::Instant::now(),
+        }
+    }
+
+    pub(crate) fn elapsed(&self) -> Duration {
+        #[cfg(not(target_arch = "wasm32"))]
+        return self.started.elapsed();
+        #[cfg(target_arch = "wasm32")]
+        Duration::ZERO
+    }
+}
+
+/// Passes a run's metrics to a callback at most once per
+/// [`PROGRESS_INTERVAL`], stamping `total` first.
+pub(crate) struct Progress<'a> {
+    started: Clock,
+    last: Clock,
+    report: &'a mut dyn FnMut(&RunMetrics),
+}
+
+impl<'a> Progress<'a> {
+    pub(crate) fn new(report: &'a mut dyn FnMut(&RunMetrics)) -> Progress<'a> {
+        Progress { started: Clock::start(), last: Clock::start(), report }
+    }
+
+    /// Report `metrics` if the interval has passed.
+    pub(crate) fn tick(&mut self, metrics: &mut RunMetrics) {
+        if self.last.elapsed() >= PROGRESS_INTERVAL {
+            self.last = Clock::start();
+            metrics.total = self.started.elapsed();
+            (self.report)(metrics);
+        }
+    }
+
+    /// Stamp the final `total` and report `metrics` unconditionally.
+    pub(crate) fn finish(&mut self, metrics: &mut RunMetrics) {
+        metrics.total = self.started.elapsed();
+        (self.report)(metrics);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn absorb_adds_work_and_keeps_peaks() {
+        let mut a = RunMetrics {
+            segment: Duration::from_millis(5),
+            tiles: 2,
+            blocks: 100,
+            peak_retained_blocks: 80,
+            peak_margin_entries: 3,
+            ..RunMetrics::default()
+        };
+        let b = RunMetrics {
+            segment: Duration::from_millis(7),
+            tiles: 1,
+            blocks: 50,
+            peak_retained_blocks: 40,
+            peak_margin_entries: 9,
+            ..RunMetrics::default()
+        };
+        a.absorb(&b);
+        assert_eq!(a.segment, Duration::from_millis(12));
+        assert_eq!((a.tiles, a.blocks), (3, 150));
+        assert_eq!((a.peak_retained_blocks, a.peak_margin_entries), (80, 9));
+
+        a.total = Duration::from_secs(2);
+        assert_eq!(a.tiles_per_sec(), 1.5);
+        assert_eq!(a.blocks_per_sec(), 75.0);
+        assert_eq!(RunMetrics::default().tiles_per_sec(), 0.0);
+    }
+}
@@ -14,12 +14,16 @@ pub mod segment;
 pub mod source;
 pub mod world_source;
 pub mod targz_source;
+pub mod gz_index;
 pub mod stitch;
 pub mod score;
 pub mod provenance;
 pub mod materialize;
 pub mod identity;
 pub mod runner;
+pub mod metrics;
+pub mod spill;
+pub mod checkpoint;
 
 pub use ids::{ClusterId, ContentId, TileId};
 pub use tile::{TileBounds, VoxelTile};
@@ -27,13 +31,21 @@ pub use classify::{classify, BlockClass};
 pub use profile::{ProfileParams, WorldProfile};
 pub use grid::{ComponentLabels, OccupancyGrid};
 pub use partition::{PartitionHint, PartitionIndex, PartitionPolicy};
-pub use segment::{segment_tile, segment_tile_membership, Cluster, MarginCell, SegConfig, TileSegments};
+pub use segment::{segment_tile, segment_tile_membership, Cluster, MarginCell, SegConfig, TileMembership, TileSegments};
 pub use source::{region_tile_bounds, Access, TileError, TileSource};
 pub use world_source::WorldSourceTiles;
+#[cfg(not(target_arch = "wasm32"))]
+pub use world_source::changed_tiles;
 pub use targz_source::TarGzSource;
+pub use gz_index::GzIndex;
 pub use stitch::{Build, GlobalCell, MarginEntry, StitchState};
 pub use score::{score, ScoreConfig, Scored, Signal, Tier};
 pub use provenance::{Provenance, StableBuildId};
 pub use materialize::{materialize, MaterializeCtx};
 pub use identity::{bbox_iou, match_snapshots, Outcome, PriorBuild, SnapshotMatch};
-pub use runner::{MaterializedBuild, RunStats, SegmentJob, WorldSegmenter};
+pub use runner::{
+    shard_tile_ids, IncrementalStats, MaterializedBuild, RunStats, SegmentJob, WorldSegmenter,
+};
+pub use spill::{ClusterBlocks, SpillConfig};
+pub use metrics::RunMetrics;
+pub use checkpoint::{tile_checkpoint_path, Checkpoint, CheckpointHeader};
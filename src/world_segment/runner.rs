@@ -2,32 +2,62 @@
 //! pipeline together (source -> segment -> stitch -> score -> identity ->
 //! materialize) into one deterministic, order-independent run.
 //!
-//! No clock reads (`extracted_at` is an input carried on [`SegmentJob`]), no
-//! RNG, and no `HashMap`/`HashSet` whose iteration order could reach output —
-//! only `BTreeMap`, matching the rest of the module. The result does not
+//! No clock reads reach output (`extracted_at` is an input carried on
+//! [`SegmentJob`]; the clock only feeds [`RunMetrics`]), no RNG, and no
+//! `HashMap`/`HashSet` whose iteration order could reach output — only
+//! `BTreeMap`, matching the rest of the module. The result does not
 //! depend on the order `TileSource::for_each_tile` visits tiles in, because
 //! every downstream step (`StitchState::merge`, `Vec<Build>` sorted by id,
 //! `match_snapshots` sorted by `build_id`) is itself order-independent.
+//!
+//! That same property lets [`WorldSegmenter::run_streaming_parallel`]
+//! segment tiles on a worker pool and tree-reduce the per-worker stitch
+//! states: its output is byte-identical to the serial runner's. Every
+//! runner materializes finished builds on the rayon pool in windows and
+//! emits them in stable-id order, so that tail is parallel too.
+//!
+//! The same holds across machines. [`WorldSegmenter::map_shard`] segments a
+//! shard of tile ids from a random-access source into a checkpoint file
+//! (format in [`crate::world_segment::checkpoint`]), and
+//! [`WorldSegmenter::reduce_shards`] merges the shards' stitch states,
+//! then scores and materializes exactly what `run_streaming` over the union
+//! of their tiles would. [`WorldSegmenter::run_incremental`] keeps such a
+//! checkpoint per tile and, on the next run, segments only changed tiles and
+//! materializes only the builds they affect.
+
+use std::collections::{BTreeMap, BTreeSet};
+use std::path::{Path, PathBuf};
 
-use std::collections::BTreeMap;
+use rayon::prelude::*;
 
 use crate::block_state::BlockState;
+use crate::telemetry::{self, stage};
 use crate::universal_schematic::UniversalSchematic;
-use crate::world_segment::identity::{match_snapshots, PriorBuild};
-use crate::world_segment::ids::ClusterId;
+use crate::world_segment::checkpoint::{
+    tile_checkpoint_path, tile_checkpoints, write_checkpoint, Checkpoint,
+};
+use crate::world_segment::identity::{match_snapshots, Outcome, PriorBuild};
+use crate::world_segment::ids::{ClusterId, TileId};
 use crate::world_segment::materialize::{materialize, MaterializeCtx};
+use crate::world_segment::metrics::{Clock, Progress, RunMetrics};
 use crate::world_segment::partition::PartitionIndex;
 use crate::world_segment::profile::WorldProfile;
-use crate::world_segment::provenance::Provenance;
+use crate::world_segment::provenance::{Provenance, StableBuildId};
 use crate::world_segment::score::{score, ScoreConfig, Tier};
 use crate::world_segment::segment::{segment_tile_membership, SegConfig};
-use crate::world_segment::source::TileSource;
-use crate::world_segment::stitch::StitchState;
+use crate::world_segment::source::{TileError, TileSource};
+use crate::world_segment::spill::{ClusterBlocks, SpillConfig};
+use crate::world_segment::stitch::{Build, StitchState};
+use crate::world_segment::tile::VoxelTile;
+
+/// Builds materialized ahead of the one being emitted, per rayon thread.
+const MATERIALIZE_AHEAD_PER_THREAD: usize = 4;
 
 /// Parameters for one segmentation run.
 ///
 /// `extracted_at` is a caller-supplied unix-seconds timestamp — never
-/// `SystemTime::now()` — so a run can be replayed byte-for-byte.
+/// `SystemTime::now()` — so a run can be replayed byte-for-byte. `spill`
+/// only bounds memory; it never affects output.
 #[derive(Clone, Debug)]
 pub struct SegmentJob {
     pub config: SegConfig,
@@ -38,6 +68,7 @@ pub struct SegmentJob {
     pub max_y: i32,
     pub extracted_at: i64,
     pub match_iou: f32,
+    pub spill: SpillConfig,
 }
 
 /// One finished build: its schematic plus the provenance envelope describing
@@ -60,6 +91,34 @@ pub struct RunStats {
     pub largest_block_count: u64,
 }
 
+/// What [`WorldSegmenter::run_incremental`] did.
+#[derive(Clone, Debug, Default, PartialEq)]
+pub struct IncrementalStats {
+    /// Over every current build, exactly as a full run would report them.
+    pub run: RunStats,
+    /// Tiles segmented again: changed, new, or without a usable checkpoint.
+    pub tiles_resegmented: u64,
+    /// Builds materialized and emitted.
+    pub rematerialized: u64,
+    /// Stable ids of the current builds that were not affected and not
+    /// emitted, ascending. Their previous outputs still stand.
+    pub unchanged: Vec<StableBuildId>,
+}
+
+/// Shard `index` of `count` for a distributed run: a contiguous slice of the
+/// ascending `ids`, with shard sizes differing by at most one. Empty if
+/// `index >= count`.
+pub fn shard_tile_ids(ids: &[TileId], index: usize, count: usize) -> Vec<TileId> {
+    if index >= count {
+        return Vec::new();
+    }
+    let mut ids = ids.to_vec();
+    ids.sort();
+    ids.dedup();
+    let (start, end) = (ids.len() * index / count, ids.len() * (index + 1) / count);
+    ids[start..end].to_vec()
+}
+
 /// Single-process pipeline runner: streams every tile from `source` through
 /// segmentation, stitches the results into whole builds, scores and
 /// identity-matches them, and materializes each into a schematic.
@@ -91,98 +150,551 @@ impl WorldSegmenter {
         prior: &[PriorBuild],
         emit: &mut dyn FnMut(MaterializedBuild),
     ) -> RunStats {
-        let mut stitch = StitchState::empty();
-        // Every surviving (non-substrate, non-dropped-cluster) block, grouped
-        // by the per-tile ClusterId it belonged to before stitching. A build's
-        // final block set is the union of its `cluster_ids`' entries here.
-        let mut blocks_by_cluster: BTreeMap<ClusterId, BTreeMap<(i32, i32, i32), BlockState>> =
-            BTreeMap::new();
+        let mut ignore = |_: &RunMetrics| {};
+        Self::run_streaming_metered(source, profile, partitions, job, prior, &mut ignore, emit).0
+    }
 
+    /// [`Self::run_streaming`], also returning per-stage [`RunMetrics`] and
+    /// passing the metrics so far to `progress` about once a second (see
+    /// [`PROGRESS_INTERVAL`](crate::world_segment::metrics::PROGRESS_INTERVAL))
+    /// and once at the end.
+    pub fn run_streaming_metered(
+        source: &dyn TileSource,
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        prior: &[PriorBuild],
+        progress: &mut dyn FnMut(&RunMetrics),
+        emit: &mut dyn FnMut(MaterializedBuild),
+    ) -> (RunStats, RunMetrics) {
+        let mut progress = Progress::new(progress);
+        let mut partial = Partial::new(job);
+        let mut read = Clock::start();
         source
             .for_each_tile(&mut |tile| {
-                let (segs, membership) =
-                    segment_tile_membership(&tile, profile, &job.config, partitions);
-                stitch = StitchState::merge(
-                    std::mem::replace(&mut stitch, StitchState::empty()),
-                    StitchState::from(&segs, job.config.cell_size, job.min_y),
-                    job.config.closing_radius,
-                );
-
-                // Built once per tile, not once per membership entry.
-                let tile_blocks: BTreeMap<(i32, i32, i32), BlockState> =
-                    tile.blocks().map(|(p, b)| (p, b.clone())).collect();
-                for (pos, cid) in membership {
-                    if let Some(block) = tile_blocks.get(&pos) {
-                        blocks_by_cluster.entry(cid).or_default().insert(pos, block.clone());
-                    }
-                }
-
+                partial.metrics.decode += read.elapsed();
+                partial.add_tile(&tile, profile, partitions, job);
+                progress.tick(&mut partial.metrics);
+                read = Clock::start();
                 Ok(())
             })
             // Acceptable for this task: a failing source aborts the run rather
             // than partially materializing. See Task 5's report for the note.
             .expect("tile source failed");
+        partial.metrics.decode += read.elapsed();
+
+        let all = |_: &Build, _: &Outcome| true;
+        let (stats, _, metrics) = Self::emit_builds_where(
+            partial, profile, partitions, job, prior, &all, &mut progress, emit,
+        );
+        (stats, metrics)
+    }
+
+    /// [`Self::run`] on a worker pool; see [`Self::run_streaming_parallel`].
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn run_parallel(
+        source: &dyn TileSource,
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        prior: &[PriorBuild],
+        workers: usize,
+    ) -> Vec<MaterializedBuild> {
+        let mut out = Vec::new();
+        let mut collect = |mb| out.push(mb);
+        Self::run_streaming_parallel(source, profile, partitions, job, prior, workers, &mut collect);
+        out
+    }
+
+    /// [`Self::run_streaming`] with tiles segmented on `workers` threads
+    /// (`0` = one per core).
+    ///
+    /// The source is still read on the calling thread, in its natural order;
+    /// tiles are handed to the pool through a bounded queue, so at most a few
+    /// tiles per worker are in flight, and each worker spills retained blocks
+    /// past its own `job.spill` budget. Each worker folds its tiles into its
+    /// own partial stitch, and the partials are merged pairwise in a tree.
+    /// `StitchState::merge` is order-independent, so the builds, their order
+    /// and their bytes match the serial runner exactly.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn run_streaming_parallel(
+        source: &dyn TileSource,
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        prior: &[PriorBuild],
+        workers: usize,
+        emit: &mut dyn FnMut(MaterializedBuild),
+    ) -> RunStats {
+        let mut ignore = |_: &RunMetrics| {};
+        Self::run_streaming_parallel_metered(
+            source, profile, partitions, job, prior, workers, &mut ignore, emit,
+        )
+        .0
+    }
+
+    /// [`Self::run_streaming_parallel`] with metrics, as
+    /// [`Self::run_streaming_metered`]. While tiles stream, progress reports
+    /// carry what the calling thread sees (tiles and blocks read, decode
+    /// time); the workers' segment and stitch times arrive once they finish.
+    #[cfg(not(target_arch = "wasm32"))]
+    #[allow(clippy::too_many_arguments)]
+    pub fn run_streaming_parallel_metered(
+        source: &dyn TileSource,
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        prior: &[PriorBuild],
+        workers: usize,
+        progress: &mut dyn FnMut(&RunMetrics),
+        emit: &mut dyn FnMut(MaterializedBuild),
+    ) -> (RunStats, RunMetrics) {
+        use rayon::iter::{ParallelBridge, ParallelIterator};
+
+        let mut progress = Progress::new(progress);
+
+        let pool = rayon::ThreadPoolBuilder::new()
+            .num_threads(workers)
+            .thread_name(|i| format!("world-segment-{}", i))
+            .build()
+            .expect("failed to start segmentation workers");
+        let queue_depth = 2 * pool.current_num_threads();
+
+        let partial = std::thread::scope(|scope| {
+            let (tx, rx) = std::sync::mpsc::sync_channel::<VoxelTile>(queue_depth);
+            let reducer = scope.spawn(move || {
+                pool.install(|| {
+                    rx.into_iter()
+                        .par_bridge()
+                        .fold(|| Partial::new(job), |mut partial, tile| {
+                            partial.add_tile(&tile, profile, partitions, job);
+                            partial
+                        })
+                        .reduce(|| Partial::new(job), |a, b| {
+                            Partial::merge(a, b, job.config.closing_radius)
+                        })
+                })
+            });
+            // The calling thread's view, for progress reports only.
+            let mut live = RunMetrics::default();
+            let mut read = Clock::start();
+            let streamed = source.for_each_tile(&mut |tile| {
+                live.decode += read.elapsed();
+                live.tiles += 1;
+                live.blocks += tile.len() as u64;
+                let sent = tx.send(tile).map_err(|_| {
+                    crate::world_segment::source::TileError::Io(
+                        "segmentation workers stopped".to_string(),
+                    )
+                });
+                progress.tick(&mut live);
+                read = Clock::start();
+                sent
+            });
+            live.decode += read.elapsed();
+            // Closing the queue lets the workers drain and finish.
+            drop(tx);
+            let mut partial = reducer.join().expect("segmentation worker panicked");
+            // Same policy as the serial runner: a failing source aborts.
+            streamed.expect("tile source failed");
+            partial.metrics.decode = live.decode;
+            partial
+        });
+
+        let all = |_: &Build, _: &Outcome| true;
+        let (stats, _, metrics) = Self::emit_builds_where(
+            partial, profile, partitions, job, prior, &all, &mut progress, emit,
+        );
+        (stats, metrics)
+    }
+
+    /// Map phase of a distributed run: segment the tiles `ids` (see
+    /// [`shard_tile_ids`]) pulled from a random-access `source`, and write
+    /// the shard's stitch state and retained blocks to a checkpoint at
+    /// `path`. Returns the number of tiles the source had data for.
+    pub fn map_shard(
+        source: &dyn TileSource,
+        ids: &[TileId],
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        path: &Path,
+    ) -> Result<usize, TileError> {
+        let mut tiles = ids.to_vec();
+        tiles.sort();
+        tiles.dedup();
+        let mut partial = Partial::new(job);
+        let mut found = 0;
+        for &id in &tiles {
+            if let Some(tile) = source.tile(id)? {
+                partial.add_tile(&tile, profile, partitions, job);
+                found += 1;
+            }
+        }
+
+        let Partial { stitch, mut blocks_by_cluster, .. } = partial;
+        let config_hash = job.config.config_hash(profile, partitions);
+        write_checkpoint(path, config_hash, job.min_y, tiles, stitch, &mut blocks_by_cluster)
+            .map_err(|e| TileError::Io(format!("{}: {}", path.display(), e)))?;
+        Ok(found)
+    }
+
+    /// Reduce phase of a distributed run: merge the checkpoints written by
+    /// [`Self::map_shard`] and emit builds exactly as
+    /// [`Self::run_streaming`] over the union of their tiles would. The
+    /// checkpoints must come from the same job, profile and partitions, and
+    /// no tile may be in two of them.
+    ///
+    /// Only the checkpoint headers are held in memory; blocks are read from
+    /// the checkpoint files as each build materializes, so the files must
+    /// stay in place until this returns.
+    pub fn reduce_shards(
+        checkpoints: &[PathBuf],
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        prior: &[PriorBuild],
+        emit: &mut dyn FnMut(MaterializedBuild),
+    ) -> Result<RunStats, TileError> {
+        let config_hash = job.config.config_hash(profile, partitions);
+        let mut partial = Partial::new(job);
+        let mut seen: BTreeSet<TileId> = BTreeSet::new();
+        for path in checkpoints {
+            let Checkpoint { header, file } = Checkpoint::open(path)
+                .map_err(|e| TileError::Malformed(format!("{}: {}", path.display(), e)))?;
+            if header.config_hash != config_hash || header.min_y != job.min_y {
+                return Err(TileError::Malformed(format!(
+                    "{}: checkpoint was written under a different job, profile or partitions",
+                    path.display()
+                )));
+            }
+            if let Some(id) = header.tiles.iter().find(|id| !seen.insert(**id)) {
+                return Err(TileError::Malformed(format!(
+                    "{}: tile ({}, {}) is in more than one shard",
+                    path.display(),
+                    id.x,
+                    id.z
+                )));
+            }
+            partial.stitch = StitchState::merge(
+                std::mem::replace(&mut partial.stitch, StitchState::empty()),
+                header.stitch,
+                job.config.closing_radius,
+            );
+            partial.blocks_by_cluster.adopt(file, header.palette, header.index);
+        }
+
+        Ok(Self::emit_builds(partial, profile, partitions, job, prior, emit))
+    }
+
+    /// Incremental run over a random-access `source`, keeping one checkpoint
+    /// per tile in `checkpoint_dir` (see
+    /// [`tile_checkpoint_path`](crate::world_segment::checkpoint::tile_checkpoint_path)).
+    ///
+    /// Segments again only the tiles in `changed` and those without a usable
+    /// checkpoint (missing, unreadable, or written under another job,
+    /// profile or partitions), so an empty directory makes this a full run.
+    /// A tile's segmentation depends on that tile alone, so the neighbours
+    /// of a changed tile keep their checkpoints; joins across its margins
+    /// are redone when every tile's stitch state is merged, which reads
+    /// only checkpoint headers.
+    ///
+    /// Only affected builds are materialized and emitted: those holding a
+    /// cluster of a re-segmented tile, whose cluster set did not exist in
+    /// the previous run, or whose match against `prior` is a split or a
+    /// merge. Pass the previous run's builds as `prior` so the others keep
+    /// their stable ids. After this returns, a previous output whose stable
+    /// id is neither emitted nor in [`IncrementalStats::unchanged`] is gone.
+    #[allow(clippy::too_many_arguments)]
+    pub fn run_incremental(
+        source: &dyn TileSource,
+        changed: &[TileId],
+        checkpoint_dir: &Path,
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        prior: &[PriorBuild],
+        emit: &mut dyn FnMut(MaterializedBuild),
+    ) -> Result<IncrementalStats, TileError> {
+        let io =
+            |path: &Path, e: std::io::Error| TileError::Io(format!("{}: {}", path.display(), e));
+        std::fs::create_dir_all(checkpoint_dir).map_err(|e| io(checkpoint_dir, e))?;
+        let config_hash = job.config.config_hash(profile, partitions);
+        let closing_radius = job.config.closing_radius;
+
+        let checkpointed = tile_checkpoints(checkpoint_dir).map_err(|e| io(checkpoint_dir, e))?;
+        let mut tiles: BTreeSet<TileId> = checkpointed.into_iter().collect();
+        tiles.extend(source.tile_ids()?);
+        tiles.extend(changed.iter().copied());
+        let mut stale: BTreeSet<TileId> = changed.iter().copied().collect();
+
+        // The previous run's stitch, from every checkpoint still usable.
+        let mut previous = StitchState::empty();
+        let mut kept: Vec<Checkpoint> = Vec::new();
+        for &id in &tiles {
+            match Checkpoint::open(&tile_checkpoint_path(checkpoint_dir, id)) {
+                Ok(cp) if cp.header.config_hash == config_hash && cp.header.min_y == job.min_y => {
+                    let stitch = cp.header.stitch.clone();
+                    previous = StitchState::merge(previous, stitch, closing_radius);
+                    if !stale.contains(&id) {
+                        kept.push(cp);
+                    }
+                }
+                _ => {
+                    stale.insert(id);
+                }
+            }
+        }
 
-        let builds = stitch.finish();
+        let mut partial = Partial::new(job);
+        let mut resegmented: BTreeSet<ClusterId> = BTreeSet::new();
+        for &id in &stale {
+            // Written aside and renamed, so a failed run leaves the old one.
+            let path = tile_checkpoint_path(checkpoint_dir, id);
+            let tmp = path.with_extension("nusc.tmp");
+            Self::map_shard(source, &[id], profile, partitions, job, &tmp)?;
+            std::fs::rename(&tmp, &path).map_err(|e| io(&path, e))?;
+            let cp = Checkpoint::open(&path).map_err(|e| io(&path, e))?;
+            resegmented.extend(cp.header.stitch.cluster_ids());
+            kept.push(cp);
+        }
+        for Checkpoint { header, file } in kept {
+            partial.stitch = StitchState::merge(
+                std::mem::replace(&mut partial.stitch, StitchState::empty()),
+                header.stitch,
+                closing_radius,
+            );
+            partial.blocks_by_cluster.adopt(file, header.palette, header.index);
+        }
+
+        let before: BTreeSet<Vec<ClusterId>> =
+            previous.finish().into_iter().map(|build| build.cluster_ids).collect();
+        let affected = |build: &Build, outcome: &Outcome| {
+            matches!(outcome, Outcome::Split { .. } | Outcome::Merge { .. })
+                || !before.contains(&build.cluster_ids)
+                || build.cluster_ids.iter().any(|id| resegmented.contains(id))
+        };
+        let mut rematerialized = 0;
+        let mut count = |mb: MaterializedBuild| {
+            rematerialized += 1;
+            emit(mb)
+        };
+        let mut ignore = |_: &RunMetrics| {};
+        let (run, unchanged, _) = Self::emit_builds_where(
+            partial,
+            profile,
+            partitions,
+            job,
+            prior,
+            &affected,
+            &mut Progress::new(&mut ignore),
+            &mut count,
+        );
+        let tiles_resegmented = stale.len() as u64;
+        Ok(IncrementalStats { run, tiles_resegmented, rematerialized, unchanged })
+    }
+
+    /// Everything after segmentation: stitch into builds, identity-match,
+    /// score and materialize, emitting in stable-id order.
+    fn emit_builds(
+        partial: Partial,
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        prior: &[PriorBuild],
+        emit: &mut dyn FnMut(MaterializedBuild),
+    ) -> RunStats {
+        let all = |_: &Build, _: &Outcome| true;
+        let mut ignore = |_: &RunMetrics| {};
+        let mut progress = Progress::new(&mut ignore);
+        Self::emit_builds_where(partial, profile, partitions, job, prior, &all, &mut progress, emit)
+            .0
+    }
+
+    /// [`Self::emit_builds`], materializing only the builds `rematerialize`
+    /// accepts. Stats still cover every build. Returns the stable ids of the
+    /// builds that were skipped, ascending, and the run's metrics, finished
+    /// and reported to `progress`.
+    #[allow(clippy::too_many_arguments)]
+    fn emit_builds_where(
+        partial: Partial,
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+        prior: &[PriorBuild],
+        rematerialize: &dyn Fn(&Build, &Outcome) -> bool,
+        progress: &mut Progress,
+        emit: &mut dyn FnMut(MaterializedBuild),
+    ) -> (RunStats, Vec<StableBuildId>, RunMetrics) {
+        let Partial { stitch, mut blocks_by_cluster, mut metrics } = partial;
+        metrics.final_margin_entries = stitch.margin_len() as u64;
+        metrics.peak_retained_blocks = blocks_by_cluster.peak_resident() as u64;
+        metrics.spilled_runs = blocks_by_cluster.spilled_runs() as u64;
+        metrics.spilled_blocks = blocks_by_cluster.spilled_blocks();
+        let clock = Clock::start();
+        let builds = {
+            let _stage = stage!(INFO, "segment.stitch", margin = metrics.final_margin_entries);
+            stitch.finish()
+        };
+        metrics.stitch += clock.elapsed();
+        let _stage = stage!(INFO, "segment.materialize", builds = builds.len());
+        telemetry::count("segment.builds", builds.len() as u64);
+        let clock = Clock::start();
 
         let matches = match_snapshots(&builds, prior, &job.source_id, job.match_iou);
-        let stable_by_build: BTreeMap<ClusterId, crate::world_segment::provenance::StableBuildId> =
-            matches.into_iter().map(|m| (m.build_id, m.stable_id)).collect();
+        let match_by_build: BTreeMap<ClusterId, (StableBuildId, Outcome)> =
+            matches.into_iter().map(|m| (m.build_id, (m.stable_id, m.outcome))).collect();
 
         let config_hash = job.config.config_hash(profile, partitions);
         let profile_hash = profile.profile_hash();
 
         // Sort builds by stable id up front so they're emitted in the same
         // deterministic order `run` used to return them in.
-        let mut ordered_builds: Vec<&crate::world_segment::stitch::Build> = builds.iter().collect();
-        ordered_builds.sort_by_key(|build| {
-            *stable_by_build
-                .get(&build.id)
-                .expect("match_snapshots returns exactly one match per current build")
-        });
+        let mut ordered_builds: Vec<(&Build, StableBuildId, &Outcome)> = builds
+            .iter()
+            .map(|build| {
+                let (stable_id, outcome) = match_by_build
+                    .get(&build.id)
+                    .expect("match_snapshots returns exactly one match per current build");
+                (build, *stable_id, outcome)
+            })
+            .collect();
+        ordered_builds.sort_by_key(|(_, stable_id, _)| *stable_id);
+
+        metrics.materialize += clock.elapsed();
 
+        let ctx = MaterializeCtx {
+            source_id: &job.source_id,
+            snapshot_id: &job.snapshot_id,
+            config_hash,
+            profile_hash,
+            extracted_at: job.extracted_at,
+        };
+
+        // Builds are materialized a window at a time: blocks are gathered
+        // serially (spill runs share file handles), the window is turned
+        // into schematics on the rayon pool, and the results are emitted in
+        // order. The window bounds how many unemitted builds are in memory.
+        let window = MATERIALIZE_AHEAD_PER_THREAD * rayon::current_num_threads();
         let mut stats = RunStats::default();
-        for build in ordered_builds {
-            // Union the blocks of every cluster this build absorbed.
-            let mut blocks: BTreeMap<(i32, i32, i32), BlockState> = BTreeMap::new();
-            for cid in &build.cluster_ids {
-                if let Some(cluster_blocks) = blocks_by_cluster.get(cid) {
-                    for (pos, b) in cluster_blocks {
-                        blocks.insert(*pos, b.clone());
-                    }
+        let mut skipped = Vec::new();
+        for chunk in ordered_builds.chunks(window.max(1)) {
+            let clock = Clock::start();
+            let mut pending = Vec::new();
+            for &(build, stable_id, outcome) in chunk {
+                let scored = score(build, &job.score_config);
+                stats.builds += 1;
+                match scored.tier {
+                    Tier::Confident => stats.tier_confident += 1,
+                    Tier::Probable => stats.tier_probable += 1,
+                    Tier::Debris => stats.tier_debris += 1,
+                }
+                if build.cluster_ids.len() > 1 {
+                    stats.cross_tile += 1;
+                }
+                stats.largest_block_count = stats.largest_block_count.max(build.block_count);
+                if !rematerialize(build, outcome) {
+                    skipped.push(stable_id);
+                    continue;
                 }
-            }
 
-            let scored = score(build, &job.score_config);
-            let stable_id = *stable_by_build
-                .get(&build.id)
-                .expect("match_snapshots returns exactly one match per current build");
-
-            let ctx = MaterializeCtx {
-                source_id: &job.source_id,
-                snapshot_id: &job.snapshot_id,
-                config_hash,
-                profile_hash,
-                extracted_at: job.extracted_at,
-            };
-            let (schematic, provenance) =
-                materialize(build, &blocks, scored.tier, stable_id, &ctx);
-
-            stats.builds += 1;
-            match scored.tier {
-                Tier::Confident => stats.tier_confident += 1,
-                Tier::Probable => stats.tier_probable += 1,
-                Tier::Debris => stats.tier_debris += 1,
+                // Union the blocks of every cluster this build absorbed.
+                let mut blocks: BTreeMap<(i32, i32, i32), BlockState> = BTreeMap::new();
+                for cid in &build.cluster_ids {
+                    blocks_by_cluster.blocks_for(cid, &mut blocks).expect("block spill failed");
+                }
+                pending.push((build, stable_id, scored.tier, blocks));
             }
-            if build.cluster_ids.len() > 1 {
-                stats.cross_tile += 1;
+
+            let materialized: Vec<MaterializedBuild> = pending
+                .into_par_iter()
+                .map(|(build, stable_id, tier, blocks)| {
+                    let (schematic, provenance) =
+                        materialize(build, &blocks, tier, stable_id, &ctx);
+                    MaterializedBuild { schematic, provenance }
+                })
+                .collect();
+            metrics.materialize += clock.elapsed();
+
+            for mb in materialized {
+                let clock = Clock::start();
+                emit(mb);
+                metrics.emit += clock.elapsed();
+                metrics.builds += 1;
+                progress.tick(&mut metrics);
             }
-            stats.largest_block_count = stats.largest_block_count.max(build.block_count);
+        }
 
-            emit(MaterializedBuild { schematic, provenance });
+        progress.finish(&mut metrics);
+        (stats, skipped, metrics)
+    }
+}
+
+/// Segmentation output for some subset of a world's tiles.
+struct Partial {
+    stitch: StitchState,
+    /// Every surviving (non-substrate, non-dropped-cluster) block, grouped
+    /// by the per-tile ClusterId it belonged to before stitching. A build's
+    /// final block set is the union of its `cluster_ids`' entries here.
+    /// Spilled to disk past `job.spill`'s budget.
+    blocks_by_cluster: ClusterBlocks,
+    /// Time spent and work done building this partial.
+    metrics: RunMetrics,
+}
+
+impl Partial {
+    fn new(job: &SegmentJob) -> Self {
+        Partial {
+            stitch: StitchState::empty(),
+            blocks_by_cluster: ClusterBlocks::new(job.spill.clone()),
+            metrics: RunMetrics::default(),
         }
+    }
+
+    fn add_tile(
+        &mut self,
+        tile: &VoxelTile,
+        profile: &WorldProfile,
+        partitions: &PartitionIndex,
+        job: &SegmentJob,
+    ) {
+        let _stage = stage!(DEBUG, "segment.tile", blocks = tile.len());
+        telemetry::count("segment.tiles", 1);
+        let clock = Clock::start();
+        let (segs, membership) = segment_tile_membership(tile, profile, &job.config, partitions);
+        let tile_stitch = StitchState::from(&segs, job.config.cell_size, job.min_y);
+        self.blocks_by_cluster.insert_tile(tile, &membership);
+        self.blocks_by_cluster.maybe_spill().expect("block spill failed");
+        self.metrics.segment += clock.elapsed();
+
+        let clock = Clock::start();
+        self.stitch = StitchState::merge(
+            std::mem::replace(&mut self.stitch, StitchState::empty()),
+            tile_stitch,
+            job.config.closing_radius,
+        );
+        self.metrics.stitch += clock.elapsed();
+        self.metrics.tiles += 1;
+        self.metrics.blocks += tile.len() as u64;
+        self.metrics.peak_margin_entries =
+            self.metrics.peak_margin_entries.max(self.stitch.margin_len() as u64);
+    }
 
-        stats
+    /// Order-independent: tiles are disjoint, so their cluster block sets
+    /// never disagree on a position.
+    fn merge(a: Partial, b: Partial, closing_radius: u32) -> Partial {
+        let mut metrics = a.metrics;
+        metrics.absorb(&b.metrics);
+        let clock = Clock::start();
+        let stitch = StitchState::merge(a.stitch, b.stitch, closing_radius);
+        metrics.stitch += clock.elapsed();
+        metrics.peak_margin_entries =
+            metrics.peak_margin_entries.max(stitch.margin_len() as u64);
+        let clock = Clock::start();
+        let blocks_by_cluster = ClusterBlocks::merge(a.blocks_by_cluster, b.blocks_by_cluster)
+            .expect("block spill failed");
+        metrics.segment += clock.elapsed();
+        Partial { stitch, blocks_by_cluster, metrics }
     }
 }
 
@@ -268,6 +780,7 @@ mod tests {
             max_y: 63,
             extracted_at: 1_700_000_000,
             match_iou: 0.5,
+            spill: SpillConfig::default(),
         };
 
         let mut emitted: Vec<MaterializedBuild> = Vec::new();
@@ -324,6 +837,7 @@ mod tests {
             max_y: 63,
             extracted_at: 1_700_000_000,
             match_iou: 0.5,
+            spill: SpillConfig::default(),
         };
 
         let out = WorldSegmenter::run(&source, &profile, &partitions, &job, &[]);
@@ -349,4 +863,386 @@ mod tests {
             Some("minecraft:repeater".to_string())
         );
     }
+
+    #[test]
+    fn builds_past_the_materialize_window_emit_in_stable_id_order() {
+        // Enough isolated specks to fill several materialize windows.
+        let count = 2 * MATERIALIZE_AHEAD_PER_THREAD * rayon::current_num_threads() + 1;
+        let side = (count as f64).sqrt().ceil() as i32;
+        let mut blocks: Vec<((i32, i32, i32), BlockState)> = Vec::new();
+        for i in 0..count as i32 {
+            let (x, z) = ((i % side) * 24, (i / side) * 24);
+            blocks.push(((x, -60, z), BlockState::new("minecraft:stone")));
+            blocks.push(((x, -59, z), BlockState::new("minecraft:redstone_wire")));
+        }
+        let source = MemSource {
+            id: TileId { x: 0, z: 0 },
+            bounds: TileBounds { min: (0, -64, 0), max: (side * 24, 63, side * 24) },
+            blocks,
+        };
+        let job = SegmentJob {
+            config: SegConfig::default(),
+            score_config: ScoreConfig::default(),
+            source_id: "src".to_string(),
+            snapshot_id: "snap1".to_string(),
+            min_y: -64,
+            max_y: 63,
+            extracted_at: 1_700_000_000,
+            match_iou: 0.5,
+            spill: SpillConfig::default(),
+        };
+
+        let mut ids = Vec::new();
+        let stats = WorldSegmenter::run_streaming(
+            &source,
+            &profile(),
+            &PartitionIndex::new(vec![]),
+            &job,
+            &[],
+            &mut |mb| ids.push(mb.provenance.stable_build_id),
+        );
+        assert_eq!(stats.builds, count as u64);
+        assert_eq!(ids.len(), count);
+        assert!(ids.windows(2).all(|w| w[0] < w[1]), "emitted in stable-id order");
+    }
+
+    /// A source that yields several pre-built tiles, streamed in the given
+    /// order.
+    struct MultiSource {
+        tiles: Vec<(TileId, TileBounds, Vec<((i32, i32, i32), BlockState)>)>,
+    }
+
+    impl TileSource for MultiSource {
+        fn access(&self) -> Access {
+            Access::Random
+        }
+
+        fn tile_ids(&self) -> Result<Vec<TileId>, TileError> {
+            let mut ids: Vec<TileId> = self.tiles.iter().map(|(id, _, _)| *id).collect();
+            ids.sort();
+            Ok(ids)
+        }
+
+        fn tile(&self, id: TileId) -> Result<Option<VoxelTile>, TileError> {
+            Ok(self.tiles.iter().find(|(t, _, _)| *t == id).map(|(id, bounds, blocks)| {
+                VoxelTile::from_blocks(*id, *bounds, blocks.iter().cloned())
+            }))
+        }
+
+        fn for_each_tile(
+            &self,
+            f: &mut dyn FnMut(VoxelTile) -> Result<(), TileError>,
+        ) -> Result<(), TileError> {
+            for (id, bounds, blocks) in &self.tiles {
+                f(VoxelTile::from_blocks(*id, *bounds, blocks.iter().cloned()))?;
+            }
+            Ok(())
+        }
+    }
+
+    /// A stone slab around the corner shared by four region tiles, with
+    /// builds straddling both tile boundaries plus a few isolated specks.
+    fn corner_source() -> MultiSource {
+        use crate::world_segment::source::region_tile_bounds;
+
+        let mut world: Vec<((i32, i32, i32), BlockState)> = Vec::new();
+        for x in 496..528 {
+            for z in 496..528 {
+                world.push(((x, -60, z), BlockState::new("minecraft:stone")));
+            }
+        }
+        for x in 504..520 {
+            world.push(((x, -59, 506), BlockState::new("minecraft:redstone_wire")));
+        }
+        for z in 508..518 {
+            world.push(((500, -59, z), BlockState::new("minecraft:repeater")));
+        }
+        for (x, z) in [(498, 498), (525, 500), (500, 525), (524, 524)] {
+            world.push(((x, -59, z), BlockState::new("minecraft:redstone_wire")));
+        }
+
+        let mut tiles = Vec::new();
+        for (rx, rz) in [(1, 1), (0, 0), (1, 0), (0, 1)] {
+            let (id, bounds) = region_tile_bounds(rx, rz, -64, 63);
+            let blocks: Vec<_> = world
+                .iter()
+                .filter(|((x, _, z), _)| {
+                    (bounds.min.0..=bounds.max.0).contains(x)
+                        && (bounds.min.2..=bounds.max.2).contains(z)
+                })
+                .cloned()
+                .collect();
+            tiles.push((id, bounds, blocks));
+        }
+        MultiSource { tiles }
+    }
+
+    fn corner_job() -> SegmentJob {
+        SegmentJob {
+            config: SegConfig::default(),
+            score_config: ScoreConfig::default(),
+            source_id: "src".to_string(),
+            snapshot_id: "snap1".to_string(),
+            min_y: -64,
+            max_y: 63,
+            extracted_at: 1_700_000_000,
+            match_iou: 0.5,
+            spill: SpillConfig::default(),
+        }
+    }
+
+    #[test]
+    fn parallel_run_matches_serial_run() {
+        let source = corner_source();
+        let profile = profile();
+        let partitions = PartitionIndex::new(vec![]);
+        let job = corner_job();
+
+        let mut serial = Vec::new();
+        let serial_stats = WorldSegmenter::run_streaming(
+            &source,
+            &profile,
+            &partitions,
+            &job,
+            &[],
+            &mut |mb| serial.push(mb.provenance),
+        );
+        assert!(serial_stats.cross_tile >= 1, "the wire and repeater runs span tiles");
+
+        // A budget small enough that every tile spills its blocks to disk.
+        let spilling = SegmentJob {
+            spill: SpillConfig { dir: std::env::temp_dir(), max_resident_blocks: 8 },
+            ..job.clone()
+        };
+        let mut spilled = Vec::new();
+        let spilled_stats = WorldSegmenter::run_streaming(
+            &source,
+            &profile,
+            &partitions,
+            &spilling,
+            &[],
+            &mut |mb| spilled.push(mb.provenance),
+        );
+        assert_eq!(spilled_stats, serial_stats);
+        assert_eq!(spilled, serial);
+
+        for (workers, job) in [(1, &job), (3, &job), (3, &spilling)] {
+            let mut parallel = Vec::new();
+            let parallel_stats = WorldSegmenter::run_streaming_parallel(
+                &source,
+                &profile,
+                &partitions,
+                job,
+                &[],
+                workers,
+                &mut |mb| parallel.push(mb.provenance),
+            );
+            assert_eq!(parallel_stats, serial_stats);
+            // Same builds, same emit order, same fingerprints.
+            assert_eq!(parallel, serial);
+        }
+    }
+
+    #[test]
+    fn metered_runs_count_the_pipeline() {
+        let source = corner_source();
+        let profile = profile();
+        let partitions = PartitionIndex::new(vec![]);
+        let job = SegmentJob {
+            spill: SpillConfig { dir: std::env::temp_dir(), max_resident_blocks: 8 },
+            ..corner_job()
+        };
+        let ids = source.tile_ids().unwrap();
+        let tiles = ids.len() as u64;
+        let blocks: u64 =
+            ids.iter().map(|&id| source.tile(id).unwrap().unwrap().len() as u64).sum();
+
+        let plain =
+            WorldSegmenter::run_streaming(&source, &profile, &partitions, &job, &[], &mut |_| {});
+        let mut reports = Vec::new();
+        let (stats, metrics) = WorldSegmenter::run_streaming_metered(
+            &source,
+            &profile,
+            &partitions,
+            &job,
+            &[],
+            &mut |m| reports.push(m.clone()),
+            &mut |_| {},
+        );
+        assert_eq!(stats, plain, "metering does not change the run");
+        assert_eq!((metrics.tiles, metrics.blocks, metrics.builds), (tiles, blocks, stats.builds));
+        assert!(metrics.spilled_runs > 0 && metrics.spilled_bytes() > 0);
+        assert!(metrics.peak_retained_blocks > 0 && metrics.peak_margin_entries > 0);
+        assert_eq!(reports.last(), Some(&metrics), "the final metrics are always reported");
+
+        let (parallel, parallel_metrics) = WorldSegmenter::run_streaming_parallel_metered(
+            &source,
+            &profile,
+            &partitions,
+            &job,
+            &[],
+            3,
+            &mut |_| {},
+            &mut |_| {},
+        );
+        assert_eq!(parallel, plain);
+        assert_eq!((parallel_metrics.tiles, parallel_metrics.blocks), (tiles, blocks));
+        assert_eq!(parallel_metrics.final_margin_entries, metrics.final_margin_entries);
+    }
+
+    #[test]
+    fn sharded_run_matches_serial_run() {
+        let source = corner_source();
+        let profile = profile();
+        let partitions = PartitionIndex::new(vec![]);
+        let job = corner_job();
+        let mut serial = Vec::new();
+        let serial_stats = WorldSegmenter::run_streaming(
+            &source,
+            &profile,
+            &partitions,
+            &job,
+            &[],
+            &mut |mb| serial.push(mb.provenance),
+        );
+
+        // Four tiles in three shards, mapped with a budget that spills and
+        // reduced in reverse order.
+        let spilling = SegmentJob {
+            spill: SpillConfig { dir: std::env::temp_dir(), max_resident_blocks: 8 },
+            ..job.clone()
+        };
+        let ids = source.tile_ids().unwrap();
+        let dir = std::env::temp_dir();
+        let mut paths = Vec::new();
+        for shard in 0..3 {
+            let path = dir.join(format!("nucleation-shard-{}-{}.nusc", std::process::id(), shard));
+            let shard_ids = shard_tile_ids(&ids, shard, 3);
+            let found = WorldSegmenter::map_shard(
+                &source, &shard_ids, &profile, &partitions, &spilling, &path,
+            )
+            .unwrap();
+            assert_eq!(found, shard_ids.len());
+            paths.push(path);
+        }
+        paths.reverse();
+
+        let mut sharded = Vec::new();
+        let sharded_stats = WorldSegmenter::reduce_shards(
+            &paths,
+            &profile,
+            &partitions,
+            &job,
+            &[],
+            &mut |mb| sharded.push(mb.provenance),
+        )
+        .unwrap();
+        assert_eq!(sharded_stats, serial_stats);
+        assert_eq!(sharded, serial);
+
+        // A shard fed twice is a scheduling bug, not a no-op.
+        let twice = [paths[0].clone(), paths[0].clone()];
+        let err =
+            WorldSegmenter::reduce_shards(&twice, &profile, &partitions, &job, &[], &mut |_| {});
+        assert!(matches!(err, Err(TileError::Malformed(_))));
+        // So is a checkpoint from another config.
+        let other =
+            SegmentJob { config: SegConfig { closing_radius: 1, ..SegConfig::default() }, ..job };
+        let err =
+            WorldSegmenter::reduce_shards(&paths, &profile, &partitions, &other, &[], &mut |_| {});
+        assert!(matches!(err, Err(TileError::Malformed(_))));
+
+        for path in paths {
+            std::fs::remove_file(path).unwrap();
+        }
+    }
+
+    #[test]
+    fn incremental_run_rematerializes_only_affected_builds() {
+        let profile = profile();
+        let partitions = PartitionIndex::new(vec![]);
+        let job = corner_job();
+        let dir = std::env::temp_dir()
+            .join(format!("nucleation-incremental-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        let as_prior = |catalogue: &BTreeMap<StableBuildId, Provenance>| -> Vec<PriorBuild> {
+            catalogue
+                .values()
+                .map(|p| PriorBuild {
+                    stable_id: p.stable_build_id,
+                    bbox: p.world_bbox,
+                    block_count: p.block_count,
+                })
+                .collect()
+        };
+
+        // The corner world plus a far speck, in a build of its own.
+        let mut source = corner_source();
+        let speck = BlockState::new("minecraft:redstone_wire");
+        fn tile(source: &mut MultiSource, id: TileId) -> &mut Vec<((i32, i32, i32), BlockState)> {
+            &mut source.tiles.iter_mut().find(|(t, _, _)| *t == id).unwrap().2
+        }
+        tile(&mut source, TileId { x: 0, z: 0 }).push(((100, -59, 100), speck.clone()));
+
+        // An empty checkpoint directory makes the first run a full one.
+        let mut catalogue: BTreeMap<StableBuildId, Provenance> = BTreeMap::new();
+        let mut emit = |mb: MaterializedBuild| {
+            catalogue.insert(mb.provenance.stable_build_id, mb.provenance);
+        };
+        let first = WorldSegmenter::run_incremental(
+            &source, &[], &dir, &profile, &partitions, &job, &[], &mut emit,
+        )
+        .unwrap();
+        assert_eq!(first.tiles_resegmented, 4);
+        assert_eq!(first.rematerialized, first.run.builds);
+        assert!(first.unchanged.is_empty());
+
+        // Nothing changed: nothing is segmented or materialized.
+        let prior = as_prior(&catalogue);
+        let again = WorldSegmenter::run_incremental(
+            &source, &[], &dir, &profile, &partitions, &job, &prior, &mut |_| panic!("emitted"),
+        )
+        .unwrap();
+        assert_eq!(again.run, first.run);
+        assert_eq!((again.tiles_resegmented, again.rematerialized), (0, 0));
+        assert_eq!(again.unchanged, catalogue.keys().copied().collect::<Vec<_>>());
+
+        // A new speck in tile (1, 1); the one in tile (0, 0) is untouched.
+        let changed = TileId { x: 1, z: 1 };
+        tile(&mut source, changed).push(((900, -59, 900), speck));
+        let mut emitted = Vec::new();
+        let update = WorldSegmenter::run_incremental(
+            &source,
+            &[changed],
+            &dir,
+            &profile,
+            &partitions,
+            &job,
+            &prior,
+            &mut |mb| emitted.push(mb.provenance),
+        )
+        .unwrap();
+        assert_eq!(update.tiles_resegmented, 1);
+        assert!(update.rematerialized >= 1 && update.rematerialized < update.run.builds);
+        assert_eq!(update.rematerialized + update.unchanged.len() as u64, update.run.builds);
+
+        // Unchanged outputs plus the emitted ones are exactly a full run's.
+        catalogue.retain(|id, _| update.unchanged.contains(id));
+        catalogue.extend(emitted.into_iter().map(|p| (p.stable_build_id, p)));
+        let mut full = BTreeMap::new();
+        let full_stats = WorldSegmenter::run_streaming(
+            &source,
+            &profile,
+            &partitions,
+            &job,
+            &prior,
+            &mut |mb| {
+                full.insert(mb.provenance.stable_build_id, mb.provenance);
+            },
+        );
+        assert_eq!(update.run, full_stats);
+        assert_eq!(catalogue, full);
+
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
 }
@@ -251,27 +251,91 @@ pub fn segment_tile(
 /// for the same input — both are driven by the same inner labelling, so
 /// there is a single source of truth and no risk of the two drifting apart.
 ///
-/// The map only contains blocks whose cluster survives the
+/// The membership only contains blocks whose cluster survives the
 /// `min_cluster_blocks` filter; substrate blocks and blocks in dropped
-/// clusters are absent. It is a `BTreeMap` keyed by world position so the
-/// result is order-independent regardless of how the tile's blocks were
-/// iterated.
+/// clusters are absent. It is keyed by the tile's cell index, which follows
+/// world position, so the result is order-independent regardless of how the
+/// tile's blocks were iterated.
 pub fn segment_tile_membership(
     tile: &VoxelTile,
     profile: &WorldProfile,
     config: &SegConfig,
     partitions: &PartitionIndex,
-) -> (TileSegments, BTreeMap<(i32, i32, i32), ClusterId>) {
+) -> (TileSegments, TileMembership) {
     segment_tile_inner(tile, profile, config, partitions, true)
 }
 
+/// Which cluster each surviving block of one tile belongs to.
+///
+/// Stored as `(cell, cluster)` pairs of `u32`s, ascending by cell: `cell`
+/// indexes [`VoxelTile::cells`] (so the block's position and palette index
+/// come from the tile, never copied) and `cluster` indexes
+/// [`Self::clusters`]. Eight bytes per block and no per-block allocation.
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct TileMembership {
+    /// Distinct clusters, ascending.
+    clusters: Vec<ClusterId>,
+    entries: Vec<(u32, u32)>,
+}
+
+impl TileMembership {
+    /// From `(cell index, cluster)` pairs in any order. A cell listed twice
+    /// keeps its first pair.
+    pub fn new(mut members: Vec<(u32, ClusterId)>) -> Self {
+        members.sort_by_key(|(cell, _)| *cell);
+        members.dedup_by_key(|(cell, _)| *cell);
+        let mut clusters: Vec<ClusterId> = members.iter().map(|(_, id)| *id).collect();
+        clusters.sort_unstable();
+        clusters.dedup();
+        let entries = members
+            .into_iter()
+            .map(|(cell, id)| (cell, clusters.binary_search(&id).expect("collected above") as u32))
+            .collect();
+        TileMembership { clusters, entries }
+    }
+
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+
+    /// Distinct clusters, ascending; indexed by [`Self::entries`].
+    pub fn clusters(&self) -> &[ClusterId] {
+        &self.clusters
+    }
+
+    /// `(cell index, index into clusters())`, ascending by cell.
+    pub fn entries(&self) -> &[(u32, u32)] {
+        &self.entries
+    }
+
+    /// `(cell index, cluster)` per member, ascending by cell.
+    pub fn iter(&self) -> impl Iterator<Item = (u32, ClusterId)> + '_ {
+        self.entries.iter().map(move |&(cell, c)| (cell, self.clusters[c as usize]))
+    }
+
+    pub fn cluster_of_cell(&self, cell: u32) -> Option<ClusterId> {
+        let i = self.entries.binary_search_by_key(&cell, |(c, _)| *c).ok()?;
+        Some(self.clusters[self.entries[i].1 as usize])
+    }
+
+    /// Cluster of the block at world `pos` of `tile`, the tile this
+    /// membership was computed for.
+    pub fn get(&self, tile: &VoxelTile, pos: (i32, i32, i32)) -> Option<ClusterId> {
+        self.cluster_of_cell(tile.cell_index(pos)? as u32)
+    }
+}
+
 fn segment_tile_inner(
     tile: &VoxelTile,
     profile: &WorldProfile,
     config: &SegConfig,
     partitions: &PartitionIndex,
     want_membership: bool,
-) -> (TileSegments, BTreeMap<(i32, i32, i32), ClusterId>) {
+) -> (TileSegments, TileMembership) {
     let bounds = tile.bounds();
     let cell = config.cell_size.max(1);
     // Every ClusterId minted below is bound to this hash, so ids produced
@@ -317,8 +381,8 @@ fn segment_tile_inner(
     // an anchor cell is no longer unique on its own — hence the partition is
     // folded into `ClusterId` alongside the anchor.
     //
-    // Cost is unchanged in the usual case: grids are sparse `BTreeSet`s, one
-    // per occupied partition, and a block is marked exactly once.
+    // Cost is unchanged in the usual case: grids are bitsets allocated only
+    // for occupied partitions, and a block is marked exactly once.
     // Partition-scoped floor materials, keyed by the SAME partition index the
     // loop below resolves each block to. Empty (and skipped entirely) unless the
     // caller opted in with `partition_floor_share` AND partitions are in force,
@@ -331,9 +395,10 @@ fn segment_tile_inner(
             _ => BTreeMap::new(),
         };
 
-    let mut artificial: Vec<((i32, i32, i32), Option<u32>)> = Vec::new();
+    // `(cell index, position, partition)` of every non-substrate block.
+    let mut artificial: Vec<(u32, (i32, i32, i32), Option<u32>)> = Vec::new();
     let mut grids: BTreeMap<Option<u32>, OccupancyGrid> = BTreeMap::new();
-    for (pos, state) in tile.blocks() {
+    for (cell_index, (pos, state)) in tile.blocks().enumerate() {
         if classify(state, pos.1, profile) == BlockClass::Substrate {
             continue;
         }
@@ -355,7 +420,7 @@ fn segment_tile_inner(
                 }
             }
         }
-        artificial.push((pos, pidx));
+        artificial.push((cell_index as u32, pos, pidx));
         grids
             .entry(pidx)
             .or_insert_with(|| OccupancyGrid::new(origin, dims, cell))
@@ -364,7 +429,7 @@ fn segment_tile_inner(
     if artificial.is_empty() {
         return (
             TileSegments { tile_id: tile.id(), clusters: Vec::new(), margin: Vec::new() },
-            BTreeMap::new(),
+            TileMembership::default(),
         );
     }
 
@@ -396,13 +461,13 @@ fn segment_tile_inner(
     // `min_cluster_blocks` filter below decides which clusters survive. Kept
     // only when the caller actually wants it, so `segment_tile` pays nothing
     // extra.
-    let mut pos_to_cluster: BTreeMap<(i32, i32, i32), ClusterId> = BTreeMap::new();
-    for (pos, pidx) in artificial {
+    let mut members: Vec<(u32, ClusterId)> = Vec::new();
+    for (cell_index, pos, pidx) in artificial {
         let cell_coord = geometry.cell_of(pos.0, pos.1, pos.2);
         let Some(id) = cluster_of_cell.get(&(pidx, cell_coord)) else { continue };
         acc.entry(*id).or_insert_with(ClusterAcc::new).push(pos, cell_coord);
         if want_membership {
-            pos_to_cluster.insert(pos, *id);
+            members.push((cell_index, *id));
         }
     }
 
@@ -466,9 +531,10 @@ fn segment_tile_inner(
     // cluster was dropped by `min_cluster_blocks` is not part of any emitted
     // build, so it must not appear in the membership map either.
     let membership = if want_membership {
-        pos_to_cluster.into_iter().filter(|(_, id)| kept.contains(id)).collect()
+        members.retain(|(_, id)| kept.contains(id));
+        TileMembership::new(members)
     } else {
-        BTreeMap::new()
+        TileMembership::default()
     };
 
     (TileSegments { tile_id: tile.id(), clusters, margin }, membership)
@@ -1498,11 +1564,11 @@ mod tests {
         // The one build's block is mapped; substrate is not.
         assert_eq!(segs.clusters.len(), 1);
         let cluster = segs.clusters[0].id;
-        assert_eq!(membership.get(&(10,-59,10)), Some(&cluster), "build block maps to its cluster");
-        assert_eq!(membership.get(&(0,-60,0)), None, "substrate is not in the membership map");
+        assert_eq!(membership.get(&t, (10,-59,10)), Some(cluster), "build block maps to its cluster");
+        assert_eq!(membership.get(&t, (0,-60,0)), None, "substrate is not in the membership map");
         // Every mapped position belongs to an emitted cluster.
-        for (_pos, cid) in &membership {
-            assert!(segs.clusters.iter().any(|c| c.id == *cid));
+        for (_cell, cid) in membership.iter() {
+            assert!(segs.clusters.iter().any(|c| c.id == cid));
         }
     }
 
@@ -11,7 +11,8 @@ use crate::world_segment::tile::{TileBounds, VoxelTile};
 /// Whether a source supports random tile access or only a single forward pass.
 ///
 /// A `.tar.gz` cannot be seeked, so it is `Forward`: `tile()` is unavailable and
-/// callers must use `for_each_tile`. A world directory is `Random`.
+/// callers must use `for_each_tile`, unless it has a gzip index (see
+/// `TarGzSource::with_index`). A world directory is `Random`.
 #[derive(Clone, Copy, PartialEq, Eq, Debug)]
 pub enum Access {
     Random,
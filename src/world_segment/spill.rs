@@ -0,0 +1,397 @@
+//! Bounded-memory retention of surviving blocks for the runner.
+//!
+//! The runner has to keep every surviving block until stitching has decided
+//! which clusters form which build. [`ClusterBlocks`] keeps them
+//! palette-indexed: one `(position, palette index)` pair per block, in a
+//! per-cluster array, against a palette shared by the whole store, so
+//! retaining a block costs 16 bytes and no allocation. Each tile's palette is
+//! interned once per tile, not once per block.
+//!
+//! Past [`SpillConfig::max_resident_blocks`] the resident arrays are written
+//! out as one sorted run file and dropped. Runs are sorted by `ClusterId`
+//! then position and use the same 16-byte records, with only an offset per
+//! cluster and a palette snapshot kept in memory. Materialization reads a
+//! cluster back with one seek per run that holds it.
+//!
+//! Spilling never changes output: [`ClusterBlocks::blocks_for`] returns the
+//! same sorted block map whether the blocks stayed resident or not. The
+//! palette lookup is a `HashMap`, but only for lookups; palette order is
+//! first-seen order and never reaches output.
+
+use std::collections::{BTreeMap, HashMap};
+use std::fs::{File, OpenOptions};
+use std::io::{BufWriter, Read, Seek, SeekFrom, Write};
+use std::path::PathBuf;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use crate::block_state::BlockState;
+use crate::world_segment::ids::ClusterId;
+use crate::world_segment::segment::TileMembership;
+use crate::world_segment::tile::VoxelTile;
+
+/// Bytes per spilled block: `x, y, z` (`i32`) and a palette index (`u32`).
+pub(crate) const RECORD_BYTES: usize = 16;
+
+static RUN_SEQ: AtomicU64 = AtomicU64::new(0);
+
+/// Where and when the runner spills retained blocks to disk.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct SpillConfig {
+    /// Directory for run files. They are removed when the run finishes.
+    pub dir: PathBuf,
+    /// Blocks held in memory before they are written out as a run. The
+    /// parallel runner keeps one such budget per worker.
+    pub max_resident_blocks: usize,
+}
+
+impl Default for SpillConfig {
+    /// The system temp dir, spilling every ~4M blocks (a few hundred MiB
+    /// resident).
+    fn default() -> Self {
+        SpillConfig { dir: std::env::temp_dir(), max_resident_blocks: 1 << 22 }
+    }
+}
+
+/// One sorted run: a spill file, deleted on drop, or an adopted shard
+/// checkpoint, left in place.
+struct Run {
+    temp_path: Option<PathBuf>,
+    file: File,
+    palette: Vec<BlockState>,
+    /// Cluster -> (byte offset, block count).
+    index: BTreeMap<ClusterId, (u64, u64)>,
+}
+
+impl Run {
+    /// `cluster`'s records, with indices into this run's palette.
+    fn read(&mut self, cluster: &ClusterId) -> std::io::Result<Vec<((i32, i32, i32), u32)>> {
+        let Some(&(offset, count)) = self.index.get(cluster) else {
+            return Ok(Vec::new());
+        };
+        let mut bytes = vec![0u8; count as usize * RECORD_BYTES];
+        self.file.seek(SeekFrom::Start(offset))?;
+        self.file.read_exact(&mut bytes)?;
+        let mut out = Vec::with_capacity(count as usize);
+        for record in bytes.chunks_exact(RECORD_BYTES) {
+            let field = |i: usize| <[u8; 4]>::try_from(&record[i..i + 4]).unwrap();
+            let pos = (
+                i32::from_le_bytes(field(0)),
+                i32::from_le_bytes(field(4)),
+                i32::from_le_bytes(field(8)),
+            );
+            let id = u32::from_le_bytes(field(12));
+            if id as usize >= self.palette.len() {
+                return Err(std::io::Error::new(
+                    std::io::ErrorKind::InvalidData,
+                    "bad spill palette index",
+                ));
+            }
+            out.push((pos, id));
+        }
+        Ok(out)
+    }
+}
+
+impl Drop for Run {
+    fn drop(&mut self) {
+        if let Some(path) = &self.temp_path {
+            let _ = std::fs::remove_file(path);
+        }
+    }
+}
+
+/// Write `blocks` as 16-byte records; returns the bytes written.
+fn write_records(
+    out: &mut impl Write,
+    blocks: &[((i32, i32, i32), u32)],
+) -> std::io::Result<u64> {
+    for &((x, y, z), id) in blocks {
+        let mut record = [0u8; RECORD_BYTES];
+        record[0..4].copy_from_slice(&x.to_le_bytes());
+        record[4..8].copy_from_slice(&y.to_le_bytes());
+        record[8..12].copy_from_slice(&z.to_le_bytes());
+        record[12..16].copy_from_slice(&id.to_le_bytes());
+        out.write_all(&record)?;
+    }
+    Ok((blocks.len() * RECORD_BYTES) as u64)
+}
+
+/// Surviving blocks grouped by the per-tile `ClusterId` they belong to,
+/// spilled to disk past the configured budget.
+pub struct ClusterBlocks {
+    config: SpillConfig,
+    palette: Vec<BlockState>,
+    palette_index: HashMap<BlockState, u32>,
+    /// `(position, palette index)` per block, ascending by position.
+    resident: BTreeMap<ClusterId, Vec<((i32, i32, i32), u32)>>,
+    resident_len: usize,
+    /// Largest `resident_len` so far.
+    peak_resident: usize,
+    /// Blocks written to runs by [`Self::spill`], over this store and every
+    /// store merged into it.
+    spilled_blocks: u64,
+    runs: Vec<Run>,
+}
+
+impl ClusterBlocks {
+    pub fn new(config: SpillConfig) -> Self {
+        ClusterBlocks {
+            config,
+            palette: Vec::new(),
+            palette_index: HashMap::new(),
+            resident: BTreeMap::new(),
+            resident_len: 0,
+            peak_resident: 0,
+            spilled_blocks: 0,
+            runs: Vec::new(),
+        }
+    }
+
+    /// Number of run files written so far.
+    pub fn spilled_runs(&self) -> usize {
+        self.runs.len()
+    }
+
+    /// Blocks written to spill runs so far; each takes
+    /// [`RECORD_BYTES`] on disk.
+    pub fn spilled_blocks(&self) -> u64 {
+        self.spilled_blocks
+    }
+
+    /// The most blocks held in memory at once, by this store or any store
+    /// merged into it.
+    pub fn peak_resident(&self) -> usize {
+        self.peak_resident
+    }
+
+    fn intern(&mut self, block: &BlockState) -> u32 {
+        if let Some(&id) = self.palette_index.get(block) {
+            return id;
+        }
+        let id = self.palette.len() as u32;
+        self.palette.push(block.clone());
+        self.palette_index.insert(block.clone(), id);
+        id
+    }
+
+    /// Retain every member block of `tile`.
+    pub fn insert_tile(&mut self, tile: &VoxelTile, membership: &TileMembership) {
+        let remap: Vec<u32> = tile.palette().iter().map(|b| self.intern(b)).collect();
+        let mut per_cluster: Vec<Vec<((i32, i32, i32), u32)>> =
+            vec![Vec::new(); membership.clusters().len()];
+        let cells = tile.cells();
+        // Entries ascend by cell, hence by position, so each array is sorted.
+        for &(cell, cluster) in membership.entries() {
+            let (pos, index) = cells[cell as usize];
+            per_cluster[cluster as usize].push((pos, remap[index as usize]));
+        }
+        for (cluster, blocks) in membership.clusters().iter().zip(per_cluster) {
+            self.insert_sorted(*cluster, blocks);
+        }
+    }
+
+    /// Add a cluster's blocks, sorted by position and indexed into this
+    /// store's palette.
+    fn insert_sorted(&mut self, cluster: ClusterId, blocks: Vec<((i32, i32, i32), u32)>) {
+        match self.resident.entry(cluster) {
+            std::collections::btree_map::Entry::Vacant(e) => {
+                self.resident_len += blocks.len();
+                e.insert(blocks);
+            }
+            // Only if one tile was fed twice; keep the union, first wins.
+            std::collections::btree_map::Entry::Occupied(mut e) => {
+                let existing = e.get_mut();
+                self.resident_len -= existing.len();
+                existing.extend(blocks);
+                existing.sort_by_key(|(pos, _)| *pos);
+                existing.dedup_by_key(|(pos, _)| *pos);
+                self.resident_len += existing.len();
+            }
+        }
+        self.peak_resident = self.peak_resident.max(self.resident_len);
+    }
+
+    /// Spill if the resident set is over budget. Called between tiles, so a
+    /// tile's clusters always land in a single run.
+    pub fn maybe_spill(&mut self) -> std::io::Result<()> {
+        if self.resident_len > self.config.max_resident_blocks {
+            self.spill()?;
+        }
+        Ok(())
+    }
+
+    fn spill(&mut self) -> std::io::Result<()> {
+        let path = self.config.dir.join(format!(
+            "nucleation-segment-{}-{}.spill",
+            std::process::id(),
+            RUN_SEQ.fetch_add(1, Ordering::Relaxed)
+        ));
+        let file = OpenOptions::new().read(true).write(true).create_new(true).open(&path)?;
+        // Owns the path from here on, so an error below still removes it.
+        let mut run = Run {
+            temp_path: Some(path),
+            file,
+            palette: self.palette.clone(),
+            index: BTreeMap::new(),
+        };
+        let mut out = BufWriter::new(&run.file);
+        let mut offset = 0u64;
+        for (cluster, blocks) in std::mem::take(&mut self.resident) {
+            run.index.insert(cluster, (offset, blocks.len() as u64));
+            offset += write_records(&mut out, &blocks)?;
+        }
+        out.flush()?;
+        drop(out);
+        self.spilled_blocks += self.resident_len as u64;
+        self.resident_len = 0;
+        self.runs.push(run);
+        Ok(())
+    }
+
+    /// Union of two stores. Tiles are disjoint, so the two never disagree on
+    /// a position; the result spills if the merged resident set is over
+    /// budget.
+    pub fn merge(mut a: ClusterBlocks, mut b: ClusterBlocks) -> std::io::Result<ClusterBlocks> {
+        let remap: Vec<u32> = b.palette.iter().map(|block| a.intern(block)).collect();
+        for (cluster, mut blocks) in std::mem::take(&mut b.resident) {
+            for (_, id) in &mut blocks {
+                *id = remap[*id as usize];
+            }
+            a.insert_sorted(cluster, blocks);
+        }
+        a.runs.append(&mut b.runs);
+        a.peak_resident = a.peak_resident.max(b.peak_resident);
+        a.spilled_blocks += b.spilled_blocks;
+        a.maybe_spill()?;
+        Ok(a)
+    }
+
+    /// Add every block of `cluster` to `out`, from memory and from each run
+    /// that holds part of it.
+    pub fn blocks_for(
+        &mut self,
+        cluster: &ClusterId,
+        out: &mut BTreeMap<(i32, i32, i32), BlockState>,
+    ) -> std::io::Result<()> {
+        if let Some(blocks) = self.resident.get(cluster) {
+            for (pos, id) in blocks {
+                out.insert(*pos, self.palette[*id as usize].clone());
+            }
+        }
+        for run in &mut self.runs {
+            for (pos, id) in run.read(cluster)? {
+                out.insert(pos, run.palette[id as usize].clone());
+            }
+        }
+        Ok(())
+    }
+
+    /// Write every retained block to `out` as one sorted run, starting at
+    /// byte `start` of its file: records ordered by cluster then position,
+    /// indexed into the returned palette. Returns the palette and the
+    /// cluster -> (byte offset, block count) index, offsets counted from the
+    /// start of the file. This is the block section of a shard checkpoint.
+    pub fn export(
+        &mut self,
+        out: &mut impl Write,
+        start: u64,
+    ) -> std::io::Result<(Vec<BlockState>, BTreeMap<ClusterId, (u64, u64)>)> {
+        let mut clusters: Vec<ClusterId> = self.resident.keys().copied().collect();
+        for run in &self.runs {
+            clusters.extend(run.index.keys().copied());
+        }
+        clusters.sort_unstable();
+        clusters.dedup();
+        let mut remaps: Vec<Vec<u32>> = Vec::with_capacity(self.runs.len());
+        for i in 0..self.runs.len() {
+            let palette = self.runs[i].palette.clone();
+            remaps.push(palette.iter().map(|block| self.intern(block)).collect());
+        }
+
+        let mut index = BTreeMap::new();
+        let mut offset = start;
+        for cluster in clusters {
+            let mut blocks = self.resident.get(&cluster).cloned().unwrap_or_default();
+            for (run, remap) in self.runs.iter_mut().zip(&remaps) {
+                let records = run.read(&cluster)?;
+                blocks.extend(records.into_iter().map(|(pos, id)| (pos, remap[id as usize])));
+            }
+            blocks.sort_by_key(|(pos, _)| *pos);
+            blocks.dedup_by_key(|(pos, _)| *pos);
+            index.insert(cluster, (offset, blocks.len() as u64));
+            offset += write_records(out, &blocks)?;
+        }
+        Ok((self.palette.clone(), index))
+    }
+
+    /// Serve blocks from a run written by [`Self::export`], read in place
+    /// from `file`. The file is not removed when the store drops.
+    pub fn adopt(
+        &mut self,
+        file: File,
+        palette: Vec<BlockState>,
+        index: BTreeMap<ClusterId, (u64, u64)>,
+    ) {
+        self.runs.push(Run { temp_path: None, file, palette, index });
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::world_segment::ids::{ContentId, TileId};
+    use crate::world_segment::tile::TileBounds;
+
+    fn cid(n: u8) -> ClusterId {
+        ClusterId::new(ContentId::of(&[&[n]]), TileId { x: n as i32, z: 0 }, None, (0, 0, 0))
+    }
+
+    /// Five blocks of alternating state in one cluster, as one tile.
+    fn fill(store: &mut ClusterBlocks, cluster: ClusterId, x0: i32) {
+        let bounds = TileBounds { min: (-1000, -64, -1000), max: (1000, 320, 1000) };
+        let blocks = (x0..x0 + 5).map(|x| {
+            let name = if x % 2 == 0 { "minecraft:stone" } else { "minecraft:redstone_wire" };
+            ((x, -60, 3), BlockState::new(name))
+        });
+        let tile = VoxelTile::from_blocks(TileId { x: 0, z: 0 }, bounds, blocks);
+        let membership = TileMembership::new((0..tile.len() as u32).map(|c| (c, cluster)).collect());
+        store.insert_tile(&tile, &membership);
+        store.maybe_spill().unwrap();
+    }
+
+    #[test]
+    fn spilled_blocks_read_back_like_resident_ones() {
+        let mut resident = ClusterBlocks::new(SpillConfig::default());
+        let mut spilled = ClusterBlocks::new(SpillConfig {
+            dir: std::env::temp_dir(),
+            max_resident_blocks: 4,
+        });
+        for (n, x0) in [(1, 0), (2, 100), (3, -50)] {
+            fill(&mut resident, cid(n), x0);
+            fill(&mut spilled, cid(n), x0);
+        }
+        assert_eq!(resident.spilled_runs(), 0);
+        assert_eq!(spilled.spilled_runs(), 3);
+        assert_eq!((resident.spilled_blocks(), resident.peak_resident()), (0, 15));
+        assert_eq!((spilled.spilled_blocks(), spilled.peak_resident()), (15, 5));
+
+        let mut other = ClusterBlocks::new(SpillConfig {
+            dir: std::env::temp_dir(),
+            max_resident_blocks: 4,
+        });
+        fill(&mut other, cid(4), 7);
+        let mut merged = ClusterBlocks::merge(spilled, other).unwrap();
+        assert_eq!(merged.spilled_blocks(), 20);
+        fill(&mut resident, cid(4), 7);
+
+        let paths: Vec<PathBuf> = merged.runs.iter().filter_map(|r| r.temp_path.clone()).collect();
+        for n in 1..=5 {
+            let (mut want, mut got) = (BTreeMap::new(), BTreeMap::new());
+            resident.blocks_for(&cid(n), &mut want).unwrap();
+            merged.blocks_for(&cid(n), &mut got).unwrap();
+            assert_eq!(got, want, "cluster {}", n);
+        }
+        drop(merged);
+        assert!(paths.iter().all(|p| !p.exists()), "run files are removed on drop");
+    }
+}
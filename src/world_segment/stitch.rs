@@ -13,7 +13,7 @@ use crate::world_segment::source::region_tile_bounds;
 
 pub type GlobalCell = (i32, i32, i32);
 
-#[derive(Clone, PartialEq, Eq, Debug)]
+#[derive(Clone, PartialEq, Eq, Debug, serde::Serialize, serde::Deserialize)]
 pub struct MarginEntry {
     pub cell: GlobalCell,
     pub cluster: ClusterId,
@@ -31,7 +31,9 @@ pub fn to_global(local: (i32, i32, i32), tile: TileId, cell_size: u32, min_y: i3
     )
 }
 
-#[derive(Clone, Debug)]
+/// Serializable, so a shard's partial stitch can be checkpointed and merged
+/// on another machine (see [`crate::world_segment::checkpoint`]).
+#[derive(Clone, Debug, serde::Serialize, serde::Deserialize)]
 pub struct StitchState {
     /// Union-find parent map. The root of a set is always its smallest ClusterId.
     parent: BTreeMap<ClusterId, ClusterId>,
@@ -74,6 +76,11 @@ impl StitchState {
         x
     }
 
+    /// Every cluster in this state, ascending.
+    pub fn cluster_ids(&self) -> impl Iterator<Item = ClusterId> + '_ {
+        self.clusters.keys().copied()
+    }
+
     pub fn margin_len(&self) -> usize {
         self.margin.len()
     }
@@ -1,14 +1,21 @@
-//! Forward-only tile source over a streaming `.tar.gz` world archive.
+//! Tile source over a `.tar.gz` world archive.
 //!
-//! A gzipped tar cannot be seeked, so this is `Access::Forward`: it walks the
-//! archive once, parses each `region/*.mca` entry into a tile, and streams it.
+//! A gzipped tar cannot be seeked, so by default this is `Access::Forward`:
+//! it walks the archive once, parses each `region/*.mca` entry into a tile,
+//! and streams it. [`TarGzSource::with_index`] adds a gzip access-point index
+//! (see [`gz_index`](crate::world_segment::gz_index)), which makes it
+//! `Access::Random` and lets `for_each_tile` decompress regions in parallel.
 //! Everything rejected (backups, stray level files, junk coordinates) is
 //! reported, never silently dropped.
 
 use std::fs::File;
 use std::io::{BufReader, Read};
 use std::path::{Path, PathBuf};
+use std::sync::Arc;
 
+use rayon::prelude::*;
+
+use crate::world_segment::gz_index::{GzIndex, TarEntry, DEFAULT_SPAN};
 use crate::world_segment::ids::TileId;
 use crate::world_segment::source::{Access, TileError, TileSource};
 use crate::world_segment::tile::VoxelTile;
@@ -55,6 +62,7 @@ pub struct TarGzSource {
     min_y: i32,
     max_y: i32,
     world_border: Option<i32>,
+    index: Option<Arc<GzIndex>>,
 }
 
 impl TarGzSource {
@@ -63,7 +71,7 @@ impl TarGzSource {
         if !path.exists() {
             return Err(TileError::Io(format!("{} does not exist", path.display())));
         }
-        Ok(TarGzSource { path, min_y, max_y, world_border: None })
+        Ok(TarGzSource { path, min_y, max_y, world_border: None, index: None })
     }
 
     pub fn with_world_border(mut self, border_abs: i32) -> Self {
@@ -71,6 +79,30 @@ impl TarGzSource {
         self
     }
 
+    /// Switch to random access through the archive's gzip index, loading
+    /// `<archive>.nuzx` if it is current and building (one full inflate)
+    /// and saving it otherwise.
+    ///
+    /// Tile ids then come from entry names, not region headers: a region
+    /// whose header disagrees with its name is reported and skipped. When
+    /// an archive holds the same region twice, the later entry wins, as it
+    /// would on extraction.
+    pub fn with_index(mut self) -> Result<Self, TileError> {
+        let index = GzIndex::open_or_build(&self.path, DEFAULT_SPAN)
+            .map_err(|e| TileError::Io(e.to_string()))?;
+        self.index = Some(Arc::new(index));
+        Ok(self)
+    }
+
+    /// The last indexed entry for tile `id`, if any.
+    fn indexed_entry<'a>(&self, index: &'a GzIndex, id: TileId) -> Option<&'a TarEntry> {
+        index
+            .entries
+            .iter()
+            .rev()
+            .find(|entry| self.classify(&entry.name).ok() == Some((id.x, id.z)))
+    }
+
     /// Classify an entry name. `Ok(coords)` to process; `Err(reason)` to reject
     /// (caller logs). Non-region entries return `Err` too.
     fn classify(&self, name: &str) -> Result<(i32, i32), String> {
@@ -85,26 +117,128 @@ impl TarGzSource {
         }
         Ok((x, z))
     }
+
+    /// Decode one region entry into its tile. The tile's id comes from the
+    /// decoded region via region_positions(), which reads the region header
+    /// — this avoids trusting a possibly mangled filename for identity.
+    ///
+    /// Decode failures are reported and yield `None`, not propagated: a
+    /// single malformed region must never abort the rest of the archive
+    /// (see module docs).
+    fn decode_region(&self, name: &str, buf: Vec<u8>) -> Option<VoxelTile> {
+        let source = match crate::formats::world_stream::WorldSource::from_mca_bytes(buf) {
+            Ok(source) => source,
+            Err(e) => {
+                eprintln!("world_segment: skipping {name}: malformed region data ({e})");
+                return None;
+            }
+        };
+        let positions = match source.region_positions() {
+            Ok(positions) => positions,
+            Err(e) => {
+                eprintln!("world_segment: skipping {name}: could not read region positions ({e})");
+                return None;
+            }
+        };
+        let (tx, tz) = match positions.first() {
+            Some(&p) => p,
+            None => {
+                eprintln!("world_segment: skipping {name}: no region position in header");
+                return None;
+            }
+        };
+        let tiles = crate::world_segment::world_source::WorldSourceTiles::new(
+            source, self.min_y, self.max_y,
+        );
+        // A corrupt chunk inside an otherwise valid region header surfaces
+        // here as TileError::Malformed from collect_tile(); report and skip
+        // this region, same as the decode failures above.
+        match tiles.tile(TileId { x: tx, z: tz }) {
+            Ok(tile) => tile,
+            Err(e) => {
+                eprintln!("world_segment: skipping {name}: {e}");
+                None
+            }
+        }
+    }
 }
 
 impl TileSource for TarGzSource {
     fn access(&self) -> Access {
-        Access::Forward
+        match self.index {
+            Some(_) => Access::Random,
+            None => Access::Forward,
+        }
     }
 
     fn tile_ids(&self) -> Result<Vec<TileId>, TileError> {
-        // Ids are not known without a full pass; callers should stream.
-        Ok(Vec::new())
+        // Without an index, ids are not known without a full pass; callers
+        // should stream.
+        let Some(index) = &self.index else {
+            return Ok(Vec::new());
+        };
+        let mut ids: Vec<TileId> = index
+            .entries
+            .iter()
+            .filter_map(|entry| self.classify(&entry.name).ok())
+            .map(|(x, z)| TileId { x, z })
+            .collect();
+        ids.sort();
+        ids.dedup();
+        Ok(ids)
     }
 
-    fn tile(&self, _id: TileId) -> Result<Option<VoxelTile>, TileError> {
-        Err(TileError::NotRandomAccess)
+    fn tile(&self, id: TileId) -> Result<Option<VoxelTile>, TileError> {
+        let Some(index) = &self.index else {
+            return Err(TileError::NotRandomAccess);
+        };
+        let Some(entry) = self.indexed_entry(index, id) else {
+            return Ok(None);
+        };
+        let buf = index
+            .read_at(&self.path, entry.offset, entry.size)
+            .map_err(|e| TileError::Io(e.to_string()))?;
+        if buf.is_empty() {
+            eprintln!("world_segment: skipping {}: empty entry", entry.name);
+            return Ok(None);
+        }
+        match self.decode_region(&entry.name, buf) {
+            Some(tile) if tile.id() != id => {
+                let actual = tile.id();
+                eprintln!(
+                    "world_segment: skipping {}: region header says ({},{})",
+                    entry.name, actual.x, actual.z
+                );
+                Ok(None)
+            }
+            tile => Ok(tile),
+        }
     }
 
     fn for_each_tile(
         &self,
         f: &mut dyn FnMut(VoxelTile) -> Result<(), TileError>,
     ) -> Result<(), TileError> {
+        if self.index.is_some() {
+            // Every read has its own cursor: decode a batch of regions on
+            // the rayon pool, then hand them over in id order.
+            let ids = self.tile_ids()?;
+            for batch in ids.chunks(2 * rayon::current_num_threads()) {
+                let tiles: Vec<Result<Option<VoxelTile>, TileError>> =
+                    batch.par_iter().map(|&id| self.tile(id)).collect();
+                for tile in tiles {
+                    if let Some(tile) = tile? {
+                        match f(tile) {
+                            Ok(()) => {}
+                            Err(TileError::Stop) => return Ok(()),
+                            Err(e) => return Err(e),
+                        }
+                    }
+                }
+            }
+            return Ok(());
+        }
+
         use flate2::read::GzDecoder;
         let file = File::open(&self.path).map_err(|e| TileError::Io(e.to_string()))?;
         let gz = GzDecoder::new(BufReader::new(file));
@@ -133,63 +267,22 @@ impl TileSource for TarGzSource {
                 eprintln!("world_segment: skipping {name}: empty entry");
                 continue;
             }
-            // The filename coords (rx,rz) are used ONLY for junk filtering above
-            // (the sign-extension artifact is a filename problem). The tile's
-            // actual id comes from the decoded region via region_positions(),
-            // which reads the region header — this avoids trusting a possibly
-            // mangled filename for identity.
-            //
-            // Per-entry decode failures below are reported and skipped, not
-            // propagated: a single malformed region must never abort the rest
-            // of the archive (see module docs).
-            let source = match crate::formats::world_stream::WorldSource::from_mca_bytes(buf.clone())
-            {
-                Ok(source) => source,
-                Err(e) => {
-                    eprintln!("world_segment: skipping {name}: malformed region data ({e})");
-                    continue;
-                }
-            };
-            let positions = match source.region_positions() {
-                Ok(positions) => positions,
-                Err(e) => {
-                    eprintln!("world_segment: skipping {name}: could not read region positions ({e})");
-                    continue;
-                }
-            };
-            let (tx, tz) = match positions.first() {
-                Some(&p) => p,
-                None => {
-                    eprintln!("world_segment: skipping {name}: no region position in header");
-                    continue;
-                }
+            // The filename coords (rx,rz) are used ONLY for junk filtering
+            // above (the sign-extension artifact is a filename problem); the
+            // tile's id comes from the region header, see `decode_region`.
+            let _ = (rx, rz);
+            let Some(tile) = self.decode_region(&name, buf.clone()) else {
+                continue;
             };
-            let _ = (rx, rz); // filename coords already served their filtering purpose
-            let tiles = crate::world_segment::world_source::WorldSourceTiles::new(
-                source, self.min_y, self.max_y,
-            );
-            // A corrupt chunk inside an otherwise valid region header surfaces
-            // here as TileError::Malformed from collect_tile(); report and
-            // skip this region, same as the decode failures above, rather
-            // than aborting the whole archive. `f(tile)?` intentionally still
-            // propagates — a callback error is a legitimate caller-level
-            // abort, not a per-tile decode failure.
-            match tiles.tile(TileId { x: tx, z: tz }) {
-                Ok(Some(tile)) => match f(tile) {
-                    Ok(()) => {}
-                    // `Stop` is the caller's early-termination sentinel (see
-                    // `TileError::Stop` docs): stop walking the archive and
-                    // report success, WITHOUT decompressing/parsing the rest
-                    // of it. Any other callback error is a genuine abort and
-                    // propagates as before.
-                    Err(TileError::Stop) => return Ok(()),
-                    Err(e) => return Err(e),
-                },
-                Ok(None) => {}
-                Err(e) => {
-                    eprintln!("world_segment: skipping {name}: {e}");
-                    continue;
-                }
+            match f(tile) {
+                Ok(()) => {}
+                // `Stop` is the caller's early-termination sentinel (see
+                // `TileError::Stop` docs): stop walking the archive and
+                // report success, WITHOUT decompressing/parsing the rest
+                // of it. Any other callback error is a genuine abort and
+                // propagates as before.
+                Err(TileError::Stop) => return Ok(()),
+                Err(e) => return Err(e),
             }
         }
         Ok(())
@@ -439,4 +532,64 @@ mod tests {
         // consistent with (not proof of) short-circuiting; see doc comment.
         assert_eq!(call_count, 0, "no entry in this fixture decodes into a callable tile");
     }
+
+    /// The indexed path: ids come from entry names (classified as in the
+    /// streaming path), `tile` reads one entry through the gzip index, and
+    /// the same undecodable entries are skipped rather than aborting.
+    #[test]
+    fn indexed_archive_serves_ids_and_skips_bad_entries() {
+        use std::io::Write;
+
+        let mut tar_bytes = Vec::new();
+        {
+            let mut builder = tar::Builder::new(&mut tar_bytes);
+            for (name, data) in [
+                ("world/region/r.0.0.mca", &b"not a real region file, entry a"[..]),
+                ("world/region/r.1.0.mca", &b"not a real region file, entry b"[..]),
+                ("world/region/r.40.0.mca", &b"beyond the world border"[..]),
+                ("world/region/r.0.0.mca.backup", &b"backup region bytes"[..]),
+                ("world/level.dat", &b"junk level.dat contents"[..]),
+            ] {
+                let mut header = tar::Header::new_gnu();
+                header.set_size(data.len() as u64);
+                header.set_mode(0o644);
+                header.set_cksum();
+                builder.append_data(&mut header, name, data).unwrap();
+            }
+            builder.finish().unwrap();
+        }
+        let mut gz_bytes = Vec::new();
+        {
+            let mut encoder =
+                flate2::write::GzEncoder::new(&mut gz_bytes, flate2::Compression::default());
+            encoder.write_all(&tar_bytes).unwrap();
+            encoder.finish().unwrap();
+        }
+        let path = std::env::temp_dir().join("nucleation_test_targz_source_indexed.tar.gz");
+        std::fs::write(&path, &gz_bytes).unwrap();
+
+        let source = TarGzSource::open(&path, -64, 320)
+            .unwrap()
+            .with_world_border(8192)
+            .with_index()
+            .unwrap();
+        assert_eq!(source.access(), Access::Random);
+        assert_eq!(
+            source.tile_ids().unwrap(),
+            vec![TileId { x: 0, z: 0 }, TileId { x: 1, z: 0 }]
+        );
+        assert!(source.tile(TileId { x: 0, z: 0 }).unwrap().is_none());
+        assert!(source.tile(TileId { x: 5, z: 5 }).unwrap().is_none());
+        let mut call_count = 0usize;
+        let result = source.for_each_tile(&mut |_tile| {
+            call_count += 1;
+            Ok(())
+        });
+
+        std::fs::remove_file(&path).ok();
+        std::fs::remove_file(crate::world_segment::gz_index::index_path(&path)).ok();
+
+        assert!(result.is_ok(), "{result:?}");
+        assert_eq!(call_count, 0);
+    }
 }
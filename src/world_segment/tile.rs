@@ -150,6 +150,22 @@ impl VoxelTile {
     pub fn blocks(&self) -> impl Iterator<Item = ((i32, i32, i32), &BlockState)> + '_ {
         self.cells.iter().map(move |(pos, idx)| (*pos, &self.palette[*idx as usize]))
     }
+
+    /// The deduplicated states, ordered by canonical key.
+    pub fn palette(&self) -> &[BlockState] {
+        &self.palette
+    }
+
+    /// `(position, palette index)` per block, ascending by position. The
+    /// position in this slice is a block's cell index.
+    pub fn cells(&self) -> &[((i32, i32, i32), u32)] {
+        &self.cells
+    }
+
+    /// Cell index of the block at `pos`, if the tile has one there.
+    pub fn cell_index(&self, pos: (i32, i32, i32)) -> Option<usize> {
+        self.cells.binary_search_by_key(&pos, |(p, _)| *p).ok()
+    }
 }
 
 /// Canonical string for palette dedup: name plus sorted properties.
@@ -1,9 +1,22 @@
 //! Random-access tile source over a `WorldSource` (directory / zip / mca).
 
-use std::collections::BTreeMap;
+use std::collections::{BTreeMap, HashSet};
+#[cfg(not(target_arch = "wasm32"))]
+use std::path::Path;
+#[cfg(not(target_arch = "wasm32"))]
+use std::sync::Arc;
 
+use rayon::prelude::*;
+
+use crate::formats::anvil::ChunkProjection;
+#[cfg(not(target_arch = "wasm32"))]
+use crate::formats::world_index::{IndexDelta, WorldIndex};
 use crate::formats::world_stream::WorldSource;
+#[cfg(not(target_arch = "wasm32"))]
+use crate::world_segment::ids::ContentId;
 use crate::world_segment::ids::TileId;
+#[cfg(not(target_arch = "wasm32"))]
+use crate::world_segment::profile::{ProfileParams, WorldProfile};
 use crate::world_segment::source::{region_tile_bounds, Access, TileError, TileSource};
 use crate::world_segment::tile::VoxelTile;
 
@@ -12,24 +25,127 @@ pub fn chunk_region(cx: i32, cz: i32) -> (i32, i32) {
     (cx.div_euclid(32), cz.div_euclid(32))
 }
 
+/// Tiles holding a chunk that `delta` reports changed or removed, ascending:
+/// the `changed` set for
+/// [`WorldSegmenter::run_incremental`](crate::world_segment::runner::WorldSegmenter::run_incremental)
+/// after [`WorldIndex::open`].
+#[cfg(not(target_arch = "wasm32"))]
+pub fn changed_tiles(delta: &IndexDelta) -> Vec<TileId> {
+    let mut ids: Vec<TileId> = delta
+        .changed
+        .iter()
+        .chain(&delta.removed)
+        .map(|&(cx, cz)| {
+            let (x, z) = chunk_region(cx, cz);
+            TileId { x, z }
+        })
+        .collect();
+    ids.sort();
+    ids.dedup();
+    ids
+}
+
+/// One chunk from each `stride` x `stride` block of region `id`'s 32x32
+/// chunk grid, ascending. The chunk within each block is picked by hashing
+/// the region and block, so the sample is deterministic but does not sit on
+/// a lattice the world's own structure could alias with. Stride 1 is every
+/// chunk.
+pub fn sample_chunk_positions(id: TileId, stride: u32) -> Vec<(i32, i32)> {
+    let stride = stride.clamp(1, 32) as i32;
+    let mix = |mut v: u64| {
+        v ^= v >> 33;
+        v = v.wrapping_mul(0xff51_afd7_ed55_8ccd);
+        v ^= v >> 33;
+        v = v.wrapping_mul(0xc4ce_b9fe_1a85_ec53);
+        v ^ (v >> 33)
+    };
+    let region = mix(((id.x as u32 as u64) << 32) | id.z as u32 as u64);
+    let mut positions = Vec::new();
+    for i in (0..32).step_by(stride as usize) {
+        for j in (0..32).step_by(stride as usize) {
+            let h = mix(region ^ ((i as u64) << 8 | j as u64));
+            let di = (h % stride.min(32 - i) as u64) as i32;
+            let dj = ((h >> 32) % stride.min(32 - j) as u64) as i32;
+            positions.push((id.x * 32 + i + di, id.z * 32 + j + dj));
+        }
+    }
+    positions.sort();
+    positions
+}
+
 pub struct WorldSourceTiles {
     source: WorldSource,
     min_y: i32,
     max_y: i32,
+    #[cfg(not(target_arch = "wasm32"))]
+    index: Option<Arc<WorldIndex>>,
 }
 
 impl WorldSourceTiles {
     pub fn new(source: WorldSource, min_y: i32, max_y: i32) -> Self {
-        WorldSourceTiles { source, min_y, max_y }
+        WorldSourceTiles {
+            source,
+            min_y,
+            max_y,
+            #[cfg(not(target_arch = "wasm32"))]
+            index: None,
+        }
+    }
+
+    /// Consult a current index of the source's world: regions and chunks it
+    /// knows hold nothing in `min_y..=max_y` are never read.
+    #[cfg(not(target_arch = "wasm32"))]
+    pub fn with_index(mut self, index: Arc<WorldIndex>) -> Self {
+        self.index = Some(index);
+        self
+    }
+
+    /// Chunks of a region the index says may hold blocks in range, or None
+    /// without an index.
+    fn indexed_chunks(&self, region_x: i32, region_z: i32) -> Option<Vec<(i32, i32)>> {
+        #[cfg(not(target_arch = "wasm32"))]
+        if let Some(index) = &self.index {
+            return Some(
+                index
+                    .chunks()
+                    .filter(|(pos, entry)| {
+                        chunk_region(pos.0, pos.1) == (region_x, region_z)
+                            && entry.occupies(self.min_y, self.max_y)
+                    })
+                    .map(|(pos, _)| pos)
+                    .collect(),
+            );
+        }
+        let _ = (region_x, region_z);
+        None
+    }
+
+    /// What tiles need from a chunk: block states inside the Y range.
+    fn projection(&self) -> ChunkProjection {
+        ChunkProjection::blocks_only().with_y_range(self.min_y, self.max_y)
     }
 
     fn collect_tile(&self, region_x: i32, region_z: i32) -> Result<Option<VoxelTile>, TileError> {
+        self.collect_chunks(region_x, region_z, self.indexed_chunks(region_x, region_z))
+    }
+
+    /// The tile of a region from the chunks at `positions`, or from all of
+    /// its chunks when `None`.
+    fn collect_chunks(
+        &self,
+        region_x: i32,
+        region_z: i32,
+        positions: Option<Vec<(i32, i32)>>,
+    ) -> Result<Option<VoxelTile>, TileError> {
         let (tile_id, bounds) = region_tile_bounds(region_x, region_z, self.min_y, self.max_y);
-        // Bounded chunk iteration over exactly this region's block span.
-        let iter = self
-            .source
-            .chunks_bounded(bounds.min, bounds.max)
-            .map_err(|e| TileError::Io(e.to_string()))?;
+        // Bounded chunk iteration over exactly this region's block span, or
+        // over the chunks the index says are worth reading.
+        let iter = match positions {
+            Some(positions) if positions.is_empty() => return Ok(None),
+            Some(positions) => self.source.chunks_at_projected(&positions, self.projection()),
+            None => self.source.chunks_bounded_projected(bounds.min, bounds.max, self.projection()),
+        }
+        .map_err(|e| TileError::Io(e.to_string()))?;
         // Gather blocks deterministically: BTreeMap keyed by position.
         let mut blocks: BTreeMap<(i32, i32, i32), crate::BlockState> = BTreeMap::new();
         for view in iter {
@@ -55,6 +171,164 @@ impl WorldSourceTiles {
             blocks.into_iter(),
         )))
     }
+
+    /// Region `id`'s tile built from the chunks at
+    /// [`sample_chunk_positions`] only (those the index, if any, says hold
+    /// blocks in range). Stride 1 is [`TileSource::tile`].
+    pub fn sample_tile(
+        &self,
+        id: TileId,
+        chunk_stride: u32,
+    ) -> Result<Option<VoxelTile>, TileError> {
+        if chunk_stride <= 1 {
+            return self.tile(id);
+        }
+        let mut positions = sample_chunk_positions(id, chunk_stride);
+        if let Some(indexed) = self.indexed_chunks(id.x, id.z) {
+            let indexed: HashSet<(i32, i32)> = indexed.into_iter().collect();
+            positions.retain(|pos| indexed.contains(pos));
+        }
+        self.collect_chunks(id.x, id.z, Some(positions))
+    }
+
+    /// Sample tiles for profile derivation, read in parallel: `count`
+    /// regions spread evenly over the ascending id list (all of them if
+    /// there are no more), each through [`Self::sample_tile`]. Regions with
+    /// no blocks in range are dropped, so fewer tiles may come back.
+    pub fn sample_tiles(
+        &self,
+        count: usize,
+        chunk_stride: u32,
+    ) -> Result<Vec<VoxelTile>, TileError> {
+        let ids = self.tile_ids()?;
+        let picked: Vec<TileId> = if ids.len() <= count {
+            ids
+        } else {
+            (0..count).map(|k| ids[k * ids.len() / count]).collect()
+        };
+        let tiles = picked
+            .par_iter()
+            .map(|&id| self.sample_tile(id, chunk_stride))
+            .collect::<Result<Vec<_>, TileError>>()?;
+        Ok(tiles.into_iter().flatten().collect())
+    }
+}
+
+/// File name of the profile cache [`derive_dir_profile`] keeps in a world
+/// directory.
+#[cfg(not(target_arch = "wasm32"))]
+pub const PROFILE_CACHE_NAME: &str = "nucleation.profiles";
+#[cfg(not(target_arch = "wasm32"))]
+const PROFILE_CACHE_MAGIC: &[u8; 4] = b"NUPC";
+#[cfg(not(target_arch = "wasm32"))]
+const PROFILE_CACHE_VERSION: u32 = 1;
+
+/// Derive a profile from `sample` regions of the world directory `dir`
+/// (see [`WorldSourceTiles::sample_tiles`]).
+///
+/// Results are cached in the world's [`PROFILE_CACHE_NAME`] sidecar, keyed
+/// by every argument plus the name, length and mtime of each region file,
+/// so a repeat derivation over an unchanged world reads no chunks. A failed
+/// cache write is reported, not fatal.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn derive_dir_profile(
+    dir: &Path,
+    min_y: i32,
+    max_y: i32,
+    sample: usize,
+    chunk_stride: u32,
+    params: &ProfileParams,
+) -> Result<WorldProfile, TileError> {
+    let io = |e: std::io::Error| TileError::Io(e.to_string());
+    let key = profile_cache_key(dir, min_y, max_y, sample, chunk_stride, params).map_err(io)?;
+    let cache_path = dir.join(PROFILE_CACHE_NAME);
+    let mut cache = load_profile_cache(&cache_path).unwrap_or_default();
+    if let Some(profile) = cache.get(&key) {
+        return Ok(profile.clone());
+    }
+    let source = WorldSource::open_dir(dir).map_err(|e| TileError::Io(e.to_string()))?;
+    let samples = WorldSourceTiles::new(source, min_y, max_y).sample_tiles(sample, chunk_stride)?;
+    let profile = WorldProfile::derive(&samples, params);
+    cache.insert(key, profile.clone());
+    if let Err(e) = save_profile_cache(&cache_path, &cache) {
+        eprintln!("world_segment: could not save profile cache {}: {e}", cache_path.display());
+    }
+    Ok(profile)
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+fn profile_cache_key(
+    dir: &Path,
+    min_y: i32,
+    max_y: i32,
+    sample: usize,
+    chunk_stride: u32,
+    params: &ProfileParams,
+) -> std::io::Result<ContentId> {
+    let mut parts: Vec<Vec<u8>> = vec![b"profile-cache.v1".to_vec()];
+    for v in [min_y, max_y, params.y_scan.0, params.y_scan.1] {
+        parts.push(v.to_le_bytes().to_vec());
+    }
+    for v in [sample as u64, chunk_stride as u64, params.sample_stride as u64] {
+        parts.push(v.to_le_bytes().to_vec());
+    }
+    parts.push(params.min_slab_coverage.to_bits().to_le_bytes().to_vec());
+    parts.push(params.palette_min_share.to_bits().to_le_bytes().to_vec());
+
+    let mut regions = Vec::new();
+    let region_dir = dir.join("region");
+    if region_dir.is_dir() {
+        for entry in std::fs::read_dir(&region_dir)? {
+            let entry = entry?;
+            let name = entry.file_name().to_string_lossy().to_string();
+            if !name.ends_with(".mca") {
+                continue;
+            }
+            let meta = entry.metadata()?;
+            let modified = meta
+                .modified()
+                .ok()
+                .and_then(|t| t.duration_since(std::time::UNIX_EPOCH).ok())
+                .map_or(0, |d| d.as_nanos() as u64);
+            regions.push((name, meta.len(), modified));
+        }
+    }
+    regions.sort();
+    for (name, len, modified) in regions {
+        parts.push(name.into_bytes());
+        parts.push(len.to_le_bytes().to_vec());
+        parts.push(modified.to_le_bytes().to_vec());
+    }
+    let refs: Vec<&[u8]> = parts.iter().map(|p| p.as_slice()).collect();
+    Ok(ContentId::of(&refs))
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+fn load_profile_cache(path: &Path) -> Option<BTreeMap<ContentId, WorldProfile>> {
+    let bytes = std::fs::read(path).ok()?;
+    if bytes.len() < 8 || &bytes[..4] != PROFILE_CACHE_MAGIC {
+        return None;
+    }
+    if u32::from_le_bytes(bytes[4..8].try_into().unwrap()) != PROFILE_CACHE_VERSION {
+        return None;
+    }
+    bincode::deserialize(&bytes[8..]).ok()
+}
+
+/// Write the cache through a temporary file renamed over it.
+#[cfg(not(target_arch = "wasm32"))]
+fn save_profile_cache(
+    path: &Path,
+    cache: &BTreeMap<ContentId, WorldProfile>,
+) -> std::io::Result<()> {
+    let mut bytes = Vec::new();
+    bytes.extend_from_slice(PROFILE_CACHE_MAGIC);
+    bytes.extend_from_slice(&PROFILE_CACHE_VERSION.to_le_bytes());
+    bincode::serialize_into(&mut bytes, cache)
+        .map_err(|e| std::io::Error::new(std::io::ErrorKind::InvalidData, e.to_string()))?;
+    let tmp = path.with_extension("profiles.tmp");
+    std::fs::write(&tmp, bytes)?;
+    std::fs::rename(&tmp, path)
 }
 
 impl TileSource for WorldSourceTiles {
@@ -63,6 +337,20 @@ impl TileSource for WorldSourceTiles {
     }
 
     fn tile_ids(&self) -> Result<Vec<TileId>, TileError> {
+        #[cfg(not(target_arch = "wasm32"))]
+        if let Some(index) = &self.index {
+            let mut ids: Vec<TileId> = index
+                .chunks()
+                .filter(|(_, entry)| entry.occupies(self.min_y, self.max_y))
+                .map(|(pos, _)| {
+                    let (x, z) = chunk_region(pos.0, pos.1);
+                    TileId { x, z }
+                })
+                .collect();
+            ids.sort();
+            ids.dedup();
+            return Ok(ids);
+        }
         let mut ids: Vec<TileId> = self
             .source
             .region_positions()
@@ -95,4 +383,66 @@ mod tests {
         assert_eq!(chunk_region(-32, 0), (-1, 0));
         assert_eq!(chunk_region(-33, 0), (-2, 0));
     }
+
+    #[test]
+    fn sampled_chunks_take_one_per_stratum() {
+        let id = TileId { x: -1, z: 2 };
+        let positions = sample_chunk_positions(id, 4);
+        assert_eq!(positions.len(), 64);
+        assert_eq!(positions, sample_chunk_positions(id, 4));
+        for &(cx, cz) in &positions {
+            assert_eq!(chunk_region(cx, cz), (-1, 2));
+        }
+        let strata: HashSet<(i32, i32)> =
+            positions.iter().map(|&(cx, cz)| (cx.div_euclid(4), cz.div_euclid(4))).collect();
+        assert_eq!(strata.len(), 64);
+        // A stride that does not divide 32 still stays inside the region.
+        let positions = sample_chunk_positions(id, 5);
+        assert_eq!(positions.len(), 49);
+        assert!(positions.iter().all(|&(cx, cz)| chunk_region(cx, cz) == (-1, 2)));
+        assert_eq!(sample_chunk_positions(id, 1).len(), 1024);
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    #[test]
+    fn sampled_profile_is_cached_per_world_and_params() {
+        use crate::formats::world;
+        use crate::{BlockState, UniversalSchematic};
+
+        let mut schem = UniversalSchematic::new("slab".to_string());
+        let stone = BlockState::new("minecraft:stone".to_string());
+        for x in 0..128 {
+            for z in 0..128 {
+                for y in 0..=2 {
+                    schem.set_block(x, y, z, &stone);
+                }
+            }
+        }
+        schem.set_block(5, 10, 5, &BlockState::new("minecraft:gold_block".to_string()));
+        let dir = std::env::temp_dir().join("nucleation_world_source_profile_cache");
+        let _ = std::fs::remove_dir_all(&dir);
+        world::save_world(&schem, &dir, None).unwrap();
+
+        let source = WorldSource::open_dir(&dir).unwrap();
+        let tiles = WorldSourceTiles::new(source, -64, 320);
+        let full = tiles.tile(TileId { x: 0, z: 0 }).unwrap().unwrap();
+        let sampled = tiles.sample_tile(TileId { x: 0, z: 0 }, 4).unwrap().unwrap();
+        assert!(sampled.blocks().count() < full.blocks().count());
+
+        let params = ProfileParams::default();
+        let profile = derive_dir_profile(&dir, -64, 320, 8, 4, &params).unwrap();
+        assert_eq!(profile.substrate_y_band, (0, 2));
+        assert_eq!(profile.substrate_palette.iter().collect::<Vec<_>>(), ["minecraft:stone"]);
+        let cache = load_profile_cache(&dir.join(PROFILE_CACHE_NAME)).unwrap();
+        assert_eq!(cache.len(), 1);
+
+        // Same world and params: served from the cache. Other params: a
+        // second entry.
+        assert_eq!(derive_dir_profile(&dir, -64, 320, 8, 4, &params).unwrap(), profile);
+        derive_dir_profile(&dir, -64, 320, 8, 1, &params).unwrap();
+        let cache = load_profile_cache(&dir.join(PROFILE_CACHE_NAME)).unwrap();
+        assert_eq!(cache.len(), 2);
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
 }
@@ -82,6 +82,65 @@ fn test_color_filtering() {
     }
 }
 
+#[test]
+fn test_indexed_filters_match_block_facts() {
+    let ids = |query: BlockQuery| {
+        let mut ids: Vec<&str> = query.collect().iter().map(|b| b.id).collect();
+        ids.sort_unstable();
+        ids
+    };
+    let scan = |keep: &dyn Fn(&BlockFacts) -> bool| {
+        let mut ids: Vec<&str> = all_blocks().filter(|b| keep(b)).map(|b| b.id).collect();
+        ids.sort_unstable();
+        ids
+    };
+
+    assert_eq!(ids(AllBlocks::new().only_solid()), scan(&|b| b.full_cube));
+    assert_eq!(
+        ids(AllBlocks::new()
+            .exclude_tile_entities()
+            .exclude_light_sources()),
+        scan(&|b| !b.has_block_entity && b.emit_light == 0)
+    );
+    assert_eq!(
+        ids(AllBlocks::new()
+            .with_property("facing")
+            .exclude_transparent()),
+        scan(&|b| b.has_property("facing") && !b.transparent)
+    );
+    assert_eq!(
+        ids(AllBlocks::new().with_property_value("axis", "x")),
+        scan(&|b| b
+            .get_property_values("axis")
+            .is_some_and(|values| values.iter().any(|v| v == "x")))
+    );
+
+    // Filters after a sort or limit apply to the listed blocks.
+    let sorted = AllBlocks::new().sort_by_name().limit(200).only_solid();
+    let expected: Vec<&str> = {
+        let mut all: Vec<&BlockFacts> = all_blocks().collect();
+        all.sort_by_key(|b| b.id);
+        all.into_iter()
+            .take(200)
+            .filter(|b| b.full_cube)
+            .map(|b| b.id)
+            .collect()
+    };
+    assert_eq!(
+        sorted.collect().iter().map(|b| b.id).collect::<Vec<_>>(),
+        expected
+    );
+
+    let target = ExtendedColorData::from_rgb(120, 90, 60);
+    assert_eq!(
+        ids(AllBlocks::new().similar_to_color(target, 0.08)),
+        scan(&|b| b
+            .extras
+            .color
+            .is_some_and(|c| c.to_extended().distance_oklab(&target) <= 0.08))
+    );
+}
+
 #[test]
 fn test_pattern_matching() {
     let query = AllBlocks::new();
@@ -689,7 +689,7 @@ fn palette_ramps_and_gradient_ids() {
         .all(|id| id.ends_with("_planks") || id == "minecraft:bamboo_mosaic"));
 
     // Empty palette yields an empty gradient, not a panic.
-    assert!(BlockPalette::from_block_ids(std::iter::empty())
+    assert!(BlockPalette::from_block_ids(std::iter::empty::<&str>())
         .gradient_ids((0, 0, 0), (255, 255, 255), 8)
         .is_empty());
 }
@@ -1008,3 +1008,37 @@ fn dithered_palette_blends_between_ramp_steps() {
     // Determinism: same input, same result.
     assert_eq!(fill_with(two.dithered()), fill_with(two.dithered()));
 }
+
+#[test]
+fn image_batch_snapping_matches_per_pixel_lookups() {
+    use nucleation::blockpedia::ExtendedColorData;
+
+    let palette = BlockPalette::new_wool();
+    let (width, height) = (37usize, 70usize);
+    let rgb: Vec<u8> = (0..width * height)
+        .flat_map(|i| {
+            let (x, y) = (i % width, i / width);
+            [(x * 7) as u8, (y * 3) as u8, ((x + y) * 5 % 256) as u8]
+        })
+        .collect();
+    let ids: Vec<&str> = palette.block_ids().collect();
+
+    for dither in [false, true] {
+        let indices = palette.closest_indices(&rgb, width, dither);
+        assert_eq!(indices.len(), width * height);
+        for (i, &index) in indices.iter().enumerate() {
+            let px = &rgb[i * 3..i * 3 + 3];
+            let target = ExtendedColorData::from_rgb(px[0], px[1], px[2]);
+            let (x, row) = ((i % width) as i32, (i / width) as i32);
+            let expected = if dither {
+                palette.find_closest_dithered(&target, x, 0, row)
+            } else {
+                palette.find_closest(&target)
+            };
+            assert_eq!(Some(ids[index as usize].to_string()), expected);
+        }
+    }
+    assert!(BlockPalette::from_block_ids(std::iter::empty::<&str>())
+        .closest_indices(&rgb, width, false)
+        .is_empty());
+}
@@ -132,3 +132,62 @@ fn test_sample_files() {
         assert_eq!(tile_count, re_tile_count, "Block entity count mismatch");
     }
 }
+
+#[test]
+fn test_mcstructure_water_layer() {
+    use nucleation::nbt::io::write_nbt;
+    use nucleation::nbt::{Endian, NbtMap, NbtValue};
+
+    let ints = |v: &[i32]| NbtValue::List(v.iter().map(|&i| NbtValue::Int(i)).collect());
+    let entry = |name: &str| {
+        let mut block = NbtMap::new();
+        block.insert("name", NbtValue::String(name.to_string()));
+        block.insert("states", NbtValue::Compound(NbtMap::new()));
+        NbtValue::Compound(block)
+    };
+    let mut default = NbtMap::new();
+    default.insert(
+        "block_palette",
+        NbtValue::List(vec![entry("custom:pipe"), entry("minecraft:water")]),
+    );
+    let mut palette = NbtMap::new();
+    palette.insert("default", NbtValue::Compound(default));
+    let mut structure = NbtMap::new();
+    // 2x1x2, z fastest: (0,0), (0,1), (1,0), (1,1). The second layer puts
+    // water in the pipe at (1,1) and nowhere else.
+    structure.insert(
+        "block_indices",
+        NbtValue::List(vec![ints(&[0, -1, 1, 0]), ints(&[-1, -1, -1, 1])]),
+    );
+    structure.insert("palette", NbtValue::Compound(palette));
+    let mut root = NbtMap::new();
+    root.insert("format_version", NbtValue::Int(1));
+    root.insert("size", ints(&[2, 1, 2]));
+    root.insert("structure", NbtValue::Compound(structure));
+    let mut data = Vec::new();
+    write_nbt(&mut data, &root, "", Endian::Little).unwrap();
+
+    let loaded = from_mcstructure(&data).expect("Failed to import");
+    let dry = loaded.get_block(0, 0, 0).unwrap();
+    assert_eq!(dry.name, "custom:pipe");
+    assert_eq!(dry.get_property("waterlogged"), None);
+    assert!(loaded
+        .get_block(0, 0, 1)
+        .map_or(true, |b| b.name == "minecraft:air"));
+    assert!(loaded.get_block(1, 0, 0).unwrap().name.contains("water"));
+    let wet = loaded.get_block(1, 0, 1).unwrap();
+    assert_eq!(wet.name, "custom:pipe");
+    assert_eq!(wet.get_property("waterlogged").unwrap(), "true");
+
+    // Export puts the water back in the second layer.
+    let again = from_mcstructure(&to_mcstructure(&loaded).unwrap()).unwrap();
+    let wet = again.get_block(1, 0, 1).unwrap();
+    assert_eq!(wet.get_property("waterlogged").unwrap(), "true");
+    assert_eq!(
+        again
+            .get_block(0, 0, 0)
+            .unwrap()
+            .get_property("waterlogged"),
+        None
+    );
+}
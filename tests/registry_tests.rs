@@ -4,8 +4,7 @@ use std::fs;
 
 #[test]
 fn test_registry_listing() {
-    let registry_arc = get_manager();
-    let registry = registry_arc.lock().unwrap_or_else(|e| e.into_inner());
+    let registry = get_manager();
     let importers = registry.list_importers();
     let exporters = registry.list_exporters();
 
@@ -18,8 +17,7 @@ fn test_registry_listing() {
 #[test]
 fn test_detect_litematic() {
     let data = fs::read("tests/samples/sample.litematic").expect("Failed to read sample.litematic");
-    let registry_arc = get_manager();
-    let registry = registry_arc.lock().unwrap_or_else(|e| e.into_inner());
+    let registry = get_manager();
     let format = registry.detect_format(&data);
     assert_eq!(format, Some("litematic".to_string()));
 }
@@ -27,8 +25,7 @@ fn test_detect_litematic() {
 #[test]
 fn test_detect_schematic() {
     let data = fs::read("tests/samples/sample.schem").expect("Failed to read sample.schem");
-    let registry_arc = get_manager();
-    let registry = registry_arc.lock().unwrap_or_else(|e| e.into_inner());
+    let registry = get_manager();
     let format = registry.detect_format(&data);
     assert_eq!(format, Some("schematic".to_string()));
 }
@@ -36,8 +33,7 @@ fn test_detect_schematic() {
 #[test]
 fn test_read_litematic_via_registry() {
     let data = fs::read("tests/samples/sample.litematic").expect("Failed to read sample.litematic");
-    let registry_arc = get_manager();
-    let registry = registry_arc.lock().unwrap_or_else(|e| e.into_inner());
+    let registry = get_manager();
     let schematic = registry.read(&data).expect("Failed to read litematic");
     assert!(schematic.total_blocks() > 0);
 }
@@ -45,8 +41,7 @@ fn test_read_litematic_via_registry() {
 #[test]
 fn test_read_schematic_via_registry() {
     let data = fs::read("tests/samples/sample.schem").expect("Failed to read sample.schem");
-    let registry_arc = get_manager();
-    let registry = registry_arc.lock().unwrap_or_else(|e| e.into_inner());
+    let registry = get_manager();
     let schematic = registry.read(&data).expect("Failed to read schematic");
     assert!(schematic.total_blocks() > 0);
 }
@@ -56,8 +51,7 @@ fn test_round_trip_registry() {
     // Read schem
     let data =
         fs::read("tests/samples/cutecounter.schem").expect("Failed to read cutecounter.schem");
-    let registry_arc = get_manager();
-    let registry = registry_arc.lock().unwrap_or_else(|e| e.into_inner());
+    let registry = get_manager();
     let schematic = registry.read(&data).expect("Failed to read schematic");
 
     // Write as litematic
@@ -112,8 +106,7 @@ fn test_round_trip_registry() {
 
 #[test]
 fn test_version_support() {
-    let registry_arc = get_manager();
-    let registry = registry_arc.lock().unwrap_or_else(|e| e.into_inner());
+    let registry = get_manager();
 
     let schematic = UniversalSchematic::new("test".to_string());
 
@@ -126,3 +119,60 @@ fn test_version_support() {
     let bad_version = registry.write("schematic", &schematic, Some("v99"));
     assert!(bad_version.is_err());
 }
+
+#[test]
+fn test_registered_formats_publish_a_new_snapshot() {
+    use nucleation::formats::manager::{update_manager, FormatManager, SchematicExporter};
+
+    struct NullExporter;
+    impl SchematicExporter for NullExporter {
+        fn name(&self) -> String {
+            "null-registry-test".to_string()
+        }
+        fn extensions(&self) -> Vec<String> {
+            vec!["nulltest".to_string()]
+        }
+        fn available_versions(&self) -> Vec<String> {
+            vec!["1".to_string()]
+        }
+        fn default_version(&self) -> String {
+            "1".to_string()
+        }
+        fn write(
+            &self,
+            _schematic: &UniversalSchematic,
+            _version: Option<&str>,
+        ) -> nucleation::formats::error::Result<Vec<u8>> {
+            Ok(Vec::new())
+        }
+    }
+
+    let before = get_manager();
+    update_manager(|registry| registry.register_exporter(NullExporter));
+    let after = get_manager();
+    // Put the shared registry back so other tests never see the exporter.
+    update_manager(|registry| *registry = FormatManager::clone(&before));
+
+    // Loads already holding a snapshot keep the registry they started with.
+    assert!(!before
+        .list_exporters()
+        .contains(&"null-registry-test".to_string()));
+    assert!(after
+        .list_exporters()
+        .contains(&"null-registry-test".to_string()));
+    assert!(!get_manager()
+        .list_exporters()
+        .contains(&"null-registry-test".to_string()));
+
+    // One snapshot serves loads on many threads at once.
+    let data = fs::read("tests/samples/sample.schem").expect("Failed to read sample.schem");
+    std::thread::scope(|scope| {
+        for _ in 0..4 {
+            let registry = get_manager();
+            let data = &data;
+            scope.spawn(move || {
+                assert!(registry.read(data).unwrap().total_blocks() > 0);
+            });
+        }
+    });
+}
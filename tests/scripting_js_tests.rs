@@ -216,3 +216,99 @@ fn test_js_palette_unknown_name_errors() {
     assert!(result.is_err());
     assert!(result.unwrap_err().contains("Unknown palette"));
 }
+
+#[test]
+fn test_js_context_reuses_vm_and_resets_globals() {
+    use nucleation::scripting::{ScriptContext, ScriptLimits};
+
+    let script = r#"
+        if (typeof leaked !== "undefined") throw new Error("global survived the reset");
+        let s = new Schematic("Warm");
+        s.set_block(0, 0, 0, "minecraft:stone");
+        leaked = 1;
+        result = s;
+    "#;
+    let mut context = ScriptContext::new();
+    for _ in 0..3 {
+        let s = context
+            .run_code("js", script)
+            .expect("declarations should not collide across runs")
+            .expect("should return a schematic");
+        assert_eq!(s.get_name(), "Warm");
+    }
+    assert!(context
+        .run_code("js", "Schematic = null;")
+        .unwrap()
+        .is_none());
+    assert!(context.run_code("js", script).unwrap().is_some());
+
+    context.set_limits(ScriptLimits {
+        max_instructions: Some(1_000_000),
+        max_memory: None,
+    });
+    assert!(context.run_code("js", "while (true) {}").is_err());
+    context.set_limits(ScriptLimits {
+        max_instructions: None,
+        max_memory: Some(16 << 20),
+    });
+    assert!(context
+        .run_code(
+            "js",
+            "let a = []; for (;;) a.push(new Array(1000).fill(1));"
+        )
+        .is_err());
+    assert!(context.run_code("js", script).unwrap().is_some());
+}
+
+#[test]
+fn test_js_bulk_indices() {
+    run_js_code(
+        r#"
+        let s = new Schematic("Bulk");
+        let stone = s.prepare_block("minecraft:stone");
+        let glass = s.prepare_block("minecraft:glass");
+        let cells = new Uint32Array(4 * 4 * 4).map((_, i) => (i % 2 ? stone : glass));
+        s.write_indices(0, 0, 0, 3, 3, 3, cells);
+        if (s.get_block_count() !== 64) throw new Error("count was " + s.get_block_count());
+        if (s.place_batch(new Int32Array([10, 0, 0, 11, 0, 0]), [stone, stone]) !== 2)
+            throw new Error("place_batch count");
+        let back = s.read_indices(0, 0, 0, 3, 3, 3);
+        if (!(back instanceof Uint32Array) || back.length !== 64 || back[1] !== stone)
+            throw new Error("read_indices mismatch");
+        if (s.indices_palette()[stone] !== "minecraft:stone") throw new Error("palette");
+    "#,
+    )
+    .expect("js should not error");
+}
+
+#[test]
+fn test_js_cached_template_with_params() {
+    use nucleation::scripting::ScriptContext;
+
+    let template = r#"
+        let s = new Schematic(params.name);
+        params.blocks.forEach((block, i) => s.set_block(i, 0, 0, block));
+        result = s;
+    "#;
+    let mut context = ScriptContext::new();
+    for (name, count) in [("a", 1), ("b", 3)] {
+        let params = serde_json::json!({
+            "name": name,
+            "blocks": vec!["minecraft:stone"; count],
+        });
+        let s = context
+            .run_code_with_params("js", template, &params)
+            .expect("js should not error")
+            .expect("should return a schematic");
+        assert_eq!(s.get_name(), name);
+        assert_eq!(s.get_block_count(), count as i32);
+    }
+    assert_eq!(context.compiled_scripts("js"), 1);
+    assert!(context
+        .run_code(
+            "js",
+            r#"if (typeof params !== "undefined") throw new Error("params leaked");"#
+        )
+        .unwrap()
+        .is_none());
+}
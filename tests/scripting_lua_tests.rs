@@ -237,3 +237,111 @@ fn test_lua_palette_unknown_name_errors() {
     assert!(result.is_err());
     assert!(result.unwrap_err().contains("Unknown palette"));
 }
+
+#[test]
+fn test_lua_context_reuses_vm_and_resets_globals() {
+    use nucleation::scripting::{ScriptContext, ScriptLimits};
+
+    let mut context = ScriptContext::new();
+    let first = context
+        .run_code(
+            "lua",
+            r#"
+            leaked = 1
+            Schematic = nil
+            "#,
+        )
+        .expect("lua should not error");
+    assert!(first.is_none());
+    let second = context
+        .run_code(
+            "lua",
+            r#"
+            assert(leaked == nil, "global survived the reset")
+            local s = Schematic.new("Warm")
+            s:set_block(0, 0, 0, "minecraft:stone")
+            result = s
+            "#,
+        )
+        .expect("bindings should be restored");
+    assert_eq!(
+        second.expect("should return a schematic").get_name(),
+        "Warm"
+    );
+    assert!(context.run_code("lua", "").unwrap().is_none());
+
+    context.set_limits(ScriptLimits {
+        max_instructions: Some(100_000),
+        max_memory: None,
+    });
+    let err = context
+        .run_code("lua", "while true do end")
+        .expect_err("the loop should be cut off");
+    assert!(err.contains("instruction limit"), "{err}");
+    context.set_limits(ScriptLimits {
+        max_instructions: None,
+        max_memory: Some(16 << 20),
+    });
+    assert!(context
+        .run_code("lua", "local t = {} for i = 1, 1e8 do t[i] = i end")
+        .is_err());
+    assert!(context
+        .run_code("lua", "result = Schematic.new('After')")
+        .unwrap()
+        .is_some());
+}
+
+#[test]
+fn test_lua_bulk_indices() {
+    run_lua_code(
+        r#"
+        local s = Schematic.new("Bulk")
+        local stone = s:prepare_block("minecraft:stone")
+        local glass = s:prepare_block("minecraft:glass")
+        local cells = {}
+        for i = 1, 4 * 4 * 4 do
+            cells[i] = (i % 2 == 0) and stone or glass
+        end
+        s:write_indices(0, 0, 0, 3, 3, 3, cells)
+        assert(s:get_block_count() == 64, "count was " .. s:get_block_count())
+        assert(s:place_batch({10, 0, 0, 11, 0, 0}, {stone, stone}) == 2)
+        local back = s:read_indices(0, 0, 0, 3, 3, 3)
+        assert(#back == 64 and back[2] == stone and back[1] == glass)
+        assert(s:indices_palette()[stone + 1] == "minecraft:stone")
+    "#,
+    )
+    .expect("lua should not error");
+}
+
+#[test]
+fn test_lua_cached_template_with_params() {
+    use nucleation::scripting::ScriptContext;
+
+    let template = r#"
+        local s = Schematic.new(params.name)
+        for i = 1, #params.blocks do
+            s:set_block(i - 1, 0, 0, params.blocks[i])
+        end
+        result = s
+    "#;
+    let mut context = ScriptContext::new();
+    for (name, count) in [("a", 1), ("b", 3)] {
+        let params = serde_json::json!({
+            "name": name,
+            "blocks": vec!["minecraft:stone"; count],
+        });
+        let s = context
+            .run_code_with_params("lua", template, &params)
+            .expect("lua should not error")
+            .expect("should return a schematic");
+        assert_eq!(s.get_name(), name);
+        assert_eq!(s.get_block_count(), count as i32);
+    }
+    assert_eq!(context.compiled_scripts("lua"), 1);
+    // params do not outlive their run.
+    assert!(context
+        .run_code("lua", "assert(params == nil)")
+        .unwrap()
+        .is_none());
+    assert_eq!(context.compiled_scripts("lua"), 2);
+}
@@ -96,3 +96,34 @@ fn test_shared_region_names() {
     let names = s.get_region_names();
     assert!(!names.is_empty());
 }
+
+#[test]
+fn test_shared_bulk_indices_round_trip() {
+    let mut s = ScriptingSchematic::new(None);
+    let stone = s.prepare_block("minecraft:stone").unwrap();
+    let log = s.prepare_block("minecraft:oak_log[axis=x]").unwrap();
+    assert_eq!(s.prepare_block("minecraft:stone").unwrap(), stone);
+    assert!(s.prepare_block("minecraft:chest{Items:[]}").is_err());
+
+    assert_eq!(
+        s.place_batch(&[0, 0, 0, 3, 1, 2], &[stone, log]).unwrap(),
+        2
+    );
+    assert!(s.get_block(3, 1, 2).unwrap().contains("axis=x"));
+    assert!(s.place_batch(&[0, 0, 0], &[99]).is_err());
+    assert!(s.place_batch(&[0, 0], &[stone]).is_err());
+
+    // A 2x2x2 box, x fastest, then z, then y.
+    let cells: Vec<u32> = (0..8)
+        .map(|i| if i % 3 == 0 { log } else { stone })
+        .collect();
+    s.write_indices((10, 0, 0), (11, 1, 1), &cells).unwrap();
+    assert_eq!(s.read_indices((10, 0, 0), (11, 1, 1)).unwrap(), cells);
+    assert!(s.get_block(10, 1, 1).unwrap().contains("oak_log"));
+    assert!(s.get_block(11, 1, 1).unwrap().contains("stone"));
+
+    let palette = s.indices_palette();
+    assert!(palette[log as usize].contains("axis=x"));
+    let outside = s.read_indices((50, 50, 50), (50, 50, 51)).unwrap();
+    assert!(outside.iter().all(|&i| palette[i as usize].contains("air")));
+}
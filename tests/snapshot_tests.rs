@@ -1,6 +1,8 @@
 use nucleation::block_entity::BlockEntity;
 use nucleation::formats::manager::get_manager;
-use nucleation::formats::snapshot::{from_snapshot, to_snapshot};
+use nucleation::formats::snapshot::{
+    from_snapshot, to_chunked_snapshot, to_snapshot, ChunkManifest, Snapshot,
+};
 use nucleation::utils::NbtValue;
 use nucleation::{BlockState, Region, UniversalSchematic};
 
@@ -239,7 +241,6 @@ fn snapshot_format_detection() {
     let bytes = to_snapshot(&schematic).unwrap();
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
     let detected = manager.detect_format(&bytes);
     assert_eq!(detected, Some("snapshot".to_string()));
 }
@@ -254,7 +255,6 @@ fn snapshot_format_manager_read() {
     let bytes = to_snapshot(&schematic).unwrap();
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
     let restored = manager.read(&bytes).unwrap();
 
     assert_eq!(
@@ -271,7 +271,6 @@ fn snapshot_format_manager_write() {
     schematic.set_block(7, 8, 9, &stone);
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
     let bytes = manager.write("snapshot", &schematic, None).unwrap();
 
     // Should start with NUSN magic
@@ -319,7 +318,7 @@ fn snapshot_header_format() {
     assert_eq!(&bytes[0..4], b"NUSN", "magic mismatch");
     assert_eq!(
         u32::from_le_bytes(bytes[4..8].try_into().unwrap()),
-        1,
+        2,
         "version mismatch"
     );
 }
@@ -351,3 +350,125 @@ fn snapshot_roundtrip_all_metadata() {
     assert_eq!(restored.metadata.we_version, schematic.metadata.we_version);
     assert_eq!(restored.metadata.lm_version, schematic.metadata.lm_version);
 }
+
+/// Version 1 snapshots still load, and the exporter still writes them on request.
+#[test]
+fn snapshot_v1_still_loads() {
+    let mut schematic = UniversalSchematic::new("V1".to_string());
+    let stone = BlockState::new("minecraft:stone".to_string());
+    schematic.set_block(1, 2, 3, &stone);
+
+    let manager = get_manager();
+    let bytes = manager.write("snapshot", &schematic, Some("1")).unwrap();
+    assert_eq!(u32::from_le_bytes(bytes[4..8].try_into().unwrap()), 1);
+
+    let restored = from_snapshot(&bytes).unwrap();
+    assert_eq!(
+        restored.get_block(1, 2, 3).map(|b| b.name.to_string()),
+        Some("minecraft:stone".to_string())
+    );
+    assert_eq!(restored.total_blocks(), 1);
+}
+
+/// A snapshot read in place answers block queries from its cells, with the
+/// same region precedence as the schematic, and builds the same schematic
+/// without rescanning.
+#[test]
+fn snapshot_view_reads_blocks_in_place() {
+    let mut schematic = UniversalSchematic::new("View".to_string());
+    // More than 256 states so the default region stores 16-bit cells.
+    for i in 0..300 {
+        let state = BlockState::new("minecraft:note_block".to_string())
+            .with_property("note".to_string(), i.to_string());
+        schematic.set_block(i % 20, i / 20, 0, &state);
+    }
+    schematic.set_block_in_region(
+        "Wing",
+        40,
+        0,
+        0,
+        &BlockState::new("minecraft:glass".to_string()),
+    );
+
+    let bytes = to_snapshot(&schematic).unwrap();
+    let view = Snapshot::parse(bytes.as_slice()).unwrap();
+    assert_eq!(
+        view.region_names().collect::<Vec<_>>(),
+        vec![schematic.default_region_name.as_str(), "Wing"]
+    );
+    for (x, y, z) in [(0, 0, 0), (7, 3, 0), (19, 14, 0), (40, 0, 0), (99, 0, 0)] {
+        assert_eq!(view.get_block(x, y, z), schematic.get_block(x, y, z));
+    }
+
+    let restored = view.to_schematic().unwrap();
+    assert_eq!(restored.total_blocks(), schematic.total_blocks());
+    assert_eq!(
+        restored.default_region.get_tight_bounds(),
+        schematic.default_region.get_tight_bounds()
+    );
+    let wing = view.region("Wing").unwrap();
+    assert_eq!(wing.count_non_air_blocks(), 1);
+
+    // Truncated cells are rejected up front rather than on first read.
+    assert!(Snapshot::parse(&bytes[..bytes.len() - 200]).is_err());
+}
+
+/// Cells that contradict the header are rejected when a region is built,
+/// instead of producing a region whose indices, count or bounds are wrong.
+#[test]
+fn snapshot_corrupt_cells_are_rejected() {
+    let mut schematic = UniversalSchematic::new("Corrupt".to_string());
+    let stone = BlockState::new("minecraft:stone".to_string());
+    schematic.set_block(0, 0, 0, &stone);
+    schematic.set_block(3, 0, 0, &stone);
+    let bytes = to_snapshot(&schematic).unwrap();
+    assert!(Snapshot::parse(bytes.as_slice())
+        .unwrap()
+        .to_schematic()
+        .is_ok());
+
+    // The default region's cells (one byte each) start the data sections.
+    let header_len = u64::from_le_bytes(bytes[8..16].try_into().unwrap()) as usize;
+    let base = (16 + header_len).next_multiple_of(64);
+    let bbox = schematic.default_region.get_bounding_box();
+    let (w, _, l) = bbox.get_dimensions();
+    let cell = |x: i32, y: i32, z: i32| {
+        base + ((x - bbox.min.0) + (z - bbox.min.2) * w + (y - bbox.min.1) * w * l) as usize
+    };
+
+    let mut past_palette = bytes.clone();
+    past_palette[cell(1, 0, 0)] = 200;
+    let mut extra_block = bytes.clone();
+    extra_block[cell(1, 0, 0)] = bytes[cell(0, 0, 0)];
+    for corrupt in [past_palette, extra_block] {
+        let view = Snapshot::parse(corrupt.as_slice()).unwrap();
+        assert!(view.to_schematic().is_err());
+        assert!(from_snapshot(&corrupt).is_err());
+    }
+}
+
+/// A chunked snapshot reassembles to the plain snapshot, and a chunk that
+/// doesn't match its hash is rejected.
+#[test]
+fn chunked_snapshot_reassembles() {
+    let mut schematic = UniversalSchematic::new("Chunked".to_string());
+    let stone = BlockState::new("minecraft:stone".to_string());
+    for x in 0..16 {
+        for y in 0..16 {
+            schematic.set_block(x, y, 0, &stone);
+        }
+    }
+    let chunked = to_chunked_snapshot(&schematic, 64).unwrap();
+    let manifest = ChunkManifest::parse(&chunked.manifest).unwrap();
+    let ids = manifest.chunk_ids();
+    assert_eq!(ids.len(), chunked.chunks.len());
+    let mut chunks: Vec<Vec<u8>> = chunked.chunks.into_iter().map(|(_, c)| c).collect();
+    assert_eq!(
+        manifest.assemble(&chunks).unwrap(),
+        to_snapshot(&schematic).unwrap()
+    );
+
+    chunks[0][0] ^= 1;
+    assert!(manifest.assemble(&chunks).is_err());
+    assert!(ChunkManifest::parse(b"NUSN\x02\0\0\0").is_err());
+}
@@ -38,13 +38,13 @@ fn s3_contract_against_minio_container() {
         .expect("start MinIO");
     let port = node.get_host_port_ipv4(9000.tcp()).expect("minio port");
     let store = S3Store::connect(S3Config {
-        bucket: "nucleation-test".to_string(),
         prefix: "tc/".to_string(),
         region: Some("us-east-1".to_string()),
         endpoint: Some(format!("http://127.0.0.1:{port}")),
         access_key: Some("minioadmin".to_string()),
         secret_key: Some("minioadmin".to_string()),
         force_path_style: true,
+        ..S3Config::new("nucleation-test")
     })
     .expect("connect S3");
     store.ensure_bucket().expect("ensure bucket");
@@ -2,7 +2,7 @@ use nucleation::block_position::BlockPosition;
 use nucleation::formats::anvil::is_mca;
 use nucleation::formats::manager::get_manager;
 use nucleation::formats::structure_snbt::{
-    from_structure_snbt, is_structure_snbt, to_structure_snbt,
+    from_structure_snbt, is_structure_snbt, to_structure_snbt, write_structure_snbt,
 };
 use nucleation::utils::NbtValue;
 use nucleation::{BlockState, Region, UniversalSchematic};
@@ -156,7 +156,6 @@ fn export_normalizes_translated_schematic_to_structure_local_coordinates() {
 #[test]
 fn format_manager_detects_reads_and_writes_structure_snbt() {
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
     assert_eq!(
         manager.detect_format(MINIMAL.as_bytes()).as_deref(),
         Some("structure_snbt")
@@ -306,3 +305,20 @@ fn lithium_fixture_corpus_imports_and_round_trips() {
         );
     }
 }
+
+#[test]
+fn writes_snbt_into_a_writer_and_rejects_non_snbt_cheaply() {
+    let schematic = from_structure_snbt(MINIMAL.as_bytes()).unwrap();
+    let mut out = std::io::BufWriter::new(Vec::new());
+    write_structure_snbt(&schematic, &mut out).unwrap();
+    let written = out.into_inner().unwrap();
+    assert_eq!(written, to_structure_snbt(&schematic).unwrap());
+    let reread = from_structure_snbt(&written).unwrap();
+    assert_eq!(
+        reread.get_block(1, 0, 0).map(|b| b.to_string()),
+        schematic.get_block(1, 0, 0).map(|b| b.to_string())
+    );
+
+    assert!(!is_structure_snbt(&[0x1f, 0x8b, 0x08, 0x00]));
+    assert!(!is_structure_snbt(b"{DataVersion: 4325, size: [1, 1, 1]}"));
+}
@@ -11,7 +11,6 @@ fn test_uss_texas_to_world() {
     println!("Schematic size: {} bytes", data.len());
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
 
     let schematic = manager.read(&data).expect("Failed to read schematic");
     let bb = schematic.default_region.get_bounding_box();
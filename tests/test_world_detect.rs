@@ -10,7 +10,6 @@ fn test_55_3x3_world_detect() {
     println!("File size: {}", data.len());
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
 
     let detected = manager.detect_format(&data);
     println!("Detected format: {:?}", detected);
@@ -12,7 +12,6 @@ fn test_55_3x3_roundtrip() {
     println!("Input zip size: {} bytes", data.len());
 
     let manager = get_manager();
-    let manager = manager.lock().unwrap();
 
     let schematic = manager.read(&data).expect("Failed to import world zip");
     let bb = schematic.default_region.get_bounding_box();
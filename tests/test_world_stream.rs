@@ -173,6 +173,86 @@ fn iteration_order_is_canonical() {
     assert_eq!(keys, sorted);
 }
 
+#[test]
+fn projected_iteration_drops_sections_and_extras() {
+    use nucleation::formats::anvil::ChunkProjection;
+    // One chunk with blocks in three sections: y=0, y=4 and y=6.
+    let mut schem = UniversalSchematic::new("fixture".to_string());
+    let stone = BlockState::new("minecraft:stone".to_string());
+    let gold = BlockState::new("minecraft:gold_block".to_string());
+    schem.set_block(1, 10, 1, &stone);
+    schem.set_block(5, 65, 5, &gold);
+    schem.set_block(2, 100, 2, &stone);
+    let zip = world::to_world_zip(&schem, None).expect("to_world_zip");
+    let source = WorldSource::from_zip_bytes(zip).expect("source");
+
+    let (min, max) = ((0, -64, 0), (15, 319, 15));
+    let full: Vec<_> = source
+        .chunks_bounded(min, max)
+        .expect("bounded")
+        .collect::<Result<Vec<_>, _>>()
+        .expect("all ok");
+    let projection = ChunkProjection::blocks_only().with_y_range(64, 79);
+    let projected: Vec<_> = source
+        .chunks_bounded_projected(min, max, projection)
+        .expect("projected")
+        .collect::<Result<Vec<_>, _>>()
+        .expect("all ok");
+    assert_eq!((full.len(), projected.len()), (1, 1));
+
+    let (full, projected) = (&full[0], &projected[0]);
+    assert_eq!(full.y_range(), (0, 111));
+    assert_eq!(projected.y_range(), (64, 79));
+    assert!(projected.block_entities().is_empty());
+    assert!(projected.entities().is_empty());
+    let in_band: Vec<_> = full
+        .blocks()
+        .filter(|(_, y, _, _)| (64..80).contains(y))
+        .collect();
+    assert_eq!(projected.blocks().collect::<Vec<_>>(), in_band);
+    assert_eq!(
+        projected.get_block(5, 65, 5).map(|b| b.name.as_str()),
+        Some("minecraft:gold_block")
+    );
+}
+
+#[test]
+fn parallel_iteration_matches_serial() {
+    let zip = world_zip_fixture();
+    let source = WorldSource::from_zip_bytes(zip).expect("source");
+    let key = |c: Result<nucleation::formats::world_stream::WorldChunkView, _>| {
+        let v = c.expect("ok");
+        (v.cx(), v.cz(), v.blocks().count())
+    };
+    let serial: Vec<_> = source.chunks().expect("chunks").map(key).collect();
+
+    for threads in [1, 3] {
+        let ordered: Vec<_> = source
+            .chunks()
+            .expect("chunks")
+            .parallel(threads, true)
+            .map(key)
+            .collect();
+        assert_eq!(ordered, serial, "ordered with {} threads", threads);
+
+        let mut unordered: Vec<_> = source
+            .chunks()
+            .expect("chunks")
+            .parallel(threads, false)
+            .map(key)
+            .collect();
+        unordered.sort_by_key(|(cx, cz, _)| {
+            nucleation::formats::world_stream::chunk_order_key(*cx, *cz)
+        });
+        assert_eq!(unordered, serial, "unordered with {} threads", threads);
+    }
+
+    // Dropping a half-read stream stops its workers.
+    let mut partial = source.chunks().expect("chunks").parallel(2, true);
+    assert!(partial.next().is_some());
+    drop(partial);
+}
+
 #[test]
 fn corrupt_chunk_yields_error_item_and_stream_continues() {
     // Take a valid region file and truncate one chunk's payload bytes
@@ -238,6 +318,37 @@ fn directory_source_streams_chunks() {
     let _ = std::fs::remove_dir_all(&dir);
 }
 
+#[test]
+fn mapped_directory_source_matches_buffered_reads() {
+    let mut schem = UniversalSchematic::new("dirfix".to_string());
+    let stone = BlockState::new("minecraft:stone".to_string());
+    let gold = BlockState::new("minecraft:gold_block".to_string());
+    schem.set_block(0, 64, 0, &stone);
+    schem.set_block(20, 70, 3, &gold);
+    schem.set_block(530, 64, 7, &stone);
+    let dir = std::env::temp_dir().join("nucleation_ws_test_mapped_src");
+    let _ = std::fs::remove_dir_all(&dir);
+    world::save_world(&schem, &dir, None).expect("save_world");
+
+    let blocks = |source: WorldSource| -> Vec<(i32, i32, i32, String)> {
+        source
+            .chunks()
+            .expect("chunks")
+            .flat_map(|c| {
+                let view = c.expect("ok");
+                view.blocks()
+                    .map(|(x, y, z, b)| (x, y, z, b.name.to_string()))
+                    .collect::<Vec<_>>()
+            })
+            .collect()
+    };
+    let buffered = blocks(WorldSource::open_dir(&dir).expect("open"));
+    let mapped = blocks(WorldSource::open_dir_mapped(&dir).expect("open mapped"));
+    assert_eq!(buffered.len(), 3);
+    assert_eq!(mapped, buffered);
+    let _ = std::fs::remove_dir_all(&dir);
+}
+
 // ─── Task 4: WorldSink (write/patch path) ───────────────────────────────────
 
 use nucleation::formats::world_stream::WorldSink;
@@ -335,6 +446,80 @@ fn patch_chunk_changes_only_target_chunk() {
     let _ = std::fs::remove_dir_all(&dir);
 }
 
+#[test]
+fn patch_chunks_rewrites_only_patched_records() {
+    use nucleation::formats::world_stream::WorldChunkView;
+    let mut schem = UniversalSchematic::new("patchfix".to_string());
+    let stone = BlockState::new("minecraft:stone".to_string());
+    schem.set_block(0, 64, 0, &stone);
+    schem.set_block(20, 64, 0, &stone); // cx=1
+    schem.set_block(530, 64, 7, &stone); // cx=33, region r.1.0
+    let dir = std::env::temp_dir().join("nucleation_ws_test_patch_many");
+    let _ = std::fs::remove_dir_all(&dir);
+    world::save_world(&schem, &dir, None).expect("save");
+
+    // Location entry and record bytes of chunk (local x, local z = 0).
+    let record = |bytes: &[u8], local_x: usize| -> (usize, Vec<u8>) {
+        let o = local_x * 4;
+        let offset =
+            (u32::from_be_bytes([0, bytes[o], bytes[o + 1], bytes[o + 2]]) as usize) * 4096;
+        let len = u32::from_be_bytes(bytes[offset..offset + 4].try_into().unwrap()) as usize;
+        (offset, bytes[offset..offset + 4 + len].to_vec())
+    };
+    let r00 = dir.join("region").join("r.0.0.mca");
+    let before = std::fs::read(&r00).unwrap();
+    let (patched_offset, _) = record(&before, 0);
+    let untouched_before = record(&before, 1);
+
+    // Two patches to (0,0), the second large enough to outgrow its sectors,
+    // plus one in another region.
+    let beacon = BlockState::new("minecraft:beacon".to_string());
+    let mut sink = WorldSink::open_existing(&dir).expect("open");
+    let patches: Vec<(i32, i32, Box<dyn FnOnce(&mut WorldChunkView)>)> = vec![
+        (
+            0,
+            0,
+            Box::new(|view| assert!(view.set_block(0, 64, 0, &beacon))),
+        ),
+        (
+            33,
+            0,
+            Box::new(|view| assert!(view.set_block(530, 64, 7, &beacon))),
+        ),
+        (
+            0,
+            0,
+            Box::new(|view| {
+                for i in 0..4096 {
+                    let n = ((i as u32).wrapping_mul(2_654_435_761) >> 16) % 1000;
+                    let block = BlockState::new(format!("minecraft:test_{}", n));
+                    assert!(view.set_block(i % 16, i / 256, (i / 16) % 16, &block));
+                }
+            }),
+        ),
+    ];
+    sink.patch_chunks(patches).expect("patch");
+    sink.finish().expect("finish");
+
+    let after = std::fs::read(&r00).unwrap();
+    assert_eq!(record(&after, 1), untouched_before);
+    let (moved_offset, grown) = record(&after, 0);
+    assert!(grown.len() > 4096 && moved_offset >= before.len());
+    assert_ne!(moved_offset, patched_offset);
+    let reread = world::from_world_directory(&dir).expect("reread");
+    let name = |x, y, z| {
+        reread
+            .default_region
+            .get_block(x, y, z)
+            .map(|b| b.name.to_string())
+    };
+    assert_eq!(name(0, 64, 0).as_deref(), Some("minecraft:beacon"));
+    assert_eq!(name(5, 0, 3).as_deref(), Some("minecraft:test_532"));
+    assert_eq!(name(20, 64, 0).as_deref(), Some("minecraft:stone"));
+    assert_eq!(name(530, 64, 7).as_deref(), Some("minecraft:beacon"));
+    let _ = std::fs::remove_dir_all(&dir);
+}
+
 #[test]
 fn sink_out_of_order_region_writes_lose_nothing() {
     // Chunks in two regions, written A, B, A — the second A flush must not
@@ -399,6 +584,47 @@ fn sink_out_of_order_region_writes_lose_nothing() {
     let _ = std::fs::remove_dir_all(&dir);
 }
 
+#[test]
+fn chunk_views_expose_heightmaps_and_section_summaries() {
+    let mut schem = UniversalSchematic::new("surface".to_string());
+    let stone = BlockState::new("minecraft:stone".to_string());
+    let dirt = BlockState::new("minecraft:dirt".to_string());
+    schem.set_block(1, 64, 2, &stone);
+    schem.set_block(1, 65, 2, &dirt);
+    schem.set_block(3, -10, 0, &stone);
+    let zip = world::to_world_zip(&schem, None).expect("zip");
+    let source = WorldSource::from_zip_bytes(zip).expect("source");
+    let mut view = source
+        .chunks()
+        .unwrap()
+        .next()
+        .expect("one chunk")
+        .expect("decode");
+
+    let heights = view.heightmap("MOTION_BLOCKING").expect("stored heightmap");
+    assert_eq!(heights.len(), 256);
+    assert_eq!(heights[2 * 16 + 1], 66, "just above the dirt");
+    assert_eq!(heights[3], -9);
+    assert_eq!(heights[5], -64, "empty column is the chunk bottom");
+    assert_eq!(view.heightmap("WORLD_SURFACE"), Some(heights.clone()));
+    assert_eq!(view.heightmap("OCEAN_FLOOR"), None);
+
+    let sections = view.sections();
+    let ys: Vec<i32> = sections.iter().map(|s| s.y).collect();
+    assert_eq!(ys, vec![-1, 4]);
+    assert_eq!(sections[0].non_air, 1);
+    assert_eq!(sections[1].non_air, 2);
+    let top = &sections[1];
+    let at = top.block_states[256 + 2 * 16 + 1] as usize;
+    assert_eq!(top.palette[at].name.as_str(), "minecraft:dirt");
+
+    // Edits drop the stored heightmaps, which are then recomputed.
+    assert!(view.set_block(1, 80, 2, &stone));
+    let heights = view.heightmap("MOTION_BLOCKING").unwrap();
+    assert_eq!(heights[2 * 16 + 1], 81);
+    assert_eq!(view.heightmap("OCEAN_FLOOR"), None);
+}
+
 // ─── Task 5: diff_worlds (lockstep streaming diff) ──────────────────────────
 
 use nucleation::formats::world_stream::diff_worlds;
@@ -509,8 +735,146 @@ fn diff_worlds_does_not_translate_align_shifted_chunks() {
     );
 }
 
+#[test]
+fn diff_worlds_skips_identical_records_across_batches() {
+    // 100 chunks, saved twice; two chunks of the copy are then patched, one
+    // of them past the first decode batch.
+    let stone = BlockState::new("minecraft:stone".to_string());
+    let mut schem = UniversalSchematic::new("grid".to_string());
+    for cx in 0..10 {
+        for cz in 0..10 {
+            schem.set_block(cx * 16 + 3, 64, cz * 16 + 5, &stone);
+        }
+    }
+    let root = std::env::temp_dir().join("nucleation_ws_test_diff_batches");
+    let _ = std::fs::remove_dir_all(&root);
+    let (dir_a, dir_b) = (root.join("a"), root.join("b"));
+    world::save_world(&schem, &dir_a, None).expect("save a");
+    world::save_world(&schem, &dir_b, None).expect("save b");
+
+    let gold = BlockState::new("minecraft:gold_block".to_string());
+    let mut sink = WorldSink::open_existing(&dir_b).expect("open");
+    for (cx, cz) in [(2, 8), (9, 0)] {
+        sink.patch_chunk(cx, cz, |view| {
+            view.set_block(cx * 16, 70, cz * 16, &gold);
+        })
+        .expect("patch");
+    }
+    sink.finish().expect("finish");
+
+    let src_a = WorldSource::open_dir(&dir_a).unwrap();
+    let src_b = WorldSource::open_dir(&dir_b).unwrap();
+    let diffs: Vec<_> = diff_worlds(&src_a, &src_b, "exact")
+        .unwrap()
+        .collect::<Result<Vec<_>, _>>()
+        .unwrap();
+    let positions: Vec<_> = diffs.iter().map(|d| (d.cx, d.cz)).collect();
+    assert_eq!(
+        positions,
+        vec![(9, 0), (2, 8)],
+        "canonical order, patched only"
+    );
+    assert!(diffs.iter().all(|d| d.diff.added.len() == 1));
+    let _ = std::fs::remove_dir_all(&root);
+}
+
+#[test]
+fn indexed_diff_reads_only_differing_chunks() {
+    use nucleation::formats::world_index::WorldIndex;
+    use nucleation::formats::world_stream::diff_worlds_indexed;
+
+    let stone = BlockState::new("minecraft:stone".to_string());
+    let mut schem = UniversalSchematic::new("indexed".to_string());
+    schem.set_block(0, 64, 0, &stone);
+    schem.set_block(20, 64, 0, &stone);
+    schem.set_block(530, 64, 7, &stone);
+    let root = std::env::temp_dir().join("nucleation_ws_test_indexed_diff");
+    let _ = std::fs::remove_dir_all(&root);
+    let (dir_a, dir_b) = (root.join("a"), root.join("b"));
+    world::save_world(&schem, &dir_a, None).expect("save a");
+    world::save_world(&schem, &dir_b, None).expect("save b");
+    let mut sink = WorldSink::open_existing(&dir_b).expect("open");
+    sink.patch_chunk(33, 0, |view| {
+        view.set_block(531, 64, 7, &stone);
+    })
+    .expect("patch");
+    sink.finish().expect("finish");
+
+    let (index_a, _) = WorldIndex::open(&dir_a).unwrap();
+    let (index_b, delta) = WorldIndex::open(&dir_b).unwrap();
+    assert_eq!(delta.changed.len(), 3, "first open indexes every chunk");
+    assert_eq!(index_a.differing(&index_b), vec![(33, 0)]);
+
+    let src_a = WorldSource::open_dir(&dir_a).unwrap();
+    let src_b = WorldSource::open_dir(&dir_b).unwrap();
+    let only: Vec<_> = src_b
+        .chunks_at(&[(33, 0), (5, 5)])
+        .unwrap()
+        .map(|c| c.map(|v| (v.cx(), v.cz())))
+        .collect::<Result<Vec<_>, _>>()
+        .unwrap();
+    assert_eq!(only, vec![(33, 0)], "absent positions are skipped");
+
+    let diffs: Vec<_> = diff_worlds_indexed(&src_a, &index_a, &src_b, &index_b, "exact")
+        .unwrap()
+        .collect::<Result<Vec<_>, _>>()
+        .unwrap();
+    assert_eq!(diffs.len(), 1);
+    assert_eq!((diffs[0].cx, diffs[0].cz), (33, 0));
+    let _ = std::fs::remove_dir_all(&root);
+}
+
 // ─── World generation from scratch (fabricated chunks) ──────────────────────
 
+#[test]
+fn sharded_sink_takes_concurrent_out_of_order_writes() {
+    use nucleation::formats::world_stream::{ShardedWorldSink, WorldChunkView};
+    let dir = std::env::temp_dir().join("nucleation_ws_test_sharded");
+    let _ = std::fs::remove_dir_all(&dir);
+    // One open region among three forces evictions and re-opened regions.
+    let sink = ShardedWorldSink::create(&dir, None, 1).expect("create");
+    let names = ["minecraft:stone", "minecraft:gold_block", "minecraft:dirt"];
+    let chunks: Vec<(i32, i32)> = (0..24).map(|i| ((i % 3) * 32 + i / 3, -(i % 2))).collect();
+    std::thread::scope(|scope| {
+        for worker in 0..4 {
+            let (sink, chunks) = (&sink, &chunks);
+            scope.spawn(move || {
+                for (i, &(cx, cz)) in chunks.iter().enumerate().skip(worker).step_by(4) {
+                    let mut view = WorldChunkView::new(cx, cz);
+                    let block = BlockState::new(names[i % 3].to_string());
+                    assert!(view.set_block(cx * 16 + 3, 64, cz * 16 + 5, &block));
+                    sink.write_chunk(&view).expect("write");
+                }
+            });
+        }
+    });
+    sink.finish().expect("finish");
+    assert!(dir.join("level.dat").is_file());
+
+    let source = WorldSource::open_dir(&dir).expect("open");
+    let mut read: Vec<(i32, i32, String)> = source
+        .chunks()
+        .expect("chunks")
+        .map(|c| {
+            let view = c.expect("ok");
+            let block = view
+                .get_block(view.cx() * 16 + 3, 64, view.cz() * 16 + 5)
+                .map(|b| b.name.to_string())
+                .unwrap_or_default();
+            (view.cx(), view.cz(), block)
+        })
+        .collect();
+    read.sort();
+    let mut expected: Vec<(i32, i32, String)> = chunks
+        .iter()
+        .enumerate()
+        .map(|(i, &(cx, cz))| (cx, cz, names[i % 3].to_string()))
+        .collect();
+    expected.sort();
+    assert_eq!(read, expected);
+    let _ = std::fs::remove_dir_all(&dir);
+}
+
 #[test]
 fn generate_world_from_scratch_chunk_by_chunk() {
     use nucleation::formats::world_stream::WorldChunkView;
@@ -647,3 +1011,65 @@ fn patch_chunk_preserves_biomes() {
     );
     let _ = std::fs::remove_dir_all(&dir);
 }
+
+#[test]
+fn streamed_export_matches_in_memory_import() {
+    use nucleation::formats::world_export::{export_world_box, SpoolFormat};
+    use nucleation::formats::{litematic, schematic};
+
+    let stone = BlockState::new("minecraft:stone".to_string());
+    let gold = BlockState::new("minecraft:gold_block".to_string());
+    let log = BlockState::new("minecraft:oak_log".to_string()).with_property("axis", "x");
+    let mut schem = UniversalSchematic::new("export".to_string());
+    schem.set_block(-17, 64, 0, &stone);
+    schem.set_block(-1, 61, -5, &gold);
+    schem.set_block(0, 64, 0, &log);
+    schem.set_block(25, 75, 10, &gold);
+    schem.set_block(26, 64, 0, &stone); // outside the box
+    let dir = std::env::temp_dir().join("nucleation_ws_test_export");
+    let _ = std::fs::remove_dir_all(&dir);
+    world::save_world(&schem, &dir, None).expect("save_world");
+
+    let (min, max) = ((-20, 60, -5), (25, 75, 10));
+    let eager = world::from_world_directory_bounded(&dir, min.0, min.1, min.2, max.0, max.1, max.2)
+        .expect("eager import");
+    let source = WorldSource::open_dir(&dir).expect("open");
+
+    let schem_path = dir.join("box.schem");
+    let stats = export_world_box(&source, min, max, SpoolFormat::SpongeV3, &schem_path, 2)
+        .expect("export schem");
+    assert_eq!(stats.size, (46, 16, 16));
+    assert_eq!(stats.non_air_blocks, 4);
+    assert_eq!(stats.non_air_blocks, eager.total_blocks() as u64);
+    assert!(!dir.join("box.schem.spool").exists(), "spool is removed");
+    let sponge = schematic::from_schematic(&std::fs::read(&schem_path).unwrap()).expect("read");
+
+    let lite_path = dir.join("box.litematic");
+    export_world_box(&source, min, max, SpoolFormat::Litematic, &lite_path, 0)
+        .expect("export litematic");
+    let lite = litematic::from_litematic(&std::fs::read(&lite_path).unwrap()).expect("read");
+
+    // Sponge imports at the origin; litematic keeps world coordinates.
+    for y in min.1..=max.1 {
+        for z in min.2..=max.2 {
+            for x in min.0..=max.0 {
+                let want = eager
+                    .get_block(x, y, z)
+                    .map(|b| b.to_string())
+                    .filter(|name| name != "minecraft:air");
+                let rel = (x - min.0, y - min.1, z - min.2);
+                let got = sponge
+                    .get_block(rel.0, rel.1, rel.2)
+                    .map(|b| b.to_string())
+                    .filter(|name| name != "minecraft:air");
+                assert_eq!(got, want, "sponge at {x} {y} {z}");
+                let got = lite
+                    .get_block(x, y, z)
+                    .map(|b| b.to_string())
+                    .filter(|name| name != "minecraft:air");
+                assert_eq!(got, want, "litematic at {x} {y} {z}");
+            }
+        }
+    }
+    let _ = std::fs::remove_dir_all(&dir);
+}
@@ -22,6 +22,7 @@ use nucleation::world_segment::runner::{SegmentJob, WorldSegmenter};
 use nucleation::world_segment::score::{ScoreConfig, Tier};
 use nucleation::world_segment::segment::SegConfig;
 use nucleation::world_segment::source::{region_tile_bounds, Access, TileError, TileSource};
+use nucleation::world_segment::spill::SpillConfig;
 use nucleation::world_segment::tile::{TileBounds, VoxelTile};
 
 /// An in-memory forward source yielding a fixed list of pre-built tiles, in
@@ -141,6 +142,7 @@ fn cross_tile_build_stitches_into_one() {
         max_y: 63,
         extracted_at: 1_700_000_000,
         match_iou: 0.5,
+        spill: SpillConfig::default(),
     };
 
     let out = WorldSegmenter::run(&source, &profile, &partitions, &job, &[]);
@@ -204,6 +206,7 @@ fn substrate_removed_debris_tiered_not_dropped() {
         max_y: 63,
         extracted_at: 1_700_000_000,
         match_iou: 0.5,
+        spill: SpillConfig::default(),
     };
 
     let out = WorldSegmenter::run(&source, &profile, &partitions, &job, &[]);
@@ -295,6 +298,7 @@ fn order_test_job() -> SegmentJob {
         max_y: 63,
         extracted_at: 1_700_000_123,
         match_iou: 0.5,
+        spill: SpillConfig::default(),
     }
 }
 
@@ -391,6 +395,7 @@ fn edited_build_inherits_stable_id_new_fingerprint() {
         max_y: 63,
         extracted_at: 1_700_000_000,
         match_iou: 0.5,
+        spill: SpillConfig::default(),
     };
     let out1 = WorldSegmenter::run(&source1, &profile, &partitions, &job1, &[]);
     assert_eq!(out1.len(), 1);